@@ -34,7 +34,12 @@
  * TODO: document this
  */
 
+#include "client/cat.hpp"
+#include "client/checkout.hpp"
 #include "client/context.hpp"
+#include "client/executor.hpp"
+#include "client/log.hpp"
 #include "client/status.hpp"
+#include "client/update.hpp"
 
 #endif  // SVNXX_CLIENT_HPP
@@ -0,0 +1,95 @@
+/**
+ * @file svnxx/client/cat.hpp
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+#ifndef SVNXX_CLIENT_CAT_HPP
+#define SVNXX_CLIENT_CAT_HPP
+
+#include <cstddef>
+#include <functional>
+
+#include "svnxx/detail/future.hpp"
+#include "svnxx/client/context.hpp"
+#include "svnxx/client/executor.hpp"
+
+#include "svnxx/revision.hpp"
+
+namespace apache {
+namespace subversion {
+namespace svnxx {
+namespace client {
+
+/**
+ * @brief The callback that receives the contents of a file, one
+ *        chunk at a time.
+ *
+ * The @a data belong to the cat operation and are only valid until
+ * the callback returns.
+ */
+using cat_callback = std::function<void(const char* data, std::size_t size)>;
+
+/**
+ * @ingroup svnxx_client
+ * @brief Retrieve the contents of the file @a path_or_url.
+ * @param ctx the #context object to use for this operation
+ * @param path_or_url the working copy path or URL of the file
+ * @param peg_rev the revision in which @a path_or_url is valid
+ * @param rev the revision of the contents to retrieve
+ * @param expand_keywords whether to expand keywords in the contents
+ * @param callback a function that will be called for each chunk of
+ *        the contents; it may throw svn::stop_iteration to end the
+ *        operation early
+ * @see svn_client_cat3
+ */
+void
+cat(context& ctx, const char* path_or_url,
+    const revision& peg_rev, const revision& rev,
+    bool expand_keywords, cat_callback callback);
+
+namespace async {
+
+/**
+ * @ingroup svnxx_client
+ * @brief Retrieve the contents of the file @a path_or_url
+ *        asynchronously, using one of the threads of @a exec.
+ *
+ * Behaves as if svn::client::cat() were invoked from a thread
+ * of @a exec.
+ *
+ * @warning Any callbacks registered in @a ctx, as well as the
+ *          @a callback itself, may be called in the context of a
+ *          different thread than the one that created this
+ *          asynchronous operation.
+ */
+svnxx::detail::future<void>
+cat(executor& exec, context& ctx, const char* path_or_url,
+    const revision& peg_rev, const revision& rev,
+    bool expand_keywords, cat_callback callback);
+
+} // namespace async
+} // namespace client
+} // namespace svnxx
+} // namespace subversion
+} // namespace apache
+
+#endif  // SVNXX_CLIENT_CAT_HPP
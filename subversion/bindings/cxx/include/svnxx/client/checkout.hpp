@@ -0,0 +1,112 @@
+/**
+ * @file svnxx/client/checkout.hpp
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+#ifndef SVNXX_CLIENT_CHECKOUT_HPP
+#define SVNXX_CLIENT_CHECKOUT_HPP
+
+#include <cstdint>
+
+#include "svnxx/detail/future.hpp"
+#include "svnxx/client/context.hpp"
+#include "svnxx/client/executor.hpp"
+
+#include "svnxx/depth.hpp"
+#include "svnxx/revision.hpp"
+
+namespace apache {
+namespace subversion {
+namespace svnxx {
+namespace client {
+
+/**
+ * @brief Flags that modify the behaviour of the checkout operation.
+ * @see svn_client_checkout3
+ */
+enum class checkout_flags : std::uint_least32_t
+  {
+    empty                          = 0U,
+    ignore_externals               = 1U << 0,
+    allow_unversioned_obstructions = 1U << 1,
+  };
+
+/**
+ * @brief Bitwise conjunction operator for @c checkout_flags.
+ */
+inline checkout_flags operator&(checkout_flags a, checkout_flags b)
+{
+  return checkout_flags(std::uint_least32_t(a) & std::uint_least32_t(b));
+}
+
+/**
+ * @brief Bitwise disjunction operator for  @c checkout_flags.
+ */
+inline checkout_flags operator|(checkout_flags a, checkout_flags b)
+{
+  return checkout_flags(std::uint_least32_t(a) | std::uint_least32_t(b));
+}
+
+/**
+ * @ingroup svnxx_client
+ * @brief Check out a working copy of @a url at @a path.
+ * @param ctx the #context object to use for this operation
+ * @param url the repository URL to check out
+ * @param path the path of the new working copy
+ * @param peg_rev the revision in which @a url is valid
+ * @param rev the revision to check out
+ * @param depth the depth of the operation
+ * @param flags a combination of @c checkout_flags
+ * @return the revision that was checked out
+ * @see svn_client_checkout3
+ */
+revision::number
+checkout(context& ctx, const char* url, const char* path,
+         const revision& peg_rev, const revision& rev,
+         depth depth, checkout_flags flags);
+
+namespace async {
+
+/**
+ * @ingroup svnxx_client
+ * @brief Perform an asynchronous checkout of @a url using one of the
+ *        threads of @a exec.
+ *
+ * Behaves as if svn::client::checkout() were invoked from a thread
+ * of @a exec.
+ *
+ * @warning Any callbacks registered in @a ctx may be called in the
+ *          context of a different thread than the one that created
+ *          this asynchronous operation.
+ */
+svnxx::detail::future<revision::number>
+checkout(executor& exec, context& ctx, const char* url, const char* path,
+         const revision& peg_rev, const revision& rev,
+         depth depth_, checkout_flags flags);
+
+} // namespace async
+} // namespace client
+} // namespace svnxx
+} // namespace subversion
+} // namespace apache
+
+#endif  // SVNXX_CLIENT_CHECKOUT_HPP
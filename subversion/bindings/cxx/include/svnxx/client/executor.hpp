@@ -0,0 +1,78 @@
+/**
+ * @file svnxx/client/executor.hpp
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+#ifndef SVNXX_CLIENT_EXECUTOR_HPP
+#define SVNXX_CLIENT_EXECUTOR_HPP
+
+#include <memory>
+
+#include "svnxx/detail/noncopyable.hpp"
+
+namespace apache {
+namespace subversion {
+namespace svnxx {
+namespace client {
+
+namespace detail {
+class executor;
+} // namespace detail
+
+/**
+ * @ingroup svnxx_client
+ * @brief A pool of worker threads for asynchronous client operations.
+ *
+ * Asynchronous operations that take an @c executor queue their work
+ * on it instead of starting a new thread for every call, so that an
+ * application can share one executor between many concurrent
+ * operations and bound the number of threads they use.
+ *
+ * Operations that run at the same time must use different
+ * svn::client::context objects.
+ *
+ * Destroying the executor waits until all queued operations have
+ * finished.
+ */
+class executor : private svnxx::detail::noncopyable
+{
+public:
+  /**
+   * @brief Create an executor with @a thread_count worker threads.
+   *
+   * If @a thread_count is @c 0, use as many threads as the system
+   * reports hardware threads, or one if it doesn't know.
+   */
+  explicit executor(unsigned thread_count = 0);
+  ~executor();
+
+private:
+  friend class detail::executor;
+  std::unique_ptr<detail::executor> impl;
+};
+
+} // namespace client
+} // namespace svnxx
+} // namespace subversion
+} // namespace apache
+
+#endif  // SVNXX_CLIENT_EXECUTOR_HPP
@@ -0,0 +1,135 @@
+/**
+ * @file svnxx/client/log.hpp
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+#ifndef SVNXX_CLIENT_LOG_HPP
+#define SVNXX_CLIENT_LOG_HPP
+
+#include <cstdint>
+#include <functional>
+
+#include "svnxx/detail/future.hpp"
+#include "svnxx/client/context.hpp"
+#include "svnxx/client/executor.hpp"
+
+#include "svnxx/revision.hpp"
+
+namespace apache {
+namespace subversion {
+namespace svnxx {
+namespace client {
+
+/**
+ * @brief A log message, as passed to a @c log_callback.
+ *
+ * The strings belong to the log operation and are only valid until
+ * the callback returns; they are null if the revision doesn't have
+ * the respective property or it can't be read.
+ */
+struct log_entry
+{
+  svnxx::revision::number revision; ///< The revision of this message.
+  const char* author;               ///< The author of the revision.
+  const char* date;                 ///< The date of the revision.
+  const char* message;              ///< The log message of the revision.
+  bool has_children;                ///< Whether merged revisions follow.
+};
+
+/**
+ * @brief The callback that receives the messages of a log operation.
+ */
+using log_callback = std::function<void(const log_entry& entry)>;
+
+/**
+ * @brief Flags that modify the behaviour of the log operation.
+ * @see svn_client_log5
+ */
+enum class log_flags : std::uint_least32_t
+  {
+    empty                    = 0U,
+    strict_node_history      = 1U << 0,
+    include_merged_revisions = 1U << 1,
+  };
+
+/**
+ * @brief Bitwise conjunction operator for @c log_flags.
+ */
+inline log_flags operator&(log_flags a, log_flags b)
+{
+  return log_flags(std::uint_least32_t(a) & std::uint_least32_t(b));
+}
+
+/**
+ * @brief Bitwise disjunction operator for  @c log_flags.
+ */
+inline log_flags operator|(log_flags a, log_flags b)
+{
+  return log_flags(std::uint_least32_t(a) | std::uint_least32_t(b));
+}
+
+/**
+ * @ingroup svnxx_client
+ * @brief Retrieve the log messages of @a path_or_url.
+ * @param ctx the #context object to use for this operation
+ * @param path_or_url the working copy path or URL whose history to show
+ * @param peg_rev the revision in which @a path_or_url is valid
+ * @param start the first revision to show
+ * @param end the last revision to show
+ * @param limit the maximum number of messages to show, or @c 0 for all
+ * @param flags a combination of @c log_flags
+ * @param callback a function that will be called for each log message;
+ *        it may throw svn::stop_iteration to end the operation early
+ * @see svn_client_log5
+ */
+void
+log(context& ctx, const char* path_or_url,
+    const revision& peg_rev, const revision& start, const revision& end,
+    int limit, log_flags flags, log_callback callback);
+
+namespace async {
+
+/**
+ * @ingroup svnxx_client
+ * @brief Retrieve the log messages of @a path_or_url asynchronously,
+ *        using one of the threads of @a exec.
+ *
+ * Behaves as if svn::client::log() were invoked from a thread
+ * of @a exec.
+ *
+ * @warning Any callbacks registered in @a ctx, as well as the log
+ *          @a callback itself, may be called in the context of a
+ *          different thread than the one that created this
+ *          asynchronous operation.
+ */
+svnxx::detail::future<void>
+log(executor& exec, context& ctx, const char* path_or_url,
+    const revision& peg_rev, const revision& start, const revision& end,
+    int limit, log_flags flags, log_callback callback);
+
+} // namespace async
+} // namespace client
+} // namespace svnxx
+} // namespace subversion
+} // namespace apache
+
+#endif  // SVNXX_CLIENT_LOG_HPP
@@ -30,6 +30,7 @@
 
 #include "svnxx/detail/future.hpp"
 #include "svnxx/client/context.hpp"
+#include "svnxx/client/executor.hpp"
 
 #include "svnxx/depth.hpp"
 #include "svnxx/revision.hpp"
@@ -129,6 +130,17 @@ status(context& ctx, const char* path,
        const revision& rev, depth depth_, status_flags flags,
        status_callback callback);
 
+/**
+ * @overload
+ * @ingroup svnxx_client
+ * @brief Perform an asynchronous status operation on @a path
+ *        using one of the threads of @a exec.
+ */
+svnxx::detail::future<revision::number>
+status(executor& exec, context& ctx, const char* path,
+       const revision& rev, depth depth_, status_flags flags,
+       status_callback callback);
+
 } // namespace async
 } // namespace client
 } // namespace svnxx
@@ -0,0 +1,111 @@
+/**
+ * @file svnxx/client/update.hpp
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+#ifndef SVNXX_CLIENT_UPDATE_HPP
+#define SVNXX_CLIENT_UPDATE_HPP
+
+#include <cstdint>
+
+#include "svnxx/detail/future.hpp"
+#include "svnxx/client/context.hpp"
+#include "svnxx/client/executor.hpp"
+
+#include "svnxx/depth.hpp"
+#include "svnxx/revision.hpp"
+
+namespace apache {
+namespace subversion {
+namespace svnxx {
+namespace client {
+
+/**
+ * @brief Flags that modify the behaviour of the update operation.
+ * @see svn_client_update4
+ */
+enum class update_flags : std::uint_least32_t
+  {
+    empty                          = 0U,
+    depth_is_sticky                = 1U << 0,
+    ignore_externals               = 1U << 1,
+    allow_unversioned_obstructions = 1U << 2,
+    adds_as_modification           = 1U << 3,
+    make_parents                   = 1U << 4,
+  };
+
+/**
+ * @brief Bitwise conjunction operator for @c update_flags.
+ */
+inline update_flags operator&(update_flags a, update_flags b)
+{
+  return update_flags(std::uint_least32_t(a) & std::uint_least32_t(b));
+}
+
+/**
+ * @brief Bitwise disjunction operator for  @c update_flags.
+ */
+inline update_flags operator|(update_flags a, update_flags b)
+{
+  return update_flags(std::uint_least32_t(a) | std::uint_least32_t(b));
+}
+
+/**
+ * @ingroup svnxx_client
+ * @brief Update the working copy at @a path.
+ * @param ctx the #context object to use for this operation
+ * @param path the working copy path to update
+ * @param rev the revision to update to
+ * @param depth the depth of the operation
+ * @param flags a combination of @c update_flags
+ * @return the revision that @a path was updated to
+ * @see svn_client_update4
+ */
+revision::number
+update(context& ctx, const char* path,
+       const revision& rev, depth depth, update_flags flags);
+
+namespace async {
+
+/**
+ * @ingroup svnxx_client
+ * @brief Perform an asynchronous update of @a path using one of the
+ *        threads of @a exec.
+ *
+ * Behaves as if svn::client::update() were invoked from a thread
+ * of @a exec.
+ *
+ * @warning Any callbacks registered in @a ctx may be called in the
+ *          context of a different thread than the one that created
+ *          this asynchronous operation.
+ */
+svnxx::detail::future<revision::number>
+update(executor& exec, context& ctx, const char* path,
+       const revision& rev, depth depth_, update_flags flags);
+
+} // namespace async
+} // namespace client
+} // namespace svnxx
+} // namespace subversion
+} // namespace apache
+
+#endif  // SVNXX_CLIENT_UPDATE_HPP
@@ -0,0 +1,123 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+
+#include "svnxx/client/cat.hpp"
+
+#include "aprwrap.hpp"
+#include "private.hpp"
+
+#include "svn_client.h"
+#include "svn_io.h"
+
+namespace apache {
+namespace subversion {
+namespace svnxx {
+
+namespace impl {
+namespace {
+using cat_callback = client::cat_callback;
+
+struct cat_func
+{
+  cat_callback& proxy;
+
+  // Implements svn_write_fn_t for the stream that receives the
+  // contents, passing them on without copying them.
+  static svn_error_t* write(void* baton, const char* data, apr_size_t* len)
+    {
+      const auto self = static_cast<cat_func*>(baton);
+      if (self->proxy)
+        {
+          try
+            {
+              self->proxy(data, *len);
+            }
+          catch (const stop_iteration&)
+            {
+              return impl::iteration_stopped();
+            }
+        }
+      return SVN_NO_ERROR;
+    }
+};
+} // anonymous namespace
+
+void
+cat(svn_client_ctx_t* ctx, const char* path_or_url,
+    const svn_opt_revision_t* peg_rev, const svn_opt_revision_t* rev,
+    bool expand_keywords, cat_callback callback_, apr_pool_t* scratch_pool)
+{
+  cat_func callback{callback_};
+  svn_stream_t* const out = svn_stream_create(&callback, scratch_pool);
+
+  svn_stream_set_write(out, cat_func::write);
+  impl::checked_call(
+      svn_client_cat3(nullptr, out, path_or_url, peg_rev, rev,
+                      expand_keywords, ctx, scratch_pool, scratch_pool));
+}
+
+} // namespace impl
+namespace client {
+
+void
+cat(context& ctx_, const char* path_or_url,
+    const revision& peg_rev_, const revision& rev_,
+    bool expand_keywords, cat_callback callback)
+{
+  const auto ctx = impl::unwrap(ctx_);
+  const auto peg_rev = impl::convert(peg_rev_);
+  const auto rev = impl::convert(rev_);
+  const auto scratch_pool = apr::pool(&ctx->get_pool());
+  impl::cat(ctx->get_ctx(), path_or_url, &peg_rev, &rev, expand_keywords,
+            callback, scratch_pool.get());
+}
+
+namespace async {
+
+svnxx::detail::future<void>
+cat(executor& exec, context& ctx_, const char* path_or_url,
+    const revision& peg_rev_, const revision& rev_,
+    bool expand_keywords, cat_callback callback)
+{
+  detail::weak_context_ptr weak_ctx = impl::unwrap(ctx_);
+  return impl::submit<void>(
+      exec,
+      [weak_ctx, path_or_url, peg_rev_, rev_, expand_keywords, callback]
+        {
+          auto ctx = weak_ctx.lock();
+          if (!ctx)
+            return;
+
+          const auto peg_rev = impl::convert(peg_rev_);
+          const auto rev = impl::convert(rev_);
+          const auto scratch_pool = apr::pool(&ctx->get_pool());
+
+          impl::cat(ctx->get_ctx(), path_or_url, &peg_rev, &rev,
+                    expand_keywords, callback, scratch_pool.get());
+        });
+}
+
+} // namespace async
+} // namespace client
+} // namespace svnxx
+} // namespace subversion
+} // namespace apache
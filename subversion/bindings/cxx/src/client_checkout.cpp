@@ -0,0 +1,100 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+
+#include "svnxx/client/checkout.hpp"
+
+#include "aprwrap.hpp"
+#include "private.hpp"
+
+#include "svn_client.h"
+
+namespace apache {
+namespace subversion {
+namespace svnxx {
+
+namespace impl {
+
+revision::number
+checkout(svn_client_ctx_t* ctx, const char* url, const char* path,
+         const svn_opt_revision_t* peg_rev, const svn_opt_revision_t* rev,
+         depth depth_, client::checkout_flags flags,
+         apr_pool_t* scratch_pool)
+{
+  using checkout_flags = client::checkout_flags;
+  svn_revnum_t result;
+
+  impl::checked_call(
+      svn_client_checkout3(&result, url, path, peg_rev, rev,
+                           impl::convert(depth_),
+                           bool(flags & checkout_flags::ignore_externals),
+                           bool(flags & checkout_flags::
+                                        allow_unversioned_obstructions),
+                           ctx, scratch_pool));
+  return revision::number(result);
+}
+
+} // namespace impl
+namespace client {
+
+revision::number
+checkout(context& ctx_, const char* url, const char* path,
+         const revision& peg_rev_, const revision& rev_,
+         depth depth_, checkout_flags flags)
+{
+  const auto ctx = impl::unwrap(ctx_);
+  const auto peg_rev = impl::convert(peg_rev_);
+  const auto rev = impl::convert(rev_);
+  const auto scratch_pool = apr::pool(&ctx->get_pool());
+  return impl::checkout(ctx->get_ctx(), url, path, &peg_rev, &rev,
+                        depth_, flags, scratch_pool.get());
+}
+
+namespace async {
+
+svnxx::detail::future<revision::number>
+checkout(executor& exec, context& ctx_, const char* url, const char* path,
+         const revision& peg_rev_, const revision& rev_,
+         depth depth_, checkout_flags flags)
+{
+  detail::weak_context_ptr weak_ctx = impl::unwrap(ctx_);
+  return impl::submit<revision::number>(
+      exec,
+      [weak_ctx, url, path, peg_rev_, rev_, depth_, flags]
+        {
+          auto ctx = weak_ctx.lock();
+          if (!ctx)
+            return revision::number::invalid;
+
+          const auto peg_rev = impl::convert(peg_rev_);
+          const auto rev = impl::convert(rev_);
+          const auto scratch_pool = apr::pool(&ctx->get_pool());
+
+          return impl::checkout(ctx->get_ctx(), url, path, &peg_rev, &rev,
+                                depth_, flags, scratch_pool.get());
+        });
+}
+
+} // namespace async
+} // namespace client
+} // namespace svnxx
+} // namespace subversion
+} // namespace apache
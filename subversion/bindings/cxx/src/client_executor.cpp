@@ -0,0 +1,107 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+
+#include "private/executor_private.hpp"
+
+namespace apache {
+namespace subversion {
+namespace svnxx {
+namespace client {
+
+//
+// class detail::executor
+//
+
+namespace detail {
+
+executor::executor(unsigned thread_count)
+{
+  if (!thread_count)
+    thread_count = std::thread::hardware_concurrency();
+  if (!thread_count)
+    thread_count = 1;
+
+  threads.reserve(thread_count);
+  for (unsigned i = 0; i < thread_count; ++i)
+    threads.emplace_back(&executor::run, this);
+}
+
+executor::~executor()
+{
+  {
+    std::lock_guard<std::mutex> lock(guard);
+    stopping = true;
+  }
+  wakeup.notify_all();
+
+  for (auto& thread : threads)
+    thread.join();
+}
+
+void executor::submit(std::function<void()> task)
+{
+  {
+    std::lock_guard<std::mutex> lock(guard);
+    queue.push_back(std::move(task));
+  }
+  wakeup.notify_one();
+}
+
+void executor::run()
+{
+  for (;;)
+    {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(guard);
+        wakeup.wait(lock, [this]{ return stopping || !queue.empty(); });
+
+        // Finish the queued work before stopping.
+        if (queue.empty())
+          return;
+
+        task = std::move(queue.front());
+        queue.pop_front();
+      }
+
+      // Tasks are packaged tasks that keep their own exceptions.
+      task();
+    }
+}
+
+} // namespace detail
+
+//
+// class executor
+//
+
+executor::executor(unsigned thread_count)
+  : impl(new detail::executor(thread_count))
+{}
+
+executor::~executor()
+{}
+
+} // namespace client
+} // namespace svnxx
+} // namespace subversion
+} // namespace apache
@@ -0,0 +1,167 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+
+#include "svnxx/client/log.hpp"
+
+#include "aprwrap.hpp"
+#include "private.hpp"
+
+#include "svn_client.h"
+#include "svn_hash.h"
+#include "svn_props.h"
+
+namespace apache {
+namespace subversion {
+namespace svnxx {
+
+namespace impl {
+namespace {
+using log_entry = client::log_entry;
+using log_callback = client::log_callback;
+using log_flags = client::log_flags;
+
+struct log_func
+{
+  log_callback& proxy;
+
+  static const char* revprop(apr_hash_t* revprops, const char* name)
+    {
+      if (!revprops)
+        return nullptr;
+
+      const auto value = static_cast<const svn_string_t*>(
+          svn_hash_gets(revprops, name));
+      return (value ? value->data : nullptr);
+    }
+
+  static svn_error_t* callback(void* baton,
+                               svn_log_entry_t* entry,
+                               apr_pool_t* /*scratch_pool*/)
+    {
+      const auto self = static_cast<log_func*>(baton);
+      if (self->proxy)
+        {
+          // The entry only refers to the data of the C API,
+          // so passing it on doesn't allocate anything.
+          const log_entry proxy_entry{
+            revision::number(entry->revision),
+            revprop(entry->revprops, SVN_PROP_REVISION_AUTHOR),
+            revprop(entry->revprops, SVN_PROP_REVISION_DATE),
+            revprop(entry->revprops, SVN_PROP_REVISION_LOG),
+            bool(entry->has_children)
+          };
+
+          try
+            {
+              self->proxy(proxy_entry);
+            }
+          catch (const stop_iteration&)
+            {
+              return impl::iteration_stopped();
+            }
+        }
+      return SVN_NO_ERROR;
+    }
+};
+} // anonymous namespace
+
+void
+log(svn_client_ctx_t* ctx, const char* path_or_url,
+    const svn_opt_revision_t* peg_rev,
+    const svn_opt_revision_t* start, const svn_opt_revision_t* end,
+    int limit, log_flags flags, log_callback callback_,
+    const apr::pool& scratch_pool)
+{
+  log_func callback{callback_};
+  apr::array<const char*> targets(scratch_pool, 1);
+  apr::array<svn_opt_revision_range_t*> ranges(scratch_pool, 1);
+  apr::array<const char*> revprops(scratch_pool, 3);
+  const auto range = static_cast<svn_opt_revision_range_t*>(
+      apr_palloc(scratch_pool.get(), sizeof(svn_opt_revision_range_t)));
+
+  targets.push(path_or_url);
+  range->start = *start;
+  range->end = *end;
+  ranges.push(range);
+  revprops.push(SVN_PROP_REVISION_AUTHOR);
+  revprops.push(SVN_PROP_REVISION_DATE);
+  revprops.push(SVN_PROP_REVISION_LOG);
+
+  impl::checked_call(
+      svn_client_log5(targets.get_array(), peg_rev, ranges.get_array(),
+                      limit,
+                      false, // TODO: discover_changed_paths
+                      bool(flags & log_flags::strict_node_history),
+                      bool(flags & log_flags::include_merged_revisions),
+                      revprops.get_array(),
+                      log_func::callback, &callback,
+                      ctx, scratch_pool.get()));
+}
+
+} // namespace impl
+namespace client {
+
+void
+log(context& ctx_, const char* path_or_url,
+    const revision& peg_rev_, const revision& start_, const revision& end_,
+    int limit, log_flags flags, log_callback callback)
+{
+  const auto ctx = impl::unwrap(ctx_);
+  const auto peg_rev = impl::convert(peg_rev_);
+  const auto start = impl::convert(start_);
+  const auto end = impl::convert(end_);
+  const auto scratch_pool = apr::pool(&ctx->get_pool());
+  impl::log(ctx->get_ctx(), path_or_url, &peg_rev, &start, &end,
+            limit, flags, callback, scratch_pool);
+}
+
+namespace async {
+
+svnxx::detail::future<void>
+log(executor& exec, context& ctx_, const char* path_or_url,
+    const revision& peg_rev_, const revision& start_, const revision& end_,
+    int limit, log_flags flags, log_callback callback)
+{
+  detail::weak_context_ptr weak_ctx = impl::unwrap(ctx_);
+  return impl::submit<void>(
+      exec,
+      [weak_ctx, path_or_url, peg_rev_, start_, end_, limit, flags, callback]
+        {
+          auto ctx = weak_ctx.lock();
+          if (!ctx)
+            return;
+
+          const auto peg_rev = impl::convert(peg_rev_);
+          const auto start = impl::convert(start_);
+          const auto end = impl::convert(end_);
+          const auto scratch_pool = apr::pool(&ctx->get_pool());
+
+          impl::log(ctx->get_ctx(), path_or_url, &peg_rev, &start, &end,
+                    limit, flags, callback, scratch_pool);
+        });
+}
+
+} // namespace async
+} // namespace client
+} // namespace svnxx
+} // namespace subversion
+} // namespace apache
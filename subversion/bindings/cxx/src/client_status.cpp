@@ -136,6 +136,28 @@ status(context& ctx_, const char* path,
   return status(policy, ctx_, path, rev_, depth_, flags, callback);
 }
 
+svnxx::detail::future<revision::number>
+status(executor& exec, context& ctx_, const char* path,
+       const revision& rev_, depth depth_, status_flags flags,
+       status_callback callback)
+{
+  detail::weak_context_ptr weak_ctx = impl::unwrap(ctx_);
+  return impl::submit<revision::number>(
+      exec,
+      [weak_ctx, path, rev_, depth_, flags, callback]
+        {
+          auto ctx = weak_ctx.lock();
+          if (!ctx)
+            return revision::number::invalid;
+
+          const auto rev = impl::convert(rev_);
+          const auto scratch_pool = apr::pool(&ctx->get_pool());
+
+          return impl::status(ctx->get_ctx(), path, &rev, depth_, flags,
+                              callback, scratch_pool.get());
+        });
+}
+
 } // namespace async
 } // namespace client
 } // namespace svnxx
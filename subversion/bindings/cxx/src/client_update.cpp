@@ -0,0 +1,101 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+
+#include "svnxx/client/update.hpp"
+
+#include "aprwrap.hpp"
+#include "private.hpp"
+
+#include "svn_client.h"
+
+namespace apache {
+namespace subversion {
+namespace svnxx {
+
+namespace impl {
+
+revision::number
+update(svn_client_ctx_t* ctx, const char* path,
+       const svn_opt_revision_t* rev, depth depth_,
+       client::update_flags flags, const apr::pool& scratch_pool)
+{
+  using update_flags = client::update_flags;
+
+  apr::array<const char*> paths(scratch_pool, 1);
+  apr_array_header_t* result_revs;
+
+  paths.push(path);
+  impl::checked_call(
+      svn_client_update4(&result_revs, paths.get_array(), rev,
+                         impl::convert(depth_),
+                         bool(flags & update_flags::depth_is_sticky),
+                         bool(flags & update_flags::ignore_externals),
+                         bool(flags
+                              & update_flags::allow_unversioned_obstructions),
+                         bool(flags & update_flags::adds_as_modification),
+                         bool(flags & update_flags::make_parents),
+                         ctx, scratch_pool.get()));
+  return revision::number(APR_ARRAY_IDX(result_revs, 0, svn_revnum_t));
+}
+
+} // namespace impl
+namespace client {
+
+revision::number
+update(context& ctx_, const char* path,
+       const revision& rev_, depth depth_, update_flags flags)
+{
+  const auto ctx = impl::unwrap(ctx_);
+  const auto rev = impl::convert(rev_);
+  const auto scratch_pool = apr::pool(&ctx->get_pool());
+  return impl::update(ctx->get_ctx(), path, &rev, depth_, flags,
+                      scratch_pool);
+}
+
+namespace async {
+
+svnxx::detail::future<revision::number>
+update(executor& exec, context& ctx_, const char* path,
+       const revision& rev_, depth depth_, update_flags flags)
+{
+  detail::weak_context_ptr weak_ctx = impl::unwrap(ctx_);
+  return impl::submit<revision::number>(
+      exec,
+      [weak_ctx, path, rev_, depth_, flags]
+        {
+          auto ctx = weak_ctx.lock();
+          if (!ctx)
+            return revision::number::invalid;
+
+          const auto rev = impl::convert(rev_);
+          const auto scratch_pool = apr::pool(&ctx->get_pool());
+
+          return impl::update(ctx->get_ctx(), path, &rev, depth_, flags,
+                              scratch_pool);
+        });
+}
+
+} // namespace async
+} // namespace client
+} // namespace svnxx
+} // namespace subversion
+} // namespace apache
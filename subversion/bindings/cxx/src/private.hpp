@@ -32,5 +32,6 @@
 #include "private/tristate_private.hpp"
 
 #include "private/client_context_private.hpp"
+#include "private/executor_private.hpp"
 
 #endif // SVNXX_PRIVATE_PRIVATE_HPP
@@ -0,0 +1,91 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+
+#ifndef SVNXX_PRIVATE_EXECUTOR_HPP
+#define SVNXX_PRIVATE_EXECUTOR_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "svnxx/client/executor.hpp"
+
+#include "../private/future_private.hpp"
+
+namespace apache {
+namespace subversion {
+namespace svnxx {
+namespace client {
+namespace detail {
+
+// The thread pool behind client::executor.
+class executor
+{
+public:
+  explicit executor(unsigned thread_count);
+  ~executor();
+
+  // Queue TASK to be run by one of the worker threads.
+  void submit(std::function<void()> task);
+
+  static executor& unwrap(client::executor& exec) noexcept
+    {
+      return *exec.impl;
+    }
+
+private:
+  void run();
+
+  std::mutex guard;
+  std::condition_variable wakeup;
+  std::deque<std::function<void()>> queue;
+  bool stopping{false};
+  std::vector<std::thread> threads;
+};
+
+} // namespace detail
+} // namespace client
+namespace impl {
+
+// Run FUNC on one of the threads of EXEC and return a future for its
+// result. Exceptions thrown by FUNC are stored in the future.
+template<typename T, typename Func>
+inline future<T> submit(client::executor& exec, Func func)
+{
+  const auto task = std::make_shared<std::packaged_task<T()>>(std::move(func));
+  auto result = task->get_future();
+
+  client::detail::executor::unwrap(exec).submit([task]{ (*task)(); });
+  return future<T>(std::move(result), make_future_result());
+}
+
+} // namespace impl
+} // namespace svnxx
+} // namespace subversion
+} // namespace apache
+
+#endif // SVNXX_PRIVATE_EXECUTOR_HPP
@@ -68,4 +68,19 @@ BOOST_AUTO_TEST_CASE(async_example,
   std::cout << "got revision: " << long(future.get()) << std::endl;
 }
 
+BOOST_AUTO_TEST_CASE(executor_example,
+                     * boost::unit_test::disabled())
+{
+  svn::client::executor exec(2);
+  svn::client::context ctx;
+  auto future = svn::client::async::status(exec, ctx, working_copy_root,
+                                           svn::revision(),
+                                           svn::depth::unknown,
+                                           svn::client::status_flags::empty,
+                                           status_callback);
+  BOOST_TEST(future.valid());
+  future.wait();
+  std::cout << "got revision: " << long(future.get()) << std::endl;
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -26,7 +26,6 @@
 
 #include "InputStream.h"
 #include "JNIUtil.h"
-#include "JNIByteArray.h"
 
 /**
  * Create an InputStream object.
@@ -35,12 +34,16 @@
 InputStream::InputStream(jobject jthis)
 {
   m_jthis = jthis;
+  m_jbuffer = NULL;
+  m_jbuffer_size = 0;
 }
 
 InputStream::~InputStream()
 {
   // The m_jthis does not need to be destroyed, because it is the
   // passed in parameter to the Java method.
+  if (m_jbuffer)
+    JNIUtil::getEnv()->DeleteGlobalRef(m_jbuffer);
 }
 
 /**
@@ -85,20 +88,38 @@ svn_error_t *InputStream::read(void *baton, char *buffer, apr_size_t *len)
       if (JNIUtil::isJavaExceptionThrown())
         return SVN_NO_ERROR;
 
-      mid = env->GetMethodID(clazz, "read", "([B)I");
+      mid = env->GetMethodID(clazz, "read", "([BII)I");
       if (JNIUtil::isJavaExceptionThrown() || mid == 0)
         return SVN_NO_ERROR;
 
       env->DeleteLocalRef(clazz);
     }
 
-  // Allocate a Java byte array to read the data.
-  jbyteArray data = JNIUtil::makeJByteArray(buffer, static_cast<int>(*len));
-  if (JNIUtil::isJavaExceptionThrown())
-    return SVN_NO_ERROR;
+  // Allocate a Java byte array to read the data, unless the one from
+  // the last call is large enough.
+  if (that->m_jbuffer_size < static_cast<jsize>(*len))
+    {
+      if (that->m_jbuffer)
+        {
+          env->DeleteGlobalRef(that->m_jbuffer);
+          that->m_jbuffer = NULL;
+          that->m_jbuffer_size = 0;
+        }
+
+      jbyteArray data = env->NewByteArray(static_cast<jsize>(*len));
+      if (JNIUtil::isJavaExceptionThrown())
+        return SVN_NO_ERROR;
+
+      that->m_jbuffer = static_cast<jbyteArray>(env->NewGlobalRef(data));
+      env->DeleteLocalRef(data);
+      if (JNIUtil::isJavaExceptionThrown())
+        return SVN_NO_ERROR;
+      that->m_jbuffer_size = static_cast<jsize>(*len);
+    }
 
   // Read the data.
-  jint jread = env->CallIntMethod(that->m_jthis, mid, data);
+  jint jread = env->CallIntMethod(that->m_jthis, mid, that->m_jbuffer,
+                                  jint(0), static_cast<jint>(*len));
   if (JNIUtil::isJavaExceptionThrown())
     return SVN_NO_ERROR;
 
@@ -110,20 +131,19 @@ svn_error_t *InputStream::read(void *baton, char *buffer, apr_size_t *len)
       jread = 0;
     }
 
-  // Put the Java byte array into a helper object to retrieve the
-  // data bytes.
-  JNIByteArray outdata(data, true);
-  if (JNIUtil::isJavaExceptionThrown())
-    return SVN_NO_ERROR;
-
   // Catch when the Java method tells us it read too much data.
   if (jread > (jint) *len)
     jread = 0;
 
-  // In the case of success copy the data back to the Subversion
-  // buffer.
+  // In the case of success copy only the bytes that were read back to
+  // the Subversion buffer.
   if (jread > 0)
-    memcpy(buffer, outdata.getBytes(), jread);
+    {
+      env->GetByteArrayRegion(that->m_jbuffer, 0, jread,
+                              reinterpret_cast<jbyte *>(buffer));
+      if (JNIUtil::isJavaExceptionThrown())
+        return SVN_NO_ERROR;
+    }
 
   // Copy the number of read bytes back to Subversion.
   *len = jread;
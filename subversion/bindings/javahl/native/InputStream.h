@@ -42,6 +42,14 @@ class InputStream
    * A local reference to the Java object.
    */
   jobject m_jthis;
+
+  /**
+   * A global reference to the Java array that read() passes to the
+   * Java object, kept so that every call can use the same array.
+   */
+  jbyteArray m_jbuffer;
+  jsize m_jbuffer_size;
+
   static svn_error_t *read(void *baton, char *buffer, apr_size_t *len);
   static svn_error_t *close(void *baton);
  public:
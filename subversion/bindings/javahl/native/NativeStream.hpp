@@ -118,6 +118,12 @@ public:
             ::Java::ByteArray::MutableContents& dst,
             jint offset, jint length);
 
+  /**
+   * Implements @c NativeInputStream.read(ByteBuffer).
+   * A direct buffer @a dst is filled in place.
+   */
+  jint read(::Java::Env env, jobject dst);
+
   /**
    * Implements @c InputStream.skip(long).
    */
@@ -199,6 +205,12 @@ public:
              const ::Java::ByteArray::Contents& src,
              jint offset, jint length);
 
+  /**
+   * Implements @c NativeOutputStream.write(ByteBuffer).
+   * The contents of a direct buffer @a src are written in place.
+   */
+  jint write(::Java::Env env, jobject src);
+
 private:
   virtual void dispose(jobject jthis);
 
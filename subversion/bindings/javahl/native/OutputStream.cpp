@@ -26,7 +26,13 @@
 
 #include "OutputStream.h"
 #include "JNIUtil.h"
-#include "JNIByteArray.h"
+
+namespace {
+/* Number of bytes collected before they are passed to the Java object.
+   Many small writes, like the lines of a diff, cost one JNI call
+   together instead of one each. */
+const apr_size_t BUFFER_SIZE = 64 * 1024;
+}
 
 /**
  * Create an OutputStream object.
@@ -35,6 +41,10 @@
 OutputStream::OutputStream(jobject jthis)
 {
   m_jthis = jthis;
+  m_pool = NULL;
+  m_buffer = NULL;
+  m_buffered = 0;
+  m_jbuffer = NULL;
 }
 
 /**
@@ -48,12 +58,31 @@ OutputStream::~OutputStream()
 
 /**
  * Create a svn_stream_t structure for this object.  This will be used
- * as an output stream by Subversion.
+ * as an output stream by Subversion.  Buffered data is passed to the
+ * Java object at the latest when @a pool is cleared.
  * @param pool  the pool, from which the structure is allocated
  * @return the output stream
  */
 svn_stream_t *OutputStream::getStream(const SVN::Pool &pool)
 {
+  // Data buffered for an earlier stream must not be lost.
+  if (m_pool)
+    apr_pool_cleanup_run(m_pool, this, OutputStream::cleanup);
+
+  JNIEnv *env = JNIUtil::getEnv();
+  jbyteArray jbuffer = env->NewByteArray(BUFFER_SIZE);
+  if (!JNIUtil::isJavaExceptionThrown())
+    {
+      m_jbuffer = static_cast<jbyteArray>(env->NewGlobalRef(jbuffer));
+      env->DeleteLocalRef(jbuffer);
+    }
+
+  m_pool = pool.getPool();
+  m_buffer = static_cast<char *>(apr_palloc(m_pool, BUFFER_SIZE));
+  m_buffered = 0;
+  apr_pool_cleanup_register(m_pool, this, OutputStream::cleanup,
+                            apr_pool_cleanup_null);
+
   // Create a stream with this as the baton and set the write and
   // close functions.
   svn_stream_t *ret = svn_stream_create(this, pool.getPool());
@@ -63,20 +92,15 @@ svn_stream_t *OutputStream::getStream(const SVN::Pool &pool)
 }
 
 /**
- * Implements svn_write_fn_t to write data out from Subversion.
- * @param baton     an OutputStream object for the callback
- * @param buffer    the buffer for the write data
- * @param len       on input the buffer len, on output the number of written
- *                  bytes
+ * Pass the buffered data to the Java object.
  * @return a subversion error or SVN_NO_ERROR
  */
-svn_error_t *OutputStream::write(void *baton, const char *buffer,
-                                 apr_size_t *len)
+svn_error_t *OutputStream::flush()
 {
-  JNIEnv *env = JNIUtil::getEnv();
+  if (m_buffered == 0 || m_jbuffer == NULL)
+    return SVN_NO_ERROR;
 
-  // An object of our class is passed in as the baton.
-  OutputStream *that = static_cast<OutputStream *>(baton);
+  JNIEnv *env = JNIUtil::getEnv();
 
   // The method id will not change during the time this library is
   // loaded, so it can be cached.
@@ -85,30 +109,96 @@ svn_error_t *OutputStream::write(void *baton, const char *buffer,
     {
       jclass clazz = env->FindClass("java/io/OutputStream");
       if (JNIUtil::isJavaExceptionThrown())
-        return SVN_NO_ERROR;
+        return JNIUtil::wrapJavaException();
 
-      mid = env->GetMethodID(clazz, "write", "([B)V");
+      mid = env->GetMethodID(clazz, "write", "([BII)V");
       if (JNIUtil::isJavaExceptionThrown() || mid == 0)
-        return SVN_NO_ERROR;
+        return JNIUtil::wrapJavaException();
 
       env->DeleteLocalRef(clazz);
     }
 
-  // convert the data to a Java byte array
-  jbyteArray data = JNIUtil::makeJByteArray(buffer, static_cast<int>(*len));
+  // copy the data to the Java byte array
+  env->SetByteArrayRegion(m_jbuffer, 0, static_cast<jsize>(m_buffered),
+                          reinterpret_cast<const jbyte *>(m_buffer));
   if (JNIUtil::isJavaExceptionThrown())
-    return SVN_NO_ERROR;
+    return JNIUtil::wrapJavaException();
 
   // write the data
-  env->CallObjectMethod(that->m_jthis, mid, data);
-  if (JNIUtil::isJavaExceptionThrown())
-    return SVN_NO_ERROR;
+  env->CallVoidMethod(m_jthis, mid, m_jbuffer,
+                      jint(0), static_cast<jint>(m_buffered));
+  m_buffered = 0;
 
-  env->DeleteLocalRef(data);
+  return JNIUtil::wrapJavaException();
+}
+
+/**
+ * Implements svn_write_fn_t to write data out from Subversion.
+ * @param baton     an OutputStream object for the callback
+ * @param buffer    the buffer for the write data
+ * @param len       on input the buffer len, on output the number of written
+ *                  bytes
+ * @return a subversion error or SVN_NO_ERROR
+ */
+svn_error_t *OutputStream::write(void *baton, const char *buffer,
+                                 apr_size_t *len)
+{
+  // An object of our class is passed in as the baton.
+  OutputStream *that = static_cast<OutputStream *>(baton);
+  apr_size_t remaining = *len;
+
+  if (that->m_jbuffer == NULL)
+    return JNIUtil::wrapJavaException();
+
+  // Collect the data, passing it on whenever the buffer is full.
+  while (remaining > 0)
+    {
+      apr_size_t count = BUFFER_SIZE - that->m_buffered;
+      if (count > remaining)
+        count = remaining;
+
+      memcpy(that->m_buffer + that->m_buffered, buffer, count);
+      that->m_buffered += count;
+      buffer += count;
+      remaining -= count;
+
+      if (that->m_buffered == BUFFER_SIZE)
+        SVN_ERR(that->flush());
+    }
 
   return SVN_NO_ERROR;
 }
 
+/**
+ * Implements apr_pool_cleanup_t to pass the remaining data to the Java
+ * object and release the Java array when the stream's pool goes away.
+ * A Java exception thrown while writing stays pending for the caller.
+ * @param baton     an OutputStream object
+ * @return APR_SUCCESS
+ */
+apr_status_t OutputStream::cleanup(void *baton)
+{
+  OutputStream *that = static_cast<OutputStream *>(baton);
+
+  if (that->m_jbuffer != NULL)
+    {
+      if (!JNIUtil::isJavaExceptionThrown())
+        {
+          svn_error_t *err = that->flush();
+          if (err)
+            JNIUtil::handleSVNError(err);
+        }
+
+      JNIUtil::getEnv()->DeleteGlobalRef(that->m_jbuffer);
+      that->m_jbuffer = NULL;
+    }
+
+  that->m_buffer = NULL;
+  that->m_buffered = 0;
+  that->m_pool = NULL;
+  return APR_SUCCESS;
+}
+
 /**
  * Implements svn_close_fn_t to close the output stream.
  * @param baton     an OutputStream object for the callback
@@ -121,6 +211,9 @@ svn_error_t *OutputStream::close(void *baton)
   // An object of our class is passed in as the baton
   OutputStream *that = reinterpret_cast<OutputStream*>(baton);
 
+  // Pass on what is still buffered before closing the Java object.
+  SVN_ERR(that->flush());
+
   // The method id will not change during the time this library is
   // loaded, so it can be cached.
   static jmethodID mid = 0;
@@ -41,9 +41,26 @@ class OutputStream
    * A local reference to the Java object.
    */
   jobject m_jthis;
+
+  /**
+   * Data written by Subversion that has not been passed to the Java
+   * object yet, allocated from m_pool, the pool passed to getStream().
+   */
+  apr_pool_t *m_pool;
+  char *m_buffer;
+  apr_size_t m_buffered;
+
+  /**
+   * A global reference to the Java array used to pass m_buffer to
+   * the Java object, so that every call uses the same array.
+   */
+  jbyteArray m_jbuffer;
+
+  svn_error_t *flush();
   static svn_error_t *write(void *baton,
                             const char *buffer, apr_size_t *len);
   static svn_error_t *close(void *baton);
+  static apr_status_t cleanup(void *baton);
  public:
   OutputStream(jobject jthis);
   ~OutputStream();
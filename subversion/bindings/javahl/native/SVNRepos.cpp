@@ -269,9 +269,9 @@ void SVNRepos::hotcopy(File &path, File &targetPath,
       return;
     }
 
-  SVN_JNI_ERR(svn_repos_hotcopy3(path.getInternalStyle(requestPool),
+  SVN_JNI_ERR(svn_repos_hotcopy4(path.getInternalStyle(requestPool),
                                  targetPath.getInternalStyle(requestPool),
-                                 cleanLogs, incremental,
+                                 cleanLogs, incremental, NULL,
                                  notifyCallback != NULL
                                     ? ReposNotifyCallback::notify
                                     : NULL,
@@ -27,6 +27,7 @@ import org.apache.subversion.javahl.NativeResources;
 
 import java.io.IOException;
 import java.io.OutputStream;
+import java.nio.ByteBuffer;
 
 /**
  * Implementation class for {@link OutputStream} objects returned from
@@ -67,6 +68,16 @@ public class NativeOutputStream extends OutputStream
     @Override
     public native void write(byte[] b, int off, int len) throws IOException;
 
+    /**
+     * Writes the remaining bytes of <code>src</code> to the underlying
+     * native stream and advances its position.  The contents of a
+     * direct buffer are written in place, without copying them
+     * through a Java array.
+     * @return the number of bytes written.
+     * @since 1.15
+     */
+    public native int write(ByteBuffer src) throws IOException;
+
 
     private long cppAddr;
 
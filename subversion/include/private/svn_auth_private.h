@@ -241,6 +241,18 @@ svn_auth__make_session_auth(svn_auth_baton_t **session_auth_baton,
                             apr_pool_t *result_pool,
                             apr_pool_t *scratch_pool);
 
+/* Set *COPY to a copy of the top-level AUTH_BATON that uses the same
+   providers and starts out with the same parameters and cached
+   credentials, but updates its own.  Allocate *COPY in RESULT_POOL,
+   which is also used for the credentials cached later.
+
+   Unlike AUTH_BATON itself, the copy may be used by another thread, as
+   long as the providers of AUTH_BATON can be used by several threads. */
+void
+svn_auth__copy_baton(svn_auth_baton_t **copy,
+                     const svn_auth_baton_t *auth_baton,
+                     apr_pool_t *result_pool);
+
 #if (defined(WIN32) && !defined(__MINGW32__)) || defined(DOXYGEN)
 /**
  * Set @a *provider to an authentication provider that implements
@@ -1,5 +1,5 @@
-/* batch_fsync.h --- efficiently fsync multiple targets
- *
+/**
+ * @copyright
  * ====================================================================
  *    Licensed to the Apache Software Foundation (ASF) under one
  *    or more contributor license agreements.  See the NOTICE file
@@ -18,48 +18,64 @@
  *    specific language governing permissions and limitations
  *    under the License.
  * ====================================================================
+ * @endcopyright
+ *
+ * @file svn_batch_fsync.h
+ * @brief Efficiently fsync multiple targets
  */
 
-#ifndef SVN_LIBSVN_FS_X__BATCH_FSYNC_H
-#define SVN_LIBSVN_FS_X__BATCH_FSYNC_H
+#ifndef SVN_BATCH_FSYNC_H
+#define SVN_BATCH_FSYNC_H
 
+#include <apr_pools.h>
+#include <apr_file_io.h>
+
+#include "svn_types.h"
 #include "svn_error.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
 /* Infrastructure for efficiently calling fsync on files and directories.
  *
  * The idea is to have a container of open file handles (including
  * directory handles on POSIX), at most one per file.  During the course
- * of an FS operation that needs to be fsync'ed, all touched files and
+ * of an operation that needs to be fsync'ed, all touched files and
  * folders accumulate in the container.
  *
- * At the end of the FS operation, all file changes will be written the
+ * At the end of the operation, all file changes will be written the
  * physical disk, once per file and folder.  Afterwards, all handles will
  * be closed and the container is ready for reuse.
  *
  * To minimize the delay caused by the batch flush, run all fsync calls
- * concurrently - if the OS supports multi-threading.
+ * concurrently - if the OS supports multi-threading.  All batches within
+ * the process share the same worker threads.  Hence, the number of
+ * threads and of fsyncs in flight is limited process-wide, no matter how
+ * many repositories, working copies etc. are being written to.
  */
 
 /* Opaque container type.
  */
-typedef struct svn_fs_x__batch_fsync_t svn_fs_x__batch_fsync_t;
+typedef struct svn_batch_fsync__t svn_batch_fsync__t;
 
 /* Initialize the concurrent fsync infrastructure.  Clean it up when
  * OWNING_POOL gets cleared.
  *
  * This function must be called before using any of the other functions in
- * in this module.  It should only be called once.
+ * in this module.  Calling it again while the infrastructure is still alive
+ * has no effect.
  */
 svn_error_t *
-svn_fs_x__batch_fsync_init(apr_pool_t *owning_pool);
+svn_batch_fsync__init(apr_pool_t *owning_pool);
 
 /* Set *RESULT_P to a new batch fsync structure, allocated in RESULT_POOL.
  * If FLUSH_TO_DISK is not set, the resulting struct will not actually use
  * fsync. */
 svn_error_t *
-svn_fs_x__batch_fsync_create(svn_fs_x__batch_fsync_t **result_p,
-                             svn_boolean_t flush_to_disk,
-                             apr_pool_t *result_pool);
+svn_batch_fsync__create(svn_batch_fsync__t **result_p,
+                        svn_boolean_t flush_to_disk,
+                        apr_pool_t *result_pool);
 
 /* Open the file at FILENAME for read and write access.  Return it in *FILE
  * and schedule it for fsync in BATCH.  If BATCH already contains an open
@@ -67,10 +83,10 @@ svn_fs_x__batch_fsync_create(svn_fs_x__batch_fsync_t **result_p,
  *
  * Use SCRATCH_POOL for temporaries. */
 svn_error_t *
-svn_fs_x__batch_fsync_open_file(apr_file_t **file,
-                                svn_fs_x__batch_fsync_t *batch,
-                                const char *filename,
-                                apr_pool_t *scratch_pool);
+svn_batch_fsync__open_file(apr_file_t **file,
+                           svn_batch_fsync__t *batch,
+                           const char *filename,
+                           apr_pool_t *scratch_pool);
 
 /* Inform the BATCH that a file or directory has been created at PATH.
  * "Created" means either newly created to renamed to PATH - even if another
@@ -79,14 +95,18 @@ svn_fs_x__batch_fsync_open_file(apr_file_t **file,
  *
  * Use SCRATCH_POOL for temporaries. */
 svn_error_t *
-svn_fs_x__batch_fsync_new_path(svn_fs_x__batch_fsync_t *batch,
-                               const char *path,
-                               apr_pool_t *scratch_pool);
+svn_batch_fsync__new_path(svn_batch_fsync__t *batch,
+                          const char *path,
+                          apr_pool_t *scratch_pool);
 
 /* For all files and directories in BATCH, flush all changes to disk and
  * close the file handles.  Use SCRATCH_POOL for temporaries. */
 svn_error_t *
-svn_fs_x__batch_fsync_run(svn_fs_x__batch_fsync_t *batch,
-                          apr_pool_t *scratch_pool);
+svn_batch_fsync__run(svn_batch_fsync__t *batch,
+                     apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
 
-#endif
+#endif /* SVN_BATCH_FSYNC_H */
@@ -110,6 +110,11 @@ typedef svn_error_t *(*svn_cache__error_handler_t)(svn_error_t *err,
  */
 typedef struct svn_memcache_t svn_memcache_t;
 
+/**
+ * A set of Redis servers with client-side consistent hashing.
+ */
+typedef struct svn_redis_t svn_redis_t;
+
 /**
  * An opaque structure representing a membuffer cache object.
  */
@@ -140,6 +145,12 @@ typedef struct svn_cache__info_t
    */
   apr_uint64_t hits;
 
+  /** Number of those @a hits that were served from a cache partition
+   * not local to the calling thread's NUMA node.  Always 0 for caches
+   * that are not partitioned.
+   */
+  apr_uint64_t remote_hits;
+
   /** Number of setter calls (svn_cache__set()).
    */
   apr_uint64_t sets;
@@ -174,6 +185,20 @@ typedef struct svn_cache__info_t
    */
   apr_uint64_t total_entries;
 
+  /** Part of @a data_size that is currently assigned to the first cache
+   * level.  May be 0 if the cache does not use levels.
+   */
+  apr_uint64_t l1_size;
+
+  /** Number of times that @a l1_size has been adapted to the workload.
+   */
+  apr_uint64_t l1_resizes;
+
+  /** Number of key prefixes whose items are currently being stored with
+   * a reduced priority because they rarely get read back.
+   */
+  apr_uint64_t demoted_prefixes;
+
   /** Number of index buckets with the given number of entries.
    * Bucket sizes larger than the array will saturate into the
    * highest array index.
@@ -181,6 +206,58 @@ typedef struct svn_cache__info_t
   apr_uint64_t histogram[32];
 } svn_cache__info_t;
 
+/**
+ * Cumulative access statistics of all membuffer cache front-ends that
+ * share the same prefix class.  The class is the part of the cache prefix
+ * after its last colon, e.g. "TEXT", "DIR" or "NODEREVS" for FSFS, i.e.
+ * it identifies the type of data across all repositories.
+ */
+typedef struct svn_cache__prefix_stats_t
+{
+  /** Name of the prefix class.  "(other)" collects everything that could
+   * not be attributed to a specific class. */
+  const char *name;
+
+  /** Number of getter calls. */
+  apr_uint64_t gets;
+
+  /** Number of getter calls that returned data. */
+  apr_uint64_t hits;
+
+  /** Number of setter calls. */
+  apr_uint64_t sets;
+
+  /** Total size of the serialized items passed to the cache. */
+  apr_uint64_t bytes_inserted;
+
+  /** Number of items that had to be evicted to make room for others. */
+  apr_uint64_t evictions;
+
+  /** Number of items that were not cached because they were too large. */
+  apr_uint64_t rejected;
+} svn_cache__prefix_stats_t;
+
+/**
+ * Current cache usage of a quota group, i.e. of all membuffer cache
+ * front-ends that have been assigned to it by
+ * svn_cache__membuffer_set_quota().
+ */
+typedef struct svn_cache__quota_stats_t
+{
+  /** Name of the quota group. */
+  const char *name;
+
+  /** Number of bytes that the group may occupy.  0 means "unlimited". */
+  apr_uint64_t quota;
+
+  /** Number of bytes currently occupied by the group's items. */
+  apr_uint64_t used;
+
+  /** Number of items that were not cached because the group exceeded its
+   * quota. */
+  apr_uint64_t throttled;
+} svn_cache__quota_stats_t;
+
 /**
  * Creates a new cache in @a *cache_p.  This cache will use @a pool
  * for all of its storage needs.  The elements in the cache will be
@@ -270,6 +347,73 @@ svn_cache__make_memcache_from_config(svn_memcache_t **memcache_p,
                                      apr_pool_t *result_pool,
                                      apr_pool_t *scratch_pool);
 
+/**
+ * Make all caches using @a memcache write to the memcached servers
+ * asynchronously.  svn_cache__set() will then queue the serialized value
+ * for a background thread and return without waiting for the server's
+ * reply.  Write failures will go unnoticed and a value may not be
+ * visible to readers immediately after svn_cache__set() returned.
+ * If too many writes are pending, new writes fall back to being
+ * synchronous.  Pending writes will be completed when the pool that
+ * @a memcache has been allocated in gets cleaned up.
+ *
+ * This must be called before any cache has been created for @a memcache.
+ * Without thread support, this is a no-op.
+ */
+svn_error_t *
+svn_cache__memcache_enable_async_sets(svn_memcache_t *memcache);
+
+/**
+ * Creates a new cache in @a *cache_p, storing its elements on the Redis
+ * servers in @a redis.  The elements in the cache will be indexed by
+ * keys of length @a klen, which may be APR_HASH_KEY_STRING if they are
+ * strings.  Values will be serialized using @a serialize_func and
+ * deserialized using @a deserialize_func.  As with memcached, @a prefix
+ * should be specified to differentiate this cache from other caches
+ * using the same servers.  @a *cache_p will be allocated in
+ * @a result_pool.
+ *
+ * If @a deserialize_func is NULL, then the data is returned as an
+ * svn_stringbuf_t; if @a serialize_func is NULL, then the data is
+ * assumed to be an svn_stringbuf_t.
+ *
+ * Each key is stored on a single server, selected by consistent hashing
+ * such that adding or removing servers only relocates a small share of
+ * the keys.  Servers that fail are skipped for a few seconds.  Keys are
+ * written without expiry, i.e. the cached values must be immutable and
+ * the servers should be configured with an eviction policy.
+ * svn_cache__get_many() sends all requests for the same server in a
+ * single pipeline.
+ *
+ * These caches are always thread safe.
+ *
+ * These caches do not support svn_cache__iter.
+ */
+svn_error_t *
+svn_cache__create_redis(svn_cache__t **cache_p,
+                        svn_redis_t *redis,
+                        svn_cache__serialize_func_t serialize_func,
+                        svn_cache__deserialize_func_t deserialize_func,
+                        apr_ssize_t klen,
+                        const char *prefix,
+                        apr_pool_t *result_pool);
+
+/**
+ * Given @a config, returns a Redis server set in @a *redis_p allocated
+ * in @a result_pool if @a config contains entries in the
+ * SVN_CACHE_CONFIG_CATEGORY_REDIS_SERVERS section describing Redis
+ * servers as HOST:PORT; otherwise, sets @a *redis_p to NULL.  Use
+ * @a scratch_pool for temporary allocations.
+ *
+ * Connections are opened on demand and closed when @a result_pool
+ * gets cleaned up.
+ */
+svn_error_t *
+svn_cache__make_redis_from_config(svn_redis_t **redis_p,
+                                  svn_config_t *config,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool);
+
 /**
  * Creates a new membuffer cache object in @a *cache. It will contain
  * up to @a total_size bytes of data, using @a directory_size bytes
@@ -288,6 +432,14 @@ svn_cache__make_memcache_from_config(svn_memcache_t **memcache_p,
  * specific upper limit and the setting will be capped there automatically.
  * If the number is 0, a default will be derived from @a total_size.
  *
+ * On NUMA machines, the segments may be grouped into @a partition_count
+ * partitions, ideally one per NUMA node.  Items will be written to the
+ * partition local to the writing thread's node and lookups will try the
+ * local partition before any other.  Since memory pages are allocated
+ * lazily, this tends to keep each partition's memory on its node as well.
+ * @a partition_count will be rounded down to a power of two and limited
+ * by the segment count.  Use 1 to disable partitioning.
+ *
  * If access to the resulting cache object is guaranteed to be serialized,
  * @a thread_safe may be set to @c FALSE for maximum performance.
  *
@@ -306,10 +458,54 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
                                   apr_size_t total_size,
                                   apr_size_t directory_size,
                                   apr_size_t segment_count,
+                                  apr_size_t partition_count,
                                   svn_boolean_t thread_safe,
                                   svn_boolean_t allow_blocking_writes,
                                   apr_pool_t *result_pool);
 
+/**
+ * Like svn_cache__membuffer_cache_create() but place the whole cache in
+ * a shared memory segment.  All processes forked from the current one
+ * after this call will share the cache contents, e.g. the worker processes
+ * of pre-forking servers.  Processes not forked from the creator cannot
+ * attach to the cache.
+ *
+ * If @a shm_file is not @c NULL, it names the shared memory segment.  This
+ * is required on platforms that don't support anonymous shared memory.
+ * Any existing segment of that name will be removed first.
+ *
+ * The cache is always synchronized across threads and processes.  It is
+ * not partitioned and stores the full keys of all entries, i.e. it has a
+ * slightly lower capacity than an equally sized process-local cache.
+ *
+ * The shared memory will be released when @a result_pool gets cleaned up.
+ * Return #SVN_ERR_UNSUPPORTED_FEATURE if APR doesn't support shared memory.
+ */
+svn_error_t *
+svn_cache__membuffer_cache_create_shared(svn_membuffer_t **cache,
+                                         apr_size_t total_size,
+                                         apr_size_t directory_size,
+                                         apr_size_t segment_count,
+                                         svn_boolean_t allow_blocking_writes,
+                                         const char *shm_file,
+                                         apr_pool_t *result_pool);
+
+/**
+ * Make the membuffer @a cache admit items of 64kB or more only if their
+ * estimated access frequency exceeds that of every entry that would have
+ * to be evicted for them.  Frequencies are tracked per cache segment
+ * in a count-min sketch of the recent read requests, allocated in
+ * @a result_pool.  This protects the working set from one-off scans over
+ * large data such as fulltexts.
+ *
+ * This must be called before @a cache is being used by multiple threads.
+ * For caches in shared memory, every process tracks the frequencies of
+ * its own requests.
+ */
+svn_error_t *
+svn_cache__membuffer_enable_admission_filter(svn_membuffer_t *cache,
+                                             apr_pool_t *result_pool);
+
 /**
  * @defgroup Standard priority classes for #svn_cache__create_membuffer_cache.
  * @{
@@ -378,6 +574,42 @@ svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
                                   apr_pool_t *result_pool,
                                   apr_pool_t *scratch_pool);
 
+/**
+ * Make the membuffer-based @a cache store its items LZ4-compressed if
+ * their serialized form is at least @a threshold bytes long.  Items get
+ * decompressed before being passed to the deserializer or to partial
+ * getters.  Partial setters will simply remove the respective item.
+ *
+ * Since the storage format changes, @a cache must not share its prefix
+ * with any uncompressed cache.  This must be called before @a cache is
+ * being used.  For other cache types, this is a no-op.
+ */
+svn_error_t *
+svn_cache__membuffer_enable_compression(svn_cache__t *cache,
+                                        apr_size_t threshold);
+
+/**
+ * Account the items of the membuffer-based @a cache to the quota group
+ * named @a group and limit that group to @a quota_percent percent of the
+ * membuffer's capacity.  All front-ends of the same tenant, e.g. all
+ * caches of one repository, should use the same @a group.  If several
+ * front-ends set different quotas for the same group, the latest one
+ * applies.  A @a quota_percent of 0 means "unlimited".
+ *
+ * The quota is soft.  A group that exceeds it may still use free space
+ * but its new items won't evict the items of groups within their quotas
+ * and its existing items will be evicted first when others need room.
+ *
+ * Once set, the group of a cache prefix cannot be changed for the
+ * lifetime of the membuffer.  Caches with variable-length keys or keys
+ * longer than 16 bytes, short-lived caches and caches in shared memory are
+ * not subject to quotas.  For other cache types, this is a no-op.
+ */
+svn_error_t *
+svn_cache__membuffer_set_quota(svn_cache__t *cache,
+                               const char *group,
+                               apr_uint32_t quota_percent);
+
 /**
  * Creates a null-cache instance in @a *cache_p, allocated from
  * @a result_pool.  The given @c id is the only data stored in it and can
@@ -418,6 +650,7 @@ svn_cache__is_cachable(svn_cache__t *cache,
                        apr_size_t size);
 
 #define SVN_CACHE_CONFIG_CATEGORY_MEMCACHED_SERVERS "memcached-servers"
+#define SVN_CACHE_CONFIG_CATEGORY_REDIS_SERVERS "redis-servers"
 
 /**
  * Fetches a value indexed by @a key from @a cache into @a *value,
@@ -445,6 +678,26 @@ svn_cache__has_key(svn_boolean_t *found,
                    const void *key,
                    apr_pool_t *scratch_pool);
 
+/**
+ * Fetches the values indexed by the @a key_count @a keys from @a cache
+ * into @a values.  For every index I, @a found[I] will be set to TRUE iff
+ * the respective value is in the cache and @a values[I] will then contain
+ * its deserialized copy allocated in @a result_pool.  Keys may be NULL,
+ * in which case the respective @a found element will be FALSE.  Both
+ * output arrays must have @a key_count elements.
+ *
+ * This is semantically equivalent to calling svn_cache__get() for every
+ * key but allows implementations to batch the lookups, e.g. into a single
+ * memcached round trip.
+ */
+svn_error_t *
+svn_cache__get_many(void **values,
+                    svn_boolean_t *found,
+                    svn_cache__t *cache,
+                    const void * const *keys,
+                    int key_count,
+                    apr_pool_t *result_pool);
+
 /**
  * Stores the value @a value under the key @a key in @a cache.  Uses @a
  * scratch_pool for temporary allocations.  The cache makes copies of
@@ -554,6 +807,46 @@ svn_cache__format_info(const svn_cache__info_t *info,
 struct svn_membuffer_t *
 svn_cache__get_global_membuffer_cache(void);
 
+/**
+ * Set the number of NUMA partitions for the process-wide membuffer cache
+ * to @a partition_count.  See svn_cache__membuffer_cache_create() for
+ * details.  This must be called before the first call to
+ * svn_cache__get_global_membuffer_cache() and has no effect afterwards.
+ * The default is 1, i.e. no partitioning.
+ *
+ * This function is not thread-safe.
+ */
+void
+svn_cache__set_global_membuffer_partitions(apr_size_t partition_count);
+
+/**
+ * If @a shared is set, create the process-wide membuffer cache in shared
+ * memory named @a shm_file, which may be @c NULL and must remain valid
+ * until the cache has been created.  See
+ * svn_cache__membuffer_cache_create_shared() for details.  This must be
+ * called before the first call to svn_cache__get_global_membuffer_cache()
+ * and has no effect afterwards.  To actually share the cache, the parent
+ * process must call svn_cache__get_global_membuffer_cache() before it
+ * forks its workers.  The default is to use process-local memory.
+ *
+ * This function is not thread-safe.
+ */
+void
+svn_cache__set_global_membuffer_shared(svn_boolean_t shared,
+                                       const char *shm_file);
+
+/**
+ * If @a enable is set, use an admission filter for large items in the
+ * process-wide membuffer cache.  See
+ * svn_cache__membuffer_enable_admission_filter() for details.  This must
+ * be called before the first call to svn_cache__get_global_membuffer_cache()
+ * and has no effect afterwards.  The filter is disabled by default.
+ *
+ * This function is not thread-safe.
+ */
+void
+svn_cache__set_global_membuffer_admission_filter(svn_boolean_t enable);
+
 /**
  * Return total access and size stats over all membuffer caches as they
  * share the underlying data buffer.  The result will be allocated in POOL.
@@ -561,6 +854,47 @@ svn_cache__get_global_membuffer_cache(void);
 svn_cache__info_t *
 svn_cache__membuffer_get_global_info(apr_pool_t *pool);
 
+/**
+ * Return the statistics of all prefix classes that have seen any activity
+ * in the membuffer @a cache in @a *stats as an array of
+ * svn_cache__prefix_stats_t *, allocated in @a result_pool.  The counters
+ * are not synchronized and may be slightly off.
+ */
+svn_error_t *
+svn_cache__membuffer_get_prefix_stats(apr_array_header_t **stats,
+                                      svn_membuffer_t *cache,
+                                      apr_pool_t *result_pool);
+
+/**
+ * Return the per-prefix-class statistics @a stats, as returned by
+ * svn_cache__membuffer_get_prefix_stats(), as human-readable text with
+ * one line per class, allocated in @a result_pool.
+ */
+svn_string_t *
+svn_cache__format_prefix_stats(const apr_array_header_t *stats,
+                               apr_pool_t *result_pool);
+
+/**
+ * Return the usage of all quota groups in the membuffer @a cache in
+ * @a *stats as an array of svn_cache__quota_stats_t *, allocated in
+ * @a result_pool.
+ *
+ * @see svn_cache__membuffer_set_quota
+ */
+svn_error_t *
+svn_cache__membuffer_get_quota_stats(apr_array_header_t **stats,
+                                     svn_membuffer_t *cache,
+                                     apr_pool_t *result_pool);
+
+/**
+ * Return the quota group usage @a stats, as returned by
+ * svn_cache__membuffer_get_quota_stats(), as human-readable text with
+ * one line per group, allocated in @a result_pool.
+ */
+svn_string_t *
+svn_cache__format_quota_stats(const apr_array_header_t *stats,
+                              apr_pool_t *result_pool);
+
 /**
  * Remove all current contents from CACHE.
  *
@@ -570,6 +904,57 @@ svn_cache__membuffer_get_global_info(apr_pool_t *pool);
 svn_error_t *
 svn_cache__membuffer_clear(svn_membuffer_t *cache);
 
+/**
+ * Write a snapshot of the contents of CACHE to the file at @a path,
+ * replacing it atomically.  Only items of long-lived caches with fixed-size
+ * keys of up to 16 bytes are included, i.e. the bulk of the FSFS and FSX
+ * data but none of the transaction-specific entries.  L2 items are written
+ * before L1 items such that the most recently written data ends up in L1
+ * again when the snapshot gets loaded.  Use @a scratch_pool for temporary
+ * allocations.
+ *
+ * Concurrent modifications of the cache are allowed but may or may not be
+ * reflected in the snapshot.
+ */
+svn_error_t *
+svn_cache__membuffer_save(svn_membuffer_t *cache,
+                          const char *path,
+                          apr_pool_t *scratch_pool);
+
+/**
+ * Add the contents of the snapshot file at @a path to CACHE.  Do nothing,
+ * if that file does not exist or has been written by a different version
+ * or build of Subversion, because the serialized items would then be
+ * incompatible.  Use @a scratch_pool for temporary allocations.
+ *
+ * @see svn_cache__membuffer_save
+ */
+svn_error_t *
+svn_cache__membuffer_load(svn_membuffer_t *cache,
+                          const char *path,
+                          apr_pool_t *scratch_pool);
+
+/**
+ * Make the process-wide membuffer cache load the snapshot at @a path, if
+ * that exists, when the cache gets created.  @a path may be @c NULL and
+ * must remain valid for the lifetime of the process.  It will also be
+ * used by svn_cache__save_global_membuffer().  This must be called before
+ * the first call to svn_cache__get_global_membuffer_cache().
+ *
+ * This function is not thread-safe.
+ */
+void
+svn_cache__set_global_membuffer_snapshot(const char *path);
+
+/**
+ * Write a snapshot of the process-wide membuffer cache to the path set by
+ * svn_cache__set_global_membuffer_snapshot().  Do nothing, if that has not
+ * been set or if there is no such cache.  Use @a scratch_pool for
+ * temporary allocations.
+ */
+svn_error_t *
+svn_cache__save_global_membuffer(apr_pool_t *scratch_pool);
+
 /** @} */
 
 
@@ -101,6 +101,51 @@ svn_delta__delta_from_editor(const svn_delta_editor_t **deditor,
                              struct svn_delta__extra_baton *exb,
                              apr_pool_t *pool);
 
+/** Similar to svn_txdelta_target_push() but produce windows of the given
+ * txdelta @a format:
+ *
+ * - Format 1 uses fixed 100kB source and target windows, just like
+ *   svn_txdelta_target_push().
+ * - Format 2 uses 1MB target windows.  The source view of each window
+ *   slides along with the target and covers the previous as well as the
+ *   current 1MB of the source.  Thus, changes that insert or remove data
+ *   will no longer shift the remaining content out of reach.
+ *
+ * Both formats are written as regular svndiff windows.  However, only
+ * Subversion 1.15 and later accept format 2 windows when reading svndiff
+ * data, so that format must not be used for data sent to older peers.
+ *
+ * If @a window_size is not 0, use target windows of that size instead.
+ * It will be clipped to the range of 4kB to 1MB.  Smaller windows need
+ * less memory, larger ones find more matches within large files.  The
+ * size of each window is recorded in its svndiff header.  Just as with
+ * format 2, only Subversion 1.15 and later accept windows larger than
+ * 100kB.
+ */
+svn_stream_t *
+svn_txdelta__target_push(svn_txdelta_window_handler_t handler,
+                         void *handler_baton,
+                         svn_stream_t *source,
+                         int format,
+                         apr_size_t window_size,
+                         apr_pool_t *pool);
+
+/** Similar to svn_txdelta2() but compute up to @a thread_count windows
+ * concurrently.  The stream reads ahead the data for a batch of windows,
+ * computes their deltas on worker threads and then hands them out in
+ * order.  The windows produced are identical to those of svn_txdelta2().
+ *
+ * Each window in flight needs 200kB of buffer space.  If @a thread_count
+ * is 1 or less, this is the same as svn_txdelta2().
+ */
+void
+svn_txdelta__parallel(svn_txdelta_stream_t **stream,
+                      svn_stream_t *source,
+                      svn_stream_t *target,
+                      svn_boolean_t calculate_checksum,
+                      int thread_count,
+                      apr_pool_t *pool);
+
 /** Read the txdelta window header from @a stream and return the total
     length of the unparsed window data in @a *window_len. */
 svn_error_t *
@@ -108,6 +153,80 @@ svn_txdelta__read_raw_window_len(apr_size_t *window_len,
                                  svn_stream_t *stream,
                                  apr_pool_t *pool);
 
+/** Reusable state for decoding svndiff windows from memory.  All buffers
+ * grow as needed and get reused for subsequent windows, so decoding a
+ * stream of windows allocates memory only until the largest window has
+ * been seen.
+ */
+typedef struct svn_txdelta__window_decoder_t svn_txdelta__window_decoder_t;
+
+/** Return a new window decoder allocated in @a result_pool.
+ *
+ * If @a copy_new_data is FALSE, uncompressed (svndiff0) windows returned
+ * by svn_txdelta__decode_svndiff_window() reference their new data
+ * directly in the input buffer.  That data is not NUL-terminated and
+ * becomes invalid together with the input.  Otherwise, it gets copied
+ * into a decoder-owned buffer.
+ */
+svn_txdelta__window_decoder_t *
+svn_txdelta__window_decoder_create(svn_boolean_t copy_new_data,
+                                   apr_pool_t *result_pool);
+
+/** Decode the svndiff window at the start of the @a len bytes at @a data,
+ * using svndiff version @a svndiff_version, and return it in @a *window.
+ * Set @a *window_len to the number of bytes consumed.  @a data must not
+ * contain the 4 byte svndiff stream header.
+ *
+ * The window is owned by @a decoder and remains valid until the next call
+ * for the same @a decoder.  Return #SVN_ERR_SVNDIFF_UNEXPECTED_END if
+ * @a data does not contain a complete window.
+ */
+svn_error_t *
+svn_txdelta__decode_svndiff_window(svn_txdelta_window_t **window,
+                                   apr_size_t *window_len,
+                                   svn_txdelta__window_decoder_t *decoder,
+                                   const char *data,
+                                   apr_size_t len,
+                                   int svndiff_version);
+
+/** Pull-style svndiff encoder that lends its output buffers to the
+ * caller instead of copying them.  svn_txdelta_to_svndiff_stream() is
+ * built on top of it.
+ */
+typedef struct svn_txdelta__svndiff_reader_t svn_txdelta__svndiff_reader_t;
+
+/** Return a new reader, allocated in @a result_pool, that produces the
+ * svndiff-encoded text delta from @a txstream.  @a svndiff_version and
+ * @a compression_level are the same as in svn_txdelta_to_svndiff3().
+ */
+svn_txdelta__svndiff_reader_t *
+svn_txdelta__svndiff_reader_create(svn_txdelta_stream_t *txstream,
+                                   int svndiff_version,
+                                   int compression_level,
+                                   apr_pool_t *result_pool);
+
+/** Set @a *data and @a *len to the next encoded bytes from @a reader that
+ * have not been released yet.  Return an empty buffer at the end of the
+ * delta.
+ *
+ * The data is owned by @a reader.  It remains valid until all of it has
+ * been passed to svn_txdelta__svndiff_reader_release() and this function
+ * gets called again.  Peeking repeatedly without releasing returns the
+ * same data.
+ */
+svn_error_t *
+svn_txdelta__svndiff_reader_peek(const char **data,
+                                 apr_size_t *len,
+                                 svn_txdelta__svndiff_reader_t *reader);
+
+/** Mark the first @a len bytes returned by the last call to
+ * svn_txdelta__svndiff_reader_peek() for @a reader as consumed.  @a len
+ * must not exceed the length returned by that call.
+ */
+void
+svn_txdelta__svndiff_reader_release(svn_txdelta__svndiff_reader_t *reader,
+                                    apr_size_t len);
+
 /* Return a debug editor that wraps @a wrapped_editor.
  *
  * The debug editor simply prints an indication of what callbacks are being
@@ -44,11 +44,13 @@ extern "C" {
 #  define SVN__BIT_7_SET       0x8080808080808080
 #  define SVN__R_MASK          0x0a0a0a0a0a0a0a0a
 #  define SVN__N_MASK          0x0d0d0d0d0d0d0d0d
+#  define SVN__DOLLAR_MASK     0x2424242424242424
 #else
 #  define SVN__LOWER_7BITS_SET 0x7f7f7f7f
 #  define SVN__BIT_7_SET       0x80808080
 #  define SVN__R_MASK          0x0a0a0a0a
 #  define SVN__N_MASK          0x0d0d0d0d
+#  define SVN__DOLLAR_MASK     0x24242424
 #endif
 
 /* Generic EOL character helper routines */
@@ -62,6 +64,16 @@ extern "C" {
 char *
 svn_eol__find_eol_start(char *buf, apr_size_t len);
 
+/* Look for the start of a keyword (i.e. '$') in the array pointed to by
+ * @a buf , of length @a len.  If @a eol is TRUE, look for the start of
+ * an end-of-line sequence as well.
+ * If such a byte is found, return the pointer to it, else return NULL.
+ *
+ * @since New in 1.15
+ */
+char *
+svn_eol__find_keyword_start(char *buf, apr_size_t len, svn_boolean_t eol);
+
 /* Return the first eol marker found in buffer @a buf as a NUL-terminated
  * string, or NULL if no eol marker is found. Do not examine more than
  * @a len bytes in @a buf.
@@ -168,6 +168,32 @@ typedef struct svn_fs_fs__node_stats_t
   apr_uint64_t size;
 } svn_fs_fs__node_stats_t;
 
+/* Item counts and sizes we collect per shard.
+ */
+typedef struct svn_fs_fs__shard_stats_t
+{
+  /* first revision in this shard */
+  svn_revnum_t first_revision;
+
+  /* number of revisions in this shard */
+  apr_uint64_t revision_count;
+
+  /* sum total of all rev / pack file sizes in bytes */
+  apr_uint64_t total_size;
+
+  /* total number of changed paths */
+  apr_uint64_t change_count;
+
+  /* number of noderev structs */
+  apr_uint64_t noderev_count;
+
+  /* number of representations */
+  apr_uint64_t rep_count;
+
+  /* total on-disk size of those representations in bytes */
+  apr_uint64_t rep_size;
+} svn_fs_fs__shard_stats_t;
+
 /* Comprises all the information needed to create the output of the
  * 'svnfsfs stats' command.
  */
@@ -251,8 +277,15 @@ typedef struct svn_fs_fs__stats_t
   /* histogram of sizes of directories property representations */
   svn_fs_fs__histogram_t dir_prop_rep_histogram;
 
+  /* histogram of representation delta chain lengths */
+  svn_fs_fs__histogram_t chain_length_histogram;
+
   /* extension -> svn_fs_fs__extension_info_t* map */
   apr_hash_t *by_extension;
+
+  /* svn_fs_fs__shard_stats_t * in revision order.  Non-sharded
+   * repositories are summarized in a single entry. */
+  apr_array_header_t *shards;
 } svn_fs_fs__stats_t;
 
 /* A node-revision ID in FSFS consists of 3 sub-IDs ("parts") that consist
@@ -313,6 +346,10 @@ typedef struct svn_fs_fs__ioctl_get_stats_input_t
 {
   svn_fs_progress_notify_func_t progress_func;
   void *progress_baton;
+
+  /* Maximum number of threads to scan the repository with.
+   * Values of 1 or less select the sequential scan. */
+  int jobs;
 } svn_fs_fs__ioctl_get_stats_input_t;
 
 typedef struct svn_fs_fs__ioctl_get_stats_output_t
@@ -359,11 +396,235 @@ typedef struct svn_fs_fs__ioctl_build_rep_cache_input_t
   svn_revnum_t end_rev;
   svn_fs_progress_notify_func_t progress_func;
   void *progress_baton;
+
+  /* Maximum number of threads to read the revisions with.
+   * Values of 1 or less select the sequential scan. */
+  int jobs;
 } svn_fs_fs__ioctl_build_rep_cache_input_t;
 
 /* See svn_fs_fs__build_rep_cache(). */
 SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_BUILD_REP_CACHE, SVN_FS_TYPE_FSFS, 1004);
 
+/* A single item access recorded by the FSFS access trace.
+ *
+ * The access trace is a process-wide ring buffer shared by all FSFS
+ * repositories.  It is disabled by default and can be enabled at runtime
+ * using SVN_FS_FS__IOCTL_SET_ACCESS_TRACE.
+ */
+typedef struct svn_fs_fs__access_trace_entry_t
+{
+  /* Time at which the access started. */
+  apr_time_t timestamp;
+
+  /* Path of the filesystem that got accessed. */
+  const char *fs_path;
+
+  /* Revision and item index of the item.  Revision will be
+   * SVN_INVALID_REVNUM for in-txn data. */
+  svn_revnum_t revision;
+  apr_uint64_t item_index;
+
+  /* Type of the item (see SVN_FS_FS__ITEM_TYPE_* defines). */
+  apr_uint32_t item_type;
+
+  /* TRUE, if the item was found in some cache and no file I/O occurred. */
+  svn_boolean_t cache_hit;
+
+  /* Position within the rev / pack file that the data was read from.
+   * -1 if unknown or not applicable, e.g. for cache hits. */
+  apr_off_t offset;
+
+  /* Number of bytes read from OFFSET.  -1 if unknown or not applicable,
+   * e.g. for cache hits. */
+  apr_off_t size;
+
+  /* Time it took to look up / read and parse the item. */
+  apr_interval_time_t latency;
+} svn_fs_fs__access_trace_entry_t;
+
+typedef struct svn_fs_fs__ioctl_set_access_trace_input_t
+{
+  /* Maximum number of entries to keep.  Once that has been reached, the
+   * oldest entries will be overwritten.  0 disables tracing and discards
+   * all recorded entries. */
+  int capacity;
+} svn_fs_fs__ioctl_set_access_trace_input_t;
+
+/* Enable, resize or disable the process-wide access trace.
+ * May be called with or without an open filesystem. */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_SET_ACCESS_TRACE, SVN_FS_TYPE_FSFS, 1005);
+
+typedef struct svn_fs_fs__ioctl_get_access_trace_input_t
+{
+  /* If set, remove the returned entries from the trace, so that the
+   * next call only returns entries recorded after this one. */
+  svn_boolean_t clear;
+} svn_fs_fs__ioctl_get_access_trace_input_t;
+
+typedef struct svn_fs_fs__ioctl_get_access_trace_output_t
+{
+  /* svn_fs_fs__access_trace_entry_t * elements, oldest first. */
+  apr_array_header_t *entries;
+
+  /* Number of entries that have been overwritten because the trace had
+   * not been read (with CLEAR set) in time. */
+  apr_uint64_t dropped;
+} svn_fs_fs__ioctl_get_access_trace_output_t;
+
+/* Return the entries currently held by the process-wide access trace.
+ * May be called with or without an open filesystem. */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_GET_ACCESS_TRACE, SVN_FS_TYPE_FSFS, 1006);
+
+typedef struct svn_fs_fs__ioctl_build_path_index_input_t
+{
+  svn_fs_progress_notify_func_t progress_func;
+  void *progress_baton;
+} svn_fs_fs__ioctl_build_path_index_input_t;
+
+/* Create the per-path revision index, if it does not exist yet, and add
+ * all revisions not covered by it yet.  Once the index exists, commits
+ * will keep it up to date. */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_BUILD_PATH_INDEX, SVN_FS_TYPE_FSFS, 1007);
+
+typedef struct svn_fs_fs__ioctl_path_index_prev_input_t
+{
+  /* The path to look up. */
+  const char *path;
+
+  /* The revision range to look in, inclusive. */
+  svn_revnum_t start;
+  svn_revnum_t end;
+} svn_fs_fs__ioctl_path_index_prev_input_t;
+
+typedef struct svn_fs_fs__ioctl_path_index_prev_output_t
+{
+  /* FALSE, if there is no path index or it does not cover the revision
+   * range, yet.  The other members are undefined in that case. */
+  svn_boolean_t available;
+
+  /* Youngest revision within the range that changed PATH or anything
+   * below it.  SVN_INVALID_REVNUM if there is none. */
+  svn_revnum_t change_rev;
+
+  /* Youngest revision within the range that added, deleted, replaced or
+   * moved PATH or any of its parents.  Node history may cross a copy in
+   * that revision.  SVN_INVALID_REVNUM if there is none. */
+  svn_revnum_t creation_rev;
+} svn_fs_fs__ioctl_path_index_prev_output_t;
+
+/* Query the per-path revision index.  See svn_fs_fs__path_index_prev(). */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_PATH_INDEX_PREV, SVN_FS_TYPE_FSFS, 1008);
+
+typedef struct svn_fs_fs__ioctl_get_txn_list_lock_stats_output_t
+{
+  /* Number of times that the txn list lock has been acquired. */
+  apr_uint64_t count;
+
+  /* Total and maximum time spent waiting for the txn list lock. */
+  apr_interval_time_t wait_time;
+  apr_interval_time_t max_wait_time;
+} svn_fs_fs__ioctl_get_txn_list_lock_stats_output_t;
+
+/* Return the usage statistics of the in-process lock that serializes
+ * access to the list of transactions being written to.  The statistics
+ * are shared by all instances of the same repository in this process.
+ * See svn_fs_fs__get_txn_list_lock_stats(). */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_GET_TXN_LIST_LOCK_STATS, SVN_FS_TYPE_FSFS, 1009);
+
+typedef struct svn_fs_fs__ioctl_bulk_load_input_t
+{
+  /* TRUE to start bulk load mode, FALSE to end it. */
+  svn_boolean_t enable;
+} svn_fs_fs__ioctl_bulk_load_input_t;
+
+/* Start or end bulk load mode for the FS instance.  The caller asserts
+ * that nobody else accesses the repository until bulk load mode ends.
+ * See svn_fs_fs__begin_bulk_load() and svn_fs_fs__end_bulk_load(). */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_BULK_LOAD, SVN_FS_TYPE_FSFS, 1010);
+
+typedef struct svn_fs_fs__ioctl_path_index_prev_copy_input_t
+{
+  /* The node to look up. */
+  const char *path;
+  svn_revnum_t revision;
+} svn_fs_fs__ioctl_path_index_prev_copy_input_t;
+
+typedef struct svn_fs_fs__ioctl_path_index_prev_copy_output_t
+{
+  /* FALSE, if there is no path index or it does not cover the node's
+   * history, yet.  The other members are undefined in that case. */
+  svn_boolean_t available;
+
+  /* Revision in which the node started to live at PATH. */
+  svn_revnum_t appeared_rev;
+
+  /* Location of PATH within the copy source, if the node has been copied
+   * to PATH in APPEARED_REV.  NULL and SVN_INVALID_REVNUM otherwise. */
+  const char *copyfrom_path;
+  svn_revnum_t copyfrom_rev;
+} svn_fs_fs__ioctl_path_index_prev_copy_output_t;
+
+/* Look up the copy that brought a node to its current path in the per-path
+ * revision index.  See svn_fs_fs__path_index_prev_copy(). */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_PATH_INDEX_PREV_COPY, SVN_FS_TYPE_FSFS, 1011);
+
+typedef struct svn_fs_fs__ioctl_build_date_index_input_t
+{
+  svn_fs_progress_notify_func_t progress_func;
+  void *progress_baton;
+} svn_fs_fs__ioctl_build_date_index_input_t;
+
+/* Create the revision date index from scratch, replacing any existing
+ * one.  From then on, commits and revprop changes will keep it up to
+ * date. */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_BUILD_DATE_INDEX, SVN_FS_TYPE_FSFS, 1012);
+
+typedef struct svn_fs_fs__ioctl_dated_revision_input_t
+{
+  /* The date to look up. */
+  apr_time_t tm;
+} svn_fs_fs__ioctl_dated_revision_input_t;
+
+typedef struct svn_fs_fs__ioctl_dated_revision_output_t
+{
+  /* FALSE, if there is no date index or it cannot answer the query.
+   * REVISION is undefined in that case. */
+  svn_boolean_t available;
+
+  /* Youngest revision not younger than TM, as determined by the same
+   * binary search that svn_repos_dated_revision() uses. */
+  svn_revnum_t revision;
+} svn_fs_fs__ioctl_dated_revision_output_t;
+
+/* Find the revision for a date in the revision date index.
+ * See svn_fs_fs__date_index_lookup(). */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_DATED_REVISION, SVN_FS_TYPE_FSFS, 1013);
+
+typedef struct svn_fs_fs__ioctl_path_index_deleted_rev_input_t
+{
+  /* The node to look up, which must exist at PATH in START. */
+  const char *path;
+  svn_revnum_t start;
+
+  /* Youngest revision to look in. */
+  svn_revnum_t end;
+} svn_fs_fs__ioctl_path_index_deleted_rev_input_t;
+
+typedef struct svn_fs_fs__ioctl_path_index_deleted_rev_output_t
+{
+  /* FALSE, if there is no path index or it does not cover END, yet.
+   * DELETED is undefined in that case. */
+  svn_boolean_t available;
+
+  /* Revision in which the node has been deleted from PATH.
+   * SVN_INVALID_REVNUM if it still exists there in END. */
+  svn_revnum_t deleted;
+} svn_fs_fs__ioctl_path_index_deleted_rev_output_t;
+
+/* Look up the deletion of a node in the per-path revision index.
+ * See svn_fs_fs__path_index_deleted_rev(). */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_PATH_INDEX_DELETED_REV, SVN_FS_TYPE_FSFS, 1014);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,215 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file svn_fs_x_private.h
+ * @brief Private API for tools that access FSX internals and can't use
+ *        the svn_fs_t API for that.
+ */
+
+
+#ifndef SVN_FS_X_PRIVATE_H
+#define SVN_FS_X_PRIVATE_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+#include "svn_error.h"
+#include "svn_fs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+
+/* Number of distinct item types in the FSX phys-to-log index,
+ * i.e. SVN_FS_X__ITEM_TYPE_UNUSED ... SVN_FS_X__ITEM_TYPE_REPS_CONT.
+ */
+#define SVN_FS_X__STATS_ITEM_TYPE_COUNT 11
+
+/* Number of buckets in svn_fs_x__stats_t.chain_histogram.
+ */
+#define SVN_FS_X__STATS_CHAIN_BUCKETS 8
+
+/* Sub-item of an svn_fs_x__index_entry_t.
+ */
+typedef struct svn_fs_x__index_item_t
+{
+  /* Revision that the item belongs to. */
+  svn_revnum_t revision;
+
+  /* Item number within that revision. */
+  apr_uint64_t number;
+} svn_fs_x__index_item_t;
+
+/* Tool-facing copy of a single FSX phys-to-log index entry.
+ */
+typedef struct svn_fs_x__index_entry_t
+{
+  /* offset of the first byte that belongs to the item */
+  apr_off_t offset;
+
+  /* length of the item in bytes */
+  apr_off_t size;
+
+  /* type of the item (see SVN_FS_X__ITEM_TYPE_*) defines */
+  apr_uint32_t type;
+
+  /* modified FNV-1a checksum.  0 if unknown checksum */
+  apr_uint32_t fnv1_checksum;
+
+  /* Number of items in this block / container.  0 for unused sections,
+   * 1 for non-container items, > 1 for containers. */
+  apr_uint32_t item_count;
+
+  /* List of ITEM_COUNT items in that block / container */
+  const svn_fs_x__index_item_t *items;
+} svn_fs_x__index_entry_t;
+
+/* Callback function type receiving a single P2L index ENTRY, a user
+ * provided BATON and a SCRATCH_POOL for temporary allocations.
+ * ENTRY's lifetime may end when the callback returns.
+ */
+typedef svn_error_t *
+(*svn_fs_x__dump_index_func_t)(const svn_fs_x__index_entry_t *entry,
+                               void *baton,
+                               apr_pool_t *scratch_pool);
+
+/* Summary of all P2L entries of a given item type.
+ */
+typedef struct svn_fs_x__item_type_stats_t
+{
+  /* Number of index entries, i.e. items or containers. */
+  apr_uint64_t count;
+
+  /* Total number of items within those entries.  For containers, the
+   * ratio SUB_ITEMS / COUNT is the average fill of the container. */
+  apr_uint64_t sub_items;
+
+  /* Maximum number of items found in any single entry. */
+  apr_uint64_t max_sub_items;
+
+  /* Total on-disk size of those entries in bytes. */
+  apr_uint64_t size;
+
+  /* Number of entries whose size exceeds what the respective cache is
+   * expected to accept.  Only counted for containers. */
+  apr_uint64_t uncachable;
+} svn_fs_x__item_type_stats_t;
+
+/* Summary of the string tables found in one kind of container.
+ */
+typedef struct svn_fs_x__string_table_stats_t
+{
+  /* Number of string tables read. */
+  apr_uint64_t tables;
+
+  /* Number of strings stored in those tables. */
+  apr_uint64_t strings;
+
+  /* Sum of the lengths of all strings in those tables. */
+  apr_uint64_t expanded_size;
+
+  /* Number of bytes actually required to store the string data. */
+  apr_uint64_t stored_size;
+} svn_fs_x__string_table_stats_t;
+
+/* Statistics for an FSX repository as returned by SVN_FS_X__IOCTL_GET_STATS.
+ */
+typedef struct svn_fs_x__stats_t
+{
+  /* Number of revisions in the repository. */
+  svn_revnum_t revision_count;
+
+  /* Number of revisions per shard.  0 for non-sharded repositories. */
+  int shard_size;
+
+  /* First revision that has not been packed. */
+  svn_revnum_t min_unpacked_rev;
+
+  /* Number of bytes in all P2L index entries, including unused ones. */
+  apr_uint64_t total_size;
+
+  /* Summary per item type, indexed by SVN_FS_X__ITEM_TYPE_*. */
+  svn_fs_x__item_type_stats_t item_types[SVN_FS_X__STATS_ITEM_TYPE_COUNT];
+
+  /* Path string tables in changed paths lists containers. */
+  svn_fs_x__string_table_stats_t changes_paths;
+
+  /* Path string tables in node revision containers. */
+  svn_fs_x__string_table_stats_t noderevs_paths;
+
+  /* Number of representations whose delta chain has been measured. */
+  apr_uint64_t chain_count;
+
+  /* Sum of all those delta chain lengths. */
+  apr_uint64_t chain_length_sum;
+
+  /* Longest delta chain found. */
+  apr_uint64_t chain_length_max;
+
+  /* Sum of the number of shards touched by those delta chains. */
+  apr_uint64_t chain_shard_sum;
+
+  /* Histogram of delta chain lengths.  Bucket I counts chains with
+   * 2^I <= length < 2^(I+1); the last bucket is open-ended. */
+  apr_uint64_t chain_histogram[SVN_FS_X__STATS_CHAIN_BUCKETS];
+
+  /* Capacity of the process-wide membuffer cache in bytes. */
+  apr_uint64_t cache_total_size;
+
+  /* Number of bytes used in the membuffer cache after the scan. */
+  apr_uint64_t cache_used_size;
+
+  /* Number of entries in the membuffer cache after the scan. */
+  apr_uint64_t cache_used_entries;
+} svn_fs_x__stats_t;
+
+typedef struct svn_fs_x__ioctl_get_stats_input_t
+{
+  svn_fs_progress_notify_func_t progress_func;
+  void *progress_baton;
+} svn_fs_x__ioctl_get_stats_input_t;
+
+typedef struct svn_fs_x__ioctl_get_stats_output_t
+{
+  svn_fs_x__stats_t *stats;
+} svn_fs_x__ioctl_get_stats_output_t;
+
+/* See svn_fs_x__get_stats(). */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_X__IOCTL_GET_STATS, SVN_FS_TYPE_FSX, 1000);
+
+typedef struct svn_fs_x__ioctl_dump_index_input_t
+{
+  svn_revnum_t revision;
+  svn_fs_x__dump_index_func_t callback_func;
+  void *callback_baton;
+} svn_fs_x__ioctl_dump_index_input_t;
+
+/* See svn_fs_x__dump_index(). */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_X__IOCTL_DUMP_INDEX, SVN_FS_TYPE_FSX, 1001);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_FS_X_PRIVATE_H */
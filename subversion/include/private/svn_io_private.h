@@ -85,6 +85,71 @@ svn_io__file_lock_autocreate(const char *lock_file,
                              apr_pool_t *pool);
 
 
+/** Hint to the operating system that the @a length bytes starting at
+ * @a offset in @a file will be read soon.  The data may then be fetched
+ * asynchronously, e.g. into the OS file cache, while the caller continues
+ * to work.  This is purely advisory and a no-op on platforms that don't
+ * support it.  Failures to apply the hint are silently ignored.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_io__file_prefetch(apr_file_t *file,
+                      apr_off_t offset,
+                      apr_off_t length,
+                      apr_pool_t *scratch_pool);
+
+/** Create @a to_path as a hard link to the existing file @a from_path.
+ * Both must be on the same file system and @a to_path must not exist.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_io__file_link(const char *from_path,
+                  const char *to_path,
+                  apr_pool_t *scratch_pool);
+
+
+/** Copy the contents of @a from_file, which must be at its start, to the
+ * empty @a to_file.  On copy-on-write file systems, let both files share
+ * their data blocks instead, if possible.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_io__file_clone(apr_file_t *from_file,
+                   apr_file_t *to_file,
+                   apr_pool_t *scratch_pool);
+
+/** Copy the remaining contents of @a from_file to @a to_file without
+ * passing them through user space, if the platform supports that for
+ * these files.  Set @a *copied to TRUE on success and leave both files
+ * positioned after the copied data.  Otherwise, set @a *copied to FALSE
+ * and leave both files unchanged, so the caller can copy the data itself.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_io__file_splice(svn_boolean_t *copied,
+                    apr_file_t *from_file,
+                    apr_file_t *to_file,
+                    apr_pool_t *scratch_pool);
+
+
+/** Like svn_io_remove_dir2(), but remove the subtrees of @a path in up
+ * to @a thread_count threads.  @a cancel_func, if not @c NULL, must be
+ * thread-safe.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_io__remove_dir_concurrently(const char *path,
+                                svn_boolean_t ignore_enoent,
+                                int thread_count,
+                                svn_cancel_func_t cancel_func,
+                                void *cancel_baton,
+                                apr_pool_t *scratch_pool);
+
 /** Return the underlying file, if any, associated with the stream, or
  * NULL if not available.  Accessing the file bypasses the stream.
  */
@@ -71,6 +71,17 @@ typedef svn_error_t *(*svn_ra_svn__command_handler)(svn_ra_svn_conn_t *conn,
                                                     svn_ra_svn__list_t *params,
                                                     void *baton);
 
+/** Command handler that reads its parameter list from @a conn itself,
+ * typically with svn_ra_svn__read_tuple().  That avoids building an item
+ * tree for frequent commands with simple parameters.  The handler must
+ * read the parameter list before returning any error wrapped in
+ * SVN_RA_SVN_CMD_ERR.
+ */
+typedef svn_error_t *(*svn_ra_svn__stream_command_handler)(
+  svn_ra_svn_conn_t *conn,
+  apr_pool_t *pool,
+  void *baton);
+
 /** Command table, used by svn_ra_svn_handle_commands().
  */
 typedef struct svn_ra_svn__cmd_entry_t
@@ -88,6 +99,9 @@ typedef struct svn_ra_svn__cmd_entry_t
   /** Termination flag.  If set, command-handling will cease after
    * command is processed. */
   svn_boolean_t terminate;
+
+  /** If set, this is used instead of HANDLER, which should be NULL. */
+  svn_ra_svn__stream_command_handler stream_handler;
 } svn_ra_svn__cmd_entry_t;
 
 
@@ -132,6 +146,44 @@ svn_ra_svn__set_capabilities(svn_ra_svn_conn_t *conn,
 int
 svn_ra_svn__svndiff_version(svn_ra_svn_conn_t *conn);
 
+/** Byte counts of the stream compression on a connection, see
+ * svn_ra_svn__enable_stream_compression().
+ */
+typedef struct svn_ra_svn__compression_stats_t
+{
+  /** Data received, after and before decompression. */
+  apr_uint64_t raw_in;
+  apr_uint64_t wire_in;
+
+  /** Data sent, before and after compression. */
+  apr_uint64_t raw_out;
+  apr_uint64_t wire_out;
+} svn_ra_svn__compression_stats_t;
+
+/** Compress all further data sent and received over @a conn, flushing
+ * any data written before.  Both sides must enable the compression at
+ * the same point in the protocol, see #SVN_RA_SVN_CAP_COMPRESS_STREAM.
+ * Do nothing if the compression is already enabled.  Use @a scratch_pool
+ * for temporary allocations.
+ */
+svn_error_t *
+svn_ra_svn__enable_stream_compression(svn_ra_svn_conn_t *conn,
+                                      apr_pool_t *scratch_pool);
+
+/** Return the byte counts of the stream compression on @a conn, or NULL
+ * if that is not enabled.
+ */
+const svn_ra_svn__compression_stats_t *
+svn_ra_svn__get_compression_stats(svn_ra_svn_conn_t *conn);
+
+/** Return the hex-encoded HMAC-MD5 of @a data keyed with @a key, as used
+ * by the CRAM-MD5 mechanism, allocated in @a result_pool.
+ */
+const char *
+svn_ra_svn__hmac_md5_hex(const char *key,
+                         const char *data,
+                         apr_pool_t *result_pool);
+
 
 /**
  * Set the shim callbacks to be used by @a conn to @a shim_callbacks.
@@ -365,15 +417,37 @@ svn_ra_svn__has_command(svn_boolean_t *has_command,
                         svn_ra_svn_conn_t *conn,
                         apr_pool_t *pool);
 
+/** What it took to handle a command, see svn_ra_svn__handle_command().
+ */
+typedef struct svn_ra_svn__command_stats_t
+{
+  /** Name of the command.  NULL if no command has been received. */
+  const char *cmdname;
+
+  /** Time from receiving the command name until the handler returned. */
+  apr_interval_time_t duration;
+
+  /** Number of bytes received and sent while handling the command.
+   * Received data includes anything already buffered with the command,
+   * and part of the response may still be in the send buffer. */
+  apr_uint64_t bytes_in;
+  apr_uint64_t bytes_out;
+
+  /** Whether the command failed. */
+  svn_boolean_t failed;
+} svn_ra_svn__command_stats_t;
+
 /** Accept a single command from @a conn and handle them according
  * to @a cmd_hash.  Command handlers will be passed @a conn, @a pool,
  * the parameters of the command, and @a baton.  @a *terminate will be
  * set if either @a error_on_disconnect is FALSE and the connection got
  * closed, or if the command being handled has the "terminate" flag set
- * in the command table.
+ * in the command table.  If @a stats is not NULL, fill it in for the
+ * command handled, allocating the name in @a pool.
  */
 svn_error_t *
 svn_ra_svn__handle_command(svn_boolean_t *terminate,
+                           svn_ra_svn__command_stats_t *stats,
                            apr_hash_t *cmd_hash,
                            void *baton,
                            svn_ra_svn_conn_t *conn,
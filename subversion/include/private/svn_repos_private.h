@@ -131,6 +131,22 @@ svn_repos__fs_type(const char **fs_type,
                    apr_pool_t *pool);
 
 
+/* Set *AUTHZ_READ_FUNC and *AUTHZ_READ_BATON to a read authorization
+ * callback that checks the rules in AUTHZ for USER on REPOS_NAME.
+ * Allocate the baton in RESULT_POOL.
+ *
+ * Functions in this library that report directory contents recognize
+ * this callback and check all entries of a directory at once, using
+ * svn_repos_authz_check_children().
+ */
+void
+svn_repos__authz_read_func_create(svn_repos_authz_func_t *authz_read_func,
+                                  void **authz_read_baton,
+                                  svn_authz_t *authz,
+                                  const char *repos_name,
+                                  const char *user,
+                                  apr_pool_t *result_pool);
+
 /* Create a commit editor for REPOS, based on REVISION.  */
 svn_error_t *
 svn_repos__get_commit_ev2(svn_editor_t **editor,
@@ -103,6 +103,19 @@ svn_sqlite__read_schema_version(int *version,
                                 svn_sqlite__db_t *db,
                                 apr_pool_t *scratch_pool);
 
+/* Return in *DATA_VERSION a number that changes whenever another
+   connection commits a change to DB, and in *TOTAL_CHANGES the number of
+   rows changed through DB itself since it was opened.  If the version of
+   SQLite can't tell about other connections, or if a transaction is open
+   in DB, set *DATA_VERSION to -1.
+
+   Together they tell whether anything read from DB before may be out of
+   date.  */
+svn_error_t *
+svn_sqlite__read_data_version(apr_int64_t *data_version,
+                              apr_int64_t *total_changes,
+                              svn_sqlite__db_t *db);
+
 
 
 /* Open a connection in *DB to the database at PATH. Validate the schema,
@@ -133,6 +146,18 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
 svn_error_t *
 svn_sqlite__close(svn_sqlite__db_t *db);
 
+/* Return a table of the number of executions, the number of rows stepped
+   through and the total, average and maximum execution time of each
+   prepared statement of DB, allocated in RESULT_POOL, starting with the
+   statement that took the most time.
+
+   Statements are only timed if the SVN_SQLITE_PROFILE environment variable
+   was set to a file name when DB was opened; closing DB then appends this
+   table to that file.  Return NULL if statements of DB are not timed. */
+const char *
+svn_sqlite__profile_report(svn_sqlite__db_t *db,
+                           apr_pool_t *result_pool);
+
 /* Add a custom function to be used with this database connection.  The data
    in BATON should live at least as long as the connection in DB.
 
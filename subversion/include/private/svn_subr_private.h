@@ -284,6 +284,35 @@ svn_checksum__wrap_write_stream(svn_checksum_t **checksum,
                                 svn_checksum_kind_t kind,
                                 apr_pool_t *pool);
 
+/**
+ * Like svn_checksum__wrap_write_stream(), but calculate checksums of
+ * type @a kind1 and @a kind2 in one pass over the data, and write them
+ * to @a *checksum1 and @a *checksum2.  The returned stream supports
+ * #svn_stream_reset if @a inner_stream does.
+ *
+ * @since New in 1.15
+ */
+svn_stream_t *
+svn_checksum__wrap_write_stream2(svn_checksum_t **checksum1,
+                                 svn_checksum_kind_t kind1,
+                                 svn_checksum_t **checksum2,
+                                 svn_checksum_kind_t kind2,
+                                 svn_stream_t *inner_stream,
+                                 apr_pool_t *pool);
+
+/**
+ * Update the checksum contexts @a ctx1 and @a ctx2 with the same @a len
+ * bytes of @a data, alternating between them in blocks small enough to
+ * stay in the CPU cache.  @a ctx2 may be @c NULL.
+ *
+ * @since New in 1.15
+ */
+svn_error_t *
+svn_checksum__update2(svn_checksum_ctx_t *ctx1,
+                      svn_checksum_ctx_t *ctx2,
+                      const void *data,
+                      apr_size_t len);
+
 /**
  * Return a stream that calculates a 32 bit modified FNV-1a checksum
  * over all data written to the @a inner_stream and writes the digest
@@ -428,6 +457,31 @@ svn_hash__read_entry(svn_hash__entry_t *entry,
                      svn_boolean_t incremental,
                      apr_pool_t *pool);
 
+/** Like svn_hash__read_entry() but parse the entry from the buffer
+ * starting at @a *data and ending at @a end, and advance @a *data behind
+ * it.  Instead of being copied, the members of @a *entry point into the
+ * buffer, which gets modified to 0-terminate them.
+ *
+ * @since New in 1.15
+ */
+svn_error_t *
+svn_hash__parse_entry(svn_hash__entry_t *entry,
+                      char **data,
+                      char *end,
+                      const char *terminator,
+                      svn_boolean_t incremental);
+
+/** Like svn_hash_read2() but parse the serialized hash from the contents
+ * of @a text in a single pass.  The contents of @a text get modified.
+ *
+ * @since New in 1.15
+ */
+svn_error_t *
+svn_hash__read_buffer(apr_hash_t *hash,
+                      svn_stringbuf_t *text,
+                      const char *terminator,
+                      apr_pool_t *pool);
+
 /** @} */
 
 /** @} */
@@ -505,6 +559,17 @@ svn_version__at_least(const svn_version_t *version,
 /* Slowest, best compression method & level provided by zlib. */
 #define SVN__COMPRESSION_ZLIB_MAX     9
 
+/* Fastest, least effective compression level used with zstd. */
+#define SVN__COMPRESSION_ZSTD_MIN     1
+
+/* Default compression level used with zstd. */
+#define SVN__COMPRESSION_ZSTD_DEFAULT 3
+
+/* Slowest, best compression level used with zstd.  Higher levels exist
+   but require excessive amounts of memory for little or no gain on
+   svndiff-sized data. */
+#define SVN__COMPRESSION_ZSTD_MAX     19
+
 /* Encode VAL into the buffer P using the variable-length 7b/8b unsigned
    integer format.  Return the incremented value of P after the
    encoded bytes have been written.  P must point to a buffer of size
@@ -591,6 +656,29 @@ svn__decompress_lz4(const void *data, apr_size_t len,
                     svn_stringbuf_t *out,
                     apr_size_t limit);
 
+/* Return TRUE if this build of Subversion supports zstd compression.
+ * If it does not, svn__compress_zstd() and svn__decompress_zstd() will
+ * always return SVN_ERR_UNSUPPORTED_FEATURE.
+ */
+svn_boolean_t
+svn__zstd_available(void);
+
+/* Same as svn__compress_zlib(), but use zstd compression with the given
+ * COMPRESSION_LEVEL, which will be clipped to the range
+ * SVN__COMPRESSION_ZSTD_MIN ... SVN__COMPRESSION_ZSTD_MAX.
+ */
+svn_error_t *
+svn__compress_zstd(const void *data, apr_size_t len,
+                   svn_stringbuf_t *out,
+                   int compression_level);
+
+/* Same as svn__decompress_zlib(), but use zstd compression.
+ */
+svn_error_t *
+svn__decompress_zstd(const void *data, apr_size_t len,
+                     svn_stringbuf_t *out,
+                     apr_size_t limit);
+
 /** @} */
 
 /**
@@ -746,6 +834,14 @@ const char *svn_lz4__compiled_version(void);
  */
 int svn_lz4__runtime_version(void);
 
+/* Return the zstd version we compiled against or NULL if Subversion has
+ * been built without zstd support. */
+const char *svn_zstd__compiled_version(void);
+
+/* Return the zstd version we run against or NULL if Subversion has been
+ * built without zstd support. */
+const char *svn_zstd__runtime_version(apr_pool_t *result_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,155 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file svn_task.h
+ * @brief Process a sequence of independent work items concurrently
+ */
+
+#ifndef SVN_TASK_H
+#define SVN_TASK_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+#include "svn_error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * This is a minimal framework for running a fixed number of independent
+ * work items on a set of worker threads while the caller receives the
+ * results strictly in item order.
+ *
+ * The processing part of each item runs in some worker thread and must
+ * therefore not touch any data that it does not own exclusively, except
+ * for read-only data and objects that are explicitly thread-safe.  State
+ * that is expensive to set up but not thread-safe, e.g. an open
+ * filesystem or repository handle, can be kept in a per-thread context
+ * object.
+ *
+ * The output part of each item always runs in the caller's thread and may
+ * therefore safely access any of the caller's data structures.  It is
+ * also the natural place to send notifications.
+ *
+ * If threading is not supported by APR or a single thread has been
+ * requested, all items will be processed and output sequentially within
+ * the caller's thread.
+ *
+ * @{
+ */
+
+/** Callback constructing the per-thread context object and returning it
+ * in @a *thread_context.  @a context_baton is the baton given to
+ * svn_task__run().  Allocate the context in @a result_pool, which will be
+ * valid for as long as the thread exists.  Use @a scratch_pool for
+ * temporary allocations.
+ *
+ * This will be called from within the worker thread before processing
+ * its first item.
+ */
+typedef svn_error_t *
+(*svn_task__thread_context_constructor_t)(void **thread_context,
+                                          void *context_baton,
+                                          apr_pool_t *result_pool,
+                                          apr_pool_t *scratch_pool);
+
+/** Callback processing the work item with the given @a index.
+ * @a process_baton is the baton given to svn_task__run() and
+ * @a thread_context is the context object for the current thread (or
+ * @c NULL if no constructor has been given).
+ *
+ * Return the result of the processing in @a *result, allocated in
+ * @a result_pool.  That pool will remain valid until the result has been
+ * passed to the output callback.  Use @a scratch_pool for temporary
+ * allocations.
+ *
+ * Implementations should periodically call @a cancel_func with
+ * @a cancel_baton.  Besides checking for user cancellation, this also
+ * stops processing early once some other item has failed.
+ */
+typedef svn_error_t *
+(*svn_task__process_func_t)(void **result,
+                            int index,
+                            void *process_baton,
+                            void *thread_context,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
+/** Callback handling the @a result of processing the work item with the
+ * given @a index.  @a output_baton is the baton given to svn_task__run().
+ * This will always be called from within the thread that called
+ * svn_task__run() and in ascending @a index order.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ */
+typedef svn_error_t *
+(*svn_task__output_func_t)(void *result,
+                           int index,
+                           void *output_baton,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *scratch_pool);
+
+/** Process all work items from index 0 to @a item_count - 1 using up to
+ * @a thread_count concurrent worker threads.  Each item is being handled
+ * by a single call to @a process_func with @a process_baton.  If
+ * @a output_func is not @c NULL, call it with @a output_baton for each
+ * processing result in item order.
+ *
+ * If @a context_constructor is not @c NULL, call it with @a context_baton
+ * once per worker thread and pass the resulting object to all invocations
+ * of @a process_func within that thread.
+ *
+ * The first error returned by any of the callbacks - taken in item order -
+ * will be returned.  Items that have not been started, yet, will be
+ * skipped in that case and errors returned for later items get cleared.
+ *
+ * @a cancel_func, if not @c NULL, will be called with @a cancel_baton
+ * from within the worker threads as well as from within the caller's
+ * thread and must therefore be thread-safe.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_task__run(int thread_count,
+              int item_count,
+              svn_task__process_func_t process_func,
+              void *process_baton,
+              svn_task__output_func_t output_func,
+              void *output_baton,
+              svn_task__thread_context_constructor_t context_constructor,
+              void *context_baton,
+              svn_cancel_func_t cancel_func,
+              void *cancel_baton,
+              apr_pool_t *scratch_pool);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_TASK_H */
@@ -398,6 +398,28 @@ svn_wc__status2_from_3(svn_wc_status2_t **status,
                        apr_pool_t *result_pool,
                        apr_pool_t *scratch_pool);
 
+/**
+ * Like svn_wc_walk_status(), but compare the texts of modified files
+ * with up to @a thread_count threads, or with as many as configured for
+ * @a wc_ctx if that is more.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_wc__walk_status_threaded(svn_wc_context_t *wc_ctx,
+                             const char *local_abspath,
+                             svn_depth_t depth,
+                             svn_boolean_t get_all,
+                             svn_boolean_t no_ignore,
+                             svn_boolean_t ignore_text_mods,
+                             const apr_array_header_t *ignore_patterns,
+                             int thread_count,
+                             svn_wc_status_func4_t status_func,
+                             void *status_baton,
+                             svn_cancel_func_t cancel_func,
+                             void *cancel_baton,
+                             apr_pool_t *scratch_pool);
+
 /**
  * Set @a *children to a new array of the immediate children of the working
  * node at @a dir_abspath.  The elements of @a *children are (const char *)
@@ -2069,6 +2091,141 @@ svn_wc__complete_directory_add(svn_wc_context_t *wc_ctx,
                                apr_pool_t *scratch_pool);
 
 
+/* A merge into a working file that is split into phases, so that the
+   merging of the file contents can run concurrently with other work.
+   svn_wc_merge5() is the same as running all phases at once. */
+typedef struct svn_wc__file_merge_t svn_wc__file_merge_t;
+
+/* Start merging into TARGET_ABSPATH and return the merge in *MERGE,
+   allocated in RESULT_POOL.  The parameters are the same as for
+   svn_wc_merge5(), with MERGE_PROPS replacing a non-NULL
+   MERGE_PROPS_OUTCOME.
+
+   This checks the target, merges the properties and handles trivial and
+   binary merges.  LEFT_ABSPATH and RIGHT_ABSPATH must remain unchanged
+   until svn_wc__file_merge_finish() has been called, unless
+   svn_wc__file_merge_detach() has been called.
+
+   The working copy is not modified before svn_wc__file_merge_finish(). */
+svn_error_t *
+svn_wc__file_merge_begin(svn_wc__file_merge_t **merge,
+                         svn_wc_context_t *wc_ctx,
+                         const char *left_abspath,
+                         const char *right_abspath,
+                         const char *target_abspath,
+                         const char *left_label,
+                         const char *right_label,
+                         const char *target_label,
+                         const svn_wc_conflict_version_t *left_version,
+                         const svn_wc_conflict_version_t *right_version,
+                         svn_boolean_t dry_run,
+                         const char *diff3_cmd,
+                         const apr_array_header_t *merge_options,
+                         apr_hash_t *original_props,
+                         const apr_array_header_t *prop_diff,
+                         svn_boolean_t merge_props,
+                         svn_cancel_func_t cancel_func,
+                         void *cancel_baton,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool);
+
+/* Return TRUE if the contents of the files still need to be merged for
+   MERGE, i.e. if svn_wc__file_merge_run() will do any actual work. */
+svn_boolean_t
+svn_wc__file_merge_pending(const svn_wc__file_merge_t *merge);
+
+/* If MERGE is pending, copy the LEFT_ABSPATH and RIGHT_ABSPATH files
+   given to svn_wc__file_merge_begin() into temporary files that will be
+   removed when RESULT_POOL gets cleaned up.  The caller's files may then
+   be removed before MERGE has been completed. */
+svn_error_t *
+svn_wc__file_merge_detach(svn_wc__file_merge_t *merge,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
+/* Merge the file contents for MERGE, if necessary.
+
+   This neither accesses the working copy database nor the WC_CTX given
+   to svn_wc__file_merge_begin().  It may therefore be called from any
+   thread, as long as no two threads work on the same MERGE.  CANCEL_FUNC
+   must be thread-safe in that case. */
+svn_error_t *
+svn_wc__file_merge_run(svn_wc__file_merge_t *merge,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *scratch_pool);
+
+/* Complete MERGE after svn_wc__file_merge_run(): install the result,
+   record conflicts and invoke CONFLICT_FUNC, just like svn_wc_merge5().
+   Set *MERGE_CONTENT_OUTCOME and, if not NULL, *MERGE_PROPS_OUTCOME as
+   documented there.
+
+   This must be called from the thread that owns the working copy
+   context. */
+svn_error_t *
+svn_wc__file_merge_finish(enum svn_wc_merge_outcome_t *merge_content_outcome,
+                          enum svn_wc_notify_state_t *merge_props_outcome,
+                          svn_wc__file_merge_t *merge,
+                          svn_wc_conflict_resolver_func2_t conflict_func,
+                          void *conflict_baton,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *scratch_pool);
+
+
+/* The transmission of a file's text during a commit, split into phases
+   so that the delta can be computed concurrently with other work.
+   svn_wc_transmit_text_deltas3() is the same as running all phases at
+   once. */
+typedef struct svn_wc__text_delta_t svn_wc__text_delta_t;
+
+/* Start transmitting the text of LOCAL_ABSPATH and return it in *DELTA,
+   allocated in RESULT_POOL.  Send a fulltext if FULLTEXT is set.  This
+   opens the working file and the pristine text and prepares the new
+   pristine text, but nothing gets read yet.
+
+   RESULT_POOL must not be cleared or destroyed before
+   svn_wc__text_delta_finish() has been called.  The new windows will be
+   allocated in it, too. */
+svn_error_t *
+svn_wc__text_delta_begin(svn_wc__text_delta_t **delta,
+                         svn_wc_context_t *wc_ctx,
+                         const char *local_abspath,
+                         svn_boolean_t fulltext,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool);
+
+/* Compute the delta windows for DELTA ahead of time, until the windows
+   hold MAX_SIZE bytes of target text or the delta is complete.
+
+   This neither accesses the working copy database nor the WC_CTX given
+   to svn_wc__text_delta_begin().  It may therefore be called from any
+   thread, as long as no two threads work on the same DELTA.  CANCEL_FUNC
+   must be thread-safe in that case.  It may be called at most once. */
+svn_error_t *
+svn_wc__text_delta_run(svn_wc__text_delta_t *delta,
+                       apr_size_t max_size,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *scratch_pool);
+
+/* Send DELTA to FILE_BATON of EDITOR: the windows computed by
+   svn_wc__text_delta_run(), if any, followed by the rest of the delta.
+   Then install the new pristine text and close FILE_BATON, just like
+   svn_wc_transmit_text_deltas3() with the same output parameters.
+
+   This must be called from the thread that owns the working copy
+   context. */
+svn_error_t *
+svn_wc__text_delta_finish(const svn_checksum_t **new_text_base_md5_checksum,
+                          const svn_checksum_t **new_text_base_sha1_checksum,
+                          svn_wc__text_delta_t *delta,
+                          const svn_delta_editor_t *editor,
+                          void *file_baton,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
+
 /* Acquire a write lock on LOCAL_ABSPATH or an ancestor that covers
    all possible paths affected by resolving the conflicts in the tree
    LOCAL_ABSPATH.  Set *LOCK_ROOT_ABSPATH to the path of the lock
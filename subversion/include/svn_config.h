@@ -112,11 +112,18 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_HTTP_MAX_CONNECTIONS      "http-max-connections"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_HTTP_CHUNKED_REQUESTS     "http-chunked-requests"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_HTTP_COMMIT_PIPELINE_DEPTH \
+                                          "http-commit-pipeline-depth"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_HTTP_BASELINE_CACHE       "http-baseline-cache"
 
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_SERF_LOG_COMPONENTS       "serf-log-components"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_SERF_LOG_LEVEL            "serf-log-level"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_SVN_IDLE_CONNECTIONS      "svn-idle-connections"
 
 
 #define SVN_CONFIG_CATEGORY_CONFIG          "config"
@@ -161,6 +168,20 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_MEMORY_CACHE_SIZE         "memory-cache-size"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_DIFF_IGNORE_CONTENT_TYPE  "diff-ignore-content-type"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_MERGE_THREADS             "merge-threads"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_COMMIT_THREADS            "commit-threads"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_BLAME_THREADS             "blame-threads"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_EXTERNALS_THREADS         "externals-threads"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_UPDATE_THREADS            "update-threads"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_EXPORT_THREADS            "export-threads"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_LOCAL_FULLTEXT_LIMIT      "local-fulltext-limit"
 #define SVN_CONFIG_SECTION_TUNNELS              "tunnels"
 #define SVN_CONFIG_SECTION_AUTO_PROPS           "auto-props"
 /** @since New in 1.8. */
@@ -171,6 +192,20 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_SQLITE_EXCLUSIVE_CLIENTS  "exclusive-locking-clients"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_SQLITE_BUSY_TIMEOUT       "busy-timeout"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_INSTALL_THREADS           "install-threads"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_STATUS_THREADS            "status-threads"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_CLEANUP_THREADS           "cleanup-threads"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_FSMONITOR                 "fsmonitor"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_SHARED_PRISTINE_DIR       "shared-pristine-dir"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_SQLITE_WAL                "wal-journal"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_NODE_CACHE_SIZE           "node-cache-size"
 /** @} */
 
 /** @name Repository conf directory configuration files strings
@@ -191,6 +226,8 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_FORCE_USERNAME_CASE       "force-username-case"
 /** @since New in 1.8. */
 #define SVN_CONFIG_OPTION_HOOKS_ENV                 "hooks-env"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_AUTH_TICKET_LIFETIME      "auth-ticket-lifetime"
 /** @since New in 1.5. */
 #define SVN_CONFIG_SECTION_SASL                 "sasl"
 /** @since New in 1.5. */
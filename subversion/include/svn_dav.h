@@ -413,6 +413,15 @@ extern "C" {
 #define SVN_DAV_NS_DAV_SVN_SVNDIFF2\
             SVN_DAV_PROP_NS_DAV "svn/svndiff2"
 
+/** Presence of this in a DAV header in an OPTIONS response indicates
+ * that the transmitter (in this case, the server) knows how to handle
+ * svndiff3 format encoding.
+ *
+ * @since New in 1.15.
+ */
+#define SVN_DAV_NS_DAV_SVN_SVNDIFF3\
+            SVN_DAV_PROP_NS_DAV "svn/svndiff3"
+
 /** Presence of this in a DAV header in an OPTIONS response indicates
  * that the transmitter (in this case, the server) sends the result
  * checksum in the response to a successful PUT request.
@@ -422,6 +431,16 @@ extern "C" {
 #define SVN_DAV_NS_DAV_SVN_PUT_RESULT_CHECKSUM\
             SVN_DAV_PROP_NS_DAV "svn/put-result-checksum"
 
+/** Presence of this in a DAV header in an OPTIONS response indicates
+ * that the transmitter (in this case, the server) knows how to send
+ * delta-encoded <S:entry> elements in a log report for revisions that
+ * carry nothing but svn:author and svn:date.
+ *
+ * @since New in 1.15.
+ */
+#define SVN_DAV_NS_DAV_SVN_LOG_COMPACT\
+            SVN_DAV_PROP_NS_DAV "svn/log-compact"
+
 /** @} */
 
 /** @} */
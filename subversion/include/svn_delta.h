@@ -526,7 +526,10 @@ svn_txdelta_apply(svn_stream_t *source,
  *
  * @since New in 1.7.  Since 1.10, @a svndiff_version can be 2 for the
  * svndiff2 format.  @a compression_level is currently ignored if
- * @a svndiff_version is set to 2.
+ * @a svndiff_version is set to 2.  Since 1.15, @a svndiff_version can be
+ * 3 for the Zstandard-based svndiff3 format, which is only available if
+ * Subversion has been built with zstd support.  In that case,
+ * @a compression_level is the zstd compression level from 1 to 19.
  */
 void
 svn_txdelta_to_svndiff3(svn_txdelta_window_handler_t *handler,
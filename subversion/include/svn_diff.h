@@ -455,6 +455,28 @@ typedef enum svn_diff_file_ignore_space_t
   svn_diff_file_ignore_space_all
 } svn_diff_file_ignore_space_t;
 
+/** How lines get matched between the files being compared.
+ *
+ * @since New in 1.15.
+ */
+typedef enum svn_diff_file_algorithm_t
+{
+  /** Find a minimal diff as with #svn_diff_file_algorithm_minimal, unless
+   * the files differ so much that this would take very long.  In that
+   * case, fall back to #svn_diff_file_algorithm_patience. */
+  svn_diff_file_algorithm_default,
+
+  /** Always find a minimal diff.  The time this takes grows with the
+   * product of the file size and the number of differences. */
+  svn_diff_file_algorithm_minimal,
+
+  /** Match lines that occur exactly once in both files first and diff
+   * the sections between them recursively.  This is fast even for large
+   * files with many changes, and tends to keep moved blocks of code
+   * together.  The diff may not be minimal, though. */
+  svn_diff_file_algorithm_patience
+} svn_diff_file_algorithm_t;
+
 /** Options to control the behaviour of the file diff routines.
  *
  * @since New in 1.4.
@@ -487,6 +509,12 @@ typedef struct svn_diff_file_options_t
    *
    * @since New in 1.9 */
   int context_size;
+
+  /** How to match lines between the files.  The default is
+   * @c svn_diff_file_algorithm_default.
+   *
+   * @since New in 1.15 */
+  svn_diff_file_algorithm_t algorithm;
 } svn_diff_file_options_t;
 
 /** Allocate a @c svn_diff_file_options_t structure in @a pool, initializing
@@ -510,6 +538,8 @@ svn_diff_file_options_create(apr_pool_t *pool);
  * - --ignore-eol-style
  * - --show-c-function, -p @since New in 1.5.
  * - --context, -U ARG @since New in 1.9.
+ * - --minimal @since New in 1.15.
+ * - --patience @since New in 1.15.
  * - --unified, -u (for compatibility, does nothing).
  */
 svn_error_t *
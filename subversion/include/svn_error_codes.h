@@ -1502,6 +1502,21 @@ SVN_ERROR_START
              SVN_ERR_MISC_CATEGORY_START + 47,
              "Could not canonicalize path or URI")
 
+  /** @since New in 1.15. */
+  SVN_ERRDEF(SVN_ERR_ZSTD_COMPRESSION_FAILED,
+             SVN_ERR_MISC_CATEGORY_START + 48,
+             "Zstandard compression failed")
+
+  /** @since New in 1.15. */
+  SVN_ERRDEF(SVN_ERR_ZSTD_DECOMPRESSION_FAILED,
+             SVN_ERR_MISC_CATEGORY_START + 49,
+             "Zstandard decompression failed")
+
+  /** @since New in 1.15. */
+  SVN_ERRDEF(SVN_ERR_REDIS_REPLY,
+             SVN_ERR_MISC_CATEGORY_START + 50,
+             "Unexpected reply from Redis server")
+
   /* command-line client errors */
 
   SVN_ERRDEF(SVN_ERR_CL_ARG_PARSING_ERROR,
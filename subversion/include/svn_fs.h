@@ -166,6 +166,60 @@ typedef struct svn_fs_t svn_fs_t;
  */
 #define SVN_FS_CONFIG_FSFS_LOG_ADDRESSING       "fsfs-log-addressing"
 
+/** String with a decimal representation of the maximum number of worker
+ * threads that svn_fs_verify() may use to verify FSFS format 7 shards
+ * concurrently.  Values of "1" or less (the default) select the
+ * sequential verification.
+ *
+ * @note Concurrent verification accesses the process-wide caches from
+ * multiple threads.  It will therefore only be used if the cache has not
+ * been configured as single-threaded, see #svn_cache_config_t.
+ *
+ * @since New in 1.15.
+ */
+#define SVN_FS_CONFIG_FSFS_VERIFY_JOBS          "fsfs-verify-jobs"
+
+/** String with a decimal representation of the maximum number of worker
+ * threads that svn_fs_pack2() may use to pack FSFS shards concurrently.
+ * Values of "1" or less (the default) select the sequential packing.
+ *
+ * @note The same restrictions as for #SVN_FS_CONFIG_FSFS_VERIFY_JOBS
+ * apply.  In concurrent mode, the cancellation callback may be invoked
+ * from several threads at once.
+ *
+ * @since New in 1.15.
+ */
+#define SVN_FS_CONFIG_FSFS_PACK_JOBS            "fsfs-pack-jobs"
+
+/** String with a decimal representation of the maximum number of worker
+ * threads that svn_fs_hotcopy4() may use to copy packed FSFS shards
+ * concurrently.  Values of "1" or less (the default) select the
+ * sequential copying.
+ *
+ * @note In concurrent mode, the cancellation callback may be invoked
+ * from several threads at once.
+ *
+ * @since New in 1.15.
+ */
+#define SVN_FS_CONFIG_FSFS_HOTCOPY_JOBS         "fsfs-hotcopy-jobs"
+
+/** Enable / disable an in-memory Bloom filter in front of the FSFS
+ * rep-cache database.  It allows commits to skip the database lookup
+ * for most representations that are not yet known to the rep-cache.
+ * This is most useful for long-running bulk operations like loading
+ * dump files, where many commits go through the same filesystem object.
+ * The filter is built from the database upon first use.
+ *
+ * @note Representations added to the rep-cache by other processes after
+ * the filter has been built will not be found.  This does not affect
+ * correctness but may reduce the savings from rep-sharing.
+ *
+ * Default is disabled.
+ *
+ * @since New in 1.15.
+ */
+#define SVN_FS_CONFIG_FSFS_REP_CACHE_FILTER     "fsfs-rep-cache-filter"
+
 /* Note to maintainers: if you add further SVN_FS_CONFIG_FSFS_CACHE_* knobs,
    update fs_fs.c:verify_as_revision_before_current_plus_plus(). */
 
@@ -553,10 +607,33 @@ typedef void (*svn_fs_hotcopy_notify_t)(void *baton,
  * @a cancel_baton as usual to allow the user to preempt this potentially
  * lengthy operation.
  *
+ * @a fs_config is passed to the filesystem objects opened for the source
+ * and the destination and may be @c NULL.  It can e.g. be used to enable
+ * concurrent copying, see #SVN_FS_CONFIG_FSFS_HOTCOPY_JOBS.
+ *
  * Use @a scratch_pool for temporary allocations.
  *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_fs_hotcopy4(const char *src_path,
+                const char *dest_path,
+                svn_boolean_t clean,
+                svn_boolean_t incremental,
+                apr_hash_t *fs_config,
+                svn_fs_hotcopy_notify_t notify_func,
+                void *notify_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_fs_hotcopy4(), but with @a fs_config always passed as @c NULL.
+ *
+ * @deprecated Provided for backward compatibility with the 1.14 API.
  * @since New in 1.9.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_fs_hotcopy3(const char *src_path,
                 const char *dest_path,
@@ -3301,11 +3378,29 @@ typedef svn_error_t *(*svn_fs_pack_notify_t)(void *baton,
                                              apr_pool_t *pool);
 
 /**
- * Possibly update the filesystem located in the directory @a path
- * to use disk space more efficiently.
+ * Possibly update the filesystem located in the directory @a db_path
+ * to use disk space more efficiently.  Use the backend-specific
+ * configuration @a fs_config when opening the filesystem.  @a fs_config
+ * may be @c NULL.
  *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_fs_pack2(const char *db_path,
+             apr_hash_t *fs_config,
+             svn_fs_pack_notify_t notify_func,
+             void *notify_baton,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *pool);
+
+/**
+ * Like svn_fs_pack2() but with @a fs_config being set to @c NULL.
+ *
+ * @deprecated Provided for backward compatibility with the 1.14 API.
  * @since New in 1.6.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_fs_pack(const char *db_path,
             svn_fs_pack_notify_t notify_func,
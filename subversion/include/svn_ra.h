@@ -1101,6 +1101,99 @@ svn_ra_get_file(svn_ra_session_t *session,
                 apr_hash_t **props,
                 apr_pool_t *pool);
 
+/**
+ * Like svn_ra_get_file() but push only the @a length bytes of the file
+ * contents that start at @a offset to @a stream.  Fewer bytes will be
+ * pushed if the file ends before @a offset + @a length.  @a stream may
+ * not be @c NULL.
+ *
+ * If the server has the #SVN_RA_CAPABILITY_GET_FILE_RANGE capability,
+ * it only reconstructs and sends the requested range, so the cost is
+ * roughly proportional to @a length rather than to the file size.
+ * Otherwise, this falls back to fetching the whole file and discarding
+ * the data outside the range.
+ *
+ * The stream handlers for @a stream may not perform any RA
+ * operations using @a session.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_ra_get_file_range(svn_ra_session_t *session,
+                      const char *path,
+                      svn_revnum_t revision,
+                      svn_filesize_t offset,
+                      svn_filesize_t length,
+                      svn_stream_t *stream,
+                      svn_revnum_t *fetched_rev,
+                      apr_hash_t **props,
+                      apr_pool_t *pool);
+
+/**
+ * A file to be fetched by svn_ra_get_files().
+ *
+ * @since New in 1.15.
+ */
+typedef struct svn_ra_file_request_t
+{
+  /** The path of the file, relative to the URL of the session. */
+  const char *path;
+
+  /** The revision to fetch, or #SVN_INVALID_REVNUM for HEAD. */
+  svn_revnum_t revision;
+
+  /** If not @c NULL, the contents of the file get pushed to this stream.
+   * It will not be closed. */
+  svn_stream_t *stream;
+} svn_ra_file_request_t;
+
+/**
+ * The callback invoked by svn_ra_get_files() after @a file has been
+ * fetched and its contents, if requested, have been pushed to
+ * @a file->stream.  @a fetched_rev is the revision that was actually
+ * retrieved.  @a props contains the properties of the file as described
+ * for svn_ra_get_file(), or is @c NULL if they were not requested.
+ *
+ * @a props is allocated in @a scratch_pool, which will be cleared after
+ * the callback returns.
+ *
+ * @since New in 1.15.
+ */
+typedef svn_error_t *(*svn_ra_file_receiver_t)(
+  void *baton,
+  const svn_ra_file_request_t *file,
+  svn_revnum_t fetched_rev,
+  apr_hash_t *props,
+  apr_pool_t *scratch_pool);
+
+/**
+ * Fetch the contents and, if @a want_props is set, the properties of all
+ * @a files, an array of <tt>svn_ra_file_request_t *</tt>, just like
+ * svn_ra_get_file() would do for each of them.  Call @a receiver with
+ * @a receiver_baton for every file, in the order given by @a files.
+ * @a receiver may be @c NULL.
+ *
+ * If the server has the #SVN_RA_CAPABILITY_GET_FILES capability, the
+ * requests are sent in batches without waiting for the previous files
+ * to arrive, so the latency of the connection does not add up with the
+ * number of files.  Otherwise, this falls back to calling
+ * svn_ra_get_file() for every file.
+ *
+ * Stop at and return the first error.  The stream handlers and
+ * @a receiver may not perform any RA operations using @a session.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_ra_get_files(svn_ra_session_t *session,
+                 const apr_array_header_t *files,
+                 svn_boolean_t want_props,
+                 svn_ra_file_receiver_t receiver,
+                 void *receiver_baton,
+                 apr_pool_t *scratch_pool);
+
 /**
  * If @a dirents is non @c NULL, set @a *dirents to contain all the entries
  * of directory @a path at @a revision.  The keys of @a dirents will be
@@ -1898,6 +1991,50 @@ svn_ra_get_file_revs2(svn_ra_session_t *session,
                       void *handler_baton,
                       apr_pool_t *pool);
 
+/**
+ * The callback invoked by svn_ra_get_blame() for every line of the file,
+ * in order.  @a line_no is the 0-based line number and @a revision the
+ * revision that last changed that line, or #SVN_INVALID_REVNUM if that
+ * revision is older than the requested range.  @a pool may be used for
+ * temporary allocations.
+ *
+ * @since New in 1.15.
+ */
+typedef svn_error_t *(*svn_ra_blame_receiver_t)(void *baton,
+                                                apr_int64_t line_no,
+                                                svn_revnum_t revision,
+                                                apr_pool_t *pool);
+
+/**
+ * Let the server annotate every line of the file @a path in revision
+ * @a end with the revision that last changed it.  Lines last changed
+ * before @a start will be reported with #SVN_INVALID_REVNUM.  Call
+ * @a receiver with @a receiver_baton for every line, in order.
+ *
+ * The result matches what svn_ra_get_file_revs2() with
+ * @a include_merged_revisions set to FALSE provides for a client-side
+ * blame with default diff options.  However, only the annotations get
+ * transmitted and the server may reuse results of previous requests.
+ *
+ * @a path is relative to the URL of @a session.  @a start must not be
+ * larger than @a end.
+ *
+ * If the server does not have the #SVN_RA_CAPABILITY_SERVER_BLAME
+ * capability, return #SVN_ERR_UNSUPPORTED_FEATURE.
+ *
+ * Use @a pool for temporary allocations.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_ra_get_blame(svn_ra_session_t *session,
+                 const char *path,
+                 svn_revnum_t start,
+                 svn_revnum_t end,
+                 svn_ra_blame_receiver_t receiver,
+                 void *receiver_baton,
+                 apr_pool_t *pool);
+
 /**
  * Similar to svn_ra_get_file_revs2(), but with @a include_merged_revisions
  * set to FALSE.
@@ -2265,6 +2402,30 @@ svn_ra_has_capability(svn_ra_session_t *session,
  */
 #define SVN_RA_CAPABILITY_LIST "list"
 
+/**
+ * The capability of a server to annotate file lines, see svn_ra_get_blame().
+ *
+ * @since New in 1.15.
+ */
+#define SVN_RA_CAPABILITY_SERVER_BLAME "server-blame"
+
+/**
+ * The capability of a server to send many files in response to a single
+ * request, see svn_ra_get_files().
+ *
+ * @since New in 1.15.
+ */
+#define SVN_RA_CAPABILITY_GET_FILES "get-files"
+
+/**
+ * The capability of a server to send only a byte range of a file,
+ * reconstructing no more of the file than necessary, see
+ * svn_ra_get_file_range().
+ *
+ * @since New in 1.15.
+ */
+#define SVN_RA_CAPABILITY_GET_FILE_RANGE "get-file-range"
+
 
 /*       *** PLEASE READ THIS IF YOU ADD A NEW CAPABILITY ***
  *
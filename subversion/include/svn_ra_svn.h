@@ -50,6 +50,8 @@ extern "C" {
 #define SVN_RA_SVN_CAP_EDIT_PIPELINE "edit-pipeline"
 #define SVN_RA_SVN_CAP_SVNDIFF1 "svndiff1"
 #define SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED "accepts-svndiff2"
+/** @since New in 1.15. */
+#define SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED "accepts-svndiff3"
 #define SVN_RA_SVN_CAP_ABSENT_ENTRIES "absent-entries"
 /* maps to SVN_RA_CAPABILITY_COMMIT_REVPROPS: */
 #define SVN_RA_SVN_CAP_COMMIT_REVPROPS "commit-revprops"
@@ -71,6 +73,16 @@ extern "C" {
 #define SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE "file-revs-reverse"
 /* maps to SVN_RA_CAPABILITY_LIST */
 #define SVN_RA_SVN_CAP_LIST "list"
+/* maps to SVN_RA_CAPABILITY_GET_FILES */
+#define SVN_RA_SVN_CAP_GET_FILES "get-files"
+/* maps to SVN_RA_CAPABILITY_GET_FILE_RANGE */
+#define SVN_RA_SVN_CAP_GET_FILE_RANGE "get-file-range"
+/** The server issues auth tickets, or the client accepts them.
+ * @since New in 1.15. */
+#define SVN_RA_SVN_CAP_AUTH_TICKET "auth-ticket"
+/** If both sides announce this, all data following the repos-info
+ * response gets LZ4-compressed.  @since New in 1.15. */
+#define SVN_RA_SVN_CAP_COMPRESS_STREAM "compress-stream"
 
 
 /** ra_svn passes @c svn_dirent_t fields over the wire as a list of
@@ -181,7 +193,7 @@ typedef svn_error_t *(*svn_ra_svn_edit_callback)(void *baton);
  * @a compression_level specifies the desired network data compression
  * level from 0 (no compression) to 9 (best but slowest). The effect
  * of the parameter depends on the compression algorithm; for example,
- * it is used verbatim by zlib/deflate but ignored by LZ4.
+ * it is used verbatim by zlib/deflate and Zstandard but ignored by LZ4.
  *
  * If @a zero_copy_limit is not 0, cached file contents smaller than the
  * given limit may be sent directly to the network socket.  Otherwise,
@@ -680,10 +680,32 @@ svn_repos_fs_type(svn_repos_t *repos,
  * @a cancel_baton as usual to allow the user to preempt this potentially
  * lengthy operation.
  *
+ * @a fs_config is passed to svn_fs_hotcopy4() and may be @c NULL.
+ *
  * Use @a scratch_pool for temporary allocations.
  *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_repos_hotcopy4(const char *src_path,
+                   const char *dst_path,
+                   svn_boolean_t clean_logs,
+                   svn_boolean_t incremental,
+                   apr_hash_t *fs_config,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_repos_hotcopy4(), but with @a fs_config always passed as
+ * @c NULL.
+ *
  * @since New in 1.9.
+ * @deprecated Provided for backward compatibility with the 1.14 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_hotcopy3(const char *src_path,
                    const char *dst_path,
@@ -1005,6 +1027,21 @@ svn_repos_hooks_setenv(svn_repos_t *repos,
 /* Reporting the state of a working copy, for updates. */
 
 
+/** Key in the @c fs_config hash given to svn_repos_open3() whose value is
+ * a string with a decimal representation of the maximum number of worker
+ * threads that the editor drive of svn_repos_begin_report3() may use to
+ * compute the text deltas of files ahead of time.  Values of "1" or less
+ * (the default) compute each delta when the editor drive reaches it.
+ *
+ * @note The workers access the process-wide caches from multiple threads.
+ * They will therefore only be used if the cache has not been configured
+ * as single-threaded, see #svn_cache_config_t.  Worker threads are not
+ * available for BDB repositories.
+ *
+ * @since New in 1.15.
+ */
+#define SVN_REPOS_CONFIG_REPORT_JOBS "repos-report-jobs"
+
 /**
  * Construct and return a @a report_baton that will be passed to the
  * other functions in this section to describe the state of a pre-existing
@@ -1051,7 +1088,9 @@ svn_repos_hooks_setenv(svn_repos_t *repos,
  * maximize throughput.  However, until the whole block has been
  * pushed to the network stack, other clients block, so be careful
  * when using larger values here.  Pass 0 for @a zero_copy_limit to
- * disable this optimization altogether.
+ * disable this optimization altogether.  Only cached data can be sent
+ * that way.  Besides added files, it will also be used for changed files
+ * of up to 16kB, which will then be sent in full instead of as a delta.
  *
  * @note Never activate this optimization if @a editor might access
  * any FSFS data structures (and, hence, caches).  So, it is basically
@@ -1089,6 +1128,10 @@ svn_repos_hooks_setenv(svn_repos_t *repos,
  * than or equal to the depth of the working copy, then the editor
  * operations will affect only paths at or above @a depth.
  *
+ * The text deltas of files may be computed ahead of the editor drive by
+ * several threads, as configured by #SVN_REPOS_CONFIG_REPORT_JOBS.  The
+ * @a editor will still only be driven from within the calling thread.
+ *
  * @since New in 1.8.
  */
 svn_error_t *
@@ -1520,6 +1563,96 @@ svn_repos_replay(svn_fs_root_t *root,
                  void *edit_baton,
                  apr_pool_t *pool);
 
+/**
+ * Key in the @c fs_config hash given to svn_repos_open3() whose value is
+ * a string with a decimal representation of the maximum number of worker
+ * threads that svn_repos_replay_range() may use to read the changes of
+ * upcoming revisions ahead of time.  Values of "1" or less (the default)
+ * read each revision only when it gets replayed.
+ *
+ * @note The workers access the process-wide caches from multiple threads.
+ * They will therefore only be used if the cache has not been configured
+ * as single-threaded, see #svn_cache_config_t.  Worker threads are not
+ * available for BDB repositories.
+ *
+ * @since New in 1.15.
+ */
+#define SVN_REPOS_CONFIG_REPLAY_JOBS "repos-replay-jobs"
+
+/**
+ * Callback invoked by svn_repos_replay_range() before replaying
+ * @a revision.  Set @a *editor and @a *edit_baton to the editor to
+ * replay the revision with.  @a rev_props contains the readable revision
+ * properties of @a revision.  @a replay_baton is the baton given to
+ * svn_repos_replay_range() and @a pool may be used for allocations that
+ * are needed until the corresponding #svn_repos_replay_revfinish_func_t
+ * call returns.
+ *
+ * @since New in 1.15.
+ */
+typedef svn_error_t *(*svn_repos_replay_revstart_func_t)(
+  svn_revnum_t revision,
+  void *replay_baton,
+  const svn_delta_editor_t **editor,
+  void **edit_baton,
+  apr_hash_t *rev_props,
+  apr_pool_t *pool);
+
+/**
+ * Callback invoked by svn_repos_replay_range() after replaying
+ * @a revision with @a editor and @a edit_baton.  It is the callback's
+ * responsibility to close the edit.  The other parameters are the same
+ * as for #svn_repos_replay_revstart_func_t.
+ *
+ * @since New in 1.15.
+ */
+typedef svn_error_t *(*svn_repos_replay_revfinish_func_t)(
+  svn_revnum_t revision,
+  void *replay_baton,
+  const svn_delta_editor_t *editor,
+  void *edit_baton,
+  apr_hash_t *rev_props,
+  apr_pool_t *pool);
+
+/**
+ * Replay all revisions from @a start_rev to @a end_rev, inclusive, of
+ * @a repos, in one go.  For each revision, call @a revstart_func with
+ * @a replay_baton to get an editor, drive it just like
+ * svn_repos_replay2() does with @a base_dir, @a low_water_mark,
+ * @a send_deltas, @a authz_read_func and @a authz_read_baton and finally
+ * call @a revfinish_func.  The revision properties passed to the
+ * callbacks are filtered with @a authz_read_func, just like
+ * svn_repos_fs_revision_proplist() does.  If replaying a revision fails,
+ * the edit will be aborted before returning the error.
+ *
+ * While a revision is being replayed, the changes of the following
+ * revisions may be read on worker threads, see
+ * #SVN_REPOS_CONFIG_REPLAY_JOBS.  This keeps the data of the next
+ * revisions in the caches by the time their editor drive needs them.
+ * The callbacks will still only be invoked from within the calling
+ * thread.
+ *
+ * @a cancel_func and @a cancel_baton are used for cancellation.
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_repos_replay_range(svn_repos_t *repos,
+                       svn_revnum_t start_rev,
+                       svn_revnum_t end_rev,
+                       const char *base_dir,
+                       svn_revnum_t low_water_mark,
+                       svn_boolean_t send_deltas,
+                       svn_repos_replay_revstart_func_t revstart_func,
+                       svn_repos_replay_revfinish_func_t revfinish_func,
+                       void *replay_baton,
+                       svn_repos_authz_func_t authz_read_func,
+                       void *authz_read_baton,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *scratch_pool);
+
 /* ---------------------------------------------------------------*/
 
 /* Making commits. */
@@ -1729,12 +1862,12 @@ svn_repos_stat(svn_dirent_t **dirent,
                apr_pool_t *pool);
 
 /**
- * Callback type to be used with svn_repos_list().  It will be invoked for
+ * Callback type to be used with svn_repos_list2().  It will be invoked for
  * every directory entry found.
  *
  * The full path of the entry is given in @a path and @a dirent contains
- * various additional information.  If svn_repos_list() has been called
- * with @a path_info_only set, only the @a kind element of this struct
+ * various additional information.  Only the @a kind element and those
+ * elements requested by the @a dirent_fields given to svn_repos_list2()
  * will be valid.
  *
  * @a baton is the user-provided receiver baton.  @a scratch_pool may be
@@ -1747,6 +1880,22 @@ typedef svn_error_t *(* svn_repos_dirent_receiver_t)(const char *path,
                                                      void *baton,
                                                      apr_pool_t *scratch_pool);
 
+/**
+ * Key in the @c fs_config hash given to svn_repos_open3() whose value is
+ * a string with a decimal representation of the maximum number of worker
+ * threads that svn_repos_list2() may use to walk independent sub-trees
+ * concurrently.  Values of "1" or less (the default) walk the whole tree
+ * in the calling thread.
+ *
+ * @note The workers access the process-wide caches from multiple threads.
+ * They will therefore only be used if the cache has not been configured
+ * as single-threaded, see #svn_cache_config_t.  Worker threads are not
+ * available for BDB repositories.
+ *
+ * @since New in 1.15.
+ */
+#define SVN_REPOS_CONFIG_LIST_JOBS "repos-list-jobs"
+
 /**
  * Efficiently list everything within a sub-tree.  Specify glob patterns
  * to search for specific files and folders.
@@ -1755,8 +1904,14 @@ typedef svn_error_t *(* svn_repos_dirent_receiver_t)(const char *path,
  * @a depth.  For each directory entry found, @a receiver will be called
  * with @a receiver_baton.  The starting @a path will be reported as well.
  * Because retrieving all elements of a #svn_dirent_t can be expensive,
- * you may set @a path_info_only to receive only the path name and the node
- * kind.  The entries will be reported ordered by their path.
+ * only those selected by @a dirent_fields (a combination of the
+ * @c SVN_DIRENT_* flags) will be retrieved.  The node kind will always be
+ * provided.  The entries will be reported ordered by their path.
+ *
+ * If @a root is a revision root and #SVN_REPOS_CONFIG_LIST_JOBS has been
+ * set for its filesystem, sub-trees of @a path get walked by several
+ * worker threads.  @a receiver will still only be called from the
+ * calling thread and in the same order.
  *
  * @a patterns is an optional array of <tt>const char *</tt>.  If it is
  * not @c NULL, only those directory entries will be reported whose last
@@ -1775,8 +1930,31 @@ typedef svn_error_t *(* svn_repos_dirent_receiver_t)(const char *path,
  *
  * Use @a scratch_pool for temporary memory allocation.
  *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_repos_list2(svn_fs_root_t *root,
+                const char *path,
+                const apr_array_header_t *patterns,
+                svn_depth_t depth,
+                apr_uint32_t dirent_fields,
+                svn_repos_authz_func_t authz_read_func,
+                void *authz_read_baton,
+                svn_repos_dirent_receiver_t receiver,
+                void *receiver_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *scratch_pool);
+
+/**
+ * Similar to svn_repos_list2(), but with @a path_info_only instead of
+ * @a dirent_fields.  If @a path_info_only is set, retrieve only the node
+ * kind.  Otherwise, retrieve all elements of the #svn_dirent_t.
+ *
  * @since New in 1.10.
+ * @deprecated Provided for backward compatibility with the 1.14 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_list(svn_fs_root_t *root,
                const char *path,
@@ -2112,6 +2290,22 @@ typedef svn_error_t *(*svn_repos_log_entry_receiver_t)(
   apr_pool_t *scratch_pool);
 
 
+/** Key in the @c fs_config hash given to svn_repos_open3() whose value is
+ * a string with a decimal representation of the maximum number of worker
+ * threads that svn_repos_get_logs5() may use to walk path histories.
+ * The workers look ahead in the histories of all log targets, including
+ * those of merged revisions, while the log entries are being sent.
+ * Values of "1" or less (the default) walk the histories sequentially.
+ *
+ * @note Concurrent walking accesses the process-wide caches from multiple
+ * threads.  It will therefore only be used if the cache has not been
+ * configured as single-threaded, see #svn_cache_config_t.  It is not
+ * available for BDB repositories.
+ *
+ * @since New in 1.15.
+ */
+#define SVN_REPOS_CONFIG_LOG_JOBS "repos-log-jobs"
+
 /**
  * Invoke @a revision_receiver with @a revision_receiver_baton on each
  * revision from @a start to @a end in @a repos's filesystem.  @a start may
@@ -2172,6 +2366,10 @@ typedef svn_error_t *(*svn_repos_log_entry_receiver_t)(
  * @a path_change_receiver is @c NULL, the same filtering is performed
  * just without reporting any path changes.
  *
+ * The histories may be walked by several threads, as configured by
+ * #SVN_REPOS_CONFIG_LOG_JOBS.  The callbacks will still only be invoked
+ * from within the calling thread and in the same order.
+ *
  * Use @a scratch_pool for temporary allocations.
  *
  * @see svn_repos_path_change_receiver_t, svn_repos_log_entry_receiver_t
@@ -2460,6 +2658,54 @@ svn_repos_get_file_revs(svn_repos_t *repos,
                         void *handler_baton,
                         apr_pool_t *pool);
 
+/**
+ * The callback invoked by svn_repos_blame() for every line of the file,
+ * in order.  @a line_no is the 0-based line number and @a revision the
+ * revision that last changed that line.  @a pool may be used for
+ * temporary allocations.
+ *
+ * @since New in 1.15.
+ */
+typedef svn_error_t *(*svn_repos_blame_receiver_t)(void *baton,
+                                                   apr_int64_t line_no,
+                                                   svn_revnum_t revision,
+                                                   apr_pool_t *pool);
+
+/**
+ * Annotate every line of the file at @a path in revision @a end with the
+ * revision that last changed it and report the result to @a receiver
+ * with @a receiver_baton.  Lines that were last changed before @a start
+ * are reported with #SVN_INVALID_REVNUM.  @a start must not be larger
+ * than @a end.
+ *
+ * This produces the same annotations as a client-side blame based on
+ * svn_repos_get_file_revs2() with @a include_merged_revisions set to
+ * FALSE and default diff options.  The annotations for each location in
+ * the file's history get cached, such that blaming a younger revision of
+ * the same file later only needs to process the revisions added since.
+ *
+ * If @a authz_read_func is not @c NULL, stop at the first unreadable
+ * location in the history of @a path, just like
+ * svn_repos_get_file_revs2() does.
+ *
+ * Use @a cancel_func and @a cancel_baton for cancellation and
+ * @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_repos_blame(svn_repos_t *repos,
+                const char *path,
+                svn_revnum_t start,
+                svn_revnum_t end,
+                svn_repos_authz_func_t authz_read_func,
+                void *authz_read_baton,
+                svn_repos_blame_receiver_t receiver,
+                void *receiver_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *scratch_pool);
+
 
 /* ---------------------------------------------------------------*/
 
@@ -3279,6 +3525,21 @@ svn_repos_verify_fs(svn_repos_t *repos,
                     void *cancel_baton,
                     apr_pool_t *pool);
 
+/** Key in the @c fs_config hash given to svn_repos_open3() whose value is
+ * a string with a decimal representation of the maximum number of worker
+ * threads that svn_repos_dump_fs4() may use to dump chunks of revisions
+ * concurrently.  Values of "1" or less (the default) dump all revisions
+ * sequentially.
+ *
+ * @note The workers access the process-wide caches from multiple threads.
+ * They will therefore only be used if the cache has not been configured
+ * as single-threaded, see #svn_cache_config_t.  Worker threads are not
+ * available for BDB repositories.
+ *
+ * @since New in 1.15.
+ */
+#define SVN_REPOS_CONFIG_DUMP_JOBS "repos-dump-jobs"
+
 /**
  * Dump the contents of the filesystem within already-open @a repos into
  * writable @a dumpstream.  If @a dumpstream is
@@ -3338,6 +3599,13 @@ svn_repos_verify_fs(svn_repos_t *repos,
  * @a cancel_baton as argument to see if the client wishes to cancel
  * the dump.
  *
+ * Chunks of revisions may be dumped by several threads, as configured by
+ * #SVN_REPOS_CONFIG_DUMP_JOBS.  The output will be the same as for a
+ * sequential dump, and @a notify_func will still only be called from
+ * within the calling thread and in the same order.  However,
+ * @a filter_func and @a cancel_func will then be called from multiple
+ * threads concurrently and must be thread-safe.
+ *
  * Use @a scratch_pool for temporary allocation.
  *
  * @since New in 1.10.
@@ -3420,6 +3688,23 @@ svn_repos_dump_fs(svn_repos_t *repos,
                   apr_pool_t *pool);
 
 
+/** Key in the @c fs_config hash given to svn_repos_open3() whose value is
+ * a boolean string.  If set, svn_repos_load_fs6() loads in bulk mode,
+ * asserting that nobody else accesses the repository during the load.
+ * Flushing the new revisions to disk and updating the rep-sharing cache
+ * then happen in large batches and at the end of the load instead of
+ * once per revision.  Also, mergeinfo that the load has already parsed
+ * and rewritten does not get validated a second time.  Revisions loaded
+ * in bulk mode may get lost if the system crashes before the load ends.
+ *
+ * @note Bulk mode is currently only implemented for FSFS repositories.
+ * Other backends load as usual.
+ *
+ * @since New in 1.15.
+ */
+#define SVN_REPOS_CONFIG_BULK_LOAD "repos-bulk-load"
+
+
 /**
  * Read and parse dumpfile-formatted @a dumpstream, reconstructing
  * filesystem revisions in already-open @a repos, handling uuids in
@@ -3479,6 +3764,9 @@ svn_repos_dump_fs(svn_repos_t *repos,
  * @a cancel_baton as argument to see if the client wishes to cancel
  * the load.
  *
+ * @a repos may be configured to load in bulk mode, see
+ * #SVN_REPOS_CONFIG_BULK_LOAD.
+ *
  * @since New in 1.10.
  */
 svn_error_t *
@@ -4306,6 +4594,28 @@ svn_repos_authz_check_access(svn_authz_t *authz,
                              svn_boolean_t *access_granted,
                              apr_pool_t *pool);
 
+/**
+ * Like svn_repos_authz_check_access() but check the paths of all
+ * children @a names (const char *) of @a parent_path at once.  Set the
+ * respective element of @a access_granted, which must provide room for
+ * @a names->nelts elements, to TRUE if access is granted for that child.
+ *
+ * @a parent_path must be an absolute path.  Evaluating the rules for all
+ * children together lets the lookup resume from @a parent_path instead
+ * of walking the full path for each child.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_repos_authz_check_children(svn_authz_t *authz,
+                               const char *repos_name,
+                               const char *parent_path,
+                               const apr_array_header_t *names,
+                               const char *user,
+                               svn_repos_authz_access_t required_access,
+                               svn_boolean_t *access_granted,
+                               apr_pool_t *pool);
+
 
 
 /** Revision Access Levels
@@ -22,10 +22,12 @@
  */
 
 #include <apr_pools.h>
+#include <apr_thread_proc.h>
 
 #include "client.h"
 
 #include "svn_client.h"
+#include "svn_config.h"
 #include "svn_subst.h"
 #include "svn_string.h"
 #include "svn_error.h"
@@ -37,6 +39,7 @@
 #include "svn_hash.h"
 #include "svn_sorts.h"
 
+#include "private/svn_task.h"
 #include "private/svn_wc_private.h"
 
 #include "svn_private_config.h"
@@ -106,8 +109,45 @@ struct file_rev_baton {
      happens when we move to the previous revision */
   svn_revnum_t last_revnum;
   apr_hash_t *last_props;
+
+  /* When comparing revisions on worker threads (THREADS > 1), the
+     received revisions that have not been blamed yet, the batch of
+     revisions being compared while they are received, and the pool
+     holding the file that the first revision of BATCH is compared
+     against.  PENDING is NULL if all revisions are blamed as they
+     arrive. */
+  int threads;
+  apr_array_header_t *pending;  /* pending_blame_t * */
+  struct blame_batch_t *batch;
+  apr_pool_t *last_file_pool;
 };
 
+/* A received revision whose blame has not been computed yet. */
+typedef struct pending_blame_t
+{
+  const char *last_file;   /* the previous file, or NULL for the first */
+  const char *cur_file;    /* the file for this revision */
+  struct rev *rev;         /* the rev struct for this revision */
+  apr_pool_t *file_pool;   /* CUR_FILE gets removed with this pool */
+  svn_diff_t *diff;        /* the comparison, once it is done */
+  apr_pool_t *diff_pool;   /* the pool DIFF is allocated in */
+} pending_blame_t;
+
+/* A batch of pending revisions being compared in the background. */
+typedef struct blame_batch_t
+{
+  struct file_rev_baton *frb;
+  apr_array_header_t *pending;  /* pending_blame_t * */
+  svn_error_t *err;             /* the result of comparing them */
+
+  apr_pool_t *pool;             /* root pool for the comparisons */
+
+#if APR_HAS_THREADS
+  /* The thread comparing them, or NULL if it has been joined. */
+  apr_thread_t *thread;
+#endif
+} blame_batch_t;
+
 /* The baton used by the txdelta window handler. Allocated per revision */
 struct delta_baton {
   /* Our underlying handler/baton that we wrap */
@@ -118,6 +158,7 @@ struct delta_baton {
   const char *filename;
   svn_boolean_t is_merged_revision;
   struct rev *rev;     /* the rev struct for the current revision */
+  apr_pool_t *file_pool;  /* the pool of FILENAME, if pending */
 };
 
 
@@ -282,6 +323,34 @@ static const svn_diff_output_fns_t output_fns = {
         output_diff_modified
 };
 
+/* Add the blame for DIFF to CHAIN, for revision REV.  DIFF may be NULL
+   in which case blame is added for every line of the file. */
+static svn_error_t *
+apply_file_blame(svn_diff_t *diff,
+                 struct blame_chain *chain,
+                 struct rev *rev,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton)
+{
+  if (!diff)
+    {
+      SVN_ERR_ASSERT(chain->blame == NULL);
+      chain->blame = blame_create(chain, rev, 0);
+    }
+  else
+    {
+      struct diff_baton diff_baton;
+
+      diff_baton.chain = chain;
+      diff_baton.rev = rev;
+
+      SVN_ERR(svn_diff_output2(diff, &diff_baton, &output_fns,
+                               cancel_func, cancel_baton));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Add the blame for the diffs between LAST_FILE and CUR_FILE to CHAIN,
    for revision REV.  LAST_FILE may be NULL in which
    case blame is added for every line of CUR_FILE. */
@@ -295,26 +364,191 @@ add_file_blame(const char *last_file,
                void *cancel_baton,
                apr_pool_t *pool)
 {
-  if (!last_file)
+  svn_diff_t *diff = NULL;
+
+  /* If we have a previous file, get the diff to adjust blame info. */
+  if (last_file)
+    SVN_ERR(svn_diff_file_diff_2(&diff, last_file, cur_file,
+                                 diff_options, pool));
+
+  return svn_error_trace(apply_file_blame(diff, chain, rev,
+                                          cancel_func, cancel_baton));
+}
+
+/* Implements svn_task__process_func_t, comparing the pending_blame_t
+   with the given INDEX in the blame_batch_t PROCESS_BATON with its
+   previous file and storing the svn_diff_t in it. */
+static svn_error_t *
+diff_pending_blame(void **result,
+                   int index,
+                   void *process_baton,
+                   void *thread_context,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  blame_batch_t *batch = process_baton;
+  pending_blame_t *pb = APR_ARRAY_IDX(batch->pending, index,
+                                      pending_blame_t *);
+
+  if (pb->last_file)
+    SVN_ERR(svn_diff_file_diff_2(&pb->diff, pb->last_file, pb->cur_file,
+                                 batch->frb->diff_options, pb->diff_pool));
+  *result = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Compare the revisions of BATCH on worker threads and store the result
+   in BATCH->ERR. */
+static void
+diff_batch(blame_batch_t *batch)
+{
+  struct file_rev_baton *frb = batch->frb;
+
+  batch->err = svn_task__run(frb->threads, batch->pending->nelts,
+                             diff_pending_blame, batch,
+                             NULL, NULL,
+                             NULL, NULL,
+                             frb->ctx->cancel_func, frb->ctx->cancel_baton,
+                             batch->pool);
+}
+
+#if APR_HAS_THREADS
+/* Thread function running diff_batch() for the blame_batch_t DATA. */
+static void * APR_THREAD_FUNC
+diff_batch_thread(apr_thread_t *thread,
+                  void *data)
+{
+  diff_batch(data);
+
+  apr_thread_exit(thread, APR_SUCCESS);
+  return NULL;
+}
+#endif
+
+/* Wait until the comparisons of BATCH are done. */
+static void
+wait_for_batch(blame_batch_t *batch)
+{
+#if APR_HAS_THREADS
+  if (batch->thread)
     {
-      SVN_ERR_ASSERT(chain->blame == NULL);
-      chain->blame = blame_create(chain, rev, 0);
+      apr_status_t retval;
+      apr_status_t status = apr_thread_join(&retval, batch->thread);
+
+      batch->thread = NULL;
+      if (status)
+        batch->err = svn_error_compose_create(
+                       batch->err,
+                       svn_error_wrap_apr(status, _("Can't join thread")));
     }
-  else
-    {
-      svn_diff_t *diff;
-      struct diff_baton diff_baton;
+#endif
+}
 
-      diff_baton.chain = chain;
-      diff_baton.rev = rev;
+/* Wait for the batch of revisions FRB is comparing, if any, and throw
+   the results away.  Used when blaming fails, so that the thread stops
+   using FRB and the files before they go away. */
+static void
+abandon_batch(struct file_rev_baton *frb)
+{
+  blame_batch_t *batch = frb->batch;
 
-      /* We have a previous file.  Get the diff and adjust blame info. */
-      SVN_ERR(svn_diff_file_diff_2(&diff, last_file, cur_file,
-                                   diff_options, pool));
-      SVN_ERR(svn_diff_output2(diff, &diff_baton, &output_fns,
-                               cancel_func, cancel_baton));
+  if (!batch)
+    return;
+
+  frb->batch = NULL;
+  wait_for_batch(batch);
+  svn_error_clear(batch->err);
+  svn_pool_destroy(batch->pool);
+}
+
+/* Wait for the batch of revisions FRB is comparing, if any, add their
+   blame to FRB->CHAIN and remove the files that are no longer needed. */
+static svn_error_t *
+finish_batch(struct file_rev_baton *frb)
+{
+  blame_batch_t *batch = frb->batch;
+  pending_blame_t *last;
+  svn_error_t *err;
+  int i;
+
+  if (!batch)
+    return SVN_NO_ERROR;
+
+  frb->batch = NULL;
+  wait_for_batch(batch);
+
+  err = batch->err;
+  for (i = 0; i < batch->pending->nelts && !err; i++)
+    {
+      pending_blame_t *pb = APR_ARRAY_IDX(batch->pending, i,
+                                          pending_blame_t *);
+
+      err = apply_file_blame(pb->diff, frb->chain, pb->rev,
+                             frb->ctx->cancel_func, frb->ctx->cancel_baton);
     }
 
+  /* Only the latest file is still needed, to be compared with the next
+     revision. */
+  last = APR_ARRAY_IDX(batch->pending, batch->pending->nelts - 1,
+                       pending_blame_t *);
+  if (frb->last_file_pool)
+    svn_pool_destroy(frb->last_file_pool);
+  for (i = 0; i < batch->pending->nelts - 1; i++)
+    svn_pool_destroy(APR_ARRAY_IDX(batch->pending, i,
+                                   pending_blame_t *)->file_pool);
+  frb->last_file_pool = last->file_pool;
+
+  svn_pool_destroy(batch->pool);
+
+  return svn_error_trace(err);
+}
+
+/* Blame the batch of revisions FRB has been comparing, if any, and start
+   comparing its pending revisions in the background while the next ones
+   are received. */
+static svn_error_t *
+start_batch(struct file_rev_baton *frb)
+{
+  blame_batch_t *batch;
+  int i;
+
+  SVN_ERR(finish_batch(frb));
+  if (frb->pending->nelts == 0)
+    return SVN_NO_ERROR;
+
+  batch = apr_pcalloc(frb->mainpool, sizeof(*batch));
+  batch->frb = frb;
+  batch->pending = frb->pending;
+  batch->pool = svn_pool_create(NULL);
+  frb->pending = apr_array_make(frb->mainpool, batch->pending->nelts,
+                                sizeof(pending_blame_t *));
+
+  /* The workers may only allocate from pools of their own. */
+  for (i = 0; i < batch->pending->nelts; i++)
+    APR_ARRAY_IDX(batch->pending, i, pending_blame_t *)->diff_pool
+      = svn_pool_create(batch->pool);
+
+  frb->batch = batch;
+
+#if APR_HAS_THREADS
+  {
+    apr_status_t status = apr_thread_create(&batch->thread, NULL,
+                                            diff_batch_thread, batch,
+                                            batch->pool);
+
+    if (!status)
+      return SVN_NO_ERROR;
+
+    batch->thread = NULL;
+  }
+#endif
+
+  /* Without a thread to spare, compare them right away. */
+  diff_batch(batch);
+
   return SVN_NO_ERROR;
 }
 
@@ -334,6 +568,29 @@ update_blame(void *baton)
   if (dbaton->source_stream)
     SVN_ERR(svn_stream_close(dbaton->source_stream));
 
+  /* Defer the comparison if it can run concurrently with others. */
+  if (frb->pending)
+    {
+      pending_blame_t *pb = apr_palloc(frb->mainpool, sizeof(*pb));
+
+      pb->last_file = frb->last_filename;
+      pb->cur_file = dbaton->filename;
+      pb->rev = dbaton->rev;
+      pb->file_pool = dbaton->file_pool;
+      pb->diff = NULL;
+      pb->diff_pool = NULL;
+      APR_ARRAY_PUSH(frb->pending, pending_blame_t *) = pb;
+
+      frb->last_filename = dbaton->filename;
+
+      /* Every pending revision keeps its file around, so limit the batch
+         to what is needed to keep all threads busy. */
+      if (frb->pending->nelts >= 8 * frb->threads)
+        SVN_ERR(start_batch(frb));
+
+      return SVN_NO_ERROR;
+    }
+
   /* If we are including merged revisions, we need to add each rev to the
      merged chain. */
   if (frb->include_merged_revisions)
@@ -505,6 +762,9 @@ file_rev_handler(void *baton, const char *path, svn_revnum_t revnum,
 
   if (frb->include_merged_revisions && !merged_revision)
     filepool = frb->filepool;
+  else if (frb->pending)
+    /* The file must survive until its revision has been blamed. */
+    filepool = delta_baton->file_pool = svn_pool_create(frb->mainpool);
   else
     filepool = frb->currpool;
 
@@ -655,6 +915,108 @@ normalize_blames(struct blame_chain *chain,
     }
 }
 
+/* Baton for server_blame_receiver(). */
+struct server_blame_baton
+{
+  /* The revision that last changed each line, in line order. */
+  apr_array_header_t *revisions;
+};
+
+/* Implements svn_ra_blame_receiver_t. */
+static svn_error_t *
+server_blame_receiver(void *baton,
+                      apr_int64_t line_no,
+                      svn_revnum_t revision,
+                      apr_pool_t *pool)
+{
+  struct server_blame_baton *sbb = baton;
+
+  APR_ARRAY_PUSH(sbb->revisions, svn_revnum_t) = revision;
+  return SVN_NO_ERROR;
+}
+
+/* Blame the file that RA_SESSION points to between START_REVNUM and
+ * END_REVNUM, letting the server calculate which revision changed each
+ * line.  Report every line to RECEIVER with RECEIVER_BATON.  This reports
+ * the same information as the file_rev_handler() based code path without
+ * merged revisions, but the file contents get transferred only once.
+ *
+ * Use POOL for all allocations.
+ */
+static svn_error_t *
+blame_on_server(svn_ra_session_t *ra_session,
+                svn_revnum_t start_revnum,
+                svn_revnum_t end_revnum,
+                svn_client_blame_receiver4_t receiver,
+                void *receiver_baton,
+                svn_client_ctx_t *ctx,
+                apr_pool_t *pool)
+{
+  struct server_blame_baton sbb;
+  apr_hash_t *rev_props_cache = apr_hash_make(pool);
+  svn_stringbuf_t *contents = svn_stringbuf_create_empty(pool);
+  svn_stream_t *stream;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  sbb.revisions = apr_array_make(pool, 0, sizeof(svn_revnum_t));
+  SVN_ERR(svn_ra_get_blame(ra_session, "", start_revnum, end_revnum,
+                           server_blame_receiver, &sbb, pool));
+
+  SVN_ERR(svn_ra_get_file(ra_session, "", end_revnum,
+                          svn_stream_from_stringbuf(contents, pool),
+                          NULL, NULL, pool));
+  stream = svn_subst_stream_translated(svn_stream_from_stringbuf(contents,
+                                                                 pool),
+                                       "\n", TRUE, NULL, FALSE, pool);
+
+  for (i = 0; i < sbb.revisions->nelts; i++)
+    {
+      svn_revnum_t revision = APR_ARRAY_IDX(sbb.revisions, i, svn_revnum_t);
+      apr_hash_t *rev_props = NULL;
+      svn_boolean_t eof;
+      svn_stringbuf_t *sb;
+
+      svn_pool_clear(iterpool);
+      if (ctx->cancel_func)
+        SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
+
+      /* Many lines usually share the same few revisions. */
+      if (SVN_IS_VALID_REVNUM(revision))
+        {
+          rev_props = apr_hash_get(rev_props_cache, &revision,
+                                   sizeof(revision));
+          if (!rev_props)
+            {
+              svn_revnum_t *key = apr_pmemdup(pool, &revision,
+                                              sizeof(revision));
+
+              SVN_ERR(svn_ra_rev_proplist(ra_session, revision, &rev_props,
+                                          pool));
+              apr_hash_set(rev_props_cache, key, sizeof(*key), rev_props);
+            }
+        }
+
+      SVN_ERR(svn_stream_readline(stream, &sb, "\n", &eof, iterpool));
+      if (!eof || sb->len)
+        {
+          svn_string_t line;
+          line.data = sb->data;
+          line.len = sb->len;
+          SVN_ERR(receiver(receiver_baton, i, revision, rev_props,
+                           SVN_INVALID_REVNUM, NULL, NULL,
+                           &line, FALSE, iterpool));
+        }
+      if (eof)
+        break;
+    }
+
+  SVN_ERR(svn_stream_close(stream));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_client_blame6(svn_revnum_t *start_revnum_p,
                   svn_revnum_t *end_revnum_p,
@@ -678,6 +1040,7 @@ svn_client_blame6(svn_revnum_t *start_revnum_p,
   svn_stream_t *last_stream;
   svn_stream_t *stream;
   const char *target_abspath_or_url;
+  svn_error_t *err;
 
   if (start->kind == svn_opt_revision_unspecified
       || end->kind == svn_opt_revision_unspecified)
@@ -772,6 +1135,28 @@ svn_client_blame6(svn_revnum_t *start_revnum_p,
         }
     }
 
+  /* Without merge tracking and with the default diff options, a server
+     that can do the blame itself saves us from fetching every revision of
+     the file. */
+  if (!include_merged_revisions
+      && start_revnum <= end_revnum
+      && end->kind != svn_opt_revision_working
+      && (!diff_options
+          || (diff_options->ignore_space == svn_diff_file_ignore_space_none
+              && !diff_options->ignore_eol_style
+              && !diff_options->show_c_function)))
+    {
+      svn_boolean_t server_blame;
+
+      SVN_ERR(svn_ra_has_capability(ra_session, &server_blame,
+                                    SVN_RA_CAPABILITY_SERVER_BLAME, pool));
+      if (server_blame)
+        return svn_error_trace(blame_on_server(ra_session,
+                                               start_revnum, end_revnum,
+                                               receiver, receiver_baton,
+                                               ctx, pool));
+    }
+
   frb.start_rev = start_revnum;
   frb.end_rev = end_revnum;
   frb.target = target;
@@ -811,16 +1196,52 @@ svn_client_blame6(svn_revnum_t *start_revnum_p,
       frb.prevfilepool = svn_pool_create(pool);
     }
 
+  /* Merged revisions are blamed against two chains, which requires them
+     to be processed one at a time. */
+  frb.threads = 1;
+  frb.pending = NULL;
+  frb.batch = NULL;
+  frb.last_file_pool = NULL;
+  if (!include_merged_revisions)
+    {
+      svn_config_t *cfg = ctx->config
+                           ? svn_hash_gets(ctx->config,
+                                           SVN_CONFIG_CATEGORY_CONFIG)
+                           : NULL;
+      apr_int64_t blame_threads;
+
+      SVN_ERR(svn_config_get_int64(cfg, &blame_threads,
+                                   SVN_CONFIG_SECTION_MISCELLANY,
+                                   SVN_CONFIG_OPTION_BLAME_THREADS, 1));
+      if (blame_threads > 1)
+        {
+          frb.threads = (int)MIN(blame_threads, 64);
+          frb.pending = apr_array_make(pool, 8 * frb.threads,
+                                       sizeof(pending_blame_t *));
+        }
+    }
+
   /* Collect all blame information.
      We need to ensure that we get one revision before the start_rev,
      if available so that we can know what was actually changed in the start
      revision. */
-  SVN_ERR(svn_ra_get_file_revs2(ra_session, "",
-                                frb.backwards ? start_revnum
-                                              : MAX(0, start_revnum-1),
-                                end_revnum,
-                                include_merged_revisions,
-                                file_rev_handler, &frb, pool));
+  err = svn_ra_get_file_revs2(ra_session, "",
+                              frb.backwards ? start_revnum
+                                            : MAX(0, start_revnum-1),
+                              end_revnum,
+                              include_merged_revisions,
+                              file_rev_handler, &frb, pool);
+  if (err)
+    {
+      abandon_batch(&frb);
+      return svn_error_trace(err);
+    }
+
+  if (frb.pending)
+    {
+      SVN_ERR(start_batch(&frb));
+      SVN_ERR(finish_batch(&frb));
+    }
 
   if (end->kind == svn_opt_revision_working)
     {
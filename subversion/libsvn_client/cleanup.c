@@ -37,8 +37,10 @@
 #include "svn_pools.h"
 #include "client.h"
 #include "svn_props.h"
+#include "svn_sorts.h"
 
 #include "svn_private_config.h"
+#include "private/svn_task.h"
 #include "private/svn_wc_private.h"
 
 
@@ -54,6 +56,10 @@ struct cleanup_status_walk_baton
   svn_boolean_t remove_ignored_items;
   svn_boolean_t include_externals;
   svn_client_ctx_t *ctx;
+
+  /* The unversioned and ignored items found by the walk, to be removed
+     once it is done.  const char *local_abspath */
+  apr_array_header_t *removals;
 };
 
 /* Forward declararion. */
@@ -63,6 +69,130 @@ cleanup_status_walk(void *baton,
                     const svn_wc_status3_t *status,
                     apr_pool_t *scratch_pool);
 
+/* Set *THREAD_COUNT to the number of threads that may be used to remove
+   unversioned and ignored items, as configured in CTX. */
+static svn_error_t *
+get_cleanup_threads(int *thread_count,
+                    svn_client_ctx_t *ctx)
+{
+  svn_config_t *cfg = ctx->config
+                       ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+                       : NULL;
+  apr_int64_t cleanup_threads;
+
+  SVN_ERR(svn_config_get_int64(cfg, &cleanup_threads,
+                               SVN_CONFIG_SECTION_WORKING_COPY,
+                               SVN_CONFIG_OPTION_CLEANUP_THREADS, 1));
+  *thread_count = (int)MAX(1, MIN(cleanup_threads, 64));
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove the item at index INDEX of the removals of the
+   cleanup_status_walk_baton PROCESS_BATON and set *RESULT to its
+   svn_node_kind_t, or to NULL if it was already gone.
+   Implements svn_task__process_func_t. */
+static svn_error_t *
+remove_item(void **result,
+            int index,
+            void *process_baton,
+            void *thread_context,
+            svn_cancel_func_t cancel_func,
+            void *cancel_baton,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  struct cleanup_status_walk_baton *b = process_baton;
+  const char *local_abspath = APR_ARRAY_IDX(b->removals, index,
+                                            const char *);
+  svn_node_kind_t kind_on_disk;
+
+  *result = NULL;
+  SVN_ERR(svn_io_check_path(local_abspath, &kind_on_disk, scratch_pool));
+  switch (kind_on_disk)
+    {
+      case svn_node_file:
+      case svn_node_symlink:
+        SVN_ERR(svn_io_remove_file2(local_abspath, FALSE, scratch_pool));
+        break;
+      case svn_node_dir:
+        SVN_ERR(svn_io_remove_dir2(local_abspath, FALSE,
+                                   cancel_func, cancel_baton,
+                                   scratch_pool));
+        break;
+      case svn_node_none:
+      default:
+        return SVN_NO_ERROR;
+    }
+
+  *result = apr_pmemdup(result_pool, &kind_on_disk, sizeof(kind_on_disk));
+  return SVN_NO_ERROR;
+}
+
+/* Notify the removal of the item at index INDEX of the removals of the
+   cleanup_status_walk_baton OUTPUT_BATON, whose kind is in RESULT.
+   Implements svn_task__output_func_t. */
+static svn_error_t *
+notify_removal(void *result,
+               int index,
+               void *output_baton,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *scratch_pool)
+{
+  struct cleanup_status_walk_baton *b = output_baton;
+  const svn_node_kind_t *kind_on_disk = result;
+  svn_wc_notify_t *notify;
+
+  if (kind_on_disk && b->ctx->notify_func2)
+    {
+      notify = svn_wc_create_notify(APR_ARRAY_IDX(b->removals, index,
+                                                  const char *),
+                                    svn_wc_notify_delete, scratch_pool);
+      notify->kind = *kind_on_disk;
+      b->ctx->notify_func2(b->ctx->notify_baton2, notify, scratch_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Walk LOCAL_ABSPATH with cleanup_status_walk() and baton B, ignoring
+   the patterns in IGNORES, and then remove the unversioned and ignored
+   items it found, concurrently if so configured.  The removals are
+   notified in the order of the walk. */
+static svn_error_t *
+walk_and_remove(struct cleanup_status_walk_baton *b,
+                const char *local_abspath,
+                const apr_array_header_t *ignores,
+                apr_pool_t *scratch_pool)
+{
+  svn_client_ctx_t *ctx = b->ctx;
+  int thread_count;
+
+  SVN_ERR(svn_wc_walk_status(ctx->wc_ctx, local_abspath,
+                             svn_depth_infinity,
+                             TRUE,  /* get all */
+                             b->remove_ignored_items,
+                             TRUE,  /* ignore textmods */
+                             ignores,
+                             cleanup_status_walk, b,
+                             ctx->cancel_func,
+                             ctx->cancel_baton,
+                             scratch_pool));
+
+  if (b->removals->nelts == 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_cleanup_threads(&thread_count, ctx));
+
+  return svn_error_trace(svn_task__run(thread_count, b->removals->nelts,
+                                       remove_item, b,
+                                       notify_removal, b,
+                                       NULL, NULL,
+                                       ctx->cancel_func, ctx->cancel_baton,
+                                       scratch_pool));
+}
+
 static svn_error_t *
 do_cleanup(const char *local_abspath,
            svn_boolean_t break_locks,
@@ -101,20 +231,12 @@ do_cleanup(const char *local_abspath,
       b.remove_ignored_items = remove_ignored_items;
       b.include_externals = include_externals;
       b.ctx = ctx;
+      b.removals = apr_array_make(scratch_pool, 0, sizeof(const char *));
 
       SVN_ERR(svn_wc_get_default_ignores(&ignores, ctx->config, scratch_pool));
 
       SVN_WC__CALL_WITH_WRITE_LOCK(
-              svn_wc_walk_status(ctx->wc_ctx, local_abspath,
-                                 svn_depth_infinity,
-                                 TRUE,  /* get all */
-                                 remove_ignored_items,
-                                 TRUE,  /* ignore textmods */
-                                 ignores,
-                                 cleanup_status_walk, &b,
-                                 ctx->cancel_func,
-                                 ctx->cancel_baton,
-                                 scratch_pool),
+              walk_and_remove(&b, local_abspath, ignores, scratch_pool),
               ctx->wc_ctx,
               local_abspath,
               FALSE /* lock_anchor */,
@@ -186,30 +308,17 @@ cleanup_status_walk(void *baton,
   else
     return SVN_NO_ERROR;
 
-  SVN_ERR(svn_io_check_path(local_abspath, &kind_on_disk, scratch_pool));
-  switch (kind_on_disk)
-    {
-      case svn_node_file:
-      case svn_node_symlink:
-        SVN_ERR(svn_io_remove_file2(local_abspath, FALSE, scratch_pool));
-        break;
-      case svn_node_dir:
-        SVN_ERR(svn_io_remove_dir2(local_abspath, FALSE,
-                                   b->ctx->cancel_func, b->ctx->cancel_baton,
-                                   scratch_pool));
-        break;
-      case svn_node_none:
-      default:
-        return SVN_NO_ERROR;
-    }
+  /* Items within one that is removed anyway need no removal of their
+     own; the walk reports them right after it. */
+  if (b->removals->nelts > 0
+      && svn_dirent_is_ancestor(APR_ARRAY_IDX(b->removals,
+                                              b->removals->nelts - 1,
+                                              const char *),
+                                local_abspath))
+    return SVN_NO_ERROR;
 
-  if (b->ctx->notify_func2)
-    {
-      notify = svn_wc_create_notify(local_abspath, svn_wc_notify_delete,
-                                    scratch_pool);
-      notify->kind = kind_on_disk;
-      b->ctx->notify_func2(b->ctx->notify_baton2, notify, scratch_pool);
-    }
+  APR_ARRAY_PUSH(b->removals, const char *)
+    = apr_pstrdup(b->removals->pool, local_abspath);
 
   return SVN_NO_ERROR;
 }
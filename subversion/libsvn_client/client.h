@@ -63,6 +63,20 @@ typedef struct svn_client__private_ctx_t
   /* Total number of bytes transferred over network across all RA sessions. */
   apr_off_t total_progress;
 
+  /* Mergeinfo fetched from repositories by
+     svn_client__get_repos_mergeinfo_catalog(), which doesn't change for a
+     given revision, and the pool it is allocated in.  The keys identify
+     what was asked for; the values are mergeinfo_cache_entry_t *. */
+  apr_hash_t *mergeinfo_cache;
+  apr_pool_t *mergeinfo_cache_pool;
+
+  /* Log entries and move ancestry checks that tree conflict resolution in
+     conflicts.c fetched from repositories for given revisions, and the
+     pool they are allocated in.  They are shared by all conflicts
+     described with this context. */
+  apr_hash_t *conflicts_cache;
+  apr_pool_t *conflicts_cache_pool;
+
   /* The public context. */
   svn_client_ctx_t public_ctx;
 } svn_client__private_ctx_t;
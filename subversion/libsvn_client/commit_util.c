@@ -38,6 +38,7 @@
 #include "svn_props.h"
 #include "svn_iter.h"
 #include "svn_hash.h"
+#include "svn_config.h"
 
 #include <assert.h>
 
@@ -45,6 +46,7 @@
 #include "private/svn_wc_private.h"
 #include "private/svn_client_private.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_task.h"
 
 /*** Uncomment this to turn on commit driver debugging. ***/
 /*
@@ -363,6 +365,8 @@ bail_on_tree_conflicted_ancestor(svn_wc_context_t *wc_ctx,
    to a const char * absolute path of a child. See the comment about
    danglers at the top of svn_client__harvest_committables().
 
+   Compare the texts of modified files with up to THREAD_COUNT threads.
+
    If CANCEL_FUNC is non-null, call it with CANCEL_BATON to see
    if the user has cancelled the operation.
 
@@ -397,6 +401,25 @@ harvest_status_callback(void *status_baton,
                         const svn_wc_status3_t *status,
                         apr_pool_t *scratch_pool);
 
+/* Set *THREAD_COUNT to the number of threads that may be used to read
+   the files of a commit, as configured in CTX. */
+static svn_error_t *
+get_commit_threads(int *thread_count,
+                   svn_client_ctx_t *ctx)
+{
+  svn_config_t *cfg = ctx->config
+                       ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+                       : NULL;
+  apr_int64_t commit_threads;
+
+  SVN_ERR(svn_config_get_int64(cfg, &commit_threads,
+                               SVN_CONFIG_SECTION_MISCELLANY,
+                               SVN_CONFIG_OPTION_COMMIT_THREADS, 1));
+  *thread_count = (int)MAX(1, MIN(commit_threads, 64));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 harvest_committables(const char *local_abspath,
                      svn_client__committables_t *committables,
@@ -408,6 +431,7 @@ harvest_committables(const char *local_abspath,
                      apr_hash_t *danglers,
                      svn_client__check_url_kind_t check_url_func,
                      void *check_url_baton,
+                     int thread_count,
                      svn_cancel_func_t cancel_func,
                      void *cancel_baton,
                      svn_wc_notify_func2_t notify_func,
@@ -437,17 +461,18 @@ harvest_committables(const char *local_abspath,
 
   baton.skip_below_abspath = NULL;
 
-  SVN_ERR(svn_wc_walk_status(wc_ctx,
-                             local_abspath,
-                             depth,
-                             (copy_mode_relpath != NULL) /* get_all */,
-                             FALSE /* no_ignore */,
-                             FALSE /* ignore_text_mods */,
-                             NULL /* ignore_patterns */,
-                             harvest_status_callback,
-                             &baton,
-                             cancel_func, cancel_baton,
-                             scratch_pool));
+  SVN_ERR(svn_wc__walk_status_threaded(wc_ctx,
+                                       local_abspath,
+                                       depth,
+                                       (copy_mode_relpath != NULL),
+                                       FALSE /* no_ignore */,
+                                       FALSE /* ignore_text_mods */,
+                                       NULL /* ignore_patterns */,
+                                       thread_count,
+                                       harvest_status_callback,
+                                       &baton,
+                                       cancel_func, cancel_baton,
+                                       scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -1169,6 +1194,7 @@ svn_client__harvest_committables(svn_client__committables_t **committables,
   apr_hash_t *changelist_hash = NULL;
   struct handle_descendants_baton hdb;
   apr_hash_index_t *hi;
+  int commit_threads;
 
   /* It's possible that one of the named targets has a parent that is
    * itself scheduled for addition or replacement -- that is, the
@@ -1202,6 +1228,8 @@ svn_client__harvest_committables(svn_client__committables_t **committables,
   /* And the LOCK_TOKENS dito. */
   *lock_tokens = apr_hash_make(result_pool);
 
+  SVN_ERR(get_commit_threads(&commit_threads, ctx));
+
   /* If we have a list of changelists, convert that into a hash with
      changelist keys. */
   if (changelists && changelists->nelts)
@@ -1237,6 +1265,7 @@ svn_client__harvest_committables(svn_client__committables_t **committables,
                                    depth, just_locked, changelist_hash,
                                    danglers,
                                    check_url_func, check_url_baton,
+                                   commit_threads,
                                    ctx->cancel_func, ctx->cancel_baton,
                                    ctx->notify_func2, ctx->notify_baton2,
                                    ctx->wc_ctx, result_pool, iterpool));
@@ -1298,6 +1327,7 @@ struct copy_committables_baton
   apr_pool_t *result_pool;
   svn_client__check_url_kind_t check_url_func;
   void *check_url_baton;
+  int commit_threads;
 };
 
 static svn_error_t *
@@ -1330,6 +1360,7 @@ harvest_copy_committables(void *baton, void *item, apr_pool_t *pool)
                                NULL,
                                btn->check_url_func,
                                btn->check_url_baton,
+                               btn->commit_threads,
                                btn->ctx->cancel_func,
                                btn->ctx->cancel_baton,
                                btn->ctx->notify_func2,
@@ -1372,6 +1403,8 @@ svn_client__get_copy_committables(svn_client__committables_t **committables,
   btn.check_url_func = check_url_func;
   btn.check_url_baton = check_url_baton;
 
+  SVN_ERR(get_commit_threads(&btn.commit_threads, ctx));
+
   /* For each copy pair, harvest the committables for that pair into the
      committables hash. */
   return svn_iter_apr_array(NULL, copy_pairs,
@@ -1856,6 +1889,214 @@ fixup_error:
                                             err, ctx, pool));
 }
 
+/* Notify CTX that the text of ITEM is about to be sent. */
+static void
+notify_text_delta(const svn_client_commit_item3_t *item,
+                  const char *notify_path_prefix,
+                  svn_client_ctx_t *ctx,
+                  apr_pool_t *scratch_pool)
+{
+  if (ctx->notify_func2)
+    {
+      svn_wc_notify_t *notify;
+      notify = svn_wc_create_notify(item->path,
+                                    svn_wc_notify_commit_postfix_txdelta,
+                                    scratch_pool);
+      notify->kind = svn_node_file;
+      notify->path_prefix = notify_path_prefix;
+      ctx->notify_func2(ctx->notify_baton2, notify, scratch_pool);
+    }
+}
+
+/* Return TRUE if the full text of ITEM must be sent. */
+static svn_boolean_t
+needs_fulltext(const svn_client_commit_item3_t *item)
+{
+  /* If the node has no history, transmit full text */
+  return (item->state_flags & SVN_CLIENT_COMMIT_ITEM_ADD)
+         && ! (item->state_flags & SVN_CLIENT_COMMIT_ITEM_IS_COPY);
+}
+
+/* The amount of delta target text to compute ahead of time per file.
+   Larger files get the remainder of their delta computed while being
+   sent. */
+#define TEXT_DELTA_PREFETCH_SIZE (1024 * 1024)
+
+/* A file text whose delta gets computed ahead of its transmission. */
+typedef struct pending_text_delta_t
+{
+  struct file_mod_t *mod;
+
+  /* The delta, allocated in POOL.  NULL if it could not be started. */
+  svn_wc__text_delta_t *delta;
+
+  /* The error from starting or computing DELTA. */
+  svn_error_t *err;
+
+  apr_pool_t *pool;
+} pending_text_delta_t;
+
+/* Everything needed to send the pending text deltas. */
+typedef struct text_delta_baton_t
+{
+  const char *base_url;
+  const svn_delta_editor_t *editor;
+  const char *notify_path_prefix;
+  apr_hash_t *sha1_checksums;
+  svn_client_ctx_t *ctx;
+  apr_pool_t *result_pool;
+} text_delta_baton_t;
+
+/* Implements svn_task__process_func_t, computing the first windows of
+   the pending_text_delta_t * at INDEX in the array PROCESS_BATON. */
+static svn_error_t *
+compute_text_delta(void **result,
+                   int index,
+                   void *process_baton,
+                   void *thread_context,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *pending = process_baton;
+  pending_text_delta_t *ptd = APR_ARRAY_IDX(pending, index,
+                                            pending_text_delta_t *);
+
+  /* Errors are reported for the file that caused them, in order. */
+  if (ptd->delta)
+    ptd->err = svn_wc__text_delta_run(ptd->delta, TEXT_DELTA_PREFETCH_SIZE,
+                                      cancel_func, cancel_baton,
+                                      scratch_pool);
+  *result = ptd;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t, sending the pending_text_delta_t
+   RESULT as described by the text_delta_baton_t OUTPUT_BATON. */
+static svn_error_t *
+send_text_delta(void *result,
+                int index,
+                void *output_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *scratch_pool)
+{
+  pending_text_delta_t *ptd = result;
+  text_delta_baton_t *tdb = output_baton;
+  const svn_client_commit_item3_t *item = ptd->mod->item;
+  const svn_checksum_t *new_text_base_sha1_checksum;
+  svn_error_t *err = ptd->err;
+
+  ptd->err = SVN_NO_ERROR;
+
+  notify_text_delta(item, tdb->notify_path_prefix, tdb->ctx, scratch_pool);
+
+  if (!err)
+    err = svn_wc__text_delta_finish(NULL, &new_text_base_sha1_checksum,
+                                    ptd->delta, tdb->editor,
+                                    ptd->mod->file_baton,
+                                    tdb->result_pool, scratch_pool);
+  if (err)
+    return svn_error_trace(fixup_commit_error(item->path, tdb->base_url,
+                                              item->session_relpath,
+                                              svn_node_file, err, tdb->ctx,
+                                              scratch_pool));
+
+  if (tdb->sha1_checksums)
+    svn_hash_sets(tdb->sha1_checksums, item->path,
+                  new_text_base_sha1_checksum);
+
+  svn_pool_destroy(ptd->mod->file_pool);
+  return SVN_NO_ERROR;
+}
+
+/* Send the texts of all struct file_mod_t * in FILE_MODS to EDITOR while
+   up to THREAD_COUNT threads compute the deltas of the following files.
+   Files are sent in the same order as they would be sequentially.  Store
+   the new SHA1 checksums in SHA1_CHECKSUMS, if not NULL, allocated in
+   RESULT_POOL.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+transmit_text_deltas_concurrently(apr_hash_t *file_mods,
+                                  int thread_count,
+                                  const char *base_url,
+                                  const svn_delta_editor_t *editor,
+                                  const char *notify_path_prefix,
+                                  apr_hash_t *sha1_checksums,
+                                  svn_client_ctx_t *ctx,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *mods = apr_array_make(scratch_pool,
+                                            apr_hash_count(file_mods),
+                                            sizeof(struct file_mod_t *));
+  apr_array_header_t *pending
+    = apr_array_make(scratch_pool, 8 * thread_count,
+                     sizeof(pending_text_delta_t *));
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_hash_index_t *hi;
+  text_delta_baton_t tdb;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i, j;
+
+  tdb.base_url = base_url;
+  tdb.editor = editor;
+  tdb.notify_path_prefix = notify_path_prefix;
+  tdb.sha1_checksums = sha1_checksums;
+  tdb.ctx = ctx;
+  tdb.result_pool = result_pool;
+
+  for (hi = apr_hash_first(scratch_pool, file_mods);
+       hi;
+       hi = apr_hash_next(hi))
+    APR_ARRAY_PUSH(mods, struct file_mod_t *) = apr_hash_this_val(hi);
+
+  /* Each batch keeps its files open until they have been sent, so limit
+     the batch size to what is needed to keep all threads busy. */
+  for (i = 0; i < mods->nelts && !err; i += 8 * thread_count)
+    {
+      svn_pool_clear(iterpool);
+
+      for (j = i; j < mods->nelts && j < i + 8 * thread_count; j++)
+        {
+          /* The worker threads allocate windows in this pool, so it must
+             not share its allocator with the pools of this thread. */
+          apr_pool_t *pool = svn_pool_create(NULL);
+          pending_text_delta_t *ptd = apr_pcalloc(pool, sizeof(*ptd));
+
+          ptd->mod = APR_ARRAY_IDX(mods, j, struct file_mod_t *);
+          ptd->pool = pool;
+          ptd->err = svn_wc__text_delta_begin(&ptd->delta, ctx->wc_ctx,
+                                              ptd->mod->item->path,
+                                              needs_fulltext(ptd->mod->item),
+                                              pool, iterpool);
+          APR_ARRAY_PUSH(pending, pending_text_delta_t *) = ptd;
+        }
+
+      err = svn_task__run(thread_count, pending->nelts,
+                          compute_text_delta, pending,
+                          send_text_delta, &tdb,
+                          NULL, NULL,
+                          ctx->cancel_func, ctx->cancel_baton,
+                          iterpool);
+
+      /* Release all deltas, including those that have been skipped after
+         an error. */
+      for (j = 0; j < pending->nelts; j++)
+        {
+          pending_text_delta_t *ptd = APR_ARRAY_IDX(pending, j,
+                                                    pending_text_delta_t *);
+          svn_error_clear(ptd->err);
+          svn_pool_destroy(ptd->pool);
+        }
+      apr_array_clear(pending);
+    }
+
+  svn_pool_destroy(iterpool);
+  return svn_error_trace(err);
+}
+
 svn_error_t *
 svn_client__do_commit(const char *base_url,
                       const apr_array_header_t *commit_items,
@@ -1875,6 +2116,7 @@ svn_client__do_commit(const char *base_url,
   struct item_commit_baton cb_baton;
   apr_array_header_t *paths =
     apr_array_make(scratch_pool, commit_items->nelts, sizeof(const char *));
+  int commit_threads;
 
   /* Ditto for the checksums. */
   if (sha1_checksums)
@@ -1899,11 +2141,26 @@ svn_client__do_commit(const char *base_url,
   cb_baton.commit_items = items_hash;
   cb_baton.base_url = base_url;
 
+  SVN_ERR(get_commit_threads(&commit_threads, ctx));
+
   /* Drive the commit editor! */
   SVN_ERR(svn_delta_path_driver3(editor, edit_baton, paths, TRUE,
                                  do_item_commit, &cb_baton, scratch_pool));
 
   /* Transmit outstanding text deltas. */
+  if (commit_threads > 1)
+    {
+      SVN_ERR(transmit_text_deltas_concurrently(file_mods, commit_threads,
+                                                base_url, editor,
+                                                notify_path_prefix,
+                                                sha1_checksums
+                                                  ? *sha1_checksums
+                                                  : NULL,
+                                                ctx, result_pool,
+                                                scratch_pool));
+      apr_hash_clear(file_mods);
+    }
+
   for (hi = apr_hash_first(scratch_pool, file_mods);
        hi;
        hi = apr_hash_next(hi))
@@ -1912,7 +2169,6 @@ svn_client__do_commit(const char *base_url,
       const svn_client_commit_item3_t *item = mod->item;
       const svn_checksum_t *new_text_base_md5_checksum;
       const svn_checksum_t *new_text_base_sha1_checksum;
-      svn_boolean_t fulltext = FALSE;
       svn_error_t *err;
 
       svn_pool_clear(iterpool);
@@ -1921,26 +2177,13 @@ svn_client__do_commit(const char *base_url,
       if (ctx->cancel_func)
         SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
 
-      if (ctx->notify_func2)
-        {
-          svn_wc_notify_t *notify;
-          notify = svn_wc_create_notify(item->path,
-                                        svn_wc_notify_commit_postfix_txdelta,
-                                        iterpool);
-          notify->kind = svn_node_file;
-          notify->path_prefix = notify_path_prefix;
-          ctx->notify_func2(ctx->notify_baton2, notify, iterpool);
-        }
-
-      /* If the node has no history, transmit full text */
-      if ((item->state_flags & SVN_CLIENT_COMMIT_ITEM_ADD)
-          && ! (item->state_flags & SVN_CLIENT_COMMIT_ITEM_IS_COPY))
-        fulltext = TRUE;
+      notify_text_delta(item, notify_path_prefix, ctx, iterpool);
 
       err = svn_wc_transmit_text_deltas3(&new_text_base_md5_checksum,
                                          &new_text_base_sha1_checksum,
                                          ctx->wc_ctx, item->path,
-                                         fulltext, editor, mod->file_baton,
+                                         needs_fulltext(item), editor,
+                                         mod->file_baton,
                                          result_pool, iterpool);
 
       if (err)
@@ -365,6 +365,69 @@ check_move_ancestry(svn_boolean_t *related,
   return SVN_NO_ERROR;
 }
 
+/* The most entries the conflicts cache of a client context holds before
+   it starts over. */
+#define CONFLICTS_CACHE_SIZE 1000
+
+/* Make room for one more entry in the conflicts cache of PRIVATE_CTX and
+   return the pool to allocate it in. */
+static apr_pool_t *
+make_room_in_conflicts_cache(svn_client__private_ctx_t *private_ctx)
+{
+  if (apr_hash_count(private_ctx->conflicts_cache) >= CONFLICTS_CACHE_SIZE)
+    {
+      svn_pool_clear(private_ctx->conflicts_cache_pool);
+      private_ctx->conflicts_cache =
+        apr_hash_make(private_ctx->conflicts_cache_pool);
+    }
+
+  return private_ctx->conflicts_cache_pool;
+}
+
+/* Like check_move_ancestry(), but remember the answer in the conflicts
+ * cache of CTX.  The history of a revision never changes, and the same
+ * deletions and copies are looked at again for every conflict whose
+ * details are searched for in the same revisions. */
+static svn_error_t *
+check_move_ancestry_cached(svn_boolean_t *related,
+                           svn_ra_session_t *ra_session,
+                           const char *repos_root_url,
+                           const char *deleted_repos_relpath,
+                           svn_revnum_t deleted_rev,
+                           const char *copyfrom_path,
+                           svn_revnum_t copyfrom_rev,
+                           svn_boolean_t check_last_changed_rev,
+                           svn_client_ctx_t *ctx,
+                           apr_pool_t *scratch_pool)
+{
+  svn_client__private_ctx_t *private_ctx = svn_client__get_private_ctx(ctx);
+  const char *cache_key;
+  const char *cached;
+  apr_pool_t *cache_pool;
+
+  cache_key = apr_psprintf(scratch_pool, "ancestry:%ld:%ld:%d:%s\n%s\n%s",
+                           deleted_rev, copyfrom_rev,
+                           check_last_changed_rev ? 1 : 0, repos_root_url,
+                           deleted_repos_relpath, copyfrom_path);
+  cached = svn_hash_gets(private_ctx->conflicts_cache, cache_key);
+  if (cached)
+    {
+      *related = (cached[0] == 'y');
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(check_move_ancestry(related, ra_session, repos_root_url,
+                              deleted_repos_relpath, deleted_rev,
+                              copyfrom_path, copyfrom_rev,
+                              check_last_changed_rev, scratch_pool));
+
+  cache_pool = make_room_in_conflicts_cache(private_ctx);
+  svn_hash_sets(private_ctx->conflicts_cache,
+                apr_pstrdup(cache_pool, cache_key), *related ? "y" : "n");
+
+  return SVN_NO_ERROR;
+}
+
 struct copy_info {
   const char *copyto_path;
   const char *copyfrom_path;
@@ -652,13 +715,13 @@ match_copies_to_deletion(const char *deleted_repos_relpath,
 
               copy = APR_ARRAY_IDX(copies_with_same_source_path, i,
                                    struct copy_info *);
-              SVN_ERR(check_move_ancestry(&related,
-                                          ra_session, repos_root_url,
-                                          deleted_repos_relpath,
-                                          deleted_rev,
-                                          copy->copyfrom_path,
-                                          copy->copyfrom_rev,
-                                          TRUE, iterpool));
+              SVN_ERR(check_move_ancestry_cached(&related,
+                                                 ra_session, repos_root_url,
+                                                 deleted_repos_relpath,
+                                                 deleted_rev,
+                                                 copy->copyfrom_path,
+                                                 copy->copyfrom_rev,
+                                                 TRUE, ctx, iterpool));
               if (!related)
                 continue;
 
@@ -764,6 +827,10 @@ struct find_deleted_rev_baton
 
   /* Extra RA session that can be used to make additional requests. */
   svn_ra_session_t *extra_ra_session;
+
+  /* If not NULL, copies of all log entries received are appended to this
+   * array of svn_log_entry_t *, allocated in its pool. */
+  apr_array_header_t *log_entries;
 };
 
 /* If DELETED_RELPATH matches the moved-from path of a move in MOVES,
@@ -890,12 +957,13 @@ find_nested_moves(apr_array_header_t *moves,
 
           copy = APR_ARRAY_IDX(copies_with_same_source_path, j,
                                struct copy_info *);
-          SVN_ERR(check_move_ancestry(&related, ra_session, repos_root_url,
-                                      moved_along_repos_relpath,
-                                      revision,
-                                      copy->copyfrom_path,
-                                      copy->copyfrom_rev,
-                                      TRUE, iterpool));
+          SVN_ERR(check_move_ancestry_cached(&related, ra_session,
+                                             repos_root_url,
+                                             moved_along_repos_relpath,
+                                             revision,
+                                             copy->copyfrom_path,
+                                             copy->copyfrom_rev,
+                                             TRUE, ctx, iterpool));
           if (related)
             {
               struct repos_move_info *nested_move;
@@ -1631,6 +1699,10 @@ find_moves(void *baton, svn_log_entry_t *log_entry, apr_pool_t *scratch_pool)
   apr_hash_t *copies;
   apr_array_header_t *moves;
 
+  if (b->log_entries)
+    APR_ARRAY_PUSH(b->log_entries, svn_log_entry_t *) =
+      svn_log_entry_dup(log_entry, b->log_entries->pool);
+
   if (b->ctx->notify_func2)
     {
       svn_wc_notify_t *notify;
@@ -1700,9 +1772,32 @@ find_moves(void *baton, svn_log_entry_t *log_entry, apr_pool_t *scratch_pool)
   return SVN_NO_ERROR;
 }
 
+/* Return a copy of the array of svn_log_entry_t * LOG_ENTRIES, allocated
+ * in RESULT_POOL. */
+static apr_array_header_t *
+dup_log_entries(const apr_array_header_t *log_entries,
+                apr_pool_t *result_pool)
+{
+  apr_array_header_t *new_entries;
+  int i;
+
+  new_entries = apr_array_make(result_pool, log_entries->nelts,
+                               sizeof(svn_log_entry_t *));
+  for (i = 0; i < log_entries->nelts; i++)
+    APR_ARRAY_PUSH(new_entries, svn_log_entry_t *) =
+      svn_log_entry_dup(APR_ARRAY_IDX(log_entries, i, svn_log_entry_t *),
+                        result_pool);
+
+  return new_entries;
+}
+
 /* Find all moves which occurred in repository history starting at
  * REPOS_RELPATH@START_REV until END_REV (where START_REV > END_REV).
- * Return results in *MOVES_TABLE (see struct find_moves_baton for details). */
+ * Return results in *MOVES_TABLE (see struct find_moves_baton for details).
+ *
+ * The log of the revision range is remembered in the conflicts cache of
+ * CTX, so other conflicts searching the same range don't ask the
+ * repository for it again. */
 static svn_error_t *
 find_moves_in_revision_range(struct apr_hash_t **moves_table,
                              const char *repos_relpath,
@@ -1721,6 +1816,9 @@ find_moves_in_revision_range(struct apr_hash_t **moves_table,
   apr_array_header_t *paths;
   apr_array_header_t *revprops;
   struct find_moves_baton b = { 0 };
+  svn_client__private_ctx_t *private_ctx = svn_client__get_private_ctx(ctx);
+  const char *cache_key;
+  apr_array_header_t *cached;
 
   SVN_ERR_ASSERT(start_rev > end_rev);
 
@@ -1747,14 +1845,48 @@ find_moves_in_revision_range(struct apr_hash_t **moves_table,
   SVN_ERR(svn_ra__dup_session(&b.extra_ra_session, ra_session, NULL,
                               scratch_pool, scratch_pool));
 
-  SVN_ERR(svn_ra_get_log2(ra_session, paths, start_rev, end_rev,
-                          0, /* no limit */
-                          TRUE, /* need the changed paths list */
-                          FALSE, /* need to traverse copies */
-                          FALSE, /* no need for merged revisions */
-                          revprops,
-                          find_moves, &b,
-                          scratch_pool));
+  cache_key = apr_psprintf(scratch_pool, "log:%ld:%ld:%s\n%s",
+                           start_rev, end_rev, repos_uuid, repos_relpath);
+  cached = svn_hash_gets(private_ctx->conflicts_cache, cache_key);
+  if (cached)
+    {
+      apr_array_header_t *log_entries;
+      apr_pool_t *iterpool;
+      int i;
+
+      /* Looking for moves may make the cache start over, so work on
+       * a copy of what it holds. */
+      log_entries = dup_log_entries(cached, scratch_pool);
+      iterpool = svn_pool_create(scratch_pool);
+      for (i = 0; i < log_entries->nelts; i++)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(find_moves(&b, APR_ARRAY_IDX(log_entries, i,
+                                               svn_log_entry_t *),
+                             iterpool));
+        }
+      svn_pool_destroy(iterpool);
+    }
+  else
+    {
+      apr_pool_t *cache_pool;
+
+      b.log_entries = apr_array_make(scratch_pool, 0,
+                                     sizeof(svn_log_entry_t *));
+      SVN_ERR(svn_ra_get_log2(ra_session, paths, start_rev, end_rev,
+                              0, /* no limit */
+                              TRUE, /* need the changed paths list */
+                              FALSE, /* need to traverse copies */
+                              FALSE, /* no need for merged revisions */
+                              revprops,
+                              find_moves, &b,
+                              scratch_pool));
+
+      cache_pool = make_room_in_conflicts_cache(private_ctx);
+      svn_hash_sets(private_ctx->conflicts_cache,
+                    apr_pstrdup(cache_pool, cache_key),
+                    dup_log_entries(b.log_entries, cache_pool));
+    }
 
   *moves_table = b.moves_table;
 
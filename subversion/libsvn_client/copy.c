@@ -1503,7 +1503,8 @@ repos_to_repos_copy(const apr_array_header_t *copy_pairs,
       SVN_ERR(svn_client__get_repos_mergeinfo(
                 &mergeinfo, ra_session,
                 pair->src_abspath_or_url, pair->src_revnum,
-                svn_mergeinfo_inherited, TRUE /*squelch_incapable*/, pool));
+                svn_mergeinfo_inherited, TRUE /*squelch_incapable*/,
+                ctx, pool));
       if (mergeinfo)
         SVN_ERR(svn_mergeinfo_to_string(&info->mergeinfo, mergeinfo, pool));
 
@@ -2145,7 +2146,8 @@ wc_to_repos_copy(const apr_array_header_t *copy_pairs,
       if (src_origin)
         SVN_ERR(svn_client__get_repos_mergeinfo(
                   &mergeinfo, ra_session, src_origin->url, src_origin->rev,
-                  svn_mergeinfo_inherited, TRUE /*sqelch_inc.*/, iterpool));
+                  svn_mergeinfo_inherited, TRUE /*sqelch_inc.*/,
+                  ctx, iterpool));
       else
         mergeinfo = NULL;
       /* ... and WC mergeinfo. */
@@ -2808,7 +2810,7 @@ repos_to_wc_copy_single(svn_boolean_t *timestamp_sleep,
                                               pair->src_revnum,
                                               svn_mergeinfo_inherited,
                                               TRUE /*squelch_incapable*/,
-                                              pool));
+                                              ctx, pool));
       SVN_ERR(extend_wc_mergeinfo(dst_abspath, src_mergeinfo, ctx, pool));
 
       /* ### Maybe the notification should mention this mergeinfo change. */
@@ -32,6 +32,7 @@
 #include "svn_hash.h"
 #include "svn_client.h"
 #include "svn_error.h"
+#include "svn_pools.h"
 
 #include "private/svn_wc_private.h"
 
@@ -106,6 +107,12 @@ svn_client_create_context2(svn_client_ctx_t **ctx,
 
   private_ctx->magic_null = 0;
   private_ctx->magic_id = CLIENT_CTX_MAGIC;
+  private_ctx->mergeinfo_cache_pool = svn_pool_create(pool);
+  private_ctx->mergeinfo_cache
+    = apr_hash_make(private_ctx->mergeinfo_cache_pool);
+  private_ctx->conflicts_cache_pool = svn_pool_create(pool);
+  private_ctx->conflicts_cache
+    = apr_hash_make(private_ctx->conflicts_cache_pool);
 
   public_ctx->notify_func2 = call_notify_func;
   public_ctx->notify_baton2 = public_ctx;
@@ -40,11 +40,14 @@
 #include "svn_subst.h"
 #include "svn_time.h"
 #include "svn_props.h"
+#include "svn_config.h"
+#include "svn_sorts.h"
 #include "client.h"
 
 #include "svn_private_config.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_delta_private.h"
+#include "private/svn_task.h"
 #include "private/svn_wc_private.h"
 
 #ifndef ENABLE_EV2_IMPL
@@ -511,6 +514,18 @@ struct edit_baton
   void *cancel_baton;
   svn_wc_notify_func2_t notify_func;
   void *notify_baton;
+
+  /* Whether ROOT_PATH was created by this export, so that files can be
+     written to their final location directly. */
+  svn_boolean_t fresh;
+
+  /* Number of threads that may put files into place. */
+  int threads;
+
+  /* If THREADS is greater than 1, the pending_node_t * added since the
+     last call to flush_pending(), allocated in PENDING_POOL. */
+  apr_array_header_t *pending;
+  apr_pool_t *pending_pool;
 };
 
 
@@ -563,6 +578,239 @@ struct handler_baton
 };
 
 
+/* A node added by the export editor that still has to be put into place
+   or notified. */
+typedef struct pending_node_t
+{
+  svn_node_kind_t kind;
+  const char *path;
+
+  /* For files, where the text was received.  This is PATH itself if it
+     was written there directly. */
+  const char *tmppath;
+
+  /* How to translate the text, as for svn_subst_copy_and_translate4(). */
+  const char *eol;
+  svn_boolean_t repair;
+  apr_hash_t *keywords;
+  svn_boolean_t special;
+
+  svn_boolean_t executable;
+  apr_time_t date;
+} pending_node_t;
+
+/* Send the notification for the node PATH of KIND added by the export
+   editor EB. */
+static void
+notify_added(struct edit_baton *eb,
+             const char *path,
+             svn_node_kind_t kind,
+             apr_pool_t *scratch_pool)
+{
+  if (eb->notify_func)
+    {
+      svn_wc_notify_t *notify = svn_wc_create_notify(path,
+                                                     svn_wc_notify_update_add,
+                                                     scratch_pool);
+      notify->kind = kind;
+      (*eb->notify_func)(eb->notify_baton, notify, scratch_pool);
+    }
+}
+
+/* Translate the text of FILE, which was written to its final location,
+   in place. */
+static svn_error_t *
+translate_in_place(const pending_node_t *file,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *scratch_pool)
+{
+  svn_stream_t *src_stream;
+  svn_stream_t *dst_stream;
+  const char *dst_tmp;
+  svn_error_t *err;
+
+  /* Special files are created from their text, which must not be open
+     any more when they replace it. */
+  if (file->special)
+    {
+      svn_stringbuf_t *text;
+      apr_size_t len;
+
+      SVN_ERR(svn_stringbuf_from_file2(&text, file->path, scratch_pool));
+      SVN_ERR(svn_subst_create_specialfile(&dst_stream, file->path,
+                                           scratch_pool, scratch_pool));
+      len = text->len;
+      SVN_ERR(svn_stream_write(dst_stream, text->data, &len));
+      return svn_error_trace(svn_stream_close(dst_stream));
+    }
+
+  SVN_ERR(svn_stream_open_readonly(&src_stream, file->path, scratch_pool,
+                                   scratch_pool));
+  SVN_ERR(svn_stream_open_unique(&dst_stream, &dst_tmp,
+                                 svn_dirent_dirname(file->path,
+                                                    scratch_pool),
+                                 svn_io_file_del_none,
+                                 scratch_pool, scratch_pool));
+  dst_stream = svn_subst_stream_translated(dst_stream, file->eol,
+                                           file->repair, file->keywords,
+                                           TRUE /* expand */, scratch_pool);
+
+  /* This closes both streams. */
+  err = svn_stream_copy3(src_stream, dst_stream, cancel_func, cancel_baton,
+                         scratch_pool);
+  if (err)
+    {
+      if (err->apr_err == SVN_ERR_IO_INCONSISTENT_EOL)
+        err = svn_error_createf(SVN_ERR_IO_INCONSISTENT_EOL, err,
+                                _("File '%s' has inconsistent newlines"),
+                                svn_dirent_local_style(file->path,
+                                                       scratch_pool));
+      return svn_error_compose_create(
+                err, svn_io_remove_file2(dst_tmp, TRUE, scratch_pool));
+    }
+
+  return svn_error_trace(svn_io_file_rename2(dst_tmp, file->path, FALSE,
+                                             scratch_pool));
+}
+
+/* Put the received text of FILE into place, translating it as needed,
+   and set its executable bit and timestamp. */
+static svn_error_t *
+install_file(const pending_node_t *file,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *scratch_pool)
+{
+  svn_boolean_t translate = (file->eol || file->special
+                             || (file->keywords
+                                 && apr_hash_count(file->keywords) > 0));
+
+  if (strcmp(file->tmppath, file->path) == 0)
+    {
+      if (translate)
+        SVN_ERR(translate_in_place(file, cancel_func, cancel_baton,
+                                   scratch_pool));
+    }
+  else if (! translate)
+    {
+      SVN_ERR(svn_io_file_rename2(file->tmppath, file->path, FALSE,
+                                  scratch_pool));
+    }
+  else
+    {
+      SVN_ERR(svn_subst_copy_and_translate4(file->tmppath, file->path,
+                                            file->eol, file->repair,
+                                            file->keywords,
+                                            TRUE, /* expand */
+                                            file->special,
+                                            cancel_func, cancel_baton,
+                                            scratch_pool));
+
+      SVN_ERR(svn_io_remove_file2(file->tmppath, FALSE, scratch_pool));
+    }
+
+  if (file->executable)
+    SVN_ERR(svn_io_set_file_executable(file->path, TRUE, FALSE,
+                                       scratch_pool));
+
+  if (file->date && (! file->special))
+    SVN_ERR(svn_io_set_file_affected_time(file->date, file->path,
+                                          scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t, putting the file at index INDEX
+   of the pending nodes PROCESS_BATON into place. */
+static svn_error_t *
+install_pending(void **result,
+                int index,
+                void *process_baton,
+                void *thread_context,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  const apr_array_header_t *pending = process_baton;
+  const pending_node_t *node = APR_ARRAY_IDX(pending, index,
+                                             const pending_node_t *);
+
+  *result = NULL;
+  if (node->kind == svn_node_file)
+    SVN_ERR(install_file(node, cancel_func, cancel_baton, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t, notifying the node at index INDEX
+   of the pending nodes of the edit_baton OUTPUT_BATON. */
+static svn_error_t *
+notify_pending(void *result,
+               int index,
+               void *output_baton,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *scratch_pool)
+{
+  struct edit_baton *eb = output_baton;
+  const pending_node_t *node = APR_ARRAY_IDX(eb->pending, index,
+                                             const pending_node_t *);
+
+  notify_added(eb, node->path, node->kind, scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove the temporary files of the pending nodes of EB that have not
+   been put into place, and forget about them. */
+static void
+discard_pending(struct edit_baton *eb,
+                apr_pool_t *scratch_pool)
+{
+  int i;
+
+  for (i = 0; i < eb->pending->nelts; i++)
+    {
+      const pending_node_t *node = APR_ARRAY_IDX(eb->pending, i,
+                                                 const pending_node_t *);
+
+      if (node->kind == svn_node_file
+          && strcmp(node->tmppath, node->path) != 0)
+        svn_error_clear(svn_io_remove_file2(node->tmppath, TRUE,
+                                            scratch_pool));
+    }
+
+  apr_array_clear(eb->pending);
+  svn_pool_clear(eb->pending_pool);
+}
+
+/* Put the pending files of EB into place using up to EB->threads
+   threads, and send the notifications for all pending nodes in order. */
+static svn_error_t *
+flush_pending(struct edit_baton *eb,
+              apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+
+  if (eb->pending->nelts == 0)
+    return SVN_NO_ERROR;
+
+  err = svn_task__run(eb->threads, eb->pending->nelts,
+                      install_pending, eb->pending,
+                      notify_pending, eb,
+                      NULL, NULL,
+                      eb->cancel_func, eb->cancel_baton,
+                      scratch_pool);
+
+  /* The files that are in place have no temporary files left. */
+  discard_pending(eb, scratch_pool);
+
+  return svn_error_trace(err);
+}
+
+
 static svn_error_t *
 set_target_revision(void *edit_baton,
                     svn_revnum_t target_revision,
@@ -586,6 +834,10 @@ open_root(void *edit_baton,
 {
   struct edit_baton *eb = edit_baton;
   struct dir_baton *db = apr_pcalloc(pool, sizeof(*db));
+  svn_node_kind_t kind;
+
+  SVN_ERR(svn_io_check_path(eb->root_path, &kind, pool));
+  eb->fresh = (kind == svn_node_none);
 
   SVN_ERR(open_root_internal(eb->root_path, eb->overwrite,
                              eb->notify_func, eb->notify_baton, pool));
@@ -612,28 +864,51 @@ add_directory(const char *path,
   struct dir_baton *db = apr_pcalloc(pool, sizeof(*db));
   struct edit_baton *eb = pb->edit_baton;
   const char *full_path = svn_dirent_join(eb->root_path, path, pool);
-  svn_node_kind_t kind;
+  svn_boolean_t made = FALSE;
 
-  SVN_ERR(svn_io_check_path(full_path, &kind, pool));
-  if (kind == svn_node_none)
-    SVN_ERR(svn_io_dir_make(full_path, APR_OS_DEFAULT, pool));
-  else if (kind == svn_node_file)
-    return svn_error_createf(SVN_ERR_WC_NOT_WORKING_COPY, NULL,
-                             _("'%s' exists and is not a directory"),
-                             svn_dirent_local_style(full_path, pool));
-  else if (! (kind == svn_node_dir && eb->overwrite))
-    return svn_error_createf(SVN_ERR_WC_OBSTRUCTED_UPDATE, NULL,
-                             _("'%s' already exists"),
-                             svn_dirent_local_style(full_path, pool));
+  /* Nothing can be in the way in a fresh export, except for names that
+     differ only in case on some file systems. */
+  if (eb->fresh)
+    {
+      svn_error_t *err = svn_io_dir_make(full_path, APR_OS_DEFAULT, pool);
 
-  if (eb->notify_func)
+      if (err && APR_STATUS_IS_EEXIST(err->apr_err))
+        svn_error_clear(err);
+      else
+        {
+          SVN_ERR(err);
+          made = TRUE;
+        }
+    }
+
+  if (! made)
     {
-      svn_wc_notify_t *notify = svn_wc_create_notify(full_path,
-                                                     svn_wc_notify_update_add,
-                                                     pool);
-      notify->kind = svn_node_dir;
-      (*eb->notify_func)(eb->notify_baton, notify, pool);
+      svn_node_kind_t kind;
+
+      SVN_ERR(svn_io_check_path(full_path, &kind, pool));
+      if (kind == svn_node_none)
+        SVN_ERR(svn_io_dir_make(full_path, APR_OS_DEFAULT, pool));
+      else if (kind == svn_node_file)
+        return svn_error_createf(SVN_ERR_WC_NOT_WORKING_COPY, NULL,
+                                 _("'%s' exists and is not a directory"),
+                                 svn_dirent_local_style(full_path, pool));
+      else if (! (kind == svn_node_dir && eb->overwrite))
+        return svn_error_createf(SVN_ERR_WC_OBSTRUCTED_UPDATE, NULL,
+                                 _("'%s' already exists"),
+                                 svn_dirent_local_style(full_path, pool));
+    }
+
+  /* Keep the notifications in order with those of pending files. */
+  if (eb->pending)
+    {
+      pending_node_t *node = apr_pcalloc(eb->pending_pool, sizeof(*node));
+
+      node->kind = svn_node_dir;
+      node->path = apr_pstrdup(eb->pending_pool, full_path);
+      APR_ARRAY_PUSH(eb->pending, pending_node_t *) = node;
     }
+  else
+    notify_added(eb, full_path, svn_node_dir, pool);
 
   /* Build our dir baton. */
   db->path = full_path;
@@ -705,12 +980,28 @@ apply_textdelta(void *file_baton,
 {
   struct file_baton *fb = file_baton;
   struct handler_baton *hb = apr_palloc(pool, sizeof(*hb));
+  svn_error_t *err = NULL;
 
-  /* Create a temporary file in the same directory as the file. We're going
-     to rename the thing into place when we're done. */
-  SVN_ERR(svn_stream_open_unique(&fb->tmp_stream, &fb->tmppath,
-                                 svn_dirent_dirname(fb->path, pool),
-                                 svn_io_file_del_none, fb->pool, fb->pool));
+  /* In a fresh export, nothing can see the file before it is done, so
+     write it in place. */
+  if (fb->edit_baton->fresh)
+    {
+      err = svn_stream_open_writable(&fb->tmp_stream, fb->path,
+                                     fb->pool, fb->pool);
+      if (! err)
+        fb->tmppath = fb->path;
+      else if (APR_STATUS_IS_EEXIST(err->apr_err))
+        svn_error_clear(err);
+      else
+        return svn_error_trace(err);
+    }
+
+  /* Otherwise create a temporary file in the same directory as the file.
+     We're going to rename the thing into place when we're done. */
+  if (! fb->tmppath)
+    SVN_ERR(svn_stream_open_unique(&fb->tmp_stream, &fb->tmppath,
+                                   svn_dirent_dirname(fb->path, pool),
+                                   svn_io_file_del_none, fb->pool, fb->pool));
 
   hb->pool = pool;
   hb->tmppath = fb->tmppath;
@@ -785,7 +1076,8 @@ change_dir_prop(void *dir_baton,
 }
 
 
-/* Move the tmpfile to file, and send feedback. */
+/* Move the tmpfile to file, translating it as needed, and send feedback.
+   If other threads put files into place, just queue it. */
 static svn_error_t *
 close_file(void *file_baton,
            const char *text_digest,
@@ -795,6 +1087,8 @@ close_file(void *file_baton,
   struct edit_baton *eb = fb->edit_baton;
   svn_checksum_t *text_checksum;
   svn_checksum_t *actual_checksum;
+  pending_node_t *file;
+  apr_pool_t *result_pool;
 
   /* Was a txdelta even sent? */
   if (! fb->tmppath)
@@ -814,55 +1108,70 @@ close_file(void *file_baton,
                                      _("Checksum mismatch for '%s'"),
                                      svn_dirent_local_style(fb->path, pool));
 
-  if ((! fb->eol_style_val) && (! fb->keywords_val) && (! fb->special))
-    {
-      SVN_ERR(svn_io_file_rename2(fb->tmppath, fb->path, FALSE, pool));
-    }
-  else
+  /* Remember everything about the file in a pool that outlives POOL, if
+     it is left to other threads. */
+  result_pool = eb->pending ? eb->pending_pool : pool;
+  file = apr_pcalloc(result_pool, sizeof(*file));
+  file->kind = svn_node_file;
+  file->path = apr_pstrdup(result_pool, fb->path);
+  file->tmppath = apr_pstrdup(result_pool, fb->tmppath);
+  file->special = fb->special;
+  file->executable = (fb->executable_val != NULL);
+  file->date = fb->date;
+
+  if (fb->eol_style_val)
     {
       svn_subst_eol_style_t style;
-      const char *eol = NULL;
-      svn_boolean_t repair = FALSE;
-      apr_hash_t *final_kw = NULL;
 
-      if (fb->eol_style_val)
-        {
-          SVN_ERR(get_eol_style(&style, &eol, fb->eol_style_val->data,
-                                eb->native_eol));
-          repair = TRUE;
-        }
+      SVN_ERR(get_eol_style(&style, &file->eol, fb->eol_style_val->data,
+                            eb->native_eol));
+      file->repair = TRUE;
+    }
 
-      if (fb->keywords_val)
-        SVN_ERR(svn_subst_build_keywords3(&final_kw, fb->keywords_val->data,
-                                          fb->revision, fb->url,
-                                          fb->repos_root_url, fb->date,
-                                          fb->author, pool));
+  if (fb->keywords_val)
+    SVN_ERR(svn_subst_build_keywords3(&file->keywords,
+                                      fb->keywords_val->data,
+                                      fb->revision, fb->url,
+                                      fb->repos_root_url, fb->date,
+                                      fb->author, result_pool));
 
-      SVN_ERR(svn_subst_copy_and_translate4(fb->tmppath, fb->path,
-                                            eol, repair, final_kw,
-                                            TRUE, /* expand */
-                                            fb->special,
-                                            eb->cancel_func, eb->cancel_baton,
-                                            pool));
+  if (eb->pending)
+    {
+      APR_ARRAY_PUSH(eb->pending, pending_node_t *) = file;
+      if (eb->pending->nelts >= 8 * eb->threads)
+        SVN_ERR(flush_pending(eb, pool));
 
-      SVN_ERR(svn_io_remove_file2(fb->tmppath, FALSE, pool));
+      return SVN_NO_ERROR;
     }
 
-  if (fb->executable_val)
-    SVN_ERR(svn_io_set_file_executable(fb->path, TRUE, FALSE, pool));
+  SVN_ERR(install_file(file, eb->cancel_func, eb->cancel_baton, pool));
+  notify_added(eb, fb->path, svn_node_file, pool);
 
-  if (fb->date && (! fb->special))
-    SVN_ERR(svn_io_set_file_affected_time(fb->date, fb->path, pool));
+  return SVN_NO_ERROR;
+}
 
-  if (fb->edit_baton->notify_func)
-    {
-      svn_wc_notify_t *notify = svn_wc_create_notify(fb->path,
-                                                     svn_wc_notify_update_add,
-                                                     pool);
-      notify->kind = svn_node_file;
-      (*fb->edit_baton->notify_func)(fb->edit_baton->notify_baton, notify,
-                                     pool);
-    }
+/* Put the remaining pending files into place. */
+static svn_error_t *
+close_edit(void *edit_baton,
+           apr_pool_t *pool)
+{
+  struct edit_baton *eb = edit_baton;
+
+  if (eb->pending)
+    SVN_ERR(flush_pending(eb, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove the temporary files of the pending files. */
+static svn_error_t *
+abort_edit(void *edit_baton,
+           apr_pool_t *pool)
+{
+  struct edit_baton *eb = edit_baton;
+
+  if (eb->pending)
+    discard_pending(eb, pool);
 
   return SVN_NO_ERROR;
 }
@@ -914,6 +1223,15 @@ get_editor_ev1(const svn_delta_editor_t **export_editor,
   editor->close_file = close_file;
   editor->change_file_prop = change_file_prop;
   editor->change_dir_prop = change_dir_prop;
+  editor->close_edit = close_edit;
+  editor->abort_edit = abort_edit;
+
+  if (eb->threads > 1)
+    {
+      eb->pending = apr_array_make(result_pool, 8 * eb->threads,
+                                   sizeof(pending_node_t *));
+      eb->pending_pool = svn_pool_create(result_pool);
+    }
 
   SVN_ERR(svn_delta_get_cancellation_editor(ctx->cancel_func,
                                             ctx->cancel_baton,
@@ -1364,6 +1682,25 @@ export_directory(const char *from_url,
 
 /*** Public Interfaces ***/
 
+/* Set *THREAD_COUNT to the number of threads that may be used to put
+   exported files into place, as configured in CTX. */
+static svn_error_t *
+get_export_threads(int *thread_count,
+                   svn_client_ctx_t *ctx)
+{
+  svn_config_t *cfg = ctx->config
+                       ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+                       : NULL;
+  apr_int64_t export_threads;
+
+  SVN_ERR(svn_config_get_int64(cfg, &export_threads,
+                               SVN_CONFIG_SECTION_MISCELLANY,
+                               SVN_CONFIG_OPTION_EXPORT_THREADS, 1));
+  *thread_count = (int)MAX(1, MIN(export_threads, 64));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_client_export5(svn_revnum_t *result_rev,
                    const char *from_path_or_url,
@@ -1421,6 +1758,7 @@ svn_client_export5(svn_revnum_t *result_rev,
       eb->cancel_baton = ctx->cancel_baton;
       eb->notify_func = ctx->notify_func2;
       eb->notify_baton = ctx->notify_baton2;
+      SVN_ERR(get_export_threads(&eb->threads, ctx));
 
       SVN_ERR(svn_ra_check_path(ra_session, "", loc->rev, &kind, pool));
 
@@ -37,10 +37,13 @@
 #include "svn_dirent_uri.h"
 #include "svn_path.h"
 #include "svn_props.h"
+#include "svn_sorts.h"
 #include "svn_config.h"
 #include "client.h"
 
 #include "svn_private_config.h"
+#include "private/svn_auth_private.h"
+#include "private/svn_task.h"
 #include "private/svn_wc_private.h"
 
 
@@ -745,6 +748,11 @@ handle_external_item_removal(const svn_client_ctx_t *ctx,
   return svn_error_trace(err);
 }
 
+/* Check out, update or switch the external NEW_ITEM defined on
+   PARENT_DIR_ABSPATH to LOCAL_ABSPATH.
+
+   If IS_FILE_EXTERNAL is not NULL, leave file externals alone and set
+   *IS_FILE_EXTERNAL to whether NEW_ITEM is one. */
 static svn_error_t *
 handle_external_item_change(svn_client_ctx_t *ctx,
                             const char *repos_root_url,
@@ -755,6 +763,7 @@ handle_external_item_change(svn_client_ctx_t *ctx,
                             const svn_wc_external_item2_t *new_item,
                             svn_ra_session_t *ra_session,
                             svn_boolean_t *timestamp_sleep,
+                            svn_boolean_t *is_file_external,
                             apr_pool_t *scratch_pool)
 {
   svn_client__pathrev_t *new_loc;
@@ -825,6 +834,12 @@ handle_external_item_change(svn_client_ctx_t *ctx,
                                "or a directory"),
                              new_loc->url, new_loc->rev);
 
+  if (is_file_external)
+    {
+      *is_file_external = (ext_kind == svn_node_file);
+      if (*is_file_external)
+        return SVN_NO_ERROR;
+    }
 
   /* Not protecting against recursive externals.  Detecting them in
      the global case is hard, and it should be pretty obvious to a
@@ -958,6 +973,272 @@ wrap_external_error(const svn_client_ctx_t *ctx,
   return err;
 }
 
+/* A directory external that may be fetched by a worker thread, see
+   handle_external_jobs(). */
+typedef struct external_job_t
+{
+  /* The arguments for handle_external_item_change(). */
+  const char *parent_dir_abspath;
+  const char *parent_dir_url;
+  const char *target_abspath;
+  const char *old_defining_abspath;
+  const svn_wc_external_item2_t *new_item;
+
+  /* Root pool for the worker's data, not sharing an allocator with the
+     caller's pools.  NULL if the caller has to handle the item itself,
+     because it overlaps with another external. */
+  apr_pool_t *pool;
+
+  /* The configuration and authentication for the worker, in POOL. */
+  apr_hash_t *config;
+  svn_auth_baton_t *auth_baton;
+
+  /* The notifications sent by the worker, svn_wc_notify_t *, in POOL. */
+  apr_array_header_t *notifications;
+
+  /* Whether the worker set file timestamps. */
+  svn_boolean_t timestamp_sleep;
+
+  /* Whether the caller still has to handle the item, because the worker
+     didn't or failed. */
+  svn_boolean_t deferred;
+} external_job_t;
+
+/* Baton for fetch_external() and finish_external(). */
+typedef struct external_jobs_baton_t
+{
+  /* The external_job_t * to handle. */
+  apr_array_header_t *jobs;
+
+  /* The arguments of svn_client__handle_externals(). */
+  const char *repos_root_url;
+  svn_boolean_t *timestamp_sleep;
+  svn_ra_session_t *ra_session;
+  svn_client_ctx_t *ctx;
+} external_jobs_baton_t;
+
+/* Implements svn_wc_notify_func2_t, remembering NOTIFY in the
+   external_job_t BATON. */
+static void
+buffer_notification(void *baton,
+                    const svn_wc_notify_t *notify,
+                    apr_pool_t *pool)
+{
+  external_job_t *job = baton;
+
+  APR_ARRAY_PUSH(job->notifications, svn_wc_notify_t *)
+    = svn_wc_dup_notify(notify, job->pool);
+}
+
+/* Implements svn_task__process_func_t, fetching the external_job_t with
+   the given INDEX in the external_jobs_baton_t PROCESS_BATON with a
+   client context of its own. */
+static svn_error_t *
+fetch_external(void **result,
+               int index,
+               void *process_baton,
+               void *thread_context,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  external_jobs_baton_t *jb = process_baton;
+  external_job_t *job = APR_ARRAY_IDX(jb->jobs, index, external_job_t *);
+  svn_client_ctx_t *ctx;
+  svn_boolean_t is_file_external = FALSE;
+  svn_error_t *err;
+
+  *result = job;
+  job->deferred = TRUE;
+  if (!job->pool)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_client_create_context2(&ctx, job->config, job->pool));
+  ctx->auth_baton = job->auth_baton;
+  ctx->notify_func2 = buffer_notification;
+  ctx->notify_baton2 = job;
+  ctx->cancel_func = cancel_func;
+  ctx->cancel_baton = cancel_baton;
+  ctx->client_name = jb->ctx->client_name;
+  ctx->mimetypes_map = jb->ctx->mimetypes_map;
+  ctx->check_tunnel_func = jb->ctx->check_tunnel_func;
+  ctx->open_tunnel_func = jb->ctx->open_tunnel_func;
+  ctx->tunnel_baton = jb->ctx->tunnel_baton;
+
+  err = handle_external_item_change(ctx, jb->repos_root_url,
+                                    job->parent_dir_abspath,
+                                    job->parent_dir_url,
+                                    job->target_abspath,
+                                    job->old_defining_abspath,
+                                    job->new_item, NULL,
+                                    &job->timestamp_sleep,
+                                    &is_file_external, scratch_pool);
+  err = svn_error_compose_create(err, svn_wc_context_destroy(ctx->wc_ctx));
+
+  if (err && err->apr_err == SVN_ERR_CANCELLED)
+    return svn_error_trace(err);
+
+  /* Everything else, including prompting for credentials, is left to the
+     caller, which picks up where this attempt stopped. */
+  if (err || is_file_external)
+    {
+      svn_error_clear(err);
+      apr_array_clear(job->notifications);
+      return SVN_NO_ERROR;
+    }
+
+  job->deferred = FALSE;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t, sending the notifications for the
+   external_job_t RESULT or handling it in this thread, as described by
+   the external_jobs_baton_t OUTPUT_BATON. */
+static svn_error_t *
+finish_external(void *result,
+                int index,
+                void *output_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *scratch_pool)
+{
+  external_job_t *job = result;
+  external_jobs_baton_t *jb = output_baton;
+  svn_client_ctx_t *ctx = jb->ctx;
+  int i;
+
+  if (job->deferred)
+    return svn_error_trace(wrap_external_error(
+                      ctx, job->target_abspath,
+                      handle_external_item_change(ctx,
+                                                  jb->repos_root_url,
+                                                  job->parent_dir_abspath,
+                                                  job->parent_dir_url,
+                                                  job->target_abspath,
+                                                  job->old_defining_abspath,
+                                                  job->new_item,
+                                                  jb->ra_session,
+                                                  jb->timestamp_sleep, NULL,
+                                                  scratch_pool),
+                      scratch_pool));
+
+  if (ctx->notify_func2)
+    for (i = 0; i < job->notifications->nelts; i++)
+      ctx->notify_func2(ctx->notify_baton2,
+                        APR_ARRAY_IDX(job->notifications, i,
+                                      svn_wc_notify_t *),
+                        scratch_pool);
+
+  if (job->timestamp_sleep)
+    *jb->timestamp_sleep = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Handle the external_job_t * in JOBS in order, like
+   handle_external_item_change() would, using up to THREAD_COUNT threads
+   to fetch the directory externals.
+
+   Externals whose targets are nested within each other and file
+   externals, which are part of the working copy defining them, are
+   handled by this thread, using RA_SESSION if not NULL.  Workers that
+   fail, e.g. because they would have to prompt for credentials, leave
+   their item to this thread as well.
+
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+handle_external_jobs(apr_array_header_t *jobs,
+                     int thread_count,
+                     const char *repos_root_url,
+                     svn_boolean_t *timestamp_sleep,
+                     svn_ra_session_t *ra_session,
+                     svn_client_ctx_t *ctx,
+                     apr_pool_t *scratch_pool)
+{
+  external_jobs_baton_t jb;
+  svn_error_t *err;
+  int i, j;
+
+  for (i = 0; i < jobs->nelts; i++)
+    {
+      external_job_t *job = APR_ARRAY_IDX(jobs, i, external_job_t *);
+      svn_config_t *cfg;
+
+      for (j = 0; j < jobs->nelts; j++)
+        {
+          const external_job_t *other = APR_ARRAY_IDX(jobs, j,
+                                                      external_job_t *);
+
+          if (i != j
+              && (svn_dirent_is_ancestor(job->target_abspath,
+                                         other->target_abspath)
+                  || svn_dirent_is_ancestor(other->target_abspath,
+                                            job->target_abspath)))
+            break;
+        }
+      if (j < jobs->nelts)
+        continue;
+
+      /* The worker threads allocate in this pool, so it must not share
+         its allocator with the pools of this thread. */
+      job->pool = svn_pool_create(NULL);
+      job->notifications = apr_array_make(job->pool, 16,
+                                          sizeof(svn_wc_notify_t *));
+
+      /* Reading the configuration may modify it, so each worker needs a
+         copy.  The externals of externals are handled by the worker
+         itself. */
+      job->config = NULL;
+      if (ctx->config)
+        SVN_ERR(svn_config_copy_config(&job->config, ctx->config,
+                                       job->pool));
+      cfg = job->config ? svn_hash_gets(job->config,
+                                        SVN_CONFIG_CATEGORY_CONFIG)
+                        : NULL;
+      if (cfg)
+        svn_config_set(cfg, SVN_CONFIG_SECTION_MISCELLANY,
+                       SVN_CONFIG_OPTION_EXTERNALS_THREADS, "1");
+
+      job->auth_baton = NULL;
+      if (ctx->auth_baton)
+        {
+          svn_auth__copy_baton(&job->auth_baton, ctx->auth_baton,
+                               job->pool);
+          svn_auth_set_parameter(job->auth_baton,
+                                 SVN_AUTH_PARAM_NON_INTERACTIVE, "");
+        }
+    }
+
+  jb.jobs = jobs;
+  jb.repos_root_url = repos_root_url;
+  jb.timestamp_sleep = timestamp_sleep;
+  jb.ra_session = ra_session;
+  jb.ctx = ctx;
+
+  err = svn_task__run(thread_count, jobs->nelts,
+                      fetch_external, &jb,
+                      finish_external, &jb,
+                      NULL, NULL,
+                      ctx->cancel_func, ctx->cancel_baton,
+                      scratch_pool);
+
+  for (i = 0; i < jobs->nelts; i++)
+    {
+      external_job_t *job = APR_ARRAY_IDX(jobs, i, external_job_t *);
+
+      if (job->pool)
+        svn_pool_destroy(job->pool);
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Handle the externals defined on LOCAL_ABSPATH by NEW_DESC_TEXT.
+
+   If JOBS is not NULL, don't handle them yet but add them to JOBS as
+   external_job_t *, allocated in the pool of JOBS, for
+   handle_external_jobs(). */
 static svn_error_t *
 handle_externals_change(svn_client_ctx_t *ctx,
                         const char *repos_root_url,
@@ -968,11 +1249,13 @@ handle_externals_change(svn_client_ctx_t *ctx,
                         svn_depth_t ambient_depth,
                         svn_depth_t requested_depth,
                         svn_ra_session_t *ra_session,
+                        apr_array_header_t *jobs,
                         apr_pool_t *scratch_pool)
 {
   apr_array_header_t *new_desc;
   int i;
   apr_pool_t *iterpool;
+  apr_pool_t *desc_pool = jobs ? jobs->pool : scratch_pool;
   const char *url;
 
   iterpool = svn_pool_create(scratch_pool);
@@ -989,12 +1272,12 @@ handle_externals_change(svn_client_ctx_t *ctx,
   if (new_desc_text)
     SVN_ERR(svn_wc_parse_externals_description3(&new_desc, local_abspath,
                                                 new_desc_text,
-                                                FALSE, scratch_pool));
+                                                FALSE, desc_pool));
   else
     new_desc = NULL;
 
   SVN_ERR(svn_wc__node_get_url(&url, ctx->wc_ctx, local_abspath,
-                               scratch_pool, iterpool));
+                               desc_pool, iterpool));
 
   SVN_ERR_ASSERT(url);
 
@@ -1029,17 +1312,29 @@ handle_externals_change(svn_client_ctx_t *ctx,
 
       old_defining_abspath = svn_hash_gets(old_externals, target_abspath);
 
-      SVN_ERR(wrap_external_error(
-                      ctx, target_abspath,
-                      handle_external_item_change(ctx,
-                                                  repos_root_url,
-                                                  local_abspath, url,
-                                                  target_abspath,
-                                                  old_defining_abspath,
-                                                  new_item, ra_session,
-                                                  timestamp_sleep,
-                                                  iterpool),
-                      iterpool));
+      if (jobs)
+        {
+          external_job_t *job = apr_pcalloc(jobs->pool, sizeof(*job));
+
+          job->parent_dir_abspath = apr_pstrdup(jobs->pool, local_abspath);
+          job->parent_dir_url = url;
+          job->target_abspath = apr_pstrdup(jobs->pool, target_abspath);
+          job->old_defining_abspath = old_defining_abspath;
+          job->new_item = new_item;
+          APR_ARRAY_PUSH(jobs, external_job_t *) = job;
+        }
+      else
+        SVN_ERR(wrap_external_error(
+                        ctx, target_abspath,
+                        handle_external_item_change(ctx,
+                                                    repos_root_url,
+                                                    local_abspath, url,
+                                                    target_abspath,
+                                                    old_defining_abspath,
+                                                    new_item, ra_session,
+                                                    timestamp_sleep, NULL,
+                                                    iterpool),
+                        iterpool));
 
       /* And remove already processed items from the to-remove hash */
       if (old_defining_abspath)
@@ -1066,9 +1361,21 @@ svn_client__handle_externals(apr_hash_t *externals_new,
   apr_hash_t *old_external_defs;
   apr_hash_index_t *hi;
   apr_pool_t *iterpool;
+  svn_config_t *cfg = ctx->config
+                       ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+                       : NULL;
+  apr_int64_t externals_threads;
+  apr_array_header_t *jobs = NULL;
 
   SVN_ERR_ASSERT(repos_root_url);
 
+  SVN_ERR(svn_config_get_int64(cfg, &externals_threads,
+                               SVN_CONFIG_SECTION_MISCELLANY,
+                               SVN_CONFIG_OPTION_EXTERNALS_THREADS, 1));
+  externals_threads = MAX(1, MIN(externals_threads, 64));
+  if (externals_threads > 1)
+    jobs = apr_array_make(scratch_pool, 0, sizeof(external_job_t *));
+
   iterpool = svn_pool_create(scratch_pool);
 
   SVN_ERR(svn_wc__externals_defined_below(&old_external_defs,
@@ -1109,9 +1416,14 @@ svn_client__handle_externals(apr_hash_t *externals_new,
                                       local_abspath,
                                       desc_text, old_external_defs,
                                       ambient_depth, requested_depth,
-                                      ra_session, iterpool));
+                                      ra_session, jobs, iterpool));
     }
 
+  if (jobs)
+    SVN_ERR(handle_external_jobs(jobs, (int)externals_threads,
+                                 repos_root_url, timestamp_sleep,
+                                 ra_session, ctx, iterpool));
+
   /* Remove the remaining externals */
   for (hi = apr_hash_first(scratch_pool, old_external_defs);
        hi;
@@ -59,6 +59,7 @@
 #include "private/svn_client_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_task.h"
 #include "private/svn_wc_private.h"
 
 #include "svn_private_config.h"
@@ -318,6 +319,13 @@ typedef struct merge_cmd_baton_t {
      generated conflict files. */
   const apr_array_header_t *ext_patterns;
 
+  /* The number of threads to merge file contents with.  If this is larger
+     than 1, text merges that can't be done trivially are queued up as
+     pending_text_merge_t * in PENDING_TEXT_MERGES and completed by
+     flush_text_merges(). */
+  int merge_threads;
+  apr_array_header_t *pending_text_merges;
+
   /* RA sessions used throughout a merge operation.  Opened/re-parented
      as needed.
 
@@ -1743,6 +1751,179 @@ mark_file_edited(merge_cmd_baton_t *merge_b,
   return SVN_NO_ERROR;
 }
 
+/* Record the outcome of merging the text and properties of the file
+   LOCAL_ABSPATH for MERGE_B and produce the notification for it.
+   CONTENT_OUTCOME and PROPERTY_STATE are as returned by svn_wc_merge5().
+   HAS_LOCAL_MODS tells whether the file had local modifications before
+   the merge. */
+static svn_error_t *
+record_file_merge(merge_cmd_baton_t *merge_b,
+                  const char *local_abspath,
+                  svn_boolean_t has_local_mods,
+                  enum svn_wc_merge_outcome_t content_outcome,
+                  svn_wc_notify_state_t property_state,
+                  apr_pool_t *scratch_pool)
+{
+  svn_wc_notify_state_t text_state;
+
+  if (content_outcome == svn_wc_merge_conflict
+      || property_state == svn_wc_notify_state_conflicted)
+    {
+      alloc_and_store_path(&merge_b->conflicted_paths, local_abspath,
+                           merge_b->pool);
+    }
+
+  if (content_outcome == svn_wc_merge_conflict)
+    text_state = svn_wc_notify_state_conflicted;
+  else if (has_local_mods
+           && content_outcome != svn_wc_merge_unchanged)
+    text_state = svn_wc_notify_state_merged;
+  else if (content_outcome == svn_wc_merge_merged)
+    text_state = svn_wc_notify_state_changed;
+  else if (content_outcome == svn_wc_merge_no_merge)
+    text_state = svn_wc_notify_state_missing;
+  else /* merge_outcome == svn_wc_merge_unchanged */
+    text_state = svn_wc_notify_state_unchanged;
+
+  if (text_state == svn_wc_notify_state_conflicted
+      || text_state == svn_wc_notify_state_merged
+      || text_state == svn_wc_notify_state_changed
+      || property_state == svn_wc_notify_state_conflicted
+      || property_state == svn_wc_notify_state_merged
+      || property_state == svn_wc_notify_state_changed)
+    {
+      SVN_ERR(record_update_update(merge_b, local_abspath, svn_node_file,
+                                   text_state, property_state,
+                                   scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* A file merge whose contents still need to be merged. */
+typedef struct pending_text_merge_t
+{
+  /* The merge target and whether it had local modifications. */
+  const char *local_abspath;
+  svn_boolean_t has_local_mods;
+
+  /* The merge itself, allocated in POOL. */
+  svn_wc__file_merge_t *merge;
+  apr_pool_t *pool;
+} pending_text_merge_t;
+
+/* Implements svn_task__process_func_t, merging the file contents for the
+   pending_text_merge_t * at INDEX in the array PROCESS_BATON. */
+static svn_error_t *
+run_text_merge(void **result,
+               int index,
+               void *process_baton,
+               void *thread_context,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *pending = process_baton;
+  pending_text_merge_t *ptm = APR_ARRAY_IDX(pending, index,
+                                            pending_text_merge_t *);
+
+  SVN_ERR(svn_wc__file_merge_run(ptm->merge, cancel_func, cancel_baton,
+                                 scratch_pool));
+  *result = ptm;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t, completing the pending_text_merge_t
+   RESULT for the merge_cmd_baton_t OUTPUT_BATON. */
+static svn_error_t *
+finish_text_merge(void *result,
+                  int index,
+                  void *output_baton,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  apr_pool_t *scratch_pool)
+{
+  pending_text_merge_t *ptm = result;
+  merge_cmd_baton_t *merge_b = output_baton;
+  enum svn_wc_merge_outcome_t content_outcome;
+  svn_wc_notify_state_t property_state;
+
+  SVN_ERR(svn_wc__file_merge_finish(&content_outcome, &property_state,
+                                    ptm->merge, NULL, NULL,
+                                    cancel_func, cancel_baton,
+                                    scratch_pool));
+
+  return svn_error_trace(record_file_merge(merge_b, ptm->local_abspath,
+                                           ptm->has_local_mods,
+                                           content_outcome, property_state,
+                                           scratch_pool));
+}
+
+/* Merge the contents of all files queued in MERGE_B->PENDING_TEXT_MERGES
+   concurrently and complete these merges in queue order.
+
+   This must be called before any other notification is sent or any
+   other node is being modified, so that the working copy and the
+   notifications look as if all merges had been done immediately. */
+static svn_error_t *
+flush_text_merges(merge_cmd_baton_t *merge_b,
+                  apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *pending = merge_b->pending_text_merges;
+  svn_client_ctx_t *ctx = merge_b->ctx;
+  svn_error_t *err;
+  int i;
+
+  if (!pending || pending->nelts == 0)
+    return SVN_NO_ERROR;
+
+  err = svn_task__run(merge_b->merge_threads, pending->nelts,
+                      run_text_merge, pending,
+                      finish_text_merge, merge_b,
+                      NULL, NULL,
+                      ctx->cancel_func, ctx->cancel_baton,
+                      scratch_pool);
+
+  /* Release all merges, including those that have been skipped after
+     an error. */
+  for (i = 0; i < pending->nelts; i++)
+    svn_pool_destroy(APR_ARRAY_IDX(pending, i, pending_text_merge_t *)->pool);
+  apr_array_clear(pending);
+
+  return svn_error_trace(err);
+}
+
+/* Queue the pending MERGE into LOCAL_ABSPATH, allocated in POOL, for
+   MERGE_B.  HAS_LOCAL_MODS tells whether the file had local modifications
+   before the merge.  Flush the queue once enough merges have been
+   gathered to keep all threads busy. */
+static svn_error_t *
+queue_text_merge(merge_cmd_baton_t *merge_b,
+                 const char *local_abspath,
+                 svn_boolean_t has_local_mods,
+                 svn_wc__file_merge_t *merge,
+                 apr_pool_t *pool,
+                 apr_pool_t *scratch_pool)
+{
+  pending_text_merge_t *ptm = apr_palloc(pool, sizeof(*ptm));
+
+  /* The diff driver removes the left and right files once we return. */
+  SVN_ERR(svn_wc__file_merge_detach(merge, pool, scratch_pool));
+
+  ptm->local_abspath = apr_pstrdup(pool, local_abspath);
+  ptm->has_local_mods = has_local_mods;
+  ptm->merge = merge;
+  ptm->pool = pool;
+  APR_ARRAY_PUSH(merge_b->pending_text_merges, pending_text_merge_t *) = ptm;
+
+  if (merge_b->pending_text_merges->nelts >= 8 * merge_b->merge_threads)
+    SVN_ERR(flush_text_merges(merge_b, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* An svn_diff_tree_processor_t function.
 
    Called before either merge_file_changed(), merge_file_added(),
@@ -1769,6 +1950,11 @@ merge_file_opened(void **new_file_baton,
   const char *local_abspath = svn_dirent_join(merge_b->target->abspath,
                                               relpath, scratch_pool);
 
+  /* Only changed files may become pending text merges.  Complete those
+     before anything else happens. */
+  if (!left_source || !right_source)
+    SVN_ERR(flush_text_merges(merge_b, scratch_pool));
+
   fb = apr_pcalloc(result_pool, sizeof(*fb));
   fb->tree_conflict_reason = CONFLICT_REASON_NONE;
   fb->tree_conflict_action = svn_wc_conflict_action_edit;
@@ -1858,6 +2044,7 @@ merge_file_opened(void **new_file_baton,
 
           /* ### Similar to directory */
           *skip = TRUE;
+          SVN_ERR(flush_text_merges(merge_b, scratch_pool));
           SVN_ERR(mark_file_edited(merge_b, fb, local_abspath, scratch_pool));
           return SVN_NO_ERROR;
           /* ### /Similar */
@@ -1875,6 +2062,7 @@ merge_file_opened(void **new_file_baton,
 
           /* ### Similar to directory */
           *skip = TRUE;
+          SVN_ERR(flush_text_merges(merge_b, scratch_pool));
           SVN_ERR(mark_file_edited(merge_b, fb, local_abspath, scratch_pool));
           return SVN_NO_ERROR;
           /* ### /Similar */
@@ -2019,13 +2207,17 @@ merge_file_changed(const char *relpath,
                                               relpath, scratch_pool);
   const svn_wc_conflict_version_t *left;
   const svn_wc_conflict_version_t *right;
-  svn_wc_notify_state_t text_state;
   svn_wc_notify_state_t property_state;
 
   SVN_ERR_ASSERT(local_abspath && svn_dirent_is_absolute(local_abspath));
   SVN_ERR_ASSERT(!left_file || svn_dirent_is_absolute(left_file));
   SVN_ERR_ASSERT(!right_file || svn_dirent_is_absolute(right_file));
 
+  /* Unless this may become another pending text merge, complete the
+     pending ones first. */
+  if (fb->shadowed || merge_b->record_only || !left_file)
+    SVN_ERR(flush_text_merges(merge_b, scratch_pool));
+
   SVN_ERR(mark_file_edited(merge_b, fb, local_abspath, scratch_pool));
 
   if (fb->shadowed)
@@ -2048,7 +2240,6 @@ merge_file_changed(const char *relpath,
      fulltexts! */
 
   property_state = svn_wc_notify_state_unchanged;
-  text_state = svn_wc_notify_state_unchanged;
 
   SVN_ERR(prepare_merge_props_changed(&prop_changes, local_abspath,
                                       prop_changes, merge_b,
@@ -2119,50 +2310,78 @@ merge_file_changed(const char *relpath,
       SVN_ERR(svn_wc_text_modified_p2(&has_local_mods, ctx->wc_ctx,
                                       local_abspath, FALSE, scratch_pool));
 
-      /* Do property merge and text merge in one step so that keyword expansion
-         takes into account the new property values. */
-      SVN_ERR(svn_wc_merge5(&content_outcome, &property_state, ctx->wc_ctx,
-                            left_file, right_file, local_abspath,
-                            left_label, right_label, target_label,
-                            left, right,
-                            merge_b->dry_run, merge_b->diff3_cmd,
-                            merge_b->merge_options,
-                            left_props, prop_changes,
-                            NULL, NULL,
-                            ctx->cancel_func,
-                            ctx->cancel_baton,
-                            scratch_pool));
+      if (merge_b->merge_threads > 1)
+        {
+          apr_pool_t *merge_pool
+            = svn_pool_create(merge_b->pending_text_merges->pool);
+          svn_wc__file_merge_t *merge;
+          svn_error_t *err;
+
+          /* Start the merge and queue it if the file contents need to be
+             merged.  Property merge and text merge still happen in one
+             step. */
+          err = svn_wc__file_merge_begin(&merge, ctx->wc_ctx,
+                                         left_file, right_file,
+                                         local_abspath,
+                                         left_label, right_label,
+                                         target_label,
+                                         left, right,
+                                         merge_b->dry_run, merge_b->diff3_cmd,
+                                         merge_b->merge_options,
+                                         left_props, prop_changes, TRUE,
+                                         ctx->cancel_func, ctx->cancel_baton,
+                                         merge_pool, scratch_pool);
+          if (!err && svn_wc__file_merge_pending(merge))
+            return svn_error_trace(queue_text_merge(merge_b, local_abspath,
+                                                    has_local_mods, merge,
+                                                    merge_pool,
+                                                    scratch_pool));
 
-      if (content_outcome == svn_wc_merge_conflict
-          || property_state == svn_wc_notify_state_conflicted)
+          if (!err)
+            err = flush_text_merges(merge_b, scratch_pool);
+          if (!err)
+            err = svn_wc__file_merge_finish(&content_outcome,
+                                            &property_state, merge,
+                                            NULL, NULL,
+                                            ctx->cancel_func,
+                                            ctx->cancel_baton,
+                                            scratch_pool);
+
+          svn_pool_destroy(merge_pool);
+          SVN_ERR(err);
+        }
+      else
         {
-          alloc_and_store_path(&merge_b->conflicted_paths, local_abspath,
-                               merge_b->pool);
+          /* Do property merge and text merge in one step so that keyword
+             expansion takes into account the new property values. */
+          SVN_ERR(svn_wc_merge5(&content_outcome, &property_state,
+                                ctx->wc_ctx,
+                                left_file, right_file, local_abspath,
+                                left_label, right_label, target_label,
+                                left, right,
+                                merge_b->dry_run, merge_b->diff3_cmd,
+                                merge_b->merge_options,
+                                left_props, prop_changes,
+                                NULL, NULL,
+                                ctx->cancel_func,
+                                ctx->cancel_baton,
+                                scratch_pool));
         }
 
-      if (content_outcome == svn_wc_merge_conflict)
-        text_state = svn_wc_notify_state_conflicted;
-      else if (has_local_mods
-               && content_outcome != svn_wc_merge_unchanged)
-        text_state = svn_wc_notify_state_merged;
-      else if (content_outcome == svn_wc_merge_merged)
-        text_state = svn_wc_notify_state_changed;
-      else if (content_outcome == svn_wc_merge_no_merge)
-        text_state = svn_wc_notify_state_missing;
-      else /* merge_outcome == svn_wc_merge_unchanged */
-        text_state = svn_wc_notify_state_unchanged;
+      return svn_error_trace(record_file_merge(merge_b, local_abspath,
+                                               has_local_mods,
+                                               content_outcome,
+                                               property_state,
+                                               scratch_pool));
     }
 
-  if (text_state == svn_wc_notify_state_conflicted
-      || text_state == svn_wc_notify_state_merged
-      || text_state == svn_wc_notify_state_changed
-      || property_state == svn_wc_notify_state_conflicted
+  if (property_state == svn_wc_notify_state_conflicted
       || property_state == svn_wc_notify_state_merged
       || property_state == svn_wc_notify_state_changed)
     {
       SVN_ERR(record_update_update(merge_b, local_abspath, svn_node_file,
-                                   text_state, property_state,
-                                   scratch_pool));
+                                   svn_wc_notify_state_unchanged,
+                                   property_state, scratch_pool));
     }
 
   return SVN_NO_ERROR;
@@ -2553,6 +2772,8 @@ merge_dir_opened(void **new_dir_baton,
   const char *local_abspath = svn_dirent_join(merge_b->target->abspath,
                                               relpath, scratch_pool);
 
+  SVN_ERR(flush_text_merges(merge_b, scratch_pool));
+
   db = apr_pcalloc(result_pool, sizeof(*db));
   db->pool = result_pool;
   db->tree_conflict_reason = CONFLICT_REASON_NONE;
@@ -2950,6 +3171,8 @@ merge_dir_changed(const char *relpath,
   const char *local_abspath = svn_dirent_join(merge_b->target->abspath,
                                               relpath, scratch_pool);
 
+  SVN_ERR(flush_text_merges(merge_b, scratch_pool));
+
   SVN_ERR(handle_pending_notifications(merge_b, db, scratch_pool));
 
   SVN_ERR(mark_dir_edited(merge_b, db, local_abspath, scratch_pool));
@@ -3036,6 +3259,8 @@ merge_dir_added(const char *relpath,
   const char *local_abspath = svn_dirent_join(merge_b->target->abspath,
                                               relpath, scratch_pool);
 
+  SVN_ERR(flush_text_merges(merge_b, scratch_pool));
+
   /* For consistency; usually a no-op from _dir_added() */
   SVN_ERR(handle_pending_notifications(merge_b, db, scratch_pool));
   SVN_ERR(mark_dir_edited(merge_b, db, local_abspath, scratch_pool));
@@ -3205,6 +3430,8 @@ merge_dir_deleted(const char *relpath,
   svn_boolean_t same;
   apr_hash_t *working_props;
 
+  SVN_ERR(flush_text_merges(merge_b, scratch_pool));
+
   SVN_ERR(handle_pending_notifications(merge_b, db, scratch_pool));
   SVN_ERR(mark_dir_edited(merge_b, db, local_abspath, scratch_pool));
 
@@ -3373,6 +3600,8 @@ merge_dir_closed(const char *relpath,
   merge_cmd_baton_t *merge_b = processor->baton;
   struct merge_dir_baton_t *db = dir_baton;
 
+  SVN_ERR(flush_text_merges(merge_b, scratch_pool));
+
   SVN_ERR(handle_pending_notifications(merge_b, db, scratch_pool));
 
   return SVN_NO_ERROR;
@@ -3403,6 +3632,8 @@ merge_node_absent(const char *relpath,
   const char *local_abspath = svn_dirent_join(merge_b->target->abspath,
                                               relpath, scratch_pool);
 
+  SVN_ERR(flush_text_merges(merge_b, scratch_pool));
+
   SVN_ERR(record_skip(merge_b, local_abspath, svn_node_unknown,
                       svn_wc_notify_skip, svn_wc_notify_state_missing,
                       db, scratch_pool));
@@ -5921,6 +6152,7 @@ drive_merge_report_editor(const char *target_abspath,
       svn_pool_destroy(iterpool);
     }
   SVN_ERR(reporter->finish_report(report_baton, scratch_pool));
+  SVN_ERR(flush_text_merges(merge_b, scratch_pool));
 
   /* Point the merge baton's RA sessions back where they were. */
   SVN_ERR(svn_ra_reparent(merge_b->ra_session1, old_sess1_url, scratch_pool));
@@ -7774,6 +8006,7 @@ do_file_merge(svn_mergeinfo_catalog_t result_catalog,
                                               file_baton,
                                               processor,
                                               iterpool));
+              SVN_ERR(flush_text_merges(merge_b, iterpool));
             }
 
           if (is_path_conflicted_by_merge(merge_b))
@@ -9833,6 +10066,7 @@ do_merge(apr_hash_t **modified_subtrees,
   svn_config_t *cfg;
   const char *diff3_cmd;
   const char *preserved_exts_str;
+  apr_int64_t merge_threads;
   int i;
   svn_boolean_t checked_mergeinfo_capability = FALSE;
   svn_ra_session_t *ra_session1 = NULL, *ra_session2 = NULL;
@@ -9920,6 +10154,13 @@ do_merge(apr_hash_t **modified_subtrees,
 
   merge_cmd_baton.use_sleep = use_sleep;
 
+  SVN_ERR(svn_config_get_int64(cfg, &merge_threads,
+                               SVN_CONFIG_SECTION_MISCELLANY,
+                               SVN_CONFIG_OPTION_MERGE_THREADS, 1));
+  merge_cmd_baton.merge_threads = (int)MAX(1, MIN(merge_threads, 64));
+  merge_cmd_baton.pending_text_merges
+    = apr_array_make(scratch_pool, 0, sizeof(pending_text_merge_t *));
+
   /* Do we already know the specific subtrees with mergeinfo we want
      to record-only mergeinfo on? */
   if (record_only && record_only_paths)
@@ -11238,7 +11479,7 @@ find_unmerged_mergeinfo(svn_mergeinfo_catalog_t *unmerged_to_source_catalog,
                     &source_mergeinfo, source_ra_session,
                     source_pathrev->url, source_pathrev->rev,
                     svn_mergeinfo_inherited, FALSE /*squelch_incapable*/,
-                    iterpool));
+                    ctx, iterpool));
           if (!source_mergeinfo)
             source_mergeinfo = apr_hash_make(iterpool);
         }
@@ -11470,7 +11711,7 @@ calculate_left_hand_side(svn_client__pathrev_t **left_p,
             &mergeinfo_catalog, source_ra_session,
             source_loc->url, source_loc->rev,
             svn_mergeinfo_inherited, FALSE /* squelch_incapable */,
-            TRUE /* include_descendants */, iterpool, iterpool));
+            TRUE /* include_descendants */, ctx, iterpool, iterpool));
 
   if (!mergeinfo_catalog)
     mergeinfo_catalog = apr_hash_make(iterpool);
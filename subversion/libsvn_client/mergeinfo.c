@@ -464,6 +464,7 @@ svn_client__get_repos_mergeinfo(svn_mergeinfo_t *target_mergeinfo,
                                 svn_revnum_t rev,
                                 svn_mergeinfo_inheritance_t inherit,
                                 svn_boolean_t squelch_incapable,
+                                svn_client_ctx_t *ctx,
                                 apr_pool_t *pool)
 {
   svn_mergeinfo_catalog_t tgt_mergeinfo_cat;
@@ -474,7 +475,7 @@ svn_client__get_repos_mergeinfo(svn_mergeinfo_t *target_mergeinfo,
                                                   ra_session,
                                                   url, rev, inherit,
                                                   squelch_incapable, FALSE,
-                                                  pool, pool));
+                                                  ctx, pool, pool));
 
   if (tgt_mergeinfo_cat && apr_hash_count(tgt_mergeinfo_cat))
     {
@@ -489,6 +490,17 @@ svn_client__get_repos_mergeinfo(svn_mergeinfo_t *target_mergeinfo,
   return SVN_NO_ERROR;
 }
 
+/* The most mergeinfo catalogs a client context remembers before it
+   starts over. */
+#define MERGEINFO_CACHE_SIZE 1000
+
+/* What svn_client__get_repos_mergeinfo_catalog() found for some
+   location, in the mergeinfo cache of a client context. */
+typedef struct mergeinfo_cache_entry_t
+{
+  svn_mergeinfo_catalog_t catalog;  /* may be NULL */
+} mergeinfo_cache_entry_t;
+
 svn_error_t *
 svn_client__get_repos_mergeinfo_catalog(svn_mergeinfo_catalog_t *mergeinfo_cat,
                                         svn_ra_session_t *ra_session,
@@ -497,6 +509,7 @@ svn_client__get_repos_mergeinfo_catalog(svn_mergeinfo_catalog_t *mergeinfo_cat,
                                         svn_mergeinfo_inheritance_t inherit,
                                         svn_boolean_t squelch_incapable,
                                         svn_boolean_t include_descendants,
+                                        svn_client_ctx_t *ctx,
                                         apr_pool_t *result_pool,
                                         apr_pool_t *scratch_pool)
 {
@@ -505,6 +518,30 @@ svn_client__get_repos_mergeinfo_catalog(svn_mergeinfo_catalog_t *mergeinfo_cat,
   apr_array_header_t *rel_paths = apr_array_make(scratch_pool, 1,
                                                  sizeof(const char *));
   const char *old_session_url;
+  svn_client__private_ctx_t *private_ctx = svn_client__get_private_ctx(ctx);
+  mergeinfo_cache_entry_t *entry;
+  const char *cache_key = NULL;
+
+  /* The mergeinfo of a revision never changes, so what was fetched
+     before can be used again, unless it was asked for HEAD. */
+  if (SVN_IS_VALID_REVNUM(rev))
+    {
+      const char *uuid;
+
+      SVN_ERR(svn_ra_get_uuid2(ra_session, &uuid, scratch_pool));
+      cache_key = apr_psprintf(scratch_pool, "%s:%ld:%d:%d:%s",
+                               uuid, rev, inherit, include_descendants,
+                               url);
+      entry = svn_hash_gets(private_ctx->mergeinfo_cache, cache_key);
+      if (entry)
+        {
+          *mergeinfo_cat = entry->catalog
+                         ? svn_mergeinfo_catalog_dup(entry->catalog,
+                                                     result_pool)
+                         : NULL;
+          return SVN_NO_ERROR;
+        }
+    }
 
   APR_ARRAY_PUSH(rel_paths, const char *) = "";
 
@@ -547,6 +584,26 @@ svn_client__get_repos_mergeinfo_catalog(svn_mergeinfo_catalog_t *mergeinfo_cat,
                                                      result_pool,
                                                      scratch_pool));
     }
+
+  if (cache_key)
+    {
+      apr_pool_t *cache_pool = private_ctx->mergeinfo_cache_pool;
+
+      if (apr_hash_count(private_ctx->mergeinfo_cache)
+          >= MERGEINFO_CACHE_SIZE)
+        {
+          svn_pool_clear(cache_pool);
+          private_ctx->mergeinfo_cache = apr_hash_make(cache_pool);
+        }
+
+      entry = apr_palloc(cache_pool, sizeof(*entry));
+      entry->catalog = *mergeinfo_cat
+                     ? svn_mergeinfo_catalog_dup(*mergeinfo_cat, cache_pool)
+                     : NULL;
+      svn_hash_sets(private_ctx->mergeinfo_cache,
+                    apr_pstrdup(cache_pool, cache_key), entry);
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -693,7 +750,7 @@ svn_client__get_wc_or_repos_mergeinfo_catalog(
                         &target_mergeinfo_cat_repos, ra_session,
                         url, target_rev, inherit,
                         TRUE, include_descendants,
-                        result_pool, scratch_pool));
+                        ctx, result_pool, scratch_pool));
 
               if (target_mergeinfo_cat_repos
                   && svn_hash_gets(target_mergeinfo_cat_repos, repos_relpath))
@@ -1086,7 +1143,7 @@ get_mergeinfo(svn_mergeinfo_catalog_t *mergeinfo_catalog,
       SVN_ERR(svn_client__get_repos_mergeinfo_catalog(
         mergeinfo_catalog, ra_session, peg_loc->url, peg_loc->rev,
         svn_mergeinfo_inherited, FALSE, include_descendants,
-        result_pool, scratch_pool));
+        ctx, result_pool, scratch_pool));
     }
   else /* ! svn_path_is_url() */
     {
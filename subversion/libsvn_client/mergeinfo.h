@@ -188,7 +188,8 @@ svn_client__get_wc_mergeinfo_catalog(svn_mergeinfo_catalog_t *mergeinfo_cat,
    SVN_ERR_UNSUPPORTED_FEATURE error.
 
    RA_SESSION is an open RA session to the repository in which URL lives;
-   it may be temporarily reparented by this function.
+   it may be temporarily reparented by this function.  CTX is used as by
+   svn_client__get_repos_mergeinfo_catalog().
 */
 svn_error_t *
 svn_client__get_repos_mergeinfo(svn_mergeinfo_t *target_mergeinfo,
@@ -197,6 +198,7 @@ svn_client__get_repos_mergeinfo(svn_mergeinfo_t *target_mergeinfo,
                                 svn_revnum_t rev,
                                 svn_mergeinfo_inheritance_t inherit,
                                 svn_boolean_t squelch_incapable,
+                                svn_client_ctx_t *ctx,
                                 apr_pool_t *pool);
 
 /* If INCLUDE_DESCENDANTS is FALSE, behave exactly like
@@ -208,7 +210,10 @@ svn_client__get_repos_mergeinfo(svn_mergeinfo_t *target_mergeinfo,
    with explicit mergeinfo are also included in MERGEINFO_CAT.  The
    keys for the subtree mergeinfo are the repository root-relative
    paths of the subtrees.  If no mergeinfo is found, then
-   *TARGET_MERGEINFO_CAT is set to NULL. */
+   *TARGET_MERGEINFO_CAT is set to NULL.
+
+   Mergeinfo fetched for a valid REV is remembered in CTX, so that asking
+   for it again doesn't need a round trip to the repository. */
 svn_error_t *
 svn_client__get_repos_mergeinfo_catalog(svn_mergeinfo_catalog_t *mergeinfo_cat,
                                         svn_ra_session_t *ra_session,
@@ -217,6 +222,7 @@ svn_client__get_repos_mergeinfo_catalog(svn_mergeinfo_catalog_t *mergeinfo_cat,
                                         svn_mergeinfo_inheritance_t inherit,
                                         svn_boolean_t squelch_incapable,
                                         svn_boolean_t include_descendants,
+                                        svn_client_ctx_t *ctx,
                                         apr_pool_t *result_pool,
                                         apr_pool_t *scratch_pool);
 
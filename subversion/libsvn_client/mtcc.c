@@ -56,6 +56,8 @@ typedef struct mtcc_op_t
   mtcc_kind_t kind;                 /* editor operation */
 
   apr_array_header_t *children;     /* List of mtcc_op_t * */
+  apr_hash_t *child_index;          /* const char *name -> mtcc_op_t *,
+                                       the last child of that name */
 
   const char *src_relpath;              /* For ADD_DIR, ADD_FILE */
   svn_revnum_t src_rev;                 /* For ADD_DIR, ADD_FILE */
@@ -89,8 +91,27 @@ struct svn_client__mtcc_t
   svn_client_ctx_t *ctx;
 
   mtcc_op_t *root_op;
+
+  /* Node kinds known to exist in the repository, keyed by "REV:RELPATH"
+     relative to the session url. Maps to svn_node_kind_t *. */
+  apr_hash_t *repos_kinds;
+
+  /* Lookup statistics per repository directory, with the same keys as
+     REPOS_KINDS. Maps to repos_dir_t *. */
+  apr_hash_t *repos_dirs;
 };
 
+/* Lookup statistics of a repository directory */
+typedef struct repos_dir_t
+{
+  int lookups;                      /* Children checked one at a time */
+  svn_boolean_t listed;             /* All children are in REPOS_KINDS */
+} repos_dir_t;
+
+/* After this many children of a directory have been checked one by one,
+   fetch the kinds of all its children with a single request. */
+#define LIST_DIR_THRESHOLD 16
+
 static mtcc_op_t *
 mtcc_op_create(const char *name,
                svn_boolean_t add,
@@ -108,13 +129,33 @@ mtcc_op_create(const char *name,
     op->kind = directory ? OP_OPEN_DIR : OP_OPEN_FILE;
 
   if (directory)
-    op->children = apr_array_make(result_pool, 4, sizeof(mtcc_op_t *));
+    {
+      op->children = apr_array_make(result_pool, 4, sizeof(mtcc_op_t *));
+      op->child_index = apr_hash_make(result_pool);
+    }
 
   op->src_rev = SVN_INVALID_REVNUM;
 
   return op;
 }
 
+/* Add CHILD as the last child of OP */
+static void
+mtcc_op_add_child(mtcc_op_t *op,
+                  mtcc_op_t *child)
+{
+  APR_ARRAY_PUSH(op->children, mtcc_op_t *) = child;
+  svn_hash_sets(op->child_index, child->name, child);
+}
+
+/* Remove all children of OP, making it a leaf */
+static void
+mtcc_op_clear_children(mtcc_op_t *op)
+{
+  op->children = NULL;
+  op->child_index = NULL;
+}
+
 static svn_error_t *
 mtcc_op_find(mtcc_op_t **op,
              svn_boolean_t *created,
@@ -128,7 +169,7 @@ mtcc_op_find(mtcc_op_t **op,
 {
   const char *name;
   const char *child;
-  int i;
+  mtcc_op_t *cop;
 
   assert(svn_relpath_is_canonical(relpath));
   if (created)
@@ -168,20 +209,16 @@ mtcc_op_find(mtcc_op_t **op,
                                  name, base_op->name);
     }
 
-  for (i = base_op->children->nelts-1; i >= 0 ; i--)
-    {
-      mtcc_op_t *cop;
+  /* Only the last child of a given name can be anything but a delete, as
+     a node must be deleted before it can be added again. */
+  cop = svn_hash_gets(base_op->child_index, name);
 
-      cop = APR_ARRAY_IDX(base_op->children, i, mtcc_op_t *);
-
-      if (! strcmp(cop->name, name)
-          && (find_deletes || cop->kind != OP_DELETE))
-        {
-          return svn_error_trace(
-                        mtcc_op_find(op, created, child ? child : "", cop,
-                                     find_existing, find_deletes, create_file,
-                                     result_pool, scratch_pool));
-        }
+  if (cop && (find_deletes || cop->kind != OP_DELETE))
+    {
+      return svn_error_trace(
+                    mtcc_op_find(op, created, child ? child : "", cop,
+                                 find_existing, find_deletes, create_file,
+                                 result_pool, scratch_pool));
     }
 
   if (!created)
@@ -191,11 +228,9 @@ mtcc_op_find(mtcc_op_t **op,
     }
 
   {
-    mtcc_op_t *cop;
-
     cop = mtcc_op_create(name, FALSE, child || !create_file, result_pool);
 
-    APR_ARRAY_PUSH(base_op->children, mtcc_op_t *) = cop;
+    mtcc_op_add_child(base_op, cop);
 
     if (!child)
       {
@@ -244,33 +279,24 @@ get_origin(svn_boolean_t *done,
   else
     name = relpath;
 
-  if (op->children && op->children->nelts)
+  if (op->child_index)
     {
-      int i;
+      mtcc_op_t *cop = svn_hash_gets(op->child_index, name);
 
-      for (i = op->children->nelts-1; i >= 0; i--)
+      if (cop)
         {
-           mtcc_op_t *cop;
-
-           cop = APR_ARRAY_IDX(op->children, i, mtcc_op_t *);
-
-           if (! strcmp(cop->name, name))
+          if (cop->kind == OP_DELETE)
             {
-              if (cop->kind == OP_DELETE)
-                {
-                  *done = TRUE;
-                  return SVN_NO_ERROR;
-                }
-
-              SVN_ERR(get_origin(done, origin_relpath, rev,
-                                 cop, child ? child : "",
-                                 result_pool, scratch_pool));
+              *done = TRUE;
+              return SVN_NO_ERROR;
+            }
 
-              if (*origin_relpath || *done)
-                return SVN_NO_ERROR;
+          SVN_ERR(get_origin(done, origin_relpath, rev,
+                             cop, child ? child : "",
+                             result_pool, scratch_pool));
 
-              break;
-            }
+          if (*origin_relpath || *done)
+            return SVN_NO_ERROR;
         }
     }
 
@@ -323,6 +349,130 @@ mtcc_get_origin(const char **origin_relpath,
   return SVN_NO_ERROR;
 }
 
+/* Return the key for RELPATH@REV in the repository kind caches of MTCC */
+static const char *
+repos_key(const char *relpath,
+          svn_revnum_t rev,
+          apr_pool_t *result_pool)
+{
+  return apr_psprintf(result_pool, "%ld:%s", rev, relpath);
+}
+
+/* Fetch the kinds of all children of the directory PARENT_RELPATH@REV
+   with a single request and store them in MTCC->REPOS_KINDS. */
+static svn_error_t *
+list_repos_dir(repos_dir_t *dir,
+               const char *parent_relpath,
+               svn_revnum_t rev,
+               svn_client__mtcc_t *mtcc,
+               apr_pool_t *scratch_pool)
+{
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+  svn_node_kind_t *kind;
+
+  SVN_ERR(svn_ra_get_dir2(mtcc->ra_session, &dirents, NULL, NULL,
+                          parent_relpath, rev, SVN_DIRENT_KIND,
+                          scratch_pool));
+
+  for (hi = apr_hash_first(scratch_pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const svn_dirent_t *dirent = apr_hash_this_val(hi);
+
+      kind = apr_palloc(mtcc->pool, sizeof(*kind));
+      *kind = dirent->kind;
+      svn_hash_sets(mtcc->repos_kinds,
+                    repos_key(svn_relpath_join(parent_relpath, name,
+                                               scratch_pool),
+                              rev, mtcc->pool),
+                    kind);
+    }
+
+  dir->listed = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *KIND to the kind of RELPATH@REV in the repository, like
+   svn_ra_check_path() would, but remember the results in MTCC.
+
+   Scripted commits tend to touch many nodes in the same directory, so
+   once enough of those were checked individually, the whole directory
+   is listed instead. */
+static svn_error_t *
+mtcc_repos_check_path(svn_node_kind_t *kind,
+                      const char *relpath,
+                      svn_revnum_t rev,
+                      svn_client__mtcc_t *mtcc,
+                      apr_pool_t *scratch_pool)
+{
+  const char *key = repos_key(relpath, rev, scratch_pool);
+  svn_node_kind_t *cached_kind = svn_hash_gets(mtcc->repos_kinds, key);
+
+  if (cached_kind)
+    {
+      *kind = *cached_kind;
+      return SVN_NO_ERROR;
+    }
+
+  if (*relpath)
+    {
+      const char *parent_relpath = svn_relpath_dirname(relpath, scratch_pool);
+      const char *parent_key = repos_key(parent_relpath, rev, scratch_pool);
+      svn_node_kind_t *parent_kind = svn_hash_gets(mtcc->repos_kinds,
+                                                   parent_key);
+      repos_dir_t *dir = svn_hash_gets(mtcc->repos_dirs, parent_key);
+
+      if (parent_kind && *parent_kind != svn_node_dir)
+        {
+          *kind = svn_node_none;
+          return SVN_NO_ERROR;
+        }
+
+      if (!dir)
+        {
+          dir = apr_pcalloc(mtcc->pool, sizeof(*dir));
+          svn_hash_sets(mtcc->repos_dirs,
+                        apr_pstrdup(mtcc->pool, parent_key), dir);
+        }
+
+      if (!dir->listed && ++dir->lookups >= LIST_DIR_THRESHOLD)
+        {
+          svn_node_kind_t parent_node_kind;
+
+          SVN_ERR(mtcc_repos_check_path(&parent_node_kind, parent_relpath,
+                                        rev, mtcc, scratch_pool));
+
+          if (parent_node_kind != svn_node_dir)
+            {
+              *kind = svn_node_none;
+              return SVN_NO_ERROR;
+            }
+
+          SVN_ERR(list_repos_dir(dir, parent_relpath, rev, mtcc,
+                                 scratch_pool));
+        }
+
+      if (dir->listed)
+        {
+          cached_kind = svn_hash_gets(mtcc->repos_kinds, key);
+          *kind = cached_kind ? *cached_kind : svn_node_none;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  SVN_ERR(svn_ra_check_path(mtcc->ra_session, relpath, rev, kind,
+                            scratch_pool));
+
+  cached_kind = apr_palloc(mtcc->pool, sizeof(*cached_kind));
+  *cached_kind = *kind;
+  svn_hash_sets(mtcc->repos_kinds, apr_pstrdup(mtcc->pool, key),
+                cached_kind);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_client__mtcc_create(svn_client__mtcc_t **mtcc,
                         const char *anchor_url,
@@ -339,6 +489,8 @@ svn_client__mtcc_create(svn_client__mtcc_t **mtcc,
   (*mtcc)->pool = mtcc_pool;
 
   (*mtcc)->root_op = mtcc_op_create(NULL, FALSE, TRUE, mtcc_pool);
+  (*mtcc)->repos_kinds = apr_hash_make(mtcc_pool);
+  (*mtcc)->repos_dirs = apr_hash_make(mtcc_pool);
 
   (*mtcc)->ctx = ctx;
 
@@ -417,6 +569,10 @@ mtcc_reparent(const char *new_anchor_url,
 
   SVN_ERR(svn_ra_reparent(mtcc->ra_session, new_anchor_url, scratch_pool));
 
+  /* Cached repository kinds are relative to the old session url */
+  apr_hash_clear(mtcc->repos_kinds);
+  apr_hash_clear(mtcc->repos_dirs);
+
   /* Create directory open operations for new ancestors */
   while (*up)
     {
@@ -427,7 +583,7 @@ mtcc_reparent(const char *new_anchor_url,
 
       root_op = mtcc_op_create(NULL, FALSE, TRUE, mtcc->pool);
 
-      APR_ARRAY_PUSH(root_op->children, mtcc_op_t *) = mtcc->root_op;
+      mtcc_op_add_child(root_op, mtcc->root_op);
 
       mtcc->root_op = root_op;
     }
@@ -541,8 +697,8 @@ svn_client__mtcc_add_copy(const char *src_relpath,
   SVN_ERR(mtcc_verify_create(mtcc, dst_relpath, scratch_pool));
 
   /* Subversion requires the kind of a copy */
-  SVN_ERR(svn_ra_check_path(mtcc->ra_session, src_relpath, revision, &kind,
-                            scratch_pool));
+  SVN_ERR(mtcc_repos_check_path(&kind, src_relpath, revision, mtcc,
+                                scratch_pool));
 
   if (kind != svn_node_dir && kind != svn_node_file)
     {
@@ -655,7 +811,7 @@ mtcc_add_delete(const char *relpath,
     }
 
   op->kind = OP_DELETE;
-  op->children = NULL;
+  mtcc_op_clear_children(op);
   op->prop_mods = NULL;
 
   return SVN_NO_ERROR;
@@ -1001,14 +1157,14 @@ svn_client__mtcc_check_path(svn_node_kind_t *kind,
       && !mtcc->root_op->performed_stat)
     {
       /* We know nothing about the root. Perhaps it is a file? */
-      SVN_ERR(svn_ra_check_path(mtcc->ra_session, "", mtcc->base_revision,
-                                kind, scratch_pool));
+      SVN_ERR(mtcc_repos_check_path(kind, "", mtcc->base_revision, mtcc,
+                                    scratch_pool));
 
       mtcc->root_op->performed_stat = TRUE;
       if (*kind == svn_node_file)
         {
           mtcc->root_op->kind = OP_OPEN_FILE;
-          mtcc->root_op->children = NULL;
+          mtcc_op_clear_children(mtcc->root_op);
         }
       return SVN_NO_ERROR;
     }
@@ -1025,8 +1181,8 @@ svn_client__mtcc_check_path(svn_node_kind_t *kind,
       if (!origin_relpath)
         *kind = svn_node_none;
       else
-        SVN_ERR(svn_ra_check_path(mtcc->ra_session, origin_relpath,
-                                  origin_rev, kind, scratch_pool));
+        SVN_ERR(mtcc_repos_check_path(kind, origin_relpath, origin_rev,
+                                      mtcc, scratch_pool));
 
       if (op && *kind == svn_node_dir)
         {
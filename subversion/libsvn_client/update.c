@@ -37,9 +37,12 @@
 #include "svn_path.h"
 #include "svn_pools.h"
 #include "svn_io.h"
+#include "svn_sorts.h"
 #include "client.h"
 
 #include "svn_private_config.h"
+#include "private/svn_auth_private.h"
+#include "private/svn_task.h"
 #include "private/svn_wc_private.h"
 
 /* Implements svn_wc_dirents_func_t for update and switch handling. Assumes
@@ -717,6 +720,527 @@ svn_client__update_internal(svn_revnum_t *result_rev,
 }
 
 
+/* Set *THREAD_COUNT to the number of targets that may be updated
+   concurrently, as configured in CTX. */
+static svn_error_t *
+get_update_threads(int *thread_count,
+                   svn_client_ctx_t *ctx)
+{
+  svn_config_t *cfg = ctx->config
+                       ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+                       : NULL;
+  apr_int64_t update_threads;
+
+  SVN_ERR(svn_config_get_int64(cfg, &update_threads,
+                               SVN_CONFIG_SECTION_MISCELLANY,
+                               SVN_CONFIG_OPTION_UPDATE_THREADS, 1));
+  *thread_count = (int)MAX(1, MIN(update_threads, 64));
+
+  return SVN_NO_ERROR;
+}
+
+/* Update the target PATH of svn_client_update4() like
+   svn_client__update_internal() does, with the arguments of
+   svn_client_update4().  Set *RESULT_REV to the revision it was updated
+   to, or to SVN_INVALID_REVNUM if it was skipped because it is not
+   versioned.  Set *FOUND_VALID_TARGET if it was not skipped.  */
+static svn_error_t *
+update_target(svn_revnum_t *result_rev,
+              svn_boolean_t *timestamp_sleep,
+              svn_boolean_t *found_valid_target,
+              const char *path,
+              const svn_opt_revision_t *revision,
+              svn_depth_t depth,
+              svn_boolean_t depth_is_sticky,
+              svn_boolean_t ignore_externals,
+              svn_boolean_t allow_unver_obstructions,
+              svn_boolean_t adds_as_modification,
+              svn_boolean_t make_parents,
+              svn_client_ctx_t *ctx,
+              apr_pool_t *scratch_pool)
+{
+  const char *local_abspath;
+  svn_error_t *err;
+
+  if (ctx->cancel_func)
+    SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
+
+  SVN_ERR(svn_dirent_get_absolute(&local_abspath, path, scratch_pool));
+  err = svn_client__update_internal(result_rev, timestamp_sleep,
+                                    local_abspath,
+                                    revision, depth, depth_is_sticky,
+                                    ignore_externals,
+                                    allow_unver_obstructions,
+                                    adds_as_modification,
+                                    make_parents,
+                                    FALSE, NULL, ctx,
+                                    scratch_pool);
+
+  if (err)
+    {
+      if (err->apr_err != SVN_ERR_WC_NOT_WORKING_COPY)
+        return svn_error_trace(err);
+
+      svn_error_clear(err);
+
+      /* SVN_ERR_WC_NOT_WORKING_COPY: it's not versioned */
+
+      *result_rev = SVN_INVALID_REVNUM;
+      if (ctx->notify_func2)
+        {
+          svn_wc_notify_t *notify;
+          notify = svn_wc_create_notify(path,
+                                        svn_wc_notify_skip,
+                                        scratch_pool);
+          ctx->notify_func2(ctx->notify_baton2, notify, scratch_pool);
+        }
+    }
+  else
+    *found_valid_target = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* A target of svn_client_update4() when updating targets concurrently. */
+typedef struct update_job_t
+{
+  /* The target as given and as absolute path. */
+  const char *path;
+  const char *local_abspath;
+
+  /* The revision to update to, HEAD resolved to the revision shared by
+     all targets in the same repository, if possible. */
+  svn_opt_revision_t revision;
+
+  /* Whether the target may be updated by a worker thread: a versioned
+     directory that neither contains nor is contained in another
+     target, so that it can be locked and updated on its own. */
+  svn_boolean_t concurrent;
+
+  /* Whether the caller still has to update the target, because it was
+     not a candidate or the worker failed. */
+  svn_boolean_t deferred;
+
+  /* The revision the target was updated to. */
+  svn_revnum_t result_rev;
+} update_job_t;
+
+/* The outcome of updating an update_job_t in a worker thread. */
+typedef struct update_result_t
+{
+  /* The notifications sent by the worker, svn_wc_notify_t *, in POOL. */
+  apr_array_header_t *notifications;
+
+  /* The conflicts raised by the update, for the caller to resolve.
+     const char *local_abspath -> "" */
+  apr_hash_t *conflicted_paths;
+
+  /* The revision the target was updated to. */
+  svn_revnum_t result_rev;
+
+  /* Whether the worker set file timestamps. */
+  svn_boolean_t timestamp_sleep;
+
+  /* Whether the caller still has to update the target. */
+  svn_boolean_t deferred;
+
+  /* The pool of this result. */
+  apr_pool_t *pool;
+} update_result_t;
+
+/* The per-thread context of update workers: a client context of its own,
+   with the RA session that it reuses for all targets it updates. */
+typedef struct update_thread_t
+{
+  svn_client_ctx_t *ctx;
+  svn_ra_session_t *ra_session;
+  apr_pool_t *pool;
+} update_thread_t;
+
+/* Baton for the callbacks of update_targets_concurrently(). */
+typedef struct update_jobs_baton_t
+{
+  /* The update_job_t * to handle. */
+  apr_array_header_t *jobs;
+
+  /* The configuration and authentication that each worker copies,
+     read-only while the workers run. */
+  apr_hash_t *config;
+  svn_auth_baton_t *auth_baton;
+
+  /* The arguments of svn_client_update4(). */
+  svn_depth_t depth;
+  svn_boolean_t depth_is_sticky;
+  svn_boolean_t ignore_externals;
+  svn_boolean_t allow_unver_obstructions;
+  svn_boolean_t adds_as_modification;
+  svn_boolean_t *timestamp_sleep;
+  svn_boolean_t *found_valid_target;
+  svn_client_ctx_t *ctx;
+} update_jobs_baton_t;
+
+/* Implements svn_wc_notify_func2_t, remembering NOTIFY in the
+   update_result_t BATON. */
+static void
+buffer_notification(void *baton,
+                    const svn_wc_notify_t *notify,
+                    apr_pool_t *pool)
+{
+  update_result_t *ur = baton;
+
+  APR_ARRAY_PUSH(ur->notifications, svn_wc_notify_t *)
+    = svn_wc_dup_notify(notify, ur->pool);
+}
+
+/* Implements svn_task__thread_context_constructor_t, setting up an
+   update_thread_t as described by the update_jobs_baton_t
+   CONTEXT_BATON. */
+static svn_error_t *
+make_update_thread(void **thread_context,
+                   void *context_baton,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  update_jobs_baton_t *jb = context_baton;
+  update_thread_t *thread = apr_pcalloc(result_pool, sizeof(*thread));
+  apr_hash_t *config = NULL;
+  svn_client_ctx_t *ctx;
+
+  if (jb->config)
+    SVN_ERR(svn_config_copy_config(&config, jb->config, result_pool));
+
+  SVN_ERR(svn_client_create_context2(&ctx, config, result_pool));
+  if (jb->auth_baton)
+    svn_auth__copy_baton(&ctx->auth_baton, jb->auth_baton, result_pool);
+  ctx->notify_func2 = buffer_notification;
+  ctx->client_name = jb->ctx->client_name;
+  ctx->mimetypes_map = jb->ctx->mimetypes_map;
+  ctx->check_tunnel_func = jb->ctx->check_tunnel_func;
+  ctx->open_tunnel_func = jb->ctx->open_tunnel_func;
+  ctx->tunnel_baton = jb->ctx->tunnel_baton;
+
+  thread->ctx = ctx;
+  thread->pool = result_pool;
+  *thread_context = thread;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t, updating the update_job_t with the
+   given INDEX in the update_jobs_baton_t PROCESS_BATON with the
+   update_thread_t THREAD_CONTEXT. */
+static svn_error_t *
+update_job(void **result,
+           int index,
+           void *process_baton,
+           void *thread_context,
+           svn_cancel_func_t cancel_func,
+           void *cancel_baton,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  update_jobs_baton_t *jb = process_baton;
+  const update_job_t *job = APR_ARRAY_IDX(jb->jobs, index, update_job_t *);
+  update_thread_t *thread = thread_context;
+  svn_client_ctx_t *ctx = thread->ctx;
+  update_result_t *ur = apr_pcalloc(result_pool, sizeof(*ur));
+  const char *lockroot_abspath;
+  svn_error_t *err;
+
+  *result = ur;
+  ur->pool = result_pool;
+  ur->notifications = apr_array_make(result_pool, 16,
+                                     sizeof(svn_wc_notify_t *));
+  ur->conflicted_paths = apr_hash_make(result_pool);
+  ur->deferred = TRUE;
+  if (!job->concurrent)
+    return SVN_NO_ERROR;
+
+  ctx->notify_baton2 = ur;
+  ctx->cancel_func = cancel_func;
+  ctx->cancel_baton = cancel_baton;
+
+  /* Lock only the target itself, which then also is the anchor of the
+     update, so that the other targets can be updated meanwhile. */
+  err = svn_wc__acquire_write_lock(&lockroot_abspath, ctx->wc_ctx,
+                                   job->local_abspath,
+                                   FALSE /* lock_anchor */,
+                                   scratch_pool, scratch_pool);
+  if (!err)
+    {
+      err = update_internal(&ur->result_rev, &ur->timestamp_sleep,
+                            ur->conflicted_paths, &thread->ra_session,
+                            job->local_abspath, lockroot_abspath,
+                            &job->revision, jb->depth, jb->depth_is_sticky,
+                            jb->ignore_externals,
+                            jb->allow_unver_obstructions,
+                            jb->adds_as_modification,
+                            TRUE, ctx, thread->pool, scratch_pool);
+      err = svn_error_compose_create(
+              err,
+              svn_wc__release_write_lock(ctx->wc_ctx, lockroot_abspath,
+                                         scratch_pool));
+    }
+
+  if (err && err->apr_err == SVN_ERR_CANCELLED)
+    return svn_error_trace(err);
+
+  /* Everything else, including prompting for credentials, is left to the
+     caller, which updates the target again.  The session may be
+     unusable now. */
+  if (err)
+    {
+      svn_error_clear(err);
+      apr_array_clear(ur->notifications);
+      thread->ra_session = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  ur->deferred = FALSE;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t, sending the notifications in the
+   update_result_t RESULT for the update_job_t with the given INDEX and
+   resolving its conflicts, as described by the update_jobs_baton_t
+   OUTPUT_BATON. */
+static svn_error_t *
+finish_update_job(void *result,
+                  int index,
+                  void *output_baton,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  apr_pool_t *scratch_pool)
+{
+  update_result_t *ur = result;
+  update_jobs_baton_t *jb = output_baton;
+  update_job_t *job = APR_ARRAY_IDX(jb->jobs, index, update_job_t *);
+  svn_client_ctx_t *ctx = jb->ctx;
+  int i;
+
+  if (ur->timestamp_sleep)
+    *jb->timestamp_sleep = TRUE;
+
+  job->deferred = ur->deferred;
+  if (job->deferred)
+    return SVN_NO_ERROR;
+
+  if (ctx->notify_func2)
+    for (i = 0; i < ur->notifications->nelts; i++)
+      ctx->notify_func2(ctx->notify_baton2,
+                        APR_ARRAY_IDX(ur->notifications, i,
+                                      svn_wc_notify_t *),
+                        scratch_pool);
+
+  job->result_rev = ur->result_rev;
+  *jb->found_valid_target = TRUE;
+
+  if (ctx->conflict_func2 && apr_hash_count(ur->conflicted_paths))
+    SVN_ERR(svn_client__resolve_conflicts(NULL, ur->conflicted_paths, ctx,
+                                          scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set up the update_job_t * for the PATHS of svn_client_update4() to
+   update to REVISION in JOBS, allocated in the pool of JOBS.  If REVISION
+   is HEAD, resolve it for all targets in the repository of the first
+   candidate for a worker thread.  */
+static svn_error_t *
+make_update_jobs(apr_array_header_t *jobs,
+                 const apr_array_header_t *paths,
+                 const svn_opt_revision_t *revision,
+                 svn_client_ctx_t *ctx,
+                 apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_array_header_t *uuids;
+  const char *head_uuid = NULL;
+  svn_revnum_t head_rev = SVN_INVALID_REVNUM;
+  int i, j;
+
+  uuids = apr_array_make(scratch_pool, paths->nelts, sizeof(const char *));
+  for (i = 0; i < paths->nelts; i++)
+    {
+      update_job_t *job = apr_pcalloc(jobs->pool, sizeof(*job));
+      const char *repos_relpath = NULL;
+      const char *repos_root_url = NULL;
+      const char *repos_uuid = NULL;
+      svn_node_kind_t kind;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      job->path = APR_ARRAY_IDX(paths, i, const char *);
+      job->revision = *revision;
+      job->result_rev = SVN_INVALID_REVNUM;
+      job->deferred = TRUE;
+      SVN_ERR(svn_dirent_get_absolute(&job->local_abspath, job->path,
+                                      jobs->pool));
+
+      /* Whatever we can't tell from here is left to the caller. */
+      err = svn_wc__node_get_base(&kind, NULL, &repos_relpath,
+                                  &repos_root_url, &repos_uuid, NULL,
+                                  ctx->wc_ctx, job->local_abspath,
+                                  TRUE /* ignore_enoent */,
+                                  scratch_pool, iterpool);
+      if (err)
+        svn_error_clear(err);
+      else if (repos_relpath && kind == svn_node_dir)
+        job->concurrent = TRUE;
+
+      APR_ARRAY_PUSH(jobs, update_job_t *) = job;
+      APR_ARRAY_PUSH(uuids, const char *) = repos_uuid;
+
+      if (job->concurrent && !head_uuid
+          && (revision->kind == svn_opt_revision_head
+              || revision->kind == svn_opt_revision_unspecified))
+        {
+          svn_ra_session_t *ra_session;
+
+          /* This may prompt for credentials, which the workers can then
+             use as well. */
+          err = svn_client__open_ra_session_internal(
+                  &ra_session, NULL,
+                  svn_path_url_add_component2(repos_root_url, repos_relpath,
+                                              iterpool),
+                  job->local_abspath, NULL, FALSE, TRUE, ctx,
+                  iterpool, iterpool);
+          if (!err)
+            err = svn_ra_get_latest_revnum(ra_session, &head_rev, iterpool);
+
+          if (err && err->apr_err == SVN_ERR_CANCELLED)
+            return svn_error_trace(err);
+          else if (err)
+            svn_error_clear(err);
+          else
+            head_uuid = repos_uuid;
+        }
+    }
+
+  for (i = 0; i < jobs->nelts; i++)
+    {
+      update_job_t *job = APR_ARRAY_IDX(jobs, i, update_job_t *);
+      const char *repos_uuid = APR_ARRAY_IDX(uuids, i, const char *);
+
+      if (head_uuid && repos_uuid && strcmp(head_uuid, repos_uuid) == 0)
+        {
+          job->revision.kind = svn_opt_revision_number;
+          job->revision.value.number = head_rev;
+        }
+
+      /* Targets within each other are left to the caller. */
+      for (j = 0; j < jobs->nelts && job->concurrent; j++)
+        {
+          const update_job_t *other = APR_ARRAY_IDX(jobs, j, update_job_t *);
+
+          if (i != j
+              && (svn_dirent_is_ancestor(job->local_abspath,
+                                         other->local_abspath)
+                  || svn_dirent_is_ancestor(other->local_abspath,
+                                            job->local_abspath)))
+            job->concurrent = FALSE;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Update the PATHS of svn_client_update4(), with its arguments, using up
+   to THREAD_COUNT threads.  Set *FOUND_VALID_TARGET if some target was
+   not skipped and add the revisions the targets were updated to to
+   RESULT_REVS, if not NULL.
+
+   The targets that can be locked on their own are updated concurrently,
+   each worker thread using a client context and RA session of its own,
+   and their notifications are sent in order.  After that, the remaining
+   targets, and those whose workers failed, are updated one after the
+   other in this thread. */
+static svn_error_t *
+update_targets_concurrently(apr_array_header_t *result_revs,
+                            svn_boolean_t *timestamp_sleep,
+                            svn_boolean_t *found_valid_target,
+                            const apr_array_header_t *paths,
+                            const svn_opt_revision_t *revision,
+                            svn_depth_t depth,
+                            svn_boolean_t depth_is_sticky,
+                            svn_boolean_t ignore_externals,
+                            svn_boolean_t allow_unver_obstructions,
+                            svn_boolean_t adds_as_modification,
+                            int thread_count,
+                            svn_client_ctx_t *ctx,
+                            apr_pool_t *scratch_pool)
+{
+  update_jobs_baton_t jb = { 0 };
+  apr_pool_t *template_pool;
+  apr_pool_t *iterpool;
+  svn_config_t *cfg;
+  svn_error_t *err;
+  int i;
+
+  jb.jobs = apr_array_make(scratch_pool, paths->nelts,
+                           sizeof(update_job_t *));
+  SVN_ERR(make_update_jobs(jb.jobs, paths, revision, ctx, scratch_pool));
+
+  /* The workers copy these concurrently, so they must not share their
+     allocator with the pools of this thread, which may modify the
+     originals meanwhile.  The externals of the targets are handled by
+     the workers themselves. */
+  template_pool = svn_pool_create(NULL);
+  if (ctx->config)
+    SVN_ERR(svn_config_copy_config(&jb.config, ctx->config, template_pool));
+  cfg = jb.config ? svn_hash_gets(jb.config, SVN_CONFIG_CATEGORY_CONFIG)
+                  : NULL;
+  if (cfg)
+    svn_config_set(cfg, SVN_CONFIG_SECTION_MISCELLANY,
+                   SVN_CONFIG_OPTION_EXTERNALS_THREADS, "1");
+  if (ctx->auth_baton)
+    {
+      svn_auth__copy_baton(&jb.auth_baton, ctx->auth_baton, template_pool);
+      svn_auth_set_parameter(jb.auth_baton, SVN_AUTH_PARAM_NON_INTERACTIVE,
+                             "");
+    }
+
+  jb.depth = depth;
+  jb.depth_is_sticky = depth_is_sticky;
+  jb.ignore_externals = ignore_externals;
+  jb.allow_unver_obstructions = allow_unver_obstructions;
+  jb.adds_as_modification = adds_as_modification;
+  jb.timestamp_sleep = timestamp_sleep;
+  jb.found_valid_target = found_valid_target;
+  jb.ctx = ctx;
+
+  err = svn_task__run(thread_count, jb.jobs->nelts,
+                      update_job, &jb,
+                      finish_update_job, &jb,
+                      make_update_thread, &jb,
+                      ctx->cancel_func, ctx->cancel_baton,
+                      scratch_pool);
+  svn_pool_destroy(template_pool);
+  SVN_ERR(err);
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < jb.jobs->nelts; i++)
+    {
+      update_job_t *job = APR_ARRAY_IDX(jb.jobs, i, update_job_t *);
+
+      svn_pool_clear(iterpool);
+      if (job->deferred)
+        SVN_ERR(update_target(&job->result_rev, timestamp_sleep,
+                              found_valid_target, job->path, &job->revision,
+                              depth, depth_is_sticky, ignore_externals,
+                              allow_unver_obstructions, adds_as_modification,
+                              FALSE /* make_parents */, ctx, iterpool));
+
+      if (result_revs)
+        APR_ARRAY_PUSH(result_revs, svn_revnum_t) = job->result_rev;
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_client_update4(apr_array_header_t **result_revs,
                    const apr_array_header_t *paths,
@@ -736,6 +1260,7 @@ svn_client_update4(apr_array_header_t **result_revs,
   svn_boolean_t sleep = FALSE;
   svn_error_t *err = SVN_NO_ERROR;
   svn_boolean_t found_valid_target = FALSE;
+  int thread_count;
 
   if (result_revs)
     *result_revs = apr_array_make(pool, paths->nelts, sizeof(svn_revnum_t));
@@ -749,58 +1274,39 @@ svn_client_update4(apr_array_header_t **result_revs,
                                  _("'%s' is not a local path"), path);
     }
 
-  for (i = 0; i < paths->nelts; ++i)
+  SVN_ERR(get_update_threads(&thread_count, ctx));
+  if (thread_count > 1 && paths->nelts > 1 && !make_parents)
     {
-      svn_revnum_t result_rev;
-      const char *local_abspath;
-      path = APR_ARRAY_IDX(paths, i, const char *);
-
-      svn_pool_clear(iterpool);
-
-      if (ctx->cancel_func)
-        {
-          err = ctx->cancel_func(ctx->cancel_baton);
-          if (err)
-            goto cleanup;
-        }
-
-      err = svn_dirent_get_absolute(&local_abspath, path, iterpool);
-      if (err)
-        goto cleanup;
-      err = svn_client__update_internal(&result_rev, &sleep, local_abspath,
-                                        revision, depth, depth_is_sticky,
-                                        ignore_externals,
+      err = update_targets_concurrently(result_revs ? *result_revs : NULL,
+                                        &sleep, &found_valid_target,
+                                        paths, revision, depth,
+                                        depth_is_sticky, ignore_externals,
                                         allow_unver_obstructions,
                                         adds_as_modification,
-                                        make_parents,
-                                        FALSE, NULL, ctx,
-                                        iterpool);
-
+                                        thread_count, ctx, iterpool);
       if (err)
+        goto cleanup;
+    }
+  else
+    {
+      for (i = 0; i < paths->nelts; ++i)
         {
-          if (err->apr_err != SVN_ERR_WC_NOT_WORKING_COPY)
-            goto cleanup;
+          svn_revnum_t result_rev;
+          path = APR_ARRAY_IDX(paths, i, const char *);
 
-          svn_error_clear(err);
-          err = SVN_NO_ERROR;
+          svn_pool_clear(iterpool);
 
-          /* SVN_ERR_WC_NOT_WORKING_COPY: it's not versioned */
+          err = update_target(&result_rev, &sleep, &found_valid_target, path,
+                              revision, depth, depth_is_sticky,
+                              ignore_externals, allow_unver_obstructions,
+                              adds_as_modification, make_parents, ctx,
+                              iterpool);
+          if (err)
+            goto cleanup;
 
-          result_rev = SVN_INVALID_REVNUM;
-          if (ctx->notify_func2)
-            {
-              svn_wc_notify_t *notify;
-              notify = svn_wc_create_notify(path,
-                                            svn_wc_notify_skip,
-                                            iterpool);
-              ctx->notify_func2(ctx->notify_baton2, notify, iterpool);
-            }
+          if (result_revs)
+            APR_ARRAY_PUSH(*result_revs, svn_revnum_t) = result_rev;
         }
-      else
-        found_valid_target = TRUE;
-
-      if (result_revs)
-        APR_ARRAY_PUSH(*result_revs, svn_revnum_t) = result_rev;
     }
   svn_pool_destroy(iterpool);
 
@@ -37,6 +37,7 @@
 
 #include "private/svn_delta_private.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_subr_private.h"
 #include "svn_private_config.h"
 
 
@@ -138,6 +139,9 @@ struct ev2_edit_baton
   svn_delta_fetch_base_func_t fetch_base_func;
   void *fetch_base_baton;
 
+  /* Memory still available to buffer file contents.  */
+  apr_size_t contents_budget;
+
   svn_delta__unlock_func_t do_unlock;
   void *unlock_baton;
 };
@@ -191,8 +195,9 @@ struct change_node
   apr_hash_t *props;  /* new/final set of props to apply  */
 
   svn_boolean_t contents_changed; /* the file contents changed */
-  const char *contents_abspath;  /* file containing new fulltext  */
-  svn_checksum_t *checksum;  /* checksum of new fulltext  */
+  svn_spillbuf_t *contents;  /* new fulltext, NULL if empty  */
+  svn_checksum_t *checksum;  /* checksum of new fulltext; SHA1 when
+                                driving Ev2, MD5 when driving Ev1  */
 
   /* If COPYFROM_PATH is not NULL, then copy PATH@REV to this node.
      RESTRUCTURE must be RESTRUCTURE_ADD.  */
@@ -203,6 +208,41 @@ struct change_node
   svn_boolean_t unlock;
 };
 
+/* File contents are buffered in memory in blocks of this size. */
+#define CONTENTS_BLOCKSIZE 4096
+
+/* At most this much of a single file's contents is buffered in memory.
+   The rest is spilled to a temporary file. */
+#define CONTENTS_MAXSIZE (64 * 1024)
+
+/* All buffered file contents of an edit may use this much memory.
+   Contents are held until their parent directory is processed, so
+   this caps the memory used by large directories. */
+#define CONTENTS_MEMORY_BUDGET (16 * 1024 * 1024)
+
+/* Return a new buffer for file contents that keeps no more than BUDGET
+   bytes in memory.  Allocate it in RESULT_POOL. */
+static svn_spillbuf_t *
+create_contents_buf(apr_size_t budget,
+                    apr_pool_t *result_pool)
+{
+  return svn_spillbuf__create(CONTENTS_BLOCKSIZE,
+                              MIN(budget, CONTENTS_MAXSIZE),
+                              result_pool);
+}
+
+/* Deduct the memory used by the file contents in BUF from *BUDGET. */
+static void
+charge_contents_buf(apr_size_t *budget,
+                    const svn_spillbuf_t *buf)
+{
+  apr_size_t used
+    = (apr_size_t)APR_ALIGN(svn_spillbuf__get_memory_size(buf),
+                            CONTENTS_BLOCKSIZE);
+
+  *budget -= MIN(used, *budget);
+}
+
 
 static struct change_node *
 locate_change(struct ev2_edit_baton *eb,
@@ -356,13 +396,11 @@ process_actions(struct ev2_edit_baton *eb,
       /* ### validate we aren't overwriting KIND?  */
       kind = svn_node_file;
 
-      if (change->contents_abspath)
+      if (change->contents)
         {
-          /* ### the checksum might be in CHANGE->CHECKSUM  */
-          SVN_ERR(svn_io_file_checksum2(&checksum, change->contents_abspath,
-                                        svn_checksum_sha1, scratch_pool));
-          SVN_ERR(svn_stream_open_readonly(&contents, change->contents_abspath,
-                                           scratch_pool, scratch_pool));
+          checksum = change->checksum;
+          contents = svn_stream__from_spillbuf(change->contents,
+                                               scratch_pool);
         }
       else
         {
@@ -413,7 +451,7 @@ process_actions(struct ev2_edit_baton *eb,
               /* If this file was added, but apply_txdelta() was not
                  called (i.e., CONTENTS_CHANGED is FALSE), then we're adding
                  an empty file.  */
-              if (change->contents_abspath == NULL)
+              if (change->contents == NULL)
                 {
                   contents = svn_stream_empty(scratch_pool);
                   checksum = svn_checksum_empty_checksum(svn_checksum_sha1,
@@ -781,6 +819,11 @@ struct handler_baton
 
   svn_stream_t *source;
 
+  /* The buffer receiving the new contents and the budget to charge
+     for it. */
+  svn_spillbuf_t *contents;
+  apr_size_t *contents_budget;
+
   apr_pool_t *pool;
 };
 
@@ -794,6 +837,8 @@ window_handler(svn_txdelta_window_t *window, void *baton)
   if (window != NULL && !err)
     return SVN_NO_ERROR;
 
+  charge_contents_buf(hb->contents_budget, hb->contents);
+
   SVN_ERR(svn_stream_close(hb->source));
 
   svn_pool_destroy(hb->pool);
@@ -811,18 +856,6 @@ open_delta_base(svn_stream_t **stream, void *baton,
                                   result_pool, scratch_pool);
 }
 
-/* Lazy-open handler for opening a stream for the delta result. */
-static svn_error_t *
-open_delta_target(svn_stream_t **stream, void *baton,
-                apr_pool_t *result_pool, apr_pool_t *scratch_pool)
-{
-  struct change_node *change = baton;
-  return svn_stream_open_unique(stream, &change->contents_abspath,
-                                NULL,
-                                svn_io_file_del_on_pool_cleanup,
-                                result_pool, scratch_pool);
-}
-
 static svn_error_t *
 ev2_apply_textdelta(void *file_baton,
                     const char *base_checksum,
@@ -838,7 +871,7 @@ ev2_apply_textdelta(void *file_baton,
 
   change = locate_change(fb->eb, fb->path);
   SVN_ERR_ASSERT(!change->contents_changed);
-  SVN_ERR_ASSERT(change->contents_abspath == NULL);
+  SVN_ERR_ASSERT(change->contents == NULL);
   SVN_ERR_ASSERT(!SVN_IS_VALID_REVNUM(change->changing)
                  || change->changing == fb->base_revision);
   change->changing = fb->base_revision;
@@ -850,9 +883,17 @@ ev2_apply_textdelta(void *file_baton,
                                             (char*)fb->delta_base,
                                             FALSE, handler_pool);
 
+  /* Buffer the result, computing the SHA1 that Ev2 wants up front.
+     Closing TARGET at the end of the delta sets CHANGE->CHECKSUM. */
   change->contents_changed = TRUE;
-  target = svn_stream_lazyopen_create(open_delta_target, change,
-                                      FALSE, fb->eb->edit_pool);
+  change->contents = create_contents_buf(fb->eb->contents_budget,
+                                         fb->eb->edit_pool);
+  target = svn_stream_checksummed2(
+             svn_stream__from_spillbuf(change->contents, fb->eb->edit_pool),
+             NULL, &change->checksum, svn_checksum_sha1, FALSE,
+             fb->eb->edit_pool);
+  hb->contents = change->contents;
+  hb->contents_budget = &fb->eb->contents_budget;
 
   svn_txdelta_apply(hb->source, target,
                     NULL, NULL,
@@ -1008,6 +1049,7 @@ svn_delta__delta_from_editor(const svn_delta_editor_t **deditor,
   eb->changes = apr_hash_make(pool);
   eb->path_order = apr_array_make(pool, 1, sizeof(const char *));
   eb->edit_pool = pool;
+  eb->contents_budget = CONTENTS_MEMORY_BUDGET;
   eb->found_abs_paths = found_abs_paths;
   *eb->found_abs_paths = FALSE;
   eb->exb = exb;
@@ -1057,6 +1099,9 @@ struct editor_baton
   /* REPOS_RELPATH -> struct change_node *  */
   apr_hash_t *changes;
 
+  /* Memory still available to buffer file contents.  */
+  apr_size_t contents_budget;
+
   apr_pool_t *edit_pool;
 };
 
@@ -1117,8 +1162,7 @@ add_file_cb(void *baton,
             apr_pool_t *scratch_pool)
 {
   struct editor_baton *eb = baton;
-  const char *tmp_filename;
-  svn_stream_t *tmp_stream;
+  svn_spillbuf_t *buf;
   svn_checksum_t *md5_checksum;
   struct change_node *change = insert_change(relpath, eb->changes);
 
@@ -1129,18 +1173,19 @@ add_file_cb(void *baton,
   else
     md5_checksum = (svn_checksum_t *)checksum;
 
-  /* Spool the contents to a tempfile, and provide that to the driver. */
-  SVN_ERR(svn_stream_open_unique(&tmp_stream, &tmp_filename, NULL,
-                                 svn_io_file_del_on_pool_cleanup,
-                                 eb->edit_pool, scratch_pool));
-  SVN_ERR(svn_stream_copy3(contents, tmp_stream, NULL, NULL, scratch_pool));
+  /* Buffer the contents, and provide them to the driver. */
+  buf = create_contents_buf(eb->contents_budget, eb->edit_pool);
+  SVN_ERR(svn_stream_copy3(contents,
+                           svn_stream__from_spillbuf(buf, scratch_pool),
+                           NULL, NULL, scratch_pool));
+  charge_contents_buf(&eb->contents_budget, buf);
 
   change->action = RESTRUCTURE_ADD;
   change->kind = svn_node_file;
   change->deleting = replaces_rev;
   change->props = svn_prop_hash_dup(props, eb->edit_pool);
   change->contents_changed = TRUE;
-  change->contents_abspath = tmp_filename;
+  change->contents = buf;
   change->checksum = svn_checksum_dup(md5_checksum, eb->edit_pool);
 
   return SVN_NO_ERROR;
@@ -1223,7 +1268,6 @@ alter_file_cb(void *baton,
               apr_pool_t *scratch_pool)
 {
   struct editor_baton *eb = baton;
-  svn_stream_t *tmp_stream;
   struct change_node *change = insert_change(relpath, eb->changes);
 
   /* Note: this node may already have information in CHANGE as a result
@@ -1237,7 +1281,7 @@ alter_file_cb(void *baton,
 
   if (contents)
     {
-      const char *tmp_filename;
+      svn_spillbuf_t *buf;
       svn_checksum_t *md5_checksum;
 
       /* We may need to re-checksum these contents */
@@ -1248,15 +1292,15 @@ alter_file_cb(void *baton,
                                            svn_checksum_md5, TRUE,
                                            scratch_pool);
 
-      /* Spool the contents to a tempfile, and provide that to the driver. */
-      SVN_ERR(svn_stream_open_unique(&tmp_stream, &tmp_filename, NULL,
-                                     svn_io_file_del_on_pool_cleanup,
-                                     eb->edit_pool, scratch_pool));
-      SVN_ERR(svn_stream_copy3(contents, tmp_stream, NULL, NULL,
-                               scratch_pool));
+      /* Buffer the contents, and provide them to the driver. */
+      buf = create_contents_buf(eb->contents_budget, eb->edit_pool);
+      SVN_ERR(svn_stream_copy3(contents,
+                               svn_stream__from_spillbuf(buf, scratch_pool),
+                               NULL, NULL, scratch_pool));
+      charge_contents_buf(&eb->contents_budget, buf);
 
       change->contents_changed = TRUE;
-      change->contents_abspath = tmp_filename;
+      change->contents = buf;
       change->checksum = svn_checksum_dup(md5_checksum, eb->edit_pool);
     }
 
@@ -1697,7 +1741,7 @@ apply_change(void **dir_baton,
   else
     SVN_ERR(drive_ev1_props(eb, relpath, change, file_baton, scratch_pool));
 
-  if (change->contents_changed && change->contents_abspath)
+  if (change->contents_changed && change->contents)
     {
       svn_txdelta_window_handler_t handler;
       void *handler_baton;
@@ -1707,8 +1751,7 @@ apply_change(void **dir_baton,
          ### shim code...  */
       SVN_ERR(deditor->apply_textdelta(file_baton, NULL, scratch_pool,
                                        &handler, &handler_baton));
-      SVN_ERR(svn_stream_open_readonly(&contents, change->contents_abspath,
-                                       scratch_pool, scratch_pool));
+      contents = svn_stream__from_spillbuf(change->contents, scratch_pool);
       /* ### it would be nice to send a true txdelta here, but whatever.  */
       SVN_ERR(svn_txdelta_send_stream(contents, handler, handler_baton,
                                       NULL, scratch_pool));
@@ -1928,6 +1971,7 @@ svn_delta__editor_from_delta(svn_editor_t **editor_p,
   eb->deditor = deditor;
   eb->dedit_baton = dedit_baton;
   eb->edit_pool = result_pool;
+  eb->contents_budget = CONTENTS_MEMORY_BUDGET;
   eb->repos_root = apr_pstrdup(result_pool, repos_root);
   eb->base_relpath = apr_pstrdup(result_pool, base_relpath);
 
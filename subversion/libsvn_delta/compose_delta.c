@@ -23,6 +23,7 @@
 
 
 #include <assert.h>
+#include <string.h>
 
 #include <apr_general.h>        /* For APR_INLINE */
 
@@ -30,10 +31,13 @@
 #include "svn_pools.h"
 #include "delta.h"
 
-/* Define a MIN macro if this platform doesn't already have one. */
+/* Define MIN and MAX macros if this platform doesn't already have them. */
 #ifndef MIN
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #endif
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
 
 
 /* ==================================================================== */
@@ -212,10 +216,28 @@ search_offset_index(const offset_index_t *ndx,
 /* ==================================================================== */
 /* Mapping ranges in the source stream to ranges in the composed delta. */
 
+/* An entry in a flat range index. */
+typedef struct flat_range_t
+{
+  /* The same as in range_index_node_t. */
+  apr_size_t offset;
+  apr_size_t limit;
+  apr_size_t target_offset;
+} flat_range_t;
+
 /* The range index tree. */
 typedef struct range_index_t
 {
   range_index_node_t *tree;
+
+  /* If not NULL, the index uses this array of COUNT ranges instead of
+     TREE.  The ranges are ordered just like the list of tree nodes.
+     ROOT takes the role of the splayed tree root: it is the position of
+     the range found by the last search. */
+  flat_range_t *ranges;
+  int count;
+  int root;
+
   alloc_block_t *free_list;
   apr_pool_t *pool;
 } range_index_t;
@@ -226,11 +248,24 @@ create_range_index(apr_pool_t *pool)
 {
   range_index_t *ndx = apr_palloc(pool, sizeof(*ndx));
   ndx->tree = NULL;
+  ndx->ranges = NULL;
+  ndx->count = 0;
+  ndx->root = 0;
   ndx->pool = pool;
   ndx->free_list = NULL;
   return ndx;
 }
 
+/* Create a flat range index with room for up to CAPACITY ranges.
+   Allocate from POOL. */
+static range_index_t *
+create_flat_range_index(int capacity, apr_pool_t *pool)
+{
+  range_index_t *ndx = create_range_index(pool);
+  ndx->ranges = apr_palloc(pool, MAX(capacity, 1) * sizeof(*ndx->ranges));
+  return ndx;
+}
+
 /* Allocate a node for the range index tree. */
 static range_index_node_t *
 alloc_range_index_node(range_index_t *ndx,
@@ -627,6 +662,188 @@ build_range_list(apr_size_t offset, apr_size_t limit, range_index_t *ndx)
 }
 
 
+/* ==================================================================== */
+/* A flat variant of the range index. */
+
+/* Windows with up to this many source copies use a flat range index.
+   Searching a small sorted array is much cheaper than chasing pointers
+   through the splay tree, and inserting ranges only needs to move a few
+   cache lines.  For very large windows, the O(log n) tree wins. */
+#define FLAT_RANGE_INDEX_MAX_OPS 1024
+
+/* Set NDX->ROOT to the position of the last range in NDX that starts
+   at or before OFFSET, or to 0 if there is none.  This is what
+   splay_range_index() moves to the tree root. */
+static void
+seek_flat_range_index(apr_size_t offset, range_index_t *ndx)
+{
+  int lo = 0;
+  int hi = ndx->count;
+
+  /* Find the first range starting behind OFFSET. */
+  while (lo < hi)
+    {
+      int mid = lo + (hi - lo) / 2;
+      if (ndx->ranges[mid].offset <= offset)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  ndx->root = lo > 0 ? lo - 1 : 0;
+}
+
+/* Like clean_tree() but for the flat index in NDX: remove all ranges
+   behind the root that are superseded by the root range ending at
+   LIMIT. */
+static void
+clean_flat_range_index(range_index_t *ndx, apr_size_t limit)
+{
+  flat_range_t *ranges = ndx->ranges;
+  int first = ndx->root + 1;
+  int last = first;
+
+  while (last < ndx->count
+         && (ranges[last].limit <= limit
+             || (ranges[last].offset < limit
+                 && last + 1 < ndx->count
+                 && ranges[last + 1].offset < limit)))
+    ++last;
+
+  if (last > first)
+    {
+      memmove(&ranges[first], &ranges[last],
+              (ndx->count - last) * sizeof(*ranges));
+      ndx->count -= last - first;
+    }
+}
+
+/* Insert a new range at position POS in NDX and make it the root. */
+static void
+insert_flat_range_at(int pos,
+                     apr_size_t offset,
+                     apr_size_t limit,
+                     apr_size_t target_offset,
+                     range_index_t *ndx)
+{
+  flat_range_t *range = &ndx->ranges[pos];
+
+  memmove(range + 1, range, (ndx->count - pos) * sizeof(*range));
+  range->offset = offset;
+  range->limit = limit;
+  range->target_offset = target_offset;
+
+  ++ndx->count;
+  ndx->root = pos;
+}
+
+/* Like insert_range() but for the flat index in NDX.
+   NOTE: The range index must have been seeked to OFFSET! */
+static void
+insert_flat_range(apr_size_t offset, apr_size_t limit,
+                  apr_size_t target_offset, range_index_t *ndx)
+{
+  flat_range_t *root = &ndx->ranges[ndx->root];
+
+  if (ndx->count == 0)
+    {
+      insert_flat_range_at(0, offset, limit, target_offset, ndx);
+    }
+  else if (offset == root->offset && limit > root->limit)
+    {
+      root->limit = limit;
+      root->target_offset = target_offset;
+      clean_flat_range_index(ndx, limit);
+    }
+  else if (offset > root->offset && limit > root->limit)
+    {
+      const flat_range_t *next = (ndx->root + 1 < ndx->count
+                                  ? root + 1 : NULL);
+      const flat_range_t *prev = (ndx->root > 0 ? root - 1 : NULL);
+
+      /* Ignore the range if ROOT and NEXT already cover it. */
+      if (next && root->limit >= next->offset && limit <= next->limit)
+        return;
+
+      if (prev && prev->limit > offset)
+        {
+          /* The new range and PREV supersede ROOT. */
+          root->offset = offset;
+          root->limit = limit;
+          root->target_offset = target_offset;
+        }
+      else
+        {
+          insert_flat_range_at(ndx->root + 1, offset, limit, target_offset,
+                               ndx);
+        }
+      clean_flat_range_index(ndx, limit);
+    }
+  else if (offset < root->offset)
+    {
+      assert(ndx->root == 0);
+      insert_flat_range_at(0, offset, limit, target_offset, ndx);
+      clean_flat_range_index(ndx, limit);
+    }
+}
+
+/* Like build_range_list() but for the flat index in NDX.
+   NOTE: The range index must have been seeked to OFFSET! */
+static range_list_node_t *
+build_flat_range_list(apr_size_t offset, apr_size_t limit,
+                      range_index_t *ndx)
+{
+  range_list_node_t *range_list = NULL;
+  range_list_node_t *last_range = NULL;
+  const flat_range_t *range = ndx->ranges + ndx->root;
+  const flat_range_t *end = ndx->ranges + ndx->count;
+
+  while (offset < limit)
+    {
+      if (range == end)
+        return alloc_range_list(&range_list, &last_range, ndx,
+                                range_from_source,
+                                offset, limit, 0);
+
+      if (offset < range->offset)
+        {
+          if (limit <= range->offset)
+            return alloc_range_list(&range_list, &last_range, ndx,
+                                    range_from_source,
+                                    offset, limit, 0);
+
+          alloc_range_list(&range_list, &last_range, ndx,
+                           range_from_source,
+                           offset, range->offset, 0);
+          offset = range->offset;
+        }
+      else if (offset >= range->limit)
+        {
+          ++range;
+        }
+      else
+        {
+          const apr_size_t target_offset =
+            offset - range->offset + range->target_offset;
+
+          if (limit <= range->limit)
+            return alloc_range_list(&range_list, &last_range, ndx,
+                                    range_from_target,
+                                    offset, limit, target_offset);
+
+          alloc_range_list(&range_list, &last_range, ndx,
+                           range_from_target,
+                           offset, range->limit, target_offset);
+          offset = range->limit;
+          ++range;
+        }
+    }
+
+  /* A range's offset isn't smaller than its limit? Impossible! */
+  SVN_ERR_MALFUNCTION_NO_RETURN();
+}
+
+
 /* Copy the instructions from WINDOW that define the range [OFFSET,
    LIMIT) in WINDOW's target stream to TARGET_OFFSET in the window
    represented by BUILD_BATON. HINT is a position in the instructions
@@ -769,10 +986,21 @@ svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
   svn_txdelta_window_t *composite;
   apr_pool_t *subpool = svn_pool_create(pool);
   offset_index_t *offset_index = create_offset_index(window_A, subpool);
-  range_index_t *range_index = create_range_index(subpool);
+  range_index_t *range_index;
   apr_size_t target_offset = 0;
+  int src_ops = 0;
   int i;
 
+  /* The range index never holds more entries than there are source
+     copies in WINDOW_B. */
+  for (i = 0; i < window_B->num_ops; ++i)
+    if (window_B->ops[i].action_code == svn_txdelta_source)
+      ++src_ops;
+
+  range_index = (src_ops <= FLAT_RANGE_INDEX_MAX_OPS
+                 ? create_flat_range_index(src_ops, subpool)
+                 : create_range_index(subpool));
+
   /* Read the description of the delta composition algorithm in
      notes/fs-improvements.txt before going any further.
      You have been warned. */
@@ -802,8 +1030,16 @@ svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
           range_list_node_t *range_list, *range;
           apr_size_t tgt_off = target_offset;
 
-          splay_range_index(offset, range_index);
-          range_list = build_range_list(offset, limit, range_index);
+          if (range_index->ranges)
+            {
+              seek_flat_range_index(offset, range_index);
+              range_list = build_flat_range_list(offset, limit, range_index);
+            }
+          else
+            {
+              splay_range_index(offset, range_index);
+              range_list = build_range_list(offset, limit, range_index);
+            }
 
           for (range = range_list; range; range = range->next)
             {
@@ -822,7 +1058,10 @@ svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
           assert(tgt_off == target_offset + op->length);
 
           free_range_list(range_list, range_index);
-          insert_range(offset, limit, target_offset, range_index);
+          if (range_index->ranges)
+            insert_flat_range(offset, limit, target_offset, range_index);
+          else
+            insert_range(offset, limit, target_offset, range_index);
         }
 
       /* Remember the new offset in the would-be target stream. */
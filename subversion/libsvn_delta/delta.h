@@ -44,6 +44,16 @@ extern "C" {
 
 #define SVN_DELTA_WINDOW_SIZE 102400
 
+/* The size of the target view of one svndiff window in txdelta 2 format.
+   The source view of those windows may be up to twice as large. */
+
+#define SVN_DELTA_LARGE_WINDOW_SIZE (1024 * 1024)
+
+/* The smallest target view size that callers may request for the
+   windows of a delta stream. */
+
+#define SVN_DELTA_MIN_WINDOW_SIZE 4096
+
 
 /* Context/baton for building an operation sequence. */
 
@@ -39,13 +39,16 @@
 static const char SVNDIFF_V0[] = { 'S', 'V', 'N', 0 };
 static const char SVNDIFF_V1[] = { 'S', 'V', 'N', 1 };
 static const char SVNDIFF_V2[] = { 'S', 'V', 'N', 2 };
+static const char SVNDIFF_V3[] = { 'S', 'V', 'N', 3 };
 
 #define SVNDIFF_HEADER_SIZE (sizeof(SVNDIFF_V0))
 
 static const char *
 get_svndiff_header(int version)
 {
-  if (version == 2)
+  if (version == 3)
+    return SVNDIFF_V3;
+  else if (version == 2)
     return SVNDIFF_V2;
   else if (version == 1)
     return SVNDIFF_V1;
@@ -70,9 +73,17 @@ struct encoder_baton {
 /* This is at least as big as the largest size for a single instruction. */
 #define MAX_INSTRUCTION_LEN (2*SVN__MAX_ENCODED_UINT_LEN+1)
 /* This is at least as big as the largest possible instructions
-   section: in theory, the instructions could be SVN_DELTA_WINDOW_SIZE
+   section: in theory, the instructions could be SVN_DELTA_LARGE_WINDOW_SIZE
    1-byte copy-from-source instructions (though this is very unlikely). */
-#define MAX_INSTRUCTION_SECTION_LEN (SVN_DELTA_WINDOW_SIZE*MAX_INSTRUCTION_LEN)
+#define MAX_INSTRUCTION_SECTION_LEN \
+  (SVN_DELTA_LARGE_WINDOW_SIZE*MAX_INSTRUCTION_LEN)
+
+/* Largest window dimensions that we accept when reading svndiff data.
+   The window header carries the actual view sizes, so a reader accepts
+   the classic windows as well as those of the txdelta 2 format, which
+   have larger target views and a source view spanning two windows. */
+#define MAX_TVIEW_LEN SVN_DELTA_LARGE_WINDOW_SIZE
+#define MAX_SVIEW_LEN (2 * SVN_DELTA_LARGE_WINDOW_SIZE)
 
 
 /* Append an encoded integer to a string.  */
@@ -198,7 +209,15 @@ encode_window(svn_stringbuf_t **instructions_p,
   append_encoded_int(header, window->sview_offset);
   append_encoded_int(header, window->sview_len);
   append_encoded_int(header, window->tview_len);
-  if (version == 2)
+  if (version == 3)
+    {
+      svn_stringbuf_t *compressed_instructions;
+      compressed_instructions = svn_stringbuf_create_empty(pool);
+      SVN_ERR(svn__compress_zstd(instructions->data, instructions->len,
+                                 compressed_instructions, compression_level));
+      instructions = compressed_instructions;
+    }
+  else if (version == 2)
     {
       svn_stringbuf_t *compressed_instructions;
       compressed_instructions = svn_stringbuf_create_empty(pool);
@@ -217,7 +236,15 @@ encode_window(svn_stringbuf_t **instructions_p,
   append_encoded_int(header, instructions->len);
 
   /* Encode the data. */
-  if (version == 2)
+  if (version == 3)
+    {
+      svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
+
+      SVN_ERR(svn__compress_zstd(window->new_data->data, window->new_data->len,
+                                 compressed, compression_level));
+      newdata = svn_stringbuf__morph_into_string(compressed);
+    }
+  else if (version == 2)
     {
       svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
 
@@ -245,8 +272,6 @@ encode_window(svn_stringbuf_t **instructions_p,
   return SVN_NO_ERROR;
 }
 
-/* Note: When changing things here, check the related comment in
-   the svn_txdelta_to_svndiff_stream() function.  */
 static svn_error_t *
 window_handler(svn_txdelta_window_t *window, void *baton)
 {
@@ -355,14 +380,13 @@ struct decode_baton
   svn_txdelta_window_handler_t consumer_func;
   void *consumer_baton;
 
-  /* Pool to create subpools from; each developing window will be a
-     subpool.  */
+  /* Pool containing the parser's state and buffers.  */
   apr_pool_t *pool;
 
-  /* The current subpool which contains our current window-buffer.  */
-  apr_pool_t *subpool;
+  /* Reusable buffers for the decoded windows.  */
+  svn_txdelta__window_decoder_t *decoder;
 
-  /* The actual svndiff data buffer, living within subpool.  */
+  /* The actual svndiff data buffer.  */
   svn_stringbuf_t *buffer;
 
   /* The offset and size of the last source view, so that we can check
@@ -468,6 +492,78 @@ decode_instruction(svn_txdelta_op_t *op,
   return p;
 }
 
+/* Make sure that instruction number N, given as the decoded OP, is valid
+   for the given window lengths.  *TPOS and *NPOS are the target and new
+   data positions before OP and will be advanced accordingly.  Return an
+   error if the instruction is invalid.  */
+static svn_error_t *
+verify_instruction(const svn_txdelta_op_t *op,
+                   int n,
+                   apr_size_t sview_len,
+                   apr_size_t tview_len,
+                   apr_size_t new_len,
+                   apr_size_t *tpos,
+                   apr_size_t *npos)
+{
+  if (op->length == 0)
+    return svn_error_createf
+      (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
+       _("Invalid diff stream: insn %d has length zero"), n);
+  else if (op->length > tview_len - *tpos)
+    return svn_error_createf
+      (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
+       _("Invalid diff stream: insn %d overflows the target view"), n);
+
+  switch (op->action_code)
+    {
+    case svn_txdelta_source:
+      if (op->length > sview_len - op->offset ||
+          op->offset > sview_len)
+        return svn_error_createf
+          (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
+           _("Invalid diff stream: "
+             "[src] insn %d overflows the source view"), n);
+      break;
+    case svn_txdelta_target:
+      if (op->offset >= *tpos)
+        return svn_error_createf
+          (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
+           _("Invalid diff stream: "
+             "[tgt] insn %d starts beyond the target view position"), n);
+      break;
+    case svn_txdelta_new:
+      if (op->length > new_len - *npos)
+        return svn_error_createf
+          (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
+           _("Invalid diff stream: "
+             "[new] insn %d overflows the new data section"), n);
+      *npos += op->length;
+      break;
+    }
+
+  *tpos += op->length;
+  return SVN_NO_ERROR;
+}
+
+/* Return an error unless the instructions, having covered TPOS bytes of
+   the target view and NPOS bytes of new data, exactly match the window's
+   TVIEW_LEN and NEW_LEN.  */
+static svn_error_t *
+verify_instructions_complete(apr_size_t tpos,
+                             apr_size_t npos,
+                             apr_size_t tview_len,
+                             apr_size_t new_len)
+{
+  if (tpos != tview_len)
+    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
+                            _("Delta does not fill the target window"));
+  if (npos != new_len)
+    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
+                            _("Delta does not contain enough new data"));
+
+  return SVN_NO_ERROR;
+}
+
 /* Count the instructions in the range [P..END-1] and make sure they
    are valid for the given window lengths.  Return an error if the
    instructions are invalid; otherwise set *NINST to the number of
@@ -493,50 +589,13 @@ count_and_verify_instructions(int *ninst,
         return svn_error_createf
           (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
            _("Invalid diff stream: insn %d cannot be decoded"), n);
-      else if (op.length == 0)
-        return svn_error_createf
-          (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
-           _("Invalid diff stream: insn %d has length zero"), n);
-      else if (op.length > tview_len - tpos)
-        return svn_error_createf
-          (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
-           _("Invalid diff stream: insn %d overflows the target view"), n);
 
-      switch (op.action_code)
-        {
-        case svn_txdelta_source:
-          if (op.length > sview_len - op.offset ||
-              op.offset > sview_len)
-            return svn_error_createf
-              (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
-               _("Invalid diff stream: "
-                 "[src] insn %d overflows the source view"), n);
-          break;
-        case svn_txdelta_target:
-          if (op.offset >= tpos)
-            return svn_error_createf
-              (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
-               _("Invalid diff stream: "
-                 "[tgt] insn %d starts beyond the target view position"), n);
-          break;
-        case svn_txdelta_new:
-          if (op.length > new_len - npos)
-            return svn_error_createf
-              (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
-               _("Invalid diff stream: "
-                 "[new] insn %d overflows the new data section"), n);
-          npos += op.length;
-          break;
-        }
-      tpos += op.length;
+      SVN_ERR(verify_instruction(&op, n, sview_len, tview_len, new_len,
+                                 &tpos, &npos));
       n++;
     }
-  if (tpos != tview_len)
-    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
-                            _("Delta does not fill the target window"));
-  if (npos != new_len)
-    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
-                            _("Delta does not contain enough new data"));
+
+  SVN_ERR(verify_instructions_complete(tpos, npos, tview_len, new_len));
 
   *ninst = n;
   return SVN_NO_ERROR;
@@ -565,13 +624,29 @@ decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
 
   insend = data + inslen;
 
-  if (version == 2)
+  if (version == 3)
+    {
+      svn_stringbuf_t *instout = svn_stringbuf_create_empty(pool);
+      svn_stringbuf_t *ndout = svn_stringbuf_create_empty(pool);
+
+      SVN_ERR(svn__decompress_zstd(insend, newlen, ndout,
+                                   MAX_TVIEW_LEN));
+      SVN_ERR(svn__decompress_zstd(data, insend - data, instout,
+                                   MAX_INSTRUCTION_SECTION_LEN));
+
+      newlen = ndout->len;
+      data = (unsigned char *)instout->data;
+      insend = (unsigned char *)instout->data + instout->len;
+
+      new_data = svn_stringbuf__morph_into_string(ndout);
+    }
+  else if (version == 2)
     {
       svn_stringbuf_t *instout = svn_stringbuf_create_empty(pool);
       svn_stringbuf_t *ndout = svn_stringbuf_create_empty(pool);
 
       SVN_ERR(svn__decompress_lz4(insend, newlen, ndout,
-                                  SVN_DELTA_WINDOW_SIZE));
+                                  MAX_TVIEW_LEN));
       SVN_ERR(svn__decompress_lz4(data, insend - data, instout,
                                   MAX_INSTRUCTION_SECTION_LEN));
 
@@ -587,7 +662,7 @@ decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
       svn_stringbuf_t *ndout = svn_stringbuf_create_empty(pool);
 
       SVN_ERR(svn__decompress_zlib(insend, newlen, ndout,
-                                   SVN_DELTA_WINDOW_SIZE));
+                                   MAX_TVIEW_LEN));
       SVN_ERR(svn__decompress_zlib(data, insend - data, instout,
                                    MAX_INSTRUCTION_SECTION_LEN));
 
@@ -632,6 +707,263 @@ decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
   return SVN_NO_ERROR;
 }
 
+/* Reusable state for decoding svndiff windows without per-window
+   allocations. */
+struct svn_txdelta__window_decoder_t
+{
+  /* The window returned to the caller and its new data. */
+  svn_txdelta_window_t window;
+  svn_string_t new_data;
+
+  /* Instruction buffer with space for OPS_SIZE entries. */
+  svn_txdelta_op_t *ops;
+  int ops_size;
+
+  /* Decompressed instructions and new data, reused for every window. */
+  svn_stringbuf_t *instructions;
+  svn_stringbuf_t *new_data_buf;
+
+  /* If set, copy uncompressed new data into NEW_DATA_BUF instead of
+     referencing it in the input buffer. */
+  svn_boolean_t copy_new_data;
+
+  /* Pool to grow the buffers in. */
+  apr_pool_t *pool;
+};
+
+svn_txdelta__window_decoder_t *
+svn_txdelta__window_decoder_create(svn_boolean_t copy_new_data,
+                                   apr_pool_t *result_pool)
+{
+  svn_txdelta__window_decoder_t *decoder
+    = apr_pcalloc(result_pool, sizeof(*decoder));
+
+  decoder->instructions = svn_stringbuf_create_empty(result_pool);
+  decoder->new_data_buf = svn_stringbuf_create_empty(result_pool);
+  decoder->copy_new_data = copy_new_data;
+  decoder->pool = result_pool;
+
+  return decoder;
+}
+
+/* Decode and verify the instructions in [P..END) into DECODER's
+   instruction buffer in a single pass, growing the buffer as needed.
+   The other parameters are the same as for count_and_verify_instructions.
+   Complete DECODER->WINDOW with the resulting instructions.  */
+static svn_error_t *
+decode_and_verify_instructions(svn_txdelta__window_decoder_t *decoder,
+                               const unsigned char *p,
+                               const unsigned char *end,
+                               apr_size_t sview_len,
+                               apr_size_t tview_len,
+                               apr_size_t new_len)
+{
+  int n = 0;
+  int src_ops = 0;
+  apr_size_t tpos = 0, npos = 0;
+
+  while (p < end)
+    {
+      svn_txdelta_op_t *op;
+
+      if (n == decoder->ops_size)
+        {
+          /* Every instruction takes at least one byte, so this is
+             enough for all remaining ones. */
+          int new_size = n + (int)(end - p);
+          svn_txdelta_op_t *new_ops
+            = apr_palloc(decoder->pool, new_size * sizeof(*new_ops));
+
+          if (n)
+            memcpy(new_ops, decoder->ops, n * sizeof(*new_ops));
+
+          decoder->ops = new_ops;
+          decoder->ops_size = new_size;
+        }
+
+      op = &decoder->ops[n];
+      p = decode_instruction(op, p, end);
+      if (p == NULL)
+        return svn_error_createf
+          (SVN_ERR_SVNDIFF_INVALID_OPS, NULL,
+           _("Invalid diff stream: insn %d cannot be decoded"), n);
+
+      if (op->action_code == svn_txdelta_new)
+        op->offset = npos;
+      else if (op->action_code == svn_txdelta_source)
+        ++src_ops;
+
+      SVN_ERR(verify_instruction(op, n, sview_len, tview_len, new_len,
+                                 &tpos, &npos));
+      n++;
+    }
+
+  SVN_ERR(verify_instructions_complete(tpos, npos, tview_len, new_len));
+
+  decoder->window.ops = decoder->ops;
+  decoder->window.num_ops = n;
+  decoder->window.src_ops = src_ops;
+
+  return SVN_NO_ERROR;
+}
+
+/* Like decode_window but use the buffers in DECODER and return the
+   result in DECODER->WINDOW.  */
+static svn_error_t *
+decode_window_reuse(svn_txdelta__window_decoder_t *decoder,
+                    svn_filesize_t sview_offset,
+                    apr_size_t sview_len,
+                    apr_size_t tview_len,
+                    apr_size_t inslen,
+                    apr_size_t newlen,
+                    const unsigned char *data,
+                    unsigned int version)
+{
+  const unsigned char *insend = data + inslen;
+  svn_stringbuf_t *instout = decoder->instructions;
+  svn_stringbuf_t *ndout = decoder->new_data_buf;
+
+  decoder->window.sview_offset = sview_offset;
+  decoder->window.sview_len = sview_len;
+  decoder->window.tview_len = tview_len;
+  decoder->window.new_data = &decoder->new_data;
+
+  if (version >= 1 && version <= 3)
+    {
+      if (version == 3)
+        {
+          SVN_ERR(svn__decompress_zstd(insend, newlen, ndout,
+                                       MAX_TVIEW_LEN));
+          SVN_ERR(svn__decompress_zstd(data, inslen, instout,
+                                       MAX_INSTRUCTION_SECTION_LEN));
+        }
+      else if (version == 2)
+        {
+          SVN_ERR(svn__decompress_lz4(insend, newlen, ndout,
+                                      MAX_TVIEW_LEN));
+          SVN_ERR(svn__decompress_lz4(data, inslen, instout,
+                                      MAX_INSTRUCTION_SECTION_LEN));
+        }
+      else
+        {
+          SVN_ERR(svn__decompress_zlib(insend, newlen, ndout,
+                                       MAX_TVIEW_LEN));
+          SVN_ERR(svn__decompress_zlib(data, inslen, instout,
+                                       MAX_INSTRUCTION_SECTION_LEN));
+        }
+
+      newlen = ndout->len;
+      data = (unsigned char *)instout->data;
+      insend = (unsigned char *)instout->data + instout->len;
+
+      decoder->new_data.data = ndout->data;
+    }
+  else if (decoder->copy_new_data)
+    {
+      /* Keep the data[len]=='\0' invariant of svn_string_t. */
+      svn_stringbuf_setempty(ndout);
+      svn_stringbuf_appendbytes(ndout, (const char *)insend, newlen);
+      decoder->new_data.data = ndout->data;
+    }
+  else
+    {
+      decoder->new_data.data = (const char *)insend;
+    }
+
+  decoder->new_data.len = newlen;
+
+  return svn_error_trace(decode_and_verify_instructions(decoder, data,
+                                                        insend, sview_len,
+                                                        tview_len, newlen));
+}
+
+/* Decode the header of a delta window from the svndiff data in [*P..END)
+   into the five integer fields and check them for sanity.  On success,
+   set *P behind the header.  If the header is incomplete, set *P to NULL
+   instead.  */
+static svn_error_t *
+decode_window_header(const unsigned char **p,
+                     const unsigned char *end,
+                     svn_filesize_t *sview_offset,
+                     apr_size_t *sview_len,
+                     apr_size_t *tview_len,
+                     apr_size_t *inslen,
+                     apr_size_t *newlen)
+{
+  const unsigned char *q = *p;
+
+  *p = NULL;
+  q = decode_file_offset(sview_offset, q, end);
+  if (q == NULL)
+    return SVN_NO_ERROR;
+
+  q = decode_size(sview_len, q, end);
+  if (q == NULL)
+    return SVN_NO_ERROR;
+
+  q = decode_size(tview_len, q, end);
+  if (q == NULL)
+    return SVN_NO_ERROR;
+
+  q = decode_size(inslen, q, end);
+  if (q == NULL)
+    return SVN_NO_ERROR;
+
+  q = decode_size(newlen, q, end);
+  if (q == NULL)
+    return SVN_NO_ERROR;
+
+  if (*tview_len > MAX_TVIEW_LEN ||
+      *sview_len > MAX_SVIEW_LEN ||
+      /* for svndiff1, newlen includes the original length */
+      *newlen > MAX_TVIEW_LEN + SVN__MAX_ENCODED_UINT_LEN ||
+      *inslen > MAX_INSTRUCTION_SECTION_LEN)
+    return svn_error_create(
+             SVN_ERR_SVNDIFF_CORRUPT_WINDOW, NULL,
+             _("Svndiff contains a too-large window"));
+
+  /* Check for integer overflow.  */
+  if (*sview_offset < 0 || *inslen + *newlen < *inslen
+      || *sview_len + *tview_len < *sview_len
+      || (apr_size_t)*sview_offset + *sview_len
+         < (apr_size_t)*sview_offset)
+    return svn_error_create(
+              SVN_ERR_SVNDIFF_CORRUPT_WINDOW, NULL,
+              _("Svndiff contains corrupt window header"));
+
+  *p = q;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_txdelta__decode_svndiff_window(svn_txdelta_window_t **window,
+                                   apr_size_t *window_len,
+                                   svn_txdelta__window_decoder_t *decoder,
+                                   const char *data,
+                                   apr_size_t len,
+                                   int svndiff_version)
+{
+  const unsigned char *start = (const unsigned char *)data;
+  const unsigned char *end = start + len;
+  const unsigned char *p = start;
+  svn_filesize_t sview_offset;
+  apr_size_t sview_len, tview_len, inslen, newlen;
+
+  SVN_ERR(decode_window_header(&p, end, &sview_offset, &sview_len,
+                               &tview_len, &inslen, &newlen));
+  if (p == NULL || (apr_size_t)(end - p) < inslen + newlen)
+    return svn_error_create(SVN_ERR_SVNDIFF_UNEXPECTED_END, NULL,
+                            _("Unexpected end of svndiff input"));
+
+  SVN_ERR(decode_window_reuse(decoder, sview_offset, sview_len, tview_len,
+                              inslen, newlen, p, svndiff_version));
+
+  *window = &decoder->window;
+  *window_len = (p - start) + inslen + newlen;
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 write_handler(void *baton,
               const char *buffer,
@@ -653,6 +985,8 @@ write_handler(void *baton,
         db->version = 1;
       else if (memcmp(buffer, SVNDIFF_V2 + db->header_bytes, nheader) == 0)
         db->version = 2;
+      else if (memcmp(buffer, SVNDIFF_V3 + db->header_bytes, nheader) == 0)
+        db->version = 3;
       else
         return svn_error_create(SVN_ERR_SVNDIFF_INVALID_HEADER, NULL,
                                 _("Svndiff has invalid header"));
@@ -678,7 +1012,7 @@ write_handler(void *baton,
 
   while (1)
     {
-      svn_txdelta_window_t window;
+      svn_txdelta_window_t *window;
 
       /* Read the header, if we have enough bytes for that.  */
       p = (const unsigned char *) db->buffer->data;
@@ -690,42 +1024,10 @@ write_handler(void *baton,
           apr_size_t sview_len, tview_len, inslen, newlen;
           const unsigned char *hdr_start = p;
 
-          p = decode_file_offset(&sview_offset, p, end);
+          SVN_ERR(decode_window_header(&p, end, &sview_offset, &sview_len,
+                                       &tview_len, &inslen, &newlen));
           if (p == NULL)
-              break;
-
-          p = decode_size(&sview_len, p, end);
-          if (p == NULL)
-              break;
-
-          p = decode_size(&tview_len, p, end);
-          if (p == NULL)
-              break;
-
-          p = decode_size(&inslen, p, end);
-          if (p == NULL)
-              break;
-
-          p = decode_size(&newlen, p, end);
-          if (p == NULL)
-              break;
-
-          if (tview_len > SVN_DELTA_WINDOW_SIZE ||
-              sview_len > SVN_DELTA_WINDOW_SIZE ||
-              /* for svndiff1, newlen includes the original length */
-              newlen > SVN_DELTA_WINDOW_SIZE + SVN__MAX_ENCODED_UINT_LEN ||
-              inslen > MAX_INSTRUCTION_SECTION_LEN)
-            return svn_error_create(
-                     SVN_ERR_SVNDIFF_CORRUPT_WINDOW, NULL,
-                     _("Svndiff contains a too-large window"));
-
-          /* Check for integer overflow.  */
-          if (sview_offset < 0 || inslen + newlen < inslen
-              || sview_len + tview_len < sview_len
-              || (apr_size_t)sview_offset + sview_len < (apr_size_t)sview_offset)
-            return svn_error_create(
-                      SVN_ERR_SVNDIFF_CORRUPT_WINDOW, NULL,
-                      _("Svndiff contains corrupt window header"));
+            break;
 
           /* Check for source windows which slide backwards.  */
           if (sview_len > 0
@@ -756,10 +1058,11 @@ write_handler(void *baton,
         return SVN_NO_ERROR;
 
       /* Decode the window and send it off. */
-      SVN_ERR(decode_window(&window, db->sview_offset, db->sview_len,
-                            db->tview_len, db->inslen, db->newlen, p,
-                            db->subpool, db->version));
-      SVN_ERR(db->consumer_func(&window, db->consumer_baton));
+      SVN_ERR(decode_window_reuse(db->decoder, db->sview_offset,
+                                  db->sview_len, db->tview_len, db->inslen,
+                                  db->newlen, p, db->version));
+      window = &db->decoder->window;
+      SVN_ERR(db->consumer_func(window, db->consumer_baton));
 
       p += db->inslen + db->newlen;
 
@@ -772,9 +1075,6 @@ write_handler(void *baton,
       /* Remember the offset and length of the source view for next time.  */
       db->last_sview_offset = db->sview_offset;
       db->last_sview_len = db->sview_len;
-
-      /* Clear subpool. */
-      svn_pool_clear(db->subpool);
     }
 
   /* At this point we processed all integral windows and DB->BUFFER is empty
@@ -833,7 +1133,7 @@ svn_txdelta_parse_svndiff(svn_txdelta_window_handler_t handler,
       db->consumer_func = handler;
       db->consumer_baton = handler_baton;
       db->pool = subpool;
-      db->subpool = svn_pool_create(subpool);
+      db->decoder = svn_txdelta__window_decoder_create(TRUE, subpool);
       db->buffer = svn_stringbuf_create_empty(db->pool);
       db->last_sview_offset = 0;
       db->last_sview_len = 0;
@@ -921,10 +1221,10 @@ read_window_header(svn_stream_t *stream, svn_filesize_t *sview_offset,
   SVN_ERR(read_one_size(inslen, header_len, stream));
   SVN_ERR(read_one_size(newlen, header_len, stream));
 
-  if (*tview_len > SVN_DELTA_WINDOW_SIZE ||
-      *sview_len > SVN_DELTA_WINDOW_SIZE ||
+  if (*tview_len > MAX_TVIEW_LEN ||
+      *sview_len > MAX_SVIEW_LEN ||
       /* for svndiff1, newlen includes the original length */
-      *newlen > SVN_DELTA_WINDOW_SIZE + SVN__MAX_ENCODED_UINT_LEN ||
+      *newlen > MAX_TVIEW_LEN + SVN__MAX_ENCODED_UINT_LEN ||
       *inslen > MAX_INSTRUCTION_SECTION_LEN)
     return svn_error_create(SVN_ERR_SVNDIFF_CORRUPT_WINDOW, NULL,
                             _("Svndiff contains a too-large window"));
@@ -995,66 +1295,167 @@ svn_txdelta__read_raw_window_len(apr_size_t *window_len,
   return SVN_NO_ERROR;
 }
 
-typedef struct svndiff_stream_baton_t
+/* Maximum number of separate buffers that make up an encoded window:
+   the stream header, the window header, the instructions and the new
+   data. */
+#define MAX_SEGMENTS 4
+
+struct svn_txdelta__svndiff_reader_t
 {
-  apr_pool_t *scratch_pool;
   svn_txdelta_stream_t *txstream;
-  svn_txdelta_window_handler_t handler;
-  void *handler_baton;
-  svn_stringbuf_t *window_buffer;
-  apr_size_t read_pos;
+  int version;
+  int compression_level;
+  svn_boolean_t header_done;
   svn_boolean_t hit_eof;
-} svndiff_stream_baton_t;
 
+  /* Holds the current window and its encoded form. */
+  apr_pool_t *window_pool;
+
+  /* The encoded data not handed out completely, yet.  SEGMENTS[CURRENT]
+     is the segment being handed out and OFFSET is the number of bytes
+     already released from it. */
+  const char *segments[MAX_SEGMENTS];
+  apr_size_t lengths[MAX_SEGMENTS];
+  int segment_count;
+  int current;
+  apr_size_t offset;
+};
+
+/* Append the LEN bytes at DATA as a new segment to READER, unless it
+   is empty. */
+static void
+add_segment(svn_txdelta__svndiff_reader_t *reader,
+            const char *data,
+            apr_size_t len)
+{
+  if (len)
+    {
+      reader->segments[reader->segment_count] = data;
+      reader->lengths[reader->segment_count] = len;
+      reader->segment_count++;
+    }
+}
+
+/* Fetch the next window from READER's delta stream and make its encoded
+   form the list of segments to hand out. */
 static svn_error_t *
-svndiff_stream_write_fn(void *baton, const char *data, apr_size_t *len)
+encode_next_window(svn_txdelta__svndiff_reader_t *reader)
 {
-  svndiff_stream_baton_t *b = baton;
+  svn_txdelta_window_t *window;
+  svn_stringbuf_t *instructions;
+  svn_stringbuf_t *header;
+  const svn_string_t *newdata;
+
+  svn_pool_clear(reader->window_pool);
+  reader->segment_count = 0;
+  reader->current = 0;
+  reader->offset = 0;
+
+  if (!reader->header_done)
+    {
+      add_segment(reader, get_svndiff_header(reader->version),
+                  SVNDIFF_HEADER_SIZE);
+      reader->header_done = TRUE;
+    }
 
-  /* The memory usage here is limited, as this buffer doesn't grow
-     beyond the (header size + max window size in svndiff format).
-     See the comment in svn_txdelta_to_svndiff_stream().  */
-  svn_stringbuf_appendbytes(b->window_buffer, data, *len);
+  SVN_ERR(svn_txdelta_next_window(&window, reader->txstream,
+                                  reader->window_pool));
+  if (!window)
+    {
+      reader->hit_eof = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  /* The encoded window refers to the new data of WINDOW, if it has not
+     been compressed.  So, that is being handed out without copying. */
+  SVN_ERR(encode_window(&instructions, &header, &newdata, window,
+                        reader->version, reader->compression_level,
+                        reader->window_pool));
+  add_segment(reader, header->data, header->len);
+  add_segment(reader, instructions->data, instructions->len);
+  add_segment(reader, newdata->data, newdata->len);
 
   return SVN_NO_ERROR;
 }
 
+svn_txdelta__svndiff_reader_t *
+svn_txdelta__svndiff_reader_create(svn_txdelta_stream_t *txstream,
+                                   int svndiff_version,
+                                   int compression_level,
+                                   apr_pool_t *result_pool)
+{
+  svn_txdelta__svndiff_reader_t *reader;
+
+  reader = apr_pcalloc(result_pool, sizeof(*reader));
+  reader->txstream = txstream;
+  reader->version = svndiff_version;
+  reader->compression_level = compression_level;
+  reader->window_pool = svn_pool_create(result_pool);
+
+  return reader;
+}
+
+svn_error_t *
+svn_txdelta__svndiff_reader_peek(const char **data,
+                                 apr_size_t *len,
+                                 svn_txdelta__svndiff_reader_t *reader)
+{
+  /* Skip windows without data, e.g. the final NULL window after the
+     header has been sent. */
+  while (reader->current == reader->segment_count && !reader->hit_eof)
+    SVN_ERR(encode_next_window(reader));
+
+  if (reader->current == reader->segment_count)
+    {
+      *data = NULL;
+      *len = 0;
+    }
+  else
+    {
+      *data = reader->segments[reader->current] + reader->offset;
+      *len = reader->lengths[reader->current] - reader->offset;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+void
+svn_txdelta__svndiff_reader_release(svn_txdelta__svndiff_reader_t *reader,
+                                    apr_size_t len)
+{
+  SVN_ERR_ASSERT_NO_RETURN(reader->current < reader->segment_count);
+  SVN_ERR_ASSERT_NO_RETURN(len <= reader->lengths[reader->current]
+                                  - reader->offset);
+
+  reader->offset += len;
+  if (reader->offset == reader->lengths[reader->current])
+    {
+      reader->current++;
+      reader->offset = 0;
+    }
+}
+
 static svn_error_t *
 svndiff_stream_read_fn(void *baton, char *buffer, apr_size_t *len)
 {
-  svndiff_stream_baton_t *b = baton;
+  svn_txdelta__svndiff_reader_t *reader = baton;
   apr_size_t left = *len;
   apr_size_t read = 0;
 
   while (left)
     {
+      const char *data;
       apr_size_t chunk_size;
 
-      if (b->read_pos == b->window_buffer->len && !b->hit_eof)
-        {
-          svn_txdelta_window_t *window;
-
-          svn_pool_clear(b->scratch_pool);
-          svn_stringbuf_setempty(b->window_buffer);
-          SVN_ERR(svn_txdelta_next_window(&window, b->txstream,
-                                          b->scratch_pool));
-          SVN_ERR(b->handler(window, b->handler_baton));
-          b->read_pos = 0;
-
-          if (!window)
-            b->hit_eof = TRUE;
-        }
+      SVN_ERR(svn_txdelta__svndiff_reader_peek(&data, &chunk_size, reader));
+      if (!chunk_size)
+        break;
 
-      if (left > b->window_buffer->len - b->read_pos)
-        chunk_size = b->window_buffer->len - b->read_pos;
-      else
+      if (chunk_size > left)
         chunk_size = left;
 
-      if (!chunk_size)
-          break;
-
-      memcpy(buffer, b->window_buffer->data + b->read_pos, chunk_size);
-      b->read_pos += chunk_size;
+      memcpy(buffer, data, chunk_size);
+      svn_txdelta__svndiff_reader_release(reader, chunk_size);
       buffer += chunk_size;
       read += chunk_size;
       left -= chunk_size;
@@ -1070,31 +1471,14 @@ svn_txdelta_to_svndiff_stream(svn_txdelta_stream_t *txstream,
                               int compression_level,
                               apr_pool_t *pool)
 {
-  svndiff_stream_baton_t *baton;
-  svn_stream_t *push_stream;
+  svn_txdelta__svndiff_reader_t *reader;
   svn_stream_t *pull_stream;
 
-  baton = apr_pcalloc(pool, sizeof(*baton));
-  baton->scratch_pool = svn_pool_create(pool);
-  baton->txstream = txstream;
-  baton->window_buffer = svn_stringbuf_create_empty(pool);
-  baton->hit_eof = FALSE;
-  baton->read_pos = 0;
-
-  push_stream = svn_stream_create(baton, pool);
-  svn_stream_set_write(push_stream, svndiff_stream_write_fn);
-
-  /* We rely on the implementation detail of the svn_txdelta_to_svndiff3()
-     function, namely, on how the window_handler() function behaves.
-     As long as it writes one svndiff window at a time to the target
-     stream, the memory usage of this function (in other words, how
-     much data can be accumulated in the internal 'window_buffer')
-     is limited.  */
-  svn_txdelta_to_svndiff3(&baton->handler, &baton->handler_baton,
-                          push_stream, svndiff_version,
-                          compression_level, pool);
-
-  pull_stream = svn_stream_create(baton, pool);
+  /* Only the current window and its encoded form are kept in memory. */
+  reader = svn_txdelta__svndiff_reader_create(txstream, svndiff_version,
+                                              compression_level, pool);
+
+  pull_stream = svn_stream_create(reader, pool);
   svn_stream_set_read2(pull_stream, NULL, svndiff_stream_read_fn);
 
   return pull_stream;
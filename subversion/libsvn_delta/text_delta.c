@@ -34,6 +34,8 @@
 #include "svn_checksum.h"
 
 #include "delta.h"
+#include "private/svn_delta_private.h"
+#include "private/svn_task.h"
 
 
 /* Text delta stream descriptor. */
@@ -80,6 +82,18 @@ struct tpush_baton {
   apr_size_t source_len;
   svn_boolean_t source_done;
   apr_size_t target_len;
+
+  /* Size of the target windows to produce. */
+  apr_size_t window_size;
+
+  /* If set, the source view of the next window will begin with the
+     last chunk read for the previous one (txdelta format 2). */
+  svn_boolean_t sliding;
+
+  /* TRUE, if the current source chunk has been read for the next window.
+     Its length. */
+  svn_boolean_t source_read;
+  apr_size_t chunk_len;
 };
 
 
@@ -499,9 +513,260 @@ svn_txdelta(svn_txdelta_stream_t **stream,
 }
 
 
+/* Functions for implementing a delta stream that computes multiple
+   windows concurrently. */
+
+/* Number of windows to read ahead per worker thread.  More than one
+   keeps the workers busy when some windows take longer than others. */
+#define PARALLEL_WINDOWS_PER_THREAD 2
+
+/* Input and output of a single window in the parallel delta stream. */
+struct parallel_window_t {
+  /* Source data followed by target data. */
+  char *buf;
+  apr_size_t source_len;
+  apr_size_t target_len;
+
+  /* Offset of the source data in the source stream. */
+  svn_filesize_t source_offset;
+
+  /* The computed window, allocated in the batch pool. */
+  svn_txdelta_window_t *window;
+};
+
+/* Parallel delta stream baton. */
+struct parallel_txdelta_baton {
+  /* These are copied from parameters passed to svn_txdelta__parallel. */
+  svn_stream_t *source;
+  svn_stream_t *target;
+  int thread_count;
+
+  /* Private data */
+  svn_boolean_t more_source;    /* FALSE if source stream hit EOF. */
+  svn_boolean_t more;           /* FALSE if target stream hit EOF. */
+  svn_filesize_t pos;           /* Offset of next read in source file. */
+
+  /* The current batch of windows.  BATCH_SIZE entries have been
+     allocated, COUNT of them contain windows and the next one to
+     return is at index NEXT. */
+  struct parallel_window_t *windows;
+  int batch_size;
+  int count;
+  int next;
+
+  /* Holds the windows of the current batch. */
+  apr_pool_t *batch_pool;
+
+  svn_checksum_ctx_t *context;  /* If not NULL, the context for computing
+                                   the checksum. */
+  svn_checksum_t *checksum;     /* If non-NULL, the checksum of TARGET. */
+
+  apr_pool_t *result_pool;      /* For results (e.g. checksum) */
+};
+
+/* Implements svn_task__process_func_t.  Compute the window with the
+   given INDEX in the parallel_txdelta_baton PROCESS_BATON. */
+static svn_error_t *
+compute_parallel_window(void **result,
+                        int index,
+                        void *process_baton,
+                        void *thread_context,
+                        svn_cancel_func_t cancel_func,
+                        void *cancel_baton,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  struct parallel_txdelta_baton *b = process_baton;
+  struct parallel_window_t *w = &b->windows[index];
+
+  *result = compute_window(w->buf, w->source_len, w->target_len,
+                           w->source_offset, result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Keep a copy of the window RESULT
+   for the given INDEX in the parallel_txdelta_baton OUTPUT_BATON. */
+static svn_error_t *
+store_parallel_window(void *result,
+                      int index,
+                      void *output_baton,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *scratch_pool)
+{
+  struct parallel_txdelta_baton *b = output_baton;
+  b->windows[index].window = svn_txdelta_window_dup(result, b->batch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the data for the next batch of windows in B and compute them. */
+static svn_error_t *
+read_parallel_batch(struct parallel_txdelta_baton *b)
+{
+  apr_pool_t *task_pool;
+
+  svn_pool_clear(b->batch_pool);
+  b->count = 0;
+  b->next = 0;
+
+  /* Reading happens strictly in stream order, just like in
+     txdelta_next_window. */
+  while (b->more && b->count < b->batch_size)
+    {
+      struct parallel_window_t *w = &b->windows[b->count];
+      apr_size_t source_len = SVN_DELTA_WINDOW_SIZE;
+      apr_size_t target_len = SVN_DELTA_WINDOW_SIZE;
+
+      if (b->more_source)
+        {
+          SVN_ERR(svn_stream_read_full(b->source, w->buf, &source_len));
+          b->more_source = (source_len == SVN_DELTA_WINDOW_SIZE);
+        }
+      else
+        source_len = 0;
+
+      SVN_ERR(svn_stream_read_full(b->target, w->buf + source_len,
+                                   &target_len));
+      b->pos += source_len;
+
+      if (target_len == 0)
+        {
+          /* No target data?  We're done. */
+          if (b->context != NULL)
+            SVN_ERR(svn_checksum_final(&b->checksum, b->context,
+                                       b->result_pool));
+
+          b->more = FALSE;
+          break;
+        }
+      else if (b->context != NULL)
+        SVN_ERR(svn_checksum_update(b->context, w->buf + source_len,
+                                    target_len));
+
+      w->source_len = source_len;
+      w->target_len = target_len;
+      w->source_offset = b->pos - source_len;
+      ++b->count;
+    }
+
+  if (b->count == 0)
+    return SVN_NO_ERROR;
+
+  task_pool = svn_pool_create(b->batch_pool);
+  SVN_ERR(svn_task__run(b->thread_count, b->count,
+                        compute_parallel_window, b,
+                        store_parallel_window, b,
+                        NULL, NULL, NULL, NULL, task_pool));
+  svn_pool_destroy(task_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_txdelta_next_window_fn_t for the parallel delta
+   stream. */
+static svn_error_t *
+parallel_txdelta_next_window(svn_txdelta_window_t **window,
+                             void *baton,
+                             apr_pool_t *pool)
+{
+  struct parallel_txdelta_baton *b = baton;
+
+  if (b->next == b->count)
+    SVN_ERR(read_parallel_batch(b));
+
+  /* Hand out copies, so the window remains valid for as long as POOL
+     does, just like with any other delta stream. */
+  *window = b->next < b->count
+          ? svn_txdelta_window_dup(b->windows[b->next++].window, pool)
+          : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_txdelta_md5_digest_fn_t for the parallel delta
+   stream. */
+static const unsigned char *
+parallel_txdelta_md5_digest(void *baton)
+{
+  struct parallel_txdelta_baton *b = baton;
+
+  /* If there are more windows for this stream, the digest has not yet
+     been calculated.  */
+  if (b->more || b->context == NULL)
+    return NULL;
+
+  return b->checksum->digest;
+}
+
+void
+svn_txdelta__parallel(svn_txdelta_stream_t **stream,
+                      svn_stream_t *source,
+                      svn_stream_t *target,
+                      svn_boolean_t calculate_checksum,
+                      int thread_count,
+                      apr_pool_t *pool)
+{
+  struct parallel_txdelta_baton *b;
+  int i;
+
+  if (thread_count <= 1)
+    {
+      svn_txdelta2(stream, source, target, calculate_checksum, pool);
+      return;
+    }
+
+  b = apr_pcalloc(pool, sizeof(*b));
+  b->source = source;
+  b->target = target;
+  b->thread_count = thread_count;
+  b->more_source = TRUE;
+  b->more = TRUE;
+  b->batch_size = thread_count * PARALLEL_WINDOWS_PER_THREAD;
+  b->windows = apr_pcalloc(pool, b->batch_size * sizeof(*b->windows));
+  for (i = 0; i < b->batch_size; ++i)
+    b->windows[i].buf = apr_palloc(pool, 2 * SVN_DELTA_WINDOW_SIZE);
+
+  b->batch_pool = svn_pool_create(pool);
+  b->context = calculate_checksum
+             ? svn_checksum_ctx_create(svn_checksum_md5, pool)
+             : NULL;
+  b->result_pool = pool;
+
+  *stream = svn_txdelta_stream_create(b, parallel_txdelta_next_window,
+                                      parallel_txdelta_md5_digest, pool);
+}
+
+
 
 /* Functions for implementing a "target push" delta. */
 
+/* Prepare the source view in TB for the next window. */
+static void
+tpush_advance_source(struct tpush_baton *tb)
+{
+  if (!tb->sliding)
+    {
+      tb->source_offset += tb->source_len;
+      tb->source_len = 0;
+    }
+  else if (tb->source_read && tb->chunk_len)
+    {
+      /* Keep the latest chunk as the first half of the next view.
+         Content moved by less than one window will then still be found.
+         Without new source data, the view simply stays as it is. */
+      apr_size_t history_len = tb->source_len - tb->chunk_len;
+
+      memmove(tb->buf, tb->buf + history_len, tb->chunk_len);
+      tb->source_offset += history_len;
+      tb->source_len = tb->chunk_len;
+    }
+
+  tb->source_read = FALSE;
+  tb->target_len = 0;
+}
+
 /* This is the write handler for a target-push delta stream.  It reads
  * source data, buffers target data, and fires off delta windows when
  * the target data buffer is full. */
@@ -518,16 +783,19 @@ tpush_write_handler(void *baton, const char *data, apr_size_t *len)
       svn_pool_clear(pool);
 
       /* Make sure we're all full up on source data, if possible. */
-      if (tb->source_len == 0 && !tb->source_done)
+      if (!tb->source_read && !tb->source_done)
         {
-          tb->source_len = SVN_DELTA_WINDOW_SIZE;
-          SVN_ERR(svn_stream_read_full(tb->source, tb->buf, &tb->source_len));
-          if (tb->source_len < SVN_DELTA_WINDOW_SIZE)
+          tb->chunk_len = tb->window_size;
+          SVN_ERR(svn_stream_read_full(tb->source, tb->buf + tb->source_len,
+                                       &tb->chunk_len));
+          tb->source_len += tb->chunk_len;
+          tb->source_read = TRUE;
+          if (tb->chunk_len < tb->window_size)
             tb->source_done = TRUE;
         }
 
-      /* Copy in the target data, up to SVN_DELTA_WINDOW_SIZE. */
-      chunk_len = SVN_DELTA_WINDOW_SIZE - tb->target_len;
+      /* Copy in the target data, up to the window size. */
+      chunk_len = tb->window_size - tb->target_len;
       if (chunk_len > data_len)
         chunk_len = data_len;
       memcpy(tb->buf + tb->source_len + tb->target_len, data, chunk_len);
@@ -536,14 +804,12 @@ tpush_write_handler(void *baton, const char *data, apr_size_t *len)
       tb->target_len += chunk_len;
 
       /* If we're full of target data, compute and fire off a window. */
-      if (tb->target_len == SVN_DELTA_WINDOW_SIZE)
+      if (tb->target_len == tb->window_size)
         {
           window = compute_window(tb->buf, tb->source_len, tb->target_len,
                                   tb->source_offset, pool);
           SVN_ERR(tb->wh(window, tb->whb));
-          tb->source_offset += tb->source_len;
-          tb->source_len = 0;
-          tb->target_len = 0;
+          tpush_advance_source(tb);
         }
     }
 
@@ -578,21 +844,45 @@ svn_stream_t *
 svn_txdelta_target_push(svn_txdelta_window_handler_t handler,
                         void *handler_baton, svn_stream_t *source,
                         apr_pool_t *pool)
+{
+  return svn_txdelta__target_push(handler, handler_baton, source, 1, 0,
+                                  pool);
+}
+
+svn_stream_t *
+svn_txdelta__target_push(svn_txdelta_window_handler_t handler,
+                         void *handler_baton,
+                         svn_stream_t *source,
+                         int format,
+                         apr_size_t window_size,
+                         apr_pool_t *pool)
 {
   struct tpush_baton *tb;
   svn_stream_t *stream;
 
   /* Initialize baton. */
-  tb = apr_palloc(pool, sizeof(*tb));
+  tb = apr_pcalloc(pool, sizeof(*tb));
   tb->source = source;
   tb->wh = handler;
   tb->whb = handler_baton;
   tb->pool = pool;
-  tb->buf = apr_palloc(pool, 2 * SVN_DELTA_WINDOW_SIZE);
   tb->source_offset = 0;
   tb->source_len = 0;
   tb->source_done = FALSE;
   tb->target_len = 0;
+  tb->sliding = format >= 2;
+
+  if (window_size == 0)
+    window_size = tb->sliding ? SVN_DELTA_LARGE_WINDOW_SIZE
+                              : SVN_DELTA_WINDOW_SIZE;
+  else if (window_size < SVN_DELTA_MIN_WINDOW_SIZE)
+    window_size = SVN_DELTA_MIN_WINDOW_SIZE;
+  else if (window_size > SVN_DELTA_LARGE_WINDOW_SIZE)
+    window_size = SVN_DELTA_LARGE_WINDOW_SIZE;
+
+  /* Format 2 source views may span two windows, plus one for the target. */
+  tb->window_size = window_size;
+  tb->buf = apr_palloc(pool, (tb->sliding ? 3 : 2) * tb->window_size);
 
   /* Create and return writable stream. */
   stream = svn_stream_create(tb, pool);
@@ -622,33 +912,53 @@ size_buffer(char **buf, apr_size_t *buf_size,
   return SVN_NO_ERROR;
 }
 
+/* Overlapping copies with a shorter pattern will grow the chunk they
+ * copy at once up to this size. */
+#define PATTERN_CHUNK_SIZE 4096
+
 /* Copy LEN bytes from SOURCE to TARGET.  Unlike memmove() or memcpy(),
  * create repeating patterns if the source and target ranges overlap.
  * Return a pointer to the first byte after the copied target range.  */
 static APR_INLINE char *
 patterning_copy(char *target, const char *source, apr_size_t len)
 {
+  apr_size_t overlap = target - source;
+
+  /* Most copies don't overlap at all. */
+  if (len <= overlap)
+    {
+      memcpy(target, source, len);
+      return target + len;
+    }
+
+  /* Runs of a single byte are the most frequent overlapping case. */
+  if (overlap == 1)
+    {
+      memset(target, *source, len);
+      return target + len;
+    }
+
   /* If the source and target overlap, repeat the overlapping pattern
-     in the target buffer. Always copy from the source buffer because
-     presumably it will be in the L1 cache after the first iteration
-     and doing this should avoid pipeline stalls due to write/read
-     dependencies. */
-  const apr_size_t overlap = target - source;
+     in the target buffer.  [SOURCE, TARGET) always contains a whole
+     number of pattern repetitions, so we may double the size of each
+     copy until we reach PATTERN_CHUNK_SIZE.  That keeps the number of
+     memcpy() calls low for short patterns.  Always copy from the start
+     of the source buffer because presumably it will be in the L1 cache
+     after the first iteration and doing this should avoid pipeline
+     stalls due to write/read dependencies. */
   while (len > overlap)
     {
       memcpy(target, source, overlap);
       target += overlap;
       len -= overlap;
-    }
 
-  /* Copy any remaining source pattern. */
-  if (len)
-    {
-      memcpy(target, source, len);
-      target += len;
+      if (overlap < PATTERN_CHUNK_SIZE)
+        overlap *= 2;
     }
 
-  return target;
+  /* Copy any remaining source pattern. */
+  memcpy(target, source, len);
+  return target + len;
 }
 
 void
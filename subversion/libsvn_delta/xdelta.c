@@ -29,6 +29,7 @@
 
 #include "svn_hash.h"
 #include "svn_delta.h"
+#include "svn_sorts.h"
 #include "private/svn_string_private.h"
 #include "delta.h"
 
@@ -77,7 +78,13 @@ adler32_replace(apr_uint32_t adler32, const char c_out, const char c_in)
 }
 
 /* Calculate an pseudo-adler32 checksum for MATCH_BLOCKSIZE bytes starting
-   at DATA.  Return the checksum value.  */
+   at DATA.  Return the checksum value.
+
+   Rather than feeding every byte into S2 individually, process 8 bytes at
+   a time:  Their plain sum gets added to S1 while S2 receives 8 times the
+   previous S1 plus the bytes weighted by the number of times they would
+   have been added to S2.  The sums within each chunk are independent of
+   each other, which shortens the dependency chain from 128 to 16 steps. */
 
 static APR_INLINE apr_uint32_t
 init_adler32(const char *data)
@@ -90,14 +97,15 @@ init_adler32(const char *data)
 
   for (; input < last; input += 8)
     {
-      s1 += input[0]; s2 += s1;
-      s1 += input[1]; s2 += s1;
-      s1 += input[2]; s2 += s1;
-      s1 += input[3]; s2 += s1;
-      s1 += input[4]; s2 += s1;
-      s1 += input[5]; s2 += s1;
-      s1 += input[6]; s2 += s1;
-      s1 += input[7]; s2 += s1;
+      apr_uint32_t sum = (input[0] + input[1]) + (input[2] + input[3])
+                       + (input[4] + input[5]) + (input[6] + input[7]);
+      apr_uint32_t weighted = 8 * input[0] + 7 * input[1]
+                            + 6 * input[2] + 5 * input[3]
+                            + 4 * input[4] + 3 * input[5]
+                            + 2 * input[6] +     input[7];
+
+      s2 += 8 * s1 + weighted;
+      s1 += sum;
     }
 
   return s2 * 0x10000 + s1;
@@ -278,7 +286,7 @@ find_match(const struct blocks *blocks,
            apr_size_t pending_insert_start)
 {
   apr_size_t apos, bpos = *bposp;
-  apr_size_t delta, max_delta;
+  apr_size_t delta, max_delta, back_delta;
 
   apos = find_block(blocks, rolling, b + bpos);
 
@@ -294,14 +302,15 @@ find_match(const struct blocks *blocks,
                                     b + bpos + MATCH_BLOCKSIZE,
                                     max_delta);
 
-  /* See if we can extend backwards (max MATCH_BLOCKSIZE-1 steps because A's
-     content has been sampled only every MATCH_BLOCKSIZE positions).  */
-  while (apos > 0 && bpos > pending_insert_start && a[apos-1] == b[bpos-1])
-    {
-      --apos;
-      --bpos;
-      ++delta;
-    }
+  /* See if we can extend backwards (usually max MATCH_BLOCKSIZE-1 steps
+     because A's content has been sampled only every MATCH_BLOCKSIZE
+     positions).  Compare whole machine words where possible.  */
+  max_delta = MIN(apos, bpos - pending_insert_start);
+  back_delta = svn_cstring__reverse_match_length(a + apos, b + bpos,
+                                                 max_delta);
+  apos -= back_delta;
+  bpos -= back_delta;
+  delta += back_delta;
 
   *aposp = apos;
   *bposp = bpos;
@@ -28,16 +28,24 @@
 #include "svn_diff.h"
 #include "svn_types.h"
 
+#include "private/svn_subr_private.h"
+
 #include "diff.h"
 
 #include "svn_private_config.h"
 
-/* Copies the data from ORIGINAL_STREAM to a temporary file, returning both
-   the original and compressed size. */
+/* Compressed data is kept in memory blocks of this size, up to
+   COMPRESSED_MAXSIZE bytes.  Anything beyond that goes to a temporary file,
+   so large binaries don't make the diff balloon in memory. */
+#define COMPRESSED_BLOCKSIZE SVN__STREAM_CHUNK_SIZE
+#define COMPRESSED_MAXSIZE (1024 * 1024)
+
+/* Compresses the data from ORIGINAL_STREAM into a new spill buffer,
+   allocated in RESULT_POOL, and returns it in *RESULT together with the
+   original size. */
 static svn_error_t *
-create_compressed(apr_file_t **result,
+create_compressed(svn_spillbuf_t **result,
                   svn_filesize_t *full_size,
-                  svn_filesize_t *compressed_size,
                   svn_stream_t *original_stream,
                   svn_cancel_func_t cancel_func,
                   void *cancel_baton,
@@ -48,12 +56,11 @@ create_compressed(apr_file_t **result,
   svn_filesize_t bytes_read = 0;
   apr_size_t rd;
 
-  SVN_ERR(svn_io_open_uniquely_named(result, NULL, NULL, "diffgz",
-                                     NULL, svn_io_file_del_on_pool_cleanup,
-                                     result_pool, scratch_pool));
+  *result = svn_spillbuf__create(COMPRESSED_BLOCKSIZE, COMPRESSED_MAXSIZE,
+                                 result_pool);
 
   compressed = svn_stream_compressed(
-                  svn_stream_from_aprfile2(*result, TRUE, scratch_pool),
+                  svn_stream__from_spillbuf(*result, scratch_pool),
                   scratch_pool);
 
   if (original_stream)
@@ -80,7 +87,6 @@ create_compressed(apr_file_t **result,
   SVN_ERR(svn_stream_close(compressed)); /* Flush compression */
 
   *full_size = bytes_read;
-  SVN_ERR(svn_io_file_size_get(compressed_size, *result, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -159,73 +165,128 @@ static const char b85lenstr[] =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
     "abcdefghijklmnopqrstuvwxyz";
 
+/* Appends one line of git-like base85 output for the LEN bytes at DATA
+   to OUTPUT.  LEN must be between 1 and GIT_BASE85_CHUNKSIZE. */
+static void
+append_base85_line(svn_stringbuf_t *output,
+                   const unsigned char *data,
+                   apr_size_t len)
+{
+  char line[1 + GIT_BASE85_CHUNKSIZE / 4 * 5];
+  char *p = line;
+
+  *p++ = b85lenstr[len - 1];
+  while (len)
+    {
+      unsigned info = 0;
+      int n;
+
+      /* Push 4 bytes into the 32 bit info, when available */
+      for (n = 24; n >= 0 && len; n -= 8, data++, len--)
+        info |= (*data) << n;
+
+      /* Write out info as base85 */
+      for (n = 4; n >= 0; n--)
+        {
+          p[n] = b85str[info % 85];
+          info /= 85;
+        }
+      p += 5;
+    }
+
+  svn_stringbuf_appendbytes(output, line, p - line);
+  svn_stringbuf_appendbytes(output, APR_EOL_STR, sizeof(APR_EOL_STR) - 1);
+}
+
+/* Writes the contents of BUFFER to OUTPUT_STREAM and empties it. */
+static svn_error_t *
+flush_output(svn_stringbuf_t *buffer,
+             svn_stream_t *output_stream)
+{
+  apr_size_t len = buffer->len;
+
+  SVN_ERR(svn_stream_write(output_stream, buffer->data, &len));
+  svn_stringbuf_setempty(buffer);
+
+  return SVN_NO_ERROR;
+}
+
 /* Writes out a git-like literal output of the compressed data in
    COMPRESSED_DATA to OUTPUT_STREAM, describing that its normal length is
-   UNCOMPRESSED_SIZE. */
+   UNCOMPRESSED_SIZE.  The encoded lines are collected in a buffer of
+   bounded size and written in large blocks. */
 static svn_error_t *
 write_literal(svn_filesize_t uncompressed_size,
-              svn_stream_t *compressed_data,
+              svn_spillbuf_t *compressed_data,
               svn_stream_t *output_stream,
               svn_cancel_func_t cancel_func,
               void *cancel_baton,
               apr_pool_t *scratch_pool)
 {
-  apr_size_t rd;
-  SVN_ERR(svn_stream_seek(compressed_data, NULL)); /* Seek to start */
+  unsigned char chunk[GIT_BASE85_CHUNKSIZE];
+  apr_size_t chunk_len = 0;
+  svn_stringbuf_t *output
+    = svn_stringbuf_create_ensure(SVN__STREAM_CHUNK_SIZE, scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
 
   SVN_ERR(svn_stream_printf(output_stream, scratch_pool,
                             "literal %" SVN_FILESIZE_T_FMT APR_EOL_STR,
                             uncompressed_size));
 
-  do
+  while (TRUE)
     {
-      char chunk[GIT_BASE85_CHUNKSIZE];
-      const unsigned char *next;
-      apr_size_t left;
+      const char *data;
+      apr_size_t len;
 
-      rd = sizeof(chunk);
+      svn_pool_clear(iterpool);
 
       if (cancel_func)
         SVN_ERR(cancel_func(cancel_baton));
 
-      SVN_ERR(svn_stream_read_full(compressed_data, chunk, &rd));
-
-      {
-        apr_size_t one = 1;
-        SVN_ERR(svn_stream_write(output_stream, &b85lenstr[rd-1], &one));
-      }
-
-      left = rd;
-      next = (void*)chunk;
-      while (left)
-      {
-        char five[5];
-        unsigned info = 0;
-        int n;
-        apr_size_t five_sz;
+      SVN_ERR(svn_spillbuf__read(&data, &len, compressed_data, iterpool));
+      if (data == NULL)
+        break;
 
-        /* Push 4 bytes into the 32 bit info, when available */
-        for (n = 24; n >= 0 && left; n -= 8, next++, left--)
+      while (len)
         {
-            info |= (*next) << n;
+          /* Encode full lines directly from the block and collect the
+             rest in CHUNK. */
+          if (chunk_len == 0 && len >= GIT_BASE85_CHUNKSIZE)
+            {
+              append_base85_line(output, (const unsigned char *)data,
+                                 GIT_BASE85_CHUNKSIZE);
+              data += GIT_BASE85_CHUNKSIZE;
+              len -= GIT_BASE85_CHUNKSIZE;
+            }
+          else
+            {
+              apr_size_t n = GIT_BASE85_CHUNKSIZE - chunk_len;
+
+              if (n > len)
+                n = len;
+
+              memcpy(chunk + chunk_len, data, n);
+              chunk_len += n;
+              data += n;
+              len -= n;
+
+              if (chunk_len < GIT_BASE85_CHUNKSIZE)
+                continue;
+
+              append_base85_line(output, chunk, chunk_len);
+              chunk_len = 0;
+            }
+
+          if (output->len >= SVN__STREAM_CHUNK_SIZE)
+            SVN_ERR(flush_output(output, output_stream));
         }
-
-        /* Write out info as base85 */
-        for (n = 4; n >= 0; n--)
-        {
-            five[n] = b85str[info % 85];
-            info /= 85;
-        }
-
-        five_sz = 5;
-        SVN_ERR(svn_stream_write(output_stream, five, &five_sz));
-      }
-
-      SVN_ERR(svn_stream_puts(output_stream, APR_EOL_STR));
     }
-  while (rd == GIT_BASE85_CHUNKSIZE);
+  svn_pool_destroy(iterpool);
 
-  return SVN_NO_ERROR;
+  if (chunk_len)
+    append_base85_line(output, chunk, chunk_len);
+
+  return svn_error_trace(flush_output(output, output_stream));
 }
 
 svn_error_t *
@@ -236,20 +297,18 @@ svn_diff_output_binary(svn_stream_t *output_stream,
                        void *cancel_baton,
                        apr_pool_t *scratch_pool)
 {
-  apr_file_t *original_apr;
+  svn_spillbuf_t *original_compressed;
   svn_filesize_t original_full;
-  svn_filesize_t original_deflated;
-  apr_file_t *latest_apr;
+  svn_spillbuf_t *latest_compressed;
   svn_filesize_t latest_full;
-  svn_filesize_t latest_deflated;
   apr_pool_t *subpool = svn_pool_create(scratch_pool);
 
-  SVN_ERR(create_compressed(&original_apr, &original_full, &original_deflated,
+  SVN_ERR(create_compressed(&original_compressed, &original_full,
                             original, cancel_func, cancel_baton,
                             scratch_pool, subpool));
   svn_pool_clear(subpool);
 
-  SVN_ERR(create_compressed(&latest_apr, &latest_full, &latest_deflated,
+  SVN_ERR(create_compressed(&latest_compressed, &latest_full,
                             latest,  cancel_func, cancel_baton,
                             scratch_pool, subpool));
   svn_pool_clear(subpool);
@@ -259,22 +318,18 @@ svn_diff_output_binary(svn_stream_t *output_stream,
   /* ### git would first calculate if a git-delta latest->original would be
          shorter than the zipped data. For now lets assume that it is not
          and just dump the literal data */
-  SVN_ERR(write_literal(latest_full,
-                        svn_stream_from_aprfile2(latest_apr, FALSE, subpool),
-                        output_stream,
+  SVN_ERR(write_literal(latest_full, latest_compressed, output_stream,
                         cancel_func, cancel_baton,
-                        scratch_pool));
+                        subpool));
   svn_pool_clear(subpool);
   SVN_ERR(svn_stream_puts(output_stream, APR_EOL_STR));
 
   /* ### git would first calculate if a git-delta original->latest would be
          shorter than the zipped data. For now lets assume that it is not
          and just dump the literal data */
-  SVN_ERR(write_literal(original_full,
-                        svn_stream_from_aprfile2(original_apr, FALSE, subpool),
-                        output_stream,
+  SVN_ERR(write_literal(original_full, original_compressed, output_stream,
                         cancel_func, cancel_baton,
-                        scratch_pool));
+                        subpool));
   svn_pool_destroy(subpool);
 
   return SVN_NO_ERROR;
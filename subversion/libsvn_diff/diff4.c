@@ -166,10 +166,11 @@ adjust_diff(svn_diff_t *diff, svn_diff_t *adjust)
 }
 
 svn_error_t *
-svn_diff_diff4_2(svn_diff_t **diff,
-                 void *diff_baton,
-                 const svn_diff_fns2_t *vtable,
-                 apr_pool_t *pool)
+svn_diff__diff4_2(svn_diff_t **diff,
+                  void *diff_baton,
+                  const svn_diff_fns2_t *vtable,
+                  svn_diff_file_algorithm_t algorithm,
+                  apr_pool_t *pool)
 {
   svn_diff__tree_t *tree;
   svn_diff__position_t *position_list[4];
@@ -251,7 +252,7 @@ svn_diff_diff4_2(svn_diff_t **diff,
   lcs_ol = svn_diff__lcs(position_list[0], position_list[2],
                          token_counts[0], token_counts[2],
                          num_tokens, prefix_lines,
-                         suffix_lines, subpool3);
+                         suffix_lines, algorithm, subpool3);
   diff_ol = svn_diff__diff(lcs_ol, 1, 1, TRUE, pool);
 
   svn_pool_clear(subpool3);
@@ -275,7 +276,7 @@ svn_diff_diff4_2(svn_diff_t **diff,
   lcs_adjust = svn_diff__lcs(position_list[3], position_list[2],
                              token_counts[3], token_counts[2],
                              num_tokens, prefix_lines,
-                             suffix_lines, subpool3);
+                             suffix_lines, algorithm, subpool3);
   diff_adjust = svn_diff__diff(lcs_adjust, 1, 1, FALSE, subpool3);
   adjust_diff(diff_ol, diff_adjust);
 
@@ -287,7 +288,7 @@ svn_diff_diff4_2(svn_diff_t **diff,
   lcs_adjust = svn_diff__lcs(position_list[1], position_list[3],
                              token_counts[1], token_counts[3],
                              num_tokens, prefix_lines,
-                             suffix_lines, subpool3);
+                             suffix_lines, algorithm, subpool3);
   diff_adjust = svn_diff__diff(lcs_adjust, 1, 1, FALSE, subpool3);
   adjust_diff(diff_ol, diff_adjust);
 
@@ -302,7 +303,8 @@ svn_diff_diff4_2(svn_diff_t **diff,
       if (hunk->type == svn_diff__type_conflict)
         {
           svn_diff__resolve_conflict(hunk, &position_list[1],
-                                     &position_list[2], num_tokens, pool);
+                                     &position_list[2], num_tokens,
+                                     algorithm, pool);
         }
     }
 
@@ -312,3 +314,14 @@ svn_diff_diff4_2(svn_diff_t **diff,
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_diff_diff4_2(svn_diff_t **diff,
+                 void *diff_baton,
+                 const svn_diff_fns2_t *vtable,
+                 apr_pool_t *pool)
+{
+  return svn_error_trace(svn_diff__diff4_2(diff, diff_baton, vtable,
+                                           svn_diff_file_algorithm_default,
+                                           pool));
+}
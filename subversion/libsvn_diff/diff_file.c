@@ -86,6 +86,10 @@ typedef struct svn_diff__file_baton_t
     char *curp;    /* current position in the current chunk */
     char *endp;    /* next memory address after the current chunk */
 
+    /* If not NULL, the whole file is mapped into memory at this address
+       and BUFFER points into it instead of holding a copy of the chunk. */
+    char *map;
+
     svn_diff__normalize_state_t normalize_state;
 
     /* Where the identical suffix starts in this datasource */
@@ -152,6 +156,55 @@ read_chunk(apr_file_t *file,
 }
 
 
+/* Make *BUFFER point to the LENGTH bytes at OFFSET in FILE.  If FILE is
+ * mapped into memory, just point into the mapping.  Otherwise, read the
+ * data into the memory that *BUFFER points to.
+ */
+static APR_INLINE svn_error_t *
+load_chunk(char **buffer, const struct file_info *file,
+           apr_off_t length, apr_off_t offset,
+           apr_pool_t *scratch_pool)
+{
+  if (file->map)
+    {
+      *buffer = file->map + offset;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(read_chunk(file->file, *buffer, length, offset,
+                                    scratch_pool));
+}
+
+/* Map the open FILE into memory, if that is sensible, and set FILE->MAP
+ * accordingly.  Small files are cheaper to read in a single chunk.  The
+ * mapping is read-only, so don't map files whose contents will need to
+ * be normalized in place according to OPTIONS.  If mapping fails, e.g.
+ * for special files, silently fall back to reading chunks.  Allocate the
+ * mapping in POOL.
+ */
+static void
+map_file(struct file_info *file,
+         const svn_diff_file_options_t *options,
+         apr_pool_t *pool)
+{
+#if APR_HAS_MMAP
+  apr_mmap_t *mm;
+#endif
+
+  file->map = NULL;
+
+#if APR_HAS_MMAP
+  if (file->size <= CHUNK_SIZE || file->size > APR_SIZE_MAX
+      || options->ignore_space || options->ignore_eol_style)
+    return;
+
+  if (apr_mmap_create(&mm, file->file, 0, (apr_size_t)file->size,
+                      APR_MMAP_READ, pool) == APR_SUCCESS)
+    file->map = mm->mm;
+#endif /* APR_HAS_MMAP */
+}
+
+
 /* Map or read a file at PATH. *BUFFER will point to the file
  * contents; if the file was mapped, *FILE and *MM will contain the
  * mmap context; otherwise they will be NULL.  SIZE will contain the
@@ -288,7 +341,7 @@ increment_chunk(struct file_info *file, apr_pool_t *pool)
       file->chunk++;
       length = file->chunk == last_chunk ?
         offset_in_chunk(file->size) : CHUNK_SIZE;
-      SVN_ERR(read_chunk(file->file, file->buffer,
+      SVN_ERR(load_chunk(&file->buffer, file,
                          length, chunk_to_offset(file->chunk),
                          pool));
       file->endp = file->buffer + length;
@@ -315,7 +368,7 @@ decrement_chunk(struct file_info *file, apr_pool_t *pool)
     {
       /* Read previous chunk and reset pointers. */
       file->chunk--;
-      SVN_ERR(read_chunk(file->file, file->buffer,
+      SVN_ERR(load_chunk(&file->buffer, file,
                          CHUNK_SIZE, chunk_to_offset(file->chunk),
                          pool));
       file->endp = file->buffer + CHUNK_SIZE;
@@ -370,6 +423,62 @@ static svn_boolean_t contains_eol(apr_uintptr_t chunk)
 
   return (r_test & n_test & SVN__BIT_7_SET) != SVN__BIT_7_SET;
 }
+
+/* Return the number of eol sequences that find_identical_prefix() counts
+ * when it steps over the LEN bytes at DATA one by one.  *HAD_CR tells
+ * whether the byte before DATA was a '\r' and is updated for the last
+ * byte of DATA. */
+static apr_off_t
+count_eols_forward(const char *data, apr_size_t len, svn_boolean_t *had_cr)
+{
+  apr_off_t lines = 0;
+  const char *end = data + len;
+
+  for (; data < end; data++)
+    {
+      if (*data == '\r')
+        {
+          lines++;
+          *had_cr = TRUE;
+        }
+      else
+        {
+          if (*data == '\n' && !*had_cr)
+            lines++;
+          *had_cr = FALSE;
+        }
+    }
+
+  return lines;
+}
+
+/* Return the number of eol sequences that find_identical_suffix() counts
+ * when it steps backwards over the LEN bytes that end at LAST (inclusive)
+ * one by one.  *HAD_NL tells whether the byte after LAST was a '\n' and
+ * is updated for the first byte of the range. */
+static apr_off_t
+count_eols_backward(const char *last, apr_size_t len, svn_boolean_t *had_nl)
+{
+  apr_off_t lines = 0;
+  const char *start = last - len;
+
+  for (; last > start; last--)
+    {
+      if (*last == '\n')
+        {
+          lines++;
+          *had_nl = TRUE;
+        }
+      else
+        {
+          if (*last == '\r' && !*had_nl)
+            lines++;
+          *had_nl = FALSE;
+        }
+    }
+
+  return lines;
+}
 #endif
 
 /* Find the prefix which is identical between all elements of the FILE array.
@@ -434,36 +543,34 @@ find_identical_prefix(svn_boolean_t *reached_one_eof, apr_off_t *prefix_lines,
             max_delta = delta;
         }
 
-      is_match = TRUE;
+      /* Don't stop at EOLs.  Most words of typical text contain none and
+       * for those that do, we count them here just like the byte-wise
+       * loop above would.  The per-file comparisons get OR-ed together,
+       * so there is only a single branch per word for 2 and 3 files. */
       for (delta = 0; delta < max_delta; delta += sizeof(apr_uintptr_t))
         {
           apr_uintptr_t chunk = *(const apr_uintptr_t *)(file[0].curp + delta);
-          if (contains_eol(chunk))
-            break;
+          apr_uintptr_t mismatch = 0;
 
           for (i = 1; i < file_len; i++)
-            if (chunk != *(const apr_uintptr_t *)(file[i].curp + delta))
-              {
-                is_match = FALSE;
-                break;
-              }
+            mismatch |= chunk ^ *(const apr_uintptr_t *)(file[i].curp + delta);
 
-          if (! is_match)
+          if (mismatch)
             break;
+
+          if (contains_eol(chunk))
+            lines += count_eols_forward(file[0].curp + delta,
+                                        sizeof(apr_uintptr_t), &had_cr);
+          else
+            had_cr = FALSE;
         }
 
+      /* We either found a mismatch at or shortly behind curp+delta or we
+       * cannot proceed with chunky ops without exceeding endp.  In any way,
+       * everything up to curp + delta is equal and has been counted. */
       if (delta /* > 0*/)
-        {
-          /* We either found a mismatch or an EOL at or shortly behind curp+delta
-           * or we cannot proceed with chunky ops without exceeding endp.
-           * In any way, everything up to curp + delta is equal and not an EOL.
-           */
-          for (i = 0; i < file_len; i++)
-            file[i].curp += delta;
-
-          /* Skipped data without EOL markers, so last char was not a CR. */
-          had_cr = FALSE;
-        }
+        for (i = 0; i < file_len; i++)
+          file[i].curp += delta;
 #endif
 
       *reached_one_eof = is_one_at_eof(file, file_len);
@@ -554,6 +661,7 @@ find_identical_suffix(apr_off_t *suffix_lines, struct file_info file[],
       file_for_suffix[i].path = file[i].path;
       file_for_suffix[i].file = file[i].file;
       file_for_suffix[i].size = file[i].size;
+      file_for_suffix[i].map = file[i].map;
       file_for_suffix[i].chunk =
         (int) offset_to_chunk(file_for_suffix[i].size); /* last chunk */
       length[i] = offset_in_chunk(file_for_suffix[i].size);
@@ -569,6 +677,13 @@ find_identical_suffix(apr_off_t *suffix_lines, struct file_info file[],
           /* Prefix ended in last chunk, so we can reuse the prefix buffer */
           file_for_suffix[i].buffer = file[i].buffer;
         }
+      else if (file_for_suffix[i].map)
+        {
+          SVN_ERR(load_chunk(&file_for_suffix[i].buffer, &file_for_suffix[i],
+                             length[i],
+                             chunk_to_offset(file_for_suffix[i].chunk),
+                             pool));
+        }
       else
         {
           /* There is at least more than 1 chunk,
@@ -654,6 +769,7 @@ find_identical_suffix(apr_off_t *suffix_lines, struct file_info file[],
       while (can_read_word)
         {
           apr_uintptr_t chunk;
+          apr_uintptr_t mismatch = 0;
 
           /* For each file curp is positioned at the current byte, but we
              want to examine the current byte and the ones before the current
@@ -661,18 +777,21 @@ find_identical_suffix(apr_off_t *suffix_lines, struct file_info file[],
 
           chunk = *(const apr_uintptr_t *)(file_for_suffix[0].curp + 1
                                              - sizeof(apr_uintptr_t));
-          if (contains_eol(chunk))
-            break;
-
-          for (i = 1, is_match = TRUE; is_match && i < file_len; i++)
-            is_match = (chunk
-                           == *(const apr_uintptr_t *)
+          for (i = 1; i < file_len; i++)
+            mismatch |= chunk ^ *(const apr_uintptr_t *)
                                     (file_for_suffix[i].curp + 1
-                                       - sizeof(apr_uintptr_t)));
+                                       - sizeof(apr_uintptr_t));
 
-          if (! is_match)
+          if (mismatch)
             break;
 
+          /* Count EOLs like the byte-wise loop above would. */
+          if (contains_eol(chunk))
+            lines += count_eols_backward(file_for_suffix[0].curp,
+                                         sizeof(apr_uintptr_t), &had_nl);
+          else
+            had_nl = FALSE;
+
           for (i = 0; i < file_len; i++)
             {
               file_for_suffix[i].curp -= sizeof(apr_uintptr_t);
@@ -681,9 +800,6 @@ find_identical_suffix(apr_off_t *suffix_lines, struct file_info file[],
                                        - sizeof(apr_uintptr_t))
                                   > min_curp[i]);
             }
-
-          /* We skipped some bytes, so there are no closing EOLs */
-          had_nl = FALSE;
         }
 
       /* The > min_curp[i] check leaves at least one final byte for checking
@@ -757,11 +873,11 @@ find_identical_suffix(apr_off_t *suffix_lines, struct file_info file[],
  * BATON's type is (svn_diff__file_baton_t *).
  *
  * For each file in the FILE array, open the file at FILE.path; initialize
- * FILE.file, FILE.size, FILE.buffer, FILE.curp and FILE.endp; allocate a
- * buffer and read the first chunk.  Then find the prefix and suffix lines
- * which are identical between all the files.  Return the number of identical
- * prefix lines in PREFIX_LINES, and the number of identical suffix lines in
- * SUFFIX_LINES.
+ * FILE.file, FILE.size, FILE.map, FILE.buffer, FILE.curp and FILE.endp;
+ * map the file into memory or allocate a buffer and read the first chunk.
+ * Then find the prefix and suffix lines which are identical between all
+ * the files.  Return the number of identical prefix lines in PREFIX_LINES,
+ * and the number of identical suffix lines in SUFFIX_LINES.
  *
  * Finding the identical prefix and suffix allows us to exclude those from the
  * rest of the diff algorithm, which increases performance by reducing the
@@ -799,8 +915,10 @@ datasources_open(void *baton,
       SVN_ERR(svn_io_file_size_get(&filesize, file->file, file_baton->pool));
       file->size = filesize;
       length[i] = filesize > CHUNK_SIZE ? CHUNK_SIZE : filesize;
-      file->buffer = apr_palloc(file_baton->pool, (apr_size_t) length[i]);
-      SVN_ERR(read_chunk(file->file, file->buffer,
+      map_file(file, file_baton->options, file_baton->pool);
+      if (!file->map)
+        file->buffer = apr_palloc(file_baton->pool, (apr_size_t) length[i]);
+      SVN_ERR(load_chunk(&file->buffer, file,
                          length[i], 0, file_baton->pool));
       file->endp = file->buffer + length[i];
       file->curp = file->buffer;
@@ -953,12 +1071,9 @@ datasource_get_next_token(apr_uint32_t *hash, void **token, void *baton,
         h = svn__adler32(h, c, length);
       }
 
-      curp = endp = file->buffer;
       file->chunk++;
       length = file->chunk == last_chunk ?
         offset_in_chunk(file->size) : CHUNK_SIZE;
-      endp += length;
-      file->endp = endp;
 
       /* Issue #4283: Normally we should have checked for reaching the skipped
          suffix here, but because we assume that a suffix always starts on a
@@ -968,10 +1083,12 @@ datasource_get_next_token(apr_uint32_t *hash, void **token, void *baton,
          When changing things here, make sure the whitespace settings are
          applied, or we might not reach the exact suffix boundary as token
          boundary. */
-      SVN_ERR(read_chunk(file->file,
-                         curp, length,
-                         chunk_to_offset(file->chunk),
+      SVN_ERR(load_chunk(&file->buffer, file,
+                         length, chunk_to_offset(file->chunk),
                          file_baton->pool));
+      curp = file->buffer;
+      endp = curp + length;
+      file->endp = endp;
 
       /* If the last chunk ended in a CR, we're done. */
       if (had_cr)
@@ -1062,7 +1179,17 @@ token_compare(void *baton, void *token1, void *token2, int *compare)
       offset[i] = file_token[i]->norm_offset;
       state[i] = svn_diff__normalize_state_normal;
 
-      if (offset_to_chunk(offset[i]) == file[i]->chunk)
+      if (file[i]->map)
+        {
+          /* Mapped files are never normalized, so the whole token is in
+           * memory, right where it was found.
+           */
+          bufp[i] = file[i]->map + offset[i];
+
+          length[i] = total_length;
+          raw_length[i] = 0;
+        }
+      else if (offset_to_chunk(offset[i]) == file[i]->chunk)
         {
           /* If the start of the token is in memory, the entire token is
            * in memory.
@@ -1181,6 +1308,8 @@ static const svn_diff_fns2_t svn_diff__file_vtable =
 
 /* Id for the --ignore-eol-style option, which doesn't have a short name. */
 #define SVN_DIFF__OPT_IGNORE_EOL_STYLE 256
+#define SVN_DIFF__OPT_MINIMAL 257
+#define SVN_DIFF__OPT_PATIENCE 258
 
 /* Options supported by svn_diff_file_options_parse(). */
 static const apr_getopt_option_t diff_options[] =
@@ -1193,6 +1322,8 @@ static const apr_getopt_option_t diff_options[] =
    * ### we don't have optional argument support. */
   { "unified", 'u', 0, NULL },
   { "context", 'U', 1, NULL },
+  { "minimal", SVN_DIFF__OPT_MINIMAL, 0, NULL },
+  { "patience", SVN_DIFF__OPT_PATIENCE, 0, NULL },
   { NULL, 0, 0, NULL }
 };
 
@@ -1298,6 +1429,12 @@ svn_diff_file_options_parse(svn_diff_file_options_t *options,
         case 'U':
           SVN_ERR(svn_cstring_atoi(&options->context_size, opt_arg));
           break;
+        case SVN_DIFF__OPT_MINIMAL:
+          options->algorithm = svn_diff_file_algorithm_minimal;
+          break;
+        case SVN_DIFF__OPT_PATIENCE:
+          options->algorithm = svn_diff_file_algorithm_patience;
+          break;
         default:
           break;
         }
@@ -1326,7 +1463,8 @@ svn_diff_file_diff_2(svn_diff_t **diff,
   baton.files[1].path = modified;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff_2(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff_2(diff, &baton, &svn_diff__file_vtable,
+                           options->algorithm, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
@@ -1348,7 +1486,8 @@ svn_diff_file_diff3_2(svn_diff_t **diff,
   baton.files[2].path = latest;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff3_2(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff3_2(diff, &baton, &svn_diff__file_vtable,
+                            options->algorithm, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
@@ -1372,7 +1511,8 @@ svn_diff_file_diff4_2(svn_diff_t **diff,
   baton.files[3].path = ancestor;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff4_2(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff4_2(diff, &baton, &svn_diff__file_vtable,
+                            options->algorithm, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
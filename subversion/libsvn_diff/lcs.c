@@ -26,6 +26,9 @@
 #include <apr_pools.h>
 #include <apr_general.h>
 
+#include "svn_pools.h"
+#include "svn_sorts.h"
+
 #include "diff.h"
 
 
@@ -184,13 +187,14 @@ svn_diff__snake(svn_diff__snake_t *fp_k,
 }
 
 
+/* Reverse the order of the LCS chain and append TAIL to it. */
 static svn_diff__lcs_t *
-svn_diff__lcs_reverse(svn_diff__lcs_t *lcs)
+svn_diff__lcs_reverse(svn_diff__lcs_t *lcs, svn_diff__lcs_t *tail)
 {
   svn_diff__lcs_t *next;
   svn_diff__lcs_t *prev;
 
-  next = NULL;
+  next = tail;
   while (lcs != NULL)
     {
       prev = lcs->next;
@@ -228,15 +232,25 @@ prepend_lcs(svn_diff__lcs_t *lcs, apr_off_t lines,
 }
 
 
-svn_diff__lcs_t *
-svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
-              svn_diff__position_t *position_list2, /* pointer to tail (ring) */
-              svn_diff__token_index_t *token_counts_list1, /* array of counts */
-              svn_diff__token_index_t *token_counts_list2, /* array of counts */
-              svn_diff__token_index_t num_tokens,
-              apr_off_t prefix_lines,
-              apr_off_t suffix_lines,
-              apr_pool_t *pool)
+/* If the default algorithm needs more than this number of costly steps,
+ * i.e. the files differ in too many places to find a minimal diff quickly,
+ * we fall back to the patience algorithm.  The time spent on the minimal
+ * diff grows with the square of this number. */
+#define MAX_MINIMAL_COST 4096
+
+/* Calculate the minimal LCS of the non-empty POSITION_LIST1 and
+ * POSITION_LIST2 as described at the top of this file, and return it,
+ * followed by TAIL.  If GIVE_UP is set, return NULL instead of a result
+ * as soon as this gets too expensive. */
+static svn_diff__lcs_t *
+minimal_lcs(svn_diff__position_t *position_list1,
+            svn_diff__position_t *position_list2,
+            svn_diff__token_index_t *token_counts_list1,
+            svn_diff__token_index_t *token_counts_list2,
+            svn_diff__token_index_t num_tokens,
+            svn_diff__lcs_t *tail,
+            svn_boolean_t give_up,
+            apr_pool_t *pool)
 {
   apr_off_t length[2];
   svn_diff__token_index_t *token_counts[2];
@@ -250,35 +264,6 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
 
   svn_diff__position_t sentinel_position[2];
 
-  /* Since EOF is always a sync point we tack on an EOF link
-   * with sentinel positions
-   */
-  lcs = apr_palloc(pool, sizeof(*lcs));
-  lcs->position[0] = apr_pcalloc(pool, sizeof(*lcs->position[0]));
-  lcs->position[0]->offset = position_list1
-                             ? position_list1->offset + suffix_lines + 1
-                             : prefix_lines + suffix_lines + 1;
-  lcs->position[1] = apr_pcalloc(pool, sizeof(*lcs->position[1]));
-  lcs->position[1]->offset = position_list2
-                             ? position_list2->offset + suffix_lines + 1
-                             : prefix_lines + suffix_lines + 1;
-  lcs->length = 0;
-  lcs->refcount = 1;
-  lcs->next = NULL;
-
-  if (position_list1 == NULL || position_list2 == NULL)
-    {
-      if (suffix_lines)
-        lcs = prepend_lcs(lcs, suffix_lines,
-                          lcs->position[0]->offset - suffix_lines,
-                          lcs->position[1]->offset - suffix_lines,
-                          pool);
-      if (prefix_lines)
-        lcs = prepend_lcs(lcs, prefix_lines, 1, 1, pool);
-
-      return lcs;
-    }
-
   unique_count[1] = unique_count[0] = 0;
   for (token_index = 0; token_index < num_tokens; token_index++)
     {
@@ -353,21 +338,454 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
 
       p++;
     }
-  while (fp[0].position[1] != &sentinel_position[1]);
+  while (fp[0].position[1] != &sentinel_position[1]
+         && (!give_up || p <= MAX_MINIMAL_COST));
 
-  if (suffix_lines)
-    lcs->next = prepend_lcs(fp[0].lcs, suffix_lines,
-                            lcs->position[0]->offset - suffix_lines,
-                            lcs->position[1]->offset - suffix_lines,
-                            pool);
+  if (fp[0].position[1] == &sentinel_position[1])
+    lcs = svn_diff__lcs_reverse(fp[0].lcs, tail);
   else
-    lcs->next = fp[0].lcs;
-
-  lcs = svn_diff__lcs_reverse(lcs);
+    lcs = NULL;
 
   position_list1->next = sentinel_position[0].next;
   position_list2->next = sentinel_position[1].next;
 
+  return lcs;
+}
+
+
+/*
+ * The patience algorithm does not look for a minimal diff.  Instead, it
+ * pairs up the tokens that occur exactly once in both sources, keeps the
+ * longest sequence of such pairs that appear in the same order in both
+ * and then recurses into the sections between them.  Its run time depends
+ * mostly on the size of the sources and not on the number of differences.
+ */
+
+/* A section of both sources that the patience algorithm still has to
+ * process, or a run of matching tokens that it has found.  Indexes are
+ * relative to the start of the respective source. */
+typedef struct patience_item_t
+{
+  apr_off_t start[2];
+  apr_off_t length[2];
+
+  /* If set, this is a run of LENGTH[0] matching tokens. */
+  svn_boolean_t is_match;
+} patience_item_t;
+
+/* State of the patience algorithm. */
+typedef struct patience_t
+{
+  /* The token indexes of both sources. */
+  svn_diff__token_index_t *tokens[2];
+
+  /* Per token index: The number of occurrences within each source section
+   * and the position of the last one.  Entries are only valid if the
+   * token's GENERATION matches CURRENT_GENERATION. */
+  apr_off_t *count[2];
+  apr_off_t *last[2];
+  apr_off_t *generation;
+  apr_off_t current_generation;
+
+  /* Matching runs found so far, in source order. */
+  apr_array_header_t *matches;
+
+  /* Sections still to process.  The top-most item is the left-most. */
+  apr_array_header_t *stack;
+
+  /* Scratch space for the LIS and the small-section LCS. */
+  apr_off_t *scratch;
+  apr_size_t scratch_size;
+
+  apr_pool_t *pool;
+} patience_t;
+
+/* Sections not exceeding this number of table cells will get diffed
+ * exactly, if they contain no unique lines to anchor the diff. */
+#define PATIENCE_MAX_TABLE_SIZE 0x10000
+
+/* Append the match of LENGTH tokens at START0 and START1 to P->MATCHES,
+ * merging it with the previous match if they are adjacent. */
+static void
+patience_add_match(patience_t *p,
+                   apr_off_t start0,
+                   apr_off_t start1,
+                   apr_off_t length)
+{
+  patience_item_t *last;
+
+  if (length == 0)
+    return;
+
+  if (p->matches->nelts)
+    {
+      last = &APR_ARRAY_IDX(p->matches, p->matches->nelts - 1,
+                            patience_item_t);
+      if (last->start[0] + last->length[0] == start0
+          && last->start[1] + last->length[1] == start1)
+        {
+          last->length[0] += length;
+          last->length[1] += length;
+          return;
+        }
+    }
+
+  last = apr_array_push(p->matches);
+  last->start[0] = start0;
+  last->start[1] = start1;
+  last->length[0] = length;
+  last->length[1] = length;
+  last->is_match = TRUE;
+}
+
+/* Push the section or match given by START0, LENGTH0, START1, LENGTH1
+ * and IS_MATCH onto P->STACK. */
+static void
+patience_push(patience_t *p,
+              apr_off_t start0,
+              apr_off_t length0,
+              apr_off_t start1,
+              apr_off_t length1,
+              svn_boolean_t is_match)
+{
+  patience_item_t *item;
+
+  if (length0 == 0 && length1 == 0)
+    return;
+
+  item = apr_array_push(p->stack);
+  item->start[0] = start0;
+  item->start[1] = start1;
+  item->length[0] = length0;
+  item->length[1] = length1;
+  item->is_match = is_match;
+}
+
+/* Make sure that P->SCRATCH can hold at least SIZE elements. */
+static void
+patience_ensure_scratch(patience_t *p, apr_size_t size)
+{
+  if (p->scratch_size < size)
+    {
+      p->scratch_size = MAX(size, 2 * p->scratch_size);
+      p->scratch = apr_palloc(p->pool,
+                              p->scratch_size * sizeof(*p->scratch));
+    }
+}
+
+/* Find the exact LCS of the section ITEM using a table and add its
+ * matches to P.  ITEM must be small enough. */
+static void
+patience_table_lcs(patience_t *p, const patience_item_t *item)
+{
+  const svn_diff__token_index_t *tokens0 = p->tokens[0] + item->start[0];
+  const svn_diff__token_index_t *tokens1 = p->tokens[1] + item->start[1];
+  apr_off_t width = item->length[1] + 1;
+  apr_off_t *table;
+  apr_off_t i, j;
+
+  /* TABLE[i * WIDTH + j] is the LCS length of the section suffixes that
+   * start at I and J, respectively. */
+  patience_ensure_scratch(p, (item->length[0] + 1) * width);
+  table = p->scratch;
+
+  for (j = 0; j < width; j++)
+    table[item->length[0] * width + j] = 0;
+
+  for (i = item->length[0] - 1; i >= 0; i--)
+    {
+      table[i * width + item->length[1]] = 0;
+      for (j = item->length[1] - 1; j >= 0; j--)
+        if (tokens0[i] == tokens1[j])
+          table[i * width + j] = table[(i + 1) * width + j + 1] + 1;
+        else
+          table[i * width + j] = MAX(table[(i + 1) * width + j],
+                                     table[i * width + j + 1]);
+    }
+
+  for (i = 0, j = 0; i < item->length[0] && j < item->length[1]; )
+    if (tokens0[i] == tokens1[j])
+      {
+        patience_add_match(p, item->start[0] + i, item->start[1] + j, 1);
+        i++;
+        j++;
+      }
+    else if (table[(i + 1) * width + j] >= table[i * width + j + 1])
+      i++;
+    else
+      j++;
+}
+
+/* Process the section ITEM: Match its common start and end, anchor the
+ * remainder at the longest increasing sequence of tokens that occur
+ * exactly once in both sources and push the sections in between onto
+ * P->STACK. */
+static void
+patience_section(patience_t *p, patience_item_t item)
+{
+  const svn_diff__token_index_t *tokens0 = p->tokens[0];
+  const svn_diff__token_index_t *tokens1 = p->tokens[1];
+  apr_off_t head = 0;
+  apr_off_t tail = 0;
+  apr_off_t end0, end1;
+  apr_off_t anchors, longest;
+  apr_off_t *lis_ends, *lis_prev, *anchor0;
+  apr_off_t i;
+
+  while (head < item.length[0] && head < item.length[1]
+         && tokens0[item.start[0] + head] == tokens1[item.start[1] + head])
+    head++;
+
+  patience_add_match(p, item.start[0], item.start[1], head);
+  item.start[0] += head;
+  item.start[1] += head;
+  item.length[0] -= head;
+  item.length[1] -= head;
+
+  end0 = item.start[0] + item.length[0];
+  end1 = item.start[1] + item.length[1];
+  while (tail < item.length[0] && tail < item.length[1]
+         && tokens0[end0 - tail - 1] == tokens1[end1 - tail - 1])
+    tail++;
+
+  /* The common end gets reported after everything else in this section. */
+  patience_push(p, end0 - tail, tail, end1 - tail, tail, TRUE);
+  item.length[0] -= tail;
+  item.length[1] -= tail;
+  end0 -= tail;
+  end1 -= tail;
+
+  if (item.length[0] == 0 || item.length[1] == 0)
+    return;
+
+  /* Count the tokens in both parts of the section. */
+  p->current_generation++;
+  for (i = item.start[0]; i < end0; i++)
+    {
+      svn_diff__token_index_t token = tokens0[i];
+      if (p->generation[token] != p->current_generation)
+        {
+          p->generation[token] = p->current_generation;
+          p->count[0][token] = 0;
+          p->count[1][token] = 0;
+        }
+
+      p->count[0][token]++;
+      p->last[0][token] = i;
+    }
+
+  for (i = item.start[1]; i < end1; i++)
+    {
+      svn_diff__token_index_t token = tokens1[i];
+      if (p->generation[token] == p->current_generation)
+        {
+          p->count[1][token]++;
+          p->last[1][token] = i;
+        }
+    }
+
+  /* Find the longest sequence of unique tokens that appear in the same
+   * order in both parts using patience sorting.  LIS_ENDS[l] is the
+   * anchor that ends the best sequence of length L+1 found so far and
+   * LIS_PREV links each anchor to its predecessor within its sequence.
+   * ANCHOR0 maps anchors to their positions in the first source. */
+  patience_ensure_scratch(p, 3 * MIN(item.length[0], item.length[1]));
+  lis_ends = p->scratch;
+  lis_prev = lis_ends + MIN(item.length[0], item.length[1]);
+  anchor0 = lis_prev + MIN(item.length[0], item.length[1]);
+
+  anchors = 0;
+  longest = 0;
+  for (i = item.start[0]; i < end0; i++)
+    {
+      svn_diff__token_index_t token = tokens0[i];
+      apr_off_t pos1, low, high;
+
+      if (p->count[0][token] != 1 || p->count[1][token] != 1)
+        continue;
+
+      /* Binary search for the first sequence end at or after POS1. */
+      pos1 = p->last[1][token];
+      low = 0;
+      high = longest;
+      while (low < high)
+        {
+          apr_off_t mid = low + (high - low) / 2;
+          if (p->last[1][tokens0[anchor0[lis_ends[mid]]]] < pos1)
+            low = mid + 1;
+          else
+            high = mid;
+        }
+
+      anchor0[anchors] = i;
+      lis_prev[anchors] = low ? lis_ends[low - 1] : -1;
+      lis_ends[low] = anchors;
+      if (low == longest)
+        longest++;
+
+      anchors++;
+    }
+
+  if (longest == 0)
+    {
+      /* No anchors.  Diff small sections exactly and report all others
+       * as completely changed. */
+      if ((item.length[0] + 1) * (item.length[1] + 1)
+          <= PATIENCE_MAX_TABLE_SIZE)
+        patience_table_lcs(p, &item);
+
+      return;
+    }
+
+  /* Push the sections between the anchors from right to left, so the
+   * left-most one gets processed first. */
+  for (i = lis_ends[longest - 1]; i >= 0; i = lis_prev[i])
+    {
+      apr_off_t pos0 = anchor0[i];
+      apr_off_t pos1 = p->last[1][tokens0[pos0]];
+
+      patience_push(p, pos0 + 1, end0 - pos0 - 1, pos1 + 1, end1 - pos1 - 1,
+                    FALSE);
+      patience_push(p, pos0, 1, pos1, 1, TRUE);
+      end0 = pos0;
+      end1 = pos1;
+    }
+
+  patience_push(p, item.start[0], end0 - item.start[0],
+                item.start[1], end1 - item.start[1], FALSE);
+}
+
+/* Calculate the LCS of the non-empty POSITION_LIST1 and POSITION_LIST2
+ * using the patience algorithm and return it, followed by TAIL. */
+static svn_diff__lcs_t *
+patience_lcs(svn_diff__position_t *position_list1,
+             svn_diff__position_t *position_list2,
+             svn_diff__token_index_t num_tokens,
+             svn_diff__lcs_t *tail,
+             apr_pool_t *pool)
+{
+  svn_diff__position_t *position_list[2];
+  svn_diff__position_t **positions[2];
+  apr_off_t length[2];
+  patience_t p = { { 0 } };
+  patience_item_t item;
+  svn_diff__lcs_t *lcs;
+  int i;
+
+  position_list[0] = position_list1;
+  position_list[1] = position_list2;
+
+  p.pool = svn_pool_create(pool);
+  for (i = 0; i < 2; i++)
+    {
+      svn_diff__position_t *position = position_list[i]->next;
+      apr_off_t k;
+
+      length[i] = position_list[i]->offset - position->offset + 1;
+      positions[i] = apr_palloc(p.pool, length[i] * sizeof(*positions[i]));
+      p.tokens[i] = apr_palloc(p.pool, length[i] * sizeof(*p.tokens[i]));
+      for (k = 0; k < length[i]; k++, position = position->next)
+        {
+          positions[i][k] = position;
+          p.tokens[i][k] = position->token_index;
+        }
+
+      p.count[i] = apr_palloc(p.pool, num_tokens * sizeof(*p.count[i]));
+      p.last[i] = apr_palloc(p.pool, num_tokens * sizeof(*p.last[i]));
+    }
+
+  p.generation = apr_pcalloc(p.pool, num_tokens * sizeof(*p.generation));
+  p.matches = apr_array_make(p.pool, 16, sizeof(patience_item_t));
+  p.stack = apr_array_make(p.pool, 16, sizeof(patience_item_t));
+
+  patience_push(&p, 0, length[0], 0, length[1], FALSE);
+  while (p.stack->nelts)
+    {
+      item = *(patience_item_t *)apr_array_pop(p.stack);
+      if (item.is_match)
+        patience_add_match(&p, item.start[0], item.start[1], item.length[0]);
+      else
+        patience_section(&p, item);
+    }
+
+  /* Like svn_diff__snake(), refer to the actual positions, so that
+   * callers can continue to walk the position lists from there. */
+  lcs = tail;
+  for (i = p.matches->nelts - 1; i >= 0; i--)
+    {
+      const patience_item_t *match = &APR_ARRAY_IDX(p.matches, i,
+                                                    patience_item_t);
+      svn_diff__lcs_t *new_lcs = apr_palloc(pool, sizeof(*new_lcs));
+
+      new_lcs->position[0] = positions[0][match->start[0]];
+      new_lcs->position[1] = positions[1][match->start[1]];
+      new_lcs->length = match->length[0];
+      new_lcs->refcount = 1;
+      new_lcs->next = lcs;
+      lcs = new_lcs;
+    }
+
+  svn_pool_destroy(p.pool);
+
+  return lcs;
+}
+
+
+svn_diff__lcs_t *
+svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
+              svn_diff__position_t *position_list2, /* pointer to tail (ring) */
+              svn_diff__token_index_t *token_counts_list1, /* array of counts */
+              svn_diff__token_index_t *token_counts_list2, /* array of counts */
+              svn_diff__token_index_t num_tokens,
+              apr_off_t prefix_lines,
+              apr_off_t suffix_lines,
+              svn_diff_file_algorithm_t algorithm,
+              apr_pool_t *pool)
+{
+  svn_diff__lcs_t *lcs;
+  svn_diff__lcs_t *tail;
+
+  /* Since EOF is always a sync point we tack on an EOF link
+   * with sentinel positions
+   */
+  lcs = apr_palloc(pool, sizeof(*lcs));
+  lcs->position[0] = apr_pcalloc(pool, sizeof(*lcs->position[0]));
+  lcs->position[0]->offset = position_list1
+                             ? position_list1->offset + suffix_lines + 1
+                             : prefix_lines + suffix_lines + 1;
+  lcs->position[1] = apr_pcalloc(pool, sizeof(*lcs->position[1]));
+  lcs->position[1]->offset = position_list2
+                             ? position_list2->offset + suffix_lines + 1
+                             : prefix_lines + suffix_lines + 1;
+  lcs->length = 0;
+  lcs->refcount = 1;
+  lcs->next = NULL;
+
+  if (suffix_lines)
+    tail = prepend_lcs(lcs, suffix_lines,
+                       lcs->position[0]->offset - suffix_lines,
+                       lcs->position[1]->offset - suffix_lines,
+                       pool);
+  else
+    tail = lcs;
+
+  if (position_list1 == NULL || position_list2 == NULL)
+    lcs = tail;
+  else if (algorithm == svn_diff_file_algorithm_patience)
+    lcs = patience_lcs(position_list1, position_list2, num_tokens, tail,
+                       pool);
+  else
+    {
+      lcs = minimal_lcs(position_list1, position_list2,
+                        token_counts_list1, token_counts_list2, num_tokens,
+                        tail,
+                        algorithm == svn_diff_file_algorithm_default,
+                        pool);
+      if (lcs == NULL)
+        lcs = patience_lcs(position_list1, position_list2, num_tokens, tail,
+                           pool);
+    }
+
   if (prefix_lines)
     return prepend_lcs(lcs, prefix_lines, 1, 1, pool);
   else
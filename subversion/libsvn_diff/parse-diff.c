@@ -54,6 +54,31 @@
 /* Like strlen() but for string literals. */
 #define STRLEN_LITERAL(str) (sizeof(str) - 1)
 
+/* Size of the window a line source keeps in memory. */
+#define LINE_SOURCE_BUFFER_SIZE (64 * 1024)
+
+/* A source of lines at arbitrary offsets within a patch file.  It keeps
+ * a window of the file in memory and serves lines from it, so parsing the
+ * patch and reading hunk texts later on neither reads the file byte by
+ * byte nor seeks for every line.  The window only moves when a line
+ * starts outside of it.  All hunks of a patch file share its source. */
+typedef struct line_source_t
+{
+  /* The patch file, or NULL if all data is in BUFFER. */
+  apr_file_t *file;
+
+  /* The window of data and its capacity. */
+  char *buffer;
+  apr_size_t buffer_size;
+
+  /* The file offset of BUFFER[0] and the number of valid bytes there. */
+  apr_off_t window_start;
+  apr_size_t window_len;
+
+  /* The EOL of the first line in the file, or NULL if not looked up yet. */
+  const char *first_eol;
+} line_source_t;
+
 /* This struct describes a range within a file, as well as the
  * current cursor position within the range. All numbers are in bytes. */
 struct svn_diff__hunk_range {
@@ -66,8 +91,8 @@ struct svn_diff_hunk_t {
   /* The patch this hunk belongs to. */
   const svn_patch_t *patch;
 
-  /* APR file handle to the patch file this hunk came from. */
-  apr_file_t *apr_file;
+  /* The lines of the patch file this hunk came from. */
+  line_source_t *source;
 
   /* Whether the hunk was interpreted as pretty-print mergeinfo. If so,
      the hunk content is in PATCH and the rest of this hunk object is
@@ -104,20 +129,271 @@ struct svn_diff_binary_patch_t {
   /* The patch this hunk belongs to. */
   const svn_patch_t *patch;
 
-  /* APR file handle to the patch file this hunk came from. */
-  apr_file_t *apr_file;
+  /* The lines of the patch file this hunk came from. */
+  line_source_t *source;
 
-  /* Offsets inside APR_FILE representing the location of the patch */
+  /* Offsets inside SOURCE representing the location of the patch */
   apr_off_t src_start;
   apr_off_t src_end;
   svn_filesize_t src_filesize; /* Expanded/final size */
 
-  /* Offsets inside APR_FILE representing the location of the patch */
+  /* Offsets inside SOURCE representing the location of the patch */
   apr_off_t dst_start;
   apr_off_t dst_end;
   svn_filesize_t dst_filesize; /* Expanded/final size */
 };
 
+/* Return a new line source for FILE, allocated in RESULT_POOL. */
+static line_source_t *
+line_source_create(apr_file_t *file,
+                   apr_pool_t *result_pool)
+{
+  line_source_t *source = apr_pcalloc(result_pool, sizeof(*source));
+
+  source->file = file;
+  source->buffer_size = LINE_SOURCE_BUFFER_SIZE;
+  source->buffer = apr_palloc(result_pool, source->buffer_size);
+
+  return source;
+}
+
+/* Return a new line source for the LEN bytes at DATA, allocated in
+ * RESULT_POOL.  DATA must remain valid for the lifetime of the source. */
+static line_source_t *
+line_source_create_from_memory(char *data,
+                               apr_size_t len,
+                               apr_pool_t *result_pool)
+{
+  line_source_t *source = apr_pcalloc(result_pool, sizeof(*source));
+
+  source->buffer = data;
+  source->buffer_size = len;
+  source->window_len = len;
+
+  return source;
+}
+
+/* Return the number of bytes in SOURCE's window at or after OFFSET. */
+static apr_size_t
+line_source_available(const line_source_t *source,
+                      apr_off_t offset)
+{
+  if (offset < source->window_start
+      || offset - source->window_start >= (apr_off_t)source->window_len)
+    return 0;
+
+  return source->window_len - (apr_size_t)(offset - source->window_start);
+}
+
+/* Move SOURCE's window to start at OFFSET unless OFFSET is already inside
+ * of it.  At the end of the file, the window will be empty. */
+static svn_error_t *
+line_source_fill(line_source_t *source,
+                 apr_off_t offset,
+                 apr_pool_t *scratch_pool)
+{
+  apr_size_t len;
+
+  if (source->file == NULL || line_source_available(source, offset))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_io_file_seek(source->file, APR_SET, &offset, scratch_pool));
+  len = source->buffer_size;
+  SVN_ERR(svn_io_file_read_full2(source->file, source->buffer, len, &len,
+                                 NULL, scratch_pool));
+  source->window_start = offset;
+  source->window_len = len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Copy up to *LEN bytes at OFFSET in SOURCE to BUFFER and set *LEN to the
+ * number of bytes copied. */
+static svn_error_t *
+line_source_read(line_source_t *source,
+                 apr_off_t offset,
+                 char *buffer,
+                 apr_size_t *len,
+                 apr_pool_t *scratch_pool)
+{
+  apr_size_t copied = 0;
+
+  while (copied < *len)
+    {
+      apr_size_t available;
+
+      SVN_ERR(line_source_fill(source, offset, scratch_pool));
+      available = line_source_available(source, offset);
+      if (available == 0)
+        break;
+
+      if (available > *len - copied)
+        available = *len - copied;
+
+      memcpy(buffer + copied,
+             source->buffer + (offset - source->window_start), available);
+      copied += available;
+      offset += available;
+    }
+
+  *len = copied;
+  return SVN_NO_ERROR;
+}
+
+/* Read the line starting at *OFFSET in SOURCE and advance *OFFSET to the
+ * start of the next line.  This behaves exactly like svn_io_file_readline()
+ * on a file positioned at *OFFSET, including the handling of MAX_LEN,
+ * but scans SOURCE's window instead of reading single bytes. */
+static svn_error_t *
+line_source_readline(line_source_t *source,
+                     apr_off_t *offset,
+                     svn_stringbuf_t **stringbuf,
+                     const char **eol,
+                     svn_boolean_t *eof,
+                     apr_size_t max_len,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *str = svn_stringbuf_create_ensure(80, result_pool);
+  const char *eol_str = NULL;
+  svn_boolean_t found_eof = FALSE;
+  apr_off_t pos = *offset;
+  apr_size_t len = 0;
+
+  while (TRUE)
+    {
+      const char *data;
+      const char *p;
+      apr_size_t available;
+
+      if (len >= max_len)
+        {
+          found_eof = TRUE;
+          break;
+        }
+
+      SVN_ERR(line_source_fill(source, pos, scratch_pool));
+      available = line_source_available(source, pos);
+      if (available == 0)
+        {
+          found_eof = TRUE;
+          break;
+        }
+
+      if (available > max_len - len)
+        available = max_len - len;
+
+      /* Scan the window for the next EOL character. */
+      data = source->buffer + (pos - source->window_start);
+      for (p = data; p < data + available; p++)
+        if (*p == '\n' || *p == '\r')
+          break;
+
+      svn_stringbuf_appendbytes(str, data, p - data);
+      len += p - data;
+      pos += p - data;
+
+      if (p < data + available)
+        {
+          len++;
+          pos++;
+
+          if (*p == '\n')
+            eol_str = "\n";
+          else
+            {
+              eol_str = "\r";
+
+              /* Check for "\r\n". */
+              if (len < max_len)
+                {
+                  SVN_ERR(line_source_fill(source, pos, scratch_pool));
+                  if (line_source_available(source, pos)
+                      && source->buffer[pos - source->window_start] == '\n')
+                    {
+                      eol_str = "\r\n";
+                      pos++;
+                    }
+                }
+            }
+          break;
+        }
+    }
+
+  *offset = pos;
+  *stringbuf = str;
+  if (eol)
+    *eol = eol_str;
+  if (eof)
+    *eof = found_eof;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *EOL to the EOL of the first line in SOURCE, or to NULL if
+ * SOURCE does not contain an EOL at all. */
+static svn_error_t *
+line_source_get_first_eol(const char **eol,
+                          line_source_t *source,
+                          apr_pool_t *scratch_pool)
+{
+  if (! source->first_eol)
+    {
+      apr_off_t offset = 0;
+      svn_stringbuf_t *str;
+
+      SVN_ERR(line_source_readline(source, &offset, &str, &source->first_eol,
+                                   NULL, APR_SIZE_MAX,
+                                   scratch_pool, scratch_pool));
+    }
+
+  *eol = source->first_eol;
+  return SVN_NO_ERROR;
+}
+
+struct svn_patch_file_t
+{
+  /* The APR file handle to the patch file. */
+  apr_file_t *apr_file;
+
+  /* The lines of the patch file. */
+  line_source_t *source;
+
+  /* The file offset of the next line the parser reads. */
+  apr_off_t next_offset;
+
+  /* Whether the parser has read past the end of the file. */
+  svn_boolean_t eof;
+};
+
+/* Read the next line from PATCH_FILE into *LINE and advance the parser.
+ * Set *EOF if the end of the file has been reached.  Allocate *LINE in
+ * RESULT_POOL and use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_next_line(svn_stringbuf_t **line,
+               svn_boolean_t *eof,
+               svn_patch_file_t *patch_file,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  SVN_ERR(line_source_readline(patch_file->source, &patch_file->next_offset,
+                               line, NULL, eof, APR_SIZE_MAX,
+                               result_pool, scratch_pool));
+  if (*eof)
+    patch_file->eof = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Let the parser of PATCH_FILE continue at OFFSET. */
+static void
+rewind_patch_file(svn_patch_file_t *patch_file,
+                  apr_off_t offset)
+{
+  patch_file->next_offset = offset;
+  patch_file->eof = FALSE;
+}
+
 /* Common guts of svn_diff_hunk__create_adds_single_line() and
  * svn_diff_hunk__create_deletes_single_line().
  *
@@ -136,11 +412,11 @@ add_or_delete_single_line(svn_diff_hunk_t **hunk_out,
   const apr_size_t header_len = strlen(hunk_header[add]);
   const apr_size_t len = strlen(line);
   const apr_size_t end = header_len + (1 + len); /* The +1 is for the \n. */
-  svn_stringbuf_t *buf = svn_stringbuf_create_ensure(end + 1, scratch_pool);
+  svn_stringbuf_t *buf = svn_stringbuf_create_ensure(end + 1, result_pool);
 
   hunk->patch = patch;
 
-  /* hunk->apr_file is created below. */
+  /* hunk->source is created below. */
 
   hunk->diff_text_range.start = header_len;
   hunk->diff_text_range.current = header_len;
@@ -185,7 +461,7 @@ add_or_delete_single_line(svn_diff_hunk_t **hunk_out,
   hunk->leading_context = 0;
   hunk->trailing_context = 0;
 
-  /* Create APR_FILE and put just a hunk in it (without a diff header).
+  /* Put just a hunk in BUF (without a diff header) and read it from there.
    * Save the offset of the last byte of the diff line. */
   svn_stringbuf_appendbytes(buf, hunk_header[add], header_len);
   svn_stringbuf_appendbyte(buf, add ? '+' : '-');
@@ -195,14 +471,8 @@ add_or_delete_single_line(svn_diff_hunk_t **hunk_out,
 
   hunk->diff_text_range.end = buf->len;
 
-  SVN_ERR(svn_io_open_unique_file3(&hunk->apr_file, NULL /* filename */,
-                                   NULL /* system tempdir */,
-                                   svn_io_file_del_on_pool_cleanup,
-                                   result_pool, scratch_pool));
-  SVN_ERR(svn_io_file_write_full(hunk->apr_file,
-                                 buf->data, buf->len,
-                                 NULL, scratch_pool));
-  /* No need to seek. */
+  hunk->source = line_source_create_from_memory(buf->data, buf->len,
+                                                result_pool);
 
   *hunk_out = hunk;
   return SVN_NO_ERROR;
@@ -303,7 +573,7 @@ svn_diff_hunk__get_fuzz_penalty(const svn_diff_hunk_t *hunk)
 /* Baton for the base85 stream implementation */
 struct base85_baton_t
 {
-  apr_file_t *file;
+  line_source_t *source;
   apr_pool_t *iterpool;
   char buffer[52];        /* Bytes on current line */
   apr_off_t next_pos;     /* Start position of next line */
@@ -352,17 +622,11 @@ read_handler_base85(void *baton, char *buffer, apr_size_t *len)
 
       if (b85b->next_pos >= b85b->end_pos)
         break; /* At EOF */
-      SVN_ERR(svn_io_file_seek(b85b->file, APR_SET, &b85b->next_pos,
-                               iterpool));
-      SVN_ERR(svn_io_file_readline(b85b->file, &line, NULL, &at_eof,
-                                   APR_SIZE_MAX, iterpool, iterpool));
+      SVN_ERR(line_source_readline(b85b->source, &b85b->next_pos, &line,
+                                   NULL, &at_eof, APR_SIZE_MAX,
+                                   iterpool, iterpool));
       if (at_eof)
         b85b->next_pos = b85b->end_pos;
-      else
-        {
-          SVN_ERR(svn_io_file_get_offset(&b85b->next_pos, b85b->file,
-                                         iterpool));
-        }
 
       if (line->len && line->data[0] >= 'A' && line->data[0] <= 'Z')
         b85b->buf_size = line->data[0] - 'A' + 1;
@@ -402,7 +666,7 @@ close_handler_base85(void *baton)
    The current implementation might assume that both start_pos and end_pos
    are located at line boundaries. */
 static svn_stream_t *
-get_base85_data_stream(apr_file_t *file,
+get_base85_data_stream(line_source_t *source,
                        apr_off_t start_pos,
                        apr_off_t end_pos,
                        apr_pool_t *result_pool)
@@ -410,7 +674,7 @@ get_base85_data_stream(apr_file_t *file,
   struct base85_baton_t *b85b = apr_pcalloc(result_pool, sizeof(*b85b));
   svn_stream_t *base85s = svn_stream_create(b85b, result_pool);
 
-  b85b->file = file;
+  b85b->source = source;
   b85b->iterpool = svn_pool_create(result_pool);
   b85b->next_pos = start_pos;
   b85b->end_pos = end_pos;
@@ -484,7 +748,7 @@ svn_stream_t *
 svn_diff_get_binary_diff_original_stream(const svn_diff_binary_patch_t *bpatch,
                                          apr_pool_t *result_pool)
 {
-  svn_stream_t *s = get_base85_data_stream(bpatch->apr_file, bpatch->src_start,
+  svn_stream_t *s = get_base85_data_stream(bpatch->source, bpatch->src_start,
                                            bpatch->src_end, result_pool);
 
   s = svn_stream_compressed(s, result_pool);
@@ -499,7 +763,7 @@ svn_stream_t *
 svn_diff_get_binary_diff_result_stream(const svn_diff_binary_patch_t *bpatch,
                                        apr_pool_t *result_pool)
 {
-  svn_stream_t *s = get_base85_data_stream(bpatch->apr_file, bpatch->dst_start,
+  svn_stream_t *s = get_base85_data_stream(bpatch->source, bpatch->dst_start,
                                            bpatch->dst_end, result_pool);
 
   s = svn_stream_compressed(s, result_pool);
@@ -643,7 +907,7 @@ parse_hunk_header(const char *header, svn_diff_hunk_t *hunk,
 }
 
 /* Read a line of original or modified hunk text from the specified
- * RANGE within FILE. FILE is expected to contain unidiff text.
+ * RANGE within SOURCE. SOURCE is expected to contain unidiff text.
  * Leading unidiff symbols ('+', '-', and ' ') are removed from the line,
  * Any lines commencing with the VERBOTEN character are discarded.
  * VERBOTEN should be '+' or '-', depending on which form of hunk text
@@ -654,7 +918,7 @@ parse_hunk_header(const char *header, svn_diff_hunk_t *hunk,
  * and svn_diff_hunk_readline_modified_text().
  */
 static svn_error_t *
-hunk_readline_original_or_modified(apr_file_t *file,
+hunk_readline_original_or_modified(line_source_t *source,
                                    struct svn_diff__hunk_range *range,
                                    svn_stringbuf_t **stringbuf,
                                    const char **eol,
@@ -666,7 +930,6 @@ hunk_readline_original_or_modified(apr_file_t *file,
 {
   apr_size_t max_len;
   svn_boolean_t filtered;
-  apr_off_t pos;
   svn_stringbuf_t *str;
   const char *eol_p;
   apr_pool_t *last_pool;
@@ -683,9 +946,6 @@ hunk_readline_original_or_modified(apr_file_t *file,
       return SVN_NO_ERROR;
     }
 
-  SVN_ERR(svn_io_file_get_offset(&pos, file, scratch_pool));
-  SVN_ERR(svn_io_file_seek(file, APR_SET, &range->current, scratch_pool));
-
   /* It's not ITERPOOL because we use data allocated in LAST_POOL out
      of the loop. */
   last_pool = svn_pool_create(scratch_pool);
@@ -694,9 +954,8 @@ hunk_readline_original_or_modified(apr_file_t *file,
       svn_pool_clear(last_pool);
 
       max_len = range->end - range->current;
-      SVN_ERR(svn_io_file_readline(file, &str, eol, eof, max_len,
-                                   last_pool, last_pool));
-      SVN_ERR(svn_io_file_get_offset(&range->current, file, last_pool));
+      SVN_ERR(line_source_readline(source, &range->current, &str, eol, eof,
+                                   max_len, last_pool, last_pool));
       filtered = (str->data[0] == verboten || str->data[0] == '\\');
     }
   while (filtered && ! *eof);
@@ -728,21 +987,14 @@ hunk_readline_original_or_modified(apr_file_t *file,
 
       if (!no_final_eol && eol != &eol_p)
         {
-          apr_off_t start = 0;
-
-          SVN_ERR(svn_io_file_seek(file, APR_SET, &start, scratch_pool));
-
-          SVN_ERR(svn_io_file_readline(file, &str, eol, NULL, APR_SIZE_MAX,
-                                       scratch_pool, scratch_pool));
+          SVN_ERR(line_source_get_first_eol(eol, source, scratch_pool));
 
           /* Every patch file that has hunks has at least one EOL*/
           SVN_ERR_ASSERT(*eol != NULL);
         }
 
       *eof = FALSE;
-      /* Fall through to seek back to the right location */
     }
-  SVN_ERR(svn_io_file_seek(file, APR_SET, &pos, scratch_pool));
 
   svn_pool_destroy(last_pool);
   return SVN_NO_ERROR;
@@ -757,7 +1009,7 @@ svn_diff_hunk_readline_original_text(svn_diff_hunk_t *hunk,
                                      apr_pool_t *scratch_pool)
 {
   return svn_error_trace(
-    hunk_readline_original_or_modified(hunk->apr_file,
+    hunk_readline_original_or_modified(hunk->source,
                                        hunk->patch->reverse ?
                                          &hunk->modified_text_range :
                                          &hunk->original_text_range,
@@ -778,7 +1030,7 @@ svn_diff_hunk_readline_modified_text(svn_diff_hunk_t *hunk,
                                      apr_pool_t *scratch_pool)
 {
   return svn_error_trace(
-    hunk_readline_original_or_modified(hunk->apr_file,
+    hunk_readline_original_or_modified(hunk->source,
                                        hunk->patch->reverse ?
                                          &hunk->original_text_range :
                                          &hunk->modified_text_range,
@@ -800,7 +1052,6 @@ svn_diff_hunk_readline_diff_text(svn_diff_hunk_t *hunk,
 {
   svn_stringbuf_t *line;
   apr_size_t max_len;
-  apr_off_t pos;
   const char *eol_p;
 
   if (!eol)
@@ -815,15 +1066,10 @@ svn_diff_hunk_readline_diff_text(svn_diff_hunk_t *hunk,
       return SVN_NO_ERROR;
     }
 
-  SVN_ERR(svn_io_file_get_offset(&pos, hunk->apr_file, scratch_pool));
-  SVN_ERR(svn_io_file_seek(hunk->apr_file, APR_SET,
-                           &hunk->diff_text_range.current, scratch_pool));
   max_len = hunk->diff_text_range.end - hunk->diff_text_range.current;
-  SVN_ERR(svn_io_file_readline(hunk->apr_file, &line, eol, eof, max_len,
-                               result_pool,
-                   scratch_pool));
-  SVN_ERR(svn_io_file_get_offset(&hunk->diff_text_range.current,
-                                 hunk->apr_file, scratch_pool));
+  SVN_ERR(line_source_readline(hunk->source, &hunk->diff_text_range.current,
+                               &line, eol, eof, max_len,
+                               result_pool, scratch_pool));
 
   if (*eof && !*eol && *line->data)
     {
@@ -836,27 +1082,16 @@ svn_diff_hunk_readline_diff_text(svn_diff_hunk_t *hunk,
       if (eol != &eol_p)
         {
           /* Lets pick the first eol we find in our patch file */
-          apr_off_t start = 0;
-          svn_stringbuf_t *str;
-
-          SVN_ERR(svn_io_file_seek(hunk->apr_file, APR_SET, &start,
-                                   scratch_pool));
-
-          SVN_ERR(svn_io_file_readline(hunk->apr_file, &str, eol, NULL,
-                                       APR_SIZE_MAX,
-                                       scratch_pool, scratch_pool));
+          SVN_ERR(line_source_get_first_eol(eol, hunk->source,
+                                            scratch_pool));
 
           /* Every patch file that has hunks has at least one EOL*/
           SVN_ERR_ASSERT(*eol != NULL);
         }
 
       *eof = FALSE;
-
-      /* Fall through to seek back to the right location */
     }
 
-  SVN_ERR(svn_io_file_seek(hunk->apr_file, APR_SET, &pos, scratch_pool));
-
   if (hunk->patch->reverse)
     {
       if (line->data[0] == '+')
@@ -1038,7 +1273,7 @@ parse_pretty_mergeinfo_line(svn_boolean_t *found_mergeinfo,
   return SVN_NO_ERROR;
 }
 
-/* Return the next *HUNK from a PATCH in APR_FILE.
+/* Return the next *HUNK from a PATCH in PATCH_FILE.
  * If no hunk can be found, set *HUNK to NULL.
  * Set IS_PROPERTY to TRUE if we have a property hunk. If the returned HUNK
  * is the first belonging to a certain property, then PROP_NAME and
@@ -1052,7 +1287,7 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
                 const char **prop_name,
                 svn_diff_operation_kind_t *prop_operation,
                 svn_patch_t *patch,
-                apr_file_t *apr_file,
+                svn_patch_file_t *patch_file,
                 svn_boolean_t ignore_whitespace,
                 apr_pool_t *result_pool,
                 apr_pool_t *scratch_pool)
@@ -1087,7 +1322,7 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
   *prop_name = NULL;
   *is_property = FALSE;
 
-  if (apr_file_eof(apr_file) == APR_EOF)
+  if (patch_file->eof)
     {
       /* No more hunks here. */
       *hunk = NULL;
@@ -1103,9 +1338,6 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
   modified_end = 0;
   *hunk = apr_pcalloc(result_pool, sizeof(**hunk));
 
-  /* Get current seek position. */
-  SVN_ERR(svn_io_file_get_offset(&pos, apr_file, scratch_pool));
-
   /* Start out assuming noise. */
   last_line_type = noise_line;
 
@@ -1116,12 +1348,9 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
       svn_pool_clear(iterpool);
 
       /* Remember the current line's offset, and read the line. */
-      last_line = pos;
-      SVN_ERR(svn_io_file_readline(apr_file, &line, NULL, &eof, APR_SIZE_MAX,
-                                   iterpool, iterpool));
-
-      /* Update line offset for next iteration. */
-      SVN_ERR(svn_io_file_get_offset(&pos, apr_file, iterpool));
+      last_line = patch_file->next_offset;
+      SVN_ERR(read_next_line(&line, &eof, patch_file, iterpool, iterpool));
+      pos = patch_file->next_offset;
 
       /* Lines starting with a backslash indicate a missing EOL:
        * "\ No newline at end of file" or "end of property". */
@@ -1138,10 +1367,9 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
                * has no trailing EOL. Snip off trailing EOL which is part
                * of the patch file but not part of the hunk text. */
               off = last_line - 2;
-              SVN_ERR(svn_io_file_seek(apr_file, APR_SET, &off, iterpool));
               len = sizeof(eolbuf);
-              SVN_ERR(svn_io_file_read_full2(apr_file, eolbuf, len, &len,
-                                             &eof, iterpool));
+              SVN_ERR(line_source_read(patch_file->source, off, eolbuf, &len,
+                                       iterpool));
               if (eolbuf[0] == '\r' && eolbuf[1] == '\n')
                 hunk_text_end = last_line - 2;
               else if (eolbuf[1] == '\n' || eolbuf[1] == '\r')
@@ -1161,7 +1389,6 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
                     modified_end = hunk_text_end;
                 }
 
-              SVN_ERR(svn_io_file_seek(apr_file, APR_SET, &pos, iterpool));
               /* Set for the type and context by using != the other type */
               if (last_line_type != modified_line)
                 original_no_final_eol = TRUE;
@@ -1390,7 +1617,7 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
     /* Rewind to the start of the line just read, so subsequent calls
      * to this function or svn_diff_parse_next_patch() don't end
      * up skipping the line -- it may contain a patch or hunk header. */
-    SVN_ERR(svn_io_file_seek(apr_file, APR_SET, &last_line, scratch_pool));
+    rewind_patch_file(patch_file, last_line);
 
   if (hunk_seen && start < end)
     {
@@ -1410,7 +1637,7 @@ parse_next_hunk(svn_diff_hunk_t **hunk,
         }
 
       (*hunk)->patch = patch;
-      (*hunk)->apr_file = apr_file;
+      (*hunk)->source = patch_file->source;
       (*hunk)->leading_context = leading_context;
       (*hunk)->trailing_context = trailing_context;
       (*hunk)->diff_text_range.start = start;
@@ -1947,15 +2174,6 @@ add_property_hunk(svn_patch_t *patch, const char *prop_name,
   return SVN_NO_ERROR;
 }
 
-struct svn_patch_file_t
-{
-  /* The APR file handle to the patch file. */
-  apr_file_t *apr_file;
-
-  /* The file offset at which the next patch is expected. */
-  apr_off_t next_patch_offset;
-};
-
 svn_error_t *
 svn_diff_open_patch_file(svn_patch_file_t **patch_file,
                          const char *local_abspath,
@@ -1963,24 +2181,27 @@ svn_diff_open_patch_file(svn_patch_file_t **patch_file,
 {
   svn_patch_file_t *p;
 
-  p = apr_palloc(result_pool, sizeof(*p));
-  SVN_ERR(svn_io_file_open(&p->apr_file, local_abspath,
-                           APR_READ | APR_BUFFERED, APR_OS_DEFAULT,
-                           result_pool));
-  p->next_patch_offset = 0;
+  p = apr_pcalloc(result_pool, sizeof(*p));
+
+  /* The line source does its own buffering. */
+  SVN_ERR(svn_io_file_open(&p->apr_file, local_abspath, APR_READ,
+                           APR_OS_DEFAULT, result_pool));
+  p->source = line_source_create(p->apr_file, result_pool);
+  p->next_offset = 0;
+  p->eof = FALSE;
   *patch_file = p;
 
   return SVN_NO_ERROR;
 }
 
-/* Parse hunks from APR_FILE and store them in PATCH->HUNKS.
+/* Parse hunks from PATCH_FILE and store them in PATCH->HUNKS.
  * Parsing stops if no valid next hunk can be found.
  * If IGNORE_WHITESPACE is TRUE, lines without
  * leading spaces will be treated as context lines.
  * Allocate results in RESULT_POOL.
  * Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
-parse_hunks(svn_patch_t *patch, apr_file_t *apr_file,
+parse_hunks(svn_patch_t *patch, svn_patch_file_t *patch_file,
             svn_boolean_t ignore_whitespace,
             apr_pool_t *result_pool, apr_pool_t *scratch_pool)
 {
@@ -2001,7 +2222,7 @@ parse_hunks(svn_patch_t *patch, apr_file_t *apr_file,
       svn_pool_clear(iterpool);
 
       SVN_ERR(parse_next_hunk(&hunk, &is_property, &prop_name, &prop_operation,
-                              patch, apr_file, ignore_whitespace, result_pool,
+                              patch, patch_file, ignore_whitespace, result_pool,
                               iterpool));
 
       if (hunk && is_property)
@@ -2034,7 +2255,7 @@ parse_hunks(svn_patch_t *patch, apr_file_t *apr_file,
 }
 
 static svn_error_t *
-parse_binary_patch(svn_patch_t *patch, apr_file_t *apr_file,
+parse_binary_patch(svn_patch_t *patch, svn_patch_file_t *patch_file,
                    svn_boolean_t reverse,
                    apr_pool_t *result_pool, apr_pool_t *scratch_pool)
 {
@@ -2046,20 +2267,15 @@ parse_binary_patch(svn_patch_t *patch, apr_file_t *apr_file,
   svn_boolean_t in_blob = FALSE;
   svn_boolean_t in_src = FALSE;
 
-  bpatch->apr_file = apr_file;
+  bpatch->source = patch_file->source;
 
   patch->prop_patches = apr_hash_make(result_pool);
 
-  SVN_ERR(svn_io_file_get_offset(&pos, apr_file, scratch_pool));
-
   while (!eof)
     {
-      last_line = pos;
-      SVN_ERR(svn_io_file_readline(apr_file, &line, NULL, &eof, APR_SIZE_MAX,
-                               iterpool, iterpool));
-
-      /* Update line offset for next iteration. */
-      SVN_ERR(svn_io_file_get_offset(&pos, apr_file, iterpool));
+      last_line = patch_file->next_offset;
+      SVN_ERR(read_next_line(&line, &eof, patch_file, iterpool, iterpool));
+      pos = patch_file->next_offset;
 
       if (in_blob)
         {
@@ -2126,7 +2342,7 @@ parse_binary_patch(svn_patch_t *patch, apr_file_t *apr_file,
   if (!eof)
     /* Rewind to the start of the line just read, so subsequent calls
      * don't end up skipping the line. It may contain a patch or hunk header.*/
-    SVN_ERR(svn_io_file_seek(apr_file, APR_SET, &last_line, scratch_pool));
+    rewind_patch_file(patch_file, last_line);
   else if (in_src
            && ((bpatch->src_end > bpatch->src_start) || !bpatch->src_filesize))
     {
@@ -2200,14 +2416,14 @@ svn_diff_parse_next_patch(svn_patch_t **patch_p,
                           apr_pool_t *result_pool,
                           apr_pool_t *scratch_pool)
 {
-  apr_off_t pos, last_line;
+  apr_off_t last_line;
   svn_boolean_t eof;
   svn_boolean_t line_after_tree_header_read = FALSE;
   apr_pool_t *iterpool;
   svn_patch_t *patch;
   enum parse_state state = state_start;
 
-  if (apr_file_eof(patch_file->apr_file) == APR_EOF)
+  if (patch_file->eof)
     {
       /* No more patches here. */
       *patch_p = NULL;
@@ -2220,9 +2436,6 @@ svn_diff_parse_next_patch(svn_patch_t **patch_p,
   patch->old_symlink_bit = svn_tristate_unknown;
   patch->new_symlink_bit = svn_tristate_unknown;
 
-  pos = patch_file->next_patch_offset;
-  SVN_ERR(svn_io_file_seek(patch_file->apr_file, APR_SET, &pos, scratch_pool));
-
   iterpool = svn_pool_create(scratch_pool);
   do
     {
@@ -2233,16 +2446,8 @@ svn_diff_parse_next_patch(svn_patch_t **patch_p,
       svn_pool_clear(iterpool);
 
       /* Remember the current line's offset, and read the line. */
-      last_line = pos;
-      SVN_ERR(svn_io_file_readline(patch_file->apr_file, &line, NULL, &eof,
-                                   APR_SIZE_MAX, iterpool, iterpool));
-
-      if (! eof)
-        {
-          /* Update line offset for next iteration. */
-          SVN_ERR(svn_io_file_get_offset(&pos, patch_file->apr_file,
-                                         iterpool));
-        }
+      last_line = patch_file->next_offset;
+      SVN_ERR(read_next_line(&line, &eof, patch_file, iterpool, iterpool));
 
       /* Run the state machine. */
       for (i = 0; i < (sizeof(transitions) / sizeof(transitions[0])); i++)
@@ -2272,8 +2477,7 @@ svn_diff_parse_next_patch(svn_patch_t **patch_p,
            * Rewind to the start of the line just read, so subsequent calls
            * to this function don't end up skipping the line -- it may
            * contain a patch. */
-          SVN_ERR(svn_io_file_seek(patch_file->apr_file, APR_SET, &last_line,
-                                   scratch_pool));
+          rewind_patch_file(patch_file, last_line);
           break;
         }
       else if (state == state_git_tree_seen
@@ -2288,8 +2492,7 @@ svn_diff_parse_next_patch(svn_patch_t **patch_p,
            *
            * Rewind to the start of the line just read - it may be a new
            * header that begins there. */
-          SVN_ERR(svn_io_file_seek(patch_file->apr_file, APR_SET, &last_line,
-                                   scratch_pool));
+          rewind_patch_file(patch_file, last_line);
           state = state_start;
         }
 
@@ -2343,20 +2546,17 @@ svn_diff_parse_next_patch(svn_patch_t **patch_p,
     {
       if (state == state_binary_patch_found)
         {
-          SVN_ERR(parse_binary_patch(patch, patch_file->apr_file, reverse,
+          SVN_ERR(parse_binary_patch(patch, patch_file, reverse,
                                      result_pool, iterpool));
           /* And fall through in property parsing */
         }
 
-      SVN_ERR(parse_hunks(patch, patch_file->apr_file, ignore_whitespace,
+      SVN_ERR(parse_hunks(patch, patch_file, ignore_whitespace,
                           result_pool, iterpool));
     }
 
   svn_pool_destroy(iterpool);
 
-  SVN_ERR(svn_io_file_get_offset(&patch_file->next_patch_offset,
-                                 patch_file->apr_file, scratch_pool));
-
   if (patch && patch->hunks)
     {
       /* Usually, hunks appear in the patch sorted by their original line
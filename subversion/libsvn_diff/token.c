@@ -22,6 +22,8 @@
  */
 
 
+#include <string.h>
+
 #include <apr.h>
 #include <apr_pools.h>
 #include <apr_general.h>
@@ -34,27 +36,38 @@
 
 
 /*
- * Prime number to use as the size of the hash table.  This number was
- * not selected by testing of any kind and may need tweaking.
+ * Tokens are interned in an open-addressing hash table with linear probing.
+ * The nodes themselves live in a single array that doubles in size as
+ * needed, so a node's position in that array is its token index.  The
+ * table is kept at most half full.
  */
-#define SVN_DIFF__HASH_SIZE 127
+#define SVN_DIFF__INITIAL_SLOT_BITS 8
 
 struct svn_diff__node_t
 {
-  svn_diff__node_t       *parent;
-  svn_diff__node_t       *left;
-  svn_diff__node_t       *right;
-
   apr_uint32_t            hash;
-  svn_diff__token_index_t index;
   void                   *token;
 };
 
+/* A slot in the hash table.  INDEX is the token index + 1, so zero-filled
+ * slots are empty.  The HASH is duplicated here to keep the probing local
+ * to the slot array. */
+typedef struct slot_t
+{
+  apr_uint32_t            hash;
+  svn_diff__token_index_t index;
+} slot_t;
+
 struct svn_diff__tree_t
 {
-  svn_diff__node_t       *root[SVN_DIFF__HASH_SIZE];
-  apr_pool_t             *pool;
+  slot_t                 *slots;
+  int                     slot_bits;
+
+  svn_diff__node_t       *nodes;
+  svn_diff__token_index_t nodes_allocated;
   svn_diff__token_index_t node_count;
+
+  apr_pool_t             *pool;
 };
 
 
@@ -76,67 +89,107 @@ svn_diff__tree_create(svn_diff__tree_t **tree, apr_pool_t *pool)
 {
   *tree = apr_pcalloc(pool, sizeof(**tree));
   (*tree)->pool = pool;
+  (*tree)->slot_bits = SVN_DIFF__INITIAL_SLOT_BITS;
+  (*tree)->slots = apr_pcalloc(pool, sizeof(*(*tree)->slots)
+                                     << SVN_DIFF__INITIAL_SLOT_BITS);
+  (*tree)->nodes_allocated = 1 << (SVN_DIFF__INITIAL_SLOT_BITS - 1);
+  (*tree)->nodes = apr_palloc(pool, sizeof(*(*tree)->nodes)
+                                    * (*tree)->nodes_allocated);
   (*tree)->node_count = 0;
 }
 
+/* Return the first slot to probe for HASH in a table of 2^SLOT_BITS slots.
+ * The token hashes we get may be weak in their lower bits, e.g. Adler-32,
+ * so use the upper bits of a multiplicative hash. */
+static APR_INLINE apr_size_t
+first_slot(apr_uint32_t hash, int slot_bits)
+{
+  return (apr_uint32_t)(hash * 0x9e3779b1U) >> (32 - slot_bits);
+}
+
+/* Double the number of slots in TREE and re-insert all nodes. */
+static void
+grow_slots(svn_diff__tree_t *tree)
+{
+  apr_size_t mask;
+  svn_diff__token_index_t i;
+
+  tree->slot_bits++;
+  tree->slots = apr_pcalloc(tree->pool,
+                            sizeof(*tree->slots) << tree->slot_bits);
+  mask = ((apr_size_t)1 << tree->slot_bits) - 1;
+
+  for (i = 0; i < tree->node_count; i++)
+    {
+      apr_size_t slot = first_slot(tree->nodes[i].hash, tree->slot_bits);
+      while (tree->slots[slot].index)
+        slot = (slot + 1) & mask;
+
+      tree->slots[slot].hash = tree->nodes[i].hash;
+      tree->slots[slot].index = i + 1;
+    }
+}
 
 static svn_error_t *
-tree_insert_token(svn_diff__node_t **node, svn_diff__tree_t *tree,
+tree_insert_token(svn_diff__token_index_t *index, svn_diff__tree_t *tree,
                   void *diff_baton,
                   const svn_diff_fns2_t *vtable,
                   apr_uint32_t hash, void *token)
 {
-  svn_diff__node_t *new_node;
-  svn_diff__node_t **node_ref;
-  svn_diff__node_t *parent;
-  int rv;
+  svn_diff__node_t *node;
+  apr_size_t mask = ((apr_size_t)1 << tree->slot_bits) - 1;
+  apr_size_t slot;
 
   SVN_ERR_ASSERT(token);
 
-  parent = NULL;
-  node_ref = &tree->root[hash % SVN_DIFF__HASH_SIZE];
-
-  while (*node_ref != NULL)
+  for (slot = first_slot(hash, tree->slot_bits);
+       tree->slots[slot].index;
+       slot = (slot + 1) & mask)
     {
-      parent = *node_ref;
+      int rv;
 
-      rv = hash - parent->hash;
-      if (!rv)
-        SVN_ERR(vtable->token_compare(diff_baton, parent->token, token, &rv));
+      if (tree->slots[slot].hash != hash)
+        continue;
 
+      node = &tree->nodes[tree->slots[slot].index - 1];
+      SVN_ERR(vtable->token_compare(diff_baton, node->token, token, &rv));
       if (rv == 0)
         {
           /* Discard the previous token.  This helps in cases where
            * only recently read tokens are still in memory.
            */
           if (vtable->token_discard != NULL)
-            vtable->token_discard(diff_baton, parent->token);
+            vtable->token_discard(diff_baton, node->token);
 
-          parent->token = token;
-          *node = parent;
+          node->token = token;
+          *index = tree->slots[slot].index - 1;
 
           return SVN_NO_ERROR;
         }
-      else if (rv > 0)
-        {
-          node_ref = &parent->left;
-        }
-      else
-        {
-          node_ref = &parent->right;
-        }
     }
 
   /* Create a new node */
-  new_node = apr_palloc(tree->pool, sizeof(*new_node));
-  new_node->parent = parent;
-  new_node->left = NULL;
-  new_node->right = NULL;
-  new_node->hash = hash;
-  new_node->token = token;
-  new_node->index = tree->node_count++;
+  if (tree->node_count == tree->nodes_allocated)
+    {
+      svn_diff__node_t *nodes = apr_palloc(tree->pool,
+                                           2 * tree->nodes_allocated
+                                             * sizeof(*nodes));
+      memcpy(nodes, tree->nodes, tree->node_count * sizeof(*nodes));
+      tree->nodes = nodes;
+      tree->nodes_allocated *= 2;
+    }
+
+  node = &tree->nodes[tree->node_count];
+  node->hash = hash;
+  node->token = token;
 
-  *node = *node_ref = new_node;
+  tree->slots[slot].hash = hash;
+  tree->slots[slot].index = ++tree->node_count;
+  *index = tree->node_count - 1;
+
+  /* Keep the table at most half full. */
+  if ((apr_size_t)tree->node_count > (mask >> 1))
+    grow_slots(tree);
 
   return SVN_NO_ERROR;
 }
@@ -158,7 +211,7 @@ svn_diff__get_tokens(svn_diff__position_t **position_list,
   svn_diff__position_t *start_position;
   svn_diff__position_t *position = NULL;
   svn_diff__position_t **position_ref;
-  svn_diff__node_t *node;
+  svn_diff__token_index_t token_index;
   void *token;
   apr_off_t offset;
   apr_uint32_t hash;
@@ -176,12 +229,13 @@ svn_diff__get_tokens(svn_diff__position_t **position_list,
         break;
 
       offset++;
-      SVN_ERR(tree_insert_token(&node, tree, diff_baton, vtable, hash, token));
+      SVN_ERR(tree_insert_token(&token_index, tree, diff_baton, vtable,
+                                hash, token));
 
       /* Create a new position */
       position = apr_palloc(pool, sizeof(*position));
       position->next = NULL;
-      position->token_index = node->index;
+      position->token_index = token_index;
       position->offset = offset;
 
       *position_ref = position;
@@ -0,0 +1,240 @@
+/* access_trace.c --- runtime tracing of FSFS item accesses
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_strings.h>
+
+#include "access_trace.h"
+#include "svn_pools.h"
+#include "svn_hash.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
+
+/* The process-wide access trace.  All members but MUTEX are protected by
+ * MUTEX. */
+typedef struct access_trace_t
+{
+  /* Serializes access to this structure. */
+  svn_mutex__t *mutex;
+
+  /* Root pool holding ENTRIES and PATHS.  Gets replaced whenever the
+   * capacity changes.  NULL while tracing is disabled. */
+  apr_pool_t *pool;
+
+  /* Ring buffer of CAPACITY elements. */
+  svn_fs_fs__access_trace_entry_t *entries;
+  int capacity;
+
+  /* Index of the oldest entry in ENTRIES and number of valid entries. */
+  int first;
+  int count;
+
+  /* Number of entries overwritten since the last clear. */
+  apr_uint64_t dropped;
+
+  /* Interned FS paths, so entries don't depend on the lifetime of the
+   * svn_fs_t that they have been recorded for.  const char * -> itself. */
+  apr_hash_t *paths;
+} access_trace_t;
+
+/* Our singleton. */
+static access_trace_t trace = { NULL };
+
+/* Keep track on whether we already initialized TRACE. */
+static svn_atomic_t trace_initialized = FALSE;
+
+/* Non-zero while tracing is enabled.  Allows for a lock-free check. */
+static volatile svn_atomic_t trace_enabled = FALSE;
+
+/* Core implementation of svn_fs_fs__access_trace_init. */
+static svn_error_t *
+init_trace(void *baton,
+           apr_pool_t *owning_pool)
+{
+  SVN_ERR(svn_mutex__init(&trace.mutex, TRUE, owning_pool));
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__access_trace_init(apr_pool_t *owning_pool)
+{
+  /* Protect against multiple calls. */
+  return svn_error_trace(svn_atomic__init_once(&trace_initialized,
+                                               init_trace,
+                                               NULL, owning_pool));
+}
+
+/* Implement svn_fs_fs__access_trace_configure while holding the lock. */
+static svn_error_t *
+configure(int capacity)
+{
+  svn_atomic_set(&trace_enabled, FALSE);
+  if (trace.pool)
+    svn_pool_destroy(trace.pool);
+
+  trace.pool = NULL;
+  trace.entries = NULL;
+  trace.capacity = 0;
+  trace.first = 0;
+  trace.count = 0;
+  trace.dropped = 0;
+  trace.paths = NULL;
+
+  if (capacity > 0)
+    {
+      /* TRACE outlives any pool that our callers may provide. */
+      trace.pool = svn_pool_create(NULL);
+      trace.entries = apr_pcalloc(trace.pool,
+                                  capacity * sizeof(*trace.entries));
+      trace.capacity = capacity;
+      trace.paths = apr_hash_make(trace.pool);
+
+      svn_atomic_set(&trace_enabled, TRUE);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__access_trace_configure(int capacity)
+{
+  SVN_MUTEX__WITH_LOCK(trace.mutex, configure(capacity));
+  return SVN_NO_ERROR;
+}
+
+apr_time_t
+svn_fs_fs__access_trace_start(void)
+{
+  return svn_atomic_read(&trace_enabled) ? apr_time_now() : 0;
+}
+
+/* Implement svn_fs_fs__access_trace_record while holding the lock.
+ * ENTRY contains all data but the FS_PATH, which will be taken from FS. */
+static svn_error_t *
+add_entry(svn_fs_t *fs,
+          const svn_fs_fs__access_trace_entry_t *entry)
+{
+  svn_fs_fs__access_trace_entry_t *slot;
+  const char *path;
+
+  /* Tracing may have been disabled while we were reading the item. */
+  if (trace.capacity == 0)
+    return SVN_NO_ERROR;
+
+  path = svn_hash_gets(trace.paths, fs->path);
+  if (!path)
+    {
+      path = apr_pstrdup(trace.pool, fs->path);
+      svn_hash_sets(trace.paths, path, path);
+    }
+
+  if (trace.count == trace.capacity)
+    {
+      /* Overwrite the oldest entry. */
+      slot = &trace.entries[trace.first];
+      trace.first = (trace.first + 1) % trace.capacity;
+      ++trace.dropped;
+    }
+  else
+    {
+      slot = &trace.entries[(trace.first + trace.count) % trace.capacity];
+      ++trace.count;
+    }
+
+  *slot = *entry;
+  slot->fs_path = path;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__access_trace_record(svn_fs_t *fs,
+                               svn_revnum_t revision,
+                               apr_uint64_t item_index,
+                               apr_uint32_t item_type,
+                               svn_boolean_t cache_hit,
+                               apr_off_t offset,
+                               apr_off_t size,
+                               apr_time_t start)
+{
+  svn_fs_fs__access_trace_entry_t entry;
+
+  /* Tracing was disabled when the access began. */
+  if (start == 0)
+    return SVN_NO_ERROR;
+
+  entry.timestamp = start;
+  entry.fs_path = NULL;
+  entry.revision = revision;
+  entry.item_index = item_index;
+  entry.item_type = item_type;
+  entry.cache_hit = cache_hit;
+  entry.offset = cache_hit ? -1 : offset;
+  entry.size = cache_hit ? -1 : size;
+  entry.latency = apr_time_now() - start;
+
+  SVN_MUTEX__WITH_LOCK(trace.mutex, add_entry(fs, &entry));
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_fs_fs__access_trace_get while holding the lock. */
+static svn_error_t *
+get_entries(apr_array_header_t **entries,
+            apr_uint64_t *dropped,
+            svn_boolean_t clear,
+            apr_pool_t *result_pool)
+{
+  int i;
+
+  *entries = apr_array_make(result_pool, trace.count,
+                            sizeof(svn_fs_fs__access_trace_entry_t *));
+  for (i = 0; i < trace.count; ++i)
+    {
+      svn_fs_fs__access_trace_entry_t *entry
+        = apr_pmemdup(result_pool,
+                      &trace.entries[(trace.first + i) % trace.capacity],
+                      sizeof(*entry));
+      entry->fs_path = apr_pstrdup(result_pool, entry->fs_path);
+      APR_ARRAY_PUSH(*entries, svn_fs_fs__access_trace_entry_t *) = entry;
+    }
+
+  *dropped = trace.dropped;
+  if (clear)
+    {
+      trace.first = 0;
+      trace.count = 0;
+      trace.dropped = 0;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__access_trace_get(apr_array_header_t **entries,
+                            apr_uint64_t *dropped,
+                            svn_boolean_t clear,
+                            apr_pool_t *result_pool)
+{
+  SVN_MUTEX__WITH_LOCK(trace.mutex,
+                       get_entries(entries, dropped, clear, result_pool));
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,86 @@
+/* access_trace.h --- runtime tracing of FSFS item accesses
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS_FS__ACCESS_TRACE_H
+#define SVN_LIBSVN_FS_FS__ACCESS_TRACE_H
+
+#include "svn_fs.h"
+#include "private/svn_fs_fs_private.h"
+
+/* A process-wide ring buffer of recent item accesses, i.e. noderev,
+ * representation header, txdelta window and changed paths list reads,
+ * across all FSFS repositories opened by this process.
+ *
+ * Tracing is disabled by default and costs a single atomic read per
+ * access in that state.  Once enabled, every access will record whether
+ * it could be served from cache, where in the rev / pack file the data
+ * was read from and how long it took.  Servers use that to find out
+ * which requests cause random I/O.
+ */
+
+/* Initialize the access trace infrastructure.  OWNING_POOL must remain
+ * valid for as long as any FSFS instance may be in use.  Multiple calls
+ * are harmless.
+ */
+svn_error_t *
+svn_fs_fs__access_trace_init(apr_pool_t *owning_pool);
+
+/* Set the maximum number of entries in the access trace to CAPACITY,
+ * discarding all entries recorded so far.  0 disables tracing.
+ */
+svn_error_t *
+svn_fs_fs__access_trace_configure(int capacity);
+
+/* Return the time stamp to pass to svn_fs_fs__access_trace_record if
+ * access tracing is enabled and 0 otherwise.
+ */
+apr_time_t
+svn_fs_fs__access_trace_start(void);
+
+/* If START is not 0, add an entry for the item given by REVISION and
+ * ITEM_INDEX in FS to the access trace.  ITEM_TYPE is one of the
+ * SVN_FS_FS__ITEM_TYPE_* values.  CACHE_HIT, OFFSET and SIZE describe how
+ * the item has been retrieved, see svn_fs_fs__access_trace_entry_t.
+ * START must have been returned by svn_fs_fs__access_trace_start.
+ */
+svn_error_t *
+svn_fs_fs__access_trace_record(svn_fs_t *fs,
+                               svn_revnum_t revision,
+                               apr_uint64_t item_index,
+                               apr_uint32_t item_type,
+                               svn_boolean_t cache_hit,
+                               apr_off_t offset,
+                               apr_off_t size,
+                               apr_time_t start);
+
+/* Return the contents of the access trace in *ENTRIES as an array of
+ * svn_fs_fs__access_trace_entry_t *, oldest first, and the number of
+ * entries lost due to overflow in *DROPPED.  If CLEAR is set, empty the
+ * trace afterwards.  Allocate the result in RESULT_POOL.
+ */
+svn_error_t *
+svn_fs_fs__access_trace_get(apr_array_header_t **entries,
+                            apr_uint64_t *dropped,
+                            svn_boolean_t clear,
+                            apr_pool_t *result_pool);
+
+#endif
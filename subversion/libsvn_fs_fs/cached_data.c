@@ -33,6 +33,7 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_temp_serializer.h"
 
+#include "access_trace.h"
 #include "fs_fs.h"
 #include "id.h"
 #include "index.h"
@@ -444,6 +445,9 @@ get_node_revision_body(node_revision_t **noderev_p,
   else
     {
       svn_fs_fs__revision_file_t *revision_file;
+      apr_time_t trace_start = svn_fs_fs__access_trace_start();
+      apr_off_t offset = -1;
+      apr_off_t size = -1;
 
       /* noderevs in rev / pack files can be cached */
       const svn_fs_fs__id_part_t *rev_item = svn_fs_fs__id_rev_item(id);
@@ -461,7 +465,10 @@ get_node_revision_body(node_revision_t **noderev_p,
                                  &key,
                                  result_pool));
           if (is_cached)
-            return SVN_NO_ERROR;
+            return svn_error_trace(svn_fs_fs__access_trace_record(
+                                     fs, key.revision, key.second,
+                                     SVN_FS_FS__ITEM_TYPE_NODEREV, TRUE,
+                                     -1, -1, trace_start));
         }
 
       /* read the data from disk */
@@ -469,6 +476,9 @@ get_node_revision_body(node_revision_t **noderev_p,
                                      rev_item->revision,
                                      rev_item->number,
                                      scratch_pool));
+      if (trace_start)
+        SVN_ERR(svn_io_file_get_offset(&offset, revision_file->file,
+                                       scratch_pool));
 
       if (use_block_read(fs))
         {
@@ -488,6 +498,13 @@ get_node_revision_body(node_revision_t **noderev_p,
                                           revision_file->stream,
                                           result_pool,
                                           scratch_pool));
+          if (trace_start)
+            {
+              SVN_ERR(svn_io_file_get_offset(&size, revision_file->file,
+                                             scratch_pool));
+              size -= offset;
+            }
+
           SVN_ERR(fixup_node_revision(fs, *noderev_p, scratch_pool));
 
           /* The noderev is not in cache, yet. Add it, if caching has been enabled. */
@@ -499,6 +516,10 @@ get_node_revision_body(node_revision_t **noderev_p,
         }
 
       SVN_ERR(svn_fs_fs__close_revision_file(revision_file));
+      SVN_ERR(svn_fs_fs__access_trace_record(fs, key.revision, key.second,
+                                             SVN_FS_FS__ITEM_TYPE_NODEREV,
+                                             FALSE, offset, size,
+                                             trace_start));
     }
 
   return SVN_NO_ERROR;
@@ -533,6 +554,54 @@ svn_fs_fs__get_node_revision(node_revision_t **noderev_p,
   return svn_error_trace(err);
 }
 
+svn_error_t *
+svn_fs_fs__get_noderev_header(svn_fs_fs__noderev_header_t *header,
+                              svn_fs_t *fs,
+                              const svn_fs_id_t *id,
+                              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  node_revision_t *noderev;
+
+  /* Committed noderevs may be in cache.  Read them in place. */
+  if (ffd->node_revision_cache && !svn_fs_fs__id_is_txn(id))
+    {
+      const svn_fs_fs__id_part_t *rev_item = svn_fs_fs__id_rev_item(id);
+      apr_time_t trace_start = svn_fs_fs__access_trace_start();
+      svn_boolean_t is_cached;
+      void *dummy;
+      pair_cache_key_t key = { 0 };
+      key.revision = rev_item->revision;
+      key.second = rev_item->number;
+
+      SVN_ERR(svn_cache__get_partial(&dummy, &is_cached,
+                                     ffd->node_revision_cache, &key,
+                                     svn_fs_fs__extract_noderev_header,
+                                     header, scratch_pool));
+      if (is_cached)
+        return svn_error_trace(svn_fs_fs__access_trace_record(
+                                 fs, key.revision, key.second,
+                                 SVN_FS_FS__ITEM_TYPE_NODEREV, TRUE,
+                                 -1, -1, trace_start));
+    }
+
+  /* Not cached (yet).  The full read will also populate the cache. */
+  SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, scratch_pool,
+                                       scratch_pool));
+
+  header->kind = noderev->kind;
+  header->predecessor_rev = noderev->predecessor_id
+                          ? svn_fs_fs__id_rev(noderev->predecessor_id)
+                          : SVN_INVALID_REVNUM;
+  header->predecessor_count = noderev->predecessor_count;
+  header->copyfrom_rev = noderev->copyfrom_rev;
+  header->copyroot_rev = noderev->copyroot_rev;
+  header->mergeinfo_count = noderev->mergeinfo_count;
+  header->has_mergeinfo = noderev->has_mergeinfo;
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Given a revision file REV_FILE, opened to REV in FS, find the Node-ID
    of the header located at OFFSET and store it in *ID_P.  Allocate
@@ -808,9 +877,8 @@ auto_read_diff_version(rep_state_t *rs, apr_pool_t *pool)
   if (rs->ver == -1)
     {
       char buf[4];
-      SVN_ERR(rs_aligned_seek(rs, NULL, rs->start, pool));
-      SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, buf,
-                                     sizeof(buf), NULL, NULL, pool));
+      SVN_ERR(svn_fs_fs__rev_file_read(rs->sfile->rfile, buf, rs->start,
+                                       sizeof(buf), pool));
 
       /* ### Layering violation */
       if (! ((buf[0] == 'S') && (buf[1] == 'V') && (buf[2] == 'N')))
@@ -841,6 +909,7 @@ create_rep_state_body(rep_state_t **rep_state,
   svn_fs_fs__rep_header_t *rh;
   svn_boolean_t is_cached = FALSE;
   apr_uint64_t estimated_window_storage;
+  apr_time_t trace_start = svn_fs_fs__access_trace_start();
 
   /* If the hint is
    * - given,
@@ -959,6 +1028,16 @@ create_rep_state_body(rep_state_t **rep_state,
   /* finalize */
   SVN_ERR(dbg_log_access(fs, rep->revision, rep->item_index, rh,
                          SVN_FS_FS__ITEM_TYPE_ANY_REP, scratch_pool));
+  if (! svn_fs_fs__id_txn_used(&rep->txn_id))
+    SVN_ERR(svn_fs_fs__access_trace_record(fs, rep->revision,
+                                           rep->item_index,
+                                           SVN_FS_FS__ITEM_TYPE_ANY_REP,
+                                           is_cached,
+                                           is_cached
+                                             ? -1
+                                             : rs->start - rh->header_size,
+                                           rh->header_size,
+                                           trace_start));
 
   rs->header_size = rh->header_size;
   *rep_state = rs;
@@ -1085,6 +1164,7 @@ svn_fs_fs__check_rep(representation_t *rep,
 svn_error_t *
 svn_fs_fs__rep_chain_length(int *chain_length,
                             int *shard_count,
+                            svn_filesize_t *chain_size,
                             representation_t *rep,
                             svn_fs_t *fs,
                             apr_pool_t *scratch_pool)
@@ -1098,6 +1178,7 @@ svn_fs_fs__rep_chain_length(int *chain_length,
   svn_boolean_t is_delta = FALSE;
   int count = 0;
   int shards = 1;
+  svn_filesize_t size = 0;
   svn_revnum_t last_shard = rep->revision / shard_size;
 
   /* Check whether the length of the deltification chain is acceptable.
@@ -1132,6 +1213,7 @@ svn_fs_fs__rep_chain_length(int *chain_length,
                                     subpool,
                                     iterpool));
 
+      size += base_rep.size;
       base_rep.revision = header->base_revision;
       base_rep.item_index = header->base_item_index;
       base_rep.size = header->base_length;
@@ -1159,6 +1241,8 @@ svn_fs_fs__rep_chain_length(int *chain_length,
 
   *chain_length = count;
   *shard_count = shards;
+  if (chain_size)
+    *chain_size = size;
   svn_pool_destroy(subpool);
   svn_pool_destroy(iterpool);
 
@@ -1553,6 +1637,9 @@ read_delta_window(svn_txdelta_window_t **nwin, int this_chunk,
   apr_off_t start_offset;
   apr_off_t end_offset;
   apr_pool_t *iterpool;
+  apr_time_t trace_start = SVN_IS_VALID_REVNUM(rs->revision)
+                         ? svn_fs_fs__access_trace_start()
+                         : 0;
 
   SVN_ERR_ASSERT(rs->chunk_index <= this_chunk);
 
@@ -1563,7 +1650,10 @@ read_delta_window(svn_txdelta_window_t **nwin, int this_chunk,
   SVN_ERR(get_cached_window(nwin, rs, this_chunk, &is_cached,
                             result_pool, scratch_pool));
   if (is_cached)
-    return SVN_NO_ERROR;
+    return svn_error_trace(svn_fs_fs__access_trace_record(
+                             rs->sfile->fs, rs->revision, rs->item_index,
+                             SVN_FS_FS__ITEM_TYPE_ANY_REP, TRUE, -1, -1,
+                             trace_start));
 
   /* someone has to actually read the data from file.  Open it */
   SVN_ERR(auto_open_shared_file(rs->sfile));
@@ -1584,7 +1674,10 @@ read_delta_window(svn_txdelta_window_t **nwin, int this_chunk,
       SVN_ERR(get_cached_window(nwin, rs, this_chunk, &is_cached,
                                 result_pool, scratch_pool));
       if (is_cached)
-        return SVN_NO_ERROR;
+        return svn_error_trace(svn_fs_fs__access_trace_record(
+                                 rs->sfile->fs, rs->revision, rs->item_index,
+                                 SVN_FS_FS__ITEM_TYPE_ANY_REP, FALSE, -1, -1,
+                                 trace_start));
     }
 
   /* data is still not cached -> we need to read it.
@@ -1595,30 +1688,70 @@ read_delta_window(svn_txdelta_window_t **nwin, int this_chunk,
   /* RS->FILE may be shared between RS instances -> make sure we point
    * to the right data. */
   start_offset = rs->start + rs->current;
-  SVN_ERR(rs_aligned_seek(rs, NULL, start_offset, scratch_pool));
+  if (rs->sfile->rfile->mapped_data)
+    {
+      /* Parse the windows directly from the memory mapped file.
+       * There is no file pointer to keep in sync. */
+      apr_off_t offset = start_offset;
+      svn_stream_t *stream
+        = svn_fs_fs__rev_file_mapped_stream(rs->sfile->rfile, &offset,
+                                            rs->start + rs->size,
+                                            scratch_pool);
+
+      /* Skip windows to reach the current chunk if we aren't there yet. */
+      iterpool = svn_pool_create(scratch_pool);
+      while (rs->chunk_index < this_chunk)
+        {
+          apr_size_t window_len;
+          apr_off_t window_start = offset;
 
-  /* Skip windows to reach the current chunk if we aren't there yet. */
-  iterpool = svn_pool_create(scratch_pool);
-  while (rs->chunk_index < this_chunk)
+          svn_pool_clear(iterpool);
+          SVN_ERR(svn_txdelta__read_raw_window_len(&window_len, stream,
+                                                   iterpool));
+          offset = window_start + window_len;
+          rs->chunk_index++;
+          rs->current = offset - rs->start;
+          if (rs->current >= rs->size)
+            return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                                    _("Reading one svndiff window read "
+                                      "beyond the end of the "
+                                      "representation"));
+        }
+      svn_pool_destroy(iterpool);
+
+      /* Actually read the next window. */
+      SVN_ERR(svn_txdelta_read_svndiff_window(nwin, stream, rs->ver,
+                                              result_pool));
+      end_offset = offset;
+    }
+  else
     {
-      svn_pool_clear(iterpool);
-      SVN_ERR(svn_txdelta_skip_svndiff_window(rs->sfile->rfile->file,
-                                              rs->ver, iterpool));
-      rs->chunk_index++;
-      SVN_ERR(get_file_offset(&start_offset, rs, iterpool));
-      rs->current = start_offset - rs->start;
-      if (rs->current >= rs->size)
-        return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
-                                _("Reading one svndiff window read "
-                                  "beyond the end of the "
-                                  "representation"));
+      SVN_ERR(rs_aligned_seek(rs, NULL, start_offset, scratch_pool));
+
+      /* Skip windows to reach the current chunk if we aren't there yet. */
+      iterpool = svn_pool_create(scratch_pool);
+      while (rs->chunk_index < this_chunk)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(svn_txdelta_skip_svndiff_window(rs->sfile->rfile->file,
+                                                  rs->ver, iterpool));
+          rs->chunk_index++;
+          SVN_ERR(get_file_offset(&start_offset, rs, iterpool));
+          rs->current = start_offset - rs->start;
+          if (rs->current >= rs->size)
+            return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                                    _("Reading one svndiff window read "
+                                      "beyond the end of the "
+                                      "representation"));
+        }
+      svn_pool_destroy(iterpool);
+
+      /* Actually read the next window. */
+      SVN_ERR(svn_txdelta_read_svndiff_window(nwin, rs->sfile->rfile->stream,
+                                              rs->ver, result_pool));
+      SVN_ERR(get_file_offset(&end_offset, rs, scratch_pool));
     }
-  svn_pool_destroy(iterpool);
 
-  /* Actually read the next window. */
-  SVN_ERR(svn_txdelta_read_svndiff_window(nwin, rs->sfile->rfile->stream,
-                                          rs->ver, result_pool));
-  SVN_ERR(get_file_offset(&end_offset, rs, scratch_pool));
   rs->current = end_offset - rs->start;
   if (rs->current > rs->size)
     return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
@@ -1630,7 +1763,11 @@ read_delta_window(svn_txdelta_window_t **nwin, int this_chunk,
   if (SVN_IS_VALID_REVNUM(rs->revision))
     SVN_ERR(set_cached_window(*nwin, rs, scratch_pool));
 
-  return SVN_NO_ERROR;
+  return svn_error_trace(svn_fs_fs__access_trace_record(
+                           rs->sfile->fs, rs->revision, rs->item_index,
+                           SVN_FS_FS__ITEM_TYPE_ANY_REP, FALSE,
+                           start_offset, end_offset - start_offset,
+                           trace_start));
 }
 
 /* Read SIZE bytes from the representation RS and return it in *NWIN. */
@@ -1640,6 +1777,9 @@ read_plain_window(svn_stringbuf_t **nwin, rep_state_t *rs,
                   apr_pool_t *scratch_pool)
 {
   apr_off_t offset;
+  apr_time_t trace_start = SVN_IS_VALID_REVNUM(rs->revision)
+                         ? svn_fs_fs__access_trace_start()
+                         : 0;
 
   /* RS->FILE may be shared between RS instances -> make sure we point
    * to the right data. */
@@ -1647,18 +1787,20 @@ read_plain_window(svn_stringbuf_t **nwin, rep_state_t *rs,
   SVN_ERR(auto_set_start_offset(rs, scratch_pool));
 
   offset = rs->start + rs->current;
-  SVN_ERR(rs_aligned_seek(rs, NULL, offset, scratch_pool));
 
   /* Read the plain data. */
   *nwin = svn_stringbuf_create_ensure(size, result_pool);
-  SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, (*nwin)->data, size,
-                                 NULL, NULL, result_pool));
+  SVN_ERR(svn_fs_fs__rev_file_read(rs->sfile->rfile, (*nwin)->data, offset,
+                                   size, scratch_pool));
   (*nwin)->data[size] = 0;
 
   /* Update RS. */
   rs->current += (apr_off_t)size;
 
-  return SVN_NO_ERROR;
+  return svn_error_trace(svn_fs_fs__access_trace_record(
+                           rs->sfile->fs, rs->revision, rs->item_index,
+                           SVN_FS_FS__ITEM_TYPE_ANY_REP, FALSE,
+                           offset, (apr_off_t)size, trace_start));
 }
 
 /* Skip SIZE bytes from the PLAIN representation RS. */
@@ -1674,10 +1816,13 @@ skip_plain_window(rep_state_t *rs,
 
 /* Get the undeltified window that is a result of combining all deltas
    from the current desired representation identified in *RB with its
-   base representation.  Store the window in *RESULT. */
+   base representation.  Store the window in *RESULT.  If TOP_WINDOW is
+   not NULL, it is the current window of the first rep in the list and
+   has already been read by the caller. */
 static svn_error_t *
 get_combined_window(svn_stringbuf_t **result,
-                    struct rep_read_baton *rb)
+                    struct rep_read_baton *rb,
+                    svn_txdelta_window_t *top_window)
 {
   apr_pool_t *pool, *new_pool, *window_pool;
   int i;
@@ -1700,8 +1845,11 @@ get_combined_window(svn_stringbuf_t **result,
       svn_pool_clear(iterpool);
 
       rs = APR_ARRAY_IDX(rb->rs_list, i, rep_state_t *);
-      SVN_ERR(read_delta_window(&window, rb->chunk_index, rs, window_pool,
-                                iterpool));
+      if (i == 0 && top_window)
+        window = top_window;
+      else
+        SVN_ERR(read_delta_window(&window, rb->chunk_index, rs, window_pool,
+                                  iterpool));
 
       APR_ARRAY_PUSH(windows, svn_txdelta_window_t *) = window;
       if (window->src_ops == 0)
@@ -1733,11 +1881,15 @@ get_combined_window(svn_stringbuf_t **result,
         {
           /* Even if we don't need the source rep now, we still must keep
            * its read offset in sync with what we might need for the next
-           * window. */
+           * window.  Windows may have been skipped in between, so position
+           * the source explicitly. */
           if (window->src_ops)
-            SVN_ERR(read_plain_window(&source, rb->src_state,
-                                      window->sview_len,
-                                      pool, iterpool));
+            {
+              rb->src_state->current = (apr_off_t)window->sview_offset;
+              SVN_ERR(read_plain_window(&source, rb->src_state,
+                                        window->sview_len,
+                                        pool, iterpool));
+            }
           else
             SVN_ERR(skip_plain_window(rb->src_state, window->sview_len));
         }
@@ -1839,9 +1991,8 @@ get_contents_from_windows(struct rep_read_baton *rb,
           SVN_ERR(auto_set_start_offset(rs, rb->pool));
 
           offset = rs->start + rs->current;
-          SVN_ERR(rs_aligned_seek(rs, NULL, offset, rb->pool));
-          SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, cur,
-                                         copy_len, NULL, NULL, rb->pool));
+          SVN_ERR(svn_fs_fs__rev_file_read(rs->sfile->rfile, cur, offset,
+                                           copy_len, rb->pool));
         }
 
       rs->current += copy_len;
@@ -1882,7 +2033,7 @@ get_contents_from_windows(struct rep_read_baton *rb,
             break;
 
           /* Get more buffered data by evaluating a chunk. */
-          SVN_ERR(get_combined_window(&sbuf, rb));
+          SVN_ERR(get_combined_window(&sbuf, rb, NULL));
 
           rb->chunk_index++;
           rb->buf_len = sbuf->len;
@@ -1896,6 +2047,85 @@ get_contents_from_windows(struct rep_read_baton *rb,
   return SVN_NO_ERROR;
 }
 
+/* Advance the window stream in RB by up to LEN bytes without
+   reconstructing windows that lie completely within the skipped range.
+   Only the window containing the new position gets combined. */
+static svn_error_t *
+skip_windows(struct rep_read_baton *rb,
+             svn_filesize_t len)
+{
+  rep_state_t *rs;
+
+  if (len > rb->len - rb->off)
+    len = rb->len - rb->off;
+
+  /* Plain texts can simply be positioned. */
+  if (rb->rs_list->nelts == 0)
+    {
+      rb->src_state->current += (apr_off_t)len;
+      rb->off += len;
+      return SVN_NO_ERROR;
+    }
+
+  rs = APR_ARRAY_IDX(rb->rs_list, 0, rep_state_t *);
+  while (len > 0)
+    {
+      /* Drop buffered data from a previous chunk first. */
+      if (rb->buf)
+        {
+          apr_size_t step = rb->buf_len - rb->buf_pos;
+          if (step > len)
+            step = (apr_size_t)len;
+
+          rb->buf_pos += step;
+          rb->off += step;
+          len -= step;
+
+          if (rb->buf_pos == rb->buf_len)
+            {
+              svn_pool_clear(rb->pool);
+              rb->buf = NULL;
+            }
+        }
+      else
+        {
+          svn_txdelta_window_t *window;
+          svn_stringbuf_t *sbuf;
+          apr_pool_t *window_pool;
+
+          if (rs->current == rs->size)
+            break;
+
+          /* The top-level window tells us how much text this chunk
+             expands to.  That's all we need to know to skip it. */
+          window_pool = svn_pool_create(rb->pool);
+          SVN_ERR(read_delta_window(&window, rb->chunk_index, rs,
+                                    window_pool, window_pool));
+          if (window->tview_len <= len)
+            {
+              /* The deeper reps will catch up when they get read next. */
+              rs->chunk_index++;
+              rb->chunk_index++;
+              rb->off += window->tview_len;
+              len -= window->tview_len;
+              svn_pool_destroy(window_pool);
+              continue;
+            }
+
+          /* The new position is within this chunk. */
+          SVN_ERR(get_combined_window(&sbuf, rb, window));
+          svn_pool_destroy(window_pool);
+
+          rb->chunk_index++;
+          rb->buf_len = sbuf->len;
+          rb->buf = sbuf->data;
+          rb->buf_pos = 0;
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Baton type for get_fulltext_partial. */
 typedef struct fulltext_baton_t
 {
@@ -2101,6 +2331,72 @@ skip_contents(struct rep_read_baton *baton,
   return svn_error_trace(err);
 }
 
+/* Initialize the window stream in RB and make it catch up with the data
+ * already delivered from the fulltext cache.
+ */
+static svn_error_t *
+init_window_stream(struct rep_read_baton *rb)
+{
+  rb->len = rb->rep.expanded_size;
+  SVN_ERR(build_rep_list(&rb->rs_list, &rb->base_window,
+                         &rb->src_state, rb->fs, &rb->rep,
+                         rb->filehandle_pool));
+
+  /* In case we did read from the fulltext cache before, make the
+   * window stream catch up.  Also, initialize the fulltext buffer
+   * if we want to cache the fulltext at the end.  Once data has been
+   * skipped, there is no checksum to catch up with, so don't bother
+   * reconstructing the data. */
+  if (rb->checksum_finalized)
+    SVN_ERR(skip_windows(rb, rb->fulltext_delivered));
+  else
+    SVN_ERR(skip_contents(rb, rb->fulltext_delivered));
+
+  return SVN_NO_ERROR;
+}
+
+/* BATON is of type `rep_read_baton'; skip the next LEN bytes of the
+   representation.  Whole delta windows within the skipped range are
+   not being reconstructed.  This is a SKIP_FN for svn_stream_t. */
+static svn_error_t *
+rep_read_skip(void *baton,
+              apr_size_t len)
+{
+  struct rep_read_baton *rb = baton;
+
+  if (len == 0)
+    return SVN_NO_ERROR;
+
+  /* We won't see all the data, so we can neither verify the checksum
+   * nor cache the fulltext. */
+  rb->checksum_finalized = TRUE;
+  rb->current_fulltext = NULL;
+
+  /* As long as the fulltext is cached, there is no stream to position. */
+  if (rb->fulltext_cache)
+    {
+      svn_boolean_t found;
+      svn_filesize_t remaining = rb->rep.expanded_size
+                               - rb->fulltext_delivered;
+
+      SVN_ERR(svn_cache__has_key(&found, rb->fulltext_cache,
+                                 &rb->fulltext_cache_key, rb->pool));
+      if (found)
+        {
+          rb->fulltext_delivered += MIN(len, remaining);
+          return SVN_NO_ERROR;
+        }
+
+      /* Cache miss.  Continue with the window stream. */
+      rb->fulltext_cache = NULL;
+    }
+
+  if (!rb->rs_list)
+    SVN_ERR(init_window_stream(rb));
+
+  return svn_error_trace(skip_windows(rb, len));
+}
+
 /* BATON is of type `rep_read_baton'; read the next *LEN bytes of the
    representation and store them in *BUF.  Sum as we read and verify
    the MD5 sum at the end.  This is a READ_FULL_FN for svn_stream_t. */
@@ -2127,18 +2423,7 @@ rep_read_contents(void *baton,
 
   /* No fulltext cache to help us.  We must read from the window stream. */
   if (!rb->rs_list)
-    {
-      /* Window stream not initialized, yet.  Do it now. */
-      rb->len = rb->rep.expanded_size;
-      SVN_ERR(build_rep_list(&rb->rs_list, &rb->base_window,
-                             &rb->src_state, rb->fs, &rb->rep,
-                             rb->filehandle_pool));
-
-      /* In case we did read from the fulltext cache before, make the
-       * window stream catch up.  Also, initialize the fulltext buffer
-       * if we want to cache the fulltext at the end. */
-      SVN_ERR(skip_contents(rb, rb->fulltext_delivered));
-    }
+    SVN_ERR(init_window_stream(rb));
 
   /* Get the next block of data.
    * Keep in mind that the representation might be empty and leave us
@@ -2253,6 +2538,7 @@ svn_fs_fs__get_contents(svn_stream_t **contents_p,
       *contents_p = svn_stream_create(rb, pool);
       svn_stream_set_read2(*contents_p, NULL /* only full read support */,
                            rep_read_contents);
+      svn_stream_set_skip(*contents_p, rep_read_skip);
       svn_stream_set_close(*contents_p, rep_read_contents_close);
     }
 
@@ -2486,8 +2772,17 @@ svn_fs_fs__get_file_delta_stream(svn_txdelta_stream_t **stream_p,
 
   /* Try a shortcut: if the target is stored as a delta against the source,
      then just use that delta.  However, prefer using the fulltext cache
-     whenever that is available. */
-  if (target->data_rep && (source || ! ffd->fulltext_cache))
+     whenever that is available.
+
+     Newer formats may store windows that exceed the classic window size,
+     which older clients would reject.  Only forward those if neither view
+     can have grown beyond SVN_DELTA_WINDOW_SIZE. */
+  if (target->data_rep && (source || ! ffd->fulltext_cache)
+      && (ffd->format < SVN_FS_FS__MIN_LARGE_DELTA_WINDOWS_FORMAT
+          || (target->data_rep->expanded_size <= SVN_DELTA_WINDOW_SIZE
+              && (!source || !source->data_rep
+                  || source->data_rep->expanded_size
+                       <= SVN_DELTA_WINDOW_SIZE))))
     {
       /* Read target's base rep if any. */
       SVN_ERR(create_rep_state(&rep_state, &rep_header, NULL,
@@ -2578,6 +2873,56 @@ compare_dirent_name(const void *a, const void *b)
   return strcmp(lhs->name, rhs);
 }
 
+/* Set *DIRENT to the directory entry described by the key and value of
+ * ENTRY, allocated in RESULT_POOL.  The value of ENTRY gets modified.
+ * ID is provided for nicer error messages.
+ */
+static svn_error_t *
+parse_dir_entry(svn_fs_dirent_t **dirent_p,
+                svn_hash__entry_t *entry,
+                const svn_fs_id_t *id,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  svn_fs_dirent_t *dirent;
+  char *str;
+
+  dirent = apr_pcalloc(result_pool, sizeof(*dirent));
+  dirent->name = apr_pstrmemdup(result_pool, entry->key, entry->keylen);
+
+  str = svn_cstring_tokenize(" ", &entry->val);
+  if (str == NULL)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                       _("Directory entry corrupt in '%s'"),
+                       svn_fs_fs__id_unparse(id, scratch_pool)->data);
+
+  if (strcmp(str, SVN_FS_FS__KIND_FILE) == 0)
+    {
+      dirent->kind = svn_node_file;
+    }
+  else if (strcmp(str, SVN_FS_FS__KIND_DIR) == 0)
+    {
+      dirent->kind = svn_node_dir;
+    }
+  else
+    {
+      return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                       _("Directory entry corrupt in '%s'"),
+                       svn_fs_fs__id_unparse(id, scratch_pool)->data);
+    }
+
+  str = svn_cstring_tokenize(" ", &entry->val);
+  if (str == NULL)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                       _("Directory entry corrupt in '%s'"),
+                       svn_fs_fs__id_unparse(id, scratch_pool)->data);
+
+  SVN_ERR(svn_fs_fs__id_parse(&dirent->id, str, result_pool));
+
+  *dirent_p = dirent;
+  return SVN_NO_ERROR;
+}
+
 /* Into *ENTRIES_P, read all directories entries from the key-value text in
  * STREAM.  If INCREMENTAL is TRUE, read until the end of the STREAM and
  * update the data.  ID is provided for nicer error messages.
@@ -2607,7 +2952,6 @@ read_dir_entries(apr_array_header_t **entries_p,
     {
       svn_hash__entry_t entry;
       svn_fs_dirent_t *dirent;
-      char *str;
 
       svn_pool_clear(iterpool);
       SVN_ERR_W(svn_hash__read_entry(&entry, stream, terminator,
@@ -2637,37 +2981,7 @@ read_dir_entries(apr_array_header_t **entries_p,
         }
 
       /* Add a new directory entry. */
-      dirent = apr_pcalloc(result_pool, sizeof(*dirent));
-      dirent->name = apr_pstrmemdup(result_pool, entry.key, entry.keylen);
-
-      str = svn_cstring_tokenize(" ", &entry.val);
-      if (str == NULL)
-        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
-                           _("Directory entry corrupt in '%s'"),
-                           svn_fs_fs__id_unparse(id, scratch_pool)->data);
-
-      if (strcmp(str, SVN_FS_FS__KIND_FILE) == 0)
-        {
-          dirent->kind = svn_node_file;
-        }
-      else if (strcmp(str, SVN_FS_FS__KIND_DIR) == 0)
-        {
-          dirent->kind = svn_node_dir;
-        }
-      else
-        {
-          return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
-                           _("Directory entry corrupt in '%s'"),
-                           svn_fs_fs__id_unparse(id, scratch_pool)->data);
-        }
-
-      str = svn_cstring_tokenize(" ", &entry.val);
-      if (str == NULL)
-        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
-                           _("Directory entry corrupt in '%s'"),
-                           svn_fs_fs__id_unparse(id, scratch_pool)->data);
-
-      SVN_ERR(svn_fs_fs__id_parse(&dirent->id, str, result_pool));
+      SVN_ERR(parse_dir_entry(&dirent, &entry, id, result_pool, iterpool));
 
       /* In incremental mode, update the hash; otherwise, write to the
        * final array.  Be sure to use hash keys that survive this iteration.
@@ -2728,6 +3042,55 @@ get_txn_dir_info(svn_filesize_t *filesize,
   return SVN_NO_ERROR;
 }
 
+/* Parse the committed directory representation contents in TEXT, which may
+ * use either the hash dump or the indexed format, and return the entries
+ * as a sorted array in *ENTRIES_P.  A hash dump gets parsed in place, so
+ * this modifies TEXT.  ID is provided for nicer error messages.
+ */
+static svn_error_t *
+parse_dir_contents(apr_array_header_t **entries_p,
+                   svn_stringbuf_t *text,
+                   const svn_fs_id_t *id,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *entries;
+  char *p = text->data;
+  char *end = text->data + text->len;
+
+  if (svn_fs_fs__is_indexed_dir(text->data, text->len))
+    return svn_error_trace(svn_fs_fs__read_indexed_dir(entries_p, text->data,
+                                                       text->len, id,
+                                                       result_pool,
+                                                       scratch_pool));
+
+  /* De-serialize the hash in place, without going through a stream. */
+  entries = apr_array_make(result_pool, 16, sizeof(svn_fs_dirent_t *));
+  while (1)
+    {
+      svn_hash__entry_t entry;
+      svn_fs_dirent_t *dirent;
+
+      SVN_ERR_W(svn_hash__parse_entry(&entry, &p, end, SVN_HASH_TERMINATOR,
+                                      FALSE),
+                apr_psprintf(scratch_pool,
+                             _("Directory representation corrupt in '%s'"),
+                             svn_fs_fs__id_unparse(id, scratch_pool)->data));
+      if (entry.key == NULL)
+        break;
+
+      SVN_ERR(parse_dir_entry(&dirent, &entry, id, result_pool,
+                              scratch_pool));
+      APR_ARRAY_PUSH(entries, svn_fs_dirent_t *) = dirent;
+    }
+
+  if (!sorted(entries))
+    svn_sort__array(entries, compare_dirents);
+
+  *entries_p = entries;
+  return SVN_NO_ERROR;
+}
+
 /* Fetch the contents of a directory into DIR.  Values are stored
    as filename to string mappings; further conversion is necessary to
    convert them into svn_fs_dirent_t values. */
@@ -2781,10 +3144,8 @@ get_dir_contents(svn_fs_fs__dir_data_t *dir,
       SVN_ERR(svn_stringbuf_from_stream(&text, contents, len, scratch_pool));
       SVN_ERR(svn_stream_close(contents));
 
-      /* de-serialize hash */
-      contents = svn_stream_from_stringbuf(text, scratch_pool);
-      SVN_ERR(read_dir_entries(&dir->entries, contents, FALSE, noderev->id,
-                               result_pool, scratch_pool));
+      SVN_ERR(parse_dir_contents(&dir->entries, text, noderev->id,
+                                 result_pool, scratch_pool));
     }
   else
     {
@@ -2896,6 +3257,110 @@ svn_fs_fs__find_dir_entry(apr_array_header_t *entries,
   return result ? *result : NULL;
 }
 
+/* Baton type used with find_indexed_dir_entry_partial. */
+typedef struct find_dir_entry_baton_t
+{
+  /* Name of the entry to look up. */
+  const char *name;
+
+  /* ID of the directory noderev; only used for error messages. */
+  const svn_fs_id_t *id;
+
+  /* Will be set if the cached fulltext uses the indexed format. */
+  svn_boolean_t indexed;
+} find_dir_entry_baton_t;
+
+/* Implement svn_cache__partial_getter_func_t for the fulltexts of
+ * directory representations.  If DATA uses the indexed format, look up
+ * the entry specified by the find_dir_entry_baton_t BATON and return it
+ * in *OUT.  Update the BATON's INDEXED flag accordingly.
+ */
+static svn_error_t *
+find_indexed_dir_entry_partial(void **out,
+                               const void *data,
+                               apr_size_t data_len,
+                               void *baton,
+                               apr_pool_t *result_pool)
+{
+  find_dir_entry_baton_t *entry_baton = baton;
+
+  /* We cached the fulltext with an NUL appended to it. */
+  apr_size_t len = data_len - 1;
+
+  entry_baton->indexed = svn_fs_fs__is_indexed_dir(data, len);
+  if (entry_baton->indexed)
+    SVN_ERR(svn_fs_fs__find_indexed_dir_entry((svn_fs_dirent_t **)out,
+                                              data, len, entry_baton->name,
+                                              entry_baton->id, result_pool));
+  else
+    *out = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* For the committed directory NODEREV in FS, look up the entry NAME
+ * without parsing the whole directory.  This is only possible if the
+ * representation uses the indexed format, in which case set *INDEXED and
+ * return the entry in *DIRENT, or NULL if it does not exist.  Otherwise,
+ * clear *INDEXED and return the directory fulltext in *TEXT, if it had to
+ * be read, or set *TEXT to NULL.  The fulltext will be added to the
+ * fulltext cache such that later lookups can be served from there.
+ *
+ * Allocate *DIRENT in RESULT_POOL and *TEXT in SCRATCH_POOL.
+ */
+static svn_error_t *
+find_committed_dir_entry(svn_fs_dirent_t **dirent,
+                         svn_boolean_t *indexed,
+                         svn_stringbuf_t **text,
+                         svn_fs_t *fs,
+                         node_revision_t *noderev,
+                         const char *name,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  representation_t *rep = noderev->data_rep;
+  svn_stream_t *contents;
+
+  *text = NULL;
+  if (ffd->fulltext_cache)
+    {
+      svn_boolean_t found;
+      find_dir_entry_baton_t baton;
+      pair_cache_key_t key;
+
+      key.revision = rep->revision;
+      key.second = rep->item_index;
+      baton.name = name;
+      baton.id = noderev->id;
+      baton.indexed = FALSE;
+
+      SVN_ERR(svn_cache__get_partial((void **)dirent, &found,
+                                     ffd->fulltext_cache, &key,
+                                     find_indexed_dir_entry_partial, &baton,
+                                     result_pool));
+      if (found && baton.indexed)
+        {
+          *indexed = TRUE;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  SVN_ERR(svn_fs_fs__get_contents(&contents, fs, rep, TRUE, scratch_pool));
+  SVN_ERR(svn_stringbuf_from_stream(text, contents,
+                                    (apr_size_t)rep->expanded_size,
+                                    scratch_pool));
+  SVN_ERR(svn_stream_close(contents));
+
+  *indexed = svn_fs_fs__is_indexed_dir((*text)->data, (*text)->len);
+  if (*indexed)
+    SVN_ERR(svn_fs_fs__find_indexed_dir_entry(dirent, (*text)->data,
+                                              (*text)->len, name,
+                                              noderev->id, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
                                   svn_fs_t *fs,
@@ -2904,6 +3369,7 @@ svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
                                   apr_pool_t *result_pool,
                                   apr_pool_t *scratch_pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   extract_dir_entry_baton_t baton;
   svn_boolean_t found = FALSE;
 
@@ -2935,10 +3401,35 @@ svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
       svn_fs_dirent_t *entry;
       svn_fs_dirent_t *entry_copy = NULL;
       svn_fs_fs__dir_data_t dir;
+      svn_stringbuf_t *text = NULL;
+
+      /* Committed directories in the indexed format don't need to be
+       * parsed as a whole.  The directory cache will then be populated
+       * by the next full listing of that directory. */
+      if (   noderev->data_rep
+          && !svn_fs_fs__id_txn_used(&noderev->data_rep->txn_id)
+          && ffd->format >= SVN_FS_FS__MIN_INDEXED_DIRS_FORMAT)
+        {
+          svn_boolean_t indexed;
+          SVN_ERR(find_committed_dir_entry(dirent, &indexed, &text, fs,
+                                           noderev, name, result_pool,
+                                           scratch_pool));
+          if (indexed)
+            return SVN_NO_ERROR;
+        }
 
       /* Read in the directory contents. */
-      SVN_ERR(get_dir_contents(&dir, fs, noderev, scratch_pool,
-                               scratch_pool));
+      if (text)
+        {
+          dir.txn_filesize = SVN_INVALID_FILESIZE;
+          SVN_ERR(parse_dir_contents(&dir.entries, text, noderev->id,
+                                     scratch_pool, scratch_pool));
+        }
+      else
+        {
+          SVN_ERR(get_dir_contents(&dir, fs, noderev, scratch_pool,
+                                   scratch_pool));
+        }
 
       /* Update the cache, if we are to use one.
        *
@@ -2999,6 +3490,7 @@ svn_fs_fs__get_proplist(apr_hash_t **proplist_p,
       fs_fs_data_t *ffd = fs->fsap_data;
       representation_t *rep = noderev->prop_rep;
       pair_cache_key_t key = { 0 };
+      svn_stringbuf_t *text;
 
       key.revision = rep->revision;
       key.second = rep->item_index;
@@ -3011,20 +3503,24 @@ svn_fs_fs__get_proplist(apr_hash_t **proplist_p,
             return SVN_NO_ERROR;
         }
 
+      /* Read the whole list and parse it in a single pass. */
       proplist = apr_hash_make(pool);
       SVN_ERR(svn_fs_fs__get_contents(&stream, fs, noderev->prop_rep, FALSE,
                                       pool));
-      err = svn_hash_read2(proplist, stream, SVN_HASH_TERMINATOR, pool);
+      SVN_ERR(svn_stringbuf_from_stream(&text, stream,
+                                        (apr_size_t)rep->expanded_size,
+                                        pool));
+      SVN_ERR(svn_stream_close(stream));
+
+      err = svn_hash__read_buffer(proplist, text, SVN_HASH_TERMINATOR, pool);
       if (err)
         {
           svn_string_t *id_str = svn_fs_fs__id_unparse(noderev->id, pool);
 
-          err = svn_error_compose_create(err, svn_stream_close(stream));
           return svn_error_quick_wrapf(err,
                    _("malformed property list for node-revision '%s'"),
                    id_str->data);
         }
-      SVN_ERR(svn_stream_close(stream));
 
       if (ffd->properties_cache && SVN_IS_VALID_REVNUM(rep->revision))
         SVN_ERR(svn_cache__set(ffd->properties_cache, &key, proplist, pool));
@@ -3051,6 +3547,7 @@ svn_fs_fs__create_changes_context(svn_fs_fs__changes_context_t **context,
   result->fs = fs;
   result->revision = rev;
   result->rev_file_pool = result_pool;
+  result->changes_offset = -1;
 
   *context = result;
   return SVN_NO_ERROR;
@@ -3064,8 +3561,12 @@ svn_fs_fs__get_changes(apr_array_header_t **changes,
 {
   apr_off_t item_index = SVN_FS_FS__ITEM_INDEX_CHANGES;
   svn_boolean_t found;
+  svn_boolean_t cache_hit;
+  apr_off_t trace_offset = -1;
+  apr_off_t trace_size = -1;
   fs_fs_data_t *ffd = context->fs->fsap_data;
   svn_fs_fs__changes_list_t *changes_list;
+  apr_time_t trace_start = svn_fs_fs__access_trace_start();
 
   pair_cache_key_t key;
   key.revision = context->revision;
@@ -3083,6 +3584,7 @@ svn_fs_fs__get_changes(apr_array_header_t **changes,
       found = FALSE;
     }
 
+  cache_hit = found;
   if (!found)
     {
       /* read changes from revision file */
@@ -3099,7 +3601,10 @@ svn_fs_fs__get_changes(apr_array_header_t **changes,
                                                    scratch_pool));
         }
 
-      if (use_block_read(context->fs))
+      /* Only the first block may be prefetched, see block_read_changes().
+       * Trying again for every following block of a long list would
+       * re-read and re-parse the start of the list each time. */
+      if (use_block_read(context->fs) && context->next == 0)
         {
           /* 'block-read' will probably populate the cache with the data
            * that we want.  However, we won't want to force it to process
@@ -3118,11 +3623,17 @@ svn_fs_fs__get_changes(apr_array_header_t **changes,
       /* If we still have no data, read it here. */
       if (!found)
         {
-          apr_off_t changes_offset;
+          apr_off_t changes_offset = context->changes_offset;
 
           /* Addressing is very different for old formats
-           * (needs to read the revision trailer). */
-          if (svn_fs_fs__use_log_addressing(context->fs))
+           * (needs to read the revision trailer).  Look it up only once
+           * per list, i.e. not for every block. */
+          if (changes_offset >= 0)
+            {
+              if (!svn_fs_fs__use_log_addressing(context->fs))
+                item_index = changes_offset;
+            }
+          else if (svn_fs_fs__use_log_addressing(context->fs))
             {
               SVN_ERR(svn_fs_fs__item_offset(&changes_offset, context->fs,
                                              context->revision_file,
@@ -3140,6 +3651,7 @@ svn_fs_fs__get_changes(apr_array_header_t **changes,
               /* This variable will be used for debug logging only. */
               item_index = changes_offset;
             }
+          context->changes_offset = changes_offset;
 
           /* Actual reading and parsing are the same, though. */
           SVN_ERR(aligned_seek(context->fs, context->revision_file->file,
@@ -3158,6 +3670,9 @@ svn_fs_fs__get_changes(apr_array_header_t **changes,
                                          scratch_pool));
           changes_list->end_offset -= changes_offset;
           changes_list->start_offset = context->next_offset;
+
+          trace_offset = changes_offset + changes_list->start_offset;
+          trace_size = changes_list->end_offset - changes_list->start_offset;
           changes_list->count = (*changes)->nelts;
           changes_list->changes = (change_t **)(*changes)->elts;
           changes_list->eol = changes_list->count < SVN_FS_FS__CHANGES_BLOCK_SIZE;
@@ -3193,6 +3708,11 @@ svn_fs_fs__get_changes(apr_array_header_t **changes,
 
   SVN_ERR(dbg_log_access(context->fs, context->revision, item_index, *changes,
                          SVN_FS_FS__ITEM_TYPE_CHANGES, scratch_pool));
+  SVN_ERR(svn_fs_fs__access_trace_record(context->fs, context->revision,
+                                         SVN_FS_FS__ITEM_INDEX_CHANGES,
+                                         SVN_FS_FS__ITEM_TYPE_CHANGES,
+                                         cache_hit, trace_offset,
+                                         trace_size, trace_start));
 
   return SVN_NO_ERROR;
 }
@@ -3330,16 +3850,29 @@ cache_windows(svn_fs_t *fs,
           char *buf;
 
           /* navigate to the current window */
-          SVN_ERR(rs_aligned_seek(rs, NULL, start_offset, iterpool));
-          SVN_ERR(svn_txdelta__read_raw_window_len(&window_len,
+          if (rs->sfile->rfile->mapped_data)
+            {
+              apr_off_t offset = start_offset;
+              SVN_ERR(svn_txdelta__read_raw_window_len(&window_len,
+                        svn_fs_fs__rev_file_mapped_stream(rs->sfile->rfile,
+                                                          &offset,
+                                                          rs->start + rs->size,
+                                                          iterpool),
+                        iterpool));
+            }
+          else
+            {
+              SVN_ERR(rs_aligned_seek(rs, NULL, start_offset, iterpool));
+              SVN_ERR(svn_txdelta__read_raw_window_len(&window_len,
                                                    rs->sfile->rfile->stream,
                                                    iterpool));
+            }
 
           /* Read the raw window. */
           buf = apr_palloc(iterpool, window_len + 1);
-          SVN_ERR(rs_aligned_seek(rs, NULL, start_offset, iterpool));
-          SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, buf,
-                                         window_len, NULL, NULL, iterpool));
+          SVN_ERR(svn_fs_fs__rev_file_read(rs->sfile->rfile, buf,
+                                           start_offset, window_len,
+                                           iterpool));
           buf[window_len] = 0;
 
           /* update relative offset in representation */
@@ -3658,6 +4191,48 @@ block_read_noderev(node_revision_t **noderev_p,
   return SVN_NO_ERROR;
 }
 
+/* Ask the OS to asynchronously fetch the blocks following the one at
+ * BLOCK_START in REVISION_FILE, which contains REVISION in FS.  That way,
+ * the data will likely be available by the time block_read() gets to it.
+ * The extent is limited by the read-ahead setting of FS and the end of
+ * the revision data as given by the P2L index.  Blocks that we already
+ * requested before will not be requested again.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+read_ahead(svn_fs_t *fs,
+           svn_revnum_t revision,
+           svn_fs_fs__revision_file_t *revision_file,
+           apr_off_t block_start,
+           apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_off_t start = block_start + ffd->block_size;
+  apr_off_t end = start + ffd->block_read_ahead * ffd->block_size;
+  apr_off_t max_offset;
+
+  if (ffd->block_read_ahead == 0)
+    return SVN_NO_ERROR;
+
+  /* Sequential access: only request the blocks not covered, yet. */
+  if (   revision_file->prefetched_end > start
+      && revision_file->prefetched_end <= end)
+    start = revision_file->prefetched_end;
+
+  /* Don't read beyond the revision contents. */
+  SVN_ERR(svn_fs_fs__p2l_get_max_offset(&max_offset, fs, revision_file,
+                                        revision, scratch_pool));
+  end = MIN(end, max_offset);
+  if (start >= end)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_io__file_prefetch(revision_file->file, start, end - start,
+                                scratch_pool));
+  revision_file->prefetched_end = end;
+
+  return SVN_NO_ERROR;
+}
+
 /* Read the whole (e.g. 64kB) block containing ITEM_INDEX of REVISION in FS
  * and put all data into cache.  If necessary and depending on heuristics,
  * neighboring blocks may also get read.  The data is being read from
@@ -3721,6 +4296,11 @@ block_read(void **result,
       SVN_ERR(aligned_seek(fs, revision_file->file, &block_start, offset,
                            iterpool));
 
+      /* let the OS fetch the next blocks while we parse this one */
+      if (run_count == 0)
+        SVN_ERR(read_ahead(fs, revision, revision_file, block_start,
+                           iterpool));
+
       /* read all items from the block */
       for (i = 0; i < entries->nelts; ++i)
         {
@@ -51,6 +51,17 @@ svn_fs_fs__get_node_revision(node_revision_t **noderev_p,
                              apr_pool_t *result_pool,
                              apr_pool_t *scratch_pool);
 
+/* Fill *HEADER with the scalar members of the node-revision for the node
+   ID in FS.  For committed node revisions found in the noderev cache, this
+   reads the data in place without allocating any memory.  Otherwise, fall
+   back to svn_fs_fs__get_node_revision.  Use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_fs_fs__get_noderev_header(svn_fs_fs__noderev_header_t *header,
+                              svn_fs_t *fs,
+                              const svn_fs_id_t *id,
+                              apr_pool_t *scratch_pool);
+
 /* Set *ROOT_ID to the node-id for the root of revision REV in
    filesystem FS.  Do any allocations in POOL. */
 svn_error_t *
@@ -73,10 +84,13 @@ svn_fs_fs__check_rep(representation_t *rep,
 /* Follow the representation delta chain in FS starting with REP.  The
    number of reps (including REP) in the chain will be returned in
    *CHAIN_LENGTH.  *SHARD_COUNT will be set to the number of shards
-   accessed.  Do any allocations in SCRATCH_POOL. */
+   accessed.  If CHAIN_SIZE is not NULL, set *CHAIN_SIZE to the sum of the
+   on-disk sizes of all reps in the chain, i.e. the amount of data to read
+   when reconstructing REP.  Do any allocations in SCRATCH_POOL. */
 svn_error_t *
 svn_fs_fs__rep_chain_length(int *chain_length,
                             int *shard_count,
+                            svn_filesize_t *chain_size,
                             representation_t *rep,
                             svn_fs_t *fs,
                             apr_pool_t *scratch_pool);
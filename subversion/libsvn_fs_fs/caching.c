@@ -277,21 +277,24 @@ init_callbacks(svn_cache__t *cache,
 }
 
 /* Sets *CACHE_P to cache instance based on provided options.
- * Creates memcache if MEMCACHE is not NULL. Creates membuffer cache if
- * MEMBUFFER is not NULL. Fallbacks to inprocess cache if MEMCACHE and
- * MEMBUFFER are NULL and pages is non-zero.  Sets *CACHE_P to NULL
+ * Creates memcache if MEMCACHE is not NULL. Creates a Redis cache if
+ * REDIS is not NULL. Creates membuffer cache if MEMBUFFER is not NULL.
+ * Fallbacks to inprocess cache if MEMCACHE, REDIS and MEMBUFFER are NULL
+ * and pages is non-zero.  Sets *CACHE_P to NULL
  * otherwise.  Use the given PRIORITY class for the new cache.  If it
  * is 0, then use the default priority class.  HAS_NAMESPACE indicates
  * whether we prefixed this cache instance with a namespace.
  *
  * Unless NO_HANDLER is true, register an error handler that reports errors
- * as warnings to the FS warning callback.
+ * as warnings to the FS warning callback.  Membuffer caches count towards
+ * the cache quota of FS, if one has been configured.
  *
  * Cache is allocated in RESULT_POOL, temporaries in SCRATCH_POOL.
  * */
 static svn_error_t *
 create_cache(svn_cache__t **cache_p,
              svn_memcache_t *memcache,
+             svn_redis_t *redis,
              svn_membuffer_t *membuffer,
              apr_int64_t pages,
              apr_int64_t items_per_page,
@@ -306,6 +309,7 @@ create_cache(svn_cache__t **cache_p,
              apr_pool_t *result_pool,
              apr_pool_t *scratch_pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   svn_cache__error_handler_t error_handler = no_handler
                                            ? NULL
                                            : warn_and_fail_on_cache_errors;
@@ -321,6 +325,15 @@ create_cache(svn_cache__t **cache_p,
                     ? NULL
                     : warn_and_continue_on_cache_errors;
     }
+  else if (redis)
+    {
+      SVN_ERR(svn_cache__create_redis(cache_p, redis,
+                                      serializer, deserializer, klen,
+                                      prefix, result_pool));
+      error_handler = no_handler
+                    ? NULL
+                    : warn_and_continue_on_cache_errors;
+    }
   else if (membuffer)
     {
       /* We assume caches with namespaces to be relatively short-lived,
@@ -329,6 +342,12 @@ create_cache(svn_cache__t **cache_p,
                 cache_p, membuffer, serializer, deserializer,
                 klen, prefix, priority, FALSE, has_namespace,
                 result_pool, scratch_pool));
+
+      if (ffd->cache_quota)
+        SVN_ERR(svn_cache__membuffer_set_quota(
+                  *cache_p,
+                  ffd->cache_quota_group ? ffd->cache_quota_group : fs->path,
+                  (apr_uint32_t)ffd->cache_quota));
     }
   else if (pages)
     {
@@ -346,13 +365,39 @@ create_cache(svn_cache__t **cache_p,
   return SVN_NO_ERROR;
 }
 
+/* Serialized items of at least this size will be compressed in caches
+ * that have compression enabled.  Smaller ones don't gain enough. */
+#define COMPRESSION_THRESHOLD 1024
+
+/* If FS has been configured to compress cached texts, enable compression
+ * for CACHE, which may be NULL.
+ */
+static svn_error_t *
+enable_compression(svn_cache__t *cache,
+                   svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (cache && ffd->compress_cached_texts)
+    SVN_ERR(svn_cache__membuffer_enable_compression(cache,
+                                                    COMPRESSION_THRESHOLD));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__initialize_caches(svn_fs_t *fs,
                              apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
+
+  /* The instance ID distinguishes e.g. a restored backup from the original
+   * repository.  Cached data may outlive the process (see
+   * svn_cache__membuffer_save) and must not be mistaken for the current
+   * repository contents. */
   const char *prefix = apr_pstrcat(pool,
                                    "fsfs:", fs->uuid,
+                                   "--", ffd->instance_id,
                                    "/", normalize_key_part(fs->path, pool),
                                    ":",
                                    SVN_VA_NULL);
@@ -363,6 +408,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
   svn_boolean_t cache_nodeprops;
   const char *cache_namespace;
   svn_boolean_t has_namespace;
+  const char *text_prefix;
 
   /* Evaluating the cache configuration. */
   SVN_ERR(read_config(&cache_namespace,
@@ -375,6 +421,11 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
   prefix = apr_pstrcat(pool, "ns:", cache_namespace, ":", prefix, SVN_VA_NULL);
   has_namespace = strlen(cache_namespace) > 0;
 
+  /* Compressed texts must not be mistaken for uncompressed ones. */
+  text_prefix = ffd->compress_cached_texts
+              ? apr_pstrcat(pool, prefix, "LZ4:", SVN_VA_NULL)
+              : prefix;
+
   membuffer = svn_cache__get_global_membuffer_cache();
 
   /* General rules for assigning cache priorities:
@@ -406,6 +457,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
    * the default pool size is 8192, so about a fifty should fit comfortably.
    */
   SVN_ERR(create_cache(&(ffd->rev_root_id_cache),
+                       NULL,
                        NULL,
                        membuffer,
                        1, 50,
@@ -422,6 +474,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
   /* Rough estimate: revision DAG nodes have size around 1kBytes, so
    * let's put 8 on a page. */
   SVN_ERR(create_cache(&(ffd->rev_node_cache),
+                       NULL,
                        NULL,
                        membuffer,
                        1, 8,
@@ -435,11 +488,29 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        no_handler,
                        fs->pool, pool));
 
+  /* Paths known not to exist in a given revision.  Revisions are
+   * immutable, so these entries never become stale. */
+  SVN_ERR(create_cache(&(ffd->absent_path_cache),
+                       NULL,
+                       NULL,
+                       membuffer,
+                       0, 0, /* Do not use the inprocess cache */
+                       /* Values are svn_stringbuf_t */
+                       NULL, NULL,
+                       APR_HASH_KEY_STRING,
+                       apr_pstrcat(pool, prefix, "ABSENT", SVN_VA_NULL),
+                       SVN_CACHE__MEMBUFFER_LOW_PRIORITY,
+                       has_namespace,
+                       fs,
+                       no_handler,
+                       fs->pool, pool));
+
   /* 1st level DAG node cache */
   ffd->dag_node_cache = svn_fs_fs__create_dag_cache(fs->pool);
 
   /* Very rough estimate: 1K per directory. */
   SVN_ERR(create_cache(&(ffd->dir_cache),
+                       NULL,
                        NULL,
                        membuffer,
                        1, 8,
@@ -456,6 +527,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
   /* 8 kBytes per entry (1000 revs / shared, one file offset per rev).
      Covering about 8 pack files gives us an "o.k." hit rate. */
   SVN_ERR(create_cache(&(ffd->packed_offset_cache),
+                       NULL,
                        NULL,
                        membuffer,
                        8, 1,
@@ -472,6 +544,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
 
   /* initialize node revision cache, if caching has been enabled */
   SVN_ERR(create_cache(&(ffd->node_revision_cache),
+                       NULL,
                        NULL,
                        membuffer,
                        2, 16, /* ~500 byte / entry; 32 entries total */
@@ -487,6 +560,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
 
   /* initialize representation header cache, if caching has been enabled */
   SVN_ERR(create_cache(&(ffd->rep_header_cache),
+                       NULL,
                        NULL,
                        membuffer,
                        1, 200, /* ~40 bytes / entry; 200 entries total */
@@ -502,6 +576,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
 
   /* initialize node change list cache, if caching has been enabled */
   SVN_ERR(create_cache(&(ffd->changes_cache),
+                       NULL,
                        NULL,
                        membuffer,
                        1, 8, /* 1k / entry; 8 entries total, rarely used */
@@ -517,6 +592,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
 
   /* if enabled, cache revprops */
   SVN_ERR(create_cache(&(ffd->revprop_cache),
+                       NULL,
                        NULL,
                        membuffer,
                        8, 20, /* ~400 bytes / entry, capa for ~2 packs */
@@ -530,24 +606,45 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        no_handler,
                        fs->pool, pool));
 
+  /* if enabled, cache packed revprops across revprop cache resets */
+  SVN_ERR(create_cache(&(ffd->packed_revprop_cache),
+                       NULL,
+                       NULL,
+                       membuffer,
+                       8, 20, /* ~400 bytes / entry, capa for ~2 packs */
+                       svn_fs_fs__serialize_revprops,
+                       svn_fs_fs__deserialize_revprops,
+                       sizeof(pair_cache_key_t),
+                       apr_pstrcat(pool, prefix, "PACKED_REVPROP",
+                                   SVN_VA_NULL),
+                       SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                       has_namespace,
+                       fs,
+                       no_handler,
+                       fs->pool, pool));
+
   /* if enabled, cache fulltext and other derived information */
   if (cache_fulltexts)
     {
       SVN_ERR(create_cache(&(ffd->fulltext_cache),
                            ffd->memcache,
+                           ffd->redis,
                            membuffer,
                            0, 0, /* Do not use the inprocess cache */
                            /* Values are svn_stringbuf_t */
                            NULL, NULL,
                            sizeof(pair_cache_key_t),
-                           apr_pstrcat(pool, prefix, "TEXT", SVN_VA_NULL),
+                           apr_pstrcat(pool, text_prefix, "TEXT",
+                                       SVN_VA_NULL),
                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
                            has_namespace,
                            fs,
                            no_handler,
                            fs->pool, pool));
+      SVN_ERR(enable_compression(ffd->fulltext_cache, fs));
 
       SVN_ERR(create_cache(&(ffd->mergeinfo_cache),
+                           NULL,
                            NULL,
                            membuffer,
                            0, 0, /* Do not use the inprocess cache */
@@ -563,6 +660,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                            fs->pool, pool));
 
       SVN_ERR(create_cache(&(ffd->mergeinfo_existence_cache),
+                           NULL,
                            NULL,
                            membuffer,
                            0, 0, /* Do not use the inprocess cache */
@@ -588,6 +686,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
   if (cache_nodeprops)
     {
       SVN_ERR(create_cache(&(ffd->properties_cache),
+                           NULL,
                            NULL,
                            membuffer,
                            0, 0, /* Do not use the inprocess cache */
@@ -611,6 +710,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
   if (cache_txdeltas)
     {
       SVN_ERR(create_cache(&(ffd->raw_window_cache),
+                           NULL,
                            NULL,
                            membuffer,
                            0, 0, /* Do not use the inprocess cache */
@@ -626,34 +726,38 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                            fs->pool, pool));
 
       SVN_ERR(create_cache(&(ffd->txdelta_window_cache),
+                           NULL,
                            NULL,
                            membuffer,
                            0, 0, /* Do not use the inprocess cache */
                            svn_fs_fs__serialize_txdelta_window,
                            svn_fs_fs__deserialize_txdelta_window,
                            sizeof(window_cache_key_t),
-                           apr_pstrcat(pool, prefix, "TXDELTA_WINDOW",
+                           apr_pstrcat(pool, text_prefix, "TXDELTA_WINDOW",
                                        SVN_VA_NULL),
                            SVN_CACHE__MEMBUFFER_LOW_PRIORITY,
                            has_namespace,
                            fs,
                            no_handler,
                            fs->pool, pool));
+      SVN_ERR(enable_compression(ffd->txdelta_window_cache, fs));
 
       SVN_ERR(create_cache(&(ffd->combined_window_cache),
+                           NULL,
                            NULL,
                            membuffer,
                            0, 0, /* Do not use the inprocess cache */
                            /* Values are svn_stringbuf_t */
                            NULL, NULL,
                            sizeof(window_cache_key_t),
-                           apr_pstrcat(pool, prefix, "COMBINED_WINDOW",
+                           apr_pstrcat(pool, text_prefix, "COMBINED_WINDOW",
                                        SVN_VA_NULL),
                            SVN_CACHE__MEMBUFFER_LOW_PRIORITY,
                            has_namespace,
                            fs,
                            no_handler,
                            fs->pool, pool));
+      SVN_ERR(enable_compression(ffd->combined_window_cache, fs));
     }
   else
     {
@@ -662,6 +766,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
     }
 
   SVN_ERR(create_cache(&(ffd->l2p_header_cache),
+                       NULL,
                        NULL,
                        membuffer,
                        8, 16, /* entry size varies but we must cover a
@@ -679,6 +784,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        no_handler,
                        fs->pool, pool));
   SVN_ERR(create_cache(&(ffd->l2p_page_cache),
+                       NULL,
                        NULL,
                        membuffer,
                        8, 16, /* entry size varies but we must cover a
@@ -696,6 +802,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        no_handler,
                        fs->pool, pool));
   SVN_ERR(create_cache(&(ffd->p2l_header_cache),
+                       NULL,
                        NULL,
                        membuffer,
                        4, 1, /* Large entries. Rarely used. */
@@ -710,6 +817,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        no_handler,
                        fs->pool, pool));
   SVN_ERR(create_cache(&(ffd->p2l_page_cache),
+                       NULL,
                        NULL,
                        membuffer,
                        4, 1, /* Variably sized entries. Rarely used. */
@@ -869,6 +977,7 @@ svn_fs_fs__initialize_txn_caches(svn_fs_t *fs,
 
   /* create a txn-local directory cache */
   SVN_ERR(create_cache(&ffd->txn_dir_cache,
+                       NULL,
                        NULL,
                        svn_cache__get_global_membuffer_cache(),
                        1024, 8,
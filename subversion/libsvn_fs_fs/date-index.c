@@ -0,0 +1,598 @@
+/* date-index.c : the revision date index
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_pools.h"
+#include "svn_hash.h"
+#include "svn_props.h"
+#include "svn_time.h"
+#include "svn_dirent_uri.h"
+
+#include "svn_private_config.h"
+
+#include "fs_fs.h"
+#include "fs.h"
+#include "date-index.h"
+#include "revprops.h"
+#include "util.h"
+
+/* The index file starts with a header that contains a 64 bit generation
+ * counter.  It gets incremented whenever existing entries are modified
+ * or removed, i.e. for anything but appending new entries.  Revision
+ * N's entry follows at offset HEADER_SIZE + N * ENTRY_SIZE.  It is the
+ * svn:date of that revision in microseconds since the epoch.
+ *
+ * All numbers are stored as big-endian 64 bit values. */
+#define HEADER_SIZE 8
+#define ENTRY_SIZE 8
+
+/* Entry value for revisions without a valid svn:date. */
+#define NO_DATE APR_INT64_MAX
+
+struct svn_fs_fs__date_index_t
+{
+  /* Pool containing DATES.  Cleared when the index gets reloaded. */
+  apr_pool_t *pool;
+
+  /* Generation of the index file that DATES has been read from. */
+  apr_uint64_t generation;
+
+  /* apr_time_t dates of revisions 0 to nelts-1.  May be empty. */
+  apr_array_header_t *dates;
+};
+
+
+
+/** Helper functions. **/
+
+static APR_INLINE const char *
+path_date_index(svn_fs_t *fs,
+                apr_pool_t *result_pool)
+{
+  return svn_dirent_join(fs->path, PATH_DATE_INDEX, result_pool);
+}
+
+/* Write VALUE to the 8 bytes at BUFFER. */
+static void
+encode_value(unsigned char *buffer,
+             apr_uint64_t value)
+{
+  int i;
+  for (i = ENTRY_SIZE - 1; i >= 0; i--)
+    {
+      buffer[i] = (unsigned char)(value & 0xff);
+      value >>= 8;
+    }
+}
+
+/* Return the value stored in the 8 bytes at BUFFER. */
+static apr_uint64_t
+decode_value(const unsigned char *buffer)
+{
+  apr_uint64_t value = 0;
+  int i;
+  for (i = 0; i < ENTRY_SIZE; i++)
+    value = (value << 8) | buffer[i];
+
+  return value;
+}
+
+/* Return the svn:date in revision property list PROPLIST or NO_DATE if
+   there is no valid one.  Use SCRATCH_POOL for temporary allocations. */
+static apr_time_t
+get_proplist_date(apr_hash_t *proplist,
+                  apr_pool_t *scratch_pool)
+{
+  svn_string_t *value = svn_hash_gets(proplist, SVN_PROP_REVISION_DATE);
+  apr_time_t date;
+  svn_error_t *err;
+
+  if (!value)
+    return NO_DATE;
+
+  err = svn_time_from_cstring(&date, value->data, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return NO_DATE;
+    }
+
+  return date;
+}
+
+/* Append the index entry for revision REV of FS to BUFFER.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+append_entry(svn_stringbuf_t *buffer,
+             svn_fs_t *fs,
+             svn_revnum_t rev,
+             apr_pool_t *scratch_pool)
+{
+  apr_hash_t *proplist;
+  unsigned char entry[ENTRY_SIZE];
+
+  SVN_ERR(svn_fs_fs__get_revision_proplist(&proplist, fs, rev, FALSE,
+                                           scratch_pool, scratch_pool));
+  encode_value(entry, (apr_uint64_t)get_proplist_date(proplist,
+                                                      scratch_pool));
+  svn_stringbuf_appendbytes(buffer, (const char *)entry, sizeof(entry));
+
+  return SVN_NO_ERROR;
+}
+
+/* Open the date index of FS with FLAGS and return it in *FILE and the
+   number of complete entries in it in *COUNT.  Set *FILE to NULL if FS
+   has no usable date index.  Allocate *FILE in POOL. */
+static svn_error_t *
+open_date_index(apr_file_t **file,
+                svn_revnum_t *count,
+                svn_fs_t *fs,
+                apr_int32_t flags,
+                apr_pool_t *pool)
+{
+  svn_filesize_t size;
+  svn_error_t *err;
+
+  err = svn_io_file_open(file, path_date_index(fs, pool), flags,
+                         APR_OS_DEFAULT, pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *file = NULL;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_io_file_size_get(&size, *file, pool));
+  if (size < HEADER_SIZE)
+    {
+      SVN_ERR(svn_io_file_close(*file, pool));
+      *file = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  *count = (svn_revnum_t)((size - HEADER_SIZE) / ENTRY_SIZE);
+
+  return SVN_NO_ERROR;
+}
+
+/* Read up to LEN bytes at OFFSET from FILE into BUFFER.  Set *BYTES_READ
+   to the number of bytes actually read, which may be less at the end of
+   the file.  Use POOL for temporary allocations. */
+static svn_error_t *
+read_at(apr_size_t *bytes_read,
+        apr_file_t *file,
+        apr_off_t offset,
+        unsigned char *buffer,
+        apr_size_t len,
+        apr_pool_t *pool)
+{
+  svn_boolean_t eof;
+
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, pool));
+  SVN_ERR(svn_io_file_read_full2(file, buffer, len, bytes_read, &eof,
+                                 pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Write LEN bytes from BUFFER to FILE at OFFSET.
+   Use POOL for temporary allocations. */
+static svn_error_t *
+write_at(apr_file_t *file,
+         apr_off_t offset,
+         const void *buffer,
+         apr_size_t len,
+         apr_pool_t *pool)
+{
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, pool));
+  SVN_ERR(svn_io_file_write_full(file, buffer, len, NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Replace the date index of FS with CONTENTS, which must start with a
+   header.  The generation in CONTENTS will be incremented before it gets
+   written.  Use POOL for temporary allocations. */
+static svn_error_t *
+write_date_index(svn_fs_t *fs,
+                 svn_stringbuf_t *contents,
+                 apr_pool_t *pool)
+{
+  unsigned char *header = (unsigned char *)contents->data;
+
+  encode_value(header, decode_value(header) + 1);
+  SVN_ERR(svn_io_write_atomic2(path_date_index(fs, pool),
+                               contents->data, contents->len,
+                               svn_fs_fs__path_current(fs, pool),
+                               FALSE, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Make the in-memory copy of FS's date index match the file on disk.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+refresh_date_index(svn_fs_t *fs,
+                   apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_fs_fs__date_index_t *index = ffd->date_index;
+  apr_file_t *file;
+  svn_revnum_t count;
+  unsigned char header[HEADER_SIZE];
+  apr_uint64_t generation;
+  apr_size_t bytes_read;
+
+  SVN_ERR(open_date_index(&file, &count, fs, APR_READ, scratch_pool));
+  if (!file)
+    {
+      if (index)
+        {
+          svn_pool_clear(index->pool);
+          index->dates = NULL;
+        }
+
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(read_at(&bytes_read, file, 0, header, sizeof(header),
+                  scratch_pool));
+  generation = decode_value(header);
+
+  if (!index)
+    {
+      index = apr_pcalloc(fs->pool, sizeof(*index));
+      index->pool = svn_pool_create(fs->pool);
+      ffd->date_index = index;
+    }
+
+  /* Modified entries?  Start over. */
+  if (!index->dates || index->generation != generation)
+    {
+      svn_pool_clear(index->pool);
+      index->dates = apr_array_make(index->pool, (int)count,
+                                    sizeof(apr_time_t));
+      index->generation = generation;
+    }
+
+  /* Read entries that have been added since we last looked. */
+  if (count > index->dates->nelts)
+    {
+      apr_size_t len = (count - index->dates->nelts) * ENTRY_SIZE;
+      unsigned char *buffer = apr_palloc(scratch_pool, len);
+      apr_size_t i;
+
+      SVN_ERR(read_at(&bytes_read, file,
+                      HEADER_SIZE
+                        + (apr_off_t)index->dates->nelts * ENTRY_SIZE,
+                      buffer, len, scratch_pool));
+      for (i = 0; i + ENTRY_SIZE <= bytes_read; i += ENTRY_SIZE)
+        APR_ARRAY_PUSH(index->dates, apr_time_t)
+          = (apr_time_t)decode_value(buffer + i);
+    }
+
+  SVN_ERR(svn_io_file_close(file, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *DATE to the date of revision REV in DATES.  Return FALSE if
+   there is no valid date for REV. */
+static svn_boolean_t
+get_date(apr_time_t *date,
+         const apr_array_header_t *dates,
+         svn_revnum_t rev)
+{
+  *date = APR_ARRAY_IDX(dates, rev, apr_time_t);
+  return *date != NO_DATE;
+}
+
+
+
+/** Index creation and update. **/
+
+svn_error_t *
+svn_fs_fs__create_date_index(svn_fs_t *fs,
+                             apr_pool_t *pool)
+{
+  svn_stringbuf_t *contents = svn_stringbuf_create_ensure(HEADER_SIZE, pool);
+
+  svn_stringbuf_appendfill(contents, 0, HEADER_SIZE);
+  return svn_error_trace(write_date_index(fs, contents, pool));
+}
+
+/* Baton type for build_date_index_body. */
+typedef struct build_baton_t
+{
+  svn_fs_t *fs;
+  svn_fs_progress_notify_func_t progress_func;
+  void *progress_baton;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+} build_baton_t;
+
+/* Implements svn_fs_fs__with_write_lock() callback for
+   svn_fs_fs__build_date_index. */
+static svn_error_t *
+build_date_index_body(void *baton,
+                      apr_pool_t *pool)
+{
+  build_baton_t *b = baton;
+  svn_revnum_t youngest;
+  svn_revnum_t rev;
+  svn_stringbuf_t *contents;
+  apr_file_t *file;
+  svn_revnum_t count;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  SVN_ERR(svn_fs_fs__youngest_rev(&youngest, b->fs, pool));
+  contents = svn_stringbuf_create_ensure(HEADER_SIZE
+                                           + (youngest + 1) * ENTRY_SIZE,
+                                         pool);
+  svn_stringbuf_appendfill(contents, 0, HEADER_SIZE);
+
+  /* Continue the generation count of the existing index, if any, so
+     that readers notice the change. */
+  SVN_ERR(open_date_index(&file, &count, b->fs, APR_READ, pool));
+  if (file)
+    {
+      apr_size_t bytes_read;
+      SVN_ERR(read_at(&bytes_read, file, 0, (unsigned char *)contents->data,
+                      HEADER_SIZE, pool));
+      SVN_ERR(svn_io_file_close(file, pool));
+    }
+
+  for (rev = 0; rev <= youngest; rev++)
+    {
+      svn_pool_clear(iterpool);
+      if (b->cancel_func)
+        SVN_ERR(b->cancel_func(b->cancel_baton));
+
+      SVN_ERR(append_entry(contents, b->fs, rev, iterpool));
+      if (b->progress_func)
+        b->progress_func(rev, b->progress_baton, iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(write_date_index(b->fs, contents, pool));
+}
+
+svn_error_t *
+svn_fs_fs__build_date_index(svn_fs_t *fs,
+                            svn_fs_progress_notify_func_t progress_func,
+                            void *progress_baton,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *pool)
+{
+  build_baton_t baton;
+
+  baton.fs = fs;
+  baton.progress_func = progress_func;
+  baton.progress_baton = progress_baton;
+  baton.cancel_func = cancel_func;
+  baton.cancel_baton = cancel_baton;
+
+  return svn_error_trace(svn_fs_fs__with_write_lock(fs,
+                                                    build_date_index_body,
+                                                    &baton, pool));
+}
+
+svn_error_t *
+svn_fs_fs__update_date_index(svn_fs_t *fs,
+                             svn_revnum_t youngest,
+                             apr_pool_t *pool)
+{
+  apr_file_t *file;
+  svn_revnum_t count;
+  svn_revnum_t rev;
+  svn_stringbuf_t *entries;
+  apr_pool_t *iterpool;
+
+  SVN_ERR(open_date_index(&file, &count, fs, APR_READ | APR_WRITE, pool));
+  if (!file)
+    return SVN_NO_ERROR;
+
+  if (count > youngest)
+    return svn_error_trace(svn_io_file_close(file, pool));
+
+  /* Usually, this is just the revision that has just been committed. */
+  entries = svn_stringbuf_create_ensure((youngest - count + 1) * ENTRY_SIZE,
+                                        pool);
+  iterpool = svn_pool_create(pool);
+  for (rev = count; rev <= youngest; rev++)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(append_entry(entries, fs, rev, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Overwrite any incomplete entry at the end of the file. */
+  SVN_ERR(write_at(file, HEADER_SIZE + (apr_off_t)count * ENTRY_SIZE,
+                   entries->data, entries->len, pool));
+
+  return svn_error_trace(svn_io_file_close(file, pool));
+}
+
+svn_error_t *
+svn_fs_fs__date_index_set_revprops(svn_fs_t *fs,
+                                   svn_revnum_t rev,
+                                   apr_hash_t *proplist,
+                                   apr_pool_t *pool)
+{
+  apr_file_t *file;
+  svn_revnum_t count;
+  unsigned char entry[ENTRY_SIZE];
+  unsigned char old_entry[ENTRY_SIZE];
+  unsigned char header[HEADER_SIZE];
+  apr_size_t bytes_read;
+
+  SVN_ERR(open_date_index(&file, &count, fs, APR_READ | APR_WRITE, pool));
+  if (!file)
+    return SVN_NO_ERROR;
+
+  encode_value(entry, (apr_uint64_t)get_proplist_date(proplist, pool));
+  if (rev == count)
+    {
+      /* Next revision to index.  Simply append. */
+      SVN_ERR(write_at(file, HEADER_SIZE + (apr_off_t)rev * ENTRY_SIZE,
+                       entry, sizeof(entry), pool));
+    }
+  else if (rev < count)
+    {
+      /* Modify the entry in-place, if it changed, and let readers know
+         by bumping the generation. */
+      SVN_ERR(read_at(&bytes_read, file,
+                      HEADER_SIZE + (apr_off_t)rev * ENTRY_SIZE,
+                      old_entry, sizeof(old_entry), pool));
+      if (memcmp(entry, old_entry, sizeof(entry)))
+        {
+          SVN_ERR(write_at(file, HEADER_SIZE + (apr_off_t)rev * ENTRY_SIZE,
+                           entry, sizeof(entry), pool));
+          SVN_ERR(read_at(&bytes_read, file, 0, header, sizeof(header),
+                          pool));
+          encode_value(header, decode_value(header) + 1);
+          SVN_ERR(write_at(file, 0, header, sizeof(header), pool));
+        }
+    }
+
+  /* The index is lagging behind for REV > COUNT.  The next commit will
+     catch up. */
+
+  return svn_error_trace(svn_io_file_close(file, pool));
+}
+
+svn_error_t *
+svn_fs_fs__truncate_date_index(svn_fs_t *fs,
+                               svn_revnum_t youngest,
+                               apr_pool_t *pool)
+{
+  svn_stringbuf_t *contents;
+  apr_size_t len = HEADER_SIZE + (apr_size_t)(youngest + 1) * ENTRY_SIZE;
+  svn_error_t *err;
+
+  err = svn_stringbuf_from_file2(&contents, path_date_index(fs, pool),
+                                 pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  if (contents->len < HEADER_SIZE || contents->len <= len)
+    return SVN_NO_ERROR;
+
+  svn_stringbuf_chop(contents, contents->len - len);
+  return svn_error_trace(write_date_index(fs, contents, pool));
+}
+
+
+
+/** Index lookup. **/
+
+svn_error_t *
+svn_fs_fs__date_index_lookup(svn_boolean_t *available,
+                             svn_revnum_t *revision,
+                             svn_fs_t *fs,
+                             apr_time_t tm,
+                             apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const apr_array_header_t *dates;
+  svn_revnum_t rev_mid, rev_top, rev_bot, rev_latest;
+  apr_time_t this_time;
+
+  *available = FALSE;
+
+  SVN_ERR(svn_fs_fs__youngest_rev(&rev_latest, fs, pool));
+  SVN_ERR(refresh_date_index(fs, pool));
+  if (!ffd->date_index || !ffd->date_index->dates
+      || ffd->date_index->dates->nelts <= rev_latest)
+    return SVN_NO_ERROR;
+
+  /* Same binary search as in svn_repos_dated_revision(). */
+  dates = ffd->date_index->dates;
+  rev_bot = 0;
+  rev_top = rev_latest;
+
+  while (rev_bot <= rev_top)
+    {
+      rev_mid = (rev_top + rev_bot) / 2;
+      if (!get_date(&this_time, dates, rev_mid))
+        return SVN_NO_ERROR;
+
+      if (this_time > tm)/* we've overshot */
+        {
+          apr_time_t previous_time;
+
+          if ((rev_mid - 1) < 0)
+            {
+              *revision = 0;
+              break;
+            }
+
+          /* see if time falls between rev_mid and rev_mid-1: */
+          if (!get_date(&previous_time, dates, rev_mid - 1))
+            return SVN_NO_ERROR;
+          if (previous_time <= tm)
+            {
+              *revision = rev_mid - 1;
+              break;
+            }
+
+          rev_top = rev_mid - 1;
+        }
+
+      else if (this_time < tm) /* we've undershot */
+        {
+          apr_time_t next_time;
+
+          if ((rev_mid + 1) > rev_latest)
+            {
+              *revision = rev_latest;
+              break;
+            }
+
+          /* see if time falls between rev_mid and rev_mid+1: */
+          if (!get_date(&next_time, dates, rev_mid + 1))
+            return SVN_NO_ERROR;
+          if (next_time > tm)
+            {
+              *revision = rev_mid;
+              break;
+            }
+
+          rev_bot = rev_mid + 1;
+        }
+
+      else
+        {
+          *revision = rev_mid;  /* exact match! */
+          break;
+        }
+    }
+
+  *available = TRUE;
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,113 @@
+/* date-index.h : interface to the revision date index
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS_FS_DATE_INDEX_H
+#define SVN_LIBSVN_FS_FS_DATE_INDEX_H
+
+#include "svn_error.h"
+
+#include "fs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+/* The date index is an optional file that lists the svn:date of every
+ * revision as a fixed-size binary entry.  It allows the revision for a
+ * given date to be found without reading the revision properties of the
+ * revisions visited by the binary search.
+ *
+ * New repositories get an index right away.  For existing ones, it gets
+ * created by svn_fs_fs__build_date_index().  From then on, every commit
+ * and every change to a revision property list keeps it up to date.
+ * Deleting the file disables the feature. */
+#define PATH_DATE_INDEX          "rev-dates"
+
+/* Create an empty date index for FS, replacing any existing one.  This is
+   meant for new repositories that don't even contain revision 0, yet.
+   Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__create_date_index(svn_fs_t *fs,
+                             apr_pool_t *pool);
+
+/* Create the date index for FS from the revision properties of all
+   revisions up to HEAD, replacing any existing one.  Report each indexed
+   revision through PROGRESS_FUNC with PROGRESS_BATON, if not NULL.
+   This takes out the FS write lock.  Use POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__build_date_index(svn_fs_t *fs,
+                            svn_fs_progress_notify_func_t progress_func,
+                            void *progress_baton,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *pool);
+
+/* If FS has a date index, add all revisions up to YOUNGEST to it that are
+   not covered by it, yet.  Otherwise, do nothing.  The caller must hold
+   the FS write lock.  Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__update_date_index(svn_fs_t *fs,
+                             svn_revnum_t youngest,
+                             apr_pool_t *pool);
+
+/* Record that the revision properties of revision REV in FS have been
+   set to PROPLIST, updating the date index entry of REV if necessary.
+   Do nothing if FS has no date index or it does not cover the revision
+   before REV.  The caller must hold the FS write lock.
+   Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__date_index_set_revprops(svn_fs_t *fs,
+                                   svn_revnum_t rev,
+                                   apr_hash_t *proplist,
+                                   apr_pool_t *pool);
+
+/* Remove all entries for revisions younger than YOUNGEST from the date
+   index of FS.  Do nothing if FS has no date index.
+   Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__truncate_date_index(svn_fs_t *fs,
+                               svn_revnum_t youngest,
+                               apr_pool_t *pool);
+
+/* Look up the youngest revision in FS that is not younger than TM in
+   FS's date index and return it in *REVISION.  The search visits the
+   same revisions as svn_repos_dated_revision() does, so the results
+   are the same even if the svn:date properties are not in order.
+
+   If FS has no date index, it does not cover HEAD, yet, or the search
+   runs into a revision without a valid svn:date, set *AVAILABLE to FALSE
+   and leave *REVISION untouched.  Otherwise, set it to TRUE.
+   Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__date_index_lookup(svn_boolean_t *available,
+                             svn_revnum_t *revision,
+                             svn_fs_t *fs,
+                             apr_time_t tm,
+                             apr_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_FS_FS_DATE_INDEX_H */
@@ -33,12 +33,15 @@
 #include "svn_version.h"
 #include "svn_pools.h"
 #include "fs.h"
+#include "access_trace.h"
+#include "date-index.h"
 #include "fs_fs.h"
 #include "tree.h"
 #include "lock.h"
 #include "hotcopy.h"
 #include "id.h"
 #include "pack.h"
+#include "path-index.h"
 #include "recovery.h"
 #include "rep-cache.h"
 #include "revprops.h"
@@ -47,6 +50,7 @@
 #include "verify.h"
 #include "svn_private_config.h"
 #include "private/svn_fs_util.h"
+#include "private/svn_batch_fsync.h"
 #include "private/svn_fs_fs_private.h"
 
 #include "../libsvn_fs/fs-loader.h"
@@ -255,6 +259,44 @@ fs_set_uuid(svn_fs_t *fs,
 }
 
 
+/* The library-level ioctl handler, i.e. for svn_fs_ioctl() being called
+   without a specific filesystem.  Conforms to fs_library_vtable_t.ioctl(). */
+static svn_error_t *
+fs_library_ioctl(svn_fs_ioctl_code_t ctlcode,
+                 void *input_void, void **output_p,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  if (strcmp(ctlcode.fs_type, SVN_FS_TYPE_FSFS) == 0)
+    {
+      if (ctlcode.code == SVN_FS_FS__IOCTL_SET_ACCESS_TRACE.code)
+        {
+          svn_fs_fs__ioctl_set_access_trace_input_t *input = input_void;
+
+          SVN_ERR(svn_fs_fs__access_trace_configure(input->capacity));
+          *output_p = NULL;
+          return SVN_NO_ERROR;
+        }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_GET_ACCESS_TRACE.code)
+        {
+          svn_fs_fs__ioctl_get_access_trace_input_t *input = input_void;
+          svn_fs_fs__ioctl_get_access_trace_output_t *output
+            = apr_pcalloc(result_pool, sizeof(*output));
+
+          SVN_ERR(svn_fs_fs__access_trace_get(&output->entries,
+                                              &output->dropped,
+                                              input && input->clear,
+                                              result_pool));
+          *output_p = output;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  return svn_error_create(SVN_ERR_FS_UNRECOGNIZED_IOCTL_CODE, NULL, NULL);
+}
+
 static svn_error_t *
 fs_ioctl(svn_fs_t *fs, svn_fs_ioctl_code_t ctlcode,
          void *input_void, void **output_p,
@@ -271,7 +313,7 @@ fs_ioctl(svn_fs_t *fs, svn_fs_ioctl_code_t ctlcode,
           svn_fs_fs__ioctl_get_stats_output_t *output;
 
           output = apr_pcalloc(result_pool, sizeof(*output));
-          SVN_ERR(svn_fs_fs__get_stats(&output->stats, fs,
+          SVN_ERR(svn_fs_fs__get_stats(&output->stats, fs, input->jobs,
                                        input->progress_func,
                                        input->progress_baton,
                                        cancel_func, cancel_baton,
@@ -319,18 +361,134 @@ fs_ioctl(svn_fs_t *fs, svn_fs_ioctl_code_t ctlcode,
           SVN_ERR(svn_fs_fs__build_rep_cache(fs,
                                              input->start_rev,
                                              input->end_rev,
+                                             input->jobs,
                                              input->progress_func,
                                              input->progress_baton,
                                              cancel_func,
                                              cancel_baton,
                                              scratch_pool));
 
+          *output_p = NULL;
+          return SVN_NO_ERROR;
+        }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_BUILD_PATH_INDEX.code)
+        {
+          svn_fs_fs__ioctl_build_path_index_input_t *input = input_void;
+
+          SVN_ERR(svn_fs_fs__build_path_index(fs,
+                                              input->progress_func,
+                                              input->progress_baton,
+                                              cancel_func,
+                                              cancel_baton,
+                                              scratch_pool));
+          *output_p = NULL;
+          return SVN_NO_ERROR;
+        }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_PATH_INDEX_PREV.code)
+        {
+          svn_fs_fs__ioctl_path_index_prev_input_t *input = input_void;
+          svn_fs_fs__ioctl_path_index_prev_output_t *output
+            = apr_pcalloc(result_pool, sizeof(*output));
+
+          SVN_ERR(svn_fs_fs__path_index_prev(&output->available,
+                                             &output->change_rev,
+                                             &output->creation_rev,
+                                             fs, input->path,
+                                             input->start, input->end,
+                                             scratch_pool));
+          *output_p = output;
+          return SVN_NO_ERROR;
+        }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_PATH_INDEX_PREV_COPY.code)
+        {
+          svn_fs_fs__ioctl_path_index_prev_copy_input_t *input = input_void;
+          svn_fs_fs__ioctl_path_index_prev_copy_output_t *output
+            = apr_pcalloc(result_pool, sizeof(*output));
+
+          SVN_ERR(svn_fs_fs__path_index_prev_copy(&output->available,
+                                                  &output->appeared_rev,
+                                                  &output->copyfrom_path,
+                                                  &output->copyfrom_rev,
+                                                  fs, input->path,
+                                                  input->revision,
+                                                  result_pool,
+                                                  scratch_pool));
+          *output_p = output;
+          return SVN_NO_ERROR;
+        }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_BUILD_DATE_INDEX.code)
+        {
+          svn_fs_fs__ioctl_build_date_index_input_t *input = input_void;
+
+          SVN_ERR(svn_fs_fs__build_date_index(fs,
+                                              input->progress_func,
+                                              input->progress_baton,
+                                              cancel_func,
+                                              cancel_baton,
+                                              scratch_pool));
+          *output_p = NULL;
+          return SVN_NO_ERROR;
+        }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_DATED_REVISION.code)
+        {
+          svn_fs_fs__ioctl_dated_revision_input_t *input = input_void;
+          svn_fs_fs__ioctl_dated_revision_output_t *output
+            = apr_pcalloc(result_pool, sizeof(*output));
+
+          output->revision = SVN_INVALID_REVNUM;
+          SVN_ERR(svn_fs_fs__date_index_lookup(&output->available,
+                                               &output->revision,
+                                               fs, input->tm,
+                                               scratch_pool));
+          *output_p = output;
+          return SVN_NO_ERROR;
+        }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_PATH_INDEX_DELETED_REV.code)
+        {
+          svn_fs_fs__ioctl_path_index_deleted_rev_input_t *input
+            = input_void;
+          svn_fs_fs__ioctl_path_index_deleted_rev_output_t *output
+            = apr_pcalloc(result_pool, sizeof(*output));
+
+          SVN_ERR(svn_fs_fs__path_index_deleted_rev(&output->available,
+                                                    &output->deleted,
+                                                    fs, input->path,
+                                                    input->start,
+                                                    input->end,
+                                                    scratch_pool));
+          *output_p = output;
+          return SVN_NO_ERROR;
+        }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_GET_TXN_LIST_LOCK_STATS.code)
+        {
+          svn_fs_fs__ioctl_get_txn_list_lock_stats_output_t *output
+            = apr_pcalloc(result_pool, sizeof(*output));
+
+          SVN_ERR(svn_fs_fs__get_txn_list_lock_stats(&output->count,
+                                                     &output->wait_time,
+                                                     &output->max_wait_time,
+                                                     fs, scratch_pool));
+          *output_p = output;
+          return SVN_NO_ERROR;
+        }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_BULK_LOAD.code)
+        {
+          svn_fs_fs__ioctl_bulk_load_input_t *input = input_void;
+
+          if (input->enable)
+            SVN_ERR(svn_fs_fs__begin_bulk_load(fs, scratch_pool));
+          else
+            SVN_ERR(svn_fs_fs__end_bulk_load(fs, scratch_pool));
+
           *output_p = NULL;
           return SVN_NO_ERROR;
         }
     }
 
-  return svn_error_create(SVN_ERR_FS_UNRECOGNIZED_IOCTL_CODE, NULL, NULL);
+  /* Process-wide controls don't depend on FS. */
+  return svn_error_trace(fs_library_ioctl(ctlcode, input_void, output_p,
+                                          cancel_func, cancel_baton,
+                                          result_pool, scratch_pool));
 }
 
 /* The vtable associated with a specific open filesystem. */
@@ -372,6 +530,7 @@ initialize_fs_struct(svn_fs_t *fs)
   ffd->use_log_addressing = FALSE;
   ffd->revprop_prefix = 0;
   ffd->flush_to_disk = TRUE;
+  ffd->bulk_load_base_rev = SVN_INVALID_REVNUM;
 
   fs->vtable = &fs_vtable;
   fs->fsap_data = ffd;
@@ -428,10 +587,14 @@ fs_open(svn_fs_t *fs,
         apr_pool_t *common_pool)
 {
   apr_pool_t *subpool = svn_pool_create(scratch_pool);
+  fs_fs_data_t *ffd;
 
   SVN_ERR(svn_fs__check_fs(fs, FALSE));
 
   SVN_ERR(initialize_fs_struct(fs));
+  ffd = fs->fsap_data;
+  ffd->common_pool_lock = common_pool_lock;
+  ffd->common_pool = common_pool;
 
   SVN_ERR(svn_fs_fs__open(fs, path, subpool));
 
@@ -444,6 +607,39 @@ fs_open(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__open_instance(svn_fs_t **instance_p,
+                         svn_fs_t *fs,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_fs_t *instance;
+
+  /* Go through the FS loader, if it told us how to. */
+  if (ffd->svn_fs_open_)
+    return svn_error_trace(ffd->svn_fs_open_(instance_p, fs->path,
+                                             fs->config, result_pool,
+                                             scratch_pool));
+
+  /* Otherwise, set up the svn_fs_t structure the same way the loader
+     would and open it directly. */
+  SVN_ERR_ASSERT(ffd->common_pool);
+
+  instance = apr_pcalloc(result_pool, sizeof(*instance));
+  instance->pool = result_pool;
+  instance->warning = fs->warning;
+  instance->warning_baton = fs->warning_baton;
+  instance->config = fs->config;
+
+  SVN_ERR(fs_open(instance, fs->path, ffd->common_pool_lock, scratch_pool,
+                  ffd->common_pool));
+
+  *instance_p = instance;
+
+  return SVN_NO_ERROR;
+}
+
 
 
 /* This implements the fs_library_vtable_t.open_for_recovery() API. */
@@ -682,7 +878,7 @@ static fs_library_vtable_t library_vtable = {
   NULL /* parse_id */,
   fs_set_svn_fs_open,
   fs_info_dup,
-  NULL /* ioctl */
+  fs_library_ioctl
 };
 
 svn_error_t *
@@ -705,6 +901,9 @@ svn_fs_fs__init(const svn_version_t *loader_version,
                              loader_version->major);
   SVN_ERR(svn_ver_check_list2(fs_version(), checklist, svn_ver_equal));
 
+  SVN_ERR(svn_batch_fsync__init(common_pool));
+  SVN_ERR(svn_fs_fs__access_trace_init(common_pool));
+
   *vtable = &library_vtable;
   return SVN_NO_ERROR;
 }
@@ -64,12 +64,15 @@ extern "C" {
 #define PATH_TXN_CURRENT      "txn-current"      /* File with next txn key */
 #define PATH_TXN_CURRENT_LOCK "txn-current-lock" /* Lock for txn-current */
 #define PATH_LOCKS_DIR        "locks"            /* Directory of locks */
+#define PATH_LOCK_DB          "locks.db"         /* Database of locks */
 #define PATH_MIN_UNPACKED_REV "min-unpacked-rev" /* Oldest revision which
                                                     has not been packed. */
 #define PATH_REVPROP_GENERATION "revprop-generation"
                                                  /* Current revprop generation*/
 #define PATH_MANIFEST         "manifest"         /* Manifest file name */
 #define PATH_PACKED           "pack"             /* Packed revision data file */
+#define PATH_L2P_TABLE        "l2p-table"        /* Decoded l2p index of a
+                                                    packed shard */
 #define PATH_EXT_PACKED_SHARD ".pack"            /* Extension for packed
                                                     shards */
 #define PATH_EXT_L2P_INDEX    ".l2p"             /* extension of the log-
@@ -100,6 +103,10 @@ extern "C" {
 /* Names of sections and options in fsfs.conf. */
 #define CONFIG_SECTION_CACHES            "caches"
 #define CONFIG_OPTION_FAIL_STOP          "fail-stop"
+#define CONFIG_OPTION_ASYNC_MEMCACHED_WRITES "async-memcached-writes"
+#define CONFIG_OPTION_COMPRESS_CACHED_TEXTS "compress-cached-texts"
+#define CONFIG_OPTION_CACHE_QUOTA        "cache-quota"
+#define CONFIG_OPTION_CACHE_QUOTA_GROUP  "cache-quota-group"
 #define CONFIG_SECTION_REP_SHARING       "rep-sharing"
 #define CONFIG_OPTION_ENABLE_REP_SHARING "enable-rep-sharing"
 #define CONFIG_SECTION_DELTIFICATION     "deltification"
@@ -107,6 +114,9 @@ extern "C" {
 #define CONFIG_OPTION_ENABLE_PROPS_DELTIFICATION "enable-props-deltification"
 #define CONFIG_OPTION_MAX_DELTIFICATION_WALK     "max-deltification-walk"
 #define CONFIG_OPTION_MAX_LINEAR_DELTIFICATION   "max-linear-deltification"
+#define CONFIG_OPTION_MAX_DELTA_CHAIN_SIZE       "max-delta-chain-size"
+#define CONFIG_OPTION_ENABLE_CONTENT_CHUNKING    "enable-content-chunking"
+#define CONFIG_OPTION_DELTA_WINDOW_SIZE          "delta-window-size"
 #define CONFIG_OPTION_COMPRESSION_LEVEL  "compression-level"
 #define CONFIG_SECTION_PACKED_REVPROPS   "packed-revprops"
 #define CONFIG_OPTION_REVPROP_PACK_SIZE  "revprop-pack-size"
@@ -115,6 +125,13 @@ extern "C" {
 #define CONFIG_OPTION_BLOCK_SIZE         "block-size"
 #define CONFIG_OPTION_L2P_PAGE_SIZE      "l2p-page-size"
 #define CONFIG_OPTION_P2L_PAGE_SIZE      "p2l-page-size"
+#define CONFIG_OPTION_BLOCK_READ_AHEAD   "block-read-ahead"
+#define CONFIG_OPTION_MMAP_PACKED_FILES  "mmap-packed-files"
+#define CONFIG_OPTION_SHARED_L2P_TABLES  "shared-l2p-tables"
+#define CONFIG_SECTION_LOCKS             "locks"
+#define CONFIG_OPTION_USE_LOCK_DATABASE  "use-lock-database"
+#define CONFIG_SECTION_PACK              "pack"
+#define CONFIG_OPTION_MAX_IO_RATE        "max-io-rate"
 #define CONFIG_SECTION_DEBUG             "debug"
 #define CONFIG_OPTION_PACK_AFTER_COMMIT  "pack-after-commit"
 #define CONFIG_OPTION_VERIFY_BEFORE_COMMIT "verify-before-commit"
@@ -127,7 +144,7 @@ extern "C" {
    Note: If you bump this, please update the switch statement in
          svn_fs_fs__create() as well.
  */
-#define SVN_FS_FS__FORMAT_NUMBER   8
+#define SVN_FS_FS__FORMAT_NUMBER   9
 
 /* The minimum format number that supports svndiff version 1.  */
 #define SVN_FS_FS__MIN_SVNDIFF1_FORMAT 2
@@ -188,6 +205,9 @@ extern "C" {
 /* The minimum format number that supports svndiff version 2. */
 #define SVN_FS_FS__MIN_SVNDIFF2_FORMAT 8
 
+/* The minimum format number that supports svndiff version 3. */
+#define SVN_FS_FS__MIN_SVNDIFF3_FORMAT 9
+
 /* The minimum format number that supports the special notation ("-")
    for optional values that are not present in the representation strings,
    such as SHA1 or the uniquifier.  For example:
@@ -200,6 +220,19 @@ extern "C" {
     database. */
 #define SVN_FS_FS__MIN_REP_CACHE_SCHEMA_V2_FORMAT 8
 
+/* The minimum format number that stores committed directories in the
+   indexed format, allowing for entry lookups without parsing the whole
+   directory. */
+#define SVN_FS_FS__MIN_INDEXED_DIRS_FORMAT 9
+
+/* The minimum format number that may keep locks in a single database
+   instead of the digest file tree. */
+#define SVN_FS_FS__MIN_LOCK_DB_FORMAT 9
+
+/* The minimum format number that supports delta windows larger than
+   the classic 100kB. */
+#define SVN_FS_FS__MIN_LARGE_DELTA_WINDOWS_FORMAT 9
+
 /* On most operating systems apr implements file locks per process, not
    per file.  On Windows apr implements the locking as per file handle
    locks, so we don't have to add our own mutex for just in-process
@@ -231,7 +264,9 @@ typedef struct fs_fs_shared_txn_data_t
   /* Whether the transaction's prototype revision file is locked for
      writing by any thread in this process (including the current
      thread; recursive locks are not permitted).  This is effectively
-     a non-recursive mutex. */
+     a non-recursive mutex.  The owning thread holds it while doing the
+     file I/O, i.e. only setting and resetting it requires the txn list
+     lock. */
   svn_boolean_t being_written;
 
   /* The pool in which this object has been allocated; a subpool of the
@@ -263,6 +298,13 @@ typedef struct fs_fs_shared_data_t
   /* A lock for intra-process synchronization when accessing the TXNS list. */
   svn_mutex__t *txn_list_lock;
 
+  /* Usage statistics of TXN_LIST_LOCK:  The number of acquisitions and
+     the total and maximum time spent waiting for it.  These are only
+     accessed while holding that lock. */
+  apr_uint64_t txn_list_lock_count;
+  apr_interval_time_t txn_list_lock_wait_time;
+  apr_interval_time_t txn_list_lock_max_wait_time;
+
   /* A lock for intra-process synchronization when grabbing the
      repository write lock. */
   svn_mutex__t *fs_write_lock;
@@ -283,6 +325,12 @@ typedef struct fs_fs_shared_data_t
 /* Data structure for the 1st level DAG node cache. */
 typedef struct fs_fs_dag_cache_t fs_fs_dag_cache_t;
 
+/* Bloom filter for rep-cache.db lookups.  See rep-cache.c. */
+typedef struct svn_fs_fs__rep_cache_filter_t svn_fs_fs__rep_cache_filter_t;
+
+/* In-memory copy of the revision date index.  See date-index.c. */
+typedef struct svn_fs_fs__date_index_t svn_fs_fs__date_index_t;
+
 /* Key type for all caches that use revision + offset / counter as key.
 
    Note: Cache keys should be 16 bytes for best performance and there
@@ -315,7 +363,8 @@ typedef enum compression_type_t
 {
   compression_type_none,
   compression_type_zlib,
-  compression_type_lz4
+  compression_type_lz4,
+  compression_type_zstd
 } compression_type_t;
 
 /* Private (non-shared) FSFS-specific data for each svn_fs_t object.
@@ -336,6 +385,21 @@ typedef struct fs_fs_data_t
   /* Rev / pack file read granularity in bytes. */
   apr_int64_t block_size;
 
+  /* Number of blocks following the current one that block-read shall ask
+     the OS to fetch asynchronously.  0 disables read-ahead. */
+  apr_int64_t block_read_ahead;
+
+  /* Whether to access pack files through read-only memory mappings. */
+  svn_boolean_t mmap_packed_files;
+
+  /* Whether to write and use decoded, memory mapped l2p index tables
+   * for packed shards. */
+  svn_boolean_t shared_l2p_tables;
+
+  /* Whether to keep locks in the PATH_LOCK_DB database instead of the
+   * PATH_LOCKS_DIR digest file tree. */
+  svn_boolean_t use_lock_db;
+
   /* Capacity in entries of log-to-phys index pages */
   apr_int64_t l2p_page_size;
 
@@ -356,10 +420,25 @@ typedef struct fs_fs_data_t
   /* Access to the configured memcached instances.  May be NULL. */
   svn_memcache_t *memcache;
 
+  /* Access to the configured Redis servers.  May be NULL. */
+  svn_redis_t *redis;
+
   /* If TRUE, don't ignore any cache-related errors.  If FALSE, errors from
      e.g. memcached may be ignored as caching is an optional feature. */
   svn_boolean_t fail_stop;
 
+  /* If TRUE, store fulltexts and delta windows LZ4-compressed in the
+     membuffer cache. */
+  svn_boolean_t compress_cached_texts;
+
+  /* Share of the membuffer cache in percent that the data of this
+     repository may occupy.  0 means "unlimited". */
+  apr_int64_t cache_quota;
+
+  /* Quota group that the membuffer caches of this repository belong to.
+     NULL means that the repository forms a group of its own. */
+  const char *cache_quota_group;
+
   /* A cache of revision root IDs, mapping from (svn_revnum_t *) to
      (svn_fs_id_t *).  (Not threadsafe.) */
   svn_cache__t *rev_root_id_cache;
@@ -371,6 +450,11 @@ typedef struct fs_fs_data_t
      to (dag_node_t *). This is the 2nd level cache for DAG nodes. */
   svn_cache__t *rev_node_cache;
 
+  /* Negative lookup cache for immutable paths.  Maps (revision, fspath)
+     to the svn_stringbuf_t "1" if that path does not exist in that
+     revision.  May be NULL. */
+  svn_cache__t *absent_path_cache;
+
   /* A cache of the contents of immutable directories; maps from
      unparsed FS ID to a apr_hash_t * mapping (const char *) dirent
      names to (svn_fs_dirent_t *). */
@@ -389,6 +473,13 @@ typedef struct fs_fs_data_t
      will be written to the cache but the getter returns apr_hash_t. */
   svn_cache__t *revprop_cache;
 
+  /* Packed revision property cache.  Maps from (rev,generation) to
+     apr_hash_t, with the generation identifying the version of the pack
+     file that the revprops had been read from.  Entries therefore remain
+     valid when the revprop cache gets reset.  Writes and reads use the
+     same types as in revprop_cache. */
+  svn_cache__t *packed_revprop_cache;
+
   /* Node properties cache.  Maps from rep key to apr_hash_t. */
   svn_cache__t *properties_cache;
 
@@ -465,6 +556,25 @@ typedef struct fs_fs_data_t
   /* Thread-safe boolean */
   svn_atomic_t rep_cache_db_opened;
 
+  /* Whether to check REP_CACHE_FILTER before querying the rep-cache. */
+  svn_boolean_t use_rep_cache_filter;
+
+  /* Bloom filter over all keys in the rep-cache.  NULL if not used or
+     not built yet. */
+  svn_fs_fs__rep_cache_filter_t *rep_cache_filter;
+
+  /* The sqlite database of the per-path revision index.  NULL if it has
+     not been opened (yet) or does not exist. */
+  svn_sqlite__db_t *path_index_db;
+
+  /* The contents of the revision date index as last read from disk.
+     NULL if it has not been read (yet) or does not exist. */
+  svn_fs_fs__date_index_t *date_index;
+
+  /* The sqlite database of locks.  NULL if it has not been opened (yet)
+     or does not exist. */
+  svn_sqlite__db_t *lock_db;
+
   /* The oldest revision not in a pack file.  It also applies to revprops
    * if revprop packing has been enabled by the FSFS format version. */
   svn_revnum_t min_unpacked_rev;
@@ -493,10 +603,24 @@ typedef struct fs_fs_data_t
    * deltification history after which skip deltas will be used. */
   apr_int64_t max_linear_deltification;
 
+  /* Maximum number of bytes that may need to be read to reconstruct a
+   * base representation before we write a new fulltext instead of a delta
+   * against it.  0 for "unlimited". */
+  apr_int64_t max_delta_chain_size;
+
+  /* Whether to index content-defined chunks of file contents and use
+   * that index to find delta bases across different nodes. */
+  svn_boolean_t content_chunking;
+
+  /* Size of the delta windows to use for new representations in bytes.
+   * 0 selects the size based on the expected size of the contents. */
+  apr_int64_t delta_window_size;
+
   /* Compression type to use with txdelta storage format in new revs. */
   compression_type_t delta_compression_type;
 
-  /* Compression level (currently, only used with compression_type_zlib). */
+  /* Compression level (used with compression_type_zlib and
+     compression_type_zstd). */
   int delta_compression_level;
 
   /* Pack after every commit. */
@@ -514,9 +638,44 @@ typedef struct fs_fs_data_t
   /* Ensure that all filesystem changes are written to disk. */
   svn_boolean_t flush_to_disk;
 
+  /* The youngest revision when bulk load mode started, or
+     SVN_INVALID_REVNUM if this instance is not in bulk load mode.
+     See svn_fs_fs__begin_bulk_load(). */
+  svn_revnum_t bulk_load_base_rev;
+
+  /* The FLUSH_TO_DISK setting to restore at the end of bulk load mode. */
+  svn_boolean_t bulk_load_flush_to_disk;
+
+  /* Rep-cache entries (representation_t *) of revisions committed in
+     bulk load mode that have not been written to the rep-cache.db, yet.
+     BULK_LOAD_REPS_HASH indexes them by their SHA1 digest.  Both are
+     allocated in BULK_LOAD_POOL and NULL if rep-sharing is disabled or
+     this instance is not in bulk load mode. */
+  apr_array_header_t *bulk_load_reps;
+  apr_hash_t *bulk_load_reps_hash;
+  apr_pool_t *bulk_load_pool;
+
+  /* Maximum number of threads to use in svn_fs_fs__verify(). */
+  int verify_jobs;
+
+  /* Maximum number of threads to use in svn_fs_fs__pack(). */
+  int pack_jobs;
+
+  /* Maximum number of threads to use in svn_fs_fs__hotcopy(). */
+  int hotcopy_jobs;
+
+  /* Maximum number of bytes per second to copy while packing revisions.
+     0 means "unlimited". */
+  apr_int64_t pack_max_io_rate;
+
   /* Pointer to svn_fs_open. */
   svn_error_t *(*svn_fs_open_)(svn_fs_t **, const char *, apr_hash_t *,
                                apr_pool_t *, apr_pool_t *);
+
+  /* The process-wide pool and its lock as passed to us by the FS loader
+     when opening this filesystem.  Used to open further instances. */
+  svn_mutex__t *common_pool_lock;
+  apr_pool_t *common_pool;
 } fs_fs_data_t;
 
 
@@ -647,6 +806,27 @@ typedef struct node_revision_t
 
 } node_revision_t;
 
+/* The fixed-size, pointer-free subset of a node_revision_t.  It can be
+ * read directly from the serialized noderev in the cache, i.e. without
+ * deserializing and copying the whole node revision. */
+typedef struct svn_fs_fs__noderev_header_t
+{
+  /* node kind */
+  svn_node_kind_t kind;
+
+  /* Revision of the predecessor node revision or SVN_INVALID_REVNUM if
+     there is no predecessor. */
+  svn_revnum_t predecessor_rev;
+
+  /* Same as in node_revision_t. */
+  int predecessor_count;
+  svn_revnum_t copyfrom_rev;
+  svn_revnum_t copyroot_rev;
+  apr_int64_t mergeinfo_count;
+  svn_boolean_t has_mergeinfo;
+
+} svn_fs_fs__noderev_header_t;
+
 
 /*** Change ***/
 typedef struct change_t
@@ -681,6 +861,10 @@ typedef struct svn_fs_fs__changes_context_t
      fetch. */
   apr_off_t next_offset;
 
+  /* Offset of the changed paths list within REVISION_FILE.  -1 until it
+     has been determined by the first read from disk. */
+  apr_off_t changes_offset;
+
   /* Has the end of the list been reached? */
   svn_boolean_t eol;
 
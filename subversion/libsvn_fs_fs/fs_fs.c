@@ -26,6 +26,7 @@
 
 #include "svn_private_config.h"
 
+#include "svn_cache_config.h"
 #include "svn_checksum.h"
 #include "svn_hash.h"
 #include "svn_props.h"
@@ -35,6 +36,7 @@
 #include "svn_version.h"
 
 #include "cached_data.h"
+#include "date-index.h"
 #include "id.h"
 #include "index.h"
 #include "low_level.h"
@@ -48,6 +50,7 @@
 #include "private/svn_io_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_task.h"
 #include "../libsvn_fs/fs-loader.h"
 
 /* The default maximum number of files per directory to store in the
@@ -693,7 +696,8 @@ parse_compression_option(compression_type_t *compression_type_p,
   int level;
   svn_boolean_t is_valid = TRUE;
 
-  /* compression = none | lz4 | zlib | zlib-1 ... zlib-9 */
+  /* compression = none | lz4 | zlib | zlib-1 ... zlib-9 |
+   *               zstd | zstd-1 ... zstd-19 */
   if (strcmp(value, "none") == 0)
     {
       type = compression_type_none;
@@ -723,6 +727,26 @@ parse_compression_option(compression_type_t *compression_type_p,
       else
         is_valid = FALSE;
     }
+  else if (strncmp(value, "zstd", 4) == 0)
+    {
+      const char *p = value + 4;
+
+      type = compression_type_zstd;
+      if (*p == 0)
+        {
+          level = SVN__COMPRESSION_ZSTD_DEFAULT;
+        }
+      else if (*p == '-')
+        {
+          p++;
+          SVN_ERR(svn_cstring_atoi(&level, p));
+          if (level < SVN__COMPRESSION_ZSTD_MIN
+              || level > SVN__COMPRESSION_ZSTD_MAX)
+            is_valid = FALSE;
+        }
+      else
+        is_valid = FALSE;
+    }
   else
     {
       is_valid = FALSE;
@@ -738,21 +762,15 @@ parse_compression_option(compression_type_t *compression_type_p,
   return SVN_NO_ERROR;
 }
 
-/* Read the configuration information of the file system at FS_PATH
- * and set the respective values in FFD.  Use pools as usual.
+/* Evaluate the configuration CONFIG of a file system and set the
+ * respective values in FFD.  Use pools as usual.
  */
 static svn_error_t *
-read_config(fs_fs_data_t *ffd,
-            const char *fs_path,
-            apr_pool_t *result_pool,
-            apr_pool_t *scratch_pool)
+parse_config(fs_fs_data_t *ffd,
+             svn_config_t *config,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
 {
-  svn_config_t *config;
-
-  SVN_ERR(svn_config_read3(&config,
-                           svn_dirent_join(fs_path, PATH_CONFIG, scratch_pool),
-                           FALSE, FALSE, FALSE, scratch_pool));
-
   /* Initialize ffd->rep_sharing_allowed. */
   if (ffd->format >= SVN_FS_FS__MIN_REP_SHARING_FORMAT)
     SVN_ERR(svn_config_get_bool(config, &ffd->rep_sharing_allowed,
@@ -780,6 +798,23 @@ read_config(fs_fs_data_t *ffd,
                                    CONFIG_SECTION_DELTIFICATION,
                                    CONFIG_OPTION_MAX_LINEAR_DELTIFICATION,
                                    SVN_FS_FS_MAX_LINEAR_DELTIFICATION));
+      SVN_ERR(svn_config_get_int64(config, &ffd->max_delta_chain_size,
+                                   CONFIG_SECTION_DELTIFICATION,
+                                   CONFIG_OPTION_MAX_DELTA_CHAIN_SIZE, 0));
+      ffd->max_delta_chain_size *= 0x400;
+
+      /* The chunk index lives in the rep-cache database. */
+      SVN_ERR(svn_config_get_bool(config, &ffd->content_chunking,
+                                  CONFIG_SECTION_DELTIFICATION,
+                                  CONFIG_OPTION_ENABLE_CONTENT_CHUNKING,
+                                  FALSE));
+      if (!ffd->rep_sharing_allowed)
+        ffd->content_chunking = FALSE;
+
+      SVN_ERR(svn_config_get_int64(config, &ffd->delta_window_size,
+                                   CONFIG_SECTION_DELTIFICATION,
+                                   CONFIG_OPTION_DELTA_WINDOW_SIZE, 0));
+      ffd->delta_window_size *= 0x400;
     }
   else
     {
@@ -787,6 +822,9 @@ read_config(fs_fs_data_t *ffd,
       ffd->deltify_properties = FALSE;
       ffd->max_deltification_walk = SVN_FS_FS_MAX_DELTIFICATION_WALK;
       ffd->max_linear_deltification = SVN_FS_FS_MAX_LINEAR_DELTIFICATION;
+      ffd->max_delta_chain_size = 0;
+      ffd->content_chunking = FALSE;
+      ffd->delta_window_size = 0;
     }
 
   /* Initialize revprop packing settings in ffd. */
@@ -825,6 +863,14 @@ read_config(fs_fs_data_t *ffd,
                                    CONFIG_SECTION_IO,
                                    CONFIG_OPTION_P2L_PAGE_SIZE,
                                    0x400));
+      SVN_ERR(svn_config_get_int64(config, &ffd->block_read_ahead,
+                                   CONFIG_SECTION_IO,
+                                   CONFIG_OPTION_BLOCK_READ_AHEAD,
+                                   4));
+      if (ffd->block_read_ahead < 0)
+        return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                 _("'%s' must not be negative"),
+                                 CONFIG_OPTION_BLOCK_READ_AHEAD);
 
       /* Don't accept unreasonable or illegal values.
        * Block size and P2L page size are in kbytes;
@@ -847,10 +893,19 @@ read_config(fs_fs_data_t *ffd,
       ffd->block_size = 0x1000; /* Matches default APR file buffer size. */
       ffd->l2p_page_size = 0x2000;    /* Matches above default. */
       ffd->p2l_page_size = 0x100000;  /* Matches above default in bytes. */
+      ffd->block_read_ahead = 0;
     }
 
   if (ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
     {
+      SVN_ERR(svn_config_get_bool(config, &ffd->mmap_packed_files,
+                                  CONFIG_SECTION_IO,
+                                  CONFIG_OPTION_MMAP_PACKED_FILES,
+                                  FALSE));
+      SVN_ERR(svn_config_get_bool(config, &ffd->shared_l2p_tables,
+                                  CONFIG_SECTION_IO,
+                                  CONFIG_OPTION_SHARED_L2P_TABLES,
+                                  FALSE));
       SVN_ERR(svn_config_get_bool(config, &ffd->pack_after_commit,
                                   CONFIG_SECTION_DEBUG,
                                   CONFIG_OPTION_PACK_AFTER_COMMIT,
@@ -858,9 +913,40 @@ read_config(fs_fs_data_t *ffd,
     }
   else
     {
+      ffd->mmap_packed_files = FALSE;
+      ffd->shared_l2p_tables = FALSE;
       ffd->pack_after_commit = FALSE;
     }
 
+  if (ffd->format >= SVN_FS_FS__MIN_LOCK_DB_FORMAT)
+    SVN_ERR(svn_config_get_bool(config, &ffd->use_lock_db,
+                                CONFIG_SECTION_LOCKS,
+                                CONFIG_OPTION_USE_LOCK_DATABASE,
+                                FALSE));
+  else
+    ffd->use_lock_db = FALSE;
+
+  /* Initialize the pack throttling in ffd.  Older formats pack while
+     holding the global write lock, so we would only delay commits. */
+  if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
+    {
+      SVN_ERR(svn_config_get_int64(config, &ffd->pack_max_io_rate,
+                                   CONFIG_SECTION_PACK,
+                                   CONFIG_OPTION_MAX_IO_RATE,
+                                   0));
+      if (ffd->pack_max_io_rate < 0)
+        return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                 _("'%s' must not be negative"),
+                                 CONFIG_OPTION_MAX_IO_RATE);
+
+      /* convert kBytes to bytes */
+      ffd->pack_max_io_rate *= 0x400;
+    }
+  else
+    {
+      ffd->pack_max_io_rate = 0;
+    }
+
   /* Initialize compression settings in ffd. */
   if (ffd->format >= SVN_FS_FS__MIN_DELTIFICATION_FORMAT)
     {
@@ -891,6 +977,18 @@ read_config(fs_fs_data_t *ffd,
                                       _("Compression type 'lz4' requires "
                                         "filesystem format 8 or higher"));
             }
+          if (ffd->delta_compression_type == compression_type_zstd)
+            {
+              if (ffd->format < SVN_FS_FS__MIN_SVNDIFF3_FORMAT)
+                return svn_error_create(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                        _("Compression type 'zstd' requires "
+                                          "filesystem format 9 or higher"));
+              if (!svn__zstd_available())
+                return svn_error_create(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                        _("Compression type 'zstd' is not "
+                                          "supported by this build of "
+                                          "Subversion"));
+            }
         }
       else if (compression_level_val)
         {
@@ -942,13 +1040,68 @@ read_config(fs_fs_data_t *ffd,
   SVN_ERR(svn_cache__make_memcache_from_config(&ffd->memcache, config,
                                                result_pool, scratch_pool));
 
+  /* Redis configuration */
+  SVN_ERR(svn_cache__make_redis_from_config(&ffd->redis, config,
+                                            result_pool, scratch_pool));
+
   SVN_ERR(svn_config_get_bool(config, &ffd->fail_stop,
                               CONFIG_SECTION_CACHES, CONFIG_OPTION_FAIL_STOP,
                               FALSE));
 
+  if (ffd->memcache)
+    {
+      svn_boolean_t async_writes;
+      SVN_ERR(svn_config_get_bool(config, &async_writes,
+                                  CONFIG_SECTION_CACHES,
+                                  CONFIG_OPTION_ASYNC_MEMCACHED_WRITES,
+                                  FALSE));
+      if (async_writes)
+        SVN_ERR(svn_cache__memcache_enable_async_sets(ffd->memcache));
+    }
+
+  SVN_ERR(svn_config_get_bool(config, &ffd->compress_cached_texts,
+                              CONFIG_SECTION_CACHES,
+                              CONFIG_OPTION_COMPRESS_CACHED_TEXTS,
+                              FALSE));
+
+  SVN_ERR(svn_config_get_int64(config, &ffd->cache_quota,
+                               CONFIG_SECTION_CACHES,
+                               CONFIG_OPTION_CACHE_QUOTA,
+                               0));
+  if (ffd->cache_quota < 0 || ffd->cache_quota > 100)
+    return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                             _("'%s' must be between 0 and 100"),
+                             CONFIG_OPTION_CACHE_QUOTA);
+
+  svn_config_get(config, &ffd->cache_quota_group,
+                 CONFIG_SECTION_CACHES,
+                 CONFIG_OPTION_CACHE_QUOTA_GROUP, NULL);
+  if (ffd->cache_quota_group)
+    ffd->cache_quota_group = apr_pstrdup(result_pool,
+                                         ffd->cache_quota_group);
+
   return SVN_NO_ERROR;
 }
 
+/* Read the configuration information of the file system at FS_PATH
+ * and set the respective values in FFD.  Use pools as usual.
+ */
+static svn_error_t *
+read_config(fs_fs_data_t *ffd,
+            const char *fs_path,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  svn_config_t *config;
+
+  SVN_ERR(svn_config_read3(&config,
+                           svn_dirent_join(fs_path, PATH_CONFIG, scratch_pool),
+                           FALSE, FALSE, FALSE, scratch_pool));
+
+  return svn_error_trace(parse_config(ffd, config, result_pool,
+                                      scratch_pool));
+}
+
 static svn_error_t *
 write_config(svn_fs_t *fs,
              apr_pool_t *pool)
@@ -972,12 +1125,46 @@ write_config(svn_fs_t *fs,
 "### no authentication for reads or writes, so you must ensure that your"    NL
 "### memcached servers are only accessible by trusted users."                NL
 ""                                                                           NL
+"[" SVN_CACHE_CONFIG_CATEGORY_REDIS_SERVERS "]"                              NL
+"### These options name Redis servers used to cache FSFS fulltexts,"         NL
+"### e.g. to share them between several server frontends.  Specify each"     NL
+"### of them as an option like so:"                                          NL
+"# first-server = 127.0.0.1:6379"                                            NL
+"### The option name is ignored; the value is of the form HOST:PORT."        NL
+"### Keys are distributed over the servers by consistent hashing, so"        NL
+"### all clients must use the same server list.  Cached data never"          NL
+"### expires; configure the servers with a maxmemory limit and an"           NL
+"### eviction policy such as allkeys-lru.  If memcached servers are"         NL
+"### configured as well, those take precedence.  The same restrictions"     NL
+"### on sharing and trust as for memcached apply."                           NL
+""                                                                           NL
 "[" CONFIG_SECTION_CACHES "]"                                                NL
 "### When a cache-related error occurs, normally Subversion ignores it"      NL
 "### and continues, logging an error if the server is appropriately"         NL
 "### configured (and ignoring it with file:// access).  To make"             NL
 "### Subversion never ignore cache errors, uncomment this line."             NL
 "# " CONFIG_OPTION_FAIL_STOP " = true"                                       NL
+"### When memcached servers are configured, writes to them normally wait"    NL
+"### for the server's reply.  Uncomment this line to let a background"       NL
+"### thread send them instead.  Cached data may then become visible to"      NL
+"### other processes slightly later and write errors won't be reported."     NL
+"# " CONFIG_OPTION_ASYNC_MEMCACHED_WRITES " = true"                          NL
+"### File contents and deltas are normally kept uncompressed in the"         NL
+"### in-memory cache.  Uncomment this line to store them LZ4-compressed"     NL
+"### instead.  This typically allows for caching two to three times as"      NL
+"### much source code at a small CPU cost.  It has no effect on memcached."  NL
+"# " CONFIG_OPTION_COMPRESS_CACHED_TEXTS " = true"                           NL
+"### All repositories normally compete for the same in-memory cache.  To"    NL
+"### keep a single busy repository from pushing everybody else's data out"   NL
+"### of the cache, limit the share of the cache that the data of this"       NL
+"### repository may occupy, in percent.  The limit is soft: free cache"      NL
+"### space may still be used but other repositories' data won't be evicted"  NL
+"### for this repository once it exceeds its share.  0 means no limit."      NL
+"# " CONFIG_OPTION_CACHE_QUOTA " = 0"                                        NL
+"### Repositories with the same quota group share a single quota.  By"       NL
+"### default, every repository forms a group of its own.  The group of a"    NL
+"### repository only changes when the server process gets restarted."        NL
+"# " CONFIG_OPTION_CACHE_QUOTA_GROUP " = customer-a"                         NL
 ""                                                                           NL
 "[" CONFIG_SECTION_REP_SHARING "]"                                           NL
 "### To conserve space, the filesystem can optionally avoid storing"         NL
@@ -1056,22 +1243,57 @@ write_config(svn_fs_t *fs,
 "### For 1.8, the default value is 16; earlier versions use 1."              NL
 "# " CONFIG_OPTION_MAX_LINEAR_DELTIFICATION " = 16"                          NL
 "###"                                                                        NL
+"### Long delta chains make reading the latest versions of a node slow."     NL
+"### This setting limits the amount of data, in kBytes, that has to be read" NL
+"### to reconstruct a deltification base.  If the delta chain of the base"   NL
+"### chosen by the above rules exceeds that size, the node will be stored"   NL
+"### as a self-contained representation and a new delta chain begins."       NL
+"### Smaller values speed up reading at the expense of disk space."          NL
+"### A value of 0 will impose no limit and is the default."                  NL
+"# " CONFIG_OPTION_MAX_DELTA_CHAIN_SIZE " = 0"                               NL
+"###"                                                                        NL
+"### Delta bases are normally taken from the history of the same node.  If"  NL
+"### this option is enabled, FSFS splits file contents into chunks at"       NL
+"### content-defined boundaries and records a sample of them in the"         NL
+"### rep-cache database.  New file contents that share enough chunks with"   NL
+"### an existing representation of another node get stored as a delta"       NL
+"### against that representation instead.  This can save a lot of space"     NL
+"### in repositories with large, similar binaries such as copied and"        NL
+"### modified assets.  Enabling it costs some CPU time during commits and"   NL
+"### requires rep-sharing to be enabled.  It is disabled by default."        NL
+"# " CONFIG_OPTION_ENABLE_CONTENT_CHUNKING " = false"                        NL
+"###"                                                                        NL
+"### Deltas are stored as a sequence of windows, each describing a range"    NL
+"### of the contents.  Larger windows find more matches in large files"      NL
+"### but need more memory to read and write.  By default, FSFS picks the"    NL
+"### window size based on the expected size of the contents:  1 MB for"      NL
+"### files of at least 4 MB, down to 4 kB for very small contents and the"   NL
+"### classic 100 kB in between.  This option sets a fixed size in kBytes"    NL
+"### instead.  Repositories before format 9 are limited to 100 kB."          NL
+"# " CONFIG_OPTION_DELTA_WINDOW_SIZE " = 0"                                  NL
+"###"                                                                        NL
 "### After deltification, we compress the data to minimize on-disk size."    NL
 "### This setting controls the compression algorithm, which will be used in" NL
 "### future revisions.  It can be used to either disable compression or to"  NL
-"### select between available algorithms (zlib, lz4).  zlib is a general-"   NL
-"### purpose compression algorithm.  lz4 is a fast compression algorithm"    NL
-"### which should be preferred for repositories with large and, possibly,"   NL
-"### incompressible files.  Note that the compression ratio of lz4 is"       NL
-"### usually lower than the one provided by zlib, but using it can"          NL
+"### select between available algorithms (zlib, lz4, zstd).  zlib is a"      NL
+"### general-purpose compression algorithm.  lz4 is a fast compression"      NL
+"### algorithm which should be preferred for repositories with large and,"   NL
+"### possibly, incompressible files.  Note that the compression ratio of"    NL
+"### lz4 is usually lower than the one provided by zlib, but using it can"   NL
 "### significantly speed up commits as well as reading the data."            NL
 "### lz4 compression algorithm is supported, starting from format 8"         NL
 "### repositories, available in Subversion 1.10 and higher."                 NL
+"### zstd (Zstandard) typically compresses text better than zlib while"      NL
+"### decompressing several times faster, making it a good choice for"        NL
+"### frequently read repositories.  It is supported, starting from format 9" NL
+"### repositories, if Subversion has been built with zstd support."          NL
 "### The syntax of this option is:"                                          NL
-"###   " CONFIG_OPTION_COMPRESSION " = none | lz4 | zlib | zlib-1 ... zlib-9" NL
+"###   " CONFIG_OPTION_COMPRESSION " = none | lz4 | zlib | zlib-1 ... zlib-9 |" NL
+"###                 zstd | zstd-1 ... zstd-19"                              NL
 "### Versions prior to Subversion 1.10 will ignore this option."             NL
 "### The default value is 'lz4' if supported by the repository format and"   NL
-"### 'zlib' otherwise.  'zlib' is currently equivalent to 'zlib-5'."         NL
+"### 'zlib' otherwise.  'zlib' is currently equivalent to 'zlib-5' and"      NL
+"### 'zstd' is equivalent to 'zstd-3'."                                      NL
 "# " CONFIG_OPTION_COMPRESSION " = lz4"                                      NL
 "###"                                                                        NL
 "### DEPRECATED: The new '" CONFIG_OPTION_COMPRESSION "' option deprecates previously used" NL
@@ -1148,6 +1370,58 @@ write_config(svn_fs_t *fs,
 "### Must be a power of 2."                                                  NL
 "### p2l-page-size is given in kBytes and with a default of 1024 kBytes."    NL
 "# " CONFIG_OPTION_P2L_PAGE_SIZE " = 1024"                                   NL
+"###"                                                                        NL
+"### If block-read has been enabled, Subversion will tell the OS to fetch"   NL
+"### the blocks following the one currently being read in the background."   NL
+"### This hides the access latency of network storage like NFS while"        NL
+"### streaming larger amounts of data, e.g. during checkouts and exports."   NL
+"### Reading ahead too many blocks may waste I/O bandwidth on random"        NL
+"### access patterns.  Set this to 0 to disable read-ahead."                 NL
+"### block-read-ahead is given in blocks and with a default of 4 blocks."    NL
+"# " CONFIG_OPTION_BLOCK_READ_AHEAD " = 4"                                   NL
+"###"                                                                        NL
+"### Pack files never change once they have been written.  Subversion may"   NL
+"### therefore map them into memory and read revision contents as well as"   NL
+"### index data directly from the mapping instead of issuing a system call"  NL
+"### per access.  This can significantly reduce the CPU load of read-mostly" NL
+"### servers.  It requires enough virtual address space to map the pack"     NL
+"### files being accessed, i.e. it should only be enabled on 64 bit"         NL
+"### systems.  Files that cannot be mapped will be read as usual.  Packed"   NL
+"### revprop files will also be decompressed directly from the mapping."     NL
+"### mmap-packed-files is disabled by default."                              NL
+"# " CONFIG_OPTION_MMAP_PACKED_FILES " = false"                              NL
+"###"                                                                        NL
+"### In format 7 repositories, every process decodes and caches the log-"    NL
+"### to-phys index pages of packed shards on its own.  If enabled, packing"  NL
+"### a shard also writes a decoded copy of that index next to the pack"      NL
+"### file.  Readers will map that copy into memory and look up item"         NL
+"### offsets directly, sharing the data with all other processes through"    NL
+"### the OS page cache.  This e.g. avoids the index decoding cost after"     NL
+"### server restarts.  Shards packed while this option is off will use"      NL
+"### the regular index.  shared-l2p-tables is disabled by default."          NL
+"# " CONFIG_OPTION_SHARED_L2P_TABLES " = false"                              NL
+""                                                                           NL
+"[" CONFIG_SECTION_LOCKS "]"                                                 NL
+"### By default, each lock is stored in a separate file and every parent"    NL
+"### directory of a locked path gets an index file listing the locks below"  NL
+"### it.  Repositories with many locks will then spend a lot of time on"     NL
+"### small file I/O while listing locks and checking them during commits."   NL
+"### If enabled, format 9 repositories and later keep all locks in a single" NL
+"### SQLite database instead.  Querying a subtree becomes a range scan and"  NL
+"### locking or unlocking many paths at once takes a single write.  Locks"   NL
+"### stored in files will be moved into the database the next time locks"   NL
+"### are being modified.  Disabling this option again will make locks in"   NL
+"### the database invisible.  use-lock-database is disabled by default."     NL
+"# " CONFIG_OPTION_USE_LOCK_DATABASE " = false"                              NL
+""                                                                           NL
+"[" CONFIG_SECTION_PACK "]"                                                  NL
+"### This parameter limits the rate (in kBytes per second) at which"         NL
+"### revision data gets copied while packing shards in format 7"             NL
+"### repositories and later.  The limit applies to the whole pack run,"      NL
+"### i.e. it is shared between all worker threads.  Setting it allows"       NL
+"### packing to run alongside regular repository access without starving"    NL
+"### readers of I/O bandwidth.  The default of 0 means 'unlimited'."         NL
+"# " CONFIG_OPTION_MAX_IO_RATE " = 0"                                        NL
 ""                                                                           NL
 "[" CONFIG_SECTION_DEBUG "]"                                                 NL
 "###"                                                                        NL
@@ -1174,6 +1448,21 @@ read_global_config(svn_fs_t *fs)
   ffd->flush_to_disk = !svn_hash__get_bool(fs->config,
                                            SVN_FS_CONFIG_NO_FLUSH_TO_DISK,
                                            FALSE);
+  SVN_ERR(svn_cstring_atoi(&ffd->verify_jobs,
+                           svn_hash__get_cstring(
+                             fs->config, SVN_FS_CONFIG_FSFS_VERIFY_JOBS,
+                             "1")));
+  SVN_ERR(svn_cstring_atoi(&ffd->pack_jobs,
+                           svn_hash__get_cstring(
+                             fs->config, SVN_FS_CONFIG_FSFS_PACK_JOBS,
+                             "1")));
+  SVN_ERR(svn_cstring_atoi(&ffd->hotcopy_jobs,
+                           svn_hash__get_cstring(
+                             fs->config, SVN_FS_CONFIG_FSFS_HOTCOPY_JOBS,
+                             "1")));
+  ffd->use_rep_cache_filter
+    = svn_hash__get_bool(fs->config, SVN_FS_CONFIG_FSFS_REP_CACHE_FILTER,
+                         FALSE);
 
   /* Ignore the user-specified larger block size if we don't use block-read.
      Defaulting to 4k gives us the same access granularity in format 7 as in
@@ -1240,24 +1529,288 @@ svn_fs_fs__read_format_file(svn_fs_t *fs, apr_pool_t *scratch_pool)
   return SVN_NO_ERROR;
 }
 
+/* Prefix of the common pool userdata keys under which open_info_t
+   structures are stored.  The repository's absolute path follows. */
+#define SVN_FSFS_OPEN_INFO_USERDATA_PREFIX "svn-fsfs-open-info-"
+
+/* What we remember about a file to tell whether it has been changed. */
+typedef struct file_stamp_t
+{
+  apr_time_t mtime;
+  apr_time_t ctime;
+  apr_off_t size;
+} file_stamp_t;
+
+/* The contents of the format, uuid and fsfs.conf files of a repository,
+   cached process-wide by get_open_info().  Never modified once
+   published. */
+typedef struct open_info_t
+{
+  file_stamp_t format_stamp;
+  file_stamp_t uuid_stamp;
+  file_stamp_t config_stamp;
+
+  int format;
+  int max_files_per_dir;
+  svn_boolean_t use_log_addressing;
+  const char *uuid;
+  const char *instance_id;
+
+  /* Read-only.  Use shallow copies. */
+  svn_config_t *config;
+
+  /* The pool this structure is allocated in. */
+  apr_pool_t *pool;
+} open_info_t;
+
+/* Set *STAMP for the file at PATH.  A missing file gets an all-zero
+   stamp.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+get_file_stamp(file_stamp_t *stamp,
+               const char *path,
+               apr_pool_t *scratch_pool)
+{
+  apr_finfo_t finfo;
+  svn_error_t *err;
+
+  memset(stamp, 0, sizeof(*stamp));
+  err = svn_io_stat(&finfo, path,
+                    APR_FINFO_MTIME | APR_FINFO_CTIME | APR_FINFO_SIZE,
+                    scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  stamp->mtime = finfo.mtime;
+  stamp->ctime = finfo.ctime;
+  stamp->size = finfo.size;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if the file stamps LHS and RHS are equal. */
+static svn_boolean_t
+file_stamps_equal(const file_stamp_t *lhs,
+                  const file_stamp_t *rhs)
+{
+  return lhs->mtime == rhs->mtime
+      && lhs->ctime == rhs->ctime
+      && lhs->size == rhs->size;
+}
+
+/* Implements apr_pool_cleanup_t.  Destroy DATA, the pool of a cached
+   open_info_t. */
+static apr_status_t
+destroy_open_info_pool(void *data)
+{
+  svn_pool_destroy(data);
+  return APR_SUCCESS;
+}
+
+/* Baton type for lookup_open_info and publish_open_info. */
+typedef struct open_info_baton_t
+{
+  apr_pool_t *common_pool;
+  const char *key;
+  open_info_t *info;
+} open_info_baton_t;
+
+/* Set BATON->INFO to the open_info_t stored in BATON->COMMON_POOL under
+   BATON->KEY, or to NULL if there is none.  Call with the common pool
+   lock held. */
+static svn_error_t *
+lookup_open_info(open_info_baton_t *baton)
+{
+  void *val;
+  apr_status_t status;
+
+  status = apr_pool_userdata_get(&val, baton->key, baton->common_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't fetch FSFS shared data"));
+
+  baton->info = val;
+
+  return SVN_NO_ERROR;
+}
+
+/* Store BATON->INFO in BATON->COMMON_POOL under BATON->KEY, replacing any
+   previous entry, and tie the lifetime of BATON->INFO->POOL to the common
+   pool.  Call with the common pool lock held. */
+static svn_error_t *
+publish_open_info(open_info_baton_t *baton)
+{
+  void *val;
+  apr_status_t status;
+
+  /* Keys must live as long as the pool.  Re-use an existing one. */
+  status = apr_pool_userdata_get(&val, baton->key, baton->common_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't fetch FSFS shared data"));
+  if (!val)
+    baton->key = apr_pstrdup(baton->common_pool, baton->key);
+
+  /* Replaced entries may still be in use by other threads, so they are
+     only released together with the common pool. */
+  apr_pool_cleanup_register(baton->common_pool, baton->info->pool,
+                            destroy_open_info_pool, apr_pool_cleanup_null);
+
+  status = apr_pool_userdata_set(baton->info, baton->key, NULL,
+                                 baton->common_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't store FSFS shared data"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the format, uuid and configuration of FS into a new open_info_t
+   with the given file stamps and return it in *INFO.  Use FS itself as
+   temporary storage.  Allocate *INFO in a new, unshared root pool.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_open_info(open_info_t **info,
+               svn_fs_t *fs,
+               const file_stamp_t *format_stamp,
+               const file_stamp_t *uuid_stamp,
+               const file_stamp_t *config_stamp,
+               apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *pool;
+  open_info_t *new_info;
+  svn_error_t *err;
+
+  SVN_ERR(svn_fs_fs__read_format_file(fs, scratch_pool));
+  SVN_ERR(read_uuid(fs, scratch_pool));
+
+  /* The common pool is not thread-safe, so use a pool of our own. */
+  pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  new_info = apr_pcalloc(pool, sizeof(*new_info));
+  new_info->pool = pool;
+  new_info->format_stamp = *format_stamp;
+  new_info->uuid_stamp = *uuid_stamp;
+  new_info->config_stamp = *config_stamp;
+  new_info->format = ffd->format;
+  new_info->max_files_per_dir = ffd->max_files_per_dir;
+  new_info->use_log_addressing = ffd->use_log_addressing;
+  new_info->uuid = apr_pstrdup(pool, fs->uuid);
+  new_info->instance_id = apr_pstrdup(pool, ffd->instance_id);
+
+  err = svn_config_read3(&new_info->config,
+                         svn_dirent_join(fs->path, PATH_CONFIG,
+                                         scratch_pool),
+                         FALSE, FALSE, FALSE, pool);
+  if (err)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_trace(err);
+    }
+
+  /* Expand all values, so shallow copies can be used concurrently. */
+  svn_config__set_read_only(new_info->config, scratch_pool);
+
+  *info = new_info;
+  return SVN_NO_ERROR;
+}
+
+/* Set *INFO to the format, uuid and configuration of FS, reading them
+   from disk only if they have changed since an earlier call for the same
+   repository.  Callers must not modify *INFO.
+
+   Servers open the same repositories over and over again, e.g. once per
+   request, while these files rarely ever change.  A few stats are much
+   cheaper than reading and parsing them each time.
+
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+get_open_info(const open_info_t **info,
+              svn_fs_t *fs,
+              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  open_info_baton_t baton;
+  file_stamp_t format_stamp, uuid_stamp, config_stamp;
+  const char *abspath;
+
+  SVN_ERR(svn_dirent_get_absolute(&abspath, fs->path, scratch_pool));
+  baton.common_pool = ffd->common_pool;
+  baton.key = apr_pstrcat(scratch_pool, SVN_FSFS_OPEN_INFO_USERDATA_PREFIX,
+                          abspath, SVN_VA_NULL);
+
+  SVN_ERR(get_file_stamp(&format_stamp, path_format(fs, scratch_pool),
+                         scratch_pool));
+  SVN_ERR(get_file_stamp(&uuid_stamp, path_uuid(fs, scratch_pool),
+                         scratch_pool));
+  SVN_ERR(get_file_stamp(&config_stamp,
+                         svn_dirent_join(fs->path, PATH_CONFIG, scratch_pool),
+                         scratch_pool));
+
+  SVN_MUTEX__WITH_LOCK(ffd->common_pool_lock, lookup_open_info(&baton));
+  if (   baton.info
+      && file_stamps_equal(&baton.info->format_stamp, &format_stamp)
+      && file_stamps_equal(&baton.info->uuid_stamp, &uuid_stamp)
+      && file_stamps_equal(&baton.info->config_stamp, &config_stamp))
+    {
+      *info = baton.info;
+      return SVN_NO_ERROR;
+    }
+
+  /* Should the files change between our stat and read calls, the stamps
+     won't match next time and we simply read them again. */
+  SVN_ERR(read_open_info(&baton.info, fs, &format_stamp, &uuid_stamp,
+                         &config_stamp, scratch_pool));
+
+  /* Concurrent opens may race here.  All of their entries are valid. */
+  SVN_MUTEX__WITH_LOCK(ffd->common_pool_lock, publish_open_info(&baton));
+
+  *info = baton.info;
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__open(svn_fs_t *fs, const char *path, apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
   fs->path = apr_pstrdup(fs->pool, path);
 
-  /* Read the FS format file. */
-  SVN_ERR(svn_fs_fs__read_format_file(fs, pool));
+  if (ffd->common_pool)
+    {
+      /* Take the format, uuid and configuration from the process-wide
+         cache. */
+      const open_info_t *info;
 
-  /* Read in and cache the repository uuid. */
-  SVN_ERR(read_uuid(fs, pool));
+      SVN_ERR(get_open_info(&info, fs, pool));
 
-  /* Read the min unpacked revision. */
-  if (ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
-    SVN_ERR(svn_fs_fs__update_min_unpacked_rev(fs, pool));
+      ffd->format = info->format;
+      ffd->max_files_per_dir = info->max_files_per_dir;
+      ffd->use_log_addressing = info->use_log_addressing;
+      fs->uuid = apr_pstrdup(fs->pool, info->uuid);
+      ffd->instance_id = apr_pstrdup(fs->pool, info->instance_id);
 
-  /* Read the configuration file. */
-  SVN_ERR(read_config(ffd, fs->path, fs->pool, pool));
+      /* Read the min unpacked revision. */
+      if (ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
+        SVN_ERR(svn_fs_fs__update_min_unpacked_rev(fs, pool));
+
+      SVN_ERR(parse_config(ffd, svn_config__shallow_copy(info->config, pool),
+                           fs->pool, pool));
+    }
+  else
+    {
+      /* Read the FS format file. */
+      SVN_ERR(svn_fs_fs__read_format_file(fs, pool));
+
+      /* Read in and cache the repository uuid. */
+      SVN_ERR(read_uuid(fs, pool));
+
+      /* Read the min unpacked revision. */
+      if (ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
+        SVN_ERR(svn_fs_fs__update_min_unpacked_rev(fs, pool));
+
+      /* Read the configuration file. */
+      SVN_ERR(read_config(ffd, fs->path, fs->pool, pool));
+    }
 
   /* Global configuration options. */
   SVN_ERR(read_global_config(fs));
@@ -1886,6 +2439,9 @@ svn_fs_fs__create_file_tree(svn_fs_t *fs,
   /* Global configuration options. */
   SVN_ERR(read_global_config(fs));
 
+  /* Create the date index.  Revision 0 will be its first entry. */
+  SVN_ERR(svn_fs_fs__create_date_index(fs, pool));
+
   /* Add revision 0. */
   SVN_ERR(write_revision_zero(fs, pool));
 
@@ -1952,6 +2508,13 @@ svn_fs_fs__create(svn_fs_t *fs,
           case 9: format = 7;
                   break;
 
+          case 10:
+          case 11:
+          case 12:
+          case 13:
+          case 14: format = 8;
+                  break;
+
           default:format = SVN_FS_FS__FORMAT_NUMBER;
         }
 
@@ -2323,8 +2886,11 @@ svn_fs_fs__info_format(int *fs_format,
     case 8:
       (*supports_version)->minor = 10;
       break;
+    case 9:
+      (*supports_version)->minor = 15;
+      break;
 #ifdef SVN_DEBUG
-# if SVN_FS_FS__FORMAT_NUMBER != 8
+# if SVN_FS_FS__FORMAT_NUMBER != 9
 #  error "Need to add a 'case' statement here"
 # endif
 #endif
@@ -2371,18 +2937,20 @@ ensure_representation_sha1(svn_fs_t *fs,
 /* Recursively index (in the rep-cache) the filesystem node with the
  * given ID, located in revision REV and its matching REV_FILE (if the
  * node ID cannot be found in this revision, do nothing).
- * Compute the SHA1 checksum of the node's representation and add
- * a corresponding entry to the repository's rep-cache.
+ * Compute the SHA1 checksum of the node's representation and append
+ * a copy of it, allocated in RESULT_POOL, to REPS.
  * If the node represents a directory this function will recurse and
  * index all children of this directory as well. */
 static svn_error_t *
-reindex_node(svn_fs_t *fs,
+reindex_node(apr_array_header_t *reps,
+             svn_fs_t *fs,
              const svn_fs_id_t *id,
              svn_revnum_t rev,
              svn_fs_fs__revision_file_t *rev_file,
              svn_cancel_func_t cancel_func,
              void *cancel_baton,
-             apr_pool_t *pool)
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
 {
   node_revision_t *noderev;
   apr_off_t offset;
@@ -2396,29 +2964,32 @@ reindex_node(svn_fs_t *fs,
     SVN_ERR(cancel_func(cancel_baton));
 
   SVN_ERR(svn_fs_fs__item_offset(&offset, fs, rev_file, rev, NULL,
-                                 svn_fs_fs__id_item(id), pool));
+                                 svn_fs_fs__id_item(id), scratch_pool));
 
-  SVN_ERR(svn_io_file_seek(rev_file->file, APR_SET, &offset, pool));
+  SVN_ERR(svn_io_file_seek(rev_file->file, APR_SET, &offset, scratch_pool));
   SVN_ERR(svn_fs_fs__read_noderev(&noderev, rev_file->stream,
-                                  pool, pool));
+                                  scratch_pool, scratch_pool));
 
   /* Make sure EXPANDED_SIZE has the correct value for every rep. */
-  SVN_ERR(svn_fs_fs__fixup_expanded_size(fs, noderev->data_rep, pool));
-  SVN_ERR(svn_fs_fs__fixup_expanded_size(fs, noderev->prop_rep, pool));
+  SVN_ERR(svn_fs_fs__fixup_expanded_size(fs, noderev->data_rep,
+                                         scratch_pool));
+  SVN_ERR(svn_fs_fs__fixup_expanded_size(fs, noderev->prop_rep,
+                                         scratch_pool));
 
   /* First reindex sub-directory to match write_final_rev() behavior. */
   if (noderev->kind == svn_node_dir)
     {
       apr_array_header_t *entries;
 
-      SVN_ERR(svn_fs_fs__rep_contents_dir(&entries, fs, noderev, pool, pool));
+      SVN_ERR(svn_fs_fs__rep_contents_dir(&entries, fs, noderev,
+                                          scratch_pool, scratch_pool));
 
       if (entries->nelts > 0)
         {
           int i;
           apr_pool_t *iterpool;
 
-          iterpool = svn_pool_create(pool);
+          iterpool = svn_pool_create(scratch_pool);
           for (i = 0; i < entries->nelts; i++)
             {
               const svn_fs_dirent_t *dirent;
@@ -2427,8 +2998,9 @@ reindex_node(svn_fs_t *fs,
 
               dirent = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *);
 
-              SVN_ERR(reindex_node(fs, dirent->id, rev, rev_file,
-                                   cancel_func, cancel_baton, iterpool));
+              SVN_ERR(reindex_node(reps, fs, dirent->id, rev, rev_file,
+                                   cancel_func, cancel_baton,
+                                   result_pool, iterpool));
             }
           svn_pool_destroy(iterpool);
         }
@@ -2437,23 +3009,232 @@ reindex_node(svn_fs_t *fs,
   if (noderev->data_rep && noderev->data_rep->revision == rev &&
       noderev->kind == svn_node_file)
     {
-      SVN_ERR(ensure_representation_sha1(fs, noderev->data_rep, pool));
-      SVN_ERR(svn_fs_fs__set_rep_reference(fs, noderev->data_rep, pool));
+      SVN_ERR(ensure_representation_sha1(fs, noderev->data_rep,
+                                         scratch_pool));
+      APR_ARRAY_PUSH(reps, representation_t *)
+        = svn_fs_fs__rep_copy(noderev->data_rep, result_pool);
     }
 
   if (noderev->prop_rep && noderev->prop_rep->revision == rev)
     {
-      SVN_ERR(ensure_representation_sha1(fs, noderev->prop_rep, pool));
-      SVN_ERR(svn_fs_fs__set_rep_reference(fs, noderev->prop_rep, pool));
+      SVN_ERR(ensure_representation_sha1(fs, noderev->prop_rep,
+                                         scratch_pool));
+      APR_ARRAY_PUSH(reps, representation_t *)
+        = svn_fs_fs__rep_copy(noderev->prop_rep, result_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Append to REPS all representations in revision REV of FS that
+ * belong into the rep-cache, allocated in RESULT_POOL.  Use SCRATCH_POOL
+ * for temporary allocations. */
+static svn_error_t *
+reindex_revision(apr_array_header_t *reps,
+                 svn_fs_t *fs,
+                 svn_revnum_t rev,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  svn_fs_id_t *root_id;
+  svn_fs_fs__revision_file_t *file;
+
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&file, fs, rev,
+                                           scratch_pool, scratch_pool));
+  SVN_ERR(svn_fs_fs__rev_get_root(&root_id, fs, rev, scratch_pool,
+                                  scratch_pool));
+  SVN_ERR(reindex_node(reps, fs, root_id, rev, file, cancel_func,
+                       cancel_baton, result_pool, scratch_pool));
+
+  return svn_error_trace(svn_fs_fs__close_revision_file(file));
+}
+
+/* Add the representations in REPS to the rep-cache of FS, all within
+ * a single SQLite transaction.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+store_rep_references(svn_fs_t *fs,
+                     const apr_array_header_t *reps,
+                     apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  SVN_ERR(svn_sqlite__begin_transaction(ffd->rep_cache_db));
+  for (i = 0; !err && i < reps->nelts; i++)
+    {
+      svn_pool_clear(iterpool);
+      err = svn_fs_fs__set_rep_reference(fs,
+                                         APR_ARRAY_IDX(reps, i,
+                                                       representation_t *),
+                                         iterpool);
     }
+  SVN_ERR(svn_sqlite__finish_transaction(ffd->rep_cache_db, err));
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Number of revisions that a worker indexes in one go when building the
+ * rep-cache concurrently.  All of their representations get added to the
+ * rep-cache in a single transaction. */
+#define REP_CACHE_BATCH_SIZE 64
+
+/* Baton type used with the callbacks of build_rep_cache_concurrently().
+ * Each work item covers REP_CACHE_BATCH_SIZE revisions of the revision
+ * range START to END.
+ */
+typedef struct build_rep_cache_baton_t
+{
+  /* The filesystem being indexed, as opened by the caller. */
+  svn_fs_t *fs;
+
+  /* Revision range to index. */
+  svn_revnum_t start;
+  svn_revnum_t end;
+
+  /* Progress notification callback to invoke for each revision
+   * (may be NULL). */
+  svn_fs_progress_notify_func_t progress_func;
+
+  /* Baton to use with PROGRESS_FUNC. */
+  void *progress_baton;
+} build_rep_cache_baton_t;
+
+/* Set *BATCH_START and *BATCH_END to the first and last revision within
+ * *BATON that belong to the work item with the given INDEX. */
+static void
+get_batch_range(svn_revnum_t *batch_start,
+                svn_revnum_t *batch_end,
+                const build_rep_cache_baton_t *baton,
+                int index)
+{
+  *batch_start = baton->start + (svn_revnum_t)index * REP_CACHE_BATCH_SIZE;
+  *batch_end = MIN(baton->end, *batch_start + REP_CACHE_BATCH_SIZE - 1);
+}
+
+/* Implements svn_task__thread_context_constructor_t.
+ * Open a separate instance of the filesystem given by the
+ * build_rep_cache_baton_t in CONTEXT_BATON, such that each thread can use
+ * its own, non-thread-safe caches. */
+static svn_error_t *
+open_reindex_fs(void **thread_context,
+                void *context_baton,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  build_rep_cache_baton_t *baton = context_baton;
+  svn_fs_t *worker_fs;
+
+  SVN_ERR(svn_fs_fs__open_instance(&worker_fs, baton->fs, result_pool,
+                                   scratch_pool));
+  *thread_context = worker_fs;
 
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_task__process_func_t.
+ * Collect the representations of the revisions in the work item with the
+ * given INDEX using the filesystem instance in THREAD_CONTEXT and return
+ * them as an array of representation_t * in *RESULT. */
+static svn_error_t *
+reindex_batch(void **result,
+              int index,
+              void *process_baton,
+              void *thread_context,
+              svn_cancel_func_t cancel_func,
+              void *cancel_baton,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  build_rep_cache_baton_t *baton = process_baton;
+  svn_fs_t *worker_fs = thread_context;
+  apr_array_header_t *reps;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t batch_start, batch_end, rev;
+
+  get_batch_range(&batch_start, &batch_end, baton, index);
+  reps = apr_array_make(result_pool, 16, sizeof(representation_t *));
+
+  for (rev = batch_start; rev <= batch_end; rev++)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(reindex_revision(reps, worker_fs, rev, cancel_func,
+                               cancel_baton, result_pool, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  *result = reps;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.
+ * Add the representations in RESULT, found in the work item with the
+ * given INDEX, to the rep-cache and notify the progress for each of its
+ * revisions. */
+static svn_error_t *
+store_batch(void *result,
+            int index,
+            void *output_baton,
+            svn_cancel_func_t cancel_func,
+            void *cancel_baton,
+            apr_pool_t *scratch_pool)
+{
+  build_rep_cache_baton_t *baton = output_baton;
+  apr_array_header_t *reps = result;
+  svn_revnum_t batch_start, batch_end, rev;
+
+  get_batch_range(&batch_start, &batch_end, baton, index);
+  SVN_ERR(store_rep_references(baton->fs, reps, scratch_pool));
+
+  if (baton->progress_func)
+    for (rev = batch_start; rev <= batch_end; rev++)
+      baton->progress_func(rev, baton->progress_baton, scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Like the sequential loop in svn_fs_fs__build_rep_cache() but scan the
+ * revisions START to END using up to JOBS threads.  The rep-cache gets
+ * updated from this thread in revision order, one transaction per batch
+ * of revisions.
+ */
+static svn_error_t *
+build_rep_cache_concurrently(svn_fs_t *fs,
+                             int jobs,
+                             svn_revnum_t start,
+                             svn_revnum_t end,
+                             svn_fs_progress_notify_func_t progress_func,
+                             void *progress_baton,
+                             svn_cancel_func_t cancel_func,
+                             void *cancel_baton,
+                             apr_pool_t *pool)
+{
+  build_rep_cache_baton_t baton;
+  int batch_count = (int)((end - start) / REP_CACHE_BATCH_SIZE + 1);
+
+  baton.fs = fs;
+  baton.start = start;
+  baton.end = end;
+  baton.progress_func = progress_func;
+  baton.progress_baton = progress_baton;
+
+  return svn_error_trace(svn_task__run(jobs, batch_count,
+                                       reindex_batch, &baton,
+                                       store_batch, &baton,
+                                       open_reindex_fs, &baton,
+                                       cancel_func, cancel_baton, pool));
+}
+
 svn_error_t *
 svn_fs_fs__build_rep_cache(svn_fs_t *fs,
                            svn_revnum_t start_rev,
                            svn_revnum_t end_rev,
+                           int jobs,
                            svn_fs_progress_notify_func_t progress_func,
                            void *progress_baton,
                            svn_cancel_func_t cancel_func,
@@ -2495,27 +3276,31 @@ svn_fs_fs__build_rep_cache(svn_fs_t *fs,
   if (!ffd->rep_cache_db)
     SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
 
+  /* Worker threads use their own FS instances but share the global cache.
+   * So, we can only go concurrent if the latter allows for it. */
+  if (jobs > 1 && !svn_cache_config_get()->single_threaded)
+    return svn_error_trace(build_rep_cache_concurrently(fs, jobs,
+                                                        start_rev, end_rev,
+                                                        progress_func,
+                                                        progress_baton,
+                                                        cancel_func,
+                                                        cancel_baton,
+                                                        pool));
+
   iterpool = svn_pool_create(pool);
   for (rev = start_rev; rev <= end_rev; rev++)
     {
-      svn_fs_id_t *root_id;
-      svn_fs_fs__revision_file_t *file;
-      svn_error_t *err;
+      apr_array_header_t *reps;
 
       svn_pool_clear(iterpool);
 
       if (progress_func)
         progress_func(rev, progress_baton, iterpool);
 
-      SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&file, fs, rev,
-                                               iterpool, iterpool));
-      SVN_ERR(svn_fs_fs__rev_get_root(&root_id, fs, rev, iterpool, iterpool));
-
-      SVN_ERR(svn_sqlite__begin_transaction(ffd->rep_cache_db));
-      err = reindex_node(fs, root_id, rev, file, cancel_func, cancel_baton, iterpool);
-      SVN_ERR(svn_sqlite__finish_transaction(ffd->rep_cache_db, err));
-
-      SVN_ERR(svn_fs_fs__close_revision_file(file));
+      reps = apr_array_make(iterpool, 16, sizeof(representation_t *));
+      SVN_ERR(reindex_revision(reps, fs, rev, cancel_func, cancel_baton,
+                               iterpool, iterpool));
+      SVN_ERR(store_rep_references(fs, reps, iterpool));
     }
 
   svn_pool_destroy(iterpool);
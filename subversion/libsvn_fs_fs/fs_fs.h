@@ -48,6 +48,16 @@ svn_error_t *svn_fs_fs__initialize_shared_data(svn_fs_t *fs,
                                                apr_pool_t *pool,
                                                apr_pool_t *common_pool);
 
+/* Open another, independent instance of the filesystem FS and return it
+   in *INSTANCE_P.  The new instance will use the same configuration as FS
+   and may be used concurrently to FS from a different thread.  Allocate
+   the result in RESULT_POOL and use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_fs_fs__open_instance(svn_fs_t **instance_p,
+                         svn_fs_t *fs,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool);
+
 /* Upgrade the fsfs filesystem FS.  Indicate progress via the optional
  * NOTIFY_FUNC callback using NOTIFY_BATON.  The optional CANCEL_FUNC
  * will periodically be called with CANCEL_BATON to allow for preemption.
@@ -306,12 +316,14 @@ svn_fs_fs__reset_txn_caches(svn_fs_t *fs);
 
 /* Scan all contents of the repository FS and return statistics in *STATS,
  * allocated in RESULT_POOL.  Report progress through PROGRESS_FUNC with
- * PROGRESS_BATON, if PROGRESS_FUNC is not NULL.
+ * PROGRESS_BATON, if PROGRESS_FUNC is not NULL.  Logically addressed
+ * rev / pack files may be scanned using up to JOBS concurrent threads.
  * Use SCRATCH_POOL for temporary allocations.
  */
 svn_error_t *
 svn_fs_fs__get_stats(svn_fs_fs__stats_t **stats,
                      svn_fs_t *fs,
+                     int jobs,
                      svn_fs_progress_notify_func_t progress_func,
                      void *progress_baton,
                      svn_cancel_func_t cancel_func,
@@ -361,6 +373,9 @@ svn_fs_fs__revision_size(apr_off_t *rev_size,
  * SVN_INVALID_REVNUM, start at revision 1; if END_REV is SVN_INVALID_REVNUM,
  * end at the head revision. If the rep-cache does not exist, then create it.
  *
+ * Use up to JOBS threads to read the revisions, if supported.  Values of 1
+ * or less select the sequential scan.
+ *
  * Indicate progress via the optional PROGRESS_FUNC callback using
  * PROGRESS_BATON. The optional CANCEL_FUNC will periodically be called with
  * CANCEL_BATON to allow cancellation. Use POOL for temporary allocations.
@@ -369,6 +384,7 @@ svn_error_t *
 svn_fs_fs__build_rep_cache(svn_fs_t *fs,
                            svn_revnum_t start_rev,
                            svn_revnum_t end_rev,
+                           int jobs,
                            svn_fs_progress_notify_func_t progress_func,
                            void *progress_baton,
                            svn_cancel_func_t cancel_func,
@@ -28,8 +28,11 @@
 #include "util.h"
 #include "recovery.h"
 #include "revprops.h"
+#include "date-index.h"
+#include "path-index.h"
 #include "rep-cache.h"
 
+#include "private/svn_task.h"
 #include "../libsvn_fs/fs-loader.h"
 
 #include "svn_private_config.h"
@@ -279,15 +282,19 @@ hotcopy_copy_shard_file(svn_boolean_t *skipped_p,
 
 /* Copy a packed shard containing revision REV, and which contains
  * MAX_FILES_PER_DIR revisions, from SRC_FS to DST_FS.
- * Update *DST_MIN_UNPACKED_REV in case the shard is new in DST_FS.
  * Do not re-copy data which already exists in DST_FS.
  * Set *SKIPPED_P to FALSE only if at least one part of the shard
  * was copied, do not change the value in *SKIPPED_P otherwise.
  * SKIPPED_P may be NULL if not required.
+ *
+ * This only accesses the file system and read-only members of SRC_FS and
+ * DST_FS, i.e. it may be called for different shards concurrently.  The
+ * shard will not become visible in DST_FS until it has been passed to
+ * hotcopy_finish_packed_shard().
+ *
  * Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
 hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
-                          svn_revnum_t *dst_min_unpacked_rev,
                           svn_fs_t *src_fs,
                           svn_fs_t *dst_fs,
                           svn_revnum_t rev,
@@ -357,15 +364,6 @@ hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
                                               scratch_pool));
     }
 
-  /* If necessary, update the min-unpacked rev file in the hotcopy. */
-  if (*dst_min_unpacked_rev < rev + max_files_per_dir)
-    {
-      *dst_min_unpacked_rev = rev + max_files_per_dir;
-      SVN_ERR(svn_fs_fs__write_min_unpacked_rev(dst_fs,
-                                                *dst_min_unpacked_rev,
-                                                scratch_pool));
-    }
-
   return SVN_NO_ERROR;
 }
 
@@ -532,13 +530,169 @@ remove_folder(const char *path,
   return svn_error_trace(err);
 }
 
+/* Make the packed shard starting at revision REV, which contains
+ * MAX_FILES_PER_DIR revisions and has just been copied to DST_FS by
+ * hotcopy_copy_packed_shard(), visible in DST_FS.  Shards must be
+ * finished in revision order.
+ *
+ * Update *DST_MIN_UNPACKED_REV and, if the shard contains revisions
+ * younger than DST_YOUNGEST, the 'current' file in case the shard is new
+ * in DST_FS.  Remove the revision and revprop files which are now packed,
+ * looking for individual files only if INCREMENTAL is set.  Unless SKIPPED
+ * is set, indicate progress via the optional NOTIFY_FUNC callback using
+ * NOTIFY_BATON.  CANCEL_FUNC and CANCEL_BATON do the usual thing.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+hotcopy_finish_packed_shard(svn_revnum_t *dst_min_unpacked_rev,
+                            svn_fs_t *dst_fs,
+                            svn_revnum_t rev,
+                            int max_files_per_dir,
+                            svn_revnum_t dst_youngest,
+                            svn_boolean_t incremental,
+                            svn_boolean_t skipped,
+                            svn_fs_hotcopy_notify_t notify_func,
+                            void* notify_baton,
+                            svn_cancel_func_t cancel_func,
+                            void* cancel_baton,
+                            apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *dst_ffd = dst_fs->fsap_data;
+  svn_revnum_t pack_end_rev = rev + max_files_per_dir - 1;
+
+  /* If necessary, update the min-unpacked rev file in the hotcopy. */
+  if (*dst_min_unpacked_rev < rev + max_files_per_dir)
+    {
+      *dst_min_unpacked_rev = rev + max_files_per_dir;
+      SVN_ERR(svn_fs_fs__write_min_unpacked_rev(dst_fs,
+                                                *dst_min_unpacked_rev,
+                                                scratch_pool));
+    }
+
+  /* Whenever this pack did not previously exist in the destination,
+   * update 'current' to the most recent packed rev (so readers can see
+   * new revisions which arrived in this pack). */
+  if (pack_end_rev > dst_youngest)
+    {
+      SVN_ERR(svn_fs_fs__write_current(dst_fs, pack_end_rev, 0, 0,
+                                       scratch_pool));
+    }
+
+  /* When notifying about packed shards, make things simpler by either
+   * reporting a full revision range, i.e [pack start, pack end] or
+   * reporting nothing. There is one case when this approach might not
+   * be exact (incremental hotcopy with a pack replacing last unpacked
+   * revisions), but generally this is good enough. */
+  if (notify_func && !skipped)
+    notify_func(notify_baton, rev, pack_end_rev, scratch_pool);
+
+  /* Remove revision files which are now packed. */
+  if (incremental)
+    {
+      SVN_ERR(hotcopy_remove_rev_files(dst_fs, rev,
+                                       rev + max_files_per_dir,
+                                       max_files_per_dir, scratch_pool));
+      if (dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
+        SVN_ERR(hotcopy_remove_revprop_files(dst_fs, rev,
+                                             rev + max_files_per_dir,
+                                             max_files_per_dir,
+                                             scratch_pool));
+    }
+
+  /* Now that all revisions have moved into the pack, the original
+   * rev dir can be removed. */
+  SVN_ERR(remove_folder(svn_fs_fs__path_rev_shard(dst_fs, rev, scratch_pool),
+                        cancel_func, cancel_baton, scratch_pool));
+  if (rev > 0 && dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
+    SVN_ERR(remove_folder(svn_fs_fs__path_revprops_shard(dst_fs, rev,
+                                                         scratch_pool),
+                          cancel_func, cancel_baton, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton type used when copying packed shards concurrently. */
+typedef struct hotcopy_packed_shards_baton_t
+{
+  /* Hotcopy source and destination. */
+  svn_fs_t *src_fs;
+  svn_fs_t *dst_fs;
+
+  /* Youngest revision in DST_FS before the hotcopy started. */
+  svn_revnum_t dst_youngest;
+
+  /* Current value of the min-unpacked-rev file in DST_FS. */
+  svn_revnum_t dst_min_unpacked_rev;
+
+  /* Hotcopy parameters, see hotcopy_revisions(). */
+  svn_boolean_t incremental;
+  svn_fs_hotcopy_notify_t notify_func;
+  void* notify_baton;
+} hotcopy_packed_shards_baton_t;
+
+/* Implements svn_task__process_func_t.
+ * Copy the packed shard with the given INDEX as described by the
+ * hotcopy_packed_shards_baton_t in PROCESS_BATON.  Return whether all of
+ * its files had been skipped as svn_boolean_t in *RESULT. */
+static svn_error_t *
+copy_packed_shard_item(void **result,
+                       int index,
+                       void *process_baton,
+                       void *thread_context,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  hotcopy_packed_shards_baton_t *baton = process_baton;
+  fs_fs_data_t *src_ffd = baton->src_fs->fsap_data;
+  int max_files_per_dir = src_ffd->max_files_per_dir;
+  svn_boolean_t *skipped = apr_palloc(result_pool, sizeof(*skipped));
+
+  if (cancel_func)
+    SVN_ERR(cancel_func(cancel_baton));
+
+  *skipped = TRUE;
+  SVN_ERR(hotcopy_copy_packed_shard(skipped, baton->src_fs, baton->dst_fs,
+                                    (svn_revnum_t)index * max_files_per_dir,
+                                    max_files_per_dir, scratch_pool));
+
+  *result = skipped;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.
+ * Make the packed shard with the given INDEX, just copied by
+ * copy_packed_shard_item(), visible in the hotcopy destination described
+ * by the hotcopy_packed_shards_baton_t in OUTPUT_BATON. */
+static svn_error_t *
+finish_packed_shard_item(void *result,
+                         int index,
+                         void *output_baton,
+                         svn_cancel_func_t cancel_func,
+                         void *cancel_baton,
+                         apr_pool_t *scratch_pool)
+{
+  hotcopy_packed_shards_baton_t *baton = output_baton;
+  fs_fs_data_t *src_ffd = baton->src_fs->fsap_data;
+  int max_files_per_dir = src_ffd->max_files_per_dir;
+
+  return svn_error_trace(hotcopy_finish_packed_shard(
+                           &baton->dst_min_unpacked_rev, baton->dst_fs,
+                           (svn_revnum_t)index * max_files_per_dir,
+                           max_files_per_dir, baton->dst_youngest,
+                           baton->incremental, *(svn_boolean_t *)result,
+                           baton->notify_func, baton->notify_baton,
+                           cancel_func, cancel_baton, scratch_pool));
+}
+
 /* Copy the revision and revprop files (possibly sharded / packed) from
  * SRC_FS to DST_FS.  Do not re-copy data which already exists in DST_FS.
  * When copying packed or unpacked shards, checkpoint the result in DST_FS
  * for every shard by updating the 'current' file if necessary.  Assume
  * the >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT filesystem format without
  * global next-ID counters.  Indicate progress via the optional NOTIFY_FUNC
- * callback using NOTIFY_BATON.  Use POOL for temporary allocations.
+ * callback using NOTIFY_BATON.  Copy packed shards concurrently if so
+ * configured for SRC_FS.  Use POOL for temporary allocations.
  */
 static svn_error_t *
 hotcopy_revisions(svn_fs_t *src_fs,
@@ -557,7 +711,6 @@ hotcopy_revisions(svn_fs_t *src_fs,
                   apr_pool_t *pool)
 {
   fs_fs_data_t *src_ffd = src_fs->fsap_data;
-  fs_fs_data_t *dst_ffd = dst_fs->fsap_data;
   int max_files_per_dir = src_ffd->max_files_per_dir;
   svn_revnum_t src_min_unpacked_rev;
   svn_revnum_t dst_min_unpacked_rev;
@@ -601,63 +754,53 @@ hotcopy_revisions(svn_fs_t *src_fs,
    */
 
   iterpool = svn_pool_create(pool);
-  /* First, copy packed shards. */
-  for (rev = 0; rev < src_min_unpacked_rev; rev += max_files_per_dir)
+  /* First, copy packed shards.  Copying packs does not involve any caches
+   * or other shared state, so we may give each shard its own thread. */
+  rev = 0;
+  if (   src_ffd->hotcopy_jobs > 1
+      && max_files_per_dir > 0
+      && src_min_unpacked_rev / max_files_per_dir > 1
+      && src_min_unpacked_rev / max_files_per_dir <= INT_MAX)
+    {
+      hotcopy_packed_shards_baton_t baton;
+      baton.src_fs = src_fs;
+      baton.dst_fs = dst_fs;
+      baton.dst_youngest = dst_youngest;
+      baton.dst_min_unpacked_rev = dst_min_unpacked_rev;
+      baton.incremental = incremental;
+      baton.notify_func = notify_func;
+      baton.notify_baton = notify_baton;
+
+      SVN_ERR(svn_task__run(src_ffd->hotcopy_jobs,
+                            (int)(src_min_unpacked_rev / max_files_per_dir),
+                            copy_packed_shard_item, &baton,
+                            finish_packed_shard_item, &baton,
+                            NULL, NULL, cancel_func, cancel_baton,
+                            iterpool));
+
+      dst_min_unpacked_rev = baton.dst_min_unpacked_rev;
+      rev = src_min_unpacked_rev;
+    }
+
+  for (; rev < src_min_unpacked_rev; rev += max_files_per_dir)
     {
       svn_boolean_t skipped = TRUE;
-      svn_revnum_t pack_end_rev;
 
       svn_pool_clear(iterpool);
 
       if (cancel_func)
         SVN_ERR(cancel_func(cancel_baton));
 
-      /* Copy the packed shard. */
-      SVN_ERR(hotcopy_copy_packed_shard(&skipped, &dst_min_unpacked_rev,
-                                        src_fs, dst_fs,
+      /* Copy the packed shard and make it visible. */
+      SVN_ERR(hotcopy_copy_packed_shard(&skipped, src_fs, dst_fs,
                                         rev, max_files_per_dir,
                                         iterpool));
-
-      pack_end_rev = rev + max_files_per_dir - 1;
-
-      /* Whenever this pack did not previously exist in the destination,
-       * update 'current' to the most recent packed rev (so readers can see
-       * new revisions which arrived in this pack). */
-      if (pack_end_rev > dst_youngest)
-        {
-          SVN_ERR(svn_fs_fs__write_current(dst_fs, pack_end_rev, 0, 0,
-                                           iterpool));
-        }
-
-      /* When notifying about packed shards, make things simpler by either
-       * reporting a full revision range, i.e [pack start, pack end] or
-       * reporting nothing. There is one case when this approach might not
-       * be exact (incremental hotcopy with a pack replacing last unpacked
-       * revisions), but generally this is good enough. */
-      if (notify_func && !skipped)
-        notify_func(notify_baton, rev, pack_end_rev, iterpool);
-
-      /* Remove revision files which are now packed. */
-      if (incremental)
-        {
-          SVN_ERR(hotcopy_remove_rev_files(dst_fs, rev,
-                                           rev + max_files_per_dir,
-                                           max_files_per_dir, iterpool));
-          if (dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
-            SVN_ERR(hotcopy_remove_revprop_files(dst_fs, rev,
-                                                 rev + max_files_per_dir,
-                                                 max_files_per_dir,
-                                                 iterpool));
-        }
-
-      /* Now that all revisions have moved into the pack, the original
-       * rev dir can be removed. */
-      SVN_ERR(remove_folder(svn_fs_fs__path_rev_shard(dst_fs, rev, iterpool),
-                            cancel_func, cancel_baton, iterpool));
-      if (rev > 0 && dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
-        SVN_ERR(remove_folder(svn_fs_fs__path_revprops_shard(dst_fs, rev,
-                                                             iterpool),
-                              cancel_func, cancel_baton, iterpool));
+      SVN_ERR(hotcopy_finish_packed_shard(&dst_min_unpacked_rev, dst_fs,
+                                          rev, max_files_per_dir,
+                                          dst_youngest, incremental,
+                                          skipped, notify_func, notify_baton,
+                                          cancel_func, cancel_baton,
+                                          iterpool));
     }
 
   if (cancel_func)
@@ -959,6 +1102,17 @@ hotcopy_body(void *baton, apr_pool_t *pool)
                                         PATH_LOCKS_DIR, TRUE,
                                         cancel_func, cancel_baton, pool));
 
+  /* Same for the lock database. */
+  dst_subdir = svn_dirent_join(dst_fs->path, PATH_LOCK_DB, pool);
+  SVN_ERR(svn_io_remove_file2(dst_subdir, TRUE, pool));
+  src_subdir = svn_dirent_join(src_fs->path, PATH_LOCK_DB, pool);
+  SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
+  if (kind == svn_node_file)
+    {
+      SVN_ERR(svn_sqlite__hotcopy(src_subdir, dst_subdir, pool));
+      SVN_ERR(svn_io_set_file_read_write(dst_subdir, FALSE, pool));
+    }
+
   /* Now copy the node-origins cache tree. */
   src_subdir = svn_dirent_join(src_fs->path, PATH_NODE_ORIGINS_DIR, pool);
   SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
@@ -990,6 +1144,32 @@ hotcopy_body(void *baton, apr_pool_t *pool)
         }
     }
 
+  /* Same for the path index. */
+  src_subdir = svn_dirent_join(src_fs->path, PATH_INDEX_DB_NAME, pool);
+  dst_subdir = svn_dirent_join(dst_fs->path, PATH_INDEX_DB_NAME, pool);
+  SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
+  if (kind == svn_node_file)
+    {
+      SVN_ERR(svn_sqlite__hotcopy(src_subdir, dst_subdir, pool));
+      SVN_ERR(svn_io_set_file_read_write(dst_subdir, FALSE, pool));
+      SVN_ERR(svn_fs_fs__del_path_index_entries(dst_fs, src_youngest, pool));
+    }
+
+  /* The date index is a plain file.  Don't keep the one that got created
+     for a new destination, if the source has none. */
+  src_subdir = svn_dirent_join(src_fs->path, PATH_DATE_INDEX, pool);
+  dst_subdir = svn_dirent_join(dst_fs->path, PATH_DATE_INDEX, pool);
+  SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
+  if (kind == svn_node_file)
+    {
+      SVN_ERR(svn_io_copy_file(src_subdir, dst_subdir, TRUE, pool));
+      SVN_ERR(svn_fs_fs__truncate_date_index(dst_fs, src_youngest, pool));
+    }
+  else
+    {
+      SVN_ERR(svn_io_remove_file2(dst_subdir, TRUE, pool));
+    }
+
   /* Copy the txn-current file. */
   if (dst_ffd->format >= SVN_FS_FS__MIN_TXN_CURRENT_FORMAT)
     SVN_ERR(svn_io_dir_file_copy(src_fs->path, dst_fs->path,
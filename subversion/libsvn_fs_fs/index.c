@@ -66,6 +66,14 @@ const apr_uint64_t off_t_max = (sizeof(apr_off_t) == sizeof(apr_int64_t))
 /* We put this string in front of the P2L index header. */
 #define P2L_STREAM_PREFIX "P2L-INDEX\n"
 
+/* We put this string in front of decoded L2P index tables.  It is 16 bytes
+ * long, keeping the 64 bit values that follow it aligned. */
+#define L2P_TABLE_PREFIX "L2P-TABLE-V1\n\0\0\0"
+#define L2P_TABLE_PREFIX_LEN 16
+
+/* Number of 64 bit values in the header of a decoded L2P index table. */
+#define L2P_TABLE_HEADER_VALUES 4
+
 /* Size of the buffer that will fit the index header prefixes. */
 #define STREAM_PREFIX_LEN MAX(sizeof(L2P_STREAM_PREFIX), \
                               sizeof(P2L_STREAM_PREFIX))
@@ -186,6 +194,10 @@ struct svn_fs_fs__packed_number_stream_t
   /* underlying data file containing the packed values */
   apr_file_t *file;
 
+  /* memory mapped contents of FILE or NULL.  If given, we read through
+   * it instead of accessing FILE. */
+  const unsigned char *mapped_data;
+
   /* Offset within FILE at which the stream data starts
    * (i.e. which offset will reported as offset 0 by packed_stream_offset). */
   apr_off_t stream_start;
@@ -250,43 +262,56 @@ SVN__PREVENT_INLINE
 static svn_error_t *
 packed_stream_read(svn_fs_fs__packed_number_stream_t *stream)
 {
-  unsigned char buffer[MAX_NUMBER_PREFETCH];
+  unsigned char file_buffer[MAX_NUMBER_PREFETCH];
+  const unsigned char *buffer = file_buffer;
   apr_size_t bytes_read = 0;
   apr_size_t i;
   value_position_pair_t *target;
   apr_off_t block_start = 0;
   apr_off_t block_left = 0;
-  apr_status_t err;
+  apr_status_t err = APR_SUCCESS;
 
   /* all buffered data will have been read starting here */
   stream->start_offset = stream->next_offset;
 
-  /* packed numbers are usually not aligned to MAX_NUMBER_PREFETCH blocks,
-   * i.e. the last number has been incomplete (and not buffered in stream)
-   * and need to be re-read.  Therefore, always correct the file pointer.
-   */
-  SVN_ERR(svn_io_file_aligned_seek(stream->file, stream->block_size,
-                                   &block_start, stream->next_offset,
-                                   stream->pool));
+  if (stream->mapped_data)
+    {
+      /* Simply decode the data in-place.  There are no block boundaries
+       * to consider. */
+      buffer = stream->mapped_data + stream->next_offset;
+      bytes_read = (apr_size_t)MIN(MAX_NUMBER_PREFETCH,
+                                   stream->stream_end - stream->next_offset);
+    }
+  else
+    {
+      /* packed numbers are usually not aligned to MAX_NUMBER_PREFETCH
+       * blocks, i.e. the last number has been incomplete (and not buffered
+       * in stream) and need to be re-read.  Therefore, always correct the
+       * file pointer.
+       */
+      SVN_ERR(svn_io_file_aligned_seek(stream->file, stream->block_size,
+                                       &block_start, stream->next_offset,
+                                       stream->pool));
 
-  /* prefetch at least one number but, if feasible, don't cross block
-   * boundaries.  This shall prevent jumping back and forth between two
-   * blocks because the extra data was not actually request _now_.
-   */
-  bytes_read = sizeof(buffer);
-  block_left = stream->block_size - (stream->next_offset - block_start);
-  if (block_left >= 10 && block_left < bytes_read)
-    bytes_read = (apr_size_t)block_left;
-
-  /* Don't read beyond the end of the file section that belongs to this
-   * index / stream. */
-  bytes_read = (apr_size_t)MIN(bytes_read,
-                               stream->stream_end - stream->next_offset);
-
-  err = apr_file_read(stream->file, buffer, &bytes_read);
-  if (err && !APR_STATUS_IS_EOF(err))
-    return stream_error_create(stream, err,
-      _("Can't read index file '%s' at offset 0x%s"));
+      /* prefetch at least one number but, if feasible, don't cross block
+       * boundaries.  This shall prevent jumping back and forth between two
+       * blocks because the extra data was not actually request _now_.
+       */
+      bytes_read = sizeof(file_buffer);
+      block_left = stream->block_size - (stream->next_offset - block_start);
+      if (block_left >= 10 && block_left < bytes_read)
+        bytes_read = (apr_size_t)block_left;
+
+      /* Don't read beyond the end of the file section that belongs to this
+       * index / stream. */
+      bytes_read = (apr_size_t)MIN(bytes_read,
+                                   stream->stream_end - stream->next_offset);
+
+      err = apr_file_read(stream->file, file_buffer, &bytes_read);
+      if (err && !APR_STATUS_IS_EOF(err))
+        return stream_error_create(stream, err,
+          _("Can't read index file '%s' at offset 0x%s"));
+    }
 
   /* if the last number is incomplete, trim it from the buffer */
   while (bytes_read > 0 && buffer[bytes_read-1] >= 0x80)
@@ -344,13 +369,14 @@ packed_stream_read(svn_fs_fs__packed_number_stream_t *stream)
 }
 
 /* Create and open a packed number stream reading from offsets START to
- * END in FILE and return it in *STREAM.  Access the file in chunks of
- * BLOCK_SIZE bytes.  Expect the stream to be prefixed by STREAM_PREFIX.
- * Allocate *STREAM in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ * END in REV_FILE and return it in *STREAM.  Access the file in chunks of
+ * BLOCK_SIZE bytes - unless it has been memory mapped.  Expect the stream
+ * to be prefixed by STREAM_PREFIX.  Allocate *STREAM in RESULT_POOL and
+ * use SCRATCH_POOL for temporaries.
  */
 static svn_error_t *
 packed_stream_open(svn_fs_fs__packed_number_stream_t **stream,
-                   apr_file_t *file,
+                   svn_fs_fs__revision_file_t *rev_file,
                    apr_off_t start,
                    apr_off_t end,
                    const char *stream_prefix,
@@ -367,10 +393,8 @@ packed_stream_open(svn_fs_fs__packed_number_stream_t **stream,
   SVN_ERR_ASSERT(len < sizeof(buffer));
 
   /* Read the header prefix and compare it with the expected prefix */
-  SVN_ERR(svn_io_file_aligned_seek(file, block_size, NULL, start,
+  SVN_ERR(svn_fs_fs__rev_file_read(rev_file, buffer, start, len,
                                    scratch_pool));
-  SVN_ERR(svn_io_file_read_full2(file, buffer, len, NULL, NULL,
-                                 scratch_pool));
 
   if (strncmp(buffer, stream_prefix, len))
     return svn_error_createf(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
@@ -382,7 +406,8 @@ packed_stream_open(svn_fs_fs__packed_number_stream_t **stream,
   result = apr_palloc(result_pool, sizeof(*result));
 
   result->pool = result_pool;
-  result->file = file;
+  result->file = rev_file->file;
+  result->mapped_data = (const unsigned char *)rev_file->mapped_data;
   result->stream_start = start + len;
   result->stream_end = end;
 
@@ -946,7 +971,7 @@ auto_open_l2p_index(svn_fs_fs__revision_file_t *rev_file,
 
       SVN_ERR(svn_fs_fs__auto_read_footer(rev_file));
       SVN_ERR(packed_stream_open(&rev_file->l2p_stream,
-                                 rev_file->file,
+                                 rev_file,
                                  rev_file->l2p_offset,
                                  rev_file->p2l_offset,
                                  L2P_STREAM_PREFIX,
@@ -1521,6 +1546,112 @@ l2p_entry_access_func(void **out,
   return l2p_page_get_entry(baton, page, offsets, result_pool);
 }
 
+/*
+ * Decoded L2P index tables
+ *
+ * For packed shards, the L2P index may also be stored in a flat, decoded
+ * form in a separate file.  Being read-only, it can be mapped into memory
+ * and shared by all processes accessing the repository.  All values are
+ * stored as 64 bit little-endian numbers following the L2P_TABLE_PREFIX:
+ *
+ *   first revision, number of revisions N,
+ *   L2P and P2L offsets of the pack file (used to detect stale tables),
+ *   N+1 indexes of the first offset for each revision (plus end marker),
+ *   the item offsets of all revisions, in item index order.
+ */
+
+/* Append VALUE to the decoded L2P index table in TABLE. */
+static void
+l2p_table_append(svn_stringbuf_t *table,
+                 apr_uint64_t value)
+{
+  unsigned char buffer[sizeof(value)];
+  apr_size_t i;
+
+  for (i = 0; i < sizeof(value); ++i, value >>= 8)
+    buffer[i] = (unsigned char)value;
+
+  svn_stringbuf_appendbytes(table, (const char *)buffer, sizeof(buffer));
+}
+
+/* Return the value at INDEX in the decoded L2P index TABLE.  The caller
+ * must have checked INDEX against the table size. */
+static apr_uint64_t
+l2p_table_get(const unsigned char *table,
+              apr_size_t index)
+{
+  const unsigned char *p
+    = table + L2P_TABLE_PREFIX_LEN + index * sizeof(apr_uint64_t);
+  apr_uint64_t value = 0;
+  apr_size_t i;
+
+  for (i = sizeof(value); i > 0; --i)
+    value = (value << 8) | p[i - 1];
+
+  return value;
+}
+
+/* If enabled in FS and the pack file REV_FILE has a valid decoded L2P
+ * index table, look up the offset of (REVISION, ITEM_INDEX) in it and
+ * return it in *OFFSET.  Set *FOUND to TRUE in that case.  Otherwise, set
+ * *FOUND to FALSE and leave it to our caller to use the regular index.
+ */
+static svn_error_t *
+l2p_table_lookup(svn_boolean_t *found,
+                 apr_off_t *offset,
+                 svn_fs_t *fs,
+                 svn_fs_fs__revision_file_t *rev_file,
+                 svn_revnum_t revision,
+                 apr_uint64_t item_index)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const unsigned char *table;
+  apr_size_t size, value_count, rev_index, first_value;
+  apr_uint64_t revision_count, first, last;
+
+  *found = FALSE;
+  if (!ffd->shared_l2p_tables || !rev_file->is_packed)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_fs__rev_file_l2p_table(&table, &size, rev_file, fs));
+  if (table == NULL)
+    return SVN_NO_ERROR;
+
+  /* Ignore tables that don't match the current pack file. */
+  SVN_ERR(svn_fs_fs__auto_read_footer(rev_file));
+  if (   size < L2P_TABLE_PREFIX_LEN
+                + L2P_TABLE_HEADER_VALUES * sizeof(apr_uint64_t)
+      || memcmp(table, L2P_TABLE_PREFIX, L2P_TABLE_PREFIX_LEN)
+      || l2p_table_get(table, 0) != (apr_uint64_t)rev_file->start_revision
+      || l2p_table_get(table, 2) != (apr_uint64_t)rev_file->l2p_offset
+      || l2p_table_get(table, 3) != (apr_uint64_t)rev_file->p2l_offset)
+    return SVN_NO_ERROR;
+
+  /* Locate the item offsets for REVISION.  If the table does not cover
+   * the requested item, let the regular index report the error. */
+  value_count = (size - L2P_TABLE_PREFIX_LEN) / sizeof(apr_uint64_t);
+  revision_count = l2p_table_get(table, 1);
+  rev_index = (apr_size_t)(revision - rev_file->start_revision);
+  if (   revision_count >= value_count
+      || rev_index >= revision_count
+      || L2P_TABLE_HEADER_VALUES + revision_count + 1 > value_count)
+    return SVN_NO_ERROR;
+
+  first = l2p_table_get(table, L2P_TABLE_HEADER_VALUES + rev_index);
+  last = l2p_table_get(table, L2P_TABLE_HEADER_VALUES + rev_index + 1);
+  first_value = (apr_size_t)(L2P_TABLE_HEADER_VALUES + revision_count + 1);
+  if (   first > last
+      || last > value_count - first_value
+      || item_index >= last - first)
+    return SVN_NO_ERROR;
+
+  *offset = (apr_off_t)l2p_table_get(table, first_value
+                                            + (apr_size_t)(first + item_index));
+  *found = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
 /* Using the log-to-phys indexes in FS, find the absolute offset in the
  * rev file for (REVISION, ITEM_INDEX) and return it in *OFFSET.
  * Use SCRATCH_POOL for temporary allocations.
@@ -1541,6 +1672,12 @@ l2p_index_lookup(apr_off_t *offset,
   svn_boolean_t is_cached = FALSE;
   void *dummy = NULL;
 
+  /* Prefer the shared, decoded table over our own index page caches. */
+  SVN_ERR(l2p_table_lookup(&is_cached, offset, fs, rev_file, revision,
+                           item_index));
+  if (is_cached)
+    return SVN_NO_ERROR;
+
   /* read index master data structure and extract the info required to
    * access the l2p index page for (REVISION,ITEM_INDEX)*/
   info_baton.revision = revision;
@@ -1767,6 +1904,89 @@ svn_fs_fs__l2p_get_max_ids(apr_array_header_t **max_ids,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__l2p_table_write(svn_fs_t *fs,
+                           svn_revnum_t revision,
+                           apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_fs_fs__revision_file_t *rev_file;
+  l2p_header_t *header;
+  svn_stringbuf_t *table;
+  apr_uint64_t item_count = 0;
+  apr_size_t i, page, page_count;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, revision,
+                                           scratch_pool, iterpool));
+  SVN_ERR_ASSERT(rev_file->is_packed);
+  SVN_ERR(svn_fs_fs__auto_read_footer(rev_file));
+  SVN_ERR(get_l2p_header(&header, rev_file, fs, revision, scratch_pool,
+                         iterpool));
+
+  page_count = header->page_table_index[header->revision_count];
+  for (page = 0; page < page_count; ++page)
+    item_count += header->page_table[page].entry_count;
+
+  table = svn_stringbuf_create_ensure(L2P_TABLE_PREFIX_LEN
+                                      + (L2P_TABLE_HEADER_VALUES
+                                         + header->revision_count + 1
+                                         + item_count)
+                                        * sizeof(apr_uint64_t),
+                                      scratch_pool);
+  svn_stringbuf_appendbytes(table, L2P_TABLE_PREFIX, L2P_TABLE_PREFIX_LEN);
+
+  l2p_table_append(table, header->first_revision);
+  l2p_table_append(table, header->revision_count);
+  l2p_table_append(table, rev_file->l2p_offset);
+  l2p_table_append(table, rev_file->p2l_offset);
+
+  /* Index of the first item offset for each revision.  Since only the
+   * last page of each revision may be partially filled, the pages of a
+   * revision cover a contiguous range of item indexes. */
+  item_count = 0;
+  for (i = 0; i < header->revision_count; ++i)
+    {
+      l2p_table_append(table, item_count);
+      for (page = header->page_table_index[i];
+           page < header->page_table_index[i + 1];
+           ++page)
+        item_count += header->page_table[page].entry_count;
+    }
+
+  l2p_table_append(table, item_count);
+
+  /* Append the contents of all pages in table order. */
+  for (page = 0; page < page_count; ++page)
+    {
+      l2p_page_t *l2p_page;
+      apr_uint32_t k;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(get_l2p_page(&l2p_page, rev_file, fs, header->first_revision,
+                           &header->page_table[page], iterpool));
+
+      for (k = 0; k < l2p_page->entry_count; ++k)
+        l2p_table_append(table, l2p_page->offsets[k]);
+    }
+
+  svn_pool_destroy(iterpool);
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  /* Readers may access the table at any time, so replace it atomically.
+   * It shall be read-only, just like the pack file. */
+  SVN_ERR(svn_io_write_atomic2(svn_fs_fs__path_rev_packed(fs, revision,
+                                                          PATH_L2P_TABLE,
+                                                          scratch_pool),
+                               table->data, table->len,
+                               svn_fs_fs__path_rev_packed(fs, revision,
+                                                          PATH_PACKED,
+                                                          scratch_pool),
+                               ffd->flush_to_disk, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__item_offset(apr_off_t *absolute_position,
                        svn_fs_t *fs,
@@ -2138,7 +2358,7 @@ auto_open_p2l_index(svn_fs_fs__revision_file_t *rev_file,
 
       SVN_ERR(svn_fs_fs__auto_read_footer(rev_file));
       SVN_ERR(packed_stream_open(&rev_file->p2l_stream,
-                                 rev_file->file,
+                                 rev_file,
                                  rev_file->p2l_offset,
                                  rev_file->footer_offset,
                                  P2L_STREAM_PREFIX,
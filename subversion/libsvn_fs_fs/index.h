@@ -214,6 +214,17 @@ svn_fs_fs__l2p_get_max_ids(apr_array_header_t **max_ids,
                            apr_pool_t *result_pool,
                            apr_pool_t *scratch_pool);
 
+/* Decode the whole log-to-phys index of the packed shard containing
+ * REVISION in FS and write it as a flat table to that shard's
+ * PATH_L2P_TABLE file.  Readers may then map that file and look up item
+ * offsets without decoding and caching index pages themselves.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__l2p_table_write(svn_fs_t *fs,
+                           svn_revnum_t revision,
+                           apr_pool_t *scratch_pool);
+
 /* In *OFFSET, return the last OFFSET in the pack / rev file containing.
  * REV_FILE determines whether to access single rev or pack file data.
  * If that is not available anymore (neither in cache nor on disk), re-open
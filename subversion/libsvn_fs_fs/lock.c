@@ -42,8 +42,13 @@
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_sqlite.h"
 #include "svn_private_config.h"
 
+#include "locks-db.h"
+
+LOCKS_DB_SQL_DECLARE_STATEMENTS(statements);
+
 /* Names of hash keys used to store a lock for writing to disk. */
 #define PATH_KEY "path"
 #define TOKEN_KEY "token"
@@ -331,6 +336,268 @@ read_digest_file(apr_hash_t **children_p,
 }
 
 
+/*** Lock database functions. ***/
+
+/* Forward declarations. */
+static svn_error_t *
+walk_digest_locks(svn_fs_t *fs,
+                  const char *digest_path,
+                  svn_fs_get_locks_callback_t get_locks_func,
+                  void *get_locks_baton,
+                  svn_boolean_t have_write_lock,
+                  apr_pool_t *pool);
+
+static svn_error_t *
+unlock_single(svn_fs_t *fs,
+              svn_lock_t *lock,
+              apr_pool_t *pool);
+
+/* Check if LOCK has been already expired. */
+static svn_boolean_t lock_expired(const svn_lock_t *lock)
+{
+  return lock->expiration_date && (apr_time_now() > lock->expiration_date);
+}
+
+/* Store LOCK in the open lock database SDB, replacing any existing lock
+   on the same path. */
+static svn_error_t *
+db_set_lock(svn_sqlite__db_t *sdb,
+            const svn_lock_t *lock)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SET_LOCK));
+  SVN_ERR(svn_sqlite__bindf(stmt, "ssssdLL",
+                            lock->path, lock->token, lock->owner,
+                            lock->comment, lock->is_dav_comment,
+                            (apr_int64_t)lock->creation_date,
+                            (apr_int64_t)lock->expiration_date));
+
+  return svn_error_trace(svn_sqlite__insert(NULL, stmt));
+}
+
+/* Remove the lock on PATH from the open lock database SDB. */
+static svn_error_t *
+db_delete_lock(svn_sqlite__db_t *sdb,
+               const char *path)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_DELETE_LOCK));
+  SVN_ERR(svn_sqlite__bindf(stmt, "s", path));
+
+  return svn_error_trace(svn_sqlite__update(NULL, stmt));
+}
+
+/* Return the lock stored in the current row of STMT, allocated in
+   RESULT_POOL. */
+static svn_lock_t *
+db_read_lock(svn_sqlite__stmt_t *stmt,
+             apr_pool_t *result_pool)
+{
+  svn_lock_t *lock = svn_lock_create(result_pool);
+
+  lock->path = svn_sqlite__column_text(stmt, 0, result_pool);
+  lock->token = svn_sqlite__column_text(stmt, 1, result_pool);
+  lock->owner = svn_sqlite__column_text(stmt, 2, result_pool);
+  lock->comment = svn_sqlite__column_text(stmt, 3, result_pool);
+  lock->is_dav_comment = svn_sqlite__column_boolean(stmt, 4);
+  lock->creation_date = svn_sqlite__column_int64(stmt, 5);
+  lock->expiration_date = svn_sqlite__column_int64(stmt, 6);
+
+  return lock;
+}
+
+/* Implements svn_fs_get_locks_callback_t, BATON being the
+   svn_sqlite__db_t to add LOCK to. */
+static svn_error_t *
+import_lock(void *baton,
+            svn_lock_t *lock,
+            apr_pool_t *pool)
+{
+  return svn_error_trace(db_set_lock(baton, lock));
+}
+
+/* Copy all (non-expired) locks from the digest file tree of FS into the
+   open lock database SDB.  Use POOL for temporary allocations. */
+static svn_error_t *
+import_digest_locks(svn_sqlite__db_t *sdb,
+                    svn_fs_t *fs,
+                    apr_pool_t *pool)
+{
+  const char *digest_path;
+
+  SVN_ERR(digest_path_from_path(&digest_path, fs->path, "/", pool));
+  SVN_SQLITE__WITH_TXN(walk_digest_locks(fs, digest_path, import_lock, sdb,
+                                         FALSE, pool),
+                       sdb);
+
+  return SVN_NO_ERROR;
+}
+
+/* Create the lock database for FS, move all locks from the digest file
+   tree into it and remove that tree.  The caller must hold the FS write
+   lock.  Use POOL for temporary allocations. */
+static svn_error_t *
+create_lock_db(svn_fs_t *fs,
+               apr_pool_t *pool)
+{
+  const char *db_path = svn_dirent_join(fs->path, PATH_LOCK_DB, pool);
+  const char *tmp_path = apr_pstrcat(pool, db_path, ".tmp", SVN_VA_NULL);
+  svn_sqlite__db_t *sdb;
+
+  /* Populate the database under a temporary name such that readers will
+     never see it incomplete.  A previous attempt may have been
+     interrupted, so start from scratch. */
+  SVN_ERR(svn_io_remove_file2(tmp_path, TRUE, pool));
+  SVN_ERR(svn_sqlite__open(&sdb, tmp_path, svn_sqlite__mode_rwcreate,
+                           statements, 0, NULL, 0, pool, pool));
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__exec_statements(sdb,
+                                                    STMT_CREATE_SCHEMA),
+                        sdb);
+  SVN_SQLITE__ERR_CLOSE(import_digest_locks(sdb, fs, pool), sdb);
+  SVN_ERR(svn_sqlite__close(sdb));
+
+  SVN_ERR(svn_io_copy_perms(svn_fs_fs__path_current(fs, pool), tmp_path,
+                            pool));
+  SVN_ERR(svn_io_file_rename2(tmp_path, db_path, TRUE, pool));
+
+  /* From now on, the digest files are no longer being used.  Readers
+     that are still walking the tree may see some of the locks vanish.
+     This is the same small race that hotcopy accepts when replacing
+     the tree. */
+  return svn_error_trace(svn_io_remove_dir2(svn_dirent_join(fs->path,
+                                                            PATH_LOCKS_DIR,
+                                                            pool),
+                                            TRUE, NULL, NULL, pool));
+}
+
+/* If FS has been configured to keep its locks in a database, make sure
+   that database is open.  HAVE_WRITE_LOCK should be TRUE if the caller
+   holds the FS write lock; a missing database will then be created.
+   Otherwise, FFD->LOCK_DB remains NULL in that case and the digest file
+   tree will be used.  Use POOL for temporary allocations. */
+static svn_error_t *
+open_lock_db(svn_fs_t *fs,
+             svn_boolean_t have_write_lock,
+             apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *db_path;
+  svn_node_kind_t kind;
+
+  if (ffd->lock_db || !ffd->use_lock_db)
+    return SVN_NO_ERROR;
+
+  db_path = svn_dirent_join(fs->path, PATH_LOCK_DB, pool);
+  SVN_ERR(svn_io_check_path(db_path, &kind, pool));
+  if (kind == svn_node_none)
+    {
+      if (!have_write_lock)
+        return SVN_NO_ERROR;
+
+      SVN_ERR(create_lock_db(fs, pool));
+    }
+
+  /* The database will be automatically closed when fs->pool is
+     destroyed. */
+  SVN_ERR(svn_sqlite__open(&ffd->lock_db, db_path,
+                           svn_sqlite__mode_readwrite, statements,
+                           0, NULL, 0, fs->pool, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *LOCK_P to the lock on PATH stored in the open lock database SDB,
+   or to NULL if there is none.  Allocate the result in POOL. */
+static svn_error_t *
+db_get_lock(svn_lock_t **lock_p,
+            svn_sqlite__db_t *sdb,
+            const char *path,
+            apr_pool_t *pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_GET_LOCK));
+  SVN_ERR(svn_sqlite__bindf(stmt, "s", path));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  *lock_p = have_row ? db_read_lock(stmt, pool) : NULL;
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Call GET_LOCKS_FUNC/GET_LOCKS_BATON for all locks in and under PATH
+   as stored in FS's open lock database.  This is a single range scan.
+   HAVE_WRITE_LOCK should be true if the caller (directly or indirectly)
+   has the FS write lock. */
+static svn_error_t *
+db_walk_locks(svn_fs_t *fs,
+              const char *path,
+              svn_fs_get_locks_callback_t get_locks_func,
+              void *get_locks_baton,
+              svn_boolean_t have_write_lock,
+              apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  svn_error_t *err;
+  apr_array_header_t *expired = apr_array_make(pool, 0,
+                                               sizeof(svn_lock_t *));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  if (svn_fspath__is_root(path, strlen(path)))
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->lock_db,
+                                        STMT_GET_ALL_LOCKS));
+    }
+  else
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->lock_db,
+                                        STMT_GET_LOCKS_BELOW));
+      SVN_ERR(svn_sqlite__bindf(stmt, "s", path));
+    }
+
+  err = svn_sqlite__step(&have_row, stmt);
+  while (!err && have_row)
+    {
+      svn_lock_t *lock;
+
+      svn_pool_clear(iterpool);
+      lock = db_read_lock(stmt, iterpool);
+
+      /* Only remove expired locks if we have the write lock.
+         Read operations shouldn't change the filesystem.  We can't
+         modify the database while iterating over STMT, though. */
+      if (lock_expired(lock))
+        {
+          if (have_write_lock)
+            APR_ARRAY_PUSH(expired, svn_lock_t *) = svn_lock_dup(lock, pool);
+        }
+      else
+        {
+          err = get_locks_func(get_locks_baton, lock, iterpool);
+        }
+
+      if (!err)
+        err = svn_sqlite__step(&have_row, stmt);
+    }
+
+  SVN_ERR(svn_error_compose_create(err, svn_sqlite__reset(stmt)));
+
+  for (i = 0; i < expired->nelts; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(unlock_single(fs, APR_ARRAY_IDX(expired, i, svn_lock_t *),
+                            iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 
 /*** Lock helper functions (path here are still FS paths, not on-disk
      schema-supporting paths) ***/
@@ -446,17 +713,6 @@ delete_from_digest(const char *fs_path,
   return SVN_NO_ERROR;
 }
 
-static svn_error_t *
-unlock_single(svn_fs_t *fs,
-              svn_lock_t *lock,
-              apr_pool_t *pool);
-
-/* Check if LOCK has been already expired. */
-static svn_boolean_t lock_expired(const svn_lock_t *lock)
-{
-  return lock->expiration_date && (apr_time_now() > lock->expiration_date);
-}
-
 /* Set *LOCK_P to the lock for PATH in FS.  HAVE_WRITE_LOCK should be
    TRUE if the caller (or one of its callers) has taken out the
    repository-wide write lock, FALSE otherwise.  If MUST_EXIST is
@@ -471,16 +727,25 @@ get_lock(svn_lock_t **lock_p,
          svn_boolean_t must_exist,
          apr_pool_t *pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   svn_lock_t *lock = NULL;
-  const char *digest_path;
-  svn_node_kind_t kind;
-
-  SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
-  SVN_ERR(svn_io_check_path(digest_path, &kind, pool));
 
   *lock_p = NULL;
-  if (kind != svn_node_none)
-    SVN_ERR(read_digest_file(NULL, &lock, fs->path, digest_path, pool));
+  SVN_ERR(open_lock_db(fs, have_write_lock, pool));
+  if (ffd->lock_db)
+    {
+      SVN_ERR(db_get_lock(&lock, ffd->lock_db, path, pool));
+    }
+  else
+    {
+      const char *digest_path;
+      svn_node_kind_t kind;
+
+      SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
+      SVN_ERR(svn_io_check_path(digest_path, &kind, pool));
+      if (kind != svn_node_none)
+        SVN_ERR(read_digest_file(NULL, &lock, fs->path, digest_path, pool));
+    }
 
   if (! lock)
     return must_exist ? SVN_FS__ERR_NO_SUCH_LOCK(fs, path) : SVN_NO_ERROR;
@@ -534,16 +799,16 @@ get_lock_helper(svn_fs_t *fs,
 
 
 /* A function that calls GET_LOCKS_FUNC/GET_LOCKS_BATON for
-   all locks in and under PATH in FS.
+   all locks in and under the path in FS that DIGEST_PATH belongs to.
    HAVE_WRITE_LOCK should be true if the caller (directly or indirectly)
    has the FS write lock. */
 static svn_error_t *
-walk_locks(svn_fs_t *fs,
-           const char *digest_path,
-           svn_fs_get_locks_callback_t get_locks_func,
-           void *get_locks_baton,
-           svn_boolean_t have_write_lock,
-           apr_pool_t *pool)
+walk_digest_locks(svn_fs_t *fs,
+                  const char *digest_path,
+                  svn_fs_get_locks_callback_t get_locks_func,
+                  void *get_locks_baton,
+                  svn_boolean_t have_write_lock,
+                  apr_pool_t *pool)
 {
   apr_hash_index_t *hi;
   apr_hash_t *children;
@@ -595,6 +860,34 @@ walk_locks(svn_fs_t *fs,
 }
 
 
+/* A function that calls GET_LOCKS_FUNC/GET_LOCKS_BATON for
+   all locks in and under PATH in FS.
+   HAVE_WRITE_LOCK should be true if the caller (directly or indirectly)
+   has the FS write lock. */
+static svn_error_t *
+walk_locks(svn_fs_t *fs,
+           const char *path,
+           svn_fs_get_locks_callback_t get_locks_func,
+           void *get_locks_baton,
+           svn_boolean_t have_write_lock,
+           apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *digest_path;
+
+  SVN_ERR(open_lock_db(fs, have_write_lock, pool));
+  if (ffd->lock_db)
+    return svn_error_trace(db_walk_locks(fs, path, get_locks_func,
+                                         get_locks_baton, have_write_lock,
+                                         pool));
+
+  SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
+  return svn_error_trace(walk_digest_locks(fs, digest_path, get_locks_func,
+                                           get_locks_baton, have_write_lock,
+                                           pool));
+}
+
+
 /* Utility function:  verify that a lock can be used.  Interesting
    errors returned from this function:
 
@@ -652,9 +945,7 @@ svn_fs_fs__allow_locked_operation(const char *path,
   if (recurse)
     {
       /* Discover all locks at or below the path. */
-      const char *digest_path;
-      SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
-      SVN_ERR(walk_locks(fs, digest_path, get_locks_callback,
+      SVN_ERR(walk_locks(fs, path, get_locks_callback,
                          fs, have_write_lock, pool));
     }
   else
@@ -823,6 +1114,49 @@ struct lock_info_t {
   svn_error_t *fs_err;
 };
 
+/* Store the locks of all entries in INFOS, an array of struct
+   lock_info_t, that passed the pre-checks in the open lock database SDB.
+   The caller shall run this within an SQLite transaction. */
+static svn_error_t *
+db_set_locks_body(svn_sqlite__db_t *sdb,
+                  apr_array_header_t *infos)
+{
+  int i;
+
+  for (i = 0; i < infos->nelts; ++i)
+    {
+      struct lock_info_t *info = &APR_ARRAY_IDX(infos, i,
+                                                struct lock_info_t);
+      if (! info->fs_err)
+        SVN_ERR(db_set_lock(sdb, info->lock));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Like db_set_locks_body but store all locks in a single, durable
+   transaction.  If that fails, none of them will have been stored and
+   all locks in INFOS will be reset to NULL. */
+static svn_error_t *
+db_set_locks(svn_sqlite__db_t *sdb,
+             apr_array_header_t *infos)
+{
+  svn_error_t *err;
+  int i;
+
+  err = svn_sqlite__begin_transaction(sdb);
+  if (!err)
+    err = svn_sqlite__finish_transaction(sdb,
+                                         db_set_locks_body(sdb, infos));
+  if (!err)
+    return SVN_NO_ERROR;
+
+  for (i = 0; i < infos->nelts; ++i)
+    APR_ARRAY_IDX(infos, i, struct lock_info_t).lock = NULL;
+
+  return svn_error_trace(err);
+}
+
 /* The body of svn_fs_fs__lock(), which see.
 
    BATON is a 'struct lock_baton *' holding the effective arguments.
@@ -838,6 +1172,7 @@ static svn_error_t *
 lock_body(void *baton, apr_pool_t *pool)
 {
   struct lock_baton *lb = baton;
+  fs_fs_data_t *ffd = lb->fs->fsap_data;
   svn_fs_root_t *root;
   svn_revnum_t youngest;
   const char *rev_0_path;
@@ -846,6 +1181,8 @@ lock_body(void *baton, apr_pool_t *pool)
   apr_hash_index_t *hi;
   apr_pool_t *iterpool = svn_pool_create(pool);
 
+  SVN_ERR(open_lock_db(lb->fs, TRUE, pool));
+
   /* Until we implement directory locks someday, we only allow locks
      on files. */
   /* Use fs->vtable->foo instead of svn_fs_foo to avoid circular
@@ -869,8 +1206,8 @@ lock_body(void *baton, apr_pool_t *pool)
                          youngest, iterpool));
 
       /* If no error occurred while pre-checking, schedule the index updates for
-         this path. */
-      if (!info.fs_err)
+         this path.  The lock database does not need them. */
+      if (!info.fs_err && !ffd->lock_db)
         schedule_index_update(index_updates, info.path, iterpool);
 
       APR_ARRAY_PUSH(lb->infos, struct lock_info_t) = info;
@@ -925,12 +1262,18 @@ lock_body(void *baton, apr_pool_t *pool)
           info->lock->creation_date = apr_time_now();
           info->lock->expiration_date = lb->expiration_date;
 
-          info->fs_err = set_lock(lb->fs->path, info->lock, rev_0_path,
-                                  iterpool);
+          if (! ffd->lock_db)
+            info->fs_err = set_lock(lb->fs->path, info->lock, rev_0_path,
+                                    iterpool);
         }
     }
 
   svn_pool_destroy(iterpool);
+
+  /* With the lock database, all locks get written at once. */
+  if (ffd->lock_db)
+    SVN_ERR(db_set_locks(ffd->lock_db, lb->infos));
+
   return SVN_NO_ERROR;
 }
 
@@ -975,6 +1318,48 @@ struct unlock_info_t {
   svn_boolean_t done;
 };
 
+/* Remove the locks of all entries in INFOS, an array of struct
+   unlock_info_t, that passed the pre-checks from the open lock database
+   SDB.  The caller shall run this within an SQLite transaction. */
+static svn_error_t *
+db_delete_locks_body(svn_sqlite__db_t *sdb,
+                     apr_array_header_t *infos)
+{
+  int i;
+
+  for (i = 0; i < infos->nelts; ++i)
+    {
+      struct unlock_info_t *info = &APR_ARRAY_IDX(infos, i,
+                                                  struct unlock_info_t);
+      if (! info->fs_err)
+        SVN_ERR(db_delete_lock(sdb, info->path));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Like db_delete_locks_body but remove all locks in a single, durable
+   transaction.  Mark the respective entries in INFOS as done only if
+   that succeeded. */
+static svn_error_t *
+db_delete_locks(svn_sqlite__db_t *sdb,
+                apr_array_header_t *infos)
+{
+  int i;
+
+  SVN_SQLITE__WITH_TXN(db_delete_locks_body(sdb, infos), sdb);
+
+  for (i = 0; i < infos->nelts; ++i)
+    {
+      struct unlock_info_t *info = &APR_ARRAY_IDX(infos, i,
+                                                  struct unlock_info_t);
+      if (! info->fs_err)
+        info->done = TRUE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* The body of svn_fs_fs__unlock(), which see.
 
    BATON is a 'struct unlock_baton *' holding the effective arguments.
@@ -990,6 +1375,7 @@ static svn_error_t *
 unlock_body(void *baton, apr_pool_t *pool)
 {
   struct unlock_baton *ub = baton;
+  fs_fs_data_t *ffd = ub->fs->fsap_data;
   svn_fs_root_t *root;
   svn_revnum_t youngest;
   const char *rev_0_path;
@@ -998,6 +1384,8 @@ unlock_body(void *baton, apr_pool_t *pool)
   apr_hash_index_t *hi;
   apr_pool_t *iterpool = svn_pool_create(pool);
 
+  SVN_ERR(open_lock_db(ub->fs, TRUE, pool));
+
   SVN_ERR(ub->fs->vtable->youngest_rev(&youngest, ub->fs, pool));
   SVN_ERR(ub->fs->vtable->revision_root(&root, ub->fs, youngest, pool));
 
@@ -1019,13 +1407,20 @@ unlock_body(void *baton, apr_pool_t *pool)
                              iterpool));
 
       /* If no error occurred while pre-checking, schedule the index updates for
-         this path. */
-      if (!info.fs_err)
+         this path.  The lock database does not need them. */
+      if (!info.fs_err && !ffd->lock_db)
         schedule_index_update(indices_updates, info.path, iterpool);
 
       APR_ARRAY_PUSH(ub->infos, struct unlock_info_t) = info;
     }
 
+  /* With the lock database, all locks get removed at once. */
+  if (ffd->lock_db)
+    {
+      svn_pool_destroy(iterpool);
+      return svn_error_trace(db_delete_locks(ffd->lock_db, ub->infos));
+    }
+
   rev_0_path = svn_fs_fs__path_rev_absolute(ub->fs, 0, pool);
 
   /* Unlike the lock_body(), we need to delete locks *before* we start to
@@ -1348,7 +1743,6 @@ svn_fs_fs__get_locks(svn_fs_t *fs,
                      void *get_locks_baton,
                      apr_pool_t *pool)
 {
-  const char *digest_path;
   get_locks_filter_baton_t glfb;
 
   SVN_ERR(svn_fs__check_fs(fs, TRUE));
@@ -1359,9 +1753,7 @@ svn_fs_fs__get_locks(svn_fs_t *fs,
   glfb.get_locks_func = get_locks_func;
   glfb.get_locks_baton = get_locks_baton;
 
-  /* Get the top digest path in our tree of interest, and then walk it. */
-  SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
-  SVN_ERR(walk_locks(fs, digest_path, get_locks_filter_func, &glfb,
-                     FALSE, pool));
+  /* Walk the tree of interest. */
+  SVN_ERR(walk_locks(fs, path, get_locks_filter_func, &glfb, FALSE, pool));
   return SVN_NO_ERROR;
 }
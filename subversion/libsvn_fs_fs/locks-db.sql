@@ -0,0 +1,70 @@
+/* locks-db.sql -- schema of the lock database
+ *   This is intended for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+-- STMT_CREATE_SCHEMA
+/* One row per locked path.  PATH is the canonical fspath of the locked
+   node, e.g. "/trunk/foo.c".  The dates are in APR time format and
+   EXPIRATION_DATE is 0 for locks that never expire. */
+CREATE TABLE locks (
+  path TEXT NOT NULL PRIMARY KEY,
+  token TEXT NOT NULL,
+  owner TEXT NOT NULL,
+  comment TEXT,
+  is_dav_comment INTEGER NOT NULL,
+  creation_date INTEGER NOT NULL,
+  expiration_date INTEGER NOT NULL
+  );
+
+PRAGMA USER_VERSION = 1;
+
+-- STMT_GET_LOCK
+SELECT path, token, owner, comment, is_dav_comment, creation_date,
+       expiration_date
+FROM locks
+WHERE path = ?1
+
+/* All locks at or below ?1, which must not be the root path.  Since '0'
+   is the character following '/', the range covers exactly the paths
+   that start with ?1 || '/'. */
+-- STMT_GET_LOCKS_BELOW
+SELECT path, token, owner, comment, is_dav_comment, creation_date,
+       expiration_date
+FROM locks
+WHERE path = ?1
+   OR (path > ?1 || '/' AND path < ?1 || '0')
+ORDER BY path
+
+-- STMT_GET_ALL_LOCKS
+SELECT path, token, owner, comment, is_dav_comment, creation_date,
+       expiration_date
+FROM locks
+ORDER BY path
+
+-- STMT_SET_LOCK
+INSERT OR REPLACE INTO locks (path, token, owner, comment, is_dav_comment,
+                              creation_date, expiration_date)
+VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7)
+
+-- STMT_DELETE_LOCK
+DELETE FROM locks
+WHERE path = ?1
@@ -62,6 +62,18 @@
 #define REP_PLAIN          "PLAIN"
 #define REP_DELTA          "DELTA"
 
+/* Indexed directory contents start with this keyword, followed by a space,
+ * the number of entries and a newline.  After that, we store one offset
+ * per entry, each one DIR_INDEX_OFFSET_WIDTH hex digits wide, followed by
+ * another newline.  The offsets are relative to the first byte after that
+ * newline, i.e. the start of the entry data.  Each entry is stored as
+ *
+ *   <name> NUL <kind> SP <id> NL
+ *
+ * and all entries are sorted by name. */
+#define DIR_INDEX_KEYWORD  "DIR-INDEX"
+#define DIR_INDEX_OFFSET_WIDTH 8
+
 /* An arbitrary maximum path length, so clients can't run us out of memory
  * by giving us arbitrarily large paths. */
 #define FSFS_MAX_PATH_LEN 4096
@@ -1328,3 +1340,322 @@ svn_fs_fs__write_rep_header(svn_fs_fs__rep_header_t *header,
 
   return svn_error_trace(svn_stream_puts(stream, text));
 }
+
+svn_boolean_t
+svn_fs_fs__is_indexed_dir(const char *data,
+                          apr_size_t len)
+{
+  return len > sizeof(DIR_INDEX_KEYWORD)
+      && memcmp(data, DIR_INDEX_KEYWORD " ", sizeof(DIR_INDEX_KEYWORD)) == 0;
+}
+
+/* Write OFFSET as DIR_INDEX_OFFSET_WIDTH lower-case hex digits to BUFFER
+ * (not NUL-terminated) and return BUFFER. */
+static const char *
+encode_dir_offset(char *buffer,
+                  apr_size_t offset)
+{
+  int i;
+  for (i = DIR_INDEX_OFFSET_WIDTH - 1; i >= 0; --i, offset >>= 4)
+    buffer[i] = "0123456789abcdef"[offset & 0xf];
+
+  return buffer;
+}
+
+svn_error_t *
+svn_fs_fs__write_indexed_dir(svn_stream_t *stream,
+                             apr_array_header_t *entries,
+                             apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_stringbuf_t *offsets
+    = svn_stringbuf_create_ensure(entries->nelts * DIR_INDEX_OFFSET_WIDTH,
+                                  scratch_pool);
+  svn_stringbuf_t *data = svn_stringbuf_create_empty(scratch_pool);
+  apr_size_t len;
+  int i;
+
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      svn_fs_dirent_t *dirent = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *);
+      svn_string_t *id_str;
+      char offset[DIR_INDEX_OFFSET_WIDTH];
+
+      svn_pool_clear(iterpool);
+
+      /* The binary search relies on the entries being sorted. */
+      SVN_ERR_ASSERT(i == 0 || strcmp(APR_ARRAY_IDX(entries, i - 1,
+                                                    svn_fs_dirent_t *)->name,
+                                      dirent->name) < 0);
+
+      /* The offset must fit into the fixed-width index entry. */
+      if ((apr_uint64_t)data->len > APR_UINT32_MAX)
+        return svn_error_create(SVN_ERR_FS_GENERAL, NULL,
+                                _("Directory too large for indexed format"));
+
+      svn_stringbuf_appendbytes(offsets,
+                                encode_dir_offset(offset, data->len),
+                                DIR_INDEX_OFFSET_WIDTH);
+
+      id_str = svn_fs_fs__id_unparse(dirent->id, iterpool);
+      svn_stringbuf_appendbytes(data, dirent->name, strlen(dirent->name) + 1);
+      svn_stringbuf_appendcstr(data, dirent->kind == svn_node_file
+                                     ? SVN_FS_FS__KIND_FILE
+                                     : SVN_FS_FS__KIND_DIR);
+      svn_stringbuf_appendbyte(data, ' ');
+      svn_stringbuf_appendbytes(data, id_str->data, id_str->len);
+      svn_stringbuf_appendbyte(data, '\n');
+    }
+
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_stream_printf(stream, scratch_pool, DIR_INDEX_KEYWORD " %d\n",
+                            entries->nelts));
+  svn_stringbuf_appendbyte(offsets, '\n');
+  len = offsets->len;
+  SVN_ERR(svn_stream_write(stream, offsets->data, &len));
+  len = data->len;
+  SVN_ERR(svn_stream_write(stream, data->data, &len));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the error object to use for corrupt indexed directory contents
+ * of the directory with noderev ID.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+indexed_dir_corrupt(const svn_fs_id_t *id,
+                    apr_pool_t *scratch_pool)
+{
+  return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                           _("Directory representation corrupt in '%s'"),
+                           svn_fs_fs__id_unparse(id, scratch_pool)->data);
+}
+
+/* Parse the header of the indexed directory representation contents given
+ * as LEN bytes in DATA.  Return the number of entries in *COUNT, the start
+ * of the offset table in *TABLE and the entry data as *ENTRIES with length
+ * *ENTRIES_LEN.  ID is only used for error messages. */
+static svn_error_t *
+read_indexed_dir_header(int *count,
+                        const char **table,
+                        const char **entries,
+                        apr_size_t *entries_len,
+                        const char *data,
+                        apr_size_t len,
+                        const svn_fs_id_t *id,
+                        apr_pool_t *scratch_pool)
+{
+  const char *number = data + sizeof(DIR_INDEX_KEYWORD);
+  const char *eol;
+  apr_uint64_t value;
+  apr_size_t table_len;
+
+  if (!svn_fs_fs__is_indexed_dir(data, len))
+    return svn_error_trace(indexed_dir_corrupt(id, scratch_pool));
+
+  eol = memchr(number, '\n', len - sizeof(DIR_INDEX_KEYWORD));
+  if (eol == NULL)
+    return svn_error_trace(indexed_dir_corrupt(id, scratch_pool));
+
+  SVN_ERR(svn_cstring_strtoui64(&value,
+                                apr_pstrmemdup(scratch_pool, number,
+                                               eol - number),
+                                0, APR_INT32_MAX, 10));
+
+  /* The offset table and its terminating newline must fit into DATA. */
+  table_len = (apr_size_t)value * DIR_INDEX_OFFSET_WIDTH;
+  if (table_len / DIR_INDEX_OFFSET_WIDTH != value
+      || table_len >= len - (eol + 1 - data)
+      || eol[1 + table_len] != '\n')
+    return svn_error_trace(indexed_dir_corrupt(id, scratch_pool));
+
+  *count = (int)value;
+  *table = eol + 1;
+  *entries = *table + table_len + 1;
+  *entries_len = len - (*entries - data);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the start of the entry with index IDX in *ENTRY and its name
+ * length in *NAME_LEN.  TABLE, ENTRIES and ENTRIES_LEN are as returned by
+ * read_indexed_dir_header.  ID is only used for error messages. */
+static svn_error_t *
+get_indexed_dir_entry(const char **entry,
+                      apr_size_t *name_len,
+                      const char *table,
+                      const char *entries,
+                      apr_size_t entries_len,
+                      int idx,
+                      const svn_fs_id_t *id,
+                      apr_pool_t *scratch_pool)
+{
+  const char *digits = table + (apr_size_t)idx * DIR_INDEX_OFFSET_WIDTH;
+  const char *name_end;
+  apr_size_t offset = 0;
+  int i;
+
+  for (i = 0; i < DIR_INDEX_OFFSET_WIDTH; ++i)
+    {
+      char c = digits[i];
+      if (c >= '0' && c <= '9')
+        offset = offset * 16 + (c - '0');
+      else if (c >= 'a' && c <= 'f')
+        offset = offset * 16 + (c - 'a' + 10);
+      else
+        return svn_error_trace(indexed_dir_corrupt(id, scratch_pool));
+    }
+
+  if (offset >= entries_len)
+    return svn_error_trace(indexed_dir_corrupt(id, scratch_pool));
+
+  name_end = memchr(entries + offset, '\0', entries_len - offset);
+  if (name_end == NULL)
+    return svn_error_trace(indexed_dir_corrupt(id, scratch_pool));
+
+  *entry = entries + offset;
+  *name_len = name_end - *entry;
+
+  return SVN_NO_ERROR;
+}
+
+/* Parse the entry starting at ENTRY into a new svn_fs_dirent_t and return
+ * it in *DIRENT_P.  There are END - ENTRY bytes of data available and the
+ * name is NAME_LEN bytes long.  Allocate the result in RESULT_POOL.  ID is
+ * only used for error messages. */
+static svn_error_t *
+parse_indexed_dir_entry(svn_fs_dirent_t **dirent_p,
+                        const char *entry,
+                        apr_size_t name_len,
+                        const char *end,
+                        const svn_fs_id_t *id,
+                        apr_pool_t *result_pool)
+{
+  svn_fs_dirent_t *dirent = apr_pcalloc(result_pool, sizeof(*dirent));
+  const char *kind = entry + name_len + 1;
+  const char *id_str;
+  const char *eol = memchr(kind, '\n', end - kind);
+
+  if (eol == NULL)
+    return svn_error_trace(indexed_dir_corrupt(id, result_pool));
+
+  if (   (apr_size_t)(eol - kind) > sizeof(SVN_FS_FS__KIND_FILE)
+      && memcmp(kind, SVN_FS_FS__KIND_FILE " ",
+                sizeof(SVN_FS_FS__KIND_FILE)) == 0)
+    {
+      dirent->kind = svn_node_file;
+      id_str = kind + sizeof(SVN_FS_FS__KIND_FILE);
+    }
+  else if (   (apr_size_t)(eol - kind) > sizeof(SVN_FS_FS__KIND_DIR)
+           && memcmp(kind, SVN_FS_FS__KIND_DIR " ",
+                     sizeof(SVN_FS_FS__KIND_DIR)) == 0)
+    {
+      dirent->kind = svn_node_dir;
+      id_str = kind + sizeof(SVN_FS_FS__KIND_DIR);
+    }
+  else
+    {
+      return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                               _("Directory entry corrupt in '%s'"),
+                               svn_fs_fs__id_unparse(id, result_pool)->data);
+    }
+
+  dirent->name = apr_pstrmemdup(result_pool, entry, name_len);
+  SVN_ERR(svn_fs_fs__id_parse(&dirent->id,
+                              apr_pstrmemdup(result_pool, id_str,
+                                             eol - id_str),
+                              result_pool));
+
+  *dirent_p = dirent;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__read_indexed_dir(apr_array_header_t **entries_p,
+                            const char *data,
+                            apr_size_t len,
+                            const svn_fs_id_t *id,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+  const char *table;
+  const char *entries;
+  apr_size_t entries_len;
+  const char *previous = NULL;
+  apr_array_header_t *result;
+  int count;
+  int i;
+
+  SVN_ERR(read_indexed_dir_header(&count, &table, &entries, &entries_len,
+                                  data, len, id, scratch_pool));
+
+  result = apr_array_make(result_pool, count, sizeof(svn_fs_dirent_t *));
+  for (i = 0; i < count; ++i)
+    {
+      svn_fs_dirent_t *dirent;
+      const char *entry;
+      apr_size_t name_len;
+
+      SVN_ERR(get_indexed_dir_entry(&entry, &name_len, table, entries,
+                                    entries_len, i, id, scratch_pool));
+
+      /* Lookups rely on the entries being strictly sorted. */
+      if (previous && strcmp(previous, entry) >= 0)
+        return svn_error_trace(indexed_dir_corrupt(id, scratch_pool));
+
+      SVN_ERR(parse_indexed_dir_entry(&dirent, entry, name_len,
+                                      entries + entries_len, id,
+                                      result_pool));
+      APR_ARRAY_PUSH(result, svn_fs_dirent_t *) = dirent;
+      previous = entry;
+    }
+
+  *entries_p = result;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__find_indexed_dir_entry(svn_fs_dirent_t **dirent_p,
+                                  const char *data,
+                                  apr_size_t len,
+                                  const char *name,
+                                  const svn_fs_id_t *id,
+                                  apr_pool_t *result_pool)
+{
+  const char *table;
+  const char *entries;
+  apr_size_t entries_len;
+  int lower = 0;
+  int upper;
+
+  SVN_ERR(read_indexed_dir_header(&upper, &table, &entries, &entries_len,
+                                  data, len, id, result_pool));
+
+  /* Binary search for NAME in [LOWER, UPPER). */
+  while (lower < upper)
+    {
+      int middle = lower + (upper - lower) / 2;
+      const char *entry;
+      apr_size_t name_len;
+      int diff;
+
+      SVN_ERR(get_indexed_dir_entry(&entry, &name_len, table, entries,
+                                    entries_len, middle, id, result_pool));
+
+      /* Entry names are NUL-terminated within DATA. */
+      diff = strcmp(entry, name);
+      if (diff == 0)
+        return svn_error_trace(parse_indexed_dir_entry(dirent_p, entry,
+                                                       name_len,
+                                                       entries + entries_len,
+                                                       id, result_pool));
+
+      if (diff < 0)
+        lower = middle + 1;
+      else
+        upper = middle;
+    }
+
+  *dirent_p = NULL;
+  return SVN_NO_ERROR;
+}
@@ -37,6 +37,7 @@
  * - node revision
  * - representation (as in "text:" and "props:" lines)
  * - representation header ("PLAIN" and "DELTA" lines)
+ * - indexed directory contents (since format 9)
  */
 
 /* Given the last "few" bytes (should be at least 40) of revision REV in
@@ -233,3 +234,43 @@ svn_error_t *
 svn_fs_fs__write_rep_header(svn_fs_fs__rep_header_t *header,
                             svn_stream_t *stream,
                             apr_pool_t *scratch_pool);
+
+/* Return TRUE, if the LEN bytes of directory representation contents in
+ * DATA use the indexed directory format (since format 9). */
+svn_boolean_t
+svn_fs_fs__is_indexed_dir(const char *data,
+                          apr_size_t len);
+
+/* Write the directory given as a sorted array of svn_fs_dirent_t * in
+ * ENTRIES to STREAM, using the indexed directory format.
+ * Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__write_indexed_dir(svn_stream_t *stream,
+                             apr_array_header_t *entries,
+                             apr_pool_t *scratch_pool);
+
+/* Parse all entries of the indexed directory representation contents
+ * given as LEN bytes in DATA and return them as a sorted array of
+ * svn_fs_dirent_t * in *ENTRIES_P.  ID is the directory's noderev ID and
+ * only used for nicer error messages.  Allocate the result in RESULT_POOL
+ * and use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_fs_fs__read_indexed_dir(apr_array_header_t **entries_p,
+                            const char *data,
+                            apr_size_t len,
+                            const svn_fs_id_t *id,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
+/* Look up the directory entry NAME in the indexed directory representation
+ * contents given as LEN bytes in DATA.  Return it in *DIRENT_P or set that
+ * to NULL, if no such entry exists.  Only the entries visited by the
+ * binary search will be parsed.  ID is the directory's noderev ID and only
+ * used for nicer error messages.  Allocate the result in RESULT_POOL. */
+svn_error_t *
+svn_fs_fs__find_indexed_dir_entry(svn_fs_dirent_t **dirent_p,
+                                  const char *data,
+                                  apr_size_t len,
+                                  const char *name,
+                                  const svn_fs_id_t *id,
+                                  apr_pool_t *result_pool);
@@ -25,11 +25,14 @@
 #include "svn_pools.h"
 #include "svn_dirent_uri.h"
 #include "svn_sorts.h"
+#include "svn_cache_config.h"
 #include "private/svn_temp_serializer.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_io_private.h"
+#include "private/svn_mutex.h"
+#include "private/svn_task.h"
 
 #include "fs_fs.h"
 #include "pack.h"
@@ -131,6 +134,73 @@ typedef struct reference_t
   svn_fs_fs__id_part_t from;
 } reference_t;
 
+/* Maximum time in microseconds that we sleep between cancellation checks
+ * when throttling the pack I/O.
+ */
+#define MAX_THROTTLE_SLEEP (APR_USEC_PER_SEC / 10)
+
+/* I/O budget shared by all shards being packed in one pack run.
+ */
+typedef struct pack_throttle_t
+{
+  /* maximum number of bytes to copy per second.  0 means "unlimited". */
+  apr_int64_t max_io_rate;
+
+  /* serializes access to the members below.  May be NULL. */
+  svn_mutex__t *mutex;
+
+  /* when the pack run started */
+  apr_time_t start;
+
+  /* number of bytes copied since START */
+  apr_int64_t bytes_copied;
+} pack_throttle_t;
+
+/* Add SIZE to the bytes copied under THROTTLE and return the time at
+ * which the copied data would be within budget in *DUE.
+ */
+static svn_error_t *
+account_io(apr_time_t *due,
+           pack_throttle_t *throttle,
+           apr_off_t size)
+{
+  throttle->bytes_copied += size;
+  *due = throttle->start
+       + (apr_time_t)((double)throttle->bytes_copied * APR_USEC_PER_SEC
+                      / throttle->max_io_rate);
+
+  return SVN_NO_ERROR;
+}
+
+/* Account for SIZE bytes having been copied and wait until THROTTLE's
+ * I/O budget allows for further copying.  THROTTLE may be NULL.
+ * CANCEL_FUNC and CANCEL_BATON are what you think they are.
+ */
+static svn_error_t *
+throttle_io(pack_throttle_t *throttle,
+            apr_off_t size,
+            svn_cancel_func_t cancel_func,
+            void *cancel_baton)
+{
+  apr_time_t due, now;
+
+  if (throttle == NULL || throttle->max_io_rate == 0)
+    return SVN_NO_ERROR;
+
+  SVN_MUTEX__WITH_LOCK(throttle->mutex, account_io(&due, throttle, size));
+
+  /* Sleep in short intervals to remain responsive to cancellation. */
+  for (now = apr_time_now(); now < due; now = apr_time_now())
+    {
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      apr_sleep(MIN(due - now, MAX_THROTTLE_SLEEP));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* This structure keeps track of all the temporary data and status that
  * needs to be kept around during the creation of one pack file.  After
  * each revision range (in case we can't process all revs at once due to
@@ -236,6 +306,9 @@ typedef struct pack_context_t
 
   /* ensure that all filesystem changes are written to disk. */
   svn_boolean_t flush_to_disk;
+
+  /* I/O budget to respect while copying data.  May be NULL. */
+  pack_throttle_t *throttle;
 } pack_context_t;
 
 /* Create and initialize a new pack context for packing shard SHARD_REV in
@@ -243,7 +316,7 @@ typedef struct pack_context_t
  * and return the structure in *CONTEXT.
  *
  * Limit the number of items being copied per iteration to MAX_ITEMS.
- * Set FLUSH_TO_DISK, CANCEL_FUNC and CANCEL_BATON as well.
+ * Set FLUSH_TO_DISK, THROTTLE, CANCEL_FUNC and CANCEL_BATON as well.
  */
 static svn_error_t *
 initialize_pack_context(pack_context_t *context,
@@ -253,6 +326,7 @@ initialize_pack_context(pack_context_t *context,
                         svn_revnum_t shard_rev,
                         int max_items,
                         svn_boolean_t flush_to_disk,
+                        pack_throttle_t *throttle,
                         svn_cancel_func_t cancel_func,
                         void *cancel_baton,
                         apr_pool_t *pool)
@@ -282,6 +356,7 @@ initialize_pack_context(pack_context_t *context,
   context->paths = svn_prefix_tree__create(context->info_pool);
 
   context->flush_to_disk = flush_to_disk;
+  context->throttle = throttle;
 
   /* Create the new directory and pack file. */
   context->shard_dir = shard_dir;
@@ -421,7 +496,8 @@ close_pack_context(pack_context_t *context,
 }
 
 /* Efficiently copy SIZE bytes from SOURCE to DEST.  Invoke the CANCEL_FUNC
- * from CONTEXT at regular intervals.  Use POOL for allocations.
+ * from CONTEXT at regular intervals and respect its I/O budget.
+ * Use POOL for allocations.
  */
 static svn_error_t *
 copy_file_data(pack_context_t *context,
@@ -442,6 +518,8 @@ copy_file_data(pack_context_t *context,
                                      NULL, NULL, pool));
       SVN_ERR(svn_io_file_write_full(dest, buffer, (apr_size_t)size,
                                      NULL, pool));
+      SVN_ERR(throttle_io(context->throttle, size, context->cancel_func,
+                          context->cancel_baton));
     }
   else
     {
@@ -462,6 +540,8 @@ copy_file_data(pack_context_t *context,
                                          NULL, NULL, pool));
           SVN_ERR(svn_io_file_write_full(dest, buffer, to_copy,
                                          NULL, pool));
+          SVN_ERR(throttle_io(context->throttle, to_copy,
+                              context->cancel_func, context->cancel_baton));
 
           size -= to_copy;
         }
@@ -1540,7 +1620,8 @@ append_revision(pack_context_t *context,
  * SHARD_DIR into the PACK_FILE_DIR, using POOL for allocations.  Limit
  * the extra memory consumption to MAX_MEM bytes.  If FLUSH_TO_DISK is
  * non-zero, do not return until the data has actually been written on
- * the disk.  CANCEL_FUNC and CANCEL_BATON are what you think they are.
+ * the disk.  Don't exceed the I/O budget given by THROTTLE, which may be
+ * NULL.  CANCEL_FUNC and CANCEL_BATON are what you think they are.
  */
 static svn_error_t *
 pack_log_addressed(svn_fs_t *fs,
@@ -1549,6 +1630,7 @@ pack_log_addressed(svn_fs_t *fs,
                    svn_revnum_t shard_rev,
                    apr_size_t max_mem,
                    svn_boolean_t flush_to_disk,
+                   pack_throttle_t *throttle,
                    svn_cancel_func_t cancel_func,
                    void *cancel_baton,
                    apr_pool_t *pool)
@@ -1582,7 +1664,8 @@ pack_log_addressed(svn_fs_t *fs,
   /* set up a pack context */
   SVN_ERR(initialize_pack_context(&context, fs, pack_file_dir, shard_dir,
                                   shard_rev, max_items, flush_to_disk,
-                                  cancel_func, cancel_baton, pool));
+                                  throttle, cancel_func, cancel_baton,
+                                  pool));
 
   /* phase 1: determine the size of the revisions to pack */
   SVN_ERR(svn_fs_fs__l2p_get_max_ids(&max_ids, fs, shard_rev,
@@ -1707,7 +1790,8 @@ svn_fs_fs__get_packed_offset(apr_off_t *rev_offset,
  * Pack the revision shard starting at SHARD_REV containing exactly
  * MAX_FILES_PER_DIR revisions from SHARD_PATH into the PACK_FILE_DIR,
  * using POOL for allocations.  If FLUSH_TO_DISK is non-zero, do not
- * return until the data has actually been written on the disk.
+ * return until the data has actually been written on the disk.  Don't
+ * exceed the I/O budget given by THROTTLE, which may be NULL.
  * CANCEL_FUNC and CANCEL_BATON are what you think they are.
  */
 static svn_error_t *
@@ -1716,6 +1800,7 @@ pack_phys_addressed(const char *pack_file_dir,
                     svn_revnum_t start_rev,
                     int max_files_per_dir,
                     svn_boolean_t flush_to_disk,
+                    pack_throttle_t *throttle,
                     svn_cancel_func_t cancel_func,
                     void *cancel_baton,
                     apr_pool_t *pool)
@@ -1752,7 +1837,7 @@ pack_phys_addressed(const char *pack_file_dir,
     {
       svn_stream_t *rev_stream;
       const char *path;
-      apr_off_t offset;
+      apr_off_t offset, end_offset;
       apr_file_t *rev_file;
 
       svn_pool_clear(iterpool);
@@ -1777,6 +1862,11 @@ pack_phys_addressed(const char *pack_file_dir,
                                svn_stream_from_aprfile2(pack_file, TRUE,
                                                         iterpool),
                                cancel_func, cancel_baton, iterpool));
+
+      /* Charge the copied data against our I/O budget. */
+      SVN_ERR(svn_io_file_get_offset(&end_offset, pack_file, iterpool));
+      SVN_ERR(throttle_io(throttle, end_offset - offset,
+                          cancel_func, cancel_baton));
     }
 
   /* Close stream over APR file. */
@@ -1805,6 +1895,7 @@ pack_phys_addressed(const char *pack_file_dir,
  * using POOL for allocations.  Try to limit the amount of temporary
  * memory needed to MAX_MEM bytes.  If FLUSH_TO_DISK is non-zero, do
  * not return until the data has actually been written on the disk.
+ * Don't exceed the I/O budget given by THROTTLE, which may be NULL.
  * CANCEL_FUNC and CANCEL_BATON are what you think they are.
  *
  * If for some reason we detect a partial packing already performed, we
@@ -1820,6 +1911,7 @@ pack_rev_shard(svn_fs_t *fs,
                int max_files_per_dir,
                apr_size_t max_mem,
                svn_boolean_t flush_to_disk,
+               pack_throttle_t *throttle,
                svn_cancel_func_t cancel_func,
                void *cancel_baton,
                apr_pool_t *pool)
@@ -1841,11 +1933,11 @@ pack_rev_shard(svn_fs_t *fs,
   if (svn_fs_fs__use_log_addressing(fs))
     SVN_ERR(pack_log_addressed(fs, pack_file_dir, shard_path,
                                shard_rev, max_mem, flush_to_disk,
-                               cancel_func, cancel_baton, pool));
+                               throttle, cancel_func, cancel_baton, pool));
   else
     SVN_ERR(pack_phys_addressed(pack_file_dir, shard_path, shard_rev,
                                 max_files_per_dir, flush_to_disk,
-                                cancel_func, cancel_baton, pool));
+                                throttle, cancel_func, cancel_baton, pool));
 
   SVN_ERR(svn_io_copy_perms(shard_path, pack_file_dir, pool));
   SVN_ERR(svn_io_set_file_read_only(pack_file_path, FALSE, pool));
@@ -1865,6 +1957,7 @@ struct pack_baton
   svn_cancel_func_t cancel_func;
   void *cancel_baton;
   size_t max_mem;
+  pack_throttle_t *throttle;
 
   /* Additional entries valid when entering pack_shard(). */
   const char *revs_dir;
@@ -1957,6 +2050,57 @@ synced_pack_shard(void *baton,
   return SVN_NO_ERROR;
 }
 
+/* Return the path of the unpacked revision SHARD in REVS_DIR in
+ * *REV_SHARD_PATH and the path of its packed counterpart in
+ * *REV_PACK_FILE_DIR.  Allocate both in POOL.
+ */
+static void
+get_rev_shard_paths(const char **rev_shard_path,
+                    const char **rev_pack_file_dir,
+                    const char *revs_dir,
+                    apr_int64_t shard,
+                    apr_pool_t *pool)
+{
+  *rev_pack_file_dir = svn_dirent_join(revs_dir,
+                  apr_psprintf(pool,
+                               "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
+                               shard),
+                  pool);
+  *rev_shard_path = svn_dirent_join(revs_dir,
+                                    apr_psprintf(pool, "%" APR_INT64_T_FMT,
+                                                 shard),
+                                    pool);
+}
+
+/* Switch the shard described by BATON over to its packed revision data,
+ * which must already have been written.  Use POOL for allocations.
+ */
+static svn_error_t *
+switch_to_packed_shard(struct pack_baton *baton,
+                       apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = baton->fs->fsap_data;
+
+  /* For newer repo formats, we only acquired the pack lock so far.
+     Before modifying the repo state by switching over to the packed
+     data, we need to acquire the global (write) lock. */
+  if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
+    SVN_ERR(svn_fs_fs__with_write_lock(baton->fs, synced_pack_shard, baton,
+                                       pool));
+  else
+    SVN_ERR(synced_pack_shard(baton, pool));
+
+  /* Provide the decoded index for other processes to share.  This reads
+   * the new pack file, so it can only be done after the switch. */
+  if (ffd->shared_l2p_tables && svn_fs_fs__use_log_addressing(baton->fs))
+    SVN_ERR(svn_fs_fs__l2p_table_write(baton->fs,
+                                       (svn_revnum_t)(baton->shard
+                                                 * ffd->max_files_per_dir),
+                                       pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Pack the shard described by BATON.
  *
  * If for some reason we detect a partial packing already performed,
@@ -1975,31 +2119,18 @@ pack_shard(struct pack_baton *baton,
                                svn_fs_pack_notify_start, pool));
 
   /* Some useful paths. */
-  rev_pack_file_dir = svn_dirent_join(baton->revs_dir,
-                  apr_psprintf(pool,
-                               "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
-                               baton->shard),
-                  pool);
-  baton->rev_shard_path = svn_dirent_join(baton->revs_dir,
-                                          apr_psprintf(pool,
-                                                       "%" APR_INT64_T_FMT,
-                                                       baton->shard),
-                                          pool);
+  get_rev_shard_paths(&baton->rev_shard_path, &rev_pack_file_dir,
+                      baton->revs_dir, baton->shard, pool);
 
   /* pack the revision content */
   SVN_ERR(pack_rev_shard(baton->fs, rev_pack_file_dir, baton->rev_shard_path,
                          baton->shard, ffd->max_files_per_dir,
                          baton->max_mem, ffd->flush_to_disk,
+                         baton->throttle,
                          baton->cancel_func, baton->cancel_baton, pool));
 
-  /* For newer repo formats, we only acquired the pack lock so far.
-     Before modifying the repo state by switching over to the packed
-     data, we need to acquire the global (write) lock. */
-  if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
-    SVN_ERR(svn_fs_fs__with_write_lock(baton->fs, synced_pack_shard, baton,
-                                       pool));
-  else
-    SVN_ERR(synced_pack_shard(baton, pool));
+  /* Make the packed data visible. */
+  SVN_ERR(switch_to_packed_shard(baton, pool));
 
   /* Notify caller we're starting to pack this shard. */
   if (baton->notify_func)
@@ -2009,6 +2140,134 @@ pack_shard(struct pack_baton *baton,
   return SVN_NO_ERROR;
 }
 
+/* Baton type used by pack_shards_concurrently() and its callbacks.
+ */
+typedef struct pack_shards_baton_t
+{
+  /* The pack run.  Its SHARD member is only valid within the output
+   * callback. */
+  struct pack_baton *pb;
+
+  /* Shard corresponding to work item index 0. */
+  apr_int64_t first_shard;
+
+  /* Maximum amount of placement memory per worker. */
+  apr_size_t max_mem;
+} pack_shards_baton_t;
+
+/* Implements svn_task__thread_context_constructor_t.
+ * Open a separate instance of the filesystem given by the
+ * pack_shards_baton_t in CONTEXT_BATON, such that each thread can use
+ * its own, non-thread-safe caches. */
+static svn_error_t *
+open_worker_fs(void **thread_context,
+               void *context_baton,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  pack_shards_baton_t *baton = context_baton;
+  svn_fs_t *worker_fs;
+
+  SVN_ERR(svn_fs_fs__open_instance(&worker_fs, baton->pb->fs, result_pool,
+                                   scratch_pool));
+  *thread_context = worker_fs;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.
+ * Write the pack file for the shard with the given INDEX using the
+ * filesystem instance in THREAD_CONTEXT.  The shard will not be switched
+ * over to the packed data, yet. */
+static svn_error_t *
+pack_rev_shard_item(void **result,
+                    int index,
+                    void *process_baton,
+                    void *thread_context,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  pack_shards_baton_t *baton = process_baton;
+  svn_fs_t *fs = thread_context;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_int64_t shard = baton->first_shard + index;
+  const char *rev_shard_path, *rev_pack_file_dir;
+
+  get_rev_shard_paths(&rev_shard_path, &rev_pack_file_dir,
+                      baton->pb->revs_dir, shard, scratch_pool);
+  SVN_ERR(pack_rev_shard(fs, rev_pack_file_dir, rev_shard_path,
+                         shard, ffd->max_files_per_dir,
+                         baton->max_mem, ffd->flush_to_disk,
+                         baton->pb->throttle, cancel_func, cancel_baton,
+                         scratch_pool));
+
+  *result = NULL;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.
+ * Switch the shard with the given INDEX over to the pack file that has
+ * just been written and notify the user.  Since we get called in shard
+ * order, min-unpacked-rev will advance one shard at a time. */
+static svn_error_t *
+switch_shard_item(void *result,
+                  int index,
+                  void *output_baton,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  apr_pool_t *scratch_pool)
+{
+  pack_shards_baton_t *baton = output_baton;
+  struct pack_baton *pb = baton->pb;
+  const char *rev_pack_file_dir;
+
+  pb->shard = baton->first_shard + index;
+  get_rev_shard_paths(&pb->rev_shard_path, &rev_pack_file_dir,
+                      pb->revs_dir, pb->shard, scratch_pool);
+
+  if (pb->notify_func)
+    SVN_ERR(pb->notify_func(pb->notify_baton, pb->shard,
+                            svn_fs_pack_notify_start, scratch_pool));
+
+  SVN_ERR(switch_to_packed_shard(pb, scratch_pool));
+
+  if (pb->notify_func)
+    SVN_ERR(pb->notify_func(pb->notify_baton, pb->shard,
+                            svn_fs_pack_notify_end, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Pack the SHARD_COUNT shards starting at FIRST_SHARD as described by PB,
+ * using up to JOBS worker threads.  The pack files get written
+ * concurrently but the switch-over to them happens in shard order from
+ * within the current thread.  Use POOL for temporary allocations.
+ */
+static svn_error_t *
+pack_shards_concurrently(struct pack_baton *pb,
+                         int jobs,
+                         apr_int64_t first_shard,
+                         int shard_count,
+                         apr_pool_t *pool)
+{
+  pack_shards_baton_t baton;
+  baton.pb = pb;
+  baton.first_shard = first_shard;
+
+  /* Don't let the total memory usage grow with the number of workers. */
+  jobs = MIN(jobs, shard_count);
+  baton.max_mem = pb->max_mem / jobs;
+
+  return svn_error_trace(svn_task__run(jobs, shard_count,
+                                       pack_rev_shard_item, &baton,
+                                       switch_shard_item, &baton,
+                                       open_worker_fs, &baton,
+                                       pb->cancel_func, pb->cancel_baton,
+                                       pool));
+}
+
 /* Read the youngest rev and the first non-packed rev info for FS from disk.
    Set *FULLY_PACKED when there is no completed unpacked shard.
    Use SCRATCH_POOL for temporary allocations.
@@ -2057,7 +2316,7 @@ pack_body(void *baton,
 {
   struct pack_baton *pb = baton;
   fs_fs_data_t *ffd = pb->fs->fsap_data;
-  apr_int64_t completed_shards;
+  apr_int64_t completed_shards, first_shard;
   apr_pool_t *iterpool;
   svn_boolean_t fully_packed;
 
@@ -2080,8 +2339,22 @@ pack_body(void *baton,
     pb->revsprops_dir = svn_dirent_join(pb->fs->path, PATH_REVPROPS_DIR,
                                         pool);
 
+  /* Worker threads use their own FS instances but share the global cache.
+   * So, we can only go concurrent if the latter allows for it. */
+  first_shard = ffd->min_unpacked_rev / ffd->max_files_per_dir;
+  if (   ffd->pack_jobs > 1
+      && completed_shards - first_shard > 1
+      && completed_shards - first_shard <= INT_MAX
+      && !svn_cache_config_get()->single_threaded)
+    {
+      int shard_count = (int)(completed_shards - first_shard);
+      return svn_error_trace(pack_shards_concurrently(pb, ffd->pack_jobs,
+                                                      first_shard,
+                                                      shard_count, pool));
+    }
+
   iterpool = svn_pool_create(pool);
-  for (pb->shard = ffd->min_unpacked_rev / ffd->max_files_per_dir;
+  for (pb->shard = first_shard;
        pb->shard < completed_shards;
        pb->shard++)
     {
@@ -2147,6 +2420,16 @@ svn_fs_fs__pack(svn_fs_t *fs,
   pb.cancel_baton = cancel_baton;
   pb.max_mem = max_mem ? max_mem : DEFAULT_MAX_MEM;
 
+  /* All workers share the same I/O budget. */
+  if (ffd->pack_max_io_rate)
+    {
+      pb.throttle = apr_pcalloc(pool, sizeof(*pb.throttle));
+      pb.throttle->max_io_rate = ffd->pack_max_io_rate;
+      pb.throttle->start = apr_time_now();
+      SVN_ERR(svn_mutex__init(&pb.throttle->mutex, ffd->pack_jobs > 1,
+                              pool));
+    }
+
   if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
     {
       /* Newer repositories provide a pack operation specific lock.
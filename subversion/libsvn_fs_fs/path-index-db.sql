@@ -0,0 +1,216 @@
+/* path-index-db.sql -- schema of the per-path revision index
+ *   This is intended for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+-- STMT_CREATE_SCHEMA
+/* All revisions in which a path or anything below it has been changed.
+   Contains one row per changed path and each of its parent directories,
+   including the root directory. */
+CREATE TABLE path_changes (
+  path TEXT NOT NULL,
+  revision INTEGER NOT NULL,
+  PRIMARY KEY (path, revision)
+  );
+
+/* All revisions in which a path itself has been added, deleted, replaced
+   or moved.  History may cross copies there, so the index can't be used
+   to find the next history location beyond these revisions. */
+CREATE TABLE path_creations (
+  path TEXT NOT NULL,
+  revision INTEGER NOT NULL,
+  PRIMARY KEY (path, revision)
+  );
+
+/* All revisions in which a path itself has been added or replaced, i.e.
+   in which the node found at that path started to live there.  If that
+   node has been copied, COPYFROM_PATH and COPYFROM_REV record the copy
+   source.  Otherwise, they are NULL. */
+CREATE TABLE path_copies (
+  path TEXT NOT NULL,
+  revision INTEGER NOT NULL,
+  copyfrom_path TEXT,
+  copyfrom_rev INTEGER,
+  PRIMARY KEY (path, revision)
+  );
+
+/* The svn:mergeinfo property of PATH as set in REVISION.  Only revisions
+   that change the value, delete it or delete PATH get a row, which is
+   then NULL.  The mergeinfo of PATH in revision N is found in its youngest
+   row up to N.  Copies add rows for all copied paths with mergeinfo. */
+CREATE TABLE path_mergeinfo (
+  path TEXT NOT NULL,
+  revision INTEGER NOT NULL,
+  mergeinfo TEXT,
+  PRIMARY KEY (path, revision)
+  );
+
+/* A single row containing the youngest revision N such that all revisions
+   0 .. N have been indexed.  Copies have only been indexed for revisions
+   COPIES_START .. N and mergeinfo for revisions 0 .. MERGEINFO_YOUNGEST. */
+CREATE TABLE path_index_info (
+  youngest INTEGER NOT NULL,
+  copies_start INTEGER NOT NULL DEFAULT 0,
+  mergeinfo_youngest INTEGER NOT NULL DEFAULT -1
+  );
+
+INSERT INTO path_index_info (youngest) VALUES (-1);
+
+PRAGMA USER_VERSION = 3;
+
+-- STMT_UPGRADE_TO_2
+/* Format 2 introduces the PATH_COPIES table.  It only covers revisions
+   that get indexed after the upgrade. */
+CREATE TABLE path_copies (
+  path TEXT NOT NULL,
+  revision INTEGER NOT NULL,
+  copyfrom_path TEXT,
+  copyfrom_rev INTEGER,
+  PRIMARY KEY (path, revision)
+  );
+
+ALTER TABLE path_index_info
+ADD COLUMN copies_start INTEGER NOT NULL DEFAULT 0;
+
+UPDATE path_index_info
+SET copies_start = youngest + 1;
+
+PRAGMA USER_VERSION = 2;
+
+-- STMT_UPGRADE_TO_3
+/* Format 3 introduces the PATH_MERGEINFO table.  Mergeinfo changes can
+   only be indexed on top of those of all previous revisions, so none are
+   covered until the next 'svnadmin build-path-index'. */
+CREATE TABLE path_mergeinfo (
+  path TEXT NOT NULL,
+  revision INTEGER NOT NULL,
+  mergeinfo TEXT,
+  PRIMARY KEY (path, revision)
+  );
+
+ALTER TABLE path_index_info
+ADD COLUMN mergeinfo_youngest INTEGER NOT NULL DEFAULT -1;
+
+PRAGMA USER_VERSION = 3;
+
+-- STMT_GET_YOUNGEST
+SELECT youngest
+FROM path_index_info
+
+-- STMT_SET_YOUNGEST
+UPDATE path_index_info
+SET youngest = ?1
+
+-- STMT_GET_COPIES_START
+SELECT copies_start
+FROM path_index_info
+
+-- STMT_SET_COPIES_START
+UPDATE path_index_info
+SET copies_start = ?1
+
+-- STMT_GET_MERGEINFO_YOUNGEST
+SELECT mergeinfo_youngest
+FROM path_index_info
+
+-- STMT_SET_MERGEINFO_YOUNGEST
+UPDATE path_index_info
+SET mergeinfo_youngest = ?1
+
+-- STMT_ADD_CHANGE
+INSERT OR IGNORE INTO path_changes (path, revision)
+VALUES (?1, ?2)
+
+-- STMT_ADD_CREATION
+INSERT OR IGNORE INTO path_creations (path, revision)
+VALUES (?1, ?2)
+
+-- STMT_ADD_COPY
+INSERT OR REPLACE INTO path_copies (path, revision, copyfrom_path,
+                                    copyfrom_rev)
+VALUES (?1, ?2, ?3, ?4)
+
+-- STMT_GET_LAST_COPY
+SELECT revision, copyfrom_path, copyfrom_rev
+FROM path_copies
+WHERE path = ?1 AND revision <= ?2
+ORDER BY revision DESC
+LIMIT 1
+
+-- STMT_SET_MERGEINFO
+INSERT OR REPLACE INTO path_mergeinfo (path, revision, mergeinfo)
+VALUES (?1, ?2, ?3)
+
+-- STMT_GET_MERGEINFO
+SELECT mergeinfo
+FROM path_mergeinfo
+WHERE path = ?1 AND revision <= ?2
+ORDER BY revision DESC
+LIMIT 1
+
+-- STMT_GET_DESCENDANT_MERGEINFO
+/* Return the youngest row up to revision ?2 for all paths below ?1.
+   SQLite takes the values of the bare columns from the row that contains
+   the maximum revision. */
+SELECT path, mergeinfo, MAX(revision)
+FROM path_mergeinfo
+WHERE ((?1 = '/' AND path > '/')
+       OR (path > ?1 || '/' AND path < ?1 || '0'))
+  AND revision <= ?2
+GROUP BY path
+ORDER BY path
+
+-- STMT_GET_LAST_CHANGE
+SELECT revision
+FROM path_changes
+WHERE path = ?1 AND revision >= ?2 AND revision <= ?3
+ORDER BY revision DESC
+LIMIT 1
+
+-- STMT_GET_LAST_CREATION
+SELECT revision
+FROM path_creations
+WHERE path = ?1 AND revision >= ?2 AND revision <= ?3
+ORDER BY revision DESC
+LIMIT 1
+
+-- STMT_GET_FIRST_CREATION
+SELECT revision
+FROM path_creations
+WHERE path = ?1 AND revision >= ?2 AND revision <= ?3
+ORDER BY revision ASC
+LIMIT 1
+
+-- STMT_DEL_CHANGES_YOUNGER_THAN_REV
+DELETE FROM path_changes
+WHERE revision > ?1
+
+-- STMT_DEL_CREATIONS_YOUNGER_THAN_REV
+DELETE FROM path_creations
+WHERE revision > ?1
+
+-- STMT_DEL_COPIES_YOUNGER_THAN_REV
+DELETE FROM path_copies
+WHERE revision > ?1
+
+-- STMT_DEL_MERGEINFO_YOUNGER_THAN_REV
+DELETE FROM path_mergeinfo
+WHERE revision > ?1
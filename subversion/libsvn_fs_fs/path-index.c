@@ -0,0 +1,1226 @@
+/* path-index.c --- the per-path revision index for fsfs
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_pools.h"
+#include "svn_dirent_uri.h"
+#include "svn_mergeinfo.h"
+
+#include "svn_private_config.h"
+
+#include "cached_data.h"
+#include "fs_fs.h"
+#include "fs.h"
+#include "path-index.h"
+#include "tree.h"
+
+#include "private/svn_fspath.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_sqlite.h"
+
+#include "path-index-db.h"
+
+PATH_INDEX_DB_SQL_DECLARE_STATEMENTS(statements);
+
+/* Number of revisions to add to the index within a single SQLite
+   transaction. */
+#define REVISIONS_PER_TXN 64
+
+/* Current schema version of the path index database. */
+#define PATH_INDEX_FORMAT 3
+
+
+
+/** Helper functions. **/
+static APR_INLINE const char *
+path_path_index_db(const char *fs_path,
+                   apr_pool_t *result_pool)
+{
+  return svn_dirent_join(fs_path, PATH_INDEX_DB_NAME, result_pool);
+}
+
+/* Implement upgrade_path_index within an SQLite transaction. */
+static svn_error_t *
+upgrade_path_index_body(svn_sqlite__db_t *sdb,
+                        apr_pool_t *scratch_pool)
+{
+  int version;
+
+  /* Some other process may have upgraded the database in the meantime. */
+  SVN_ERR(svn_sqlite__read_schema_version(&version, sdb, scratch_pool));
+  if (version < 2)
+    SVN_ERR(svn_sqlite__exec_statements(sdb, STMT_UPGRADE_TO_2));
+  if (version < 3)
+    SVN_ERR(svn_sqlite__exec_statements(sdb, STMT_UPGRADE_TO_3));
+
+  return SVN_NO_ERROR;
+}
+
+/* Upgrade the path index database SDB to the current format.  Revisions
+   that have already been indexed will not be covered by the new tables
+   until the next 'svnadmin build-path-index'.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+upgrade_path_index(svn_sqlite__db_t *sdb,
+                   apr_pool_t *scratch_pool)
+{
+  SVN_SQLITE__WITH_IMMEDIATE_TXN(upgrade_path_index_body(sdb, scratch_pool),
+                                 sdb);
+
+  return SVN_NO_ERROR;
+}
+
+/* Open the path index database of FS.  If it does not exist, create it
+   if CREATE is set and do nothing otherwise.  Use POOL for temporary
+   allocations. */
+static svn_error_t *
+open_path_index(svn_fs_t *fs,
+                svn_boolean_t create,
+                apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t *sdb;
+  const char *db_path;
+  svn_boolean_t exists;
+  int version;
+
+  if (ffd->path_index_db)
+    return SVN_NO_ERROR;
+
+  db_path = path_path_index_db(fs->path, pool);
+  SVN_ERR(svn_fs_fs__exists_path_index(&exists, fs, pool));
+  if (!exists && !create)
+    return SVN_NO_ERROR;
+
+#ifndef WIN32
+  /* We want to extend the permissions that apply to the repository
+     as a whole when creating a new index and not simply default
+     to umask. */
+  if (!exists)
+    {
+      const char *current = svn_fs_fs__path_current(fs, pool);
+      svn_error_t *err = svn_io_file_create_empty(db_path, pool);
+
+      if (err && !APR_STATUS_IS_EEXIST(err->apr_err))
+        /* A real error. */
+        return svn_error_trace(err);
+      else if (err)
+        /* Some other thread/process created the file. */
+        svn_error_clear(err);
+      else
+        /* We created the file. */
+        SVN_ERR(svn_io_copy_perms(current, db_path, pool));
+    }
+#endif
+
+  /* The database will be automatically closed when fs->pool is
+     destroyed. */
+  SVN_ERR(svn_sqlite__open(&sdb, db_path,
+                           svn_sqlite__mode_rwcreate, statements,
+                           0, NULL, 0,
+                           fs->pool, pool));
+
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__read_schema_version(&version, sdb, pool),
+                        sdb);
+  if (version <= 0)
+    SVN_SQLITE__ERR_CLOSE(svn_sqlite__exec_statements(sdb,
+                                                      STMT_CREATE_SCHEMA),
+                          sdb);
+  else if (version < PATH_INDEX_FORMAT)
+    SVN_SQLITE__ERR_CLOSE(upgrade_path_index(sdb, pool), sdb);
+
+  ffd->path_index_db = sdb;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *YOUNGEST to the youngest revision N in FS's open path index such
+   that all revisions up to N have been indexed. */
+static svn_error_t *
+get_youngest(svn_revnum_t *youngest,
+             svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->path_index_db,
+                                    STMT_GET_YOUNGEST));
+  SVN_ERR(svn_sqlite__step_row(stmt));
+  *youngest = svn_sqlite__column_revnum(stmt, 0);
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Set *COPIES_START to the oldest revision N in FS's open path index such
+   that copies have been indexed for all revisions starting at N. */
+static svn_error_t *
+get_copies_start(svn_revnum_t *copies_start,
+                 svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->path_index_db,
+                                    STMT_GET_COPIES_START));
+  SVN_ERR(svn_sqlite__step_row(stmt));
+  *copies_start = svn_sqlite__column_revnum(stmt, 0);
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Record COPIES_START in FS's open path index as the oldest revision N
+   such that copies have been indexed for all revisions starting at N. */
+static svn_error_t *
+set_copies_start(svn_fs_t *fs,
+                 svn_revnum_t copies_start)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->path_index_db,
+                                    STMT_SET_COPIES_START));
+  SVN_ERR(svn_sqlite__bind_revnum(stmt, 1, copies_start));
+
+  return svn_error_trace(svn_sqlite__step_done(stmt));
+}
+
+/* Set *MERGEINFO_YOUNGEST to the youngest revision N in FS's open path
+   index such that mergeinfo has been indexed for all revisions up to N. */
+static svn_error_t *
+get_mergeinfo_youngest(svn_revnum_t *mergeinfo_youngest,
+                       svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->path_index_db,
+                                    STMT_GET_MERGEINFO_YOUNGEST));
+  SVN_ERR(svn_sqlite__step_row(stmt));
+  *mergeinfo_youngest = svn_sqlite__column_revnum(stmt, 0);
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Record MERGEINFO_YOUNGEST in FS's open path index as the youngest
+   revision N such that mergeinfo has been indexed for all revisions up
+   to N. */
+static svn_error_t *
+set_mergeinfo_youngest(svn_fs_t *fs,
+                       svn_revnum_t mergeinfo_youngest)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->path_index_db,
+                                    STMT_SET_MERGEINFO_YOUNGEST));
+  SVN_ERR(svn_sqlite__bind_revnum(stmt, 1, mergeinfo_youngest));
+
+  return svn_error_trace(svn_sqlite__step_done(stmt));
+}
+
+/* If CHANGE in REVISION added or replaced a node, record that along with
+   its copy source in FS's open path index. */
+static svn_error_t *
+add_copy(svn_fs_t *fs,
+         const change_t *change,
+         svn_revnum_t revision)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const svn_fs_path_change2_t *info = &change->info;
+  svn_sqlite__stmt_t *stmt;
+
+  if (   info->change_kind != svn_fs_path_change_add
+      && info->change_kind != svn_fs_path_change_replace)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->path_index_db,
+                                    STMT_ADD_COPY));
+  SVN_ERR(svn_sqlite__bindf(stmt, "srsr", change->path.data, revision,
+                            info->copyfrom_path,
+                            info->copyfrom_path ? info->copyfrom_rev
+                                                : SVN_INVALID_REVNUM));
+
+  return svn_error_trace(svn_sqlite__step_done(stmt));
+}
+
+/* Add PATH and all its parents to the list of paths changed in REVISION
+   in FS's open path index.  If IS_CREATION is set, also record PATH
+   as having been added, deleted or replaced in REVISION. */
+static svn_error_t *
+add_change(svn_fs_t *fs,
+           const char *path,
+           svn_revnum_t revision,
+           svn_boolean_t is_creation,
+           apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+
+  if (is_creation)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->path_index_db,
+                                        STMT_ADD_CREATION));
+      SVN_ERR(svn_sqlite__bindf(stmt, "sr", path, revision));
+      SVN_ERR(svn_sqlite__step_done(stmt));
+    }
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->path_index_db,
+                                    STMT_ADD_CHANGE));
+  while (TRUE)
+    {
+      int affected_rows;
+
+      SVN_ERR(svn_sqlite__bindf(stmt, "sr", path, revision));
+      SVN_ERR(svn_sqlite__update(&affected_rows, stmt));
+
+      /* If PATH had already been recorded for REVISION, then so have
+         all its parents. */
+      if (affected_rows == 0 || svn_fspath__is_root(path, strlen(path)))
+        break;
+
+      path = svn_fspath__dirname(path, pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Add all changes of REVISION in FS to its open path index.  If
+   COPIES_ONLY is set, only add the copies.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+index_revision(svn_fs_t *fs,
+               svn_revnum_t revision,
+               svn_boolean_t copies_only,
+               apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__changes_context_t *context;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(svn_fs_fs__create_changes_context(&context, fs, revision,
+                                            scratch_pool));
+  while (!context->eol)
+    {
+      apr_array_header_t *changes;
+      int i;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__get_changes(&changes, context, iterpool, iterpool));
+
+      for (i = 0; i < changes->nelts; ++i)
+        {
+          const change_t *change = APR_ARRAY_IDX(changes, i, change_t *);
+
+          SVN_ERR(add_copy(fs, change, revision));
+          if (!copies_only)
+            SVN_ERR(add_change(fs, change->path.data, revision,
+                               change->info.change_kind
+                                 != svn_fs_path_change_modify,
+                               iterpool));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *MERGEINFO to the svn:mergeinfo of PATH in REVISION as recorded in
+   FS's open path index or to NULL if PATH has none.  Allocate the result
+   in RESULT_POOL. */
+static svn_error_t *
+get_mergeinfo(const char **mergeinfo,
+              svn_fs_t *fs,
+              const char *path,
+              svn_revnum_t revision,
+              apr_pool_t *result_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->path_index_db,
+                                    STMT_GET_MERGEINFO));
+  SVN_ERR(svn_sqlite__bindf(stmt, "sr", path, revision));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  *mergeinfo = have_row ? svn_sqlite__column_text(stmt, 0, result_pool)
+                        : NULL;
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Record MERGEINFO, which may be NULL, as the svn:mergeinfo of PATH in
+   REVISION in FS's open path index unless PATH already has that value.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+set_mergeinfo(svn_fs_t *fs,
+              const char *path,
+              svn_revnum_t revision,
+              const char *mergeinfo,
+              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  const char *current;
+
+  SVN_ERR(get_mergeinfo(&current, fs, path, revision, scratch_pool));
+  if (current ? (mergeinfo && strcmp(current, mergeinfo) == 0) : !mergeinfo)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->path_index_db,
+                                    STMT_SET_MERGEINFO));
+  SVN_ERR(svn_sqlite__bindf(stmt, "srs", path, revision, mergeinfo));
+
+  return svn_error_trace(svn_sqlite__step_done(stmt));
+}
+
+/* A path with mergeinfo as found in the path index. */
+typedef struct mergeinfo_entry_t
+{
+  const char *path;
+  const char *mergeinfo;
+} mergeinfo_entry_t;
+
+/* Set *ENTRIES to the mergeinfo_entry_t * for all paths below PATH that
+   have mergeinfo in REVISION according to FS's open path index, ordered
+   by path.  Allocate the result in RESULT_POOL. */
+static svn_error_t *
+get_descendant_mergeinfo(apr_array_header_t **entries,
+                         svn_fs_t *fs,
+                         const char *path,
+                         svn_revnum_t revision,
+                         apr_pool_t *result_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  *entries = apr_array_make(result_pool, 0, sizeof(mergeinfo_entry_t *));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->path_index_db,
+                                    STMT_GET_DESCENDANT_MERGEINFO));
+  SVN_ERR(svn_sqlite__bindf(stmt, "sr", path, revision));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      /* Deletions leave NULL entries behind. */
+      if (!svn_sqlite__column_is_null(stmt, 1))
+        {
+          mergeinfo_entry_t *entry = apr_palloc(result_pool, sizeof(*entry));
+          entry->path = svn_sqlite__column_text(stmt, 0, result_pool);
+          entry->mergeinfo = svn_sqlite__column_text(stmt, 1, result_pool);
+          APR_ARRAY_PUSH(*entries, mergeinfo_entry_t *) = entry;
+        }
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Sort change_t * by path such that parents come before their
+   descendants. */
+static int
+compare_change_paths(const void *a,
+                     const void *b)
+{
+  const change_t *lhs = *(const change_t * const *)a;
+  const change_t *rhs = *(const change_t * const *)b;
+
+  return strcmp(lhs->path.data, rhs->path.data);
+}
+
+/* Record in FS's open path index how CHANGE in REVISION affected the
+   mergeinfo of the paths below and at its path, i.e. drop the mergeinfo
+   of deleted or replaced subtrees and add that of copied ones.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+index_subtree_mergeinfo(svn_fs_t *fs,
+                        const change_t *change,
+                        svn_revnum_t revision,
+                        apr_pool_t *scratch_pool)
+{
+  const svn_fs_path_change2_t *info = &change->info;
+  const char *path = change->path.data;
+  apr_array_header_t *entries;
+  int i;
+
+  if (   info->change_kind == svn_fs_path_change_delete
+      || info->change_kind == svn_fs_path_change_replace)
+    {
+      SVN_ERR(set_mergeinfo(fs, path, revision, NULL, scratch_pool));
+      SVN_ERR(get_descendant_mergeinfo(&entries, fs, path, revision,
+                                       scratch_pool));
+      for (i = 0; i < entries->nelts; ++i)
+        {
+          const mergeinfo_entry_t *entry
+            = APR_ARRAY_IDX(entries, i, mergeinfo_entry_t *);
+          SVN_ERR(set_mergeinfo(fs, entry->path, revision, NULL,
+                                scratch_pool));
+        }
+    }
+
+  /* The copy target itself will be read from the revision. */
+  if (   info->change_kind != svn_fs_path_change_delete
+      && info->copyfrom_path)
+    {
+      SVN_ERR(get_descendant_mergeinfo(&entries, fs, info->copyfrom_path,
+                                       info->copyfrom_rev, scratch_pool));
+      for (i = 0; i < entries->nelts; ++i)
+        {
+          const mergeinfo_entry_t *entry
+            = APR_ARRAY_IDX(entries, i, mergeinfo_entry_t *);
+          const char *relpath
+            = svn_fspath__skip_ancestor(info->copyfrom_path, entry->path);
+
+          SVN_ERR(set_mergeinfo(fs,
+                                svn_fspath__join(path, relpath, scratch_pool),
+                                revision, entry->mergeinfo, scratch_pool));
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the mergeinfo changes of REVISION in FS to its open path index.
+   The index must already cover the mergeinfo of all older revisions.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+index_mergeinfo(svn_fs_t *fs,
+                svn_revnum_t revision,
+                apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__changes_context_t *context;
+  apr_array_header_t *subtrees
+    = apr_array_make(scratch_pool, 0, sizeof(change_t *));
+  apr_array_header_t *nodes
+    = apr_array_make(scratch_pool, 0, sizeof(change_t *));
+  svn_fs_root_t *root;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  /* Changes to whole subtrees must be applied before the changes to
+     individual paths within them. */
+  SVN_ERR(svn_fs_fs__create_changes_context(&context, fs, revision,
+                                            scratch_pool));
+  while (!context->eol)
+    {
+      apr_array_header_t *changes;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__get_changes(&changes, context, scratch_pool,
+                                     iterpool));
+
+      for (i = 0; i < changes->nelts; ++i)
+        {
+          change_t *change = APR_ARRAY_IDX(changes, i, change_t *);
+          svn_fs_path_change_kind_t kind = change->info.change_kind;
+
+          if (   kind == svn_fs_path_change_delete
+              || kind == svn_fs_path_change_replace
+              || change->info.copyfrom_path)
+            APR_ARRAY_PUSH(subtrees, change_t *) = change;
+
+          if (   kind == svn_fs_path_change_add
+              || kind == svn_fs_path_change_replace
+              || (   kind == svn_fs_path_change_modify
+                  && change->info.prop_mod
+                  && change->info.mergeinfo_mod != svn_tristate_false))
+            APR_ARRAY_PUSH(nodes, change_t *) = change;
+        }
+    }
+
+  svn_sort__array(subtrees, compare_change_paths);
+  for (i = 0; i < subtrees->nelts; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(index_subtree_mergeinfo(fs,
+                                      APR_ARRAY_IDX(subtrees, i, change_t *),
+                                      revision, iterpool));
+    }
+
+  SVN_ERR(svn_fs_fs__revision_root(&root, fs, revision, scratch_pool));
+  for (i = 0; i < nodes->nelts; ++i)
+    {
+      const change_t *change = APR_ARRAY_IDX(nodes, i, change_t *);
+      svn_string_t *mergeinfo;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__node_mergeinfo(&mergeinfo, root, change->path.data,
+                                        iterpool, iterpool));
+      SVN_ERR(set_mergeinfo(fs, change->path.data, revision,
+                            mergeinfo ? mergeinfo->data : NULL, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Add up to REVISIONS_PER_TXN revisions following the youngest one
+   covered by the open path index of FS but not beyond HEAD.  Set *DONE
+   if the index has caught up with HEAD.  Return the first newly indexed
+   revision in *FIRST and the last one in *LAST.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+index_next_revisions(svn_boolean_t *done,
+                     svn_revnum_t *first,
+                     svn_revnum_t *last,
+                     svn_fs_t *fs,
+                     svn_revnum_t head,
+                     apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_revnum_t youngest, mergeinfo_youngest;
+  svn_boolean_t with_mergeinfo;
+  svn_revnum_t rev;
+  apr_pool_t *iterpool;
+
+  SVN_ERR(get_youngest(&youngest, fs));
+  SVN_ERR(get_mergeinfo_youngest(&mergeinfo_youngest, fs));
+
+  *first = youngest + 1;
+  *last = MIN(head, youngest + REVISIONS_PER_TXN);
+  *done = *last >= head;
+
+  /* Mergeinfo changes can only be indexed in sequence.  If older ones are
+     missing, 'svnadmin build-path-index' will add them later. */
+  with_mergeinfo = (mergeinfo_youngest == youngest);
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (rev = *first; rev <= *last; ++rev)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(index_revision(fs, rev, FALSE, iterpool));
+      if (with_mergeinfo)
+        SVN_ERR(index_mergeinfo(fs, rev, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  if (*first <= *last)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->path_index_db,
+                                        STMT_SET_YOUNGEST));
+      SVN_ERR(svn_sqlite__bind_revnum(stmt, 1, *last));
+      SVN_ERR(svn_sqlite__step_done(stmt));
+
+      if (with_mergeinfo)
+        SVN_ERR(set_mergeinfo_youngest(fs, *last));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Add all revisions up to HEAD to the open path index of FS. */
+static svn_error_t *
+catch_up(svn_fs_t *fs,
+         svn_fs_progress_notify_func_t progress_func,
+         void *progress_baton,
+         svn_cancel_func_t cancel_func,
+         void *cancel_baton,
+         apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_revnum_t head;
+  svn_boolean_t done = FALSE;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  SVN_ERR(svn_fs_fs__youngest_rev(&head, fs, pool));
+
+  /* Concurrent commits may try to catch up at the same time.  Reading
+     and advancing the youngest indexed revision within an immediate
+     transaction makes sure that each revision gets indexed once. */
+  while (!done)
+    {
+      svn_revnum_t first, last;
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_SQLITE__WITH_IMMEDIATE_TXN(
+        index_next_revisions(&done, &first, &last, fs, head, iterpool),
+        ffd->path_index_db);
+
+      if (progress_func)
+        for (; first <= last; ++first)
+          progress_func(first, progress_baton, iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Add the copies of up to REVISIONS_PER_TXN revisions preceding the
+   oldest one for which copies are covered by the open path index of FS.
+   Set *DONE if copies are now covered for all revisions.  Return the
+   first and last newly indexed revisions in *FIRST and *LAST.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+index_prev_copies(svn_boolean_t *done,
+                  svn_revnum_t *first,
+                  svn_revnum_t *last,
+                  svn_fs_t *fs,
+                  apr_pool_t *scratch_pool)
+{
+  svn_revnum_t copies_start;
+  svn_revnum_t rev;
+  apr_pool_t *iterpool;
+
+  SVN_ERR(get_copies_start(&copies_start, fs));
+
+  *first = MAX(0, copies_start - REVISIONS_PER_TXN);
+  *last = copies_start - 1;
+  *done = *first == 0;
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (rev = *first; rev <= *last; ++rev)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(index_revision(fs, rev, TRUE, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  if (*first <= *last)
+    SVN_ERR(set_copies_start(fs, *first));
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the copies of all revisions to the open path index of FS that have
+   been indexed before the index recorded copies. */
+static svn_error_t *
+backfill_copies(svn_fs_t *fs,
+                svn_fs_progress_notify_func_t progress_func,
+                void *progress_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_boolean_t done = FALSE;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  while (!done)
+    {
+      svn_revnum_t first, last;
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_SQLITE__WITH_IMMEDIATE_TXN(
+        index_prev_copies(&done, &first, &last, fs, iterpool),
+        ffd->path_index_db);
+
+      if (progress_func)
+        for (; first <= last; ++first)
+          progress_func(first, progress_baton, iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the mergeinfo changes of up to REVISIONS_PER_TXN revisions
+   following the youngest one for which mergeinfo is covered by the open
+   path index of FS but not beyond the youngest indexed revision.  Set
+   *DONE if mergeinfo is now covered for all indexed revisions.  Return
+   the first and last newly indexed revisions in *FIRST and *LAST.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+index_next_mergeinfo(svn_boolean_t *done,
+                     svn_revnum_t *first,
+                     svn_revnum_t *last,
+                     svn_fs_t *fs,
+                     apr_pool_t *scratch_pool)
+{
+  svn_revnum_t youngest, mergeinfo_youngest;
+  svn_revnum_t rev;
+  apr_pool_t *iterpool;
+
+  SVN_ERR(get_youngest(&youngest, fs));
+  SVN_ERR(get_mergeinfo_youngest(&mergeinfo_youngest, fs));
+
+  *first = mergeinfo_youngest + 1;
+  *last = MIN(youngest, mergeinfo_youngest + REVISIONS_PER_TXN);
+  *done = *last >= youngest;
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (rev = *first; rev <= *last; ++rev)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(index_mergeinfo(fs, rev, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  if (*first <= *last)
+    SVN_ERR(set_mergeinfo_youngest(fs, *last));
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the mergeinfo changes of all revisions to the open path index of FS
+   that have been indexed before the index recorded mergeinfo. */
+static svn_error_t *
+backfill_mergeinfo(svn_fs_t *fs,
+                   svn_fs_progress_notify_func_t progress_func,
+                   void *progress_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_boolean_t done = FALSE;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  while (!done)
+    {
+      svn_revnum_t first, last;
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_SQLITE__WITH_IMMEDIATE_TXN(
+        index_next_mergeinfo(&done, &first, &last, fs, iterpool),
+        ffd->path_index_db);
+
+      if (progress_func)
+        for (; first <= last; ++first)
+          progress_func(first, progress_baton, iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+
+/** Library-private API's. **/
+
+svn_error_t *
+svn_fs_fs__exists_path_index(svn_boolean_t *exists,
+                             svn_fs_t *fs,
+                             apr_pool_t *pool)
+{
+  svn_node_kind_t kind;
+
+  SVN_ERR(svn_io_check_path(path_path_index_db(fs->path, pool),
+                            &kind, pool));
+
+  *exists = (kind != svn_node_none);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__close_path_index(svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (ffd->path_index_db)
+    {
+      SVN_ERR(svn_sqlite__close(ffd->path_index_db));
+      ffd->path_index_db = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__build_path_index(svn_fs_t *fs,
+                            svn_fs_progress_notify_func_t progress_func,
+                            void *progress_baton,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *pool)
+{
+  SVN_ERR(open_path_index(fs, TRUE, pool));
+  SVN_ERR(backfill_copies(fs, progress_func, progress_baton,
+                          cancel_func, cancel_baton, pool));
+  SVN_ERR(backfill_mergeinfo(fs, progress_func, progress_baton,
+                             cancel_func, cancel_baton, pool));
+  SVN_ERR(catch_up(fs, progress_func, progress_baton,
+                   cancel_func, cancel_baton, pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__update_path_index(svn_fs_t *fs,
+                             apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  SVN_ERR(open_path_index(fs, FALSE, pool));
+  if (ffd->path_index_db)
+    SVN_ERR(catch_up(fs, NULL, NULL, NULL, NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *REVISION to the revision between START and END that statement
+   STMT_IDX finds first for PATH in the open path index of FS.  Set it
+   to SVN_INVALID_REVNUM if there is none. */
+static svn_error_t *
+get_revision(svn_revnum_t *revision,
+                  svn_fs_t *fs,
+                  int stmt_idx,
+                  const char *path,
+                  svn_revnum_t start,
+                  svn_revnum_t end)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->path_index_db, stmt_idx));
+  SVN_ERR(svn_sqlite__bindf(stmt, "srr", path, start, end));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  *revision = have_row ? svn_sqlite__column_revnum(stmt, 0)
+                       : SVN_INVALID_REVNUM;
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+svn_error_t *
+svn_fs_fs__path_index_prev(svn_boolean_t *available,
+                           svn_revnum_t *change_rev,
+                           svn_revnum_t *creation_rev,
+                           svn_fs_t *fs,
+                           const char *path,
+                           svn_revnum_t start,
+                           svn_revnum_t end,
+                           apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_revnum_t youngest;
+  svn_revnum_t created = SVN_INVALID_REVNUM;
+
+  *available = FALSE;
+
+  SVN_ERR(open_path_index(fs, FALSE, pool));
+  if (!ffd->path_index_db)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_youngest(&youngest, fs));
+  if (youngest < end)
+    return SVN_NO_ERROR;
+
+  path = svn_fspath__canonicalize(path, pool);
+  SVN_ERR(get_revision(change_rev, fs, STMT_GET_LAST_CHANGE,
+                       path, start, end));
+
+  /* Any creation of PATH or its parents may make history cross a copy. */
+  while (TRUE)
+    {
+      svn_revnum_t rev;
+      SVN_ERR(get_revision(&rev, fs, STMT_GET_LAST_CREATION,
+                           path, start, end));
+      if (SVN_IS_VALID_REVNUM(rev) && rev > created)
+        created = rev;
+
+      if (svn_fspath__is_root(path, strlen(path)))
+        break;
+
+      path = svn_fspath__dirname(path, pool);
+    }
+
+  *creation_rev = created;
+  *available = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__path_index_deleted_rev(svn_boolean_t *available,
+                                  svn_revnum_t *deleted,
+                                  svn_fs_t *fs,
+                                  const char *path,
+                                  svn_revnum_t start,
+                                  svn_revnum_t end,
+                                  apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_revnum_t youngest;
+  svn_revnum_t found = SVN_INVALID_REVNUM;
+
+  *available = FALSE;
+
+  SVN_ERR(open_path_index(fs, FALSE, pool));
+  if (!ffd->path_index_db)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_youngest(&youngest, fs));
+  if (youngest < end)
+    return SVN_NO_ERROR;
+
+  /* While the node exists at PATH, neither PATH nor any of its parents
+     can be added without being deleted or replaced first.  So, the
+     oldest creation of any of them after START is the deletion. */
+  path = svn_fspath__canonicalize(path, pool);
+  while (TRUE)
+    {
+      svn_revnum_t rev;
+      SVN_ERR(get_revision(&rev, fs, STMT_GET_FIRST_CREATION,
+                           path, start + 1, end));
+      if (SVN_IS_VALID_REVNUM(rev)
+          && (!SVN_IS_VALID_REVNUM(found) || rev < found))
+        found = rev;
+
+      if (svn_fspath__is_root(path, strlen(path)))
+        break;
+
+      path = svn_fspath__dirname(path, pool);
+    }
+
+  *deleted = found;
+  *available = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__path_index_prev_copy(svn_boolean_t *available,
+                                svn_revnum_t *appeared_rev,
+                                const char **copyfrom_path,
+                                svn_revnum_t *copyfrom_rev,
+                                svn_fs_t *fs,
+                                const char *path,
+                                svn_revnum_t revision,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_revnum_t youngest, copies_start;
+  svn_revnum_t found_rev = SVN_INVALID_REVNUM;
+  const char *found_path = NULL;
+  const char *found_copyfrom_path = NULL;
+  svn_revnum_t found_copyfrom_rev = SVN_INVALID_REVNUM;
+  const char *parent_path;
+
+  *available = FALSE;
+
+  SVN_ERR(open_path_index(fs, FALSE, scratch_pool));
+  if (!ffd->path_index_db)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_youngest(&youngest, fs));
+  SVN_ERR(get_copies_start(&copies_start, fs));
+  if (youngest < revision)
+    return SVN_NO_ERROR;
+
+  /* The node at PATH started to live there with the youngest addition of
+     PATH or any of its parents.  If several of them happened in the same
+     revision, the deepest one determines the node's origin. */
+  path = svn_fspath__canonicalize(path, scratch_pool);
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->path_index_db,
+                                    STMT_GET_LAST_COPY));
+  parent_path = path;
+  while (TRUE)
+    {
+      svn_boolean_t have_row;
+
+      SVN_ERR(svn_sqlite__bindf(stmt, "sr", parent_path, revision));
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+      if (have_row && svn_sqlite__column_revnum(stmt, 0) > found_rev)
+        {
+          found_rev = svn_sqlite__column_revnum(stmt, 0);
+          found_path = parent_path;
+          found_copyfrom_path = svn_sqlite__column_text(stmt, 1,
+                                                        scratch_pool);
+          found_copyfrom_rev = svn_sqlite__column_revnum(stmt, 2);
+        }
+      SVN_ERR(svn_sqlite__reset(stmt));
+
+      if (svn_fspath__is_root(parent_path, strlen(parent_path)))
+        break;
+
+      parent_path = svn_fspath__dirname(parent_path, scratch_pool);
+    }
+
+  /* Only the root node exists without ever having been added.  For any
+     other path, let the caller figure out what is going on. */
+  if (!SVN_IS_VALID_REVNUM(found_rev))
+    {
+      if (copies_start == 0 && svn_fspath__is_root(path, strlen(path)))
+        {
+          *appeared_rev = 0;
+          *copyfrom_path = NULL;
+          *copyfrom_rev = SVN_INVALID_REVNUM;
+          *available = TRUE;
+        }
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Older copies may not have been indexed. */
+  if (found_rev < copies_start)
+    return SVN_NO_ERROR;
+
+  *appeared_rev = found_rev;
+  if (found_copyfrom_path)
+    {
+      *copyfrom_path
+        = svn_fspath__join(found_copyfrom_path,
+                           svn_fspath__skip_ancestor(found_path, path),
+                           result_pool);
+      *copyfrom_rev = found_copyfrom_rev;
+    }
+  else
+    {
+      *copyfrom_path = NULL;
+      *copyfrom_rev = SVN_INVALID_REVNUM;
+    }
+
+  *available = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__path_index_mergeinfo(svn_boolean_t *available,
+                                svn_fs_t *fs,
+                                const char *path,
+                                svn_revnum_t revision,
+                                svn_fs_mergeinfo_receiver_t receiver,
+                                void *baton,
+                                apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_revnum_t mergeinfo_youngest;
+  apr_array_header_t *entries;
+  apr_pool_t *iterpool;
+  int i;
+
+  *available = FALSE;
+
+  SVN_ERR(open_path_index(fs, FALSE, scratch_pool));
+  if (!ffd->path_index_db)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_mergeinfo_youngest(&mergeinfo_youngest, fs));
+  if (mergeinfo_youngest < revision)
+    return SVN_NO_ERROR;
+
+  /* Finish the query before calling RECEIVER, which may want to use the
+     index itself. */
+  path = svn_fspath__canonicalize(path, scratch_pool);
+  SVN_ERR(get_descendant_mergeinfo(&entries, fs, path, revision,
+                                   scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      const mergeinfo_entry_t *entry
+        = APR_ARRAY_IDX(entries, i, mergeinfo_entry_t *);
+      svn_mergeinfo_t mergeinfo;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      /* Issue #3896: Treat syntactically invalid mergeinfo as if there
+         was none, just as the tree crawl does. */
+      err = svn_mergeinfo_parse(&mergeinfo, entry->mergeinfo, iterpool);
+      if (err && err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
+        {
+          svn_error_clear(err);
+          continue;
+        }
+
+      SVN_ERR(err);
+      SVN_ERR(receiver(entry->path, mergeinfo, baton, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  *available = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_fs_fs__del_path_index_entries within an SQLite
+   transaction. */
+static svn_error_t *
+del_entries(svn_fs_t *fs,
+            svn_revnum_t youngest)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_revnum_t indexed, copies_start, mergeinfo_youngest;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->path_index_db,
+                                    STMT_DEL_CHANGES_YOUNGER_THAN_REV));
+  SVN_ERR(svn_sqlite__bind_revnum(stmt, 1, youngest));
+  SVN_ERR(svn_sqlite__step_done(stmt));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->path_index_db,
+                                    STMT_DEL_CREATIONS_YOUNGER_THAN_REV));
+  SVN_ERR(svn_sqlite__bind_revnum(stmt, 1, youngest));
+  SVN_ERR(svn_sqlite__step_done(stmt));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->path_index_db,
+                                    STMT_DEL_COPIES_YOUNGER_THAN_REV));
+  SVN_ERR(svn_sqlite__bind_revnum(stmt, 1, youngest));
+  SVN_ERR(svn_sqlite__step_done(stmt));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->path_index_db,
+                                    STMT_DEL_MERGEINFO_YOUNGER_THAN_REV));
+  SVN_ERR(svn_sqlite__bind_revnum(stmt, 1, youngest));
+  SVN_ERR(svn_sqlite__step_done(stmt));
+
+  SVN_ERR(get_youngest(&indexed, fs));
+  if (indexed > youngest)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->path_index_db,
+                                        STMT_SET_YOUNGEST));
+      SVN_ERR(svn_sqlite__bind_revnum(stmt, 1, youngest));
+      SVN_ERR(svn_sqlite__step_done(stmt));
+    }
+
+  /* Revisions that get re-indexed will include their copies. */
+  SVN_ERR(get_copies_start(&copies_start, fs));
+  if (copies_start > youngest + 1)
+    SVN_ERR(set_copies_start(fs, youngest + 1));
+
+  SVN_ERR(get_mergeinfo_youngest(&mergeinfo_youngest, fs));
+  if (mergeinfo_youngest > youngest)
+    SVN_ERR(set_mergeinfo_youngest(fs, youngest));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__del_path_index_entries(svn_fs_t *fs,
+                                  svn_revnum_t youngest,
+                                  apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  SVN_ERR(open_path_index(fs, FALSE, pool));
+  if (ffd->path_index_db)
+    SVN_SQLITE__WITH_TXN(del_entries(fs, youngest), ffd->path_index_db);
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,164 @@
+/* path-index.h : interface to the per-path revision index
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS_FS_PATH_INDEX_H
+#define SVN_LIBSVN_FS_FS_PATH_INDEX_H
+
+#include "svn_error.h"
+
+#include "fs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+/* The path index is an optional SQLite database that records for every
+ * path the revisions in which it or any path below it has been changed,
+ * the copies made to it and the changes to its svn:mergeinfo property.
+ * It allows path-restricted log operations to find the next relevant
+ * revision, location segments to be determined without walking the node
+ * history and mergeinfo catalogs to be read without crawling the tree.
+ *
+ * The index gets created by svn_fs_fs__build_path_index().  From then on,
+ * every commit will add its changes to it.  Deleting the database file
+ * disables the feature. */
+#define PATH_INDEX_DB_NAME       "path-index.db"
+
+/* Set *EXISTS to TRUE iff the path index DB file exists in FS.
+   Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__exists_path_index(svn_boolean_t *exists,
+                             svn_fs_t *fs,
+                             apr_pool_t *pool);
+
+/* Close the path index database associated with FS. */
+svn_error_t *
+svn_fs_fs__close_path_index(svn_fs_t *fs);
+
+/* Create the path index database for FS, if it does not exist yet, and
+   add all revisions up to HEAD that are not covered by it, yet.  Report
+   each newly indexed revision through PROGRESS_FUNC with PROGRESS_BATON,
+   if not NULL.  Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__build_path_index(svn_fs_t *fs,
+                            svn_fs_progress_notify_func_t progress_func,
+                            void *progress_baton,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *pool);
+
+/* If FS has a path index, add all revisions up to HEAD to it that are not
+   covered by it, yet.  Otherwise, do nothing.
+   Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__update_path_index(svn_fs_t *fs,
+                             apr_pool_t *pool);
+
+/* Look up PATH in FS's path index for the revision range START to END.
+   Set *CHANGE_REV to the youngest revision in that range that changed
+   PATH or any path below it and *CREATION_REV to the youngest revision in
+   that range that added, deleted, replaced or moved PATH or any of its
+   parents.  Either one is SVN_INVALID_REVNUM if there is no such revision.
+
+   If FS has no path index or it does not cover END, yet, set *AVAILABLE
+   to FALSE and leave the other outputs untouched.  Otherwise, set it to
+   TRUE.  Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__path_index_prev(svn_boolean_t *available,
+                           svn_revnum_t *change_rev,
+                           svn_revnum_t *creation_rev,
+                           svn_fs_t *fs,
+                           const char *path,
+                           svn_revnum_t start,
+                           svn_revnum_t end,
+                           apr_pool_t *pool);
+
+/* Look up in FS's path index the revision in which the node at PATH in
+   revision START has been deleted, i.e. the oldest revision after START
+   up to END that deleted, replaced or moved PATH or any of its parents.
+   Return it in *DELETED or SVN_INVALID_REVNUM if there is none.  The
+   caller must make sure that PATH exists in START.
+
+   If FS has no path index or it does not cover END, yet, set *AVAILABLE
+   to FALSE and leave *DELETED untouched.  Otherwise, set it to TRUE.
+   Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__path_index_deleted_rev(svn_boolean_t *available,
+                                  svn_revnum_t *deleted,
+                                  svn_fs_t *fs,
+                                  const char *path,
+                                  svn_revnum_t start,
+                                  svn_revnum_t end,
+                                  apr_pool_t *pool);
+
+/* Look up in FS's path index where the node at PATH in REVISION started
+   to live at that path, i.e. the youngest revision up to REVISION that
+   added or replaced PATH or any of its parents.  Return that revision in
+   *APPEARED_REV.  If the node has been copied there, set *COPYFROM_PATH
+   to PATH's location within the copy source, allocated in RESULT_POOL,
+   and *COPYFROM_REV to the copy source revision.  Otherwise, set them to
+   NULL and SVN_INVALID_REVNUM, respectively.
+
+   If FS has no path index, it does not cover REVISION or the relevant
+   copies have been made before the index started to record them, set
+   *AVAILABLE to FALSE and leave the other outputs untouched.  Otherwise,
+   set it to TRUE.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__path_index_prev_copy(svn_boolean_t *available,
+                                svn_revnum_t *appeared_rev,
+                                const char **copyfrom_path,
+                                svn_revnum_t *copyfrom_rev,
+                                svn_fs_t *fs,
+                                const char *path,
+                                svn_revnum_t revision,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool);
+
+/* Invoke RECEIVER with BATON for the mergeinfo of each path below PATH
+   in REVISION of FS as recorded in its path index.  Like the tree crawl,
+   skip syntactically invalid mergeinfo and do not report PATH itself.
+
+   If FS has no path index or its mergeinfo does not cover REVISION, yet,
+   set *AVAILABLE to FALSE and do not invoke RECEIVER.  Otherwise, set it
+   to TRUE.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__path_index_mergeinfo(svn_boolean_t *available,
+                                svn_fs_t *fs,
+                                const char *path,
+                                svn_revnum_t revision,
+                                svn_fs_mergeinfo_receiver_t receiver,
+                                void *baton,
+                                apr_pool_t *scratch_pool);
+
+/* Delete from FS's path index all entries for revisions younger than
+   YOUNGEST.  Do nothing if FS has no path index. */
+svn_error_t *
+svn_fs_fs__del_path_index_entries(svn_fs_t *fs,
+                                  svn_revnum_t youngest,
+                                  apr_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_FS_FS_PATH_INDEX_H */
@@ -24,13 +24,17 @@
 
 #include "svn_hash.h"
 #include "svn_pools.h"
+#include "svn_sorts.h"
 #include "private/svn_string_private.h"
 
 #include "index.h"
+#include "date-index.h"
 #include "low_level.h"
+#include "path-index.h"
 #include "rep-cache.h"
 #include "revprops.h"
 #include "util.h"
+#include "verify.h"
 #include "cached_data.h"
 
 #include "../libsvn_fs/fs-loader.h"
@@ -331,6 +335,118 @@ recover_get_root_offset(apr_off_t *root_offset,
   return SVN_NO_ERROR;
 }
 
+/* Check that the revision file of the committed log-addressed revision
+   REV in FS is complete:  Its footer must be readable, the index data must
+   match the footer checksums and the root node as well as the changed
+   paths list must be located before the index data.  This is cheap and
+   does not depend on the size of the revision contents.  Invoke
+   CANCEL_FUNC with CANCEL_BATON at regular intervals.  Use SCRATCH_POOL
+   for temporary allocations. */
+static svn_error_t *
+recover_validate_log_addressed_rev(svn_fs_t *fs,
+                                   svn_revnum_t rev,
+                                   svn_cancel_func_t cancel_func,
+                                   void *cancel_baton,
+                                   apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__revision_file_t *rev_file;
+  apr_array_header_t *max_ids;
+  apr_off_t root_offset;
+  apr_off_t changes_offset;
+
+  SVN_ERR(svn_fs_fs__verify_index_checksums(fs, rev, cancel_func,
+                                            cancel_baton, scratch_pool));
+
+  /* The L2P index must cover REV and point to items within the
+     revision's data section. */
+  SVN_ERR(svn_fs_fs__l2p_get_max_ids(&max_ids, fs, rev, 1, scratch_pool,
+                                     scratch_pool));
+  if (APR_ARRAY_IDX(max_ids, 0, apr_uint64_t)
+        <= SVN_FS_FS__ITEM_INDEX_ROOT_NODE)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                             _("Log-to-phys index of revision %ld does not "
+                               "contain the root node"), rev);
+
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rev, scratch_pool,
+                                           scratch_pool));
+  SVN_ERR(svn_fs_fs__auto_read_footer(rev_file));
+  SVN_ERR(svn_fs_fs__item_offset(&root_offset, fs, rev_file, rev, NULL,
+                                 SVN_FS_FS__ITEM_INDEX_ROOT_NODE,
+                                 scratch_pool));
+  SVN_ERR(svn_fs_fs__item_offset(&changes_offset, fs, rev_file, rev, NULL,
+                                 SVN_FS_FS__ITEM_INDEX_CHANGES,
+                                 scratch_pool));
+
+  if (   root_offset < 0 || root_offset >= rev_file->l2p_offset
+      || changes_offset < 0 || changes_offset >= rev_file->l2p_offset)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                             _("Log-to-phys index of revision %ld points "
+                               "outside of the revision contents"), rev);
+
+  return svn_error_trace(svn_fs_fs__close_revision_file(rev_file));
+}
+
+/* Validate the revisions in FS that are younger than the youngest
+   revision YOUNGEST_REV recorded in 'current', up to and including
+   MAX_REV.  Those are the ones that may have been left incomplete by an
+   unclean shutdown.  Older revisions, including all packed ones, have
+   been completely written before they became visible, so we don't need
+   to scan them.  Invoke CANCEL_FUNC with CANCEL_BATON at regular
+   intervals.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+recover_validate_tail(svn_fs_t *fs,
+                      svn_revnum_t youngest_rev,
+                      svn_revnum_t max_rev,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t rev;
+
+  /* Packed shards are always complete. */
+  SVN_ERR(svn_fs_fs__update_min_unpacked_rev(fs, scratch_pool));
+  for (rev = MAX(youngest_rev + 1, ffd->min_unpacked_rev);
+       rev <= max_rev;
+       ++rev)
+    {
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      if (svn_fs_fs__use_log_addressing(fs))
+        {
+          err = recover_validate_log_addressed_rev(fs, rev, cancel_func,
+                                                   cancel_baton, iterpool);
+        }
+      else
+        {
+          /* Without footers, parsing the trailer is the best we can do. */
+          svn_fs_fs__revision_file_t *rev_file;
+          apr_off_t root_offset;
+
+          err = svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rev, iterpool,
+                                                 iterpool);
+          if (!err)
+            err = svn_error_compose_create(
+                    recover_get_root_offset(&root_offset, rev, rev_file,
+                                            iterpool),
+                    svn_fs_fs__close_revision_file(rev_file));
+        }
+
+      if (err)
+        return svn_error_createf(SVN_ERR_FS_CORRUPT, err,
+                                 _("Revision %ld has an incomplete or "
+                                   "corrupt revs file"), rev);
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 /* Baton used for recover_body below. */
 struct recover_baton {
   svn_fs_t *fs;
@@ -401,6 +517,12 @@ recover_body(void *baton, apr_pool_t *pool)
                              _("Expected current rev to be <= %ld "
                                "but found %ld"), max_rev, youngest_rev);
 
+  /* Only the revisions that were not yet visible before the recovery may
+     have been left in an incomplete state.  Make sure we don't publish
+     any of those. */
+  SVN_ERR(recover_validate_tail(fs, youngest_rev, max_rev, b->cancel_func,
+                                b->cancel_baton, pool));
+
   /* We only need to search for maximum IDs for old FS formats which
      se global ID counters. */
   if (ffd->format < SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
@@ -488,6 +610,11 @@ recover_body(void *baton, apr_pool_t *pool)
         SVN_ERR(svn_fs_fs__del_rep_reference(fs, max_rev, pool));
     }
 
+  /* Likewise, the path index must not claim to cover revisions that
+     don't exist anymore. */
+  SVN_ERR(svn_fs_fs__del_path_index_entries(fs, max_rev, pool));
+  SVN_ERR(svn_fs_fs__truncate_date_index(fs, max_rev, pool));
+
   /* Now store the discovered youngest revision, and the next IDs if
      relevant, in a new 'current' file. */
   return svn_fs_fs__write_current(fs, max_rev, next_node_id, next_copy_id,
@@ -70,6 +70,16 @@ SELECT hash, revision, offset, size, expanded_size
 FROM rep_cache
 WHERE revision >= ?1 AND revision <= ?2
 
+-- STMT_GET_REP_COUNT
+/* Works for both V1 and V2 schemas. */
+SELECT COUNT(*)
+FROM rep_cache
+
+-- STMT_GET_ALL_HASHES
+/* Works for both V1 and V2 schemas. */
+SELECT hash
+FROM rep_cache
+
 -- STMT_GET_MAX_REV
 /* Works for both V1 and V2 schemas. */
 SELECT MAX(revision)
@@ -80,6 +90,25 @@ FROM rep_cache
 DELETE FROM rep_cache
 WHERE revision > ?1
 
+-- STMT_CREATE_CHUNK_REFS
+/* A table mapping hashes of content-defined chunks to the SHA1 of a
+   representation containing that chunk.  This is only used as a hint
+   when choosing delta bases, i.e. the representation may not exist.
+   Created on demand and ignored by older versions. */
+CREATE TABLE IF NOT EXISTS chunk_refs (
+  hash INTEGER NOT NULL PRIMARY KEY,
+  rep_hash TEXT NOT NULL
+  );
+
+-- STMT_GET_CHUNK_REF
+SELECT rep_hash
+FROM chunk_refs
+WHERE hash = ?1
+
+-- STMT_SET_CHUNK_REF
+INSERT OR REPLACE INTO chunk_refs (hash, rep_hash)
+VALUES (?1, ?2)
+
 /* An INSERT takes an SQLite reserved lock that prevents other writes
    but doesn't block reads.  The incomplete transaction means that no
    permanent change is made to the database and the transaction is
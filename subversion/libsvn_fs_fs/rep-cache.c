@@ -33,6 +33,7 @@
 #include "svn_path.h"
 
 #include "private/svn_sqlite.h"
+#include "private/svn_subr_private.h"
 
 #include "rep-cache-db.h"
 
@@ -49,6 +50,152 @@ path_rep_cache_db(const char *fs_path,
 }
 
 
+/** Bloom filter for rep-cache lookups. **/
+
+/* Number of bits per key in a newly built filter.  With FILTER_HASHES
+   bits set per key, this gives a false positive rate of about 0.02%. */
+#define FILTER_BITS_PER_KEY 32
+
+/* Once keys have been added until there are fewer than this many bits
+   per key (false positive rate of about 0.2%), we rebuild the filter. */
+#define FILTER_MIN_BITS_PER_KEY 16
+
+/* Minimal size of the filter in bits.  Must be a power of two. */
+#define FILTER_MIN_BITS 0x10000
+
+/* Number of bits to set per key.  The SHA1 digest provides enough bits
+   for up to 5 independent hash values. */
+#define FILTER_HASHES 4
+
+struct svn_fs_fs__rep_cache_filter_t
+{
+  /* The filter bits.  Indexes range from 0 to BIT_COUNT - 1. */
+  svn_bit_array__t *bits;
+
+  /* Size of the filter in bits.  Always a power of two. */
+  apr_size_t bit_count;
+
+  /* Number of keys that have been added to the filter. */
+  apr_size_t key_count;
+
+  /* Pool that contains this filter. */
+  apr_pool_t *pool;
+};
+
+/* Return the bit index within FILTER for the hash function number I
+   applied to the SHA1 DIGEST. */
+static apr_size_t
+filter_bit(const svn_fs_fs__rep_cache_filter_t *filter,
+           const unsigned char *digest,
+           int i)
+{
+  const unsigned char *p = digest + i * 4;
+  apr_size_t value = (apr_size_t)p[0]
+                   | ((apr_size_t)p[1] << 8)
+                   | ((apr_size_t)p[2] << 16)
+                   | ((apr_size_t)p[3] << 24);
+
+  return value & (filter->bit_count - 1);
+}
+
+/* Add the SHA1 DIGEST to FILTER. */
+static void
+filter_add(svn_fs_fs__rep_cache_filter_t *filter,
+           const unsigned char *digest)
+{
+  int i;
+  for (i = 0; i < FILTER_HASHES; ++i)
+    svn_bit_array__set(filter->bits, filter_bit(filter, digest, i), TRUE);
+
+  filter->key_count++;
+}
+
+/* Return FALSE, if the SHA1 DIGEST has definitely not been added to
+   FILTER. */
+static svn_boolean_t
+filter_may_contain(const svn_fs_fs__rep_cache_filter_t *filter,
+                   const unsigned char *digest)
+{
+  int i;
+  for (i = 0; i < FILTER_HASHES; ++i)
+    if (!svn_bit_array__get(filter->bits, filter_bit(filter, digest, i)))
+      return FALSE;
+
+  return TRUE;
+}
+
+/* If FS uses a rep-cache filter but has not built it yet, do so now.
+   The rep-cache database must already be open.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+auto_build_filter(svn_fs_t *fs,
+                  apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_fs_fs__rep_cache_filter_t *filter;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  apr_int64_t count;
+  apr_pool_t *pool;
+  apr_pool_t *iterpool;
+  svn_error_t *err;
+
+  if (ffd->rep_cache_filter)
+    return SVN_NO_ERROR;
+
+  /* Size the filter such that it will not need to be rebuilt anytime
+     soon. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                    STMT_GET_REP_COUNT));
+  SVN_ERR(svn_sqlite__step_row(stmt));
+  count = svn_sqlite__column_int64(stmt, 0);
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  pool = svn_pool_create(fs->pool);
+  filter = apr_pcalloc(pool, sizeof(*filter));
+  filter->pool = pool;
+  filter->bit_count = FILTER_MIN_BITS;
+  while (   filter->bit_count < APR_SIZE_MAX / 2
+         && (apr_int64_t)(filter->bit_count / FILTER_BITS_PER_KEY) < count)
+    filter->bit_count *= 2;
+
+  filter->bits = svn_bit_array__create(filter->bit_count, pool);
+
+  /* Add all keys currently in the database. */
+  iterpool = svn_pool_create(scratch_pool);
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                    STMT_GET_ALL_HASHES));
+  err = svn_sqlite__step(&have_row, stmt);
+  while (!err && have_row)
+    {
+      svn_checksum_t *checksum;
+
+      svn_pool_clear(iterpool);
+      err = svn_checksum_parse_hex(&checksum, svn_checksum_sha1,
+                                   svn_sqlite__column_text(stmt, 0, iterpool),
+                                   iterpool);
+      if (err)
+        break;
+
+      filter_add(filter, checksum->digest);
+      err = svn_sqlite__step(&have_row, stmt);
+    }
+
+  err = svn_error_compose_create(err, svn_sqlite__reset(stmt));
+  svn_pool_destroy(iterpool);
+
+  if (err)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_trace(err);
+    }
+
+  ffd->rep_cache_filter = filter;
+
+  return SVN_NO_ERROR;
+}
+
+
 /** Library-private API's. **/
 
 /* Body of svn_fs_fs__open_rep_cache().
@@ -112,6 +259,13 @@ open_rep_cache(void *baton,
       SVN_SQLITE__ERR_CLOSE(svn_sqlite__exec_statements(sdb, stmt), sdb);
     }
 
+  /* The chunk index does not change the schema version because it is
+     optional and other versions may simply ignore it. */
+  if (ffd->content_chunking)
+    SVN_SQLITE__ERR_CLOSE(svn_sqlite__exec_statements(sdb,
+                                                      STMT_CREATE_CHUNK_REFS),
+                          sdb);
+
   /* This is used as a flag that the database is available so don't
      set it earlier. */
   ffd->rep_cache_db = sdb;
@@ -281,6 +435,29 @@ svn_fs_fs__get_rep_reference(representation_t **rep_p,
                             _("Only SHA1 checksums can be used as keys in the "
                               "rep_cache table.\n"));
 
+  /* In bulk load mode, recent entries may not be in the database, yet. */
+  if (ffd->bulk_load_reps_hash)
+    {
+      rep = apr_hash_get(ffd->bulk_load_reps_hash, checksum->digest,
+                         APR_SHA1_DIGESTSIZE);
+      if (rep)
+        {
+          *rep_p = svn_fs_fs__rep_copy(rep, pool);
+          return SVN_NO_ERROR;
+        }
+    }
+
+  /* Skip the database lookup for keys that it definitely doesn't have. */
+  if (ffd->use_rep_cache_filter)
+    {
+      SVN_ERR(auto_build_filter(fs, pool));
+      if (!filter_may_contain(ffd->rep_cache_filter, checksum->digest))
+        {
+          *rep_p = NULL;
+          return SVN_NO_ERROR;
+        }
+    }
+
   SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db, STMT_GET_REP));
   SVN_ERR(svn_sqlite__bindf(stmt, "s",
                             svn_checksum_to_cstring(checksum, pool)));
@@ -352,6 +529,20 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
 
   SVN_ERR(svn_sqlite__insert(NULL, stmt));
 
+  /* Keep the filter in sync.  Once it gets too crowded, drop it such that
+     it will be rebuilt with a larger size upon the next lookup. */
+  if (ffd->rep_cache_filter)
+    {
+      svn_fs_fs__rep_cache_filter_t *filter = ffd->rep_cache_filter;
+
+      filter_add(filter, rep->sha1_digest);
+      if (filter->bit_count / FILTER_MIN_BITS_PER_KEY < filter->key_count)
+        {
+          ffd->rep_cache_filter = NULL;
+          svn_pool_destroy(filter->pool);
+        }
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -373,9 +564,104 @@ svn_fs_fs__del_rep_reference(svn_fs_t *fs,
   SVN_ERR(svn_sqlite__bindf(stmt, "r", youngest));
   SVN_ERR(svn_sqlite__step_done(stmt));
 
+  /* The rep-cache filter may now report deleted keys as being present.
+     That is harmless as the database lookup will not find them. */
+
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__get_chunk_reference(svn_checksum_t **sha1_p,
+                               svn_fs_t *fs,
+                               apr_uint64_t hash,
+                               apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR_ASSERT(ffd->content_chunking);
+  if (! ffd->rep_cache_db)
+    SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                    STMT_GET_CHUNK_REF));
+  SVN_ERR(svn_sqlite__bind_int64(stmt, 1, (apr_int64_t)hash));
+
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  if (have_row)
+    {
+      const char *sha1_digest = svn_sqlite__column_text(stmt, 0, pool);
+      svn_error_t *err = svn_checksum_parse_hex(sha1_p, svn_checksum_sha1,
+                                                sha1_digest, pool);
+      if (err)
+        return svn_error_compose_create(err, svn_sqlite__reset(stmt));
+    }
+  else
+    *sha1_p = NULL;
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Baton type for set_chunk_references(). */
+typedef struct set_chunk_references_baton_t
+{
+  const apr_array_header_t *hashes;
+  const char *sha1_digest;
+} set_chunk_references_baton_t;
+
+/* Implements svn_sqlite__transaction_callback_t for
+   svn_fs_fs__set_chunk_references(). */
+static svn_error_t *
+set_chunk_references(void *baton,
+                     svn_sqlite__db_t *db,
+                     apr_pool_t *scratch_pool)
+{
+  set_chunk_references_baton_t *b = baton;
+  svn_sqlite__stmt_t *stmt;
+  int i;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, db, STMT_SET_CHUNK_REF));
+  for (i = 0; i < b->hashes->nelts; ++i)
+    {
+      apr_uint64_t hash = APR_ARRAY_IDX(b->hashes, i, apr_uint64_t);
+
+      SVN_ERR(svn_sqlite__bind_int64(stmt, 1, (apr_int64_t)hash));
+      SVN_ERR(svn_sqlite__bind_text(stmt, 2, b->sha1_digest));
+      SVN_ERR(svn_sqlite__insert(NULL, stmt));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__set_chunk_references(svn_fs_t *fs,
+                                const apr_array_header_t *hashes,
+                                const representation_t *rep,
+                                apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  set_chunk_references_baton_t baton;
+  svn_checksum_t checksum;
+
+  SVN_ERR_ASSERT(ffd->content_chunking && rep->has_sha1);
+  if (! ffd->rep_cache_db)
+    SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
+
+  if (hashes->nelts == 0)
+    return SVN_NO_ERROR;
+
+  checksum.kind = svn_checksum_sha1;
+  checksum.digest = rep->sha1_digest;
+
+  baton.hashes = hashes;
+  baton.sha1_digest = svn_checksum_to_cstring(&checksum, pool);
+
+  return svn_error_trace(svn_sqlite__with_transaction(ffd->rep_cache_db,
+                                                      set_chunk_references,
+                                                      &baton, pool));
+}
+
 /* Start a transaction to take an SQLite reserved lock that prevents
    other writes.
 
@@ -90,6 +90,29 @@ svn_fs_fs__del_rep_reference(svn_fs_t *fs,
                              svn_revnum_t youngest,
                              apr_pool_t *pool);
 
+/* Set *SHA1_P to the SHA1 checksum of a representation in FS that has
+   been recorded as containing the content chunk identified by HASH.
+   Set it to NULL if no such representation is known.  Note that the
+   representation does not necessarily exist.  Allocate *SHA1_P in POOL.
+
+   Only available if content chunking has been enabled for FS. */
+svn_error_t *
+svn_fs_fs__get_chunk_reference(svn_checksum_t **sha1_p,
+                               svn_fs_t *fs,
+                               apr_uint64_t hash,
+                               apr_pool_t *pool);
+
+/* Record in FS that the representation REP contains the content chunks
+   identified by the apr_uint64_t elements in HASHES.  Use POOL for
+   temporary allocations.
+
+   Only available if content chunking has been enabled for FS. */
+svn_error_t *
+svn_fs_fs__set_chunk_references(svn_fs_t *fs,
+                                const apr_array_header_t *hashes,
+                                const representation_t *rep,
+                                apr_pool_t *pool);
+
 /* Start a transaction to take an SQLite reserved lock that prevents
    other writes, call BODY, end the transaction, and return what BODY returned.
  */
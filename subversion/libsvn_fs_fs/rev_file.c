@@ -20,6 +20,13 @@
  * ====================================================================
  */
 
+#include <string.h>
+
+#include <apr_strings.h>
+
+#include "svn_pools.h"
+#include "svn_sorts.h"
+
 #include "rev_file.h"
 #include "fs_fs.h"
 #include "index.h"
@@ -49,6 +56,18 @@ init_revision_file(svn_fs_fs__revision_file_t *file,
   file->p2l_stream = NULL;
   file->l2p_stream = NULL;
   file->block_size = ffd->block_size;
+  file->prefetched_end = 0;
+  file->mapped_data = NULL;
+  file->mapped_size = 0;
+#if APR_HAS_MMAP
+  file->mmap = NULL;
+#endif
+  file->l2p_table = NULL;
+  file->l2p_table_size = 0;
+  file->l2p_table_probed = FALSE;
+#if APR_HAS_MMAP
+  file->l2p_table_mmap = NULL;
+#endif
   file->l2p_offset = -1;
   file->l2p_checksum = NULL;
   file->p2l_offset = -1;
@@ -120,6 +139,38 @@ auto_make_writable(const char *path,
   return SVN_NO_ERROR;
 }
 
+/* Map the whole contents of the already opened FILE into memory, allocated
+ * in RESULT_POOL.  If that fails, FILE will simply not be mapped.
+ * Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+map_rev_file(svn_fs_fs__revision_file_t *file,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+#if APR_HAS_MMAP
+  apr_finfo_t finfo;
+  apr_mmap_t *mmap;
+
+  SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_SIZE, file->file,
+                               scratch_pool));
+
+  /* Files larger than our address space will be accessed as usual.
+   * Same if the mapping fails for some other reason. */
+  if (   finfo.size > 0
+      && finfo.size <= APR_SIZE_MAX
+      && apr_mmap_create(&mmap, file->file, 0, (apr_size_t)finfo.size,
+                         APR_MMAP_READ, result_pool) == APR_SUCCESS)
+    {
+      file->mmap = mmap;
+      file->mapped_data = mmap->mm;
+      file->mapped_size = finfo.size;
+    }
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 /* Core implementation of svn_fs_fs__open_pack_or_rev_file working on an
  * existing, initialized FILE structure.  If WRITABLE is TRUE, give write
  * access to the file - temporarily resetting the r/o state if necessary.
@@ -160,6 +211,10 @@ open_pack_or_rev_file(svn_fs_fs__revision_file_t *file,
                                                   result_pool);
           file->is_packed = svn_fs_fs__is_packed_rev(fs, rev);
 
+          /* Pack files are immutable, so we may map them. */
+          if (!writable && file->is_packed && ffd->mmap_packed_files)
+            SVN_ERR(map_rev_file(file, result_pool, scratch_pool));
+
           return SVN_NO_ERROR;
         }
 
@@ -237,22 +292,23 @@ svn_fs_fs__auto_read_footer(svn_fs_fs__revision_file_t *file)
       svn_stringbuf_t *footer;
 
       /* Determine file size. */
-      SVN_ERR(svn_io_file_seek(file->file, APR_END, &filesize, file->pool));
+      if (file->mapped_data)
+        filesize = file->mapped_size;
+      else
+        SVN_ERR(svn_io_file_seek(file->file, APR_END, &filesize,
+                                 file->pool));
 
       /* Read last byte (containing the length of the footer). */
-      SVN_ERR(svn_io_file_aligned_seek(file->file, file->block_size, NULL,
-                                       filesize - 1, file->pool));
-      SVN_ERR(svn_io_file_read_full2(file->file, &footer_length,
-                                     sizeof(footer_length), NULL, NULL,
-                                     file->pool));
+      SVN_ERR(svn_fs_fs__rev_file_read(file, &footer_length,
+                                       filesize - 1, sizeof(footer_length),
+                                       file->pool));
 
       /* Read footer. */
       footer = svn_stringbuf_create_ensure(footer_length, file->pool);
-      SVN_ERR(svn_io_file_aligned_seek(file->file, file->block_size, NULL,
+      SVN_ERR(svn_fs_fs__rev_file_read(file, footer->data,
                                        filesize - 1 - footer_length,
-                                       file->pool));
-      SVN_ERR(svn_io_file_read_full2(file->file, footer->data, footer_length,
-                                     &footer->len, NULL, file->pool));
+                                       footer_length, file->pool));
+      footer->len = footer_length;
       footer->data[footer->len] = '\0';
 
       /* Extract index locations. */
@@ -267,6 +323,146 @@ svn_fs_fs__auto_read_footer(svn_fs_fs__revision_file_t *file)
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__rev_file_read(svn_fs_fs__revision_file_t *file,
+                         void *buffer,
+                         apr_off_t offset,
+                         apr_size_t len,
+                         apr_pool_t *scratch_pool)
+{
+  if (file->mapped_data)
+    {
+      if (   offset < 0
+          || offset > file->mapped_size
+          || (apr_off_t)len > file->mapped_size - offset)
+        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                                 _("Unexpected end of pack file for r%ld "
+                                   "at offset %s"),
+                                 file->start_revision,
+                                 apr_off_t_toa(scratch_pool, offset));
+
+      memcpy(buffer, file->mapped_data + offset, len);
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_io_file_aligned_seek(file->file, file->block_size, NULL,
+                                   offset, scratch_pool));
+  return svn_error_trace(svn_io_file_read_full2(file->file, buffer, len,
+                                                NULL, NULL, scratch_pool));
+}
+
+/* Baton type for mapped_stream_read(). */
+typedef struct mapped_stream_baton_t
+{
+  /* the memory mapped file to read from */
+  svn_fs_fs__revision_file_t *file;
+
+  /* current read position within FILE, owned by the stream creator */
+  apr_off_t *offset;
+
+  /* first offset within FILE that shall not be read anymore */
+  apr_off_t end;
+} mapped_stream_baton_t;
+
+/* Implements svn_read_fn_t for svn_fs_fs__rev_file_mapped_stream(). */
+static svn_error_t *
+mapped_stream_read(void *baton,
+                   char *buffer,
+                   apr_size_t *len)
+{
+  mapped_stream_baton_t *b = baton;
+  apr_off_t end = MIN(b->end, b->file->mapped_size);
+  apr_off_t available = *b->offset < end ? end - *b->offset : 0;
+
+  if ((apr_off_t)*len > available)
+    *len = (apr_size_t)available;
+
+  memcpy(buffer, b->file->mapped_data + *b->offset, *len);
+  *b->offset += *len;
+
+  return SVN_NO_ERROR;
+}
+
+svn_stream_t *
+svn_fs_fs__rev_file_mapped_stream(svn_fs_fs__revision_file_t *file,
+                                  apr_off_t *offset,
+                                  apr_off_t end,
+                                  apr_pool_t *result_pool)
+{
+  mapped_stream_baton_t *baton = apr_palloc(result_pool, sizeof(*baton));
+  svn_stream_t *stream;
+
+  SVN_ERR_ASSERT_NO_RETURN(file->mapped_data);
+
+  baton->file = file;
+  baton->offset = offset;
+  baton->end = end;
+
+  stream = svn_stream_create(baton, result_pool);
+  svn_stream_set_read2(stream, NULL /* only full read support */,
+                       mapped_stream_read);
+
+  return stream;
+}
+
+svn_error_t *
+svn_fs_fs__rev_file_l2p_table(const unsigned char **table,
+                              apr_size_t *size,
+                              svn_fs_fs__revision_file_t *file,
+                              svn_fs_t *fs)
+{
+#if APR_HAS_MMAP
+  if (!file->l2p_table_probed && file->is_packed)
+    {
+      apr_pool_t *scratch_pool = svn_pool_create(file->pool);
+      const char *path = svn_fs_fs__path_rev_packed(fs, file->start_revision,
+                                                    PATH_L2P_TABLE,
+                                                    scratch_pool);
+      apr_file_t *table_file;
+      apr_finfo_t finfo;
+      apr_mmap_t *mmap;
+      svn_error_t *err;
+
+      /* Don't try again, whatever the outcome. */
+      file->l2p_table_probed = TRUE;
+
+      /* The table is optional.  If it is missing or cannot be mapped,
+       * our caller will simply use the regular index. */
+      err = svn_io_file_open(&table_file, path, APR_READ, APR_OS_DEFAULT,
+                             scratch_pool);
+      if (!err)
+        {
+          err = svn_io_file_info_get(&finfo, APR_FINFO_SIZE, table_file,
+                                     scratch_pool);
+          if (   !err
+              && finfo.size > 0
+              && finfo.size <= APR_SIZE_MAX
+              && apr_mmap_create(&mmap, table_file, 0,
+                                 (apr_size_t)finfo.size, APR_MMAP_READ,
+                                 file->pool) == APR_SUCCESS)
+            {
+              file->l2p_table_mmap = mmap;
+              file->l2p_table = mmap->mm;
+              file->l2p_table_size = (apr_size_t)finfo.size;
+            }
+
+          /* The mapping remains valid after closing the file. */
+          err = svn_error_compose_create(err,
+                                         svn_io_file_close(table_file,
+                                                           scratch_pool));
+        }
+
+      svn_error_clear(err);
+      svn_pool_destroy(scratch_pool);
+    }
+#endif
+
+  *table = file->l2p_table;
+  *size = file->l2p_table_size;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
                                svn_fs_t *fs,
@@ -293,6 +489,31 @@ svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
 svn_error_t *
 svn_fs_fs__close_revision_file(svn_fs_fs__revision_file_t *file)
 {
+#if APR_HAS_MMAP
+  if (file->mmap)
+    {
+      apr_status_t status = apr_mmap_delete(file->mmap);
+      if (status)
+        return svn_error_wrap_apr(status, _("Failed to delete mmap"));
+    }
+
+  file->mmap = NULL;
+
+  if (file->l2p_table_mmap)
+    {
+      apr_status_t status = apr_mmap_delete(file->l2p_table_mmap);
+      if (status)
+        return svn_error_wrap_apr(status, _("Failed to delete mmap"));
+    }
+
+  file->l2p_table_mmap = NULL;
+#endif
+  file->mapped_data = NULL;
+  file->mapped_size = 0;
+  file->l2p_table = NULL;
+  file->l2p_table_size = 0;
+  file->l2p_table_probed = FALSE;
+
   if (file->stream)
     SVN_ERR(svn_stream_close(file->stream));
   if (file->file)
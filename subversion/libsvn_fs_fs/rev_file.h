@@ -23,6 +23,8 @@
 #ifndef SVN_LIBSVN_FS__REV_FILE_H
 #define SVN_LIBSVN_FS__REV_FILE_H
 
+#include <apr_mmap.h>
+
 #include "svn_fs.h"
 #include "id.h"
 
@@ -67,6 +69,40 @@ typedef struct svn_fs_fs__revision_file_t
    * use aligned seek() without having the FS handy. */
   apr_off_t block_size;
 
+  /* End of the section within FILE that we last asked the OS to read
+   * ahead.  0 if no read-ahead has been requested, yet. */
+  apr_off_t prefetched_end;
+
+  /* Read-only memory mapping of the whole FILE or NULL.  Only provided for
+   * pack files opened read-only and if enabled in the FS configuration.
+   * If not NULL, readers may access the data directly instead of seeking
+   * and reading FILE.  Note that this does not change the FILE pointer. */
+  const char *mapped_data;
+
+  /* Number of bytes in MAPPED_DATA.  0 if FILE has not been mapped. */
+  apr_off_t mapped_size;
+
+#if APR_HAS_MMAP
+  /* The mapping providing MAPPED_DATA.  NULL if FILE has not been mapped. */
+  apr_mmap_t *mmap;
+#endif
+
+  /* Read-only memory mapping of the decoded L2P index table that belongs
+   * to this pack file or NULL if there is none or it has not been mapped
+   * yet.  See svn_fs_fs__rev_file_l2p_table(). */
+  const unsigned char *l2p_table;
+
+  /* Number of bytes in L2P_TABLE. */
+  apr_size_t l2p_table_size;
+
+  /* TRUE, if we already tried to map the decoded L2P index table. */
+  svn_boolean_t l2p_table_probed;
+
+#if APR_HAS_MMAP
+  /* The mapping providing L2P_TABLE.  NULL if the table is not mapped. */
+  apr_mmap_t *l2p_table_mmap;
+#endif
+
   /* Offset within FILE at which the rev data ends and the L2P index
    * data starts. Less than P2L_OFFSET. -1 if svn_fs_fs__auto_read_footer
    * has not been called, yet. */
@@ -128,6 +164,40 @@ svn_fs_fs__open_pack_or_rev_file_writable(svn_fs_fs__revision_file_t **file,
 svn_error_t *
 svn_fs_fs__auto_read_footer(svn_fs_fs__revision_file_t *file);
 
+/* Read LEN bytes starting at OFFSET from FILE into BUFFER.  Use the memory
+ * mapping of FILE, if available, and an aligned seek followed by a read
+ * otherwise.  In the latter case, the file pointer will be positioned
+ * directly behind the data read.  Use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__rev_file_read(svn_fs_fs__revision_file_t *file,
+                         void *buffer,
+                         apr_off_t offset,
+                         apr_size_t len,
+                         apr_pool_t *scratch_pool);
+
+/* Return a read-only stream in RESULT_POOL that reads the data of the
+ * memory mapped FILE starting at *OFFSET up to but not including END.
+ * *OFFSET will be updated with every read and may also be modified by
+ * the caller to navigate within the data.  FILE must be memory mapped.
+ */
+svn_stream_t *
+svn_fs_fs__rev_file_mapped_stream(svn_fs_fs__revision_file_t *file,
+                                  apr_off_t *offset,
+                                  apr_off_t end,
+                                  apr_pool_t *result_pool);
+
+/* If FILE is a pack file in FS and the decoded L2P index table of that
+ * shard exists, map it into memory and return its contents in *TABLE and
+ * its size in *SIZE.  Set *TABLE to NULL if there is no such table or it
+ * cannot be mapped.  Only the first call per FILE will access the disk.
+ */
+svn_error_t *
+svn_fs_fs__rev_file_l2p_table(const unsigned char **table,
+                              apr_size_t *size,
+                              svn_fs_fs__revision_file_t *file,
+                              svn_fs_t *fs);
+
 /* Open the proto-rev file of transaction TXN_ID in FS and return it in *FILE.
  * Allocate *FILE in RESULT_POOL use and SCRATCH_POOL for temporaries.. */
 svn_error_t *
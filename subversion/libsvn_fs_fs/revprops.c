@@ -21,12 +21,14 @@
  */
 
 #include <assert.h>
+#include <apr_mmap.h>
 
 #include "svn_pools.h"
 #include "svn_hash.h"
 #include "svn_dirent_uri.h"
 #include "svn_sorts.h"
 
+#include "date-index.h"
 #include "fs_fs.h"
 #include "revprops.h"
 #include "temp_serializer.h"
@@ -156,6 +158,10 @@ typedef struct packed_revprops_t
   /* packed shard folder path */
   const char *folder;
 
+  /* identifies the version of the pack file that the data had been read
+   * from; 0 if unknown */
+  apr_uint64_t generation;
+
   /* sum of values in SIZES */
   apr_size_t total_size;
 
@@ -260,6 +266,28 @@ cache_revprops(svn_boolean_t *is_cached,
   return SVN_NO_ERROR;
 }
 
+/* Store the unparsed revprop hash CONTENT for REVISION in FS's packed
+ * revprop cache, using GENERATION as the pack file version.  Use
+ * SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+cache_packed_revprops(svn_fs_t *fs,
+                      svn_revnum_t revision,
+                      apr_uint64_t generation,
+                      svn_string_t *content,
+                      apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  pair_cache_key_t key;
+
+  key.revision = revision;
+  key.second = (apr_int64_t)generation;
+
+  SVN_ERR(svn_cache__set(ffd->packed_revprop_cache, &key, content,
+                         scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Read the non-packed revprops for revision REV in FS, put them into the
  * revprop cache if PROPULATE_CACHE is set and return them in *PROPERTIES.
  *
@@ -570,6 +598,9 @@ parse_packed_revprops(svn_fs_t *fs,
           svn_boolean_t already_cached;
           SVN_ERR(cache_revprops(&already_cached, fs, revision, &serialized,
                                  iterpool));
+          if (revprops->generation)
+            SVN_ERR(cache_packed_revprops(fs, revision, revprops->generation,
+                                          &serialized, iterpool));
 
           /* Stop populating the cache once we encountered too many entries
            * already present relative to the numbers being added. */
@@ -599,6 +630,153 @@ parse_packed_revprops(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+/* Return a value identifying the version of the revprop pack file
+ * described by FINFO.  Pack files never get modified in place but are
+ * replaced by new files, so any update will change the result.
+ */
+static apr_uint64_t
+get_pack_generation(const apr_finfo_t *finfo)
+{
+  /* FNV style mixing of the file's identity and its last change. */
+  apr_uint64_t generation = (apr_uint64_t)finfo->inode;
+  generation = (generation * APR_UINT64_C(0x100000001b3))
+             ^ (apr_uint64_t)finfo->mtime;
+  generation = (generation * APR_UINT64_C(0x100000001b3))
+             ^ (apr_uint64_t)finfo->size;
+
+  /* Reserve 0 for "unknown". */
+  return generation ? generation : 1;
+}
+
+/* The file info we need to determine the pack file generation. */
+#define PACK_GENERATION_WANTED (APR_FINFO_INODE | APR_FINFO_MTIME \
+                                | APR_FINFO_SIZE)
+
+/* Look up the properties of REVPROPS->REVISION in FS's packed revprop
+ * cache, using the pack file name and folder in REVPROPS.  If found,
+ * set REVPROPS->PROPERTIES, allocated in RESULT_POOL.  Otherwise, leave
+ * it unchanged.  Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+get_cached_packed_revprops(svn_fs_t *fs,
+                           packed_revprops_t *revprops,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_finfo_t finfo;
+  pair_cache_key_t key;
+  svn_boolean_t is_cached;
+  svn_error_t *err;
+  const char *path = svn_dirent_join(revprops->folder, revprops->filename,
+                                     scratch_pool);
+
+  /* Whatever went wrong here will be reported by the actual read. */
+  err = svn_io_stat(&finfo, path, PACK_GENERATION_WANTED, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  key.revision = revprops->revision;
+  key.second = (apr_int64_t)get_pack_generation(&finfo);
+  SVN_ERR(svn_cache__get((void **)&revprops->properties, &is_cached,
+                         ffd->packed_revprop_cache, &key, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the revprop pack file at PATH in FS into *CONTENT, allocated in
+ * RESULT_POOL, and set *GENERATION to the version of the file being read.
+ * If the file got mapped into memory instead of being read, return the
+ * mapping in *MAPPING; the caller must delete it after use.  Otherwise,
+ * set *MAPPING to NULL.
+ *
+ * Recoverable errors are handled as in svn_fs_fs__try_stringbuf_from_file
+ * with MISSING and LAST_ATTEMPT having the same meaning.  Use SCRATCH_POOL
+ * for temporaries.
+ */
+static svn_error_t *
+read_pack_file(svn_stringbuf_t **content,
+               apr_uint64_t *generation,
+               void **mapping,
+               svn_boolean_t *missing,
+               svn_fs_t *fs,
+               const char *path,
+               svn_boolean_t last_attempt,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_file_t *file;
+  apr_finfo_t finfo;
+  svn_error_t *err;
+
+  *content = NULL;
+  *mapping = NULL;
+  *missing = FALSE;
+
+  err = svn_io_file_open(&file, path, APR_READ | APR_BUFFERED,
+                         APR_OS_DEFAULT, scratch_pool);
+  if (!err)
+    err = svn_io_file_info_get(&finfo, PACK_GENERATION_WANTED, file,
+                               scratch_pool);
+
+#if APR_HAS_MMAP
+  /* Decompress directly from the mapped file contents, if enabled. */
+  if (!err && ffd->mmap_packed_files && finfo.size > 0
+      && finfo.size <= APR_SIZE_MAX)
+    {
+      apr_mmap_t *mmap;
+      if (apr_mmap_create(&mmap, file, 0, (apr_size_t)finfo.size,
+                          APR_MMAP_READ, result_pool) == APR_SUCCESS)
+        {
+          *content = apr_pcalloc(result_pool, sizeof(**content));
+          (*content)->data = mmap->mm;
+          (*content)->len = (apr_size_t)finfo.size;
+          (*content)->blocksize = (apr_size_t)finfo.size;
+          (*content)->pool = result_pool;
+          *mapping = mmap;
+        }
+    }
+#endif
+
+  if (!err && !*content)
+    err = svn_stringbuf_from_aprfile(content, file, result_pool);
+
+  if (!err)
+    {
+      *generation = get_pack_generation(&finfo);
+      return svn_error_trace(svn_io_file_close(file, scratch_pool));
+    }
+
+  /* Same recoverable errors as in svn_fs_fs__try_stringbuf_from_file. */
+  *content = NULL;
+  if (APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      if (!last_attempt)
+        {
+          svn_error_clear(err);
+          *missing = TRUE;
+          return SVN_NO_ERROR;
+        }
+    }
+#ifdef ESTALE
+  else if (APR_TO_OS_ERROR(err->apr_err) == ESTALE
+            || APR_TO_OS_ERROR(err->apr_err) == EIO)
+    {
+      if (!last_attempt)
+        {
+          svn_error_clear(err);
+          return SVN_NO_ERROR;
+        }
+    }
+#endif
+
+  return svn_error_trace(err);
+}
+
 /* In filesystem FS, read the packed revprops for revision REV into
  * *REVPROPS. Populate the revprop cache, if POPULATE_CACHE is set.
  * If you want to modify revprop contents / update REVPROPS, READ_ALL
@@ -613,10 +791,12 @@ read_pack_revprop(packed_revprops_t **revprops,
                   svn_boolean_t populate_cache,
                   apr_pool_t *pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   apr_pool_t *iterpool = svn_pool_create(pool);
   svn_boolean_t missing = FALSE;
   svn_error_t *err;
   packed_revprops_t *result;
+  void *mapping = NULL;
   int i;
 
   /* someone insisted that REV is packed. Double-check if necessary */
@@ -644,14 +824,26 @@ read_pack_revprop(packed_revprops_t **revprops,
        * Re-read the manifest and the pack file.
        */
       SVN_ERR(get_revprop_packname(fs, result, pool, iterpool));
+
+      /* We may have read the same version of that pack file before. */
+      if (!read_all && ffd->packed_revprop_cache)
+        {
+          SVN_ERR(get_cached_packed_revprops(fs, result, pool, iterpool));
+          if (result->properties)
+            {
+              svn_pool_destroy(iterpool);
+              *revprops = result;
+              return SVN_NO_ERROR;
+            }
+        }
+
       file_path  = svn_dirent_join(result->folder,
                                    result->filename,
                                    iterpool);
-      SVN_ERR(svn_fs_fs__try_stringbuf_from_file(&result->packed_revprops,
-                                &missing,
-                                file_path,
-                                i + 1 < SVN_FS_FS__RECOVERABLE_RETRY_COUNT,
-                                pool));
+      SVN_ERR(read_pack_file(&result->packed_revprops, &result->generation,
+                             &mapping, &missing, fs, file_path,
+                             i + 1 < SVN_FS_FS__RECOVERABLE_RETRY_COUNT,
+                             pool, iterpool));
     }
 
   /* the file content should be available now */
@@ -663,6 +855,13 @@ read_pack_revprop(packed_revprops_t **revprops,
   err = parse_packed_revprops(fs, result, read_all, populate_cache, pool,
                               iterpool);
   svn_pool_destroy(iterpool);
+
+#if APR_HAS_MMAP
+  /* All data has been decompressed into separate buffers by now. */
+  if (mapping)
+    apr_mmap_delete(mapping);
+#endif
+
   if (err)
     return svn_error_createf(SVN_ERR_FS_CORRUPT, err,
                   _("Revprop pack file for r%ld is corrupt"), rev);
@@ -1261,6 +1460,9 @@ svn_fs_fs__set_revision_proplist(svn_fs_t *fs,
   SVN_ERR(switch_to_new_revprop(fs, final_path, tmp_path, perms_reference,
                                 files_to_delete, pool));
 
+  /* The svn:date may have changed. */
+  SVN_ERR(svn_fs_fs__date_index_set_revprops(fs, rev, proplist, pool));
+
   return SVN_NO_ERROR;
 }
 
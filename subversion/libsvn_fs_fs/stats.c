@@ -20,6 +20,7 @@
  * ====================================================================
  */
 
+#include "svn_cache_config.h"
 #include "svn_dirent_uri.h"
 #include "svn_fs.h"
 #include "svn_pools.h"
@@ -28,6 +29,7 @@
 #include "private/svn_cache.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
+#include "private/svn_task.h"
 
 #include "index.h"
 #include "pack.h"
@@ -123,6 +125,49 @@ typedef struct rep_ref_t
 
 } rep_ref_t;
 
+/* A noderev found while scanning a rev / pack file in log. addressing mode
+ * that has not been added to the query, yet. */
+typedef struct scanned_noderev_t
+{
+  /* The parsed noderev with expanded sizes already being fixed up. */
+  node_revision_t *noderev;
+
+  /* Revision that contains this noderev. */
+  svn_revnum_t revision;
+
+  /* On-disk size of the noderev struct in bytes. */
+  apr_size_t size;
+} scanned_noderev_t;
+
+/* Everything we read from a single rev / pack file in log. addressing
+ * mode.  Collecting this data does not touch the query, so multiple files
+ * may be scanned concurrently.  The file contents get added to the query
+ * later, strictly in revision order. */
+typedef struct scanned_file_t
+{
+  /* First revision in this file. */
+  svn_revnum_t base;
+
+  /* Number of revisions in this file. */
+  int count;
+
+  /* Size of the file as covered by the p2l index. */
+  apr_off_t max_offset;
+
+  /* Number of changed paths per revision, COUNT elements. */
+  apr_uint64_t *change_counts;
+
+  /* Length of the changed paths lists in bytes per revision,
+   * COUNT elements. */
+  apr_uint64_t *changes_lens;
+
+  /* All scanned_noderev_t * in file order. */
+  apr_array_header_t *noderevs;
+
+  /* Delta chain links of all representations as rep_ref_t *. */
+  apr_array_header_t *rep_refs;
+} scanned_file_t;
+
 /* Represents a single revision.
  * There will be only one instance per revision. */
 typedef struct revision_info_t
@@ -203,6 +248,9 @@ typedef struct query_t
 
   /* Baton for CANCEL_FUNC. */
   void *cancel_baton;
+
+  /* Maximum number of threads to use for scanning the repository. */
+  int jobs;
 } query_t;
 
 /* Initialize the LARGEST_CHANGES member in STATS with a capacity of COUNT
@@ -596,31 +644,44 @@ parse_dir(query_t *query,
   return SVN_NO_ERROR;
 }
 
-/* Parse the noderev given as NODEREV_STR and store the info in QUERY and
- * REVISION_INFO.  In phys. addressing mode, continue reading all DAG nodes,
- * directories and representations linked in that tree structure.
+/* Parse the noderev given as NODEREV_STR in FS and return it in *NODEREV,
+ * allocated in RESULT_POOL.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+parse_noderev(node_revision_t **noderev,
+              svn_fs_t *fs,
+              svn_stringbuf_t *noderev_str,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  svn_stream_t *stream = svn_stream_from_stringbuf(noderev_str, scratch_pool);
+  SVN_ERR(svn_fs_fs__read_noderev(noderev, stream, result_pool,
+                                  scratch_pool));
+  SVN_ERR(svn_fs_fs__fixup_expanded_size(fs, (*noderev)->data_rep,
+                                         scratch_pool));
+  SVN_ERR(svn_fs_fs__fixup_expanded_size(fs, (*noderev)->prop_rep,
+                                         scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Store the info of NODEREV with an on-disk size of NODEREV_SIZE bytes in
+ * QUERY and REVISION_INFO.  In phys. addressing mode, continue reading all
+ * DAG nodes, directories and representations linked in that tree structure.
  *
  * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
  * temporaries.
  */
 static svn_error_t *
-read_noderev(query_t *query,
-             svn_stringbuf_t *noderev_str,
-             revision_info_t *revision_info,
-             apr_pool_t *result_pool,
-             apr_pool_t *scratch_pool)
+process_noderev(query_t *query,
+                node_revision_t *noderev,
+                apr_size_t noderev_size,
+                revision_info_t *revision_info,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
 {
   rep_stats_t *text = NULL;
   rep_stats_t *props = NULL;
-  node_revision_t *noderev;
-
-  svn_stream_t *stream = svn_stream_from_stringbuf(noderev_str, scratch_pool);
-  SVN_ERR(svn_fs_fs__read_noderev(&noderev, stream, scratch_pool,
-                                  scratch_pool));
-  SVN_ERR(svn_fs_fs__fixup_expanded_size(query->fs, noderev->data_rep,
-                                         scratch_pool));
-  SVN_ERR(svn_fs_fs__fixup_expanded_size(query->fs, noderev->prop_rep,
-                                         scratch_pool));
 
   if (noderev->data_rep)
     {
@@ -664,18 +725,42 @@ read_noderev(query_t *query,
   /* update stats */
   if (noderev->kind == svn_node_dir)
     {
-      revision_info->dir_noderev_size += noderev_str->len;
+      revision_info->dir_noderev_size += noderev_size;
       revision_info->dir_noderev_count++;
     }
   else
     {
-      revision_info->file_noderev_size += noderev_str->len;
+      revision_info->file_noderev_size += noderev_size;
       revision_info->file_noderev_count++;
     }
 
   return SVN_NO_ERROR;
 }
 
+/* Parse the noderev given as NODEREV_STR and store the info in QUERY and
+ * REVISION_INFO.  In phys. addressing mode, continue reading all DAG nodes,
+ * directories and representations linked in that tree structure.
+ *
+ * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
+ * temporaries.
+ */
+static svn_error_t *
+read_noderev(query_t *query,
+             svn_stringbuf_t *noderev_str,
+             revision_info_t *revision_info,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  node_revision_t *noderev;
+
+  SVN_ERR(parse_noderev(&noderev, query->fs, noderev_str, scratch_pool,
+                        scratch_pool));
+  SVN_ERR(process_noderev(query, noderev, noderev_str->len, revision_info,
+                          result_pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* For the revision given as REVISION_INFO within QUERY, determine the number
  * of entries in its changed paths list and store that info in REVISION_INFO.
  * Use SCRATCH_POOL for temporary allocations.
@@ -988,68 +1073,65 @@ resolve_representation_refs(query_t *query,
   return SVN_NO_ERROR;
 }
 
-/* Process the logically addressed revision contents of revisions BASE to
- * BASE + COUNT - 1 in QUERY.
+/* Read the logically addressed revision contents of revisions BASE to
+ * BASE + COUNT - 1 in FS and return them in *SCANNED, allocated in
+ * RESULT_POOL.  This does not depend on any other revisions, so it may be
+ * called for different files concurrently, as long as each call uses its
+ * own FS instance.
  *
- * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
- * temporaries.
+ * If not NULL, call CANCEL_FUNC with CANCEL_BATON from time to time.
+ * Use SCRATCH_POOL for temporary allocations.
  */
 static svn_error_t *
-read_log_rev_or_packfile(query_t *query,
+scan_log_rev_or_packfile(scanned_file_t **scanned,
+                         svn_fs_t *fs,
                          svn_revnum_t base,
                          int count,
+                         svn_cancel_func_t cancel_func,
+                         void *cancel_baton,
                          apr_pool_t *result_pool,
                          apr_pool_t *scratch_pool)
 {
-  fs_fs_data_t *ffd = query->fs->fsap_data;
+  fs_fs_data_t *ffd = fs->fsap_data;
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
-  apr_off_t max_offset;
   apr_off_t offset = 0;
   int i;
   svn_fs_fs__revision_file_t *rev_file;
+  scanned_file_t *result = apr_pcalloc(result_pool, sizeof(*result));
 
-  /* We collect the delta chain links as we scan the file.  Afterwards,
-   * we determine the lengths of those delta chains and throw this
-   * temporary container away. */
-  apr_array_header_t *rep_refs = apr_array_make(scratch_pool, 64,
-                                                sizeof(rep_ref_t *));
+  result->base = base;
+  result->count = count;
+  result->change_counts = apr_pcalloc(result_pool,
+                                      count * sizeof(*result->change_counts));
+  result->changes_lens = apr_pcalloc(result_pool,
+                                     count * sizeof(*result->changes_lens));
+  result->noderevs = apr_array_make(result_pool, 64,
+                                    sizeof(scanned_noderev_t *));
 
-  /* we will process every revision in the rev / pack file */
-  for (i = 0; i < count; ++i)
-    {
-      /* create the revision info for the current rev */
-      revision_info_t *info = apr_pcalloc(result_pool, sizeof(*info));
-      info->representations = apr_array_make(result_pool, 4,
-                                             sizeof(rep_stats_t*));
-      info->revision = base + i;
-
-      APR_ARRAY_PUSH(query->revisions, revision_info_t*) = info;
-    }
+  /* We collect the delta chain links as we scan the file.  They will be
+   * resolved once all earlier revisions are known. */
+  result->rep_refs = apr_array_make(result_pool, 64, sizeof(rep_ref_t *));
 
   /* open the pack / rev file that is covered by the p2l index */
-  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, query->fs, base,
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, base,
                                            scratch_pool, iterpool));
-  SVN_ERR(svn_fs_fs__p2l_get_max_offset(&max_offset, query->fs, rev_file,
+  SVN_ERR(svn_fs_fs__p2l_get_max_offset(&result->max_offset, fs, rev_file,
                                         base, scratch_pool));
 
-  /* record the whole pack size in the first rev so the total sum will
-     still be correct */
-  APR_ARRAY_IDX(query->revisions, base, revision_info_t*)->end = max_offset;
-
   /* for all offsets in the file, get the P2L index entries and process
      the interesting items (change lists, noderevs) */
-  for (offset = 0; offset < max_offset; )
+  for (offset = 0; offset < result->max_offset; )
     {
       apr_array_header_t *entries;
 
       svn_pool_clear(iterpool);
 
       /* cancellation support */
-      if (query->cancel_func)
-        SVN_ERR(query->cancel_func(query->cancel_baton));
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
 
       /* get all entries for the current block */
-      SVN_ERR(svn_fs_fs__p2l_index_lookup(&entries, query->fs, rev_file, base,
+      SVN_ERR(svn_fs_fs__p2l_index_lookup(&entries, fs, rev_file, base,
                                           offset, ffd->p2l_page_size,
                                           iterpool, iterpool));
 
@@ -1057,9 +1139,9 @@ read_log_rev_or_packfile(query_t *query,
       for (i = 0; i < entries->nelts; ++i)
         {
           svn_stringbuf_t *item;
-          revision_info_t *info;
           svn_fs_fs__p2l_entry_t *entry
             = &APR_ARRAY_IDX(entries, i, svn_fs_fs__p2l_entry_t);
+          int rev_idx = (int)(entry->item.revision - base);
 
           /* skip bits we previously processed */
           if (i == 0 && entry->offset < offset)
@@ -1070,20 +1152,27 @@ read_log_rev_or_packfile(query_t *query,
             continue;
 
           /* read and process interesting items */
-          info = APR_ARRAY_IDX(query->revisions, entry->item.revision,
-                               revision_info_t*);
-
           if (entry->type == SVN_FS_FS__ITEM_TYPE_NODEREV)
             {
+              scanned_noderev_t *noderev
+                = apr_palloc(result_pool, sizeof(*noderev));
+
               SVN_ERR(read_item(&item, rev_file, entry, iterpool, iterpool));
-              SVN_ERR(read_noderev(query, item, info, result_pool, iterpool));
+              SVN_ERR(parse_noderev(&noderev->noderev, fs, item,
+                                    result_pool, iterpool));
+              noderev->revision = entry->item.revision;
+              noderev->size = item->len;
+
+              APR_ARRAY_PUSH(result->noderevs, scanned_noderev_t *)
+                = noderev;
             }
           else if (entry->type == SVN_FS_FS__ITEM_TYPE_CHANGES)
             {
+              SVN_ERR_ASSERT(rev_idx >= 0 && rev_idx < count);
               SVN_ERR(read_item(&item, rev_file, entry, iterpool, iterpool));
-              info->change_count
+              result->change_counts[rev_idx]
                 = get_log_change_count(item->data + 0, item->len);
-              info->changes_len += entry->size;
+              result->changes_lens[rev_idx] += entry->size;
             }
           else if (   (entry->type == SVN_FS_FS__ITEM_TYPE_FILE_REP)
                    || (entry->type == SVN_FS_FS__ITEM_TYPE_DIR_REP)
@@ -1092,7 +1181,7 @@ read_log_rev_or_packfile(query_t *query,
             {
               /* Collect the delta chain link. */
               svn_fs_fs__rep_header_t *header;
-              rep_ref_t *ref = apr_pcalloc(scratch_pool, sizeof(*ref));
+              rep_ref_t *ref = apr_pcalloc(result_pool, sizeof(*ref));
 
               SVN_ERR(svn_io_file_aligned_seek(rev_file->file,
                                                rev_file->block_size,
@@ -1117,7 +1206,7 @@ read_log_rev_or_packfile(query_t *query,
                   ref->base_revision = SVN_INVALID_REVNUM;
                 }
 
-              APR_ARRAY_PUSH(rep_refs, rep_ref_t *) = ref;
+              APR_ARRAY_PUSH(result->rep_refs, rep_ref_t *) = ref;
             }
 
           /* advance offset */
@@ -1125,15 +1214,111 @@ read_log_rev_or_packfile(query_t *query,
         }
     }
 
+  /* clean up and close file handles */
+  svn_pool_destroy(iterpool);
+
+  *scanned = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the rev / pack file contents in SCANNED to QUERY.  All revisions
+ * before SCANNED->BASE must already have been added.
+ *
+ * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
+ * temporaries.
+ */
+static svn_error_t *
+add_scanned_file(query_t *query,
+                 scanned_file_t *scanned,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  /* we will process every revision in the rev / pack file */
+  for (i = 0; i < scanned->count; ++i)
+    {
+      /* create the revision info for the current rev */
+      revision_info_t *info = apr_pcalloc(result_pool, sizeof(*info));
+      info->representations = apr_array_make(result_pool, 4,
+                                             sizeof(rep_stats_t*));
+      info->revision = scanned->base + i;
+      info->change_count = scanned->change_counts[i];
+      info->changes_len = scanned->changes_lens[i];
+
+      APR_ARRAY_PUSH(query->revisions, revision_info_t*) = info;
+    }
+
+  /* record the whole pack size in the first rev so the total sum will
+     still be correct */
+  APR_ARRAY_IDX(query->revisions, scanned->base, revision_info_t*)->end
+    = scanned->max_offset;
+
+  /* process the noderevs in the order they were found in the file */
+  for (i = 0; i < scanned->noderevs->nelts; ++i)
+    {
+      scanned_noderev_t *noderev
+        = APR_ARRAY_IDX(scanned->noderevs, i, scanned_noderev_t *);
+      revision_info_t *info
+        = APR_ARRAY_IDX(query->revisions, noderev->revision,
+                        revision_info_t*);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(process_noderev(query, noderev->noderev, noderev->size, info,
+                              result_pool, iterpool));
+    }
+
   /* Resolve the delta chain links. */
-  SVN_ERR(resolve_representation_refs(query, rep_refs));
+  SVN_ERR(resolve_representation_refs(query, scanned->rep_refs));
 
-  /* clean up and close file handles */
   svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
 
+/* Report progress in QUERY after the rev / pack file starting at REVISION
+ * has been processed.  Use SCRATCH_POOL for temporary allocations.
+ */
+static void
+notify_log_progress(query_t *query,
+                    svn_revnum_t revision,
+                    apr_pool_t *scratch_pool)
+{
+  /* show progress for every pack file and every 1000 revs or so */
+  if (query->progress_func)
+    {
+      if (query->shard_size && (revision % query->shard_size == 0))
+        query->progress_func(revision, query->progress_baton, scratch_pool);
+      if (!query->shard_size && (revision % 1000 == 0))
+        query->progress_func(revision, query->progress_baton, scratch_pool);
+    }
+}
+
+/* Process the logically addressed revision contents of revisions BASE to
+ * BASE + COUNT - 1 in QUERY.
+ *
+ * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
+ * temporaries.
+ */
+static svn_error_t *
+read_log_rev_or_packfile(query_t *query,
+                         svn_revnum_t base,
+                         int count,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  scanned_file_t *scanned;
+
+  SVN_ERR(scan_log_rev_or_packfile(&scanned, query->fs, base, count,
+                                   query->cancel_func, query->cancel_baton,
+                                   scratch_pool, scratch_pool));
+  SVN_ERR(add_scanned_file(query, scanned, result_pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Read the content of the pack file staring at revision BASE logical
  * addressing mode and store it in QUERY.
  *
@@ -1150,8 +1335,7 @@ read_log_pack_file(query_t *query,
                                    result_pool, scratch_pool));
 
   /* one more pack file processed */
-  if (query->progress_func)
-    query->progress_func(base, query->progress_baton, scratch_pool);
+  notify_log_progress(query, base, scratch_pool);
 
   return SVN_NO_ERROR;
 }
@@ -1172,17 +1356,150 @@ read_log_revision_file(query_t *query,
                                    result_pool, scratch_pool));
 
   /* show progress every 1000 revs or so */
-  if (query->progress_func)
+  notify_log_progress(query, revision, scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton type used while scanning the rev / pack files concurrently. */
+typedef struct scan_concurrently_baton_t
+{
+  /* The query to add the scanned contents to. */
+  query_t *query;
+
+  /* Number of pack files, i.e. the first work items.  All further items
+   * are non-packed revisions. */
+  int pack_count;
+
+  /* Pool for persistent allocations in QUERY. */
+  apr_pool_t *result_pool;
+} scan_concurrently_baton_t;
+
+/* Set *BASE and *COUNT to the first revision and the number of revisions
+ * in the rev / pack file processed by the work item with the given INDEX
+ * in BATON. */
+static void
+get_item_range(svn_revnum_t *base,
+               int *count,
+               const scan_concurrently_baton_t *baton,
+               int index)
+{
+  const query_t *query = baton->query;
+
+  if (index < baton->pack_count)
     {
-      if (query->shard_size && (revision % query->shard_size == 0))
-        query->progress_func(revision, query->progress_baton, scratch_pool);
-      if (!query->shard_size && (revision % 1000 == 0))
-        query->progress_func(revision, query->progress_baton, scratch_pool);
+      *base = (svn_revnum_t)index * query->shard_size;
+      *count = query->shard_size;
+    }
+  else
+    {
+      *base = query->min_unpacked_rev + (index - baton->pack_count);
+      *count = 1;
     }
+}
+
+/* Implements svn_task__thread_context_constructor_t.
+ * Open a separate instance of the filesystem in the query given by the
+ * scan_concurrently_baton_t in CONTEXT_BATON, such that each thread can
+ * use its own, non-thread-safe caches. */
+static svn_error_t *
+open_worker_fs(void **thread_context,
+               void *context_baton,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  scan_concurrently_baton_t *baton = context_baton;
+  svn_fs_t *worker_fs;
+
+  SVN_ERR(svn_fs_fs__open_instance(&worker_fs, baton->query->fs,
+                                   result_pool, scratch_pool));
+  *thread_context = worker_fs;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.
+ * Scan the rev / pack file for the work item with the given INDEX using
+ * the filesystem instance in THREAD_CONTEXT. */
+static svn_error_t *
+scan_file_item(void **result,
+               int index,
+               void *process_baton,
+               void *thread_context,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  scan_concurrently_baton_t *baton = process_baton;
+  svn_fs_t *worker_fs = thread_context;
+  scanned_file_t *scanned;
+  svn_revnum_t base;
+  int count;
+
+  get_item_range(&base, &count, baton, index);
+  SVN_ERR(scan_log_rev_or_packfile(&scanned, worker_fs, base, count,
+                                   cancel_func, cancel_baton,
+                                   result_pool, scratch_pool));
+  *result = scanned;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.
+ * Add the scanned file contents in RESULT to the query and report
+ * progress in the same way as the sequential code would. */
+static svn_error_t *
+add_file_item(void *result,
+              int index,
+              void *output_baton,
+              svn_cancel_func_t cancel_func,
+              void *cancel_baton,
+              apr_pool_t *scratch_pool)
+{
+  scan_concurrently_baton_t *baton = output_baton;
+  scanned_file_t *scanned = result;
+
+  SVN_ERR(add_scanned_file(baton->query, scanned, baton->result_pool,
+                           scratch_pool));
+  notify_log_progress(baton->query, scanned->base, scratch_pool);
 
   return SVN_NO_ERROR;
 }
 
+/* Like the log. addressing part of read_revisions() but scan the rev /
+ * pack files using up to JOBS concurrent threads.  Their contents are
+ * being added to QUERY strictly in revision order, so the results are
+ * identical to the sequential scan.
+ *
+ * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
+ * temporaries.
+ */
+static svn_error_t *
+read_log_revisions_concurrently(query_t *query,
+                                int jobs,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool)
+{
+  scan_concurrently_baton_t baton;
+  svn_revnum_t item_count;
+
+  baton.query = query;
+  baton.pack_count = (int)(query->min_unpacked_rev / query->shard_size);
+  baton.result_pool = result_pool;
+
+  item_count = baton.pack_count + query->head - query->min_unpacked_rev + 1;
+  SVN_ERR_ASSERT(item_count <= INT_MAX);
+
+  return svn_error_trace(svn_task__run(jobs, (int)item_count,
+                                       scan_file_item, &baton,
+                                       add_file_item, &baton,
+                                       open_worker_fs, &baton,
+                                       query->cancel_func,
+                                       query->cancel_baton,
+                                       scratch_pool));
+}
+
 /* Read the repository and collect the stats info in QUERY.
  *
  * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
@@ -1193,10 +1510,24 @@ read_revisions(query_t *query,
                apr_pool_t *result_pool,
                apr_pool_t *scratch_pool)
 {
-  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_pool_t *iterpool;
   svn_revnum_t revision;
 
+  /* Only the scan of log. addressed rev / pack files can be distributed
+   * over several threads.  Worker threads use their own FS instances but
+   * share the global cache.  So, we can only go concurrent if the latter
+   * allows for it. */
+  if (   query->jobs > 1
+      && query->shard_size > 0
+      && svn_fs_fs__use_log_addressing(query->fs)
+      && !svn_cache_config_get()->single_threaded)
+    return svn_error_trace(read_log_revisions_concurrently(query,
+                                                           query->jobs,
+                                                           result_pool,
+                                                           scratch_pool));
+
   /* read all packed revs */
+  iterpool = svn_pool_create(scratch_pool);
   for ( revision = 0
       ; revision < query->min_unpacked_rev
       ; revision += query->shard_size)
@@ -1258,13 +1589,16 @@ add_rep_stats(svn_fs_fs__representation_stats_t *stats,
 }
 
 /* Aggregate the info the in revision_info_t * array REVISIONS into the
- * respectve fields of STATS.
+ * respectve fields of STATS.  SHARD_SIZE is the number of revisions per
+ * shard and 0 for non-sharded repositories.
  */
 static void
 aggregate_stats(const apr_array_header_t *revisions,
+                int shard_size,
                 svn_fs_fs__stats_t *stats)
 {
   int i, k;
+  svn_fs_fs__shard_stats_t *shard = NULL;
 
   /* aggregate info from all revisions */
   stats->revision_count = revisions->nelts;
@@ -1273,6 +1607,22 @@ aggregate_stats(const apr_array_header_t *revisions,
       revision_info_t *revision = APR_ARRAY_IDX(revisions, i,
                                                 revision_info_t *);
 
+      /* start a new shard summary, if necessary.  Non-sharded
+       * repositories are summarized as a single shard. */
+      if (!shard || (shard_size && i % shard_size == 0))
+        {
+          shard = apr_pcalloc(stats->shards->pool, sizeof(*shard));
+          shard->first_revision = revision->revision;
+          APR_ARRAY_PUSH(stats->shards, svn_fs_fs__shard_stats_t *) = shard;
+        }
+
+      shard->revision_count++;
+      shard->total_size += revision->end - revision->offset;
+      shard->change_count += revision->change_count;
+      shard->noderev_count += revision->dir_noderev_count
+                            + revision->file_noderev_count;
+      shard->rep_count += revision->representations->nelts;
+
       /* data gathered on a revision level */
       stats->change_count += revision->change_count;
       stats->change_len += revision->changes_len;
@@ -1313,6 +1663,9 @@ aggregate_stats(const apr_array_header_t *revisions,
             }
 
           add_rep_stats(&stats->total_rep_stats, rep);
+          add_to_histogram(&stats->chain_length_histogram,
+                           rep->chain_length);
+          shard->rep_size += rep->size;
         }
     }
 }
@@ -1326,18 +1679,21 @@ create_stats(apr_pool_t *result_pool)
 
   initialize_largest_changes(stats, 64, result_pool);
   stats->by_extension = apr_hash_make(result_pool);
+  stats->shards = apr_array_make(result_pool, 16,
+                                 sizeof(svn_fs_fs__shard_stats_t *));
 
   return stats;
 }
 
-/* Create a *QUERY, allocated in RESULT_POOL, reading filesystem FS and
- * collecting results in STATS.  Store the optional PROCESS_FUNC and
- * PROGRESS_BATON as well as CANCEL_FUNC and CANCEL_BATON in *QUERY, too.
- * Use SCRATCH_POOL for temporary allocations.
+/* Create a *QUERY, allocated in RESULT_POOL, reading filesystem FS with
+ * up to JOBS threads and collecting results in STATS.  Store the optional
+ * PROCESS_FUNC and PROGRESS_BATON as well as CANCEL_FUNC and CANCEL_BATON
+ * in *QUERY, too.  Use SCRATCH_POOL for temporary allocations.
  */
 static svn_error_t *
 create_query(query_t **query,
              svn_fs_t *fs,
+             int jobs,
              svn_fs_fs__stats_t *stats,
              svn_fs_progress_notify_func_t progress_func,
              void *progress_baton,
@@ -1372,6 +1728,7 @@ create_query(query_t **query,
   (*query)->progress_baton = progress_baton;
   (*query)->cancel_func = cancel_func;
   (*query)->cancel_baton = cancel_baton;
+  (*query)->jobs = jobs;
 
   return SVN_NO_ERROR;
 }
@@ -1379,6 +1736,7 @@ create_query(query_t **query,
 svn_error_t *
 svn_fs_fs__get_stats(svn_fs_fs__stats_t **stats,
                      svn_fs_t *fs,
+                     int jobs,
                      svn_fs_progress_notify_func_t progress_func,
                      void *progress_baton,
                      svn_cancel_func_t cancel_func,
@@ -1389,11 +1747,11 @@ svn_fs_fs__get_stats(svn_fs_fs__stats_t **stats,
   query_t *query;
 
   *stats = create_stats(result_pool);
-  SVN_ERR(create_query(&query, fs, *stats, progress_func, progress_baton,
-                       cancel_func, cancel_baton, scratch_pool,
-                       scratch_pool));
+  SVN_ERR(create_query(&query, fs, jobs, *stats, progress_func,
+                       progress_baton, cancel_func, cancel_baton,
+                       scratch_pool, scratch_pool));
   SVN_ERR(read_revisions(query, scratch_pool, scratch_pool));
-  aggregate_stats(query->revisions, *stats);
+  aggregate_stats(query->revisions, query->shard_size, *stats);
 
   return SVN_NO_ERROR;
 }
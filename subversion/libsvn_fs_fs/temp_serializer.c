@@ -787,6 +787,36 @@ svn_fs_fs__deserialize_node_revision(void **item,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__extract_noderev_header(void **out,
+                                  const void *data,
+                                  apr_size_t data_len,
+                                  void *baton,
+                                  apr_pool_t *pool)
+{
+  const node_revision_t *noderev = data;
+  svn_fs_fs__noderev_header_t *header = baton;
+
+  /* The ID structs contain no pointers that we would use, so we can
+   * read the revision directly from the serialized data. */
+  const svn_fs_id_t *predecessor_id
+    = svn_temp_deserializer__ptr(noderev,
+                                 (const void *const *)&noderev->predecessor_id);
+
+  header->kind = noderev->kind;
+  header->predecessor_rev = predecessor_id
+                          ? svn_fs_fs__id_rev(predecessor_id)
+                          : SVN_INVALID_REVNUM;
+  header->predecessor_count = noderev->predecessor_count;
+  header->copyfrom_rev = noderev->copyfrom_rev;
+  header->copyroot_rev = noderev->copyroot_rev;
+  header->mergeinfo_count = noderev->mergeinfo_count;
+  header->has_mergeinfo = noderev->has_mergeinfo;
+
+  *out = header;
+  return SVN_NO_ERROR;
+}
+
 /* Utility function that returns the directory serialized inside CONTEXT
  * to DATA and DATA_LEN.  If OVERPROVISION is set, allocate some extra
  * room for future in-place changes by svn_fs_fs__replace_dir_entry. */
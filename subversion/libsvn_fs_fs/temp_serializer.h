@@ -214,6 +214,19 @@ svn_fs_fs__deserialize_node_revision(void **item,
                                      apr_size_t buffer_size,
                                      apr_pool_t *pool);
 
+/**
+ * Implements #svn_cache__partial_getter_func_t for #node_revision_t.
+ * Fill the #svn_fs_fs__noderev_header_t given in @a baton directly from
+ * the serialized node revision in @a data of @a data_len and set @a *out
+ * to @a baton.  Nothing will be allocated.
+ */
+svn_error_t *
+svn_fs_fs__extract_noderev_header(void **out,
+                                  const void *data,
+                                  apr_size_t data_len,
+                                  void *baton,
+                                  apr_pool_t *pool);
+
 /**
  * Implements #svn_cache__serialize_func_t for a #svn_fs_fs__dir_data_t
  */
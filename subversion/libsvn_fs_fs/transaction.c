@@ -41,8 +41,12 @@
 #include "temp_serializer.h"
 #include "cached_data.h"
 #include "lock.h"
+#include "date-index.h"
+#include "path-index.h"
 #include "rep-cache.h"
 
+#include "private/svn_batch_fsync.h"
+#include "private/svn_delta_private.h"
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
 #include "private/svn_sorts_private.h"
@@ -209,7 +213,10 @@ free_shared_txn(svn_fs_t *fs, const svn_fs_fs__id_part_t *txn_id)
 
 /* Obtain a lock on the transaction list of filesystem FS, call BODY
    with FS, BATON, and POOL, and then unlock the transaction list.
-   Return what BODY returned. */
+   Return what BODY returned.
+
+   The time spent waiting for the lock is being added to the lock
+   statistics in FS's shared data.  BODY should not do any I/O. */
 static svn_error_t *
 with_txnlist_lock(svn_fs_t *fs,
                   svn_error_t *(*body)(svn_fs_t *fs,
@@ -220,52 +227,83 @@ with_txnlist_lock(svn_fs_t *fs,
 {
   fs_fs_data_t *ffd = fs->fsap_data;
   fs_fs_shared_data_t *ffsd = ffd->shared;
+  apr_time_t start = apr_time_now();
+  apr_interval_time_t wait;
 
-  SVN_MUTEX__WITH_LOCK(ffsd->txn_list_lock,
-                       body(fs, baton, pool));
+  SVN_ERR(svn_mutex__lock(ffsd->txn_list_lock));
 
-  return SVN_NO_ERROR;
-}
+  /* The statistics are protected by the lock we just acquired. */
+  wait = apr_time_now() - start;
+  ffsd->txn_list_lock_count++;
+  ffsd->txn_list_lock_wait_time += wait;
+  if (wait > ffsd->txn_list_lock_max_wait_time)
+    ffsd->txn_list_lock_max_wait_time = wait;
 
+  return svn_error_trace(svn_mutex__unlock(ffsd->txn_list_lock,
+                                           body(fs, baton, pool)));
+}
 
-/* A structure used by unlock_proto_rev() and unlock_proto_rev_body(),
-   which see. */
-struct unlock_proto_rev_baton
+/* Baton type used by svn_fs_fs__get_txn_list_lock_stats(). */
+struct txn_list_lock_stats_baton_t
 {
-  svn_fs_fs__id_part_t txn_id;
-  void *lockcookie;
+  apr_uint64_t *count;
+  apr_interval_time_t *wait_time;
+  apr_interval_time_t *max_wait_time;
 };
 
-/* Callback used in the implementation of unlock_proto_rev(). */
+/* Callback used in the implementation of
+   svn_fs_fs__get_txn_list_lock_stats().  BATON is a
+   struct txn_list_lock_stats_baton_t *. */
+static svn_error_t *
+get_txn_list_lock_stats_body(svn_fs_t *fs,
+                             const void *baton,
+                             apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const struct txn_list_lock_stats_baton_t *b = baton;
+
+  /* Don't count our own acquisition. */
+  *b->count = ffd->shared->txn_list_lock_count - 1;
+  *b->wait_time = ffd->shared->txn_list_lock_wait_time;
+  *b->max_wait_time = ffd->shared->txn_list_lock_max_wait_time;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__get_txn_list_lock_stats(apr_uint64_t *count,
+                                   apr_interval_time_t *wait_time,
+                                   apr_interval_time_t *max_wait_time,
+                                   svn_fs_t *fs,
+                                   apr_pool_t *scratch_pool)
+{
+  struct txn_list_lock_stats_baton_t b;
+
+  b.count = count;
+  b.wait_time = wait_time;
+  b.max_wait_time = max_wait_time;
+
+  return svn_error_trace(with_txnlist_lock(fs, get_txn_list_lock_stats_body,
+                                           &b, scratch_pool));
+}
+
+
+/* Callback used in the implementation of unlock_proto_rev().
+   BATON is the svn_fs_fs__id_part_t of the transaction. */
 static svn_error_t *
 unlock_proto_rev_body(svn_fs_t *fs, const void *baton, apr_pool_t *pool)
 {
-  const struct unlock_proto_rev_baton *b = baton;
-  apr_file_t *lockfile = b->lockcookie;
-  fs_fs_shared_txn_data_t *txn = get_shared_txn(fs, &b->txn_id, FALSE);
-  apr_status_t apr_err;
+  const svn_fs_fs__id_part_t *txn_id = baton;
+  fs_fs_shared_txn_data_t *txn = get_shared_txn(fs, txn_id, FALSE);
 
   if (!txn)
     return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
                              _("Can't unlock unknown transaction '%s'"),
-                             svn_fs_fs__id_txn_unparse(&b->txn_id, pool));
+                             svn_fs_fs__id_txn_unparse(txn_id, pool));
   if (!txn->being_written)
     return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
                              _("Can't unlock nonlocked transaction '%s'"),
-                             svn_fs_fs__id_txn_unparse(&b->txn_id, pool));
-
-  apr_err = apr_file_unlock(lockfile);
-  if (apr_err)
-    return svn_error_wrap_apr
-      (apr_err,
-       _("Can't unlock prototype revision lockfile for transaction '%s'"),
-       svn_fs_fs__id_txn_unparse(&b->txn_id, pool));
-  apr_err = apr_file_close(lockfile);
-  if (apr_err)
-    return svn_error_wrap_apr
-      (apr_err,
-       _("Can't close prototype revision lockfile for transaction '%s'"),
-       svn_fs_fs__id_txn_unparse(&b->txn_id, pool));
+                             svn_fs_fs__id_txn_unparse(txn_id, pool));
 
   txn->being_written = FALSE;
 
@@ -283,30 +321,42 @@ unlock_proto_rev(svn_fs_t *fs,
                  void *lockcookie,
                  apr_pool_t *pool)
 {
-  struct unlock_proto_rev_baton b;
+  apr_file_t *lockfile = lockcookie;
+  apr_status_t apr_err;
+  svn_error_t *err = SVN_NO_ERROR;
 
-  b.txn_id = *txn_id;
-  b.lockcookie = lockcookie;
-  return with_txnlist_lock(fs, unlock_proto_rev_body, &b, pool);
-}
+  /* Release the file lock before clearing the BEING_WRITTEN flag.
+     Otherwise, another thread in this process might try to lock the
+     file while we still hold it and report it as being written by
+     another process.  Only the flag requires the txn list lock. */
+  apr_err = apr_file_unlock(lockfile);
+  if (apr_err)
+    err = svn_error_wrap_apr
+      (apr_err,
+       _("Can't unlock prototype revision lockfile for transaction '%s'"),
+       svn_fs_fs__id_txn_unparse(txn_id, pool));
 
-/* A structure used by get_writable_proto_rev() and
-   get_writable_proto_rev_body(), which see. */
-struct get_writable_proto_rev_baton
-{
-  void **lockcookie;
-  svn_fs_fs__id_part_t txn_id;
-};
+  apr_err = apr_file_close(lockfile);
+  if (apr_err && !err)
+    err = svn_error_wrap_apr
+      (apr_err,
+       _("Can't close prototype revision lockfile for transaction '%s'"),
+       svn_fs_fs__id_txn_unparse(txn_id, pool));
+
+  return svn_error_compose_create(err,
+                                  with_txnlist_lock(fs, unlock_proto_rev_body,
+                                                    txn_id, pool));
+}
 
-/* Callback used in the implementation of get_writable_proto_rev(). */
+/* Callback used in the implementation of get_writable_proto_rev().
+   BATON is the svn_fs_fs__id_part_t of the transaction. */
 static svn_error_t *
 get_writable_proto_rev_body(svn_fs_t *fs, const void *baton, apr_pool_t *pool)
 {
-  const struct get_writable_proto_rev_baton *b = baton;
-  void **lockcookie = b->lockcookie;
-  fs_fs_shared_txn_data_t *txn = get_shared_txn(fs, &b->txn_id, TRUE);
+  const svn_fs_fs__id_part_t *txn_id = baton;
+  fs_fs_shared_txn_data_t *txn = get_shared_txn(fs, txn_id, TRUE);
 
-  /* First, ensure that no thread in this process (including this one)
+  /* Ensure that no thread in this process (including this one)
      is currently writing to this transaction's proto-rev file. */
   if (txn->being_written)
     return svn_error_createf(SVN_ERR_FS_REP_BEING_WRITTEN, NULL,
@@ -314,56 +364,64 @@ get_writable_proto_rev_body(svn_fs_t *fs, const void *baton, apr_pool_t *pool)
                                "of transaction '%s' because a previous "
                                "representation is currently being written by "
                                "this process"),
-                             svn_fs_fs__id_txn_unparse(&b->txn_id, pool));
+                             svn_fs_fs__id_txn_unparse(txn_id, pool));
 
+  /* Claim the proto-rev file for this thread.  All further checks
+     involve I/O and will be done without holding the txn list lock. */
+  txn->being_written = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Lock the prototype revision lock file for transaction TXN_ID in
+   filesystem FS and return the open lock file in *LOCKFILE.  The caller
+   must have claimed the proto-rev file for the current thread.
+   Perform all allocations in POOL. */
+static svn_error_t *
+lock_proto_rev_file(apr_file_t **lockfile,
+                    svn_fs_t *fs,
+                    const svn_fs_fs__id_part_t *txn_id,
+                    apr_pool_t *pool)
+{
+  apr_status_t apr_err;
+  const char *lockfile_path
+    = svn_fs_fs__path_txn_proto_rev_lock(fs, txn_id, pool);
 
   /* We know that no thread in this process is writing to the proto-rev
      file, and by extension, that no thread in this process is holding a
      lock on the prototype revision lock file.  It is therefore safe
      for us to attempt to lock this file, to see if any other process
-     is holding a lock. */
+     is holding a lock.
 
-  {
-    apr_file_t *lockfile;
-    apr_status_t apr_err;
-    const char *lockfile_path
-      = svn_fs_fs__path_txn_proto_rev_lock(fs, &b->txn_id, pool);
-
-    /* Open the proto-rev lockfile, creating it if necessary, as it may
-       not exist if the transaction dates from before the lockfiles were
-       introduced.
-
-       ### We'd also like to use something like svn_io_file_lock2(), but
-           that forces us to create a subpool just to be able to unlock
-           the file, which seems a waste. */
-    SVN_ERR(svn_io_file_open(&lockfile, lockfile_path,
-                             APR_WRITE | APR_CREATE, APR_OS_DEFAULT, pool));
-
-    apr_err = apr_file_lock(lockfile,
-                            APR_FLOCK_EXCLUSIVE | APR_FLOCK_NONBLOCK);
-    if (apr_err)
-      {
-        svn_error_clear(svn_io_file_close(lockfile, pool));
-
-        if (APR_STATUS_IS_EAGAIN(apr_err))
-          return svn_error_createf(SVN_ERR_FS_REP_BEING_WRITTEN, NULL,
-                                   _("Cannot write to the prototype revision "
-                                     "file of transaction '%s' because a "
-                                     "previous representation is currently "
-                                     "being written by another process"),
-                                   svn_fs_fs__id_txn_unparse(&b->txn_id,
-                                                             pool));
-
-        return svn_error_wrap_apr(apr_err,
-                                  _("Can't get exclusive lock on file '%s'"),
-                                  svn_dirent_local_style(lockfile_path, pool));
-      }
-
-    *lockcookie = lockfile;
-  }
+     Open the proto-rev lockfile, creating it if necessary, as it may
+     not exist if the transaction dates from before the lockfiles were
+     introduced.
 
-  /* We've successfully locked the transaction; mark it as such. */
-  txn->being_written = TRUE;
+     ### We'd also like to use something like svn_io_file_lock2(), but
+         that forces us to create a subpool just to be able to unlock
+         the file, which seems a waste. */
+  SVN_ERR(svn_io_file_open(lockfile, lockfile_path,
+                           APR_WRITE | APR_CREATE, APR_OS_DEFAULT, pool));
+
+  apr_err = apr_file_lock(*lockfile,
+                          APR_FLOCK_EXCLUSIVE | APR_FLOCK_NONBLOCK);
+  if (apr_err)
+    {
+      svn_error_clear(svn_io_file_close(*lockfile, pool));
+      *lockfile = NULL;
+
+      if (APR_STATUS_IS_EAGAIN(apr_err))
+        return svn_error_createf(SVN_ERR_FS_REP_BEING_WRITTEN, NULL,
+                                 _("Cannot write to the prototype revision "
+                                   "file of transaction '%s' because a "
+                                   "previous representation is currently "
+                                   "being written by another process"),
+                                 svn_fs_fs__id_txn_unparse(txn_id, pool));
+
+      return svn_error_wrap_apr(apr_err,
+                                _("Can't get exclusive lock on file '%s'"),
+                                svn_dirent_local_style(lockfile_path, pool));
+    }
 
   return SVN_NO_ERROR;
 }
@@ -430,14 +488,22 @@ get_writable_proto_rev(apr_file_t **file,
                        const svn_fs_fs__id_part_t *txn_id,
                        apr_pool_t *pool)
 {
-  struct get_writable_proto_rev_baton b;
+  apr_file_t *lockfile;
   svn_error_t *err;
   apr_off_t end_offset = 0;
 
-  b.lockcookie = lockcookie;
-  b.txn_id = *txn_id;
+  SVN_ERR(with_txnlist_lock(fs, get_writable_proto_rev_body, txn_id, pool));
+
+  /* Now that this thread owns the proto-rev file, check for other
+     processes.  On failure, give up our claim. */
+  err = lock_proto_rev_file(&lockfile, fs, txn_id, pool);
+  if (err)
+    return svn_error_compose_create(err,
+                                    with_txnlist_lock(fs,
+                                                      unlock_proto_rev_body,
+                                                      txn_id, pool));
 
-  SVN_ERR(with_txnlist_lock(fs, get_writable_proto_rev_body, &b, pool));
+  *lockcookie = lockfile;
 
   /* Now open the prototype revision file and seek to the end. */
   err = svn_io_file_open(file,
@@ -1902,6 +1968,167 @@ fnv1a_checksum_finalize(apr_uint32_t *digest,
   return SVN_NO_ERROR;
 }
 
+/* Content-defined chunking of file contents.
+ *
+ * Chunk boundaries are determined by a "gear" rolling hash over the last
+ * 64 bytes.  Therefore, local changes only affect the chunks close to
+ * them and the other chunks will be found again in the modified contents,
+ * regardless of any shift in their position.  Only a sample of the chunks
+ * gets recorded in the chunk index in the rep-cache database.
+ */
+
+/* Chunk size limits.  The average chunk size is about CHUNK_MIN_SIZE plus
+ * 2^CHUNK_BOUNDARY_BITS bytes. */
+#define CHUNK_MIN_SIZE      0x1000
+#define CHUNK_MAX_SIZE      0x10000
+#define CHUNK_BOUNDARY_BITS 14
+
+/* Only chunks whose content hash has none of these bits set are used.
+ * That limits the index to about 1 entry per 160kB of contents. */
+#define CHUNK_SAMPLE_MASK   0x7
+
+/* The delta base gets chosen after this many bytes of contents. */
+#define CHUNK_PREFIX_SIZE   0x400000
+
+/* The minimum number of sampled chunks that a representation must share
+ * with the new contents to be considered as delta base. */
+#define CHUNK_MIN_MATCHES   2
+
+/* Content-defined chunking state for a file representation being
+ * written. */
+typedef struct chunker_t
+{
+  /* Gear hash over the current chunk's data. */
+  apr_uint64_t gear;
+
+  /* Number of bytes in the current chunk so far. */
+  apr_size_t chunk_len;
+
+  /* Checksum context for the current chunk's data. */
+  svn_checksum_ctx_t *checksum_ctx;
+
+  /* Hashes of all sampled chunks so far, as apr_uint64_t. */
+  apr_array_header_t *hashes;
+
+  /* Pool for checksum results, cleared after each chunk. */
+  apr_pool_t *iterpool;
+} chunker_t;
+
+/* Return a new chunker allocated in RESULT_POOL. */
+static chunker_t *
+chunker_create(apr_pool_t *result_pool)
+{
+  chunker_t *chunker = apr_pcalloc(result_pool, sizeof(*chunker));
+
+  chunker->checksum_ctx = svn_checksum_ctx_create(svn_checksum_fnv1a_32x4,
+                                                  result_pool);
+  chunker->hashes = apr_array_make(result_pool, 16, sizeof(apr_uint64_t));
+  chunker->iterpool = svn_pool_create(result_pool);
+
+  return chunker;
+}
+
+/* Return the pseudo-random value that the gear hash adds for byte C. */
+static APR_INLINE apr_uint64_t
+gear_value(unsigned char c)
+{
+  apr_uint64_t value = (c + 1) * APR_UINT64_C(0x9e3779b97f4a7c15);
+  return value ^ (value >> 29);
+}
+
+/* Finalize the current chunk in CHUNKER and record it if it has been
+ * sampled. */
+static svn_error_t *
+chunker_end_chunk(chunker_t *chunker)
+{
+  svn_checksum_t *checksum;
+  apr_uint32_t digest;
+
+  SVN_ERR(svn_checksum_final(&checksum, chunker->checksum_ctx,
+                             chunker->iterpool));
+  memcpy(&digest, checksum->digest, sizeof(digest));
+
+  /* Combining the hash with the chunk length makes collisions less
+   * likely.  Those would only result in less suitable delta bases. */
+  if ((digest & CHUNK_SAMPLE_MASK) == 0)
+    APR_ARRAY_PUSH(chunker->hashes, apr_uint64_t)
+      = ((apr_uint64_t)digest << 32) | chunker->chunk_len;
+
+  SVN_ERR(svn_checksum_ctx_reset(chunker->checksum_ctx));
+  svn_pool_clear(chunker->iterpool);
+  chunker->gear = 0;
+  chunker->chunk_len = 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Feed the LEN bytes at DATA to CHUNKER. */
+static svn_error_t *
+chunker_update(chunker_t *chunker,
+               const char *data,
+               apr_size_t len)
+{
+  const char *end = data + len;
+
+  while (data < end)
+    {
+      apr_size_t to_scan;
+      apr_size_t i;
+      apr_uint64_t gear = chunker->gear;
+      const unsigned char *p = (const unsigned char *)data;
+      svn_boolean_t at_boundary = FALSE;
+
+      /* The gear hash only depends on the last 64 bytes, so there is no
+       * need to calculate it well before reaching CHUNK_MIN_SIZE. */
+      if (chunker->chunk_len < CHUNK_MIN_SIZE - 64)
+        {
+          apr_size_t to_skip = MIN((apr_size_t)(end - data),
+                                   CHUNK_MIN_SIZE - 64 - chunker->chunk_len);
+          SVN_ERR(svn_checksum_update(chunker->checksum_ctx, data, to_skip));
+          chunker->chunk_len += to_skip;
+          data += to_skip;
+          continue;
+        }
+
+      /* Hash the data up to CHUNK_MIN_SIZE without looking for a boundary.
+       * After that, stop at the first boundary or at CHUNK_MAX_SIZE. */
+      to_scan = MIN((apr_size_t)(end - data), CHUNK_MAX_SIZE - chunker->chunk_len);
+      for (i = 0; i < to_scan && chunker->chunk_len + i < CHUNK_MIN_SIZE; ++i)
+        gear = (gear << 1) + gear_value(p[i]);
+
+      for (; i < to_scan; ++i)
+        {
+          gear = (gear << 1) + gear_value(p[i]);
+          if ((gear >> (64 - CHUNK_BOUNDARY_BITS)) == 0)
+            {
+              at_boundary = TRUE;
+              ++i;
+              break;
+            }
+        }
+
+      SVN_ERR(svn_checksum_update(chunker->checksum_ctx, data, i));
+      chunker->gear = gear;
+      chunker->chunk_len += i;
+      data += i;
+
+      if (at_boundary || chunker->chunk_len == CHUNK_MAX_SIZE)
+        SVN_ERR(chunker_end_chunk(chunker));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Finalize the last chunk in CHUNKER, if there is one. */
+static svn_error_t *
+chunker_close(chunker_t *chunker)
+{
+  if (chunker->chunk_len)
+    SVN_ERR(chunker_end_chunk(chunker));
+
+  return SVN_NO_ERROR;
+}
+
 /* This baton is used by the representation writing streams.  It keeps
    track of the checksum information as well as the total size of the
    representation so far. */
@@ -1941,6 +2168,13 @@ struct rep_write_baton
   /* calculate a modified FNV-1a checksum of the on-disk representation */
   svn_checksum_ctx_t *fnv1a_checksum_ctx;
 
+  /* Content-defined chunking state.  NULL if disabled. */
+  chunker_t *chunker;
+
+  /* If not NULL, the delta base has not been chosen yet and the contents
+     are being collected here instead of being written to DELTA_STREAM. */
+  svn_stringbuf_t *prefix;
+
   /* Local / scratch pool, available for temporary allocations. */
   apr_pool_t *scratch_pool;
 
@@ -1948,6 +2182,11 @@ struct rep_write_baton
   apr_pool_t *result_pool;
 };
 
+/* Choose the delta base for the contents collected in B->PREFIX, start
+   writing the delta and pass the collected data on.  Defined below. */
+static svn_error_t *
+flush_rep_prefix(struct rep_write_baton *b);
+
 /* Handler for the write method of the representation writable stream.
    BATON is a rep_write_baton, DATA is the data to write, and *LEN is
    the length of this data. */
@@ -1958,10 +2197,23 @@ rep_write_contents(void *baton,
 {
   struct rep_write_baton *b = baton;
 
-  SVN_ERR(svn_checksum_update(b->md5_checksum_ctx, data, *len));
-  SVN_ERR(svn_checksum_update(b->sha1_checksum_ctx, data, *len));
+  SVN_ERR(svn_checksum__update2(b->md5_checksum_ctx, b->sha1_checksum_ctx,
+                                data, *len));
   b->rep_size += *len;
 
+  if (b->chunker)
+    SVN_ERR(chunker_update(b->chunker, data, *len));
+
+  /* Still collecting the data to choose a delta base from? */
+  if (b->prefix)
+    {
+      svn_stringbuf_appendbytes(b->prefix, data, *len);
+      if (b->prefix->len < CHUNK_PREFIX_SIZE)
+        return SVN_NO_ERROR;
+
+      return svn_error_trace(flush_rep_prefix(b));
+    }
+
   /* If we are writing a delta, use that stream. */
   if (b->delta_stream)
     return svn_stream_write(b->delta_stream, data, len);
@@ -2005,6 +2257,60 @@ shards_spanned(int *spanned,
   return SVN_NO_ERROR;
 }
 
+/* Set *REP to NULL if it would not be a suitable delta base in FS, e.g.
+   because its delta chain is too long.  Perform temporary allocations
+   in POOL. */
+static svn_error_t *
+check_delta_base(representation_t **rep,
+                 svn_fs_t *fs,
+                 apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (*rep)
+    {
+      int chain_length = 0;
+      int shard_count = 0;
+      svn_filesize_t chain_size = 0;
+
+      /* Very short rep bases are simply not worth it as we are unlikely
+       * to re-coup the deltification space overhead of 20+ bytes. */
+      svn_filesize_t rep_size = (*rep)->expanded_size;
+      if (rep_size < 64)
+        {
+          *rep = NULL;
+          return SVN_NO_ERROR;
+        }
+
+      /* Check whether the length of the deltification chain is acceptable.
+       * Otherwise, shared reps may form a non-skipping delta chain in
+       * extreme cases. */
+      SVN_ERR(svn_fs_fs__rep_chain_length(&chain_length, &shard_count,
+                                          &chain_size, *rep, fs, pool));
+
+      /* Some reasonable limit, depending on how acceptable longer linear
+       * chains are in this repo.  Also, allow for some minimal chain. */
+      if (chain_length >= 2 * (int)ffd->max_linear_deltification + 2)
+        *rep = NULL;
+      /* Start a new delta chain if reconstructing the base would already
+       * require reading more data than configured. */
+      else if (   ffd->max_delta_chain_size
+               && chain_size > ffd->max_delta_chain_size)
+        *rep = NULL;
+      else
+        /* To make it worth opening additional shards / pack files, we
+         * require that the reps have a certain minimal size.  To deltify
+         * against a rep in different shard, the lower limit is 512 bytes
+         * and doubles with every extra shard to visit along the delta
+         * chain. */
+        if (   shard_count > 1
+            && ((svn_filesize_t)128 << shard_count) >= rep_size)
+          *rep = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Given a node-revision NODEREV in filesystem FS, return the
    representation in *REP to use as the base for a text representation
    delta if PROPS is FALSE.  If PROPS has been set, a suitable props
@@ -2088,42 +2394,7 @@ choose_delta_base(representation_t **rep,
 
   /* if we encountered a shared rep, its parent chain may be different
    * from the node-rev parent chain. */
-  if (*rep)
-    {
-      int chain_length = 0;
-      int shard_count = 0;
-
-      /* Very short rep bases are simply not worth it as we are unlikely
-       * to re-coup the deltification space overhead of 20+ bytes. */
-      svn_filesize_t rep_size = (*rep)->expanded_size;
-      if (rep_size < 64)
-        {
-          *rep = NULL;
-          return SVN_NO_ERROR;
-        }
-
-      /* Check whether the length of the deltification chain is acceptable.
-       * Otherwise, shared reps may form a non-skipping delta chain in
-       * extreme cases. */
-      SVN_ERR(svn_fs_fs__rep_chain_length(&chain_length, &shard_count,
-                                          *rep, fs, pool));
-
-      /* Some reasonable limit, depending on how acceptable longer linear
-       * chains are in this repo.  Also, allow for some minimal chain. */
-      if (chain_length >= 2 * (int)ffd->max_linear_deltification + 2)
-        *rep = NULL;
-      else
-        /* To make it worth opening additional shards / pack files, we
-         * require that the reps have a certain minimal size.  To deltify
-         * against a rep in different shard, the lower limit is 512 bytes
-         * and doubles with every extra shard to visit along the delta
-         * chain. */
-        if (   shard_count > 1
-            && ((svn_filesize_t)128 << shard_count) >= rep_size)
-          *rep = NULL;
-    }
-
-  return SVN_NO_ERROR;
+  return svn_error_trace(check_delta_base(rep, fs, pool));
 }
 
 /* Something went wrong and the pool for the rep write is being
@@ -2169,7 +2440,12 @@ txdelta_to_svndiff(svn_txdelta_window_handler_t *handler,
   fs_fs_data_t *ffd = fs->fsap_data;
   int svndiff_version;
 
-  if (ffd->delta_compression_type == compression_type_lz4)
+  if (ffd->delta_compression_type == compression_type_zstd)
+    {
+      SVN_ERR_ASSERT_NO_RETURN(ffd->format >= SVN_FS_FS__MIN_SVNDIFF3_FORMAT);
+      svndiff_version = 3;
+    }
+  else if (ffd->delta_compression_type == compression_type_lz4)
     {
       SVN_ERR_ASSERT_NO_RETURN(ffd->format >= SVN_FS_FS__MIN_SVNDIFF2_FORMAT);
       svndiff_version = 2;
@@ -2188,6 +2464,202 @@ txdelta_to_svndiff(svn_txdelta_window_handler_t *handler,
                           ffd->delta_compression_level, pool);
 }
 
+/* Pick a delta base for the contents being written through B based on
+   the chunk index.  Replace *BASE_REP, the default base chosen from the
+   node's history, with the representation that shares the most sampled
+   chunks with the beginning of the contents, if that looks like a much
+   better base.  Perform temporary allocations in SCRATCH_POOL.
+
+   The chunk index is only a hint, so errors reading it are ignored. */
+static svn_error_t *
+choose_chunk_delta_base(representation_t **base_rep,
+                        struct rep_write_baton *b,
+                        apr_pool_t *scratch_pool)
+{
+  const apr_array_header_t *hashes = b->chunker->hashes;
+  apr_hash_t *matches = apr_hash_make(scratch_pool);
+  svn_checksum_t *best = NULL;
+  int best_count = 0;
+  int default_count = 0;
+  representation_t *candidate;
+  svn_error_t *err;
+  int i;
+
+  /* Count the sampled chunks per representation that contains them. */
+  for (i = 0; i < hashes->nelts; ++i)
+    {
+      svn_checksum_t *sha1;
+      int *count;
+
+      err = svn_fs_fs__get_chunk_reference(&sha1, b->fs,
+                                           APR_ARRAY_IDX(hashes, i,
+                                                         apr_uint64_t),
+                                           scratch_pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          return SVN_NO_ERROR;
+        }
+
+      if (sha1 == NULL)
+        continue;
+
+      count = apr_hash_get(matches, sha1->digest, APR_SHA1_DIGESTSIZE);
+      if (count == NULL)
+        {
+          count = apr_pcalloc(scratch_pool, sizeof(*count));
+          apr_hash_set(matches, sha1->digest, APR_SHA1_DIGESTSIZE, count);
+        }
+
+      if (++*count > best_count)
+        {
+          best_count = *count;
+          best = sha1;
+        }
+    }
+
+  if (best_count < CHUNK_MIN_MATCHES)
+    return SVN_NO_ERROR;
+
+  /* Stick with the default base unless the best match is considerably
+     better.  That keeps the skip-delta scheme intact for the usual case
+     of small modifications to the same node. */
+  if (*base_rep && (*base_rep)->has_sha1)
+    {
+      int *count = apr_hash_get(matches, (*base_rep)->sha1_digest,
+                                APR_SHA1_DIGESTSIZE);
+      if (count)
+        default_count = *count;
+    }
+
+  if (2 * default_count >= best_count)
+    return SVN_NO_ERROR;
+
+  err = svn_fs_fs__get_rep_reference(&candidate, b->fs, best, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(check_delta_base(&candidate, b->fs, scratch_pool));
+  if (candidate)
+    *base_rep = candidate;
+
+  return SVN_NO_ERROR;
+}
+
+/* Contents of at least this size get written with the largest delta
+   windows that the repository format supports. */
+#define LARGE_CONTENTS_SIZE 0x400000
+
+/* Contents of less than this size get written with delta windows just
+   large enough to hold twice their size. */
+#define SMALL_CONTENTS_SIZE 0x8000
+
+/* Smallest delta window size that we use. */
+#define MIN_DELTA_WINDOW_SIZE 0x1000
+
+/* Return the size of the delta windows to use when writing contents of
+   about EXPECTED_SIZE bytes to FS.  A negative EXPECTED_SIZE means that
+   we have no idea.  0 selects the default window size. */
+static apr_size_t
+delta_window_size(svn_fs_t *fs,
+                  svn_filesize_t expected_size)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_size_t max_size
+    = ffd->format >= SVN_FS_FS__MIN_LARGE_DELTA_WINDOWS_FORMAT
+    ? 0x100000
+    : 102400;
+  apr_size_t window_size;
+
+  if (ffd->delta_window_size > 0)
+    return ffd->delta_window_size < (apr_int64_t)max_size
+         ? (apr_size_t)ffd->delta_window_size
+         : max_size;
+
+  if (expected_size >= LARGE_CONTENTS_SIZE)
+    return max_size;
+
+  if (expected_size < 0 || expected_size >= SMALL_CONTENTS_SIZE)
+    return 0;
+
+  /* Leave some room for growth, so the contents will still fit into a
+     single window. */
+  window_size = MIN_DELTA_WINDOW_SIZE;
+  while ((svn_filesize_t)window_size < 2 * expected_size)
+    window_size *= 2;
+
+  return window_size;
+}
+
+/* Write the header for a delta against BASE_REP to B's representation
+   and set up B->DELTA_STREAM to write the deltified contents.  The new
+   contents are expected to be about EXPECTED_SIZE bytes long or -1 if
+   unknown. */
+static svn_error_t *
+start_rep_delta(struct rep_write_baton *b,
+                representation_t *base_rep,
+                svn_filesize_t expected_size)
+{
+  svn_stream_t *source;
+  svn_txdelta_window_handler_t wh;
+  void *whb;
+  svn_fs_fs__rep_header_t header = { 0 };
+
+  SVN_ERR(svn_fs_fs__get_contents(&source, b->fs, base_rep, TRUE,
+                                  b->scratch_pool));
+
+  /* Write out the rep header. */
+  if (base_rep)
+    {
+      header.base_revision = base_rep->revision;
+      header.base_item_index = base_rep->item_index;
+      header.base_length = base_rep->size;
+      header.type = svn_fs_fs__rep_delta;
+    }
+  else
+    {
+      header.type = svn_fs_fs__rep_self_delta;
+    }
+  SVN_ERR(svn_fs_fs__write_rep_header(&header, b->rep_stream,
+                                      b->scratch_pool));
+
+  /* Now determine the offset of the actual svndiff data. */
+  SVN_ERR(svn_io_file_get_offset(&b->delta_start, b->file,
+                                 b->scratch_pool));
+
+  /* Prepare to write the svndiff data. */
+  txdelta_to_svndiff(&wh, &whb, b->rep_stream, b->fs, b->result_pool);
+
+  b->delta_stream = svn_txdelta__target_push(wh, whb, source, 1,
+                                             delta_window_size(b->fs,
+                                                               expected_size),
+                                             b->scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+flush_rep_prefix(struct rep_write_baton *b)
+{
+  representation_t *base_rep;
+  apr_size_t len = b->prefix->len;
+
+  SVN_ERR(choose_delta_base(&base_rep, b->fs, b->noderev, FALSE,
+                            b->scratch_pool));
+  SVN_ERR(choose_chunk_delta_base(&base_rep, b, b->scratch_pool));
+
+  /* Either this is all of the contents or there are at least that many. */
+  SVN_ERR(start_rep_delta(b, base_rep, len));
+
+  SVN_ERR(svn_stream_write(b->delta_stream, b->prefix->data, &len));
+  b->prefix = NULL;
+
+  return SVN_NO_ERROR;
+}
+
 /* Get a rep_write_baton and store it in *WB_P for the representation
    indicated by NODEREV in filesystem FS.  Perform allocations in
    POOL.  Only appropriate for file contents, not for props or
@@ -2198,13 +2670,9 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
                     node_revision_t *noderev,
                     apr_pool_t *pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   struct rep_write_baton *b;
   apr_file_t *file;
-  representation_t *base_rep;
-  svn_stream_t *source;
-  svn_txdelta_window_handler_t wh;
-  void *whb;
-  svn_fs_fs__rep_header_t header = { 0 };
 
   b = apr_pcalloc(pool, sizeof(*b));
 
@@ -2230,39 +2698,27 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
 
   SVN_ERR(svn_io_file_get_offset(&b->rep_offset, file, b->scratch_pool));
 
-  /* Get the base for this delta. */
-  SVN_ERR(choose_delta_base(&base_rep, fs, noderev, FALSE, b->scratch_pool));
-  SVN_ERR(svn_fs_fs__get_contents(&source, fs, base_rep, TRUE,
-                                  b->scratch_pool));
+  /* Cleanup in case something goes wrong. */
+  apr_pool_cleanup_register(b->scratch_pool, b, rep_write_cleanup,
+                            apr_pool_cleanup_null);
 
-  /* Write out the rep header. */
-  if (base_rep)
+  if (ffd->content_chunking)
     {
-      header.base_revision = base_rep->revision;
-      header.base_item_index = base_rep->item_index;
-      header.base_length = base_rep->size;
-      header.type = svn_fs_fs__rep_delta;
+      /* Defer the choice of the delta base until we know enough of the
+         contents. */
+      b->chunker = chunker_create(b->scratch_pool);
+      b->prefix = svn_stringbuf_create_empty(b->scratch_pool);
     }
   else
     {
-      header.type = svn_fs_fs__rep_self_delta;
-    }
-  SVN_ERR(svn_fs_fs__write_rep_header(&header, b->rep_stream,
-                                      b->scratch_pool));
-
-  /* Now determine the offset of the actual svndiff data. */
-  SVN_ERR(svn_io_file_get_offset(&b->delta_start, file,
-                                 b->scratch_pool));
-
-  /* Cleanup in case something goes wrong. */
-  apr_pool_cleanup_register(b->scratch_pool, b, rep_write_cleanup,
-                            apr_pool_cleanup_null);
-
-  /* Prepare to write the svndiff data. */
-  txdelta_to_svndiff(&wh, &whb, b->rep_stream, fs, pool);
+      representation_t *base_rep;
 
-  b->delta_stream = svn_txdelta_target_push(wh, whb, source,
-                                            b->scratch_pool);
+      /* Get the base for this delta. */
+      SVN_ERR(choose_delta_base(&base_rep, fs, noderev, FALSE,
+                                b->scratch_pool));
+      SVN_ERR(start_rep_delta(b, base_rep,
+                              base_rep ? base_rep->expanded_size : -1));
+    }
 
   *wb_p = b;
 
@@ -2520,6 +2976,12 @@ rep_write_contents_close(void *baton)
 
   rep = apr_pcalloc(b->result_pool, sizeof(*rep));
 
+  /* Short contents may not have been written yet. */
+  if (b->prefix)
+    SVN_ERR(flush_rep_prefix(b));
+  if (b->chunker)
+    SVN_ERR(chunker_close(b->chunker));
+
   /* Close our delta stream so the last bits of svndiff are written
      out. */
   if (b->delta_stream)
@@ -2595,6 +3057,15 @@ rep_write_contents_close(void *baton)
 
   SVN_ERR(unlock_proto_rev(b->fs, &rep->txn_id, b->lockcookie,
                            b->scratch_pool));
+
+  /* Make the chunks of these contents available as delta bases for
+     future representations.  This is merely an optimization, so don't
+     fail the operation if it cannot be done. */
+  if (b->chunker)
+    svn_error_clear(svn_fs_fs__set_chunk_references(b->fs,
+                                                    b->chunker->hashes,
+                                                    rep, b->scratch_pool));
+
   svn_pool_destroy(b->scratch_pool);
 
   return SVN_NO_ERROR;
@@ -2729,9 +3200,7 @@ write_container_handler(void *baton,
 {
   struct write_container_baton *whb = baton;
 
-  SVN_ERR(svn_checksum_update(whb->md5_ctx, data, *len));
-  if (whb->sha1_ctx)
-    SVN_ERR(svn_checksum_update(whb->sha1_ctx, data, *len));
+  SVN_ERR(svn_checksum__update2(whb->md5_ctx, whb->sha1_ctx, data, *len));
 
   SVN_ERR(svn_stream_write(whb->stream, data, len));
   whb->size += *len;
@@ -2769,6 +3238,19 @@ write_directory_to_stream(svn_stream_t *stream,
   return SVN_NO_ERROR;
 }
 
+/* Implement collection_writer_t writing the sorted svn_fs_dirent_t* array
+   given as BATON in the indexed directory format. */
+static svn_error_t *
+write_indexed_directory_to_stream(svn_stream_t *stream,
+                                  void *baton,
+                                  apr_pool_t *pool)
+{
+  apr_array_header_t *dir = baton;
+  SVN_ERR(svn_fs_fs__write_indexed_dir(stream, dir, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Write out the COLLECTION as a text representation to file FILE using
    WRITER.  In the process, record position, the total size of the dump and
    MD5 as well as SHA1 in REP.   Add the representation of type ITEM_TYPE to
@@ -2950,8 +3432,11 @@ write_container_delta_rep(representation_t *rep,
   txdelta_to_svndiff(&diff_wh, &diff_whb, file_stream, fs, scratch_pool);
 
   whb = apr_pcalloc(scratch_pool, sizeof(*whb));
-  whb->stream = svn_txdelta_target_push(diff_wh, diff_whb, source,
-                                        scratch_pool);
+  whb->stream = svn_txdelta__target_push(diff_wh, diff_whb, source, 1,
+                                         delta_window_size(fs,
+                                           base_rep ? base_rep->expanded_size
+                                                    : -1),
+                                         scratch_pool);
   whb->size = 0;
   whb->md5_ctx = svn_checksum_ctx_create(svn_checksum_md5, scratch_pool);
   if (item_type != SVN_FS_FS__ITEM_TYPE_DIR_REP)
@@ -3192,18 +3677,24 @@ write_final_rev(const svn_fs_id_t **new_id_p,
           pair_cache_key_t *key;
           svn_fs_fs__dir_data_t dir_data;
 
+          /* Newer formats allow for single entry lookups without parsing
+           * the whole directory. */
+          collection_writer_t writer
+            = ffd->format >= SVN_FS_FS__MIN_INDEXED_DIRS_FORMAT
+            ? write_indexed_directory_to_stream
+            : write_directory_to_stream;
+
           /* Write out the contents of this directory as a text rep. */
           noderev->data_rep->revision = rev;
           if (ffd->deltify_directories)
             SVN_ERR(write_container_delta_rep(noderev->data_rep, file,
-                                              entries,
-                                              write_directory_to_stream,
+                                              entries, writer,
                                               fs, noderev, NULL, FALSE,
                                               SVN_FS_FS__ITEM_TYPE_DIR_REP,
                                               pool));
           else
             SVN_ERR(write_container_rep(noderev->data_rep, file, entries,
-                                        write_directory_to_stream, fs, NULL,
+                                        writer, fs, NULL,
                                         FALSE, SVN_FS_FS__ITEM_TYPE_DIR_REP,
                                         pool));
 
@@ -3593,13 +4084,14 @@ verify_locks(svn_fs_t *fs,
 }
 
 /* Writes final revision properties to file PATH applying permissions
-   from file PERMS_REFERENCE. This involves setting svn:date and
-   removing any temporary properties associated with the commit flags. */
+   from file PERMS_REFERENCE and schedule the necessary fsync calls in
+   BATCH. This involves setting svn:date and removing any temporary
+   properties associated with the commit flags. */
 static svn_error_t *
 write_final_revprop(const char *path,
                     const char *perms_reference,
                     svn_fs_txn_t *txn,
-                    svn_boolean_t flush_to_disk,
+                    svn_batch_fsync__t *batch,
                     apr_pool_t *pool)
 {
   apr_hash_t *txnprops;
@@ -3629,19 +4121,17 @@ write_final_revprop(const char *path,
       svn_hash_sets(txnprops, SVN_PROP_REVISION_DATE, &date);
     }
 
-  /* Create new revprops file. Tell OS to truncate existing file,
-     since  file may already exists from failed transaction. */
-  SVN_ERR(svn_io_file_open(&revprop_file, path,
-                           APR_WRITE | APR_CREATE | APR_TRUNCATE
-                           | APR_BUFFERED, APR_OS_DEFAULT, pool));
+  /* Create new revprops file.  It is owned by BATCH, which will flush and
+     close it.  Truncate any existing file, since the file may already
+     exist from a failed transaction. */
+  SVN_ERR(svn_batch_fsync__open_file(&revprop_file, batch, path,
+                                     pool));
+  SVN_ERR(svn_io_file_trunc(revprop_file, 0, pool));
 
   stream = svn_stream_from_aprfile2(revprop_file, TRUE, pool);
   SVN_ERR(svn_hash_write2(txnprops, stream, SVN_HASH_TERMINATOR, pool));
   SVN_ERR(svn_stream_close(stream));
-
-  if (flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(revprop_file, pool));
-  SVN_ERR(svn_io_file_close(revprop_file, pool));
+  SVN_ERR(svn_io_file_flush(revprop_file, pool));
 
   SVN_ERR(svn_io_copy_perms(perms_reference, path, pool));
 
@@ -3729,6 +4219,8 @@ struct commit_baton {
   svn_revnum_t *new_rev_p;
   svn_fs_t *fs;
   svn_fs_txn_t *txn;
+  svn_fs_fs__catch_up_func_t catch_up_func;
+  void *catch_up_baton;
   apr_array_header_t *reps_to_cache;
   apr_hash_t *reps_hash;
   apr_pool_t *reps_pool;
@@ -3748,13 +4240,14 @@ commit_body(void *baton, apr_pool_t *pool)
   apr_uint64_t start_node_id;
   apr_uint64_t start_copy_id;
   svn_revnum_t old_rev, new_rev;
-  apr_file_t *proto_file;
+  apr_file_t *proto_file, *rev_file;
   void *proto_file_lockcookie;
   apr_off_t initial_offset, changed_path_offset;
   const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__txn_get_id(cb->txn);
   apr_hash_t *changed_paths;
   apr_array_header_t *directory_ids = apr_array_make(pool, 4,
                                                      sizeof(pair_cache_key_t));
+  svn_batch_fsync__t *batch;
 
   /* Re-Read the current repository format.  All our repo upgrade and
      config evaluation strategies are such that existing information in
@@ -3780,10 +4273,21 @@ commit_body(void *baton, apr_pool_t *pool)
   ffd->youngest_rev_cache = old_rev;
 
   /* Check to make sure this transaction is based off the most recent
-     revision. */
+     revision.  The caller has already merged the transaction against
+     what was the youngest revision shortly before, so catching up with
+     the revisions committed since is cheap.  Doing it here rather than
+     failing means that a large commit can't be starved by a stream of
+     small ones. */
   if (cb->txn->base_rev != old_rev)
-    return svn_error_create(SVN_ERR_FS_TXN_OUT_OF_DATE, NULL,
-                            _("Transaction out of date"));
+    {
+      if (!cb->catch_up_func)
+        return svn_error_create(SVN_ERR_FS_TXN_OUT_OF_DATE, NULL,
+                                _("Transaction out of date"));
+
+      SVN_ERR(cb->catch_up_func(cb->catch_up_baton, cb->txn, old_rev,
+                                pool));
+      SVN_ERR_ASSERT(cb->txn->base_rev == old_rev);
+    }
 
   /* We need the changes list for verification as well as for writing it
      to the final rev file. */
@@ -3837,10 +4341,14 @@ commit_body(void *baton, apr_pool_t *pool)
                                      NULL, pool));
     }
 
-  if (ffd->flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(proto_file, pool));
+  /* The rev file contents will be flushed to disk together with all
+     other new files once it has been moved into place. */
   SVN_ERR(svn_io_file_close(proto_file, pool));
 
+  /* Collect all files and directories that need to be flushed to disk
+     before we may bump 'current' and sync them all in one go. */
+  SVN_ERR(svn_batch_fsync__create(&batch, ffd->flush_to_disk, pool));
+
   /* We don't unlock the prototype revision file immediately to avoid a
      race with another caller writing to the prototype revision file
      before we commit it. */
@@ -3863,6 +4371,7 @@ commit_body(void *baton, apr_pool_t *pool)
                                                     PATH_REVS_DIR,
                                                     pool),
                                     new_dir, pool));
+          SVN_ERR(svn_batch_fsync__new_path(batch, new_dir, pool));
         }
 
       /* Create the revprops shard. */
@@ -3879,6 +4388,7 @@ commit_body(void *baton, apr_pool_t *pool)
                                                     PATH_REVPROPS_DIR,
                                                     pool),
                                     new_dir, pool));
+          SVN_ERR(svn_batch_fsync__new_path(batch, new_dir, pool));
         }
     }
 
@@ -3891,7 +4401,12 @@ commit_body(void *baton, apr_pool_t *pool)
   rev_filename = svn_fs_fs__path_rev(cb->fs, new_rev, pool);
   proto_filename = svn_fs_fs__path_txn_proto_rev(cb->fs, txn_id, pool);
   SVN_ERR(svn_fs_fs__move_into_place(proto_filename, rev_filename,
-                                     old_rev_filename, ffd->flush_to_disk,
+                                     old_rev_filename, FALSE, pool));
+
+  /* Schedule the rev file contents as well as its directory entry to be
+     flushed to disk. */
+  SVN_ERR(svn_batch_fsync__new_path(batch, rev_filename, pool));
+  SVN_ERR(svn_batch_fsync__open_file(&rev_file, batch, rev_filename,
                                      pool));
 
   /* Now that we've moved the prototype revision file out of the way,
@@ -3904,7 +4419,12 @@ commit_body(void *baton, apr_pool_t *pool)
   SVN_ERR_ASSERT(! svn_fs_fs__is_packed_revprop(cb->fs, new_rev));
   revprop_filename = svn_fs_fs__path_revprops(cb->fs, new_rev, pool);
   SVN_ERR(write_final_revprop(revprop_filename, old_rev_filename,
-                              cb->txn, ffd->flush_to_disk, pool));
+                              cb->txn, batch, pool));
+
+  /* Flush the rev file, the revprops file and any new shard folders to
+     disk.  The fsync calls run concurrently, so the write lock is held
+     only for about the duration of the slowest of them. */
+  SVN_ERR(svn_batch_fsync__run(batch, pool));
 
   /* Run paranoia checks. */
   if (ffd->verify_before_commit)
@@ -3932,6 +4452,10 @@ commit_body(void *baton, apr_pool_t *pool)
   /* Remove this transaction directory. */
   SVN_ERR(svn_fs_fs__purge_txn(cb->fs, cb->txn->id, pool));
 
+  /* Add the new revision to the date index, if any.  We still hold the
+     write lock, so no other commit can interfere. */
+  SVN_ERR(svn_fs_fs__update_date_index(cb->fs, new_rev, pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -3954,10 +4478,106 @@ write_reps_to_cache(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+/* Add the representations in REPS_TO_CACHE (an array of representation_t *)
+ * to the rep-cache database of FS within a single sqlite transaction. */
+static svn_error_t *
+write_reps_to_cache_db(svn_fs_t *fs,
+                       const apr_array_header_t *reps_to_cache,
+                       apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_error_t *err;
+
+  SVN_ERR(svn_fs_fs__open_rep_cache(fs, scratch_pool));
+
+  /* Write new entries to the rep-sharing database.
+   *
+   * We use an sqlite transaction to speed things up;
+   * see <http://www.sqlite.org/faq.html#q19>.
+   */
+  /* ### A commit that touches thousands of files will starve other
+         (reader/writer) commits for the duration of the below call.
+         Maybe write in batches? */
+  SVN_ERR(svn_sqlite__begin_transaction(ffd->rep_cache_db));
+  err = write_reps_to_cache(fs, reps_to_cache, scratch_pool);
+  err = svn_sqlite__finish_transaction(ffd->rep_cache_db, err);
+
+  if (svn_error_find_cause(err, SVN_ERR_SQLITE_ROLLBACK_FAILED))
+    {
+      /* Failed rollback means that our db connection is unusable, and
+         the only thing we can do is close it.  The connection will be
+         reopened during the next operation with rep-cache.db. */
+      return svn_error_trace(
+          svn_error_compose_create(err,
+                                   svn_fs_fs__close_rep_cache(fs)));
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Number of pending rep-cache entries in bulk load mode that triggers
+ * writing them to the rep-cache.db. */
+#define BULK_LOAD_REP_CACHE_BATCH 10000
+
+/* Write the rep-cache entries that FS collected in bulk load mode to the
+ * rep-cache.db.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+write_bulk_load_reps(svn_fs_t *fs,
+                     apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (ffd->bulk_load_reps->nelts == 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(write_reps_to_cache_db(fs, ffd->bulk_load_reps, scratch_pool));
+
+  /* Lookups are served by the rep-cache.db again. */
+  svn_pool_clear(ffd->bulk_load_pool);
+  ffd->bulk_load_reps = apr_array_make(ffd->bulk_load_pool,
+                                       BULK_LOAD_REP_CACHE_BATCH,
+                                       sizeof(representation_t *));
+  ffd->bulk_load_reps_hash = apr_hash_make(ffd->bulk_load_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Add copies of the representations in REPS_TO_CACHE (an array of
+ * representation_t *) to the pending rep-cache entries of FS in bulk
+ * load mode.  Write them to the rep-cache.db once there are enough.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+queue_bulk_load_reps(svn_fs_t *fs,
+                     const apr_array_header_t *reps_to_cache,
+                     apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  int i;
+
+  for (i = 0; i < reps_to_cache->nelts; i++)
+    {
+      representation_t *rep
+        = svn_fs_fs__rep_copy(APR_ARRAY_IDX(reps_to_cache, i,
+                                            representation_t *),
+                              ffd->bulk_load_pool);
+
+      APR_ARRAY_PUSH(ffd->bulk_load_reps, representation_t *) = rep;
+      apr_hash_set(ffd->bulk_load_reps_hash, rep->sha1_digest,
+                   sizeof(rep->sha1_digest), rep);
+    }
+
+  if (ffd->bulk_load_reps->nelts >= BULK_LOAD_REP_CACHE_BATCH)
+    SVN_ERR(write_bulk_load_reps(fs, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__commit(svn_revnum_t *new_rev_p,
                   svn_fs_t *fs,
                   svn_fs_txn_t *txn,
+                  svn_fs_fs__catch_up_func_t catch_up_func,
+                  void *catch_up_baton,
                   apr_pool_t *pool)
 {
   struct commit_baton cb;
@@ -3966,6 +4586,8 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
   cb.new_rev_p = new_rev_p;
   cb.fs = fs;
   cb.txn = txn;
+  cb.catch_up_func = catch_up_func;
+  cb.catch_up_baton = catch_up_baton;
 
   if (ffd->rep_sharing_allowed)
     {
@@ -3985,35 +4607,149 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
   /* At this point, *NEW_REV_P has been set, so errors below won't affect
      the success of the commit.  (See svn_fs_commit_txn().)  */
 
+  if (ffd->bulk_load_reps)
+    SVN_ERR(queue_bulk_load_reps(fs, cb.reps_to_cache, pool));
+  else if (ffd->rep_sharing_allowed)
+    SVN_ERR(write_reps_to_cache_db(fs, cb.reps_to_cache, pool));
+
+  /* Keep the path index, if any, up to date. */
+  SVN_ERR(svn_fs_fs__update_path_index(fs, pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__begin_bulk_load(svn_fs_t *fs,
+                           apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (SVN_IS_VALID_REVNUM(ffd->bulk_load_base_rev))
+    return svn_error_create(SVN_ERR_FS_GENERAL, NULL,
+                            _("Bulk load mode has already been started"));
+
+  SVN_ERR(svn_fs_fs__youngest_rev(&ffd->bulk_load_base_rev, fs,
+                                  scratch_pool));
+
+  /* Defer all fsyncs to svn_fs_fs__end_bulk_load(). */
+  ffd->bulk_load_flush_to_disk = ffd->flush_to_disk;
+  ffd->flush_to_disk = FALSE;
+
   if (ffd->rep_sharing_allowed)
     {
-      svn_error_t *err;
+      ffd->bulk_load_pool = svn_pool_create(fs->pool);
+      ffd->bulk_load_reps = apr_array_make(ffd->bulk_load_pool,
+                                           BULK_LOAD_REP_CACHE_BATCH,
+                                           sizeof(representation_t *));
+      ffd->bulk_load_reps_hash = apr_hash_make(ffd->bulk_load_pool);
+    }
 
-      SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
+  return SVN_NO_ERROR;
+}
 
-      /* Write new entries to the rep-sharing database.
-       *
-       * We use an sqlite transaction to speed things up;
-       * see <http://www.sqlite.org/faq.html#q19>.
-       */
-      /* ### A commit that touches thousands of files will starve other
-             (reader/writer) commits for the duration of the below call.
-             Maybe write in batches? */
-      SVN_ERR(svn_sqlite__begin_transaction(ffd->rep_cache_db));
-      err = write_reps_to_cache(fs, cb.reps_to_cache, pool);
-      err = svn_sqlite__finish_transaction(ffd->rep_cache_db, err);
-
-      if (svn_error_find_cause(err, SVN_ERR_SQLITE_ROLLBACK_FAILED))
+/* Schedule all files and directories that commits of the revisions after
+ * BASE_REV in FS may have created or changed to be flushed to disk in
+ * BATCH.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+queue_bulk_load_fsyncs(svn_batch_fsync__t *batch,
+                       svn_fs_t *fs,
+                       svn_revnum_t base_rev,
+                       apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t youngest, rev;
+  apr_file_t *file;
+
+  SVN_ERR(svn_fs_fs__youngest_rev(&youngest, fs, scratch_pool));
+  for (rev = base_rev + 1; rev <= youngest; rev++)
+    {
+      const char *path;
+
+      svn_pool_clear(iterpool);
+
+      /* Nobody else may touch the repository during a bulk load, so
+         these revisions cannot have been packed yet. */
+      if (ffd->max_files_per_dir && rev % ffd->max_files_per_dir == 0)
         {
-          /* Failed rollback means that our db connection is unusable, and
-             the only thing we can do is close it.  The connection will be
-             reopened during the next operation with rep-cache.db. */
-          return svn_error_trace(
-              svn_error_compose_create(err,
-                                       svn_fs_fs__close_rep_cache(fs)));
+          SVN_ERR(svn_batch_fsync__new_path(
+                      batch, svn_fs_fs__path_rev_shard(fs, rev, iterpool),
+                      iterpool));
+          SVN_ERR(svn_batch_fsync__new_path(
+                      batch, svn_fs_fs__path_revprops_shard(fs, rev,
+                                                            iterpool),
+                      iterpool));
         }
-      else if (err)
-        return svn_error_trace(err);
+
+      path = svn_fs_fs__path_rev(fs, rev, iterpool);
+      SVN_ERR(svn_batch_fsync__new_path(batch, path, iterpool));
+      SVN_ERR(svn_batch_fsync__open_file(&file, batch, path, iterpool));
+
+      path = svn_fs_fs__path_revprops(fs, rev, iterpool);
+      SVN_ERR(svn_batch_fsync__new_path(batch, path, iterpool));
+      SVN_ERR(svn_batch_fsync__open_file(&file, batch, path, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* The last 'current' and 'txn-current' files.  Flushing them last
+     is not required as the batch gets flushed as a whole. */
+  SVN_ERR(svn_batch_fsync__new_path(batch, svn_fs_fs__path_current(fs,
+                                                             scratch_pool),
+                                    scratch_pool));
+  SVN_ERR(svn_batch_fsync__open_file(&file, batch,
+                                     svn_fs_fs__path_current(fs,
+                                                             scratch_pool),
+                                     scratch_pool));
+  if (ffd->format >= SVN_FS_FS__MIN_TXN_CURRENT_FORMAT)
+    {
+      SVN_ERR(svn_batch_fsync__new_path(batch,
+                                        svn_fs_fs__path_txn_current(
+                                          fs, scratch_pool),
+                                        scratch_pool));
+      SVN_ERR(svn_batch_fsync__open_file(&file, batch,
+                                         svn_fs_fs__path_txn_current(
+                                           fs, scratch_pool),
+                                         scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__end_bulk_load(svn_fs_t *fs,
+                         apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_revnum_t base_rev = ffd->bulk_load_base_rev;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (!SVN_IS_VALID_REVNUM(base_rev))
+    return SVN_NO_ERROR;
+
+  /* Leave bulk load mode even if the final barrier fails. */
+  if (ffd->bulk_load_reps)
+    err = write_bulk_load_reps(fs, scratch_pool);
+
+  ffd->flush_to_disk = ffd->bulk_load_flush_to_disk;
+  ffd->bulk_load_base_rev = SVN_INVALID_REVNUM;
+  ffd->bulk_load_reps = NULL;
+  ffd->bulk_load_reps_hash = NULL;
+  if (ffd->bulk_load_pool)
+    {
+      svn_pool_destroy(ffd->bulk_load_pool);
+      ffd->bulk_load_pool = NULL;
+    }
+
+  SVN_ERR(err);
+
+  if (ffd->flush_to_disk)
+    {
+      svn_batch_fsync__t *batch;
+
+      SVN_ERR(svn_batch_fsync__create(&batch, TRUE, scratch_pool));
+      SVN_ERR(queue_bulk_load_fsyncs(batch, fs, base_rev, scratch_pool));
+      SVN_ERR(svn_batch_fsync__run(batch, scratch_pool));
     }
 
   return SVN_NO_ERROR;
@@ -25,6 +25,18 @@
 
 #include "fs.h"
 
+/* Return the usage statistics of the txn list lock of FS, which is
+   shared by all FS instances of the same repository in this process:
+   *COUNT is the number of times that the lock has been acquired,
+   *WAIT_TIME is the total and *MAX_WAIT_TIME the longest time spent
+   waiting for it.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__get_txn_list_lock_stats(apr_uint64_t *count,
+                                   apr_interval_time_t *wait_time,
+                                   apr_interval_time_t *max_wait_time,
+                                   svn_fs_t *fs,
+                                   apr_pool_t *scratch_pool);
+
 /* Return the transaction ID of TXN.
  */
 const svn_fs_fs__id_part_t *
@@ -210,16 +222,50 @@ svn_fs_fs__add_index_data(svn_fs_t *fs,
                           svn_revnum_t revision,
                           apr_pool_t *pool);
 
+/* Callback type for svn_fs_fs__commit.  Bring TXN up to date with
+   revision YOUNGEST by merging in the changes since its base revision
+   and set TXN->BASE_REV to YOUNGEST.  BATON is the baton given to
+   svn_fs_fs__commit.  This gets called with the FS write lock held.
+   Use SCRATCH_POOL for temporary allocations. */
+typedef svn_error_t *(*svn_fs_fs__catch_up_func_t)(void *baton,
+                                                   svn_fs_txn_t *txn,
+                                                   svn_revnum_t youngest,
+                                                   apr_pool_t *scratch_pool);
+
 /* Commit the transaction TXN in filesystem FS and return its new
-   revision number in *REV.  If the transaction is out of date, return
-   the error SVN_ERR_FS_TXN_OUT_OF_DATE. Use POOL for temporary
-   allocations. */
+   revision number in *REV.  If the transaction is out of date, call
+   CATCH_UP_FUNC with CATCH_UP_BATON to merge the revisions committed
+   in between, or return the error SVN_ERR_FS_TXN_OUT_OF_DATE if
+   CATCH_UP_FUNC is NULL.  Use POOL for temporary allocations. */
 svn_error_t *
 svn_fs_fs__commit(svn_revnum_t *new_rev_p,
                   svn_fs_t *fs,
                   svn_fs_txn_t *txn,
+                  svn_fs_fs__catch_up_func_t catch_up_func,
+                  void *catch_up_baton,
                   apr_pool_t *pool);
 
+/* Start bulk load mode for FS.  Until svn_fs_fs__end_bulk_load() gets
+   called, commits through FS will not flush their data to disk and will
+   collect their rep-cache entries in memory, writing them to the
+   rep-cache.db in large batches.
+
+   The caller must make sure that nobody else accesses the repository
+   until bulk load mode ends.  Revisions committed in that mode may get
+   lost if the system crashes before.  Use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_fs_fs__begin_bulk_load(svn_fs_t *fs,
+                           apr_pool_t *scratch_pool);
+
+/* End bulk load mode for FS.  Write all pending rep-cache entries and,
+   unless FS has been configured not to, flush all revisions committed
+   in bulk load mode to disk.  Do nothing if FS is not in bulk load mode.
+   Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__end_bulk_load(svn_fs_t *fs,
+                         apr_pool_t *scratch_pool);
+
 /* Set *NAMES_P to an array of names which are all the active
    transactions in filesystem FS.  Allocate the array from POOL. */
 svn_error_t *
@@ -59,6 +59,7 @@
 #include "fs_fs.h"
 #include "id.h"
 #include "pack.h"
+#include "path-index.h"
 #include "temp_serializer.h"
 #include "transaction.h"
 #include "util.h"
@@ -498,6 +499,52 @@ dag_node_cache_set(svn_fs_root_t *root,
   return svn_cache__set(cache, key, node, pool);
 }
 
+/* Set *ABSENT to TRUE if PATH is known not to exist in ROOT; FALSE if
+   that is unknown.  Only revision roots are covered by this negative
+   lookup cache.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+absent_path_cache_get(svn_boolean_t *absent,
+                      svn_fs_root_t *root,
+                      const char *path,
+                      apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = root->fs->fsap_data;
+
+  *absent = FALSE;
+  if (!root->is_txn_root && ffd->absent_path_cache)
+    {
+      const char *key
+        = svn_fs_fs__combine_number_and_string(root->rev, path,
+                                               scratch_pool);
+      SVN_ERR(svn_cache__has_key(absent, ffd->absent_path_cache, key,
+                                 scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Remember that PATH does not exist in ROOT.  This is a no-op for
+   transaction roots.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+absent_path_cache_set(svn_fs_root_t *root,
+                      const char *path,
+                      apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = root->fs->fsap_data;
+
+  if (!root->is_txn_root && ffd->absent_path_cache)
+    {
+      const char *key
+        = svn_fs_fs__combine_number_and_string(root->rev, path,
+                                               scratch_pool);
+      svn_stringbuf_t *value = svn_stringbuf_create("1", scratch_pool);
+      SVN_ERR(svn_cache__set(ffd->absent_path_cache, key, value,
+                             scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Baton for find_descendants_in_cache. */
 struct fdic_baton {
@@ -993,6 +1040,28 @@ open_path(parent_path_t **parent_path_p,
      find the next item.  This is only useful if the caller didn't request
      the full parent chain. */
   assert(svn_fs__is_canonical_abspath(path));
+
+  /* Build tools tend to probe the same non-existent paths over and over.
+     Revisions are immutable, so a cached miss lets us skip the walk.
+     Callers that want the parent chain for a missing last component
+     must still get it, though. */
+  if (!(flags & open_path_last_optional))
+    {
+      svn_boolean_t absent;
+      SVN_ERR(absent_path_cache_get(&absent, root, path, iterpool));
+      if (absent)
+        {
+          svn_pool_destroy(iterpool);
+          if (flags & open_path_allow_null)
+            {
+              *parent_path_p = NULL;
+              return SVN_NO_ERROR;
+            }
+
+          return SVN_FS__NOT_FOUND(root, path);
+        }
+    }
+
   path_so_far->len = 0; /* "" */
   if (flags & open_path_node_only)
     {
@@ -1122,6 +1191,9 @@ open_path(parent_path_t **parent_path_p,
           /* "file not found" requires special handling.  */
           if (child == NULL)
             {
+              /* A missing entry along the way implies a missing PATH. */
+              SVN_ERR(absent_path_cache_set(root, path, iterpool));
+
               /* If this was the last path component, and the caller
                  said it was optional, then don't return an error;
                  just put a NULL node pointer in the path.  */
@@ -2222,6 +2294,29 @@ merge_changes(dag_node_t *ancestor_node,
 }
 
 
+/* Implements svn_fs_fs__catch_up_func_t.  Merge the changes between the
+   base revision of TXN and YOUNGEST into TXN.  In case of a conflict,
+   set BATON, a svn_stringbuf_t *, to the conflicting path. */
+static svn_error_t *
+catch_up_with_youngest(void *baton,
+                       svn_fs_txn_t *txn,
+                       svn_revnum_t youngest,
+                       apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *conflict = baton;
+  svn_fs_root_t *youngest_root;
+  dag_node_t *youngest_root_node;
+
+  SVN_ERR(svn_fs_fs__revision_root(&youngest_root, txn->fs, youngest,
+                                   scratch_pool));
+  SVN_ERR(get_root(&youngest_root_node, youngest_root, scratch_pool));
+  SVN_ERR(merge_changes(NULL, youngest_root_node, txn, conflict,
+                        scratch_pool));
+  txn->base_rev = youngest;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__commit_txn(const char **conflict_p,
                       svn_revnum_t *new_rev,
@@ -2266,6 +2361,11 @@ svn_fs_fs__commit_txn(const char **conflict_p,
    *       T's tree, except immutable now.
    *
    * Lather, rinse, repeat.
+   *
+   * All of the above happens without holding the write lock.  Only if
+   * yet another revision got committed before we obtained the lock, the
+   * changes of those few revisions get merged in while holding it, so
+   * we don't need to start over (see catch_up_with_youngest()).
    */
 
   svn_error_t *err = SVN_NO_ERROR;
@@ -2323,8 +2423,15 @@ svn_fs_fs__commit_txn(const char **conflict_p,
       txn->base_rev = youngish_rev;
 
       /* Try to commit. */
-      err = svn_fs_fs__commit(new_rev, fs, txn, iterpool);
-      if (err && (err->apr_err == SVN_ERR_FS_TXN_OUT_OF_DATE))
+      err = svn_fs_fs__commit(new_rev, fs, txn, catch_up_with_youngest,
+                              conflict, iterpool);
+      if (err && (err->apr_err == SVN_ERR_FS_CONFLICT))
+        {
+          if (conflict_p)
+            *conflict_p = conflict->data;
+          goto cleanup;
+        }
+      else if (err && (err->apr_err == SVN_ERR_FS_TXN_OUT_OF_DATE))
         {
           /* Did someone else finish committing a new revision while we
              were in mid-merge or mid-commit?  If so, we'll need to
@@ -4253,6 +4360,33 @@ crawl_directory_dag_for_mergeinfo(svn_fs_root_t *root,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__node_mergeinfo(svn_string_t **mergeinfo,
+                          svn_fs_root_t *root,
+                          const char *path,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  dag_node_t *node;
+  svn_boolean_t has_mergeinfo;
+  apr_hash_t *proplist;
+  svn_string_t *value;
+
+  *mergeinfo = NULL;
+
+  SVN_ERR(get_dag(&node, root, path, scratch_pool));
+  SVN_ERR(svn_fs_fs__dag_has_mergeinfo(&has_mergeinfo, node));
+  if (!has_mergeinfo)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_fs__dag_get_proplist(&proplist, node, scratch_pool));
+  value = svn_hash_gets(proplist, SVN_PROP_MERGEINFO);
+  if (value)
+    *mergeinfo = svn_string_dup(value, result_pool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Return the cache key as a combination of REV_ROOT->REV, the inheritance
    flags INHERIT and ADJUST_INHERITED_MERGEINFO, and the PATH.  The result
    will be allocated in POOL..
@@ -4439,12 +4573,19 @@ add_descendant_mergeinfo(svn_fs_root_t *root,
                          apr_pool_t *scratch_pool)
 {
   dag_node_t *this_dag;
-  svn_boolean_t go_down;
+  svn_boolean_t go_down, indexed;
 
   SVN_ERR(get_dag(&this_dag, root, path, scratch_pool));
   SVN_ERR(svn_fs_fs__dag_has_descendants_with_mergeinfo(&go_down,
                                                         this_dag));
-  if (go_down)
+  if (!go_down)
+    return SVN_NO_ERROR;
+
+  /* Prefer the path index over crawling the tree. */
+  SVN_ERR(svn_fs_fs__path_index_mergeinfo(&indexed, root->fs, path,
+                                          root->rev, receiver, baton,
+                                          scratch_pool));
+  if (!indexed)
     SVN_ERR(crawl_directory_dag_for_mergeinfo(root,
                                               path,
                                               this_dag,
@@ -4778,10 +4919,10 @@ verify_node(dag_node_t *node,
           else
             {
               /* access mergeinfo counter with minimal overhead */
-              node_revision_t *noderev;
-              SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, dirent->id,
-                                                   iterpool, iterpool));
-              child_mergeinfo = noderev->mergeinfo_count;
+              svn_fs_fs__noderev_header_t header;
+              SVN_ERR(svn_fs_fs__get_noderev_header(&header, fs, dirent->id,
+                                                    iterpool));
+              child_mergeinfo = header.mergeinfo_count;
             }
 
           children_mergeinfo += child_mergeinfo;
@@ -84,6 +84,16 @@ svn_fs_fs__node_created_rev(svn_revnum_t *revision,
                             const char *path,
                             apr_pool_t *pool);
 
+/* Set *MERGEINFO to the svn:mergeinfo property of PATH under ROOT or to
+   NULL if it has none.  Allocate the result in RESULT_POOL and use
+   SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__node_mergeinfo(svn_string_t **mergeinfo,
+                          svn_fs_root_t *root,
+                          const char *path,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
 /* Verify metadata for ROOT.
    ### Currently only implemented for revision roots. */
 svn_error_t *
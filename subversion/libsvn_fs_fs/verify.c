@@ -23,7 +23,9 @@
 #include "svn_sorts.h"
 #include "svn_checksum.h"
 #include "svn_time.h"
+#include "svn_cache_config.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_task.h"
 
 #include "verify.h"
 #include "fs_fs.h"
@@ -213,17 +215,12 @@ verify_index_checksum(apr_file_t *file,
   return SVN_NO_ERROR;
 }
 
-/* Verify the MD5 checksums of the index data in the rev / pack file
- * containing revision START in FS.  If given, invoke CANCEL_FUNC with
- * CANCEL_BATON at regular intervals.  Use SCRATCH_POOL for temporary
- * allocations.
- */
-static svn_error_t *
-verify_index_checksums(svn_fs_t *fs,
-                       svn_revnum_t start,
-                       svn_cancel_func_t cancel_func,
-                       void *cancel_baton,
-                       apr_pool_t *scratch_pool)
+svn_error_t *
+svn_fs_fs__verify_index_checksums(svn_fs_t *fs,
+                                  svn_revnum_t start,
+                                  svn_cancel_func_t cancel_func,
+                                  void *cancel_baton,
+                                  apr_pool_t *scratch_pool)
 {
   svn_fs_fs__revision_file_t *rev_file;
 
@@ -802,14 +799,14 @@ pack_size(svn_fs_t *fs, svn_revnum_t rev)
  * verified.  You may call this for format7 or higher repos.
  */
 static svn_error_t *
-verify_f7_metadata_consistency(svn_fs_t *fs,
-                               svn_revnum_t start,
-                               svn_revnum_t end,
-                               svn_fs_progress_notify_func_t notify_func,
-                               void *notify_baton,
-                               svn_cancel_func_t cancel_func,
-                               void *cancel_baton,
-                               apr_pool_t *pool)
+verify_f7_range(svn_fs_t *fs,
+                svn_revnum_t start,
+                svn_revnum_t end,
+                svn_fs_progress_notify_func_t notify_func,
+                void *notify_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
   svn_revnum_t revision, next_revision;
@@ -829,8 +826,8 @@ verify_f7_metadata_consistency(svn_fs_t *fs,
         notify_func(pack_start, notify_baton, iterpool);
 
       /* Check for external corruption to the indexes. */
-      err = verify_index_checksums(fs, pack_start, cancel_func,
-                                   cancel_baton, iterpool);
+      err = svn_fs_fs__verify_index_checksums(fs, pack_start, cancel_func,
+                                              cancel_baton, iterpool);
 
       /* two-way index check */
       if (!err)
@@ -884,6 +881,177 @@ verify_f7_metadata_consistency(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+/* Baton type used with the callbacks of verify_f7_concurrently().
+ * Each work item covers the part of a single shard that lies within
+ * the revision range START to END.
+ */
+typedef struct verify_f7_baton_t
+{
+  /* The filesystem being verified, as opened by the caller. */
+  svn_fs_t *fs;
+
+  /* Revision range to verify. */
+  svn_revnum_t start;
+  svn_revnum_t end;
+
+  /* Progress notification callback to invoke for each shard
+   * (may be NULL). */
+  svn_fs_progress_notify_func_t notify_func;
+
+  /* Baton to use with NOTIFY_FUNC. */
+  void *notify_baton;
+} verify_f7_baton_t;
+
+/* Set *SHARD_START and *SHARD_END to the first and last revision within
+ * *BATON that belong to the work item with the given INDEX. */
+static void
+get_item_range(svn_revnum_t *shard_start,
+               svn_revnum_t *shard_end,
+               const verify_f7_baton_t *baton,
+               int index)
+{
+  fs_fs_data_t *ffd = baton->fs->fsap_data;
+  svn_revnum_t shard = baton->start / ffd->max_files_per_dir + index;
+
+  *shard_start = MAX(baton->start, shard * ffd->max_files_per_dir);
+  *shard_end = MIN(baton->end, (shard + 1) * ffd->max_files_per_dir - 1);
+}
+
+/* Implements svn_task__thread_context_constructor_t.
+ * Open a separate instance of the filesystem given by the
+ * verify_f7_baton_t in CONTEXT_BATON, such that each thread can use its
+ * own, non-thread-safe caches. */
+static svn_error_t *
+open_worker_fs(void **thread_context,
+               void *context_baton,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  verify_f7_baton_t *baton = context_baton;
+  svn_fs_t *worker_fs;
+
+  SVN_ERR(svn_fs_fs__open_instance(&worker_fs, baton->fs, result_pool,
+                                   scratch_pool));
+  *thread_context = worker_fs;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.
+ * Verify the shard with the given INDEX using the filesystem instance in
+ * THREAD_CONTEXT. */
+static svn_error_t *
+verify_f7_shard(void **result,
+                int index,
+                void *process_baton,
+                void *thread_context,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  verify_f7_baton_t *baton = process_baton;
+  svn_fs_t *worker_fs = thread_context;
+  svn_revnum_t shard_start, shard_end;
+
+  get_item_range(&shard_start, &shard_end, baton, index);
+  SVN_ERR(verify_f7_range(worker_fs, shard_start, shard_end, NULL, NULL,
+                          cancel_func, cancel_baton, scratch_pool));
+
+  *result = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.
+ * Send the progress notification for the shard with the given INDEX in
+ * the same way as verify_f7_range() would. */
+static svn_error_t *
+notify_f7_shard(void *result,
+                int index,
+                void *output_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *scratch_pool)
+{
+  verify_f7_baton_t *baton = output_baton;
+  fs_fs_data_t *ffd = baton->fs->fsap_data;
+  svn_revnum_t shard_start, shard_end, pack_start;
+
+  get_item_range(&shard_start, &shard_end, baton, index);
+  pack_start = svn_fs_fs__packed_base_rev(baton->fs, shard_start);
+
+  if (baton->notify_func && (pack_start % ffd->max_files_per_dir == 0))
+    baton->notify_func(pack_start, baton->notify_baton, scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Like verify_f7_range() but verify the shards within the revision range
+ * START to END concurrently, using up to JOBS threads.  Notifications and
+ * errors are being reported in revision order.
+ */
+static svn_error_t *
+verify_f7_concurrently(svn_fs_t *fs,
+                       int jobs,
+                       svn_revnum_t start,
+                       svn_revnum_t end,
+                       svn_fs_progress_notify_func_t notify_func,
+                       void *notify_baton,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  verify_f7_baton_t baton;
+  int shard_count = (int)(end / ffd->max_files_per_dir
+                          - start / ffd->max_files_per_dir + 1);
+
+  baton.fs = fs;
+  baton.start = start;
+  baton.end = end;
+  baton.notify_func = notify_func;
+  baton.notify_baton = notify_baton;
+
+  return svn_error_trace(svn_task__run(jobs, shard_count,
+                                       verify_f7_shard, &baton,
+                                       notify_f7_shard, &baton,
+                                       open_worker_fs, &baton,
+                                       cancel_func, cancel_baton, pool));
+}
+
+/* Verify the format 7 metadata of FS for the revision range START to END.
+ * Use multiple threads, if configured to and if supported.  The remaining
+ * parameters are the same as for svn_fs_fs__verify.
+ */
+static svn_error_t *
+verify_f7_metadata_consistency(svn_fs_t *fs,
+                               svn_revnum_t start,
+                               svn_revnum_t end,
+                               svn_fs_progress_notify_func_t notify_func,
+                               void *notify_baton,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  /* Worker threads use their own FS instances but share the global cache.
+   * So, we can only go concurrent if the latter allows for it. */
+  if (   ffd->verify_jobs > 1
+      && ffd->max_files_per_dir > 0
+      && !svn_cache_config_get()->single_threaded)
+    return svn_error_trace(verify_f7_concurrently(fs, ffd->verify_jobs,
+                                                  start, end,
+                                                  notify_func, notify_baton,
+                                                  cancel_func, cancel_baton,
+                                                  pool));
+
+  return svn_error_trace(verify_f7_range(fs, start, end,
+                                         notify_func, notify_baton,
+                                         cancel_func, cancel_baton, pool));
+}
+
 svn_error_t *
 svn_fs_fs__verify(svn_fs_t *fs,
                   svn_revnum_t start,
@@ -39,4 +39,16 @@ svn_error_t *svn_fs_fs__verify(svn_fs_t *fs,
                                void *cancel_baton,
                                apr_pool_t *pool);
 
+/* Verify the MD5 checksums of the index data in the rev / pack file
+ * containing revision START in FS against the checksums stored in its
+ * footer.  If given, invoke CANCEL_FUNC with CANCEL_BATON at regular
+ * intervals.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__verify_index_checksums(svn_fs_t *fs,
+                                  svn_revnum_t start,
+                                  svn_cancel_func_t cancel_func,
+                                  void *cancel_baton,
+                                  apr_pool_t *scratch_pool);
+
 #endif
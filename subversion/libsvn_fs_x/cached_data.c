@@ -2378,8 +2378,15 @@ svn_fs_x__get_file_delta_stream(svn_txdelta_stream_t **stream_p,
 
   /* Try a shortcut: if the target is stored as a delta against the source,
      then just use that delta.  However, prefer using the fulltext cache
-     whenever that is available. */
-  if (target->data_rep && source)
+     whenever that is available.
+
+     The stored windows may exceed the classic window size, which older
+     clients would reject.  Only forward them if they can't be that large,
+     i.e. if neither view may have grown beyond SVN_DELTA_WINDOW_SIZE. */
+  if (target->data_rep && source
+      && target->data_rep->expanded_size <= SVN_DELTA_WINDOW_SIZE
+      && (!source->data_rep
+          || source->data_rep->expanded_size <= SVN_DELTA_WINDOW_SIZE))
     {
       /* Read target's base rep if any. */
       SVN_ERR(create_rep_state(&rep_state, &rep_header, NULL,
@@ -2925,6 +2932,7 @@ svn_fs_x__create_changes_context(svn_fs_x__changes_context_t **context,
                                                     sizeof(*result));
   result->fs = fs;
   result->revision = rev;
+  result->pool = result_pool;
 
   SVN_ERR(svn_fs_x__ensure_revision_exists(rev, fs, scratch_pool));
   SVN_ERR(svn_fs_x__rev_file_init(&result->revision_file, fs, rev,
@@ -2947,6 +2955,25 @@ svn_fs_x__get_changes(apr_array_header_t **changes,
   id.change_set = svn_fs_x__change_set_by_rev(context->revision);
   id.number = SVN_FS_X__ITEM_INDEX_CHANGES;
 
+  /* Continue with a container that we could not cache? */
+  if (context->container)
+    {
+      SVN_ERR(svn_fs_x__changes_get_list(changes, context->container,
+                                         context->container_sub_item,
+                                         context, result_pool));
+      context->next += (*changes)->nelts;
+
+      /* Release the container as soon as we don't need it anymore. */
+      if (context->eol)
+        {
+          svn_pool_destroy(context->container_pool);
+          context->container_pool = NULL;
+          context->container = NULL;
+        }
+
+      return SVN_NO_ERROR;
+    }
+
   /* try cache lookup first */
 
   if (svn_fs_x__is_packed_rev(context->fs, context->revision))
@@ -3190,6 +3217,7 @@ block_read_changes_container(apr_array_header_t **changes,
   svn_fs_x__pair_cache_key_t key;
   svn_stream_t *stream;
   svn_revnum_t revision = svn_fs_x__get_revnum(entry->items[0].change_set);
+  apr_pool_t *container_pool;
 
   key.revision = svn_fs_x__packed_base_rev(fs, revision);
   key.second = entry->offset;
@@ -3206,10 +3234,12 @@ block_read_changes_container(apr_array_header_t **changes,
 
   SVN_ERR(read_item(&stream, fs, rev_file, entry, scratch_pool));
 
-  /* read changes from revision file */
+  /* read changes from revision file.  We may need to keep the container
+     around for the following blocks of the list. */
 
-  SVN_ERR(svn_fs_x__read_changes_container(&container, stream, scratch_pool,
-                                           scratch_pool));
+  container_pool = must_read ? svn_pool_create(context->pool) : scratch_pool;
+  SVN_ERR(svn_fs_x__read_changes_container(&container, stream,
+                                           container_pool, scratch_pool));
 
   /* extract requested data */
 
@@ -3219,6 +3249,28 @@ block_read_changes_container(apr_array_header_t **changes,
   SVN_ERR(svn_cache__set(ffd->changes_container_cache, &key, container,
                          scratch_pool));
 
+  if (must_read)
+    {
+      /* Long lists are being read in several blocks.  If the container
+         did not fit into the cache, keep it for the following blocks.
+         Otherwise, we would read and decode it once per block. */
+      svn_boolean_t is_cached = TRUE;
+      if (!context->eol)
+        SVN_ERR(svn_cache__has_key(&is_cached, ffd->changes_container_cache,
+                                   &key, scratch_pool));
+
+      if (is_cached)
+        {
+          svn_pool_destroy(container_pool);
+        }
+      else
+        {
+          context->container = container;
+          context->container_pool = container_pool;
+          context->container_sub_item = sub_item;
+        }
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -3301,6 +3353,35 @@ block_read_noderevs_container(svn_fs_x__noderev_t **noderev_p,
         return SVN_NO_ERROR;
     }
 
+  /* Containers that are too large for the cache would have to be decoded
+   * completely on every single access.  Only decode what we need and put
+   * that into the noderev cache instead.  Note that the in-memory
+   * representation is larger than the on-disk one. */
+  if (!svn_cache__is_cachable(ffd->noderevs_container_cache,
+                              (apr_size_t)entry->size))
+    {
+      /* There is no point in pre-fetching data that can't be cached. */
+      if (!must_read)
+        return SVN_NO_ERROR;
+
+      SVN_ERR(read_item(&stream, fs, rev_file, entry, scratch_pool));
+      SVN_ERR(svn_fs_x__read_noderevs_container_item(noderev_p, stream,
+                                                     sub_item, result_pool,
+                                                     scratch_pool));
+
+      if (sub_item < entry->item_count)
+        {
+          const svn_fs_x__id_t *id = &entry->items[sub_item];
+
+          key.revision = svn_fs_x__get_revnum(id->change_set);
+          key.second = id->number;
+          SVN_ERR(svn_cache__set(ffd->node_revision_cache, &key, *noderev_p,
+                                 scratch_pool));
+        }
+
+      return SVN_NO_ERROR;
+    }
+
   SVN_ERR(read_item(&stream, fs, rev_file, entry, scratch_pool));
 
   /* read noderevs from revision file */
@@ -373,6 +373,26 @@ create_cache(svn_cache__t **cache_p,
   return SVN_NO_ERROR;
 }
 
+/* Serialized items of at least this size will be compressed in caches
+ * that have compression enabled.  Smaller ones don't gain enough. */
+#define COMPRESSION_THRESHOLD 1024
+
+/* If FS has been configured to compress cached texts, enable compression
+ * for CACHE, which may be NULL.
+ */
+static svn_error_t *
+enable_compression(svn_cache__t *cache,
+                   svn_fs_t *fs)
+{
+  svn_fs_x__data_t *ffd = fs->fsap_data;
+
+  if (cache && ffd->compress_cached_texts)
+    SVN_ERR(svn_cache__membuffer_enable_compression(cache,
+                                                    COMPRESSION_THRESHOLD));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_x__initialize_caches(svn_fs_t *fs,
                             apr_pool_t *scratch_pool)
@@ -393,6 +413,7 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
   svn_boolean_t cache_nodeprops;
   const char *cache_namespace;
   svn_boolean_t has_namespace;
+  const char *text_prefix;
 
   /* Evaluating the cache configuration. */
   SVN_ERR(read_config(&cache_namespace,
@@ -407,6 +428,11 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
                        SVN_VA_NULL);
   has_namespace = strlen(cache_namespace) > 0;
 
+  /* Compressed texts must not be mistaken for uncompressed ones. */
+  text_prefix = ffd->compress_cached_texts
+              ? apr_pstrcat(scratch_pool, prefix, "LZ4:", SVN_VA_NULL)
+              : prefix;
+
   membuffer = svn_cache__get_global_membuffer_cache();
 
   /* General rules for assigning cache priorities:
@@ -433,6 +459,23 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
   /* 1st level DAG node cache */
   ffd->dag_node_cache = svn_fs_x__create_dag_cache(fs->pool);
 
+  /* 2nd level DAG cache.  This one is process-wide and allows multiple
+     sessions on the same repository to share their path lookups. */
+  SVN_ERR(create_cache(&(ffd->dag_path_cache),
+                       NULL,
+                       membuffer,
+                       0, 0, /* Do not use inprocess cache */
+                       svn_fs_x__serialize_id,
+                       svn_fs_x__deserialize_id,
+                       APR_HASH_KEY_STRING,
+                       apr_pstrcat(scratch_pool, prefix, "DAG_PATH",
+                                   SVN_VA_NULL),
+                       SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                       has_namespace,
+                       fs,
+                       no_handler, FALSE,
+                       fs->pool, scratch_pool));
+
   /* Very rough estimate: 1K per directory. */
   SVN_ERR(create_cache(&(ffd->dir_cache),
                        NULL,
@@ -504,13 +547,14 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
                        /* Values are svn_stringbuf_t */
                        NULL, NULL,
                        sizeof(svn_fs_x__pair_cache_key_t),
-                       apr_pstrcat(scratch_pool, prefix, "TEXT",
+                       apr_pstrcat(scratch_pool, text_prefix, "TEXT",
                                    SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
                        has_namespace,
                        fs,
                        no_handler, !cache_fulltexts,
                        fs->pool, scratch_pool));
+  SVN_ERR(enable_compression(ffd->fulltext_cache, fs));
 
   SVN_ERR(create_cache(&(ffd->properties_cache),
                        NULL,
@@ -551,13 +595,14 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
                        svn_fs_x__serialize_txdelta_window,
                        svn_fs_x__deserialize_txdelta_window,
                        sizeof(svn_fs_x__window_cache_key_t),
-                       apr_pstrcat(scratch_pool, prefix, "TXDELTA_WINDOW",
+                       apr_pstrcat(scratch_pool, text_prefix, "TXDELTA_WINDOW",
                                    SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_LOW_PRIORITY,
                        has_namespace,
                        fs,
                        no_handler, !cache_txdeltas,
                        fs->pool, scratch_pool));
+  SVN_ERR(enable_compression(ffd->txdelta_window_cache, fs));
 
   SVN_ERR(create_cache(&(ffd->combined_window_cache),
                        NULL,
@@ -566,13 +611,14 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
                        /* Values are svn_stringbuf_t */
                        NULL, NULL,
                        sizeof(svn_fs_x__window_cache_key_t),
-                       apr_pstrcat(scratch_pool, prefix, "COMBINED_WINDOW",
+                       apr_pstrcat(scratch_pool, text_prefix, "COMBINED_WINDOW",
                                    SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_LOW_PRIORITY,
                        has_namespace,
                        fs,
                        no_handler, !cache_txdeltas,
                        fs->pool, scratch_pool));
+  SVN_ERR(enable_compression(ffd->combined_window_cache, fs));
 
   /* Caches for our various container types. */
   SVN_ERR(create_cache(&(ffd->noderevs_container_cache),
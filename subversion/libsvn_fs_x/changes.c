@@ -208,6 +208,16 @@ svn_fs_x__changes_estimate_size(const svn_fs_x__changes_t *changes)
        + 100;
 }
 
+void
+svn_fs_x__changes_get_path_stats(const svn_fs_x__changes_t *changes,
+                                 apr_size_t *count,
+                                 apr_size_t *expanded_size,
+                                 apr_size_t *stored_size)
+{
+  svn_fs_x__string_table_get_stats(changes->paths, count, expanded_size,
+                                   stored_size);
+}
+
 svn_error_t *
 svn_fs_x__changes_get_list(apr_array_header_t **list,
                            const svn_fs_x__changes_t *changes,
@@ -457,6 +467,7 @@ svn_fs_x__changes_get_list_func(void **out,
   int last;
   int i;
   apr_array_header_t *list;
+  svn_stringbuf_t *buffer;
 
   svn_fs_x__changes_get_list_baton_t *b = baton;
   apr_uint32_t idx = b->sub_item;
@@ -498,16 +509,28 @@ svn_fs_x__changes_get_list_func(void **out,
 
   /* construct result */
   list = apr_array_make(pool, last - first, sizeof(svn_fs_x__change_t*));
+  buffer = svn_stringbuf_create_ensure(256, pool);
 
   for (i = first; i < last; ++i)
     {
       const binary_change_t *binary_change = &changes[i];
+      svn_fs_x__change_t *change;
+      apr_size_t path_len;
+      char *path;
+
+      /* Look the path up without copying it and allocate the change struct
+       * and its path in one go. */
+      const char *borrowed_path
+        = svn_fs_x__string_table_get_borrowed_func(paths, binary_change->path,
+                                                   &path_len, buffer);
 
       /* convert BINARY_CHANGE into a standard FSX svn_fs_x__change_t */
-      svn_fs_x__change_t *change = apr_pcalloc(pool, sizeof(*change));
-      change->path.data
-        = svn_fs_x__string_table_get_func(paths, binary_change->path,
-                                          &change->path.len, pool);
+      change = apr_palloc(pool, sizeof(*change) + path_len + 1);
+      memset(change, 0, sizeof(*change));
+      path = (char *)(change + 1);
+      memcpy(path, borrowed_path, path_len + 1);
+      change->path.data = path;
+      change->path.len = path_len;
 
       change->change_kind = (svn_fs_path_change_kind_t)
         ((binary_change->flags & CHANGE_KIND_MASK) >> CHANGE_KIND_SHIFT);
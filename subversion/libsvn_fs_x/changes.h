@@ -69,6 +69,16 @@ svn_fs_x__changes_append_list(apr_size_t *list_index,
 apr_size_t
 svn_fs_x__changes_estimate_size(const svn_fs_x__changes_t *changes);
 
+/* Set *COUNT, *EXPANDED_SIZE and *STORED_SIZE to the statistics of the
+ * path string table in the finalized container CHANGES as described by
+ * svn_fs_x__string_table_get_stats.
+ */
+void
+svn_fs_x__changes_get_path_stats(const svn_fs_x__changes_t *changes,
+                                 apr_size_t *count,
+                                 apr_size_t *expanded_size,
+                                 apr_size_t *stored_size);
+
 /* Read changes containers. */
 
 /* From CHANGES, access the change list with the given IDX and extract the
@@ -466,6 +466,62 @@ svn_fs_x__invalidate_dag_cache(svn_fs_root_t *root,
     }
 }
 
+
+/* 2nd level cache */
+
+/* Return the key under which the node at PATH in the revision ROOT will
+   be stored in the shared DAG path cache.  Allocate it in RESULT_POOL. */
+static const char *
+dag_path_cache_key(svn_fs_root_t *root,
+                   const svn_string_t *path,
+                   apr_pool_t *result_pool)
+{
+  const char *key = apr_pstrmemdup(result_pool, path->data, path->len);
+  return svn_fs_x__combine_number_and_string(root->rev, key, result_pool);
+}
+
+/* Look up KEY, derived from PATH in the revision ROOT, in the shared DAG
+   path cache.  If found, construct the respective DAG node in the first-
+   level cache and return a reference to it in *NODE_P.  Set *NODE_P to
+   NULL otherwise.  Use SCRATCH_POOL for temporary allocations.
+
+   NOTE: *NODE_P will live within the DAG cache and we merely return a
+   reference to it.  Hence, it will invalid upon the next cache insertion.
+   Callers must create a copy if they want a non-temporary object.
+ */
+static svn_error_t *
+dag_path_cache_get(dag_node_t **node_p,
+                   svn_fs_root_t *root,
+                   const svn_string_t *path,
+                   const char *key,
+                   apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = root->fs->fsap_data;
+  svn_fs_x__id_t *node_id;
+  svn_boolean_t found;
+  cache_entry_t *bucket;
+
+  SVN_ERR(svn_cache__get((void **)&node_id, &found, ffd->dag_path_cache,
+                         key, scratch_pool));
+  if (!found)
+    {
+      *node_p = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  /* Auto-insert the node in the 1st level cache. */
+  auto_clear_dag_cache(ffd->dag_node_cache);
+  bucket = cache_lookup(ffd->dag_node_cache,
+                        svn_fs_x__root_change_set(root), path);
+  if (bucket->node == NULL)
+    SVN_ERR(svn_fs_x__dag_get_node(&bucket->node, root->fs, node_id,
+                                   ffd->dag_node_cache->pool,
+                                   scratch_pool));
+
+  *node_p = bucket->node;
+  return SVN_NO_ERROR;
+}
+
 
 /* Traversing directory paths.  */
 
@@ -655,6 +711,7 @@ walk_dag_path(dag_node_t **node_p,
   apr_pool_t *iterpool;
   svn_fs_x__change_set_t change_set = svn_fs_x__root_change_set(root);
   const char *entry;
+  const char *key = NULL;
   svn_string_t directory;
   svn_stringbuf_t *entry_buffer;
 
@@ -704,6 +761,20 @@ walk_dag_path(dag_node_t **node_p,
                                         change_set, FALSE, scratch_pool));
     }
 
+  /* Third attempt: Other sessions on the same repository, possibly in
+     other threads, may have walked the same path before.  Their results
+     are kept in the process-wide 2nd level cache.  As with the first
+     attempt, this only works for committed data. */
+  if (!root->is_txn_root)
+    {
+      key = dag_path_cache_key(root, path, scratch_pool);
+      SVN_ERR(dag_path_cache_get(node_p, root, path, key, scratch_pool));
+
+      /* Did the shortcut work? */
+      if (*node_p)
+        return SVN_NO_ERROR;
+    }
+
   /* Now there is something to iterate over. Thus, create the ITERPOOL. */
   iterpool = svn_pool_create(scratch_pool);
 
@@ -728,6 +799,15 @@ walk_dag_path(dag_node_t **node_p,
   svn_pool_destroy(iterpool);
   *node_p = here;
 
+  /* Share the result of our full walk with other sessions. */
+  if (key)
+    {
+      svn_fs_x__data_t *ffd = root->fs->fsap_data;
+      SVN_ERR(svn_cache__set(ffd->dag_path_cache, key,
+                             (void *)svn_fs_x__dag_get_id(here),
+                             scratch_pool));
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -32,7 +32,6 @@
 #include "svn_delta.h"
 #include "svn_version.h"
 #include "svn_pools.h"
-#include "batch_fsync.h"
 #include "fs.h"
 #include "fs_x.h"
 #include "pack.h"
@@ -48,6 +47,7 @@
 #include "util.h"
 #include "svn_private_config.h"
 #include "private/svn_fs_util.h"
+#include "private/svn_batch_fsync.h"
 
 #include "../libsvn_fs/fs-loader.h"
 
@@ -285,6 +285,49 @@ x_begin_txn(svn_fs_txn_t **txn_p,
 }
 
 
+/* Handler for svn_fs_ioctl() calls on an open filesystem FS.
+   Conforms to fs_vtable_t.ioctl(). */
+static svn_error_t *
+x_ioctl(svn_fs_t *fs, svn_fs_ioctl_code_t ctlcode,
+        void *input_void, void **output_p,
+        svn_cancel_func_t cancel_func,
+        void *cancel_baton,
+        apr_pool_t *result_pool,
+        apr_pool_t *scratch_pool)
+{
+  if (strcmp(ctlcode.fs_type, SVN_FS_TYPE_FSX) == 0)
+    {
+      if (ctlcode.code == SVN_FS_X__IOCTL_GET_STATS.code)
+        {
+          svn_fs_x__ioctl_get_stats_input_t *input = input_void;
+          svn_fs_x__ioctl_get_stats_output_t *output;
+
+          output = apr_pcalloc(result_pool, sizeof(*output));
+          SVN_ERR(svn_fs_x__get_stats(&output->stats, fs,
+                                      input->progress_func,
+                                      input->progress_baton,
+                                      cancel_func, cancel_baton,
+                                      result_pool, scratch_pool));
+          *output_p = output;
+          return SVN_NO_ERROR;
+        }
+      else if (ctlcode.code == SVN_FS_X__IOCTL_DUMP_INDEX.code)
+        {
+          svn_fs_x__ioctl_dump_index_input_t *input = input_void;
+
+          SVN_ERR(svn_fs_x__dump_index(fs, input->revision,
+                                       input->callback_func,
+                                       input->callback_baton,
+                                       cancel_func, cancel_baton,
+                                       scratch_pool));
+          *output_p = NULL;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  return svn_error_create(SVN_ERR_FS_UNRECOGNIZED_IOCTL_CODE, NULL, NULL);
+}
+
 
 /* The vtable associated with a specific open filesystem. */
 static fs_vtable_t fs_vtable = {
@@ -311,7 +354,7 @@ static fs_vtable_t fs_vtable = {
   svn_fs_x__verify_root,
   x_freeze,
   x_set_errcall,
-  NULL /* ioctl */
+  x_ioctl
 };
 
 
@@ -667,7 +710,7 @@ svn_fs_x__init(const svn_version_t *loader_version,
                              loader_version->major);
   SVN_ERR(svn_ver_check_list2(x_version(), checklist, svn_ver_equal));
 
-  SVN_ERR(svn_fs_x__batch_fsync_init(common_pool));
+  SVN_ERR(svn_batch_fsync__init(common_pool));
 
   *vtable = &library_vtable;
   return SVN_NO_ERROR;
@@ -98,12 +98,15 @@ extern "C" {
 /* Names of sections and options in fsx.conf. */
 #define CONFIG_SECTION_CACHES            "caches"
 #define CONFIG_OPTION_FAIL_STOP          "fail-stop"
+#define CONFIG_OPTION_ASYNC_MEMCACHED_WRITES "async-memcached-writes"
+#define CONFIG_OPTION_COMPRESS_CACHED_TEXTS "compress-cached-texts"
 #define CONFIG_SECTION_REP_SHARING       "rep-sharing"
 #define CONFIG_OPTION_ENABLE_REP_SHARING "enable-rep-sharing"
 #define CONFIG_SECTION_DELTIFICATION     "deltification"
 #define CONFIG_OPTION_MAX_DELTIFICATION_WALK     "max-deltification-walk"
 #define CONFIG_OPTION_MAX_LINEAR_DELTIFICATION   "max-linear-deltification"
 #define CONFIG_OPTION_COMPRESSION_LEVEL  "compression-level"
+#define CONFIG_OPTION_REPS_CONTAINER_HASH_SIZE  "reps-container-hash-size"
 #define CONFIG_SECTION_PACKED_REVPROPS   "packed-revprops"
 #define CONFIG_OPTION_REVPROP_PACK_SIZE  "revprop-pack-size"
 #define CONFIG_OPTION_COMPRESS_PACKED_REVPROPS  "compress-packed-revprops"
@@ -121,11 +124,16 @@ extern "C" {
    Note: If you bump this, please update the switch statement in
          svn_fs_x__create() as well.
  */
-#define SVN_FS_X__FORMAT_NUMBER   2
+#define SVN_FS_X__FORMAT_NUMBER   4
 
 /* Latest experimental format number.  Experimental formats are only
    compatible with themselves. */
-#define SVN_FS_X__EXPERIMENTAL_FORMAT_NUMBER   2
+#define SVN_FS_X__EXPERIMENTAL_FORMAT_NUMBER   4
+
+/* The txdelta format used for all representations written in the current
+   format, see svn_txdelta__target_push().  Format 2 windows may be too
+   large for older peers, so they must not be sent over the wire as-is. */
+#define SVN_FS_X__TXDELTA_FORMAT   2
 
 /* On most operating systems apr implements file locks per process, not
    per file.  On Windows apr implements the locking as per file handle
@@ -287,9 +295,20 @@ typedef struct svn_fs_x__data_t
      e.g. memcached may be ignored as caching is an optional feature. */
   svn_boolean_t fail_stop;
 
+  /* If TRUE, store fulltexts and delta windows LZ4-compressed in the
+     membuffer cache. */
+  svn_boolean_t compress_cached_texts;
+
   /* Caches native dag_node_t* instances */
   svn_fs_x__dag_cache_t *dag_node_cache;
 
+  /* 2nd level DAG cache mapping (revision, normalized path) combined by
+     svn_fs_x__combine_number_and_string() to the svn_fs_x__id_t of the
+     node at that location.  Being backed by the global membuffer cache,
+     it is shared between all FS objects and threads accessing the same
+     repository within this process. */
+  svn_cache__t *dag_path_cache;
+
   /* A cache of the contents of immutable directories; maps from
      unparsed FS ID to a apr_hash_t * mapping (const char *) dirent
      names to (svn_fs_x__dirent_t *). */
@@ -394,6 +413,10 @@ typedef struct svn_fs_x__data_t
   /* Compression level to use with txdelta storage format in new revs. */
   int delta_compression_level;
 
+  /* Memory limit in bytes for the matching hash used while building a
+   * representations container during pack.  0 means "no limit". */
+  apr_int64_t reps_container_hash_size;
+
   /* Pack after every commit. */
   svn_boolean_t pack_after_commit;
 
@@ -554,6 +577,18 @@ typedef struct svn_fs_x__changes_context_t
   /* Has the end of the list been reached? */
   svn_boolean_t eol;
 
+  /* Pool that this context has been allocated in. */
+  apr_pool_t *pool;
+
+  /* Decoded changes container holding the list, if the container could
+     not be cached but more blocks remain to be read.  NULL otherwise.
+     Allocated in CONTAINER_POOL, which gets destroyed at EOL. */
+  struct svn_fs_x__changes_t *container;
+  apr_pool_t *container_pool;
+
+  /* Index of the list within CONTAINER. */
+  apr_uint32_t container_sub_item;
+
 } svn_fs_x__changes_context_t;
 
 /*** Directory (only used at the cache interface) ***/
@@ -288,6 +288,17 @@ read_config(svn_fs_x__data_t *ffd,
   ffd->delta_compression_level
     = (int)MIN(MAX(SVN_DELTA_COMPRESSION_LEVEL_NONE, compression_level),
                 SVN_DELTA_COMPRESSION_LEVEL_MAX);
+  SVN_ERR(svn_config_get_int64(config, &ffd->reps_container_hash_size,
+                               CONFIG_SECTION_DELTIFICATION,
+                               CONFIG_OPTION_REPS_CONTAINER_HASH_SIZE,
+                               0));
+  if (ffd->reps_container_hash_size < 0)
+    return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                             _("Negative value for fsx.conf setting '%s'."),
+                             CONFIG_OPTION_REPS_CONTAINER_HASH_SIZE);
+
+  /* convert kBytes to bytes */
+  ffd->reps_container_hash_size *= 0x400;
 
   /* Initialize revprop packing settings in ffd. */
   SVN_ERR(svn_config_get_bool(config, &ffd->compress_packed_revprops,
@@ -346,6 +357,22 @@ read_config(svn_fs_x__data_t *ffd,
                               CONFIG_SECTION_CACHES, CONFIG_OPTION_FAIL_STOP,
                               FALSE));
 
+  if (ffd->memcache)
+    {
+      svn_boolean_t async_writes;
+      SVN_ERR(svn_config_get_bool(config, &async_writes,
+                                  CONFIG_SECTION_CACHES,
+                                  CONFIG_OPTION_ASYNC_MEMCACHED_WRITES,
+                                  FALSE));
+      if (async_writes)
+        SVN_ERR(svn_cache__memcache_enable_async_sets(ffd->memcache));
+    }
+
+  SVN_ERR(svn_config_get_bool(config, &ffd->compress_cached_texts,
+                              CONFIG_SECTION_CACHES,
+                              CONFIG_OPTION_COMPRESS_CACHED_TEXTS,
+                              FALSE));
+
   return SVN_NO_ERROR;
 }
 
@@ -380,6 +407,16 @@ write_config(svn_fs_t *fs,
 "### configured (and ignoring it with file:// access).  To make"             NL
 "### Subversion never ignore cache errors, uncomment this line."             NL
 "# " CONFIG_OPTION_FAIL_STOP " = true"                                       NL
+"### When memcached servers are configured, writes to them normally wait"    NL
+"### for the server's reply.  Uncomment this line to let a background"       NL
+"### thread send them instead.  Cached data may then become visible to"      NL
+"### other processes slightly later and write errors won't be reported."     NL
+"# " CONFIG_OPTION_ASYNC_MEMCACHED_WRITES " = true"                          NL
+"### File contents and deltas are normally kept uncompressed in the"         NL
+"### in-memory cache.  Uncomment this line to store them LZ4-compressed"     NL
+"### instead.  This typically allows for caching two to three times as"      NL
+"### much source code at a small CPU cost.  It has no effect on memcached."  NL
+"# " CONFIG_OPTION_COMPRESS_CACHED_TEXTS " = true"                           NL
 ""                                                                           NL
 "[" CONFIG_SECTION_REP_SHARING "]"                                           NL
 "### To conserve space, the filesystem can optionally avoid storing"         NL
@@ -457,6 +494,16 @@ write_config(svn_fs_t *fs,
 "### and 0 disabling it altogether."                                         NL
 "### The default value is 5."                                                NL
 "# " CONFIG_OPTION_COMPRESSION_LEVEL " = 5"                                  NL
+"###"                                                                        NL
+"### When packing a shard, representations get combined into containers"     NL
+"### that store content shared between them only once.  Finding those"       NL
+"### common parts uses a hash table that grows with the container contents." NL
+"### This setting limits its size (in kBytes) per container.  Lower values"  NL
+"### reduce memory usage during pack but may miss some matches.  A value"    NL
+"### of 0 means there is no limit.  16MB of container text need about"       NL
+"### 4096 kBytes of hash."                                                   NL
+"### The default value is 0."                                                NL
+"# " CONFIG_OPTION_REPS_CONTAINER_HASH_SIZE " = 0"                           NL
 ""                                                                           NL
 "[" CONFIG_SECTION_PACKED_REVPROPS "]"                                       NL
 "### This parameter controls the size (in kBytes) of packed revprop files."  NL
@@ -1272,8 +1319,12 @@ svn_fs_x__info_format(int *fs_format,
     case 2:
       (*supports_version)->minor = 10;
       break;
+    case 3:
+    case 4:
+      (*supports_version)->minor = 15;
+      break;
 #ifdef SVN_DEBUG
-# if SVN_FS_X__FORMAT_NUMBER != 2
+# if SVN_FS_X__FORMAT_NUMBER != 4
 #  error "Need to add a 'case' statement here"
 # endif
 #endif
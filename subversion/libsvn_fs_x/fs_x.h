@@ -24,6 +24,7 @@
 #define SVN_LIBSVN_FS_X_FS_X_H
 
 #include "fs.h"
+#include "private/svn_fs_x_private.h"
 
 /* Read the 'format' file of fsx filesystem FS and store its info in FS.
  * Use SCRATCH_POOL for temporary allocations. */
@@ -217,4 +218,34 @@ svn_error_t *
 svn_fs_x__initialize_caches(svn_fs_t *fs,
                             apr_pool_t *scratch_pool);
 
+/* Scan all contents of the repository FS and return statistics in *STATS,
+ * allocated in RESULT_POOL.  Report progress through PROGRESS_FUNC with
+ * PROGRESS_BATON, if PROGRESS_FUNC is not NULL.  If not NULL, call
+ * CANCEL_FUNC with CANCEL_BATON from time to time.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_x__get_stats(svn_fs_x__stats_t **stats,
+                    svn_fs_t *fs,
+                    svn_fs_progress_notify_func_t progress_func,
+                    void *progress_baton,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool);
+
+/* Read the P2L index for the rev / pack file containing REVISION in FS.
+ * For each index entry, invoke CALLBACK_FUNC with CALLBACK_BATON.
+ * If not NULL, call CANCEL_FUNC with CANCEL_BATON from time to time.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_x__dump_index(svn_fs_t *fs,
+                     svn_revnum_t revision,
+                     svn_fs_x__dump_index_func_t callback_func,
+                     void *callback_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *scratch_pool);
+
 #endif
@@ -30,6 +30,7 @@
 #include "util.h"
 #include "pack.h"
 
+#include "private/svn_adler32.h"
 #include "private/svn_dep_compat.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
@@ -78,6 +79,9 @@ typedef struct l2p_page_table_entry_t
 
   /* size of the page on disk (in the index file) */
   apr_uint32_t size;
+
+  /* Adler32 checksum over the SIZE bytes of on-disk page data */
+  apr_uint32_t checksum;
 } l2p_page_table_entry_t;
 
 /* Master run-time data structure of an log-to-phys index.  It contains
@@ -157,6 +161,9 @@ typedef struct p2l_header_t
 
   /* offsets of the pages / cluster descriptions within the index file */
   apr_off_t *offsets;
+
+  /* Adler32 checksums over the on-disk data of each page description */
+  apr_uint32_t *checksums;
 } p2l_header_t;
 
 /*
@@ -792,10 +799,12 @@ compare_l2p_entries_by_offset(const l2p_page_entry_t *lhs,
 /* Write the log-2-phys index page description for the l2p_page_entry_t
  * array ENTRIES, starting with element START up to but not including END.
  * Write the resulting representation into BUFFER.  Use SCRATCH_POOL for
- * temporary allocations.
+ * temporary allocations.  Return the Adler32 checksum of the encoded
+ * page in *CHECKSUM.
  */
 static svn_error_t *
-encode_l2p_page(apr_array_header_t *entries,
+encode_l2p_page(apr_uint32_t *checksum,
+                apr_array_header_t *entries,
                 int start,
                 int end,
                 svn_spillbuf_t *buffer,
@@ -811,6 +820,9 @@ encode_l2p_page(apr_array_header_t *entries,
   apr_size_t data_size = count * sizeof(l2p_page_entry_t);
   svn_stringbuf_t *container_offsets
     = svn_stringbuf_create_ensure(count * 2, scratch_pool);
+  svn_stringbuf_t *page
+    = svn_stringbuf_create_ensure(count * 4 + ENCODED_INT_LENGTH,
+                                  scratch_pool);
 
   /* SORTED: relevant items from ENTRIES, sorted by offset */
   l2p_page_entry_t *sorted
@@ -847,12 +859,10 @@ encode_l2p_page(apr_array_header_t *entries,
         }
     }
 
-  /* write container list to BUFFER */
-  SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
-                              encode_uint(encoded, container_count),
-                              scratch_pool));
-  SVN_ERR(svn_spillbuf__write(buffer, (const char *)container_offsets->data,
-                              container_offsets->len, scratch_pool));
+  /* write container list to PAGE */
+  svn_stringbuf_appendbytes(page, (const char *)encoded,
+                            encode_uint(encoded, container_count));
+  svn_stringbuf_appendstr(page, container_offsets);
 
   /* encode items */
   for (i = start; i < end; ++i)
@@ -860,7 +870,7 @@ encode_l2p_page(apr_array_header_t *entries,
       l2p_page_entry_t *entry = &APR_ARRAY_IDX(entries, i, l2p_page_entry_t);
       if (entry->offset == 0)
         {
-          SVN_ERR(svn_spillbuf__write(buffer, "\0", 1, scratch_pool));
+          svn_stringbuf_appendbyte(page, 0);
         }
       else
         {
@@ -869,24 +879,25 @@ encode_l2p_page(apr_array_header_t *entries,
           if (void_idx == NULL)
             {
               apr_uint64_t value = entry->offset + container_count;
-              SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
-                                          encode_uint(encoded, value),
-                                          scratch_pool));
+              svn_stringbuf_appendbytes(page, (const char *)encoded,
+                                        encode_uint(encoded, value));
             }
           else
             {
               apr_uintptr_t idx = (apr_uintptr_t)void_idx;
               apr_uint64_t value = entry->sub_item;
-              SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
-                                          encode_uint(encoded, idx),
-                                          scratch_pool));
-              SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
-                                          encode_uint(encoded, value),
-                                          scratch_pool));
+              svn_stringbuf_appendbytes(page, (const char *)encoded,
+                                        encode_uint(encoded, idx));
+              svn_stringbuf_appendbytes(page, (const char *)encoded,
+                                        encode_uint(encoded, value));
             }
         }
     }
 
+  /* checksum the page and write it to BUFFER */
+  *checksum = svn__adler32(1, page->data, page->len);
+  SVN_ERR(svn_spillbuf__write(buffer, page->data, page->len, scratch_pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -920,6 +931,8 @@ svn_fs_x__l2p_index_append(svn_checksum_t **checksum,
     = apr_array_make(local_pool, 16, sizeof(apr_uint64_t));
   apr_array_header_t *entry_counts
     = apr_array_make(local_pool, 16, sizeof(apr_uint64_t));
+  apr_array_header_t *page_checksums
+    = apr_array_make(local_pool, 16, sizeof(apr_uint64_t));
 
   /* collect the item offsets and sub-item value for the current revision */
   apr_array_header_t *entries
@@ -965,16 +978,18 @@ svn_fs_x__l2p_index_append(svn_checksum_t **checksum,
                * our address space. */
               apr_uint64_t last_buffer_size
                 = (apr_uint64_t)svn_spillbuf__get_size(buffer);
+              apr_uint32_t checksum;
 
               svn_pool_clear(iterpool);
 
               entry_count = ffd->l2p_page_size < entries->nelts - i
                           ? (int)ffd->l2p_page_size
                           : entries->nelts - i;
-              SVN_ERR(encode_l2p_page(entries, i, i + entry_count,
+              SVN_ERR(encode_l2p_page(&checksum, entries, i, i + entry_count,
                                       buffer, iterpool));
 
               APR_ARRAY_PUSH(entry_counts, apr_uint64_t) = entry_count;
+              APR_ARRAY_PUSH(page_checksums, apr_uint64_t) = checksum;
               APR_ARRAY_PUSH(page_sizes, apr_uint64_t)
                 = svn_spillbuf__get_size(buffer) - last_buffer_size;
             }
@@ -1053,6 +1068,8 @@ svn_fs_x__l2p_index_append(svn_checksum_t **checksum,
       SVN_ERR(stream_write_encoded(stream, value));
       value = APR_ARRAY_IDX(entry_counts, i, apr_uint64_t);
       SVN_ERR(stream_write_encoded(stream, value));
+      value = APR_ARRAY_IDX(page_checksums, i, apr_uint64_t);
+      SVN_ERR(stream_write_encoded(stream, value));
     }
 
   /* append page contents and implicitly close STREAM */
@@ -1344,6 +1361,12 @@ get_l2p_header_body(l2p_header_t **header,
                                 _("Page exceeds L2P index page size"));
 
       result->page_table[page].entry_count = (apr_uint32_t)value;
+      SVN_ERR(packed_stream_get(&value, stream));
+      if (value > APR_UINT32_MAX)
+        return svn_error_create(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
+                                _("Invalid L2P index page checksum"));
+
+      result->page_table[page].checksum = (apr_uint32_t)value;
     }
 
   /* correct the page description offsets */
@@ -2162,6 +2185,28 @@ svn_fs_x__p2l_proto_index_next_offset(apr_off_t *next_offset,
   return SVN_NO_ERROR;
 }
 
+/* Append the encoded p2l index page description in PAGE to BUFFER and
+ * clear PAGE.  Record its size and Adler32 checksum in TABLE_SIZES and
+ * TABLE_CHECKSUMS, respectively.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+flush_p2l_page(svn_spillbuf_t *buffer,
+               svn_stringbuf_t *page,
+               apr_array_header_t *table_sizes,
+               apr_array_header_t *table_checksums,
+               apr_pool_t *scratch_pool)
+{
+  APR_ARRAY_PUSH(table_sizes, apr_uint64_t) = page->len;
+  APR_ARRAY_PUSH(table_checksums, apr_uint64_t)
+    = svn__adler32(1, page->data, page->len);
+
+  SVN_ERR(svn_spillbuf__write(buffer, page->data, page->len, scratch_pool));
+  svn_stringbuf_setempty(page);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_x__p2l_index_append(svn_checksum_t **checksum,
                            svn_fs_t *fs,
@@ -2182,8 +2227,6 @@ svn_fs_x__p2l_index_append(svn_checksum_t **checksum,
 
   apr_uint64_t last_entry_end = 0;
   apr_uint64_t last_page_end = 0;
-  apr_uint64_t last_buffer_size = 0;  /* byte offset in the spill buffer at
-                                         the begin of the current revision */
   apr_uint64_t file_size = 0;
 
   /* temporary data structures that collect the data which will be moved
@@ -2191,6 +2234,11 @@ svn_fs_x__p2l_index_append(svn_checksum_t **checksum,
   apr_pool_t *local_pool = svn_pool_create(scratch_pool);
   apr_array_header_t *table_sizes
      = apr_array_make(local_pool, 16, sizeof(apr_uint64_t));
+  apr_array_header_t *table_checksums
+     = apr_array_make(local_pool, 16, sizeof(apr_uint64_t));
+
+  /* encoded data of the current page description */
+  svn_stringbuf_t *page = svn_stringbuf_create_empty(local_pool);
 
   /* 64k blocks, spill after 16MB */
   svn_spillbuf_t *buffer
@@ -2209,7 +2257,8 @@ svn_fs_x__p2l_index_append(svn_checksum_t **checksum,
     {
       svn_fs_x__p2l_entry_t entry;
       apr_uint64_t entry_end;
-      svn_boolean_t new_page = svn_spillbuf__get_size(buffer) == 0;
+      svn_boolean_t new_page = svn_spillbuf__get_size(buffer) == 0
+                            && page->len == 0;
       svn_revnum_t last_revision = revision;
       apr_uint64_t last_number = 0;
 
@@ -2258,11 +2307,8 @@ svn_fs_x__p2l_index_append(svn_checksum_t **checksum,
       entry_end = entry.offset + entry.size;
       while (entry_end - last_page_end > page_size)
         {
-          apr_uint64_t buffer_size = svn_spillbuf__get_size(buffer);
-          APR_ARRAY_PUSH(table_sizes, apr_uint64_t)
-             = buffer_size - last_buffer_size;
-
-          last_buffer_size = buffer_size;
+          SVN_ERR(flush_p2l_page(buffer, page, table_sizes, table_checksums,
+                                 iterpool));
           last_page_end += page_size;
           new_page = TRUE;
         }
@@ -2271,23 +2317,19 @@ svn_fs_x__p2l_index_append(svn_checksum_t **checksum,
          (all following entries in the same table will store sizes only) */
       if (new_page)
         {
-          SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
-                                      encode_uint(encoded, entry.offset),
-                                      iterpool));
+          svn_stringbuf_appendbytes(page, (const char *)encoded,
+                                    encode_uint(encoded, entry.offset));
           last_revision = revision;
         }
 
       /* write simple item / container entry */
-      SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
-                                  encode_uint(encoded, entry.size),
-                                  iterpool));
-      SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
-                                  encode_uint(encoded, entry.type
-                                                     + entry.item_count * 16),
-                                  iterpool));
-      SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
-                                  encode_uint(encoded, entry.fnv1_checksum),
-                                  iterpool));
+      svn_stringbuf_appendbytes(page, (const char *)encoded,
+                                encode_uint(encoded, entry.size));
+      svn_stringbuf_appendbytes(page, (const char *)encoded,
+                                encode_uint(encoded, entry.type
+                                                   + entry.item_count * 16));
+      svn_stringbuf_appendbytes(page, (const char *)encoded,
+                                encode_uint(encoded, entry.fnv1_checksum));
 
       /* container contents (only one for non-container items) */
       for (sub_item = 0; sub_item < entry.item_count; ++sub_item)
@@ -2295,18 +2337,16 @@ svn_fs_x__p2l_index_append(svn_checksum_t **checksum,
           svn_revnum_t item_rev
             = svn_fs_x__get_revnum(entry.items[sub_item].change_set);
           apr_int64_t diff = item_rev - last_revision;
-          SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
-                                      encode_int(encoded, diff),
-                                      iterpool));
+          svn_stringbuf_appendbytes(page, (const char *)encoded,
+                                    encode_int(encoded, diff));
           last_revision = item_rev;
         }
 
       for (sub_item = 0; sub_item < entry.item_count; ++sub_item)
         {
           apr_int64_t diff = entry.items[sub_item].number - last_number;
-          SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
-                                      encode_int(encoded, diff),
-                                      iterpool));
+          svn_stringbuf_appendbytes(page, (const char *)encoded,
+                                    encode_int(encoded, diff));
           last_number = entry.items[sub_item].number;
         }
 
@@ -2316,9 +2356,9 @@ svn_fs_x__p2l_index_append(svn_checksum_t **checksum,
   /* close the source file */
   SVN_ERR(svn_io_file_close(proto_index, local_pool));
 
-  /* store length of last table */
-  APR_ARRAY_PUSH(table_sizes, apr_uint64_t)
-      = svn_spillbuf__get_size(buffer) - last_buffer_size;
+  /* store the last table */
+  SVN_ERR(flush_p2l_page(buffer, page, table_sizes, table_checksums,
+                         local_pool));
 
   /* Open target stream. */
   stream = svn_stream_checksummed2(svn_stream_from_aprfile2(index_file, TRUE,
@@ -2332,12 +2372,15 @@ svn_fs_x__p2l_index_append(svn_checksum_t **checksum,
   SVN_ERR(stream_write_encoded(stream, file_size));
   SVN_ERR(stream_write_encoded(stream, page_size));
 
-  /* write the page table (actually, the sizes of each page description) */
+  /* write the page table (actually, the sizes and checksums of each
+   * page description) */
   SVN_ERR(stream_write_encoded(stream, table_sizes->nelts));
   for (i = 0; i < table_sizes->nelts; ++i)
     {
       apr_uint64_t value = APR_ARRAY_IDX(table_sizes, i, apr_uint64_t);
       SVN_ERR(stream_write_encoded(stream, value));
+      value = APR_ARRAY_IDX(table_checksums, i, apr_uint64_t);
+      SVN_ERR(stream_write_encoded(stream, value));
     }
 
   /* append page contents and implicitly close STREAM */
@@ -2508,6 +2551,8 @@ get_p2l_header(p2l_header_t **header,
 
   result->offsets
     = apr_pcalloc(result_pool, (result->page_count + 1) * sizeof(*result->offsets));
+  result->checksums
+    = apr_pcalloc(result_pool, result->page_count * sizeof(*result->checksums));
 
   /* read page sizes and derive page description offsets from them */
   result->offsets[0] = 0;
@@ -2515,6 +2560,13 @@ get_p2l_header(p2l_header_t **header,
     {
       SVN_ERR(packed_stream_get(&value, stream));
       result->offsets[i+1] = result->offsets[i] + (apr_off_t)value;
+
+      SVN_ERR(packed_stream_get(&value, stream));
+      if (value > APR_UINT32_MAX)
+        return svn_error_create(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
+                                _("Invalid P2L index page checksum"));
+
+      result->checksums[i] = (apr_uint32_t)value;
     }
 
   /* correct the offset values */
@@ -3433,6 +3485,159 @@ svn_fs_x__item_offset(apr_off_t *absolute_position,
   return SVN_NO_ERROR;
 }
 
+/* Read the SIZE bytes of index data at the index stream relative OFFSET
+ * in REV_FILE and return their Adler32 checksum in *CHECKSUM.  The index
+ * stream starts at STREAM_START and ends at STREAM_END.  Use SCRATCH_POOL
+ * for temporary allocations.
+ */
+static svn_error_t *
+calc_page_checksum(apr_uint32_t *checksum,
+                   svn_fs_x__revision_file_t *rev_file,
+                   apr_off_t stream_start,
+                   apr_off_t stream_end,
+                   apr_off_t offset,
+                   apr_size_t size,
+                   apr_pool_t *scratch_pool)
+{
+  char *data;
+
+  if (offset < 0 || stream_start + offset + (apr_off_t)size > stream_end)
+    return svn_error_create(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
+                            _("Index page extends beyond the index data"));
+
+  data = apr_palloc(scratch_pool, size);
+  SVN_ERR(svn_fs_x__rev_file_seek(rev_file, NULL, stream_start + offset));
+  SVN_ERR(svn_fs_x__rev_file_read(rev_file, data, size));
+  *checksum = svn__adler32(1, data, size);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_x__l2p_index_verify_pages(svn_fs_t *fs,
+                                 svn_fs_x__revision_file_t *rev_file,
+                                 svn_cancel_func_t cancel_func,
+                                 void *cancel_baton,
+                                 apr_pool_t *scratch_pool)
+{
+  l2p_header_t *header;
+  svn_fs_x__rev_file_info_t file_info;
+  svn_fs_x__index_info_t index_info;
+  apr_off_t stream_start;
+  apr_size_t page, page_count;
+  apr_size_t rel_revision = 0;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(svn_fs_x__rev_file_info(&file_info, rev_file));
+  SVN_ERR(svn_fs_x__rev_file_l2p_info(&index_info, rev_file));
+  SVN_ERR(get_l2p_header(&header, rev_file, fs, file_info.start_revision,
+                         scratch_pool, scratch_pool));
+
+  /* Page offsets are relative to the end of the stream prefix. */
+  stream_start = index_info.start + strlen(SVN_FS_X__L2P_STREAM_PREFIX);
+  page_count = header->page_table_index[header->revision_count];
+  for (page = 0; page < page_count; ++page)
+    {
+      const l2p_page_table_entry_t *entry = &header->page_table[page];
+      apr_uint32_t actual;
+
+      svn_pool_clear(iterpool);
+
+      /* Which revision does this page belong to? */
+      while (header->page_table_index[rel_revision + 1] <= page)
+        ++rel_revision;
+
+      SVN_ERR(calc_page_checksum(&actual, rev_file, stream_start,
+                                 index_info.end, entry->offset, entry->size,
+                                 iterpool));
+      if (actual != entry->checksum)
+        {
+          const char *file_name;
+          SVN_ERR(svn_fs_x__rev_file_name(&file_name, rev_file, iterpool));
+
+          return svn_error_createf(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
+                       _("Checksum mismatch in L2P index page %s of r%ld "
+                         "in file %s:\n"
+                         "   expected:  %08x\n"
+                         "     actual:  %08x\n"),
+                       apr_psprintf(iterpool, "%" APR_SIZE_T_FMT,
+                                    page - header->page_table_index
+                                                             [rel_revision]),
+                       header->first_revision + (svn_revnum_t)rel_revision,
+                       file_name, entry->checksum, actual);
+        }
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_x__p2l_index_verify_pages(svn_fs_t *fs,
+                                 svn_fs_x__revision_file_t *rev_file,
+                                 svn_cancel_func_t cancel_func,
+                                 void *cancel_baton,
+                                 apr_pool_t *scratch_pool)
+{
+  p2l_header_t *header;
+  svn_fs_x__rev_file_info_t file_info;
+  svn_fs_x__index_info_t index_info;
+  apr_off_t stream_start;
+  apr_size_t page;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(svn_fs_x__rev_file_info(&file_info, rev_file));
+  SVN_ERR(svn_fs_x__rev_file_p2l_info(&index_info, rev_file));
+  SVN_ERR(get_p2l_header(&header, rev_file, fs, file_info.start_revision,
+                         scratch_pool, scratch_pool));
+
+  /* Page offsets are relative to the end of the stream prefix. */
+  stream_start = index_info.start + strlen(SVN_FS_X__P2L_STREAM_PREFIX);
+  for (page = 0; page < header->page_count; ++page)
+    {
+      apr_off_t offset = header->offsets[page];
+      apr_off_t size = header->offsets[page + 1] - offset;
+      apr_uint32_t actual;
+
+      svn_pool_clear(iterpool);
+
+      if (size < 0)
+        return svn_error_create(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
+                                _("Negative P2L index page size"));
+
+      SVN_ERR(calc_page_checksum(&actual, rev_file, stream_start,
+                                 index_info.end, offset, (apr_size_t)size,
+                                 iterpool));
+      if (actual != header->checksums[page])
+        {
+          const char *file_name;
+          apr_uint64_t first = page * header->page_size;
+          SVN_ERR(svn_fs_x__rev_file_name(&file_name, rev_file, iterpool));
+
+          return svn_error_createf(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
+                       _("Checksum mismatch in P2L index page for "
+                         "offsets %s to %s in file %s:\n"
+                         "   expected:  %08x\n"
+                         "     actual:  %08x\n"),
+                       apr_psprintf(iterpool, "%" APR_UINT64_T_FMT, first),
+                       apr_psprintf(iterpool, "%" APR_UINT64_T_FMT,
+                                    first + header->page_size - 1),
+                       file_name, header->checksums[page], actual);
+        }
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Calculate the FNV1 checksum over the offset range in REV_FILE, covered by
  * ENTRY.  Store the result in ENTRY->FNV1_CHECKSUM.  Use SCRATCH_POOL for
  * temporary allocations. */
@@ -3825,17 +4030,22 @@ svn_fs_x__serialize_p2l_header(void **data,
   svn_temp_serializer__context_t *context;
   svn_stringbuf_t *serialized;
   apr_size_t table_size = (header->page_count + 1) * sizeof(*header->offsets);
+  apr_size_t checksums_size = header->page_count * sizeof(*header->checksums);
 
   /* serialize header and all its elements */
   context = svn_temp_serializer__init(header,
                                       sizeof(*header),
-                                      table_size + sizeof(*header) + 32,
+                                        table_size + checksums_size
+                                      + sizeof(*header) + 32,
                                       pool);
 
-  /* offsets array */
+  /* offsets and checksums arrays */
   svn_temp_serializer__add_leaf(context,
                                 (const void * const *)&header->offsets,
                                 table_size);
+  svn_temp_serializer__add_leaf(context,
+                                (const void * const *)&header->checksums,
+                                checksums_size);
 
   /* return the serialized result */
   serialized = svn_temp_serializer__get(context);
@@ -3854,8 +4064,9 @@ svn_fs_x__deserialize_p2l_header(void **out,
 {
   p2l_header_t *header = data;
 
-  /* resolve the only pointer in the struct */
+  /* resolve the pointers in the struct */
   svn_temp_deserializer__resolve(header, (void**)&header->offsets);
+  svn_temp_deserializer__resolve(header, (void**)&header->checksums);
 
   /* done */
   *out = header;
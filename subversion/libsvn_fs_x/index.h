@@ -304,6 +304,31 @@ svn_fs_x__p2l_get_max_offset(apr_off_t *offset,
                              svn_revnum_t revision,
                              apr_pool_t *scratch_pool);
 
+/* Verify the Adler32 checksums of all log-to-phys index pages in REV_FILE
+ * of FS.  Return SVN_ERR_FS_INDEX_CORRUPTION identifying the page and its
+ * revision upon the first mismatch.  If given, invoke CANCEL_FUNC with
+ * CANCEL_BATON for every page.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_x__l2p_index_verify_pages(svn_fs_t *fs,
+                                 svn_fs_x__revision_file_t *rev_file,
+                                 svn_cancel_func_t cancel_func,
+                                 void *cancel_baton,
+                                 apr_pool_t *scratch_pool);
+
+/* Verify the Adler32 checksums of all phys-to-log index pages in REV_FILE
+ * of FS.  Return SVN_ERR_FS_INDEX_CORRUPTION identifying the rev / pack
+ * file range covered by the page upon the first mismatch.  If given, invoke
+ * CANCEL_FUNC with CANCEL_BATON for every page.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+svn_error_t *
+svn_fs_x__p2l_index_verify_pages(svn_fs_t *fs,
+                                 svn_fs_x__revision_file_t *rev_file,
+                                 svn_cancel_func_t cancel_func,
+                                 void *cancel_baton,
+                                 apr_pool_t *scratch_pool);
+
 /* Index (re-)creation utilities.
  */
 
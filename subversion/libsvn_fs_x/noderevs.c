@@ -300,6 +300,16 @@ svn_fs_x__noderevs_estimate_size(const svn_fs_x__noderevs_t *container)
        + 100;
 }
 
+void
+svn_fs_x__noderevs_get_path_stats(const svn_fs_x__noderevs_t *container,
+                                  apr_size_t *count,
+                                  apr_size_t *expanded_size,
+                                  apr_size_t *stored_size)
+{
+  svn_fs_x__string_table_get_stats(container->paths, count, expanded_size,
+                                   stored_size);
+}
+
 /* Set *ID to the ID part stored at index IDX in IDS.
  */
 static svn_error_t *
@@ -579,13 +589,15 @@ svn_fs_x__write_noderevs_container(svn_stream_t *stream,
 }
 
 /* Allocate a svn_fs_x__representation_t array in RESULT_POOL and return it
- * in REPS_P.  Deserialize the data in REP_STREAM and DIGEST_STREAM and store
- * the resulting representations into the *REPS_P.
+ * in REPS_P.  Deserialize the first LIMIT representations in REP_STREAM
+ * and DIGEST_STREAM and store them into the *REPS_P.  If LIMIT exceeds
+ * the number of representations in REP_STREAM, read all of them.
  */
 static svn_error_t *
 read_reps(apr_array_header_t **reps_p,
           svn_packed__int_stream_t *rep_stream,
           svn_packed__byte_stream_t *digest_stream,
+          apr_size_t limit,
           apr_pool_t *result_pool)
 {
   apr_size_t i;
@@ -594,9 +606,11 @@ read_reps(apr_array_header_t **reps_p,
 
   apr_size_t count
     = svn_packed__int_count(svn_packed__first_int_substream(rep_stream));
-  apr_array_header_t *reps
-    = apr_array_make(result_pool, (int)count,
-                     sizeof(svn_fs_x__representation_t));
+  apr_array_header_t *reps;
+
+  count = MIN(count, limit);
+  reps = apr_array_make(result_pool, (int)count,
+                        sizeof(svn_fs_x__representation_t));
 
   for (i = 0; i < count; ++i)
     {
@@ -643,42 +657,23 @@ read_reps(apr_array_header_t **reps_p,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_fs_x__read_noderevs_container(svn_fs_x__noderevs_t **container,
-                                  svn_stream_t *stream,
-                                  apr_pool_t *result_pool,
-                                  apr_pool_t *scratch_pool)
+/* Allocate a svn_fs_x__id_t array in RESULT_POOL and return it in *IDS_P.
+ * Deserialize the first LIMIT IDs in IDS_STREAM into it.  If LIMIT exceeds
+ * the number of IDs in IDS_STREAM, read all of them.
+ */
+static void
+read_ids(apr_array_header_t **ids_p,
+         svn_packed__int_stream_t *ids_stream,
+         apr_size_t limit,
+         apr_pool_t *result_pool)
 {
   apr_size_t i;
-  apr_size_t count;
-
-  svn_fs_x__noderevs_t *noderevs
-    = apr_pcalloc(result_pool, sizeof(*noderevs));
-
-  svn_packed__data_root_t *root;
-  svn_packed__int_stream_t *structs_stream;
-  svn_packed__int_stream_t *ids_stream;
-  svn_packed__int_stream_t *reps_stream;
-  svn_packed__int_stream_t *noderevs_stream;
-  svn_packed__byte_stream_t *digests_stream;
-
-  /* read everything from disk */
-  SVN_ERR(svn_fs_x__read_string_table(&noderevs->paths, stream,
-                                      result_pool, scratch_pool));
-  SVN_ERR(svn_packed__data_read(&root, stream, result_pool, scratch_pool));
-
-  /* get streams */
-  structs_stream = svn_packed__first_int_stream(root);
-  ids_stream = svn_packed__first_int_substream(structs_stream);
-  reps_stream = svn_packed__next_int_stream(ids_stream);
-  noderevs_stream = svn_packed__next_int_stream(reps_stream);
-  digests_stream = svn_packed__first_byte_stream(root);
-
-  /* read ids array */
-  count
+  apr_size_t count
     = svn_packed__int_count(svn_packed__first_int_substream(ids_stream));
-  noderevs->ids
-    = apr_array_make(result_pool, (int)count, sizeof(svn_fs_x__id_t));
+  apr_array_header_t *ids;
+
+  count = MIN(count, limit);
+  ids = apr_array_make(result_pool, (int)count, sizeof(svn_fs_x__id_t));
   for (i = 0; i < count; ++i)
     {
       svn_fs_x__id_t id;
@@ -686,18 +681,30 @@ svn_fs_x__read_noderevs_container(svn_fs_x__noderevs_t **container,
       id.change_set = (svn_revnum_t)svn_packed__get_int(ids_stream);
       id.number = svn_packed__get_uint(ids_stream);
 
-      APR_ARRAY_PUSH(noderevs->ids, svn_fs_x__id_t) = id;
+      APR_ARRAY_PUSH(ids, svn_fs_x__id_t) = id;
     }
 
-  /* read rep arrays */
-  SVN_ERR(read_reps(&noderevs->reps, reps_stream, digests_stream,
-                    result_pool));
+  *ids_p = ids;
+}
 
-  /* read noderevs array */
-  count
+/* Allocate a binary_noderev_t array in RESULT_POOL and return it in
+ * *NODEREVS_P.  Deserialize the first LIMIT noderevs in NODEREVS_STREAM
+ * into it.  If LIMIT exceeds the number of noderevs in NODEREVS_STREAM,
+ * read all of them.
+ */
+static void
+read_noderevs(apr_array_header_t **noderevs_p,
+              svn_packed__int_stream_t *noderevs_stream,
+              apr_size_t limit,
+              apr_pool_t *result_pool)
+{
+  apr_size_t i;
+  apr_size_t count
     = svn_packed__int_count(svn_packed__first_int_substream(noderevs_stream));
-  noderevs->noderevs
-    = apr_array_make(result_pool, (int)count, sizeof(binary_noderev_t));
+  apr_array_header_t *noderevs;
+
+  count = MIN(count, limit);
+  noderevs = apr_array_make(result_pool, (int)count, sizeof(binary_noderev_t));
   for (i = 0; i < count; ++i)
     {
       binary_noderev_t noderev;
@@ -721,14 +728,136 @@ svn_fs_x__read_noderevs_container(svn_fs_x__noderevs_t **container,
       noderev.created_path = (apr_size_t)svn_packed__get_uint(noderevs_stream);
       noderev.mergeinfo_count = svn_packed__get_uint(noderevs_stream);
 
-      APR_ARRAY_PUSH(noderevs->noderevs, binary_noderev_t) = noderev;
+      APR_ARRAY_PUSH(noderevs, binary_noderev_t) = noderev;
     }
 
+  *noderevs_p = noderevs;
+}
+
+/* Read the string table and the packed data of a noderev container from
+ * STREAM.  Allocate the container struct in RESULT_POOL, fill in its PATHS
+ * and return it in *CONTAINER.  Return the packed stream root in *ROOT,
+ * also allocated in RESULT_POOL.  Use SCRATCH_POOL for temporaries.
+ *
+ * The column data will remain encoded in *ROOT until the caller extracts
+ * the parts it needs.
+ */
+static svn_error_t *
+read_container_raw(svn_fs_x__noderevs_t **container,
+                   svn_packed__data_root_t **root,
+                   svn_stream_t *stream,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  svn_fs_x__noderevs_t *noderevs
+    = apr_pcalloc(result_pool, sizeof(*noderevs));
+
+  SVN_ERR(svn_fs_x__read_string_table(&noderevs->paths, stream,
+                                      result_pool, scratch_pool));
+  SVN_ERR(svn_packed__data_read(root, stream, result_pool, scratch_pool));
+
+  *container = noderevs;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_x__read_noderevs_container(svn_fs_x__noderevs_t **container,
+                                  svn_stream_t *stream,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool)
+{
+  svn_fs_x__noderevs_t *noderevs;
+
+  svn_packed__data_root_t *root;
+  svn_packed__int_stream_t *structs_stream;
+  svn_packed__int_stream_t *ids_stream;
+  svn_packed__int_stream_t *reps_stream;
+  svn_packed__int_stream_t *noderevs_stream;
+  svn_packed__byte_stream_t *digests_stream;
+
+  /* read everything from disk */
+  SVN_ERR(read_container_raw(&noderevs, &root, stream, result_pool,
+                             scratch_pool));
+
+  /* get streams */
+  structs_stream = svn_packed__first_int_stream(root);
+  ids_stream = svn_packed__first_int_substream(structs_stream);
+  reps_stream = svn_packed__next_int_stream(ids_stream);
+  noderevs_stream = svn_packed__next_int_stream(reps_stream);
+  digests_stream = svn_packed__first_byte_stream(root);
+
+  /* decode all arrays */
+  read_ids(&noderevs->ids, ids_stream, APR_SIZE_MAX, result_pool);
+  SVN_ERR(read_reps(&noderevs->reps, reps_stream, digests_stream,
+                    APR_SIZE_MAX, result_pool));
+  read_noderevs(&noderevs->noderevs, noderevs_stream, APR_SIZE_MAX,
+                result_pool);
+
   *container = noderevs;
 
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_x__read_noderevs_container_item(svn_fs_x__noderev_t **noderev_p,
+                                       svn_stream_t *stream,
+                                       apr_size_t idx,
+                                       apr_pool_t *result_pool,
+                                       apr_pool_t *scratch_pool)
+{
+  svn_fs_x__noderevs_t *noderevs;
+  const binary_noderev_t *noderev;
+  apr_size_t id_limit;
+  apr_size_t rep_limit;
+
+  svn_packed__data_root_t *root;
+  svn_packed__int_stream_t *structs_stream;
+  svn_packed__int_stream_t *ids_stream;
+  svn_packed__int_stream_t *reps_stream;
+  svn_packed__int_stream_t *noderevs_stream;
+  svn_packed__byte_stream_t *digests_stream;
+
+  /* read everything from disk but don't decode it, yet */
+  SVN_ERR(read_container_raw(&noderevs, &root, stream, scratch_pool,
+                             scratch_pool));
+
+  /* get streams */
+  structs_stream = svn_packed__first_int_stream(root);
+  ids_stream = svn_packed__first_int_substream(structs_stream);
+  reps_stream = svn_packed__next_int_stream(ids_stream);
+  noderevs_stream = svn_packed__next_int_stream(reps_stream);
+  digests_stream = svn_packed__first_byte_stream(root);
+
+  /* The columns are sequences of variable-length numbers, i.e. we can't
+   * seek to IDX directly.  But we can stop as soon as we reached it. */
+  read_noderevs(&noderevs->noderevs, noderevs_stream,
+                idx < APR_SIZE_MAX ? idx + 1 : idx, scratch_pool);
+
+  /* Out-of-range indexes will be reported by svn_fs_x__noderevs_get. */
+  if (idx < (apr_size_t)noderevs->noderevs->nelts)
+    {
+      /* Only decode the IDs and representations referenced by IDX.
+       * All indexes are 1-based. */
+      noderev = &APR_ARRAY_IDX(noderevs->noderevs, idx, binary_noderev_t);
+      id_limit = MAX(MAX(noderev->id, noderev->node_id),
+                     MAX(noderev->copy_id, noderev->predecessor_id));
+      rep_limit = MAX(noderev->prop_rep, noderev->data_rep);
+    }
+  else
+    {
+      id_limit = 0;
+      rep_limit = 0;
+    }
+
+  read_ids(&noderevs->ids, ids_stream, id_limit, scratch_pool);
+  SVN_ERR(read_reps(&noderevs->reps, reps_stream, digests_stream,
+                    rep_limit, scratch_pool));
+
+  return svn_error_trace(svn_fs_x__noderevs_get(noderev_p, noderevs, idx,
+                                                result_pool));
+}
+
 svn_error_t *
 svn_fs_x__serialize_noderevs_container(void **data,
                                        apr_size_t *data_len,
@@ -875,9 +1004,14 @@ svn_fs_x__noderevs_get_func(void **out,
   SVN_ERR(get_representation(&noderev->data_rep, &reps,
                              binary_noderev->data_rep, pool));
 
+  /* Copy roots are often the node itself.  The string table stores each
+   * path only once, i.e. the same index means the same path. */
   if (binary_noderev->flags & NODEREV_HAS_CPATH)
     noderev->created_path
-      = svn_fs_x__string_table_get_func(paths,
+      = (   (binary_noderev->flags & NODEREV_HAS_COPYROOT)
+         && binary_noderev->created_path == binary_noderev->copyroot_path)
+      ? noderev->copyroot_path
+      : svn_fs_x__string_table_get_func(paths,
                                         binary_noderev->created_path,
                                         NULL,
                                         pool);
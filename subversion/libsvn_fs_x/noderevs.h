@@ -67,6 +67,16 @@ svn_fs_x__noderevs_add(svn_fs_x__noderevs_t *container,
 apr_size_t
 svn_fs_x__noderevs_estimate_size(const svn_fs_x__noderevs_t *container);
 
+/* Set *COUNT, *EXPANDED_SIZE and *STORED_SIZE to the statistics of the
+ * path string table in the finalized CONTAINER as described by
+ * svn_fs_x__string_table_get_stats.
+ */
+void
+svn_fs_x__noderevs_get_path_stats(const svn_fs_x__noderevs_t *container,
+                                  apr_size_t *count,
+                                  apr_size_t *expanded_size,
+                                  apr_size_t *stored_size);
+
 /* Read from noderev containers. */
 
 /* From CONTAINER, extract the noderev with the given IDX.  Allocate
@@ -98,6 +108,19 @@ svn_fs_x__read_noderevs_container(svn_fs_x__noderevs_t **container,
                                    apr_pool_t *result_pool,
                                    apr_pool_t *scratch_pool);
 
+/* Read the noderev at index IDX from the serialized noderev container in
+ * STREAM and return it in *NODEREV_P, allocated in RESULT_POOL.  In contrast
+ * to svn_fs_x__read_noderevs_container, this only decodes the container
+ * data up to IDX and what that noderev references.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+svn_error_t *
+svn_fs_x__read_noderevs_container_item(svn_fs_x__noderev_t **noderev_p,
+                                       svn_stream_t *stream,
+                                       apr_size_t idx,
+                                       apr_pool_t *result_pool,
+                                       apr_pool_t *scratch_pool);
+
 /* Implements #svn_cache__serialize_func_t for svn_fs_x__noderevs_t
  * objects.
  */
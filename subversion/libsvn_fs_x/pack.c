@@ -65,6 +65,10 @@
  * revision files to temporary files.  The latter serve as buckets for a
  * very coarse bucket presort:  Separate change lists, file properties,
  * directory properties and noderevs + representations from one another.
+ * Each revision file is read strictly front to back.  Representations that
+ * may end up in a reps container get expanded while we are at it and their
+ * fulltexts go into one more bucket.  Thus, the later steps will only need
+ * to read from the temporary files and never from the repository.
  *
  * The third step will determine an optimized placement for the items in
  * each of the 4 buckets separately.  The first three will simply order
@@ -116,6 +120,20 @@ typedef struct path_order_t
   svn_fs_x__id_t rep_id;
 } path_order_t;
 
+/* Location of an expanded representation in the fulltext bucket.
+ */
+typedef struct fulltext_t
+{
+  /* ID of the representation item.  Used as hash key. */
+  svn_fs_x__id_t id;
+
+  /* position of the fulltext within the bucket file */
+  apr_off_t offset;
+
+  /* length of the fulltext in bytes */
+  apr_size_t size;
+} fulltext_t;
+
 /* Represents a reference from item FROM to item TO.  FROM may be a noderev
  * or rep_id while TO is (currently) always a representation.  We will sort
  * them by TO which allows us to collect all dependent items.
@@ -225,6 +243,15 @@ typedef struct pack_context_t
    * Will be filled in phase 2 and be cleared after each revision range.*/
   apr_file_t *reps_file;
 
+  /* svn_fs_x__id_t -> fulltext_t *, for all property and small data
+   * representations that have been expanded into FULLTEXTS_FILE.
+   * Will be filled in phase 2 and be cleared after each revision range. */
+  apr_hash_t *fulltexts;
+
+  /* temp file receiving the fulltexts referenced by FULLTEXTS.
+   * Will be filled in phase 2 and be cleared after each revision range.*/
+  apr_file_t *fulltexts_file;
+
   /* pool used for temporary data structures that will be cleaned up when
    * the next range of revisions is being processed */
   apr_pool_t *info_pool;
@@ -244,7 +271,7 @@ initialize_pack_context(pack_context_t *context,
                         const char *shard_dir,
                         svn_revnum_t shard_rev,
                         int max_items,
-                        svn_fs_x__batch_fsync_t *batch,
+                        svn_batch_fsync__t *batch,
                         svn_cancel_func_t cancel_func,
                         void *cancel_baton,
                         apr_pool_t *pool)
@@ -274,8 +301,8 @@ initialize_pack_context(pack_context_t *context,
   context->pack_file_path
     = svn_dirent_join(pack_file_dir, PATH_PACKED, pool);
 
-  SVN_ERR(svn_fs_x__batch_fsync_open_file(&context->pack_file, batch,
-                                          context->pack_file_path, pool));
+  SVN_ERR(svn_batch_fsync__open_file(&context->pack_file, batch,
+                                     context->pack_file_path, pool));
 
   /* Proto index files */
   SVN_ERR(svn_fs_x__l2p_proto_index_open(
@@ -316,9 +343,14 @@ initialize_pack_context(pack_context_t *context,
   SVN_ERR(svn_io_open_unique_file3(&context->reps_file, NULL, temp_dir,
                                    svn_io_file_del_on_close, pool, pool));
 
+  /* expanded representations bucket */
+  SVN_ERR(svn_io_open_unique_file3(&context->fulltexts_file, NULL, temp_dir,
+                                   svn_io_file_del_on_close, pool, pool));
+
   /* the pool used for temp structures */
   context->info_pool = svn_pool_create(pool);
   context->paths = svn_prefix_tree__create(context->info_pool);
+  context->fulltexts = apr_hash_make(context->info_pool);
 
   return SVN_NO_ERROR;
 }
@@ -342,9 +374,11 @@ reset_pack_context(pack_context_t *context,
   apr_array_clear(context->references);
   apr_array_clear(context->reps);
   SVN_ERR(svn_io_file_trunc(context->reps_file, 0, scratch_pool));
+  SVN_ERR(svn_io_file_trunc(context->fulltexts_file, 0, scratch_pool));
 
   svn_pool_clear(context->info_pool);
   context->paths = svn_prefix_tree__create(context->info_pool);
+  context->fulltexts = apr_hash_make(context->info_pool);
 
   return SVN_NO_ERROR;
 }
@@ -604,6 +638,117 @@ copy_rep_to_temp(pack_context_t *context,
   return SVN_NO_ERROR;
 }
 
+/* If the representation identified by ENTRY in REV_FILE may later be put
+ * into a reps container, expand it and append the fulltext to
+ * CONTEXT->FULLTEXTS_FILE.  Doing this while we stream through REV_FILE
+ * anyway means that the delta bases are most likely still hot and that we
+ * won't have to go back to the repository when writing the containers.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+copy_fulltext_to_temp(pack_context_t *context,
+                      svn_fs_x__revision_file_t *rev_file,
+                      svn_fs_x__p2l_entry_t *entry,
+                      apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = context->fs->fsap_data;
+  svn_fs_x__representation_t representation = { 0 };
+  svn_stringbuf_t *contents;
+  svn_stream_t *stream;
+  fulltext_t *fulltext;
+
+  assert(entry->item_count == 1);
+  representation.id = entry->items[0];
+
+  SVN_ERR(svn_fs_x__rev_file_seek(rev_file, NULL, entry->offset));
+  SVN_ERR(svn_fs_x__get_representation_length(&representation.size,
+                                              &representation.expanded_size,
+                                              context->fs, rev_file,
+                                              entry, scratch_pool));
+
+  /* Large data reps will never be put into containers,
+   * c.f. reps_fit_into_containers(). */
+  if (   (   entry->type == SVN_FS_X__ITEM_TYPE_FILE_REP
+          || entry->type == SVN_FS_X__ITEM_TYPE_DIR_REP)
+      && representation.expanded_size > 2 * ffd->block_size)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_x__get_contents(&stream, context->fs, &representation,
+                                 FALSE, scratch_pool));
+  contents = svn_stringbuf_create_ensure(representation.expanded_size,
+                                         scratch_pool);
+  contents->len = representation.expanded_size;
+  SVN_ERR(svn_stream_read_full(stream, contents->data, &contents->len));
+  SVN_ERR(svn_stream_close(stream));
+
+  fulltext = apr_palloc(context->info_pool, sizeof(*fulltext));
+  fulltext->id = representation.id;
+  fulltext->size = contents->len;
+  SVN_ERR(svn_io_file_get_offset(&fulltext->offset, context->fulltexts_file,
+                                 scratch_pool));
+  SVN_ERR(svn_io_file_write_full(context->fulltexts_file, contents->data,
+                                 contents->len, NULL, scratch_pool));
+  apr_hash_set(context->fulltexts, &fulltext->id, sizeof(fulltext->id),
+               fulltext);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *CONTENTS to the fulltext of the representation identified by ENTRY
+ * as stored in CONTEXT's fulltext bucket.  If the representation has not
+ * been expanded in phase 2, read it from TEMP_FILE, which may also be
+ * accessed through FILE.  Allocate *CONTENTS in RESULT_POOL.
+ */
+static svn_error_t *
+read_fulltext(svn_string_t **contents,
+              pack_context_t *context,
+              svn_fs_x__p2l_entry_t *entry,
+              apr_file_t *temp_file,
+              svn_fs_x__revision_file_t *file,
+              apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *buffer;
+  fulltext_t *fulltext = apr_hash_get(context->fulltexts, &entry->items[0],
+                                      sizeof(entry->items[0]));
+
+  if (fulltext)
+    {
+      buffer = svn_stringbuf_create_ensure(fulltext->size, result_pool);
+      buffer->len = fulltext->size;
+      SVN_ERR(svn_io_file_seek(context->fulltexts_file, APR_SET,
+                               &fulltext->offset, result_pool));
+      SVN_ERR(svn_io_file_read_full2(context->fulltexts_file, buffer->data,
+                                     buffer->len, NULL, NULL, result_pool));
+    }
+  else
+    {
+      svn_fs_x__representation_t representation = { 0 };
+      svn_stream_t *stream;
+
+      representation.id = entry->items[0];
+      SVN_ERR(svn_io_file_seek(temp_file, APR_SET, &entry->offset,
+                               result_pool));
+      SVN_ERR(svn_fs_x__get_representation_length(&representation.size,
+                                             &representation.expanded_size,
+                                             context->fs, file,
+                                             entry, result_pool));
+      SVN_ERR(svn_fs_x__get_contents(&stream, context->fs, &representation,
+                                     FALSE, result_pool));
+      buffer = svn_stringbuf_create_ensure(representation.expanded_size,
+                                           result_pool);
+      buffer->len = representation.expanded_size;
+
+      /* The representation is immutable.  Read it normally. */
+      SVN_ERR(svn_stream_read_full(stream, buffer->data, &buffer->len));
+      SVN_ERR(svn_stream_close(stream));
+    }
+
+  buffer->data[buffer->len] = '\0';
+  *contents = svn_stringbuf__morph_into_string(buffer);
+
+  return SVN_NO_ERROR;
+}
+
 /* Directories first, dirs / files sorted by name in reverse lexical order.
  * This maximizes the chance of two items being located close to one another
  * in *all* pack files independent of their change order.  It also groups
@@ -1236,9 +1381,7 @@ write_reps_containers(pack_context_t *context,
   /* copy all items in strict order */
   for (i = entries->nelts-1; i >= 0; --i)
     {
-      svn_fs_x__representation_t representation = { 0 };
-      svn_stringbuf_t *contents;
-      svn_stream_t *stream;
+      svn_string_t *contents;
       apr_size_t list_index;
       svn_fs_x__p2l_entry_t *entry
         = APR_ARRAY_IDX(entries, i, svn_fs_x__p2l_entry_t *);
@@ -1269,28 +1412,11 @@ write_reps_containers(pack_context_t *context,
         }
 
       assert(entry->item_count == 1);
-      representation.id = entry->items[0];
-
-      /* select the change list in the source file, parse it and add it to
-       * the container */
-      SVN_ERR(svn_io_file_seek(temp_file, APR_SET, &entry->offset,
-                               iterpool));
-      SVN_ERR(svn_fs_x__get_representation_length(&representation.size,
-                                             &representation.expanded_size,
-                                             context->fs, file,
-                                             entry, iterpool));
-      SVN_ERR(svn_fs_x__get_contents(&stream, context->fs, &representation,
-                                     FALSE, iterpool));
-      contents = svn_stringbuf_create_ensure(representation.expanded_size,
-                                             iterpool);
-      contents->len = representation.expanded_size;
-
-      /* The representation is immutable.  Read it normally. */
-      SVN_ERR(svn_stream_read_full(stream, contents->data, &contents->len));
-      SVN_ERR(svn_stream_close(stream));
 
-      SVN_ERR(svn_fs_x__reps_add(&list_index, container,
-                                 svn_stringbuf__morph_into_string(contents)));
+      /* get the expanded representation and add it to the container */
+      SVN_ERR(read_fulltext(&contents, context, entry, temp_file, file,
+                            iterpool));
+      SVN_ERR(svn_fs_x__reps_add(&list_index, container, contents));
       SVN_ERR_ASSERT(list_index == sub_items->nelts);
       block_left -= entry->size;
 
@@ -1784,6 +1910,12 @@ pack_range(pack_context_t *context,
                   else
                     SVN_ERR_ASSERT(entry->type == SVN_FS_X__ITEM_TYPE_UNUSED);
 
+                  /* expand potential container members right away */
+                  if (   entry->type >= SVN_FS_X__ITEM_TYPE_FILE_REP
+                      && entry->type <= SVN_FS_X__ITEM_TYPE_DIR_PROPS)
+                    SVN_ERR(copy_fulltext_to_temp(context, rev_file, entry,
+                                                  iterpool));
+
                   offset += entry->size;
                 }
             }
@@ -1919,7 +2051,7 @@ pack_log_addressed(svn_fs_t *fs,
                    const char *shard_dir,
                    svn_revnum_t shard_rev,
                    apr_size_t max_mem,
-                   svn_fs_x__batch_fsync_t *batch,
+                   svn_batch_fsync__t *batch,
                    svn_cancel_func_t cancel_func,
                    void *cancel_baton,
                    apr_pool_t *scratch_pool)
@@ -2019,7 +2151,7 @@ pack_rev_shard(svn_fs_t *fs,
                apr_int64_t shard,
                int max_files_per_dir,
                apr_size_t max_mem,
-               svn_fs_x__batch_fsync_t *batch,
+               svn_batch_fsync__t *batch,
                svn_cancel_func_t cancel_func,
                void *cancel_baton,
                apr_pool_t *scratch_pool)
@@ -2036,7 +2168,7 @@ pack_rev_shard(svn_fs_t *fs,
 
   /* Create the new directory and pack file. */
   SVN_ERR(svn_io_dir_make(pack_file_dir, APR_OS_DEFAULT, scratch_pool));
-  SVN_ERR(svn_fs_x__batch_fsync_new_path(batch, pack_file_dir, scratch_pool));
+  SVN_ERR(svn_batch_fsync__new_path(batch, pack_file_dir, scratch_pool));
 
   /* Index information files */
   SVN_ERR(pack_log_addressed(fs, pack_file_dir, shard_path, shard_rev,
@@ -2076,7 +2208,7 @@ pack_shard(const char *dir,
 {
   svn_fs_x__data_t *ffd = fs->fsap_data;
   const char *shard_path, *pack_file_dir;
-  svn_fs_x__batch_fsync_t *batch;
+  svn_batch_fsync__t *batch;
 
   /* Notify caller we're starting to pack this shard. */
   if (notify_func)
@@ -2084,8 +2216,8 @@ pack_shard(const char *dir,
                         scratch_pool));
 
   /* Perform all fsyncs through this instance. */
-  SVN_ERR(svn_fs_x__batch_fsync_create(&batch, ffd->flush_to_disk,
-                                       scratch_pool));
+  SVN_ERR(svn_batch_fsync__create(&batch, ffd->flush_to_disk,
+                                  scratch_pool));
 
   /* Some useful paths. */
   pack_file_dir = svn_dirent_join(dir,
@@ -2119,7 +2251,7 @@ pack_shard(const char *dir,
   ffd->min_unpacked_rev = (svn_revnum_t)((shard + 1) * max_files_per_dir);
 
   /* Ensure that packed file is written to disk.*/
-  SVN_ERR(svn_fs_x__batch_fsync_run(batch, scratch_pool));
+  SVN_ERR(svn_batch_fsync__run(batch, scratch_pool));
 
   /* Finally, remove the existing shard directories. */
   SVN_ERR(svn_io_remove_dir2(shard_path, TRUE,
@@ -50,9 +50,14 @@
  * text body size limit. */
 #define MAX_INSTRUCTIONS (MAX_TEXT_BODY / 8)
 
-/* value of unused hash buckets */
+/* value of unused hash bucket slots */
 #define NO_OFFSET ((apr_uint32_t)(-1))
 
+/* Number of entries per hash bucket.  Two buckets fit into a typical
+ * 64 byte cache line.
+ */
+#define BUCKET_SLOTS 4
+
 /* Byte strings are described by a series of copy instructions that each
  * do one of the following
  *
@@ -113,31 +118,43 @@ typedef struct base_t
   apr_uint32_t rep;
 } base_t;
 
-/* Yet another hash data structure.  This one tries to be more cache
- * friendly by putting the first byte of each hashed sequence in a
- * common array.  This array will often fit into L1 or L2 at least and
- * give a 99% accurate test for a match without giving false negatives.
+/* Hash key type. 32 bits for pseudo-Adler32 hash sums.
  */
-typedef struct hash_t
+typedef apr_uint32_t hash_key_t;
+
+/* A hash bucket holding up to BUCKET_SLOTS text sequences that map to
+ * the same bucket index.  Keeping the full key per slot allows for a quick
+ * check of all slots at once (compilers will vectorize it) without having
+ * to access the text corpus.  It also makes rehashing cheap.
+ */
+typedef struct bucket_t
 {
-  /* for used entries i, prefixes[i] == text[offsets[i]]; 0 otherwise.
-   * This allows for a quick check without resolving the double
-   * indirection. */
-  char *prefixes;
+  /* for used slots i, keys[i] is the hash_key() of the sequence. */
+  hash_key_t keys[BUCKET_SLOTS];
 
-  /* for used entries i, offsets[i] is start offset in the text corpus;
+  /* for used slots i, offsets[i] is start offset in the text corpus;
    * NO_OFFSET otherwise.
    */
-  apr_uint32_t *offsets;
+  apr_uint32_t offsets[BUCKET_SLOTS];
+} bucket_t;
 
-  /* to be used later for optimizations. */
-  apr_uint32_t *last_matches;
+/* Yet another hash data structure.  This one tries to be cache friendly
+ * by checking a whole bucket, located within a single cache line, for
+ * matches before accessing the text corpus.
+ */
+typedef struct hash_t
+{
+  /* array of SIZE buckets */
+  bucket_t *buckets;
 
-  /* number of buckets in this hash, i.e. elements in each array above.
+  /* number of buckets in this hash.
    * Must be 1 << (8 * sizeof(hash_key_t) - shift) */
   apr_size_t size;
 
-  /* number of buckets actually in use. Must be <= size. */
+  /* upper limit to SIZE.  0 for "unlimited". */
+  apr_size_t max_size;
+
+  /* number of slots actually in use. Must be <= size * BUCKET_SLOTS. */
   apr_size_t used;
 
   /* number of bits to shift right to map a hash_key_t to a bucket index */
@@ -147,10 +164,6 @@ typedef struct hash_t
   apr_pool_t *pool;
 } hash_t;
 
-/* Hash key type. 32 bits for pseudo-Adler32 hash sums.
- */
-typedef apr_uint32_t hash_key_t;
-
 /* Constructor data structure.
  */
 struct svn_fs_x__reps_builder_t
@@ -297,7 +310,7 @@ hash_key(const char *data)
 /* Map the ADLER32 key to a bucket index in HASH and return that index.
  */
 static apr_size_t
-hash_to_index(hash_t *hash, hash_key_t adler32)
+hash_to_index(const hash_t *hash, hash_key_t adler32)
 {
   return (adler32 * 0xd1f3da69) >> hash->shift;
 }
@@ -311,75 +324,145 @@ allocate_hash_members(hash_t *hash,
                       apr_pool_t *result_pool)
 {
   apr_size_t i;
+  int k;
 
   hash->pool = result_pool;
   hash->size = size;
-
-  hash->prefixes = apr_pcalloc(result_pool, size);
-  hash->last_matches = apr_pcalloc(result_pool,
-                                   sizeof(*hash->last_matches) * size);
-  hash->offsets = apr_palloc(result_pool, sizeof(*hash->offsets) * size);
+  hash->buckets = apr_palloc(result_pool, sizeof(*hash->buckets) * size);
 
   for (i = 0; i < size; ++i)
-    hash->offsets[i] = NO_OFFSET;
+    for (k = 0; k < BUCKET_SLOTS; ++k)
+      {
+        hash->buckets[i].keys[k] = 0;
+        hash->buckets[i].offsets[k] = NO_OFFSET;
+      }
 }
 
 /* Initialize the HASH data structure with 2**TWOPOWER buckets allocated
- * in RESULT_POOL.
+ * in RESULT_POOL.  Never grow it beyond MAX_SIZE buckets unless that is 0.
  */
 static void
 init_hash(hash_t *hash,
           apr_size_t twoPower,
+          apr_size_t max_size,
           apr_pool_t *result_pool)
 {
   hash->used = 0;
   hash->shift = sizeof(hash_key_t) * 8 - twoPower;
+  hash->max_size = max_size;
 
   allocate_hash_members(hash, 1 << twoPower, result_pool);
 }
 
-/* Make HASH have at least MIN_SIZE buckets but at least double the number
- * of buckets in HASH by rehashing it based TEXT.
+/* Return the offset of the MATCH_BLOCKSIZE bytes long sequence in TEXT
+ * that has been recorded in HASH under KEY and that equals DATA.
+ * Return NO_OFFSET if there is no such sequence.
+ */
+static apr_uint32_t
+hash_lookup(const hash_t *hash,
+            hash_key_t key,
+            const svn_stringbuf_t *text,
+            const char *data)
+{
+  const bucket_t *bucket = &hash->buckets[hash_to_index(hash, key)];
+  unsigned int candidates = 0;
+  int i;
+
+  /* Test all slots without branching.  Most of the time, there will be
+   * no candidate at all. */
+  for (i = 0; i < BUCKET_SLOTS; ++i)
+    candidates |= (unsigned int)(bucket->keys[i] == key) << i;
+
+  for (i = 0; candidates; ++i, candidates >>= 1)
+    if (   (candidates & 1)
+        && (bucket->offsets[i] != NO_OFFSET)
+        && (memcmp(text->data + bucket->offsets[i], data,
+                   MATCH_BLOCKSIZE) == 0))
+      return bucket->offsets[i];
+
+  return NO_OFFSET;
+}
+
+/* Record the sequence starting at OFFSET under KEY in HASH.  If the
+ * respective bucket is full, replace the entry with the lowest offset
+ * unless that is >= PROTECTED_START.
+ */
+static void
+hash_insert(hash_t *hash,
+            hash_key_t key,
+            apr_uint32_t offset,
+            apr_uint32_t protected_start)
+{
+  bucket_t *bucket = &hash->buckets[hash_to_index(hash, key)];
+  int victim = 0;
+  int i;
+
+  for (i = 0; i < BUCKET_SLOTS; ++i)
+    {
+      if (bucket->offsets[i] == NO_OFFSET)
+        {
+          ++hash->used;
+          victim = i;
+          break;
+        }
+
+      if (bucket->offsets[i] < bucket->offsets[victim])
+        victim = i;
+    }
+
+  /* Don't replace hash entries that stem from the current text.
+   * This makes early matches more likely. */
+  if (   bucket->offsets[victim] != NO_OFFSET
+      && bucket->offsets[victim] >= protected_start)
+    return;
+
+  bucket->keys[victim] = key;
+  bucket->offsets[victim] = offset;
+}
+
+/* Make HASH have at least MIN_SLOTS slots but at least double the number
+ * of buckets in HASH by rehashing it - unless that would exceed the size
+ * limit of HASH.
  */
 static void
 grow_hash(hash_t *hash,
-          svn_stringbuf_t *text,
-          apr_size_t min_size)
+          apr_size_t min_slots)
 {
   hash_t copy;
   apr_size_t i;
+  int k;
 
   /* determine the new hash size */
   apr_size_t new_size = hash->size * 2;
   apr_size_t new_shift = hash->shift - 1;
-  while (new_size < min_size)
+  while (new_size * BUCKET_SLOTS < min_slots)
     {
       new_size *= 2;
       --new_shift;
     }
 
+  if (hash->max_size)
+    while (new_size > hash->max_size && new_size > hash->size)
+      {
+        new_size /= 2;
+        ++new_shift;
+      }
+
+  if (new_size <= hash->size)
+    return;
+
   /* allocate new hash */
   allocate_hash_members(&copy, new_size, hash->pool);
   copy.used = 0;
   copy.shift = new_shift;
+  copy.max_size = hash->max_size;
 
-  /* copy / translate data */
+  /* copy / translate data.  We have the keys already. */
   for (i = 0; i < hash->size; ++i)
-    {
-      apr_uint32_t offset = hash->offsets[i];
-      if (offset != NO_OFFSET)
-        {
-          hash_key_t key = hash_key(text->data + offset);
-          size_t idx = hash_to_index(&copy, key);
-
-          if (copy.offsets[idx] == NO_OFFSET)
-            copy.used++;
-
-          copy.prefixes[idx] = hash->prefixes[i];
-          copy.offsets[idx] = offset;
-          copy.last_matches[idx] = hash->last_matches[i];
-        }
-    }
+    for (k = 0; k < BUCKET_SLOTS; ++k)
+      if (hash->buckets[i].offsets[k] != NO_OFFSET)
+        hash_insert(&copy, hash->buckets[i].keys[k],
+                    hash->buckets[i].offsets[k], NO_OFFSET);
 
   *hash = copy;
 }
@@ -388,12 +471,24 @@ svn_fs_x__reps_builder_t *
 svn_fs_x__reps_builder_create(svn_fs_t *fs,
                               apr_pool_t *result_pool)
 {
+  svn_fs_x__data_t *ffd = fs->fsap_data;
   svn_fs_x__reps_builder_t *result = apr_pcalloc(result_pool,
                                                  sizeof(*result));
+  apr_size_t max_buckets = 0;
+
+  /* Round the configured hash memory limit down to a power of two number
+   * of buckets. */
+  if (ffd->reps_container_hash_size > 0)
+    {
+      apr_uint64_t buckets = (apr_uint64_t)ffd->reps_container_hash_size
+                           / sizeof(bucket_t);
+      for (max_buckets = 16; max_buckets * 2 <= buckets; max_buckets *= 2)
+        ;
+    }
 
   result->fs = fs;
   result->text = svn_stringbuf_create_empty(result_pool);
-  init_hash(&result->hash, 4, result_pool);
+  init_hash(&result->hash, 4, max_buckets, result_pool);
 
   result->bases = apr_array_make(result_pool, 0, sizeof(base_t));
   result->reps = apr_array_make(result_pool, 0, sizeof(rep_t));
@@ -442,7 +537,7 @@ add_new_text(svn_fs_x__reps_builder_t *builder,
 {
   instruction_t instruction;
   apr_size_t offset;
-  apr_size_t buckets_required;
+  apr_size_t slots_required;
 
   if (len == 0)
     return;
@@ -456,28 +551,16 @@ add_new_text(svn_fs_x__reps_builder_t *builder,
   svn_stringbuf_appendbytes(builder->text, data, len);
 
   /* expand the hash upfront to minimize the chances of collisions */
-  buckets_required = builder->hash.used + len / MATCH_BLOCKSIZE;
-  if (buckets_required * 3 >= builder->hash.size * 2)
-    grow_hash(&builder->hash, builder->text, 2 * buckets_required);
+  slots_required = builder->hash.used + len / MATCH_BLOCKSIZE;
+  if (slots_required * 3 >= builder->hash.size * BUCKET_SLOTS * 2)
+    grow_hash(&builder->hash, 2 * slots_required);
 
   /* add hash entries for the new sequence */
   for (offset = instruction.offset;
        offset + MATCH_BLOCKSIZE <= builder->text->len;
        offset += MATCH_BLOCKSIZE)
-    {
-      hash_key_t key = hash_key(builder->text->data + offset);
-      size_t idx = hash_to_index(&builder->hash, key);
-
-      /* Don't replace hash entries that stem from the current text.
-       * This makes early matches more likely. */
-      if (builder->hash.offsets[idx] == NO_OFFSET)
-        ++builder->hash.used;
-      else if (builder->hash.offsets[idx] >= instruction.offset)
-        continue;
-
-      builder->hash.offsets[idx] = (apr_uint32_t)offset;
-      builder->hash.prefixes[idx] = builder->text->data[offset];
-    }
+    hash_insert(&builder->hash, hash_key(builder->text->data + offset),
+                (apr_uint32_t)offset, (apr_uint32_t)instruction.offset);
 }
 
 svn_error_t *
@@ -504,22 +587,16 @@ svn_fs_x__reps_add(apr_size_t *rep_idx,
   while (current < last_to_test)
     {
       hash_key_t key = hash_key(current);
-      size_t offset;
-      size_t idx;
+      size_t offset = NO_OFFSET;
 
       /* search for the next matching sequence */
 
       for (; current < last_to_test; ++current)
         {
-          idx = hash_to_index(&builder->hash, key);
-          if (builder->hash.prefixes[idx] == current[0])
-            {
-              offset = builder->hash.offsets[idx];
-              if (   (offset != NO_OFFSET)
-                  && (memcmp(&builder->text->data[offset], current,
-                             MATCH_BLOCKSIZE) == 0))
-                break;
-            }
+          offset = hash_lookup(&builder->hash, key, builder->text, current);
+          if (offset != NO_OFFSET)
+            break;
+
           key = hash_key_replace(key, current[0], current[MATCH_BLOCKSIZE]);
         }
 
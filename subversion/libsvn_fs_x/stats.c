@@ -0,0 +1,301 @@
+/* stats.c -- implements the svn_fs_x__get_stats private API
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include "svn_pools.h"
+
+#include "private/svn_cache.h"
+
+#include "fs_x.h"
+#include "cached_data.h"
+#include "changes.h"
+#include "index.h"
+#include "noderevs.h"
+#include "rev_file.h"
+#include "util.h"
+
+/* Add the sizes of the string table described by COUNT, EXPANDED_SIZE and
+ * STORED_SIZE to STATS.
+ */
+static void
+add_string_table_stats(svn_fs_x__string_table_stats_t *stats,
+                       apr_size_t count,
+                       apr_size_t expanded_size,
+                       apr_size_t stored_size)
+{
+  ++stats->tables;
+  stats->strings += count;
+  stats->expanded_size += expanded_size;
+  stats->stored_size += stored_size;
+}
+
+/* Read the container described by ENTRY from REV_FILE in FS and add the
+ * statistics of its path string table to STATS.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+analyze_container(svn_fs_x__stats_t *stats,
+                  svn_fs_t *fs,
+                  svn_fs_x__revision_file_t *rev_file,
+                  const svn_fs_x__p2l_entry_t *entry,
+                  apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *text;
+  svn_stream_t *stream;
+  apr_size_t count, expanded_size, stored_size;
+
+  /* Read the raw container data.  Checksums are the business of "verify". */
+  text = svn_stringbuf_create_ensure(entry->size, scratch_pool);
+  text->len = entry->size;
+  text->data[text->len] = 0;
+  SVN_ERR(svn_fs_x__rev_file_seek(rev_file, NULL, entry->offset));
+  SVN_ERR(svn_fs_x__rev_file_read(rev_file, text->data, text->len));
+  stream = svn_stream_from_stringbuf(text, scratch_pool);
+
+  if (entry->type == SVN_FS_X__ITEM_TYPE_CHANGES_CONT)
+    {
+      svn_fs_x__changes_t *changes;
+      SVN_ERR(svn_fs_x__read_changes_container(&changes, stream,
+                                               scratch_pool, scratch_pool));
+      svn_fs_x__changes_get_path_stats(changes, &count, &expanded_size,
+                                       &stored_size);
+      add_string_table_stats(&stats->changes_paths, count, expanded_size,
+                             stored_size);
+    }
+  else
+    {
+      svn_fs_x__noderevs_t *noderevs;
+      SVN_ERR(svn_fs_x__read_noderevs_container(&noderevs, stream,
+                                                scratch_pool, scratch_pool));
+      svn_fs_x__noderevs_get_path_stats(noderevs, &count, &expanded_size,
+                                        &stored_size);
+      add_string_table_stats(&stats->noderevs_paths, count, expanded_size,
+                             stored_size);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* If REP in FS has been created in the same change set as its node
+ * NODEREV_ID, measure its delta chain and add the result to STATS.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+analyze_rep(svn_fs_x__stats_t *stats,
+            svn_fs_t *fs,
+            svn_fs_x__representation_t *rep,
+            const svn_fs_x__id_t *noderev_id,
+            apr_pool_t *scratch_pool)
+{
+  int chain_length, shard_count;
+  int bucket = 0;
+
+  /* Count every rep only once, i.e. for the node that introduced it. */
+  if (!rep || rep->id.change_set != noderev_id->change_set)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_x__rep_chain_length(&chain_length, &shard_count, rep, fs,
+                                     scratch_pool));
+
+  ++stats->chain_count;
+  stats->chain_length_sum += chain_length;
+  stats->chain_shard_sum += shard_count;
+  if (stats->chain_length_max < (apr_uint64_t)chain_length)
+    stats->chain_length_max = chain_length;
+
+  while (   (chain_length >>= 1) > 0
+         && bucket < SVN_FS_X__STATS_CHAIN_BUCKETS - 1)
+    ++bucket;
+  ++stats->chain_histogram[bucket];
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the P2L index ENTRY read from REV_FILE in FS to STATS.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+analyze_entry(svn_fs_x__stats_t *stats,
+              svn_fs_t *fs,
+              svn_fs_x__revision_file_t *rev_file,
+              const svn_fs_x__p2l_entry_t *entry,
+              apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = fs->fsap_data;
+  svn_fs_x__item_type_stats_t *type_stats;
+  svn_cache__t *cache = NULL;
+  apr_uint32_t i;
+
+  stats->total_size += entry->size;
+  if (entry->type >= SVN_FS_X__STATS_ITEM_TYPE_COUNT)
+    return SVN_NO_ERROR;
+
+  type_stats = &stats->item_types[entry->type];
+  ++type_stats->count;
+  type_stats->sub_items += entry->item_count;
+  type_stats->size += entry->size;
+  if (type_stats->max_sub_items < entry->item_count)
+    type_stats->max_sub_items = entry->item_count;
+
+  /* The on-disk size is only a lower bound to the size of the cached
+   * object, so this is an estimate. */
+  if (entry->type == SVN_FS_X__ITEM_TYPE_CHANGES_CONT)
+    cache = ffd->changes_container_cache;
+  else if (entry->type == SVN_FS_X__ITEM_TYPE_NODEREVS_CONT)
+    cache = ffd->noderevs_container_cache;
+  else if (entry->type == SVN_FS_X__ITEM_TYPE_REPS_CONT)
+    cache = ffd->reps_container_cache;
+
+  if (cache && !svn_cache__is_cachable(cache, entry->size))
+    ++type_stats->uncachable;
+
+  if (   entry->type == SVN_FS_X__ITEM_TYPE_CHANGES_CONT
+      || entry->type == SVN_FS_X__ITEM_TYPE_NODEREVS_CONT)
+    SVN_ERR(analyze_container(stats, fs, rev_file, entry, scratch_pool));
+
+  /* Measure the delta chains of all reps introduced by these noderevs. */
+  if (   entry->type == SVN_FS_X__ITEM_TYPE_NODEREV
+      || entry->type == SVN_FS_X__ITEM_TYPE_NODEREVS_CONT)
+    {
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      for (i = 0; i < entry->item_count; ++i)
+        {
+          svn_fs_x__noderev_t *noderev;
+
+          svn_pool_clear(iterpool);
+          SVN_ERR(svn_fs_x__get_node_revision(&noderev, fs, &entry->items[i],
+                                              iterpool, iterpool));
+          SVN_ERR(analyze_rep(stats, fs, noderev->data_rep,
+                              &noderev->noderev_id, iterpool));
+          SVN_ERR(analyze_rep(stats, fs, noderev->prop_rep,
+                              &noderev->noderev_id, iterpool));
+        }
+
+      svn_pool_destroy(iterpool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Add all P2L index entries of the rev / pack file containing REVISION
+ * in FS to STATS.  If not NULL, call CANCEL_FUNC with CANCEL_BATON for
+ * every entry.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+analyze_rev_file(svn_fs_x__stats_t *stats,
+                 svn_fs_t *fs,
+                 svn_revnum_t revision,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = fs->fsap_data;
+  svn_fs_x__revision_file_t *rev_file;
+  int i;
+  apr_off_t offset, max_offset;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(svn_fs_x__rev_file_init(&rev_file, fs, revision, scratch_pool));
+  SVN_ERR(svn_fs_x__p2l_get_max_offset(&max_offset, fs, rev_file, revision,
+                                       scratch_pool));
+
+  /* Walk through all P2L index entries in offset order. */
+  for (offset = 0; offset < max_offset; )
+    {
+      apr_array_header_t *entries;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_x__p2l_index_lookup(&entries, fs, rev_file, revision,
+                                         offset, ffd->p2l_page_size,
+                                         iterpool, iterpool));
+
+      for (i = 0; i < entries->nelts && offset < max_offset; ++i)
+        {
+          const svn_fs_x__p2l_entry_t *entry
+            = &APR_ARRAY_IDX(entries, i, const svn_fs_x__p2l_entry_t);
+          offset = entry->offset + entry->size;
+
+          if (cancel_func)
+            SVN_ERR(cancel_func(cancel_baton));
+
+          SVN_ERR(analyze_entry(stats, fs, rev_file, entry, iterpool));
+        }
+    }
+
+  SVN_ERR(svn_fs_x__close_revision_file(rev_file));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_x__get_stats(svn_fs_x__stats_t **stats,
+                    svn_fs_t *fs,
+                    svn_fs_progress_notify_func_t progress_func,
+                    void *progress_baton,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = fs->fsap_data;
+  svn_fs_x__stats_t *result = apr_pcalloc(result_pool, sizeof(*result));
+  svn_revnum_t youngest, revision;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(svn_fs_x__youngest_rev(&youngest, fs, scratch_pool));
+  SVN_ERR(svn_fs_x__update_min_unpacked_rev(fs, scratch_pool));
+
+  result->revision_count = youngest + 1;
+  result->shard_size = ffd->max_files_per_dir;
+  result->min_unpacked_rev = ffd->min_unpacked_rev;
+
+  /* Each pack file has a single index covering all of its revisions. */
+  for (revision = 0; revision <= youngest;
+       revision += svn_fs_x__pack_size(fs, revision))
+    {
+      svn_pool_clear(iterpool);
+
+      if (progress_func)
+        progress_func(revision, progress_baton, iterpool);
+
+      SVN_ERR(analyze_rev_file(result, fs, revision, cancel_func,
+                               cancel_baton, iterpool));
+    }
+
+  /* The scan touched all meta data, so this is the cache footprint of the
+   * whole repository as far as the cache could hold it. */
+  if (svn_cache__get_global_membuffer_cache())
+    {
+      svn_cache__info_t *cache_info
+        = svn_cache__membuffer_get_global_info(iterpool);
+
+      result->cache_total_size = cache_info->total_size;
+      result->cache_used_size = cache_info->used_size;
+      result->cache_used_entries = cache_info->used_entries;
+    }
+
+  svn_pool_destroy(iterpool);
+  *stats = result;
+
+  return SVN_NO_ERROR;
+}
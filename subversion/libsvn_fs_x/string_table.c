@@ -584,6 +584,37 @@ svn_fs_x__string_table_get(const string_table_t *table,
   return apr_pstrmemdup(result_pool, "", 0);
 }
 
+void
+svn_fs_x__string_table_get_stats(const string_table_t *table,
+                                 apr_size_t *count,
+                                 apr_size_t *expanded_size,
+                                 apr_size_t *stored_size)
+{
+  apr_size_t i, k;
+
+  *count = 0;
+  *expanded_size = 0;
+  *stored_size = 0;
+
+  for (i = 0; i < table->size; ++i)
+    {
+      const string_sub_table_t *sub_table = &table->sub_tables[i];
+
+      *count += sub_table->short_string_count + sub_table->long_string_count;
+      *stored_size += sub_table->data_size;
+
+      for (k = 0; k < sub_table->short_string_count; ++k)
+        *expanded_size += sub_table->short_strings[k].head_length
+                        + sub_table->short_strings[k].tail_length;
+
+      for (k = 0; k < sub_table->long_string_count; ++k)
+        {
+          *expanded_size += sub_table->long_strings[k].len;
+          *stored_size += sub_table->long_strings[k].len;
+        }
+    }
+}
+
 svn_error_t *
 svn_fs_x__write_string_table(svn_stream_t *stream,
                              const string_table_t *table,
@@ -904,3 +935,76 @@ svn_fs_x__string_table_get_func(const string_table_t *table,
 
   return "";
 }
+
+const char*
+svn_fs_x__string_table_get_borrowed_func(const string_table_t *table,
+                                         apr_size_t idx,
+                                         apr_size_t *length,
+                                         svn_stringbuf_t *buffer)
+{
+  apr_size_t table_number = idx >> TABLE_SHIFT;
+  apr_size_t sub_index = idx & STRING_INDEX_MASK;
+
+  if (table_number < table->size)
+    {
+      /* resolve TABLE->SUB_TABLES pointer and select sub-table */
+      string_sub_table_t *sub_tables
+        = (string_sub_table_t *)svn_temp_deserializer__ptr(table,
+                                   (const void *const *)&table->sub_tables);
+      string_sub_table_t *sub_table = sub_tables + table_number;
+
+      /* pick the right kind of string */
+      if (idx & LONG_STRING_MASK)
+        {
+          if (sub_index < sub_table->long_string_count)
+            {
+              /* Long strings are stored in full, including the
+                 terminating NUL.  Simply point to them. */
+              svn_string_t *long_strings
+                = (svn_string_t *)svn_temp_deserializer__ptr(sub_table,
+                             (const void *const *)&sub_table->long_strings);
+
+              if (length)
+                *length = long_strings[sub_index].len;
+
+              return (const char*)svn_temp_deserializer__ptr(long_strings,
+                        (const void *const *)&long_strings[sub_index].data);
+            }
+        }
+      else
+        {
+          if (sub_index < sub_table->short_string_count)
+            {
+              string_header_t *header;
+              apr_size_t len;
+
+              /* See svn_fs_x__string_table_get_func. */
+              string_sub_table_t table_copy = *sub_table;
+              table_copy.data
+                = (const char *)svn_temp_deserializer__ptr(sub_tables,
+                                     (const void *const *)&sub_table->data);
+              table_copy.short_strings
+                = (string_header_t *)svn_temp_deserializer__ptr(sub_tables,
+                            (const void *const *)&sub_table->short_strings);
+
+              /* reconstruct the char data in BUFFER, leaving enough room
+                 for the chunky copy in table_copy_string() */
+              header = table_copy.short_strings + sub_index;
+              len = header->head_length + header->tail_length;
+              svn_stringbuf_ensure(buffer, len + PADDING);
+              if (length)
+                *length = len;
+
+              table_copy_string(buffer->data, len, &table_copy, header);
+              buffer->len = len;
+
+              return buffer->data;
+            }
+        }
+    }
+
+  if (length)
+    *length = 0;
+
+  return "";
+}
@@ -85,6 +85,16 @@ svn_fs_x__string_table_get(const string_table_t *table,
                            apr_size_t *length,
                            apr_pool_t *result_pool);
 
+/* Set *COUNT to the number of strings in TABLE, *EXPANDED_SIZE to the sum
+ * of their lengths and *STORED_SIZE to the number of bytes that TABLE
+ * needs to store their contents.
+ */
+void
+svn_fs_x__string_table_get_stats(const string_table_t *table,
+                                 apr_size_t *count,
+                                 apr_size_t *expanded_size,
+                                 apr_size_t *stored_size);
+
 /* Write a serialized representation of the string table TABLE to STREAM.
  * Use SCRATCH_POOL for temporary allocations.
  */
@@ -126,6 +136,19 @@ svn_fs_x__string_table_get_func(const string_table_t *table,
                                 apr_size_t *length,
                                 apr_pool_t *result_pool);
 
+/* Like svn_fs_x__string_table_get_func but don't allocate any memory.
+ * Long strings are returned as a pointer into the cache serialized TABLE
+ * itself; short strings get reconstructed in BUFFER, which will be grown
+ * as necessary.  Either way, the result is NUL-terminated and only valid
+ * until TABLE gets released or BUFFER gets modified.  If LENGTH is not
+ * NULL, set *LENGTH to strlen() of the result string.
+ */
+const char*
+svn_fs_x__string_table_get_borrowed_func(const string_table_t *table,
+                                         apr_size_t idx,
+                                         apr_size_t *length,
+                                         svn_stringbuf_t *buffer);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -42,9 +42,10 @@
 #include "lock.h"
 #include "rep-cache.h"
 #include "index.h"
-#include "batch_fsync.h"
 #include "revprops.h"
 
+#include "private/svn_delta_private.h"
+#include "private/svn_batch_fsync.h"
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
 #include "private/svn_sorts_private.h"
@@ -2316,8 +2317,9 @@ rep_write_get_baton(rep_write_baton_t **wb_p,
                           ffd->delta_compression_level,
                           result_pool);
 
-  b->delta_stream = svn_txdelta_target_push(wh, whb, source,
-                                            b->result_pool);
+  b->delta_stream = svn_txdelta__target_push(wh, whb, source,
+                                             SVN_FS_X__TXDELTA_FORMAT, 0,
+                                             b->result_pool);
 
   *wb_p = b;
 
@@ -2926,8 +2928,9 @@ write_container_delta_rep(svn_fs_x__representation_t *rep,
                           scratch_pool);
 
   whb = apr_pcalloc(scratch_pool, sizeof(*whb));
-  whb->stream = svn_txdelta_target_push(diff_wh, diff_whb, source,
-                                        scratch_pool);
+  whb->stream = svn_txdelta__target_push(diff_wh, diff_whb, source,
+                                         SVN_FS_X__TXDELTA_FORMAT, 0,
+                                         scratch_pool);
   whb->size = 0;
   whb->md5_ctx = svn_checksum_ctx_create(svn_checksum_md5, scratch_pool);
   if (item_type != SVN_FS_X__ITEM_TYPE_DIR_REP)
@@ -3481,7 +3484,7 @@ static svn_error_t *
 write_final_revprop(const char **path,
                     svn_fs_txn_t *txn,
                     svn_revnum_t revision,
-                    svn_fs_x__batch_fsync_t *batch,
+                    svn_batch_fsync__t *batch,
                     apr_pool_t *result_pool,
                     apr_pool_t *scratch_pool)
 {
@@ -3514,7 +3517,7 @@ write_final_revprop(const char **path,
 
   /* Create a file at the final revprops location. */
   *path = svn_fs_x__path_revprops(txn->fs, revision, result_pool);
-  SVN_ERR(svn_fs_x__batch_fsync_open_file(&file, batch, *path, scratch_pool));
+  SVN_ERR(svn_batch_fsync__open_file(&file, batch, *path, scratch_pool));
 
   /* Write the new contents to the final revprops file. */
   SVN_ERR(svn_fs_x__write_non_packed_revprops(file, props, scratch_pool));
@@ -3571,7 +3574,7 @@ svn_fs_x__add_index_data(svn_fs_t *fs,
 static svn_error_t *
 auto_create_shard(svn_fs_t *fs,
                   svn_revnum_t revision,
-                  svn_fs_x__batch_fsync_t *batch,
+                  svn_batch_fsync__t *batch,
                   apr_pool_t *scratch_pool)
 {
   svn_fs_x__data_t *ffd = fs->fsap_data;
@@ -3588,7 +3591,7 @@ auto_create_shard(svn_fs_t *fs,
       SVN_ERR(svn_io_copy_perms(svn_dirent_join(fs->path, PATH_REVS_DIR,
                                                 scratch_pool),
                                 new_dir, scratch_pool));
-      SVN_ERR(svn_fs_x__batch_fsync_new_path(batch, new_dir, scratch_pool));
+      SVN_ERR(svn_batch_fsync__new_path(batch, new_dir, scratch_pool));
     }
 
   return SVN_NO_ERROR;
@@ -3600,7 +3603,7 @@ auto_create_shard(svn_fs_t *fs,
 
    Note that the lifetime of *FILE is determined by BATCH instead of
    SCRATCH_POOL.  It will be invalidated by either BATCH being cleaned up
-   itself of by running svn_fs_x__batch_fsync_run on it.
+   itself of by running svn_batch_fsync__run on it.
 
    This function will "destroy" the transaction by removing its prototype
    revision file, so it can at most be called once per transaction.  Also,
@@ -3615,7 +3618,7 @@ get_writable_final_rev(apr_file_t **file,
                        svn_fs_t *fs,
                        svn_fs_x__txn_id_t txn_id,
                        svn_revnum_t revision,
-                       svn_fs_x__batch_fsync_t *batch,
+                       svn_batch_fsync__t *batch,
                        apr_pool_t *scratch_pool)
 {
   get_writable_proto_rev_baton_t baton;
@@ -3642,13 +3645,13 @@ get_writable_final_rev(apr_file_t **file,
                                                        scratch_pool),
                                    unlock_proto_rev(fs, txn_id, lockcookie,
                                                     scratch_pool)));
-  SVN_ERR(svn_fs_x__batch_fsync_new_path(batch, final_rev_filename,
-                                         scratch_pool));
+  SVN_ERR(svn_batch_fsync__new_path(batch, final_rev_filename,
+                                    scratch_pool));
 
   /* Now open the prototype revision file and seek to the end.
      Note that BATCH always seeks to position 0 before returning the file. */
-  SVN_ERR(svn_fs_x__batch_fsync_open_file(file, batch, final_rev_filename,
-                                          scratch_pool));
+  SVN_ERR(svn_batch_fsync__open_file(file, batch, final_rev_filename,
+                                     scratch_pool));
   SVN_ERR(svn_io_file_seek(*file, APR_END, &end_offset, scratch_pool));
 
   /* We don't want unused sections (such as leftovers from failed delta
@@ -3665,7 +3668,7 @@ get_writable_final_rev(apr_file_t **file,
 static svn_error_t *
 write_next_file(svn_fs_t *fs,
                 svn_revnum_t revision,
-                svn_fs_x__batch_fsync_t *batch,
+                svn_batch_fsync__t *batch,
                 apr_pool_t *scratch_pool)
 {
   apr_file_t *file;
@@ -3674,7 +3677,7 @@ write_next_file(svn_fs_t *fs,
   char *buf;
 
   /* Create / open the 'next' file. */
-  SVN_ERR(svn_fs_x__batch_fsync_open_file(&file, batch, path, scratch_pool));
+  SVN_ERR(svn_batch_fsync__open_file(&file, batch, path, scratch_pool));
 
   /* Write its contents. */
   buf = apr_psprintf(scratch_pool, "%ld\n", revision);
@@ -3691,7 +3694,7 @@ write_next_file(svn_fs_t *fs,
 static svn_error_t *
 bump_current(svn_fs_t *fs,
              svn_revnum_t new_rev,
-             svn_fs_x__batch_fsync_t *batch,
+             svn_batch_fsync__t *batch,
              apr_pool_t *scratch_pool)
 {
   const char *current_filename;
@@ -3700,7 +3703,7 @@ bump_current(svn_fs_t *fs,
   SVN_ERR(write_next_file(fs, new_rev, batch, scratch_pool));
 
   /* Commit all changes to disk. */
-  SVN_ERR(svn_fs_x__batch_fsync_run(batch, scratch_pool));
+  SVN_ERR(svn_batch_fsync__run(batch, scratch_pool));
 
   /* Make the revision visible to all processes and threads. */
   current_filename = svn_fs_x__path_current(fs, scratch_pool);
@@ -3709,7 +3712,7 @@ bump_current(svn_fs_t *fs,
                                     batch, scratch_pool));
 
   /* Make the new revision permanently visible. */
-  SVN_ERR(svn_fs_x__batch_fsync_run(batch, scratch_pool));
+  SVN_ERR(svn_batch_fsync__run(batch, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -3776,7 +3779,7 @@ commit_body(void *baton,
   apr_off_t initial_offset, changed_path_offset;
   svn_fs_x__txn_id_t txn_id = svn_fs_x__txn_get_id(cb->txn);
   apr_hash_t *changed_paths;
-  svn_fs_x__batch_fsync_t *batch;
+  svn_batch_fsync__t *batch;
   apr_array_header_t *directory_ids
     = apr_array_make(scratch_pool, 4, sizeof(svn_fs_x__pair_cache_key_t));
 
@@ -3822,8 +3825,8 @@ commit_body(void *baton,
 
   /* Use this to force all data to be flushed to physical storage
      (to the degree our environment will allow). */
-  SVN_ERR(svn_fs_x__batch_fsync_create(&batch, ffd->flush_to_disk,
-                                       scratch_pool));
+  SVN_ERR(svn_batch_fsync__create(&batch, ffd->flush_to_disk,
+                                  scratch_pool));
 
   /* Set up the target directory. */
   SVN_ERR(auto_create_shard(cb->fs, new_rev, batch, subpool));
@@ -187,8 +187,8 @@ verify_index_checksum(svn_fs_x__revision_file_t *file,
   return SVN_NO_ERROR;
 }
 
-/* Verify the MD5 checksums of the index data in the rev / pack file
- * containing revision START in FS.  If given, invoke CANCEL_FUNC with
+/* Verify the per-page Adler32 checksums as well as the MD5 checksums of
+ * the index data in the rev / pack file containing revision START in FS.  If given, invoke CANCEL_FUNC with
  * CANCEL_BATON at regular intervals.  Use SCRATCH_POOL for temporary
  * allocations.
  */
@@ -208,6 +208,13 @@ verify_index_checksums(svn_fs_t *fs,
   SVN_ERR(svn_fs_x__rev_file_l2p_info(&l2p_index_info, rev_file));
   SVN_ERR(svn_fs_x__rev_file_p2l_info(&p2l_index_info, rev_file));
 
+  /* Check the individual index pages first.  That narrows any corruption
+   * down to the affected page. */
+  SVN_ERR(svn_fs_x__l2p_index_verify_pages(fs, rev_file, cancel_func,
+                                           cancel_baton, scratch_pool));
+  SVN_ERR(svn_fs_x__p2l_index_verify_pages(fs, rev_file, cancel_func,
+                                           cancel_baton, scratch_pool));
+
   /* Verify the index contents against the checksum from the footer. */
   SVN_ERR(verify_index_checksum(rev_file, "L2P index", &l2p_index_info,
                                 cancel_func, cancel_baton, scratch_pool));
@@ -634,6 +634,98 @@ svn_error_t *svn_ra_get_file(svn_ra_session_t *session,
                                    fetched_rev, props, pool);
 }
 
+/* Baton for range_write_handler(). */
+typedef struct range_baton_t
+{
+  /* Where the data within the range gets written to. */
+  svn_stream_t *stream;
+
+  /* Number of bytes still to discard before the range starts. */
+  svn_filesize_t skip;
+
+  /* Number of bytes within the range still to pass on. */
+  svn_filesize_t remaining;
+} range_baton_t;
+
+/* Implements svn_write_fn_t.  Pass the data within the range described
+   by the range_baton_t BATON on to its stream and discard the rest. */
+static svn_error_t *
+range_write_handler(void *baton,
+                    const char *data,
+                    apr_size_t *len)
+{
+  range_baton_t *rb = baton;
+  apr_size_t avail = *len;
+
+  if (rb->skip >= avail)
+    {
+      rb->skip -= avail;
+      return SVN_NO_ERROR;
+    }
+
+  data += rb->skip;
+  avail -= (apr_size_t)rb->skip;
+  rb->skip = 0;
+
+  if (avail > rb->remaining)
+    avail = (apr_size_t)rb->remaining;
+
+  if (avail > 0)
+    {
+      SVN_ERR(svn_stream_write(rb->stream, data, &avail));
+      rb->remaining -= avail;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *svn_ra_get_file_range(svn_ra_session_t *session,
+                                   const char *path,
+                                   svn_revnum_t revision,
+                                   svn_filesize_t offset,
+                                   svn_filesize_t length,
+                                   svn_stream_t *stream,
+                                   svn_revnum_t *fetched_rev,
+                                   apr_hash_t **props,
+                                   apr_pool_t *pool)
+{
+  range_baton_t *rb;
+  svn_stream_t *range_stream;
+
+  SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
+  SVN_ERR_ASSERT(stream != NULL && offset >= 0 && length >= 0);
+
+  /* Nothing to send.  Only check for existence and get the props. */
+  if (length == 0)
+    return session->vtable->get_file(session, path, revision, NULL,
+                                     fetched_rev, props, pool);
+
+  if (session->vtable->get_file_range)
+    {
+      svn_boolean_t has;
+
+      SVN_ERR(svn_ra_has_capability(session, &has,
+                                    SVN_RA_CAPABILITY_GET_FILE_RANGE,
+                                    pool));
+      if (has)
+        return session->vtable->get_file_range(session, path, revision,
+                                               offset, length, stream,
+                                               fetched_rev, props, pool);
+    }
+
+  /* Fetch the whole file and cut out the range. */
+  rb = apr_pcalloc(pool, sizeof(*rb));
+  rb->stream = stream;
+  rb->skip = offset;
+  rb->remaining = length;
+
+  range_stream = svn_stream_create(rb, pool);
+  svn_stream_set_write(range_stream, range_write_handler);
+
+  return session->vtable->get_file(session, path, revision, range_stream,
+                                   fetched_rev, props, pool);
+}
+
 svn_error_t *svn_ra_get_dir2(svn_ra_session_t *session,
                              apr_hash_t **dirents,
                              svn_revnum_t *fetched_rev,
@@ -1068,6 +1160,84 @@ svn_error_t *svn_ra_get_file_revs2(svn_ra_session_t *session,
   return svn_error_trace(err);
 }
 
+svn_error_t *
+svn_ra_get_blame(svn_ra_session_t *session,
+                 const char *path,
+                 svn_revnum_t start,
+                 svn_revnum_t end,
+                 svn_ra_blame_receiver_t receiver,
+                 void *receiver_baton,
+                 apr_pool_t *pool)
+{
+  SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
+  SVN_ERR_ASSERT(SVN_IS_VALID_REVNUM(start) && SVN_IS_VALID_REVNUM(end)
+                 && start <= end);
+  if (!session->vtable->get_blame)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL, NULL);
+
+  SVN_ERR(svn_ra__assert_capable_server(session,
+                                        SVN_RA_CAPABILITY_SERVER_BLAME,
+                                        NULL, pool));
+
+  return session->vtable->get_blame(session, path, start, end,
+                                    receiver, receiver_baton, pool);
+}
+
+svn_error_t *
+svn_ra_get_files(svn_ra_session_t *session,
+                 const apr_array_header_t *files,
+                 svn_boolean_t want_props,
+                 svn_ra_file_receiver_t receiver,
+                 void *receiver_baton,
+                 apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  int i;
+
+  for (i = 0; i < files->nelts; i++)
+    {
+      const svn_ra_file_request_t *file
+        = APR_ARRAY_IDX(files, i, const svn_ra_file_request_t *);
+
+      SVN_ERR_ASSERT(svn_relpath_is_canonical(file->path));
+    }
+
+  if (session->vtable->get_files)
+    {
+      svn_boolean_t has;
+
+      SVN_ERR(svn_ra_has_capability(session, &has,
+                                    SVN_RA_CAPABILITY_GET_FILES,
+                                    scratch_pool));
+      if (has)
+        return session->vtable->get_files(session, files, want_props,
+                                          receiver, receiver_baton,
+                                          scratch_pool);
+    }
+
+  /* Fetch the files one by one. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < files->nelts; i++)
+    {
+      const svn_ra_file_request_t *file
+        = APR_ARRAY_IDX(files, i, const svn_ra_file_request_t *);
+      svn_revnum_t fetched_rev;
+      apr_hash_t *props = NULL;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(session->vtable->get_file(session, file->path, file->revision,
+                                        file->stream, &fetched_rev,
+                                        want_props ? &props : NULL,
+                                        iterpool));
+      if (receiver)
+        SVN_ERR(receiver(receiver_baton, file, fetched_rev, props,
+                         iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *svn_ra_lock(svn_ra_session_t *session,
                          apr_hash_t *path_revs,
                          const char *comment,
@@ -345,6 +345,36 @@ typedef struct svn_ra__vtable_t {
                        void *receiver_baton,
                        apr_pool_t *scratch_pool);
 
+  /* See svn_ra_get_blame(). */
+  svn_error_t *(*get_blame)(svn_ra_session_t *session,
+                            const char *path,
+                            svn_revnum_t start,
+                            svn_revnum_t end,
+                            svn_ra_blame_receiver_t receiver,
+                            void *receiver_baton,
+                            apr_pool_t *pool);
+
+  /* See svn_ra_get_files().  Only called if the session has the
+     SVN_RA_CAPABILITY_GET_FILES capability. */
+  svn_error_t *(*get_files)(svn_ra_session_t *session,
+                            const apr_array_header_t *files,
+                            svn_boolean_t want_props,
+                            svn_ra_file_receiver_t receiver,
+                            void *receiver_baton,
+                            apr_pool_t *scratch_pool);
+
+  /* See svn_ra_get_file_range().  Only called if the session has the
+     SVN_RA_CAPABILITY_GET_FILE_RANGE capability.  LENGTH is not 0. */
+  svn_error_t *(*get_file_range)(svn_ra_session_t *session,
+                                 const char *path,
+                                 svn_revnum_t revision,
+                                 svn_filesize_t offset,
+                                 svn_filesize_t length,
+                                 svn_stream_t *stream,
+                                 svn_revnum_t *fetched_rev,
+                                 apr_hash_t **props,
+                                 apr_pool_t *pool);
+
   /* Experimental support below here */
 
   /* See svn_ra__register_editor_shim_callbacks() */
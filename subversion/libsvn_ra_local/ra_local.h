@@ -67,6 +67,11 @@ typedef struct svn_ra_local__session_baton_t
   svn_auth_baton_t *auth_baton;
 
   const char *useragent;
+
+  /* Maximum size of cached fulltexts that are passed to the client
+     directly from the cache instead of being read and sent as deltas.
+     0 disables this. */
+  apr_size_t fulltext_limit;
 } svn_ra_local__session_baton_t;
 
 
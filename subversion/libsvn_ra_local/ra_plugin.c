@@ -167,6 +167,35 @@ cache_init(void *baton, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Set *FULLTEXT_LIMIT to the local-fulltext-limit given in CONFIG_HASH,
+   converted to bytes. */
+static svn_error_t *
+get_fulltext_limit(apr_size_t *fulltext_limit,
+                   apr_hash_t *config_hash)
+{
+  svn_config_t *config = NULL;
+  const char *fulltext_limit_str;
+  apr_uint64_t fulltext_limit_kb;
+
+  *fulltext_limit = 0;
+
+  if (config_hash)
+    config = svn_hash_gets(config_hash, SVN_CONFIG_CATEGORY_CONFIG);
+  svn_config_get(config, &fulltext_limit_str, SVN_CONFIG_SECTION_MISCELLANY,
+                 SVN_CONFIG_OPTION_LOCAL_FULLTEXT_LIMIT, NULL);
+  if (fulltext_limit_str)
+    {
+      SVN_ERR(svn_error_quick_wrap(svn_cstring_strtoui64(&fulltext_limit_kb,
+                                                         fulltext_limit_str,
+                                                         0, APR_SIZE_MAX / 1024,
+                                                         10),
+                                   _("local-fulltext-limit invalid")));
+      *fulltext_limit = (apr_size_t)fulltext_limit_kb * 1024;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /*----------------------------------------------------------------*/
 
 /*** The reporter vtable needed by do_update() and friends ***/
@@ -277,6 +306,9 @@ static const svn_ra_reporter3_t ra_local_reporter =
 
 
 /* ...
+ *
+ * Unless disabled in SESSION, small cached fulltexts are handed to EDITOR
+ * directly from the FS cache, without reading and deltifying them.
  *
  * Wrap a cancellation editor using SESSION's cancellation function around
  * the supplied EDITOR.  ### Some callers (via svn_ra_do_update2() etc.)
@@ -360,13 +392,14 @@ make_reporter(svn_ra_session_t *session,
                                   edit_baton,
                                   NULL,
                                   NULL,
-                                  0, /* Disable zero-copy codepath, because
-                                        RA API users are unaware about the
-                                        zero-copy code path limitation (do
-                                        not access FSFS data structures
-                                        and, hence, caches).  See notes
-                                        to svn_repos_begin_report3() for
-                                        additional details. */
+                                  /* The zero-copy code path is disabled
+                                     by default, because RA API users are
+                                     unaware of its limitation (do not
+                                     access FSFS data structures and,
+                                     hence, caches).  See notes to
+                                     svn_repos_begin_report3() for
+                                     additional details. */
+                                  sess->fulltext_limit,
                                   result_pool));
 
   /* Wrap the report baton given us by the repos layer with our own
@@ -585,6 +618,7 @@ svn_ra_local__open(svn_ra_session_t *session,
   sess->callbacks = callbacks;
   sess->callback_baton = callback_baton;
   sess->auth_baton = auth_baton;
+  SVN_ERR(get_fulltext_limit(&sess->fulltext_limit, config));
 
   /* Look through the URL, figure out which part points to the
      repository, and which part is the path *within* the
@@ -640,6 +674,7 @@ svn_ra_local__dup_session(svn_ra_session_t *new_session,
   new_sess = apr_pcalloc(result_pool, sizeof(*new_sess));
   new_sess->callbacks = old_sess->callbacks;
   new_sess->callback_baton = old_sess->callback_baton;
+  new_sess->fulltext_limit = old_sess->fulltext_limit;
 
   /* ### Re-use existing FS handle? */
 
@@ -734,6 +769,24 @@ svn_ra_local__get_file_revs(svn_ra_session_t *session,
                                   handler, handler_baton, pool);
 }
 
+static svn_error_t *
+svn_ra_local__get_blame(svn_ra_session_t *session,
+                        const char *path,
+                        svn_revnum_t start,
+                        svn_revnum_t end,
+                        svn_ra_blame_receiver_t receiver,
+                        void *receiver_baton,
+                        apr_pool_t *pool)
+{
+  svn_ra_local__session_baton_t *sess = session->priv;
+  const char *abs_path = svn_fspath__join(sess->fs_path->data, path, pool);
+  return svn_error_trace(svn_repos_blame(sess->repos, abs_path, start, end,
+                                         NULL, NULL,
+                                         receiver, receiver_baton,
+                                         session->cancel_func,
+                                         session->cancel_baton, pool));
+}
+
 static svn_error_t *
 svn_ra_local__get_dated_revision(svn_ra_session_t *session,
                                  svn_revnum_t *revision,
@@ -1253,44 +1306,112 @@ get_node_props(apr_hash_t **props,
 }
 
 
-/* Getting just one file. */
+/* Baton type to be passed into write_cached_fulltext. */
+typedef struct cached_fulltext_baton_t
+{
+  svn_stream_t *stream;
+  apr_size_t fulltext_limit;
+  svn_boolean_t written;
+} cached_fulltext_baton_t;
+
+/* Implements svn_fs_process_contents_func_t.  Write the LEN bytes of
+   CONTENTS to the stream in BATON, a cached_fulltext_baton_t, unless they
+   exceed its size limit. */
 static svn_error_t *
-svn_ra_local__get_file(svn_ra_session_t *session,
-                       const char *path,
-                       svn_revnum_t revision,
-                       svn_stream_t *stream,
-                       svn_revnum_t *fetched_rev,
-                       apr_hash_t **props,
-                       apr_pool_t *pool)
+write_cached_fulltext(const unsigned char *contents,
+                      apr_size_t len,
+                      void *baton,
+                      apr_pool_t *scratch_pool)
+{
+  cached_fulltext_baton_t *b = baton;
+
+  if (len > b->fulltext_limit)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_stream_write(b->stream, (const char *)contents, &len));
+  b->written = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Open the root of REVISION in SESSION in *ROOT and make sure that PATH
+   is a file in it.  Set *ABS_PATH to the path of the file within the
+   repository.  If REVISION is invalid, use HEAD and set *FETCHED_REV to
+   it, unless FETCHED_REV is NULL.  Allocate the results in POOL. */
+static svn_error_t *
+open_file_root(svn_fs_root_t **root,
+               const char **abs_path,
+               svn_ra_session_t *session,
+               const char *path,
+               svn_revnum_t revision,
+               svn_revnum_t *fetched_rev,
+               apr_pool_t *pool)
 {
-  svn_fs_root_t *root;
-  svn_stream_t *contents;
   svn_revnum_t youngest_rev;
   svn_ra_local__session_baton_t *sess = session->priv;
-  const char *abs_path = svn_fspath__join(sess->fs_path->data, path, pool);
   svn_node_kind_t node_kind;
 
+  *abs_path = svn_fspath__join(sess->fs_path->data, path, pool);
+
   /* Open the revision's root. */
   if (! SVN_IS_VALID_REVNUM(revision))
     {
       SVN_ERR(svn_fs_youngest_rev(&youngest_rev, sess->fs, pool));
-      SVN_ERR(svn_fs_revision_root(&root, sess->fs, youngest_rev, pool));
+      SVN_ERR(svn_fs_revision_root(root, sess->fs, youngest_rev, pool));
       if (fetched_rev != NULL)
         *fetched_rev = youngest_rev;
     }
   else
-    SVN_ERR(svn_fs_revision_root(&root, sess->fs, revision, pool));
+    SVN_ERR(svn_fs_revision_root(root, sess->fs, revision, pool));
 
-  SVN_ERR(svn_fs_check_path(&node_kind, root, abs_path, pool));
+  SVN_ERR(svn_fs_check_path(&node_kind, *root, *abs_path, pool));
   if (node_kind == svn_node_none)
     {
       return svn_error_createf(SVN_ERR_FS_NOT_FOUND, NULL,
-                               _("'%s' path not found"), abs_path);
+                               _("'%s' path not found"), *abs_path);
     }
   else if (node_kind != svn_node_file)
     {
       return svn_error_createf(SVN_ERR_FS_NOT_FILE, NULL,
-                               _("'%s' is not a file"), abs_path);
+                               _("'%s' is not a file"), *abs_path);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Getting just one file. */
+static svn_error_t *
+svn_ra_local__get_file(svn_ra_session_t *session,
+                       const char *path,
+                       svn_revnum_t revision,
+                       svn_stream_t *stream,
+                       svn_revnum_t *fetched_rev,
+                       apr_hash_t **props,
+                       apr_pool_t *pool)
+{
+  svn_fs_root_t *root;
+  svn_stream_t *contents;
+  svn_ra_local__session_baton_t *sess = session->priv;
+  const char *abs_path;
+
+  SVN_ERR(open_file_root(&root, &abs_path, session, path, revision,
+                         fetched_rev, pool));
+
+  if (stream && sess->fulltext_limit)
+    {
+      /* Try to hand a cached fulltext to the caller's stream directly,
+         without reading it through a contents stream. */
+      cached_fulltext_baton_t baton;
+      svn_boolean_t called;
+
+      baton.stream = stream;
+      baton.fulltext_limit = sess->fulltext_limit;
+      baton.written = FALSE;
+      SVN_ERR(svn_fs_try_process_file_contents(&called, root, abs_path,
+                                               write_cached_fulltext, &baton,
+                                               pool));
+      if (baton.written)
+        stream = NULL;
     }
 
   if (stream)
@@ -1324,6 +1445,71 @@ svn_ra_local__get_file(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+/* Getting a part of a file.  The fs stream skips the data before OFFSET
+   without reconstructing it, if it can. */
+static svn_error_t *
+svn_ra_local__get_file_range(svn_ra_session_t *session,
+                             const char *path,
+                             svn_revnum_t revision,
+                             svn_filesize_t offset,
+                             svn_filesize_t length,
+                             svn_stream_t *stream,
+                             svn_revnum_t *fetched_rev,
+                             apr_hash_t **props,
+                             apr_pool_t *pool)
+{
+  svn_fs_root_t *root;
+  svn_stream_t *contents;
+  svn_ra_local__session_baton_t *sess = session->priv;
+  svn_cancel_func_t cancel_func = sess->callbacks
+                                ? sess->callbacks->cancel_func : NULL;
+  const char *abs_path;
+  char *buffer;
+
+  SVN_ERR(open_file_root(&root, &abs_path, session, path, revision,
+                         fetched_rev, pool));
+  SVN_ERR(svn_fs_file_contents(&contents, root, abs_path, pool));
+
+  while (offset > 0)
+    {
+      apr_size_t to_skip = offset > APR_SIZE_MAX ? APR_SIZE_MAX
+                                                 : (apr_size_t)offset;
+
+      SVN_ERR(svn_stream_skip(contents, to_skip));
+      offset -= to_skip;
+    }
+
+  buffer = apr_palloc(pool, SVN__STREAM_CHUNK_SIZE);
+  while (length > 0)
+    {
+      apr_size_t len = length > SVN__STREAM_CHUNK_SIZE
+                     ? SVN__STREAM_CHUNK_SIZE
+                     : (apr_size_t)length;
+      apr_size_t requested = len;
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(sess->callback_baton));
+
+      SVN_ERR(svn_stream_read_full(contents, buffer, &len));
+      if (len > 0)
+        SVN_ERR(svn_stream_write(stream, buffer, &len));
+
+      /* A short read means EOF. */
+      if (len < requested)
+        break;
+
+      length -= len;
+    }
+
+  SVN_ERR(svn_stream_close(contents));
+
+  /* Handle props if requested. */
+  if (props)
+    SVN_ERR(get_node_props(props, root, abs_path, sess->uuid, pool, pool));
+
+  return SVN_NO_ERROR;
+}
+
 
 
 /* Getting a directory's entries */
@@ -1655,7 +1841,15 @@ svn_ra_local__replay_range(svn_ra_session_t *session,
                            void *replay_baton,
                            apr_pool_t *pool)
 {
-  return svn_error_create(SVN_ERR_RA_NOT_IMPLEMENTED, NULL, NULL);
+  svn_ra_local__session_baton_t *sess = session->priv;
+
+  return svn_repos_replay_range(sess->repos, start_revision, end_revision,
+                                sess->fs_path->data, low_water_mark,
+                                send_deltas, revstart_func, revfinish_func,
+                                replay_baton, NULL, NULL,
+                                sess->callbacks
+                                  ? sess->callbacks->cancel_func : NULL,
+                                sess->callback_baton, pool);
 }
 
 
@@ -1676,10 +1870,20 @@ svn_ra_local__has_capability(svn_ra_session_t *session,
       || strcmp(capability, SVN_RA_CAPABILITY_EPHEMERAL_TXNPROPS) == 0
       || strcmp(capability, SVN_RA_CAPABILITY_GET_FILE_REVS_REVERSE) == 0
       || strcmp(capability, SVN_RA_CAPABILITY_LIST) == 0
+      || strcmp(capability, SVN_RA_CAPABILITY_SERVER_BLAME) == 0
       )
     {
       *has = TRUE;
     }
+  else if (strcmp(capability, SVN_RA_CAPABILITY_GET_FILES) == 0)
+    {
+      /* There is no round trip to save. */
+      *has = FALSE;
+    }
+  else if (strcmp(capability, SVN_RA_CAPABILITY_GET_FILE_RANGE) == 0)
+    {
+      *has = TRUE;
+    }
   else if (strcmp(capability, SVN_RA_CAPABILITY_MERGEINFO) == 0)
     {
       /* With mergeinfo, the code's capabilities may not reflect the
@@ -1849,7 +2053,6 @@ svn_ra_local__list(svn_ra_session_t *session,
 {
   svn_ra_local__session_baton_t *sess = session->priv;
   svn_fs_root_t *root;
-  svn_boolean_t path_info_only = (dirent_fields & ~SVN_DIRENT_KIND) == 0;
 
   dirent_receiver_baton_t baton;
   baton.receiver = receiver;
@@ -1857,13 +2060,13 @@ svn_ra_local__list(svn_ra_session_t *session,
 
   SVN_ERR(svn_fs_revision_root(&root, sess->fs, revision, pool));
   path = svn_dirent_join(sess->fs_path->data, path, pool);
-  return svn_error_trace(svn_repos_list(root, path, patterns, depth,
-                                        path_info_only, NULL, NULL,
-                                        dirent_receiver, &baton,
-                                        sess->callbacks
-                                          ? sess->callbacks->cancel_func
-                                          : NULL,
-                                        sess->callback_baton, pool));
+  return svn_error_trace(svn_repos_list2(root, path, patterns, depth,
+                                         dirent_fields, NULL, NULL,
+                                         dirent_receiver, &baton,
+                                         sess->callbacks
+                                           ? sess->callbacks->cancel_func
+                                           : NULL,
+                                         sess->callback_baton, pool));
 }
 
 /*----------------------------------------------------------------*/
@@ -1917,6 +2120,9 @@ static const svn_ra__vtable_t ra_local_vtable =
   svn_ra_local__get_inherited_props,
   NULL /* set_svn_ra_open */,
   svn_ra_local__list ,
+  svn_ra_local__get_blame,
+  NULL /* get_files */,
+  svn_ra_local__get_file_range,
   svn_ra_local__register_editor_shim_callbacks,
   svn_ra_local__get_commit_ev2,
   NULL /* replay_range_ev2 */
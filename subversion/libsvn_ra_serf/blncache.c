@@ -24,7 +24,11 @@
 #include <apr_pools.h>
 
 #include "svn_hash.h"
+#include "svn_checksum.h"
+#include "svn_config.h"
 #include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "svn_string.h"
 #include "svn_types.h"
 #include "svn_pools.h"
 
@@ -50,8 +54,19 @@ struct svn_ra_serf__blncache_t
    * structures. (Allocated from the same pool as 'revnum_to_bc'.)
    */
   apr_hash_t *baseline_info;
+
+  /* The file that new baselines get appended to, or NULL if the cache
+   * is not persistent.  (Allocated from POOL.) */
+  const char *path;
+
+  /* The pool that the cache has been created in. */
+  apr_pool_t *pool;
 };
 
+/* The sub-directory of the user configuration area that holds the
+ * persistent baseline caches. */
+#define BLNCACHE_SUBDIR "ra-serf-baselines"
+
 
 
 /* Return a pointer to an 'baseline_info_t' structure allocated from
@@ -99,6 +114,7 @@ svn_ra_serf__blncache_create(svn_ra_serf__blncache_t **blncache_p,
   cache_pool = svn_pool_create(pool);
   blncache->revnum_to_bc = apr_hash_make(cache_pool);
   blncache->baseline_info = apr_hash_make(cache_pool);
+  blncache->pool = pool;
 
   *blncache_p = blncache;
 
@@ -107,6 +123,64 @@ svn_ra_serf__blncache_create(svn_ra_serf__blncache_t **blncache_p,
 
 #define MAX_CACHE_SIZE 1000
 
+/* Add BASELINE_URL (may be NULL), REVISION and BC_URL to the in-memory
+ * hashes of BLNCACHE.
+ */
+static void
+cache_insert(svn_ra_serf__blncache_t *blncache,
+             const char *baseline_url,
+             svn_revnum_t revision,
+             const char *bc_url)
+{
+  apr_pool_t *cache_pool = apr_hash_pool_get(blncache->revnum_to_bc);
+
+  /* If the caches are too big, delete and recreate 'em and move along. */
+  if (MAX_CACHE_SIZE < (apr_hash_count(blncache->baseline_info)
+                        + apr_hash_count(blncache->revnum_to_bc)))
+    {
+      svn_pool_clear(cache_pool);
+      blncache->revnum_to_bc = apr_hash_make(cache_pool);
+      blncache->baseline_info = apr_hash_make(cache_pool);
+    }
+
+  hash_set_copy(blncache->revnum_to_bc, &revision, sizeof(revision),
+                apr_pstrdup(cache_pool, bc_url));
+
+  if (baseline_url)
+    {
+      hash_set_copy(blncache->baseline_info, baseline_url,
+                    APR_HASH_KEY_STRING,
+                    baseline_info_make(bc_url, revision, cache_pool));
+    }
+}
+
+/* Append BASELINE_URL (may be NULL), REVISION and BC_URL as one line to
+ * the file of BLNCACHE.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+append_to_file(svn_ra_serf__blncache_t *blncache,
+               const char *baseline_url,
+               svn_revnum_t revision,
+               const char *bc_url,
+               apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+  const char *line;
+
+  /* The URLs are URI-encoded, so they contain no whitespace. */
+  line = apr_psprintf(scratch_pool, "%ld %s%s%s\n", revision, bc_url,
+                      baseline_url ? " " : "",
+                      baseline_url ? baseline_url : "");
+
+  SVN_ERR(svn_io_file_open(&file, blncache->path,
+                           APR_WRITE | APR_CREATE | APR_APPEND,
+                           APR_OS_DEFAULT, scratch_pool));
+  SVN_ERR(svn_io_file_write_full(file, line, strlen(line), NULL,
+                                 scratch_pool));
+
+  return svn_error_trace(svn_io_file_close(file, scratch_pool));
+}
+
 svn_error_t *
 svn_ra_serf__blncache_set(svn_ra_serf__blncache_t *blncache,
                           const char *baseline_url,
@@ -116,28 +190,116 @@ svn_ra_serf__blncache_set(svn_ra_serf__blncache_t *blncache,
 {
   if (bc_url && SVN_IS_VALID_REVNUM(revision))
     {
-      apr_pool_t *cache_pool = apr_hash_pool_get(blncache->revnum_to_bc);
+      /* Only store what the file does not know yet. */
+      if (blncache->path
+          && (!apr_hash_get(blncache->revnum_to_bc,
+                            &revision, sizeof(revision))
+              || (baseline_url
+                  && !svn_hash_gets(blncache->baseline_info,
+                                    baseline_url))))
+        svn_error_clear(append_to_file(blncache, baseline_url, revision,
+                                       bc_url, scratch_pool));
 
-      /* If the caches are too big, delete and recreate 'em and move along. */
-      if (MAX_CACHE_SIZE < (apr_hash_count(blncache->baseline_info)
-                            + apr_hash_count(blncache->revnum_to_bc)))
-        {
-          svn_pool_clear(cache_pool);
-          blncache->revnum_to_bc = apr_hash_make(cache_pool);
-          blncache->baseline_info = apr_hash_make(cache_pool);
-        }
+      cache_insert(blncache, baseline_url, revision, bc_url);
+    }
+
+  return SVN_NO_ERROR;
+}
 
-      hash_set_copy(blncache->revnum_to_bc, &revision, sizeof(revision),
-                    apr_pstrdup(cache_pool, bc_url));
+/* Load the baselines stored in the file at PATH into BLNCACHE.  Return
+ * the number of lines in *LINE_COUNT.  Skip malformed lines, e.g. those
+ * from interrupted writes.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+load_file(int *line_count,
+          svn_ra_serf__blncache_t *blncache,
+          const char *path,
+          apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents;
+  apr_array_header_t *lines;
+  int i;
+
+  SVN_ERR(svn_stringbuf_from_file2(&contents, path, scratch_pool));
+  lines = svn_cstring_split(contents->data, "\n", TRUE, scratch_pool);
+
+  for (i = 0; i < lines->nelts; i++)
+    {
+      apr_array_header_t *fields
+        = svn_cstring_split(APR_ARRAY_IDX(lines, i, const char *), " ",
+                            TRUE, scratch_pool);
+      svn_revnum_t revision;
+      svn_error_t *err;
 
-      if (baseline_url)
+      if (fields->nelts < 2 || fields->nelts > 3)
+        continue;
+
+      err = svn_revnum_parse(&revision, APR_ARRAY_IDX(fields, 0,
+                                                      const char *), NULL);
+      if (err)
         {
-          hash_set_copy(blncache->baseline_info, baseline_url,
-                        APR_HASH_KEY_STRING,
-                        baseline_info_make(bc_url, revision, cache_pool));
+          svn_error_clear(err);
+          continue;
         }
+
+      cache_insert(blncache,
+                   fields->nelts == 3
+                     ? APR_ARRAY_IDX(fields, 2, const char *)
+                     : NULL,
+                   revision,
+                   APR_ARRAY_IDX(fields, 1, const char *));
+    }
+
+  *line_count = lines->nelts;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_serf__blncache_persist(svn_ra_serf__blncache_t *blncache,
+                              const char *config_dir,
+                              const char *key,
+                              apr_pool_t *scratch_pool)
+{
+  const char *dir;
+  svn_checksum_t *checksum;
+  const char *path;
+  int line_count;
+  svn_error_t *err;
+
+  if (blncache->path)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_config_get_user_config_path(&dir, config_dir, BLNCACHE_SUBDIR,
+                                          scratch_pool));
+  if (!dir)
+    return SVN_NO_ERROR;
+
+  err = svn_io_make_dir_recursively(dir, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_md5, key, strlen(key),
+                       scratch_pool));
+  path = svn_dirent_join(dir, svn_checksum_to_cstring(checksum,
+                                                      scratch_pool),
+                         blncache->pool);
+
+  err = load_file(&line_count, blncache, path, scratch_pool);
+  if (err)
+    {
+      /* Most likely, the file does not exist, yet. */
+      svn_error_clear(err);
+    }
+  else if (line_count > MAX_CACHE_SIZE)
+    {
+      /* Start over rather than letting the file grow without bounds. */
+      svn_error_clear(svn_io_remove_file2(path, TRUE, scratch_pool));
     }
 
+  blncache->path = path;
   return SVN_NO_ERROR;
 }
 
@@ -83,6 +83,22 @@ svn_ra_serf__blncache_get_baseline_info(const char **bc_url_p,
                                         const char *baseline_url,
                                         apr_pool_t *pool);
 
+/* Make BLNCACHE persistent: load the baselines that have been stored in
+ * the file for KEY, e.g. the server and VCC URL, within the user
+ * configuration area CONFIG_DIR (NULL for the default location) and
+ * append all baselines added later to that file.  Baseline mappings never
+ * change for a given repository, so the entries need no expiry.
+ *
+ * Problems with the file are silently ignored; the cache then just
+ * remains empty or in-memory.  Do nothing if BLNCACHE is already
+ * persistent.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_ra_serf__blncache_persist(svn_ra_serf__blncache_t *blncache,
+                              const char *config_dir,
+                              const char *key,
+                              apr_pool_t *scratch_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
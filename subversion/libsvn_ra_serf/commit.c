@@ -40,6 +40,7 @@
 #include "private/svn_dep_compat.h"
 #include "private/svn_fspath.h"
 #include "private/svn_skel.h"
+#include "private/svn_subr_private.h"
 
 #include "ra_serf.h"
 #include "../libsvn_ra/ra_loader.h"
@@ -72,6 +73,15 @@ typedef struct commit_context_t {
   const char *vcc_url;           /* vcc url */
 
   int open_batons;               /* Number of open batons */
+
+  /* The number of file PUT and PROPPATCH requests that close_file() may
+     leave in flight, or 0 to complete them before it returns. */
+  int pipeline_depth;
+
+  /* The number of such requests still in flight, and the errors the
+     completed ones have reported but nobody has returned yet. */
+  int pending_requests;
+  svn_error_t *pending_err;
 } commit_context_t;
 
 #define USING_HTTPV2_COMMIT_SUPPORT(commit_ctx) ((commit_ctx)->txn_url != NULL)
@@ -194,6 +204,10 @@ typedef struct file_context_t {
   /* URL to PUT the file at. */
   const char *url;
 
+  /* Number of this file's requests still in flight after close_file().
+     POOL is destroyed once they have all completed. */
+  int pending_requests;
+
 } file_context_t;
 
 
@@ -829,15 +843,16 @@ create_proppatch_body(serf_bucket_t **bkt,
   return SVN_NO_ERROR;
 }
 
-static svn_error_t*
-proppatch_resource(svn_ra_serf__session_t *session,
-                   proppatch_context_t *proppatch,
-                   apr_pool_t *pool)
+/* Return a handler for the PROPPATCH request described by PROPPATCH,
+   allocated in RESULT_POOL. */
+static svn_ra_serf__handler_t *
+create_proppatch_handler(svn_ra_serf__session_t *session,
+                         proppatch_context_t *proppatch,
+                         apr_pool_t *result_pool)
 {
   svn_ra_serf__handler_t *handler;
-  svn_error_t *err;
 
-  handler = svn_ra_serf__create_handler(session, pool);
+  handler = svn_ra_serf__create_handler(session, result_pool);
 
   handler->method = "PROPPATCH";
   handler->path = proppatch->path;
@@ -852,13 +867,15 @@ proppatch_resource(svn_ra_serf__session_t *session,
   handler->response_handler = svn_ra_serf__handle_multistatus_only;
   handler->response_baton = handler;
 
-  err = svn_ra_serf__context_run_one(handler, pool);
-
-  if (!err && handler->sline.code != 207)
-    err = svn_error_trace(svn_ra_serf__unexpected_status(handler));
+  return handler;
+}
 
-  /* Use specific error code for property handling errors.
-     Use loop to provide the right result with tracing */
+/* Return ERR, the result of a PROPPATCH request, using the specific
+   error code for property handling errors. */
+static svn_error_t *
+proppatch_error(svn_error_t *err)
+{
+  /* Use loop to provide the right result with tracing */
   if (err && err->apr_err == SVN_ERR_RA_DAV_REQUEST_FAILED)
     {
       svn_error_t *e = err;
@@ -870,7 +887,25 @@ proppatch_resource(svn_ra_serf__session_t *session,
         }
     }
 
-  return svn_error_trace(err);
+  return err;
+}
+
+static svn_error_t*
+proppatch_resource(svn_ra_serf__session_t *session,
+                   proppatch_context_t *proppatch,
+                   apr_pool_t *pool)
+{
+  svn_ra_serf__handler_t *handler;
+  svn_error_t *err;
+
+  handler = create_proppatch_handler(session, proppatch, pool);
+
+  err = svn_ra_serf__context_run_one(handler, pool);
+
+  if (!err && handler->sline.code != 207)
+    err = svn_error_trace(svn_ra_serf__unexpected_status(handler));
+
+  return svn_error_trace(proppatch_error(err));
 }
 
 /* Implements svn_ra_serf__request_body_delegate_t */
@@ -1710,7 +1745,13 @@ add_file(const char *path,
   dir_context_t *dir = parent_baton;
   file_context_t *new_file;
   const char *deleted_parent = path;
-  apr_pool_t *scratch_pool = svn_pool_create(file_pool);
+  apr_pool_t *scratch_pool;
+
+  /* With pipelining, the file's requests outlive FILE_POOL. */
+  if (dir->commit_ctx->pipeline_depth > 0)
+    file_pool = svn_pool_create(dir->commit_ctx->pool);
+
+  scratch_pool = svn_pool_create(file_pool);
 
   new_file = apr_pcalloc(file_pool, sizeof(*new_file));
   new_file->pool = file_pool;
@@ -1834,6 +1875,10 @@ open_file(const char *path,
   dir_context_t *parent = parent_baton;
   file_context_t *new_file;
 
+  /* With pipelining, the file's requests outlive FILE_POOL. */
+  if (parent->commit_ctx->pipeline_depth > 0)
+    file_pool = svn_pool_create(parent->commit_ctx->pool);
+
   new_file = apr_pcalloc(file_pool, sizeof(*new_file));
   new_file->pool = file_pool;
 
@@ -1865,68 +1910,37 @@ open_file(const char *path,
   return SVN_NO_ERROR;
 }
 
+/* Choose the svndiff version and compression level for sending deltas
+   to the server of SESSION: the first version from our own preferences,
+   as also advertised in our "Accept-Encoding" headers, that the server
+   supports.  With 'http-compression = no', this is uncompressed svndiff0,
+   which every server can handle. */
 static void
 negotiate_put_encoding(int *svndiff_version_p,
                        int *svndiff_compression_level_p,
                        svn_ra_serf__session_t *session)
 {
-  int svndiff_version;
+  const int *versions = svn_ra_serf__get_svndiff_preferences(session);
+  int svndiff_version = 0;
   int compression_level;
+  int i;
 
-  if (session->using_compression == svn_tristate_unknown)
-    {
-      /* With http-compression=auto, prefer svndiff2 to svndiff1 with a
-       * low latency connection (assuming the underlying network has high
-       * bandwidth), as it is faster and in this case, we don't care about
-       * worse compression ratio.
-       *
-       * Note: For future compatibility, we also handle a theoretically
-       * possible case where the server has advertised only svndiff2 support.
-       */
-      if (session->supports_svndiff2 &&
-          svn_ra_serf__is_low_latency_connection(session))
-        svndiff_version = 2;
-      else if (session->supports_svndiff1)
-        svndiff_version = 1;
-      else if (session->supports_svndiff2)
-        svndiff_version = 2;
-      else
-        svndiff_version = 0;
-    }
-  else if (session->using_compression == svn_tristate_true)
-    {
-      /* Otherwise, prefer svndiff1, as svndiff2 is not a reasonable
-       * substitute for svndiff1 with default compression level.  (It gives
-       * better speed and compression ratio comparable to svndiff1 with
-       * compression level 1, but not 5).
-       *
-       * Note: For future compatibility, we also handle a theoretically
-       * possible case where the server has advertised only svndiff2 support.
-       */
-      if (session->supports_svndiff1)
-        svndiff_version = 1;
-      else if (session->supports_svndiff2)
-        svndiff_version = 2;
-      else
-        svndiff_version = 0;
-    }
-  else
+  for (i = 0; versions[i] > 0; i++)
     {
-      /* Difference between svndiff formats 0 and 1/2 that format 1/2 allows
-       * compression.  Uncompressed svndiff0 should also be slightly more
-       * effective if the compression is not required at all.
-       *
-       * If the server cannot handle svndiff1/2, or compression is disabled
-       * with the 'http-compression = no' client configuration option, fall
-       * back to uncompressed svndiff0 format.  As a bonus, users can force
-       * the usage of the uncompressed format by setting the corresponding
-       * client configuration option, if they want to.
-       */
-      svndiff_version = 0;
+      if ((versions[i] == 1 && session->supports_svndiff1)
+          || (versions[i] == 2 && session->supports_svndiff2)
+          || (versions[i] == 3 && session->supports_svndiff3
+              && svn__zstd_available()))
+        {
+          svndiff_version = versions[i];
+          break;
+        }
     }
 
   if (svndiff_version == 0)
     compression_level = SVN_DELTA_COMPRESSION_LEVEL_NONE;
+  else if (svndiff_version == 3)
+    compression_level = SVN__COMPRESSION_ZSTD_DEFAULT;
   else
     compression_level = SVN_DELTA_COMPRESSION_LEVEL_DEFAULT;
 
@@ -2004,17 +2018,17 @@ create_body_from_txdelta_stream(serf_bucket_t **body_bkt,
 {
   open_txdelta_baton_t *b = baton;
   svn_txdelta_stream_t *txdelta_stream;
-  svn_stream_t *stream;
   int svndiff_version;
   int compression_level;
 
   SVN_ERR(b->open_func(&txdelta_stream, b->open_baton, pool, scratch_pool));
 
   negotiate_put_encoding(&svndiff_version, &compression_level, b->session);
-  stream = svn_txdelta_to_svndiff_stream(txdelta_stream, svndiff_version,
-                                         compression_level, pool);
-  *body_bkt = svn_ra_serf__create_stream_bucket(stream, alloc,
-                                                txdelta_stream_errfunc, b);
+  *body_bkt = svn_ra_serf__create_svndiff_bucket(txdelta_stream,
+                                                 svndiff_version,
+                                                 compression_level, alloc,
+                                                 txdelta_stream_errfunc, b,
+                                                 pool);
 
   return SVN_NO_ERROR;
 }
@@ -2133,6 +2147,208 @@ change_file_prop(void *file_baton,
   return SVN_NO_ERROR;
 }
 
+/* A PUT or PROPPATCH request for a file that close_file() has queued
+   without waiting for its response. */
+typedef struct pending_request_t
+{
+  file_context_t *file;
+  svn_ra_serf__handler_t *handler;
+
+  /* The status code that indicates success. */
+  int expected_status;
+
+  /* Is this a PROPPATCH? */
+  svn_boolean_t is_proppatch;
+} pending_request_t;
+
+/* Implements svn_ra_serf__response_done_delegate_t.
+
+   Record the outcome of the pending request in BATON in its commit
+   context, and release its file once this was the last one. */
+static svn_error_t *
+pending_request_done(serf_request_t *request,
+                     void *baton,
+                     apr_pool_t *scratch_pool)
+{
+  pending_request_t *pr = baton;
+  file_context_t *file = pr->file;
+  commit_context_t *commit_ctx = file->commit_ctx;
+  svn_ra_serf__handler_t *handler = pr->handler;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (handler->server_error)
+    err = svn_ra_serf__server_error_create(handler, scratch_pool);
+  else if (handler->sline.code != pr->expected_status)
+    err = svn_ra_serf__unexpected_status(handler);
+
+  if (pr->is_proppatch)
+    err = proppatch_error(err);
+
+  /* Errors are returned by the next close_file() or close_edit(); the
+     remaining requests of the commit must still run to completion. */
+  commit_ctx->pending_err = svn_error_compose_create(commit_ctx->pending_err,
+                                                     err);
+  commit_ctx->pending_requests--;
+
+  if (--file->pending_requests == 0)
+    {
+      if (file->svndiff)
+        svn_error_clear(svn_ra_serf__request_body_cleanup(file->svndiff,
+                                                          scratch_pool));
+
+      /* Our caller no longer touches HANDLER, which lives in this pool. */
+      svn_pool_destroy(file->pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Queue HANDLER, a request for FILE expecting EXPECTED_STATUS, without
+   waiting for its response.  IS_PROPPATCH tells whether HANDLER is the
+   PROPPATCH. */
+static void
+queue_pending_request(file_context_t *file,
+                      svn_ra_serf__handler_t *handler,
+                      int expected_status,
+                      svn_boolean_t is_proppatch)
+{
+  pending_request_t *pr = apr_pcalloc(file->pool, sizeof(*pr));
+
+  pr->file = file;
+  pr->handler = handler;
+  pr->expected_status = expected_status;
+  pr->is_proppatch = is_proppatch;
+
+  handler->done_delegate = pending_request_done;
+  handler->done_delegate_baton = pr;
+
+  file->pending_requests++;
+  file->commit_ctx->pending_requests++;
+
+  svn_ra_serf__request_create(handler);
+}
+
+/* Run the serf context until no more than MAX_PENDING of the requests
+   queued by queue_pending_request() are left in flight, or until one
+   of them failed.  Return the errors reported so far. */
+static svn_error_t *
+wait_for_pending_requests(commit_context_t *commit_ctx,
+                          int max_pending,
+                          apr_pool_t *scratch_pool)
+{
+  svn_ra_serf__session_t *session = commit_ctx->session;
+  apr_interval_time_t waittime_left = session->timeout;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err;
+
+  while (commit_ctx->pending_requests > max_pending
+         && !commit_ctx->pending_err)
+    {
+      svn_pool_clear(iterpool);
+
+      err = svn_ra_serf__context_run(session, &waittime_left, iterpool);
+      if (err)
+        {
+          err = svn_error_compose_create(err, commit_ctx->pending_err);
+          commit_ctx->pending_err = SVN_NO_ERROR;
+          return svn_error_trace(err);
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  err = commit_ctx->pending_err;
+  commit_ctx->pending_err = SVN_NO_ERROR;
+
+  return svn_error_trace(err);
+}
+
+/* Implement close_file() for a commit with a pipeline depth: queue the
+   PUT of FILE (or an empty one if PUT_EMPTY_FILE) and its PROPPATCH
+   behind the requests of the previous files, and release FILE once they
+   are done. */
+static svn_error_t *
+close_file_pipelined(file_context_t *file,
+                     svn_boolean_t put_empty_file,
+                     apr_pool_t *scratch_pool)
+{
+  commit_context_t *commit_ctx = file->commit_ctx;
+  svn_boolean_t need_put = (file->svndiff || put_empty_file);
+  svn_boolean_t need_proppatch = (apr_hash_count(file->prop_changes) > 0);
+  int max_pending = commit_ctx->pipeline_depth;
+
+  if (need_put)
+    max_pending--;
+  if (need_proppatch)
+    max_pending--;
+  if (max_pending < 0)
+    max_pending = 0;
+
+  SVN_ERR(wait_for_pending_requests(commit_ctx, max_pending, scratch_pool));
+
+  if (need_put)
+    {
+      svn_ra_serf__handler_t *handler;
+
+      handler = svn_ra_serf__create_handler(commit_ctx->session, file->pool);
+
+      handler->method = "PUT";
+      handler->path = file->url;
+
+      handler->response_handler = svn_ra_serf__expect_empty_body;
+      handler->response_baton = handler;
+
+      if (put_empty_file)
+        {
+          handler->body_delegate = create_empty_put_body;
+          handler->body_delegate_baton = file;
+          handler->body_type = "text/plain";
+        }
+      else
+        {
+          SVN_ERR(svn_stream_close(file->stream));
+
+          svn_ra_serf__request_body_get_delegate(&handler->body_delegate,
+                                                 &handler->body_delegate_baton,
+                                                 file->svndiff);
+          handler->body_type = SVN_SVNDIFF_MIME_TYPE;
+        }
+
+      handler->header_delegate = setup_put_headers;
+      handler->header_delegate_baton = file;
+
+      queue_pending_request(file, handler,
+                            (file->added && !file->copy_path)
+                              ? 201  /* Created */
+                              : 204, /* Updated */
+                            FALSE);
+    }
+
+  if (need_proppatch)
+    {
+      proppatch_context_t *proppatch;
+
+      proppatch = apr_pcalloc(file->pool, sizeof(*proppatch));
+      proppatch->pool = file->pool;
+      proppatch->relpath = file->relpath;
+      proppatch->path = file->url;
+      proppatch->commit_ctx = commit_ctx;
+      proppatch->prop_changes = file->prop_changes;
+      proppatch->base_revision = file->base_revision;
+
+      queue_pending_request(file,
+                            create_proppatch_handler(commit_ctx->session,
+                                                     proppatch, file->pool),
+                            207, TRUE);
+    }
+
+  commit_ctx->open_batons--;
+
+  if (file->pending_requests == 0)
+    svn_pool_destroy(file->pool);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 close_file(void *file_baton,
            const char *text_checksum,
@@ -2149,6 +2365,16 @@ close_file(void *file_baton,
   if ((!ctx->svndiff) && ctx->added && (!ctx->copy_path))
     put_empty_file = TRUE;
 
+  if (ctx->commit_ctx->pipeline_depth > 0)
+    {
+      /* The requests outlive the caller's pool. */
+      if (text_checksum)
+        ctx->result_checksum = apr_pstrdup(ctx->pool, text_checksum);
+
+      return svn_error_trace(close_file_pipelined(ctx, put_empty_file,
+                                                  scratch_pool));
+    }
+
   /* If we have a stream of changes, push them to the server... */
   if ((ctx->svndiff || put_empty_file) && !ctx->svndiff_sent)
     {
@@ -2251,6 +2477,9 @@ close_edit(void *edit_baton,
               SVN_ERR_FS_INCORRECT_EDITOR_COMPLETION, NULL,
               _("Closing editor with directories or files open"));
 
+  /* Complete the PUTs and PROPPATCHes close_file() left in flight. */
+  SVN_ERR(wait_for_pending_requests(ctx, 0, pool));
+
   /* MERGE our activity */
   SVN_ERR(svn_ra_serf__run_merge(&commit_info,
                                  ctx->session,
@@ -2325,6 +2554,11 @@ abort_edit(void *edit_baton,
 
   SVN_ERR(svn_ra_serf__context_run_one(handler, pool));
 
+  /* Requests still queued by close_file() have been resent and completed
+     before the DELETE; whatever they reported no longer matters. */
+  svn_error_clear(ctx->pending_err);
+  ctx->pending_err = SVN_NO_ERROR;
+
   /* 204 if deleted,
      403 if DELETE was forbidden (indicates MKACTIVITY was forbidden too),
      404 if the activity wasn't found. */
@@ -2392,6 +2626,13 @@ svn_ra_serf__get_commit_editor(svn_ra_session_t *ra_session,
 
   ctx->deleted_entries = apr_hash_make(ctx->pool);
 
+  /* FSFS and FSX refuse concurrent representation writes within one
+     transaction, so pipeline on the first connection only, where the
+     server handles the requests one after the other.  HTTP/2 would run
+     them as concurrent streams. */
+  if (!session->http20)
+    ctx->pipeline_depth = (int)session->commit_pipeline_depth;
+
   editor = svn_delta_default_editor(pool);
   editor->open_root = open_root;
   editor->delete_entry = delete_entry;
@@ -2409,8 +2650,9 @@ svn_ra_serf__get_commit_editor(svn_ra_session_t *ra_session,
   /* Only install the callback that allows streaming PUT request bodies
    * if the server has the necessary capability.  Otherwise, this will
    * fallback to the default implementation using the temporary files.
-   * See default_editor.c:apply_textdelta_stream(). */
-  if (session->supports_put_result_checksum)
+   * See default_editor.c:apply_textdelta_stream().  Pipelined PUTs need
+   * their bodies spooled, as the caller's stream is gone by then. */
+  if (session->supports_put_result_checksum && ctx->pipeline_depth == 0)
     editor->apply_textdelta_stream = apply_textdelta_stream;
 
   *ret_editor = editor;
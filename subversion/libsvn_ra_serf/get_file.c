@@ -74,6 +74,11 @@ typedef struct stream_ctx_t {
   /* If we're writing this file to a stream, this will be non-NULL. */
   svn_stream_t *result_stream;
 
+  /* If RANGE_LENGTH is not negative, only this many bytes of the file,
+     starting at RANGE_OFFSET, get written to RESULT_STREAM. */
+  svn_filesize_t range_offset;
+  svn_filesize_t range_length;
+
 } stream_ctx_t;
 
 
@@ -88,7 +93,19 @@ headers_fetch(serf_bucket_t *headers,
 {
   stream_ctx_t *fetch_ctx = baton;
 
-  if (fetch_ctx->session->using_compression != svn_tristate_false)
+  /* Ranges of a compressed response are useless to us, so don't ask
+     for compression with a range. */
+  if (fetch_ctx->range_length >= 0)
+    {
+      serf_bucket_headers_setn(headers, "Range",
+                               apr_psprintf(pool,
+                                            "bytes=%" SVN_FILESIZE_T_FMT
+                                            "-%" SVN_FILESIZE_T_FMT,
+                                            fetch_ctx->range_offset,
+                                            fetch_ctx->range_offset
+                                            + fetch_ctx->range_length - 1));
+    }
+  else if (fetch_ctx->session->using_compression != svn_tristate_false)
     {
       serf_bucket_headers_setn(headers, "Accept-Encoding", "gzip");
     }
@@ -199,8 +216,24 @@ handle_stream(serf_request_t *request,
 {
   stream_ctx_t *fetch_ctx = handler_baton;
   apr_status_t status;
+  int code = fetch_ctx->handler->sline.code;
+  svn_filesize_t body_offset = 0;
 
-  if (fetch_ctx->handler->sline.code != 200)
+  if (fetch_ctx->range_length >= 0)
+    {
+      /* The range starts beyond the end of the file. */
+      if (code == 416)
+        return svn_error_trace(svn_ra_serf__handle_discard_body(
+                                 request, response, NULL, pool));
+
+      /* A server may also ignore the range and send all of the file. */
+      if (code == 206)
+        body_offset = fetch_ctx->range_offset;
+      else if (code != 200)
+        return svn_error_trace(
+                 svn_ra_serf__unexpected_status(fetch_ctx->handler));
+    }
+  else if (code != 200)
     return svn_error_trace(svn_ra_serf__unexpected_status(fetch_ctx->handler));
 
   while (1)
@@ -246,6 +279,32 @@ handle_stream(serf_request_t *request,
           len -= (apr_size_t)skip;
         }
 
+      if (len && fetch_ctx->range_length >= 0)
+        {
+          /* Clip the data to the range, relative to its start. */
+          svn_filesize_t start = body_offset + fetch_ctx->read_size
+                               - (svn_filesize_t)len
+                               - fetch_ctx->range_offset;
+          svn_filesize_t end = start + (svn_filesize_t)len;
+
+          if (end > fetch_ctx->range_length)
+            end = fetch_ctx->range_length;
+
+          if (end <= start || end <= 0)
+            {
+              len = 0;
+            }
+          else if (start < 0)
+            {
+              data -= start;
+              len = (apr_size_t)end;
+            }
+          else
+            {
+              len = (apr_size_t)(end - start);
+            }
+        }
+
       if (len)
         {
           apr_size_t written_len;
@@ -314,14 +373,19 @@ get_file_prop_cb(void *baton,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_ra_serf__get_file(svn_ra_session_t *ra_session,
-                      const char *path,
-                      svn_revnum_t revision,
-                      svn_stream_t *stream,
-                      svn_revnum_t *fetched_rev,
-                      apr_hash_t **props,
-                      apr_pool_t *result_pool)
+/* Implement svn_ra_serf__get_file() and, if LENGTH is not negative,
+   svn_ra_serf__get_file_range() for the range given by OFFSET and
+   LENGTH. */
+static svn_error_t *
+get_file(svn_ra_session_t *ra_session,
+         const char *path,
+         svn_revnum_t revision,
+         svn_filesize_t offset,
+         svn_filesize_t length,
+         svn_stream_t *stream,
+         svn_revnum_t *fetched_rev,
+         apr_hash_t **props,
+         apr_pool_t *result_pool)
 {
   svn_ra_serf__session_t *session = ra_session->priv;
   const char *fetch_url;
@@ -353,7 +417,7 @@ svn_ra_serf__get_file(svn_ra_session_t *ra_session,
 
   if (props)
       which_props = all_props;
-  else if (stream && session->wc_callbacks->get_wc_contents)
+  else if (stream && length < 0 && session->wc_callbacks->get_wc_contents)
       which_props = type_and_checksum_props;
   else
       which_props = check_path_props;
@@ -383,9 +447,12 @@ svn_ra_serf__get_file(svn_ra_session_t *ra_session,
 
   if (stream)
     {
-      svn_boolean_t found;
-      SVN_ERR(try_get_wc_contents(&found, session, fb.sha1_checksum, stream,
-                                  scratch_pool));
+      svn_boolean_t found = FALSE;
+
+      /* The working copy only helps with whole files. */
+      if (length < 0)
+        SVN_ERR(try_get_wc_contents(&found, session, fb.sha1_checksum,
+                                    stream, scratch_pool));
 
       /* No contents found in the WC, let's fetch from server. */
       if (!found)
@@ -397,6 +464,8 @@ svn_ra_serf__get_file(svn_ra_session_t *ra_session,
           stream_ctx = apr_pcalloc(scratch_pool, sizeof(*stream_ctx));
           stream_ctx->result_stream = stream;
           stream_ctx->session = session;
+          stream_ctx->range_offset = offset;
+          stream_ctx->range_length = length;
 
           handler = svn_ra_serf__create_handler(session, scratch_pool);
 
@@ -419,7 +488,10 @@ svn_ra_serf__get_file(svn_ra_session_t *ra_session,
 
           SVN_ERR(svn_ra_serf__context_run_one(handler, scratch_pool));
 
-          if (handler->sline.code != 200)
+          if (handler->sline.code != 200
+              && (length < 0
+                  || (handler->sline.code != 206
+                      && handler->sline.code != 416)))
             return svn_error_trace(svn_ra_serf__unexpected_status(handler));
         }
     }
@@ -428,3 +500,32 @@ svn_ra_serf__get_file(svn_ra_session_t *ra_session,
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_ra_serf__get_file(svn_ra_session_t *ra_session,
+                      const char *path,
+                      svn_revnum_t revision,
+                      svn_stream_t *stream,
+                      svn_revnum_t *fetched_rev,
+                      apr_hash_t **props,
+                      apr_pool_t *result_pool)
+{
+  return svn_error_trace(get_file(ra_session, path, revision, 0, -1,
+                                  stream, fetched_rev, props, result_pool));
+}
+
+svn_error_t *
+svn_ra_serf__get_file_range(svn_ra_session_t *ra_session,
+                            const char *path,
+                            svn_revnum_t revision,
+                            svn_filesize_t offset,
+                            svn_filesize_t length,
+                            svn_stream_t *stream,
+                            svn_revnum_t *fetched_rev,
+                            apr_hash_t **props,
+                            apr_pool_t *result_pool)
+{
+  return svn_error_trace(get_file(ra_session, path, revision, offset,
+                                  length, stream, fetched_rev, props,
+                                  result_pool));
+}
@@ -36,6 +36,7 @@
 #include "svn_config.h"
 #include "svn_path.h"
 #include "svn_props.h"
+#include "svn_time.h"
 
 #include "private/svn_dav_protocol.h"
 #include "private/svn_string_private.h"
@@ -64,7 +65,8 @@ enum log_state_e {
   REPLACED_PATH,
   DELETED_PATH,
   MODIFIED_PATH,
-  SUBTRACTIVE_MERGE
+  SUBTRACTIVE_MERGE,
+  ENTRY
 };
 
 typedef struct log_context_t {
@@ -96,6 +98,12 @@ typedef struct log_context_t {
   svn_boolean_t want_author;
   svn_boolean_t want_date;
   svn_boolean_t want_message;
+
+  /* Whether to ask the server for compact <S:entry> elements, and the
+     revision and date the next one's deltas are relative to. */
+  svn_boolean_t compact;
+  svn_revnum_t compact_rev;
+  apr_time_t compact_date;
 } log_context_t;
 
 #define D_ "DAV:"
@@ -109,6 +117,9 @@ static const svn_ra_serf__xml_transition_t log_ttable[] = {
   { REPORT, S_, "log-item", ITEM,
     FALSE, { NULL }, TRUE },
 
+  { REPORT, S_, "entry", ENTRY,
+    FALSE, { "r", "?a", "?t", "?d", NULL }, TRUE },
+
   { ITEM, D_, SVN_DAV__VERSION_NAME, VERSION,
     TRUE, { NULL }, TRUE },
 
@@ -331,6 +342,49 @@ log_closed(svn_ra_serf__xml_estate_t *xes,
       log_ctx->collect_revprops = NULL;
       log_ctx->collect_paths = NULL;
     }
+  else if (leaving_state == ENTRY)
+    {
+      svn_log_entry_t *log_entry;
+      const char *value;
+      apr_int64_t delta;
+
+      /* Always advance the delta base, even past the limit.  */
+      SVN_ERR(svn_cstring_atoi64(&delta, svn_hash_gets(attrs, "r")));
+      log_ctx->compact_rev += (svn_revnum_t)delta;
+
+      value = svn_hash_gets(attrs, "t");
+      if (value)
+        {
+          SVN_ERR(svn_cstring_atoi64(&delta, value));
+          log_ctx->compact_date += delta;
+          value = svn_time_to_cstring(log_ctx->compact_date, scratch_pool);
+        }
+      else
+        value = svn_hash_gets(attrs, "d");
+
+      if ((log_ctx->limit > 0) && (log_ctx->nest_level == 0)
+          && (++log_ctx->count > log_ctx->limit))
+        {
+          return SVN_NO_ERROR;
+        }
+
+      log_entry = svn_log_entry_create(scratch_pool);
+      log_entry->revision = log_ctx->compact_rev;
+      log_entry->revprops = apr_hash_make(scratch_pool);
+
+      if (value && log_ctx->want_date)
+        svn_hash_sets(log_entry->revprops, SVN_PROP_REVISION_DATE,
+                      svn_string_create(value, scratch_pool));
+
+      value = svn_hash_gets(attrs, "a");
+      if (value && log_ctx->want_author)
+        svn_hash_sets(log_entry->revprops, SVN_PROP_REVISION_AUTHOR,
+                      svn_string_create(value, scratch_pool));
+
+      SVN_ERR(log_ctx->receiver(log_ctx->receiver_baton,
+                                log_entry,
+                                scratch_pool));
+    }
   else if (leaving_state == VERSION)
     {
       svn_ra_serf__xml_note(xes, ITEM, "revision", cdata->data);
@@ -498,6 +552,12 @@ create_log_body(serf_bucket_t **body_bkt,
   svn_ra_serf__add_empty_tag_buckets(buckets, alloc,
                                      "S:encode-binary-props", SVN_VA_NULL);
 
+  if (log_ctx->compact)
+    {
+      svn_ra_serf__add_empty_tag_buckets(buckets, alloc,
+                                         "S:compact-entries", SVN_VA_NULL);
+    }
+
   svn_ra_serf__add_close_tag_buckets(buckets, alloc,
                                      "S:log-report");
 
@@ -540,6 +600,9 @@ svn_ra_serf__get_log(svn_ra_session_t *ra_session,
   log_ctx->include_merged_revisions = include_merged_revisions;
   log_ctx->revprops = revprops;
   log_ctx->nest_level = 0;
+  log_ctx->compact = session->supports_log_compact;
+  log_ctx->compact_rev = 0;
+  log_ctx->compact_date = 0;
 
   want_custom_revprops = FALSE;
   if (revprops)
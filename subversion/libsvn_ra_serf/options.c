@@ -247,10 +247,19 @@ capabilities_headers_iterator_callback(void *baton,
           /* Same for svndiff2. */
           session->supports_svndiff2 = TRUE;
         }
+      if (svn_cstring_match_list(SVN_DAV_NS_DAV_SVN_SVNDIFF3, vals))
+        {
+          /* And svndiff3. */
+          session->supports_svndiff3 = TRUE;
+        }
       if (svn_cstring_match_list(SVN_DAV_NS_DAV_SVN_PUT_RESULT_CHECKSUM, vals))
         {
           session->supports_put_result_checksum = TRUE;
         }
+      if (svn_cstring_match_list(SVN_DAV_NS_DAV_SVN_LOG_COMPACT, vals))
+        {
+          session->supports_log_compact = TRUE;
+        }
     }
 
   /* SVN-specific headers -- if present, server supports HTTP protocol v2 */
@@ -704,6 +713,22 @@ svn_ra_serf__has_capability(svn_ra_session_t *ra_session,
       return SVN_NO_ERROR;
     }
 
+  /* Any HTTP server can answer Range requests, though not all of them
+     avoid producing the complete file to do so. */
+  if (strcmp(capability, SVN_RA_CAPABILITY_GET_FILE_RANGE) == 0)
+    {
+      *has = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  /* The protocol has no request for these. */
+  if (strcmp(capability, SVN_RA_CAPABILITY_SERVER_BLAME) == 0
+      || strcmp(capability, SVN_RA_CAPABILITY_GET_FILES) == 0)
+    {
+      *has = FALSE;
+      return SVN_NO_ERROR;
+    }
+
   cap_result = svn_hash_gets(serf_sess->capabilities, capability);
 
   /* If any capability is unknown, they're all unknown, so ask. */
@@ -693,6 +693,36 @@ retrieve_baseline_info(svn_revnum_t *actual_revision,
 }
 
 
+/* Like svn_ra_serf__discover_vcc(), but also make the baseline cache of
+   SESSION persistent if that has been enabled.  The cache file is
+   specific to the server and the VCC URL.  */
+static svn_error_t *
+discover_v1_vcc(const char **vcc_url,
+                svn_ra_serf__session_t *session,
+                apr_pool_t *scratch_pool)
+{
+  SVN_ERR(svn_ra_serf__discover_vcc(vcc_url, session, scratch_pool));
+
+  if (session->persistent_blncache)
+    {
+      const char *config_dir = NULL;
+      const char *key;
+
+      if (session->auth_baton)
+        config_dir = svn_auth_get_parameter(session->auth_baton,
+                                            SVN_AUTH_PARAM_CONFIG_DIR);
+
+      key = apr_psprintf(scratch_pool, "%s://%s%s",
+                         session->session_url.scheme,
+                         session->session_url.hostinfo, *vcc_url);
+      SVN_ERR(svn_ra_serf__blncache_persist(session->blncache, config_dir,
+                                            key, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
 /* For HTTPv1 servers, do a PROPFIND dance on the VCC to fetch the youngest
    revnum. If BASECOLL_URL is non-NULL, then the corresponding baseline
    collection URL is also returned.
@@ -764,7 +794,7 @@ svn_ra_serf__get_youngest_revnum(svn_revnum_t *youngest,
     return svn_error_trace(svn_ra_serf__v2_get_youngest_revnum(
                              youngest, session, scratch_pool));
 
-  SVN_ERR(svn_ra_serf__discover_vcc(&vcc_url, session, scratch_pool));
+  SVN_ERR(discover_v1_vcc(&vcc_url, session, scratch_pool));
 
   return svn_error_trace(v1_get_youngest_revnum(youngest, NULL,
                                                 session, vcc_url,
@@ -812,7 +842,7 @@ get_baseline_info(const char **bc_url,
     {
       const char *vcc_url;
 
-      SVN_ERR(svn_ra_serf__discover_vcc(&vcc_url, session, scratch_pool));
+      SVN_ERR(discover_v1_vcc(&vcc_url, session, scratch_pool));
 
       if (SVN_IS_VALID_REVNUM(revision))
         {
@@ -82,6 +82,10 @@ typedef struct svn_ra_serf__connection_t {
 
   svn_ra_serf__session_t *session;
 
+  /* Response bytes received by fetches since this connection was opened.
+     A connection that carried more data likely has a wider TCP window. */
+  apr_uint64_t fetched_bytes;
+
 } svn_ra_serf__connection_t;
 
 /** Maximum value we'll allow for the http-max-connections config option.
@@ -110,6 +114,26 @@ struct svn_ra_serf__session_t {
      fetch operations (updates, etc.) */
   apr_int64_t max_connections;
 
+  /* The number of connections that parallelized fetches may currently
+     use, between 2 and MAX_CONNECTIONS.  Adapted by update.c to the
+     measured latency and to overload responses from the server. */
+  int conn_limit;
+
+  /* Smoothed time until the first response byte of a fetch sent on an
+     idle connection, or 0 if that has not been measured yet. */
+  apr_interval_time_t fetch_latency;
+
+  /* CONN_LIMIT must not be raised before this time, because the server
+     reported an overload. */
+  apr_time_t conn_backoff_until;
+
+  /* The number of file PUT and PROPPATCH requests that a commit may keep
+     in flight, or 0 to complete each file before the next one. */
+  apr_int64_t commit_pipeline_depth;
+
+  /* Whether BLNCACHE shall be kept on disk across sessions. */
+  svn_boolean_t persistent_blncache;
+
   /* Are we using ssl */
   svn_boolean_t using_ssl;
 
@@ -269,10 +293,17 @@ struct svn_ra_serf__session_t {
   /* Indicates whether the server can understand svndiff version 2. */
   svn_boolean_t supports_svndiff2;
 
+  /* Indicates whether the server can understand svndiff version 3. */
+  svn_boolean_t supports_svndiff3;
+
   /* Indicates whether the server sends the result checksum in the response
    * to a successful PUT request. */
   svn_boolean_t supports_put_result_checksum;
 
+  /* Indicates whether the server can send compact <S:entry> elements
+   * in a log report. */
+  svn_boolean_t supports_log_compact;
+
   apr_interval_time_t conn_latency;
 };
 
@@ -1355,6 +1386,18 @@ svn_ra_serf__get_file(svn_ra_session_t *session,
                       apr_hash_t **props,
                       apr_pool_t *pool);
 
+/* Implements svn_ra__vtable_t.get_file_range(). */
+svn_error_t *
+svn_ra_serf__get_file_range(svn_ra_session_t *session,
+                            const char *path,
+                            svn_revnum_t revision,
+                            svn_filesize_t offset,
+                            svn_filesize_t length,
+                            svn_stream_t *stream,
+                            svn_revnum_t *fetched_rev,
+                            apr_hash_t **props,
+                            apr_pool_t *pool);
+
 /* Implements svn_ra__vtable_t.get_dir(). */
 svn_error_t *
 svn_ra_serf__get_dir(svn_ra_session_t *ra_session,
@@ -1600,6 +1643,13 @@ void
 svn_ra_serf__setup_svndiff_accept_encoding(serf_bucket_t *headers,
                                            svn_ra_serf__session_t *session);
 
+/* Return the svndiff versions that SESSION is willing to use, most
+   preferred first and terminated by -1.  This is the order advertised
+   by svn_ra_serf__setup_svndiff_accept_encoding() and should also be
+   used for deltas sent to the server. */
+const int *
+svn_ra_serf__get_svndiff_preferences(svn_ra_serf__session_t *session);
+
 svn_boolean_t
 svn_ra_serf__is_low_latency_connection(svn_ra_serf__session_t *session);
 
@@ -1659,6 +1709,21 @@ svn_ra_serf__create_stream_bucket(svn_stream_t *stream,
                                   svn_ra_serf__stream_bucket_errfunc_t errfunc,
                                   void *errfunc_baton);
 
+/* Create a bucket that produces the svndiff-encoded text delta from
+   TXSTREAM, using SVNDIFF_VERSION and COMPRESSION_LEVEL.  Unlike a stream
+   bucket around svn_txdelta_to_svndiff_stream(), this hands out the
+   encoded windows without copying them.  Errors are reported through
+   ERRFUNC as in svn_ra_serf__create_stream_bucket().  The encoder state
+   is allocated in RESULT_POOL. */
+serf_bucket_t *
+svn_ra_serf__create_svndiff_bucket(svn_txdelta_stream_t *txstream,
+                                   int svndiff_version,
+                                   int compression_level,
+                                   serf_bucket_alloc_t *allocator,
+                                   svn_ra_serf__stream_bucket_errfunc_t errfunc,
+                                   void *errfunc_baton,
+                                   apr_pool_t *result_pool);
+
 #if defined(SVN_DEBUG)
 /* Wrapper macros to collect file and line information */
 #define svn_ra_serf__wrap_err \
@@ -161,6 +161,7 @@ load_config(svn_ra_serf__session_t *session,
   const char *proxy_host = NULL;
   const char *port_str = NULL;
   const char *timeout_str = NULL;
+  const char *max_connections_option;
   const char *exceptions;
   apr_port_t proxy_port;
   svn_tristate_t chunked_requests;
@@ -244,6 +245,20 @@ load_config(svn_ra_serf__session_t *session,
                                SVN_CONFIG_SECTION_GLOBAL,
                                SVN_CONFIG_OPTION_HTTP_MAX_CONNECTIONS,
                                SVN_CONFIG_DEFAULT_OPTION_HTTP_MAX_CONNECTIONS));
+  svn_config_get(config, &max_connections_option, SVN_CONFIG_SECTION_GLOBAL,
+                 SVN_CONFIG_OPTION_HTTP_MAX_CONNECTIONS, NULL);
+
+  /* Load the number of commit requests to keep in flight. */
+  SVN_ERR(svn_config_get_int64(config, &session->commit_pipeline_depth,
+                               SVN_CONFIG_SECTION_GLOBAL,
+                               SVN_CONFIG_OPTION_HTTP_COMMIT_PIPELINE_DEPTH,
+                               0));
+
+  /* Should we keep the baseline cache on disk. */
+  SVN_ERR(svn_config_get_bool(config, &session->persistent_blncache,
+                              SVN_CONFIG_SECTION_GLOBAL,
+                              SVN_CONFIG_OPTION_HTTP_BASELINE_CACHE,
+                              FALSE));
 
   /* Should we use chunked transfer encoding. */
   SVN_ERR(svn_config_get_tristate(config, &chunked_requests,
@@ -311,6 +326,23 @@ load_config(svn_ra_serf__session_t *session,
                                    server_group,
                                    SVN_CONFIG_OPTION_HTTP_MAX_CONNECTIONS,
                                    session->max_connections));
+      svn_config_get(config, &max_connections_option, server_group,
+                     SVN_CONFIG_OPTION_HTTP_MAX_CONNECTIONS,
+                     max_connections_option);
+
+      /* Load the number of commit requests to keep in flight, overriding
+         the global value. */
+      SVN_ERR(svn_config_get_int64(
+                config, &session->commit_pipeline_depth, server_group,
+                SVN_CONFIG_OPTION_HTTP_COMMIT_PIPELINE_DEPTH,
+                session->commit_pipeline_depth));
+
+      /* Should we keep the baseline cache on disk, overriding the global
+         value. */
+      SVN_ERR(svn_config_get_bool(config, &session->persistent_blncache,
+                                  server_group,
+                                  SVN_CONFIG_OPTION_HTTP_BASELINE_CACHE,
+                                  session->persistent_blncache));
 
       /* Should we use chunked transfer encoding. */
       SVN_ERR(svn_config_get_tristate(config, &chunked_requests,
@@ -357,6 +389,18 @@ load_config(svn_ra_serf__session_t *session,
   if (session->max_connections < 2)
     session->max_connections = 2;
 
+  /* Start with that many connections.  Unless the number has been
+     configured explicitly, allow updates to use up to the compiled-in
+     limit on high-latency links. */
+  session->conn_limit = (int)session->max_connections;
+  if (!max_connections_option)
+    session->max_connections = SVN_RA_SERF__MAX_CONNECTIONS_LIMIT;
+
+  if (session->commit_pipeline_depth < 0)
+    session->commit_pipeline_depth = 0;
+  else if (session->commit_pipeline_depth > 1000)
+    session->commit_pipeline_depth = 1000;
+
   /* Parse the connection timeout value, if any. */
   session->timeout = apr_time_from_sec(DEFAULT_HTTP_TIMEOUT);
   if (timeout_str)
@@ -643,6 +687,11 @@ ra_serf_dup_session(svn_ra_session_t *new_session,
                                    result_pool));
 
   /* max_connections */
+  /* conn_limit */
+  /* fetch_latency */
+  /* conn_backoff_until */
+  /* commit_pipeline_depth */
+  /* persistent_blncache */
   /* using_ssl */
   /* using_compression */
   /* http10 */
@@ -762,7 +811,9 @@ ra_serf_dup_session(svn_ra_session_t *new_session,
   /* supports_rev_rsrc_replay */
   /* supports_svndiff1 */
   /* supports_svndiff2 */
+  /* supports_svndiff3 */
   /* supports_put_result_checksum */
+  /* supports_log_compact */
   /* conn_latency */
 
   new_sess->context = serf_context_create(result_pool);
@@ -1068,6 +1119,9 @@ static const svn_ra__vtable_t serf_vtable = {
   svn_ra_serf__get_inherited_props,
   NULL /* set_svn_ra_open */,
   svn_ra_serf__list,
+  NULL /* get_blame */,
+  NULL /* get_files */,
+  svn_ra_serf__get_file_range,
   svn_ra_serf__register_editor_shim_callbacks,
   NULL /* commit_ev2 */,
   NULL /* replay_range_ev2 */
@@ -0,0 +1,138 @@
+/*
+ * svndiff_bucket.c : a serf bucket that produces svndiff data
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <serf.h>
+#include <serf_bucket_util.h>
+
+#include "svn_private_config.h"
+#include "private/svn_delta_private.h"
+
+#include "ra_serf.h"
+
+typedef struct svndiff_bucket_ctx_t
+{
+  svn_txdelta__svndiff_reader_t *reader;
+  svn_ra_serf__stream_bucket_errfunc_t errfunc;
+  void *errfunc_baton;
+} svndiff_bucket_ctx_t;
+
+/* Get the next encoded data from CTX's reader in *DATA and *LEN.  Report
+   errors through the errfunc. */
+static apr_status_t
+svndiff_bucket_fetch(svndiff_bucket_ctx_t *ctx,
+                     const char **data,
+                     apr_size_t *len)
+{
+  svn_error_t *err;
+
+  err = svn_txdelta__svndiff_reader_peek(data, len, ctx->reader);
+  if (err)
+    {
+      if (ctx->errfunc)
+        ctx->errfunc(ctx->errfunc_baton, err);
+      svn_error_clear(err);
+
+      return SVN_ERR_RA_SERF_STREAM_BUCKET_READ_ERROR;
+    }
+
+  return *len ? APR_SUCCESS : APR_EOF;
+}
+
+static apr_status_t
+svndiff_bucket_read(serf_bucket_t *bucket, apr_size_t requested,
+                    const char **data, apr_size_t *len)
+{
+  svndiff_bucket_ctx_t *ctx = bucket->data;
+  apr_status_t status;
+
+  /* Hand out the reader's buffer directly.  It stays valid until we
+     peek again, i.e. until the next call to this bucket. */
+  status = svndiff_bucket_fetch(ctx, data, len);
+  if (status)
+    return status;
+
+  if (*len > requested)
+    *len = requested;
+
+  svn_txdelta__svndiff_reader_release(ctx->reader, *len);
+
+  return APR_SUCCESS;
+}
+
+#if !SERF_VERSION_AT_LEAST(1, 4, 0)
+static apr_status_t
+svndiff_bucket_readline(serf_bucket_t *bucket, int acceptable,
+                        int *found,
+                        const char **data, apr_size_t *len)
+{
+  /* ### for now, we know callers won't use this function.  */
+  svn_error_clear(svn_error__malfunction(TRUE, __FILE__, __LINE__,
+                                         "Not implemented."));
+  return APR_ENOTIMPL;
+}
+#endif
+
+static apr_status_t
+svndiff_bucket_peek(serf_bucket_t *bucket,
+                    const char **data, apr_size_t *len)
+{
+  svndiff_bucket_ctx_t *ctx = bucket->data;
+
+  return svndiff_bucket_fetch(ctx, data, len);
+}
+
+static const serf_bucket_type_t svndiff_bucket_vtable = {
+  "SVNDIFF",
+  svndiff_bucket_read,
+#if SERF_VERSION_AT_LEAST(1, 4, 0)
+  serf_default_readline,
+#else
+  svndiff_bucket_readline,
+#endif
+  serf_default_read_iovec,
+  serf_default_read_for_sendfile,
+  serf_default_read_bucket,
+  svndiff_bucket_peek,
+  serf_default_destroy_and_data
+};
+
+serf_bucket_t *
+svn_ra_serf__create_svndiff_bucket(svn_txdelta_stream_t *txstream,
+                                   int svndiff_version,
+                                   int compression_level,
+                                   serf_bucket_alloc_t *allocator,
+                                   svn_ra_serf__stream_bucket_errfunc_t errfunc,
+                                   void *errfunc_baton,
+                                   apr_pool_t *result_pool)
+{
+  svndiff_bucket_ctx_t *ctx;
+
+  ctx = serf_bucket_mem_calloc(allocator, sizeof(*ctx));
+  ctx->reader = svn_txdelta__svndiff_reader_create(txstream, svndiff_version,
+                                                   compression_level,
+                                                   result_pool);
+  ctx->errfunc = errfunc;
+  ctx->errfunc_baton = errfunc_baton;
+
+  return serf_bucket_create(&svndiff_bucket_vtable, allocator, ctx);
+}
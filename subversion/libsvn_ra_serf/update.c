@@ -255,6 +255,11 @@ static const svn_ra_serf__xml_transition_t update_ttable[] = {
 #define REQUEST_COUNT_TO_PAUSE 50
 #define REQUEST_COUNT_TO_RESUME 40
 
+/* With HTTP/2 all requests are streams multiplexed over one connection,
+   so a slow response doesn't hold up the ones behind it.  Keep many more
+   of them outstanding to cover the latency. */
+#define HTTP2_REQUEST_COUNT_TO_RESUME 200
+
 #define SPILLBUF_BLOCKSIZE 4096
 #define SPILLBUF_MAXBUFFSIZE 131072
 
@@ -388,6 +393,12 @@ typedef struct fetch_ctx_t {
   /* The base-rev header  */
   const char *delta_base;
 
+  /* When the request was sent on an otherwise idle connection, or 0. */
+  apr_time_t sent_time;
+
+  /* How often this fetch has been retried after an overload response. */
+  int retries;
+
 } fetch_ctx_t;
 
 /*
@@ -544,21 +555,102 @@ create_file_baton(file_baton_t **new_file,
   return SVN_NO_ERROR;
 }
 
+/* Return the number of outstanding requests below which CTX resumes
+   processing the REPORT response. */
+static unsigned int
+request_count_to_resume(const report_context_t *ctx)
+{
+  return ctx->sess->http20 ? HTTP2_REQUEST_COUNT_TO_RESUME
+                           : REQUEST_COUNT_TO_RESUME;
+}
+
 /** Minimum nr. of outstanding requests needed before a new connection is
  *  opened. */
 #define REQS_PER_CONN 8
 
+/* Fetch latencies from which on new connections are opened for fewer
+   outstanding requests, and from which on more connections than
+   configured by default may be opened. */
+#define MEDIUM_FETCH_LATENCY apr_time_from_msec(40)
+#define HIGH_FETCH_LATENCY apr_time_from_msec(120)
+
+/* For how long no connections are added after the server has answered a
+   fetch with 503 Service Unavailable. */
+#define OVERLOAD_BACKOFF apr_time_from_sec(30)
+
+/* How often a fetch is retried after 503 Service Unavailable. */
+#define MAX_FETCH_RETRIES 3
+
+/* Return the number of outstanding requests per connection for SESS
+   that justifies opening another connection.  The higher the latency,
+   the more a connection waits rather than transfers, so the sooner
+   another one pays off. */
+static int
+requests_per_connection(const svn_ra_serf__session_t *sess)
+{
+  if (sess->fetch_latency >= HIGH_FETCH_LATENCY)
+    return REQS_PER_CONN / 4;
+  else if (sess->fetch_latency >= MEDIUM_FETCH_LATENCY)
+    return REQS_PER_CONN / 2;
+  else
+    return REQS_PER_CONN;
+}
+
+/* Fold the LATENCY measured for a fetch into the estimate of SESS. */
+static void
+record_fetch_latency(svn_ra_serf__session_t *sess,
+                     apr_interval_time_t latency)
+{
+  if (sess->fetch_latency)
+    sess->fetch_latency = (7 * sess->fetch_latency + latency) / 8;
+  else
+    sess->fetch_latency = latency;
+}
+
+/* Allow SESS to use another connection for fetches if all connections
+   it may currently use are open and busy with NUM_ACTIVE_REQS requests
+   in total, the link has a high latency and the server has not been
+   overloaded recently. */
+static void
+raise_connection_limit(svn_ra_serf__session_t *sess, int num_active_reqs)
+{
+  if (sess->conn_limit < sess->max_connections
+      && sess->num_conns >= sess->conn_limit
+      && sess->fetch_latency >= HIGH_FETCH_LATENCY
+      && (num_active_reqs / requests_per_connection(sess)) > sess->conn_limit
+      && apr_time_now() >= sess->conn_backoff_until)
+    sess->conn_limit++;
+}
+
+/* The server answered a fetch on SESS with 503 Service Unavailable.  Use
+   one connection less from now on, but at least two, and don't add any
+   for a while. */
+static void
+lower_connection_limit(svn_ra_serf__session_t *sess)
+{
+  int limit = (sess->num_conns < sess->conn_limit) ? sess->num_conns
+                                                   : sess->conn_limit;
+
+  sess->conn_limit = (limit > 2) ? limit - 1 : 2;
+  sess->conn_backoff_until = apr_time_now() + OVERLOAD_BACKOFF;
+}
+
 /** This function creates a new connection for this serf session, but only
- * if the number of NUM_ACTIVE_REQS > REQS_PER_CONN or if there currently is
- * only one main connection open.
+ * if the number of NUM_ACTIVE_REQS exceeds the requests per connection
+ * for the measured latency or if there currently is only one main
+ * connection open.
  */
 static svn_error_t *
 open_connection_if_needed(svn_ra_serf__session_t *sess, int num_active_reqs)
 {
-  /* For each REQS_PER_CONN outstanding requests open a new connection, with
+  /* An HTTP/2 connection carries any number of concurrent requests. */
+  if (sess->http20)
+    return SVN_NO_ERROR;
+
+  /* For each batch of outstanding requests open a new connection, with
    * a minimum of 1 extra connection. */
   if (sess->num_conns == 1 ||
-      ((num_active_reqs / REQS_PER_CONN) > sess->num_conns))
+      ((num_active_reqs / requests_per_connection(sess)) > sess->num_conns))
     {
       int cur = sess->num_conns;
       apr_status_t status;
@@ -591,6 +683,7 @@ get_best_connection(report_context_t *ctx)
 {
   svn_ra_serf__connection_t *conn;
   int first_conn = 1;
+  int num_conns = ctx->sess->num_conns;
 
   /* Skip the first connection if the REPORT response hasn't been completely
      received yet or if we're being told to limit our connections to
@@ -605,12 +698,22 @@ get_best_connection(report_context_t *ctx)
      ###
      ### See https://issues.apache.org/jira/browse/SVN-4116.
   */
+  /* With HTTP/2 the REPORT response doesn't block the requests sent after
+     it on the same connection, so they all become streams on that one. */
+  if (ctx->sess->http20)
+    return ctx->sess->conns[0];
+
   if (ctx->report_received && (ctx->sess->max_connections > 2))
     first_conn = 0;
 
+  /* Leave the connections alone that we stopped using after an overload
+     of the server. */
+  if (num_conns > ctx->sess->conn_limit)
+    num_conns = ctx->sess->conn_limit;
+
   /* If there's only one available auxiliary connection to use, don't bother
      doing all the cur_conn math -- just return that one connection.  */
-  if (ctx->sess->num_conns - first_conn == 1)
+  if (num_conns - first_conn == 1)
     {
       conn = ctx->sess->conns[first_conn];
     }
@@ -625,15 +728,19 @@ get_best_connection(report_context_t *ctx)
 
          The method used here selects the connection with the least amount of
          pending requests, thereby giving more work to lightly loaded server
-         processes.
+         processes.  Among those, prefer the connection that has carried the
+         most data, as its TCP window is likely the widest.
        */
       int i, best_conn = first_conn;
       unsigned int min = INT_MAX;
-      for (i = first_conn; i < ctx->sess->num_conns; i++)
+      for (i = first_conn; i < num_conns; i++)
         {
           serf_connection_t *sc = ctx->sess->conns[i]->conn;
           unsigned int pending = serf_connection_pending_requests(sc);
-          if (pending < min)
+          if (pending < min
+              || (pending == min
+                  && ctx->sess->conns[i]->fetched_bytes
+                       > ctx->sess->conns[best_conn]->fetched_bytes))
             {
               min = pending;
               best_conn = i;
@@ -643,15 +750,17 @@ get_best_connection(report_context_t *ctx)
 #else
     /* We don't know how many requests are pending per connection, so just
        cycle them. */
+      if (ctx->sess->cur_conn >= num_conns)
+        ctx->sess->cur_conn = first_conn;
       conn = ctx->sess->conns[ctx->sess->cur_conn];
       ctx->sess->cur_conn++;
-      if (ctx->sess->cur_conn >= ctx->sess->num_conns)
+      if (ctx->sess->cur_conn >= num_conns)
         ctx->sess->cur_conn = first_conn;
 #endif
     }
   return conn;
 }
-
+
 /** Helpers to open and close directories */
 
 static svn_error_t*
@@ -792,6 +901,13 @@ headers_fetch(serf_bucket_t *headers,
 {
   fetch_ctx_t *fetch_ctx = baton;
 
+#if SERF_VERSION_AT_LEAST(1, 4, 0)
+  /* Only a request on an otherwise idle connection measures the latency
+     rather than the time spent waiting behind other responses. */
+  if (serf_connection_pending_requests(fetch_ctx->handler->conn->conn) <= 1)
+#endif
+    fetch_ctx->sent_time = apr_time_now();
+
   /* note that we have old VC URL */
   if (fetch_ctx->delta_base)
     {
@@ -962,6 +1078,13 @@ handle_fetch(serf_request_t *request,
       serf_bucket_t *hdrs;
       const char *val;
 
+      if (fetch_ctx->sent_time)
+        {
+          record_fetch_latency(fetch_ctx->session,
+                               apr_time_now() - fetch_ctx->sent_time);
+          fetch_ctx->sent_time = 0;
+        }
+
       /* If the error code wasn't 200, something went wrong. Don't use the
        * returned data as its probably an error message. Just bail out instead.
        */
@@ -1020,6 +1143,7 @@ handle_fetch(serf_request_t *request,
         }
 
       fetch_ctx->read_size += len;
+      fetch_ctx->handler->conn->fetched_bytes += len;
 
       if (fetch_ctx->aborted_read)
         {
@@ -1173,6 +1297,11 @@ file_props_done(serf_request_t *request,
   return svn_error_trace(close_file(file, scratch_pool));
 }
 
+/* Forward declaration */
+static void
+send_fetch(fetch_ctx_t *fetch_ctx,
+           svn_ra_serf__connection_t *conn);
+
 static svn_error_t *
 file_fetch_done(serf_request_t *request,
                 void *baton,
@@ -1182,6 +1311,18 @@ file_fetch_done(serf_request_t *request,
   file_baton_t *file = fetch_ctx->file;
   svn_ra_serf__handler_t *handler = fetch_ctx->handler;
 
+  /* The server is overloaded.  Use fewer connections and try again. */
+  if (handler->sline.code == 503 && fetch_ctx->retries < MAX_FETCH_RETRIES)
+    {
+      report_context_t *ctx = file->parent_dir->ctx;
+
+      lower_connection_limit(ctx->sess);
+      fetch_ctx->retries++;
+      send_fetch(fetch_ctx, get_best_connection(ctx));
+
+      return SVN_NO_ERROR;
+    }
+
   if (handler->server_error)
       return svn_error_trace(svn_ra_serf__server_error_create(handler,
                                                               scratch_pool));
@@ -1205,6 +1346,42 @@ file_fetch_done(serf_request_t *request,
   return svn_error_trace(close_file(file, scratch_pool));
 }
 
+/* Send the GET request for FETCH_CTX on CONN. */
+static void
+send_fetch(fetch_ctx_t *fetch_ctx,
+           svn_ra_serf__connection_t *conn)
+{
+  file_baton_t *file = fetch_ctx->file;
+  svn_ra_serf__handler_t *handler;
+
+  handler = svn_ra_serf__create_handler(fetch_ctx->session, file->pool);
+
+  handler->method = "GET";
+  handler->path = file->url;
+
+  handler->conn = conn; /* Explicit scheduling */
+
+  handler->custom_accept_encoding = TRUE;
+  handler->no_dav_headers = TRUE;
+  handler->header_delegate = headers_fetch;
+  handler->header_delegate_baton = fetch_ctx;
+
+  handler->response_handler = handle_fetch;
+  handler->response_baton = fetch_ctx;
+
+  handler->response_error = cancel_fetch;
+  handler->response_error_baton = fetch_ctx;
+
+  handler->done_delegate = file_fetch_done;
+  handler->done_delegate_baton = fetch_ctx;
+
+  fetch_ctx->handler = handler;
+  fetch_ctx->read_headers = FALSE;
+  fetch_ctx->sent_time = 0;
+
+  svn_ra_serf__request_create(handler);
+}
+
 /* Initiates additional requests needed for a file when not in "send-all" mode.
  */
 static svn_error_t *
@@ -1213,10 +1390,11 @@ fetch_for_file(file_baton_t *file,
 {
   report_context_t *ctx = file->parent_dir->ctx;
   svn_ra_serf__connection_t *conn;
-  svn_ra_serf__handler_t *handler;
 
   /* Open extra connections if we have enough requests to send. */
-  if (ctx->sess->num_conns < ctx->sess->max_connections)
+  raise_connection_limit(ctx->sess, ctx->num_active_fetches +
+                                    ctx->num_active_propfinds);
+  if (ctx->sess->num_conns < ctx->sess->conn_limit)
     SVN_ERR(open_connection_if_needed(ctx->sess, ctx->num_active_fetches +
                                                  ctx->num_active_propfinds));
 
@@ -1324,30 +1502,7 @@ fetch_for_file(file_baton_t *file,
                                         : NULL;
             }
 
-          handler = svn_ra_serf__create_handler(ctx->sess, file->pool);
-
-          handler->method = "GET";
-          handler->path = file->url;
-
-          handler->conn = conn; /* Explicit scheduling */
-
-          handler->custom_accept_encoding = TRUE;
-          handler->no_dav_headers = TRUE;
-          handler->header_delegate = headers_fetch;
-          handler->header_delegate_baton = fetch_ctx;
-
-          handler->response_handler = handle_fetch;
-          handler->response_baton = fetch_ctx;
-
-          handler->response_error = cancel_fetch;
-          handler->response_error_baton = fetch_ctx;
-
-          handler->done_delegate = file_fetch_done;
-          handler->done_delegate_baton = fetch_ctx;
-
-          fetch_ctx->handler = handler;
-
-          svn_ra_serf__request_create(handler);
+          send_fetch(fetch_ctx, conn);
 
           ctx->num_active_fetches++;
         }
@@ -1444,7 +1599,9 @@ fetch_for_dir(dir_baton_t *dir,
   svn_ra_serf__connection_t *conn;
 
   /* Open extra connections if we have enough requests to send. */
-  if (ctx->sess->num_conns < ctx->sess->max_connections)
+  raise_connection_limit(ctx->sess, ctx->num_active_fetches +
+                                    ctx->num_active_propfinds);
+  if (ctx->sess->num_conns < ctx->sess->conn_limit)
     SVN_ERR(open_connection_if_needed(ctx->sess, ctx->num_active_fetches +
                                                  ctx->num_active_propfinds));
 
@@ -2251,7 +2408,7 @@ update_delay_handler(serf_request_t *request,
         }
 
       while ((udb->report->num_active_fetches + udb->report->num_active_propfinds)
-                 < REQUEST_COUNT_TO_RESUME)
+                 < request_count_to_resume(udb->report))
         {
           const char *data;
           apr_size_t len;
@@ -2335,7 +2492,7 @@ process_pending(update_delay_baton_t *udb,
   serf_bucket_alloc_t *alloc = NULL;
 
   while ((udb->report->num_active_fetches + udb->report->num_active_propfinds)
-            < REQUEST_COUNT_TO_RESUME)
+            < request_count_to_resume(udb->report))
     {
       const char *data;
       apr_size_t len;
@@ -2409,7 +2566,7 @@ process_editor_report(report_context_t *ctx,
   /* Open the first extra connection. */
   SVN_ERR(open_connection_if_needed(sess, 0));
 
-  sess->cur_conn = 1;
+  sess->cur_conn = (sess->num_conns > 1) ? 1 : 0;
 
   /* Note that we may have no active GET or PROPFIND requests, yet the
      processing has not been completed. This could be from a delay on the
@@ -45,6 +45,7 @@
 #include "private/svn_fspath.h"
 #include "private/svn_auth_private.h"
 #include "private/svn_cert.h"
+#include "private/svn_subr_private.h"
 
 #include "ra_serf.h"
 
@@ -2042,39 +2043,66 @@ svn_ra_serf__uri_parse(apr_uri_t *uri,
   return SVN_NO_ERROR;
 }
 
-void
-svn_ra_serf__setup_svndiff_accept_encoding(serf_bucket_t *headers,
-                                           svn_ra_serf__session_t *session)
+/* An ordered list of svndiff versions and the matching "Accept-Encoding"
+   header value. */
+typedef struct svndiff_prefs_t
+{
+  int versions[5];
+  const char *accept_encoding;
+} svndiff_prefs_t;
+
+/* Don't advertise support for compressed svndiff formats if compression
+   is disabled. */
+static const svndiff_prefs_t uncompressed_prefs =
+  { { 0, -1 }, "svndiff" };
+
+/* With http-compression=auto, prefer svndiff2 to svndiff1 with a low
+   latency connection (assuming the underlying network has high bandwidth),
+   as it is faster and in this case, we don't care about worse compression
+   ratio. */
+static const svndiff_prefs_t fast_prefs =
+  { { 2, 3, 1, 0, -1 },
+    "gzip,svndiff2;q=0.9,svndiff3;q=0.85,svndiff1;q=0.8,svndiff;q=0.7" };
+static const svndiff_prefs_t fast_prefs_no_zstd =
+  { { 2, 1, 0, -1 },
+    "gzip,svndiff2;q=0.9,svndiff1;q=0.8,svndiff;q=0.7" };
+
+/* Otherwise, prefer svndiff1 over svndiff2.  svndiff2 is not a reasonable
+   substitute for svndiff1 with default compression level, because, while
+   it is faster, it also gives worse compression ratio.  svndiff3, if
+   available, beats svndiff1 in both respects. */
+static const svndiff_prefs_t small_prefs =
+  { { 3, 1, 2, 0, -1 },
+    "gzip,svndiff3;q=0.95,svndiff1;q=0.9,svndiff2;q=0.8,svndiff;q=0.7" };
+static const svndiff_prefs_t small_prefs_no_zstd =
+  { { 1, 2, 0, -1 },
+    "gzip,svndiff1;q=0.9,svndiff2;q=0.8,svndiff;q=0.7" };
+
+/* Return the svndiff preferences for SESSION. */
+static const svndiff_prefs_t *
+get_svndiff_prefs(svn_ra_serf__session_t *session)
 {
   if (session->using_compression == svn_tristate_false)
-    {
-      /* Don't advertise support for compressed svndiff formats if
-         compression is disabled. */
-      serf_bucket_headers_setn(
-        headers, "Accept-Encoding", "svndiff");
-    }
+    return &uncompressed_prefs;
   else if (session->using_compression == svn_tristate_unknown &&
            svn_ra_serf__is_low_latency_connection(session))
-    {
-      /* With http-compression=auto, advertise that we prefer svndiff2
-         to svndiff1 with a low latency connection (assuming the underlying
-         network has high bandwidth), as it is faster and in this case, we
-         don't care about worse compression ratio. */
-      serf_bucket_headers_setn(
-        headers, "Accept-Encoding",
-        "gzip,svndiff2;q=0.9,svndiff1;q=0.8,svndiff;q=0.7");
-    }
+    return svn__zstd_available() ? &fast_prefs : &fast_prefs_no_zstd;
   else
-    {
-      /* Otherwise, advertise that we prefer svndiff1 over svndiff2.
-         svndiff2 is not a reasonable substitute for svndiff1 with default
-         compression level, because, while it is faster, it also gives worse
-         compression ratio.  While we can use svndiff2 in some cases (see
-         above), we can't do this generally. */
-      serf_bucket_headers_setn(
-        headers, "Accept-Encoding",
-        "gzip,svndiff1;q=0.9,svndiff2;q=0.8,svndiff;q=0.7");
-    }
+    return svn__zstd_available() ? &small_prefs : &small_prefs_no_zstd;
+}
+
+void
+svn_ra_serf__setup_svndiff_accept_encoding(serf_bucket_t *headers,
+                                           svn_ra_serf__session_t *session)
+{
+  serf_bucket_headers_setn(headers, "Accept-Encoding",
+                           get_svndiff_prefs(session)->accept_encoding);
+}
+
+const int *
+svn_ra_serf__get_svndiff_preferences(svn_ra_serf__session_t *session)
+{
+  return get_svndiff_prefs(session)->versions;
 }
 
 svn_boolean_t
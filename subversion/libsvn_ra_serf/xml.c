@@ -59,6 +59,11 @@ struct svn_ra_serf__xml_context_t {
   /* The transition table.  */
   const svn_ra_serf__xml_transition_t *ttable;
 
+  /* TTABLE indexed by FROM_STATE: for each state up to MAX_STATE, a NULL
+     terminated array of the transitions leaving it, in table order.  */
+  const svn_ra_serf__xml_transition_t ***transitions;
+  int max_state;
+
   /* The callback information.  */
   svn_ra_serf__xml_opened_t opened_cb;
   svn_ra_serf__xml_closed_t closed_cb;
@@ -122,7 +127,10 @@ struct svn_ra_serf__xml_estate_t {
      if no attributes have been collected.  */
   apr_hash_t *attrs;
 
-  /* Any collected cdata. May be NULL if no cdata is being collected.  */
+  /* Should the cdata of this element be collected?  */
+  svn_boolean_t collect_cdata;
+
+  /* Any collected cdata. NULL until the first piece of cdata arrives.  */
   svn_stringbuf_t *cdata;
 
   /* Previous/outer state.  */
@@ -473,6 +481,52 @@ lazy_create_pool(void *baton)
   return xes->state_pool;
 }
 
+/* Build the TRANSITIONS index of XMLCTX from its TTABLE, allocated in
+   RESULT_POOL.  */
+static void
+index_transitions(svn_ra_serf__xml_context_t *xmlctx,
+                  apr_pool_t *result_pool)
+{
+  const svn_ra_serf__xml_transition_t *scan;
+  const svn_ra_serf__xml_transition_t **slots;
+  int *counts;
+  int count = 0;
+  int state;
+
+  xmlctx->max_state = XML_STATE_INITIAL;
+  for (scan = xmlctx->ttable; scan->ns != NULL; ++scan)
+    {
+      if (scan->from_state > xmlctx->max_state)
+        xmlctx->max_state = scan->from_state;
+      if (scan->to_state > xmlctx->max_state)
+        xmlctx->max_state = scan->to_state;
+      count++;
+    }
+
+  counts = apr_pcalloc(result_pool,
+                       (xmlctx->max_state + 1) * sizeof(*counts));
+  for (scan = xmlctx->ttable; scan->ns != NULL; ++scan)
+    if (scan->from_state >= 0)
+      counts[scan->from_state]++;
+
+  /* One array of pointers holds all lists, each with its terminator.  */
+  slots = apr_pcalloc(result_pool,
+                      (count + xmlctx->max_state + 1) * sizeof(*slots));
+  xmlctx->transitions = apr_palloc(result_pool,
+                                   (xmlctx->max_state + 1)
+                                     * sizeof(*xmlctx->transitions));
+  for (state = 0; state <= xmlctx->max_state; state++)
+    {
+      xmlctx->transitions[state] = slots;
+      slots += counts[state] + 1;
+      counts[state] = 0;
+    }
+
+  for (scan = xmlctx->ttable; scan->ns != NULL; ++scan)
+    if (scan->from_state >= 0)
+      xmlctx->transitions[scan->from_state][counts[scan->from_state]++] = scan;
+}
+
 svn_error_t *
 svn_ra_serf__xml_context_done(svn_ra_serf__xml_context_t *xmlctx)
 {
@@ -539,6 +593,8 @@ svn_ra_serf__xml_context_create(
   xmlctx->baton = baton;
   xmlctx->scratch_pool = svn_pool_create(result_pool);
 
+  index_transitions(xmlctx, result_pool);
+
   xes = apr_pcalloc(result_pool, sizeof(*xes));
   /* XES->STATE == 0  */
 
@@ -638,7 +694,8 @@ xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
 {
   svn_ra_serf__xml_estate_t *current = xmlctx->current;
   svn_ra_serf__dav_props_t elemname;
-  const svn_ra_serf__xml_transition_t *scan;
+  const svn_ra_serf__xml_transition_t *const *candidate;
+  const svn_ra_serf__xml_transition_t *scan = NULL;
   apr_pool_t *new_pool;
   svn_ra_serf__xml_estate_t *new_xes;
 
@@ -656,21 +713,29 @@ xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
 
   expand_ns(&elemname, current->ns_list, raw_name);
 
-  for (scan = xmlctx->ttable; scan->ns != NULL; ++scan)
+  if (current->state >= 0 && current->state <= xmlctx->max_state)
     {
-      if (scan->from_state != current->state)
-        continue;
-
-      /* Wildcard tag match.  */
-      if (*scan->name == '*')
-        break;
+      for (candidate = xmlctx->transitions[current->state];
+           *candidate != NULL;
+           ++candidate)
+        {
+          /* Wildcard tag match.  */
+          if (*(*candidate)->name == '*')
+            {
+              scan = *candidate;
+              break;
+            }
 
-      /* Found a specific transition.  */
-      if (strcmp(elemname.name, scan->name) == 0
-          && strcmp(elemname.xmlns, scan->ns) == 0)
-        break;
+          /* Found a specific transition.  */
+          if (strcmp(elemname.name, (*candidate)->name) == 0
+              && strcmp(elemname.xmlns, (*candidate)->ns) == 0)
+            {
+              scan = *candidate;
+              break;
+            }
+        }
     }
-  if (scan->ns == NULL)
+  if (scan == NULL)
     {
       if (current->state == XML_STATE_INITIAL)
         {
@@ -707,11 +772,9 @@ xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
       new_xes = apr_pcalloc(new_pool, sizeof(*new_xes));
       new_xes->state_pool = new_pool;
 
-      /* If we're supposed to collect cdata, then set up a buffer for
-         this. The existence of this buffer will instruct our cdata
-         callback to collect the cdata.  */
-      if (scan->collect_cdata)
-        new_xes->cdata = svn_stringbuf_create_empty(new_pool);
+      /* If we're supposed to collect cdata, our cdata callback will
+         create the buffer, sized to the first piece of cdata.  */
+      new_xes->collect_cdata = scan->collect_cdata;
 
       if (scan->collect_attrs[0] != NULL)
         {
@@ -755,8 +818,17 @@ xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
 
   /* Some basic copies to set up the new estate.  */
   new_xes->state = scan->to_state;
-  new_xes->tag.name = apr_pstrdup(new_pool, elemname.name);
-  new_xes->tag.xmlns = apr_pstrdup(new_pool, elemname.xmlns);
+  if (*scan->name == '*')
+    {
+      new_xes->tag.name = apr_pstrdup(new_pool, elemname.name);
+      new_xes->tag.xmlns = apr_pstrdup(new_pool, elemname.xmlns);
+    }
+  else
+    {
+      /* The table holds the same strings with a longer lifetime.  */
+      new_xes->tag.name = scan->name;
+      new_xes->tag.xmlns = scan->ns;
+    }
   new_xes->custom_close = scan->custom_close;
 
   /* Start with the parent's namespace set.  */
@@ -806,6 +878,8 @@ xml_cb_end(svn_ra_serf__xml_context_t *xmlctx,
           xes->cdata->pool = NULL;
 #endif
         }
+      else if (xes->collect_cdata)
+        cdata = svn_string_create_empty(xmlctx->scratch_pool);
       else
         cdata = NULL;
 
@@ -845,10 +919,19 @@ xml_cb_cdata(svn_ra_serf__xml_context_t *xmlctx,
   if (xmlctx->waiting > 0)
     return SVN_NO_ERROR;
 
-  /* If the current state is collecting cdata, then copy the cdata.  */
-  if (xmlctx->current->cdata != NULL)
+  /* If the current state is collecting cdata, then copy the cdata.
+     Expat usually delivers the cdata of an element in one piece, so
+     size the buffer to that piece rather than growing it from empty.
+     The data can't be kept without copying: expat passes some of it
+     from its own stack.  */
+  if (xmlctx->current->collect_cdata)
     {
-      svn_stringbuf_appendbytes(xmlctx->current->cdata, data, len);
+      svn_ra_serf__xml_estate_t *xes = xmlctx->current;
+
+      if (xes->cdata == NULL)
+        xes->cdata = svn_stringbuf_ncreate(data, len, xes->state_pool);
+      else
+        svn_stringbuf_appendbytes(xes->cdata, data, len);
     }
   /* ... else if a CDATA_CB has been supplied, then invoke it for
      all states.  */
@@ -50,7 +50,9 @@
 
 #include "svn_private_config.h"
 
+#include "private/svn_atomic.h"
 #include "private/svn_fspath.h"
+#include "private/svn_mutex.h"
 #include "private/svn_string_private.h"
 #include "private/svn_subr_private.h"
 
@@ -249,6 +251,17 @@ static svn_error_t *handle_auth_request(svn_ra_svn__session_baton_t *sess,
   SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "lc", &mechlist, &realm));
   if (mechlist->nelts == 0)
     return SVN_NO_ERROR;
+
+  /* An auth ticket from an earlier session saves the full exchange. */
+  if (svn_ra_svn__find_mech(mechlist, "SVN-TICKET"))
+    {
+      svn_boolean_t success;
+
+      SVN_ERR(svn_ra_svn__do_ticket_auth(&success, sess, realm, pool));
+      if (success)
+        return SVN_NO_ERROR;
+    }
+
   return DO_AUTH(sess, mechlist, realm, pool);
 }
 
@@ -604,12 +617,286 @@ static apr_status_t close_tunnel_cleanup(void *baton)
   return APR_SUCCESS; /* ignored */
 }
 
+/* A connection that outlived its session and may be picked up by the
+ * next session to the same repository, see
+ * SVN_CONFIG_OPTION_SVN_IDLE_CONNECTIONS. */
+typedef struct idle_conn_t
+{
+  /* The connection.  It lives in POOL, together with its socket or tunnel
+     agent process and this structure. */
+  svn_ra_svn_conn_t *conn;
+  apr_pool_t *pool;
+
+  /* The server and credentials CONN belongs to, see conn_key(). */
+  const char *key;
+
+  /* The URL that the server side is parented to. */
+  const char *server_url;
+
+  struct idle_conn_t *next;
+} idle_conn_t;
+
+/* The idle connections, most recently released first, and their number.
+ * Access is serialized by IDLE_CONNS_MUTEX. */
+static idle_conn_t *idle_conns = NULL;
+static int idle_conns_count = 0;
+static svn_mutex__t *idle_conns_mutex = NULL;
+static volatile svn_atomic_t idle_conns_init_state = 0;
+
+/* Pool cleanup called when the pool for IDLE_CONNS_MUTEX is destroyed,
+ * i.e. in apr_terminate(). */
+static apr_status_t idle_conns_done(void *data)
+{
+  idle_conns = NULL;
+  idle_conns_count = 0;
+  idle_conns_mutex = NULL;
+  idle_conns_init_state = 0;
+
+  return APR_SUCCESS;
+}
+
+/* Implements svn_atomic__err_init_func_t. */
+static svn_error_t *
+init_idle_conns(void *baton, apr_pool_t *pool)
+{
+  apr_pool_t *global_pool = svn_pool_create(NULL);
+
+  apr_pool_cleanup_register(global_pool, NULL, idle_conns_done,
+                            apr_pool_cleanup_null);
+  return svn_error_trace(svn_mutex__init(&idle_conns_mutex, TRUE,
+                                         global_pool));
+}
+
+/* Return the key that identifies connections for URI made with the
+ * caller's AUTH_BATON, tunneling through TUNNEL_NAME and TUNNEL_ARGV.
+ * Connections with the same key are authenticated as the same user.
+ * Allocate the result in RESULT_POOL. */
+static const char *
+conn_key(const apr_uri_t *uri,
+         const char *tunnel_name,
+         const char **tunnel_argv,
+         svn_auth_baton_t *auth_baton,
+         apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *key
+    = svn_stringbuf_createf(result_pool, "%p %s %s %s %u",
+                            (void *)auth_baton,
+                            tunnel_name ? tunnel_name : "",
+                            uri->user ? uri->user : "",
+                            uri->hostname, (unsigned)uri->port);
+
+  for (; tunnel_argv && *tunnel_argv; tunnel_argv++)
+    {
+      svn_stringbuf_appendbyte(key, ' ');
+      svn_stringbuf_appendcstr(key, *tunnel_argv);
+    }
+
+  return key->data;
+}
+
+/* Remove the most recently released connection for KEY whose repository
+ * contains URL from the list of idle connections and return it in
+ * *IDLE.  Set *IDLE to NULL if there is none.  Call with IDLE_CONNS_MUTEX
+ * locked. */
+static svn_error_t *
+take_idle_conn(idle_conn_t **idle,
+               const char *key,
+               const char *url)
+{
+  idle_conn_t **p;
+
+  for (p = &idle_conns; *p; p = &(*p)->next)
+    if (strcmp((*p)->key, key) == 0
+        && (*p)->conn->repos_root
+        && svn_uri__is_ancestor((*p)->conn->repos_root, url))
+      {
+        *idle = *p;
+        *p = (*p)->next;
+        idle_conns_count--;
+
+        return SVN_NO_ERROR;
+      }
+
+  *idle = NULL;
+  return SVN_NO_ERROR;
+}
+
+/* Add IDLE to the list of idle connections.  If that makes more than
+ * MAX_IDLE connections, remove the one released longest ago and return
+ * it in *EVICTED.  Otherwise, set *EVICTED to NULL.  Call with
+ * IDLE_CONNS_MUTEX locked. */
+static svn_error_t *
+put_idle_conn(idle_conn_t **evicted,
+              idle_conn_t *idle,
+              int max_idle)
+{
+  idle_conn_t **p;
+
+  idle->next = idle_conns;
+  idle_conns = idle;
+  idle_conns_count++;
+
+  *evicted = NULL;
+  if (idle_conns_count > max_idle)
+    {
+      for (p = &idle_conns; (*p)->next; p = &(*p)->next)
+        ;
+
+      *evicted = *p;
+      *p = NULL;
+      idle_conns_count--;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Ties a connection that may be reused to its session. */
+typedef struct conn_owner_t
+{
+  /* The session using the connection, see release_conn(). */
+  svn_ra_svn__session_baton_t *sess;
+
+  /* The pool that the connection lives in. */
+  apr_pool_t *conn_pool;
+
+  /* See conn_key(). */
+  const char *key;
+
+  /* The maximum number of idle connections to keep. */
+  int max_idle;
+
+  /* Set once the connection has been fully set up for SESS. */
+  svn_boolean_t reusable;
+} conn_owner_t;
+
+/* Pool cleanup for the session pool of a session whose connection may be
+ * reused.  BATON is the conn_owner_t.  Put the connection into the list
+ * of idle connections if it is between two commands; destroy it
+ * otherwise. */
+static apr_status_t
+release_conn(void *baton)
+{
+  conn_owner_t *owner = baton;
+  svn_ra_svn_conn_t *conn = owner->sess->conn;
+  svn_boolean_t data_available = TRUE;
+  idle_conn_t *idle, *evicted;
+  svn_error_t *err;
+
+  if (!owner->conn_pool)
+    return APR_SUCCESS;
+
+  /* Anything left in the buffers or on the wire, including the server
+     having closed the connection, means we can't tell where we are in
+     the protocol. */
+  if (owner->reusable
+      && conn->read_ptr == conn->read_end
+      && conn->write_pos == 0)
+    {
+      err = svn_ra_svn__data_available(conn, &data_available);
+      if (err)
+        {
+          svn_error_clear(err);
+          data_available = TRUE;
+        }
+    }
+
+  if (data_available)
+    {
+      svn_pool_destroy(owner->conn_pool);
+      return APR_SUCCESS;
+    }
+
+  /* Drop all references to the session. */
+  conn->session = NULL;
+  conn->shim_callbacks = NULL;
+  svn_ra_svn__set_block_handler(conn, NULL, NULL);
+
+  idle = apr_palloc(owner->conn_pool, sizeof(*idle));
+  idle->conn = conn;
+  idle->pool = owner->conn_pool;
+  idle->key = apr_pstrdup(owner->conn_pool, owner->key);
+  idle->server_url = apr_pstrdup(owner->conn_pool,
+                                 owner->sess->parent->server_url->data);
+
+  err = svn_mutex__lock(idle_conns_mutex);
+  if (err)
+    {
+      svn_error_clear(err);
+      svn_pool_destroy(owner->conn_pool);
+      return APR_SUCCESS;
+    }
+
+  svn_error_clear(svn_mutex__unlock(idle_conns_mutex,
+                                    put_idle_conn(&evicted, idle,
+                                                  owner->max_idle)));
+  if (evicted)
+    svn_pool_destroy(evicted->pool);
+
+  return APR_SUCCESS;
+}
+
+/* Try to find an idle connection for OWNER->KEY that can be reparented
+ * to URL and hand it over to OWNER->SESS.  Set *REUSED to whether there
+ * was such a connection.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+reuse_idle_conn(svn_boolean_t *reused,
+                conn_owner_t *owner,
+                const char *url,
+                apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess = owner->sess;
+  idle_conn_t *idle;
+  svn_error_t *err;
+
+  SVN_ERR(svn_atomic__init_once(&idle_conns_init_state, init_idle_conns,
+                                NULL, scratch_pool));
+
+  while (TRUE)
+    {
+      SVN_MUTEX__WITH_LOCK(idle_conns_mutex,
+                           take_idle_conn(&idle, owner->key, url));
+      if (!idle)
+        {
+          *reused = FALSE;
+          return SVN_NO_ERROR;
+        }
+
+      sess->conn = idle->conn;
+      idle->conn->session = sess;
+      svn_stringbuf_set(sess->parent->server_url, idle->server_url);
+
+      /* The server side still points to where the previous session left
+         it.  This also makes sure that the connection still works. */
+      err = svn_ra_svn__write_cmd_reparent(idle->conn, scratch_pool, url);
+      if (!err)
+        err = handle_auth_request(sess, scratch_pool);
+      if (!err)
+        err = svn_ra_svn__read_cmd_response(idle->conn, scratch_pool, "");
+      if (!err)
+        break;
+
+      /* Try the next one. */
+      svn_error_clear(err);
+      sess->conn = NULL;
+      svn_pool_destroy(idle->pool);
+    }
+
+  svn_stringbuf_set(sess->parent->server_url, url);
+  owner->conn_pool = idle->pool;
+  owner->reusable = TRUE;
+
+  *reused = TRUE;
+  return SVN_NO_ERROR;
+}
+
 /* Open a session to URL, returning it in *SESS_P, allocating it in POOL.
    URI is a parsed version of URL.  CALLBACKS and CALLBACKS_BATON
    are provided by the caller of ra_svn_open. If TUNNEL_NAME is not NULL,
    it is the name of the tunnel type parsed from the URL scheme.
    If TUNNEL_ARGV is not NULL, it points to a program argument list to use
-   when invoking the tunnel agent.
+   when invoking the tunnel agent.  If MAX_IDLE is positive, take the
+   connection from the idle connections if possible and keep up to
+   MAX_IDLE connections open for later sessions after closing this one.
 */
 static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
                                  const char *url,
@@ -620,6 +907,7 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
                                  const svn_ra_callbacks2_t *callbacks,
                                  void *callbacks_baton,
                                  svn_auth_baton_t *auth_baton,
+                                 int max_idle,
                                  apr_pool_t *result_pool,
                                  apr_pool_t *scratch_pool)
 {
@@ -629,7 +917,10 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
   apr_uint64_t minver, maxver;
   svn_ra_svn__list_t *mechlist, *server_caplist, *repos_caplist;
   const char *client_string = NULL;
+  const char *ticket;
   apr_pool_t *pool = result_pool;
+  apr_pool_t *conn_pool = result_pool;
+  conn_owner_t *owner = NULL;
   svn_ra_svn__parent_t *parent;
 
   parent = apr_pcalloc(pool, sizeof(*parent));
@@ -639,6 +930,7 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
 
   sess = apr_palloc(pool, sizeof(*sess));
   sess->pool = pool;
+  sess->conn = NULL;
   sess->is_tunneled = (tunnel_name != NULL);
   sess->parent = parent;
   sess->user = uri->user;
@@ -649,6 +941,7 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
   sess->callbacks_baton = callbacks_baton;
   sess->bytes_read = sess->bytes_written = 0;
   sess->auth_baton = auth_baton;
+  sess->ticket_realmstring = NULL;
 
   if (config)
     SVN_ERR(svn_config_copy_config(&sess->config, config, pool));
@@ -656,13 +949,60 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
     sess->config = NULL;
 
   if (tunnel_name)
+    sess->realm_prefix = apr_psprintf(pool, "<svn+%s://%s:%d>",
+                                      tunnel_name,
+                                      uri->hostname, uri->port);
+  else
+    sess->realm_prefix = apr_psprintf(pool, "<svn://%s:%d>", uri->hostname,
+                                      uri->port ? uri->port : SVN_RA_SVN_PORT);
+
+  /* Build the useragent string, querying the client for any
+     customizations it wishes to note.  For historical reasons, we
+     still deliver the hard-coded client version info
+     (SVN_RA_SVN__DEFAULT_USERAGENT) and the customized client string
+     separately in the protocol/capabilities handshake below.  But the
+     commit logic wants the combined form for use with the
+     SVN_PROP_TXN_USER_AGENT ephemeral property because that's
+     consistent with our DAV approach.  */
+  if (sess->callbacks->get_client_string != NULL)
+    SVN_ERR(sess->callbacks->get_client_string(sess->callbacks_baton,
+                                               &client_string, pool));
+  if (client_string)
+    sess->useragent = apr_pstrcat(pool, SVN_RA_SVN__DEFAULT_USERAGENT " ",
+                                  client_string, SVN_VA_NULL);
+  else
+    sess->useragent = SVN_RA_SVN__DEFAULT_USERAGENT;
+
+  /* Tunnels opened through the callbacks belong to the caller and can't
+     outlive the session. */
+  if (max_idle > 0 && (!tunnel_name || tunnel_argv))
     {
-      sess->realm_prefix = apr_psprintf(pool, "<svn+%s://%s:%d>",
-                                        tunnel_name,
-                                        uri->hostname, uri->port);
+      svn_boolean_t reused;
+
+      owner = apr_pcalloc(pool, sizeof(*owner));
+      owner->sess = sess;
+      owner->key = conn_key(uri, tunnel_name, tunnel_argv,
+                            callbacks->auth_baton, pool);
+      owner->max_idle = max_idle;
+      apr_pool_cleanup_register(pool, owner, release_conn,
+                                apr_pool_cleanup_null);
+
+      SVN_ERR(reuse_idle_conn(&reused, owner, url, scratch_pool));
+      if (reused)
+        {
+          *sess_p = sess;
+          return SVN_NO_ERROR;
+        }
+
+      /* The connection must survive the session pool. */
+      conn_pool = svn_pool_create(NULL);
+      owner->conn_pool = conn_pool;
+    }
 
+  if (tunnel_name)
+    {
       if (tunnel_argv)
-        SVN_ERR(make_tunnel(tunnel_argv, &conn, pool));
+        SVN_ERR(make_tunnel(tunnel_argv, &conn, conn_pool));
       else
         {
           struct tunnel_data_t *const td = apr_palloc(pool, sizeof(*td));
@@ -689,34 +1029,14 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
     }
   else
     {
-      sess->realm_prefix = apr_psprintf(pool, "<svn://%s:%d>", uri->hostname,
-                                        uri->port ? uri->port : SVN_RA_SVN_PORT);
-
       SVN_ERR(make_connection(uri->hostname,
                               uri->port ? uri->port : SVN_RA_SVN_PORT,
-                              &sock, pool));
+                              &sock, conn_pool));
       conn = svn_ra_svn_create_conn5(sock, NULL, NULL,
                                      SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
-                                     0, 0, 0, 0, pool);
+                                     0, 0, 0, 0, conn_pool);
     }
 
-  /* Build the useragent string, querying the client for any
-     customizations it wishes to note.  For historical reasons, we
-     still deliver the hard-coded client version info
-     (SVN_RA_SVN__DEFAULT_USERAGENT) and the customized client string
-     separately in the protocol/capabilities handshake below.  But the
-     commit logic wants the combined form for use with the
-     SVN_PROP_TXN_USER_AGENT ephemeral property because that's
-     consistent with our DAV approach.  */
-  if (sess->callbacks->get_client_string != NULL)
-    SVN_ERR(sess->callbacks->get_client_string(sess->callbacks_baton,
-                                               &client_string, pool));
-  if (client_string)
-    sess->useragent = apr_pstrcat(pool, SVN_RA_SVN__DEFAULT_USERAGENT " ",
-                                  client_string, SVN_VA_NULL);
-  else
-    sess->useragent = SVN_RA_SVN__DEFAULT_USERAGENT;
-
   /* Make sure we set conn->session before reading from it,
    * because the reader and writer functions expect a non-NULL value. */
   sess->conn = conn;
@@ -747,7 +1067,7 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
    * capability list, and the URL, and subsequently there is an auth
    * request. */
   /* Client-side capabilities list: */
-  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "n(wwwwwww)cc(?c)",
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "n(wwwwwwwww?w)cc(?c)",
                                   (apr_uint64_t) 2,
                                   SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                   SVN_RA_SVN_CAP_SVNDIFF1,
@@ -756,6 +1076,11 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
                                   SVN_RA_SVN_CAP_DEPTH,
                                   SVN_RA_SVN_CAP_MERGEINFO,
                                   SVN_RA_SVN_CAP_LOG_REVPROPS,
+                                  SVN_RA_SVN_CAP_AUTH_TICKET,
+                                  SVN_RA_SVN_CAP_COMPRESS_STREAM,
+                                  svn__zstd_available()
+                                    ? SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED
+                                    : NULL,
                                   url,
                                   SVN_RA_SVN__DEFAULT_USERAGENT,
                                   client_string));
@@ -765,15 +1090,24 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
    * supported security layers, which is a ways off. */
 
   /* Read the repository's uuid and root URL, and perhaps learn more
-     capabilities that weren't available before now. */
-  SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "c?c?l", &conn->uuid,
-                                        &conn->repos_root, &repos_caplist));
+     capabilities that weren't available before now.  If we just had
+     to authenticate in full, there may be an auth ticket, too. */
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, conn_pool, "c?c?l?c",
+                                        &conn->uuid, &conn->repos_root,
+                                        &repos_caplist, &ticket));
   if (repos_caplist)
     SVN_ERR(svn_ra_svn__set_capabilities(conn, repos_caplist));
+  if (ticket)
+    SVN_ERR(svn_ra_svn__save_auth_ticket(sess, ticket, pool));
+  sess->ticket_realmstring = NULL;
+
+  /* The server switched to compression right after repos-info. */
+  if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_COMPRESS_STREAM))
+    SVN_ERR(svn_ra_svn__enable_stream_compression(conn, pool));
 
   if (conn->repos_root)
     {
-      conn->repos_root = svn_uri_canonicalize(conn->repos_root, pool);
+      conn->repos_root = svn_uri_canonicalize(conn->repos_root, conn_pool);
       /* We should check that the returned string is a prefix of url, since
          that's the API guarantee, but this isn't true for 1.0 servers.
          Checking the length prevents client crashes. */
@@ -783,6 +1117,9 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
                                   "server"));
     }
 
+  if (owner)
+    owner->reusable = TRUE;
+
   *sess_p = sess;
 
   return SVN_NO_ERROR;
@@ -855,6 +1192,7 @@ static svn_error_t *ra_svn_open(svn_ra_session_t *session,
   const char *tunnel, **tunnel_argv;
   apr_uri_t uri;
   svn_config_t *cfg, *cfg_client;
+  apr_int64_t max_idle = 0;
 
   /* We don't support server-prescribed redirections in ra-svn. */
   if (corrected_url)
@@ -898,11 +1236,28 @@ static svn_error_t *ra_svn_open(svn_ra_session_t *session,
   svn_auth_set_parameter(auth_baton,
                          SVN_AUTH_PARAM_CONFIG_CATEGORY_SERVERS, cfg);
 
+  if (cfg)
+    {
+      const char *server_group = svn_auth_get_parameter(
+                                   auth_baton, SVN_AUTH_PARAM_SERVER_GROUP);
+
+      SVN_ERR(svn_config_get_int64(cfg, &max_idle,
+                                   SVN_CONFIG_SECTION_GLOBAL,
+                                   SVN_CONFIG_OPTION_SVN_IDLE_CONNECTIONS,
+                                   0));
+      if (server_group)
+        SVN_ERR(svn_config_get_int64(cfg, &max_idle, server_group,
+                                     SVN_CONFIG_OPTION_SVN_IDLE_CONNECTIONS,
+                                     max_idle));
+      if (max_idle > APR_INT32_MAX)
+        max_idle = APR_INT32_MAX;
+    }
+
   /* We open the session in a subpool so we can get rid of it if we
      reparent with a server that doesn't support reparenting. */
   SVN_ERR(open_session(&sess, url, &uri, tunnel, tunnel_argv, config,
                        callbacks, callback_baton,
-                       auth_baton, sess_pool, scratch_pool));
+                       auth_baton, (int)max_idle, sess_pool, scratch_pool));
   session->priv = sess;
 
   return SVN_NO_ERROR;
@@ -961,7 +1316,7 @@ reparent_server(svn_ra_session_t *ra_session,
   if (! err)
     err = open_session(&new_sess, url, &uri, sess->tunnel_name, sess->tunnel_argv,
                        sess->config, sess->callbacks, sess->callbacks_baton,
-                       sess->auth_baton, sess_pool, sess_pool);
+                       sess->auth_baton, 0, sess_pool, sess_pool);
   /* We destroy the new session pool on error, since it is allocated in
      the main session pool. */
   if (err)
@@ -1436,24 +1791,30 @@ parse_iproplist(apr_array_header_t **inherited_props,
   return SVN_NO_ERROR;
 }
 
-static svn_error_t *ra_svn_get_file(svn_ra_session_t *session, const char *path,
-                                    svn_revnum_t rev, svn_stream_t *stream,
-                                    svn_revnum_t *fetched_rev,
-                                    apr_hash_t **props,
-                                    apr_pool_t *pool)
+/* Read the response to a get-file request for PATH from CONN, including
+ * the file contents if WANT_CONTENTS is set, and push the contents to
+ * STREAM unless that is NULL.  Set *FETCHED_REV and *PROPS like
+ * svn_ra_get_file() does.
+ *
+ * If writing to STREAM fails, read the rest of the response anyway so
+ * that the connection remains usable.  Use POOL for all allocations. */
+static svn_error_t *
+read_file_response(svn_ra_svn_conn_t *conn,
+                   const char *path,
+                   svn_boolean_t want_contents,
+                   svn_stream_t *stream,
+                   svn_revnum_t *fetched_rev,
+                   apr_hash_t **props,
+                   apr_pool_t *pool)
 {
-  svn_ra_svn__session_baton_t *sess_baton = session->priv;
-  svn_ra_svn_conn_t *conn = sess_baton->conn;
   svn_ra_svn__list_t *proplist;
   const char *expected_digest;
+  svn_revnum_t rev;
   svn_checksum_t *expected_checksum = NULL;
   svn_checksum_ctx_t *checksum_ctx;
+  svn_error_t *err = SVN_NO_ERROR;
   apr_pool_t *iterpool;
 
-  path = reparent_path(session, path, pool);
-  SVN_ERR(svn_ra_svn__write_cmd_get_file(conn, pool, path, rev,
-                                         (props != NULL), (stream != NULL)));
-  SVN_ERR(handle_auth_request(sess_baton, pool));
   SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "(?c)rl",
                                         &expected_digest,
                                         &rev, &proplist));
@@ -1464,7 +1825,7 @@ static svn_error_t *ra_svn_get_file(svn_ra_session_t *session, const char *path,
     SVN_ERR(svn_ra_svn__parse_proplist(proplist, pool, props));
 
   /* We're done if the contents weren't wanted. */
-  if (!stream)
+  if (!want_contents)
     return SVN_NO_ERROR;
 
   if (expected_digest)
@@ -1492,12 +1853,14 @@ static svn_error_t *ra_svn_get_file(svn_ra_session_t *session, const char *path,
         SVN_ERR(svn_checksum_update(checksum_ctx, item->u.string.data,
                                     item->u.string.len));
 
-      SVN_ERR(svn_stream_write(stream, item->u.string.data,
-                               &item->u.string.len));
+      if (stream && !err)
+        err = svn_stream_write(stream, item->u.string.data,
+                               &item->u.string.len);
     }
   svn_pool_destroy(iterpool);
 
-  SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, ""));
+  SVN_ERR(svn_error_compose_create(
+            svn_ra_svn__read_cmd_response(conn, pool, ""), err));
 
   if (expected_checksum)
     {
@@ -1513,6 +1876,231 @@ static svn_error_t *ra_svn_get_file(svn_ra_session_t *session, const char *path,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *ra_svn_get_file(svn_ra_session_t *session, const char *path,
+                                    svn_revnum_t rev, svn_stream_t *stream,
+                                    svn_revnum_t *fetched_rev,
+                                    apr_hash_t **props,
+                                    apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+
+  path = reparent_path(session, path, pool);
+  SVN_ERR(svn_ra_svn__write_cmd_get_file(conn, pool, path, rev,
+                                         (props != NULL), (stream != NULL)));
+  SVN_ERR(handle_auth_request(sess_baton, pool));
+
+  return svn_error_trace(read_file_response(conn, path, stream != NULL,
+                                            stream, fetched_rev, props,
+                                            pool));
+}
+
+static svn_error_t *ra_svn_get_file_range(svn_ra_session_t *session,
+                                          const char *path,
+                                          svn_revnum_t rev,
+                                          svn_filesize_t offset,
+                                          svn_filesize_t length,
+                                          svn_stream_t *stream,
+                                          svn_revnum_t *fetched_rev,
+                                          apr_hash_t **props,
+                                          apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+
+  path = reparent_path(session, path, pool);
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w(c(?r)bnn)",
+                                  "get-file-range", path, rev,
+                                  (props != NULL), (apr_uint64_t)offset,
+                                  (apr_uint64_t)length));
+  SVN_ERR(handle_auth_request(sess_baton, pool));
+
+  /* The server sends no checksum for a range. */
+  return svn_error_trace(read_file_response(conn, path, TRUE, stream,
+                                            fetched_rev, props, pool));
+}
+
+/* The maximum number of files and, roughly, the maximum number of bytes
+ * that ra_svn_get_files() puts into a single get-files request.  While
+ * the server answers one request, the next one is already on its way.
+ * Keeping the requests small guarantees that this one request fits into
+ * the socket buffers, so neither side blocks on the other while writing. */
+#define GET_FILES_BATCH_FILES 256
+#define GET_FILES_BATCH_SIZE 0x4000
+
+/* Send a get-files request to CONN for the files in FILES, starting at
+ * index *NEXT, and advance *NEXT past the last file sent.  Request the
+ * properties if WANT_PROPS is set and the contents if WANT_CONTENTS is
+ * set.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+write_get_files_batch(svn_ra_session_t *session,
+                      svn_ra_svn_conn_t *conn,
+                      const apr_array_header_t *files,
+                      int *next,
+                      svn_boolean_t want_props,
+                      svn_boolean_t want_contents,
+                      apr_pool_t *scratch_pool)
+{
+  apr_size_t size = 0;
+  int i;
+
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "w((!", "get-files"));
+  for (i = *next;
+       i < files->nelts
+         && i - *next < GET_FILES_BATCH_FILES
+         && size < GET_FILES_BATCH_SIZE;
+       i++)
+    {
+      const svn_ra_file_request_t *file
+        = APR_ARRAY_IDX(files, i, const svn_ra_file_request_t *);
+      const char *path = reparent_path(session, file->path, scratch_pool);
+
+      SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "!(c(?r))!",
+                                      path, file->revision));
+      size += strlen(path) + 32;
+    }
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "!)bb)",
+                                  want_props, want_contents));
+
+  *next = i;
+  return SVN_NO_ERROR;
+}
+
+/* Read and discard the responses for the next COUNT files of a get-files
+ * request from CONN.  WANT_CONTENTS tells whether the request asked for
+ * the contents.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+skip_get_files_responses(svn_ra_svn_conn_t *conn,
+                         int count,
+                         svn_boolean_t want_contents,
+                         apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  const char *status;
+  svn_ra_svn__list_t *params;
+  svn_ra_svn__item_t *item;
+  int i;
+
+  for (i = 0; i < count; i++)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_svn__read_tuple(conn, iterpool, "wl", &status, &params));
+      if (!want_contents || strcmp(status, "success") != 0)
+        continue;
+
+      do
+        {
+          SVN_ERR(svn_ra_svn__read_item(conn, iterpool, &item));
+          if (item->kind != SVN_RA_SVN_STRING)
+            return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                    _("Non-string as part of file contents"));
+        }
+      while (item->u.string.len > 0);
+
+      SVN_ERR(svn_ra_svn__read_tuple(conn, iterpool, "wl", &status, &params));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Like skip_get_files_responses() but for a whole get-files request for
+ * COUNT files, including the auth request the response starts with. */
+static svn_error_t *
+skip_get_files_request(svn_ra_svn_conn_t *conn,
+                       int count,
+                       svn_boolean_t want_contents,
+                       apr_pool_t *scratch_pool)
+{
+  const char *status;
+  svn_ra_svn__list_t *params;
+
+  SVN_ERR(svn_ra_svn__read_tuple(conn, scratch_pool, "wl", &status, &params));
+  if (strcmp(status, "success") != 0)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(skip_get_files_responses(conn, count, want_contents,
+                                                  scratch_pool));
+}
+
+static svn_error_t *
+ra_svn_get_files(svn_ra_session_t *session,
+                 const apr_array_header_t *files,
+                 svn_boolean_t want_props,
+                 svn_ra_file_receiver_t receiver,
+                 void *receiver_baton,
+                 apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_boolean_t want_contents = FALSE;
+  int batch_end, next, i;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (files->nelts == 0)
+    return SVN_NO_ERROR;
+
+  for (i = 0; i < files->nelts; i++)
+    if (APR_ARRAY_IDX(files, i, const svn_ra_file_request_t *)->stream)
+      want_contents = TRUE;
+
+  /* Send the first request on its own, so that the server may ask us to
+     authenticate. */
+  next = 0;
+  SVN_ERR(write_get_files_batch(session, conn, files, &next,
+                                want_props, want_contents, iterpool));
+  SVN_ERR(handle_auth_request(sess_baton, iterpool));
+
+  i = 0;
+  while (i < files->nelts)
+    {
+      /* The files up to BATCH_END belong to the request we read the
+         response for.  Let the server work on the next request while we
+         do that. */
+      batch_end = next;
+      if (next < files->nelts)
+        SVN_ERR(write_get_files_batch(session, conn, files, &next,
+                                      want_props, want_contents, iterpool));
+
+      for (; !err && i < batch_end; i++)
+        {
+          const svn_ra_file_request_t *file
+            = APR_ARRAY_IDX(files, i, const svn_ra_file_request_t *);
+          svn_revnum_t fetched_rev;
+          apr_hash_t *props = NULL;
+
+          svn_pool_clear(iterpool);
+          err = read_file_response(conn, file->path, want_contents,
+                                   file->stream, &fetched_rev,
+                                   want_props ? &props : NULL, iterpool);
+          if (!err && receiver)
+            err = receiver(receiver_baton, file, fetched_rev, props,
+                           iterpool);
+        }
+
+      if (err)
+        {
+          /* Don't leave the rest of the responses in the pipe. */
+          svn_error_t *skip_err
+            = skip_get_files_responses(conn, batch_end - i, want_contents,
+                                       iterpool);
+          if (!skip_err && next > batch_end)
+            skip_err = skip_get_files_request(conn, next - batch_end,
+                                              want_contents, iterpool);
+
+          return svn_error_compose_create(err, skip_err);
+        }
+
+      /* Each response starts with an auth request, which is trivial now. */
+      if (i < files->nelts)
+        SVN_ERR(handle_auth_request(sess_baton, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Write the protocol words that correspond to DIRENT_FIELDS to CONN
  * and use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
@@ -3076,6 +3664,8 @@ ra_svn_has_capability(svn_ra_session_t *session,
       {SVN_RA_CAPABILITY_GET_FILE_REVS_REVERSE,
                                        SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE},
       {SVN_RA_CAPABILITY_LIST, SVN_RA_SVN_CAP_LIST},
+      {SVN_RA_CAPABILITY_GET_FILES, SVN_RA_SVN_CAP_GET_FILES},
+      {SVN_RA_CAPABILITY_GET_FILE_RANGE, SVN_RA_SVN_CAP_GET_FILE_RANGE},
 
       {NULL, NULL} /* End of list marker */
   };
@@ -3083,6 +3673,10 @@ ra_svn_has_capability(svn_ra_session_t *session,
 
   *has = FALSE;
 
+  /* The protocol has no command for these. */
+  if (strcmp(capability, SVN_RA_CAPABILITY_SERVER_BLAME) == 0)
+    return SVN_NO_ERROR;
+
   for (i = 0; capabilities[i][0]; i++)
     {
       if (strcmp(capability, capabilities[i][0]) == 0)
@@ -3298,6 +3892,9 @@ static const svn_ra__vtable_t ra_svn_vtable = {
   ra_svn_get_inherited_props,
   NULL /* ra_set_svn_ra_open */,
   ra_svn_list,
+  NULL /* get_blame */,
+  ra_svn_get_files,
+  ra_svn_get_file_range,
   ra_svn_register_editor_shim_callbacks,
   NULL /* commit_ev2 */,
   NULL /* replay_range_ev2 */
@@ -109,6 +109,21 @@ static void compute_digest(unsigned char *digest, const char *challenge,
   apr_md5_final(digest, &ctx);
 }
 
+const char *
+svn_ra_svn__hmac_md5_hex(const char *key,
+                         const char *data,
+                         apr_pool_t *result_pool)
+{
+  unsigned char digest[APR_MD5_DIGESTSIZE];
+  char *hex = apr_palloc(result_pool, 2 * APR_MD5_DIGESTSIZE + 1);
+
+  compute_digest(digest, data, key);
+  hex_encode(hex, digest);
+  hex[2 * APR_MD5_DIGESTSIZE] = '\0';
+
+  return hex;
+}
+
 /* Fail the authentication, from the server's perspective. */
 static svn_error_t *fail(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
                          const char *msg)
@@ -32,6 +32,8 @@
 #include "svn_types.h"
 #include "svn_string.h"
 #include "svn_error.h"
+#include "svn_hash.h"
+#include "svn_config.h"
 #include "svn_ra.h"
 #include "svn_ra_svn.h"
 
@@ -67,6 +69,104 @@ static svn_error_t *read_success(svn_ra_svn_conn_t *conn, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Auth tickets live in the auth area of the config dir, keyed by the
+   realm string just like passwords. */
+#define AUTH_TICKET_CRED_KIND "svn.ticket"
+#define AUTH_TICKET_KEY "ticket"
+
+/* Set *CONFIG_DIR to the config dir that auth tickets for SESS are
+   cached in and return TRUE, or return FALSE if they may not be cached. */
+static svn_boolean_t
+get_ticket_cache_dir(const char **config_dir,
+                     svn_ra_svn__session_baton_t *sess)
+{
+  if (!sess->auth_baton
+      || svn_auth_get_parameter(sess->auth_baton,
+                                SVN_AUTH_PARAM_NO_AUTH_CACHE))
+    return FALSE;
+
+  *config_dir = svn_auth_get_parameter(sess->auth_baton,
+                                       SVN_AUTH_PARAM_CONFIG_DIR);
+  return TRUE;
+}
+
+/* Replace the auth ticket cached for REALMSTRING in CONFIG_DIR with
+   TICKET, or remove it if TICKET is NULL. */
+static svn_error_t *
+write_ticket(const char *ticket,
+             const char *realmstring,
+             const char *config_dir,
+             apr_pool_t *pool)
+{
+  apr_hash_t *creds = apr_hash_make(pool);
+
+  if (ticket)
+    svn_hash_sets(creds, AUTH_TICKET_KEY, svn_string_create(ticket, pool));
+
+  return svn_error_trace(svn_config_write_auth_data(creds,
+                                                    AUTH_TICKET_CRED_KIND,
+                                                    realmstring, config_dir,
+                                                    pool));
+}
+
+svn_error_t *
+svn_ra_svn__do_ticket_auth(svn_boolean_t *success,
+                           svn_ra_svn__session_baton_t *sess,
+                           const char *realm,
+                           apr_pool_t *pool)
+{
+  const char *realmstring, *config_dir, *status, *arg;
+  apr_hash_t *creds;
+  svn_string_t *ticket = NULL;
+
+  *success = FALSE;
+  if (!get_ticket_cache_dir(&config_dir, sess))
+    return SVN_NO_ERROR;
+
+  realmstring = apr_psprintf(pool, "%s %s", sess->realm_prefix, realm);
+  sess->ticket_realmstring = apr_pstrdup(sess->pool, realmstring);
+
+  /* Nothing cached yet is the common case. */
+  SVN_ERR(svn_config_read_auth_data(&creds, AUTH_TICKET_CRED_KIND,
+                                    realmstring, config_dir, pool));
+  if (creds)
+    ticket = svn_hash_gets(creds, AUTH_TICKET_KEY);
+  if (!ticket)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_ra_svn__auth_response(sess->conn, pool, "SVN-TICKET",
+                                    ticket->data));
+  SVN_ERR(svn_ra_svn__read_tuple(sess->conn, pool, "w(?c)", &status, &arg));
+  if (strcmp(status, "success") == 0)
+    {
+      /* We keep using this ticket until it expires. */
+      sess->ticket_realmstring = NULL;
+      *success = TRUE;
+      return SVN_NO_ERROR;
+    }
+  else if (strcmp(status, "failure") != 0)
+    return svn_error_create(SVN_ERR_RA_NOT_AUTHORIZED, NULL,
+                            _("Unexpected server response to authentication"));
+
+  /* The ticket expired or the server forgot its key.  Drop it and let the
+     caller authenticate in full; that may earn us a new ticket. */
+  return svn_error_trace(write_ticket(NULL, realmstring, config_dir, pool));
+}
+
+svn_error_t *
+svn_ra_svn__save_auth_ticket(svn_ra_svn__session_baton_t *sess,
+                             const char *ticket,
+                             apr_pool_t *pool)
+{
+  const char *config_dir;
+
+  if (!sess->ticket_realmstring || !get_ticket_cache_dir(&config_dir, sess))
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(write_ticket(ticket, sess->ticket_realmstring,
+                                      config_dir, pool));
+}
+
 svn_error_t *
 svn_ra_svn__do_internal_auth(svn_ra_svn__session_baton_t *sess,
                              const svn_ra_svn__list_t *mechlist,
@@ -202,6 +202,8 @@ svn_ra_svn_conn_t *svn_ra_svn_create_conn5(apr_socket_t *sock,
   conn->session = NULL;
   conn->read_ptr = conn->read_buf;
   conn->read_end = conn->read_buf;
+  conn->write_buf_size = SVN_RA_SVN__WRITEBUF_SIZE;
+  conn->write_buf = apr_palloc(result_pool, conn->write_buf_size);
   conn->write_pos = 0;
   conn->written_since_error_check = 0;
   conn->error_check_interval = error_check_interval;
@@ -215,6 +217,7 @@ svn_ra_svn_conn_t *svn_ra_svn_create_conn5(apr_socket_t *sock,
   conn->capabilities = apr_hash_make(result_pool);
   conn->compression_level = compression_level;
   conn->zero_copy_limit = zero_copy_limit;
+  conn->compression_stats = NULL;
   conn->pool = result_pool;
 
   if (sock != NULL)
@@ -273,13 +276,17 @@ svn_ra_svn__svndiff_version(svn_ra_svn_conn_t *conn)
   if (svn_ra_svn_compression_level(conn) <= 0)
     return 0;
 
-  /* Prefer SVNDIFF2 over SVNDIFF1. */
+  /* Prefer SVNDIFF3 over SVNDIFF2 over SVNDIFF1.  SVNDIFF3 gives us
+   * a better compression ratio than SVNDIFF1 at LZ4-like decoding speed. */
+  if (svn__zstd_available()
+      && svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED))
+    return 3;
   if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED))
     return 2;
   if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF1))
     return 1;
 
-  /* The connection does not support SVNDIFF1/2; default to "version 0". */
+  /* The connection does not support SVNDIFF1/2/3; default to "version 0". */
   return 0;
 }
 
@@ -363,14 +370,21 @@ check_io_limits(svn_ra_svn_conn_t *conn)
   return SVN_NO_ERROR;
 }
 
-/* Write data to socket or output file as appropriate. */
-static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
-                                    const char *data, apr_size_t len)
+/* Write the NVEC data blocks in VEC to socket or output file as
+   appropriate.  VEC will be modified. */
+static svn_error_t *writebuf_outputv(svn_ra_svn_conn_t *conn,
+                                     apr_pool_t *pool,
+                                     struct iovec *vec,
+                                     int nvec)
 {
-  const char *end = data + len;
+  apr_size_t len = 0;
   apr_size_t count;
   apr_pool_t *subpool = NULL;
   svn_ra_svn__session_baton_t *session = conn->session;
+  int i;
+
+  for (i = 0; i < nvec; ++i)
+    len += vec[i].iov_len;
 
   /* Limit the size of the response, if a limit has been configured.
    * This is to limit the server load in case users e.g. accidentally ran
@@ -378,14 +392,22 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   conn->current_out += len;
   SVN_ERR(check_io_limits(conn));
 
-  while (data < end)
+  while (nvec > 0)
     {
-      count = end - data;
+      apr_size_t remaining;
+
+      /* Skip empty blocks, e.g. an empty write buffer. */
+      if (vec[0].iov_len == 0)
+        {
+          ++vec;
+          --nvec;
+          continue;
+        }
 
       if (session && session->callbacks && session->callbacks->cancel_func)
         SVN_ERR((session->callbacks->cancel_func)(session->callbacks_baton));
 
-      SVN_ERR(svn_ra_svn__stream_write(conn->stream, data, &count));
+      SVN_ERR(svn_ra_svn__stream_writev(conn->stream, vec, nvec, &count));
       if (count == 0)
         {
           if (!subpool)
@@ -394,7 +416,24 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
             svn_pool_clear(subpool);
           SVN_ERR(conn->block_handler(conn, subpool, conn->block_baton));
         }
-      data += count;
+
+      /* Skip the data that has been written. */
+      remaining = count;
+      while (remaining > 0)
+        {
+          if (remaining >= vec[0].iov_len)
+            {
+              remaining -= vec[0].iov_len;
+              ++vec;
+              --nvec;
+            }
+          else
+            {
+              vec[0].iov_base = (char *)vec[0].iov_base + remaining;
+              vec[0].iov_len -= remaining;
+              remaining = 0;
+            }
+        }
 
       if (session)
         {
@@ -416,33 +455,59 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   return SVN_NO_ERROR;
 }
 
-/* Write data from the write buffer out to the socket. */
-static svn_error_t *writebuf_flush(svn_ra_svn_conn_t *conn, apr_pool_t *pool)
+/* Write the write buffer contents, followed by the LEN bytes of DATA,
+   out to the socket.  DATA may be NULL if LEN is 0. */
+static svn_error_t *writebuf_flush_with(svn_ra_svn_conn_t *conn,
+                                        apr_pool_t *pool,
+                                        const char *data,
+                                        apr_size_t len)
 {
-  apr_size_t write_pos = conn->write_pos;
+  struct iovec vec[2];
+
+  vec[0].iov_base = conn->write_buf;
+  vec[0].iov_len = conn->write_pos;
+  vec[1].iov_base = (char *)data;
+  vec[1].iov_len = len;
 
   /* Clear conn->write_pos first in case the block handler does a read. */
   conn->write_pos = 0;
-  SVN_ERR(writebuf_output(conn, pool, conn->write_buf, write_pos));
+  SVN_ERR(writebuf_outputv(conn, pool, vec, len ? 2 : 1));
   return SVN_NO_ERROR;
 }
 
+/* Write data from the write buffer out to the socket. */
+static svn_error_t *writebuf_flush(svn_ra_svn_conn_t *conn, apr_pool_t *pool)
+{
+  return writebuf_flush_with(conn, pool, NULL, 0);
+}
+
+/* Replace the empty write buffer of CONN with one twice the size, unless
+   it reached its maximum size already. */
+static void writebuf_grow(svn_ra_svn_conn_t *conn)
+{
+  if (conn->write_buf_size < SVN_RA_SVN__WRITEBUF_MAX_SIZE)
+    {
+      conn->write_buf_size *= 2;
+      conn->write_buf = apr_palloc(conn->pool, conn->write_buf_size);
+    }
+}
+
 static svn_error_t *writebuf_write(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
                                    const char *data, apr_size_t len)
 {
-  /* data >= 8k is sent immediately */
-  if (len >= sizeof(conn->write_buf) / 2)
-    {
-      if (conn->write_pos > 0)
-        SVN_ERR(writebuf_flush(conn, pool));
+  /* Large blocks get sent immediately, along with the buffered data and
+     without being copied first. */
+  if (len >= SVN_RA_SVN__DIRECT_WRITE_SIZE)
+    return writebuf_flush_with(conn, pool, data, len);
 
-      return writebuf_output(conn, pool, data, len);
+  /* ensure room for the data to add.  A connection that keeps filling
+     its buffer sends lots of data, so batch more of it per write. */
+  if (conn->write_pos + len > conn->write_buf_size)
+    {
+      SVN_ERR(writebuf_flush(conn, pool));
+      writebuf_grow(conn);
     }
 
-  /* ensure room for the data to add */
-  if (conn->write_pos + len > sizeof(conn->write_buf))
-    SVN_ERR(writebuf_flush(conn, pool));
-
   /* buffer the new data block as well */
   memcpy(conn->write_buf + conn->write_pos, data, len);
   conn->write_pos += len;
@@ -461,7 +526,7 @@ static svn_error_t *writebuf_write(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
 static APR_INLINE svn_error_t *
 writebuf_writechar(svn_ra_svn_conn_t *conn, apr_pool_t *pool, char data)
 {
-  if (conn->write_pos < sizeof(conn->write_buf))
+  if (conn->write_pos < conn->write_buf_size)
   {
     conn->write_buf[conn->write_pos] = data;
     conn->write_pos++;
@@ -668,7 +733,7 @@ static svn_error_t *write_number(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
 
   /* SVN_INT64_BUFFER_SIZE includes space for a terminating NUL that
    * svn__ui64toa will always append. */
-  if (conn->write_pos + SVN_INT64_BUFFER_SIZE >= sizeof(conn->write_buf))
+  if (conn->write_pos + SVN_INT64_BUFFER_SIZE >= conn->write_buf_size)
     SVN_ERR(writebuf_flush(conn, pool));
 
   written = svn__ui64toa(conn->write_buf + conn->write_pos, number);
@@ -728,7 +793,7 @@ svn_ra_svn__write_ncstring(svn_ra_svn_conn_t *conn,
 {
   /* Apart from LEN bytes of string contents, we need room for a number,
      a colon and a space. */
-  apr_size_t max_fill = sizeof(conn->write_buf) - SVN_INT64_BUFFER_SIZE - 2;
+  apr_size_t max_fill = conn->write_buf_size - SVN_INT64_BUFFER_SIZE - 2;
 
   /* In most cases, there is enough left room in the WRITE_BUF
      the we can serialize directly into it.  On platforms with
@@ -830,7 +895,7 @@ svn_error_t *
 svn_ra_svn__start_list(svn_ra_svn_conn_t *conn,
                        apr_pool_t *pool)
 {
-  if (conn->write_pos + 2 <= sizeof(conn->write_buf))
+  if (conn->write_pos + 2 <= conn->write_buf_size)
     {
       conn->write_buf[conn->write_pos] = '(';
       conn->write_buf[conn->write_pos+1] = ' ';
@@ -845,7 +910,7 @@ svn_error_t *
 svn_ra_svn__end_list(svn_ra_svn_conn_t *conn,
                      apr_pool_t *pool)
 {
-  if (conn->write_pos + 2 <= sizeof(conn->write_buf))
+  if (conn->write_pos + 2 <= conn->write_buf_size)
   {
     conn->write_buf[conn->write_pos] = ')';
     conn->write_buf[conn->write_pos+1] = ' ';
@@ -866,6 +931,33 @@ svn_ra_svn__flush(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_ra_svn__enable_stream_compression(svn_ra_svn_conn_t *conn,
+                                      apr_pool_t *scratch_pool)
+{
+  if (conn->compression_stats)
+    return SVN_NO_ERROR;
+
+  /* Anything written so far must go out uncompressed.  The other side
+     cannot have sent compressed data before it got our last message. */
+  SVN_ERR(svn_ra_svn__flush(conn, scratch_pool));
+  if (conn->read_end > conn->read_ptr)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Unexpected data before enabling "
+                              "compression"));
+
+  conn->stream = svn_ra_svn__stream_compressed(&conn->compression_stats,
+                                               conn->stream, conn->pool);
+
+  return SVN_NO_ERROR;
+}
+
+const svn_ra_svn__compression_stats_t *
+svn_ra_svn__get_compression_stats(svn_ra_svn_conn_t *conn)
+{
+  return conn->compression_stats;
+}
+
 /* --- WRITING TUPLES --- */
 
 static svn_error_t *
@@ -990,7 +1082,7 @@ write_tuple_string_opt_list(svn_ra_svn_conn_t *conn,
 
   /* If this how far we can fill the WRITE_BUF with string data and still
      guarantee that the length info will fit in as well. */
-  max_fill = sizeof(conn->write_buf)
+  max_fill = conn->write_buf_size
            - 2                       /* open list */
            - SVN_INT64_BUFFER_SIZE   /* string length + separator */
            - 2;                      /* close list */
@@ -1291,6 +1383,60 @@ static svn_error_t *read_string(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   return SVN_NO_ERROR;
 }
 
+/* Given its first character FIRST_CHAR, read a word from CONN into
+ * BUFFER, which must provide MAX_WORD_LENGTH + 1 bytes.  Set *LEN to the
+ * length of the NUL-terminated word and *NEXT_CHAR to the character
+ * following it.  Use POOL for temporary allocations.
+ */
+static svn_error_t *read_word(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
+                              char *buffer, apr_size_t *len,
+                              char *next_char, char first_char)
+{
+  char *end = buffer + MAX_WORD_LENGTH;
+  char *p = buffer + 1;
+
+  buffer[0] = first_char;
+  if (conn->read_ptr + MAX_WORD_LENGTH <= conn->read_end)
+    {
+      /* Fast path: we can simply take a chunk from the read
+       * buffer and inspect it with no overflow checks etc.
+       *
+       * Copying these 24 bytes unconditionally is also faster
+       * than a variable-sized memcpy.  Note that P is at BUFFER[1].
+       */
+      memcpy(p, conn->read_ptr, MAX_WORD_LENGTH - 1);
+      *end = 0;
+
+      /* This will terminate at P == END because of *END == NUL. */
+      while (svn_ctype_isalnum(*p) || *p == '-')
+        ++p;
+
+      /* Only now do we mark data as actually read. */
+      conn->read_ptr += p - buffer;
+    }
+  else
+    {
+      /* Slow path. Byte-by-byte copying and checking for
+       * input and output buffer boundaries. */
+      for (p = buffer + 1; p != end; ++p)
+        {
+          SVN_ERR(readbuf_getchar(conn, pool, p));
+          if (!svn_ctype_isalnum(*p) && *p != '-')
+            break;
+        }
+    }
+
+  if (p == end)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Word is too long"));
+
+  *next_char = *p;
+  *p = '\0';
+  *len = p - buffer;
+
+  return SVN_NO_ERROR;
+}
+
 /* Given the first non-whitespace character FIRST_CHAR, read an item
  * into the already allocated structure ITEM.  LEVEL should be set
  * to 0 for the first call and is used to enforce a recursion limit
@@ -1345,51 +1491,11 @@ static svn_error_t *read_item(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
     {
       /* It's a word.  Read it into a buffer of limited size. */
       char *buffer = apr_palloc(pool, MAX_WORD_LENGTH + 1);
-      char *end = buffer + MAX_WORD_LENGTH;
-      char *p = buffer + 1;
-
-      buffer[0] = c;
-      if (conn->read_ptr + MAX_WORD_LENGTH <= conn->read_end)
-        {
-          /* Fast path: we can simply take a chunk from the read
-           * buffer and inspect it with no overflow checks etc.
-           *
-           * Copying these 24 bytes unconditionally is also faster
-           * than a variable-sized memcpy.  Note that P is at BUFFER[1].
-           */
-          memcpy(p, conn->read_ptr, MAX_WORD_LENGTH - 1);
-          *end = 0;
-
-          /* This will terminate at P == END because of *END == NUL. */
-          while (svn_ctype_isalnum(*p) || *p == '-')
-            ++p;
-
-          /* Only now do we mark data as actually read. */
-          conn->read_ptr += p - buffer;
-        }
-      else
-        {
-          /* Slow path. Byte-by-byte copying and checking for
-           * input and output buffer boundaries. */
-          for (p = buffer + 1; p != end; ++p)
-            {
-              SVN_ERR(readbuf_getchar(conn, pool, p));
-              if (!svn_ctype_isalnum(*p) && *p != '-')
-                break;
-            }
-        }
-
-      if (p == end)
-        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
-                                _("Word is too long"));
-
-      c = *p;
-      *p = '\0';
 
       /* Store the word in ITEM. */
       item->kind = SVN_RA_SVN_WORD;
       item->u.word.data = buffer;
-      item->u.word.len = p - buffer;
+      SVN_ERR(read_word(conn, pool, buffer, &item->u.word.len, &c, c));
     }
   else if (c == '(')
     {
@@ -1602,71 +1708,70 @@ svn_ra_svn__skip_leading_garbage(svn_ra_svn_conn_t *conn,
 
 /* --- READING AND PARSING TUPLES --- */
 
-/* Parse a tuple of svn_ra_svn__item_t *'s.  Advance *FMT to the end of the
- * tuple specification and advance AP by the corresponding arguments. */
+/* Store the data item ELT in the next argument from AP, as requested by
+ * the format character FMT_CHAR.  Set *MATCHED to FALSE and leave AP
+ * untouched if ELT does not match FMT_CHAR, which must not be '(', ')'
+ * nor '?'.
+ */
+static void
+store_item(svn_boolean_t *matched,
+           svn_ra_svn__item_t *elt,
+           char fmt_char,
+           va_list *ap)
+{
+  *matched = TRUE;
+  if (fmt_char == 'c' && elt->kind == SVN_RA_SVN_STRING)
+    *va_arg(*ap, const char **) = elt->u.string.data;
+  else if (fmt_char == 's' && elt->kind == SVN_RA_SVN_STRING)
+    *va_arg(*ap, svn_string_t **) = &elt->u.string;
+  else if (fmt_char == 'w' && elt->kind == SVN_RA_SVN_WORD)
+    *va_arg(*ap, const char **) = elt->u.word.data;
+  else if (fmt_char == 'b' && elt->kind == SVN_RA_SVN_WORD)
+    {
+      if (svn_string_compare(&elt->u.word, &str_true))
+        *va_arg(*ap, svn_boolean_t *) = TRUE;
+      else if (svn_string_compare(&elt->u.word, &str_false))
+        *va_arg(*ap, svn_boolean_t *) = FALSE;
+      else
+        *matched = FALSE;
+    }
+  else if (fmt_char == 'n' && elt->kind == SVN_RA_SVN_NUMBER)
+    *va_arg(*ap, apr_uint64_t *) = elt->u.number;
+  else if (fmt_char == 'r' && elt->kind == SVN_RA_SVN_NUMBER)
+    *va_arg(*ap, svn_revnum_t *) = (svn_revnum_t) elt->u.number;
+  else if (fmt_char == 'B' && elt->kind == SVN_RA_SVN_WORD)
+    {
+      if (svn_string_compare(&elt->u.word, &str_true))
+        *va_arg(*ap, apr_uint64_t *) = TRUE;
+      else if (svn_string_compare(&elt->u.word, &str_false))
+        *va_arg(*ap, apr_uint64_t *) = FALSE;
+      else
+        *matched = FALSE;
+    }
+  else if (fmt_char == '3' && elt->kind == SVN_RA_SVN_WORD)
+    {
+      if (svn_string_compare(&elt->u.word, &str_true))
+        *va_arg(*ap, svn_tristate_t *) = svn_tristate_true;
+      else if (svn_string_compare(&elt->u.word, &str_false))
+        *va_arg(*ap, svn_tristate_t *) = svn_tristate_false;
+      else
+        *matched = FALSE;
+    }
+  else if (fmt_char == 'l' && elt->kind == SVN_RA_SVN_LIST)
+    *va_arg(*ap, svn_ra_svn__list_t **) = &elt->u.list;
+  else
+    *matched = FALSE;
+}
+
+/* The tuple described by *FMT ran out of data items.  Unless that's an
+ * error, set all optional arguments in AP to their default values and
+ * advance *FMT to the end of the tuple specification. */
 static svn_error_t *
-vparse_tuple(const svn_ra_svn__list_t *items,
-             const char **fmt,
+finish_tuple(const char **fmt,
              va_list *ap)
 {
-  int count, nesting_level;
-  svn_ra_svn__item_t *elt;
+  int nesting_level;
 
-  for (count = 0; **fmt && count < items->nelts; (*fmt)++, count++)
-    {
-      /* '?' just means the tuple may stop; skip past it. */
-      if (**fmt == '?')
-        (*fmt)++;
-      elt = &SVN_RA_SVN__LIST_ITEM(items, count);
-      if (**fmt == '(' && elt->kind == SVN_RA_SVN_LIST)
-        {
-          (*fmt)++;
-          SVN_ERR(vparse_tuple(&elt->u.list, fmt, ap));
-        }
-      else if (**fmt == 'c' && elt->kind == SVN_RA_SVN_STRING)
-        *va_arg(*ap, const char **) = elt->u.string.data;
-      else if (**fmt == 's' && elt->kind == SVN_RA_SVN_STRING)
-        *va_arg(*ap, svn_string_t **) = &elt->u.string;
-      else if (**fmt == 'w' && elt->kind == SVN_RA_SVN_WORD)
-        *va_arg(*ap, const char **) = elt->u.word.data;
-      else if (**fmt == 'b' && elt->kind == SVN_RA_SVN_WORD)
-        {
-          if (svn_string_compare(&elt->u.word, &str_true))
-            *va_arg(*ap, svn_boolean_t *) = TRUE;
-          else if (svn_string_compare(&elt->u.word, &str_false))
-            *va_arg(*ap, svn_boolean_t *) = FALSE;
-          else
-            break;
-        }
-      else if (**fmt == 'n' && elt->kind == SVN_RA_SVN_NUMBER)
-        *va_arg(*ap, apr_uint64_t *) = elt->u.number;
-      else if (**fmt == 'r' && elt->kind == SVN_RA_SVN_NUMBER)
-        *va_arg(*ap, svn_revnum_t *) = (svn_revnum_t) elt->u.number;
-      else if (**fmt == 'B' && elt->kind == SVN_RA_SVN_WORD)
-        {
-          if (svn_string_compare(&elt->u.word, &str_true))
-            *va_arg(*ap, apr_uint64_t *) = TRUE;
-          else if (svn_string_compare(&elt->u.word, &str_false))
-            *va_arg(*ap, apr_uint64_t *) = FALSE;
-          else
-            break;
-        }
-      else if (**fmt == '3' && elt->kind == SVN_RA_SVN_WORD)
-        {
-          if (svn_string_compare(&elt->u.word, &str_true))
-            *va_arg(*ap, svn_tristate_t *) = svn_tristate_true;
-          else if (svn_string_compare(&elt->u.word, &str_false))
-            *va_arg(*ap, svn_tristate_t *) = svn_tristate_false;
-          else
-            break;
-        }
-      else if (**fmt == 'l' && elt->kind == SVN_RA_SVN_LIST)
-        *va_arg(*ap, svn_ra_svn__list_t **) = &elt->u.list;
-      else if (**fmt == ')')
-        return SVN_NO_ERROR;
-      else
-        break;
-    }
   if (**fmt == '?')
     {
       nesting_level = 0;
@@ -1717,6 +1822,134 @@ vparse_tuple(const svn_ra_svn__list_t *items,
   return SVN_NO_ERROR;
 }
 
+/* Parse a tuple of svn_ra_svn__item_t *'s.  Advance *FMT to the end of the
+ * tuple specification and advance AP by the corresponding arguments. */
+static svn_error_t *
+vparse_tuple(const svn_ra_svn__list_t *items,
+             const char **fmt,
+             va_list *ap)
+{
+  int count;
+  svn_ra_svn__item_t *elt;
+  svn_boolean_t matched;
+
+  for (count = 0; **fmt && count < items->nelts; (*fmt)++, count++)
+    {
+      /* '?' just means the tuple may stop; skip past it. */
+      if (**fmt == '?')
+        (*fmt)++;
+      elt = &SVN_RA_SVN__LIST_ITEM(items, count);
+      if (**fmt == '(' && elt->kind == SVN_RA_SVN_LIST)
+        {
+          (*fmt)++;
+          SVN_ERR(vparse_tuple(&elt->u.list, fmt, ap));
+        }
+      else if (**fmt == ')')
+        return SVN_NO_ERROR;
+      else if (**fmt == '(')
+        break;
+      else
+        {
+          store_item(&matched, elt, **fmt, ap);
+          if (!matched)
+            break;
+        }
+    }
+
+  return svn_error_trace(finish_tuple(fmt, ap));
+}
+
+/* Read the remainder of a tuple from CONN, i.e. everything after its
+ * opening parenthesis, and store its elements in AP as specified by *FMT.
+ * Advance *FMT to the end of the tuple specification.  LEVEL is the
+ * nesting level of the tuple, with 0 being the top-level.
+ *
+ * This is equivalent to reading the tuple with read_item and parsing it
+ * with vparse_tuple but does not construct the item tree. */
+static svn_error_t *
+vread_tuple(svn_ra_svn_conn_t *conn,
+            apr_pool_t *pool,
+            const char **fmt,
+            va_list *ap,
+            int level)
+{
+  char c;
+  svn_ra_svn__item_t stack_elt;
+  svn_boolean_t matched;
+
+  if (++level >= ITEM_NESTING_LIMIT)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Items are nested too deeply"));
+
+  while (1)
+    {
+      SVN_ERR(readbuf_getchar_skip_whitespace(conn, pool, &c));
+      if (c == ')')
+        break;
+
+      /* '?' just means the tuple may stop; skip past it. */
+      if (**fmt == '?')
+        (*fmt)++;
+
+      if (**fmt == '\0' || **fmt == ')')
+        {
+          /* Ignore items beyond the end of the specification. */
+          SVN_ERR(read_item(conn, pool, &stack_elt, c, level));
+          continue;
+        }
+
+      if (**fmt == '(')
+        {
+          if (c != '(')
+            return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                    _("Malformed network data"));
+
+          (*fmt)++;
+          SVN_ERR(vread_tuple(conn, pool, fmt, ap, level));
+          SVN_ERR(readbuf_getchar(conn, pool, &c));
+          if (!svn_iswhitespace(c))
+            return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                    _("Malformed network data"));
+        }
+      else if (   (**fmt == 'b' || **fmt == 'B' || **fmt == '3')
+               && svn_ctype_isalpha(c))
+        {
+          /* Flags don't need to survive this function. */
+          char buffer[MAX_WORD_LENGTH + 1];
+
+          stack_elt.kind = SVN_RA_SVN_WORD;
+          stack_elt.u.word.data = buffer;
+          SVN_ERR(read_word(conn, pool, buffer, &stack_elt.u.word.len, &c,
+                            c));
+          if (!svn_iswhitespace(c))
+            return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                    _("Malformed network data"));
+
+          store_item(&matched, &stack_elt, **fmt, ap);
+          if (!matched)
+            return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                    _("Malformed network data"));
+        }
+      else
+        {
+          /* Strings and lists get returned by reference to ELT. */
+          svn_ra_svn__item_t *elt = (**fmt == 's' || **fmt == 'l')
+                                  ? apr_palloc(pool, sizeof(*elt))
+                                  : &stack_elt;
+
+          SVN_ERR(read_item(conn, pool, elt, c, level));
+          store_item(&matched, elt, **fmt, ap);
+          if (!matched)
+            return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                    _("Malformed network data"));
+        }
+
+      (*fmt)++;
+    }
+
+  return svn_error_trace(finish_tuple(fmt, ap));
+}
+
 svn_error_t *
 svn_ra_svn__parse_tuple(const svn_ra_svn__list_t *list,
                         const char *fmt, ...)
@@ -1736,17 +1969,26 @@ svn_ra_svn__read_tuple(svn_ra_svn_conn_t *conn,
                        const char *fmt, ...)
 {
   va_list ap;
-  svn_ra_svn__item_t *item;
   svn_error_t *err;
+  char c;
 
-  SVN_ERR(svn_ra_svn__read_item(conn, pool, &item));
-  if (item->kind != SVN_RA_SVN_LIST)
+  SVN_ERR(readbuf_getchar_skip_whitespace(conn, pool, &c));
+  if (c != '(')
     return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
                             _("Malformed network data"));
+
+  /* Store the tuple elements directly in the caller's variables. */
   va_start(ap, fmt);
-  err = vparse_tuple(&item->u.list, &fmt, &ap);
+  err = vread_tuple(conn, pool, &fmt, &ap, 0);
   va_end(ap);
-  return err;
+  SVN_ERR(err);
+
+  SVN_ERR(readbuf_getchar(conn, pool, &c));
+  if (!svn_iswhitespace(c))
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Malformed network data"));
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -1903,8 +2145,83 @@ svn_ra_svn__has_command(svn_boolean_t *has_command,
   return svn_error_trace(err);
 }
 
+/* Read the start of the next command from CONN, up to and including the
+ * command name, and return the name in *CMDNAME.  Use POOL for
+ * allocations. */
+static svn_error_t *
+read_command_name(const char **cmdname,
+                  svn_ra_svn_conn_t *conn,
+                  apr_pool_t *pool)
+{
+  svn_ra_svn__item_t item;
+  char c;
+
+  SVN_ERR(readbuf_getchar_skip_whitespace(conn, pool, &c));
+  if (c == '(')
+    {
+      SVN_ERR(readbuf_getchar_skip_whitespace(conn, pool, &c));
+      if (svn_ctype_isalpha(c))
+        {
+          SVN_ERR(read_item(conn, pool, &item, c, 1));
+          *cmdname = item.u.word.data;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                          _("Malformed network data"));
+}
+
+/* Read and discard the remaining items of the current top-level list
+ * from CONN, including the closing parenthesis.  Use POOL for temporary
+ * allocations. */
+static svn_error_t *
+skip_rest_of_list(svn_ra_svn_conn_t *conn,
+                  apr_pool_t *pool)
+{
+  svn_ra_svn__item_t item;
+  char c;
+
+  SVN_ERR(readbuf_getchar_skip_whitespace(conn, pool, &c));
+  while (c != ')')
+    {
+      SVN_ERR(read_item(conn, pool, &item, c, 1));
+      SVN_ERR(readbuf_getchar_skip_whitespace(conn, pool, &c));
+    }
+
+  SVN_ERR(readbuf_getchar(conn, pool, &c));
+  if (!svn_iswhitespace(c))
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Malformed network data"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Having read the command name, read the parameter list of the command
+ * from CONN and skip the rest of the command.  Return the parameters in
+ * *PARAMS, allocated in POOL. */
+static svn_error_t *
+read_command_params(svn_ra_svn__list_t **params,
+                    svn_ra_svn_conn_t *conn,
+                    apr_pool_t *pool)
+{
+  svn_ra_svn__item_t *item = apr_palloc(pool, sizeof(*item));
+  char c;
+
+  SVN_ERR(readbuf_getchar_skip_whitespace(conn, pool, &c));
+  if (c != '(')
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Malformed network data"));
+
+  SVN_ERR(read_item(conn, pool, item, c, 1));
+  *params = &item->u.list;
+
+  return svn_error_trace(skip_rest_of_list(conn, pool));
+}
+
 svn_error_t *
 svn_ra_svn__handle_command(svn_boolean_t *terminate,
+                           svn_ra_svn__command_stats_t *stats,
                            apr_hash_t *cmd_hash,
                            void *baton,
                            svn_ra_svn_conn_t *conn,
@@ -1913,15 +2230,30 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
 {
   const char *cmdname;
   svn_error_t *err, *write_err;
-  svn_ra_svn__list_t *params;
-  const svn_ra_svn__cmd_entry_t *command;
+  svn_ra_svn__list_t *params = NULL;
+  const svn_ra_svn__cmd_entry_t *command = NULL;
+  apr_time_t start = 0;
 
   *terminate = FALSE;
+  if (stats)
+    stats->cmdname = NULL;
 
   /* Limit I/O for every command separately. */
   svn_ra_svn__reset_command_io_counters(conn);
 
-  err = svn_ra_svn__read_tuple(conn, pool, "wl", &cmdname, &params);
+  /* Unless the handler reads the parameters itself, parse them into an
+   * item tree. */
+  err = read_command_name(&cmdname, conn, pool);
+  if (!err)
+    {
+      if (stats)
+        start = apr_time_now();
+
+      command = svn_hash_gets(cmd_hash, cmdname);
+      if (!command || !command->stream_handler)
+        err = read_command_params(&params, conn, pool);
+    }
+
   if (err)
     {
       if (!error_on_disconnect
@@ -1934,13 +2266,21 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
       return err;
     }
 
-  command = svn_hash_gets(cmd_hash, cmdname);
   if (command)
     {
       /* Call the standard command handler.
        * If that is not set, then this is a lecagy API call and we invoke
        * the legacy command handler. */
-      if (command->handler)
+      if (command->stream_handler)
+        {
+          /* The handler has read the parameters.  Skip the rest of the
+           * command unless the connection is in an undefined state. */
+          err = command->stream_handler(conn, pool, baton);
+          if (!err || err->apr_err == SVN_ERR_RA_SVN_CMD_ERR)
+            err = svn_error_compose_create(skip_rest_of_list(conn, pool),
+                                           err);
+        }
+      else if (command->handler)
         {
           err = (*command->handler)(conn, pool, params, baton);
         }
@@ -1968,6 +2308,15 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
       err = svn_error_create(SVN_ERR_RA_SVN_CMD_ERR, err, NULL);
     }
 
+  if (stats)
+    {
+      stats->cmdname = cmdname;
+      stats->duration = apr_time_now() - start;
+      stats->bytes_in = conn->current_in;
+      stats->bytes_out = conn->current_out;
+      stats->failed = (err != NULL);
+    }
+
   if (err && err->apr_err == SVN_ERR_RA_SVN_CMD_ERR)
     {
       write_err = svn_ra_svn__write_cmd_failure(
@@ -2001,8 +2350,8 @@ svn_ra_svn__handle_commands2(svn_ra_svn_conn_t *conn,
       svn_error_t *err;
       svn_pool_clear(iterpool);
 
-      err = svn_ra_svn__handle_command(&terminate, cmd_hash, baton, conn,
-                                       error_on_disconnect, iterpool);
+      err = svn_ra_svn__handle_command(&terminate, NULL, cmd_hash, baton,
+                                       conn, error_on_disconnect, iterpool);
       if (err)
         {
           svn_pool_destroy(subpool);
@@ -2848,7 +3197,7 @@ svn_ra_svn__write_data_log_changed_path(svn_ra_svn_conn_t *conn,
   apr_size_t flags_len = flags_str->len;
 
   /* How much buffer space can we use for non-string data (worst case)? */
-  apr_size_t max_fill = sizeof(conn->write_buf)
+  apr_size_t max_fill = conn->write_buf_size
                       - 2                          /* list start */
                       - 2 - SVN_INT64_BUFFER_SIZE  /* path */
                       - 2                          /* action */
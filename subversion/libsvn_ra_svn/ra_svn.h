@@ -67,6 +67,15 @@ typedef svn_error_t *(*ra_svn_block_handler_t)(svn_ra_svn_conn_t *conn,
 #define SVN_RA_SVN__READBUF_SIZE (4 * SVN_RA_SVN__PAGE_SIZE)
 #define SVN_RA_SVN__WRITEBUF_SIZE (4 * SVN_RA_SVN__PAGE_SIZE)
 
+/* While a connection keeps overflowing its write buffer, e.g. because it
+   sends lots of small svndiff windows or directory entries, the buffer
+   doubles in size up to this limit. */
+#define SVN_RA_SVN__WRITEBUF_MAX_SIZE (32 * SVN_RA_SVN__PAGE_SIZE)
+
+/* Data blocks of at least this size don't get copied into the write
+   buffer.  They are sent directly, together with the buffer contents. */
+#define SVN_RA_SVN__DIRECT_WRITE_SIZE (SVN_RA_SVN__WRITEBUF_SIZE / 2)
+
 /* Create forward reference */
 typedef struct svn_ra_svn__session_baton_t svn_ra_svn__session_baton_t;
 
@@ -75,10 +84,11 @@ typedef struct svn_ra_svn__session_baton_t svn_ra_svn__session_baton_t;
 struct svn_ra_svn_conn_st {
 
   /* I/O buffers */
-  char write_buf[SVN_RA_SVN__WRITEBUF_SIZE];
   char read_buf[SVN_RA_SVN__READBUF_SIZE];
   char *read_ptr;
   char *read_end;
+  char *write_buf;
+  apr_size_t write_buf_size;
   apr_size_t write_pos;
 
   svn_ra_svn__stream_t *stream;
@@ -118,6 +128,9 @@ struct svn_ra_svn_conn_st {
   /* who's on the other side of the connection? */
   char *remote_ip;
 
+  /* byte counts of the stream compression; NULL while not compressed */
+  svn_ra_svn__compression_stats_t *compression_stats;
+
   /* EV2 support*/
   svn_delta_shim_callbacks_t *shim_callbacks;
 
@@ -160,6 +173,10 @@ struct svn_ra_svn__session_baton_t {
   apr_off_t bytes_read, bytes_written; /* apr_off_t's because that's what
                                           the callback interface uses */
   const char *useragent;
+
+  /* Realm string to save the auth ticket the server may hand out at the
+     end of the handshake for, or NULL if we don't expect one. */
+  const char *ticket_realmstring;
 };
 
 /* Set a callback for blocked writes on conn.  This handler may
@@ -216,12 +233,31 @@ svn_ra_svn__stream_t *svn_ra_svn__stream_create(svn_stream_t *in_stream,
                                                 ra_svn_timeout_fn_t timeout_cb,
                                                 apr_pool_t *result_pool);
 
+/* Return a stream that LZ4-compresses all data written to it before
+ * passing it on to STREAM and decompresses all data read from STREAM.
+ * Set *STATS to the byte counts of the new stream.  Allocate everything
+ * in RESULT_POOL.
+ */
+svn_ra_svn__stream_t *
+svn_ra_svn__stream_compressed(svn_ra_svn__compression_stats_t **stats,
+                              svn_ra_svn__stream_t *stream,
+                              apr_pool_t *result_pool);
+
 /* Write *LEN bytes from DATA to STREAM, returning the number of bytes
  * written in *LEN.
  */
 svn_error_t *svn_ra_svn__stream_write(svn_ra_svn__stream_t *stream,
                                       const char *data, apr_size_t *len);
 
+/* Write the NVEC blocks in VEC to STREAM in that order, returning the
+ * number of bytes written in *LEN.  This may write fewer bytes than the
+ * blocks contain, even if the underlying stream did not block.
+ */
+svn_error_t *svn_ra_svn__stream_writev(svn_ra_svn__stream_t *stream,
+                                       const struct iovec *vec,
+                                       int nvec,
+                                       apr_size_t *len);
+
 /* Read *LEN bytes from STREAM into DATA, returning the number of bytes
  * read in *LEN.
  */
@@ -261,6 +297,22 @@ svn_ra_svn__do_internal_auth(svn_ra_svn__session_baton_t *sess,
                              const svn_ra_svn__list_t *mechlist,
                              const char *realm, apr_pool_t *pool);
 
+/* Try to authenticate with an auth ticket cached for REALM, if there is
+ * one, setting *SUCCESS to TRUE if the server accepted it.  Otherwise,
+ * remember to save the next ticket the server hands out for REALM. */
+svn_error_t *
+svn_ra_svn__do_ticket_auth(svn_boolean_t *success,
+                           svn_ra_svn__session_baton_t *sess,
+                           const char *realm,
+                           apr_pool_t *pool);
+
+/* Cache TICKET, which the server handed out after the authentication
+ * exchange during the handshake, for future sessions. */
+svn_error_t *
+svn_ra_svn__save_auth_ticket(svn_ra_svn__session_baton_t *sess,
+                             const char *ticket,
+                             apr_pool_t *pool);
+
 /* Having picked a mechanism, start authentication by writing out an
  * auth response.  MECH_ARG may be NULL for mechanisms with no
  * initial client response. */
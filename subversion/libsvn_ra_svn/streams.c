@@ -34,6 +34,7 @@
 #include "svn_private_config.h"
 
 #include "private/svn_io_private.h"
+#include "private/svn_subr_private.h"
 
 #include "ra_svn.h"
 
@@ -42,6 +43,9 @@ struct svn_ra_svn__stream_st {
   svn_stream_t *out_stream;
   void *timeout_baton;
   ra_svn_timeout_fn_t timeout_fn;
+
+  /* The socket behind OUT_STREAM, if any.  Allows for gather writes. */
+  apr_socket_t *sock;
 };
 
 typedef struct sock_baton_t {
@@ -167,6 +171,7 @@ svn_ra_svn__stream_from_sock(apr_socket_t *sock,
 {
   sock_baton_t *b = apr_palloc(result_pool, sizeof(*b));
   svn_stream_t *sock_stream;
+  svn_ra_svn__stream_t *stream;
 
   b->sock = sock;
   b->pool = svn_pool_create(result_pool);
@@ -177,8 +182,11 @@ svn_ra_svn__stream_from_sock(apr_socket_t *sock,
   svn_stream_set_write(sock_stream, sock_write_cb);
   svn_stream_set_data_available(sock_stream, sock_pending_cb);
 
-  return svn_ra_svn__stream_create(sock_stream, sock_stream,
-                                   b, sock_timeout_cb, result_pool);
+  stream = svn_ra_svn__stream_create(sock_stream, sock_stream,
+                                     b, sock_timeout_cb, result_pool);
+  stream->sock = sock;
+
+  return stream;
 }
 
 svn_ra_svn__stream_t *
@@ -193,6 +201,7 @@ svn_ra_svn__stream_create(svn_stream_t *in_stream,
   s->out_stream = out_stream;
   s->timeout_baton = timeout_baton;
   s->timeout_fn = timeout_cb;
+  s->sock = NULL;
   return s;
 }
 
@@ -203,6 +212,31 @@ svn_ra_svn__stream_write(svn_ra_svn__stream_t *stream,
   return svn_error_trace(svn_stream_write(stream->out_stream, data, len));
 }
 
+svn_error_t *
+svn_ra_svn__stream_writev(svn_ra_svn__stream_t *stream,
+                          const struct iovec *vec,
+                          int nvec,
+                          apr_size_t *len)
+{
+  if (stream->sock)
+    {
+      apr_status_t status = apr_socket_sendv(stream->sock, vec, nvec, len);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't write to connection"));
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Generic streams don't support gather writes.  Write the first block
+     and let the caller come back for the rest. */
+  *len = nvec ? vec[0].iov_len : 0;
+  if (*len == 0)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(svn_stream_write(stream->out_stream,
+                                          vec[0].iov_base, len));
+}
+
 svn_error_t *
 svn_ra_svn__stream_read(svn_ra_svn__stream_t *stream, char *data,
                         apr_size_t *len)
@@ -230,3 +264,218 @@ svn_ra_svn__stream_data_available(svn_ra_svn__stream_t *stream,
           svn_stream_data_available(stream->in_stream,
                                     data_available));
 }
+
+/* Functions to implement an LZ4 compressed svn_ra_svn__stream_t.
+ *
+ * Every write becomes one frame: the length of the compressed block as
+ * 7b/8b-encoded integer, followed by the block as produced by
+ * svn__compress_lz4().  Since the marshaller writes whole buffers, there
+ * is no need to flush any compressor state. */
+
+/* Maximum amount of data to put into a single frame. */
+#define COMPRESSED_BLOCK_SIZE 0x10000
+
+/* Maximum size of a frame's compressed block.  Incompressible data gets
+   stored as-is, behind its length. */
+#define COMPRESSED_BLOCK_MAX (COMPRESSED_BLOCK_SIZE + SVN__MAX_ENCODED_UINT_LEN)
+
+/* Amount of compressed data to request from the wrapped stream at once. */
+#define COMPRESSED_READ_SIZE 0x4000
+
+/* Baton for an LZ4 compressed svn_ra_svn__stream_t. */
+typedef struct compressed_baton_t {
+  svn_ra_svn__stream_t *stream;  /* The wrapped stream. */
+
+  svn_stringbuf_t *in;           /* Received data not decompressed yet. */
+  svn_stringbuf_t *decompressed; /* The last frame received, ... */
+  apr_size_t decompressed_pos;   /* ... of which this much has been read. */
+
+  svn_stringbuf_t *compressed;   /* Scratch buffer for svn__compress_lz4. */
+  svn_stringbuf_t *out;          /* The last frame to send, ... */
+  apr_size_t out_pos;            /* ... of which this much has been sent, */
+  apr_size_t out_len;            /* ... containing this much raw data. */
+
+  svn_ra_svn__compression_stats_t stats;
+} compressed_baton_t;
+
+/* If B->IN starts with a complete frame, decompress it into
+   B->DECOMPRESSED, remove it from B->IN and set *FOUND.  Otherwise, set
+   *FOUND to FALSE. */
+static svn_error_t *
+decompress_frame(svn_boolean_t *found,
+                 compressed_baton_t *b)
+{
+  const unsigned char *start = (const unsigned char *)b->in->data;
+  const unsigned char *end = start + b->in->len;
+  const unsigned char *p;
+  apr_uint64_t block_len;
+
+  *found = FALSE;
+  p = svn__decode_uint(&block_len, start, end);
+  if (p == NULL)
+    {
+      if (b->in->len >= SVN__MAX_ENCODED_UINT_LEN)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Invalid compressed frame header"));
+      return SVN_NO_ERROR;
+    }
+
+  if (block_len > COMPRESSED_BLOCK_MAX)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Compressed frame too large"));
+  if ((apr_uint64_t)(end - p) < block_len)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn__decompress_lz4(p, (apr_size_t)block_len, b->decompressed,
+                              COMPRESSED_BLOCK_SIZE));
+  b->decompressed_pos = 0;
+
+  b->stats.raw_in += b->decompressed->len;
+  b->stats.wire_in += (p - start) + block_len;
+
+  svn_stringbuf_remove(b->in, 0, (p - start) + (apr_size_t)block_len);
+  *found = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_read_fn_t. */
+static svn_error_t *
+compressed_read_cb(void *baton,
+                   char *buffer,
+                   apr_size_t *len)
+{
+  compressed_baton_t *b = baton;
+  apr_size_t available;
+
+  /* Frames may arrive in pieces, hence the loop. */
+  while (b->decompressed_pos == b->decompressed->len)
+    {
+      svn_boolean_t found;
+      apr_size_t read_len = COMPRESSED_READ_SIZE;
+
+      SVN_ERR(decompress_frame(&found, b));
+      if (found)
+        continue;
+
+      svn_stringbuf_ensure(b->in, b->in->len + read_len + 1);
+      SVN_ERR(svn_ra_svn__stream_read(b->stream, b->in->data + b->in->len,
+                                      &read_len));
+      b->in->len += read_len;
+      b->in->data[b->in->len] = '\0';
+    }
+
+  available = b->decompressed->len - b->decompressed_pos;
+  if (*len > available)
+    *len = available;
+
+  memcpy(buffer, b->decompressed->data + b->decompressed_pos, *len);
+  b->decompressed_pos += *len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_write_fn_t. */
+static svn_error_t *
+compressed_write_cb(void *baton,
+                    const char *buffer,
+                    apr_size_t *len)
+{
+  compressed_baton_t *b = baton;
+
+  if (*len == 0)
+    return SVN_NO_ERROR;
+
+  /* Unless the previous call could only send part of the frame, and our
+     caller is retrying with the same arguments, start a new frame. */
+  if (b->out_pos == b->out->len)
+    {
+      unsigned char header[SVN__MAX_ENCODED_UINT_LEN];
+      unsigned char *header_end;
+
+      b->out_len = (*len > COMPRESSED_BLOCK_SIZE) ? COMPRESSED_BLOCK_SIZE
+                                                  : *len;
+      SVN_ERR(svn__compress_lz4(buffer, b->out_len, b->compressed));
+
+      header_end = svn__encode_uint(header, b->compressed->len);
+      svn_stringbuf_setempty(b->out);
+      svn_stringbuf_appendbytes(b->out, (const char *)header,
+                                header_end - header);
+      svn_stringbuf_appendbytes(b->out, b->compressed->data,
+                                b->compressed->len);
+      b->out_pos = 0;
+
+      b->stats.raw_out += b->out_len;
+      b->stats.wire_out += b->out->len;
+    }
+
+  do
+    {
+      apr_size_t tmplen = b->out->len - b->out_pos;
+      SVN_ERR(svn_ra_svn__stream_write(b->stream, b->out->data + b->out_pos,
+                                       &tmplen));
+      if (tmplen == 0)
+        {
+          /* The rest of the frame will be sent upon the next call. */
+          *len = 0;
+          return SVN_NO_ERROR;
+        }
+      b->out_pos += tmplen;
+    }
+  while (b->out_pos < b->out->len);
+
+  *len = b->out_len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements ra_svn_timeout_fn_t. */
+static void
+compressed_timeout_cb(void *baton,
+                      apr_interval_time_t interval)
+{
+  compressed_baton_t *b = baton;
+  svn_ra_svn__stream_timeout(b->stream, interval);
+}
+
+/* Implements svn_stream_data_available_fn_t. */
+static svn_error_t *
+compressed_data_available_cb(void *baton,
+                             svn_boolean_t *data_available)
+{
+  compressed_baton_t *b = baton;
+
+  /* Part of a frame means that the rest is on its way. */
+  if (b->decompressed_pos < b->decompressed->len || b->in->len > 0)
+    {
+      *data_available = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(svn_ra_svn__stream_data_available(b->stream,
+                                                           data_available));
+}
+
+svn_ra_svn__stream_t *
+svn_ra_svn__stream_compressed(svn_ra_svn__compression_stats_t **stats,
+                              svn_ra_svn__stream_t *stream,
+                              apr_pool_t *result_pool)
+{
+  compressed_baton_t *b = apr_pcalloc(result_pool, sizeof(*b));
+  svn_stream_t *in_stream = svn_stream_create(b, result_pool);
+  svn_stream_t *out_stream = svn_stream_create(b, result_pool);
+
+  b->stream = stream;
+  b->in = svn_stringbuf_create_ensure(COMPRESSED_READ_SIZE, result_pool);
+  b->decompressed = svn_stringbuf_create_empty(result_pool);
+  b->compressed = svn_stringbuf_create_empty(result_pool);
+  b->out = svn_stringbuf_create_empty(result_pool);
+
+  svn_stream_set_read2(in_stream, compressed_read_cb, NULL /* use default */);
+  svn_stream_set_data_available(in_stream, compressed_data_available_cb);
+  svn_stream_set_write(out_stream, compressed_write_cb);
+
+  *stats = &b->stats;
+  return svn_ra_svn__stream_create(in_stream, out_stream, b,
+                                   compressed_timeout_cb, result_pool);
+}
@@ -187,29 +187,64 @@ construct_authz_key(const svn_checksum_t *authz_key,
   return result;
 }
 
-/* Return a combination of REPOS_NAME, USER and AUTHZ_ID, allocated in
- * RESULT_POOL.  USER may be NULL.  This is the key for the FILTERED_POOL.
+/* Return the key for the FILTERED_POOL that describes the filtered tree
+ * for USER and REPOSITORY built from the repository-specific ACLS, as
+ * returned by collect_repos_acls().  USER may be NULL.  Allocate the
+ * result in RESULT_POOL.
+ *
+ * The filtered tree only depends on the ACLs that actually apply to the
+ * (USER, REPOSITORY) pair, their sequence numbers, paths and the rights
+ * they grant.  So, rather than naming the user, repository and authz
+ * model, the key is a serialization of exactly that information.  Users
+ * with the same rule-relevant group memberships and repositories without
+ * specific rules thus share the same tree.  And since the key does not
+ * depend on the authz file checksum, reloading a modified authz file will
+ * only have to rebuild the trees whose rules actually changed.
  */
 static svn_membuf_t *
-construct_filtered_key(const char *repos_name,
+construct_filtered_key(const apr_array_header_t *acls,
+                       const char *repository,
                        const char *user,
-                       const svn_membuf_t *authz_id,
                        apr_pool_t *result_pool)
 {
   svn_membuf_t *result = apr_pcalloc(result_pool, sizeof(*result));
-  size_t repos_len = strlen(repos_name);
-  size_t user_len = user ? strlen(user) : 1;
-  const char *nullable_user = user ? user : "\0";
-  size_t size = authz_id->size + repos_len + 1 + user_len + 1;
+  svn_stringbuf_t *buffer = svn_stringbuf_create_ensure(256, result_pool);
+  int i, k;
 
-  svn_membuf__create(result, size, result_pool);
-  result->size = size;
+  for (i = 0; i < acls->nelts; ++i)
+    {
+      const authz_acl_t *acl = APR_ARRAY_IDX(acls, i, const authz_acl_t *);
+      authz_access_t rights;
 
-  memcpy(result->data, repos_name, repos_len + 1);
-  size = repos_len + 1;
-  memcpy((char *)result->data + size, nullable_user, user_len + 1);
-  size += user_len + 1;
-  memcpy((char *)result->data + size, authz_id->data, authz_id->size);
+      if (!svn_authz__get_acl_access(&rights, acl, user, repository))
+        continue;
+
+      svn_stringbuf_appendbytes(buffer,
+                                (const char *)&acl->sequence_number,
+                                sizeof(acl->sequence_number));
+      svn_stringbuf_appendbytes(buffer, (const char *)&rights,
+                                sizeof(rights));
+      svn_stringbuf_appendbytes(buffer, (const char *)&acl->rule.len,
+                                sizeof(acl->rule.len));
+
+      for (k = 0; k < acl->rule.len; ++k)
+        {
+          const authz_rule_segment_t *segment = &acl->rule.path[k];
+          int kind = segment->kind;
+
+          svn_stringbuf_appendbytes(buffer, (const char *)&kind,
+                                    sizeof(kind));
+          svn_stringbuf_appendbytes(buffer,
+                                    (const char *)&segment->pattern.len,
+                                    sizeof(segment->pattern.len));
+          svn_stringbuf_appendbytes(buffer, segment->pattern.data,
+                                    segment->pattern.len);
+        }
+    }
+
+  /* The object pool requires the exact key length. */
+  result->data = buffer->data;
+  result->size = buffer->len;
 
   return result;
 }
@@ -872,27 +907,17 @@ finalize_tree(node_t *node,
   combine_right_limits(sum, local_sum);
 }
 
-/* From the authz CONFIG, extract the parts relevant to USER and REPOSITORY.
- * Return the filtered rule tree.
+/* Return all ACLs in AUTHZ that apply to REPOSITORY, allocated in
+ * RESULT_POOL.  Note that repo-specific rules replace global rules,
+ * even if they don't apply to the current user.
  */
-static node_t *
-create_user_authz(authz_full_t *authz,
-                  const char *repository,
-                  const char *user,
-                  apr_pool_t *result_pool,
-                  apr_pool_t *scratch_pool)
+static apr_array_header_t *
+collect_repos_acls(authz_full_t *authz,
+                   const char *repository,
+                   apr_pool_t *result_pool)
 {
   int i;
-  node_t *root = create_node(NULL, result_pool);
-  construction_context_t *ctx = create_construction_context(scratch_pool);
-
-  /* Use a separate sub-pool to keep memory usage tight. */
-  apr_pool_t *subpool = svn_pool_create(scratch_pool);
-
-  /* Find all ACLs for REPOSITORY.
-   * Note that repo-specific rules replace global rules,
-   * even if they don't apply to the current user. */
-  apr_array_header_t *acls = apr_array_make(subpool, authz->acls->nelts,
+  apr_array_header_t *acls = apr_array_make(result_pool, authz->acls->nelts,
                                             sizeof(authz_acl_t *));
   for (i = 0; i < authz->acls->nelts; ++i)
     {
@@ -920,6 +945,27 @@ create_user_authz(authz_full_t *authz,
         }
     }
 
+  return acls;
+}
+
+/* From the repository-specific ACLS, as returned by collect_repos_acls(),
+ * extract the parts relevant to USER and REPOSITORY.
+ * Return the filtered rule tree.
+ */
+static node_t *
+create_user_authz(const apr_array_header_t *acls,
+                  const char *repository,
+                  const char *user,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  int i;
+  node_t *root = create_node(NULL, result_pool);
+  construction_context_t *ctx = create_construction_context(scratch_pool);
+
+  /* Use a separate sub-pool to keep memory usage tight. */
+  apr_pool_t *subpool = svn_pool_create(scratch_pool);
+
   /* Filtering and tree construction. */
   for (i = 0; i < acls->nelts; ++i)
     process_acl(ctx, APR_ARRAY_IDX(acls, i, const authz_acl_t *),
@@ -967,6 +1013,32 @@ create_user_authz(authz_full_t *authz,
 
 /*** Lookup. ***/
 
+/* With many wildcard rules, a path segment may have to be matched against
+ * a large number of patterns at each of the nodes that apply to its parent
+ * path.  To do that at most once per distinct situation, the sets of nodes
+ * that apply to the paths being looked up become the states of a
+ * deterministic automaton with path segments as its input.  States and
+ * transitions get added on demand as new paths are being looked up.
+ */
+typedef struct dfa_state_t
+{
+  /* The nodes (node_t *) that apply to the paths leading to this state,
+   * sorted by address and without duplicates.  May be empty. */
+  apr_array_header_t *nodes;
+
+  /* The combination of the rights of all NODES.  This does not take
+   * inherited rights into account. */
+  limited_rights_t rights;
+
+  /* Map of path segment (const char *) to the dfa_state_t * reached with
+   * it from this state.  Contains only the transitions taken so far. */
+  apr_hash_t *transitions;
+} dfa_state_t;
+
+/* Once the automaton has this many transitions, discard and rebuild it
+ * to limit its memory usage. */
+#define DFA_MAX_TRANSITIONS 0x10000
+
 /* Reusable lookup state object. It is easy to pass to functions and
  * recycling it between lookups saves significant setup costs. */
 typedef struct lookup_state_t
@@ -975,16 +1047,19 @@ typedef struct lookup_state_t
    * any sub-path. */
   limited_rights_t rights;
 
-  /* Nodes applying to the path followed so far. */
-  apr_array_header_t *current;
+  /* Automaton state for the path followed so far. */
+  dfa_state_t *current;
 
   /* Temporary array containing the nodes applying to the next path
-   * segment (used to build up the next contents of CURRENT). */
+   * segment (used to find the automaton state following CURRENT). */
   apr_array_header_t *next;
 
   /* Scratch pad for path operations. */
   svn_stringbuf_t *scratch_pad;
 
+  /* Scratch pad for the reversed path segment when matching suffixes. */
+  svn_stringbuf_t *reversed;
+
   /* After each lookup iteration, CURRENT and PARENT_RIGHTS will
    * apply to this path. */
   svn_stringbuf_t *parent_path;
@@ -992,6 +1067,19 @@ typedef struct lookup_state_t
   /* Rights that apply at PARENT_PATH, if PARENT_PATH is not empty. */
   limited_rights_t parent_rights;
 
+  /* All automaton states (dfa_state_t *) created so far, keyed by the
+   * contents of their NODES arrays. */
+  apr_hash_t *dfa_states;
+
+  /* The automaton state for the root path or NULL if not created yet. */
+  dfa_state_t *dfa_root;
+
+  /* Number of transitions in all DFA_STATES. */
+  int dfa_transitions;
+
+  /* Pool containing the automaton. */
+  apr_pool_t *dfa_pool;
+
 } lookup_state_t;
 
 /* Constructor for lookup_state_t. */
@@ -1001,7 +1089,8 @@ create_lookup_state(apr_pool_t *result_pool)
   lookup_state_t *state = apr_pcalloc(result_pool, sizeof(*state));
 
   state->next = apr_array_make(result_pool, 4, sizeof(node_t *));
-  state->current = apr_array_make(result_pool, 4, sizeof(node_t *));
+  state->dfa_pool = svn_pool_create(result_pool);
+  state->dfa_states = apr_hash_make(state->dfa_pool);
 
   /* Virtually all path segments should fit into this buffer.  If they
    * don't, the buffer gets automatically reallocated.
@@ -1014,10 +1103,99 @@ create_lookup_state(apr_pool_t *result_pool)
   /* Most paths should fit into this buffer.  The same rationale as
    * above applies. */
   state->parent_path = svn_stringbuf_create_ensure(200, result_pool);
+  state->reversed = svn_stringbuf_create_ensure(200, result_pool);
 
   return state;
 }
 
+/* Discard all automaton states in STATE, including the current one. */
+static void
+reset_dfa(lookup_state_t *state)
+{
+  svn_pool_clear(state->dfa_pool);
+  state->dfa_states = apr_hash_make(state->dfa_pool);
+  state->dfa_root = NULL;
+  state->dfa_transitions = 0;
+  state->current = NULL;
+
+  /* The previous lookup can no longer be continued. */
+  svn_stringbuf_setempty(state->parent_path);
+}
+
+/* qsort-compatible comparison function for node_t * by their address. */
+static int
+compare_node_address(const void *lhs,
+                     const void *rhs)
+{
+  const node_t *lhs_node = *(const node_t * const *)lhs;
+  const node_t *rhs_node = *(const node_t * const *)rhs;
+
+  if (lhs_node == rhs_node)
+    return 0;
+
+  return lhs_node < rhs_node ? -1 : 1;
+}
+
+/* Return the automaton state in STATE for the set of NODES (node_t *).
+ * Auto-create it, if it does not exist, yet.  NODES gets sorted and
+ * duplicates will be removed from it. */
+static dfa_state_t *
+get_dfa_state(lookup_state_t *state,
+              apr_array_header_t *nodes)
+{
+  dfa_state_t *dfa_state;
+  int i, count;
+
+  /* Bring NODES into canonical form. */
+  svn_sort__array(nodes, compare_node_address);
+  for (i = 0, count = 0; i < nodes->nelts; ++i)
+    {
+      node_t *node = APR_ARRAY_IDX(nodes, i, node_t *);
+      if (count == 0 || APR_ARRAY_IDX(nodes, count - 1, node_t *) != node)
+        APR_ARRAY_IDX(nodes, count++, node_t *) = node;
+    }
+  nodes->nelts = count;
+
+  dfa_state = apr_hash_get(state->dfa_states, nodes->elts,
+                           count * sizeof(node_t *));
+  if (dfa_state)
+    return dfa_state;
+
+  dfa_state = apr_pcalloc(state->dfa_pool, sizeof(*dfa_state));
+  dfa_state->nodes = apr_array_copy(state->dfa_pool, nodes);
+  dfa_state->transitions = svn_hash__make(state->dfa_pool);
+
+  /* These init values ensure that the first node's value will be used
+   * when combined with them.  If there is no node, the sequence number
+   * remains unset and the parent's (i.e. inherited) rights will apply. */
+  dfa_state->rights.access.sequence_number = NO_SEQUENCE_NUMBER;
+  dfa_state->rights.access.rights = authz_access_none;
+  dfa_state->rights.min_rights = authz_access_write;
+  dfa_state->rights.max_rights = authz_access_none;
+
+  for (i = 0; i < count; ++i)
+    {
+      node_t *node = APR_ARRAY_IDX(nodes, i, node_t *);
+
+      /* The rule with the highest sequence number is the one that applies.
+       * Not all nodes that we are following have rules that apply directly
+       * to this path but are mere intermediates that may only have some
+       * matching deep sub-node. */
+      combine_access(&dfa_state->rights, &node->rights);
+
+      /* The rule tree node can be seen as an overlay of all the nodes that
+       * we are following.  Any of them _may_ match eventually, so the min/
+       * max possible access rights are a combination of all these
+       * sub-trees. */
+      combine_right_limits(&dfa_state->rights, &node->rights);
+    }
+
+  apr_hash_set(state->dfa_states, dfa_state->nodes->elts,
+               count * sizeof(node_t *), dfa_state);
+
+  return dfa_state;
+}
+
 /* Clear the current contents of STATE and re-initialize it for ROOT.
  * Check whether we can reuse a previous parent path lookup to shorten
  * the current PATH walk.  Return the full or remaining portion of
@@ -1028,6 +1206,11 @@ init_lockup_state(lookup_state_t *state,
                   const char *path)
 {
   apr_size_t len = strlen(path);
+
+  /* Don't let the automaton grow indefinitely. */
+  if (state->dfa_transitions >= DFA_MAX_TRANSITIONS)
+    reset_dfa(state);
+
   if (   (len > state->parent_path->len)
       && state->parent_path->len
       && (path[state->parent_path->len] == '/')
@@ -1043,23 +1226,23 @@ init_lockup_state(lookup_state_t *state,
     }
 
   /* Start lookup at ROOT for the full PATH. */
-  state->rights = root->rights;
-  state->parent_rights = root->rights;
+  if (!state->dfa_root)
+    {
+      apr_array_clear(state->next);
+      APR_ARRAY_PUSH(state->next, node_t *) = root;
 
-  apr_array_clear(state->next);
-  apr_array_clear(state->current);
-  APR_ARRAY_PUSH(state->current, node_t *) = root;
+      /* Var-segment rules match empty segments as well.
+       * This is non-recursive due to ACL normalization. */
+      if (root->pattern_sub_nodes && root->pattern_sub_nodes->any_var)
+        APR_ARRAY_PUSH(state->next, node_t *)
+          = root->pattern_sub_nodes->any_var;
 
-  /* Var-segment rules match empty segments as well */
-  if (root->pattern_sub_nodes && root->pattern_sub_nodes->any_var)
-   {
-      node_t *node = root->pattern_sub_nodes->any_var;
+      state->dfa_root = get_dfa_state(state, state->next);
+    }
 
-      /* This is non-recursive due to ACL normalization. */
-      combine_access(&state->rights, &node->rights);
-      combine_right_limits(&state->rights, &node->rights);
-      APR_ARRAY_PUSH(state->current, node_t *) = node;
-   }
+  state->current = state->dfa_root;
+  state->rights = state->dfa_root->rights;
+  state->parent_rights = root->rights;
 
   svn_stringbuf_setempty(state->parent_path);
   svn_stringbuf_setempty(state->scratch_pad);
@@ -1068,8 +1251,8 @@ init_lockup_state(lookup_state_t *state,
 }
 
 /* Add NODE to the list of NEXT nodes in STATE.  NODE may be NULL in which
- * case this is a no-op.  Also update and aggregate the access rights data
- * for the next path segment.
+ * case this is a no-op.  The access rights get aggregated once the list
+ * is complete, see get_dfa_state().
  */
 static void
 add_next_node(lookup_state_t *state,
@@ -1078,32 +1261,15 @@ add_next_node(lookup_state_t *state,
   /* Allowing NULL nodes simplifies the caller. */
   if (node)
     {
-      /* The rule with the highest sequence number is the one that applies.
-       * Not all nodes that we are following have rules that apply directly
-       * to this path but are mere intermediates that may only have some
-       * matching deep sub-node. */
-      combine_access(&state->rights, &node->rights);
-
-      /* The rule tree node can be seen as an overlay of all the nodes that
-       * we are following.  Any of them _may_ match eventually, so the min/
-       * max possible access rights are a combination of all these sub-trees.
-       */
-      combine_right_limits(&state->rights, &node->rights);
-
       /* NODE is now enlisted as a (potential) match for the next segment. */
       APR_ARRAY_PUSH(state->next, node_t *) = node;
 
       /* Variable length sub-segment sequences apply to the same node as
-       * they match empty sequences as well. */
+       * they match empty sequences as well.
+       * This is non-recursive due to ACL normalization. */
       if (node->pattern_sub_nodes && node->pattern_sub_nodes->any_var)
-        {
-          node = node->pattern_sub_nodes->any_var;
-
-          /* This is non-recursive due to ACL normalization. */
-          combine_access(&state->rights, &node->rights);
-          combine_right_limits(&state->rights, &node->rights);
-          APR_ARRAY_PUSH(state->next, node_t *) = node;
-        }
+        APR_ARRAY_PUSH(state->next, node_t *)
+          = node->pattern_sub_nodes->any_var;
     }
 }
 
@@ -1171,6 +1337,81 @@ add_complex_matches(lookup_state_t *state,
     }
 }
 
+/* Return the automaton state in STATE that follows CURRENT for the path
+ * SEGMENT.  Determine and memoize the transition, if it has not been taken
+ * before.
+ */
+static dfa_state_t *
+next_dfa_state(lookup_state_t *state,
+               dfa_state_t *current,
+               const svn_stringbuf_t *segment)
+{
+  dfa_state_t *next;
+  svn_boolean_t reversed = FALSE;
+  int i;
+
+  next = apr_hash_get(current->transitions, segment->data, segment->len);
+  if (next)
+    return next;
+
+  /* Scan follow all alternative routes to the next level. */
+  apr_array_clear(state->next);
+  for (i = 0; i < current->nodes->nelts; ++i)
+    {
+      node_t *node = APR_ARRAY_IDX(current->nodes, i, node_t *);
+      if (node->sub_nodes)
+        add_next_node(state, apr_hash_get(node->sub_nodes, segment->data,
+                                          segment->len));
+
+      /* Process alternative, wildcard-based sub-nodes. */
+      if (node->pattern_sub_nodes)
+        {
+          add_next_node(state, node->pattern_sub_nodes->any);
+
+          /* If the current node represents a "**" pattern, it matches
+           * to all levels. So, add it to the list for the NEXT level. */
+          if (node->pattern_sub_nodes->repeat)
+            add_next_node(state, node);
+
+          /* Find all prefix pattern matches. */
+          if (node->pattern_sub_nodes->prefixes)
+            add_prefix_matches(state, segment,
+                               node->pattern_sub_nodes->prefixes);
+
+          if (node->pattern_sub_nodes->complex)
+            add_complex_matches(state, segment,
+                                node->pattern_sub_nodes->complex);
+
+          /* Find all suffux pattern matches.  Suffixes behave like
+           * reversed prefixes.  Reverse a copy of SEGMENT such that later
+           * nodes still see the original. */
+          if (node->pattern_sub_nodes->suffixes)
+            {
+              if (!reversed)
+                {
+                  svn_stringbuf_setempty(state->reversed);
+                  svn_stringbuf_appendbytes(state->reversed, segment->data,
+                                            segment->len);
+                  svn_authz__reverse_string(state->reversed->data,
+                                            state->reversed->len);
+                  reversed = TRUE;
+                }
+
+              add_prefix_matches(state, state->reversed,
+                                 node->pattern_sub_nodes->suffixes);
+            }
+        }
+    }
+
+  next = get_dfa_state(state, state->next);
+  apr_hash_set(current->transitions,
+               apr_pstrmemdup(state->dfa_pool, segment->data, segment->len),
+               segment->len, next);
+  ++state->dfa_transitions;
+
+  return next;
+}
+
 /* Extract the next segment from PATH and copy it into SEGMENT, whose current
  * contents get overwritten.  Empty paths ("") are supported and leading '/'
  * segment separators will be interpreted as an empty segment ("").  Non-
@@ -1257,10 +1498,9 @@ lookup(lookup_state_t *state,
 
   /* Actually walk the path rule tree following PATH until we run out of
    * either tree or PATH. */
-  while (state->current->nelts && path)
+  while (state->current->nodes->nelts && path)
     {
-      apr_array_header_t *temp;
-      int i;
+      dfa_state_t *next;
       svn_stringbuf_t *segment = state->scratch_pad;
 
       /* Shortcut 1: We could nowhere find enough rights in this sub-tree. */
@@ -1274,18 +1514,6 @@ lookup(lookup_state_t *state,
       /* Extract the next segment. */
       path = next_segment(segment, path);
 
-      /* Initial state for this segment. */
-      apr_array_clear(state->next);
-      state->rights.access.sequence_number = NO_SEQUENCE_NUMBER;
-      state->rights.access.rights = authz_access_none;
-
-      /* These init values ensure that the first node's value will be used
-       * when combined with them.  If there is no first node,
-       * state->access.sequence_number remains unchanged and we will use
-       * the parent's (i.e. inherited) access rights. */
-      state->rights.min_rights = authz_access_write;
-      state->rights.max_rights = authz_access_none;
-
       /* Update the PARENT_PATH member in STATE to match the nodes in
        * CURRENT at the end of this iteration, i.e. if and when NEXT
        * has become CURRENT. */
@@ -1296,44 +1524,9 @@ lookup(lookup_state_t *state,
                                     segment->len);
         }
 
-      /* Scan follow all alternative routes to the next level. */
-      for (i = 0; i < state->current->nelts; ++i)
-        {
-          node_t *node = APR_ARRAY_IDX(state->current, i, node_t *);
-          if (node->sub_nodes)
-            add_next_node(state, apr_hash_get(node->sub_nodes, segment->data,
-                                              segment->len));
-
-          /* Process alternative, wildcard-based sub-nodes. */
-          if (node->pattern_sub_nodes)
-            {
-              add_next_node(state, node->pattern_sub_nodes->any);
-
-              /* If the current node represents a "**" pattern, it matches
-               * to all levels. So, add it to the list for the NEXT level. */
-              if (node->pattern_sub_nodes->repeat)
-                add_next_node(state, node);
-
-              /* Find all prefix pattern matches. */
-              if (node->pattern_sub_nodes->prefixes)
-                add_prefix_matches(state, segment,
-                                   node->pattern_sub_nodes->prefixes);
-
-              if (node->pattern_sub_nodes->complex)
-                add_complex_matches(state, segment,
-                                    node->pattern_sub_nodes->complex);
-
-              /* Find all suffux pattern matches.
-               * This must be the last check as it destroys SEGMENT. */
-              if (node->pattern_sub_nodes->suffixes)
-                {
-                  /* Suffixes behave like reversed prefixes. */
-                  svn_authz__reverse_string(segment->data, segment->len);
-                  add_prefix_matches(state, segment,
-                                     node->pattern_sub_nodes->suffixes);
-                }
-            }
-        }
+      /* Follow all alternative routes to the next level at once. */
+      next = next_dfa_state(state, state->current, segment);
+      state->rights = next->rights;
 
       /* If no rule applied to this SEGMENT directly, the parent rights
        * will apply to at least the SEGMENT node itself and possibly
@@ -1345,17 +1538,15 @@ lookup(lookup_state_t *state,
           state->rights.max_rights |= state->parent_rights.access.rights;
         }
 
-      /* The list of nodes for SEGMENT is now complete.  If we need to
-       * continue, make it the current and put the old one into the recycler.
+      /* The state for SEGMENT is now complete.  If we need to continue,
+       * make it the current one.
        *
        * If this is the end of the path, keep the parent path and rights in
        * STATE as are such that sibling lookups will benefit from it.
        */
       if (path)
         {
-          temp = state->current;
-          state->current = state->next;
-          state->next = temp;
+          state->current = next;
 
           /* In STATE, PARENT_PATH, PARENT_RIGHTS and CURRENT are now in sync. */
           state->parent_rights = state->rights;
@@ -1478,11 +1669,13 @@ filter_tree(svn_authz_t *authz,
   const char *repos_name = authz->filtered->repository;
   const char *user = authz->filtered->user;
   node_t *root;
+  apr_array_header_t *acls = collect_repos_acls(authz->full, repos_name,
+                                                scratch_pool);
 
-  if (filtered_pool)
+  /* Only models read through authz_read() are known to the AUTHZ_POOL. */
+  if (filtered_pool && authz->authz_id)
     {
-      svn_membuf_t *key = construct_filtered_key(repos_name, user,
-                                                 authz->authz_id,
+      svn_membuf_t *key = construct_filtered_key(acls, repos_name, user,
                                                  scratch_pool);
 
       /* Cache lookup. */
@@ -1508,7 +1701,7 @@ filter_tree(svn_authz_t *authz,
           SVN_ERR_ASSERT(add_ref == authz->full);
 
           /* Now construct the new filtered tree and cache it. */
-          root = create_user_authz(authz->full, repos_name, user, item_pool,
+          root = create_user_authz(acls, repos_name, user, item_pool,
                                    scratch_pool);
           svn_error_clear(svn_object_pool__insert((void **)&root,
                                                   filtered_pool, key, root,
@@ -1517,7 +1710,7 @@ filter_tree(svn_authz_t *authz,
      }
   else
     {
-      root = create_user_authz(authz->full, repos_name, user, pool,
+      root = create_user_authz(acls, repos_name, user, pool,
                                scratch_pool);
     }
 
@@ -1736,3 +1929,179 @@ svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_repos_authz_check_children(svn_authz_t *authz,
+                               const char *repos_name,
+                               const char *parent_path,
+                               const apr_array_header_t *names,
+                               const char *user,
+                               svn_repos_authz_access_t required_access,
+                               svn_boolean_t *access_granted,
+                               apr_pool_t *pool)
+{
+  const authz_access_t required =
+    ((required_access & svn_authz_read ? authz_access_read_flag : 0)
+     | (required_access & svn_authz_write ? authz_access_write_flag : 0));
+  svn_boolean_t recursive = !!(required_access & svn_authz_recursive);
+  svn_stringbuf_t *child_path;
+  apr_size_t parent_len;
+  int i;
+
+  /* Pick or create the suitable pre-filtered path rule tree. */
+  authz_user_rules_t *rules = get_user_rules(
+      authz,
+      (repos_name ? repos_name : AUTHZ_ANY_REPOSITORY),
+      user);
+
+  /* Uniform access to the repository applies to all children alike. */
+  if (   ((rules->global_rights.min_access & required) == required)
+      || ((rules->global_rights.max_access & required) != required))
+    {
+      svn_boolean_t granted
+        = ((rules->global_rights.min_access & required) == required);
+
+      for (i = 0; i < names->nelts; ++i)
+        access_granted[i] = granted;
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Did we already filter the data model? */
+  if (!rules->root)
+    SVN_ERR(filter_tree(authz, pool));
+
+  /* Sanity check. */
+  SVN_ERR_ASSERT(parent_path[0] == '/');
+
+  /* Strip trailing '/' such that we can simply append the child names. */
+  child_path = svn_stringbuf_create(parent_path, pool);
+  while (child_path->len && child_path->data[child_path->len - 1] == '/')
+    svn_stringbuf_chop(child_path, 1);
+  parent_len = child_path->len;
+
+  /* The first lookup walks PARENT_PATH and leaves the lookup state at the
+   * parent.  All following lookups resume from there and only need to
+   * take a single step each. */
+  for (i = 0; i < names->nelts; ++i)
+    {
+      const char *name = APR_ARRAY_IDX(names, i, const char *);
+      const char *path;
+
+      svn_stringbuf_chop(child_path, child_path->len - parent_len);
+      svn_stringbuf_appendbyte(child_path, '/');
+      svn_stringbuf_appendcstr(child_path, name);
+
+      path = init_lockup_state(rules->lookup_state, rules->root,
+                               child_path->data);
+      access_granted[i] = lookup(rules->lookup_state, path, required,
+                                 recursive, pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton type for authz_read_cb(). */
+typedef struct authz_read_baton_t
+{
+  svn_authz_t *authz;
+  const char *repos_name;
+  const char *user;
+} authz_read_baton_t;
+
+/* Implements svn_repos_authz_func_t, checking read access for the rules
+ * given by the authz_read_baton_t in BATON.  ROOT is not used. */
+static svn_error_t *
+authz_read_cb(svn_boolean_t *allowed,
+              svn_fs_root_t *root,
+              const char *path,
+              void *baton,
+              apr_pool_t *pool)
+{
+  authz_read_baton_t *b = baton;
+
+  /* Callers may pass relative paths. */
+  if (path && *path != '/')
+    path = svn_fspath__canonicalize(path, pool);
+
+  return svn_error_trace(svn_repos_authz_check_access(b->authz,
+                                                      b->repos_name,
+                                                      path, b->user,
+                                                      svn_authz_read,
+                                                      allowed, pool));
+}
+
+void
+svn_repos__authz_read_func_create(svn_repos_authz_func_t *authz_read_func,
+                                  void **authz_read_baton,
+                                  svn_authz_t *authz,
+                                  const char *repos_name,
+                                  const char *user,
+                                  apr_pool_t *result_pool)
+{
+  authz_read_baton_t *b = apr_pcalloc(result_pool, sizeof(*b));
+  b->authz = authz;
+  b->repos_name = repos_name;
+  b->user = user;
+
+  *authz_read_func = authz_read_cb;
+  *authz_read_baton = b;
+}
+
+svn_boolean_t
+svn_repos__authz_read_func_is_batched(svn_repos_authz_func_t authz_read_func)
+{
+  return authz_read_func == authz_read_cb;
+}
+
+svn_error_t *
+svn_repos__authz_read_children(svn_boolean_t *allowed,
+                               svn_fs_root_t *root,
+                               const char *parent_path,
+                               const apr_array_header_t *names,
+                               svn_repos_authz_func_t authz_read_func,
+                               void *authz_read_baton,
+                               apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  const char *separator;
+  int i;
+
+  /* Our own callback lets us check all children at once. */
+  if (svn_repos__authz_read_func_is_batched(authz_read_func))
+    {
+      authz_read_baton_t *b = authz_read_baton;
+
+      if (*parent_path != '/')
+        parent_path = svn_fspath__canonicalize(parent_path, scratch_pool);
+
+      return svn_error_trace(svn_repos_authz_check_children(b->authz,
+                                                            b->repos_name,
+                                                            parent_path,
+                                                            names, b->user,
+                                                            svn_authz_read,
+                                                            allowed,
+                                                            scratch_pool));
+    }
+
+  /* Pass the same child paths as svn_fspath__join() or svn_dirent_join()
+   * would produce. */
+  separator = (*parent_path && parent_path[strlen(parent_path) - 1] != '/')
+            ? "/"
+            : "";
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < names->nelts; ++i)
+    {
+      const char *name = APR_ARRAY_IDX(names, i, const char *);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(authz_read_func(&allowed[i], root,
+                              apr_pstrcat(iterpool, parent_path, separator,
+                                          name, SVN_VA_NULL),
+                              authz_read_baton, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
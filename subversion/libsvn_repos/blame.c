@@ -0,0 +1,434 @@
+/* blame.c : server-side line annotations
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_pools.h>
+
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_diff.h"
+#include "svn_fs.h"
+#include "svn_repos.h"
+
+#include "private/svn_cache.h"
+#include "svn_private_config.h"
+
+#include "repos.h"
+
+
+
+/* A "line map" is an array of svn_revnum_t, containing the revision that
+ * last changed the respective line of a file.  Line maps only depend on
+ * the history of the file, so they can be cached for any location in
+ * that history and be reused to blame later locations incrementally. */
+
+/* A location in the history of the file being blamed. */
+typedef struct blame_location_t
+{
+  const char *path;
+  svn_revnum_t revision;
+} blame_location_t;
+
+/* Baton for the line map building svn_diff_output_fns_t. */
+typedef struct line_map_baton_t
+{
+  /* Line map for the original text. */
+  const apr_array_header_t *original;
+
+  /* Line map being built for the modified text. */
+  apr_array_header_t *modified;
+
+  /* Revision to assign to all modified lines. */
+  svn_revnum_t revision;
+} line_map_baton_t;
+
+/* Implements svn_diff_output_fns_t.output_common. */
+static svn_error_t *
+output_common(void *baton,
+              apr_off_t original_start,
+              apr_off_t original_length,
+              apr_off_t modified_start,
+              apr_off_t modified_length,
+              apr_off_t latest_start,
+              apr_off_t latest_length)
+{
+  line_map_baton_t *b = baton;
+  apr_off_t i;
+
+  for (i = 0; i < original_length; ++i)
+    APR_ARRAY_PUSH(b->modified, svn_revnum_t)
+      = APR_ARRAY_IDX(b->original, original_start + i, svn_revnum_t);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_diff_output_fns_t.output_diff_modified. */
+static svn_error_t *
+output_diff_modified(void *baton,
+                     apr_off_t original_start,
+                     apr_off_t original_length,
+                     apr_off_t modified_start,
+                     apr_off_t modified_length,
+                     apr_off_t latest_start,
+                     apr_off_t latest_length)
+{
+  line_map_baton_t *b = baton;
+  apr_off_t i;
+
+  for (i = 0; i < modified_length; ++i)
+    APR_ARRAY_PUSH(b->modified, svn_revnum_t) = b->revision;
+
+  return SVN_NO_ERROR;
+}
+
+/* Two-way diffs only use the first two output functions. */
+static const svn_diff_output_fns_t line_map_fns =
+{
+  output_common,
+  output_diff_modified,
+  NULL,
+  NULL,
+  NULL
+};
+
+/* Implements svn_cache__serialize_func_t for line maps. */
+static svn_error_t *
+serialize_line_map(void **data,
+                   apr_size_t *data_len,
+                   void *in,
+                   apr_pool_t *pool)
+{
+  apr_array_header_t *line_map = in;
+
+  *data_len = line_map->nelts * sizeof(svn_revnum_t);
+  *data = apr_pmemdup(pool, line_map->elts, *data_len);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__deserialize_func_t for line maps. */
+static svn_error_t *
+deserialize_line_map(void **out,
+                     void *data,
+                     apr_size_t data_len,
+                     apr_pool_t *pool)
+{
+  apr_array_header_t *line_map = apr_array_make(pool, 0,
+                                                sizeof(svn_revnum_t));
+
+  line_map->elts = data;
+  line_map->nelts = (int)(data_len / sizeof(svn_revnum_t));
+  line_map->nalloc = line_map->nelts;
+  *out = line_map;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *CACHE to a line map cache for FS, allocated in RESULT_POOL.  Set it
+ * to NULL if there is no global membuffer cache.  Use SCRATCH_POOL for
+ * temporary allocations. */
+static svn_error_t *
+create_line_map_cache(svn_cache__t **cache,
+                      svn_fs_t *fs,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  const char *uuid;
+  const char *prefix;
+
+  *cache = NULL;
+  if (!membuffer)
+    return SVN_NO_ERROR;
+
+  /* Line maps of different repositories must never be mixed. */
+  SVN_ERR(svn_fs_get_uuid(fs, &uuid, scratch_pool));
+  prefix = apr_pstrcat(scratch_pool, "repos-blame:", uuid, "/",
+                       svn_fs_path(fs, scratch_pool), ":", SVN_VA_NULL);
+
+  return svn_error_trace(svn_cache__create_membuffer_cache(
+                           cache, membuffer,
+                           serialize_line_map, deserialize_line_map,
+                           APR_HASH_KEY_STRING, prefix,
+                           SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                           TRUE, FALSE, result_pool, scratch_pool));
+}
+
+/* Return the cache key for LOCATION, allocated in RESULT_POOL. */
+static const char *
+line_map_key(const blame_location_t *location,
+             apr_pool_t *result_pool)
+{
+  return apr_psprintf(result_pool, "%ld:%s", location->revision,
+                      location->path);
+}
+
+/* Read the contents of the file at LOCATION in FS into *TEXT, allocated
+ * in RESULT_POOL.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_text(svn_string_t **text,
+          svn_fs_t *fs,
+          const blame_location_t *location,
+          apr_pool_t *result_pool,
+          apr_pool_t *scratch_pool)
+{
+  svn_fs_root_t *root;
+  svn_stream_t *stream;
+  svn_filesize_t size;
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, location->revision, scratch_pool));
+  SVN_ERR(svn_fs_file_length(&size, root, location->path, scratch_pool));
+  SVN_ERR(svn_fs_file_contents(&stream, root, location->path, scratch_pool));
+
+  return svn_error_trace(svn_string_from_stream2(text, stream,
+                                                 (apr_size_t)size,
+                                                 result_pool));
+}
+
+/* Set *CHANGED if the contents of the files at LHS and RHS in FS differ.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+contents_changed(svn_boolean_t *changed,
+                 svn_fs_t *fs,
+                 const blame_location_t *lhs,
+                 const blame_location_t *rhs,
+                 apr_pool_t *scratch_pool)
+{
+  svn_fs_root_t *lhs_root, *rhs_root;
+
+  SVN_ERR(svn_fs_revision_root(&lhs_root, fs, lhs->revision, scratch_pool));
+  SVN_ERR(svn_fs_revision_root(&rhs_root, fs, rhs->revision, scratch_pool));
+
+  return svn_error_trace(svn_fs_contents_different(changed,
+                                                   lhs_root, lhs->path,
+                                                   rhs_root, rhs->path,
+                                                   scratch_pool));
+}
+
+svn_error_t *
+svn_repos_blame(svn_repos_t *repos,
+                const char *path,
+                svn_revnum_t start,
+                svn_revnum_t end,
+                svn_repos_authz_func_t authz_read_func,
+                void *authz_read_baton,
+                svn_repos_blame_receiver_t receiver,
+                void *receiver_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  apr_array_header_t *locations
+    = apr_array_make(scratch_pool, 16, sizeof(blame_location_t));
+  apr_array_header_t *line_map = NULL;
+  svn_string_t *text = NULL;
+  svn_cache__t *cache;
+  svn_fs_history_t *history;
+  svn_fs_root_t *root;
+  svn_node_kind_t kind;
+  svn_boolean_t complete = TRUE;
+  apr_pool_t *oldpool = svn_pool_create(scratch_pool);
+  apr_pool_t *newpool = svn_pool_create(scratch_pool);
+  apr_pool_t *iterpool, *textpool, *lastpool, *tmppool;
+  int i, cached_index = -1;
+
+  if (!SVN_IS_VALID_REVNUM(start) || !SVN_IS_VALID_REVNUM(end)
+      || start > end)
+    return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                             _("Invalid revision range %ld:%ld for blame"),
+                             start, end);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, end, scratch_pool));
+  SVN_ERR(svn_fs_check_path(&kind, root, path, scratch_pool));
+  if (kind != svn_node_file)
+    return svn_error_createf(SVN_ERR_FS_NOT_FILE, NULL,
+                             _("'%s' is not a file in revision %ld"),
+                             path, end);
+
+  SVN_ERR(create_line_map_cache(&cache, fs, scratch_pool, scratch_pool));
+
+  /* Collect the history of PATH, youngest first.  Stop at the first
+   * location for which we have a cached line map.  The history below an
+   * unreadable location must not contribute to the result; so, if there
+   * are authz restrictions, find that location first. */
+  SVN_ERR(svn_fs_node_history2(&history, root, path, oldpool, oldpool));
+  while (1)
+    {
+      blame_location_t location;
+      svn_boolean_t found;
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(svn_fs_history_prev2(&history, history, TRUE, newpool,
+                                   oldpool));
+      if (!history)
+        break;
+
+      SVN_ERR(svn_fs_history_location(&location.path, &location.revision,
+                                      history, newpool));
+      if (authz_read_func)
+        {
+          svn_fs_root_t *history_root;
+          svn_boolean_t readable;
+
+          SVN_ERR(svn_fs_revision_root(&history_root, fs,
+                                       location.revision, newpool));
+          SVN_ERR(authz_read_func(&readable, history_root, location.path,
+                                  authz_read_baton, newpool));
+          if (!readable)
+            {
+              complete = FALSE;
+              break;
+            }
+        }
+
+      location.path = apr_pstrdup(scratch_pool, location.path);
+      APR_ARRAY_PUSH(locations, blame_location_t) = location;
+
+      if (cache && cached_index < 0)
+        {
+          void *value;
+
+          SVN_ERR(svn_cache__get(&value, &found, cache,
+                                 line_map_key(&location, newpool),
+                                 scratch_pool));
+          if (found)
+            {
+              line_map = value;
+              cached_index = locations->nelts - 1;
+
+              /* Without authz restrictions, older history is irrelevant. */
+              if (!authz_read_func)
+                break;
+            }
+        }
+
+      svn_pool_clear(oldpool);
+      tmppool = oldpool;
+      oldpool = newpool;
+      newpool = tmppool;
+    }
+
+  svn_pool_destroy(oldpool);
+  svn_pool_destroy(newpool);
+
+  if (locations->nelts == 0)
+    return svn_error_createf(SVN_ERR_AUTHZ_UNREADABLE, NULL,
+                             _("Unreadable path encountered; access denied"));
+
+  /* Line maps computed from a truncated history are specific to the
+   * current user and must neither be used nor cached. */
+  if (!complete)
+    {
+      line_map = NULL;
+      cached_index = -1;
+      cache = NULL;
+    }
+
+  /* Replay the history, oldest first, starting after the cached state. */
+  if (line_map)
+    {
+      SVN_ERR(read_text(&text, fs,
+                        &APR_ARRAY_IDX(locations, cached_index,
+                                       blame_location_t),
+                        scratch_pool, scratch_pool));
+      i = cached_index - 1;
+    }
+  else
+    {
+      text = svn_string_create_empty(scratch_pool);
+      line_map = apr_array_make(scratch_pool, 0, sizeof(svn_revnum_t));
+      i = locations->nelts - 1;
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+  textpool = svn_pool_create(scratch_pool);
+  lastpool = svn_pool_create(scratch_pool);
+  for (; i >= 0; --i)
+    {
+      const blame_location_t *location
+        = &APR_ARRAY_IDX(locations, i, blame_location_t);
+      svn_boolean_t changed = TRUE;
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      /* Property changes and plain copies don't touch any lines. */
+      if (i + 1 < locations->nelts)
+        SVN_ERR(contents_changed(&changed, fs, location,
+                                 &APR_ARRAY_IDX(locations, i + 1,
+                                                blame_location_t),
+                                 iterpool));
+
+      if (changed)
+        {
+          svn_diff_t *diff;
+          line_map_baton_t baton;
+          svn_string_t *new_text;
+
+          SVN_ERR(read_text(&new_text, fs, location, textpool, iterpool));
+          SVN_ERR(svn_diff_mem_string_diff(&diff, text, new_text,
+                                           svn_diff_file_options_create(
+                                             iterpool),
+                                           iterpool));
+
+          baton.original = line_map;
+          baton.modified = apr_array_make(textpool, line_map->nelts,
+                                          sizeof(svn_revnum_t));
+          baton.revision = location->revision;
+          SVN_ERR(svn_diff_output2(diff, &baton, &line_map_fns,
+                                   cancel_func, cancel_baton));
+
+          text = new_text;
+          line_map = baton.modified;
+
+          /* The previous text and line map are no longer needed. */
+          svn_pool_clear(lastpool);
+          tmppool = lastpool;
+          lastpool = textpool;
+          textpool = tmppool;
+        }
+
+      if (cache)
+        SVN_ERR(svn_cache__set(cache, line_map_key(location, iterpool),
+                               line_map, iterpool));
+    }
+
+  /* Report the result.  Lines last changed before START are reported
+   * without a revision. */
+  for (i = 0; i < line_map->nelts; ++i)
+    {
+      svn_revnum_t revision = APR_ARRAY_IDX(line_map, i, svn_revnum_t);
+
+      svn_pool_clear(iterpool);
+      if (revision < start)
+        revision = SVN_INVALID_REVNUM;
+
+      SVN_ERR(receiver(receiver_baton, i, revision, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
@@ -231,6 +231,24 @@ svn_repos_upgrade(const char *path,
   return svn_repos_upgrade2(path, nonblocking, recovery_started, &rb, pool);
 }
 
+svn_error_t *
+svn_repos_hotcopy3(const char *src_path,
+                   const char *dst_path,
+                   svn_boolean_t clean_logs,
+                   svn_boolean_t incremental,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_repos_hotcopy4(src_path, dst_path, clean_logs,
+                                            incremental, NULL,
+                                            notify_func, notify_baton,
+                                            cancel_func, cancel_baton,
+                                            scratch_pool));
+}
+
 svn_error_t *
 svn_repos_hotcopy2(const char *src_path,
                    const char *dst_path,
@@ -677,6 +695,31 @@ svn_repos_get_file_revs(svn_repos_t *repos,
                                   handler2, handler2_baton, pool);
 }
 
+/*** From list.c ***/
+
+svn_error_t *
+svn_repos_list(svn_fs_root_t *root,
+               const char *path,
+               const apr_array_header_t *patterns,
+               svn_depth_t depth,
+               svn_boolean_t path_info_only,
+               svn_repos_authz_func_t authz_read_func,
+               void *authz_read_baton,
+               svn_repos_dirent_receiver_t receiver,
+               void *receiver_baton,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_repos_list2(root, path, patterns, depth,
+                                         path_info_only ? SVN_DIRENT_KIND
+                                                        : SVN_DIRENT_ALL,
+                                         authz_read_func, authz_read_baton,
+                                         receiver, receiver_baton,
+                                         cancel_func, cancel_baton,
+                                         scratch_pool));
+}
+
 /*** From dump.c ***/
 svn_error_t *
 svn_repos_dump_fs(svn_repos_t *repos,
@@ -37,6 +37,7 @@
 #include "svn_checksum.h"
 #include "svn_props.h"
 #include "svn_sorts.h"
+#include "svn_cache_config.h"
 
 #include "private/svn_repos_private.h"
 #include "private/svn_mergeinfo_private.h"
@@ -45,6 +46,9 @@
 #include "private/svn_utf_private.h"
 #include "private/svn_cache.h"
 #include "private/svn_fspath.h"
+#include "private/svn_subr_private.h"
+#include "private/svn_task.h"
+#include "repos.h"
 
 #define ARE_VALID_COPY_ARGS(p,r) ((p) && SVN_IS_VALID_REVNUM(r))
 
@@ -1993,6 +1997,303 @@ write_revision_record(svn_stream_t *stream,
   return SVN_NO_ERROR;
 }
 
+/* Dump revision REV of REPOS to STREAM, i.e. its revision record and,
+   if INCLUDE_CHANGES is set, its changes.  START_REV is the first revision
+   of the dump.  FOUND_OLD_REFERENCE, FOUND_OLD_MERGEINFO, NOTIFY_FUNC and
+   NOTIFY_BATON are passed to the dump editor.  All other parameters are
+   the same as for svn_repos_dump_fs4().  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+dump_revision(svn_stream_t *stream,
+              svn_repos_t *repos,
+              svn_revnum_t rev,
+              svn_revnum_t start_rev,
+              svn_boolean_t incremental,
+              svn_boolean_t use_deltas,
+              svn_boolean_t include_revprops,
+              svn_boolean_t include_changes,
+              svn_repos_authz_func_t authz_func,
+              void *authz_baton,
+              svn_boolean_t *found_old_reference,
+              svn_boolean_t *found_old_mergeinfo,
+              svn_repos_notify_func_t notify_func,
+              void *notify_baton,
+              apr_pool_t *scratch_pool)
+{
+  const svn_delta_editor_t *dump_editor;
+  void *dump_edit_baton = NULL;
+  svn_fs_t *fs = svn_repos_fs(repos);
+  svn_fs_root_t *to_root;
+  svn_boolean_t use_deltas_for_rev;
+
+  /* Write the revision record. */
+  SVN_ERR(write_revision_record(stream, repos, rev, include_revprops,
+                                authz_func, authz_baton, scratch_pool));
+
+  /* When dumping revision 0, we just write out the revision record.
+     The parser might want to use its properties.
+     If we don't want revision changes at all, skip in any case. */
+  if (rev == 0 || !include_changes)
+    return SVN_NO_ERROR;
+
+  /* Fetch the editor which dumps nodes to a file.  Regardless of
+     what we've been told, don't use deltas for the first rev of a
+     non-incremental dump. */
+  use_deltas_for_rev = use_deltas && (incremental || rev != start_rev);
+  SVN_ERR(get_dump_editor(&dump_editor, &dump_edit_baton, fs, rev,
+                          "", stream, found_old_reference,
+                          found_old_mergeinfo, NULL,
+                          notify_func, notify_baton,
+                          start_rev, use_deltas_for_rev, FALSE, FALSE,
+                          scratch_pool));
+
+  /* Drive the editor in one way or another. */
+  SVN_ERR(svn_fs_revision_root(&to_root, fs, rev, scratch_pool));
+
+  /* If this is the first revision of a non-incremental dump,
+     we're in for a full tree dump.  Otherwise, we want to simply
+     replay the revision.  */
+  if ((rev == start_rev) && (! incremental))
+    {
+      /* Compare against revision 0, so everything appears to be added. */
+      svn_fs_root_t *from_root;
+      SVN_ERR(svn_fs_revision_root(&from_root, fs, 0, scratch_pool));
+      SVN_ERR(svn_repos_dir_delta2(from_root, "", "",
+                                   to_root, "",
+                                   dump_editor, dump_edit_baton,
+                                   authz_func, authz_baton,
+                                   FALSE, /* don't send text-deltas */
+                                   svn_depth_infinity,
+                                   FALSE, /* don't send entry props */
+                                   FALSE, /* don't ignore ancestry */
+                                   scratch_pool));
+    }
+  else
+    {
+      /* The normal case: compare consecutive revs. */
+      SVN_ERR(svn_repos_replay2(to_root, "", SVN_INVALID_REVNUM, FALSE,
+                                dump_editor, dump_edit_baton,
+                                authz_func, authz_baton, scratch_pool));
+
+      /* While our editor close_edit implementation is a no-op, we still
+         do this for completeness. */
+      SVN_ERR(dump_editor->close_edit(dump_edit_baton, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Number of revisions that a worker thread dumps at a time. */
+#define DUMP_CHUNK_SIZE 8
+
+/* Dump output that worker threads keep in memory before spilling it
+   to a temporary file. */
+#define DUMP_CHUNK_MEMORY 0x100000
+
+/* Parameters of a concurrent dump, see svn_repos_dump_fs4(). */
+typedef struct dump_chunks_baton_t
+{
+  svn_repos_t *repos;
+  apr_hash_t *fs_config;
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+  svn_boolean_t incremental;
+  svn_boolean_t use_deltas;
+  svn_boolean_t include_revprops;
+  svn_boolean_t include_changes;
+  svn_repos_authz_func_t authz_func;
+  void *authz_baton;
+
+  /* Receive the notifications and warning flags in dump order. */
+  svn_repos_notify_func_t notify_func;
+  void *notify_baton;
+  svn_boolean_t *found_old_reference;
+  svn_boolean_t *found_old_mergeinfo;
+
+  /* Where the chunks get written to. */
+  svn_stream_t *stream;
+} dump_chunks_baton_t;
+
+/* A chunk of revisions dumped by a worker thread. */
+typedef struct dump_chunk_t
+{
+  /* The dump output. */
+  svn_spillbuf_t *output;
+
+  /* The svn_repos_notify_t * that would have been sent during the dump,
+     in order.  NULL if the caller does not want notifications. */
+  apr_array_header_t *notifications;
+
+  svn_boolean_t found_old_reference;
+  svn_boolean_t found_old_mergeinfo;
+} dump_chunk_t;
+
+/* Implements svn_repos_notify_func_t.
+   Append a copy of NOTIFY to the array of notifications of the
+   dump_chunk_t in BATON. */
+static void
+record_notification(void *baton,
+                    const svn_repos_notify_t *notify,
+                    apr_pool_t *scratch_pool)
+{
+  dump_chunk_t *chunk = baton;
+  apr_pool_t *pool = chunk->notifications->pool;
+  svn_repos_notify_t *copy = svn_repos_notify_create(notify->action, pool);
+
+  copy->revision = notify->revision;
+  copy->warning = notify->warning;
+  copy->warning_str = apr_pstrdup(pool, notify->warning_str);
+
+  APR_ARRAY_PUSH(chunk->notifications, svn_repos_notify_t *) = copy;
+}
+
+/* Implements svn_task__thread_context_constructor_t.
+   Open a separate instance of the repository of the dump_chunks_baton_t
+   in CONTEXT_BATON for the current worker thread. */
+static svn_error_t *
+open_worker_repos(void **thread_context,
+                  void *context_baton,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  dump_chunks_baton_t *baton = context_baton;
+  svn_repos_t *repos;
+
+  SVN_ERR(svn_repos_open3(&repos, svn_repos_path(baton->repos, scratch_pool),
+                          baton->fs_config, result_pool, scratch_pool));
+  *thread_context = repos;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.
+   Dump the revision chunk with the given INDEX of the dump described by
+   the dump_chunks_baton_t PROCESS_BATON, using the repository instance
+   in THREAD_CONTEXT, and return it as a dump_chunk_t in *RESULT. */
+static svn_error_t *
+dump_chunk(void **result,
+           int index,
+           void *process_baton,
+           void *thread_context,
+           svn_cancel_func_t cancel_func,
+           void *cancel_baton,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  dump_chunks_baton_t *baton = process_baton;
+  svn_repos_t *repos = thread_context;
+  dump_chunk_t *chunk = apr_pcalloc(result_pool, sizeof(*chunk));
+  svn_revnum_t first = baton->start_rev + (svn_revnum_t)index
+                                        * DUMP_CHUNK_SIZE;
+  svn_revnum_t last = MIN(first + DUMP_CHUNK_SIZE - 1, baton->end_rev);
+  svn_stream_t *stream;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t rev;
+
+  chunk->output = svn_spillbuf__create(SVN__STREAM_CHUNK_SIZE,
+                                       DUMP_CHUNK_MEMORY, result_pool);
+  stream = svn_stream__from_spillbuf(chunk->output, scratch_pool);
+  if (baton->notify_func)
+    chunk->notifications = apr_array_make(result_pool, DUMP_CHUNK_SIZE,
+                                          sizeof(svn_repos_notify_t *));
+
+  for (rev = first; rev <= last; rev++)
+    {
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(dump_revision(stream, repos, rev, baton->start_rev,
+                            baton->incremental, baton->use_deltas,
+                            baton->include_revprops, baton->include_changes,
+                            baton->authz_func, baton->authz_baton,
+                            &chunk->found_old_reference,
+                            &chunk->found_old_mergeinfo,
+                            chunk->notifications ? record_notification
+                                                 : NULL,
+                            chunk, iterpool));
+
+      if (chunk->notifications)
+        {
+          svn_repos_notify_t *notify
+            = svn_repos_notify_create(svn_repos_notify_dump_rev_end,
+                                      iterpool);
+
+          notify->revision = rev;
+          record_notification(chunk, notify, iterpool);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  *result = chunk;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.
+   Write the dump_chunk_t RESULT to the stream of the dump_chunks_baton_t
+   OUTPUT_BATON and send its notifications. */
+static svn_error_t *
+write_dump_chunk(void *result,
+                 int index,
+                 void *output_baton,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *scratch_pool)
+{
+  dump_chunks_baton_t *baton = output_baton;
+  dump_chunk_t *chunk = result;
+  int i;
+
+  SVN_ERR(svn_stream_copy3(svn_stream__from_spillbuf(chunk->output,
+                                                     scratch_pool),
+                           svn_stream_disown(baton->stream, scratch_pool),
+                           cancel_func, cancel_baton, scratch_pool));
+
+  if (chunk->found_old_reference)
+    *baton->found_old_reference = TRUE;
+  if (chunk->found_old_mergeinfo)
+    *baton->found_old_mergeinfo = TRUE;
+
+  if (chunk->notifications)
+    for (i = 0; i < chunk->notifications->nelts; i++)
+      baton->notify_func(baton->notify_baton,
+                         APR_ARRAY_IDX(chunk->notifications, i,
+                                       svn_repos_notify_t *),
+                         scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *JOBS to the number of worker threads to dump REPOS with and
+   *FS_CONFIG to the configuration to open the repository with in these
+   threads. */
+static svn_error_t *
+get_dump_jobs(int *jobs,
+              apr_hash_t **fs_config,
+              svn_repos_t *repos,
+              apr_pool_t *result_pool)
+{
+  *jobs = 1;
+  *fs_config = NULL;
+
+  /* Worker threads open their own instances of the repository and share
+     its caches with us. */
+  if (   strcmp(repos->fs_type, SVN_FS_TYPE_BDB) == 0
+      || svn_cache_config_get()->single_threaded)
+    return SVN_NO_ERROR;
+
+  *fs_config = svn_fs_config(repos->fs, result_pool);
+  if (*fs_config)
+    SVN_ERR(svn_cstring_atoi(jobs,
+                             svn_hash__get_cstring(*fs_config,
+                                                   SVN_REPOS_CONFIG_DUMP_JOBS,
+                                                   "1")));
+
+  return SVN_NO_ERROR;
+}
+
 /* Baton for dump_filter_authz_func(). */
 typedef struct dump_filter_baton_t
 {
@@ -2039,14 +2340,14 @@ svn_repos_dump_fs4(svn_repos_t *repos,
                    void *cancel_baton,
                    apr_pool_t *pool)
 {
-  const svn_delta_editor_t *dump_editor;
-  void *dump_edit_baton = NULL;
   svn_revnum_t rev;
   svn_fs_t *fs = svn_repos_fs(repos);
   apr_pool_t *iterpool = svn_pool_create(pool);
   svn_revnum_t youngest;
   const char *uuid;
   int version;
+  int jobs;
+  apr_hash_t *fs_config;
   svn_boolean_t found_old_reference = FALSE;
   svn_boolean_t found_old_mergeinfo = FALSE;
   svn_repos_notify_t *notify;
@@ -2108,82 +2409,65 @@ svn_repos_dump_fs4(svn_repos_t *repos,
   SVN_ERR(svn_repos__dump_magic_header_record(stream, version, pool));
   SVN_ERR(svn_repos__dump_uuid_header_record(stream, uuid, pool));
 
-  /* Create a notify object that we can reuse in the loop. */
-  if (notify_func)
-    notify = svn_repos_notify_create(svn_repos_notify_dump_rev_end,
-                                     pool);
+  SVN_ERR(get_dump_jobs(&jobs, &fs_config, repos, pool));
 
-  /* Main loop:  we're going to dump revision REV.  */
-  for (rev = start_rev; rev <= end_rev; rev++)
+  /* Let worker threads dump chunks of revisions into temporary buffers
+     and append them to STREAM in order. */
+  if (jobs > 1 && include_changes && end_rev - start_rev >= DUMP_CHUNK_SIZE)
     {
-      svn_fs_root_t *to_root;
-      svn_boolean_t use_deltas_for_rev;
+      dump_chunks_baton_t baton;
+
+      baton.repos = repos;
+      baton.fs_config = fs_config;
+      baton.start_rev = start_rev;
+      baton.end_rev = end_rev;
+      baton.incremental = incremental;
+      baton.use_deltas = use_deltas;
+      baton.include_revprops = include_revprops;
+      baton.include_changes = include_changes;
+      baton.authz_func = authz_func;
+      baton.authz_baton = &authz_baton;
+      baton.notify_func = notify_func;
+      baton.notify_baton = notify_baton;
+      baton.found_old_reference = &found_old_reference;
+      baton.found_old_mergeinfo = &found_old_mergeinfo;
+      baton.stream = stream;
+
+      SVN_ERR(svn_task__run(jobs,
+                            (int)((end_rev - start_rev) / DUMP_CHUNK_SIZE
+                                  + 1),
+                            dump_chunk, &baton,
+                            write_dump_chunk, &baton,
+                            open_worker_repos, &baton,
+                            cancel_func, cancel_baton, iterpool));
+    }
+  else
+    {
+      /* Create a notify object that we can reuse in the loop. */
+      if (notify_func)
+        notify = svn_repos_notify_create(svn_repos_notify_dump_rev_end,
+                                         pool);
 
-      svn_pool_clear(iterpool);
+      /* Main loop:  we're going to dump revision REV.  */
+      for (rev = start_rev; rev <= end_rev; rev++)
+        {
+          svn_pool_clear(iterpool);
 
-      /* Check for cancellation. */
-      if (cancel_func)
-        SVN_ERR(cancel_func(cancel_baton));
+          /* Check for cancellation. */
+          if (cancel_func)
+            SVN_ERR(cancel_func(cancel_baton));
 
-      /* Write the revision record. */
-      SVN_ERR(write_revision_record(stream, repos, rev, include_revprops,
-                                    authz_func, &authz_baton, iterpool));
-
-      /* When dumping revision 0, we just write out the revision record.
-         The parser might want to use its properties.
-         If we don't want revision changes at all, skip in any case. */
-      if (rev == 0 || !include_changes)
-        goto loop_end;
-
-      /* Fetch the editor which dumps nodes to a file.  Regardless of
-         what we've been told, don't use deltas for the first rev of a
-         non-incremental dump. */
-      use_deltas_for_rev = use_deltas && (incremental || rev != start_rev);
-      SVN_ERR(get_dump_editor(&dump_editor, &dump_edit_baton, fs, rev,
-                              "", stream, &found_old_reference,
-                              &found_old_mergeinfo, NULL,
-                              notify_func, notify_baton,
-                              start_rev, use_deltas_for_rev, FALSE, FALSE,
-                              iterpool));
-
-      /* Drive the editor in one way or another. */
-      SVN_ERR(svn_fs_revision_root(&to_root, fs, rev, iterpool));
-
-      /* If this is the first revision of a non-incremental dump,
-         we're in for a full tree dump.  Otherwise, we want to simply
-         replay the revision.  */
-      if ((rev == start_rev) && (! incremental))
-        {
-          /* Compare against revision 0, so everything appears to be added. */
-          svn_fs_root_t *from_root;
-          SVN_ERR(svn_fs_revision_root(&from_root, fs, 0, iterpool));
-          SVN_ERR(svn_repos_dir_delta2(from_root, "", "",
-                                       to_root, "",
-                                       dump_editor, dump_edit_baton,
-                                       authz_func, &authz_baton,
-                                       FALSE, /* don't send text-deltas */
-                                       svn_depth_infinity,
-                                       FALSE, /* don't send entry props */
-                                       FALSE, /* don't ignore ancestry */
-                                       iterpool));
-        }
-      else
-        {
-          /* The normal case: compare consecutive revs. */
-          SVN_ERR(svn_repos_replay2(to_root, "", SVN_INVALID_REVNUM, FALSE,
-                                    dump_editor, dump_edit_baton,
-                                    authz_func, &authz_baton, iterpool));
-
-          /* While our editor close_edit implementation is a no-op, we still
-             do this for completeness. */
-          SVN_ERR(dump_editor->close_edit(dump_edit_baton, iterpool));
-        }
+          SVN_ERR(dump_revision(stream, repos, rev, start_rev, incremental,
+                                use_deltas, include_revprops,
+                                include_changes, authz_func, &authz_baton,
+                                &found_old_reference, &found_old_mergeinfo,
+                                notify_func, notify_baton, iterpool));
 
-    loop_end:
-      if (notify_func)
-        {
-          notify->revision = rev;
-          notify_func(notify_baton, notify, iterpool);
+          if (notify_func)
+            {
+              notify->revision = rev;
+              notify_func(notify_baton, notify, iterpool);
+            }
         }
     }
 
@@ -36,7 +36,9 @@
 #include "svn_subst.h"
 #include "repos.h"
 #include "svn_private_config.h"
+#include "private/svn_cache.h"
 #include "private/svn_repos_private.h"
+#include "private/svn_skel.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_utf_private.h"
 #include "private/svn_fspath.h"
@@ -1045,10 +1047,217 @@ svn_repos_fs_pack2(svn_repos_t *repos,
   pnb.notify_func = notify_func;
   pnb.notify_baton = notify_baton;
 
-  return svn_fs_pack(repos->db_path,
-                     notify_func ? pack_notify_func : NULL,
-                     notify_func ? &pnb : NULL,
-                     cancel_func, cancel_baton, pool);
+  return svn_fs_pack2(repos->db_path, svn_fs_config(repos->fs, pool),
+                      notify_func ? pack_notify_func : NULL,
+                      notify_func ? &pnb : NULL,
+                      cancel_func, cancel_baton, pool);
+}
+
+/*** Inherited properties ***/
+
+/* The properties inherited from the parents of a path in a revision root
+ * never change.  They only depend on the parent directory, too, so all
+ * siblings inherit the same list.  We cache these lists per parent
+ * directory in the membuffer, which also allows deeper paths to reuse
+ * the list of their parent. */
+
+/* Implements svn_cache__serialize_func_t for depth-first ordered arrays
+ * of svn_prop_inherited_item_t *. */
+static svn_error_t *
+serialize_iprops(void **data,
+                 apr_size_t *data_len,
+                 void *in,
+                 apr_pool_t *pool)
+{
+  apr_array_header_t *iprops = in;
+  svn_skel_t *skel;
+  svn_stringbuf_t *buffer;
+
+  SVN_ERR(svn_skel__unparse_iproplist(&skel, iprops, pool, pool));
+  buffer = svn_skel__unparse(skel, pool);
+
+  *data = buffer->data;
+  *data_len = buffer->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__deserialize_func_t for depth-first ordered
+ * arrays of svn_prop_inherited_item_t *. */
+static svn_error_t *
+deserialize_iprops(void **out,
+                   void *data,
+                   apr_size_t data_len,
+                   apr_pool_t *pool)
+{
+  apr_array_header_t *iprops;
+  svn_skel_t *skel = svn_skel__parse(data, data_len, pool);
+
+  if (!skel)
+    return svn_error_create(SVN_ERR_FS_MALFORMED_SKEL, NULL,
+                            _("Malformed inherited properties in cache"));
+
+  SVN_ERR(svn_skel__parse_iprops(&iprops, skel, pool));
+  *out = iprops;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *CACHE to an inherited properties cache for FS, allocated in
+ * RESULT_POOL.  Set it to NULL if there is no global membuffer cache.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+create_iprops_cache(svn_cache__t **cache,
+                    svn_fs_t *fs,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  const char *uuid;
+  const char *prefix;
+
+  *cache = NULL;
+  if (!membuffer)
+    return SVN_NO_ERROR;
+
+  /* Properties of different repositories must never be mixed. */
+  SVN_ERR(svn_fs_get_uuid(fs, &uuid, scratch_pool));
+  prefix = apr_pstrcat(scratch_pool, "repos-iprops:", uuid, "/",
+                       svn_fs_path(fs, scratch_pool), ":", SVN_VA_NULL);
+
+  return svn_error_trace(svn_cache__create_membuffer_cache(
+                           cache, membuffer,
+                           serialize_iprops, deserialize_iprops,
+                           APR_HASH_KEY_STRING, prefix,
+                           SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                           TRUE, FALSE, result_pool, scratch_pool));
+}
+
+/* Return the cache key for the properties that the children of DIR_PATH
+ * in REVISION inherit.  PROPNAME is as for
+ * svn_repos_fs_get_inherited_props.  Allocate the result in RESULT_POOL.
+ */
+static const char *
+iprops_key(svn_revnum_t revision,
+           const char *propname,
+           const char *dir_path,
+           apr_pool_t *result_pool)
+{
+  /* Valid property names contain no spaces and are never empty. */
+  return apr_psprintf(result_pool, "%ld %s %s", revision,
+                      propname ? propname : "", dir_path);
+}
+
+/* Set *PROPS to the properties of PATH in ROOT.  If PROPNAME is not NULL,
+ * only return the property of that name.  Set *PROPS to NULL if there are
+ * no such properties.  Allocate the result in RESULT_POOL. */
+static svn_error_t *
+get_node_props(apr_hash_t **props,
+               svn_fs_root_t *root,
+               const char *path,
+               const char *propname,
+               apr_pool_t *result_pool)
+{
+  *props = NULL;
+  if (propname)
+    {
+      svn_string_t *propval;
+
+      SVN_ERR(svn_fs_node_prop(&propval, root, path, propname,
+                               result_pool));
+      if (propval)
+        {
+          *props = apr_hash_make(result_pool);
+          svn_hash_sets(*props, propname, propval);
+        }
+    }
+  else
+    {
+      SVN_ERR(svn_fs_node_proplist(props, root, path, result_pool));
+    }
+
+  if (*props && !apr_hash_count(*props))
+    *props = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *INHERITED_PROPS to the depth-first ordered array of the properties
+ * that the children of the directory DIR_PATH in the revision root ROOT
+ * inherit, without any authz filtering.  PROPNAME is as for
+ * svn_repos_fs_get_inherited_props.
+ *
+ * Start with the deepest list for DIR_PATH or its parents that can be
+ * found in CACHE and add the results for all directories below it to
+ * CACHE.  Allocate the result in RESULT_POOL and use SCRATCH_POOL for
+ * temporary allocations. */
+static svn_error_t *
+get_cached_inherited_props(apr_array_header_t **inherited_props,
+                           svn_cache__t *cache,
+                           svn_fs_root_t *root,
+                           const char *dir_path,
+                           const char *propname,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  svn_revnum_t revision = svn_fs_revision_root_revision(root);
+  apr_array_header_t *missing = apr_array_make(scratch_pool, 16,
+                                               sizeof(const char *));
+  apr_array_header_t *iprops;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  const char *path = dir_path;
+  int i;
+
+  /* Find the deepest directory with a cached result. */
+  while (TRUE)
+    {
+      svn_boolean_t found;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_cache__get((void **)&iprops, &found, cache,
+                             iprops_key(revision, propname, path, iterpool),
+                             result_pool));
+      if (found)
+        break;
+
+      APR_ARRAY_PUSH(missing, const char *) = path;
+      if (svn_fspath__is_root(path, strlen(path)))
+        {
+          iprops = apr_array_make(result_pool, 1,
+                                  sizeof(svn_prop_inherited_item_t *));
+          break;
+        }
+
+      path = svn_fspath__dirname(path, scratch_pool);
+    }
+
+  /* Add the properties of the directories below it, top-down. */
+  for (i = missing->nelts - 1; i >= 0; --i)
+    {
+      apr_hash_t *props;
+
+      svn_pool_clear(iterpool);
+      path = APR_ARRAY_IDX(missing, i, const char *);
+
+      SVN_ERR(get_node_props(&props, root, path, propname, result_pool));
+      if (props)
+        {
+          svn_prop_inherited_item_t *i_props =
+            apr_pcalloc(result_pool, sizeof(*i_props));
+          i_props->path_or_url = apr_pstrdup(result_pool, path + 1);
+          i_props->prop_hash = props;
+          APR_ARRAY_PUSH(iprops, svn_prop_inherited_item_t *) = i_props;
+        }
+
+      SVN_ERR(svn_cache__set(cache,
+                             iprops_key(revision, propname, path, iterpool),
+                             iprops, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  *inherited_props = iprops;
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -1064,6 +1273,50 @@ svn_repos_fs_get_inherited_props(apr_array_header_t **inherited_props_p,
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   apr_array_header_t *inherited_props;
   const char *parent_path = path;
+  svn_cache__t *cache = NULL;
+
+  if (svn_fs_is_revision_root(root))
+    SVN_ERR(create_iprops_cache(&cache, svn_fs_root_fs(root), scratch_pool,
+                                scratch_pool));
+
+  if (cache && !svn_fspath__is_root(path, strlen(path)))
+    {
+      apr_array_header_t *cached_props;
+      int i;
+
+      SVN_ERR(get_cached_inherited_props(&cached_props, cache, root,
+                                         svn_fspath__dirname(path,
+                                                             scratch_pool),
+                                         propname, result_pool,
+                                         scratch_pool));
+
+      /* Parents without properties don't contribute anything, so it is
+       * sufficient to check the ones in the list. */
+      inherited_props = apr_array_make(result_pool, cached_props->nelts,
+                                       sizeof(svn_prop_inherited_item_t *));
+      for (i = 0; i < cached_props->nelts; ++i)
+        {
+          svn_prop_inherited_item_t *i_props
+            = APR_ARRAY_IDX(cached_props, i, svn_prop_inherited_item_t *);
+          svn_boolean_t allowed = TRUE;
+
+          svn_pool_clear(iterpool);
+          if (authz_read_func)
+            SVN_ERR(authz_read_func(&allowed, root,
+                                    apr_pstrcat(iterpool, "/",
+                                                i_props->path_or_url,
+                                                SVN_VA_NULL),
+                                    authz_read_baton, iterpool));
+          if (allowed)
+            APR_ARRAY_PUSH(inherited_props, svn_prop_inherited_item_t *)
+              = i_props;
+        }
+
+      svn_pool_destroy(iterpool);
+
+      *inherited_props_p = inherited_props;
+      return SVN_NO_ERROR;
+    }
 
   inherited_props = apr_array_make(result_pool, 1,
                                    sizeof(svn_prop_inherited_item_t *));
@@ -1080,25 +1333,10 @@ svn_repos_fs_get_inherited_props(apr_array_header_t **inherited_props_p,
                                 authz_read_baton, iterpool));
       if (allowed)
         {
-          if (propname)
-            {
-              svn_string_t *propval;
-
-              SVN_ERR(svn_fs_node_prop(&propval, root, parent_path, propname,
-                                       result_pool));
-              if (propval)
-                {
-                  parent_properties = apr_hash_make(result_pool);
-                  svn_hash_sets(parent_properties, propname, propval);
-                }
-            }
-          else
-            {
-              SVN_ERR(svn_fs_node_proplist(&parent_properties, root,
-                                           parent_path, result_pool));
-            }
+          SVN_ERR(get_node_props(&parent_properties, root, parent_path,
+                                 propname, result_pool));
 
-          if (parent_properties && apr_hash_count(parent_properties))
+          if (parent_properties)
             {
               svn_prop_inherited_item_t *i_props =
                 apr_pcalloc(result_pool, sizeof(*i_props));
@@ -1116,7 +1354,7 @@ svn_repos_fs_get_inherited_props(apr_array_header_t **inherited_props_p,
   *inherited_props_p = inherited_props;
   return SVN_NO_ERROR;
 }
-
+
 /*
  * vim:ts=4:sw=2:expandtab:tw=80:fo=tcroq
  * vim:isk=a-z,A-Z,48-57,_,.,-,>
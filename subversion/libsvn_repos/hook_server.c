@@ -0,0 +1,394 @@
+/* hook_server.c : running repository hooks in a persistent process
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_pools.h>
+#include <apr_file_io.h>
+#include <apr_thread_proc.h>
+
+#include "svn_hash.h"
+#include "svn_error.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_string.h"
+#include "repos.h"
+#include "svn_private_config.h"
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
+#include "private/svn_string_private.h"
+
+
+
+/*** Hook servers. ***/
+
+/* How long we wait for a hook server to accept a request or to send its
+   response before we consider it hung. */
+#define HOOK_SERVER_TIMEOUT apr_time_from_sec(60)
+
+/* The longest response header line that we accept. */
+#define HOOK_SERVER_MAX_HEADER 100
+
+/* Upper limit for the hook output that a server may send. */
+#define HOOK_SERVER_MAX_OUTPUT 0x1000000
+
+/* A persistent hook server, i.e. a hook server program and the process
+   currently running it. */
+typedef struct hook_server_t
+{
+  /* Serializes all requests to this server and protects the members
+     below. */
+  svn_mutex__t *mutex;
+
+  /* Lives as long as this process. */
+  apr_pool_t *pool;
+
+  /* The server process and the pool that it has been started in.
+     Destroying PROC_POOL terminates the process.  Both are NULL if the
+     server is not running. */
+  apr_proc_t *proc;
+  apr_pool_t *proc_pool;
+} hook_server_t;
+
+/* All hook servers used by this process, keyed by the path of the
+   server program, as well as the pool and the mutex for that hash. */
+static volatile svn_atomic_t hook_servers_init_state = 0;
+static apr_hash_t *hook_servers = NULL;
+static apr_pool_t *hook_servers_pool = NULL;
+static svn_mutex__t *hook_servers_mutex = NULL;
+
+/* Implements svn_atomic__init_once's callback. */
+static svn_error_t *
+init_hook_servers(void *baton,
+                  apr_pool_t *pool)
+{
+  hook_servers_pool = svn_pool_create(NULL);
+  SVN_ERR(svn_mutex__init(&hook_servers_mutex, TRUE, hook_servers_pool));
+  hook_servers = apr_hash_make(hook_servers_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *SERVER to the hook server for the program SERVER_CMD, creating
+   the entry if it does not exist, yet.  The caller must hold
+   HOOK_SERVERS_MUTEX. */
+static svn_error_t *
+get_hook_server(hook_server_t **server,
+                const char *server_cmd)
+{
+  *server = svn_hash_gets(hook_servers, server_cmd);
+  if (!*server)
+    {
+      apr_pool_t *pool = svn_pool_create(NULL);
+
+      *server = apr_pcalloc(pool, sizeof(**server));
+      (*server)->pool = pool;
+      SVN_ERR(svn_mutex__init(&(*server)->mutex, TRUE, pool));
+
+      svn_hash_sets(hook_servers, apr_pstrdup(hook_servers_pool, server_cmd),
+                    *server);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Terminate the process of SERVER, if it is running. */
+static void
+stop_hook_server(hook_server_t *server)
+{
+  if (server->proc_pool)
+    svn_pool_destroy(server->proc_pool);
+
+  server->proc_pool = NULL;
+  server->proc = NULL;
+}
+
+/* Start the program SERVER_CMD with the environment SERVER_ENV as the
+   process of SERVER.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+start_hook_server(hook_server_t *server,
+                  const char *server_cmd,
+                  const char *const *server_env,
+                  apr_pool_t *scratch_pool)
+{
+  apr_pool_t *proc_pool = svn_pool_create(server->pool);
+  apr_proc_t *proc = apr_pcalloc(proc_pool, sizeof(*proc));
+  apr_file_t *null_handle;
+  const char *args[2];
+  svn_error_t *err;
+
+  args[0] = server_cmd;
+  args[1] = NULL;
+
+  /* The server reports the stderr output of each hook in its response,
+     so anything else that it writes there is just noise. */
+  err = svn_io_file_open(&null_handle, SVN_NULL_DEVICE_NAME, APR_WRITE,
+                         APR_OS_DEFAULT, proc_pool);
+  if (!err)
+    err = svn_io_start_cmd3(proc, ".", server_cmd, args, server_env,
+                            FALSE, TRUE, NULL, TRUE, NULL, FALSE,
+                            null_handle, proc_pool);
+  if (err)
+    {
+      svn_pool_destroy(proc_pool);
+      return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, err,
+                               _("Failed to start '%s' hook server"),
+                               server_cmd);
+    }
+
+  /* Closing the pipes tells the server to exit.  Don't let it linger if
+     it does not. */
+  apr_pool_note_subprocess(proc_pool, proc, APR_KILL_AFTER_TIMEOUT);
+
+  /* Hooks and other child processes must not hold the pipes open. */
+  apr_file_inherit_unset(proc->in);
+  apr_file_inherit_unset(proc->out);
+
+  apr_file_pipe_timeout_set(proc->in, HOOK_SERVER_TIMEOUT);
+  apr_file_pipe_timeout_set(proc->out, HOOK_SERVER_TIMEOUT);
+
+  server->proc = proc;
+  server->proc_pool = proc_pool;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if the process of SERVER has been started and has not
+   terminated since. */
+static svn_boolean_t
+hook_server_is_running(hook_server_t *server)
+{
+  int exitcode;
+  apr_exit_why_e exitwhy;
+
+  if (!server->proc)
+    return FALSE;
+
+  return apr_proc_wait(server->proc, &exitcode, &exitwhy, APR_NOWAIT)
+         != APR_CHILD_DONE;
+}
+
+/* Append the length of VALUE in a separate line, VALUE itself and a
+   newline to REQUEST. */
+static void
+append_field(svn_stringbuf_t *request,
+             const char *value)
+{
+  apr_size_t len = strlen(value);
+  char buffer[SVN_INT64_BUFFER_SIZE];
+
+  svn_stringbuf_appendbytes(request, buffer,
+                            svn__ui64toa(buffer, len));
+  svn_stringbuf_appendbyte(request, '\n');
+  svn_stringbuf_appendbytes(request, value, len);
+  svn_stringbuf_appendbyte(request, '\n');
+}
+
+/* Return the number of elements in the NULL-terminated ARRAY, which may
+   itself be NULL. */
+static int
+count_strings(const char *const *array)
+{
+  int count = 0;
+
+  if (array)
+    while (array[count])
+      ++count;
+
+  return count;
+}
+
+/* Return the request to run the hook NAME, as described in the docstring
+   of svn_repos__hook_server_run(), allocated in RESULT_POOL. */
+static svn_stringbuf_t *
+build_request(const char *name,
+              const char *const *args,
+              const char *const *env,
+              const svn_string_t *input,
+              apr_pool_t *result_pool)
+{
+  int arg_count = count_strings(args);
+  int env_count = count_strings(env);
+  svn_stringbuf_t *request;
+  int i;
+
+  request = svn_stringbuf_createf(result_pool, "%s %d %d %" APR_SIZE_T_FMT
+                                  "\n", name, arg_count, env_count,
+                                  input->len);
+  for (i = 0; i < arg_count; ++i)
+    append_field(request, args[i]);
+  for (i = 0; i < env_count; ++i)
+    append_field(request, env[i]);
+
+  svn_stringbuf_appendbytes(request, input->data, input->len);
+
+  return request;
+}
+
+/* Read exactly LEN bytes from FILE into *DATA, allocated in RESULT_POOL.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_response_data(svn_stringbuf_t **data,
+                   apr_file_t *file,
+                   apr_uint64_t len,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  apr_size_t bytes_read;
+  svn_boolean_t hit_eof;
+
+  *data = svn_stringbuf_create_ensure((apr_size_t)len, result_pool);
+  SVN_ERR(svn_io_file_read_full2(file, (*data)->data, (apr_size_t)len,
+                                 &bytes_read, &hit_eof, scratch_pool));
+  if (hit_eof)
+    return svn_error_create(SVN_ERR_REPOS_HOOK_FAILURE, NULL,
+                            _("Unexpected end of hook server response"));
+
+  (*data)->len = bytes_read;
+  (*data)->data[bytes_read] = '\0';
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the response to a request from FILE, as described in the
+   docstring of svn_repos__hook_server_run(), and return its contents in
+   *EXITCODE, *OUTPUT and *ERROR_OUTPUT, allocated in RESULT_POOL.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_response(int *exitcode,
+              svn_stringbuf_t **output,
+              svn_stringbuf_t **error_output,
+              apr_file_t *file,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *header = svn_stringbuf_create_empty(scratch_pool);
+  apr_array_header_t *tokens;
+  apr_uint64_t output_len, error_output_len;
+  char c;
+
+  while (TRUE)
+    {
+      SVN_ERR(svn_io_file_getc(&c, file, scratch_pool));
+      if (c == '\n')
+        break;
+
+      if (header->len >= HOOK_SERVER_MAX_HEADER)
+        return svn_error_create(SVN_ERR_REPOS_HOOK_FAILURE, NULL,
+                                _("Malformed hook server response"));
+      svn_stringbuf_appendbyte(header, c);
+    }
+
+  tokens = svn_cstring_split(header->data, " ", TRUE, scratch_pool);
+  if (tokens->nelts != 3)
+    return svn_error_create(SVN_ERR_REPOS_HOOK_FAILURE, NULL,
+                            _("Malformed hook server response"));
+
+  SVN_ERR(svn_cstring_atoi(exitcode, APR_ARRAY_IDX(tokens, 0, const char *)));
+  SVN_ERR(svn_cstring_strtoui64(&output_len,
+                                APR_ARRAY_IDX(tokens, 1, const char *),
+                                0, HOOK_SERVER_MAX_OUTPUT, 10));
+  SVN_ERR(svn_cstring_strtoui64(&error_output_len,
+                                APR_ARRAY_IDX(tokens, 2, const char *),
+                                0, HOOK_SERVER_MAX_OUTPUT, 10));
+
+  SVN_ERR(read_response_data(output, file, output_len, result_pool,
+                             scratch_pool));
+  SVN_ERR(read_response_data(error_output, file, error_output_len,
+                             result_pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* The body of svn_repos__hook_server_run() while holding the mutex of
+   SERVER.  All other parameters are the same. */
+static svn_error_t *
+run_hook_request(int *exitcode,
+                 svn_stringbuf_t **output,
+                 svn_stringbuf_t **error_output,
+                 hook_server_t *server,
+                 const char *server_cmd,
+                 const char *const *server_env,
+                 const char *name,
+                 const char *const *args,
+                 const char *const *env,
+                 const svn_string_t *input,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *request = build_request(name, args, env, input,
+                                           scratch_pool);
+  svn_error_t *err;
+
+  /* Restart servers that crashed or exited since the last request. */
+  if (!hook_server_is_running(server))
+    {
+      stop_hook_server(server);
+      SVN_ERR(start_hook_server(server, server_cmd, server_env,
+                                scratch_pool));
+    }
+
+  /* Don't retry failed requests.  The hook may have been run already. */
+  err = svn_io_file_write_full(server->proc->in, request->data,
+                               request->len, NULL, scratch_pool);
+  if (!err)
+    err = read_response(exitcode, output, error_output, server->proc->out,
+                        result_pool, scratch_pool);
+  if (err)
+    {
+      stop_hook_server(server);
+      return svn_error_createf(SVN_ERR_REPOS_HOOK_FAILURE, err,
+                               _("'%s' hook server failed to run the "
+                                 "'%s' hook"), server_cmd, name);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__hook_server_run(int *exitcode,
+                           svn_stringbuf_t **output,
+                           svn_stringbuf_t **error_output,
+                           const char *server_cmd,
+                           const char *const *server_env,
+                           const char *name,
+                           const char *const *args,
+                           const char *const *env,
+                           const svn_string_t *input,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  hook_server_t *server;
+
+  SVN_ERR(svn_atomic__init_once(&hook_servers_init_state, init_hook_servers,
+                                NULL, scratch_pool));
+  SVN_MUTEX__WITH_LOCK(hook_servers_mutex,
+                       get_hook_server(&server, server_cmd));
+
+  SVN_MUTEX__WITH_LOCK(server->mutex,
+                       run_hook_request(exitcode, output, error_output,
+                                        server, server_cmd, server_env,
+                                        name, args, env, input,
+                                        result_pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
@@ -45,65 +45,28 @@
 
 /*** Hook drivers. ***/
 
-/* Helper function for run_hook_cmd().  Wait for a hook to finish
-   executing and return either SVN_NO_ERROR if the hook script completed
-   without error, or an error describing the reason for failure.
-
-   NAME and CMD are the name and path of the hook program, CMD_PROC
-   is a pointer to the structure representing the running process,
-   and READ_ERRHANDLE is an open handle to the hook's stderr.
-
-   Hooks are considered to have failed if we are unable to wait for the
-   process, if we are unable to read from the hook's stderr, if the
-   process has failed to exit cleanly (due to a coredump, for example),
-   or if the process returned a non-zero return code.
-
-   Any error output returned by the hook's stderr will be included in an
-   error message, though the presence of output on stderr is not itself
-   a reason to fail a hook. */
+/* Return the error for the hook NAME that did not succeed.  EXITWHY and
+   EXITCODE describe how it terminated.  NATIVE_STDERR is the hook's
+   error output in the native encoding, unless READ_ERR indicates that it
+   could not be read.  READ_ERR will be cleared. */
 static svn_error_t *
-check_hook_result(const char *name, const char *cmd, apr_proc_t *cmd_proc,
-                  apr_file_t *read_errhandle, apr_pool_t *pool)
+hook_failure_error(const char *name,
+                   apr_exit_why_e exitwhy,
+                   int exitcode,
+                   svn_stringbuf_t *native_stderr,
+                   svn_error_t *read_err,
+                   apr_pool_t *pool)
 {
-  svn_error_t *err, *err2;
-  svn_stringbuf_t *native_stderr, *failure_message;
+  svn_stringbuf_t *failure_message;
   const char *utf8_stderr;
-  int exitcode;
-  apr_exit_why_e exitwhy;
-
-  err2 = svn_stringbuf_from_aprfile(&native_stderr, read_errhandle, pool);
-
-  err = svn_io_wait_for_cmd(cmd_proc, cmd, &exitcode, &exitwhy, pool);
-  if (err)
-    {
-      svn_error_clear(err2);
-      return svn_error_trace(err);
-    }
-
-  if (APR_PROC_CHECK_EXIT(exitwhy) && exitcode == 0)
-    {
-      /* The hook exited cleanly.  However, if we got an error reading
-         the hook's stderr, fail the hook anyway, because this might be
-         symptomatic of a more important problem. */
-      if (err2)
-        {
-          return svn_error_createf
-            (SVN_ERR_REPOS_HOOK_FAILURE, err2,
-             _("'%s' hook succeeded, but error output could not be read"),
-             name);
-        }
-
-      return SVN_NO_ERROR;
-    }
-
-  /* The hook script failed. */
 
   /* If we got the stderr output okay, try to translate it into UTF-8.
      Ensure there is something sensible in the UTF-8 string regardless. */
-  if (!err2)
+  if (!read_err)
     {
-      err2 = svn_utf_cstring_to_utf8(&utf8_stderr, native_stderr->data, pool);
-      if (err2)
+      read_err = svn_utf_cstring_to_utf8(&utf8_stderr, native_stderr->data,
+                                         pool);
+      if (read_err)
         utf8_stderr = _("[Error output could not be translated from the "
                         "native locale to UTF-8.]");
     }
@@ -113,7 +76,7 @@ check_hook_result(const char *name, const char *cmd, apr_proc_t *cmd_proc,
     }
   /*### It would be nice to include the text of any translation or read
         error in the messages above before we clear it here. */
-  svn_error_clear(err2);
+  svn_error_clear(read_err);
 
   if (!APR_PROC_CHECK_EXIT(exitwhy))
     {
@@ -158,10 +121,65 @@ check_hook_result(const char *name, const char *cmd, apr_proc_t *cmd_proc,
                                _(" with no output."));
     }
 
-  return svn_error_create(SVN_ERR_REPOS_HOOK_FAILURE, err,
+  return svn_error_create(SVN_ERR_REPOS_HOOK_FAILURE, NULL,
                           failure_message->data);
 }
 
+/* Helper function for run_hook_cmd().  Wait for a hook to finish
+   executing and return either SVN_NO_ERROR if the hook script completed
+   without error, or an error describing the reason for failure.
+
+   NAME and CMD are the name and path of the hook program, CMD_PROC
+   is a pointer to the structure representing the running process,
+   and READ_ERRHANDLE is an open handle to the hook's stderr.
+
+   Hooks are considered to have failed if we are unable to wait for the
+   process, if we are unable to read from the hook's stderr, if the
+   process has failed to exit cleanly (due to a coredump, for example),
+   or if the process returned a non-zero return code.
+
+   Any error output returned by the hook's stderr will be included in an
+   error message, though the presence of output on stderr is not itself
+   a reason to fail a hook. */
+static svn_error_t *
+check_hook_result(const char *name, const char *cmd, apr_proc_t *cmd_proc,
+                  apr_file_t *read_errhandle, apr_pool_t *pool)
+{
+  svn_error_t *err, *err2;
+  svn_stringbuf_t *native_stderr;
+  int exitcode;
+  apr_exit_why_e exitwhy;
+
+  err2 = svn_stringbuf_from_aprfile(&native_stderr, read_errhandle, pool);
+
+  err = svn_io_wait_for_cmd(cmd_proc, cmd, &exitcode, &exitwhy, pool);
+  if (err)
+    {
+      svn_error_clear(err2);
+      return svn_error_trace(err);
+    }
+
+  if (APR_PROC_CHECK_EXIT(exitwhy) && exitcode == 0)
+    {
+      /* The hook exited cleanly.  However, if we got an error reading
+         the hook's stderr, fail the hook anyway, because this might be
+         symptomatic of a more important problem. */
+      if (err2)
+        {
+          return svn_error_createf
+            (SVN_ERR_REPOS_HOOK_FAILURE, err2,
+             _("'%s' hook succeeded, but error output could not be read"),
+             name);
+        }
+
+      return SVN_NO_ERROR;
+    }
+
+  /* The hook script failed. */
+  return hook_failure_error(name, exitwhy, exitcode, native_stderr, err2,
+                            pool);
+}
+
 /* Copy the environment given as key/value pairs of ENV_HASH into
  * an array of C strings allocated in RESULT_POOL.
  * If the hook environment is empty, return NULL.
@@ -193,10 +211,81 @@ env_from_env_hash(apr_hash_t *env_hash,
   return env;
 }
 
+/* Return the environment for the hook NAME from HOOKS_ENV, as returned
+   by svn_repos__parse_hooks_env(), allocated in POOL.  Return NULL if
+   there is no environment for it. */
+static const char **
+get_hook_env(apr_hash_t *hooks_env,
+             const char *name,
+             apr_pool_t *pool)
+{
+  apr_hash_t *hook_env = NULL;
+
+  /* Check if a custom environment is defined for this hook, or else
+   * whether a default environment is defined. */
+  if (hooks_env)
+    {
+      hook_env = svn_hash_gets(hooks_env, name);
+      if (hook_env == NULL)
+        hook_env = svn_hash_gets(hooks_env,
+                                 SVN_REPOS__HOOKS_ENV_DEFAULT_SECTION);
+    }
+
+  return env_from_env_hash(hook_env, pool, pool);
+}
+
+/* Like run_hook_cmd(), but let the persistent hook server program
+   HOOK_SERVER run the hook. */
+static svn_error_t *
+run_hook_on_server(svn_string_t **result,
+                   const char *hook_server,
+                   const char *name,
+                   const char **args,
+                   apr_hash_t *hooks_env,
+                   apr_file_t *stdin_handle,
+                   apr_pool_t *pool)
+{
+  svn_string_t *input;
+  svn_stringbuf_t *native_stdout, *native_stderr;
+  int exitcode;
+
+  if (stdin_handle)
+    {
+      svn_stringbuf_t *buffer;
+
+      SVN_ERR(svn_stringbuf_from_aprfile(&buffer, stdin_handle, pool));
+      input = svn_stringbuf__morph_into_string(buffer);
+    }
+  else
+    {
+      input = svn_string_create_empty(pool);
+    }
+
+  SVN_ERR(svn_repos__hook_server_run(&exitcode, &native_stdout,
+                                     &native_stderr, hook_server,
+                                     get_hook_env(hooks_env,
+                                                  SVN_REPOS__HOOK_SERVER,
+                                                  pool),
+                                     name, args,
+                                     get_hook_env(hooks_env, name, pool),
+                                     input, pool, pool));
+  if (exitcode != 0)
+    return hook_failure_error(name, APR_PROC_EXIT, exitcode, native_stderr,
+                              SVN_NO_ERROR, pool);
+
+  if (result)
+    *result = svn_stringbuf__morph_into_string(native_stdout);
+
+  return SVN_NO_ERROR;
+}
+
 /* NAME, CMD and ARGS are the name, path to and arguments for the hook
-   program that is to be run.  The hook's exit status will be checked,
-   and if an error occurred the hook's stderr output will be added to
-   the returned error.
+   program of REPOS that is to be run.  The hook's exit status will be
+   checked, and if an error occurred the hook's stderr output will be
+   added to the returned error.
+
+   If REPOS has a hook server program, let that one run the hook instead
+   of starting CMD.
 
    If STDIN_HANDLE is non-null, pass it as the hook's stdin, else pass
    no stdin to the hook.
@@ -205,6 +294,7 @@ env_from_env_hash(apr_hash_t *env_hash,
    a zero-length string if the hook generates no output on stdout. */
 static svn_error_t *
 run_hook_cmd(svn_string_t **result,
+             svn_repos_t *repos,
              const char *name,
              const char *cmd,
              const char **args,
@@ -217,7 +307,16 @@ run_hook_cmd(svn_string_t **result,
   svn_error_t *err;
   apr_proc_t cmd_proc = {0};
   apr_pool_t *cmd_pool;
-  apr_hash_t *hook_env = NULL;
+  const char *hook_server;
+  svn_boolean_t broken_link;
+
+  hook_server = check_hook_cmd(svn_dirent_join(repos->hook_path,
+                                               SVN_REPOS__HOOK_SERVER, pool),
+                               &broken_link, pool);
+  if (hook_server && !broken_link)
+    return svn_error_trace(run_hook_on_server(result, hook_server, name,
+                                              args, hooks_env, stdin_handle,
+                                              pool));
 
   if (result)
     {
@@ -237,18 +336,8 @@ run_hook_cmd(svn_string_t **result,
    * destroy in order to clean up the stderr pipe opened for the process. */
   cmd_pool = svn_pool_create(pool);
 
-  /* Check if a custom environment is defined for this hook, or else
-   * whether a default environment is defined. */
-  if (hooks_env)
-    {
-      hook_env = svn_hash_gets(hooks_env, name);
-      if (hook_env == NULL)
-        hook_env = svn_hash_gets(hooks_env,
-                                 SVN_REPOS__HOOKS_ENV_DEFAULT_SECTION);
-    }
-
   err = svn_io_start_cmd3(&cmd_proc, ".", cmd, args,
-                          env_from_env_hash(hook_env, pool, pool),
+                          get_hook_env(hooks_env, name, pool),
                           FALSE, FALSE, stdin_handle, result != NULL,
                           null_handle, TRUE, NULL, cmd_pool);
   if (!err)
@@ -491,8 +580,8 @@ svn_repos__hooks_start_commit(svn_repos_t *repos,
       args[4] = txn_name;
       args[5] = NULL;
 
-      SVN_ERR(run_hook_cmd(NULL, SVN_REPOS__HOOK_START_COMMIT, hook, args,
-                           hooks_env, NULL, pool));
+      SVN_ERR(run_hook_cmd(NULL, repos, SVN_REPOS__HOOK_START_COMMIT,
+                           hook, args, hooks_env, NULL, pool));
     }
 
   return SVN_NO_ERROR;
@@ -578,8 +667,8 @@ svn_repos__hooks_pre_commit(svn_repos_t *repos,
         SVN_ERR(svn_io_file_open(&stdin_handle, SVN_NULL_DEVICE_NAME,
                                  APR_READ, APR_OS_DEFAULT, pool));
 
-      SVN_ERR(run_hook_cmd(NULL, SVN_REPOS__HOOK_PRE_COMMIT, hook, args,
-                           hooks_env, stdin_handle, pool));
+      SVN_ERR(run_hook_cmd(NULL, repos, SVN_REPOS__HOOK_PRE_COMMIT,
+                           hook, args, hooks_env, stdin_handle, pool));
     }
 
   return SVN_NO_ERROR;
@@ -610,8 +699,8 @@ svn_repos__hooks_post_commit(svn_repos_t *repos,
       args[3] = txn_name;
       args[4] = NULL;
 
-      SVN_ERR(run_hook_cmd(NULL, SVN_REPOS__HOOK_POST_COMMIT, hook, args,
-                           hooks_env, NULL, pool));
+      SVN_ERR(run_hook_cmd(NULL, repos, SVN_REPOS__HOOK_POST_COMMIT,
+                           hook, args, hooks_env, NULL, pool));
     }
 
   return SVN_NO_ERROR;
@@ -659,8 +748,8 @@ svn_repos__hooks_pre_revprop_change(svn_repos_t *repos,
       args[5] = action_string;
       args[6] = NULL;
 
-      SVN_ERR(run_hook_cmd(NULL, SVN_REPOS__HOOK_PRE_REVPROP_CHANGE, hook,
-                           args, hooks_env, stdin_handle, pool));
+      SVN_ERR(run_hook_cmd(NULL, repos, SVN_REPOS__HOOK_PRE_REVPROP_CHANGE,
+                           hook, args, hooks_env, stdin_handle, pool));
 
       SVN_ERR(svn_io_file_close(stdin_handle, pool));
     }
@@ -722,8 +811,8 @@ svn_repos__hooks_post_revprop_change(svn_repos_t *repos,
       args[5] = action_string;
       args[6] = NULL;
 
-      SVN_ERR(run_hook_cmd(NULL, SVN_REPOS__HOOK_POST_REVPROP_CHANGE, hook,
-                           args, hooks_env, stdin_handle, pool));
+      SVN_ERR(run_hook_cmd(NULL, repos, SVN_REPOS__HOOK_POST_REVPROP_CHANGE,
+                           hook, args, hooks_env, stdin_handle, pool));
 
       SVN_ERR(svn_io_file_close(stdin_handle, pool));
     }
@@ -763,8 +852,8 @@ svn_repos__hooks_pre_lock(svn_repos_t *repos,
       args[5] = steal_lock ? "1" : "0";
       args[6] = NULL;
 
-      SVN_ERR(run_hook_cmd(&buf, SVN_REPOS__HOOK_PRE_LOCK, hook, args,
-                           hooks_env, NULL, pool));
+      SVN_ERR(run_hook_cmd(&buf, repos, SVN_REPOS__HOOK_PRE_LOCK,
+                           hook, args, hooks_env, NULL, pool));
 
       if (token)
         /* No validation here; the FS will take care of that. */
@@ -808,8 +897,8 @@ svn_repos__hooks_post_lock(svn_repos_t *repos,
       args[3] = NULL;
       args[4] = NULL;
 
-      SVN_ERR(run_hook_cmd(NULL, SVN_REPOS__HOOK_POST_LOCK, hook, args,
-                           hooks_env, stdin_handle, pool));
+      SVN_ERR(run_hook_cmd(NULL, repos, SVN_REPOS__HOOK_POST_LOCK,
+                           hook, args, hooks_env, stdin_handle, pool));
 
       SVN_ERR(svn_io_file_close(stdin_handle, pool));
     }
@@ -846,8 +935,8 @@ svn_repos__hooks_pre_unlock(svn_repos_t *repos,
       args[5] = break_lock ? "1" : "0";
       args[6] = NULL;
 
-      SVN_ERR(run_hook_cmd(NULL, SVN_REPOS__HOOK_PRE_UNLOCK, hook, args,
-                           hooks_env, NULL, pool));
+      SVN_ERR(run_hook_cmd(NULL, repos, SVN_REPOS__HOOK_PRE_UNLOCK,
+                           hook, args, hooks_env, NULL, pool));
     }
 
   return SVN_NO_ERROR;
@@ -884,8 +973,8 @@ svn_repos__hooks_post_unlock(svn_repos_t *repos,
       args[3] = NULL;
       args[4] = NULL;
 
-      SVN_ERR(run_hook_cmd(NULL, SVN_REPOS__HOOK_POST_UNLOCK, hook, args,
-                           hooks_env, stdin_handle, pool));
+      SVN_ERR(run_hook_cmd(NULL, repos, SVN_REPOS__HOOK_POST_UNLOCK,
+                           hook, args, hooks_env, stdin_handle, pool));
 
       SVN_ERR(svn_io_file_close(stdin_handle, pool));
     }
@@ -20,16 +20,21 @@
  * ====================================================================
  */
 
+#include <string.h>
+
 #include <apr_pools.h>
 #include <apr_fnmatch.h>
 
 #include "svn_pools.h"
 #include "svn_error.h"
 #include "svn_dirent_uri.h"
+#include "svn_hash.h"
 #include "svn_time.h"
+#include "svn_cache_config.h"
 
 #include "private/svn_repos_private.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_task.h"
 #include "private/svn_utf_private.h"
 #include "svn_private_config.h" /* for SVN_TEMPLATE_ROOT_DIR */
 
@@ -37,33 +42,50 @@
 
 
 
-/* Utility function.  Given DIRENT->KIND, set all other elements of *DIRENT
- * with the values retrieved for PATH under ROOT.  Allocate them in POOL.
+/* Utility function.  Given DIRENT->KIND, set the elements of *DIRENT
+ * selected by DIRENT_FIELDS with the values retrieved for PATH under ROOT.
+ * Leave the others untouched.  Allocate them in POOL.
  */
 static svn_error_t *
 fill_dirent(svn_dirent_t *dirent,
             svn_fs_root_t *root,
             const char *path,
+            apr_uint32_t dirent_fields,
             apr_pool_t *scratch_pool)
 {
   const char *datestring;
 
-  if (dirent->kind == svn_node_file)
-    SVN_ERR(svn_fs_file_length(&(dirent->size), root, path, scratch_pool));
-  else
-    dirent->size = SVN_INVALID_FILESIZE;
-
-  SVN_ERR(svn_fs_node_has_props(&dirent->has_props, root, path,
-                                scratch_pool));
+  if (dirent_fields & SVN_DIRENT_SIZE)
+    {
+      if (dirent->kind == svn_node_file)
+        SVN_ERR(svn_fs_file_length(&(dirent->size), root, path,
+                                   scratch_pool));
+      else
+        dirent->size = SVN_INVALID_FILESIZE;
+    }
 
-  SVN_ERR(svn_repos_get_committed_info(&(dirent->created_rev),
-                                       &datestring,
-                                       &(dirent->last_author),
-                                       root, path, scratch_pool));
-  if (datestring)
-    SVN_ERR(svn_time_from_cstring(&(dirent->time), datestring,
+  if (dirent_fields & SVN_DIRENT_HAS_PROPS)
+    SVN_ERR(svn_fs_node_has_props(&dirent->has_props, root, path,
                                   scratch_pool));
 
+  /* Author and date require the revision properties to be read while
+   * the created revision alone is part of the node itself. */
+  if (dirent_fields & (SVN_DIRENT_TIME | SVN_DIRENT_LAST_AUTHOR))
+    {
+      SVN_ERR(svn_repos_get_committed_info(&(dirent->created_rev),
+                                           &datestring,
+                                           &(dirent->last_author),
+                                           root, path, scratch_pool));
+      if (datestring && (dirent_fields & SVN_DIRENT_TIME))
+        SVN_ERR(svn_time_from_cstring(&(dirent->time), datestring,
+                                      scratch_pool));
+    }
+  else if (dirent_fields & SVN_DIRENT_CREATED_REV)
+    {
+      SVN_ERR(svn_fs_node_created_rev(&(dirent->created_rev), root, path,
+                                      scratch_pool));
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -87,7 +109,7 @@ svn_repos_stat(svn_dirent_t **dirent,
   ent = svn_dirent_create(pool);
   ent->kind = kind;
 
-  SVN_ERR(fill_dirent(ent, root, path, pool));
+  SVN_ERR(fill_dirent(ent, root, path, SVN_DIRENT_ALL, pool));
 
   *dirent = ent;
   return SVN_NO_ERROR;
@@ -108,9 +130,8 @@ matches_any(const char *dirname,
 
 /* Utility to prevent code duplication.
  *
- * Construct a svn_dirent_t for PATH of type KIND under ROOT and, if
- * PATH_INFO_ONLY is not set, fill it.  Call RECEIVER with the result
- * and RECEIVER_BATON.
+ * Construct a svn_dirent_t for PATH of type KIND under ROOT and fill in
+ * the DIRENT_FIELDS.  Call RECEIVER with the result and RECEIVER_BATON.
  *
  * Use SCRATCH_POOL for temporary allocations.
  */
@@ -118,7 +139,7 @@ static svn_error_t *
 report_dirent(svn_fs_root_t *root,
               const char *path,
               svn_node_kind_t kind,
-              svn_boolean_t path_info_only,
+              apr_uint32_t dirent_fields,
               svn_repos_dirent_receiver_t receiver,
               void *receiver_baton,
               apr_pool_t *scratch_pool)
@@ -127,8 +148,7 @@ report_dirent(svn_fs_root_t *root,
 
   /* Fetch the details to report - if required. */
   dirent.kind = kind;
-  if (!path_info_only)
-    SVN_ERR(fill_dirent(&dirent, root, path, scratch_pool));
+  SVN_ERR(fill_dirent(&dirent, root, path, dirent_fields, scratch_pool));
 
   /* Report the entry. */
   SVN_ERR(receiver(path, &dirent, receiver_baton, scratch_pool));
@@ -158,32 +178,31 @@ compare_filtered_dirent(const void *lhs,
   return strcmp(lhs_dirent->dirent->name, rhs_dirent->dirent->name);
 }
 
-/* Core of svn_repos_list with the same parameter list.
+/* Fetch the entries of directory PATH under ROOT, drop those that don't
+ * pass the DEPTH and PATTERNS filters and return the remaining ones as
+ * filtered_dirent_t sorted by name in *SORTED.
  *
- * However, DEPTH is not svn_depth_empty and PATH has already been reported.
- * Therefore, we can call this recursively.
+ * If AUTHZ_READ_FUNC is not NULL, set *ALLOWED to an array with one flag
+ * per entry in *SORTED, telling whether the entry is readable.  Set it to
+ * NULL otherwise.
  *
- * Uses SCRATCH_BUFFER for temporary string contents.
+ * Uses SCRATCH_BUFFER for temporary string contents.  Allocate the results
+ * in RESULT_POOL.
  */
 static svn_error_t *
-do_list(svn_fs_root_t *root,
-        const char *path,
-        const apr_array_header_t *patterns,
-        svn_depth_t depth,
-        svn_boolean_t path_info_only,
-        svn_repos_authz_func_t authz_read_func,
-        void *authz_read_baton,
-        svn_repos_dirent_receiver_t receiver,
-        void *receiver_baton,
-        svn_cancel_func_t cancel_func,
-        void *cancel_baton,
-        svn_membuf_t *scratch_buffer,
-        apr_pool_t *scratch_pool)
+get_sorted_entries(apr_array_header_t **sorted,
+                   svn_boolean_t **allowed,
+                   svn_fs_root_t *root,
+                   const char *path,
+                   const apr_array_header_t *patterns,
+                   svn_depth_t depth,
+                   svn_repos_authz_func_t authz_read_func,
+                   void *authz_read_baton,
+                   svn_membuf_t *scratch_buffer,
+                   apr_pool_t *result_pool)
 {
   apr_hash_t *entries;
-  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   apr_hash_index_t *hi;
-  apr_array_header_t *sorted;
   int i;
 
   /* Fetch all directory entries, filter and sort them.
@@ -194,13 +213,12 @@ do_list(svn_fs_root_t *root,
    * the full path required for authz is somewhat expensive and we don't
    * want to do this twice while authz will rarely filter paths out.
    */
-  SVN_ERR(svn_fs_dir_entries(&entries, root, path, scratch_pool));
-  sorted = apr_array_make(scratch_pool, apr_hash_count(entries),
-                          sizeof(filtered_dirent_t));
-  for (hi = apr_hash_first(scratch_pool, entries); hi; hi = apr_hash_next(hi))
+  SVN_ERR(svn_fs_dir_entries(&entries, root, path, result_pool));
+  *sorted = apr_array_make(result_pool, apr_hash_count(entries),
+                           sizeof(filtered_dirent_t));
+  for (hi = apr_hash_first(result_pool, entries); hi; hi = apr_hash_next(hi))
     {
       filtered_dirent_t filtered;
-      svn_pool_clear(iterpool);
 
       filtered.dirent = apr_hash_this_val(hi);
 
@@ -214,10 +232,62 @@ do_list(svn_fs_root_t *root,
       if (!filtered.is_match && filtered.dirent->kind == svn_node_file)
         continue;
 
-      APR_ARRAY_PUSH(sorted, filtered_dirent_t) = filtered;
+      APR_ARRAY_PUSH(*sorted, filtered_dirent_t) = filtered;
+    }
+
+  svn_sort__array(*sorted, compare_filtered_dirent);
+
+  /* Check access to all remaining entries at once. */
+  *allowed = NULL;
+  if (authz_read_func && (*sorted)->nelts)
+    {
+      apr_array_header_t *names = apr_array_make(result_pool,
+                                                 (*sorted)->nelts,
+                                                 sizeof(const char *));
+      for (i = 0; i < (*sorted)->nelts; ++i)
+        APR_ARRAY_PUSH(names, const char *)
+          = APR_ARRAY_IDX(*sorted, i, filtered_dirent_t).dirent->name;
+
+      *allowed = apr_palloc(result_pool, (*sorted)->nelts * sizeof(**allowed));
+      SVN_ERR(svn_repos__authz_read_children(*allowed, root, path, names,
+                                             authz_read_func,
+                                             authz_read_baton,
+                                             result_pool));
     }
 
-  svn_sort__array(sorted, compare_filtered_dirent);
+  return SVN_NO_ERROR;
+}
+
+/* Core of svn_repos_list2 with the same parameter list.
+ *
+ * However, DEPTH is not svn_depth_empty and PATH has already been reported.
+ * Therefore, we can call this recursively.
+ *
+ * Uses SCRATCH_BUFFER for temporary string contents.
+ */
+static svn_error_t *
+do_list(svn_fs_root_t *root,
+        const char *path,
+        const apr_array_header_t *patterns,
+        svn_depth_t depth,
+        apr_uint32_t dirent_fields,
+        svn_repos_authz_func_t authz_read_func,
+        void *authz_read_baton,
+        svn_repos_dirent_receiver_t receiver,
+        void *receiver_baton,
+        svn_cancel_func_t cancel_func,
+        void *cancel_baton,
+        svn_membuf_t *scratch_buffer,
+        apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_array_header_t *sorted;
+  svn_boolean_t *allowed;
+  int i;
+
+  SVN_ERR(get_sorted_entries(&sorted, &allowed, root, path, patterns, depth,
+                             authz_read_func, authz_read_baton,
+                             scratch_buffer, scratch_pool));
 
   /* Iterate over all remaining directory entries and report them.
    * Recurse into sub-directories if requested. */
@@ -233,19 +303,14 @@ do_list(svn_fs_root_t *root,
       dirent = filtered->dirent;
 
       /* Skip paths that we don't have access to? */
+      if (allowed && !allowed[i])
+        continue;
+
       sub_path = svn_dirent_join(path, dirent->name, iterpool);
-      if (authz_read_func)
-        {
-          svn_boolean_t has_access;
-          SVN_ERR(authz_read_func(&has_access, root, sub_path,
-                                  authz_read_baton, iterpool));
-          if (!has_access)
-            continue;
-        }
 
       /* Report entry, if it passed the filter. */
       if (filtered->is_match)
-        SVN_ERR(report_dirent(root, sub_path, dirent->kind, path_info_only,
+        SVN_ERR(report_dirent(root, sub_path, dirent->kind, dirent_fields,
                               receiver, receiver_baton, iterpool));
 
       /* Check for cancellation before recursing down.  This should be
@@ -256,7 +321,7 @@ do_list(svn_fs_root_t *root,
       /* Recurse on directories. */
       if (depth == svn_depth_infinity && dirent->kind == svn_node_dir)
         SVN_ERR(do_list(root, sub_path, patterns, svn_depth_infinity,
-                        path_info_only, authz_read_func, authz_read_baton,
+                        dirent_fields, authz_read_func, authz_read_baton,
                         receiver, receiver_baton, cancel_func,
                         cancel_baton, scratch_buffer, iterpool));
     }
@@ -266,21 +331,395 @@ do_list(svn_fs_root_t *root,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_repos_list(svn_fs_root_t *root,
-               const char *path,
-               const apr_array_header_t *patterns,
-               svn_depth_t depth,
-               svn_boolean_t path_info_only,
-               svn_repos_authz_func_t authz_read_func,
-               void *authz_read_baton,
-               svn_repos_dirent_receiver_t receiver,
-               void *receiver_baton,
+
+/*** Listing sub-trees concurrently. ***/
+
+/* A directory entry found by a worker thread of list_concurrently(). */
+typedef struct collected_entry_t
+{
+  /* Full path of the entry. */
+  const char *path;
+
+  /* Details of the entry.  Only filled if IS_MATCH is set. */
+  svn_dirent_t dirent;
+
+  /* The entry passed the pattern filter and shall be reported. */
+  svn_boolean_t is_match;
+
+  /* Index of the first collected entry that is not part of the sub-tree
+   * starting at this entry. */
+  int subtree_end;
+} collected_entry_t;
+
+/* Baton for the worker threads of list_concurrently(). */
+typedef struct list_baton_t
+{
+  /* Where to find the tree to list from within the workers. */
+  const char *fs_path;
+  apr_hash_t *fs_config;
+  svn_revnum_t revision;
+
+  /* The directory whose sub-trees get listed and its filtered_dirent_t
+   * that are readable.  Each one of them is a work item. */
+  const char *path;
+  apr_array_header_t *entries;
+
+  /* Parameters as passed to svn_repos_list2. */
+  svn_fs_root_t *root;
+  const apr_array_header_t *patterns;
+  apr_uint32_t dirent_fields;
+  svn_repos_authz_func_t authz_read_func;
+  void *authz_read_baton;
+  svn_repos_dirent_receiver_t receiver;
+  void *receiver_baton;
+} list_baton_t;
+
+/* Per-thread context of the list workers. */
+typedef struct list_context_t
+{
+  /* Separate instance of the FS and the root to list. */
+  svn_fs_root_t *root;
+
+  /* Buffer for the pattern matching. */
+  svn_membuf_t scratch_buffer;
+} list_context_t;
+
+/* Implements svn_task__thread_context_constructor_t.
+   Open a separate instance of the root of the list_baton_t CONTEXT_BATON
+   for the current worker thread. */
+static svn_error_t *
+open_list_context(void **thread_context,
+                  void *context_baton,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  list_baton_t *baton = context_baton;
+  list_context_t *context = apr_pcalloc(result_pool, sizeof(*context));
+  svn_fs_t *fs;
+
+  SVN_ERR(svn_fs_open2(&fs, baton->fs_path, baton->fs_config,
+                       result_pool, scratch_pool));
+  SVN_ERR(svn_fs_revision_root(&context->root, fs, baton->revision,
+                               result_pool));
+  svn_membuf__create(&context->scratch_buffer, 256, result_pool);
+
+  *thread_context = context;
+  return SVN_NO_ERROR;
+}
+
+/* Append the entry at PATH of type KIND to COLLECTED and fill in the
+ * requested fields from BATON, if it passes the filter as per IS_MATCH.
+ * If it is a directory, collect its whole sub-tree as well, using the
+ * root and buffer in CONTEXT.  Do not check for read access.
+ *
+ * Allocate the entries in RESULT_POOL and use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+collect_subtree(apr_array_header_t *collected,
+                const char *path,
+                svn_node_kind_t kind,
+                svn_boolean_t is_match,
+                list_baton_t *baton,
+                list_context_t *context,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  collected_entry_t *entry;
+  int index = collected->nelts;
+
+  if (cancel_func)
+    SVN_ERR(cancel_func(cancel_baton));
+
+  entry = apr_array_push(collected);
+  memset(entry, 0, sizeof(*entry));
+  entry->path = path;
+  entry->is_match = is_match;
+  entry->dirent.kind = kind;
+  if (is_match)
+    SVN_ERR(fill_dirent(&entry->dirent, context->root, path,
+                        baton->dirent_fields, result_pool));
+
+  if (kind == svn_node_dir)
+    {
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      apr_array_header_t *sorted;
+      svn_boolean_t *allowed;
+      int i;
+
+      SVN_ERR(get_sorted_entries(&sorted, &allowed, context->root, path,
+                                 baton->patterns, svn_depth_infinity,
+                                 NULL, NULL, &context->scratch_buffer,
+                                 scratch_pool));
+
+      for (i = 0; i < sorted->nelts; ++i)
+        {
+          filtered_dirent_t *filtered
+            = &APR_ARRAY_IDX(sorted, i, filtered_dirent_t);
+
+          svn_pool_clear(iterpool);
+          SVN_ERR(collect_subtree(collected,
+                                  svn_dirent_join(path,
+                                                  filtered->dirent->name,
+                                                  result_pool),
+                                  filtered->dirent->kind,
+                                  filtered->is_match, baton, context,
+                                  cancel_func, cancel_baton,
+                                  result_pool, iterpool));
+        }
+
+      svn_pool_destroy(iterpool);
+    }
+
+  /* ENTRY may have been moved by reallocations of COLLECTED. */
+  APR_ARRAY_IDX(collected, index, collected_entry_t).subtree_end
+    = collected->nelts;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.
+   Collect the sub-tree for the entry with the given INDEX in the
+   list_baton_t PROCESS_BATON and return it as an array of
+   collected_entry_t in *RESULT. */
+static svn_error_t *
+list_subtree(void **result,
+             int index,
+             void *process_baton,
+             void *thread_context,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  list_baton_t *baton = process_baton;
+  const filtered_dirent_t *filtered
+    = &APR_ARRAY_IDX(baton->entries, index, filtered_dirent_t);
+  apr_array_header_t *collected
+    = apr_array_make(result_pool, 16, sizeof(collected_entry_t));
+
+  SVN_ERR(collect_subtree(collected,
+                          svn_dirent_join(baton->path,
+                                          filtered->dirent->name,
+                                          result_pool),
+                          filtered->dirent->kind, filtered->is_match,
+                          baton, thread_context, cancel_func, cancel_baton,
+                          result_pool, scratch_pool));
+
+  *result = collected;
+  return SVN_NO_ERROR;
+}
+
+/* Report those of the COLLECTED entries from index FIRST up to but not
+ * including LAST that are readable as per BATON.  They are the contents
+ * of the directory PARENT_PATH.  Report directories before their
+ * contents and skip the contents of unreadable directories.
+ *
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+report_collected(const apr_array_header_t *collected,
+                 int first,
+                 int last,
+                 const char *parent_path,
+                 list_baton_t *baton,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_boolean_t *allowed = NULL;
+  int i, k;
+
+  /* Check access to all direct children at once. */
+  if (baton->authz_read_func && first < last)
+    {
+      apr_array_header_t *names = apr_array_make(scratch_pool, 16,
+                                                 sizeof(const char *));
+      for (i = first; i < last;
+           i = APR_ARRAY_IDX(collected, i, collected_entry_t).subtree_end)
+        APR_ARRAY_PUSH(names, const char *)
+          = svn_dirent_basename(APR_ARRAY_IDX(collected, i,
+                                              collected_entry_t).path,
+                                NULL);
+
+      allowed = apr_palloc(scratch_pool, names->nelts * sizeof(*allowed));
+      SVN_ERR(svn_repos__authz_read_children(allowed, baton->root,
+                                             parent_path, names,
+                                             baton->authz_read_func,
+                                             baton->authz_read_baton,
+                                             scratch_pool));
+    }
+
+  for (i = first, k = 0; i < last;
+       i = APR_ARRAY_IDX(collected, i, collected_entry_t).subtree_end, ++k)
+    {
+      collected_entry_t *entry = &APR_ARRAY_IDX(collected, i,
+                                                collected_entry_t);
+
+      svn_pool_clear(iterpool);
+
+      /* Skip paths that we don't have access to. */
+      if (allowed && !allowed[k])
+        continue;
+
+      if (entry->is_match)
+        SVN_ERR(baton->receiver(entry->path, &entry->dirent,
+                                baton->receiver_baton, iterpool));
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(report_collected(collected, i + 1, entry->subtree_end,
+                               entry->path, baton, cancel_func,
+                               cancel_baton, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.
+   Report the collected_entry_t array RESULT for the entry with the given
+   INDEX in the list_baton_t OUTPUT_BATON. */
+static svn_error_t *
+report_subtree(void *result,
+               int index,
+               void *output_baton,
                svn_cancel_func_t cancel_func,
                void *cancel_baton,
                apr_pool_t *scratch_pool)
+{
+  list_baton_t *baton = output_baton;
+  const apr_array_header_t *collected = result;
+  collected_entry_t *entry = &APR_ARRAY_IDX(collected, 0,
+                                            collected_entry_t);
+
+  /* Read access to the sub-tree root itself has already been checked. */
+  if (entry->is_match)
+    SVN_ERR(baton->receiver(entry->path, &entry->dirent,
+                            baton->receiver_baton, scratch_pool));
+
+  return svn_error_trace(report_collected(collected, 1, entry->subtree_end,
+                                          entry->path, baton, cancel_func,
+                                          cancel_baton, scratch_pool));
+}
+
+/* Set *JOBS to the number of worker threads to use for listing the tree
+   under ROOT.  If that is more than one, return the configuration to open
+   the filesystem with in *FS_CONFIG, allocated in RESULT_POOL. */
+static svn_error_t *
+get_list_jobs(int *jobs,
+              apr_hash_t **fs_config,
+              svn_fs_root_t *root,
+              apr_pool_t *result_pool)
+{
+  svn_fs_t *fs = svn_fs_root_fs(root);
+  const char *fs_type;
+
+  *jobs = 1;
+  *fs_config = NULL;
+
+  /* Worker threads open their own instances of the filesystem and share
+     its caches with us. */
+  if (   !svn_fs_is_revision_root(root)
+      || svn_cache_config_get()->single_threaded)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_type(&fs_type, svn_fs_path(fs, result_pool), result_pool));
+  if (strcmp(fs_type, SVN_FS_TYPE_BDB) == 0)
+    return SVN_NO_ERROR;
+
+  *fs_config = svn_fs_config(fs, result_pool);
+  if (*fs_config)
+    SVN_ERR(svn_cstring_atoi(jobs,
+                             svn_hash__get_cstring(*fs_config,
+                                                   SVN_REPOS_CONFIG_LIST_JOBS,
+                                                   "1")));
+
+  return SVN_NO_ERROR;
+}
+
+/* Like do_list with DEPTH being svn_depth_infinity but walk the sub-trees
+ * of PATH concurrently on up to JOBS worker threads, using FS_CONFIG to
+ * open the filesystem of ROOT from within the workers.
+ *
+ * The workers collect complete sub-trees without checking for read access
+ * but only the readable parts of them get reported.
+ */
+static svn_error_t *
+list_concurrently(svn_fs_root_t *root,
+                  const char *path,
+                  const apr_array_header_t *patterns,
+                  apr_uint32_t dirent_fields,
+                  svn_repos_authz_func_t authz_read_func,
+                  void *authz_read_baton,
+                  svn_repos_dirent_receiver_t receiver,
+                  void *receiver_baton,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  int jobs,
+                  apr_hash_t *fs_config,
+                  svn_membuf_t *scratch_buffer,
+                  apr_pool_t *scratch_pool)
+{
+  list_baton_t baton = { 0 };
+  apr_array_header_t *sorted;
+  svn_boolean_t *allowed;
+  int i;
+
+  SVN_ERR(get_sorted_entries(&sorted, &allowed, root, path, patterns,
+                             svn_depth_infinity, authz_read_func,
+                             authz_read_baton, scratch_buffer,
+                             scratch_pool));
+
+  /* Only readable entries become work items. */
+  baton.entries = apr_array_make(scratch_pool, sorted->nelts,
+                                 sizeof(filtered_dirent_t));
+  for (i = 0; i < sorted->nelts; ++i)
+    if (!allowed || allowed[i])
+      APR_ARRAY_PUSH(baton.entries, filtered_dirent_t)
+        = APR_ARRAY_IDX(sorted, i, filtered_dirent_t);
+
+  baton.fs_path = svn_fs_path(svn_fs_root_fs(root), scratch_pool);
+  baton.fs_config = fs_config;
+  baton.revision = svn_fs_revision_root_revision(root);
+  baton.path = path;
+  baton.root = root;
+  baton.patterns = patterns;
+  baton.dirent_fields = dirent_fields;
+  baton.authz_read_func = authz_read_func;
+  baton.authz_read_baton = authz_read_baton;
+  baton.receiver = receiver;
+  baton.receiver_baton = receiver_baton;
+
+  return svn_error_trace(svn_task__run(jobs, baton.entries->nelts,
+                                       list_subtree, &baton,
+                                       report_subtree, &baton,
+                                       open_list_context, &baton,
+                                       cancel_func, cancel_baton,
+                                       scratch_pool));
+}
+
+svn_error_t *
+svn_repos_list2(svn_fs_root_t *root,
+                const char *path,
+                const apr_array_header_t *patterns,
+                svn_depth_t depth,
+                apr_uint32_t dirent_fields,
+                svn_repos_authz_func_t authz_read_func,
+                void *authz_read_baton,
+                svn_repos_dirent_receiver_t receiver,
+                void *receiver_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *scratch_pool)
 {
   svn_membuf_t scratch_buffer;
+  int jobs;
+  apr_hash_t *fs_config;
 
   /* Parameter check. */
   svn_node_kind_t kind;
@@ -326,13 +765,25 @@ svn_repos_list(svn_fs_root_t *root,
   /* Actually report PATH, if it passes the filters. */
   if (matches_any(svn_dirent_basename(path, scratch_pool), patterns,
                   &scratch_buffer))
-    SVN_ERR(report_dirent(root, path, kind, path_info_only,
+    SVN_ERR(report_dirent(root, path, kind, dirent_fields,
                           receiver, receiver_baton, scratch_pool));
 
-  /* Report directory contents if requested. */
-  if (depth > svn_depth_empty)
+  /* Report directory contents if requested.  Only full recursion has
+   * sub-trees worth walking concurrently. */
+  if (depth == svn_depth_infinity)
+    SVN_ERR(get_list_jobs(&jobs, &fs_config, root, scratch_pool));
+  else
+    jobs = 1;
+
+  if (depth > svn_depth_empty && jobs > 1)
+    SVN_ERR(list_concurrently(root, path, patterns, dirent_fields,
+                              authz_read_func, authz_read_baton,
+                              receiver, receiver_baton,
+                              cancel_func, cancel_baton, jobs, fs_config,
+                              &scratch_buffer, scratch_pool));
+  else if (depth > svn_depth_empty)
     SVN_ERR(do_list(root, path, patterns, depth,
-                    path_info_only, authz_read_func, authz_read_baton,
+                    dirent_fields, authz_read_func, authz_read_baton,
                     receiver, receiver_baton, cancel_func, cancel_baton,
                     &scratch_buffer, scratch_pool));
 
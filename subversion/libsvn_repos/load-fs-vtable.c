@@ -42,6 +42,8 @@
 #include "private/svn_dep_compat.h"
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_repos_private.h"
+#include "private/svn_subr_private.h"
+#include "private/svn_fs_fs_private.h"
 
 /*----------------------------------------------------------------------*/
 
@@ -58,6 +60,10 @@ struct parse_baton
   svn_boolean_t normalize_props;
   svn_boolean_t use_pre_commit_hook;
   svn_boolean_t use_post_commit_hook;
+
+  /* Whether REPOS has been configured for bulk loading, see
+     SVN_REPOS_CONFIG_BULK_LOAD. */
+  svn_boolean_t bulk_load;
   enum svn_repos_load_uuid uuid_action;
   const char *parent_dir; /* repository relpath, or NULL */
   svn_repos_notify_func_t notify_func;
@@ -830,6 +836,7 @@ set_node_property(void *baton,
   struct node_baton *nb = baton;
   struct revision_baton *rb = nb->rb;
   struct parse_baton *pb = rb->pb;
+  svn_boolean_t validate_props = pb->validate_props;
 
   /* If we're skipping this revision, we're done here. */
   if (rb->skipped)
@@ -878,11 +885,16 @@ set_node_property(void *baton,
       else
         {
           value = new_value;
+
+          /* The adjustment parsed and rewrote the mergeinfo already.
+             Bulk loads don't need to validate it once more. */
+          if (pb->bulk_load)
+            validate_props = FALSE;
         }
     }
 
   return change_node_prop(rb->txn_root, nb->path, name, value,
-                          pb->validate_props, rb->pb->normalize_props,
+                          validate_props, rb->pb->normalize_props,
                           nb->pool);
 }
 
@@ -1196,6 +1208,45 @@ close_revision(void *baton)
 /** The public routines **/
 
 
+/* Return TRUE if REPOS has been configured for bulk loading.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_boolean_t
+is_bulk_load(svn_repos_t *repos,
+             apr_pool_t *scratch_pool)
+{
+  apr_hash_t *fs_config = svn_fs_config(repos->fs, scratch_pool);
+
+  return fs_config && svn_hash__get_bool(fs_config,
+                                         SVN_REPOS_CONFIG_BULK_LOAD, FALSE);
+}
+
+/* Start bulk load mode for REPOS if ENABLE is set and end it otherwise.
+   Set *STARTED to FALSE if the backend does not support bulk loading.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+set_bulk_load_mode(svn_boolean_t *started,
+                   svn_repos_t *repos,
+                   svn_boolean_t enable,
+                   apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__ioctl_bulk_load_input_t input = { 0 };
+  void *output;
+  svn_error_t *err;
+
+  input.enable = enable;
+  err = svn_fs_ioctl(repos->fs, SVN_FS_FS__IOCTL_BULK_LOAD, &input,
+                     &output, NULL, NULL, scratch_pool, scratch_pool);
+  if (err && err->apr_err == SVN_ERR_FS_UNRECOGNIZED_IOCTL_CODE)
+    {
+      svn_error_clear(err);
+      *started = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  *started = enable;
+  return svn_error_trace(err);
+}
+
 svn_error_t *
 svn_repos_get_fs_build_parser6(const svn_repos_parse_fns3_t **callbacks,
                                void **parse_baton,
@@ -1264,6 +1315,7 @@ svn_repos_get_fs_build_parser6(const svn_repos_parse_fns3_t **callbacks,
   pb->use_post_commit_hook = use_post_commit_hook;
   pb->ignore_dates = ignore_dates;
   pb->normalize_props = normalize_props;
+  pb->bulk_load = is_bulk_load(repos, pool);
 
   *callbacks = parser;
   *parse_baton = pb;
@@ -1291,6 +1343,8 @@ svn_repos_load_fs6(svn_repos_t *repos,
 {
   const svn_repos_parse_fns3_t *parser;
   void *parse_baton;
+  svn_boolean_t bulk_load = FALSE;
+  svn_error_t *err;
 
   /* This is really simple. */
 
@@ -1309,8 +1363,19 @@ svn_repos_load_fs6(svn_repos_t *repos,
                                          notify_baton,
                                          pool));
 
-  return svn_repos_parse_dumpstream3(dumpstream, parser, parse_baton, FALSE,
-                                     cancel_func, cancel_baton, pool);
+  if (is_bulk_load(repos, pool))
+    SVN_ERR(set_bulk_load_mode(&bulk_load, repos, TRUE, pool));
+
+  err = svn_repos_parse_dumpstream3(dumpstream, parser, parse_baton, FALSE,
+                                    cancel_func, cancel_baton, pool);
+
+  /* Flush whatever has been loaded, even if the load failed. */
+  if (bulk_load)
+    err = svn_error_compose_create(err,
+                                   set_bulk_load_mode(&bulk_load, repos,
+                                                      FALSE, pool));
+
+  return svn_error_trace(err);
 }
 
 /*----------------------------------------------------------------------*/
@@ -33,6 +33,7 @@
 #include "svn_ctype.h"
 
 #include "private/svn_dep_compat.h"
+#include "private/svn_io_private.h"
 
 /*----------------------------------------------------------------------*/
 
@@ -289,6 +290,57 @@ parse_property_block(svn_stream_t *stream,
    a node.  Use BUFFER/BUFLEN to push the fulltext in "chunks".
 
    Use POOL for all allocations.  */
+/* Skip CONTENT_LENGTH bytes of content in STREAM that no parser callback
+   is interested in.  If STREAM reads from a regular file, simply seek over
+   the content; otherwise read and discard it using BUFFER of size BUFLEN.
+   Use POOL for temporary allocations. */
+static svn_error_t *
+skip_content(svn_stream_t *stream,
+             svn_filesize_t content_length,
+             char *buffer,
+             apr_size_t buflen,
+             apr_pool_t *pool)
+{
+  apr_file_t *file = svn_stream__aprfile(stream);
+  apr_size_t num_to_read, rlen;
+
+  if (file)
+    {
+      apr_finfo_t finfo;
+
+      SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_TYPE | APR_FINFO_SIZE,
+                                   file, pool));
+      if (finfo.filetype == APR_REG)
+        {
+          apr_off_t offset;
+
+          SVN_ERR(svn_io_file_get_offset(&offset, file, pool));
+          if (finfo.size - offset < content_length)
+            return stream_ran_dry();
+
+          offset += content_length;
+          return svn_error_trace(svn_io_file_seek(file, APR_SET, &offset,
+                                                  pool));
+        }
+    }
+
+  while (content_length)
+    {
+      if (content_length >= (svn_filesize_t)buflen)
+        rlen = buflen;
+      else
+        rlen = (apr_size_t) content_length;
+
+      num_to_read = rlen;
+      SVN_ERR(svn_stream_read_full(stream, buffer, &rlen));
+      content_length -= rlen;
+      if (rlen != num_to_read)
+        return stream_ran_dry();
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 parse_text_block(svn_stream_t *stream,
                  svn_filesize_t content_length,
@@ -318,7 +370,11 @@ parse_text_block(svn_stream_t *stream,
     }
 
   /* Regardless of whether or not we have a sink for our data, we
-     need to read it. */
+     need to get past it, but we don't need to read it without one. */
+  if (!text_stream)
+    return svn_error_trace(skip_content(stream, content_length,
+                                        buffer, buflen, pool));
+
   while (content_length)
     {
       if (content_length >= (svn_filesize_t)buflen)
@@ -332,23 +388,19 @@ parse_text_block(svn_stream_t *stream,
       if (rlen != num_to_read)
         return stream_ran_dry();
 
-      if (text_stream)
+      /* write however many bytes you read. */
+      wlen = rlen;
+      SVN_ERR(svn_stream_write(text_stream, buffer, &wlen));
+      if (wlen != rlen)
         {
-          /* write however many bytes you read. */
-          wlen = rlen;
-          SVN_ERR(svn_stream_write(text_stream, buffer, &wlen));
-          if (wlen != rlen)
-            {
-              /* Uh oh, didn't write as many bytes as we read. */
-              return svn_error_create(SVN_ERR_STREAM_UNEXPECTED_EOF, NULL,
-                                      _("Unexpected EOF writing contents"));
-            }
+          /* Uh oh, didn't write as many bytes as we read. */
+          return svn_error_create(SVN_ERR_STREAM_UNEXPECTED_EOF, NULL,
+                                  _("Unexpected EOF writing contents"));
         }
     }
 
-  /* If we opened a stream, we must close it. */
-  if (text_stream)
-    SVN_ERR(svn_stream_close(text_stream));
+  /* We opened a stream, so we must close it. */
+  SVN_ERR(svn_stream_close(text_stream));
 
   return SVN_NO_ERROR;
 }
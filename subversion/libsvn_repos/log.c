@@ -37,13 +37,16 @@
 #include "svn_sorts.h"
 #include "svn_props.h"
 #include "svn_mergeinfo.h"
+#include "svn_cache_config.h"
 #include "repos.h"
 #include "private/svn_fspath.h"
 #include "private/svn_fs_private.h"
+#include "private/svn_fs_fs_private.h"
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
+#include "private/svn_task.h"
 
 
 /* This is a mere convenience struct such that we don't need to pass that
@@ -56,6 +59,13 @@ typedef struct log_callbacks_t
   void *revision_receiver_baton;
   svn_repos_authz_func_t authz_read_func;
   void *authz_read_baton;
+
+  /* Number of threads to walk the path histories with.  If that is more
+     than 1, FS_PATH and FS_CONFIG are used to open separate instances of
+     the filesystem for them. */
+  int history_jobs;
+  const char *fs_path;
+  apr_hash_t *fs_config;
 } log_callbacks_t;
 
 
@@ -429,8 +439,209 @@ struct path_info
   svn_fs_history_t *hist;
   apr_pool_t *newpool;
   apr_pool_t *oldpool;
+
+  /* If set, the FS provides an up-to-date path index that allows us to
+     skip to the next change of PATH without walking its node history.
+     HIST will be NULL in that case. */
+  svn_boolean_t indexed;
+
+  /* Set, if HISTORY_REV has been found using the path index.  Otherwise,
+     PATH may have been copied in HISTORY_REV. */
+  svn_boolean_t index_located;
+
+  /* If not NULL, the history gets walked by worker threads ahead of time
+     and get_history() takes the next location from here. */
+  struct history_prefetch_t *prefetch;
 };
 
+/* Number of history locations a worker thread looks ahead at a time. */
+#define HISTORY_PREFETCH_STEPS 64
+
+/* A single location in a path's history, as found by a worker thread. */
+typedef struct history_step_t
+{
+  const char *path;
+  svn_revnum_t rev;
+  svn_boolean_t index_located;
+} history_step_t;
+
+/* The locations of a path's history that have been looked up by worker
+   threads but not yet been consumed by get_history(). */
+typedef struct history_prefetch_t
+{
+  /* The history_step_t locations and the index of the next one to use. */
+  apr_array_header_t *steps;
+  int next;
+
+  /* Where the walk continues after the last location in STEPS. */
+  svn_stringbuf_t *path;
+  svn_revnum_t history_rev;
+  svn_boolean_t first_time;
+  svn_boolean_t index_located;
+
+  /* Set, if no further locations can be found.  ERR is the error, if any,
+     that stopped the walk.  It gets returned once all of STEPS have been
+     consumed. */
+  svn_boolean_t finished;
+  svn_error_t *err;
+
+  /* Set, if the path does not exist at the start of the walk. */
+  svn_boolean_t missing;
+
+  /* Pool containing STEPS.  Cleared whenever new steps get fetched. */
+  apr_pool_t *pool;
+} history_prefetch_t;
+
+/* Query the path index of FS for PATH and the revision range START to END.
+   Set *AVAILABLE to FALSE if FS does not provide such an index or it is
+   not up to date.  Otherwise, set it to TRUE and return the youngest
+   revision within the range that changed PATH or anything below it in
+   *CHANGE_REV and the youngest one that created PATH or any of its
+   parents in *CREATION_REV.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+query_path_index(svn_boolean_t *available,
+                 svn_revnum_t *change_rev,
+                 svn_revnum_t *creation_rev,
+                 svn_fs_t *fs,
+                 const char *path,
+                 svn_revnum_t start,
+                 svn_revnum_t end,
+                 apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__ioctl_path_index_prev_input_t input;
+  svn_fs_fs__ioctl_path_index_prev_output_t *output;
+  svn_error_t *err;
+
+  input.path = path;
+  input.start = start;
+  input.end = end;
+
+  err = svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_PATH_INDEX_PREV, &input,
+                     (void **)&output, NULL, NULL,
+                     scratch_pool, scratch_pool);
+  if (err && err->apr_err == SVN_ERR_FS_UNRECOGNIZED_IOCTL_CODE)
+    {
+      /* Not an FSFS repository. */
+      svn_error_clear(err);
+      *available = FALSE;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  *available = output->available;
+  *change_rev = output->change_rev;
+  *creation_rev = output->creation_rev;
+
+  return SVN_NO_ERROR;
+}
+
+/* Use the path index to find the next history location for INFO in FS.
+   If that is not possible because history may cross a copy, set *RESOLVED
+   to FALSE and leave INFO untouched.  Otherwise, set *RESOLVED to TRUE and
+   *PREV_REV to the next revision not older than START that changed
+   INFO->PATH or SVN_INVALID_REVNUM, if there is none.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+index_history_prev(svn_boolean_t *resolved,
+                   svn_revnum_t *prev_rev,
+                   struct path_info *info,
+                   svn_fs_t *fs,
+                   svn_revnum_t start,
+                   apr_pool_t *scratch_pool)
+{
+  svn_boolean_t available;
+  svn_revnum_t change_rev, creation_rev;
+  svn_revnum_t end = info->first_time ? info->history_rev
+                                      : info->history_rev - 1;
+
+  *resolved = FALSE;
+
+  /* Unless the index told us so, we don't know whether we reached the
+     current location by crossing a copy. */
+  if (!info->first_time && !info->index_located)
+    {
+      SVN_ERR(query_path_index(&available, &change_rev, &creation_rev, fs,
+                               info->path->data, info->history_rev,
+                               info->history_rev, scratch_pool));
+      if (!available || SVN_IS_VALID_REVNUM(creation_rev))
+        return SVN_NO_ERROR;
+    }
+
+  if (end < start)
+    {
+      *prev_rev = SVN_INVALID_REVNUM;
+      *resolved = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(query_path_index(&available, &change_rev, &creation_rev, fs,
+                           info->path->data, start, end, scratch_pool));
+
+  /* If there is no change after the latest creation, then the only thing
+     left to report is beyond a potential copy. */
+  if (   !available
+      || (   SVN_IS_VALID_REVNUM(creation_rev)
+          && (!SVN_IS_VALID_REVNUM(change_rev) || creation_rev >= change_rev)))
+    return SVN_NO_ERROR;
+
+  *prev_rev = change_rev;
+  *resolved = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set INFO to the next location of its history that has been prefetched
+   by worker threads.  All remaining parameters are as for get_history().
+
+   There must be at least one location left in INFO->PREFETCH, unless the
+   walk has finished. */
+static svn_error_t *
+next_prefetched_history(struct path_info *info,
+                        svn_fs_t *fs,
+                        svn_repos_authz_func_t authz_read_func,
+                        void *authz_read_baton,
+                        apr_pool_t *scratch_pool)
+{
+  history_prefetch_t *prefetch = info->prefetch;
+  history_step_t *step;
+
+  if (prefetch->next == prefetch->steps->nelts)
+    {
+      svn_error_t *err = prefetch->err;
+
+      SVN_ERR_ASSERT(prefetch->finished);
+      prefetch->err = NULL;
+      info->done = TRUE;
+
+      return svn_error_trace(err);
+    }
+
+  step = &APR_ARRAY_IDX(prefetch->steps, prefetch->next, history_step_t);
+  prefetch->next++;
+
+  svn_stringbuf_set(info->path, step->path);
+  info->history_rev = step->rev;
+  info->index_located = step->index_located;
+  info->first_time = FALSE;
+
+  /* Is the history item readable?  If not, done with path. */
+  if (authz_read_func)
+    {
+      svn_boolean_t readable;
+      svn_fs_root_t *history_root;
+
+      SVN_ERR(svn_fs_revision_root(&history_root, fs, info->history_rev,
+                                   scratch_pool));
+      SVN_ERR(authz_read_func(&readable, history_root, info->path->data,
+                              authz_read_baton, scratch_pool));
+      if (! readable)
+        info->done = TRUE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Advance to the next history for the path.
  *
  * If INFO->HIST is not NULL we do this using that existing history object,
@@ -446,6 +657,9 @@ struct path_info
  * If optional AUTHZ_READ_FUNC is non-NULL, then use it (with
  * AUTHZ_READ_BATON and FS) to check whether INFO->PATH is still readable if
  * we do indeed find more history for the path.
+ *
+ * If INFO->PREFETCH is set, take the next location from there instead of
+ * walking the history.
  */
 static svn_error_t *
 get_history(struct path_info *info,
@@ -462,6 +676,50 @@ get_history(struct path_info *info,
   apr_pool_t *subpool;
   const char *path;
 
+  if (info->prefetch)
+    return svn_error_trace(next_prefetched_history(info, fs,
+                                                   authz_read_func,
+                                                   authz_read_baton,
+                                                   scratch_pool));
+
+  if (info->indexed)
+    {
+      svn_boolean_t resolved;
+      svn_revnum_t prev_rev;
+
+      SVN_ERR(index_history_prev(&resolved, &prev_rev, info, fs, start,
+                                 scratch_pool));
+      info->index_located = resolved;
+      if (resolved)
+        {
+          info->first_time = FALSE;
+          if (!SVN_IS_VALID_REVNUM(prev_rev))
+            {
+              info->done = TRUE;
+              return SVN_NO_ERROR;
+            }
+
+          info->history_rev = prev_rev;
+
+          /* Is the history item readable?  If not, done with path. */
+          if (authz_read_func)
+            {
+              svn_boolean_t readable;
+              SVN_ERR(svn_fs_revision_root(&history_root, fs,
+                                           info->history_rev,
+                                           scratch_pool));
+              SVN_ERR(authz_read_func(&readable, history_root,
+                                      info->path->data,
+                                      authz_read_baton,
+                                      scratch_pool));
+              if (! readable)
+                info->done = TRUE;
+            }
+
+          return SVN_NO_ERROR;
+        }
+    }
+
   if (info->hist)
     {
       subpool = info->newpool;
@@ -1381,6 +1639,339 @@ send_log(svn_revnum_t rev,
   return SVN_NO_ERROR;
 }
 
+/* Baton for the concurrent history walking in prefetch_histories(). */
+typedef struct prefetch_baton_t
+{
+  /* The path_infos whose histories are to be walked further. */
+  apr_array_header_t *infos;
+
+  /* Parameters of the walk, as for get_history(). */
+  svn_boolean_t strict;
+  svn_revnum_t start;
+
+  /* Whether a path that does not exist at the start of its history walk
+     shall be flagged as missing instead of causing an error. */
+  svn_boolean_t ignore_missing_locations;
+
+  /* The caller's filesystem and what worker threads need to open their
+     own instances of it. */
+  svn_fs_t *fs;
+  const char *fs_path;
+  apr_hash_t *fs_config;
+} prefetch_baton_t;
+
+/* Clear a pending error left in the history_prefetch_t DATA.
+   Implements apr_pool_cleanup_t. */
+static apr_status_t
+clear_prefetch_error(void *data)
+{
+  history_prefetch_t *prefetch = data;
+
+  svn_error_clear(prefetch->err);
+  prefetch->err = NULL;
+
+  return APR_SUCCESS;
+}
+
+/* Return a new history prefetch structure for a walk that starts at PATH
+   in revision HIST_END, allocated in RESULT_POOL. */
+static history_prefetch_t *
+create_history_prefetch(const char *path,
+                        svn_revnum_t hist_end,
+                        apr_pool_t *result_pool)
+{
+  history_prefetch_t *prefetch = apr_pcalloc(result_pool, sizeof(*prefetch));
+
+  prefetch->pool = svn_pool_create(result_pool);
+  prefetch->steps = apr_array_make(prefetch->pool, 0,
+                                   sizeof(history_step_t));
+  prefetch->path = svn_stringbuf_create(path, result_pool);
+  prefetch->history_rev = hist_end;
+  prefetch->first_time = TRUE;
+  apr_pool_cleanup_register(result_pool, prefetch, clear_prefetch_error,
+                            apr_pool_cleanup_null);
+
+  return prefetch;
+}
+
+/* Prepare WALK for walking further through its history in FS using
+   get_history(), i.e. recreate the state that get_path_histories() or
+   get_history() would have left behind for a path that keeps its history
+   object open.  Allocate the history object in RESULT_POOL. */
+static svn_error_t *
+resume_history(struct path_info *walk,
+               svn_fs_t *fs,
+               svn_boolean_t strict,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  svn_fs_root_t *root;
+  svn_fs_history_t *hist;
+
+  /* With a path index, we only need to verify that the path exists. */
+  if (walk->indexed && !walk->first_time)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, walk->history_rev, result_pool));
+  SVN_ERR(svn_fs_node_history2(&hist, root, walk->path->data,
+                               result_pool, scratch_pool));
+  if (walk->indexed)
+    return SVN_NO_ERROR;
+
+  /* Skip the current location unless this is the start of the walk. */
+  if (!walk->first_time)
+    SVN_ERR(svn_fs_history_prev2(&hist, hist, ! strict, result_pool,
+                                 scratch_pool));
+
+  if (hist)
+    {
+      walk->hist = hist;
+      walk->newpool = svn_pool_create(result_pool);
+      walk->oldpool = svn_pool_create(result_pool);
+    }
+  else
+    {
+      walk->done = TRUE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Walk up to HISTORY_PREFETCH_STEPS locations of the history of INFO in
+   FS, continuing where the last walk stopped, and return them in *RESULT.
+   Authorization is not checked here but in next_prefetched_history().
+   Errors that stop the walk are returned as part of *RESULT.
+
+   BATON provides the remaining parameters of the walk.  Allocate *RESULT
+   in RESULT_POOL and use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+walk_history(history_prefetch_t **result,
+             const struct path_info *info,
+             svn_fs_t *fs,
+             const prefetch_baton_t *baton,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  const history_prefetch_t *prefetch = info->prefetch;
+  history_prefetch_t *walked = apr_pcalloc(result_pool, sizeof(*walked));
+  struct path_info walk = { 0 };
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err;
+
+  walk.path = svn_stringbuf_dup(prefetch->path, scratch_pool);
+  walk.history_rev = prefetch->history_rev;
+  walk.first_time = prefetch->first_time;
+  walk.indexed = info->indexed;
+  walk.index_located = prefetch->index_located;
+
+  walked->steps = apr_array_make(result_pool, HISTORY_PREFETCH_STEPS,
+                                 sizeof(history_step_t));
+
+  err = resume_history(&walk, fs, baton->strict, scratch_pool, iterpool);
+  while (!err && !walk.done && walked->steps->nelts < HISTORY_PREFETCH_STEPS)
+    {
+      svn_pool_clear(iterpool);
+
+      err = get_history(&walk, fs, baton->strict, NULL, NULL, baton->start,
+                        scratch_pool, iterpool);
+      if (!err && !walk.done)
+        {
+          history_step_t *step = apr_array_push(walked->steps);
+
+          step->path = apr_pstrmemdup(result_pool, walk.path->data,
+                                      walk.path->len);
+          step->rev = walk.history_rev;
+          step->index_located = walk.index_located;
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Paths that don't exist in the first place may be ignored, just as
+     get_path_histories() does. */
+  if (err
+      && prefetch->first_time
+      && walked->steps->nelts == 0
+      && baton->ignore_missing_locations
+      && (err->apr_err == SVN_ERR_FS_NOT_FOUND ||
+          err->apr_err == SVN_ERR_FS_NOT_DIRECTORY ||
+          err->apr_err == SVN_ERR_FS_NO_SUCH_REVISION))
+    {
+      svn_error_clear(err);
+      err = SVN_NO_ERROR;
+      walked->missing = TRUE;
+    }
+
+  walked->path = svn_stringbuf_dup(walk.path, result_pool);
+  walked->history_rev = walk.history_rev;
+  walked->first_time = walked->steps->nelts ? FALSE : prefetch->first_time;
+  walked->index_located = walk.index_located;
+  walked->finished = walk.done || err || walked->missing;
+  walked->err = err;
+
+  *result = walked;
+  return SVN_NO_ERROR;
+}
+
+/* Replace the consumed locations in PREFETCH with those in WALKED. */
+static void
+store_history_steps(history_prefetch_t *prefetch,
+                    const history_prefetch_t *walked)
+{
+  int i;
+
+  svn_pool_clear(prefetch->pool);
+  prefetch->steps = apr_array_make(prefetch->pool, walked->steps->nelts,
+                                   sizeof(history_step_t));
+  for (i = 0; i < walked->steps->nelts; i++)
+    {
+      history_step_t *step = apr_array_push(prefetch->steps);
+
+      *step = APR_ARRAY_IDX(walked->steps, i, history_step_t);
+      step->path = apr_pstrdup(prefetch->pool, step->path);
+    }
+  prefetch->next = 0;
+
+  svn_stringbuf_set(prefetch->path, walked->path->data);
+  prefetch->history_rev = walked->history_rev;
+  prefetch->first_time = walked->first_time;
+  prefetch->index_located = walked->index_located;
+  prefetch->finished = walked->finished;
+  prefetch->err = walked->err;
+  prefetch->missing = walked->missing;
+}
+
+/* Implements svn_task__thread_context_constructor_t.
+   Open a separate instance of the filesystem described by the
+   prefetch_baton_t in CONTEXT_BATON for the current worker thread. */
+static svn_error_t *
+open_worker_fs(void **thread_context,
+               void *context_baton,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  prefetch_baton_t *baton = context_baton;
+  svn_fs_t *worker_fs;
+
+  SVN_ERR(svn_fs_open2(&worker_fs, baton->fs_path, baton->fs_config,
+                       result_pool, scratch_pool));
+  *thread_context = worker_fs;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.
+   Walk the history of the path_info with the given INDEX in the
+   prefetch_baton_t PROCESS_BATON, using the filesystem instance in
+   THREAD_CONTEXT. */
+static svn_error_t *
+walk_history_task(void **result,
+                  int index,
+                  void *process_baton,
+                  void *thread_context,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  prefetch_baton_t *baton = process_baton;
+  struct path_info *info = APR_ARRAY_IDX(baton->infos, index,
+                                         struct path_info *);
+
+  return svn_error_trace(walk_history((history_prefetch_t **)result, info,
+                                      thread_context, baton,
+                                      result_pool, scratch_pool));
+}
+
+/* Implements svn_task__output_func_t.
+   Hand the locations in RESULT to the path_info with the given INDEX in
+   the prefetch_baton_t OUTPUT_BATON. */
+static svn_error_t *
+store_history_task(void *result,
+                   int index,
+                   void *output_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *scratch_pool)
+{
+  prefetch_baton_t *baton = output_baton;
+  struct path_info *info = APR_ARRAY_IDX(baton->infos, index,
+                                         struct path_info *);
+
+  store_history_steps(info->prefetch, result);
+
+  return SVN_NO_ERROR;
+}
+
+/* Make sure that every history in HISTORIES that gets walked by worker
+   threads has locations left to consume, unless it has been walked
+   completely.  Walk all histories that need more locations concurrently,
+   using up to CALLBACKS->HISTORY_JOBS threads.
+
+   STRICT, START and IGNORE_MISSING_LOCATIONS are as for
+   get_path_histories().  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+prefetch_histories(const apr_array_header_t *histories,
+                   svn_fs_t *fs,
+                   svn_boolean_t strict,
+                   svn_revnum_t start,
+                   svn_boolean_t ignore_missing_locations,
+                   const log_callbacks_t *callbacks,
+                   apr_pool_t *scratch_pool)
+{
+  prefetch_baton_t baton;
+  int i;
+
+  /* Histories only get prefetched when running concurrently. */
+  if (callbacks->history_jobs < 2)
+    return SVN_NO_ERROR;
+
+  baton.infos = apr_array_make(scratch_pool, histories->nelts,
+                               sizeof(struct path_info *));
+  for (i = 0; i < histories->nelts; i++)
+    {
+      struct path_info *info = APR_ARRAY_IDX(histories, i,
+                                             struct path_info *);
+      history_prefetch_t *prefetch = info->prefetch;
+
+      if (   prefetch
+          && !info->done
+          && !prefetch->finished
+          && prefetch->next == prefetch->steps->nelts)
+        APR_ARRAY_PUSH(baton.infos, struct path_info *) = info;
+    }
+
+  if (baton.infos->nelts == 0)
+    return SVN_NO_ERROR;
+
+  baton.strict = strict;
+  baton.start = start;
+  baton.ignore_missing_locations = ignore_missing_locations;
+  baton.fs = fs;
+  baton.fs_path = callbacks->fs_path;
+  baton.fs_config = callbacks->fs_config;
+
+  /* Don't bother starting threads for a single history. */
+  if (baton.infos->nelts == 1)
+    {
+      struct path_info *info = APR_ARRAY_IDX(baton.infos, 0,
+                                             struct path_info *);
+      history_prefetch_t *walked;
+
+      SVN_ERR(walk_history(&walked, info, fs, &baton, scratch_pool,
+                           scratch_pool));
+      store_history_steps(info->prefetch, walked);
+
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(svn_task__run(callbacks->history_jobs,
+                                       baton.infos->nelts,
+                                       walk_history_task, &baton,
+                                       store_history_task, &baton,
+                                       open_worker_fs, &baton,
+                                       NULL, NULL, scratch_pool));
+}
+
 /* This controls how many history objects we keep open.  For any targets
    over this number we have to open and close their histories as needed,
    which is CPU intensive, but keeps us from using an unbounded amount of
@@ -1390,7 +1981,10 @@ send_log(svn_revnum_t rev,
 /* Get the histories for PATHS, and store them in *HISTORIES.
 
    If IGNORE_MISSING_LOCATIONS is set, don't treat requests for bogus
-   repository locations as fatal -- just ignore them.  */
+   repository locations as fatal -- just ignore them.
+
+   If CALLBACKS->HISTORY_JOBS allows for it, the histories of multiple
+   PATHS will be walked ahead of time by worker threads.  */
 static svn_error_t *
 get_path_histories(apr_array_header_t **histories,
                    svn_fs_t *fs,
@@ -1399,15 +1993,25 @@ get_path_histories(apr_array_header_t **histories,
                    svn_revnum_t hist_end,
                    svn_boolean_t strict_node_history,
                    svn_boolean_t ignore_missing_locations,
-                   svn_repos_authz_func_t authz_read_func,
-                   void *authz_read_baton,
+                   const log_callbacks_t *callbacks,
                    apr_pool_t *pool)
 {
+  svn_repos_authz_func_t authz_read_func = callbacks->authz_read_func;
+  void *authz_read_baton = callbacks->authz_read_baton;
   svn_fs_root_t *root;
   apr_pool_t *iterpool;
   svn_error_t *err;
+  svn_boolean_t indexed;
+  svn_boolean_t concurrent = callbacks->history_jobs > 1
+                          && paths->nelts > 1;
+  svn_revnum_t change_rev, creation_rev;
   int i;
 
+  /* With an up-to-date path index, we don't need to keep history objects
+     open because we will only occasionally fall back to them. */
+  SVN_ERR(query_path_index(&indexed, &change_rev, &creation_rev, fs, "/",
+                           hist_end, hist_end, pool));
+
   /* Create a history object for each path so we can walk through
      them all at the same time until we have all changes or LIMIT
      is reached.
@@ -1422,6 +2026,60 @@ get_path_histories(apr_array_header_t **histories,
   SVN_ERR(svn_fs_revision_root(&root, fs, hist_end, pool));
 
   iterpool = svn_pool_create(pool);
+
+  /* Let worker threads find the first locations of all paths at once.
+     Authorization and missing paths are being checked afterwards, in the
+     same order as in the sequential case below. */
+  if (concurrent)
+    {
+      for (i = 0; i < paths->nelts; i++)
+        {
+          const char *this_path = APR_ARRAY_IDX(paths, i, const char *);
+          struct path_info *info = apr_pcalloc(pool, sizeof(*info));
+
+          info->path = svn_stringbuf_create(this_path, pool);
+          info->history_rev = hist_end;
+          info->first_time = TRUE;
+          info->indexed = indexed;
+          info->prefetch = create_history_prefetch(this_path, hist_end,
+                                                   pool);
+          APR_ARRAY_PUSH(*histories, struct path_info *) = info;
+        }
+
+      SVN_ERR(prefetch_histories(*histories, fs, strict_node_history,
+                                 hist_start, ignore_missing_locations,
+                                 callbacks, iterpool));
+
+      (*histories)->nelts = 0;
+      for (i = 0; i < paths->nelts; i++)
+        {
+          struct path_info *info = APR_ARRAY_IDX(*histories, i,
+                                                 struct path_info *);
+          svn_pool_clear(iterpool);
+
+          if (authz_read_func)
+            {
+              svn_boolean_t readable;
+              SVN_ERR(authz_read_func(&readable, root, info->path->data,
+                                      authz_read_baton, iterpool));
+              if (! readable)
+                return svn_error_create(SVN_ERR_AUTHZ_UNREADABLE, NULL,
+                                        NULL);
+            }
+
+          if (info->prefetch->missing)
+            continue;
+
+          SVN_ERR(get_history(info, fs, strict_node_history,
+                              authz_read_func, authz_read_baton,
+                              hist_start, pool, iterpool));
+          APR_ARRAY_PUSH(*histories, struct path_info *) = info;
+        }
+      svn_pool_destroy(iterpool);
+
+      return SVN_NO_ERROR;
+    }
+
   for (i = 0; i < paths->nelts; i++)
     {
       const char *this_path = APR_ARRAY_IDX(paths, i, const char *);
@@ -1442,8 +2100,32 @@ get_path_histories(apr_array_header_t **histories,
       info->done = FALSE;
       info->history_rev = hist_end;
       info->first_time = TRUE;
+      info->indexed = indexed;
+      info->index_located = FALSE;
+      info->prefetch = NULL;
+
+      if (indexed)
+        {
+          svn_fs_history_t *hist;
 
-      if (i < MAX_OPEN_HISTORIES)
+          /* Only verify that THIS_PATH exists. */
+          err = svn_fs_node_history2(&hist, root, this_path, iterpool,
+                                     iterpool);
+          if (err
+              && ignore_missing_locations
+              && (err->apr_err == SVN_ERR_FS_NOT_FOUND ||
+                  err->apr_err == SVN_ERR_FS_NOT_DIRECTORY ||
+                  err->apr_err == SVN_ERR_FS_NO_SUCH_REVISION))
+            {
+              svn_error_clear(err);
+              continue;
+            }
+          SVN_ERR(err);
+          info->hist = NULL;
+          info->oldpool = NULL;
+          info->newpool = NULL;
+        }
+      else if (i < MAX_OPEN_HISTORIES)
         {
           err = svn_fs_node_history2(&info->hist, root, this_path, pool,
                                      iterpool);
@@ -2014,8 +2696,7 @@ do_logs(svn_fs_t *fs,
      revisions contain real changes to at least one of our paths.  */
   SVN_ERR(get_path_histories(&histories, fs, paths, hist_start, hist_end,
                              strict_node_history, ignore_missing_locations,
-                             callbacks->authz_read_func,
-                             callbacks->authz_read_baton, pool));
+                             callbacks, pool));
 
   /* Loop through all the revisions in the range and add any
      where a path was changed to the array, or if they wanted
@@ -2030,6 +2711,11 @@ do_logs(svn_fs_t *fs,
       any_histories_left = FALSE;
       svn_pool_clear(iterpool);
 
+      /* Walk ahead in histories whose prefetched locations ran out. */
+      SVN_ERR(prefetch_histories(histories, fs, strict_node_history,
+                                 hist_start, ignore_missing_locations,
+                                 callbacks, iterpool));
+
       for (i = 0; i < histories->nelts; i++)
         {
           struct path_info *info = APR_ARRAY_IDX(histories, i,
@@ -2332,6 +3018,25 @@ svn_repos_get_logs5(svn_repos_t *repos,
   callbacks.revision_receiver_baton = revision_receiver_baton;
   callbacks.authz_read_func = authz_read_func;
   callbacks.authz_read_baton = authz_read_baton;
+  callbacks.history_jobs = 1;
+  callbacks.fs_path = NULL;
+  callbacks.fs_config = NULL;
+
+  /* Worker threads open their own instances of the repository's FS and
+     share its caches with us. */
+  if (   strcmp(repos->fs_type, SVN_FS_TYPE_BDB) != 0
+      && !svn_cache_config_get()->single_threaded)
+    {
+      callbacks.fs_config = svn_fs_config(fs, scratch_pool);
+      if (callbacks.fs_config)
+        {
+          SVN_ERR(svn_cstring_atoi(&callbacks.history_jobs,
+                                   svn_hash__get_cstring(
+                                     callbacks.fs_config,
+                                     SVN_REPOS_CONFIG_LOG_JOBS, "1")));
+          callbacks.fs_path = svn_fs_path(fs, scratch_pool);
+        }
+    }
 
   if (revprops)
     {
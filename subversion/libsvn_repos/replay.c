@@ -28,6 +28,7 @@
 #include "svn_types.h"
 #include "svn_delta.h"
 #include "svn_hash.h"
+#include "svn_string.h"
 #include "svn_fs.h"
 #include "svn_checksum.h"
 #include "svn_repos.h"
@@ -35,11 +36,14 @@
 #include "svn_props.h"
 #include "svn_pools.h"
 #include "svn_path.h"
+#include "svn_cache_config.h"
 #include "svn_private_config.h"
 #include "private/svn_fspath.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_delta_private.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_task.h"
+#include "repos.h"
 
 
 /*** Backstory ***/
@@ -1046,6 +1050,290 @@ svn_repos_replay2(svn_fs_root_t *root,
 #endif
 }
 
+
+/*** Replaying revision ranges ***/
+
+/* Number of revisions that svn_repos_replay_range() hands to a single
+   svn_task__run() call.  This limits the bookkeeping overhead for long
+   revision ranges. */
+#define REPLAY_BATCH_SIZE 1024
+
+/* Files larger than this will not be read ahead. */
+#define REPLAY_PREFETCH_MAX_FILE_SIZE 0x100000
+
+/* Parameters of svn_repos_replay_range(), shared by all revisions. */
+typedef struct replay_range_baton_t
+{
+  svn_repos_t *repos;
+  apr_hash_t *fs_config;
+  svn_revnum_t first_rev;
+  const char *base_dir;
+  const char *base_relpath;
+  svn_revnum_t low_water_mark;
+  svn_boolean_t send_deltas;
+  svn_repos_replay_revstart_func_t revstart_func;
+  svn_repos_replay_revfinish_func_t revfinish_func;
+  void *replay_baton;
+  svn_repos_authz_func_t authz_read_func;
+  void *authz_read_baton;
+} replay_range_baton_t;
+
+/* Replay REVISION of the range described by BATON, calling its
+   callbacks.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+replay_range_revision(replay_range_baton_t *baton,
+                      svn_revnum_t revision,
+                      apr_pool_t *scratch_pool)
+{
+  apr_hash_t *rev_props;
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+  svn_fs_root_t *root;
+  svn_error_t *err;
+
+  SVN_ERR(svn_repos_fs_revision_proplist(&rev_props, baton->repos, revision,
+                                         baton->authz_read_func,
+                                         baton->authz_read_baton,
+                                         scratch_pool));
+  SVN_ERR(baton->revstart_func(revision, baton->replay_baton,
+                               &editor, &edit_baton, rev_props,
+                               scratch_pool));
+
+  err = svn_fs_revision_root(&root, baton->repos->fs, revision,
+                             scratch_pool);
+  if (!err)
+    err = svn_repos_replay2(root, baton->base_dir, baton->low_water_mark,
+                            baton->send_deltas, editor, edit_baton,
+                            baton->authz_read_func, baton->authz_read_baton,
+                            scratch_pool);
+  if (err)
+    {
+      svn_error_clear(editor->abort_edit(edit_baton, scratch_pool));
+      return svn_error_trace(err);
+    }
+
+  return svn_error_trace(baton->revfinish_func(revision, baton->replay_baton,
+                                               editor, edit_baton, rev_props,
+                                               scratch_pool));
+}
+
+/* Implements svn_task__thread_context_constructor_t.
+   Open a separate instance of the filesystem of the replay_range_baton_t
+   CONTEXT_BATON for the current worker thread. */
+static svn_error_t *
+open_prefetch_fs(void **thread_context,
+                 void *context_baton,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  replay_range_baton_t *baton = context_baton;
+  svn_fs_t *fs;
+
+  SVN_ERR(svn_fs_open2(&fs, svn_fs_path(baton->repos->fs, scratch_pool),
+                       baton->fs_config, result_pool, scratch_pool));
+  *thread_context = fs;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.
+   Read the changes of the revision with the given INDEX in the
+   replay_range_baton_t PROCESS_BATON, i.e. everything that its editor
+   drive is going to need, such that they will be in the caches when the
+   revision gets replayed.  There is no actual *RESULT. */
+static svn_error_t *
+prefetch_revision(void **result,
+                  int index,
+                  void *process_baton,
+                  void *thread_context,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  replay_range_baton_t *baton = process_baton;
+  svn_fs_t *fs = thread_context;
+  svn_fs_root_t *root;
+  svn_fs_path_change_iterator_t *iterator;
+  svn_fs_path_change3_t *change;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  *result = NULL;
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, baton->first_rev + index,
+                               scratch_pool));
+  SVN_ERR(svn_fs_paths_changed3(&iterator, root, scratch_pool, scratch_pool));
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+
+  /* Without deltas, the editor drive hardly needs more than the list of
+     changes that we just read. */
+  while (change && baton->send_deltas)
+    {
+      const char *path = change->path.data;
+      svn_node_kind_t kind = change->node_kind;
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      if (kind == svn_node_unknown
+          && change->change_kind != svn_fs_path_change_delete)
+        SVN_ERR(svn_fs_check_path(&kind, root, path, iterpool));
+
+      if (   kind == svn_node_file
+          && change->text_mod
+          && change->change_kind != svn_fs_path_change_delete
+          && svn_relpath_skip_ancestor(baton->base_relpath,
+                                       path[0] == '/' ? path + 1 : path))
+        {
+          svn_filesize_t length;
+          svn_stream_t *contents;
+
+          SVN_ERR(svn_fs_file_length(&length, root, path, iterpool));
+          if (length <= REPLAY_PREFETCH_MAX_FILE_SIZE)
+            {
+              SVN_ERR(svn_fs_file_contents(&contents, root, path, iterpool));
+              SVN_ERR(svn_stream_copy3(contents, svn_stream_empty(iterpool),
+                                       cancel_func, cancel_baton,
+                                       iterpool));
+            }
+        }
+
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.
+   Replay the revision with the given INDEX in the replay_range_baton_t
+   OUTPUT_BATON.  RESULT is unused. */
+static svn_error_t *
+replay_prefetched_revision(void *result,
+                           int index,
+                           void *output_baton,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *scratch_pool)
+{
+  replay_range_baton_t *baton = output_baton;
+
+  return svn_error_trace(replay_range_revision(baton,
+                                               baton->first_rev + index,
+                                               scratch_pool));
+}
+
+/* Set *JOBS to the number of worker threads to read ahead with during a
+   replay of REPOS and *FS_CONFIG to the configuration to open the
+   filesystem with in these threads. */
+static svn_error_t *
+get_replay_jobs(int *jobs,
+                apr_hash_t **fs_config,
+                svn_repos_t *repos,
+                apr_pool_t *result_pool)
+{
+  *jobs = 1;
+  *fs_config = NULL;
+
+  /* Worker threads open their own instances of the filesystem and share
+     its caches with us. */
+  if (   strcmp(repos->fs_type, SVN_FS_TYPE_BDB) == 0
+      || svn_cache_config_get()->single_threaded)
+    return SVN_NO_ERROR;
+
+  *fs_config = svn_fs_config(repos->fs, result_pool);
+  if (*fs_config)
+    SVN_ERR(svn_cstring_atoi(jobs,
+                             svn_hash__get_cstring(*fs_config,
+                                                   SVN_REPOS_CONFIG_REPLAY_JOBS,
+                                                   "1")));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos_replay_range(svn_repos_t *repos,
+                       svn_revnum_t start_rev,
+                       svn_revnum_t end_rev,
+                       const char *base_dir,
+                       svn_revnum_t low_water_mark,
+                       svn_boolean_t send_deltas,
+                       svn_repos_replay_revstart_func_t revstart_func,
+                       svn_repos_replay_revfinish_func_t revfinish_func,
+                       void *replay_baton,
+                       svn_repos_authz_func_t authz_read_func,
+                       void *authz_read_baton,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *scratch_pool)
+{
+  replay_range_baton_t baton;
+  apr_pool_t *iterpool;
+  svn_revnum_t youngest;
+  int jobs;
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest, repos->fs, scratch_pool));
+  if (   !SVN_IS_VALID_REVNUM(start_rev)
+      || !SVN_IS_VALID_REVNUM(end_rev)
+      || start_rev > end_rev
+      || end_rev > youngest)
+    return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                             _("Invalid revision range %ld:%ld"),
+                             start_rev, end_rev);
+
+  baton.repos = repos;
+  baton.base_dir = base_dir;
+  baton.base_relpath = base_dir ? base_dir : "";
+  if (baton.base_relpath[0] == '/')
+    ++baton.base_relpath;
+  baton.low_water_mark = low_water_mark;
+  baton.send_deltas = send_deltas;
+  baton.revstart_func = revstart_func;
+  baton.revfinish_func = revfinish_func;
+  baton.replay_baton = replay_baton;
+  baton.authz_read_func = authz_read_func;
+  baton.authz_read_baton = authz_read_baton;
+
+  SVN_ERR(get_replay_jobs(&jobs, &baton.fs_config, repos, scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (baton.first_rev = start_rev;
+       baton.first_rev <= end_rev;
+       baton.first_rev += REPLAY_BATCH_SIZE)
+    {
+      svn_revnum_t last_rev = MIN(baton.first_rev + REPLAY_BATCH_SIZE - 1,
+                                  end_rev);
+      svn_revnum_t rev;
+
+      svn_pool_clear(iterpool);
+
+      /* Read the next revisions on the workers while we replay the
+         current one. */
+      if (jobs > 1 && last_rev > baton.first_rev)
+        {
+          SVN_ERR(svn_task__run(jobs, (int)(last_rev - baton.first_rev + 1),
+                                prefetch_revision, &baton,
+                                replay_prefetched_revision, &baton,
+                                open_prefetch_fs, &baton,
+                                cancel_func, cancel_baton, iterpool));
+          continue;
+        }
+
+      for (rev = baton.first_rev; rev <= last_rev; rev++)
+        {
+          svn_pool_clear(iterpool);
+          if (cancel_func)
+            SVN_ERR(cancel_func(cancel_baton));
+
+          SVN_ERR(replay_range_revision(&baton, rev, iterpool));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 
 /*****************************************************************
  *                      Ev2 Implementation                       *
@@ -31,6 +31,8 @@
 #include "svn_repos.h"
 #include "svn_pools.h"
 #include "svn_props.h"
+#include "svn_sorts.h"
+#include "svn_cache_config.h"
 #include "repos.h"
 #include "svn_private_config.h"
 
@@ -38,9 +40,28 @@
 #include "private/svn_fspath.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
+#include "private/svn_task.h"
 
 #define NUM_CACHED_SOURCE_ROOTS 4
 
+/* Maximum number of files in a directory whose text deltas get computed
+   ahead of the editor drive at a time. */
+#define PREFETCH_BATCH_SIZE 64
+
+/* Files larger than this will not have their text deltas computed ahead
+   of time.  This limits the memory held by prefetched delta windows. */
+#define PREFETCH_MAX_FILE_SIZE 0x40000
+
+/* Changed files up to this size may be sent as fulltext through the
+   zero-copy code path instead of as a delta against their previous
+   contents.  This matches the ra_svn send buffer, i.e. data that will
+   usually be buffered instead of blocking on the network. */
+#define ZERO_COPY_REPLACE_DELTA_LIMIT 0x4000
+
+/* After this many files in a row without cached fulltexts, only try
+   the zero-copy code path for every so many files. */
+#define ZERO_COPY_MAX_MISSES 16
+
 /* Theory of operation: we write report operations out to a spill-buffer
    as we receive them.  When the report is finished, we read the
    operations back out again, using them to guide the progression of
@@ -113,6 +134,9 @@ typedef struct report_baton_t
   svn_boolean_t text_deltas;   /* Whether to report text deltas */
   apr_size_t zero_copy_limit;  /* Max item size that will be sent using
                                   the zero-copy code path. */
+  int zero_copy_misses;        /* Consecutive zero-copy attempts that did
+                                  not find the fulltext in the cache. */
+  int zero_copy_skips;         /* Zero-copy attempts skipped since. */
 
   /* If the client requested a specific depth, record it here; if the
      client did not, then this is svn_depth_unknown, and the depth of
@@ -144,8 +168,36 @@ typedef struct report_baton_t
   /* This will not change. So, fetch it once and reuse it. */
   svn_string_t *repos_uuid;
   apr_pool_t *pool;
+
+  /* Number of worker threads computing text deltas ahead of the editor
+     drive.  If that is more than 1, FS_PATH and FS_CONFIG are used to
+     open separate instances of the filesystem for them. */
+  int delta_jobs;
+  const char *fs_path;
+  apr_hash_t *fs_config;
+
+  /* Text deltas computed ahead of time for files in the directory being
+     processed, mapping target paths to prefetched_delta_t.  May be NULL. */
+  apr_hash_t *prefetched_deltas;
+
+  /* Read access to the entries of the directory being processed, checked
+     all at once and mapping target paths to svn_boolean_t *.  May be
+     NULL. */
+  apr_hash_t *child_access;
 } report_baton_t;
 
+/* Text delta between two files that has been computed ahead of time. */
+typedef struct prefetched_delta_t
+{
+  /* The source of the delta.  S_PATH is NULL for deltas against the empty
+     file, in which case S_REV is meaningless. */
+  svn_revnum_t s_rev;
+  const char *s_path;
+
+  /* The svn_txdelta_window_t * that make up the delta, in order. */
+  apr_array_header_t *windows;
+} prefetched_delta_t;
+
 /* The type of a function that accepts changes to an object's property
    list.  OBJECT is the object whose properties are being changed.
    NAME is the name of the property to change.  VALUE is the new value
@@ -661,6 +713,108 @@ send_zero_copy_delta(const unsigned char *contents,
   return SVN_NO_ERROR;
 }
 
+/* Return the delta from S_REV/S_PATH to T_PATH that has been computed
+   ahead of time for B, or NULL if there is none. */
+static prefetched_delta_t *
+get_prefetched_delta(report_baton_t *b,
+                     svn_revnum_t s_rev,
+                     const char *s_path,
+                     const char *t_path)
+{
+  prefetched_delta_t *prefetched;
+
+  if (!b->prefetched_deltas)
+    return NULL;
+
+  prefetched = svn_hash_gets(b->prefetched_deltas, t_path);
+  if (!prefetched)
+    return NULL;
+
+  /* The editor drive may have picked a different delta source. */
+  if (s_path == NULL)
+    return prefetched->s_path == NULL ? prefetched : NULL;
+
+  if (   prefetched->s_path == NULL
+      || prefetched->s_rev != s_rev
+      || strcmp(prefetched->s_path, s_path) != 0)
+    return NULL;
+
+  return prefetched;
+}
+
+/* Send the windows of PREFETCHED to DHANDLER with DBATON, followed by
+   the final NULL window. */
+static svn_error_t *
+send_prefetched_delta(const prefetched_delta_t *prefetched,
+                      svn_txdelta_window_handler_t dhandler,
+                      void *dbaton)
+{
+  int i;
+
+  for (i = 0; i < prefetched->windows->nelts; i++)
+    SVN_ERR(dhandler(APR_ARRAY_IDX(prefetched->windows, i,
+                                   svn_txdelta_window_t *),
+                     dbaton));
+
+  return svn_error_trace(dhandler(NULL, dbaton));
+}
+
+/* Try to send the contents of T_PATH in B->T_ROOT to DHANDLER with
+   DBATON through the zero-copy code path.  Set *SENT to TRUE if that
+   succeeded.  Otherwise, set it to FALSE and leave it to the caller to
+   send a regular delta.
+
+   Only fulltexts found in the cache can be sent that way.  If that keeps
+   failing, most files are not even tried until a later probe succeeds.
+   If S_PATH is not NULL, the fulltext replaces a delta against S_PATH and
+   is only sent if it is small.  Use POOL for temporary allocations. */
+static svn_error_t *
+try_send_zero_copy(svn_boolean_t *sent,
+                   report_baton_t *b,
+                   const char *s_path,
+                   const char *t_path,
+                   svn_txdelta_window_handler_t dhandler,
+                   void *dbaton,
+                   apr_pool_t *pool)
+{
+  zero_copy_baton_t baton;
+  svn_boolean_t called = FALSE;
+
+  *sent = FALSE;
+
+  if (b->zero_copy_misses >= ZERO_COPY_MAX_MISSES
+      && ++b->zero_copy_skips % ZERO_COPY_MAX_MISSES != 0)
+    return SVN_NO_ERROR;
+
+  baton.zero_copy_limit = s_path
+                        ? MIN(b->zero_copy_limit,
+                              ZERO_COPY_REPLACE_DELTA_LIMIT)
+                        : b->zero_copy_limit;
+  baton.dhandler = dhandler;
+  baton.dbaton = dbaton;
+  baton.zero_copy_succeeded = FALSE;
+  SVN_ERR(svn_fs_try_process_file_contents(&called, b->t_root, t_path,
+                                           send_zero_copy_delta, &baton,
+                                           pool));
+
+  /* Track whether fulltexts tend to be cached.  Too large ones count
+     as cached. */
+  if (called)
+    {
+      b->zero_copy_misses = 0;
+      b->zero_copy_skips = 0;
+    }
+  else if (b->zero_copy_misses < ZERO_COPY_MAX_MISSES)
+    {
+      b->zero_copy_misses++;
+    }
+
+  /* data has been available and small enough, i.e. been processed? */
+  *sent = called && baton.zero_copy_succeeded;
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Make the appropriate edits on FILE_BATON to change its contents and
    properties from those in S_REV/S_PATH to those in B->t_root/T_PATH,
@@ -710,25 +864,23 @@ delta_files(report_baton_t *b, void *file_baton, svn_revnum_t s_rev,
     {
       if (b->text_deltas)
         {
-          /* if we send deltas against empty streams, we may use our
-             zero-copy code. */
-          if (b->zero_copy_limit > 0 && s_path == NULL)
+          prefetched_delta_t *prefetched
+            = get_prefetched_delta(b, s_rev, s_path, t_path);
+
+          if (prefetched)
+            return svn_error_trace(send_prefetched_delta(prefetched,
+                                                         dhandler, dbaton));
+
+          /* Cached fulltexts may be sent directly using our zero-copy
+             code.  A window without source data is a valid delta
+             against any source, so small changed files qualify, too. */
+          if (b->zero_copy_limit > 0)
             {
-              zero_copy_baton_t baton;
-              svn_boolean_t called = FALSE;
-
-              baton.zero_copy_limit = b->zero_copy_limit;
-              baton.dhandler = dhandler;
-              baton.dbaton = dbaton;
-              baton.zero_copy_succeeded = FALSE;
-              SVN_ERR(svn_fs_try_process_file_contents(&called,
-                                                       b->t_root, t_path,
-                                                       send_zero_copy_delta,
-                                                       &baton, pool));
-
-              /* data has been available and small enough,
-                 i.e. been processed? */
-              if (called && baton.zero_copy_succeeded)
+              svn_boolean_t sent;
+
+              SVN_ERR(try_send_zero_copy(&sent, b, s_path, t_path,
+                                         dhandler, dbaton, pool));
+              if (sent)
                 return SVN_NO_ERROR;
             }
 
@@ -748,6 +900,16 @@ static svn_error_t *
 check_auth(report_baton_t *b, svn_boolean_t *allowed, const char *path,
            apr_pool_t *pool)
 {
+  if (b->child_access)
+    {
+      svn_boolean_t *checked = svn_hash_gets(b->child_access, path);
+      if (checked)
+        {
+          *allowed = *checked;
+          return SVN_NO_ERROR;
+        }
+    }
+
   if (b->authz_read_func)
     return svn_error_trace(b->authz_read_func(allowed, b->t_root, path,
                                               b->authz_read_baton, pool));
@@ -755,6 +917,43 @@ check_auth(report_baton_t *b, svn_boolean_t *allowed, const char *path,
   return SVN_NO_ERROR;
 }
 
+/* Check read access to all ENTRIES (svn_fs_dirent_t *) of the directory
+   T_PATH in B->t_root at once.  Return a hash in *CHILD_ACCESS, allocated
+   in RESULT_POOL, that maps their target paths to svn_boolean_t *, as
+   expected by check_auth().  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+check_children_auth(apr_hash_t **child_access,
+                    report_baton_t *b,
+                    const char *t_path,
+                    const apr_array_header_t *entries,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *names = apr_array_make(scratch_pool, entries->nelts,
+                                             sizeof(const char *));
+  svn_boolean_t *allowed = apr_palloc(result_pool,
+                                      entries->nelts * sizeof(*allowed));
+  int i;
+
+  for (i = 0; i < entries->nelts; ++i)
+    APR_ARRAY_PUSH(names, const char *)
+      = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *)->name;
+
+  SVN_ERR(svn_repos__authz_read_children(allowed, b->t_root, t_path, names,
+                                         b->authz_read_func,
+                                         b->authz_read_baton, scratch_pool));
+
+  *child_access = apr_hash_make(result_pool);
+  for (i = 0; i < entries->nelts; ++i)
+    svn_hash_sets(*child_access,
+                  svn_fspath__join(t_path, APR_ARRAY_IDX(names, i,
+                                                         const char *),
+                                   result_pool),
+                  &allowed[i]);
+
+  return SVN_NO_ERROR;
+}
+
 /* Create a dirent in *ENTRY for the given ROOT and PATH.  We use this to
    replace the source or target dirent when a report pathinfo tells us to
    change paths or revisions. */
@@ -1095,6 +1294,248 @@ update_entry(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
     }
 }
 
+/* A file whose text delta gets computed ahead of the editor drive. */
+typedef struct delta_prefetch_item_t
+{
+  svn_revnum_t s_rev;
+  const char *s_path;
+  const char *t_path;
+} delta_prefetch_item_t;
+
+/* Baton for the worker threads of prefetch_deltas(). */
+typedef struct delta_prefetch_baton_t
+{
+  /* The report being processed. */
+  report_baton_t *b;
+
+  /* The delta_prefetch_item_t to process. */
+  apr_array_header_t *items;
+
+  /* Receives the prefetched_delta_t, allocated in RESULT_POOL. */
+  apr_hash_t *prefetched;
+  apr_pool_t *result_pool;
+} delta_prefetch_baton_t;
+
+/* Per-thread context of the prefetch workers. */
+typedef struct delta_prefetch_context_t
+{
+  /* Separate instance of the report's FS and its target root. */
+  svn_fs_t *fs;
+  svn_fs_root_t *t_root;
+} delta_prefetch_context_t;
+
+/* Implements svn_task__thread_context_constructor_t.
+   Open a separate instance of the FS of the delta_prefetch_baton_t
+   CONTEXT_BATON for the current worker thread. */
+static svn_error_t *
+open_prefetch_context(void **thread_context,
+                      void *context_baton,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  delta_prefetch_baton_t *baton = context_baton;
+  delta_prefetch_context_t *context = apr_pcalloc(result_pool,
+                                                  sizeof(*context));
+
+  SVN_ERR(svn_fs_open2(&context->fs, baton->b->fs_path, baton->b->fs_config,
+                       result_pool, scratch_pool));
+  SVN_ERR(svn_fs_revision_root(&context->t_root, context->fs,
+                               baton->b->t_rev, result_pool));
+
+  *thread_context = context;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.
+   Compute the text delta for the item with the given INDEX in the
+   delta_prefetch_baton_t PROCESS_BATON and return it as a
+   prefetched_delta_t in *RESULT.  Set *RESULT to NULL, if the file
+   is too large or has not been changed. */
+static svn_error_t *
+compute_prefetched_delta(void **result,
+                         int index,
+                         void *process_baton,
+                         void *thread_context,
+                         svn_cancel_func_t cancel_func,
+                         void *cancel_baton,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  delta_prefetch_baton_t *baton = process_baton;
+  delta_prefetch_context_t *context = thread_context;
+  const delta_prefetch_item_t *item
+    = &APR_ARRAY_IDX(baton->items, index, delta_prefetch_item_t);
+  svn_fs_root_t *s_root = NULL;
+  svn_txdelta_stream_t *dstream;
+  svn_txdelta_window_t *window;
+  svn_filesize_t length;
+  prefetched_delta_t *prefetched;
+
+  *result = NULL;
+
+  SVN_ERR(svn_fs_file_length(&length, context->t_root, item->t_path,
+                             scratch_pool));
+  if (length > PREFETCH_MAX_FILE_SIZE)
+    return SVN_NO_ERROR;
+
+  /* Unchanged files don't get a delta, see delta_files(). */
+  if (item->s_path)
+    {
+      svn_boolean_t changed;
+
+      SVN_ERR(svn_fs_revision_root(&s_root, context->fs, item->s_rev,
+                                   scratch_pool));
+      SVN_ERR(svn_fs_contents_different(&changed, context->t_root,
+                                        item->t_path, s_root, item->s_path,
+                                        scratch_pool));
+      if (!changed)
+        return SVN_NO_ERROR;
+    }
+
+  prefetched = apr_pcalloc(result_pool, sizeof(*prefetched));
+  prefetched->s_rev = item->s_rev;
+  prefetched->s_path = item->s_path;
+  prefetched->windows = apr_array_make(result_pool, 1,
+                                       sizeof(svn_txdelta_window_t *));
+
+  SVN_ERR(svn_fs_get_file_delta_stream(&dstream, s_root, item->s_path,
+                                       context->t_root, item->t_path,
+                                       scratch_pool));
+  do
+    {
+      SVN_ERR(svn_txdelta_next_window(&window, dstream, scratch_pool));
+      if (window)
+        APR_ARRAY_PUSH(prefetched->windows, svn_txdelta_window_t *)
+          = svn_txdelta_window_dup(window, result_pool);
+    }
+  while (window);
+
+  *result = prefetched;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.
+   Store the prefetched_delta_t RESULT for the item with the given INDEX
+   in the delta_prefetch_baton_t OUTPUT_BATON. */
+static svn_error_t *
+store_prefetched_delta(void *result,
+                       int index,
+                       void *output_baton,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *scratch_pool)
+{
+  delta_prefetch_baton_t *baton = output_baton;
+  const delta_prefetch_item_t *item
+    = &APR_ARRAY_IDX(baton->items, index, delta_prefetch_item_t);
+  const prefetched_delta_t *computed = result;
+  prefetched_delta_t *prefetched;
+  int i;
+
+  if (!computed)
+    return SVN_NO_ERROR;
+
+  /* RESULT will be cleaned up after we return. */
+  prefetched = apr_pcalloc(baton->result_pool, sizeof(*prefetched));
+  prefetched->s_rev = item->s_rev;
+  prefetched->s_path = item->s_path;
+  prefetched->windows = apr_array_make(baton->result_pool,
+                                       computed->windows->nelts,
+                                       sizeof(svn_txdelta_window_t *));
+  for (i = 0; i < computed->windows->nelts; i++)
+    APR_ARRAY_PUSH(prefetched->windows, svn_txdelta_window_t *)
+      = svn_txdelta_window_dup(APR_ARRAY_IDX(computed->windows, i,
+                                             svn_txdelta_window_t *),
+                               baton->result_pool);
+
+  svn_hash_sets(baton->prefetched, item->t_path, prefetched);
+
+  return SVN_NO_ERROR;
+}
+
+/* Compute the text deltas for up to PREFETCH_BATCH_SIZE files, starting
+   at index FIRST of the svn_fs_dirent_t * in T_ORDERED_ENTRIES, on up to
+   B->DELTA_JOBS worker threads.  Return them in *PREFETCHED, mapping the
+   target paths to prefetched_delta_t.  Set *PREFETCHED to NULL if there
+   is nothing to compute.
+
+   The entries are the target dirents of the directory T_PATH that
+   delta_dirs() has not processed, yet.  S_REV, S_PATH, S_ENTRIES,
+   WC_DEPTH and REQUESTED_DEPTH are as in delta_dirs() and determine
+   the delta source of each entry, in the same way as delta_dirs() and
+   update_entry() do.  If they pick a different source, the prefetched
+   delta will simply be ignored.
+
+   Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+prefetch_deltas(apr_hash_t **prefetched,
+                report_baton_t *b,
+                const apr_array_header_t *t_ordered_entries,
+                int first,
+                svn_revnum_t s_rev,
+                const char *s_path,
+                const char *t_path,
+                apr_hash_t *s_entries,
+                svn_depth_t wc_depth,
+                svn_depth_t requested_depth,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  delta_prefetch_baton_t baton;
+  int last = MIN(first + PREFETCH_BATCH_SIZE, t_ordered_entries->nelts);
+  int i;
+
+  *prefetched = NULL;
+
+  baton.items = apr_array_make(scratch_pool, last - first,
+                               sizeof(delta_prefetch_item_t));
+  for (i = first; i < last; i++)
+    {
+      const svn_fs_dirent_t *t_entry
+         = APR_ARRAY_IDX(t_ordered_entries, i, svn_fs_dirent_t *);
+      const svn_fs_dirent_t *s_entry = NULL;
+      delta_prefetch_item_t *item;
+
+      if (t_entry->kind != svn_node_file)
+        continue;
+
+      if (!is_depth_upgrade(wc_depth, requested_depth, t_entry->kind))
+        {
+          if (requested_depth == svn_depth_unknown
+              && wc_depth < svn_depth_files)
+            continue;
+
+          s_entry = s_entries ? svn_hash_gets(s_entries, t_entry->name)
+                              : NULL;
+        }
+
+      item = apr_array_push(baton.items);
+      item->s_rev = s_rev;
+      item->s_path = (s_entry && s_entry->kind == svn_node_file)
+                   ? svn_fspath__join(s_path, t_entry->name, result_pool)
+                   : NULL;
+      item->t_path = svn_fspath__join(t_path, t_entry->name, result_pool);
+    }
+
+  /* A single file is just as fast to process in the editor drive. */
+  if (baton.items->nelts < 2)
+    return SVN_NO_ERROR;
+
+  baton.b = b;
+  baton.prefetched = apr_hash_make(result_pool);
+  baton.result_pool = result_pool;
+
+  SVN_ERR(svn_task__run(b->delta_jobs, baton.items->nelts,
+                        compute_prefetched_delta, &baton,
+                        store_prefetched_delta, &baton,
+                        open_prefetch_context, &baton,
+                        NULL, NULL, scratch_pool));
+
+  *prefetched = baton.prefetched;
+  return SVN_NO_ERROR;
+}
+
 /* A helper macro for when we have to recurse into subdirectories. */
 #define DEPTH_BELOW_HERE(depth) ((depth) == svn_depth_immediates) ? \
                                  svn_depth_empty : (depth)
@@ -1161,8 +1602,11 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
            svn_depth_t requested_depth, apr_pool_t *pool)
 {
   apr_hash_t *s_entries = NULL, *t_entries;
+  apr_hash_t *prefetched = NULL;
+  apr_hash_t *child_access = NULL;
   apr_hash_index_t *hi;
   apr_pool_t *subpool = svn_pool_create(pool);
+  apr_pool_t *prefetch_pool = NULL;
   apr_array_header_t *t_ordered_entries = NULL;
   int i;
 
@@ -1203,6 +1647,11 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
           if (!name)
             break;
 
+          /* Deltas and access are only prefetched for unreported
+             entries. */
+          b->prefetched_deltas = NULL;
+          b->child_access = NULL;
+
           /* Invalid revnum means we should delete, unless this is
              just an excluded subpath. */
           if (info
@@ -1304,6 +1753,14 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
       /* Loop over the dirents in the target. */
       SVN_ERR(svn_fs_dir_optimal_order(&t_ordered_entries, b->t_root,
                                        t_entries, subpool, iterpool));
+
+      /* Check read access to all of them at once, if that is cheaper than
+         checking only those that we actually report. */
+      if (   t_ordered_entries->nelts
+          && svn_repos__authz_read_func_is_batched(b->authz_read_func))
+        SVN_ERR(check_children_auth(&child_access, b, t_path,
+                                    t_ordered_entries, subpool, iterpool));
+
       for (i = 0; i < t_ordered_entries->nelts; ++i)
         {
           const svn_fs_dirent_t *t_entry
@@ -1313,6 +1770,24 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
 
           svn_pool_clear(iterpool);
 
+          /* Let worker threads compute the text deltas for the next batch
+             of files while we drive the editor.  Sub-directories will use
+             their own batches, so re-install ours for every entry. */
+          if (b->delta_jobs > 1 && i % PREFETCH_BATCH_SIZE == 0)
+            {
+              if (prefetch_pool)
+                svn_pool_clear(prefetch_pool);
+              else
+                prefetch_pool = svn_pool_create(subpool);
+
+              SVN_ERR(prefetch_deltas(&prefetched, b, t_ordered_entries, i,
+                                      s_rev, s_path, t_path, s_entries,
+                                      wc_depth, requested_depth,
+                                      prefetch_pool, iterpool));
+            }
+          b->prefetched_deltas = prefetched;
+          b->child_access = child_access;
+
           if (is_depth_upgrade(wc_depth, requested_depth, t_entry->kind))
             {
               /* We're making the working copy deeper, pretend the source
@@ -1353,6 +1828,9 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
       /* iterpool is destroyed by destroying its parent (subpool) below */
     }
 
+  /* Our prefetched deltas and access flags are about to be destroyed. */
+  b->prefetched_deltas = NULL;
+  b->child_access = NULL;
   svn_pool_destroy(subpool);
 
   return SVN_NO_ERROR;
@@ -1620,6 +2098,8 @@ svn_repos_begin_report3(void **report_baton,
                           : svn_fspath__join(b->fs_base, s_operand, pool);
   b->text_deltas = text_deltas;
   b->zero_copy_limit = zero_copy_limit;
+  b->zero_copy_misses = 0;
+  b->zero_copy_skips = 0;
   b->requested_depth = depth;
   b->ignore_ancestry = ignore_ancestry;
   b->send_copyfrom_args = send_copyfrom_args;
@@ -1634,6 +2114,28 @@ svn_repos_begin_report3(void **report_baton,
                                           1000000 /* maxsize */,
                                           pool);
   b->repos_uuid = svn_string_create(uuid, pool);
+  b->delta_jobs = 1;
+  b->fs_path = NULL;
+  b->fs_config = NULL;
+  b->prefetched_deltas = NULL;
+  b->child_access = NULL;
+
+  /* Worker threads open their own instances of the repository's FS and
+     share its caches with us. */
+  if (   text_deltas
+      && strcmp(repos->fs_type, SVN_FS_TYPE_BDB) != 0
+      && !svn_cache_config_get()->single_threaded)
+    {
+      b->fs_config = svn_fs_config(repos->fs, pool);
+      if (b->fs_config)
+        {
+          SVN_ERR(svn_cstring_atoi(&b->delta_jobs,
+                                   svn_hash__get_cstring(
+                                     b->fs_config,
+                                     SVN_REPOS_CONFIG_REPORT_JOBS, "1")));
+          b->fs_path = svn_fs_path(repos->fs, pool);
+        }
+    }
 
   /* Hand reporter back to client. */
   *report_baton = b;
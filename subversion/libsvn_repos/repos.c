@@ -798,6 +798,58 @@ create_hooks(svn_repos_t *repos, apr_pool_t *pool)
                                      description, script, pool),
             _("Creating post-revprop-change hook"));
 
+#undef SCRIPT_NAME
+
+
+  /* Hook server. */
+#define SCRIPT_NAME SVN_REPOS__HOOK_SERVER
+
+  description =
+"# HOOK SERVER"                                                              NL
+"#"                                                                          NL
+"# If a program (script, executable, binary, etc.) named '"SCRIPT_NAME"'"    NL
+"# (for which this file is a template) exists, Subversion starts it once"    NL
+"# per server process and lets it run all hooks of this repository,"         NL
+"# instead of starting a new process for every hook invocation.  Each"       NL
+"# hook still only gets run if its own hook program exists.  That program"   NL
+"# is the first argument of the request, so the server may simply look"      NL
+"# at its name or load it as a module."                                      NL
+"#"                                                                          NL
+"# The server reads one request after another from STDIN.  Each request"     NL
+"# starts with a line"                                                       NL
+"#"                                                                          NL
+"#   NAME ARG-COUNT ENV-COUNT INPUT-LENGTH"                                  NL
+"#"                                                                          NL
+"# where NAME is the name of the hook, e.g. 'pre-commit'.  It is followed"   NL
+"# by ARG-COUNT fields with the hook program and its arguments, as they"     NL
+"# are described in the other templates, and ENV-COUNT fields with the"      NL
+"# hook's environment as KEY=VALUE.  Each field is a line with the"          NL
+"# length of the value, followed by the value itself and a newline."         NL
+"# The request ends with INPUT-LENGTH bytes of data that a hook program"     NL
+"# would get on STDIN."                                                      NL
+"#"                                                                          NL
+"# For every request, the server writes a line"                              NL
+"#"                                                                          NL
+"#   EXIT-CODE OUTPUT-LENGTH ERROR-OUTPUT-LENGTH"                            NL
+"#"                                                                          NL
+"# to STDOUT, followed by OUTPUT-LENGTH bytes of output and"                 NL
+"# ERROR-OUTPUT-LENGTH bytes of error output.  They have the same meaning"   NL
+"# as the exit code, STDOUT and STDERR of a hook program.  Anything that"    NL
+"# the server itself writes to STDERR gets discarded."                       NL
+"#"                                                                          NL
+"# The server should exit once STDIN has been closed.  If it does not"       NL
+"# respond within a minute, it will be killed and the hook fails.  A"        NL
+"# server that exits or crashes will be restarted with the next request."   NL
+"# The environment of the server itself is taken from the"                   NL
+"# '"SCRIPT_NAME"' section of the hooks environment configuration."          NL;
+  script =
+"# Run a hook server written in some scripting language."                    NL
+"exec /path/to/hook-server.py"                                               NL;
+
+  SVN_ERR_W(write_hook_template_file(repos, SCRIPT_NAME,
+                                     description, script, pool),
+            _("Creating hook server template"));
+
 #undef SCRIPT_NAME
 
   return SVN_NO_ERROR;
@@ -871,6 +923,12 @@ create_conf(svn_repos_t *repos, apr_pool_t *pool)
 "### \"none\" (to compare usernames as-is without case conversion, which"    NL
 "### is the default behavior)."                                              NL
 "# force-username-case = none"                                               NL
+"### The auth-ticket-lifetime option makes svnserve hand out auth tickets"   NL
+"### to clients that authenticated with a username.  For this many seconds," NL
+"### new connections from such a client may present the ticket instead of"   NL
+"### authenticating again.  Tickets are only valid with the svnserve"        NL
+"### process that issued them.  The default is 0, which disables tickets."   NL
+"# auth-ticket-lifetime = 600"                                               NL
 "### The hooks-env options specifies a path to the hook script environment " NL
 "### configuration file. This option overrides the per-repository default"   NL
 "### and can be used to configure the hook script environment for multiple " NL
@@ -1964,10 +2022,11 @@ fs_hotcopy_notify(void *baton,
 
 /* Make a copy of a repository with hot backup of fs. */
 svn_error_t *
-svn_repos_hotcopy3(const char *src_path,
+svn_repos_hotcopy4(const char *src_path,
                    const char *dst_path,
                    svn_boolean_t clean_logs,
                    svn_boolean_t incremental,
+                   apr_hash_t *fs_config,
                    svn_repos_notify_func_t notify_func,
                    void *notify_baton,
                    svn_cancel_func_t cancel_func,
@@ -2052,8 +2111,8 @@ svn_repos_hotcopy3(const char *src_path,
   fs_notify_baton.notify_func = notify_func;
   fs_notify_baton.notify_baton = notify_baton;
 
-  SVN_ERR(svn_fs_hotcopy3(src_repos->db_path, dst_repos->db_path,
-                          clean_logs, incremental,
+  SVN_ERR(svn_fs_hotcopy4(src_repos->db_path, dst_repos->db_path,
+                          clean_logs, incremental, fs_config,
                           fs_notify_func, &fs_notify_baton,
                           cancel_func, cancel_baton, scratch_pool));
 
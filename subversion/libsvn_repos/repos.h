@@ -83,6 +83,11 @@ extern "C" {
 #define SVN_REPOS__HOOK_PRE_UNLOCK      "pre-unlock"
 #define SVN_REPOS__HOOK_POST_UNLOCK     "post-unlock"
 
+/* If this program exists in the hooks directory, it gets started once
+   and runs all hooks of the repository for which a hook program exists,
+   see svn_repos__hook_server_run(). */
+#define SVN_REPOS__HOOK_SERVER          "hook-server"
+
 
 /* The extension added to the names of example hook scripts. */
 #define SVN_REPOS__HOOK_DESC_EXT        ".tmpl"
@@ -176,6 +181,52 @@ svn_repos__parse_hooks_env(apr_hash_t **hooks_env_p,
                            apr_pool_t *result_pool,
                            apr_pool_t *scratch_pool);
 
+/* Let the persistent hook server program SERVER_CMD run the hook NAME.
+   If the server is not running yet, or if it has died since the last
+   request, start it with the environment SERVER_ENV (may be NULL).  The
+   server is shared by all repository instances within this process and
+   handles one request at a time.
+
+   ARGS is the NULL-terminated argument list of the hook program, i.e.
+   ARGS[0] is the path of the hook program itself.  ENV is the
+   NULL-terminated environment of the hook (may be NULL) and INPUT is
+   the data for its stdin.
+
+   On success, set *EXITCODE to the hook's exit code and *OUTPUT and
+   *ERROR_OUTPUT to what it wrote to stdout and stderr, respectively,
+   allocated in RESULT_POOL.  If the server does not respond within a
+   minute, or if it sends a malformed response, stop it and return
+   SVN_ERR_REPOS_HOOK_FAILURE.  The server will be restarted with the
+   next request.
+
+   Requests are written to the server's stdin as a line
+
+     NAME ARG-COUNT ENV-COUNT INPUT-LENGTH
+
+   followed by ARG-COUNT + ENV-COUNT fields, arguments first, and then
+   INPUT-LENGTH bytes of input.  Each field consists of a line with the
+   decimal length of its value, followed by the value and a newline.
+   The server answers on its stdout with a line
+
+     EXIT-CODE OUTPUT-LENGTH ERROR-OUTPUT-LENGTH
+
+   followed by OUTPUT-LENGTH bytes of stdout and ERROR-OUTPUT-LENGTH
+   bytes of stderr output of the hook.
+
+   Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_repos__hook_server_run(int *exitcode,
+                           svn_stringbuf_t **output,
+                           svn_stringbuf_t **error_output,
+                           const char *server_cmd,
+                           const char *const *server_env,
+                           const char *name,
+                           const char *const *args,
+                           const char *const *env,
+                           const svn_string_t *input,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
 /* Run the start-commit hook for REPOS.  Use POOL for any temporary
    allocations.  If the hook fails, return SVN_ERR_REPOS_HOOK_FAILURE.
 
@@ -387,6 +438,29 @@ svn_repos__prev_location(svn_revnum_t *appeared_rev,
                          const char *path,
                          apr_pool_t *pool);
 
+/* Return TRUE if AUTHZ_READ_FUNC has been created by
+   svn_repos__authz_read_func_create(), i.e. if it is cheaper to check
+   the whole contents of a directory at once than only individual
+   entries. */
+svn_boolean_t
+svn_repos__authz_read_func_is_batched(svn_repos_authz_func_t authz_read_func);
+
+/* Set ALLOWED[i] to TRUE if the child NAMES[i] (const char *) of
+   PARENT_PATH in ROOT is readable according to AUTHZ_READ_FUNC with
+   AUTHZ_READ_BATON.  ALLOWED must have room for NAMES->NELTS elements.
+
+   If AUTHZ_READ_FUNC has been created by svn_repos__authz_read_func_create(),
+   check all children at once.  Otherwise, call AUTHZ_READ_FUNC for each
+   child.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_repos__authz_read_children(svn_boolean_t *allowed,
+                               svn_fs_root_t *root,
+                               const char *parent_path,
+                               const apr_array_header_t *names,
+                               svn_repos_authz_func_t authz_read_func,
+                               void *authz_read_baton,
+                               apr_pool_t *scratch_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
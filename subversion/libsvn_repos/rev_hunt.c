@@ -39,6 +39,7 @@
 #include "repos.h"
 #include "private/svn_fspath.h"
 #include "private/svn_fs_private.h"
+#include "private/svn_fs_fs_private.h"
 #include "private/svn_sorts_private.h"
 
 
@@ -76,6 +77,45 @@ get_time(apr_time_t *tm,
 }
 
 
+/* helper for svn_repos_dated_revision().
+
+   Look up TM in the revision date index of FS and set *REVISION to the
+   result.  Set *AVAILABLE to FALSE if FS does not provide such an index
+   or the index cannot answer the query.  Otherwise, set it to TRUE.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+query_date_index(svn_boolean_t *available,
+                 svn_revnum_t *revision,
+                 svn_fs_t *fs,
+                 apr_time_t tm,
+                 apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__ioctl_dated_revision_input_t input;
+  svn_fs_fs__ioctl_dated_revision_output_t *output;
+  svn_error_t *err;
+
+  input.tm = tm;
+
+  err = svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_DATED_REVISION, &input,
+                     (void **)&output, NULL, NULL,
+                     scratch_pool, scratch_pool);
+  if (err && err->apr_err == SVN_ERR_FS_UNRECOGNIZED_IOCTL_CODE)
+    {
+      /* Not an FSFS repository. */
+      svn_error_clear(err);
+      *available = FALSE;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  *available = output->available && SVN_IS_VALID_REVNUM(output->revision);
+  if (*available)
+    *revision = output->revision;
+
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_repos_dated_revision(svn_revnum_t *revision,
                          svn_repos_t *repos,
@@ -85,6 +125,13 @@ svn_repos_dated_revision(svn_revnum_t *revision,
   svn_revnum_t rev_mid, rev_top, rev_bot, rev_latest;
   apr_time_t this_time;
   svn_fs_t *fs = repos->fs;
+  svn_boolean_t available;
+
+  /* The date index, if present, saves us from reading the revprops of
+     all revisions visited by the binary search below. */
+  SVN_ERR(query_date_index(&available, revision, fs, tm, pool));
+  if (available)
+    return SVN_NO_ERROR;
 
   /* Initialize top and bottom values of binary search. */
   SVN_ERR(svn_fs_youngest_rev(&rev_latest, fs, pool));
@@ -304,6 +351,48 @@ svn_repos_history2(svn_fs_t *fs,
 }
 
 
+/* helper for svn_repos_deleted_rev().
+
+   Look up the deletion of PATH@START up to END in the path index of FS
+   and set *DELETED to the result.  Set *AVAILABLE to FALSE if FS does
+   not provide such an index or it is not up to date.  Otherwise, set it
+   to TRUE.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+query_deleted_rev(svn_boolean_t *available,
+                  svn_revnum_t *deleted,
+                  svn_fs_t *fs,
+                  const char *path,
+                  svn_revnum_t start,
+                  svn_revnum_t end,
+                  apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__ioctl_path_index_deleted_rev_input_t input;
+  svn_fs_fs__ioctl_path_index_deleted_rev_output_t *output;
+  svn_error_t *err;
+
+  input.path = path;
+  input.start = start;
+  input.end = end;
+
+  err = svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_PATH_INDEX_DELETED_REV, &input,
+                     (void **)&output, NULL, NULL,
+                     scratch_pool, scratch_pool);
+  if (err && err->apr_err == SVN_ERR_FS_UNRECOGNIZED_IOCTL_CODE)
+    {
+      /* Not an FSFS repository. */
+      svn_error_clear(err);
+      *available = FALSE;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  *available = output->available;
+  if (*available)
+    *deleted = output->deleted;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_repos_deleted_rev(svn_fs_t *fs,
                       const char *path,
@@ -317,6 +406,7 @@ svn_repos_deleted_rev(svn_fs_t *fs,
   svn_revnum_t mid_rev;
   svn_node_kind_t kind;
   svn_fs_node_relation_t node_relation;
+  svn_boolean_t available;
 
   /* Validate the revision range. */
   if (! SVN_IS_VALID_REVNUM(start))
@@ -346,6 +436,13 @@ svn_repos_deleted_rev(svn_fs_t *fs,
       return SVN_NO_ERROR;
     }
 
+  /* The path index, if present, knows all deletions and replacements of
+     path and its parents.  That makes the probing below unnecessary. */
+  SVN_ERR(query_deleted_rev(&available, deleted, fs, path, start, end,
+                            pool));
+  if (available)
+    return SVN_NO_ERROR;
+
   /* Ensure path was deleted at or before end revision. */
   SVN_ERR(svn_fs_revision_root(&root, fs, end, pool));
   SVN_ERR(svn_fs_check_path(&kind, root, path, pool));
@@ -574,6 +671,52 @@ check_ancestry_of_peg_path(svn_boolean_t *is_ancestor,
 }
 
 
+/* Ask the path index of FS where the node at PATH@REVISION started to
+   live at PATH.  Set *AVAILABLE to FALSE if FS does not provide such an
+   index or it does not cover the node's history.  Otherwise, set it to
+   TRUE, return that revision in *APPEARED_REV and, if the node has been
+   copied there, the corresponding location within the copy source in
+   *COPYFROM_PATH and *COPYFROM_REV.  If it has not been copied, set
+   *COPYFROM_PATH to NULL.  Allocate the result in RESULT_POOL and use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+query_copy_index(svn_boolean_t *available,
+                 svn_revnum_t *appeared_rev,
+                 const char **copyfrom_path,
+                 svn_revnum_t *copyfrom_rev,
+                 svn_fs_t *fs,
+                 const char *path,
+                 svn_revnum_t revision,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__ioctl_path_index_prev_copy_input_t input;
+  svn_fs_fs__ioctl_path_index_prev_copy_output_t *output;
+  svn_error_t *err;
+
+  input.path = path;
+  input.revision = revision;
+
+  err = svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_PATH_INDEX_PREV_COPY, &input,
+                     (void **)&output, NULL, NULL,
+                     result_pool, scratch_pool);
+  if (err && err->apr_err == SVN_ERR_FS_UNRECOGNIZED_IOCTL_CODE)
+    {
+      /* Not an FSFS repository. */
+      svn_error_clear(err);
+      *available = FALSE;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  *available = output->available;
+  *appeared_rev = output->appeared_rev;
+  *copyfrom_path = output->copyfrom_path;
+  *copyfrom_rev = output->copyfrom_rev;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_repos__prev_location(svn_revnum_t *appeared_rev,
                          const char **prev_path,
@@ -585,7 +728,8 @@ svn_repos__prev_location(svn_revnum_t *appeared_rev,
 {
   svn_fs_root_t *root, *copy_root;
   const char *copy_path, *copy_src_path, *remainder;
-  svn_revnum_t copy_src_rev;
+  svn_revnum_t copy_src_rev, copy_rev;
+  svn_boolean_t indexed;
 
   /* Initialize return variables. */
   if (appeared_rev)
@@ -595,6 +739,25 @@ svn_repos__prev_location(svn_revnum_t *appeared_rev,
   if (prev_path)
     *prev_path = NULL;
 
+  /* The path index, if present, knows the answer without any tree
+     walking. */
+  SVN_ERR(query_copy_index(&indexed, &copy_rev, &copy_src_path,
+                           &copy_src_rev, fs, path, revision, pool, pool));
+  if (indexed)
+    {
+      if (copy_src_path)
+        {
+          if (prev_path)
+            *prev_path = copy_src_path;
+          if (appeared_rev)
+            *appeared_rev = copy_rev;
+          if (prev_rev)
+            *prev_rev = copy_src_rev;
+        }
+
+      return SVN_NO_ERROR;
+    }
+
   /* Ask about the most recent copy which affected PATH@REVISION.  If
      there was no such copy, we're done.  */
   SVN_ERR(svn_fs_revision_root(&root, fs, revision, pool));
@@ -891,6 +1054,7 @@ svn_repos_node_location_segments(svn_repos_t *repos,
       svn_revnum_t appeared_rev, prev_rev;
       const char *cur_path, *prev_path;
       svn_location_segment_t *segment;
+      svn_boolean_t indexed;
 
       svn_pool_clear(subpool);
 
@@ -902,8 +1066,15 @@ svn_repos_node_location_segments(svn_repos_t *repos,
       /* segment path should be absolute without leading '/'. */
       segment->path = cur_path + 1;
 
-      SVN_ERR(svn_repos__prev_location(&appeared_rev, &prev_path, &prev_rev,
-                                       fs, current_rev, cur_path, subpool));
+      /* If the path index knows this node, it also tells us where the
+         node originated in case it has not been copied. */
+      SVN_ERR(query_copy_index(&indexed, &appeared_rev, &prev_path,
+                               &prev_rev, fs, cur_path, current_rev,
+                               subpool, subpool));
+      if (! indexed)
+        SVN_ERR(svn_repos__prev_location(&appeared_rev, &prev_path,
+                                         &prev_rev, fs, current_rev,
+                                         cur_path, subpool));
 
       /* If there are no previous locations for this thing (meaning,
          it originated at the current path), then we simply need to
@@ -912,10 +1083,18 @@ svn_repos_node_location_segments(svn_repos_t *repos,
          range. */
       if (! prev_path)
         {
-          svn_fs_root_t *revroot;
-          SVN_ERR(svn_fs_revision_root(&revroot, fs, current_rev, subpool));
-          SVN_ERR(svn_fs_node_origin_rev(&(segment->range_start), revroot,
-                                         cur_path, subpool));
+          if (indexed)
+            {
+              segment->range_start = appeared_rev;
+            }
+          else
+            {
+              svn_fs_root_t *revroot;
+              SVN_ERR(svn_fs_revision_root(&revroot, fs, current_rev,
+                                           subpool));
+              SVN_ERR(svn_fs_node_origin_rev(&(segment->range_start),
+                                             revroot, cur_path, subpool));
+            }
           if (segment->range_start < end_rev)
             segment->range_start = end_rev;
           current_rev = SVN_INVALID_REVNUM;
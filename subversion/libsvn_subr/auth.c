@@ -729,6 +729,22 @@ svn_auth_get_platform_specific_client_providers(apr_array_header_t **providers,
   return SVN_NO_ERROR;
 }
 
+void
+svn_auth__copy_baton(svn_auth_baton_t **copy,
+                     const svn_auth_baton_t *auth_baton,
+                     apr_pool_t *result_pool)
+{
+  struct svn_auth_baton_t *ab;
+
+  ab = apr_pmemdup(result_pool, auth_baton, sizeof(*ab));
+  ab->parameters = apr_hash_copy(result_pool, auth_baton->parameters);
+  ab->slave_parameters = NULL;
+  ab->creds_cache = apr_hash_copy(result_pool, auth_baton->creds_cache);
+  ab->pool = result_pool;
+
+  *copy = ab;
+}
+
 svn_error_t *
 svn_auth__make_session_auth(svn_auth_baton_t **session_auth_baton,
                             const svn_auth_baton_t *auth_baton,
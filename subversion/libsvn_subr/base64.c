@@ -33,6 +33,7 @@
 #include "svn_io.h"
 #include "svn_error.h"
 #include "svn_base64.h"
+#include "private/svn_atomic.h"
 #include "private/svn_string_private.h"
 #include "private/svn_subr_private.h"
 
@@ -50,6 +51,26 @@
 static const char base64tab[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ" \
                                 "abcdefghijklmnopqrstuvwxyz0123456789+/";
 
+/* 12 bit value -> pair of base64 chars mapping table (2^12 entries of
+   2 chars each), filled in from base64tab by init_base64_pairs(). */
+static char base64_pairs[2 << 12];
+static volatile svn_atomic_t base64_pairs_init_state = 0;
+
+/* Implements svn_atomic__str_init_func_t, filling in base64_pairs. */
+static const char *
+init_base64_pairs(void *baton)
+{
+  int i;
+
+  for (i = 0; i < (1 << 12); i++)
+    {
+      base64_pairs[2 * i] = base64tab[i >> 6];
+      base64_pairs[2 * i + 1] = base64tab[i & 0x3f];
+    }
+
+  return NULL;
+}
+
 
 /* Binary input --> base64-encoded output */
 
@@ -92,7 +113,7 @@ encode_group(const unsigned char *in, char *out)
    performing any boundary checks.  Therefore, DATA must have at least
    BYTES_PER_LINE left and space for at least another BASE64_LINELEN
    chars must have been pre-allocated in STR before calling this
-   function. */
+   function.  base64_pairs must have been initialized. */
 static void
 encode_line(svn_stringbuf_t *str, const char *data)
 {
@@ -102,9 +123,16 @@ encode_line(svn_stringbuf_t *str, const char *data)
   char *end = out + BASE64_LINELEN;
 
   /* We assume that BYTES_PER_LINE is a multiple of 3 and BASE64_LINELEN
-     a multiple of 4. */
+     a multiple of 4.  Look up each group as two halves of 12 bits. */
   for ( ; out != end; in += 3, out += 4)
-    encode_group(in, out);
+    {
+      apr_size_t group = ((apr_size_t)in[0] << 16)
+                       | ((apr_size_t)in[1] << 8)
+                       | in[2];
+
+      memcpy(out, base64_pairs + 2 * (group >> 12), 2);
+      memcpy(out + 2, base64_pairs + 2 * (group & 0xfff), 2);
+    }
 
   /* Expand and terminate the string. */
   *out = '\0';
@@ -128,6 +156,9 @@ encode_bytes(svn_stringbuf_t *str, const void *data, apr_size_t len,
   const char *p = data, *end = p + len;
   apr_size_t buflen;
 
+  svn_atomic__init_once_no_error(&base64_pairs_init_state,
+                                 init_base64_pairs, NULL);
+
   /* Resize the stringbuf to make room for the (approximate) size of
      output, to avoid repeated resizes later.
      Please note that our optimized code relies on the fact that STR
@@ -431,8 +462,18 @@ decode_bytes(svn_stringbuf_t *str, const char *data, apr_size_t len,
          one line-sized chunk left to decode, we may use the optimized
          code path. */
       if ((*inbuflen == 0) && (end - p >= BASE64_LINELEN))
-        if (decode_line(str, &p))
-          continue;
+        {
+          /* Skip the line break between two full lines right away,
+             instead of letting decode_line fail on it. */
+          if (*p == '\n')
+            {
+              ++p;
+              continue;
+            }
+
+          if (decode_line(str, &p))
+            continue;
+        }
 
       /* A special case or decode_line encountered a special char. */
       if (*p == '=')
@@ -640,7 +640,8 @@ static svn_cache__vtable_t inprocess_cache_vtable = {
   inprocess_cache_is_cachable,
   inprocess_cache_get_partial,
   inprocess_cache_set_partial,
-  inprocess_cache_get_info
+  inprocess_cache_get_info,
+  NULL                                    /* get_many: use fallback */
 };
 
 svn_error_t *
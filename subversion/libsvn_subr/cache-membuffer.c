@@ -24,13 +24,23 @@
 #include <assert.h>
 #include <apr_md5.h>
 #include <apr_thread_rwlock.h>
+#include <apr_shm.h>
+#include <apr_time.h>
+
+#if __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
 
 #include "svn_pools.h"
 #include "svn_checksum.h"
 #include "svn_private_config.h"
 #include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_dirent_uri.h"
 #include "svn_string.h"
 #include "svn_sorts.h"  /* get the MIN macro */
+#include "svn_version.h"
 
 #include "private/svn_atomic.h"
 #include "private/svn_dep_compat.h"
@@ -72,6 +82,17 @@
  * caching for the last N bytes where N is the size of L1.  L2 uses a more
  * elaborate scheme based on priorities and hit counts as described below.
  *
+ * The boundary between L1 and L2 is not fixed.  Every segment compares the
+ * hits per byte in both levels and moves the boundary step by step towards
+ * the level that gets used more intensively (see adapt_levels).  Similarly,
+ * items whose prefix rarely sees its data being read back get stored with
+ * a reduced priority (see prefix_pool_adjust_priority).
+ *
+ * Front-ends may be assigned to quota groups, e.g. one per repository,
+ * that soft-limit the share of the data buffer those front-ends may
+ * occupy (see quota_group_t).  This prevents a single tenant of a busy
+ * server from flushing everybody else's data out of the cache.
+ *
  * The data buffer usage information is implicitly given by the directory
  * entries. Every USED entry has a reference to the previous and the next
  * used dictionary entry and this double-linked list is ordered by the
@@ -129,6 +150,28 @@
  * to scale well despite that bottleneck, we simply segment the cache into
  * a number of independent caches (segments). Items will be multiplexed based
  * on their hash key.
+ *
+ * On NUMA machines, the segments may further be grouped into partitions,
+ * one per node.  Writes go to the writer's local partition and remove the
+ * item from all others, i.e. there is at most one copy of every item in
+ * the whole cache.  Reads try the local partition first and fall back to
+ * the remote ones.  Because the buffers get touched lazily, their memory
+ * pages tend to get allocated on the node that uses the partition.
+ *
+ * Pre-forking servers may place the whole cache into a shared memory
+ * segment (see svn_cache__membuffer_cache_create_shared).  All processes
+ * forked after its creation then share the same cache contents.  Since
+ * the segment gets mapped to the same address in all of them, the native
+ * pointers in the segment headers remain valid.  Access is serialized by
+ * a spin lock per segment that lives in the shared memory itself.  The
+ * prefix pool, on the other hand, is process-local and therefore disabled
+ * in that mode, i.e. all entries carry their full keys.
+ *
+ * To survive server restarts, the cache contents may be written to a
+ * snapshot file and loaded again into a new cache instance (see
+ * svn_cache__membuffer_save).  Because entry fingerprints only depend on
+ * the prefix string and the key, the items can simply be re-inserted
+ * with their prefix indexes mapped to the new prefix pool.
  */
 
 /* APR's read-write lock implementation on Windows is horribly inefficient.
@@ -146,6 +189,30 @@
 #  define USE_SIMPLE_MUTEX 0
 #endif
 
+/* Readers of thread-safe caches may first try to read an item without
+ * taking the segment lock.  Every writer increments the segment's
+ * WRITE_SEQUENCE before and after modifying it, i.e. the number is odd
+ * while a modification is in progress.  A reader that sees the same even
+ * number before and after copying the data knows that its copy is
+ * consistent.  Otherwise, it falls back to reading under the lock.
+ *
+ * This requires acquire semantics for the sequence number reads.  APR does
+ * not provide those, so the optimistic path is only available with GCC
+ * compatible compilers.  It is also disabled when debugging the cache
+ * because the tag checks need a stable entry.  Define
+ * SVN_MEMBUFFER_DISABLE_LOCK_FREE_READS to disable it, e.g. to compare
+ * the scalability of both variants.
+ */
+#if APR_HAS_THREADS && defined(__ATOMIC_ACQUIRE) \
+    && !defined(SVN_DEBUG_CACHE_MEMBUFFER) \
+    && !defined(SVN_MEMBUFFER_DISABLE_LOCK_FREE_READS)
+#  define USE_LOCK_FREE_READS 1
+#  define SEQUENCE_READ(mem) __atomic_load_n((mem), __ATOMIC_ACQUIRE)
+#  define READ_FENCE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#else
+#  define USE_LOCK_FREE_READS 0
+#endif
+
 /* For more efficient copy operations, let's align all data items properly.
  * Since we can't portably align pointers, this is rather the item size
  * granularity which ensures *relative* alignment within the cache - still
@@ -240,6 +307,39 @@ typedef struct full_key_t
   svn_membuf_t full_key;
 } full_key_t;
 
+/* Maximum number of prefix classes that we track statistics for, i.e.
+ * distinct types of cached data.  Anything beyond that will be counted
+ * in the catch-all class.
+ */
+#define MAX_PREFIX_CLASSES 64
+
+/* Cache usage of a group of front-ends, e.g. of all caches of one
+ * repository (see svn_cache__membuffer_set_quota).  The usage is tracked
+ * across all segments.
+ *
+ * The quota is soft.  A group that exceeds it may still fill free space
+ * but its new items don't evict items of groups that are within their
+ * quotas.  Its items also don't get promoted from L1 to L2 and are the
+ * first to be evicted from L2 when others need room.
+ */
+typedef struct quota_group_t
+{
+  /* Name of the group as given by the front-ends.  Never changes. */
+  const char *name;
+
+  /* Maximum number of ITEM_ALIGNMENT units that the items of this group
+   * shall occupy.  0 means "unlimited". */
+  volatile svn_atomic_t quota;
+
+  /* Number of ITEM_ALIGNMENT units currently occupied by the items of this
+   * group.  Different segments update this concurrently, hence atomic. */
+  volatile svn_atomic_t used;
+
+  /* Number of items that were not cached because the group exceeded its
+   * quota.  Updates are not synchronized. */
+  apr_uint64_t throttled;
+} quota_group_t;
+
 /* A limited capacity, thread-safe pool of unique C strings.  Operations on
  * this data structure are defined by prefix_pool_* functions.  The only
  * "public" member is VALUES (r/o access only).
@@ -267,6 +367,36 @@ typedef struct prefix_pool_t
    * the implementation may . */
   apr_size_t bytes_used;
 
+  /* Number of hits and of write attempts per prefix, VALUES_MAX elements
+   * each.  Both get halved once WRITES reaches PREFIX_STATS_WINDOW, i.e.
+   * they reflect recent usage.  Used to adapt item priorities per prefix.
+   * Updates are not synchronized and values may be slightly off. */
+  apr_uint32_t *hits;
+  apr_uint32_t *writes;
+
+  /* Cumulative statistics per prefix class, CLASS_COUNT of which are in
+   * use.  Entry 0 is the catch-all class.  Entries are never removed.
+   * Updates are not synchronized. */
+  svn_cache__prefix_stats_t classes[MAX_PREFIX_CLASSES];
+  apr_uint32_t class_count;
+
+  /* Index into CLASSES for every prefix, VALUES_MAX elements. */
+  apr_uint32_t *value_class;
+
+  /* Quota groups, VALUES_MAX elements of which GROUP_COUNT are in use.
+   * Entry 0 is a dummy and means "no group".  Entries are never removed.
+   * May be NULL if VALUES_MAX is 0. */
+  quota_group_t *groups;
+  apr_uint32_t group_count;
+
+  /* Map group names to elements of GROUPS. */
+  apr_hash_t *group_map;
+
+  /* Index into GROUPS for every prefix, VALUES_MAX elements.  Once set,
+   * it never changes because items must be released from the same group
+   * that they have been accounted to. */
+  apr_uint32_t *value_group;
+
   /* The serialization object. */
   svn_mutex__t *mutex;
 } prefix_pool_t;
@@ -304,8 +434,31 @@ prefix_pool_create(prefix_pool_t **prefix_pool,
   result->values_max = (apr_uint32_t)capacity;
   result->values_used = 0;
 
+  result->hits = capacity
+               ? apr_pcalloc(result_pool, capacity * sizeof(apr_uint32_t))
+               : NULL;
+  result->writes = capacity
+                 ? apr_pcalloc(result_pool, capacity * sizeof(apr_uint32_t))
+                 : NULL;
+  result->value_class = capacity
+                 ? apr_pcalloc(result_pool, capacity * sizeof(apr_uint32_t))
+                 : NULL;
+  result->value_group = capacity
+                 ? apr_pcalloc(result_pool, capacity * sizeof(apr_uint32_t))
+                 : NULL;
+  result->groups = capacity
+                 ? apr_pcalloc(result_pool, capacity * sizeof(quota_group_t))
+                 : NULL;
+  result->group_count = 1;
+  result->group_map = svn_hash__make(result_pool);
+
+  result->classes[0].name = "(other)";
+  result->class_count = 1;
+
   result->bytes_max = bytes_max;
-  result->bytes_used = capacity * sizeof(svn_membuf_t);
+  result->bytes_used = capacity * (sizeof(svn_membuf_t)
+                                   + sizeof(quota_group_t)
+                                   + 4 * sizeof(apr_uint32_t));
 
   SVN_ERR(svn_mutex__init(&result->mutex, mutex_required, result_pool));
 
@@ -391,6 +544,281 @@ prefix_pool_get(apr_uint32_t *prefix_idx,
   return SVN_NO_ERROR;
 }
 
+/* Return the name of the prefix class that PREFIX belongs to, i.e. the
+ * part after the last colon.  Trailing colons are ignored.  The result
+ * may be empty and is neither NUL-terminated nor a copy; its length is
+ * returned in *LEN.
+ */
+static const char *
+get_prefix_class_name(apr_size_t *len,
+                      const char *prefix)
+{
+  const char *end = prefix + strlen(prefix);
+  const char *start;
+
+  while (end > prefix && end[-1] == ':')
+    --end;
+
+  for (start = end; start > prefix && start[-1] != ':'; --start)
+    ;
+
+  *len = end - start;
+  return start;
+}
+
+/* Return the index of the prefix class with the NAME of length LEN in
+ * PREFIX_POOL or 0, if there is no such class.
+ */
+static apr_uint32_t
+find_prefix_class(prefix_pool_t *prefix_pool,
+                  const char *name,
+                  apr_size_t len)
+{
+  apr_uint32_t count = prefix_pool->class_count;
+  apr_uint32_t i;
+
+  for (i = 1; i < count; ++i)
+    {
+      /* Classes may get added concurrently. */
+      const char *class_name = prefix_pool->classes[i].name;
+      if (   class_name
+          && strncmp(class_name, name, len) == 0
+          && class_name[len] == '\0')
+        return i;
+    }
+
+  return 0;
+}
+
+/* Set *CLASS_IDX to the index of the statistics class for PREFIX in
+ * PREFIX_POOL.  Auto-insert the class if it does not exist, yet, and we
+ * have not reached MAX_PREFIX_CLASSES.  To be called by
+ * prefix_pool_get_class() only.
+ */
+static svn_error_t *
+prefix_pool_get_class_internal(apr_uint32_t *class_idx,
+                               prefix_pool_t *prefix_pool,
+                               const char *prefix)
+{
+  apr_size_t len;
+  const char *name = get_prefix_class_name(&len, prefix);
+
+  *class_idx = find_prefix_class(prefix_pool, name, len);
+  if (*class_idx == 0 && len && prefix_pool->class_count < MAX_PREFIX_CLASSES)
+    {
+      *class_idx = prefix_pool->class_count;
+      prefix_pool->classes[*class_idx].name
+        = apr_pstrmemdup(apr_hash_pool_get(prefix_pool->map), name, len);
+      prefix_pool->class_count++;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread-safe wrapper around prefix_pool_get_class_internal. */
+static svn_error_t *
+prefix_pool_get_class(apr_uint32_t *class_idx,
+                      prefix_pool_t *prefix_pool,
+                      const char *prefix)
+{
+  SVN_MUTEX__WITH_LOCK(prefix_pool->mutex,
+                       prefix_pool_get_class_internal(class_idx, prefix_pool,
+                                                      prefix));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the statistics class in PREFIX_POOL for an item with KEY.
+ * If KEY does not use a pooled prefix, FULL_KEY must point to the full
+ * key as stored in the cache.  Falls back to the catch-all class.
+ */
+static svn_cache__prefix_stats_t *
+get_key_class(prefix_pool_t *prefix_pool,
+              const entry_key_t *key,
+              const char *full_key)
+{
+  apr_uint32_t class_idx = 0;
+
+  if (key->prefix_idx < prefix_pool->values_max)
+    {
+      class_idx = prefix_pool->value_class[key->prefix_idx];
+    }
+  else if (key->key_len && memchr(full_key, 0, key->key_len))
+    {
+      apr_size_t len;
+      const char *name = get_prefix_class_name(&len, full_key);
+      class_idx = find_prefix_class(prefix_pool, name, len);
+    }
+
+  return &prefix_pool->classes[class_idx];
+}
+
+/* Number of writes per prefix after which the prefix statistics will be
+ * halved.  Adaptation to changing workloads becomes faster with smaller
+ * values but the priority adjustments will be less reliable.
+ */
+#define PREFIX_STATS_WINDOW 1024
+
+/* Minimum number of writes per prefix before we adapt its priority.
+ */
+#define PREFIX_STATS_MIN_SAMPLE 64
+
+/* Count a hit for PREFIX_IDX in PREFIX_POOL.  PREFIX_IDX may be NO_INDEX
+ * or otherwise out of range, in which case nothing will be counted.
+ */
+static APR_INLINE void
+prefix_pool_count_hit(prefix_pool_t *prefix_pool,
+                      apr_uint32_t prefix_idx)
+{
+  if (prefix_idx < prefix_pool->values_max)
+    prefix_pool->hits[prefix_idx]++;
+}
+
+/* Count a write attempt for PREFIX_IDX in PREFIX_POOL and age the
+ * statistics for that prefix, if necessary.  PREFIX_IDX may be NO_INDEX.
+ */
+static void
+prefix_pool_count_write(prefix_pool_t *prefix_pool,
+                        apr_uint32_t prefix_idx)
+{
+  if (prefix_idx < prefix_pool->values_max)
+    {
+      if (++prefix_pool->writes[prefix_idx] >= PREFIX_STATS_WINDOW)
+        {
+          prefix_pool->writes[prefix_idx] /= 2;
+          prefix_pool->hits[prefix_idx] /= 2;
+        }
+    }
+}
+
+/* Return whether the recent statistics in PREFIX_POOL show that items
+ * written for PREFIX_IDX are rarely being read back.
+ */
+static svn_boolean_t
+prefix_pool_is_unproductive(prefix_pool_t *prefix_pool,
+                            apr_uint32_t prefix_idx)
+{
+  apr_uint32_t writes;
+
+  if (prefix_idx >= prefix_pool->values_max)
+    return FALSE;
+
+  writes = prefix_pool->writes[prefix_idx];
+  return writes >= PREFIX_STATS_MIN_SAMPLE
+      && prefix_pool->hits[prefix_idx] < writes;
+}
+
+/* Return the priority to use for an item with PREFIX_IDX in PREFIX_POOL
+ * that has been requested to be stored with PRIORITY.
+ *
+ * Prefixes whose items get read back less than once on average will have
+ * their priority reduced to as little as 50%.  This makes room for the
+ * data that is actually being used by the current workload.  We never
+ * move an item into a lower priority class, though.
+ */
+static apr_uint32_t
+prefix_pool_adjust_priority(prefix_pool_t *prefix_pool,
+                            apr_uint32_t prefix_idx,
+                            apr_uint32_t priority)
+{
+  apr_uint64_t hits, writes, adjusted, lower_bound;
+
+  if (!prefix_pool_is_unproductive(prefix_pool, prefix_idx))
+    return priority;
+
+  writes = prefix_pool->writes[prefix_idx];
+  hits = MIN(prefix_pool->hits[prefix_idx], writes);
+  adjusted = priority / 2 + (priority * hits) / (2 * writes);
+
+  if (priority > SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY)
+    lower_bound = SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY + 1;
+  else if (priority > SVN_CACHE__MEMBUFFER_LOW_PRIORITY)
+    lower_bound = SVN_CACHE__MEMBUFFER_LOW_PRIORITY + 1;
+  else
+    lower_bound = 1;
+
+  return (apr_uint32_t)MAX(adjusted, MIN(lower_bound, priority));
+}
+
+/* Assign PREFIX_IDX in PREFIX_POOL to the quota group NAME, unless it has
+ * been assigned to some group before, and set the QUOTA of that group.
+ * Auto-insert the group if it does not exist, yet.  If we run out of
+ * capacity, the prefix will not be subject to any quota.  To be called
+ * by prefix_pool_set_quota() only.
+ */
+static svn_error_t *
+prefix_pool_set_quota_internal(prefix_pool_t *prefix_pool,
+                               apr_uint32_t prefix_idx,
+                               const char *name,
+                               apr_uint32_t quota)
+{
+  quota_group_t *group = apr_hash_get(prefix_pool->group_map, name,
+                                      APR_HASH_KEY_STRING);
+  if (!group)
+    {
+      if (prefix_pool->group_count == prefix_pool->values_max)
+        return SVN_NO_ERROR;
+
+      group = &prefix_pool->groups[prefix_pool->group_count];
+      group->name = apr_pstrdup(apr_hash_pool_get(prefix_pool->map), name);
+      apr_hash_set(prefix_pool->group_map, group->name, APR_HASH_KEY_STRING,
+                   group);
+      prefix_pool->group_count++;
+    }
+
+  svn_atomic_set(&group->quota, quota);
+  if (prefix_pool->value_group[prefix_idx] == 0)
+    prefix_pool->value_group[prefix_idx]
+      = (apr_uint32_t)(group - prefix_pool->groups);
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread-safe wrapper around prefix_pool_set_quota_internal. */
+static svn_error_t *
+prefix_pool_set_quota(prefix_pool_t *prefix_pool,
+                      apr_uint32_t prefix_idx,
+                      const char *name,
+                      apr_uint32_t quota)
+{
+  SVN_MUTEX__WITH_LOCK(prefix_pool->mutex,
+                       prefix_pool_set_quota_internal(prefix_pool,
+                                                      prefix_idx, name,
+                                                      quota));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the quota group in PREFIX_POOL that items with KEY are accounted
+ * to or NULL, if they are not subject to any quota.
+ */
+static APR_INLINE quota_group_t *
+get_quota_group(prefix_pool_t *prefix_pool,
+                const entry_key_t *key)
+{
+  apr_uint32_t group_idx;
+
+  if (key->prefix_idx >= prefix_pool->values_max)
+    return NULL;
+
+  group_idx = prefix_pool->value_group[key->prefix_idx];
+  return group_idx ? &prefix_pool->groups[group_idx] : NULL;
+}
+
+/* Return whether GROUP, which may be NULL, occupies more than its quota.
+ */
+static APR_INLINE svn_boolean_t
+is_over_quota(quota_group_t *group)
+{
+  apr_uint32_t quota;
+
+  if (!group)
+    return FALSE;
+
+  quota = svn_atomic_read(&group->quota);
+  return quota && svn_atomic_read(&group->used) > quota;
+}
+
 /* Debugging / corruption detection support.
  * If you define this macro, the getter functions will performed expensive
  * checks on the item data, requested keys and entry types. If there is
@@ -692,6 +1120,119 @@ typedef struct cache_level_t
 
 } cache_level_t;
 
+/* Optionally, large items have to pass a TinyLFU-style admission filter
+ * before they may evict other entries.  Scans like 'svn export' write
+ * many large fulltexts that will never be read again and would otherwise
+ * flush the working set from the cache.
+ *
+ * The filter is a count-min sketch over the keys of all read requests.
+ * An item larger than ADMISSION_FILTER_MIN_SIZE will only be inserted if
+ * its estimated access frequency is higher than that of every entry that
+ * would have to be evicted for it.  To adapt to changing workloads, all
+ * counters get halved after 10 increments per counter on average.
+ */
+
+/* Number of rows, i.e. hash functions, in the count-min sketch. */
+#define ADMISSION_FILTER_DEPTH 4
+
+/* Counters saturate at this value. */
+#define ADMISSION_FILTER_MAX_COUNT 15
+
+/* Smaller items are always admitted. */
+#define ADMISSION_FILTER_MIN_SIZE 0x10000
+
+/* Pass this as frequency to disable the admission check. */
+#define ALWAYS_ADMIT APR_UINT32_MAX
+
+/* Count-min sketch of the access frequencies in one cache segment.
+ * Updates are not synchronized, i.e. the counts are approximate.
+ */
+typedef struct admission_filter_t
+{
+  /* ADMISSION_FILTER_DEPTH rows of WIDTH counters each. */
+  unsigned char *counters;
+
+  /* Number of counters per row.  Must be a power of 2. */
+  apr_uint32_t width;
+
+  /* Number of increments since the last aging. */
+  apr_uint32_t additions;
+
+  /* Age the counters once ADDITIONS reaches this value. */
+  apr_uint32_t sample_size;
+} admission_filter_t;
+
+/* Set *INDEXES to the counter positions of KEY in FILTER, one per row.
+ */
+static void
+admission_filter_indexes(apr_uint32_t indexes[ADMISSION_FILTER_DEPTH],
+                         const admission_filter_t *filter,
+                         const entry_key_t *key)
+{
+  /* The fingerprint is already well-distributed.  Mix it a bit more
+   * because some of its bits select the segment and group already. */
+  apr_uint64_t hash = key->fingerprint[0]
+                    ^ (key->fingerprint[1] * APR_UINT64_C(0x9e3779b97f4a7c15));
+  apr_uint32_t h1 = (apr_uint32_t)hash;
+  apr_uint32_t h2 = (apr_uint32_t)(hash >> 32) | 1;
+  int i;
+
+  for (i = 0; i < ADMISSION_FILTER_DEPTH; ++i)
+    indexes[i] = i * filter->width + ((h1 + i * h2) & (filter->width - 1));
+}
+
+/* Count an access to KEY in FILTER.
+ */
+static void
+admission_filter_add(admission_filter_t *filter,
+                     const entry_key_t *key)
+{
+  apr_uint32_t indexes[ADMISSION_FILTER_DEPTH];
+  int i;
+
+  admission_filter_indexes(indexes, filter, key);
+  for (i = 0; i < ADMISSION_FILTER_DEPTH; ++i)
+    if (filter->counters[indexes[i]] < ADMISSION_FILTER_MAX_COUNT)
+      filter->counters[indexes[i]]++;
+
+  filter->additions++;
+}
+
+/* Return the estimated access frequency of KEY in FILTER.
+ */
+static apr_uint32_t
+admission_filter_estimate(const admission_filter_t *filter,
+                          const entry_key_t *key)
+{
+  apr_uint32_t indexes[ADMISSION_FILTER_DEPTH];
+  apr_uint32_t result = ADMISSION_FILTER_MAX_COUNT;
+  int i;
+
+  admission_filter_indexes(indexes, filter, key);
+  for (i = 0; i < ADMISSION_FILTER_DEPTH; ++i)
+    result = MIN(result, filter->counters[indexes[i]]);
+
+  return result;
+}
+
+/* Halve all counters in FILTER if enough accesses have been counted
+ * since the last aging.
+ */
+static void
+admission_filter_age(admission_filter_t *filter)
+{
+  apr_size_t i;
+  apr_size_t count = (apr_size_t)filter->width * ADMISSION_FILTER_DEPTH;
+
+  if (filter->additions < filter->sample_size)
+    return;
+
+  for (i = 0; i < count; ++i)
+    filter->counters[i] /= 2;
+
+  filter->additions = 0;
+}
+
 /* The cache header structure.
  */
 struct svn_membuffer_t
@@ -701,6 +1242,13 @@ struct svn_membuffer_t
      and that all segments must / will report the same values here. */
   apr_uint32_t segment_count;
 
+  /* Number of NUMA partitions that the segments are split into.  Must be
+     a power of 2 and not exceed SEGMENT_COUNT.  Partition P consists of
+     the SEGMENT_COUNT / PARTITION_COUNT consecutive segments starting at
+     P * SEGMENT_COUNT / PARTITION_COUNT.  All segments report the same
+     value here. */
+  apr_uint32_t partition_count;
+
   /* Collection of prefixes shared among all instances accessing the
    * same membuffer cache backend.  If a prefix is contained in this
    * pool then all cache instances using an equal prefix must actually
@@ -739,6 +1287,11 @@ struct svn_membuffer_t
    */
   unsigned char *data;
 
+  /* Size of DATA in bytes.  This is the combined size of L1 and L2 and
+   * never changes.
+   */
+  apr_uint64_t data_size;
+
   /* Total number of data buffer bytes in use.
    */
   apr_uint64_t data_used;
@@ -767,6 +1320,32 @@ struct svn_membuffer_t
    */
   cache_level_t l2;
 
+  /* The share of DATA that is assigned to L1 adapts to the workload.
+   * Streaming workloads that read items shortly after they have been
+   * written benefit from a large L1 while workloads that re-use data
+   * over a long time need a large L2.  See adapt_levels().
+   */
+
+  /* Number of hits in L1 and L2, respectively, since the last adaptation.
+   * Halved with every adaptation.  Updates are not synchronized.
+   */
+  apr_uint64_t l1_hits;
+  apr_uint64_t l2_hits;
+
+  /* Number of bytes to write to this segment until the next adaptation.
+   */
+  apr_uint64_t adapt_countdown;
+
+  /* Number of times that the size of L1 has been changed.
+   * Purely statistical information.
+   */
+  apr_uint64_t l1_resizes;
+
+  /* Admission filter for large items.  NULL if disabled.
+   * See svn_cache__membuffer_enable_admission_filter().
+   */
+  admission_filter_t *admission;
+
 
   /* Number of used dictionary entries, i.e. number of cached items.
    * Purely statistical information that may be used for profiling only.
@@ -796,6 +1375,14 @@ struct svn_membuffer_t
    */
   apr_uint64_t total_hits;
 
+  /* Number of those hits that happened for threads running on another
+   * NUMA node than the one this segment's partition is associated with.
+   * Purely statistical information that may be used for profiling only.
+   * Updates are not synchronized and values may be nonsensicle on some
+   * platforms.
+   */
+  apr_uint64_t remote_hits;
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   /* A lock for intra-process synchronization to the cache, or NULL if
    * the cache's creator doesn't feel the cache needs to be
@@ -817,17 +1404,84 @@ struct svn_membuffer_t
    * This one is only used in debug assertions to verify that you used
    * the correct multi-threading settings. */
   svn_atomic_t write_lock_count;
+
+  /* Incremented before and after every modification of this segment, i.e.
+   * odd while a writer is active.  See USE_LOCK_FREE_READS. */
+  volatile svn_atomic_t write_sequence;
+
+  /* If set, this segment lives in shared memory and is accessible from
+   * multiple processes.  SHARED_LOCK is then used instead of LOCK. */
+  svn_boolean_t shared;
+
+  /* Process-shared spin lock.  0 if unlocked, 1 if locked.  Unused unless
+   * SHARED is set. */
+  volatile svn_atomic_t shared_lock;
+
+  /* Same as ALLOW_BLOCKING_WRITES but for SHARED_LOCK. */
+  svn_boolean_t shared_blocking_writes;
 };
 
 /* Align integer VALUE to the next ITEM_ALIGNMENT boundary.
  */
 #define ALIGN_VALUE(value) (((value) + ITEM_ALIGNMENT-1) & -ITEM_ALIGNMENT)
 
+/* Number of failed attempts to get a SHARED_LOCK before we start sleeping
+ * between attempts.
+ */
+#define SHARED_LOCK_SPIN_COUNT 100
+
+/* Try to acquire CACHE->SHARED_LOCK and return TRUE upon success.
+ */
+static APR_INLINE svn_boolean_t
+try_lock_shared(svn_membuffer_t *cache)
+{
+  return svn_atomic_cas(&cache->shared_lock, 1, 0) == 0;
+}
+
+/* Acquire CACHE->SHARED_LOCK, waiting as long as necessary.  Segments are
+ * only locked for short periods of time, so spin for a while before
+ * giving up our time slice.
+ */
+static void
+lock_shared(svn_membuffer_t *cache)
+{
+  int attempts = 0;
+  while (!try_lock_shared(cache))
+    if (++attempts > SHARED_LOCK_SPIN_COUNT)
+      apr_sleep(1);
+}
+
+/* Release CACHE->SHARED_LOCK.  The CAS provides the necessary barrier.
+ */
+static APR_INLINE void
+unlock_shared(svn_membuffer_t *cache)
+{
+  svn_atomic_cas(&cache->shared_lock, 0, 1);
+}
+
+/* Return whether accesses to CACHE need to be synchronized.
+ */
+static APR_INLINE svn_boolean_t
+is_synchronized(svn_membuffer_t *cache)
+{
+#if APR_HAS_THREADS
+  return cache->shared || cache->lock != NULL;
+#else
+  return cache->shared;
+#endif
+}
+
 /* If locking is supported for CACHE, acquire a read lock for it.
  */
 static svn_error_t *
 read_lock_cache(svn_membuffer_t *cache)
 {
+  if (cache->shared)
+    {
+      lock_shared(cache);
+      return SVN_NO_ERROR;
+    }
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -851,6 +1505,16 @@ read_lock_cache(svn_membuffer_t *cache)
 static svn_error_t *
 write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
 {
+  if (cache->shared)
+    {
+      if (cache->shared_blocking_writes)
+        lock_shared(cache);
+      else if (!try_lock_shared(cache))
+        *success = FALSE;
+
+      return SVN_NO_ERROR;
+    }
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -888,6 +1552,12 @@ write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
 static svn_error_t *
 force_write_lock_cache(svn_membuffer_t *cache)
 {
+  if (cache->shared)
+    {
+      lock_shared(cache);
+      return SVN_NO_ERROR;
+    }
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -908,6 +1578,12 @@ force_write_lock_cache(svn_membuffer_t *cache)
 static svn_error_t *
 unlock_cache(svn_membuffer_t *cache, svn_error_t *err)
 {
+  if (cache->shared)
+    {
+      unlock_shared(cache);
+      return err;
+    }
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__unlock(cache->lock, err);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -927,16 +1603,34 @@ unlock_cache(svn_membuffer_t *cache, svn_error_t *err)
 #endif
 }
 
-/* If supported, guard the execution of EXPR with a read lock to CACHE.
- * The macro has been modeled after SVN_MUTEX__WITH_LOCK.
+/* Mark CACHE as being modified.  The caller must hold the write lock.
  */
-#define WITH_READ_LOCK(cache, expr)         \
-do {                                        \
-  SVN_ERR(read_lock_cache(cache));          \
-  SVN_ERR(unlock_cache(cache, (expr)));     \
-} while (0)
-
-/* If supported, guard the execution of EXPR with a write lock to CACHE.
+static APR_INLINE void
+begin_write(svn_membuffer_t *cache)
+{
+  svn_atomic_inc(&cache->write_sequence);
+}
+
+/* Mark the modification of CACHE as completed and return ERR.  The caller
+ * must hold the write lock.
+ */
+static APR_INLINE svn_error_t *
+end_write(svn_membuffer_t *cache, svn_error_t *err)
+{
+  svn_atomic_inc(&cache->write_sequence);
+  return err;
+}
+
+/* If supported, guard the execution of EXPR with a read lock to CACHE.
+ * The macro has been modeled after SVN_MUTEX__WITH_LOCK.
+ */
+#define WITH_READ_LOCK(cache, expr)         \
+do {                                        \
+  SVN_ERR(read_lock_cache(cache));          \
+  SVN_ERR(unlock_cache(cache, (expr)));     \
+} while (0)
+
+/* If supported, guard the execution of EXPR with a write lock to CACHE.
  * The macro has been modeled after SVN_MUTEX__WITH_LOCK.
  *
  * The write lock process is complicated if we don't allow to wait for
@@ -959,7 +1653,8 @@ do {                                                            \
       else                                                      \
         break;                                                  \
     }                                                           \
-  SVN_ERR(unlock_cache(cache, (expr)));                         \
+  begin_write(cache);                                           \
+  SVN_ERR(unlock_cache(cache, end_write(cache, (expr))));       \
 } while (0)
 
 /* Returns 0 if the entry group identified by GROUP_INDEX in CACHE has not
@@ -1199,6 +1894,46 @@ unchain_entry(svn_membuffer_t *cache,
     get_entry(cache, entry->next)->previous = entry->previous;
 }
 
+/* Return the number of ITEM_ALIGNMENT units that ENTRY occupies in the
+ * data buffer.
+ */
+static APR_INLINE apr_uint32_t
+get_quota_units(const entry_t *entry)
+{
+  return (apr_uint32_t)(ALIGN_VALUE((apr_uint64_t)entry->size)
+                        / ITEM_ALIGNMENT);
+}
+
+/* Account the used ENTRY of CACHE to its quota group, if any.
+ */
+static void
+quota_charge(svn_membuffer_t *cache, const entry_t *entry)
+{
+  quota_group_t *group = get_quota_group(cache->prefix_pool, &entry->key);
+  if (group)
+    apr_atomic_add32(&group->used, get_quota_units(entry));
+}
+
+/* Undo quota_charge for ENTRY of CACHE.
+ */
+static void
+quota_release(svn_membuffer_t *cache, const entry_t *entry)
+{
+  quota_group_t *group = get_quota_group(cache->prefix_pool, &entry->key);
+  if (group)
+    {
+      apr_uint32_t units = get_quota_units(entry);
+      apr_uint32_t used;
+
+      /* After svn_cache__membuffer_clear, the usage may be under-reported.
+       * Never let it wrap around. */
+      do
+        used = svn_atomic_read(&group->used);
+      while (svn_atomic_cas(&group->used, used > units ? used - units : 0,
+                            used) != used);
+    }
+}
+
 /* Remove the used ENTRY from the CACHE, i.e. make it "unused".
  * In contrast to insertion, removal is possible for any entry.
  */
@@ -1221,6 +1956,7 @@ drop_entry(svn_membuffer_t *cache, entry_t *entry)
    */
   cache->used_entries--;
   cache->data_used -= entry->size;
+  quota_release(cache, entry);
 
   /* extend the insertion window, if the entry happens to border it
    */
@@ -1289,6 +2025,17 @@ drop_entry(svn_membuffer_t *cache, entry_t *entry)
     free_spare_group(cache, last_group);
 }
 
+/* Remove the used ENTRY from the CACHE to make room for other data and
+ * count that eviction in the statistics of ENTRY's prefix class.
+ */
+static void
+evict_entry(svn_membuffer_t *cache, entry_t *entry)
+{
+  get_key_class(cache->prefix_pool, &entry->key,
+                cache->data + entry->offset)->evictions++;
+  drop_entry(cache, entry);
+}
+
 /* Insert ENTRY into the chain of used dictionary entries. The entry's
  * offset and size members must already have been initialized. Also,
  * the offset must match the beginning of the insertion window.
@@ -1314,6 +2061,7 @@ insert_entry(svn_membuffer_t *cache, entry_t *entry)
    */
   cache->used_entries++;
   cache->data_used += entry->size;
+  quota_charge(cache, entry);
   entry->hit_count = 0;
   group->header.used++;
 
@@ -1327,23 +2075,44 @@ insert_entry(svn_membuffer_t *cache, entry_t *entry)
   assert(level->current_data <= level->start_offset + level->size);
 }
 
+/* Return the index of the partition in the cache starting with SEGMENT0
+ * that is local to the NUMA node the calling thread currently runs on.
+ */
+static apr_uint32_t
+get_local_partition(svn_membuffer_t *segment0)
+{
+#if __linux__ && defined(SYS_getcpu)
+  unsigned int cpu, node;
+
+  if (   segment0->partition_count > 1
+      && syscall(SYS_getcpu, &cpu, &node, NULL) == 0)
+    return node & (segment0->partition_count - 1);
+#endif
+
+  return 0;
+}
+
 /* Map a KEY of 16 bytes to the CACHE and group that shall contain the
- * respective item.
+ * respective item within PARTITION.
  */
 static apr_uint32_t
 get_group_index(svn_membuffer_t **cache,
-                const entry_key_t *key)
+                const entry_key_t *key,
+                apr_uint32_t partition)
 {
   svn_membuffer_t *segment0 = *cache;
   apr_uint64_t key0 = key->fingerprint[0];
   apr_uint64_t key1 = key->fingerprint[1];
+  apr_uint32_t partition_size
+    = segment0->segment_count / segment0->partition_count;
 
   /* select the cache segment to use. they have all the same group_count.
    * Since key may not be well-distributed, pre-fold it to a smaller but
    * "denser" ranger.  The modulus is a prime larger than the largest
    * counts. */
-  *cache = &segment0[(key1 % APR_UINT64_C(2809637) + (key0 / 37))
-                     & (segment0->segment_count - 1)];
+  *cache = &segment0[partition * partition_size
+                     + ((key1 % APR_UINT64_C(2809637) + (key0 / 37))
+                        & (partition_size - 1))];
   return (key0 % APR_UINT64_C(5030895599)) % segment0->group_count;
 }
 
@@ -1453,7 +2222,7 @@ find_entry(svn_membuffer_t *cache,
               }
 
             /* need to empty that entry */
-            drop_entry(cache, entry);
+            evict_entry(cache, entry);
             if (group->header.used == GROUP_SIZE)
               group = last_group_in_chain(cache, group);
             else if (group->header.chain_length == 0)
@@ -1538,7 +2307,7 @@ find_entry(svn_membuffer_t *cache,
             if (entry != &to_shrink->entries[i])
               let_entry_age(cache, &to_shrink->entries[i]);
 
-          drop_entry(cache, entry);
+          evict_entry(cache, entry);
         }
 
       /* initialize entry for the new key
@@ -1702,7 +2471,10 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
       else
         {
           svn_boolean_t keep;
+          svn_boolean_t over_quota;
           entry = get_entry(cache, cache->l2.next);
+          over_quota = is_over_quota(get_quota_group(cache->prefix_pool,
+                                                     &entry->key));
 
           if (to_fit_in->priority < SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY)
             {
@@ -1714,7 +2486,12 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
                 return FALSE;
             }
 
-          if (entry->priority <= SVN_CACHE__MEMBUFFER_LOW_PRIORITY)
+          if (over_quota)
+            {
+              /* Groups beyond their quota are the first to make room. */
+              keep = FALSE;
+            }
+          else if (entry->priority <= SVN_CACHE__MEMBUFFER_LOW_PRIORITY)
             {
               /* Be quick to remove low-prio entries - even if the incoming
                * one is low-prio as well.  This makes room for more important
@@ -1752,10 +2529,11 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
                * low-priority hits because higher prio entries will often
                * provide the same data but in a further stage of processing.
                */
-              if (entry->priority > SVN_CACHE__MEMBUFFER_LOW_PRIORITY)
+              if (   entry->priority > SVN_CACHE__MEMBUFFER_LOW_PRIORITY
+                  && !over_quota)
                 drop_hits += entry->hit_count * (apr_uint64_t)entry->priority;
 
-              drop_entry(cache, entry);
+              evict_entry(cache, entry);
             }
         }
     }
@@ -1769,13 +2547,26 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
  * If necessary, enlarge the insertion window of CACHE->L1 by promoting
  * entries to L2 until it is at least SIZE bytes long.
  *
+ * FREQUENCY is the estimated access frequency of the new item as given
+ * by the admission filter.  Entries with the same or a higher frequency
+ * are not sacrificed for it.  Pass ALWAYS_ADMIT to skip that check.
+ *
+ * GROUP is the quota group of the new item and may be NULL.  If it exceeds
+ * its quota, only entries of groups that exceed their quotas as well will
+ * be sacrificed for the new item.
+ *
  * Return TRUE if enough room could be found or made.  A FALSE result
  * indicates that the respective item shall not be added because it is
- * too large.
+ * too large or not important enough.
  */
 static svn_boolean_t
-ensure_data_insertable_l1(svn_membuffer_t *cache, apr_size_t size)
+ensure_data_insertable_l1(svn_membuffer_t *cache,
+                          apr_size_t size,
+                          apr_uint32_t frequency,
+                          quota_group_t *group)
 {
+  svn_boolean_t over_quota = is_over_quota(group);
+
   /* Guarantees that the while loop will terminate. */
   if (size > cache->l1.size)
     return FALSE;
@@ -1815,7 +2606,27 @@ ensure_data_insertable_l1(svn_membuffer_t *cache, apr_size_t size)
           /* Remove the entry from the end of insertion window and promote
            * it to L2, if it is important enough.
            */
-          svn_boolean_t keep = ensure_data_insertable_l2(cache, entry);
+          svn_boolean_t keep;
+          svn_boolean_t entry_over_quota
+            = is_over_quota(get_quota_group(cache->prefix_pool,
+                                            &entry->key));
+
+          /* Don't let a rarely used item push out a popular one. */
+          if (   frequency != ALWAYS_ADMIT
+              && admission_filter_estimate(cache->admission, &entry->key)
+                   >= frequency)
+            return FALSE;
+
+          /* Don't let a group beyond its quota push out well-behaved ones.
+           */
+          if (over_quota && !entry_over_quota)
+            {
+              group->throttled++;
+              return FALSE;
+            }
+
+          /* Items of groups beyond their quota don't get promoted. */
+          keep = !entry_over_quota && ensure_data_insertable_l2(cache, entry);
 
           /* We might have touched the group that contains ENTRY. Recheck. */
           if (entry_index == cache->l1.next)
@@ -1823,7 +2634,7 @@ ensure_data_insertable_l1(svn_membuffer_t *cache, apr_size_t size)
               if (keep)
                 promote_entry(cache, entry);
               else
-                drop_entry(cache, entry);
+                evict_entry(cache, entry);
             }
         }
     }
@@ -1832,17 +2643,204 @@ ensure_data_insertable_l1(svn_membuffer_t *cache, apr_size_t size)
    * right answer. */
 }
 
-svn_error_t *
-svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
-                                  apr_size_t total_size,
-                                  apr_size_t directory_size,
-                                  apr_size_t segment_count,
-                                  svn_boolean_t thread_safe,
-                                  svn_boolean_t allow_blocking_writes,
-                                  apr_pool_t *pool)
+/* Move the boundary between L1 and L2 in CACHE such that L1 will be
+ * NEW_L1_SIZE bytes long.  NEW_L1_SIZE must be aligned and less than
+ * the total data buffer size.  All entries that are in the way will be
+ * dropped.  No data will be moved.
+ */
+static void
+resize_l1(svn_membuffer_t *cache,
+          apr_uint64_t new_l1_size)
+{
+  if (new_l1_size > cache->l1.size)
+    {
+      /* Grow L1 at the expense of the lowest part of L2. */
+      while (   cache->l2.first != NO_INDEX
+             && get_entry(cache, cache->l2.first)->offset < new_l1_size)
+        evict_entry(cache, get_entry(cache, cache->l2.first));
+
+      /* The insertion window may not start in what is now L1. */
+      if (cache->l2.current_data < new_l1_size)
+        cache->l2.current_data = new_l1_size;
+
+      /* The free space at the end of L1 will simply be used once the
+       * insertion window reaches it. */
+    }
+  else
+    {
+      /* Shrink L1 by handing its upper part to L2. */
+      while (cache->l1.last != NO_INDEX)
+        {
+          entry_t *entry = get_entry(cache, cache->l1.last);
+          if (ALIGN_VALUE(entry->offset + entry->size) <= new_l1_size)
+            break;
+
+          evict_entry(cache, entry);
+        }
+
+      /* Restart at the beginning of L1, if the insertion window is no
+       * longer in L1.  There can't be any entries behind it. */
+      if (cache->l1.current_data > new_l1_size)
+        {
+          cache->l1.current_data = cache->l1.start_offset;
+          cache->l1.next = cache->l1.first;
+        }
+
+      /* The free space at the beginning of L2 will simply be used once
+       * the insertion window wraps around. */
+    }
+
+  cache->l1.size = new_l1_size;
+  cache->l2.start_offset = new_l1_size;
+  cache->l2.size = cache->data_size - new_l1_size;
+  cache->l1_resizes++;
+}
+
+/* Adapt the share of the data buffer in CACHE that is assigned to L1 to
+ * the hit distribution observed since the last call.
+ *
+ * If the hits per byte in L1 are much higher than those in L2, the
+ * workload mainly reads data that has been added recently, e.g. during
+ * "svnadmin verify" or "dump".  A larger L1 will let those items live
+ * longer.  If L2 gets much more hits per byte, the same data gets used
+ * over and over again, e.g. fulltexts during checkouts.  Then, make L2
+ * larger.
+ */
+static void
+adapt_levels(svn_membuffer_t *cache)
+{
+  enum { MIN_SAMPLE = 64 };
+
+  /* L1 will be kept between 1/8 and 1/2 of the data buffer.  The lower
+   * limit is what we need for items of MAX_ENTRY_SIZE bytes. */
+  apr_uint64_t step = ALIGN_VALUE(cache->data_size / 16);
+  apr_uint64_t min_size = ALIGN_VALUE(cache->data_size / 8);
+  apr_uint64_t max_size = ALIGN_VALUE(cache->data_size / 2);
+
+  if (cache->l1_hits + cache->l2_hits >= MIN_SAMPLE)
+    {
+      double l1_density = (double)cache->l1_hits / (double)cache->l1.size;
+      double l2_density = (double)cache->l2_hits / (double)cache->l2.size;
+
+      /* Don't be too eager to avoid oscillation. */
+      if (l1_density > 2 * l2_density && cache->l1.size + step <= max_size)
+        resize_l1(cache, cache->l1.size + step);
+      else if (   l2_density > 2 * l1_density
+               && cache->l1.size >= min_size + step)
+        resize_l1(cache, cache->l1.size - step);
+
+      /* Age the statistics. */
+      cache->l1_hits /= 2;
+      cache->l2_hits /= 2;
+    }
+
+  /* Check again after a quarter of the buffer has been overwritten. */
+  cache->adapt_countdown = cache->data_size / 4;
+}
+
+/* A chunk of shared memory from which the membuffer structures get
+ * allocated sequentially.
+ */
+typedef struct shared_region_t
+{
+  /* First byte of the usable memory. */
+  char *base;
+
+  /* Number of bytes available starting at BASE. */
+  apr_size_t size;
+
+  /* Number of bytes allocated so far. */
+  apr_size_t used;
+} shared_region_t;
+
+/* Return SIZE bytes of memory, aligned to ITEM_ALIGNMENT, from REGION.
+ * If REGION is NULL, allocate from POOL instead.  If ZERO is set, the
+ * memory will be initialized to 0.  Return NULL when running out of
+ * memory.
+ */
+static void *
+cache_alloc(apr_pool_t *pool,
+            shared_region_t *region,
+            apr_size_t size,
+            svn_boolean_t zero)
+{
+  char *result;
+  apr_size_t offset;
+
+  if (region == NULL)
+    return zero ? apr_pcalloc(pool, size) : apr_palloc(pool, size);
+
+  offset = region->used + (apr_size_t)(ITEM_ALIGNMENT
+         - (apr_uintptr_t)(region->base + region->used) % ITEM_ALIGNMENT)
+                        % ITEM_ALIGNMENT;
+  if (offset > region->size || region->size - offset < size)
+    return NULL;
+
+  result = region->base + offset;
+  region->used = offset + size;
+  if (zero)
+    memset(result, 0, size);
+
+  return result;
+}
+
+/* Set *REGION to a new shared memory segment of at least SIZE bytes,
+ * allocated in POOL.  If SHM_FILE is not NULL, use it as the name of the
+ * segment.
+ */
+static svn_error_t *
+create_shared_region(shared_region_t *region,
+                     apr_size_t size,
+                     const char *shm_file,
+                     apr_pool_t *pool)
+{
+#if APR_HAS_SHARED_MEMORY
+  apr_shm_t *shm;
+  apr_status_t status;
+
+  /* Left-overs from a previous (crashed) server instance would make the
+   * creation fail.  Nobody may use them anymore, so get rid of them. */
+  if (shm_file)
+    apr_shm_remove(shm_file, pool);
+
+  status = apr_shm_create(&shm, size, shm_file, pool);
+  if (status)
+    return svn_error_wrap_apr(status,
+                              _("Can't create shared memory for the cache"));
+
+  region->base = apr_shm_baseaddr_get(shm);
+  region->size = apr_shm_size_get(shm);
+  region->used = 0;
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Shared memory is not supported"));
+#endif
+}
+
+/* Implement svn_cache__membuffer_cache_create and
+ * svn_cache__membuffer_cache_create_shared.  If SHARED is set, allocate
+ * all structures in a new shared memory segment named SHM_FILE (may be
+ * NULL) and use process-shared locks.  THREAD_SAFE and PARTITION_COUNT
+ * are ignored in that case.
+ */
+static svn_error_t *
+membuffer_cache_create(svn_membuffer_t **cache,
+                       apr_size_t total_size,
+                       apr_size_t directory_size,
+                       apr_size_t segment_count,
+                       apr_size_t partition_count,
+                       svn_boolean_t thread_safe,
+                       svn_boolean_t allow_blocking_writes,
+                       svn_boolean_t shared,
+                       const char *shm_file,
+                       apr_pool_t *pool)
 {
   svn_membuffer_t *c;
   prefix_pool_t *prefix_pool;
+  shared_region_t region = { 0 };
+  shared_region_t *shm = NULL;
 
   apr_uint32_t seg;
   apr_uint32_t group_count;
@@ -1853,10 +2851,21 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   apr_uint64_t max_entry_size;
 
   /* Allocate 1% of the cache capacity to the prefix string pool.
+   * Prefix indexes are only valid within one process, so we can't use
+   * them in shared memory.
    */
-  SVN_ERR(prefix_pool_create(&prefix_pool, total_size / 100, thread_safe,
-                             pool));
-  total_size -= total_size / 100;
+  if (shared)
+    {
+      thread_safe = FALSE;
+      partition_count = 1;
+      SVN_ERR(prefix_pool_create(&prefix_pool, 0, FALSE, pool));
+    }
+  else
+    {
+      SVN_ERR(prefix_pool_create(&prefix_pool, total_size / 100,
+                                 thread_safe, pool));
+      total_size -= total_size / 100;
+    }
 
   /* Limit the total size (only relevant if we can address > 4GB)
    */
@@ -1910,8 +2919,15 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
          && segment_count < MAX_SEGMENT_COUNT)
     segment_count *= 2;
 
-  /* allocate cache as an array of segments / cache objects */
-  c = apr_palloc(pool, segment_count * sizeof(*c));
+  /* The partition count must be a power of two as well and each partition
+   * needs at least one segment.
+   */
+  while ((partition_count & (partition_count-1)) != 0)
+    partition_count &= partition_count-1;
+  if (partition_count < 1)
+    partition_count = 1;
+  if (partition_count > segment_count)
+    partition_count = segment_count;
 
   /* Split total cache size into segments of equal size
    */
@@ -1963,11 +2979,36 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   assert(spare_group_count > 0 && main_group_count > 0);
 
   group_init_size = 1 + group_count / (8 * GROUP_INIT_GRANULARITY);
+
+  /* Get all memory for the cache in a single shared memory block. */
+  if (shared)
+    {
+      apr_uint64_t region_size
+        = ALIGN_VALUE(segment_count * sizeof(*c))
+        + segment_count * (  ALIGN_VALUE(group_count * sizeof(entry_group_t))
+                           + ALIGN_VALUE(group_init_size)
+                           + ALIGN_VALUE(data_size))
+        + ITEM_ALIGNMENT;
+
+      if (region_size > APR_SIZE_MAX)
+        return svn_error_wrap_apr(APR_ENOMEM, "OOM");
+
+      SVN_ERR(create_shared_region(&region, (apr_size_t)region_size,
+                                   shm_file, pool));
+      shm = &region;
+    }
+
+  /* allocate cache as an array of segments / cache objects */
+  c = cache_alloc(pool, shm, segment_count * sizeof(*c), shared);
+  if (c == NULL)
+    return svn_error_wrap_apr(APR_ENOMEM, "OOM");
+
   for (seg = 0; seg < segment_count; ++seg)
     {
       /* allocate buffers and initialize cache members
        */
       c[seg].segment_count = (apr_uint32_t)segment_count;
+      c[seg].partition_count = (apr_uint32_t)partition_count;
       c[seg].prefix_pool = prefix_pool;
 
       c[seg].group_count = main_group_count;
@@ -1978,14 +3019,16 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       /* Allocate but don't clear / zero the directory because it would add
          significantly to the server start-up time if the caches are large.
          Group initialization will take care of that in stead. */
-      c[seg].directory = apr_palloc(pool,
-                                    group_count * sizeof(entry_group_t));
+      c[seg].directory = cache_alloc(pool, shm,
+                                     group_count * sizeof(entry_group_t),
+                                     FALSE);
 
       /* Allocate and initialize directory entries as "not initialized",
          hence "unused" */
-      c[seg].group_initialized = apr_pcalloc(pool, group_init_size);
+      c[seg].group_initialized = cache_alloc(pool, shm, group_init_size,
+                                             TRUE);
 
-      /* Allocate 1/4th of the data buffer to L1
+      /* Initially, allocate 1/4th of the data buffer to L1
        */
       c[seg].l1.first = NO_INDEX;
       c[seg].l1.last = NO_INDEX;
@@ -2004,19 +3047,30 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       c[seg].l2.current_data = c[seg].l2.start_offset;
 
       /* This cast is safe because DATA_SIZE <= MAX_SEGMENT_SIZE. */
-      c[seg].data = apr_palloc(pool, (apr_size_t)ALIGN_VALUE(data_size));
+      c[seg].data = cache_alloc(pool, shm,
+                                (apr_size_t)ALIGN_VALUE(data_size), FALSE);
+      c[seg].data_size = ALIGN_VALUE(data_size);
       c[seg].data_used = 0;
       c[seg].max_entry_size = max_entry_size;
 
+      c[seg].l1_hits = 0;
+      c[seg].l2_hits = 0;
+      c[seg].adapt_countdown = c[seg].data_size / 4;
+      c[seg].l1_resizes = 0;
+      c[seg].admission = NULL;
+
       c[seg].used_entries = 0;
       c[seg].total_reads = 0;
       c[seg].total_writes = 0;
       c[seg].total_hits = 0;
+      c[seg].remote_hits = 0;
 
       /* were allocations successful?
        * If not, initialize a minimal cache structure.
        */
-      if (c[seg].data == NULL || c[seg].directory == NULL)
+      if (   c[seg].data == NULL
+          || c[seg].directory == NULL
+          || c[seg].group_initialized == NULL)
         {
           /* We are OOM. There is no need to proceed with "half a cache".
            */
@@ -2046,6 +3100,12 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
 #endif
       /* No writers at the moment. */
       c[seg].write_lock_count = 0;
+      c[seg].write_sequence = 0;
+
+      /* Shared memory segments use their own locks. */
+      c[seg].shared = shared;
+      c[seg].shared_lock = 0;
+      c[seg].shared_blocking_writes = allow_blocking_writes;
     }
 
   /* done here
@@ -2054,10 +3114,78 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
+                                  apr_size_t total_size,
+                                  apr_size_t directory_size,
+                                  apr_size_t segment_count,
+                                  apr_size_t partition_count,
+                                  svn_boolean_t thread_safe,
+                                  svn_boolean_t allow_blocking_writes,
+                                  apr_pool_t *pool)
+{
+  return svn_error_trace(membuffer_cache_create(cache, total_size,
+                                                directory_size,
+                                                segment_count,
+                                                partition_count,
+                                                thread_safe,
+                                                allow_blocking_writes,
+                                                FALSE, NULL, pool));
+}
+
+svn_error_t *
+svn_cache__membuffer_enable_admission_filter(svn_membuffer_t *cache,
+                                             apr_pool_t *result_pool)
+{
+  apr_uint32_t seg;
+
+  for (seg = 0; seg < cache->segment_count; ++seg)
+    {
+      admission_filter_t *filter;
+      apr_uint64_t entries = (apr_uint64_t)cache[seg].group_count
+                           * GROUP_SIZE;
+
+      if (cache[seg].admission)
+        continue;
+
+      /* About one counter per row and entry that fits into the segment. */
+      filter = apr_pcalloc(result_pool, sizeof(*filter));
+      filter->width = 64;
+      while (filter->width < entries && filter->width < 0x1000000)
+        filter->width *= 2;
+
+      filter->sample_size = filter->width * 10;
+      filter->counters = apr_pcalloc(result_pool,
+                                     (apr_size_t)filter->width
+                                       * ADMISSION_FILTER_DEPTH);
+
+      cache[seg].admission = filter;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__membuffer_cache_create_shared(svn_membuffer_t **cache,
+                                         apr_size_t total_size,
+                                         apr_size_t directory_size,
+                                         apr_size_t segment_count,
+                                         svn_boolean_t allow_blocking_writes,
+                                         const char *shm_file,
+                                         apr_pool_t *pool)
+{
+  return svn_error_trace(membuffer_cache_create(cache, total_size,
+                                                directory_size,
+                                                segment_count, 1, FALSE,
+                                                allow_blocking_writes,
+                                                TRUE, shm_file, pool));
+}
+
 svn_error_t *
 svn_cache__membuffer_clear(svn_membuffer_t *cache)
 {
   apr_size_t seg;
+  apr_uint32_t i;
   apr_size_t segment_count = cache->segment_count;
 
   /* Length of the group_initialized array in bytes.
@@ -2078,6 +3206,7 @@ svn_cache__membuffer_clear(svn_membuffer_t *cache)
     {
       /* Unconditionally acquire the write lock. */
       SVN_ERR(force_write_lock_cache(&cache[seg]));
+      begin_write(&cache[seg]);
 
       /* Mark all groups as "not initialized", which implies "empty". */
       cache[seg].first_spare_group = NO_INDEX;
@@ -2102,9 +3231,16 @@ svn_cache__membuffer_clear(svn_membuffer_t *cache)
       cache[seg].used_entries = 0;
 
       /* Segment may be used again. */
-      SVN_ERR(unlock_cache(&cache[seg], SVN_NO_ERROR));
+      SVN_ERR(unlock_cache(&cache[seg],
+                           end_write(&cache[seg], SVN_NO_ERROR)));
     }
 
+  /* The quota groups are shared by all segments.  Items that got written
+   * to already cleared segments in the meantime will not be accounted
+   * for, see quota_release. */
+  for (i = 1; i < cache->prefix_pool->group_count; ++i)
+    svn_atomic_set(&cache->prefix_pool->groups[i].used, 0);
+
   /* done here */
   return SVN_NO_ERROR;
 }
@@ -2143,19 +3279,55 @@ entry_exists(svn_membuffer_t *cache,
   return SVN_NO_ERROR;
 }
 
-/* Given the SIZE and PRIORITY of a new item, return the cache level
+/* Return TRUE if an item of SIZE bytes including its key will never be
+ * written to CACHE with the given PRIORITY, see select_level().
+ */
+static svn_boolean_t
+is_too_large(svn_membuffer_t *cache,
+             apr_size_t size,
+             apr_uint32_t priority)
+{
+  if (cache->max_entry_size >= size)
+    return FALSE;
+
+  return cache->l2.size < size
+      || MAX_ITEM_SIZE < size
+      || priority <= SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY;
+}
+
+/* Return the frequency to pass to ensure_data_insertable_l1() for an
+   item with KEY and SIZE in CACHE.
+ */
+static apr_uint32_t
+get_admission_frequency(svn_membuffer_t *cache,
+                        const entry_key_t *key,
+                        apr_size_t size)
+{
+  if (cache->admission == NULL || size < ADMISSION_FILTER_MIN_SIZE)
+    return ALWAYS_ADMIT;
+
+  return admission_filter_estimate(cache->admission, key);
+}
+
+/* Given the KEY, SIZE and PRIORITY of a new item, return the cache level
    (L1 or L2) in fragment CACHE that this item shall be inserted into.
    If we can't find nor make enough room for the item, return NULL.
  */
 static cache_level_t *
 select_level(svn_membuffer_t *cache,
+             const entry_key_t *key,
              apr_size_t size,
              apr_uint32_t priority)
 {
+  quota_group_t *group = get_quota_group(cache->prefix_pool, key);
+
   if (cache->max_entry_size >= size)
     {
       /* Small items go into L1. */
-      return ensure_data_insertable_l1(cache, size)
+      return ensure_data_insertable_l1(cache, size,
+                                       get_admission_frequency(cache, key,
+                                                               size),
+                                       group)
            ? &cache->l1
            : NULL;
     }
@@ -2163,6 +3335,13 @@ select_level(svn_membuffer_t *cache,
            && MAX_ITEM_SIZE >= size
            && priority > SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY)
     {
+      /* Large items of groups beyond their quota would evict too much. */
+      if (is_over_quota(group))
+        {
+          group->throttled++;
+          return NULL;
+        }
+
       /* Large but important items go into L2. */
       entry_t dummy_entry = { { { 0 } } };
       dummy_entry.priority = priority;
@@ -2201,14 +3380,29 @@ membuffer_cache_set_internal(svn_membuffer_t *cache,
 {
   cache_level_t *level;
   apr_size_t size;
-
-  /* first, look for a previous entry for the given key */
-  entry_t *entry = find_entry(cache, group_index, to_find, FALSE);
+  entry_t *entry;
 
   /* If this one fails, you are using multiple threads but created the
    * membuffer in single-threaded mode. */
   assert(0 == svn_atomic_inc(&cache->write_lock_count));
 
+  /* Periodically adapt the L1 / L2 split to the workload.  Do this
+   * before looking for the entry because it may drop arbitrary entries.
+   */
+  if (buffer)
+    {
+      if (cache->adapt_countdown <= item_size)
+        adapt_levels(cache);
+      else
+        cache->adapt_countdown -= item_size;
+
+      if (cache->admission)
+        admission_filter_age(cache->admission);
+    }
+
+  /* first, look for a previous entry for the given key */
+  entry = find_entry(cache, group_index, to_find, FALSE);
+
   /* Quick check make sure arithmetics will work further down the road. */
   size = item_size + to_find->entry_key.key_len;
   if (size < item_size)
@@ -2228,7 +3422,9 @@ membuffer_cache_set_internal(svn_membuffer_t *cache,
        * negative value.
        */
       cache->data_used += (apr_uint64_t)size - entry->size;
+      quota_release(cache, entry);
       entry->size = size;
+      quota_charge(cache, entry);
       entry->priority = priority;
 
 #ifdef SVN_DEBUG_CACHE_MEMBUFFER
@@ -2257,7 +3453,9 @@ membuffer_cache_set_internal(svn_membuffer_t *cache,
 
   /* if necessary, enlarge the insertion window.
    */
-  level = buffer ? select_level(cache, size, priority) : NULL;
+  level = buffer
+        ? select_level(cache, &to_find->entry_key, size, priority)
+        : NULL;
   if (level)
     {
       /* Remove old data for this key, if that exists.
@@ -2317,7 +3515,8 @@ membuffer_cache_set_internal(svn_membuffer_t *cache,
  * be inserted.
  *
  * The SERIALIZER is called to transform the ITEM into a single,
- * flat data buffer. Temporary allocations may be done in POOL.
+ * flat data buffer. The attempt will be counted in STATS.  Temporary
+ * allocations may be done in POOL.
  */
 static svn_error_t *
 membuffer_cache_set(svn_membuffer_t *cache,
@@ -2325,21 +3524,39 @@ membuffer_cache_set(svn_membuffer_t *cache,
                     void *item,
                     svn_cache__serialize_func_t serializer,
                     apr_uint32_t priority,
+                    svn_cache__prefix_stats_t *stats,
                     DEBUG_CACHE_MEMBUFFER_TAG_ARG
                     apr_pool_t *scratch_pool)
 {
+  svn_membuffer_t *segment0 = cache;
+  apr_uint32_t partition = get_local_partition(segment0);
   apr_uint32_t group_index;
+  apr_uint32_t i;
   void *buffer = NULL;
   apr_size_t size = 0;
 
   /* find the entry group that will hold the key.
    */
-  group_index = get_group_index(&cache, &key->entry_key);
+  group_index = get_group_index(&cache, &key->entry_key, partition);
 
   /* Serialize data data.
    */
   if (item)
-    SVN_ERR(serializer(&buffer, &size, item, scratch_pool));
+    {
+      SVN_ERR(serializer(&buffer, &size, item, scratch_pool));
+
+      /* Give less room to data that does not get used. */
+      priority = prefix_pool_adjust_priority(segment0->prefix_pool,
+                                             key->entry_key.prefix_idx,
+                                             priority);
+      prefix_pool_count_write(segment0->prefix_pool,
+                              key->entry_key.prefix_idx);
+
+      stats->sets++;
+      stats->bytes_inserted += size;
+      if (is_too_large(cache, size + key->entry_key.key_len, priority))
+        stats->rejected++;
+    }
 
   /* The actual cache data access needs to sync'ed
    */
@@ -2352,6 +3569,28 @@ membuffer_cache_set(svn_membuffer_t *cache,
                                                priority,
                                                DEBUG_CACHE_MEMBUFFER_TAG
                                                scratch_pool));
+
+  /* Remove any copy from the other partitions.  Doing this after the
+   * local write guarantees that concurrent writers on different nodes
+   * can never leave more than one copy behind.
+   */
+  for (i = 1; i < segment0->partition_count; ++i)
+    {
+      cache = segment0;
+      group_index = get_group_index(&cache, &key->entry_key,
+                                    (partition + i)
+                                      & (segment0->partition_count - 1));
+      WITH_WRITE_LOCK(cache,
+                      membuffer_cache_set_internal(cache,
+                                                   key,
+                                                   group_index,
+                                                   NULL,
+                                                   0,
+                                                   priority,
+                                                   DEBUG_CACHE_MEMBUFFER_TAG
+                                                   scratch_pool));
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -2368,6 +3607,14 @@ increment_hit_counters(svn_membuffer_t *cache, entry_t *entry)
 
   /* That one is for stats only. */
   cache->total_hits++;
+
+  /* These drive the adaptation of L1 size and item priorities. */
+  if (entry->offset < cache->l1.size)
+    cache->l1_hits++;
+  else
+    cache->l2_hits++;
+
+  prefix_pool_count_hit(cache->prefix_pool, entry->key.prefix_idx);
 }
 
 /* Look for the cache entry in group GROUP_INDEX of CACHE, identified
@@ -2433,40 +3680,200 @@ membuffer_cache_get_internal(svn_membuffer_t *cache,
   return SVN_NO_ERROR;
 }
 
-/* Look for the *ITEM identified by KEY. If no item has been stored
- * for KEY, *ITEM will be NULL. Otherwise, the DESERIALIZER is called
- * to re-construct the proper object from the serialized data.
- * Allocations will be done in POOL.
+#if USE_LOCK_FREE_READS
+
+/* Try to do what membuffer_cache_get_internal does but without holding
+ * any lock on CACHE.  Set *DONE to TRUE, if the result in *BUFFER and
+ * *ITEM_SIZE is known to be consistent.  *BUFFER may be NULL in that case,
+ * i.e. the entry was not found.
+ *
+ * If a writer got in our way, set *DONE to FALSE and the caller must
+ * repeat the lookup under the read lock.  Since writers may modify the
+ * directory while we read it, all values read from it must be checked
+ * before we use them for addressing.  Allocations will be done in
+ * RESULT_POOL.
  */
-static svn_error_t *
-membuffer_cache_get(svn_membuffer_t *cache,
-                    const full_key_t *key,
-                    void **item,
-                    svn_cache__deserialize_func_t deserializer,
-                    DEBUG_CACHE_MEMBUFFER_TAG_ARG
-                    apr_pool_t *result_pool)
+static void
+membuffer_cache_get_optimistic(svn_membuffer_t *cache,
+                               apr_uint32_t group_index,
+                               const full_key_t *to_find,
+                               char **buffer,
+                               apr_size_t *item_size,
+                               svn_boolean_t *done,
+                               apr_pool_t *result_pool)
 {
-  apr_uint32_t group_index;
-  char *buffer;
-  apr_size_t size;
+  apr_uint32_t group_limit = cache->group_count + cache->spare_group_count;
+  apr_uint64_t data_size = cache->data_size;
+  apr_uint32_t sequence = SEQUENCE_READ(&cache->write_sequence);
+  entry_t *entry = NULL;
+  apr_uint64_t offset = 0;
+  apr_size_t size = 0;
+  apr_size_t key_len = 0;
+  apr_uint32_t steps;
 
-  /* find the entry group that will hold the key.
-   */
-  group_index = get_group_index(&cache, &key->entry_key);
-  WITH_READ_LOCK(cache,
-                 membuffer_cache_get_internal(cache,
-                                              group_index,
-                                              key,
-                                              &buffer,
-                                              &size,
-                                              DEBUG_CACHE_MEMBUFFER_TAG
-                                              result_pool));
+  *buffer = NULL;
+  *item_size = 0;
+  *done = FALSE;
 
-  /* re-construct the original data object from its serialized form.
-   */
-  if (buffer == NULL)
+  /* Some writer is active. */
+  if (sequence & 1)
+    return;
+
+  if (is_group_initialized(cache, group_index))
     {
-      *item = NULL;
+      entry_group_t *group = &cache->directory[group_index];
+
+      /* Chains are shorter than this unless we read garbage. */
+      for (steps = 0; steps <= cache->spare_group_count; ++steps)
+        {
+          apr_uint32_t used = group->header.used;
+          apr_uint32_t next = group->header.next;
+          apr_uint32_t i;
+
+          if (used > GROUP_SIZE)
+            return;
+
+          for (i = 0; i < used; ++i)
+            if (entry_keys_match(&group->entries[i].key,
+                                 &to_find->entry_key))
+              {
+                entry = &group->entries[i];
+                break;
+              }
+
+          if (entry || next == NO_INDEX)
+            break;
+
+          if (next >= group_limit)
+            return;
+
+          group = &cache->directory[next];
+        }
+
+      if (steps > cache->spare_group_count)
+        return;
+    }
+
+  if (entry)
+    {
+      /* Take a snapshot of the entry and make sure that it points into
+       * the data buffer. */
+      offset = entry->offset;
+      size = entry->size;
+      key_len = entry->key.key_len;
+
+      if (   key_len > size
+          || offset > data_size
+          || ALIGN_VALUE(size) > data_size - offset)
+        return;
+
+      /* Compare the full key, if it is not contained in the entry key. */
+      if (key_len && memcmp(to_find->full_key.data, cache->data + offset,
+                            key_len) != 0)
+        entry = NULL;
+    }
+
+  if (entry)
+    {
+      apr_size_t copy_size = ALIGN_VALUE(size) - key_len;
+      *buffer = apr_palloc(result_pool, copy_size);
+      memcpy(*buffer, cache->data + offset + key_len, copy_size);
+      *item_size = size - key_len;
+    }
+
+  /* Our copy is only valid if no writer has become active meanwhile. */
+  READ_FENCE();
+  if (SEQUENCE_READ(&cache->write_sequence) != sequence)
+    {
+      *buffer = NULL;
+      *item_size = 0;
+      return;
+    }
+
+  /* Statistics are not guarded by the lock anyway.  The entry may have
+   * been replaced since we checked the sequence number but then we only
+   * count the hit for the wrong entry. */
+  if (entry)
+    increment_hit_counters(cache, entry);
+  cache->total_reads++;
+
+  *done = TRUE;
+}
+
+#endif
+
+/* Look for the *ITEM identified by KEY. If no item has been stored
+ * for KEY, *ITEM will be NULL. Otherwise, the DESERIALIZER is called
+ * to re-construct the proper object from the serialized data.
+ * Allocations will be done in POOL.
+ */
+static svn_error_t *
+membuffer_cache_get(svn_membuffer_t *cache,
+                    const full_key_t *key,
+                    void **item,
+                    svn_cache__deserialize_func_t deserializer,
+                    DEBUG_CACHE_MEMBUFFER_TAG_ARG
+                    apr_pool_t *result_pool)
+{
+  svn_membuffer_t *segment0 = cache;
+  apr_uint32_t partition = get_local_partition(segment0);
+  apr_uint32_t group_index;
+  apr_uint32_t i;
+  char *buffer = NULL;
+  apr_size_t size;
+
+  /* find the entry group that will hold the key.  Try the local partition
+   * first.
+   */
+  for (i = 0; i < segment0->partition_count && buffer == NULL; ++i)
+    {
+      cache = segment0;
+      group_index = get_group_index(&cache, &key->entry_key,
+                                    (partition + i)
+                                      & (segment0->partition_count - 1));
+
+      /* Writes go to the local partition, so count the access there. */
+      if (i == 0 && cache->admission)
+        admission_filter_add(cache->admission, &key->entry_key);
+
+#if USE_LOCK_FREE_READS
+      /* Only synchronized caches need the optimistic path.  Fall back to
+       * the lock if a writer interfered. */
+      if (is_synchronized(cache))
+        {
+          svn_boolean_t done;
+          membuffer_cache_get_optimistic(cache, group_index, key, &buffer,
+                                         &size, &done, result_pool);
+          if (!done)
+            WITH_READ_LOCK(cache,
+                           membuffer_cache_get_internal(cache,
+                                                        group_index,
+                                                        key,
+                                                        &buffer,
+                                                        &size,
+                                                        DEBUG_CACHE_MEMBUFFER_TAG
+                                                        result_pool));
+        }
+      else
+#endif
+        WITH_READ_LOCK(cache,
+                       membuffer_cache_get_internal(cache,
+                                                    group_index,
+                                                    key,
+                                                    &buffer,
+                                                    &size,
+                                                    DEBUG_CACHE_MEMBUFFER_TAG
+                                                    result_pool));
+
+      if (buffer && i > 0)
+        cache->remote_hits++;
+    }
+
+  /* re-construct the original data object from its serialized form.
+   */
+  if (buffer == NULL)
+    {
+      *item = NULL;
       return SVN_NO_ERROR;
     }
 
@@ -2512,16 +3919,31 @@ membuffer_cache_has_key(svn_membuffer_t *cache,
                         const full_key_t *key,
                         svn_boolean_t *found)
 {
-  /* find the entry group that will hold the key.
-   */
-  apr_uint32_t group_index = get_group_index(&cache, &key->entry_key);
-  cache->total_reads++;
+  svn_membuffer_t *segment0 = cache;
+  apr_uint32_t partition = get_local_partition(segment0);
+  apr_uint32_t group_index;
+  apr_uint32_t i;
 
-  WITH_READ_LOCK(cache,
-                 membuffer_cache_has_key_internal(cache,
-                                                  group_index,
-                                                  key,
-                                                  found));
+  /* find the entry group that will hold the key.  Try the local partition
+   * first.
+   */
+  *found = FALSE;
+  for (i = 0; i < segment0->partition_count && !*found; ++i)
+    {
+      cache = segment0;
+      group_index = get_group_index(&cache, &key->entry_key,
+                                    (partition + i)
+                                      & (segment0->partition_count - 1));
+      cache->total_reads++;
+
+      WITH_READ_LOCK(cache,
+                     membuffer_cache_has_key_internal(cache,
+                                                      group_index,
+                                                      key,
+                                                      found));
+      if (*found && i > 0)
+        cache->remote_hits++;
+    }
 
   return SVN_NO_ERROR;
 }
@@ -2599,13 +4021,31 @@ membuffer_cache_get_partial(svn_membuffer_t *cache,
                             DEBUG_CACHE_MEMBUFFER_TAG_ARG
                             apr_pool_t *result_pool)
 {
-  apr_uint32_t group_index = get_group_index(&cache, &key->entry_key);
+  svn_membuffer_t *segment0 = cache;
+  apr_uint32_t partition = get_local_partition(segment0);
+  apr_uint32_t group_index;
+  apr_uint32_t i;
 
-  WITH_READ_LOCK(cache,
-                 membuffer_cache_get_partial_internal
-                     (cache, group_index, key, item, found,
-                      deserializer, baton, DEBUG_CACHE_MEMBUFFER_TAG
-                      result_pool));
+  /* Try the local partition first. */
+  *found = FALSE;
+  for (i = 0; i < segment0->partition_count && !*found; ++i)
+    {
+      cache = segment0;
+      group_index = get_group_index(&cache, &key->entry_key,
+                                    (partition + i)
+                                      & (segment0->partition_count - 1));
+
+      if (i == 0 && cache->admission)
+        admission_filter_add(cache->admission, &key->entry_key);
+
+      WITH_READ_LOCK(cache,
+                     membuffer_cache_get_partial_internal
+                         (cache, group_index, key, item, found,
+                          deserializer, baton, DEBUG_CACHE_MEMBUFFER_TAG
+                          result_pool));
+      if (*found && i > 0)
+        cache->remote_hits++;
+    }
 
   return SVN_NO_ERROR;
 }
@@ -2691,7 +4131,11 @@ membuffer_cache_set_partial_internal(svn_membuffer_t *cache,
                */
               drop_entry(cache, entry);
               if (   (cache->max_entry_size - key_len >= item_size)
-                  && ensure_data_insertable_l1(cache, item_size + key_len))
+                  && ensure_data_insertable_l1(cache, item_size + key_len,
+                                               ALWAYS_ADMIT,
+                                               get_quota_group(
+                                                 cache->prefix_pool,
+                                                 &to_find->entry_key)))
                 {
                   /* Write the new entry.
                    */
@@ -2739,14 +4183,24 @@ membuffer_cache_set_partial(svn_membuffer_t *cache,
                             DEBUG_CACHE_MEMBUFFER_TAG_ARG
                             apr_pool_t *scratch_pool)
 {
-  /* cache item lookup
+  svn_membuffer_t *segment0 = cache;
+  apr_uint32_t partition;
+
+  /* cache item lookup.  There is at most one copy of the item in the
+   * whole cache and modifying it in place is a no-op everywhere else.
    */
-  apr_uint32_t group_index = get_group_index(&cache, &key->entry_key);
-  WITH_WRITE_LOCK(cache,
-                  membuffer_cache_set_partial_internal
-                     (cache, group_index, key, func, baton,
-                      DEBUG_CACHE_MEMBUFFER_TAG
-                      scratch_pool));
+  for (partition = 0; partition < segment0->partition_count; ++partition)
+    {
+      apr_uint32_t group_index;
+
+      cache = segment0;
+      group_index = get_group_index(&cache, &key->entry_key, partition);
+      WITH_WRITE_LOCK(cache,
+                      membuffer_cache_set_partial_internal
+                         (cache, group_index, key, func, baton,
+                          DEBUG_CACHE_MEMBUFFER_TAG
+                          scratch_pool));
+    }
 
   /* done here -> unlock the cache
    */
@@ -2799,6 +4253,15 @@ typedef struct svn_membuffer_cache_t
   /* priority class for all items written through this interface */
   apr_uint32_t priority;
 
+  /* access statistics for the prefix class of this instance.  Shared with
+   * all instances of the same class and owned by MEMBUFFER. */
+  svn_cache__prefix_stats_t *stats;
+
+  /* if enabled, all items are stored in svn__compress_lz4() format and
+   * those of at least this many bytes get actually compressed.  0 means
+   * items are being stored as returned by the SERIALIZER. */
+  apr_size_t compression_threshold;
+
   /* Temporary buffer containing the hash key for the current access
    */
   full_key_t combined_key;
@@ -2917,6 +4380,121 @@ combine_key(svn_membuffer_cache_t *cache,
     = data[1] ^ cache->prefix.fingerprint[1];
 }
 
+/* standard serialization function for svn_stringbuf_t items.
+ * Implements svn_cache__serialize_func_t.
+ */
+static svn_error_t *
+serialize_svn_stringbuf(void **buffer,
+                        apr_size_t *buffer_size,
+                        void *item,
+                        apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *value_str = item;
+
+  *buffer = value_str->data;
+  *buffer_size = value_str->len + 1;
+
+  return SVN_NO_ERROR;
+}
+
+/* standard de-serialization function for svn_stringbuf_t items.
+ * Implements svn_cache__deserialize_func_t.
+ */
+static svn_error_t *
+deserialize_svn_stringbuf(void **item,
+                          void *buffer,
+                          apr_size_t buffer_size,
+                          apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *value_str = apr_palloc(result_pool, sizeof(svn_stringbuf_t));
+
+  value_str->pool = result_pool;
+  value_str->blocksize = buffer_size;
+  value_str->data = buffer;
+  value_str->len = buffer_size-1;
+  *item = value_str;
+
+  return SVN_NO_ERROR;
+}
+
+/* Largest serialized item that we may pass to svn__compress_lz4(). */
+#define MAX_PACKED_ITEM_SIZE (APR_INT32_MAX / 2)
+
+/* Return the serialized item DATA of SIZE bytes in the storage format of
+ * the compressing CACHE in *PACKED, allocated in RESULT_POOL.  Set it to
+ * NULL if the item is too large.
+ */
+static svn_error_t *
+pack_item(svn_stringbuf_t **packed,
+          svn_membuffer_cache_t *cache,
+          const void *data,
+          apr_size_t size,
+          apr_pool_t *result_pool)
+{
+  unsigned char header[SVN__MAX_ENCODED_UINT_LEN];
+  apr_size_t header_len;
+
+  if (size > MAX_PACKED_ITEM_SIZE)
+    {
+      *packed = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  *packed = svn_stringbuf_create_empty(result_pool);
+  if (size >= cache->compression_threshold)
+    return svn_error_trace(svn__compress_lz4(data, size, *packed));
+
+  /* Small items are not worth the effort.  Use the format of
+   * incompressible data, which is a plain copy. */
+  header_len = svn__encode_uint(header, (apr_uint64_t)size) - header;
+  svn_stringbuf_ensure(*packed, header_len + size);
+  svn_stringbuf_appendbytes(*packed, (const char *)header, header_len);
+  svn_stringbuf_appendbytes(*packed, data, size);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the serialized item stored as PACKED by pack_item() in
+ * *UNPACKED, allocated in RESULT_POOL.
+ */
+static svn_error_t *
+unpack_item(svn_stringbuf_t **unpacked,
+            const svn_stringbuf_t *packed,
+            apr_pool_t *result_pool)
+{
+  *unpacked = svn_stringbuf_create_empty(result_pool);
+  return svn_error_trace(svn__decompress_lz4(packed->data, packed->len,
+                                             *unpacked,
+                                             MAX_PACKED_ITEM_SIZE));
+}
+
+/* Read the item with the current COMBINED_KEY from the compressing CACHE
+ * and return it in serialized but unpacked form in *DATA, allocated in
+ * RESULT_POOL.  Set it to NULL if the item is not in the cache.
+ */
+static svn_error_t *
+get_unpacked(svn_stringbuf_t **data,
+             svn_membuffer_cache_t *cache,
+             DEBUG_CACHE_MEMBUFFER_TAG_ARG
+             apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *packed;
+
+  SVN_ERR(membuffer_cache_get(cache->membuffer,
+                              &cache->combined_key,
+                              (void **)&packed,
+                              deserialize_svn_stringbuf,
+                              DEBUG_CACHE_MEMBUFFER_TAG
+                              result_pool));
+  if (packed == NULL)
+    {
+      *data = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(unpack_item(data, packed, result_pool));
+}
+
 /* Implement svn_cache__vtable_t.get (not thread-safe)
  */
 static svn_error_t *
@@ -2945,16 +4523,34 @@ svn_membuffer_cache_get(void **value_p,
   combine_key(cache, key, cache->key_len);
 
   /* Look the item up. */
-  SVN_ERR(membuffer_cache_get(cache->membuffer,
-                              &cache->combined_key,
-                              value_p,
-                              cache->deserializer,
-                              DEBUG_CACHE_MEMBUFFER_TAG
-                              result_pool));
+  if (cache->compression_threshold)
+    {
+      svn_stringbuf_t *data;
+      SVN_ERR(get_unpacked(&data, cache, DEBUG_CACHE_MEMBUFFER_TAG
+                           result_pool));
+      if (data)
+        SVN_ERR(cache->deserializer(value_p, data->data, data->len,
+                                    result_pool));
+      else
+        *value_p = NULL;
+    }
+  else
+    {
+      SVN_ERR(membuffer_cache_get(cache->membuffer,
+                                  &cache->combined_key,
+                                  value_p,
+                                  cache->deserializer,
+                                  DEBUG_CACHE_MEMBUFFER_TAG
+                                  result_pool));
+    }
 
   /* return result */
   *found = *value_p != NULL;
 
+  cache->stats->gets++;
+  if (*found)
+    cache->stats->hits++;
+
   return SVN_NO_ERROR;
 }
 
@@ -3011,6 +4607,26 @@ svn_membuffer_cache_set(void *cache_void,
    */
   combine_key(cache, key, cache->key_len);
 
+  /* Store compressed items as opaque strings. */
+  if (cache->compression_threshold && value)
+    {
+      void *data;
+      apr_size_t size;
+      svn_stringbuf_t *packed;
+
+      SVN_ERR(cache->serializer(&data, &size, value, scratch_pool));
+      SVN_ERR(pack_item(&packed, cache, data, size, scratch_pool));
+
+      return membuffer_cache_set(cache->membuffer,
+                                 &cache->combined_key,
+                                 packed,
+                                 serialize_svn_stringbuf,
+                                 cache->priority,
+                                 cache->stats,
+                                 DEBUG_CACHE_MEMBUFFER_TAG
+                                 scratch_pool);
+    }
+
   /* (probably) add the item to the cache. But there is no real guarantee
    * that the item will actually be cached afterwards.
    */
@@ -3019,6 +4635,7 @@ svn_membuffer_cache_set(void *cache_void,
                              value,
                              cache->serializer,
                              cache->priority,
+                             cache->stats,
                              DEBUG_CACHE_MEMBUFFER_TAG
                              scratch_pool);
 }
@@ -3060,14 +4677,34 @@ svn_membuffer_cache_get_partial(void **value_p,
     }
 
   combine_key(cache, key, cache->key_len);
-  SVN_ERR(membuffer_cache_get_partial(cache->membuffer,
-                                      &cache->combined_key,
-                                      value_p,
-                                      found,
-                                      func,
-                                      baton,
-                                      DEBUG_CACHE_MEMBUFFER_TAG
-                                      result_pool));
+  if (cache->compression_threshold)
+    {
+      /* We can't access compressed data in-place. */
+      svn_stringbuf_t *data;
+      SVN_ERR(get_unpacked(&data, cache, DEBUG_CACHE_MEMBUFFER_TAG
+                           result_pool));
+
+      *found = data != NULL;
+      if (*found)
+        SVN_ERR(func(value_p, data->data, data->len, baton, result_pool));
+      else
+        *value_p = NULL;
+    }
+  else
+    {
+      SVN_ERR(membuffer_cache_get_partial(cache->membuffer,
+                                          &cache->combined_key,
+                                          value_p,
+                                          found,
+                                          func,
+                                          baton,
+                                          DEBUG_CACHE_MEMBUFFER_TAG
+                                          result_pool));
+    }
+
+  cache->stats->gets++;
+  if (*found)
+    cache->stats->hits++;
 
   return SVN_NO_ERROR;
 }
@@ -3085,7 +4722,21 @@ svn_membuffer_cache_set_partial(void *cache_void,
 
   DEBUG_CACHE_MEMBUFFER_INIT_TAG(scratch_pool)
 
-  if (key != NULL)
+  if (key != NULL && cache->compression_threshold)
+    {
+      /* Compressed items can't be modified in-place.  Since the caller
+       * wants to change the item, dropping it is always safe. */
+      combine_key(cache, key, cache->key_len);
+      SVN_ERR(membuffer_cache_set(cache->membuffer,
+                                  &cache->combined_key,
+                                  NULL,
+                                  cache->serializer,
+                                  cache->priority,
+                                  cache->stats,
+                                  DEBUG_CACHE_MEMBUFFER_TAG
+                                  scratch_pool));
+    }
+  else if (key != NULL)
     {
       combine_key(cache, key, cache->key_len);
       SVN_ERR(membuffer_cache_set_partial(cache->membuffer,
@@ -3125,6 +4776,7 @@ svn_membuffer_get_segment_info(svn_membuffer_t *segment,
   apr_uint32_t i;
 
   info->data_size += segment->l1.size + segment->l2.size;
+  info->l1_size += segment->l1.size;
   info->used_size += segment->data_used;
   info->total_size += segment->l1.size + segment->l2.size +
       segment->group_count * GROUP_SIZE * sizeof(entry_t);
@@ -3186,7 +4838,8 @@ static svn_cache__vtable_t membuffer_cache_vtable = {
   svn_membuffer_cache_is_cachable,
   svn_membuffer_cache_get_partial,
   svn_membuffer_cache_set_partial,
-  svn_membuffer_cache_get_info
+  svn_membuffer_cache_get_info,
+  NULL                                    /* get_many: use fallback */
 };
 
 /* Implement svn_cache__vtable_t.get and serialize all cache access.
@@ -3299,46 +4952,10 @@ static svn_cache__vtable_t membuffer_cache_synced_vtable = {
   svn_membuffer_cache_is_cachable,        /* no sync required */
   svn_membuffer_cache_get_partial_synced,
   svn_membuffer_cache_set_partial_synced,
-  svn_membuffer_cache_get_info            /* no sync required */
+  svn_membuffer_cache_get_info,           /* no sync required */
+  NULL                                    /* get_many: use fallback */
 };
 
-/* standard serialization function for svn_stringbuf_t items.
- * Implements svn_cache__serialize_func_t.
- */
-static svn_error_t *
-serialize_svn_stringbuf(void **buffer,
-                        apr_size_t *buffer_size,
-                        void *item,
-                        apr_pool_t *result_pool)
-{
-  svn_stringbuf_t *value_str = item;
-
-  *buffer = value_str->data;
-  *buffer_size = value_str->len + 1;
-
-  return SVN_NO_ERROR;
-}
-
-/* standard de-serialization function for svn_stringbuf_t items.
- * Implements svn_cache__deserialize_func_t.
- */
-static svn_error_t *
-deserialize_svn_stringbuf(void **item,
-                          void *buffer,
-                          apr_size_t buffer_size,
-                          apr_pool_t *result_pool)
-{
-  svn_stringbuf_t *value_str = apr_palloc(result_pool, sizeof(svn_stringbuf_t));
-
-  value_str->pool = result_pool;
-  value_str->blocksize = buffer_size;
-  value_str->data = buffer;
-  value_str->len = buffer_size-1;
-  *item = value_str;
-
-  return SVN_NO_ERROR;
-}
-
 /* Construct a svn_cache__t object on top of a shared memcache.
  */
 svn_error_t *
@@ -3356,6 +4973,7 @@ svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
 {
   svn_checksum_t *checksum;
   apr_size_t prefix_len, prefix_orig_len;
+  apr_uint32_t class_idx;
 
   /* allocate the cache header structures
    */
@@ -3407,6 +5025,12 @@ svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
   else
     cache->prefix.prefix_idx = NO_INDEX;
 
+  /* Attribute all accesses to the prefix class of this instance. */
+  SVN_ERR(prefix_pool_get_class(&class_idx, membuffer->prefix_pool, prefix));
+  cache->stats = &membuffer->prefix_pool->classes[class_idx];
+  if (cache->prefix.prefix_idx < membuffer->prefix_pool->values_max)
+    membuffer->prefix_pool->value_class[cache->prefix.prefix_idx] = class_idx;
+
   /* If key combining is not guaranteed to produce unique results, we have
    * to handle full keys.  Otherwise, leave it NULL. */
   if (cache->prefix.prefix_idx == NO_INDEX)
@@ -3444,6 +5068,51 @@ svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_cache__membuffer_enable_compression(svn_cache__t *cache,
+                                        apr_size_t threshold)
+{
+  svn_membuffer_cache_t *membuffer_cache;
+
+  if (   cache->vtable != &membuffer_cache_vtable
+      && cache->vtable != &membuffer_cache_synced_vtable)
+    return SVN_NO_ERROR;
+
+  membuffer_cache = cache->cache_internal;
+  membuffer_cache->compression_threshold = MAX(threshold, 1);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__membuffer_set_quota(svn_cache__t *cache,
+                               const char *group,
+                               apr_uint32_t quota_percent)
+{
+  svn_membuffer_cache_t *membuffer_cache;
+  svn_membuffer_t *membuffer;
+  apr_uint64_t quota;
+
+  if (   cache->vtable != &membuffer_cache_vtable
+      && cache->vtable != &membuffer_cache_synced_vtable)
+    return SVN_NO_ERROR;
+
+  /* Only items with pooled prefixes can be attributed to a group. */
+  membuffer_cache = cache->cache_internal;
+  membuffer = membuffer_cache->membuffer;
+  if (membuffer_cache->prefix.prefix_idx >= membuffer->prefix_pool->values_max)
+    return SVN_NO_ERROR;
+
+  /* All segments have the same size. */
+  quota = membuffer->data_size / ITEM_ALIGNMENT * membuffer->segment_count
+        / 100 * MIN(quota_percent, 100);
+  SVN_ERR(prefix_pool_set_quota(membuffer->prefix_pool,
+                                membuffer_cache->prefix.prefix_idx, group,
+                                (apr_uint32_t)MIN(quota, APR_UINT32_MAX)));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 svn_membuffer_get_global_segment_info(svn_membuffer_t *segment,
                                       svn_cache__info_t *info)
@@ -3451,6 +5120,8 @@ svn_membuffer_get_global_segment_info(svn_membuffer_t *segment,
   info->gets += segment->total_reads;
   info->sets += segment->total_writes;
   info->hits += segment->total_hits;
+  info->remote_hits += segment->remote_hits;
+  info->l1_resizes += segment->l1_resizes;
 
   WITH_READ_LOCK(segment,
                   svn_membuffer_get_segment_info(segment, info, TRUE));
@@ -3476,5 +5147,446 @@ svn_cache__membuffer_get_global_info(apr_pool_t *pool)
     svn_error_clear(svn_membuffer_get_global_segment_info(membuffer + i,
                                                           info));
 
+  /* The prefix pool is shared by all segments. */
+  for (i = 0; i < membuffer->prefix_pool->values_used; ++i)
+    if (prefix_pool_is_unproductive(membuffer->prefix_pool, i))
+      info->demoted_prefixes++;
+
   return info;
 }
+
+svn_error_t *
+svn_cache__membuffer_get_prefix_stats(apr_array_header_t **stats,
+                                      svn_membuffer_t *cache,
+                                      apr_pool_t *result_pool)
+{
+  prefix_pool_t *prefix_pool = cache->prefix_pool;
+  apr_uint32_t count = prefix_pool->class_count;
+  apr_uint32_t i;
+
+  *stats = apr_array_make(result_pool, count,
+                          sizeof(svn_cache__prefix_stats_t *));
+  for (i = 0; i < count; ++i)
+    {
+      const svn_cache__prefix_stats_t *source = &prefix_pool->classes[i];
+      svn_cache__prefix_stats_t *copy;
+
+      /* Skip unused classes.  Others may be registered concurrently. */
+      if (!source->name || (!source->gets && !source->sets))
+        continue;
+
+      copy = apr_pmemdup(result_pool, source, sizeof(*copy));
+      copy->name = apr_pstrdup(result_pool, source->name);
+      APR_ARRAY_PUSH(*stats, svn_cache__prefix_stats_t *) = copy;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__membuffer_get_quota_stats(apr_array_header_t **stats,
+                                     svn_membuffer_t *cache,
+                                     apr_pool_t *result_pool)
+{
+  prefix_pool_t *prefix_pool = cache->prefix_pool;
+  apr_uint32_t count = prefix_pool->group_count;
+  apr_uint32_t i;
+
+  *stats = apr_array_make(result_pool, count,
+                          sizeof(svn_cache__quota_stats_t *));
+  for (i = 1; i < count; ++i)
+    {
+      quota_group_t *source = &prefix_pool->groups[i];
+      svn_cache__quota_stats_t *copy;
+
+      /* Groups may be registered concurrently. */
+      if (!source->name)
+        continue;
+
+      copy = apr_pcalloc(result_pool, sizeof(*copy));
+      copy->name = apr_pstrdup(result_pool, source->name);
+      copy->quota = (apr_uint64_t)svn_atomic_read(&source->quota)
+                  * ITEM_ALIGNMENT;
+      copy->used = (apr_uint64_t)svn_atomic_read(&source->used)
+                 * ITEM_ALIGNMENT;
+      copy->throttled = source->throttled;
+      APR_ARRAY_PUSH(*stats, svn_cache__quota_stats_t *) = copy;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/*** Persistent snapshots. ***/
+
+/* The debug tags are not part of the snapshot, so cache debugging builds
+ * don't support snapshots. */
+#ifndef SVN_DEBUG_CACHE_MEMBUFFER
+
+/* Snapshot files start with a snapshot_header_t, followed by PREFIX_COUNT
+ * prefix strings, each given as an apr_uint32_t length followed by the
+ * string contents without terminating NUL.  After that, there is a
+ * sequence of snapshot_entry_t records, each immediately followed by
+ * the SIZE bytes of serialized item data.  All numbers are in native
+ * byte order. */
+
+/* Identifies membuffer snapshot files. */
+#define SNAPSHOT_MAGIC "SVNMBSS"
+
+/* Version of the snapshot file structure. */
+#define SNAPSHOT_FORMAT 1
+
+/* Value written in native byte order to detect foreign file origins. */
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+
+/* Upper limit for the length of a prefix string in a snapshot. */
+#define SNAPSHOT_MAX_PREFIX_LEN 0x10000
+
+/* Header of a snapshot file.  Serialized item data may contain pointer
+ * sized offsets and depends on the Subversion version that wrote it.
+ * So, all of these must match for the snapshot to be usable.
+ */
+typedef struct snapshot_header_t
+{
+  /* SNAPSHOT_MAGIC, NUL terminated. */
+  char magic[8];
+
+  /* SNAPSHOT_FORMAT */
+  apr_uint32_t format;
+
+  /* SNAPSHOT_BYTE_ORDER */
+  apr_uint32_t byte_order;
+
+  /* sizeof(void *) of the writer */
+  apr_uint32_t pointer_size;
+
+  /* Number of prefix strings that follow the header. */
+  apr_uint32_t prefix_count;
+
+  /* SVN_VERSION of the writer, NUL padded. */
+  char version[48];
+} snapshot_header_t;
+
+/* Header of a single item in a snapshot file.
+ */
+typedef struct snapshot_entry_t
+{
+  /* Fingerprint of the item's entry key. */
+  apr_uint64_t fingerprint[2];
+
+  /* Number of bytes of serialized data that follow this header. */
+  apr_uint64_t size;
+
+  /* Index of the prefix string within the snapshot file. */
+  apr_uint32_t prefix_idx;
+
+  /* Priority the item had been written with. */
+  apr_uint32_t priority;
+} snapshot_entry_t;
+
+/* Set *COUNT to the number of prefixes in PREFIX_POOL.
+ *
+ * Note: This function requires the caller to serialization access.
+ */
+static svn_error_t *
+prefix_pool_count(apr_uint32_t *count,
+                  prefix_pool_t *prefix_pool)
+{
+  *count = prefix_pool->values_used;
+  return SVN_NO_ERROR;
+}
+
+/* Append all items in LEVEL of segment CACHE whose prefix index is below
+ * PREFIX_COUNT to BUFFER in snapshot_entry_t format.
+ *
+ * Note: This function requires the caller to serialization access.
+ */
+static void
+snapshot_level(svn_membuffer_t *cache,
+               cache_level_t *level,
+               apr_uint32_t prefix_count,
+               svn_stringbuf_t *buffer)
+{
+  apr_uint32_t idx;
+  for (idx = level->first; idx != NO_INDEX; idx = get_entry(cache, idx)->next)
+    {
+      entry_t *entry = get_entry(cache, idx);
+      snapshot_entry_t record;
+
+      /* Only entries with short keys of long-lived caches have a prefix
+       * index and their full key is implied by the fingerprint. */
+      if (entry->key.prefix_idx >= prefix_count)
+        continue;
+
+      record.fingerprint[0] = entry->key.fingerprint[0];
+      record.fingerprint[1] = entry->key.fingerprint[1];
+      record.size = entry->size;
+      record.prefix_idx = entry->key.prefix_idx;
+      record.priority = entry->priority;
+
+      svn_stringbuf_appendbytes(buffer, (const char *)&record,
+                                sizeof(record));
+      svn_stringbuf_appendbytes(buffer,
+                                (const char *)cache->data + entry->offset,
+                                entry->size);
+    }
+}
+
+/* Replace the contents of BUFFER with a snapshot of segment CACHE,
+ * covering only items whose prefix index is below PREFIX_COUNT.
+ *
+ * Note: This function requires the caller to serialization access.
+ */
+static svn_error_t *
+snapshot_segment(svn_membuffer_t *cache,
+                 apr_uint32_t prefix_count,
+                 svn_stringbuf_t *buffer)
+{
+  svn_stringbuf_setempty(buffer);
+
+  /* L2 first such that L1 will contain the same items after loading. */
+  snapshot_level(cache, &cache->l2, prefix_count, buffer);
+  snapshot_level(cache, &cache->l1, prefix_count, buffer);
+
+  return SVN_NO_ERROR;
+}
+
+/* Write a snapshot of all segments of CACHE to STREAM.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+write_snapshot(svn_stream_t *stream,
+               svn_membuffer_t *cache,
+               apr_pool_t *scratch_pool)
+{
+  prefix_pool_t *prefix_pool = cache->prefix_pool;
+  svn_stringbuf_t *buffer = svn_stringbuf_create_empty(scratch_pool);
+  snapshot_header_t header;
+  apr_uint32_t prefix_count;
+  apr_uint32_t i;
+  apr_size_t len;
+
+  /* Prefixes may get added while we write the snapshot.  Items using any
+   * of those will simply not be included. */
+  SVN_MUTEX__WITH_LOCK(prefix_pool->mutex,
+                       prefix_pool_count(&prefix_count, prefix_pool));
+
+  memset(&header, 0, sizeof(header));
+  strcpy(header.magic, SNAPSHOT_MAGIC);
+  header.format = SNAPSHOT_FORMAT;
+  header.byte_order = SNAPSHOT_BYTE_ORDER;
+  header.pointer_size = sizeof(void *);
+  header.prefix_count = prefix_count;
+  apr_cpystrn(header.version, SVN_VERSION, sizeof(header.version));
+
+  len = sizeof(header);
+  SVN_ERR(svn_stream_write(stream, (const char *)&header, &len));
+
+  for (i = 0; i < prefix_count; ++i)
+    {
+      const char *prefix = prefix_pool->values[i];
+      apr_uint32_t prefix_len = (apr_uint32_t)strlen(prefix);
+
+      len = sizeof(prefix_len);
+      SVN_ERR(svn_stream_write(stream, (const char *)&prefix_len, &len));
+      len = prefix_len;
+      SVN_ERR(svn_stream_write(stream, prefix, &len));
+    }
+
+  /* Copy one segment at a time such that we don't block writers while
+   * doing file I/O. */
+  for (i = 0; i < cache->segment_count; ++i)
+    {
+      svn_membuffer_t *segment = cache + i;
+      WITH_READ_LOCK(segment,
+                     snapshot_segment(segment, prefix_count, buffer));
+
+      len = buffer->len;
+      SVN_ERR(svn_stream_write(stream, buffer->data, &len));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__membuffer_save(svn_membuffer_t *cache,
+                          const char *path,
+                          apr_pool_t *scratch_pool)
+{
+  svn_stream_t *stream;
+  const char *tmp_path;
+  svn_error_t *err;
+
+  /* Write to a temporary file first such that concurrent readers and
+   * writers of the snapshot always see a complete file. */
+  SVN_ERR(svn_stream_open_unique(&stream, &tmp_path,
+                                 svn_dirent_dirname(path, scratch_pool),
+                                 svn_io_file_del_none,
+                                 scratch_pool, scratch_pool));
+
+  err = write_snapshot(stream, cache, scratch_pool);
+  err = svn_error_compose_create(err, svn_stream_close(stream));
+  if (err)
+    return svn_error_compose_create(err,
+                                    svn_io_remove_file2(tmp_path, TRUE,
+                                                        scratch_pool));
+
+  return svn_error_trace(svn_io_file_rename2(tmp_path, path, FALSE,
+                                             scratch_pool));
+}
+
+/* Read exactly SIZE bytes from STREAM into BUFFER.  Set *COMPLETE to
+ * FALSE, if the stream ended before.
+ */
+static svn_error_t *
+read_snapshot_data(svn_boolean_t *complete,
+                   svn_stream_t *stream,
+                   void *buffer,
+                   apr_size_t size)
+{
+  apr_size_t len = size;
+  SVN_ERR(svn_stream_read_full(stream, buffer, &len));
+  *complete = len == size;
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the items from the snapshot in STREAM to CACHE.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+read_snapshot(svn_membuffer_t *cache,
+              svn_stream_t *stream,
+              apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_uint32_t partition = get_local_partition(cache);
+  snapshot_header_t header;
+  snapshot_entry_t record;
+  apr_uint32_t *prefix_map;
+  svn_membuf_t data;
+  svn_boolean_t complete;
+  apr_uint32_t i;
+
+  /* Silently skip outdated or foreign snapshots. */
+  SVN_ERR(read_snapshot_data(&complete, stream, &header, sizeof(header)));
+  if (   !complete
+      || memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC))
+      || header.format != SNAPSHOT_FORMAT
+      || header.byte_order != SNAPSHOT_BYTE_ORDER
+      || header.pointer_size != sizeof(void *)
+      || strncmp(header.version, SVN_VERSION, sizeof(header.version)))
+    return SVN_NO_ERROR;
+
+  /* Map the snapshot's prefixes to our prefix pool. */
+  svn_membuf__create(&data, 256, scratch_pool);
+  prefix_map = apr_palloc(scratch_pool,
+                          (header.prefix_count + 1) * sizeof(*prefix_map));
+  for (i = 0; i < header.prefix_count; ++i)
+    {
+      apr_uint32_t prefix_len;
+      SVN_ERR(read_snapshot_data(&complete, stream, &prefix_len,
+                                 sizeof(prefix_len)));
+      if (!complete || prefix_len > SNAPSHOT_MAX_PREFIX_LEN)
+        return SVN_NO_ERROR;
+
+      svn_membuf__ensure(&data, prefix_len + 1);
+      SVN_ERR(read_snapshot_data(&complete, stream, data.data, prefix_len));
+      if (!complete)
+        return SVN_NO_ERROR;
+
+      ((char *)data.data)[prefix_len] = '\0';
+      SVN_ERR(prefix_pool_get(&prefix_map[i], cache->prefix_pool,
+                              data.data));
+    }
+
+  /* Re-insert the items until we reach the end of the snapshot. */
+  while (TRUE)
+    {
+      svn_membuffer_t *segment = cache;
+      full_key_t key;
+      apr_uint32_t group_index;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(read_snapshot_data(&complete, stream, &record,
+                                 sizeof(record)));
+      if (   !complete
+          || record.prefix_idx >= header.prefix_count
+          || record.size > MAX_ITEM_SIZE
+          || record.size > cache->data_size)
+        break;
+
+      svn_membuf__ensure(&data, (apr_size_t)record.size);
+      SVN_ERR(read_snapshot_data(&complete, stream, data.data,
+                                 (apr_size_t)record.size));
+      if (!complete)
+        break;
+
+      /* Our prefix pool may be full. */
+      if (prefix_map[record.prefix_idx] == NO_INDEX)
+        continue;
+
+      memset(&key, 0, sizeof(key));
+      key.entry_key.fingerprint[0] = record.fingerprint[0];
+      key.entry_key.fingerprint[1] = record.fingerprint[1];
+      key.entry_key.key_len = 0;
+      key.entry_key.prefix_idx = prefix_map[record.prefix_idx];
+
+      group_index = get_group_index(&segment, &key.entry_key, partition);
+      WITH_WRITE_LOCK(segment,
+                      membuffer_cache_set_internal(segment,
+                                                   &key,
+                                                   group_index,
+                                                   data.data,
+                                                   (apr_size_t)record.size,
+                                                   record.priority,
+                                                   iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__membuffer_load(svn_membuffer_t *cache,
+                          const char *path,
+                          apr_pool_t *scratch_pool)
+{
+  svn_stream_t *stream;
+  svn_error_t *err;
+
+  err = svn_stream_open_readonly(&stream, path, scratch_pool, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      /* No snapshot, no warm start. */
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  err = read_snapshot(cache, stream, scratch_pool);
+  return svn_error_compose_create(err, svn_stream_close(stream));
+}
+
+#else /* SVN_DEBUG_CACHE_MEMBUFFER */
+
+svn_error_t *
+svn_cache__membuffer_save(svn_membuffer_t *cache,
+                          const char *path,
+                          apr_pool_t *scratch_pool)
+{
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Can't write snapshots of debug caches"));
+}
+
+svn_error_t *
+svn_cache__membuffer_load(svn_membuffer_t *cache,
+                          const char *path,
+                          apr_pool_t *scratch_pool)
+{
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Can't load snapshots into debug caches"));
+}
+
+#endif /* SVN_DEBUG_CACHE_MEMBUFFER */
@@ -21,8 +21,12 @@
  * ====================================================================
  */
 
+#include <stdlib.h>
+#include <string.h>
 #include <apr_md5.h>
+#include <apr_time.h>
 
+#include "svn_hash.h"
 #include "svn_pools.h"
 #include "svn_base64.h"
 #include "svn_path.h"
@@ -30,6 +34,7 @@
 #include "svn_private_config.h"
 #include "private/svn_cache.h"
 #include "private/svn_dep_compat.h"
+#include "private/svn_atomic.h"
 
 #include "cache.h"
 
@@ -37,18 +42,49 @@
 
 #include <apr_memcache.h>
 
+#if APR_HAS_THREADS
+#include <apr_thread_pool.h>
+#endif
+
 /* A note on thread safety:
 
    The apr_memcache_t object does its own mutex handling, and nothing
    else in memcache_t is ever modified, so this implementation should
-   be fully thread-safe.
+   be fully thread-safe.  Asynchronous writes only share the counter
+   of pending writes, which is modified atomically.
 */
 
+/* Maximum number of asynchronous writes that may be queued per
+ * svn_memcache_t.  Beyond that, writes will become synchronous again,
+ * limiting the memory held by the queue as well as the delay until
+ * the data becomes visible to readers. */
+#define MAX_PENDING_ASYNC_SETS 256
+
+/* The wrapper around apr_memcache_t. */
+struct svn_memcache_t {
+  apr_memcache_t *c;
+
+  /* Pool that C has been allocated in. */
+  apr_pool_t *pool;
+
+#if APR_HAS_THREADS
+  /* Background thread executing asynchronous writes.  NULL, if writes
+   * shall be synchronous. */
+  apr_thread_pool_t *writer;
+#endif
+
+  /* Number of writes queued in WRITER but not completed yet. */
+  volatile svn_atomic_t pending_sets;
+};
+
 /* The (internal) cache object. */
 typedef struct memcache_t {
   /* The memcached server set we're using. */
   apr_memcache_t *memcache;
 
+  /* The wrapper around MEMCACHE, giving access to e.g. the async writer. */
+  svn_memcache_t *owner;
+
   /* A prefix used to differentiate our data from any other data in
    * the memcached (URI-encoded). */
   const char *prefix;
@@ -63,11 +99,6 @@ typedef struct memcache_t {
   svn_cache__deserialize_func_t deserialize_func;
 } memcache_t;
 
-/* The wrapper around apr_memcache_t. */
-struct svn_memcache_t {
-  apr_memcache_t *c;
-};
-
 
 /* The memcached protocol says the maximum key length is 250.  Let's
    just say 249, to be safe. */
@@ -176,6 +207,33 @@ memcache_internal_get(char **data,
 }
 
 
+/* De-serialize the DATA_LEN bytes of DATA, as read from the memcached
+ * by CACHE, into *VALUE_P.  DATA must have been allocated in RESULT_POOL.
+ */
+static svn_error_t *
+deserialize_value(void **value_p,
+                  memcache_t *cache,
+                  char *data,
+                  apr_size_t data_len,
+                  apr_pool_t *result_pool)
+{
+  if (cache->deserialize_func)
+    {
+      SVN_ERR((cache->deserialize_func)(value_p, data, data_len,
+                                        result_pool));
+    }
+  else
+    {
+      svn_stringbuf_t *value = svn_stringbuf_create_empty(result_pool);
+      value->data = data;
+      value->blocksize = data_len;
+      value->len = data_len - 1; /* account for trailing NUL */
+      *value_p = value;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 memcache_get(void **value_p,
              svn_boolean_t *found,
@@ -195,22 +253,70 @@ memcache_get(void **value_p,
 
   /* If we found it, de-serialize it. */
   if (*found)
+    SVN_ERR(deserialize_value(value_p, cache, data, data_len, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement vtable.get_many using a single memcached multi-get request
+ * for all non-NULL KEYS.
+ */
+static svn_error_t *
+memcache_get_many(void **values,
+                  svn_boolean_t *found,
+                  void *cache_void,
+                  const void * const *keys,
+                  int key_count,
+                  apr_pool_t *result_pool)
+{
+  memcache_t *cache = cache_void;
+  apr_pool_t *subpool = svn_pool_create(result_pool);
+  const char **mc_keys = apr_pcalloc(subpool, key_count * sizeof(*mc_keys));
+  apr_hash_t *mc_values = NULL;
+  apr_status_t apr_err;
+  int i;
+
+  for (i = 0; i < key_count; ++i)
     {
-      if (cache->deserialize_func)
-        {
-          SVN_ERR((cache->deserialize_func)(value_p, data, data_len,
-                                            result_pool));
-        }
-      else
+      found[i] = FALSE;
+      if (keys[i] == NULL)
+        continue;
+
+      SVN_ERR(build_key(&mc_keys[i], cache, keys[i], subpool));
+      apr_memcache_add_multget_key(subpool, mc_keys[i], &mc_values);
+    }
+
+  /* Nothing to look up? */
+  if (mc_values == NULL)
+    {
+      svn_pool_destroy(subpool);
+      return SVN_NO_ERROR;
+    }
+
+  /* The value data gets allocated in RESULT_POOL, everything else is
+   * temporary. */
+  apr_err = apr_memcache_multgetp(cache->memcache, subpool, result_pool,
+                                  mc_values);
+  if (apr_err != APR_SUCCESS)
+    return svn_error_wrap_apr(apr_err,
+                              _("Unknown memcached error while reading"));
+
+  for (i = 0; i < key_count; ++i)
+    {
+      apr_memcache_value_t *value;
+      if (mc_keys[i] == NULL)
+        continue;
+
+      value = svn_hash_gets(mc_values, mc_keys[i]);
+      if (value && value->status == APR_SUCCESS && value->data)
         {
-          svn_stringbuf_t *value = svn_stringbuf_create_empty(result_pool);
-          value->data = data;
-          value->blocksize = data_len;
-          value->len = data_len - 1; /* account for trailing NUL */
-          *value_p = value;
+          SVN_ERR(deserialize_value(&values[i], cache, value->data,
+                                    value->len, result_pool));
+          found[i] = TRUE;
         }
     }
 
+  svn_pool_destroy(subpool);
   return SVN_NO_ERROR;
 }
 
@@ -234,9 +340,115 @@ memcache_has_key(svn_boolean_t *found,
   return SVN_NO_ERROR;
 }
 
+#if APR_HAS_THREADS
+
+/* A single asynchronous write.  Allocated with malloc() as it will be
+ * processed and released by the background writer thread.
+ */
+typedef struct async_set_t
+{
+  /* Server set to write to. */
+  svn_memcache_t *owner;
+
+  /* Length of DATA in bytes. */
+  apr_size_t len;
+
+  /* The memcached key (NUL-terminated) followed by the LEN bytes of the
+   * serialized value. */
+  char *data;
+
+  /* Start of the memcached key. */
+  char key[1];
+} async_set_t;
+
+/* Implement apr_thread_start_t, writing the async_set_t given as DATA to
+ * the memcached and releasing it afterwards.
+ */
+static void * APR_THREAD_FUNC
+async_set_func(apr_thread_t *thread,
+               void *data)
+{
+  async_set_t *task = data;
+
+  /* Nobody is waiting for the result, so errors can only be ignored.
+   * Caching is optional, after all. */
+  apr_memcache_set(task->owner->c, task->key, task->data, task->len, 0, 0);
+
+  svn_atomic_dec(&task->owner->pending_sets);
+  free(task);
+
+  return NULL;
+}
+
+/* Try to queue the write of LEN bytes of DATA to MC_KEY in OWNER's
+ * background writer.  Set *QUEUED to FALSE, if the data must be written
+ * synchronously instead.
+ */
+static void
+queue_async_set(svn_boolean_t *queued,
+                svn_memcache_t *owner,
+                const char *mc_key,
+                const char *data,
+                apr_size_t len)
+{
+  apr_size_t key_len = strlen(mc_key);
+  async_set_t *task;
+
+  *queued = FALSE;
+  if (svn_atomic_inc(&owner->pending_sets) >= MAX_PENDING_ASYNC_SETS)
+    {
+      svn_atomic_dec(&owner->pending_sets);
+      return;
+    }
+
+  task = malloc(sizeof(*task) + key_len + len);
+  if (task == NULL)
+    {
+      svn_atomic_dec(&owner->pending_sets);
+      return;
+    }
+
+  task->owner = owner;
+  task->len = len;
+  task->data = task->key + key_len + 1;
+  memcpy(task->key, mc_key, key_len + 1);
+  memcpy(task->data, data, len);
+
+  if (apr_thread_pool_push(owner->writer, async_set_func, task, 0, NULL))
+    {
+      svn_atomic_dec(&owner->pending_sets);
+      free(task);
+      return;
+    }
+
+  *queued = TRUE;
+}
+
+/* Pool pre-cleanup function waiting for all asynchronous writes of the
+ * svn_memcache_t given as DATA to complete before shutting down its
+ * background writer.  Runs before the apr_memcache_t gets destroyed.
+ */
+static apr_status_t
+async_writer_pre_cleanup(void *data)
+{
+  svn_memcache_t *memcache = data;
+  apr_thread_pool_t *writer = memcache->writer;
+
+  /* Stop queuing new writes. */
+  memcache->writer = NULL;
+
+  while (svn_atomic_read(&memcache->pending_sets))
+    apr_sleep(1000);
+
+  return apr_thread_pool_destroy(writer);
+}
+
+#endif /* APR_HAS_THREADS */
+
 /* Core functionality of our setter functions: store LENGTH bytes of DATA
  * to be identified by KEY in the memcached given by CACHE_VOID. Use POOL
- * for temporary allocations.
+ * for temporary allocations.  Queue the write in the background writer,
+ * if async writes have been enabled.
  */
 static svn_error_t *
 memcache_internal_set(void *cache_void,
@@ -250,6 +462,17 @@ memcache_internal_set(void *cache_void,
   apr_status_t apr_err;
 
   SVN_ERR(build_key(&mc_key, cache, key, scratch_pool));
+
+#if APR_HAS_THREADS
+  if (cache->owner->writer)
+    {
+      svn_boolean_t queued;
+      queue_async_set(&queued, cache->owner, mc_key, data, len);
+      if (queued)
+        return SVN_NO_ERROR;
+    }
+#endif
+
   apr_err = apr_memcache_set(cache->memcache, mc_key, (char *)data, len, 0, 0);
 
   /* ### Maybe write failures should be ignored (but logged)? */
@@ -398,7 +621,8 @@ static svn_cache__vtable_t memcache_vtable = {
   memcache_is_cachable,
   memcache_get_partial,
   memcache_set_partial,
-  memcache_get_info
+  memcache_get_info,
+  memcache_get_many
 };
 
 svn_error_t *
@@ -418,6 +642,7 @@ svn_cache__create_memcache(svn_cache__t **cache_p,
   cache->klen = klen;
   cache->prefix = svn_path_uri_encode(prefix, pool);
   cache->memcache = memcache->c;
+  cache->owner = memcache;
 
   wrapper->vtable = &memcache_vtable;
   wrapper->cache_internal = cache;
@@ -508,6 +733,29 @@ add_memcache_server(const char *name,
   return TRUE;
 }
 
+svn_error_t *
+svn_cache__memcache_enable_async_sets(svn_memcache_t *memcache)
+{
+#if APR_HAS_THREADS
+  apr_status_t apr_err;
+  if (memcache->writer)
+    return SVN_NO_ERROR;
+
+  /* A single writer thread keeps the writes in order and is sufficient
+   * as long as the server keeps up with our write rate.  Beyond that,
+   * writes will be synchronous anyway. */
+  apr_err = apr_thread_pool_create(&memcache->writer, 0, 1, memcache->pool);
+  if (apr_err != APR_SUCCESS)
+    return svn_error_wrap_apr(apr_err,
+                              _("Can't create memcached writer thread"));
+
+  apr_pool_pre_cleanup_register(memcache->pool, memcache,
+                                async_writer_pre_cleanup);
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 #else /* ! SVN_HAVE_MEMCACHE */
 
 /* Stubs for no apr memcache library. */
@@ -528,6 +776,12 @@ svn_cache__create_memcache(svn_cache__t **cache_p,
   return svn_error_create(SVN_ERR_NO_APR_MEMCACHE, NULL, NULL);
 }
 
+svn_error_t *
+svn_cache__memcache_enable_async_sets(svn_memcache_t *memcache)
+{
+  return svn_error_create(SVN_ERR_NO_APR_MEMCACHE, NULL, NULL);
+}
+
 #endif /* SVN_HAVE_MEMCACHE */
 
 /* Implements svn_config_enumerator2_t.  Just used for the
@@ -573,6 +827,8 @@ svn_cache__make_memcache_from_config(svn_memcache_t **memcache_p,
       return svn_error_wrap_apr(apr_err,
                                 _("Unknown error creating apr_memcache_t"));
 
+    memcache->pool = result_pool;
+
     b.memcache = memcache->c;
     b.memcache_pool = result_pool;
     b.err = SVN_NO_ERROR;
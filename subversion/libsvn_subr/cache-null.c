@@ -138,7 +138,8 @@ static svn_cache__vtable_t null_cache_vtable = {
   null_cache_is_cachable,
   null_cache_get_partial,
   null_cache_set_partial,
-  null_cache_get_info
+  null_cache_get_info,
+  NULL                                    /* get_many: use fallback */
 };
 
 svn_error_t *
@@ -0,0 +1,1177 @@
+/*
+ * cache-redis.c: Redis caching for Subversion
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <apr_md5.h>
+#include <apr_network_io.h>
+#include <apr_strings.h>
+#include <apr_time.h>
+
+#include "svn_pools.h"
+#include "svn_sorts.h"
+#include "svn_string.h"
+
+#include "svn_private_config.h"
+#include "private/svn_cache.h"
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
+#include "private/svn_string_private.h"
+
+#include "cache.h"
+
+/* A note on thread safety:
+
+   Every server has a single connection that is guarded by the server's
+   mutex.  A request (or a pipelined batch of requests) holds the mutex
+   until all replies have been read.  The only other shared state is the
+   time until which a server is considered unavailable, which is read
+   and written atomically.  Everything else is immutable after
+   construction.
+*/
+
+/* Number of points each server gets on the consistent hashing ring.
+ * Each MD5 digest provides 4 points. */
+#define POINTS_PER_SERVER 160
+
+/* Timeout for connecting to and communicating with a server. */
+#define REDIS_TIMEOUT apr_time_from_sec(1)
+
+/* After a connection failure, don't try to contact that server again
+ * for this many seconds and let its keys go to the next server on the
+ * ring instead. */
+#define REDIS_RETRY_INTERVAL 5
+
+/* Size of the per-connection reply buffer. */
+#define REDIS_BUFFER_SIZE 0x4000
+
+/* Values up to this size get copied into the request buffer and sent
+ * in a single write.  Larger ones are sent directly from the caller's
+ * buffer. */
+#define REDIS_COPY_THRESHOLD 0x10000
+
+/* Largest value we are going to store.  Redis itself accepts far larger
+ * values but transferring them would take longer than re-constructing
+ * them locally. */
+#define REDIS_MAX_VALUE_SIZE 0x1000000
+
+/* A single Redis server and our connection to it. */
+typedef struct redis_server_t
+{
+  /* "HOST:PORT", used in error messages. */
+  const char *name;
+
+  /* Resolved address of the server. */
+  apr_sockaddr_t *addr;
+
+  /* Serializes all access to the members below. */
+  svn_mutex__t *mutex;
+
+  /* Seconds since the epoch until which the server shall be considered
+   * unavailable.  0, if the server is assumed to be up. */
+  volatile svn_atomic_t retry_after;
+
+  /* Root pool holding SOCK.  NULL, if not connected. */
+  apr_pool_t *conn_pool;
+
+  /* Our connection to the server.  NULL, if not connected. */
+  apr_socket_t *sock;
+
+  /* Reply data that has been received but not been processed, yet,
+   * is in BUFFER[START, END). */
+  char *buffer;
+  apr_size_t start;
+  apr_size_t end;
+} redis_server_t;
+
+/* A point on the consistent hashing ring. */
+typedef struct ring_point_t
+{
+  /* Position on the ring. */
+  apr_uint32_t hash;
+
+  /* Server responsible for all keys in (previous point, HASH]. */
+  redis_server_t *server;
+} ring_point_t;
+
+/* The set of Redis servers a cache may use. */
+struct svn_redis_t {
+  /* All configured servers. */
+  redis_server_t **servers;
+  int server_count;
+
+  /* Points sorted by HASH.  There are POINTS_PER_SERVER for every
+   * server. */
+  ring_point_t *ring;
+  int ring_size;
+};
+
+/* The (internal) cache object. */
+typedef struct redis_cache_t {
+  /* The servers we're using. */
+  svn_redis_t *redis;
+
+  /* A prefix used to differentiate our data from any other data in
+   * the Redis database. */
+  const char *prefix;
+
+  /* The size of the key: either a fixed number of bytes or
+   * APR_HASH_KEY_STRING. */
+  apr_ssize_t klen;
+
+  /* Used to marshal values in and out of the cache. */
+  svn_cache__serialize_func_t serialize_func;
+  svn_cache__deserialize_func_t deserialize_func;
+} redis_cache_t;
+
+
+/*** Connection handling. ***/
+
+/* Return whether SERVER has failed recently and should not be used. */
+static svn_boolean_t
+server_is_down(redis_server_t *server)
+{
+  apr_uint32_t retry_after = svn_atomic_read(&server->retry_after);
+  return retry_after
+      && (apr_uint32_t)apr_time_sec(apr_time_now()) < retry_after;
+}
+
+/* Close the connection to SERVER, if there is one.  Unless SERVER_OK is
+ * set, also mark it as unavailable for the next REDIS_RETRY_INTERVAL
+ * seconds.
+ */
+static void
+server_disconnect(redis_server_t *server,
+                  svn_boolean_t server_ok)
+{
+  if (server->conn_pool)
+    svn_pool_destroy(server->conn_pool);
+
+  server->conn_pool = NULL;
+  server->sock = NULL;
+  server->start = 0;
+  server->end = 0;
+
+  if (!server_ok)
+    svn_atomic_set(&server->retry_after,
+                   (apr_uint32_t)apr_time_sec(apr_time_now())
+                   + REDIS_RETRY_INTERVAL);
+}
+
+/* Open a connection to SERVER unless it is already connected. */
+static svn_error_t *
+server_connect(redis_server_t *server)
+{
+  apr_status_t apr_err;
+
+  if (server->sock)
+    return SVN_NO_ERROR;
+
+  /* Connections are opened and closed by whichever thread happens to
+   * use the server.  Give them their own root pool, so we don't need
+   * to synchronize with other users of the pool the server lives in. */
+  server->conn_pool
+    = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+  apr_err = apr_socket_create(&server->sock, server->addr->family,
+                              SOCK_STREAM, APR_PROTO_TCP,
+                              server->conn_pool);
+  if (!apr_err)
+    apr_err = apr_socket_timeout_set(server->sock, REDIS_TIMEOUT);
+
+  /* Requests are followed by a read, so Nagle would only add latency. */
+  if (!apr_err)
+    apr_err = apr_socket_opt_set(server->sock, APR_TCP_NODELAY, 1);
+  if (!apr_err)
+    apr_err = apr_socket_connect(server->sock, server->addr);
+
+  if (apr_err)
+    {
+      server_disconnect(server, FALSE);
+      return svn_error_wrap_apr(apr_err,
+                                _("Can't connect to Redis server '%s'"),
+                                server->name);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Send all LEN bytes of DATA to SERVER. */
+static svn_error_t *
+server_send(redis_server_t *server,
+            const char *data,
+            apr_size_t len)
+{
+  while (len)
+    {
+      apr_size_t written = len;
+      apr_status_t apr_err = apr_socket_send(server->sock, data, &written);
+      if (apr_err)
+        return svn_error_wrap_apr(apr_err,
+                                  _("Can't write to Redis server '%s'"),
+                                  server->name);
+
+      data += written;
+      len -= written;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Receive at most LEN bytes from SERVER into DATA.  Set *RECEIVED to
+ * the number of bytes actually received, which will be at least 1. */
+static svn_error_t *
+server_recv(redis_server_t *server,
+            char *data,
+            apr_size_t len,
+            apr_size_t *received)
+{
+  apr_status_t apr_err = apr_socket_recv(server->sock, data, &len);
+  if (apr_err == APR_EOF || (!apr_err && len == 0))
+    return svn_error_createf(SVN_ERR_REDIS_REPLY, NULL,
+                             _("Connection to Redis server '%s' "
+                               "closed unexpectedly"),
+                             server->name);
+  if (apr_err)
+    return svn_error_wrap_apr(apr_err,
+                              _("Can't read from Redis server '%s'"),
+                              server->name);
+
+  *received = len;
+  return SVN_NO_ERROR;
+}
+
+/* Read the next CRLF-terminated line from SERVER.  Return it in *LINE,
+ * NUL-terminated and without the CRLF.  The line lives in SERVER's
+ * buffer and remains valid until the next read from SERVER.
+ */
+static svn_error_t *
+read_line(const char **line,
+          redis_server_t *server)
+{
+  apr_size_t scanned = server->start;
+  while (TRUE)
+    {
+      apr_size_t received;
+      char *eol = NULL;
+
+      if (scanned < server->end)
+        eol = memchr(server->buffer + scanned, '\n',
+                     server->end - scanned);
+
+      if (eol)
+        {
+          char *data = server->buffer + server->start;
+          if (eol == data || eol[-1] != '\r')
+            return svn_error_createf(SVN_ERR_REDIS_REPLY, NULL,
+                                     _("Malformed reply from Redis server "
+                                       "'%s'"),
+                                     server->name);
+
+          eol[-1] = '\0';
+          server->start = eol + 1 - server->buffer;
+          *line = data;
+
+          return SVN_NO_ERROR;
+        }
+
+      /* Make room for more data. */
+      if (server->start > 0)
+        {
+          memmove(server->buffer, server->buffer + server->start,
+                  server->end - server->start);
+          server->end -= server->start;
+          server->start = 0;
+        }
+
+      if (server->end == REDIS_BUFFER_SIZE)
+        return svn_error_createf(SVN_ERR_REDIS_REPLY, NULL,
+                                 _("Reply line from Redis server '%s' "
+                                   "too long"),
+                                 server->name);
+
+      scanned = server->end;
+      SVN_ERR(server_recv(server, server->buffer + server->end,
+                          REDIS_BUFFER_SIZE - server->end, &received));
+      server->end += received;
+    }
+}
+
+/* Read exactly LEN bytes from SERVER into DATA. */
+static svn_error_t *
+read_bytes(char *data,
+           apr_size_t len,
+           redis_server_t *server)
+{
+  /* Use what has already been buffered. */
+  apr_size_t buffered = MIN(len, server->end - server->start);
+  memcpy(data, server->buffer + server->start, buffered);
+  server->start += buffered;
+  data += buffered;
+  len -= buffered;
+
+  /* Anything else goes directly into DATA. */
+  while (len)
+    {
+      apr_size_t received;
+      SVN_ERR(server_recv(server, data, len, &received));
+      data += received;
+      len -= received;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return an error for the error reply LINE received from SERVER. */
+static svn_error_t *
+server_error(redis_server_t *server,
+             const char *line)
+{
+  if (*line == '-')
+    return svn_error_createf(SVN_ERR_REDIS_REPLY, NULL,
+                             _("Redis server '%s' reported an error: %s"),
+                             server->name, line + 1);
+
+  return svn_error_createf(SVN_ERR_REDIS_REPLY, NULL,
+                           _("Unexpected reply from Redis server '%s'"),
+                           server->name);
+}
+
+/* Read a status reply from SERVER.  Return an error unless it is "OK". */
+static svn_error_t *
+read_status(redis_server_t *server)
+{
+  const char *line;
+  SVN_ERR(read_line(&line, server));
+  if (*line != '+')
+    return server_error(server, line);
+
+  return SVN_NO_ERROR;
+}
+
+/* Read a bulk string reply from SERVER.  If it is the nil reply, set
+ * *FOUND to FALSE.  Otherwise, set *FOUND to TRUE and return the *SIZE
+ * bytes in *DATA, allocated in RESULT_POOL.  *DATA will be followed by
+ * an extra NUL byte.
+ */
+static svn_error_t *
+read_bulk(char **data,
+          apr_size_t *size,
+          svn_boolean_t *found,
+          redis_server_t *server,
+          apr_pool_t *result_pool)
+{
+  const char *line;
+  apr_int64_t len;
+  char crlf[2];
+  svn_error_t *err;
+
+  SVN_ERR(read_line(&line, server));
+  if (*line != '$')
+    return server_error(server, line);
+
+  err = svn_cstring_strtoi64(&len, line + 1, -1, APR_INT32_MAX, 10);
+  if (err)
+    return svn_error_compose_create(server_error(server, ""), err);
+
+  if (len < 0)
+    {
+      *found = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  *size = (apr_size_t)len;
+  *data = apr_palloc(result_pool, *size + 1);
+  SVN_ERR(read_bytes(*data, *size, server));
+  (*data)[*size] = '\0';
+
+  SVN_ERR(read_bytes(crlf, sizeof(crlf), server));
+  if (crlf[0] != '\r' || crlf[1] != '\n')
+    return server_error(server, "");
+
+  *found = TRUE;
+  return SVN_NO_ERROR;
+}
+
+
+/*** Requests. ***/
+
+/* Append the RESP bulk string header for a string of LEN bytes to BUF. */
+static void
+append_bulk_header(svn_stringbuf_t *buf,
+                   apr_size_t len)
+{
+  char header[SVN_INT64_BUFFER_SIZE + 4];
+  header[0] = '$';
+  len = svn__ui64toa(header + 1, len) + 1;
+  header[len++] = '\r';
+  header[len++] = '\n';
+  svn_stringbuf_appendbytes(buf, header, len);
+}
+
+/* Append the RESP bulk string for the LEN bytes in DATA to BUF. */
+static void
+append_bulk(svn_stringbuf_t *buf,
+            const char *data,
+            apr_size_t len)
+{
+  append_bulk_header(buf, len);
+  svn_stringbuf_appendbytes(buf, data, len);
+  svn_stringbuf_appendbytes(buf, "\r\n", 2);
+}
+
+/* Signature of functions sending a request to SERVER and reading its
+ * reply.  BATON is specific to the request. */
+typedef svn_error_t *(*request_func_t)(redis_server_t *server,
+                                       void *baton);
+
+/* Connect to SERVER, if necessary, and run REQUEST with BATON.  If that
+ * fails, drop the connection as it may contain unprocessed replies.
+ */
+static svn_error_t *
+run_request_locked(redis_server_t *server,
+                   request_func_t request,
+                   void *baton)
+{
+  svn_error_t *err;
+
+  SVN_ERR(server_connect(server));
+
+  err = request(server, baton);
+  if (err)
+    server_disconnect(server, err->apr_err == SVN_ERR_REDIS_REPLY);
+
+  return svn_error_trace(err);
+}
+
+/* Run REQUEST with BATON against SERVER, serialized with other users
+ * of that server. */
+static svn_error_t *
+run_request(redis_server_t *server,
+            request_func_t request,
+            void *baton)
+{
+  SVN_MUTEX__WITH_LOCK(server->mutex,
+                       run_request_locked(server, request, baton));
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for get_request. */
+typedef struct get_baton_t
+{
+  /* Number of keys to fetch. */
+  int count;
+
+  /* The Redis keys. */
+  svn_stringbuf_t **keys;
+
+  /* Results.  Arrays of COUNT elements each. */
+  char **data;
+  apr_size_t *sizes;
+  svn_boolean_t *found;
+
+  /* Pool for the DATA and temporaries. */
+  apr_pool_t *result_pool;
+  apr_pool_t *scratch_pool;
+} get_baton_t;
+
+/* Implements request_func_t.  Send all GET requests described by the
+ * get_baton_t BATON in a single pipeline and collect the replies. */
+static svn_error_t *
+get_request(redis_server_t *server,
+            void *baton)
+{
+  get_baton_t *b = baton;
+  svn_stringbuf_t *request = svn_stringbuf_create_empty(b->scratch_pool);
+  int i;
+
+  for (i = 0; i < b->count; ++i)
+    {
+      svn_stringbuf_appendcstr(request, "*2\r\n$3\r\nGET\r\n");
+      append_bulk(request, b->keys[i]->data, b->keys[i]->len);
+    }
+
+  SVN_ERR(server_send(server, request->data, request->len));
+
+  for (i = 0; i < b->count; ++i)
+    SVN_ERR(read_bulk(&b->data[i], &b->sizes[i], &b->found[i], server,
+                      b->result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for set_request. */
+typedef struct set_baton_t
+{
+  /* The Redis key. */
+  svn_stringbuf_t *key;
+
+  /* The value to store. */
+  const char *data;
+  apr_size_t size;
+
+  /* Pool for temporaries. */
+  apr_pool_t *scratch_pool;
+} set_baton_t;
+
+/* Implements request_func_t.  Store the value described by the
+ * set_baton_t BATON.  Cached data is immutable, so the key never
+ * expires.  It is up to the server's eviction policy to make room. */
+static svn_error_t *
+set_request(redis_server_t *server,
+            void *baton)
+{
+  set_baton_t *b = baton;
+  svn_stringbuf_t *request
+    = svn_stringbuf_create_ensure(b->key->len + 64
+                                  + MIN(b->size, REDIS_COPY_THRESHOLD),
+                                  b->scratch_pool);
+
+  svn_stringbuf_appendcstr(request, "*3\r\n$3\r\nSET\r\n");
+  append_bulk(request, b->key->data, b->key->len);
+
+  if (b->size <= REDIS_COPY_THRESHOLD)
+    {
+      append_bulk(request, b->data, b->size);
+      SVN_ERR(server_send(server, request->data, request->len));
+    }
+  else
+    {
+      append_bulk_header(request, b->size);
+      SVN_ERR(server_send(server, request->data, request->len));
+      SVN_ERR(server_send(server, b->data, b->size));
+      SVN_ERR(server_send(server, "\r\n", 2));
+    }
+
+  return svn_error_trace(read_status(server));
+}
+
+
+/*** Key distribution. ***/
+
+/* Return the first 32 bits of the MD5 digest of the LEN bytes in DATA. */
+static apr_uint32_t
+hash_key(const char *data,
+         apr_size_t len)
+{
+  unsigned char digest[APR_MD5_DIGESTSIZE];
+  apr_md5(digest, data, len);
+
+  return ((apr_uint32_t)digest[3] << 24)
+       | ((apr_uint32_t)digest[2] << 16)
+       | ((apr_uint32_t)digest[1] << 8)
+       |  (apr_uint32_t)digest[0];
+}
+
+/* Return the server in REDIS responsible for the Redis key KEY.  Skip
+ * servers that have failed recently, unless all of them did.
+ */
+static redis_server_t *
+find_server(svn_redis_t *redis,
+            const svn_stringbuf_t *key)
+{
+  apr_uint32_t hash = hash_key(key->data, key->len);
+  int lower = 0;
+  int upper = redis->ring_size;
+  int i;
+
+  /* Find the first point at or after HASH. */
+  while (lower < upper)
+    {
+      int middle = lower + (upper - lower) / 2;
+      if (redis->ring[middle].hash < hash)
+        lower = middle + 1;
+      else
+        upper = middle;
+    }
+
+  for (i = 0; i < redis->ring_size; ++i)
+    {
+      redis_server_t *server
+        = redis->ring[(lower + i) % redis->ring_size].server;
+      if (!server_is_down(server))
+        return server;
+    }
+
+  return redis->ring[lower % redis->ring_size].server;
+}
+
+/* qsort comparison function for ring_point_t. */
+static int
+compare_ring_points(const void *lhs,
+                    const void *rhs)
+{
+  apr_uint32_t lhs_hash = ((const ring_point_t *)lhs)->hash;
+  apr_uint32_t rhs_hash = ((const ring_point_t *)rhs)->hash;
+
+  return lhs_hash < rhs_hash ? -1 : (lhs_hash > rhs_hash ? 1 : 0);
+}
+
+
+/*** The cache implementation. ***/
+
+/* Return the Redis key for the cache key KEY in CACHE, allocated in
+ * RESULT_POOL.  Redis keys are binary-safe, so there is no need to
+ * encode KEY. */
+static svn_stringbuf_t *
+build_key(redis_cache_t *cache,
+          const void *key,
+          apr_pool_t *result_pool)
+{
+  apr_size_t key_len = cache->klen == APR_HASH_KEY_STRING
+                     ? strlen(key)
+                     : (apr_size_t)cache->klen;
+  svn_stringbuf_t *result
+    = svn_stringbuf_createf(result_pool, "SVN:%s:", cache->prefix);
+  svn_stringbuf_appendbytes(result, key, key_len);
+
+  return result;
+}
+
+/* De-serialize the DATA_LEN bytes of DATA, as read from the Redis server
+ * by CACHE, into *VALUE_P.  DATA must have been allocated in RESULT_POOL.
+ */
+static svn_error_t *
+deserialize_value(void **value_p,
+                  redis_cache_t *cache,
+                  char *data,
+                  apr_size_t data_len,
+                  apr_pool_t *result_pool)
+{
+  if (cache->deserialize_func)
+    {
+      SVN_ERR((cache->deserialize_func)(value_p, data, data_len,
+                                        result_pool));
+    }
+  else
+    {
+      svn_stringbuf_t *value = svn_stringbuf_create_empty(result_pool);
+      value->data = data;
+      value->blocksize = data_len;
+      value->len = data_len - 1; /* account for trailing NUL */
+      *value_p = value;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Core functionality of our getter functions: fetch DATA from the server
+ * responsible for KEY in CACHE_VOID.  Indicate success in FOUND.
+ * Allocate DATA in RESULT_POOL.
+ */
+static svn_error_t *
+redis_internal_get(char **data,
+                   apr_size_t *size,
+                   svn_boolean_t *found,
+                   void *cache_void,
+                   const void *key,
+                   apr_pool_t *result_pool)
+{
+  redis_cache_t *cache = cache_void;
+  apr_pool_t *subpool;
+  svn_stringbuf_t *redis_key;
+  get_baton_t baton;
+
+  if (key == NULL)
+    {
+      *found = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  subpool = svn_pool_create(result_pool);
+  redis_key = build_key(cache, key, subpool);
+
+  baton.count = 1;
+  baton.keys = &redis_key;
+  baton.data = data;
+  baton.sizes = size;
+  baton.found = found;
+  baton.result_pool = result_pool;
+  baton.scratch_pool = subpool;
+
+  SVN_ERR(run_request(find_server(cache->redis, redis_key), get_request,
+                      &baton));
+
+  svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+redis_get(void **value_p,
+          svn_boolean_t *found,
+          void *cache_void,
+          const void *key,
+          apr_pool_t *result_pool)
+{
+  redis_cache_t *cache = cache_void;
+  char *data;
+  apr_size_t data_len;
+  SVN_ERR(redis_internal_get(&data, &data_len, found, cache_void, key,
+                             result_pool));
+
+  /* If we found it, de-serialize it. */
+  if (*found)
+    SVN_ERR(deserialize_value(value_p, cache, data, data_len, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement vtable.get_many by sending a single pipeline of GET requests
+ * to each server that is responsible for any of the non-NULL KEYS.
+ */
+static svn_error_t *
+redis_get_many(void **values,
+               svn_boolean_t *found,
+               void *cache_void,
+               const void * const *keys,
+               int key_count,
+               apr_pool_t *result_pool)
+{
+  redis_cache_t *cache = cache_void;
+  apr_pool_t *subpool = svn_pool_create(result_pool);
+  svn_stringbuf_t **redis_keys
+    = apr_pcalloc(subpool, key_count * sizeof(*redis_keys));
+  redis_server_t **servers
+    = apr_pcalloc(subpool, key_count * sizeof(*servers));
+  char **data = apr_pcalloc(subpool, key_count * sizeof(*data));
+  apr_size_t *sizes = apr_pcalloc(subpool, key_count * sizeof(*sizes));
+  int *batch = apr_pcalloc(subpool, key_count * sizeof(*batch));
+  get_baton_t baton;
+  int i;
+
+  for (i = 0; i < key_count; ++i)
+    {
+      found[i] = FALSE;
+      if (keys[i] == NULL)
+        continue;
+
+      redis_keys[i] = build_key(cache, keys[i], subpool);
+      servers[i] = find_server(cache->redis, redis_keys[i]);
+    }
+
+  baton.keys = apr_pcalloc(subpool, key_count * sizeof(*baton.keys));
+  baton.data = apr_pcalloc(subpool, key_count * sizeof(*baton.data));
+  baton.sizes = apr_pcalloc(subpool, key_count * sizeof(*baton.sizes));
+  baton.found = apr_pcalloc(subpool, key_count * sizeof(*baton.found));
+  baton.result_pool = result_pool;
+  baton.scratch_pool = subpool;
+
+  /* Process the keys server by server, each time picking the server of
+   * the first key not processed, yet. */
+  for (i = 0; i < key_count; ++i)
+    {
+      redis_server_t *server = servers[i];
+      int k;
+
+      if (server == NULL)
+        continue;
+
+      baton.count = 0;
+      for (k = i; k < key_count; ++k)
+        if (servers[k] == server)
+          {
+            batch[baton.count] = k;
+            baton.keys[baton.count] = redis_keys[k];
+            ++baton.count;
+            servers[k] = NULL;
+          }
+
+      SVN_ERR(run_request(server, get_request, &baton));
+
+      for (k = 0; k < baton.count; ++k)
+        {
+          found[batch[k]] = baton.found[k];
+          data[batch[k]] = baton.data[k];
+          sizes[batch[k]] = baton.sizes[k];
+        }
+    }
+
+  for (i = 0; i < key_count; ++i)
+    if (found[i])
+      SVN_ERR(deserialize_value(&values[i], cache, data[i], sizes[i],
+                                result_pool));
+
+  svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
+}
+
+/* Implement vtable.has_key in terms of the getter.
+ */
+static svn_error_t *
+redis_has_key(svn_boolean_t *found,
+              void *cache_void,
+              const void *key,
+              apr_pool_t *scratch_pool)
+{
+  char *data;
+  apr_size_t data_len;
+  SVN_ERR(redis_internal_get(&data, &data_len, found, cache_void, key,
+                             scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Core functionality of our setter functions: store LEN bytes of DATA
+ * to be identified by KEY on the server responsible for it in the cache
+ * CACHE_VOID.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+redis_internal_set(void *cache_void,
+                   const void *key,
+                   const char *data,
+                   apr_size_t len,
+                   apr_pool_t *scratch_pool)
+{
+  redis_cache_t *cache = cache_void;
+  set_baton_t baton;
+
+  baton.key = build_key(cache, key, scratch_pool);
+  baton.data = data;
+  baton.size = len;
+  baton.scratch_pool = scratch_pool;
+
+  return svn_error_trace(run_request(find_server(cache->redis, baton.key),
+                                     set_request, &baton));
+}
+
+static svn_error_t *
+redis_set(void *cache_void,
+          const void *key,
+          void *value,
+          apr_pool_t *scratch_pool)
+{
+  redis_cache_t *cache = cache_void;
+  apr_pool_t *subpool;
+  void *data;
+  apr_size_t data_len;
+  svn_error_t *err;
+
+  if (key == NULL)
+    return SVN_NO_ERROR;
+
+  subpool = svn_pool_create(scratch_pool);
+  if (cache->serialize_func)
+    {
+      SVN_ERR((cache->serialize_func)(&data, &data_len, value, subpool));
+    }
+  else
+    {
+      svn_stringbuf_t *value_str = value;
+      data = value_str->data;
+      data_len = value_str->len + 1; /* copy trailing NUL */
+    }
+
+  err = redis_internal_set(cache_void, key, data, data_len, subpool);
+
+  svn_pool_destroy(subpool);
+  return err;
+}
+
+static svn_error_t *
+redis_get_partial(void **value_p,
+                  svn_boolean_t *found,
+                  void *cache_void,
+                  const void *key,
+                  svn_cache__partial_getter_func_t func,
+                  void *baton,
+                  apr_pool_t *result_pool)
+{
+  char *data;
+  apr_size_t size;
+  SVN_ERR(redis_internal_get(&data, &size, found, cache_void, key,
+                             result_pool));
+
+  /* If we found it, de-serialize it. */
+  return *found
+    ? func(value_p, data, size, baton, result_pool)
+    : SVN_NO_ERROR;
+}
+
+static svn_error_t *
+redis_set_partial(void *cache_void,
+                  const void *key,
+                  svn_cache__partial_setter_func_t func,
+                  void *baton,
+                  apr_pool_t *scratch_pool)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+
+  void *data;
+  apr_size_t size;
+  svn_boolean_t found = FALSE;
+
+  apr_pool_t *subpool = svn_pool_create(scratch_pool);
+  SVN_ERR(redis_internal_get((char **)&data, &size, &found, cache_void,
+                             key, subpool));
+
+  /* If we found it, modify it and write it back to cache */
+  if (found)
+    {
+      SVN_ERR(func(&data, &size, baton, subpool));
+      err = redis_internal_set(cache_void, key, data, size, subpool);
+    }
+
+  svn_pool_destroy(subpool);
+  return err;
+}
+
+static svn_error_t *
+redis_iter(svn_boolean_t *completed,
+           void *cache_void,
+           svn_iter_apr_hash_cb_t user_cb,
+           void *user_baton,
+           apr_pool_t *scratch_pool)
+{
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Can't iterate a Redis cache"));
+}
+
+static svn_boolean_t
+redis_is_cachable(void *unused, apr_size_t size)
+{
+  SVN_UNUSED(unused);
+  return size <= REDIS_MAX_VALUE_SIZE;
+}
+
+static svn_error_t *
+redis_get_info(void *cache_void,
+               svn_cache__info_t *info,
+               svn_boolean_t reset,
+               apr_pool_t *result_pool)
+{
+  redis_cache_t *cache = cache_void;
+
+  info->id = apr_pstrdup(result_pool, cache->prefix);
+
+  /* we don't have any memory allocation info */
+
+  return SVN_NO_ERROR;
+}
+
+static svn_cache__vtable_t redis_vtable = {
+  redis_get,
+  redis_has_key,
+  redis_set,
+  redis_iter,
+  redis_is_cachable,
+  redis_get_partial,
+  redis_set_partial,
+  redis_get_info,
+  redis_get_many
+};
+
+svn_error_t *
+svn_cache__create_redis(svn_cache__t **cache_p,
+                        svn_redis_t *redis,
+                        svn_cache__serialize_func_t serialize_func,
+                        svn_cache__deserialize_func_t deserialize_func,
+                        apr_ssize_t klen,
+                        const char *prefix,
+                        apr_pool_t *result_pool)
+{
+  svn_cache__t *wrapper = apr_pcalloc(result_pool, sizeof(*wrapper));
+  redis_cache_t *cache = apr_pcalloc(result_pool, sizeof(*cache));
+
+  cache->serialize_func = serialize_func;
+  cache->deserialize_func = deserialize_func;
+  cache->klen = klen;
+  cache->prefix = apr_pstrdup(result_pool, prefix);
+  cache->redis = redis;
+
+  wrapper->vtable = &redis_vtable;
+  wrapper->cache_internal = cache;
+  wrapper->error_handler = 0;
+  wrapper->error_baton = 0;
+  wrapper->pretend_empty = !!getenv("SVN_X_DOES_NOT_MARK_THE_SPOT");
+
+  *cache_p = wrapper;
+  return SVN_NO_ERROR;
+}
+
+
+/*** Creating svn_redis_t from svn_config_t. ***/
+
+/* Pool cleanup function closing the connections of the svn_redis_t
+ * given as DATA.  The connections live in their own root pools. */
+static apr_status_t
+close_connections(void *data)
+{
+  svn_redis_t *redis = data;
+  int i;
+
+  for (i = 0; i < redis->server_count; ++i)
+    server_disconnect(redis->servers[i], TRUE);
+
+  return APR_SUCCESS;
+}
+
+/* Baton for add_redis_server. */
+struct ars_baton {
+  svn_redis_t *redis;
+  apr_pool_t *redis_pool;
+  svn_error_t *err;
+};
+
+/* Implements svn_config_enumerator2_t. */
+static svn_boolean_t
+add_redis_server(const char *name,
+                 const char *value,
+                 void *baton,
+                 apr_pool_t *pool)
+{
+  struct ars_baton *b = baton;
+  svn_redis_t *redis = b->redis;
+  redis_server_t *server;
+  char *host, *scope;
+  apr_port_t port;
+  apr_status_t apr_err;
+  int i;
+
+  apr_err = apr_parse_addr_port(&host, &scope, &port, value, pool);
+  if (apr_err != APR_SUCCESS)
+    {
+      b->err = svn_error_wrap_apr(apr_err,
+                                  _("Error parsing Redis server '%s'"),
+                                  name);
+      return FALSE;
+    }
+
+  if (scope)
+    {
+      b->err = svn_error_createf(SVN_ERR_BAD_SERVER_SPECIFICATION, NULL,
+                                 _("Scope not allowed in Redis server "
+                                   "'%s'"),
+                                 name);
+      return FALSE;
+    }
+  if (!host || !port)
+    {
+      b->err = svn_error_createf(SVN_ERR_BAD_SERVER_SPECIFICATION, NULL,
+                                 _("Must specify host and port for Redis "
+                                   "server '%s'"),
+                                 name);
+      return FALSE;
+    }
+
+  server = apr_pcalloc(b->redis_pool, sizeof(*server));
+  server->name = apr_psprintf(b->redis_pool, "%s:%d", host, (int)port);
+  server->buffer = apr_palloc(b->redis_pool, REDIS_BUFFER_SIZE);
+
+  apr_err = apr_sockaddr_info_get(&server->addr, host, APR_UNSPEC, port, 0,
+                                  b->redis_pool);
+  if (apr_err != APR_SUCCESS)
+    {
+      b->err = svn_error_wrap_apr(apr_err,
+                                  _("Can't resolve Redis server '%s'"),
+                                  server->name);
+      return FALSE;
+    }
+
+  b->err = svn_mutex__init(&server->mutex, TRUE, b->redis_pool);
+  if (b->err)
+    return FALSE;
+
+  redis->servers[redis->server_count++] = server;
+
+  /* Place the server on the ring.  The positions depend on the server
+   * address only, so all clients agree on them irrespective of the
+   * order in which the servers have been configured. */
+  for (i = 0; i < POINTS_PER_SERVER / 4; ++i)
+    {
+      unsigned char digest[APR_MD5_DIGESTSIZE];
+      const char *point_name = apr_psprintf(pool, "%s-%d", server->name, i);
+      int k;
+
+      apr_md5(digest, point_name, strlen(point_name));
+      for (k = 0; k < 4; ++k)
+        {
+          ring_point_t *point = &redis->ring[redis->ring_size++];
+          point->hash = ((apr_uint32_t)digest[4 * k + 3] << 24)
+                      | ((apr_uint32_t)digest[4 * k + 2] << 16)
+                      | ((apr_uint32_t)digest[4 * k + 1] << 8)
+                      |  (apr_uint32_t)digest[4 * k];
+          point->server = server;
+        }
+    }
+
+  return TRUE;
+}
+
+/* Implements svn_config_enumerator2_t.  Just used for the
+   entry-counting return value of svn_config_enumerate2. */
+static svn_boolean_t
+nop_enumerator(const char *name,
+               const char *value,
+               void *baton,
+               apr_pool_t *pool)
+{
+  return TRUE;
+}
+
+svn_error_t *
+svn_cache__make_redis_from_config(svn_redis_t **redis_p,
+                                  svn_config_t *config,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool)
+{
+  struct ars_baton b;
+  svn_redis_t *redis;
+  int server_count =
+    svn_config_enumerate2(config,
+                          SVN_CACHE_CONFIG_CATEGORY_REDIS_SERVERS,
+                          nop_enumerator, NULL, scratch_pool);
+
+  if (server_count == 0)
+    {
+      *redis_p = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  redis = apr_pcalloc(result_pool, sizeof(*redis));
+  redis->servers = apr_pcalloc(result_pool,
+                               server_count * sizeof(*redis->servers));
+  redis->ring = apr_pcalloc(result_pool,
+                            server_count * POINTS_PER_SERVER
+                            * sizeof(*redis->ring));
+
+  b.redis = redis;
+  b.redis_pool = result_pool;
+  b.err = SVN_NO_ERROR;
+  svn_config_enumerate2(config,
+                        SVN_CACHE_CONFIG_CATEGORY_REDIS_SERVERS,
+                        add_redis_server, &b,
+                        scratch_pool);
+
+  /* Any server that has been added may own a connection. */
+  apr_pool_cleanup_register(result_pool, redis, close_connections,
+                            apr_pool_cleanup_null);
+  if (b.err)
+    return b.err;
+
+  qsort(redis->ring, redis->ring_size, sizeof(*redis->ring),
+        compare_ring_points);
+
+  *redis_p = redis;
+  return SVN_NO_ERROR;
+}
@@ -95,6 +95,64 @@ svn_cache__get(void **value_p,
   return err;
 }
 
+svn_error_t *
+svn_cache__get_many(void **values,
+                    svn_boolean_t *found,
+                    svn_cache__t *cache,
+                    const void * const *keys,
+                    int key_count,
+                    apr_pool_t *result_pool)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  /* In case any errors happen and are quelched, make sure we start
+     out with all FOUND set to false. */
+  for (i = 0; i < key_count; ++i)
+    {
+      found[i] = FALSE;
+      values[i] = NULL;
+    }
+
+#ifdef SVN_DEBUG
+  if (cache->pretend_empty)
+    return SVN_NO_ERROR;
+#endif
+
+  cache->reads += key_count;
+  if (cache->vtable->get_many)
+    {
+      err = (cache->vtable->get_many)(values,
+                                      found,
+                                      cache->cache_internal,
+                                      keys,
+                                      key_count,
+                                      result_pool);
+    }
+  else
+    {
+      for (i = 0; i < key_count && !err; ++i)
+        err = (cache->vtable->get)(&values[i],
+                                   &found[i],
+                                   cache->cache_internal,
+                                   keys[i],
+                                   result_pool);
+    }
+
+  /* Don't return partial results. */
+  if (err)
+    for (i = 0; i < key_count; ++i)
+      found[i] = FALSE;
+
+  err = handle_error(cache, err, result_pool);
+
+  for (i = 0; i < key_count; ++i)
+    if (found[i])
+      cache->hits++;
+
+  return err;
+}
+
 svn_error_t *
 svn_cache__has_key(svn_boolean_t *found,
                    svn_cache__t *cache,
@@ -257,7 +315,28 @@ svn_cache__format_info(const svn_cache__info_t *info,
   double data_entry_rate = (100.0 * (double)info->used_entries)
                  / (double)(info->total_entries ? info->total_entries : 1);
 
+  const char *remote = "";
+  const char *levels = "";
   const char *histogram = "";
+  if (info->remote_hits)
+    remote = apr_psprintf(result_pool,
+                          "remote  : %" APR_UINT64_T_FMT
+                          " hits (%5.2f%% of hits)\n",
+                          info->remote_hits,
+                          (100.0 * (double)info->remote_hits)
+                            / (double)(info->hits ? info->hits : 1));
+
+  if (info->l1_size)
+    levels = apr_psprintf(result_pool,
+                          "levels  : %" APR_UINT64_T_FMT " MB L1 (%5.2f%%),"
+                          " %" APR_UINT64_T_FMT " resizes,"
+                          " %" APR_UINT64_T_FMT " demoted prefixes\n",
+                          info->l1_size / _1MB,
+                          (100.0 * (double)info->l1_size)
+                            / (double)(info->data_size ? info->data_size : 1),
+                          info->l1_resizes,
+                          info->demoted_prefixes);
+
   if (!access_only)
     {
       svn_stringbuf_t *text = svn_stringbuf_create_empty(result_pool);
@@ -283,30 +362,32 @@ svn_cache__format_info(const svn_cache__info_t *info,
                             "gets    : %" APR_UINT64_T_FMT
                             ", %" APR_UINT64_T_FMT " hits (%5.2f%%)\n"
                             "sets    : %" APR_UINT64_T_FMT
-                            " (%5.2f%% of misses)\n",
+                            " (%5.2f%% of misses)\n%s",
                             info->id,
                             info->gets,
                             info->hits, hit_rate,
-                            info->sets, write_rate)
+                            info->sets, write_rate,
+                            remote)
        : svn_string_createf(result_pool,
 
                             "%s\n"
                             "gets    : %" APR_UINT64_T_FMT
                             ", %" APR_UINT64_T_FMT " hits (%5.2f%%)\n"
                             "sets    : %" APR_UINT64_T_FMT
-                            " (%5.2f%% of misses)\n"
+                            " (%5.2f%% of misses)\n%s"
                             "failures: %" APR_UINT64_T_FMT "\n"
                             "used    : %" APR_UINT64_T_FMT " MB (%5.2f%%)"
                             " of %" APR_UINT64_T_FMT " MB data cache"
                             " / %" APR_UINT64_T_FMT " MB total cache memory\n"
                             "          %" APR_UINT64_T_FMT " entries (%5.2f%%)"
-                            " of %" APR_UINT64_T_FMT " total\n%s",
+                            " of %" APR_UINT64_T_FMT " total\n%s%s",
 
                             info->id,
 
                             info->gets,
                             info->hits, hit_rate,
                             info->sets, write_rate,
+                            remote,
                             info->failures,
 
                             info->used_size / _1MB, data_usage_rate,
@@ -315,5 +396,70 @@ svn_cache__format_info(const svn_cache__info_t *info,
 
                             info->used_entries, data_entry_rate,
                             info->total_entries,
+                            levels,
                             histogram);
 }
+
+svn_string_t *
+svn_cache__format_prefix_stats(const apr_array_header_t *stats,
+                               apr_pool_t *result_pool)
+{
+  enum { _1MB = 1024 * 1024 };
+
+  svn_stringbuf_t *text = svn_stringbuf_create_empty(result_pool);
+  int i;
+
+  for (i = 0; i < stats->nelts; ++i)
+    {
+      const svn_cache__prefix_stats_t *entry
+        = APR_ARRAY_IDX(stats, i, const svn_cache__prefix_stats_t *);
+      double hit_rate = (100.0 * (double)entry->hits)
+                      / (double)(entry->gets ? entry->gets : 1);
+
+      svn_stringbuf_appendcstr(text,
+        apr_psprintf(result_pool,
+                     "%-16s: %" APR_UINT64_T_FMT " gets,"
+                     " %" APR_UINT64_T_FMT " hits (%5.2f%%),"
+                     " %" APR_UINT64_T_FMT " sets"
+                     " (%" APR_UINT64_T_FMT " MB),"
+                     " %" APR_UINT64_T_FMT " evictions,"
+                     " %" APR_UINT64_T_FMT " too large\n",
+                     entry->name, entry->gets, entry->hits, hit_rate,
+                     entry->sets, entry->bytes_inserted / _1MB,
+                     entry->evictions, entry->rejected));
+    }
+
+  return svn_string_create_from_buf(text, result_pool);
+}
+
+svn_string_t *
+svn_cache__format_quota_stats(const apr_array_header_t *stats,
+                              apr_pool_t *result_pool)
+{
+  enum { _1MB = 1024 * 1024 };
+
+  svn_stringbuf_t *text = svn_stringbuf_create_empty(result_pool);
+  int i;
+
+  for (i = 0; i < stats->nelts; ++i)
+    {
+      const svn_cache__quota_stats_t *entry
+        = APR_ARRAY_IDX(stats, i, const svn_cache__quota_stats_t *);
+
+      if (entry->quota)
+        svn_stringbuf_appendcstr(text,
+          apr_psprintf(result_pool,
+                       "%s: %" APR_UINT64_T_FMT " MB"
+                       " of %" APR_UINT64_T_FMT " MB quota,"
+                       " %" APR_UINT64_T_FMT " throttled\n",
+                       entry->name, entry->used / _1MB, entry->quota / _1MB,
+                       entry->throttled));
+      else
+        svn_stringbuf_appendcstr(text,
+          apr_psprintf(result_pool,
+                       "%s: %" APR_UINT64_T_FMT " MB, no quota\n",
+                       entry->name, entry->used / _1MB));
+    }
+
+  return svn_string_create_from_buf(text, result_pool);
+}
@@ -82,6 +82,15 @@ typedef struct svn_cache__vtable_t {
                            svn_cache__info_t *info,
                            svn_boolean_t reset,
                            apr_pool_t *result_pool);
+
+  /* See svn_cache__get_many().  Optional; may be NULL in which case
+     svn_cache__get_many() will call GET for every key. */
+  svn_error_t *(*get_many)(void **values,
+                           svn_boolean_t *found,
+                           void *cache_implementation,
+                           const void * const *keys,
+                           int key_count,
+                           apr_pool_t *result_pool);
 } svn_cache__vtable_t;
 
 struct svn_cache__t {
@@ -64,6 +64,24 @@ static svn_cache_config_t cache_settings =
 #endif
 };
 
+/* Number of NUMA partitions to use for the global membuffer cache. */
+static apr_size_t membuffer_partitions = 1;
+
+/* Whether to put the global membuffer cache into shared memory and, if
+ * so, the name of the shared memory segment (may be NULL). */
+static svn_boolean_t membuffer_shared = FALSE;
+static const char *membuffer_shm_file = NULL;
+
+/* Whether to enable the admission filter in the global membuffer cache. */
+static svn_boolean_t membuffer_admission_filter = FALSE;
+
+/* Snapshot file to load into the global membuffer cache upon creation
+ * and to save it to (may be NULL). */
+static const char *membuffer_snapshot_file = NULL;
+
+/* The global membuffer cache, once it has been created successfully. */
+static svn_membuffer_t *created_membuffer = NULL;
+
 /* Get the current FSFS cache configuration. */
 const svn_cache_config_t *
 svn_cache_config_get(void)
@@ -120,14 +138,25 @@ initialize_cache(void *baton, apr_pool_t *unused_pool)
         return SVN_NO_ERROR;
       apr_allocator_owner_set(allocator, pool);
 
-      err = svn_cache__membuffer_cache_create(
-          &cache,
-          (apr_size_t)cache_size,
-          (apr_size_t)(cache_size / 5),
-          0,
-          ! svn_cache_config_get()->single_threaded,
-          FALSE,
-          pool);
+      if (membuffer_shared)
+        err = svn_cache__membuffer_cache_create_shared(
+            &cache,
+            (apr_size_t)cache_size,
+            (apr_size_t)(cache_size / 5),
+            0,
+            FALSE,
+            membuffer_shm_file,
+            pool);
+      else
+        err = svn_cache__membuffer_cache_create(
+            &cache,
+            (apr_size_t)cache_size,
+            (apr_size_t)(cache_size / 5),
+            0,
+            membuffer_partitions,
+            ! svn_cache_config_get()->single_threaded,
+            FALSE,
+            pool);
 
       /* Some error occurred. Most likely it's an OOM error but we don't
        * really care. Simply release all cache memory and disable caching
@@ -143,8 +172,25 @@ initialize_cache(void *baton, apr_pool_t *unused_pool)
           return svn_error_trace(err);
         }
 
+      /* The filter is an optimization only. */
+      if (membuffer_admission_filter)
+        svn_error_clear(svn_cache__membuffer_enable_admission_filter(cache,
+                                                                     pool));
+
+      /* Warm start.  Caching is optional, so don't fail just because we
+       * couldn't read the snapshot. */
+      if (membuffer_snapshot_file)
+        {
+          apr_pool_t *scratch_pool = svn_pool_create(pool);
+          svn_error_clear(svn_cache__membuffer_load(cache,
+                                                    membuffer_snapshot_file,
+                                                    scratch_pool));
+          svn_pool_destroy(scratch_pool);
+        }
+
       /* done */
       *cache_p = cache;
+      created_membuffer = cache;
     }
 
   return SVN_NO_ERROR;
@@ -173,6 +219,43 @@ svn_cache__get_global_membuffer_cache(void)
   return cache;
 }
 
+void
+svn_cache__set_global_membuffer_partitions(apr_size_t partition_count)
+{
+  membuffer_partitions = partition_count;
+}
+
+void
+svn_cache__set_global_membuffer_shared(svn_boolean_t shared,
+                                       const char *shm_file)
+{
+  membuffer_shared = shared;
+  membuffer_shm_file = shm_file;
+}
+
+void
+svn_cache__set_global_membuffer_admission_filter(svn_boolean_t enable)
+{
+  membuffer_admission_filter = enable;
+}
+
+void
+svn_cache__set_global_membuffer_snapshot(const char *path)
+{
+  membuffer_snapshot_file = path;
+}
+
+svn_error_t *
+svn_cache__save_global_membuffer(apr_pool_t *scratch_pool)
+{
+  if (membuffer_snapshot_file == NULL || created_membuffer == NULL)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(svn_cache__membuffer_save(created_membuffer,
+                                                   membuffer_snapshot_file,
+                                                   scratch_pool));
+}
+
 void
 svn_cache_config_set(const svn_cache_config_t *settings)
 {
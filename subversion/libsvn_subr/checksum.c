@@ -630,6 +630,36 @@ svn_checksum_update(svn_checksum_ctx_t *ctx,
   return SVN_NO_ERROR;
 }
 
+/* Size of the blocks svn_checksum__update2() feeds to each context in
+   turn.  Small enough to stay in the CPU cache in between, and a
+   multiple of the MD5 and SHA1 block size. */
+#define UPDATE2_BLOCK_SIZE 0x4000
+
+svn_error_t *
+svn_checksum__update2(svn_checksum_ctx_t *ctx1,
+                      svn_checksum_ctx_t *ctx2,
+                      const void *data,
+                      apr_size_t len)
+{
+  const char *p = data;
+
+  if (!ctx2)
+    return svn_error_trace(svn_checksum_update(ctx1, data, len));
+
+  while (len > 0)
+    {
+      apr_size_t block = MIN(len, UPDATE2_BLOCK_SIZE);
+
+      SVN_ERR(svn_checksum_update(ctx1, p, block));
+      SVN_ERR(svn_checksum_update(ctx2, p, block));
+
+      p += block;
+      len -= block;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_checksum_final(svn_checksum_t **checksum,
                    const svn_checksum_ctx_t *ctx,
@@ -737,6 +767,11 @@ typedef struct stream_baton_t
   /* Write the final checksum here. May be NULL. */
   svn_checksum_t **checksum;
 
+  /* Build a second checksum over the same data in here, and write it to
+     *CHECKSUM2.  Both are NULL if only one checksum is wanted. */
+  svn_checksum_ctx_t *context2;
+  svn_checksum_t **checksum2;
+
   /* Copy the digest of the final checksum. May be NULL. */
   unsigned char *digest;
 
@@ -754,7 +789,7 @@ write_handler(void *baton,
 {
   stream_baton_t *b = baton;
 
-  SVN_ERR(svn_checksum_update(b->context, data, *len));
+  SVN_ERR(svn_checksum__update2(b->context, b->context2, data, *len));
   SVN_ERR(svn_stream_write(b->inner_stream, data, len));
 
   return SVN_NO_ERROR;
@@ -783,13 +818,37 @@ close_handler(void *baton)
       memcpy(b->digest, (*b->checksum)->digest, digest_size);
     }
 
+  if (b->context2)
+    SVN_ERR(svn_checksum_final(b->checksum2, b->context2, b->pool));
+
   /* Done here.  Now, close the underlying stream as well. */
   return svn_error_trace(svn_stream_close(b->inner_stream));
 }
 
-/* Common constructor function for svn_checksum__wrap_write_stream and
+/* Implement svn_stream_seek_fn_t.
+ * Only supports resetting the stream, restarting both checksums.
+ */
+static svn_error_t *
+seek_handler(void *baton,
+             const svn_stream_mark_t *mark)
+{
+  stream_baton_t *b = baton;
+
+  if (mark)
+    return svn_error_create(SVN_ERR_STREAM_SEEK_NOT_SUPPORTED, NULL, NULL);
+
+  SVN_ERR(svn_checksum_ctx_reset(b->context));
+  if (b->context2)
+    SVN_ERR(svn_checksum_ctx_reset(b->context2));
+
+  return svn_error_trace(svn_stream_reset(b->inner_stream));
+}
+
+/* Common constructor function for svn_checksum__wrap_write_stream,
+ * svn_checksum__wrap_write_stream2 and
  * svn_checksum__wrap_write_stream_fnv1a_32x4, taking the superset of their
- * respecting parameters.
+ * respecting parameters.  If CHECKSUM2 is not NULL, also calculate a
+ * checksum of KIND2 and write it there.
  *
  * In the current usage, either CHECKSUM or DIGEST will be NULL but this
  * function does not enforce any such restriction.  Also, the caller must
@@ -800,6 +859,8 @@ wrap_write_stream(svn_checksum_t **checksum,
                   unsigned char *digest,
                   svn_stream_t *inner_stream,
                   svn_checksum_kind_t kind,
+                  svn_checksum_t **checksum2,
+                  svn_checksum_kind_t kind2,
                   apr_pool_t *pool)
 {
   svn_stream_t *outer_stream;
@@ -811,6 +872,12 @@ wrap_write_stream(svn_checksum_t **checksum,
   baton->digest = digest;
   baton->pool = pool;
 
+  if (checksum2)
+    {
+      baton->context2 = svn_checksum_ctx_create(kind2, pool);
+      baton->checksum2 = checksum2;
+    }
+
   outer_stream = svn_stream_create(baton, pool);
   svn_stream_set_write(outer_stream, write_handler);
   svn_stream_set_close(outer_stream, close_handler);
@@ -824,7 +891,26 @@ svn_checksum__wrap_write_stream(svn_checksum_t **checksum,
                                 svn_checksum_kind_t kind,
                                 apr_pool_t *pool)
 {
-  return wrap_write_stream(checksum, NULL, inner_stream, kind, pool);
+  return wrap_write_stream(checksum, NULL, inner_stream, kind,
+                           NULL, kind, pool);
+}
+
+svn_stream_t *
+svn_checksum__wrap_write_stream2(svn_checksum_t **checksum1,
+                                 svn_checksum_kind_t kind1,
+                                 svn_checksum_t **checksum2,
+                                 svn_checksum_kind_t kind2,
+                                 svn_stream_t *inner_stream,
+                                 apr_pool_t *pool)
+{
+  svn_stream_t *outer_stream;
+
+  outer_stream = wrap_write_stream(checksum1, NULL, inner_stream, kind1,
+                                   checksum2, kind2, pool);
+  if (svn_stream_supports_reset(inner_stream))
+    svn_stream_set_seek(outer_stream, seek_handler);
+
+  return outer_stream;
 }
 
 /* Implement svn_close_fn_t.
@@ -849,6 +935,7 @@ svn_checksum__wrap_write_stream_fnv1a_32x4(apr_uint32_t *digest,
 {
   svn_stream_t *result
     = wrap_write_stream(NULL, (unsigned char *)digest, inner_stream,
+                        svn_checksum_fnv1a_32x4, NULL,
                         svn_checksum_fnv1a_32x4, pool);
   svn_stream_set_close(result, close_handler_fnv1a_32x4);
 
@@ -204,6 +204,42 @@ svn_config_parse(svn_config_t **cfgp, svn_stream_t *stream,
   return err;
 }
 
+static void
+for_each_option(svn_config_t *cfg, void *baton, apr_pool_t *pool,
+                svn_boolean_t callback(void *same_baton,
+                                       cfg_section_t *section,
+                                       cfg_option_t *option));
+
+static svn_boolean_t
+merge_callback(void *baton, cfg_section_t *section, cfg_option_t *option);
+
+/* Read the config FILE, using compiled snapshots in SNAPSHOT_DIR if that
+ * is not NULL.  If *RED_CONFIG is TRUE, merge the contents into *CFGP.
+ * Otherwise, allocate a new *CFGP in POOL and set *RED_CONFIG.
+ */
+static svn_error_t *
+read_file(svn_config_t **cfgp,
+          svn_boolean_t *red_config,
+          const char *file,
+          const char *snapshot_dir,
+          apr_pool_t *pool)
+{
+  svn_config_t *file_cfg;
+
+  SVN_ERR(svn_config_create2(&file_cfg, FALSE, FALSE, pool));
+  SVN_ERR(svn_config__parse_file_cached(file_cfg, file, snapshot_dir, pool));
+
+  if (*red_config)
+    for_each_option(file_cfg, *cfgp, pool, merge_callback);
+  else
+    {
+      *cfgp = file_cfg;
+      *red_config = TRUE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Read various configuration sources into *CFGP, in this order, with
  * later reads overriding the results of earlier ones:
  *
@@ -215,6 +251,9 @@ svn_config_parse(svn_config_t **cfgp, svn_stream_t *stream,
  *
  *    4. USR_FILE_PATH       (everywhere, but ignored if NULL)
  *
+ * Use compiled snapshots of the files in SNAPSHOT_DIR, if that is not
+ * NULL.
+ *
  * Allocate *CFGP in POOL.  Even if no configurations are read,
  * allocate an empty *CFGP.
  */
@@ -224,6 +263,7 @@ read_all(svn_config_t **cfgp,
          const char *usr_registry_path,
          const char *sys_file_path,
          const char *usr_file_path,
+         const char *snapshot_dir,
          apr_pool_t *pool)
 {
   svn_boolean_t red_config = FALSE;  /* "red" is the past tense of "read" */
@@ -240,16 +280,7 @@ read_all(svn_config_t **cfgp,
 #endif /* WIN32 */
 
   if (sys_file_path)
-    {
-      if (red_config)
-        SVN_ERR(svn_config_merge(*cfgp, sys_file_path, FALSE));
-      else
-        {
-          SVN_ERR(svn_config_read3(cfgp, sys_file_path,
-                                   FALSE, FALSE, FALSE, pool));
-          red_config = TRUE;
-        }
-    }
+    SVN_ERR(read_file(cfgp, &red_config, sys_file_path, snapshot_dir, pool));
 
   /*** ...followed by per-user configurations. ***/
 
@@ -268,16 +299,7 @@ read_all(svn_config_t **cfgp,
 #endif /* WIN32 */
 
   if (usr_file_path)
-    {
-      if (red_config)
-        SVN_ERR(svn_config_merge(*cfgp, usr_file_path, FALSE));
-      else
-        {
-          SVN_ERR(svn_config_read3(cfgp, usr_file_path,
-                                   FALSE, FALSE, FALSE, pool));
-          red_config = TRUE;
-        }
-    }
+    SVN_ERR(read_file(cfgp, &red_config, usr_file_path, snapshot_dir, pool));
 
   if (! red_config)
     SVN_ERR(svn_config_create2(cfgp, FALSE, FALSE, pool));
@@ -297,6 +319,7 @@ get_category_config(svn_config_t **cfg,
 {
   const char *usr_reg_path = NULL, *sys_reg_path = NULL;
   const char *usr_cfg_path, *sys_cfg_path;
+  const char *snapshot_dir;
   svn_error_t *err = NULL;
 
   *cfg = NULL;
@@ -324,8 +347,10 @@ get_category_config(svn_config_t **cfg,
 
   SVN_ERR(svn_config_get_user_config_path(&usr_cfg_path, config_dir, category,
                                           pool));
+  SVN_ERR(svn_config_get_user_config_path(&snapshot_dir, config_dir,
+                                          SVN_CONFIG__SNAPSHOT_SUBDIR, pool));
   return read_all(cfg, sys_reg_path, usr_reg_path,
-                  sys_cfg_path, usr_cfg_path, pool);
+                  sys_cfg_path, usr_cfg_path, snapshot_dir, pool);
 }
 
 
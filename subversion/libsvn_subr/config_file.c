@@ -32,12 +32,14 @@
 #include "svn_types.h"
 #include "svn_dirent_uri.h"
 #include "svn_auth.h"
+#include "svn_checksum.h"
 #include "svn_hash.h"
 #include "svn_subst.h"
 #include "svn_utf.h"
 #include "svn_pools.h"
 #include "svn_user.h"
 #include "svn_ctype.h"
+#include "svn_sorts.h"
 
 #include "private/svn_config_private.h"
 #include "private/svn_subr_private.h"
@@ -755,6 +757,181 @@ svn_config__parse_file(svn_config_t *cfg, const char *file,
   return err;
 }
 
+/* First line of compiled config snapshots.  Change it whenever the format
+   changes. */
+#define SNAPSHOT_FORMAT "svn-config-snapshot 1\n"
+
+/* Config files that changed less than this long ago are not compiled.
+   Their timestamps might not change with the next modification. */
+#define SNAPSHOT_MIN_AGE apr_time_from_sec(2)
+
+/* Baton for snapshot_add_value(). */
+typedef struct snapshot_baton_t
+{
+  /* The config to populate. */
+  svn_config_t *cfg;
+
+  /* The compiled snapshot being built.  It contains the section, option
+     and value of every option parsed, each terminated by a NUL. */
+  svn_stringbuf_t *snapshot;
+} snapshot_baton_t;
+
+/* Implements the add-value constructor callback.  Like
+   svn_config__default_add_value_fn() but also records the value in the
+   snapshot of BATON. */
+static svn_error_t *
+snapshot_add_value(void *baton,
+                   svn_stringbuf_t *section,
+                   svn_stringbuf_t *option,
+                   svn_stringbuf_t *value)
+{
+  snapshot_baton_t *b = baton;
+
+  svn_config_set(b->cfg, section->data, option->data, value->data);
+  svn_stringbuf_appendbytes(b->snapshot, section->data, section->len + 1);
+  svn_stringbuf_appendbytes(b->snapshot, option->data, option->len + 1);
+  svn_stringbuf_appendbytes(b->snapshot, value->data, value->len + 1);
+
+  return SVN_NO_ERROR;
+}
+
+/* Populate CFG from the compiled SNAPSHOT, starting at offset START.  Set
+   *VALID to FALSE and leave CFG untouched if SNAPSHOT is malformed. */
+static void
+read_snapshot(svn_boolean_t *valid,
+              svn_config_t *cfg,
+              const svn_stringbuf_t *snapshot,
+              apr_size_t start)
+{
+  const char *p = snapshot->data + start;
+  const char *end = snapshot->data + snapshot->len;
+  apr_size_t strings = 0;
+  const char *nul;
+
+  /* Every option needs 3 complete strings. */
+  for (nul = memchr(p, '\0', end - p);
+       nul;
+       nul = memchr(nul + 1, '\0', end - nul - 1))
+    strings++;
+
+  *valid = (strings % 3 == 0) && (p == end || end[-1] == '\0');
+  if (!*valid)
+    return;
+
+  while (p < end)
+    {
+      const char *section = p;
+      const char *option = section + strlen(section) + 1;
+      const char *value = option + strlen(option) + 1;
+
+      svn_config_set(cfg, section, option, value);
+      p = value + strlen(value) + 1;
+    }
+}
+
+svn_error_t *
+svn_config__parse_file_cached(svn_config_t *cfg,
+                              const char *file,
+                              const char *snapshot_dir,
+                              apr_pool_t *pool)
+{
+  apr_pool_t *scratch_pool;
+  apr_finfo_t finfo;
+  svn_checksum_t *checksum;
+  const char *snapshot_path;
+  const char *header;
+  svn_stringbuf_t *snapshot;
+  snapshot_baton_t baton;
+  svn_stream_t *stream;
+  svn_error_t *err;
+
+  if (!snapshot_dir)
+    return svn_error_trace(svn_config__parse_file(cfg, file, FALSE, pool));
+
+  /* Without timestamps, there is no way to tell whether a snapshot is
+     still valid. */
+  scratch_pool = svn_pool_create(pool);
+  err = svn_io_stat(&finfo, file,
+                    APR_FINFO_SIZE | APR_FINFO_MTIME | APR_FINFO_CTIME,
+                    scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      svn_pool_destroy(scratch_pool);
+      return svn_error_trace(svn_config__parse_file(cfg, file, FALSE, pool));
+    }
+
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_md5, file, strlen(file),
+                       scratch_pool));
+  snapshot_path = svn_dirent_join(snapshot_dir,
+                                  svn_checksum_to_cstring(checksum,
+                                                          scratch_pool),
+                                  scratch_pool);
+  header = apr_psprintf(scratch_pool,
+                        SNAPSHOT_FORMAT "%s\n%" APR_OFF_T_FMT
+                        " %" APR_TIME_T_FMT " %" APR_TIME_T_FMT "\n",
+                        file, finfo.size, finfo.mtime, finfo.ctime);
+
+  /* Use the snapshot if it was taken from the same file contents. */
+  err = svn_stringbuf_from_file2(&snapshot, snapshot_path, scratch_pool);
+  if (err)
+    svn_error_clear(err);
+  else if (   snapshot->len >= strlen(header)
+           && memcmp(snapshot->data, header, strlen(header)) == 0)
+    {
+      svn_boolean_t valid;
+
+      read_snapshot(&valid, cfg, snapshot, strlen(header));
+      if (valid)
+        {
+          svn_pool_destroy(scratch_pool);
+          return SVN_NO_ERROR;
+        }
+    }
+
+  /* Parse the file and compile a new snapshot on the way. */
+  err = svn_stream_open_readonly(&stream, file, scratch_pool, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      svn_pool_destroy(scratch_pool);
+      return SVN_NO_ERROR;
+    }
+  else
+    SVN_ERR(err);
+
+  baton.cfg = cfg;
+  baton.snapshot = svn_stringbuf_create(header, scratch_pool);
+  err = svn_config__parse_stream(stream,
+                                 svn_config__constructor_create(
+                                     NULL, NULL, snapshot_add_value,
+                                     scratch_pool),
+                                 &baton, scratch_pool);
+  if (err)
+    {
+      err = svn_error_createf(err->apr_err, err,
+                              _("Error while parsing config file: %s:"),
+                              svn_dirent_local_style(file, scratch_pool));
+      svn_pool_destroy(scratch_pool);
+      return err;
+    }
+
+  /* Failing to store the snapshot only means parsing again next time. */
+  if (apr_time_now() - MAX(finfo.mtime, finfo.ctime) > SNAPSHOT_MIN_AGE)
+    {
+      svn_error_clear(svn_io_make_dir_recursively(snapshot_dir,
+                                                  scratch_pool));
+      svn_error_clear(svn_io_write_atomic2(snapshot_path,
+                                           baton.snapshot->data,
+                                           baton.snapshot->len, NULL,
+                                           FALSE /* flush_to_disk */,
+                                           scratch_pool));
+    }
+
+  svn_pool_destroy(scratch_pool);
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_config__parse_stream(svn_stream_t *stream,
                          svn_config__constructor_t *constructor,
@@ -1152,9 +1329,20 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "###                              (yes/no/auto)."                    NL
         "###   http-max-connections       Maximum number of parallel server" NL
         "###                              connections to use for any given"  NL
-        "###                              HTTP operation."                   NL
+        "###                              HTTP operation.  If not set,"      NL
+        "###                              updates use more than the default" NL
+        "###                              on high-latency links."            NL
         "###   http-chunked-requests      Whether to use chunked transfer"   NL
         "###                              encoding for HTTP requests body."  NL
+        "###   http-commit-pipeline-depth Number of file PUT and PROPPATCH"  NL
+        "###                              requests a commit may keep in"     NL
+        "###                              flight.  Defaults to 0 (wait for"  NL
+        "###                              each file)."                       NL
+        "###   http-baseline-cache        Whether to keep the baseline URLs" NL
+        "###                              of servers that do not support"    NL
+        "###                              HTTPv2 in the user configuration"  NL
+        "###                              area across sessions.  Defaults"   NL
+        "###                              to no."                            NL
         "###   http-auth-types            List of HTTP authentication types."NL
         "###   ssl-authority-files        List of files, each of a trusted CA"
                                                                              NL
@@ -1169,6 +1357,9 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "###   http-bulk-updates          Whether to request bulk update"    NL
         "###                              responses or to fetch each file"   NL
         "###                              in an individual request. "        NL
+        "###   svn-idle-connections       Maximum number of authenticated"   NL
+        "###                              svn:// connections to keep open"   NL
+        "###                              for reuse by later sessions."      NL
         "###   store-passwords            Specifies whether passwords used"  NL
         "###                              to authenticate against a"         NL
         "###                              Subversion server may be cached"   NL
@@ -1511,6 +1702,44 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "### to show meaningful differences for binary file formats.  [New"  NL
         "### in 1.9]"                                                        NL
         "# diff-ignore-content-type = no"                                    NL
+        "### Set merge-threads to the number of threads that 'svn merge'"    NL
+        "### may use to merge the contents of text files concurrently.  The" NL
+        "### working copy is still updated by a single thread.  It defaults" NL
+        "### to 1.  [New in 1.15]"                                           NL
+        "# merge-threads = 4"                                                NL
+        "### Set commit-threads to the number of threads that 'svn commit'"  NL
+        "### may use to find modified files and to compute the deltas of"    NL
+        "### file contents ahead of time while earlier files are being"      NL
+        "### sent.  Files are still sent in order over a single connection." NL
+        "### It defaults to 1.  [New in 1.15]"                               NL
+        "# commit-threads = 4"                                               NL
+        "### Set blame-threads to the number of threads that 'svn blame'"    NL
+        "### may use to compare the revisions of the file concurrently."     NL
+        "### Revisions are still received and blamed in order.  It defaults" NL
+        "### to 1.  [New in 1.15]"                                           NL
+        "# blame-threads = 4"                                                NL
+        "### Set externals-threads to the number of directory externals"     NL
+        "### that 'svn checkout', 'svn update' and 'svn switch' may fetch"   NL
+        "### concurrently.  Notifications are still shown in order."         NL
+        "### Conflicts in externals fetched concurrently are always"         NL
+        "### postponed.  It defaults to 1.  [New in 1.15]"                   NL
+        "# externals-threads = 4"                                            NL
+        "### Set update-threads to the number of targets that 'svn update'"  NL
+        "### may update concurrently when given several.  All targets in"    NL
+        "### a repository are then updated to the same revision, and"        NL
+        "### conflicts are resolved once each target is done.  It defaults"  NL
+        "### to 1.  [New in 1.15]"                                           NL
+        "# update-threads = 4"                                               NL
+        "### Set export-threads to the number of threads that 'svn export'"  NL
+        "### may use to translate keywords and line endings and to put"      NL
+        "### files into place.  It defaults to 1.  [New in 1.15]"            NL
+        "# export-threads = 4"                                               NL
+        "### Set local-fulltext-limit to the size in kB up to which file"    NL
+        "### contents found in the memory cache are handed to the client"    NL
+        "### in one piece, instead of as a delta, when accessing a FSFS"     NL
+        "### repository via ra_local (the file:// scheme).  It defaults to"  NL
+        "### 0, which disables this.  [New in 1.15]"                         NL
+        "# local-fulltext-limit = 1024"                                      NL
         ""                                                                   NL
         "### Section for configuring automatic properties."                  NL
         "[auto-props]"                                                       NL
@@ -1552,6 +1781,56 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "### returning an error.  The default is 10000, i.e. 10 seconds."    NL
         "### Longer values may be useful when exclusive locking is enabled." NL
         "# busy-timeout = 10000"                                             NL
+        "### Set wal-journal to true to switch working copy databases to"    NL
+        "### SQLite's write-ahead log, so that status and other readers"     NL
+        "### don't wait for a running update, and to false to switch them"   NL
+        "### back.  A database keeps its mode until it is switched, which"   NL
+        "### needs a moment when no other client has it open.  Do not use"   NL
+        "### it on network file systems; exclusive-locking takes"            NL
+        "### precedence.  [New in 1.15]"                                     NL
+        "# wal-journal = false"                                              NL
+        "### Set install-threads to the number of threads that checkout,"    NL
+        "### update and other operations may use to install files from the"  NL
+        "### pristine store into the working copy concurrently.  The working"NL
+        "### copy database is still updated by a single thread.  It defaults"NL
+        "### to 1.  [New in 1.15]"                                           NL
+        "# install-threads = 4"                                              NL
+        "### Set status-threads to the number of threads that status and"    NL
+        "### other operations may use to compare the contents of files"      NL
+        "### whose timestamps have changed with their pristine texts.  The"  NL
+        "### files of one directory are compared concurrently and reported"  NL
+        "### in order.  It defaults to 1.  [New in 1.15]"                    NL
+        "# status-threads = 4"                                               NL
+        "### Set cleanup-threads to the number of threads that cleanup may"  NL
+        "### use to remove unreferenced pristine texts and unversioned or"   NL
+        "### ignored items, and that updates and switches may use to remove" NL
+        "### directory trees.  It defaults to 1.  [New in 1.15]"             NL
+        "# cleanup-threads = 4"                                              NL
+        "### Set fsmonitor to a command that reports which paths of a"       NL
+        "### working copy changed, to let status skip the others.  It is"    NL
+        "### run with the working copy root and the token it printed"        NL
+        "### last time (empty on the first run) as arguments.  It must"      NL
+        "### print a new token on the first line, followed by the changed"   NL
+        "### paths relative to the root, one per line; '/' means that"       NL
+        "### anything may have changed.  If it fails, status checks all"     NL
+        "### files as usual.  [New in 1.15]"                                 NL
+        "# fsmonitor = /usr/local/bin/svn-fsmonitor"                         NL
+        "### Set shared-pristine-dir to a directory in which working"        NL
+        "### copies share their pristine texts.  Each working copy hard"     NL
+        "### links the texts it needs, so identical texts are stored only"   NL
+        "### once and new checkouts need not download texts that are"        NL
+        "### already there.  The directory must be on the same file system"  NL
+        "### as the working copies.  'svn cleanup' removes texts that no"    NL
+        "### working copy uses anymore."                                     NL
+        "### [New in 1.15]"                                                  NL
+        "# shared-pristine-dir = /home/me/.subversion/pristine"              NL
+        "### Set node-cache-size to the number of nodes per working copy"    NL
+        "### whose information and properties long-running clients, such"    NL
+        "### as IDE integrations, keep in memory between requests.  The"     NL
+        "### cache is dropped whenever the working copy database changes,"   NL
+        "### also by another process.  It defaults to 0, which disables"     NL
+        "### it.  [New in 1.15]"                                             NL
+        "# node-cache-size = 10000"                                          NL
         ;
 
       err = svn_io_file_open(&f, path,
@@ -88,6 +88,16 @@ svn_error_t *svn_config__parse_file(svn_config_t *cfg,
                                     svn_boolean_t must_exist,
                                     apr_pool_t *pool);
 
+/* Like svn_config__parse_file() with MUST_EXIST set to FALSE.  If
+   SNAPSHOT_DIR is not NULL, take the sections and options from a
+   compiled snapshot in that directory if it matches the current size and
+   timestamps of FILE.  Otherwise, parse FILE and try to store such a
+   snapshot in SNAPSHOT_DIR for the next time. */
+svn_error_t *svn_config__parse_file_cached(svn_config_t *cfg,
+                                           const char *file,
+                                           const char *snapshot_dir,
+                                           apr_pool_t *pool);
+
 /* The name of the magic [DEFAULT] section. */
 #define SVN_CONFIG__DEFAULT_SECTION "DEFAULT"
 
@@ -145,6 +155,10 @@ svn_error_t *svn_config__parse_registry(svn_config_t *cfg,
 /* The name of the main authentication subdir in the config directory */
 #define SVN_CONFIG__AUTH_SUBDIR        "auth"
 
+/* The name of the subdir in the config directory that holds compiled
+   snapshots of config files */
+#define SVN_CONFIG__SNAPSHOT_SUBDIR    "compiled"
+
 /* Set *PATH_P to the path to config file FNAME in the system
    configuration area, allocated in POOL.  If FNAME is NULL, set
    *PATH_P to the directory name of the system config area, either
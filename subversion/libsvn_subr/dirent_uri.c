@@ -1677,7 +1677,13 @@ const char *
 svn_uri_canonicalize(const char *uri, apr_pool_t *pool)
 {
   const char *result;
-  svn_error_t *const err = canonicalize(&result, type_uri, uri, pool);
+  svn_error_t *err;
+
+  /* Most input is canonical already and only needs to be copied. */
+  if (svn_uri_is_canonical(uri, pool))
+    return apr_pstrdup(pool, uri);
+
+  err = canonicalize(&result, type_uri, uri, pool);
   if (err)
     {
       svn_error_clear(err);
@@ -1714,7 +1720,13 @@ const char *
 svn_relpath_canonicalize(const char *relpath, apr_pool_t *pool)
 {
   const char *result;
-  svn_error_t *const err = canonicalize(&result, type_relpath, relpath, pool);
+  svn_error_t *err;
+
+  /* Most input is canonical already and only needs to be copied. */
+  if (relpath_is_canonical(relpath))
+    return apr_pstrdup(pool, relpath);
+
+  err = canonicalize(&result, type_relpath, relpath, pool);
   if (err)
     {
       svn_error_clear(err);
@@ -1782,7 +1794,16 @@ const char *
 svn_dirent_canonicalize(const char *dirent, apr_pool_t *pool)
 {
   const char *result;
-  svn_error_t *const err = canonicalize_dirent(&result, dirent, pool);
+  svn_error_t *err;
+
+  /* Most input is canonical already and only needs to be copied.  Paths
+     starting with "//" are never canonical on most platforms, and their
+     check would canonicalize them on Windows. */
+  if (   !(dirent[0] == '/' && dirent[1] == '/')
+      && svn_dirent_is_canonical(dirent, pool))
+    return apr_pstrdup(pool, dirent);
+
+  err = canonicalize_dirent(&result, dirent, pool);
   if (err)
     {
       svn_error_clear(err);
@@ -1855,9 +1876,8 @@ svn_dirent_is_canonical(const char *dirent, apr_pool_t *scratch_pool)
 static svn_boolean_t
 relpath_is_canonical(const char *relpath)
 {
-  const char *dot_pos, *ptr = relpath;
-  apr_size_t i, len;
-  unsigned pattern = 0;
+  const char *dot_pos, *slash_pos, *ptr = relpath;
+  apr_size_t len;
 
   /* RELPATH is canonical if it has:
    *  - no '.' segments
@@ -1891,13 +1911,13 @@ relpath_is_canonical(const char *relpath)
     if (dot_pos > ptr && dot_pos[-1] == '/' && dot_pos[1] == '/')
       return FALSE;
 
-  /* Now validate the rest of the path. */
-  for (i = 0; i < len - 1; ++i)
-    {
-      pattern = ((pattern & 0xff) << 8) + (unsigned char)ptr[i];
-      if (pattern == 0x101 * (unsigned char)('/'))
-        return FALSE;
-    }
+  /* Now validate the rest of the path.  Jumping from separator to
+   * separator lets memchr() skip over the segment names in bulk. */
+  for (slash_pos = memchr(ptr, '/', len);
+       slash_pos;
+       slash_pos = memchr(slash_pos + 1, '/', ptr + len - slash_pos - 1))
+    if (slash_pos[1] == '/')
+      return FALSE;
 
   return TRUE;
 }
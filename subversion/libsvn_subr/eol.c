@@ -70,6 +70,46 @@ svn_eol__find_eol_start(char *buf, apr_size_t len)
   return NULL;
 }
 
+char *
+svn_eol__find_keyword_start(char *buf, apr_size_t len, svn_boolean_t eol)
+{
+#if SVN_UNALIGNED_ACCESS_IS_OK
+
+  /* Scan the input one machine word at a time, just like
+   * svn_eol__find_eol_start() does. */
+  for (; len > sizeof(apr_uintptr_t)
+       ; buf += sizeof(apr_uintptr_t), len -= sizeof(apr_uintptr_t))
+    {
+      apr_uintptr_t chunk = *(const apr_uintptr_t *)buf;
+      apr_uintptr_t d_test = chunk ^ SVN__DOLLAR_MASK;
+
+      d_test |= (d_test & SVN__LOWER_7BITS_SET) + SVN__LOWER_7BITS_SET;
+      if (eol)
+        {
+          apr_uintptr_t r_test = chunk ^ SVN__R_MASK;
+          apr_uintptr_t n_test = chunk ^ SVN__N_MASK;
+
+          r_test |= (r_test & SVN__LOWER_7BITS_SET) + SVN__LOWER_7BITS_SET;
+          n_test |= (n_test & SVN__LOWER_7BITS_SET) + SVN__LOWER_7BITS_SET;
+          d_test &= r_test & n_test;
+        }
+
+      if ((d_test & SVN__BIT_7_SET) != SVN__BIT_7_SET)
+        break;
+    }
+
+#endif
+
+  /* The remaining odd bytes will be examined the naive way: */
+  for (; len > 0; ++buf, --len)
+    {
+      if (*buf == '$' || (eol && (*buf == '\n' || *buf == '\r')))
+        return buf;
+    }
+
+  return NULL;
+}
+
 const char *
 svn_eol__detect_eol(char *buf, apr_size_t len, char **eolp)
 {
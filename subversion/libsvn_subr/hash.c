@@ -24,6 +24,7 @@
 
 
 #include <stdlib.h>
+#include <string.h>
 #include <limits.h>
 
 #include <apr_version.h>
@@ -45,6 +46,7 @@
 
 #include "private/svn_dep_compat.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_string_private.h"
 #include "private/svn_subr_private.h"
 
 #include "svn_private_config.h"
@@ -214,6 +216,152 @@ svn_hash__read_entry(svn_hash__entry_t *entry,
   return SVN_NO_ERROR;
 }
 
+/* Parse the length in the line of the serialized hash starting at LINE and
+   ending at EOL into *LENGTH.  The line must start with TAG and a space.
+   Set *MATCHED to whether it does; only then EOL gets overwritten and
+   *LENGTH set.  Use ERROR_MESSAGE for invalid lengths. */
+static svn_error_t *
+parse_length(apr_size_t *length,
+             svn_boolean_t *matched,
+             char tag,
+             char *line,
+             char *eol,
+             const char *error_message)
+{
+  apr_uint64_t ui64;
+  svn_error_t *err;
+
+  *matched = (eol - line >= 3 && line[0] == tag && line[1] == ' ');
+  if (!*matched)
+    return SVN_NO_ERROR;
+
+  *eol = '\0';
+  err = svn_cstring_strtoui64(&ui64, line + 2, 0, APR_SIZE_MAX, 10);
+  if (err)
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, err, error_message);
+
+  *length = (apr_size_t)ui64;
+  return SVN_NO_ERROR;
+}
+
+/* Set *DATA and *LEN to the LENGTH bytes starting at *P, which must be
+   followed by a newline before END.  Replace that newline by a 0 and
+   advance *P behind it.  Use ERROR_MESSAGE if the data is incomplete. */
+static svn_error_t *
+parse_data(char **data,
+           apr_size_t *len,
+           char **p,
+           char *end,
+           apr_size_t length,
+           const char *error_message)
+{
+  if (length >= (apr_size_t)(end - *p) || (*p)[length] != '\n')
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, error_message);
+
+  *data = *p;
+  *len = length;
+  (*p)[length] = '\0';
+  *p += length + 1;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_hash__parse_entry(svn_hash__entry_t *entry,
+                      char **data,
+                      char *end,
+                      const char *terminator,
+                      svn_boolean_t incremental)
+{
+  char *p = *data;
+  char *eol;
+  apr_size_t length;
+  svn_boolean_t matched;
+
+  entry->key = NULL;
+  entry->keylen = 0;
+  entry->val = NULL;
+  entry->vallen = 0;
+
+  /* Without a terminator, the hash ends with the data. */
+  if (!terminator && p == end)
+    return SVN_NO_ERROR;
+
+  eol = memchr(p, '\n', end - p);
+  if (eol == NULL)
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                            _("Serialized hash missing terminator"));
+
+  /* Check for the end of the hash. */
+  if (terminator
+      && strlen(terminator) == (apr_size_t)(eol - p)
+      && memcmp(p, terminator, eol - p) == 0)
+    {
+      *data = eol + 1;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(parse_length(&length, &matched, 'K', p, eol,
+                       _("Serialized hash malformed key length")));
+  if (!matched && incremental)
+    SVN_ERR(parse_length(&length, &matched, 'D', p, eol,
+                         _("Serialized hash malformed key length")));
+  if (!matched)
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                            _("Serialized hash malformed"));
+
+  /* The tag survives the parsing of the length. */
+  p = eol + 1;
+  SVN_ERR(parse_data(&entry->key, &entry->keylen, &p, end, length,
+                     _("Serialized hash malformed key data")));
+
+  if (**data == 'K')
+    {
+      eol = p < end ? memchr(p, '\n', end - p) : NULL;
+      if (eol == NULL)
+        return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                                _("Serialized hash malformed"));
+
+      SVN_ERR(parse_length(&length, &matched, 'V', p, eol,
+                           _("Serialized hash malformed value length")));
+      if (!matched)
+        return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                                _("Serialized hash malformed"));
+
+      p = eol + 1;
+      SVN_ERR(parse_data(&entry->val, &entry->vallen, &p, end, length,
+                         _("Serialized hash malformed value data")));
+    }
+
+  *data = p;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_hash__read_buffer(apr_hash_t *hash,
+                      svn_stringbuf_t *text,
+                      const char *terminator,
+                      apr_pool_t *pool)
+{
+  char *p = text->data;
+  char *end = text->data + text->len;
+
+  while (1)
+    {
+      svn_hash__entry_t entry;
+
+      SVN_ERR(svn_hash__parse_entry(&entry, &p, end, terminator, FALSE));
+      if (entry.key == NULL)
+        break;
+
+      apr_hash_set(hash, apr_pstrmemdup(pool, entry.key, entry.keylen),
+                   entry.keylen,
+                   svn_string_ncreate(entry.val, entry.vallen, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 hash_read(apr_hash_t *hash, svn_stream_t *stream, const char *terminator,
           svn_boolean_t incremental, apr_pool_t *pool)
@@ -251,6 +399,31 @@ hash_read(apr_hash_t *hash, svn_stream_t *stream, const char *terminator,
 }
 
 
+/* Append to BUF the line with TAG and the LENGTH of the following
+   DATA, followed by DATA and a newline. */
+static void
+append_entry_part(svn_stringbuf_t *buf,
+                  char tag,
+                  const void *data,
+                  apr_size_t length)
+{
+  char *p;
+
+  svn_stringbuf_ensure(buf, buf->len + 2 + SVN_INT64_BUFFER_SIZE + length + 2);
+  p = buf->data + buf->len;
+
+  *p++ = tag;
+  *p++ = ' ';
+  p += svn__ui64toa(p, length);
+  *p++ = '\n';
+  memcpy(p, data, length);
+  p += length;
+  *p++ = '\n';
+
+  buf->len = p - buf->data;
+  *p = '\0';
+}
+
 /* Implements svn_hash_write2 and svn_hash_write_incremental. */
 static svn_error_t *
 hash_write(apr_hash_t *hash, apr_hash_t *oldhash, svn_stream_t *stream,
@@ -259,17 +432,32 @@ hash_write(apr_hash_t *hash, apr_hash_t *oldhash, svn_stream_t *stream,
   apr_pool_t *subpool;
   apr_size_t len;
   apr_array_header_t *list;
+  svn_stringbuf_t *buf;
   int i;
 
   subpool = svn_pool_create(pool);
 
-  list = svn_sort__hash(hash, svn_sort_compare_items_lexically, pool);
+  /* Size the output buffer for the whole dump up front, so it can be
+     written with a single call. */
+  list = svn_sort__hash(hash, svn_sort_compare_items_lexically, subpool);
+  len = terminator ? strlen(terminator) + 1 : 0;
   for (i = 0; i < list->nelts; i++)
     {
       svn_sort__item_t *item = &APR_ARRAY_IDX(list, i, svn_sort__item_t);
-      svn_string_t *valstr = item->value;
+      const svn_string_t *valstr = item->value;
 
-      svn_pool_clear(subpool);
+      if (item->klen < 0)
+        return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                                _("Cannot serialize negative length"));
+
+      len += 2 * (2 + SVN_INT64_BUFFER_SIZE + 2) + item->klen + valstr->len;
+    }
+
+  buf = svn_stringbuf_create_ensure(len, subpool);
+  for (i = 0; i < list->nelts; i++)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(list, i, svn_sort__item_t);
+      svn_string_t *valstr = item->value;
 
       /* Don't output entries equal to the ones in oldhash, if present. */
       if (oldhash)
@@ -280,43 +468,33 @@ hash_write(apr_hash_t *hash, apr_hash_t *oldhash, svn_stream_t *stream,
             continue;
         }
 
-      if (item->klen < 0)
-        return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
-                                _("Cannot serialize negative length"));
-
-      /* Write it out. */
-      SVN_ERR(svn_stream_printf(stream, subpool,
-                                "K %" APR_SIZE_T_FMT "\n%s\n"
-                                "V %" APR_SIZE_T_FMT "\n",
-                                (apr_size_t) item->klen,
-                                (const char *) item->key,
-                                valstr->len));
-      len = valstr->len;
-      SVN_ERR(svn_stream_write(stream, valstr->data, &len));
-      SVN_ERR(svn_stream_puts(stream, "\n"));
+      append_entry_part(buf, 'K', item->key, item->klen);
+      append_entry_part(buf, 'V', valstr->data, valstr->len);
     }
 
   if (oldhash)
     {
       /* Output a deletion entry for each property in oldhash but not hash. */
       list = svn_sort__hash(oldhash, svn_sort_compare_items_lexically,
-                            pool);
+                            subpool);
       for (i = 0; i < list->nelts; i++)
         {
           svn_sort__item_t *item = &APR_ARRAY_IDX(list, i, svn_sort__item_t);
 
-          svn_pool_clear(subpool);
-
           /* If it's not present in the new hash, write out a D entry. */
           if (! apr_hash_get(hash, item->key, item->klen))
-            SVN_ERR(svn_stream_printf(stream, subpool,
-                                      "D %" APR_SSIZE_T_FMT "\n%s\n",
-                                      item->klen, (const char *) item->key));
+            append_entry_part(buf, 'D', item->key, item->klen);
         }
     }
 
   if (terminator)
-    SVN_ERR(svn_stream_printf(stream, subpool, "%s\n", terminator));
+    {
+      svn_stringbuf_appendcstr(buf, terminator);
+      svn_stringbuf_appendbyte(buf, '\n');
+    }
+
+  len = buf->len;
+  SVN_ERR(svn_stream_write(stream, buf->data, &len));
 
   svn_pool_destroy(subpool);
   return SVN_NO_ERROR;
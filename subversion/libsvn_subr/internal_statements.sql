@@ -42,6 +42,9 @@ COMMIT TRANSACTION
 -- STMT_INTERNAL_ROLLBACK_TRANSACTION
 ROLLBACK TRANSACTION
 
+-- STMT_INTERNAL_DATA_VERSION
+PRAGMA data_version
+
 /* Dummmy statement to determine the number of internal statements */
 -- STMT_INTERNAL_LAST
 ;
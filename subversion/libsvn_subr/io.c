@@ -29,6 +29,15 @@
 #include <unistd.h>
 #endif
 
+#ifdef HAVE_COPY_FILE_RANGE
+#include <errno.h>
+#endif
+
+#if defined(HAVE_SYS_IOCTL_H) && defined(HAVE_LINUX_FS_H)
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
 #ifndef APR_STATUS_IS_EPERM
 #include <errno.h>
 #ifdef EPERM
@@ -66,6 +75,7 @@
 
 #include "private/svn_atomic.h"
 #include "private/svn_io_private.h"
+#include "private/svn_task.h"
 #include "private/svn_utf_private.h"
 #include "private/svn_dep_compat.h"
 
@@ -885,6 +895,37 @@ copy_contents(apr_file_t *from_file,
               apr_file_t *to_file,
               apr_pool_t *pool)
 {
+#ifdef HAVE_COPY_FILE_RANGE
+  /* Let the kernel copy the data without passing it through user space.
+   * Some file systems will even share the data blocks between both files.
+   * Fall back to the explicit copy if not supported for these files. */
+  apr_os_file_t from_fd, to_fd;
+  if (   apr_os_file_get(&from_fd, from_file) == APR_SUCCESS
+      && apr_os_file_get(&to_fd, to_file) == APR_SUCCESS)
+    {
+      apr_off_t total = 0;
+      ssize_t copied;
+
+      do
+        {
+          copied = copy_file_range(from_fd, NULL, to_fd, NULL,
+                                   0x40000000, 0);
+          if (copied > 0)
+            total += copied;
+        }
+      while (copied > 0 || (copied < 0 && errno == EINTR));
+
+      if (copied == 0)
+        return APR_SUCCESS;
+
+      /* Once we wrote data, we can't fall back anymore. */
+      if (   total > 0
+          || (   errno != EXDEV && errno != ENOSYS && errno != EINVAL
+              && errno != EOPNOTSUPP && errno != EBADF))
+        return APR_FROM_OS_ERROR(errno);
+    }
+#endif
+
   /* Copy bytes till the cows come home. */
   while (1)
     {
@@ -916,6 +957,107 @@ copy_contents(apr_file_t *from_file,
   /* NOTREACHED */
 }
 
+/* Like copy_contents(), but FROM_FILE must be at its start and TO_FILE
+ * must be empty.  On copy-on-write file systems, the files will share
+ * their data blocks instead of copying them, if possible.
+ */
+static apr_status_t
+clone_contents(apr_file_t *from_file,
+               apr_file_t *to_file,
+               apr_pool_t *pool)
+{
+#ifdef FICLONE
+  apr_os_file_t from_fd, to_fd;
+  if (   apr_os_file_get(&from_fd, from_file) == APR_SUCCESS
+      && apr_os_file_get(&to_fd, to_file) == APR_SUCCESS
+      && ioctl(to_fd, FICLONE, from_fd) == 0)
+    return APR_SUCCESS;
+#endif
+
+  return copy_contents(from_file, to_file, pool);
+}
+
+svn_error_t *
+svn_io__file_clone(apr_file_t *from_file,
+                   apr_file_t *to_file,
+                   apr_pool_t *scratch_pool)
+{
+  apr_status_t apr_err = clone_contents(from_file, to_file, scratch_pool);
+
+  if (apr_err)
+    {
+      const char *from_name;
+
+      SVN_ERR(svn_io_file_name_get(&from_name, from_file, scratch_pool));
+      return svn_error_wrap_apr(apr_err, _("Can't copy '%s'"),
+                                svn_dirent_local_style(from_name,
+                                                       scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_io__file_splice(svn_boolean_t *copied,
+                    apr_file_t *from_file,
+                    apr_file_t *to_file,
+                    apr_pool_t *scratch_pool)
+{
+#ifdef HAVE_COPY_FILE_RANGE
+  apr_os_file_t from_fd, to_fd;
+  apr_off_t from_offset, to_offset;
+  apr_off_t total = 0;
+  ssize_t result;
+  int error;
+
+  *copied = FALSE;
+  if (   apr_os_file_get(&from_fd, from_file) != APR_SUCCESS
+      || apr_os_file_get(&to_fd, to_file) != APR_SUCCESS)
+    return SVN_NO_ERROR;
+
+  /* The descriptors of buffered files may be positioned elsewhere.
+   * So, copy between explicit offsets and update the files afterwards. */
+  SVN_ERR(svn_io_file_flush(to_file, scratch_pool));
+  SVN_ERR(svn_io_file_get_offset(&from_offset, from_file, scratch_pool));
+  SVN_ERR(svn_io_file_get_offset(&to_offset, to_file, scratch_pool));
+
+  do
+    {
+      result = copy_file_range(from_fd, &from_offset, to_fd, &to_offset,
+                               0x40000000, 0);
+      error = errno;
+      if (result > 0)
+        total += result;
+    }
+  while (result > 0 || (result < 0 && error == EINTR));
+
+  if (result < 0)
+    {
+      const char *from_name;
+
+      /* Once we wrote data, we can't fall back anymore. */
+      if (   total == 0
+          && (   error == EXDEV || error == ENOSYS || error == EINVAL
+              || error == EOPNOTSUPP || error == EBADF))
+        return SVN_NO_ERROR;
+
+      SVN_ERR(svn_io_file_name_get(&from_name, from_file, scratch_pool));
+      return svn_error_wrap_apr(APR_FROM_OS_ERROR(error),
+                                _("Can't copy '%s'"),
+                                svn_dirent_local_style(from_name,
+                                                       scratch_pool));
+    }
+
+  SVN_ERR(svn_io_file_seek(from_file, APR_SET, &from_offset, scratch_pool));
+  SVN_ERR(svn_io_file_seek(to_file, APR_SET, &to_offset, scratch_pool));
+  *copied = TRUE;
+#else
+  *copied = FALSE;
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 
 svn_error_t *
 svn_io_copy_file(const char *src,
@@ -956,7 +1098,7 @@ svn_io_copy_file(const char *src,
                                    svn_dirent_dirname(dst, pool),
                                    svn_io_file_del_none, pool, pool));
 
-  apr_err = copy_contents(from_file, to_file, pool);
+  apr_err = clone_contents(from_file, to_file, pool);
 
   if (apr_err)
     {
@@ -1360,11 +1502,85 @@ svn_io_set_file_affected_time(apr_time_t apr_time,
 }
 
 
+/* How long to sleep on file systems with sub-second timestamps. */
+#ifndef SVN_HI_RES_SLEEP_MS
+#define SVN_HI_RES_SLEEP_MS 10
+#endif
+
+/* Number of directory entries whose timestamps has_hi_res_timestamps()
+   checks if the first one is on an exact second. */
+#define HI_RES_SAMPLE_COUNT 16
+
+/* Return TRUE if the file system containing PATH, an existing file or
+   directory, is known to have sub-second timestamp resolution.  Use POOL
+   for temporary allocations. */
+static svn_boolean_t
+has_hi_res_timestamps(const char *path,
+                      apr_pool_t *pool)
+{
+  apr_finfo_t finfo;
+  apr_dir_t *dir;
+  apr_status_t status;
+  svn_error_t *err;
+  svn_boolean_t found = FALSE;
+  int i;
+
+  err = svn_io_stat(&finfo, path,
+                    APR_FINFO_TYPE | APR_FINFO_MTIME | APR_FINFO_LINK, pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return FALSE;
+    }
+
+  /* Very simplistic but safe approach:
+      If the filesystem has < sec mtime we can be reasonably sure
+      that the filesystem has some sub-second resolution.  On Windows
+      it is likely to be sub-millisecond; on Linux systems it depends
+      on the filesystem, ext4 is typically 1ms, 4ms or 10ms resolution.
+
+     Note for further research on algorithm:
+       FAT32 has < 1 sec precision on ctime, but 2 sec on mtime.
+
+       Linux/ext4 with CONFIG_HZ=250 has high resolution
+       apr_time_now and although the filesystem timestamps
+       have similar high precision they are only updated with
+       a coarser 4ms resolution. */
+  if (finfo.mtime % APR_USEC_PER_SEC)
+    return TRUE;
+
+  /* A single timestamp on an exact second happens once in a thousand
+     times on a millisecond precision filesystem.  Don't sleep for a
+     second because of that but look at some more in the same
+     directory. */
+  if (finfo.filetype != APR_DIR)
+    path = svn_dirent_dirname(path, pool);
+
+  err = svn_io_dir_open(&dir, path, pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return FALSE;
+    }
+
+  for (i = 0; i < HI_RES_SAMPLE_COUNT && !found; i++)
+    {
+      status = apr_dir_read(&finfo, APR_FINFO_MTIME | APR_FINFO_LINK, dir);
+      if (status && status != APR_INCOMPLETE)
+        break;
+
+      found = ((finfo.valid & APR_FINFO_MTIME)
+               && (finfo.mtime % APR_USEC_PER_SEC));
+    }
+
+  svn_error_clear(svn_io_dir_close(dir));
+  return found;
+}
+
 void
 svn_io_sleep_for_timestamps(const char *path, apr_pool_t *pool)
 {
   apr_time_t now, then;
-  svn_error_t *err;
   char *sleep_env_var;
 
   sleep_env_var = getenv(SVN_SLEEP_ENV_VAR);
@@ -1381,43 +1597,9 @@ svn_io_sleep_for_timestamps(const char *path, apr_pool_t *pool)
      if we can sleep shorter than that */
   if (path)
     {
-      apr_finfo_t finfo;
-
-      err = svn_io_stat(&finfo, path, APR_FINFO_MTIME | APR_FINFO_LINK, pool);
-
-      if (err)
-        {
-          svn_error_clear(err); /* Fall back on original behavior */
-        }
-      else if (finfo.mtime % APR_USEC_PER_SEC)
-        {
-          /* Very simplistic but safe approach:
-              If the filesystem has < sec mtime we can be reasonably sure
-              that the filesystem has some sub-second resolution.  On Windows
-              it is likely to be sub-millisecond; on Linux systems it depends
-              on the filesystem, ext4 is typically 1ms, 4ms or 10ms resolution.
-
-             ## Perhaps find a better algorithm here. This will fail once
-                in every 1000 cases on a millisecond precision filesystem
-                if the mtime happens to be an exact second.
-
-                But better to fail once in every thousand cases than every
-                time, like we did before.
-
-             Note for further research on algorithm:
-               FAT32 has < 1 sec precision on ctime, but 2 sec on mtime.
-
-               Linux/ext4 with CONFIG_HZ=250 has high resolution
-               apr_time_now and although the filesystem timestamps
-               have similar high precision they are only updated with
-               a coarser 4ms resolution. */
-
-          /* 10 milliseconds after now. */
-#ifndef SVN_HI_RES_SLEEP_MS
-#define SVN_HI_RES_SLEEP_MS 10
-#endif
-          then = now + apr_time_from_msec(SVN_HI_RES_SLEEP_MS);
-        }
+      /* 10 milliseconds after now. */
+      if (has_hi_res_timestamps(path, pool))
+        then = now + apr_time_from_msec(SVN_HI_RES_SLEEP_MS);
 
       /* Remove time taken to do stat() from sleep. */
       now = apr_time_now();
@@ -2698,6 +2880,47 @@ svn_io__file_lock_autocreate(const char *lock_file,
 
 
 
+svn_error_t *
+svn_io__file_prefetch(apr_file_t *file,
+                      apr_off_t offset,
+                      apr_off_t length,
+                      apr_pool_t *scratch_pool)
+{
+#ifdef HAVE_POSIX_FADVISE
+  apr_os_file_t filehand;
+
+  if (offset < 0 || length <= 0)
+    return SVN_NO_ERROR;
+
+  /* This is only a hint; the data will be read later in any case. */
+  apr_os_file_get(&filehand, file);
+  (void)posix_fadvise(filehand, offset, length, POSIX_FADV_WILLNEED);
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_io__file_link(const char *from_path,
+                  const char *to_path,
+                  apr_pool_t *scratch_pool)
+{
+  apr_status_t status;
+  const char *from_path_apr, *to_path_apr;
+
+  SVN_ERR(cstring_from_utf8(&from_path_apr, from_path, scratch_pool));
+  SVN_ERR(cstring_from_utf8(&to_path_apr, to_path, scratch_pool));
+
+  status = apr_file_link(from_path_apr, to_path_apr);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't link '%s' to '%s'"),
+                              svn_dirent_local_style(to_path, scratch_pool),
+                              svn_dirent_local_style(from_path,
+                                                     scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Data consistency/coherency operations. */
 
 svn_error_t *svn_io_file_flush_to_disk(apr_file_t *file,
@@ -3041,6 +3264,165 @@ svn_io_remove_dir2(const char *path, svn_boolean_t ignore_enoent,
   return svn_io_dir_remove_nonrecursive(path, pool);
 }
 
+/* Remove the files in directory PATH and add its subdirectories to
+   SUBDIRS, allocated in RESULT_POOL.  Behave like svn_io_remove_dir2()
+   for IGNORE_ENOENT, CANCEL_FUNC and CANCEL_BATON.  Set *FOUND to FALSE
+   if PATH did not exist and IGNORE_ENOENT was set, else to TRUE. */
+static svn_error_t *
+remove_dir_files(svn_boolean_t *found,
+                 apr_array_header_t *subdirs,
+                 const char *path,
+                 svn_boolean_t ignore_enoent,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+  apr_pool_t *iterpool;
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+
+  *found = FALSE;
+  if (cancel_func)
+    SVN_ERR(cancel_func(cancel_baton));
+
+  err = svn_io_get_dirents3(&dirents, path, TRUE, scratch_pool,
+                            scratch_pool);
+  if (err)
+    {
+      if (ignore_enoent && (APR_STATUS_IS_ENOENT(err->apr_err)
+                            || SVN__APR_STATUS_IS_ENOTDIR(err->apr_err)))
+        {
+          svn_error_clear(err);
+          return SVN_NO_ERROR;
+        }
+      return svn_error_trace(err);
+    }
+
+  *found = TRUE;
+#if !defined(WIN32) && !defined(__OS2__)
+  SVN_ERR(io_set_dir_perms(path, TRUE, TRUE, FALSE, FALSE,
+                           ignore_enoent, scratch_pool));
+#endif
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (hi = apr_hash_first(scratch_pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const svn_io_dirent2_t *dirent = apr_hash_this_val(hi);
+      const char *fullpath;
+
+      if (dirent->kind == svn_node_dir)
+        {
+          APR_ARRAY_PUSH(subdirs, const char *)
+            = svn_dirent_join(path, name, result_pool);
+          continue;
+        }
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      fullpath = svn_dirent_join(path, name, iterpool);
+      err = svn_io_remove_file2(fullpath, FALSE, iterpool);
+      if (err)
+        return svn_error_createf
+          (err->apr_err, err, _("Can't remove '%s'"),
+           svn_dirent_local_style(fullpath, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t, removing the directory tree at
+   index INDEX of the array of paths PROCESS_BATON. */
+static svn_error_t *
+remove_dir_task(void **result,
+                int index,
+                void *process_baton,
+                void *thread_context,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *subdirs = process_baton;
+
+  *result = NULL;
+  return svn_error_trace(svn_io_remove_dir2(APR_ARRAY_IDX(subdirs, index,
+                                                          const char *),
+                                            FALSE, cancel_func, cancel_baton,
+                                            scratch_pool));
+}
+
+svn_error_t *
+svn_io__remove_dir_concurrently(const char *path,
+                                svn_boolean_t ignore_enoent,
+                                int thread_count,
+                                svn_cancel_func_t cancel_func,
+                                void *cancel_baton,
+                                apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *cleared;
+  apr_array_header_t *frontier;
+  svn_boolean_t found;
+  int i;
+
+  if (thread_count <= 1)
+    return svn_error_trace(svn_io_remove_dir2(path, ignore_enoent,
+                                              cancel_func, cancel_baton,
+                                              scratch_pool));
+
+  /* Descend breadth-first until there are enough subtrees to keep all
+     threads busy, emptying the directories above them on the way.  A
+     directory only removes its own entries, so the subtrees can't get
+     into each other's way. */
+  cleared = apr_array_make(scratch_pool, 16, sizeof(const char *));
+  frontier = apr_array_make(scratch_pool, 16, sizeof(const char *));
+
+  SVN_ERR(remove_dir_files(&found, frontier, path, ignore_enoent,
+                           cancel_func, cancel_baton,
+                           scratch_pool, scratch_pool));
+  if (!found)
+    return SVN_NO_ERROR;
+
+  APR_ARRAY_PUSH(cleared, const char *) = path;
+  while (frontier->nelts > 0 && frontier->nelts < thread_count)
+    {
+      apr_array_header_t *next = apr_array_make(scratch_pool, 16,
+                                                sizeof(const char *));
+
+      for (i = 0; i < frontier->nelts; i++)
+        {
+          const char *dir = APR_ARRAY_IDX(frontier, i, const char *);
+
+          SVN_ERR(remove_dir_files(&found, next, dir, FALSE,
+                                   cancel_func, cancel_baton,
+                                   scratch_pool, scratch_pool));
+          APR_ARRAY_PUSH(cleared, const char *) = dir;
+        }
+
+      frontier = next;
+    }
+
+  SVN_ERR(svn_task__run(thread_count, frontier->nelts,
+                        remove_dir_task, frontier,
+                        NULL, NULL,
+                        NULL, NULL,
+                        cancel_func, cancel_baton,
+                        scratch_pool));
+
+  /* Children were added after their parents. */
+  for (i = cleared->nelts - 1; i >= 0; i--)
+    SVN_ERR(svn_io_dir_remove_nonrecursive(APR_ARRAY_IDX(cleared, i,
+                                                         const char *),
+                                           scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_io_get_dir_filenames(apr_hash_t **dirents,
                          const char *path,
@@ -518,6 +518,9 @@ parse_rangelist(const char **input, const char *end,
                 apr_pool_t *pool)
 {
   const char *curr = *input;
+  const char *p;
+  svn_merge_range_t *ranges;
+  int count;
 
   /* Eat any leading horizontal white-space before the rangelist. */
   while (curr < end && *curr != '\n' && isspace(*curr))
@@ -530,10 +533,20 @@ parse_rangelist(const char **input, const char *end,
       return SVN_NO_ERROR;
     }
 
+  /* Long-lived branches list thousands of ranges per line.  Allocate
+     them in one block, which also keeps them close together in memory. */
+  count = 1;
+  for (p = curr; p < end && *p != '\n'; p++)
+    if (*p == ',')
+      count++;
+
+  ranges = apr_palloc(pool, count * sizeof(*ranges));
+
   while (curr < end && *curr != '\n')
     {
-      /* Parse individual revisions or revision ranges. */
-      svn_merge_range_t *mrange = apr_pcalloc(pool, sizeof(*mrange));
+      /* Parse individual revisions or revision ranges.  Every range but
+         the last one is followed by a comma, so RANGES is large enough. */
+      svn_merge_range_t *mrange = ranges++;
       svn_revnum_t firstrev;
 
       SVN_ERR(svn_revnum_parse(&firstrev, curr, &curr));
@@ -972,18 +985,27 @@ rlii_next(rangelist_interval_iterator_t *it)
 typedef struct rangelist_builder_t {
   svn_rangelist_t *rl;  /* rangelist to build */
   rangelist_interval_t accu_interval;  /* current interval accumulator */
+  svn_merge_range_t *ranges;  /* preallocated ranges to use next */
+  int ranges_left;  /* number of ranges left in RANGES */
   apr_pool_t *pool;  /* from which to allocate ranges */
 } rangelist_builder_t;
 
-/* Return an initialized rangelist builder. */
+/* Return an initialized rangelist builder.  Preallocate MAX_RANGES ranges
+ * in one block; ranges beyond that are allocated one by one. */
 static rangelist_builder_t *
 rl_builder_new(svn_rangelist_t *rl,
+               int max_ranges,
                apr_pool_t *pool)
 {
   rangelist_builder_t *b = apr_pcalloc(pool, sizeof(*b));
 
   b->rl = rl;
   /* b->accu_interval = {0, 0, RL_NONE} */
+  if (max_ranges > 0)
+    {
+      b->ranges = apr_palloc(pool, max_ranges * sizeof(*b->ranges));
+      b->ranges_left = max_ranges;
+    }
   b->pool = pool;
   return b;
 }
@@ -994,7 +1016,16 @@ rl_builder_flush(rangelist_builder_t *b)
 {
   if (b->accu_interval.kind > MI_NONE)
     {
-      svn_merge_range_t *mrange = apr_pcalloc(b->pool, sizeof(*mrange));
+      svn_merge_range_t *mrange;
+
+      if (b->ranges_left)
+        {
+          mrange = b->ranges++;
+          b->ranges_left--;
+        }
+      else
+        mrange = apr_palloc(b->pool, sizeof(*mrange));
+
       mrange->start = b->accu_interval.start;
       mrange->end = b->accu_interval.end;
       mrange->inheritable = (b->accu_interval.kind == MI_INHERITABLE);
@@ -1038,7 +1069,8 @@ rangelist_merge(svn_rangelist_t *rl_out,
                 apr_pool_t *scratch_pool)
 {
   rangelist_interval_iterator_t *it[2];
-  rangelist_builder_t *rl_builder = rl_builder_new(rl_out, result_pool);
+  rangelist_builder_t *rl_builder
+    = rl_builder_new(rl_out, rl1->nelts + rl2->nelts, result_pool);
   svn_revnum_t r_last = 0;
 
   /*SVN_ERR_ASSERT(svn_rangelist__is_canonical(rl1));*/
@@ -276,6 +276,16 @@ write_packed_uint_body(unsigned char *buffer, apr_uint64_t value)
   return buffer;
 }
 
+/* Number of values that the 7b/8b coders try to process at once.  This
+ * many single-byte values fit into one 64 bit word.
+ */
+#define UINT_GROUP_SIZE 8
+
+/* The continuation bits of UINT_GROUP_SIZE consecutive bytes of 7b/8b
+ * encoded data.  If none of them is set, all bytes are complete values.
+ */
+#define CONTINUATION_BITS APR_UINT64_C(0x8080808080808080)
+
 /* Return remapped VALUE.
  *
  * Due to sign conversion and diff underflow, values close to UINT64_MAX
@@ -361,9 +371,32 @@ data_flush_buffer(svn_packed__int_stream_t *stream)
         private_data->packed
           = svn_stringbuf_create_ensure(256, private_data->pool);
 
-      /* encode numbers into our temp buffer. */
-      for (i = 0; i < stream->buffer_used; ++i)
-        p = write_packed_uint_body(p, stream->buffer[i]);
+      /* encode numbers into our temp buffer.  Small numbers are the most
+         frequent ones, so store whole groups of them as single bytes
+         without going through the variable-length encoder. */
+      for (i = 0; i < stream->buffer_used; )
+        {
+          if (i + UINT_GROUP_SIZE <= stream->buffer_used)
+            {
+              apr_uint64_t combined = 0;
+              int k;
+
+              for (k = 0; k < UINT_GROUP_SIZE; ++k)
+                combined |= stream->buffer[i + k];
+
+              if (combined < 0x80)
+                {
+                  for (k = 0; k < UINT_GROUP_SIZE; ++k)
+                    *(p++) = (unsigned char)stream->buffer[i + k];
+
+                  i += UINT_GROUP_SIZE;
+                  continue;
+                }
+            }
+
+          p = write_packed_uint_body(p, stream->buffer[i]);
+          ++i;
+        }
 
       /* append them to the final packed data */
       svn_stringbuf_appendbytes(private_data->packed,
@@ -821,10 +854,34 @@ svn_packed__data_fill_buffer(svn_packed__int_stream_t *stream)
       else
         p = (unsigned char *)private_data->packed->data;
 
-      /* unpack numbers */
+      /* unpack numbers.  Check a whole group of bytes at once for being
+         single-byte numbers and copy them without further parsing.  As
+         every number takes at least one byte, the group never exceeds
+         the data that the remaining numbers would be read from. */
       start = p;
-      for (i = end; i > 0; --i)
-        p = read_packed_uint_body(p, &stream->buffer[i-1]);
+      for (i = end; i > 0; )
+        {
+          if (i >= UINT_GROUP_SIZE)
+            {
+              apr_uint64_t group;
+
+              memcpy(&group, p, sizeof(group));
+              if ((group & CONTINUATION_BITS) == 0)
+                {
+                  int k;
+
+                  for (k = 0; k < UINT_GROUP_SIZE; ++k)
+                    stream->buffer[i - 1 - k] = p[k];
+
+                  p += UINT_GROUP_SIZE;
+                  i -= UINT_GROUP_SIZE;
+                  continue;
+                }
+            }
+
+          p = read_packed_uint_body(p, &stream->buffer[i-1]);
+          --i;
+        }
 
       /* adjust remaining packed data buffer */
       packed_read = p - start;
@@ -30,6 +30,7 @@
 #include <assert.h>
 #include "svn_hash.h"
 #include "svn_path.h"
+#include "svn_pools.h"
 #include "svn_sorts.h"
 #include "svn_error.h"
 #include "private/svn_sorts_private.h"
@@ -144,6 +145,135 @@ svn_sort__array(apr_array_header_t *array,
   qsort(array->elts, array->nelts, array->elt_size, comparison_func);
 }
 
+/* Hashes with fewer entries are sorted with qsort(). */
+#define PREFIX_SORT_THRESHOLD 32
+
+/* Runs of this many items are sorted by insertion before merging. */
+#define PREFIX_SORT_RUN 8
+
+/* An item together with a number that orders like its key. */
+typedef struct prefixed_item_t
+{
+  apr_uint64_t prefix;
+  svn_sort__item_t item;
+} prefixed_item_t;
+
+/* Return the first 8 bytes of the key of ITEM as a big-endian number,
+   padded with zeros.  If AS_PATHS is set, map the bytes such that the
+   numbers order like svn_path_compare_paths() does, i.e. with '/' right
+   after the end of the key and before all other characters.  Keys that
+   differ in their numbers compare the same way; keys with equal numbers
+   have to be compared in full. */
+static apr_uint64_t
+key_prefix(const svn_sort__item_t *item,
+           svn_boolean_t as_paths)
+{
+  const unsigned char *key = item->key;
+  apr_uint64_t prefix = 0;
+  apr_ssize_t i;
+
+  for (i = 0; i < 8; i++)
+    {
+      unsigned char c = i < item->klen ? key[i] : 0;
+
+      if (as_paths && c)
+        c = (c == '/') ? 1 : (c < '/') ? c + 1 : c;
+
+      prefix = (prefix << 8) | c;
+    }
+
+  return prefix;
+}
+
+/* Return TRUE if A sorts after B according to COMPARISON_FUNC, comparing
+   their prefixes first. */
+static APR_INLINE svn_boolean_t
+prefixed_greater(const prefixed_item_t *a,
+                 const prefixed_item_t *b,
+                 int (*comparison_func)(const svn_sort__item_t *,
+                                        const svn_sort__item_t *))
+{
+  if (a->prefix != b->prefix)
+    return a->prefix > b->prefix;
+
+  return comparison_func(&a->item, &b->item) > 0;
+}
+
+/* Sort the NELTS items of ARY, which use COMPARISON_FUNC, a comparison
+   function that key_prefix() supports for AS_PATHS.  Unlike qsort(), this
+   stays out of the keys and the function pointer for most comparisons.
+   Use SCRATCH_POOL for temporary allocations. */
+static void
+sort_prefixed(apr_array_header_t *ary,
+              int (*comparison_func)(const svn_sort__item_t *,
+                                     const svn_sort__item_t *),
+              svn_boolean_t as_paths,
+              apr_pool_t *scratch_pool)
+{
+  svn_sort__item_t *items = (svn_sort__item_t *)ary->elts;
+  int nelts = ary->nelts;
+  prefixed_item_t *from = apr_palloc(scratch_pool, nelts * sizeof(*from));
+  prefixed_item_t *to = apr_palloc(scratch_pool, nelts * sizeof(*to));
+  int width;
+  int i;
+
+  for (i = 0; i < nelts; i++)
+    {
+      from[i].prefix = key_prefix(&items[i], as_paths);
+      from[i].item = items[i];
+    }
+
+  /* Sort short runs by insertion ... */
+  for (i = 0; i < nelts; i += PREFIX_SORT_RUN)
+    {
+      int end = MIN(i + PREFIX_SORT_RUN, nelts);
+      int j;
+
+      for (j = i + 1; j < end; j++)
+        {
+          prefixed_item_t current = from[j];
+          int k = j;
+
+          for (; k > i && prefixed_greater(&from[k - 1], &current,
+                                           comparison_func); k--)
+            from[k] = from[k - 1];
+
+          from[k] = current;
+        }
+    }
+
+  /* ... and merge them bottom-up. */
+  for (width = PREFIX_SORT_RUN; width < nelts; width *= 2)
+    {
+      prefixed_item_t *temp;
+
+      for (i = 0; i < nelts; i += 2 * width)
+        {
+          int left = i;
+          int mid = MIN(i + width, nelts);
+          int right = mid;
+          int end = MIN(i + 2 * width, nelts);
+          int k;
+
+          for (k = i; k < end; k++)
+            if (left < mid
+                && (right == end
+                    || !prefixed_greater(&from[left], &from[right],
+                                         comparison_func)))
+              to[k] = from[left++];
+            else
+              to[k] = from[right++];
+        }
+
+      temp = from;
+      from = to;
+      to = temp;
+    }
+
+  for (i = 0; i < nelts; i++)
+    items[i] = from[i].item;
+}
+
 apr_array_header_t *
 svn_sort__hash(apr_hash_t *ht,
                int (*comparison_func)(const svn_sort__item_t *,
@@ -180,10 +310,25 @@ svn_sort__hash(apr_hash_t *ht,
         }
     }
 
-  /* quicksort the array if it isn't already sorted.  */
+  /* Sort the array if it isn't already sorted.  Larger ones with the
+     usual keys are worth sorting by their cached prefixes.  */
   if (!sorted)
-    svn_sort__array(ary,
-          (int (*)(const void *, const void *))comparison_func);
+    {
+      if (ary->nelts >= PREFIX_SORT_THRESHOLD
+          && (comparison_func == svn_sort_compare_items_lexically
+              || comparison_func == svn_sort_compare_items_as_paths))
+        {
+          apr_pool_t *scratch_pool = svn_pool_create(pool);
+
+          sort_prefixed(ary, comparison_func,
+                        comparison_func == svn_sort_compare_items_as_paths,
+                        scratch_pool);
+          svn_pool_destroy(scratch_pool);
+        }
+      else
+        svn_sort__array(ary,
+              (int (*)(const void *, const void *))comparison_func);
+    }
 
   return ary;
 }
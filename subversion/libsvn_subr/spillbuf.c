@@ -22,12 +22,21 @@
  */
 
 #include <apr_file_io.h>
+#include <apr_mmap.h>
 
 #include "svn_io.h"
 #include "svn_pools.h"
+#include "svn_sorts.h"
 
 #include "private/svn_subr_private.h"
 
+#include "svn_private_config.h"
+
+/* Size of the windows of the spill file that get mapped into memory for
+   reading.  Windows start at multiples of this, so it must be a multiple
+   of the page size.  */
+#define SPILL_MAP_SIZE 0x100000
+
 
 struct memblock_t {
   apr_size_t size;
@@ -87,6 +96,20 @@ struct svn_spillbuf_t {
 
   /* The name of the temporary spill file. */
   const char *filename;
+
+#if APR_HAS_MMAP
+  /* The window of SPILL that is mapped into memory, starting at offset
+     MAP_OFFSET.  Content from the spill file is handed out from here
+     instead of being copied into a memblock.  MAP_SIZE is 0 if MAP can
+     not be used for further reads.  */
+  apr_mmap_t *map;
+  apr_off_t map_offset;
+  apr_size_t map_size;
+
+  /* The memblock describing the content handed out from MAP.  It never
+     goes into the list of available blocks.  */
+  struct memblock_t map_block;
+#endif
 };
 
 
@@ -204,7 +227,10 @@ get_buffer(svn_spillbuf_t *buf)
   if (mem != NULL)
     {
       buf->out_for_reading = NULL;
-      return mem;
+#if APR_HAS_MMAP
+      if (mem != &buf->map_block)
+#endif
+        return mem;
     }
 
   if (buf->avail == NULL)
@@ -225,6 +251,11 @@ static void
 return_buffer(svn_spillbuf_t *buf,
               struct memblock_t *mem)
 {
+#if APR_HAS_MMAP
+  if (mem == &buf->map_block)
+    return;
+#endif
+
   mem->next = buf->avail;
   buf->avail = mem;
 }
@@ -344,6 +375,68 @@ svn_spillbuf__write(svn_spillbuf_t *buf,
 }
 
 
+#if APR_HAS_MMAP
+/* Make sure that the content of BUF's spill file at BUF->SPILL_START is
+   mapped into memory and set *MAPPED to TRUE.  If the file can't be
+   mapped, set *MAPPED to FALSE and seek the file to BUF->SPILL_START for
+   reading it instead.  The memory of any previous window is released.
+   Use SCRATCH_POOL for temporary allocations.  */
+static svn_error_t *
+map_spill_window(svn_boolean_t *mapped,
+                 svn_spillbuf_t *buf,
+                 apr_pool_t *scratch_pool)
+{
+  apr_off_t end = buf->spill_start + buf->spill_size;
+  apr_off_t offset;
+  apr_size_t size;
+  apr_status_t status;
+
+  if (buf->map_size
+      && buf->spill_start >= buf->map_offset
+      && buf->spill_start < buf->map_offset + (apr_off_t)buf->map_size)
+    {
+      *mapped = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  /* Content from the previous window is no longer in use.  */
+  if (buf->map)
+    {
+      status = apr_mmap_delete(buf->map);
+      buf->map = NULL;
+      buf->map_size = 0;
+      if (status)
+        return svn_error_wrap_apr(status, _("Failed to delete mmap"));
+    }
+
+  offset = buf->spill_start - buf->spill_start % SPILL_MAP_SIZE;
+  size = (apr_size_t)MIN(SPILL_MAP_SIZE, end - offset);
+
+  /* Content still in the file's write buffer would not be mapped.  */
+  SVN_ERR(svn_io_file_flush(buf->spill, scratch_pool));
+
+  status = apr_mmap_create(&buf->map, buf->spill, offset, size,
+                           APR_MMAP_READ, buf->pool);
+  if (status)
+    {
+      /* Mapped reads don't move the file pointer.  */
+      apr_off_t start = buf->spill_start;
+
+      buf->map = NULL;
+      *mapped = FALSE;
+      return svn_error_trace(svn_io_file_seek(buf->spill, APR_SET, &start,
+                                              scratch_pool));
+    }
+
+  buf->map_offset = offset;
+  buf->map_size = size;
+  *mapped = TRUE;
+
+  return SVN_NO_ERROR;
+}
+#endif
+
+
 /* Return a memblock of content, if any is available. *mem will be NULL if
    no further content is available. The memblock should eventually be
    passed to return_buffer() (or stored into buf->out_for_reading which
@@ -353,7 +446,9 @@ read_data(struct memblock_t **mem,
           svn_spillbuf_t *buf,
           apr_pool_t *scratch_pool)
 {
-  svn_error_t *err;
+#if APR_HAS_MMAP
+  svn_boolean_t mapped;
+#endif
 
   /* If we have some in-memory blocks, then return one.  */
   if (buf->head != NULL)
@@ -380,23 +475,42 @@ read_data(struct memblock_t **mem,
 
   /* Assume that the caller has seeked the spill file to the correct pos.  */
 
-  /* Get a buffer that we can read content into.  */
-  *mem = get_buffer(buf);
-  /* NOTE: mem's size/next are uninitialized.  */
+#if APR_HAS_MMAP
+  /* Hand out content straight from the mapped file, at most a block at
+     a time like it would be read.  */
+  SVN_ERR(map_spill_window(&mapped, buf, scratch_pool));
+  if (mapped)
+    {
+      apr_size_t offset = (apr_size_t)(buf->spill_start - buf->map_offset);
 
-  if ((apr_uint64_t)buf->spill_size < (apr_uint64_t)buf->blocksize)
-    (*mem)->size = (apr_size_t)buf->spill_size;
+      *mem = &buf->map_block;
+      (*mem)->data = (char *)buf->map->mm + offset;
+      (*mem)->size = MIN(buf->blocksize, buf->map_size - offset);
+      (*mem)->next = NULL;
+    }
   else
-    (*mem)->size = buf->blocksize;  /* The size of (*mem)->data  */
-  (*mem)->next = NULL;
-
-  /* Read some data from the spill file into the memblock.  */
-  err = svn_io_file_read(buf->spill, (*mem)->data, &(*mem)->size,
-                         scratch_pool);
-  if (err)
+#endif
     {
-      return_buffer(buf, *mem);
-      return svn_error_trace(err);
+      svn_error_t *err;
+
+      /* Get a buffer that we can read content into.  */
+      *mem = get_buffer(buf);
+      /* NOTE: mem's size/next are uninitialized.  */
+
+      if ((apr_uint64_t)buf->spill_size < (apr_uint64_t)buf->blocksize)
+        (*mem)->size = (apr_size_t)buf->spill_size;
+      else
+        (*mem)->size = buf->blocksize;  /* The size of (*mem)->data  */
+      (*mem)->next = NULL;
+
+      /* Read some data from the spill file into the memblock.  */
+      err = svn_io_file_read(buf->spill, (*mem)->data, &(*mem)->size,
+                             scratch_pool);
+      if (err)
+        {
+          return_buffer(buf, *mem);
+          return svn_error_trace(err);
+        }
     }
 
   /* Mark the data that we consumed from the spill file.  */
@@ -409,6 +523,9 @@ read_data(struct memblock_t **mem,
       SVN_ERR(svn_io_file_close(buf->spill, scratch_pool));
       buf->spill = NULL;
       buf->spill_start = 0;
+#if APR_HAS_MMAP
+      buf->map_size = 0;
+#endif
     }
 
   /* *mem has been initialized. Done.  */
@@ -20,7 +20,11 @@
  * ====================================================================
  */
 
+#include <stdlib.h>
+#include <string.h>
+
 #include <apr_pools.h>
+#include <apr_strings.h>
 
 #include "svn_types.h"
 #include "svn_error.h"
@@ -28,6 +32,7 @@
 #include "svn_io.h"
 #include "svn_dirent_uri.h"
 #include "svn_checksum.h"
+#include "svn_ctype.h"
 
 #include "internal_statements.h"
 
@@ -133,6 +138,13 @@ svn_sqlite__dbg_enable_errorlog(void)
 #endif
 }
 
+/* When this environment variable names a file, every database appends
+   its statement profile to that file when it is closed. */
+#define PROFILE_ENV_VAR "SVN_SQLITE_PROFILE"
+
+/* Number of characters of a statement's text to show in a profile. */
+#define PROFILE_SQL_LEN 72
+
 
 struct svn_sqlite__db_t
 {
@@ -142,6 +154,12 @@ struct svn_sqlite__db_t
   svn_sqlite__stmt_t **prepared_stmts;
   apr_pool_t *state_pool;
 
+  /* Whether statement execution is being timed, the path of the database
+     and where to append the profile on close, if anywhere. */
+  svn_boolean_t profile;
+  const char *path;
+  const char *profile_file;
+
 #ifdef SVN_UNICODE_NORMALIZATION_FIXES
   /* Buffers for SQLite extensoins. */
   svn_membuf_t sqlext_buf1;
@@ -155,6 +173,14 @@ struct svn_sqlite__stmt_t
   sqlite3_stmt *s3stmt;
   svn_sqlite__db_t *db;
   svn_boolean_t needs_reset;
+
+  /* Execution counters, only maintained while profiling.  An execution
+     runs from the first step after a reset to the next reset. */
+  apr_int64_t executions;
+  apr_int64_t rows;
+  apr_interval_time_t total_time;
+  apr_interval_time_t max_time;
+  apr_interval_time_t exec_time;
 };
 
 struct svn_sqlite__context_t
@@ -247,9 +273,8 @@ static svn_error_t *
 prepare_statement(svn_sqlite__stmt_t **stmt, svn_sqlite__db_t *db,
                   const char *text, apr_pool_t *result_pool)
 {
-  *stmt = apr_palloc(result_pool, sizeof(**stmt));
+  *stmt = apr_pcalloc(result_pool, sizeof(**stmt));
   (*stmt)->db = db;
-  (*stmt)->needs_reset = FALSE;
 
   SQLITE_ERR(sqlite3_prepare_v2(db->db3, text, -1, &(*stmt)->s3stmt, NULL), db);
 
@@ -287,8 +312,9 @@ svn_sqlite__get_statement(svn_sqlite__stmt_t **stmt, svn_sqlite__db_t *db,
 
 /* Like svn_sqlite__get_statement but gets an internal statement.
 
-   All internal statements that use this api are executed with step_done(),
-   so we don't need the fallback reset handling here or in the pool cleanup */
+   All internal statements that use this api are executed with step_done()
+   or reset right after reading their row, so we don't need the fallback
+   reset handling here or in the pool cleanup */
 static svn_error_t *
 get_internal_statement(svn_sqlite__stmt_t **stmt, svn_sqlite__db_t *db,
                        int stmt_idx)
@@ -341,10 +367,36 @@ svn_sqlite__step_row(svn_sqlite__stmt_t *stmt)
 }
 
 
+/* Like sqlite3_step() on STMT, but update the profile of STMT. */
+static int
+profiled_step(svn_sqlite__stmt_t *stmt)
+{
+  apr_time_t start = apr_time_now();
+  apr_interval_time_t elapsed;
+  int sqlite_result = sqlite3_step(stmt->s3stmt);
+
+  elapsed = apr_time_now() - start;
+  if (!stmt->needs_reset)
+    {
+      stmt->executions++;
+      stmt->exec_time = 0;
+    }
+
+  stmt->exec_time += elapsed;
+  stmt->total_time += elapsed;
+  if (stmt->exec_time > stmt->max_time)
+    stmt->max_time = stmt->exec_time;
+  if (sqlite_result == SQLITE_ROW)
+    stmt->rows++;
+
+  return sqlite_result;
+}
+
 svn_error_t *
 svn_sqlite__step(svn_boolean_t *got_row, svn_sqlite__stmt_t *stmt)
 {
-  int sqlite_result = sqlite3_step(stmt->s3stmt);
+  int sqlite_result = stmt->db->profile ? profiled_step(stmt)
+                                        : sqlite3_step(stmt->s3stmt);
 
   if (sqlite_result != SQLITE_DONE && sqlite_result != SQLITE_ROW)
     {
@@ -781,6 +833,48 @@ svn_sqlite__read_schema_version(int *version,
 }
 
 
+svn_error_t *
+svn_sqlite__read_data_version(apr_int64_t *data_version,
+                              apr_int64_t *total_changes,
+                              svn_sqlite__db_t *db)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(get_internal_statement(&stmt, db, STMT_INTERNAL_DATA_VERSION));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+
+  /* SQLite versions before 3.8.8 ignore the pragma.  Whatever was read
+     in an open transaction may still be rolled back. */
+  if (have_row && sqlite3_get_autocommit(db->db3))
+    *data_version = svn_sqlite__column_int64(stmt, 0);
+  else
+    *data_version = -1;
+  *total_changes = sqlite3_total_changes(db->db3);
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+
+/* Set *WAL to whether DB uses write-ahead logging. */
+static svn_error_t *
+journal_mode_is_wal(svn_boolean_t *wal,
+                    svn_sqlite__db_t *db,
+                    apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_error_t *err;
+
+  SVN_ERR(prepare_statement(&stmt, db, "PRAGMA journal_mode;", scratch_pool));
+  err = svn_sqlite__step_row(stmt);
+  if (!err)
+    *wal = (strcmp(svn_sqlite__column_text(stmt, 0, NULL), "wal") == 0);
+
+  return svn_error_trace(svn_error_compose_create(err,
+                                                  svn_sqlite__finalize(stmt)));
+}
+
+
 static volatile svn_atomic_t sqlite_init_state = 0;
 
 /* If possible, verify that SQLite was compiled in a thread-safe
@@ -917,6 +1011,94 @@ internal_open(svn_sqlite__db_t *db, const char *path, svn_sqlite__mode_t mode,
 }
 
 
+/* Sort statements by descending total execution time. */
+static int
+compare_total_time(const void *a, const void *b)
+{
+  const svn_sqlite__stmt_t *stmt1 = *(const svn_sqlite__stmt_t * const *)a;
+  const svn_sqlite__stmt_t *stmt2 = *(const svn_sqlite__stmt_t * const *)b;
+
+  if (stmt1->total_time != stmt2->total_time)
+    return stmt1->total_time > stmt2->total_time ? -1 : 1;
+
+  return 0;
+}
+
+const char *
+svn_sqlite__profile_report(svn_sqlite__db_t *db,
+                           apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *report;
+  apr_array_header_t *stmts;
+  int i;
+
+  if (!db->profile || !db->prepared_stmts)
+    return NULL;
+
+  stmts = apr_array_make(result_pool, 16, sizeof(svn_sqlite__stmt_t *));
+  for (i = 0; i < db->nbr_statements + STMT_INTERNAL_LAST; i++)
+    if (db->prepared_stmts[i] && db->prepared_stmts[i]->executions)
+      APR_ARRAY_PUSH(stmts, svn_sqlite__stmt_t *) = db->prepared_stmts[i];
+
+  qsort(stmts->elts, stmts->nelts, stmts->elt_size, compare_total_time);
+
+  report = svn_stringbuf_createf(result_pool,
+                                 "SQLite statement profile of '%s'\n"
+                                 "   calls       rows   total ms"
+                                 "     avg us     max us  statement\n",
+                                 db->path);
+  for (i = 0; i < stmts->nelts; i++)
+    {
+      const svn_sqlite__stmt_t *stmt = APR_ARRAY_IDX(stmts, i,
+                                                     svn_sqlite__stmt_t *);
+      const char *sql = sqlite3_sql(stmt->s3stmt);
+      char text[PROFILE_SQL_LEN + 1];
+      apr_size_t len = 0;
+
+      /* Show the start of the statement on a single line. */
+      for (; sql && *sql && len < PROFILE_SQL_LEN; sql++)
+        if (!svn_ctype_isspace(*sql))
+          text[len++] = *sql;
+        else if (len > 0 && text[len - 1] != ' ')
+          text[len++] = ' ';
+      text[len] = '\0';
+
+      svn_stringbuf_appendcstr(report,
+        apr_psprintf(result_pool,
+                     "%8" APR_INT64_T_FMT " %10" APR_INT64_T_FMT
+                     " %10.1f %10" APR_INT64_T_FMT " %10" APR_INT64_T_FMT
+                     "  %s\n",
+                     stmt->executions, stmt->rows,
+                     stmt->total_time / 1000.0,
+                     (apr_int64_t)(stmt->total_time / stmt->executions),
+                     (apr_int64_t)stmt->max_time,
+                     text));
+    }
+
+  return report->data;
+}
+
+/* Append the profile of DB to the file named by PROFILE_ENV_VAR.  This
+   is a diagnostic aid, so failures are ignored. */
+static void
+write_profile(svn_sqlite__db_t *db)
+{
+  apr_pool_t *pool = svn_pool_create(NULL);
+  const char *report = svn_sqlite__profile_report(db, pool);
+  apr_file_t *file;
+
+  if (report
+      && apr_file_open(&file, db->profile_file,
+                       APR_WRITE | APR_CREATE | APR_APPEND,
+                       APR_OS_DEFAULT, pool) == APR_SUCCESS)
+    {
+      apr_file_write_full(file, report, strlen(report), NULL);
+      apr_file_close(file);
+    }
+
+  svn_pool_destroy(pool);
+}
+
 /* APR cleanup function used to close the database when its pool is destroyed.
    DATA should be the svn_sqlite__db_t handle for the database. */
 static apr_status_t
@@ -931,6 +1113,9 @@ close_apr(void *data)
   if (db->db3 == NULL)
     return APR_SUCCESS;
 
+  if (db->profile_file)
+    write_profile(db);
+
   /* Finalize any prepared statements. */
   if (db->prepared_stmts)
     {
@@ -1083,6 +1268,17 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
 
   SVN_ERR(internal_open(*db, path, mode, timeout, scratch_pool));
 
+  {
+    const char *profile_file = getenv(PROFILE_ENV_VAR);
+
+    if (profile_file && *profile_file)
+      {
+        (*db)->profile = TRUE;
+        (*db)->path = apr_pstrdup(result_pool, path);
+        (*db)->profile_file = apr_pstrdup(result_pool, profile_file);
+      }
+  }
+
 #if SQLITE_VERSION_NUMBER >= 3008000 && SQLITE_VERSION_NUMBER < 3009000
   /* disable SQLITE_ENABLE_STAT3/4 from 3.8.1 - 3.8.3 (but not 3.8.3.1+)
    * to prevent using it when it's buggy.
@@ -1164,11 +1360,21 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
                  affects application(read: Subversion) performance/behavior. */
               "PRAGMA foreign_keys=OFF;"      /* SQLITE_DEFAULT_FOREIGN_KEYS*/
               "PRAGMA locking_mode = NORMAL;" /* SQLITE_DEFAULT_LOCKING_MODE */
-              /* Testing shows TRUNCATE is faster than DELETE on Windows. */
-              "PRAGMA journal_mode = TRUNCATE;"
               ),
                 *db);
 
+  /* Testing shows TRUNCATE is faster than DELETE on Windows.  Databases
+     that a user switched to write-ahead logging keep it, though: leaving
+     that mode requires that no other connection is open. */
+  {
+    svn_boolean_t wal;
+
+    SVN_SQLITE__ERR_CLOSE(journal_mode_is_wal(&wal, *db, scratch_pool), *db);
+    if (!wal)
+      SVN_SQLITE__ERR_CLOSE(exec_sql(*db, "PRAGMA journal_mode = TRUNCATE;"),
+                            *db);
+  }
+
 #if defined(SVN_DEBUG)
   /* When running in debug mode, enable the checking of foreign key
      constraints.  This has possible performance implications, so we don't
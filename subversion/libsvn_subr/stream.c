@@ -71,6 +71,15 @@ struct svn_stream_t {
 static svn_error_t *
 skip_default_handler(void *baton, apr_size_t len, svn_read_fn_t read_full_fn);
 
+static svn_error_t *
+read_full_handler_disown(void *baton, char *buffer, apr_size_t *len);
+
+static svn_error_t *
+read_full_handler_apr(void *baton, char *buffer, apr_size_t *len);
+
+static svn_error_t *
+write_handler_apr(void *baton, const char *data, apr_size_t *len);
+
 
 /*** Generic streams. ***/
 
@@ -397,38 +406,64 @@ svn_stream_readline(svn_stream_t *stream,
   return SVN_NO_ERROR;
 }
 
+/* Return the file that STREAM reads from and writes to without any
+   transformation, or NULL if there is no such file. */
+static apr_file_t *
+plain_file(svn_stream_t *stream)
+{
+  while (stream->read_full_fn == read_full_handler_disown)
+    stream = stream->baton;
+
+  if (   stream->read_full_fn == read_full_handler_apr
+      && stream->write_fn == write_handler_apr)
+    return stream->file;
+
+  return NULL;
+}
+
 svn_error_t *svn_stream_copy3(svn_stream_t *from, svn_stream_t *to,
                               svn_cancel_func_t cancel_func,
                               void *cancel_baton,
                               apr_pool_t *scratch_pool)
 {
-  char *buf = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
-  svn_error_t *err;
+  apr_file_t *from_file = plain_file(from);
+  apr_file_t *to_file = plain_file(to);
+  svn_boolean_t copied = FALSE;
+  svn_error_t *err = SVN_NO_ERROR;
   svn_error_t *err2;
 
+  /* Between plain files, let the kernel copy the data if it can. */
+  if (from_file && to_file)
+    err = svn_io__file_splice(&copied, from_file, to_file, scratch_pool);
+
   /* Read and write chunks until we get a short read, indicating the
      end of the stream.  (We can't get a short write without an
      associated error.) */
-  while (1)
+  if (!err && !copied)
     {
-      apr_size_t len = SVN__STREAM_CHUNK_SIZE;
+      char *buf = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
 
-      if (cancel_func)
+      while (1)
         {
-          err = cancel_func(cancel_baton);
+          apr_size_t len = SVN__STREAM_CHUNK_SIZE;
+
+          if (cancel_func)
+            {
+              err = cancel_func(cancel_baton);
+              if (err)
+                 break;
+            }
+
+          err = svn_stream_read_full(from, buf, &len);
           if (err)
              break;
-        }
-
-      err = svn_stream_read_full(from, buf, &len);
-      if (err)
-         break;
 
-      if (len > 0)
-        err = svn_stream_write(to, buf, &len);
+          if (len > 0)
+            err = svn_stream_write(to, buf, &len);
 
-      if (err || (len != SVN__STREAM_CHUNK_SIZE))
-          break;
+          if (err || (len != SVN__STREAM_CHUNK_SIZE))
+              break;
+        }
     }
 
   err2 = svn_error_compose_create(svn_stream_close(from),
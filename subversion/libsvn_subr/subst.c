@@ -1125,24 +1125,14 @@ translate_chunk(svn_stream_t *dst,
 
               if (b->keywords)
                 {
-                  /* Check 4 bytes at once to allow for efficient pipelining
-                    and to reduce loop condition overhead. */
-                  while ((end - p) >= (len + 4))
-                    {
-                      if (interesting[(unsigned char)p[len]]
-                          || interesting[(unsigned char)p[len+1]]
-                          || interesting[(unsigned char)p[len+2]]
-                          || interesting[(unsigned char)p[len+3]])
-                        break;
-
-                      len += 4;
-                    }
-
-                  /* Found an interesting char or EOF in the next 4 bytes.
-                     Find its exact position. */
-                  while ((p + len) < end
-                         && !interesting[(unsigned char)p[len]])
-                    ++len;
+                  /* use our optimized sub-routine to find the next '$',
+                     or EOL if we translate those as well */
+                  const char *start = p + len;
+                  const char *next
+                    = svn_eol__find_keyword_start((char *)start, end - start,
+                                                  b->eol_str != NULL);
+
+                  len += (next ? next : end) - start;
                 }
               else
                 {
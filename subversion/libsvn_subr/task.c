@@ -0,0 +1,585 @@
+/* task.c : process a sequence of independent work items concurrently
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
+
+#include "svn_pools.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
+#include "private/svn_task.h"
+
+#include "svn_private_config.h"
+
+/* Worker threads may run ahead of the output by at most this many items
+ * per thread.  This limits the amount of memory held by results that have
+ * not been reported, yet. */
+#define MAX_ITEMS_AHEAD_PER_THREAD 4
+
+/* Sequential implementation of svn_task__run().  All callbacks are being
+ * called from within the current thread.
+ */
+static svn_error_t *
+run_sequentially(int item_count,
+                 svn_task__process_func_t process_func,
+                 void *process_baton,
+                 svn_task__output_func_t output_func,
+                 void *output_baton,
+                 svn_task__thread_context_constructor_t context_constructor,
+                 void *context_baton,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *scratch_pool)
+{
+  void *thread_context = NULL;
+  apr_pool_t *result_pool = svn_pool_create(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  if (context_constructor)
+    SVN_ERR(context_constructor(&thread_context, context_baton,
+                                scratch_pool, iterpool));
+
+  for (i = 0; i < item_count; ++i)
+    {
+      void *result = NULL;
+
+      svn_pool_clear(result_pool);
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(process_func(&result, i, process_baton, thread_context,
+                           cancel_func, cancel_baton, result_pool,
+                           iterpool));
+      if (output_func)
+        SVN_ERR(output_func(result, i, output_baton, cancel_func,
+                            cancel_baton, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* Processing state of a single work item.
+ */
+typedef struct item_t
+{
+  /* The shared processing state that this item belongs to. */
+  struct shared_t *shared;
+
+  /* Index of this item. */
+  int index;
+
+  /* Result returned by the process callback.  Allocated in POOL. */
+  void *result;
+
+  /* Error returned by the process callback. */
+  svn_error_t *error;
+
+  /* Root pool owning RESULT.  NULL until processing starts and after
+   * the result has been handed to the output callback. */
+  apr_pool_t *pool;
+
+  /* Set once processing has completed. */
+  svn_boolean_t done;
+} item_t;
+
+/* State shared between the caller's thread and all worker threads.
+ * Unless noted otherwise, members are either read-only or protected
+ * by MUTEX.
+ */
+typedef struct shared_t
+{
+  /* Callbacks and their batons as passed to svn_task__run().
+   * Read-only. */
+  svn_task__process_func_t process_func;
+  void *process_baton;
+  svn_task__thread_context_constructor_t context_constructor;
+  void *context_baton;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* All work items.  ITEM_COUNT is read-only. */
+  item_t *items;
+  int item_count;
+
+  /* Index of the next item to be picked up by a worker thread. */
+  int next_item;
+
+  /* Index of the next item to be passed to the output callback. */
+  int next_output;
+
+  /* Maximum value by which NEXT_ITEM may exceed NEXT_OUTPUT.
+   * Read-only. */
+  int max_ahead;
+
+  /* Index of the first item that failed, either during processing or
+   * output.  ITEM_COUNT, if no item failed.  All later items will not be
+   * reported and thus need not be processed.  Since it is also read by
+   * the cancellation callback, access it atomically. */
+  volatile svn_atomic_t first_failed;
+
+  /* Synchronization objects. */
+  svn_mutex__t *mutex;
+  apr_thread_cond_t *cond;
+} shared_t;
+
+/* Wake up all threads waiting for state changes in SHARED.
+ * The caller must hold SHARED->MUTEX. */
+static svn_error_t *
+broadcast(shared_t *shared)
+{
+  apr_status_t status = apr_thread_cond_broadcast(shared->cond);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't broadcast condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait for the next state change in SHARED.
+ * The caller must hold SHARED->MUTEX. */
+static svn_error_t *
+wait_for_change(shared_t *shared)
+{
+  apr_status_t status = apr_thread_cond_wait(shared->cond,
+                                             svn_mutex__get(shared->mutex));
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't wait on condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if any item in SHARED has failed. */
+static svn_boolean_t
+has_failed(shared_t *shared)
+{
+  return svn_atomic_read(&shared->first_failed)
+       < (apr_uint32_t)shared->item_count;
+}
+
+/* Stop SHARED from processing any items after INDEX and notify all
+ * threads.  The caller must hold SHARED->MUTEX. */
+static svn_error_t *
+abort_processing(shared_t *shared,
+                 int index)
+{
+  if ((apr_uint32_t)index < svn_atomic_read(&shared->first_failed))
+    svn_atomic_set(&shared->first_failed, (apr_uint32_t)index);
+
+  return svn_error_trace(broadcast(shared));
+}
+
+/* Implements svn_cancel_func_t for the worker threads.  BATON is the
+ * item_t being processed. */
+static svn_error_t *
+worker_cancel_func(void *baton)
+{
+  item_t *item = baton;
+  shared_t *shared = item->shared;
+
+  /* Don't waste time on results that will be discarded anyway. */
+  if ((apr_uint32_t)item->index > svn_atomic_read(&shared->first_failed))
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  if (shared->cancel_func)
+    return svn_error_trace(shared->cancel_func(shared->cancel_baton));
+
+  return SVN_NO_ERROR;
+}
+
+/* Core of next_item(). */
+static svn_error_t *
+next_item_body(int *index,
+               shared_t *shared)
+{
+  while (   !has_failed(shared)
+         && shared->next_item < shared->item_count
+         && shared->next_item >= shared->next_output + shared->max_ahead)
+    SVN_ERR(wait_for_change(shared));
+
+  if (has_failed(shared) || shared->next_item >= shared->item_count)
+    *index = -1;
+  else
+    *index = shared->next_item++;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *INDEX to the next item in SHARED to be processed.  Block while
+ * the workers are too far ahead of the output.  Set *INDEX to -1 if there
+ * are no more items to process. */
+static svn_error_t *
+next_item(int *index,
+          shared_t *shared)
+{
+  SVN_MUTEX__WITH_LOCK(shared->mutex, next_item_body(index, shared));
+  return SVN_NO_ERROR;
+}
+
+/* Core of item_done(). */
+static svn_error_t *
+item_done_body(shared_t *shared,
+               item_t *item)
+{
+  item->done = TRUE;
+  if (item->error)
+    SVN_ERR(abort_processing(shared, item->index));
+  else
+    SVN_ERR(broadcast(shared));
+
+  return SVN_NO_ERROR;
+}
+
+/* Mark ITEM in SHARED as processed and notify the output thread. */
+static svn_error_t *
+item_done(shared_t *shared,
+          item_t *item)
+{
+  SVN_MUTEX__WITH_LOCK(shared->mutex, item_done_body(shared, item));
+  return SVN_NO_ERROR;
+}
+
+/* Process items from SHARED until there are no more to process.
+ * POOL is the thread's root pool. */
+static svn_error_t *
+worker_body(shared_t *shared,
+            apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  void *thread_context = NULL;
+  svn_error_t *context_err = SVN_NO_ERROR;
+
+  if (shared->context_constructor)
+    context_err = shared->context_constructor(&thread_context,
+                                              shared->context_baton,
+                                              pool, iterpool);
+
+  while (TRUE)
+    {
+      item_t *item;
+      int index;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(next_item(&index, shared));
+      if (index < 0)
+        break;
+
+      item = &shared->items[index];
+      item->pool = svn_pool_create(NULL);
+
+      /* If we could not set up the thread context, report that as the
+       * failure of our first item. */
+      if (context_err)
+        {
+          item->error = context_err;
+          SVN_ERR(item_done(shared, item));
+          break;
+        }
+
+      item->error = shared->process_func(&item->result, index,
+                                         shared->process_baton,
+                                         thread_context,
+                                         worker_cancel_func, item,
+                                         item->pool, iterpool);
+      SVN_ERR(item_done(shared, item));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function processing work items.  DATA is the shared_t instance.
+ */
+static void * APR_THREAD_FUNC
+worker(apr_thread_t *thread,
+       void *data)
+{
+  shared_t *shared = data;
+
+  /* All allocations of this thread go into its own root pool, such that
+   * we don't need to synchronize with other threads. */
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  /* Errors can only come from broken synchronization objects, in which
+   * case there is nobody we could report them to. */
+  svn_error_clear(worker_body(shared, pool));
+  svn_pool_destroy(pool);
+
+  apr_thread_exit(thread, APR_SUCCESS);
+  return NULL;
+}
+
+/* Core of wait_for_item(). */
+static svn_error_t *
+wait_for_item_body(svn_boolean_t *available,
+                   shared_t *shared,
+                   int index)
+{
+  item_t *item = &shared->items[index];
+
+  /* Items get picked up in order.  Hence, once some item failed, all
+   * items that have not been picked up will never be processed. */
+  while (!item->done && !(has_failed(shared) && index >= shared->next_item))
+    SVN_ERR(wait_for_change(shared));
+
+  *available = item->done;
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait until the item with the given INDEX in SHARED has been processed.
+ * Set *AVAILABLE to FALSE, if the item will not be processed at all. */
+static svn_error_t *
+wait_for_item(svn_boolean_t *available,
+              shared_t *shared,
+              int index)
+{
+  SVN_MUTEX__WITH_LOCK(shared->mutex,
+                       wait_for_item_body(available, shared, index));
+  return SVN_NO_ERROR;
+}
+
+/* Core of item_reported(). */
+static svn_error_t *
+item_reported_body(shared_t *shared,
+                   int index,
+                   svn_boolean_t failed)
+{
+  shared->next_output = index + 1;
+  if (failed)
+    SVN_ERR(abort_processing(shared, index));
+  else
+    SVN_ERR(broadcast(shared));
+
+  return SVN_NO_ERROR;
+}
+
+/* Tell the workers in SHARED that the item with the given INDEX has been
+ * reported.  If FAILED is set, stop all further processing. */
+static svn_error_t *
+item_reported(shared_t *shared,
+              int index,
+              svn_boolean_t failed)
+{
+  SVN_MUTEX__WITH_LOCK(shared->mutex,
+                       item_reported_body(shared, index, failed));
+  return SVN_NO_ERROR;
+}
+
+/* Pass all processed items in SHARED in order to OUTPUT_FUNC with
+ * OUTPUT_BATON and return the first error encountered.  CANCEL_FUNC and
+ * CANCEL_BATON are the caller-provided cancellation callback.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+output_items(shared_t *shared,
+             svn_task__output_func_t output_func,
+             void *output_baton,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < shared->item_count; ++i)
+    {
+      svn_error_t *err;
+      svn_boolean_t available;
+      item_t *item = &shared->items[i];
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(wait_for_item(&available, shared, i));
+
+      /* Processing has been aborted due to some error in an earlier item.
+       * That one has already been returned to the caller. */
+      if (!available)
+        break;
+
+      err = item->error;
+      item->error = SVN_NO_ERROR;
+
+      if (!err && output_func)
+        err = output_func(item->result, i, output_baton, cancel_func,
+                          cancel_baton, iterpool);
+      if (!err && cancel_func)
+        err = cancel_func(cancel_baton);
+
+      svn_pool_destroy(item->pool);
+      item->pool = NULL;
+
+      err = svn_error_compose_create(err,
+                                     item_reported(shared, i, err != NULL));
+      SVN_ERR(err);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Make sure that the workers in SHARED don't process any items that
+ * have not been reported, yet. */
+static svn_error_t *
+stop_workers(shared_t *shared)
+{
+  SVN_MUTEX__WITH_LOCK(shared->mutex,
+                       abort_processing(shared, shared->next_output));
+  return SVN_NO_ERROR;
+}
+
+/* Multi-threaded implementation of svn_task__run(). */
+static svn_error_t *
+run_concurrently(int thread_count,
+                 int item_count,
+                 svn_task__process_func_t process_func,
+                 void *process_baton,
+                 svn_task__output_func_t output_func,
+                 void *output_baton,
+                 svn_task__thread_context_constructor_t context_constructor,
+                 void *context_baton,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *scratch_pool)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_threadattr_t *attr;
+  apr_thread_t **threads;
+  apr_status_t status;
+  int started = 0;
+  int i;
+
+  shared_t *shared = apr_pcalloc(scratch_pool, sizeof(*shared));
+  shared->process_func = process_func;
+  shared->process_baton = process_baton;
+  shared->context_constructor = context_constructor;
+  shared->context_baton = context_baton;
+  shared->cancel_func = cancel_func;
+  shared->cancel_baton = cancel_baton;
+  shared->items = apr_pcalloc(scratch_pool,
+                              item_count * sizeof(*shared->items));
+  shared->item_count = item_count;
+  shared->max_ahead = thread_count * MAX_ITEMS_AHEAD_PER_THREAD;
+  shared->first_failed = (apr_uint32_t)item_count;
+
+  for (i = 0; i < item_count; ++i)
+    {
+      shared->items[i].shared = shared;
+      shared->items[i].index = i;
+    }
+
+  SVN_ERR(svn_mutex__init(&shared->mutex, TRUE, scratch_pool));
+  status = apr_thread_cond_create(&shared->cond, scratch_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  status = apr_threadattr_create(&attr, scratch_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create thread attributes"));
+
+  /* Fire up the workers. */
+  threads = apr_pcalloc(scratch_pool, thread_count * sizeof(*threads));
+  for (started = 0; started < thread_count; ++started)
+    {
+      status = apr_thread_create(&threads[started], attr, worker, shared,
+                                 scratch_pool);
+      if (status)
+        {
+          err = svn_error_wrap_apr(status, _("Can't create thread"));
+          break;
+        }
+    }
+
+  /* Report the results in order while they come in. */
+  if (!err)
+    err = output_items(shared, output_func, output_baton,
+                       cancel_func, cancel_baton, scratch_pool);
+
+  /* Make sure the workers don't pick up any new items and wait for them
+   * to finish their current ones. */
+  err = svn_error_compose_create(err, stop_workers(shared));
+
+  for (i = 0; i < started; ++i)
+    {
+      apr_status_t retval;
+      status = apr_thread_join(&retval, threads[i]);
+      if (status)
+        err = svn_error_compose_create(
+                err, svn_error_wrap_apr(status, _("Can't join thread")));
+    }
+
+  /* Release any results and errors that we did not report. */
+  for (i = 0; i < item_count; ++i)
+    {
+      svn_error_clear(shared->items[i].error);
+      if (shared->items[i].pool)
+        svn_pool_destroy(shared->items[i].pool);
+    }
+
+  return svn_error_trace(err);
+}
+
+#endif
+
+svn_error_t *
+svn_task__run(int thread_count,
+              int item_count,
+              svn_task__process_func_t process_func,
+              void *process_baton,
+              svn_task__output_func_t output_func,
+              void *output_baton,
+              svn_task__thread_context_constructor_t context_constructor,
+              void *context_baton,
+              svn_cancel_func_t cancel_func,
+              void *cancel_baton,
+              apr_pool_t *scratch_pool)
+{
+  /* There is no point in having more threads than items. */
+  if (thread_count > item_count)
+    thread_count = item_count;
+
+#if APR_HAS_THREADS
+  if (thread_count > 1)
+    return svn_error_trace(run_concurrently(thread_count, item_count,
+                                            process_func, process_baton,
+                                            output_func, output_baton,
+                                            context_constructor,
+                                            context_baton,
+                                            cancel_func, cancel_baton,
+                                            scratch_pool));
+#endif
+
+  return svn_error_trace(run_sequentially(item_count,
+                                          process_func, process_baton,
+                                          output_func, output_baton,
+                                          context_constructor,
+                                          context_baton,
+                                          cancel_func, cancel_baton,
+                                          scratch_pool));
+}
@@ -290,7 +290,13 @@ svn_utf__last_valid(const char *data, apr_size_t len)
       int category = octet_category[octet];
       state = machine[state][category];
       if (state == FSM_START)
-        start = data;
+        {
+          /* Skip any run of ASCII chars following a complete char. */
+          data = first_non_fsm_start_char(data, end - data);
+          start = data;
+        }
+      else if (state == FSM_ERROR)
+        break;
     }
   return start;
 }
@@ -320,6 +326,10 @@ svn_utf__is_valid(const char *data, apr_size_t len)
       unsigned char octet = *data++;
       int category = octet_category[octet];
       state = machine[state][category];
+      if (state == FSM_START)
+        data = first_non_fsm_start_char(data, end - data);
+      else if (state == FSM_ERROR)
+        return FALSE;
     }
   return state == FSM_START;
 }
@@ -33,6 +33,7 @@
 #include "svn_error.h"
 #include "svn_ctype.h"
 
+#include "private/svn_eol_private.h"
 #include "private/svn_utf_private.h"
 #include "private/svn_subr_private.h"
 
@@ -132,81 +133,95 @@ svn_xml_is_xml_safe(const char *data, apr_size_t len)
 
 /*** XML escaping. ***/
 
-/* ### ...?
- *
- * If *OUTSTR is @c NULL, set *OUTSTR to a new stringbuf allocated
- * in POOL, else append to the existing stringbuf there.
- */
-static void
-xml_escape_cdata(svn_stringbuf_t **outstr,
-                 const char *data,
-                 apr_size_t len,
-                 apr_pool_t *pool)
-{
-  const char *end = data + len;
-  const char *p = data, *q;
+/* Flags in ESCAPE_CLASS telling whether a character has to be replaced
+   by an entity reference in character data and in attribute values. */
+#define ESCAPE_IN_CDATA 1
+#define ESCAPE_IN_ATTR  2
+
+/* Strictly speaking, '>' only needs to be quoted if it follows "]]", but
+   it's easier to quote it all the time.
+
+   So, why are we escaping '\r' here?  Well, according to the XML spec,
+   '\r\n' gets converted to '\n' during XML parsing.  Also, any '\r' not
+   followed by '\n' is converted to '\n'.  By golly, if we say we want to
+   escape a '\r', we want to make sure it remains a '\r'!
+
+   Attribute values additionally protect whitespace and quote characters. */
+static const unsigned char escape_class[256] =
+  {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 0, 0, 3, 0, 0,   /* \t \n \r */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 2, 0, 0, 0, 3, 2, 0, 0, 0, 0, 0, 0, 0, 0,   /* " & ' */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 0, 3, 0,   /* < > */
+  };
+
+/* All characters in ESCAPE_CLASS are below this value. */
+#define ESCAPE_LIMIT 0x40
+
+/* Return the first character in the range from P to END that ESCAPE_CLASS
+   marks with a flag in MASK, or END if there is none. */
+static const char *
+find_escape(const char *p,
+            const char *end,
+            unsigned char mask)
+{
+#if SVN_UNALIGNED_ACCESS_IS_OK
+
+  /* Most text doesn't need escaping.  Skip whole machine words that don't
+     contain any byte below ESCAPE_LIMIT, using the same trick as
+     svn_eol__find_eol_start(). */
+  for (; end - p >= (apr_ssize_t)sizeof(apr_uintptr_t);
+       p += sizeof(apr_uintptr_t))
+    {
+      apr_uintptr_t chunk = *(const apr_uintptr_t *)p;
+      apr_uintptr_t low_test = chunk - (SVN__LOWER_7BITS_SET / 0x7f)
+                                       * ESCAPE_LIMIT;
 
-  if (*outstr == NULL)
-    *outstr = svn_stringbuf_create_empty(pool);
+      if (low_test & ~chunk & SVN__BIT_7_SET)
+        {
+          apr_size_t i;
 
-  while (1)
-    {
-      /* Find a character which needs to be quoted and append bytes up
-         to that point.  Strictly speaking, '>' only needs to be
-         quoted if it follows "]]", but it's easier to quote it all
-         the time.
-
-         So, why are we escaping '\r' here?  Well, according to the
-         XML spec, '\r\n' gets converted to '\n' during XML parsing.
-         Also, any '\r' not followed by '\n' is converted to '\n'.  By
-         golly, if we say we want to escape a '\r', we want to make
-         sure it remains a '\r'!  */
-      q = p;
-      while (q < end && *q != '&' && *q != '<' && *q != '>' && *q != '\r')
-        q++;
-      svn_stringbuf_appendbytes(*outstr, p, q - p);
+          for (i = 0; i < sizeof(apr_uintptr_t); i++)
+            if (escape_class[(unsigned char)p[i]] & mask)
+              return p + i;
+        }
+    }
 
-      /* We may already be a winner.  */
-      if (q == end)
-        break;
+#endif
 
-      /* Append the entity reference for the character.  */
-      if (*q == '&')
-        svn_stringbuf_appendcstr(*outstr, "&amp;");
-      else if (*q == '<')
-        svn_stringbuf_appendcstr(*outstr, "&lt;");
-      else if (*q == '>')
-        svn_stringbuf_appendcstr(*outstr, "&gt;");
-      else if (*q == '\r')
-        svn_stringbuf_appendcstr(*outstr, "&#13;");
+  while (p < end && !(escape_class[(unsigned char)*p] & mask))
+    p++;
 
-      p = q + 1;
-    }
+  return p;
 }
 
-/* Essentially the same as xml_escape_cdata, with the addition of
-   whitespace and quote characters. */
+/* Append DATA of length LEN to *OUTSTR, replacing the characters that
+ * ESCAPE_CLASS marks with a flag in MASK by entity references.
+ *
+ * If *OUTSTR is @c NULL, set *OUTSTR to a new stringbuf allocated
+ * in POOL, else append to the existing stringbuf there.
+ */
 static void
-xml_escape_attr(svn_stringbuf_t **outstr,
-                const char *data,
-                apr_size_t len,
-                apr_pool_t *pool)
+xml_escape(svn_stringbuf_t **outstr,
+           const char *data,
+           apr_size_t len,
+           unsigned char mask,
+           apr_pool_t *pool)
 {
   const char *end = data + len;
   const char *p = data, *q;
 
+  /* Usually, nothing needs to be escaped, so reserve the space once. */
   if (*outstr == NULL)
     *outstr = svn_stringbuf_create_ensure(len, pool);
+  else
+    svn_stringbuf_ensure(*outstr, (*outstr)->len + len);
 
   while (1)
     {
       /* Find a character which needs to be quoted and append bytes up
          to that point. */
-      q = p;
-      while (q < end && *q != '&' && *q != '<' && *q != '>'
-             && *q != '"' && *q != '\'' && *q != '\r'
-             && *q != '\n' && *q != '\t')
-        q++;
+      q = find_escape(p, end, mask);
       svn_stringbuf_appendbytes(*outstr, p, q - p);
 
       /* We may already be a winner.  */
@@ -215,26 +230,34 @@ xml_escape_attr(svn_stringbuf_t **outstr,
 
       /* Append the entity reference for the character.  */
       if (*q == '&')
-        svn_stringbuf_appendcstr(*outstr, "&amp;");
+        svn_stringbuf_appendbytes(*outstr, "&amp;", 5);
       else if (*q == '<')
-        svn_stringbuf_appendcstr(*outstr, "&lt;");
+        svn_stringbuf_appendbytes(*outstr, "&lt;", 4);
       else if (*q == '>')
-        svn_stringbuf_appendcstr(*outstr, "&gt;");
+        svn_stringbuf_appendbytes(*outstr, "&gt;", 4);
       else if (*q == '"')
-        svn_stringbuf_appendcstr(*outstr, "&quot;");
+        svn_stringbuf_appendbytes(*outstr, "&quot;", 6);
       else if (*q == '\'')
-        svn_stringbuf_appendcstr(*outstr, "&apos;");
+        svn_stringbuf_appendbytes(*outstr, "&apos;", 6);
       else if (*q == '\r')
-        svn_stringbuf_appendcstr(*outstr, "&#13;");
+        svn_stringbuf_appendbytes(*outstr, "&#13;", 5);
       else if (*q == '\n')
-        svn_stringbuf_appendcstr(*outstr, "&#10;");
+        svn_stringbuf_appendbytes(*outstr, "&#10;", 5);
       else if (*q == '\t')
-        svn_stringbuf_appendcstr(*outstr, "&#9;");
+        svn_stringbuf_appendbytes(*outstr, "&#9;", 4);
 
       p = q + 1;
     }
 }
 
+/* Escape character data, see xml_escape(). */
+#define xml_escape_cdata(outstr, data, len, pool) \
+  xml_escape((outstr), (data), (len), ESCAPE_IN_CDATA, (pool))
+
+/* Escape an attribute value, see xml_escape(). */
+#define xml_escape_attr(outstr, data, len, pool) \
+  xml_escape((outstr), (data), (len), ESCAPE_IN_ATTR, (pool))
+
 
 void
 svn_xml_escape_cdata_stringbuf(svn_stringbuf_t **outstr,
@@ -668,6 +691,32 @@ svn_xml_hash_atts_preserving(const char **atts,
 /*** Making XML tags. ***/
 
 
+/* Append the attribute NAME with the unescaped VALUE to *STR. */
+static void
+append_attribute(svn_stringbuf_t **str,
+                 const char *name,
+                 const char *value,
+                 apr_pool_t *pool)
+{
+  svn_stringbuf_appendbytes(*str, "\n   ", 4);
+  svn_stringbuf_appendcstr(*str, name);
+  svn_stringbuf_appendbytes(*str, "=\"", 2);
+  xml_escape_attr(str, value, strlen(value), pool);
+  svn_stringbuf_appendbyte(*str, '"');
+}
+
+/* Append the end of an open tag of style STYLE to *STR. */
+static void
+finish_open_tag(svn_stringbuf_t **str,
+                enum svn_xml_open_tag_style style)
+{
+  if (style == svn_xml_self_closing)
+    svn_stringbuf_appendbyte(*str, '/');
+  svn_stringbuf_appendbyte(*str, '>');
+  if (style != svn_xml_protect_pcdata)
+    svn_stringbuf_appendbyte(*str, '\n');
+}
+
 void
 svn_xml_make_open_tag_hash(svn_stringbuf_t **str,
                            apr_pool_t *pool,
@@ -681,7 +730,7 @@ svn_xml_make_open_tag_hash(svn_stringbuf_t **str,
   if (*str == NULL)
     *str = svn_stringbuf_create_ensure(est_size, pool);
 
-  svn_stringbuf_appendcstr(*str, "<");
+  svn_stringbuf_appendbyte(*str, '<');
   svn_stringbuf_appendcstr(*str, tagname);
 
   for (hi = apr_hash_first(pool, attributes); hi; hi = apr_hash_next(hi))
@@ -692,18 +741,10 @@ svn_xml_make_open_tag_hash(svn_stringbuf_t **str,
       apr_hash_this(hi, &key, NULL, &val);
       assert(val != NULL);
 
-      svn_stringbuf_appendcstr(*str, "\n   ");
-      svn_stringbuf_appendcstr(*str, key);
-      svn_stringbuf_appendcstr(*str, "=\"");
-      svn_xml_escape_attr_cstring(str, val, pool);
-      svn_stringbuf_appendcstr(*str, "\"");
+      append_attribute(str, key, val, pool);
     }
 
-  if (style == svn_xml_self_closing)
-    svn_stringbuf_appendcstr(*str, "/");
-  svn_stringbuf_appendcstr(*str, ">");
-  if (style != svn_xml_protect_pcdata)
-    svn_stringbuf_appendcstr(*str, "\n");
+  finish_open_tag(str, style);
 }
 
 
@@ -714,11 +755,25 @@ svn_xml_make_open_tag_v(svn_stringbuf_t **str,
                         const char *tagname,
                         va_list ap)
 {
-  apr_pool_t *subpool = svn_pool_create(pool);
-  apr_hash_t *ht = svn_xml_ap_to_hash(ap, subpool);
+  const char *key;
+
+  if (*str == NULL)
+    *str = svn_stringbuf_create_ensure(strlen(tagname) + 64, pool);
+
+  svn_stringbuf_appendbyte(*str, '<');
+  svn_stringbuf_appendcstr(*str, tagname);
+
+  /* Write the attributes in order instead of collecting them in a hash
+     first.  Like svn_xml_ap_to_hash(), skip those without a value. */
+  while ((key = va_arg(ap, char *)) != NULL)
+    {
+      const char *val = va_arg(ap, const char *);
+
+      if (val)
+        append_attribute(str, key, val, pool);
+    }
 
-  svn_xml_make_open_tag_hash(str, pool, style, tagname, ht);
-  svn_pool_destroy(subpool);
+  finish_open_tag(str, style);
 }
 
 
@@ -745,7 +800,7 @@ void svn_xml_make_close_tag(svn_stringbuf_t **str,
   if (*str == NULL)
     *str = svn_stringbuf_create_empty(pool);
 
-  svn_stringbuf_appendcstr(*str, "</");
+  svn_stringbuf_appendbytes(*str, "</", 2);
   svn_stringbuf_appendcstr(*str, tagname);
-  svn_stringbuf_appendcstr(*str, ">\n");
+  svn_stringbuf_appendbytes(*str, ">\n", 2);
 }
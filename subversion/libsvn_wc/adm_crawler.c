@@ -1051,33 +1051,66 @@ open_txdelta_stream(svn_txdelta_stream_t **txdelta_stream_p,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_wc__internal_transmit_text_deltas(svn_stream_t *tempstream,
-                                      const svn_checksum_t **new_text_base_md5_checksum,
-                                      const svn_checksum_t **new_text_base_sha1_checksum,
-                                      svn_wc__db_t *db,
-                                      const char *local_abspath,
-                                      svn_boolean_t fulltext,
-                                      const svn_delta_editor_t *editor,
-                                      void *file_baton,
-                                      apr_pool_t *result_pool,
-                                      apr_pool_t *scratch_pool)
+/* The text transmission of a file, see svn_wc__text_delta_begin(). */
+struct svn_wc__text_delta_t
 {
-  const svn_checksum_t *expected_md5_checksum;  /* recorded MD5 of BASE_S. */
-  svn_checksum_t *verify_checksum;  /* calc'd MD5 of BASE_STREAM */
-  svn_checksum_t *local_md5_checksum;  /* calc'd MD5 of LOCAL_STREAM */
-  svn_checksum_t *local_sha1_checksum;  /* calc'd SHA1 of LOCAL_STREAM */
-  svn_wc__db_install_data_t *install_data = NULL;
-  svn_error_t *err;
-  svn_error_t *err2;
-  svn_stream_t *base_stream;  /* delta source */
-  svn_stream_t *local_stream;  /* delta target: LOCAL_ABSPATH transl. to NF */
+  const char *local_abspath;
+
+  /* Delta source, or an empty stream when sending a fulltext. */
+  svn_stream_t *base_stream;
+
+  /* Delta target: LOCAL_ABSPATH translated to normal form. */
+  svn_stream_t *local_stream;
+
+  /* Recorded MD5 of BASE_STREAM and the one calculated while reading it.
+     Both are NULL when sending a fulltext. */
+  const svn_checksum_t *expected_md5_checksum;
+  svn_checksum_t *verify_checksum;
+
+  /* Checksums of LOCAL_STREAM, calculated while reading it. */
+  svn_checksum_t *local_md5_checksum;
+  svn_checksum_t *local_sha1_checksum;
+
+  /* Installs the new pristine text; NULL if none gets written. */
+  svn_wc__db_install_data_t *install_data;
+
+  /* The delta between BASE_STREAM and LOCAL_STREAM, once started by
+     svn_wc__text_delta_run(), and the windows it has produced so far.
+     The last window in WINDOWS may be NULL, marking the end of the
+     delta. */
+  svn_txdelta_stream_t *txdelta_stream;
+  apr_array_header_t *windows;
+
+  apr_pool_t *pool;
+};
+
+/* Open the streams for sending the text of LOCAL_ABSPATH in DB and return
+ * them in *DELTA, allocated in RESULT_POOL.  If TEMPSTREAM is not NULL,
+ * copy the working file translated to normal form into it.  If
+ * WANT_PRISTINE is set, write it into a new pristine text as well.  Send
+ * a fulltext if FULLTEXT is set.  Use SCRATCH_POOL for temporary
+ * allocations. */
+static svn_error_t *
+open_text_delta(svn_wc__text_delta_t **delta,
+                svn_stream_t *tempstream,
+                svn_boolean_t want_pristine,
+                svn_wc__db_t *db,
+                const char *local_abspath,
+                svn_boolean_t fulltext,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  svn_wc__text_delta_t *td = apr_pcalloc(result_pool, sizeof(*td));
+  svn_stream_t *local_stream;
+
+  td->local_abspath = apr_pstrdup(result_pool, local_abspath);
+  td->pool = result_pool;
 
   /* Translated input */
   SVN_ERR(svn_wc__internal_translated_stream(&local_stream, db,
                                              local_abspath, local_abspath,
                                              SVN_WC_TRANSLATE_TO_NF,
-                                             scratch_pool, scratch_pool));
+                                             result_pool, scratch_pool));
 
   /* If the caller wants a copy of the working file translated to
    * repository-normal form, make the copy by tee-ing the TEMPSTREAM.
@@ -1091,19 +1124,20 @@ svn_wc__internal_transmit_text_deltas(svn_stream_t *tempstream,
          translated contents into the new text base file as we read from it.
          Note that the new text base file will be closed when the new stream
          is closed. */
-      local_stream = copying_stream(local_stream, tempstream, scratch_pool);
+      local_stream = copying_stream(local_stream, tempstream, result_pool);
     }
-  if (new_text_base_sha1_checksum)
+  if (want_pristine)
     {
       svn_stream_t *new_pristine_stream;
 
       SVN_ERR(svn_wc__db_pristine_prepare_install(&new_pristine_stream,
-                                                  &install_data,
-                                                  &local_sha1_checksum, NULL,
-                                                  db, local_abspath,
-                                                  scratch_pool, scratch_pool));
+                                                  &td->install_data,
+                                                  &td->local_sha1_checksum,
+                                                  NULL, db, local_abspath,
+                                                  result_pool,
+                                                  scratch_pool));
       local_stream = copying_stream(local_stream, new_pristine_stream,
-                                    scratch_pool);
+                                    result_pool);
     }
 
   /* If sending a full text is requested, or if there is no pristine text
@@ -1118,63 +1152,80 @@ svn_wc__internal_transmit_text_deltas(svn_stream_t *tempstream,
       /* We will be computing a delta against the pristine contents */
       /* We need the expected checksum to be an MD-5 checksum rather than a
        * SHA-1 because we want to pass it to apply_textdelta(). */
-      SVN_ERR(read_and_checksum_pristine_text(&base_stream,
-                                              &expected_md5_checksum,
-                                              &verify_checksum,
+      SVN_ERR(read_and_checksum_pristine_text(&td->base_stream,
+                                              &td->expected_md5_checksum,
+                                              &td->verify_checksum,
                                               db, local_abspath,
-                                              scratch_pool, scratch_pool));
+                                              result_pool, scratch_pool));
     }
   else
     {
       /* Send a fulltext. */
-      base_stream = svn_stream_empty(scratch_pool);
-      expected_md5_checksum = NULL;
-      verify_checksum = NULL;
+      td->base_stream = svn_stream_empty(result_pool);
     }
 
   /* Arrange the stream to calculate the resulting MD5. */
-  local_stream = svn_stream_checksummed2(local_stream, &local_md5_checksum,
-                                         NULL, svn_checksum_md5, TRUE,
-                                         scratch_pool);
+  td->local_stream = svn_stream_checksummed2(local_stream,
+                                             &td->local_md5_checksum,
+                                             NULL, svn_checksum_md5, TRUE,
+                                             result_pool);
 
-  /* Tell the editor to apply a textdelta stream to the file baton. */
-  {
-    open_txdelta_stream_baton_t baton = { 0 };
-
-    /* apply_textdelta_stream() is working against a base with this checksum */
-    const char *base_digest_hex = NULL;
-
-    if (expected_md5_checksum)
-      /* ### Why '..._display()'?  expected_md5_checksum should never be all-
-       * zero, but if it is, we would want to pass NULL not an all-zero
-       * digest to apply_textdelta_stream(), wouldn't we? */
-      base_digest_hex = svn_checksum_to_cstring_display(expected_md5_checksum,
-                                                        scratch_pool);
-
-    baton.need_reset = FALSE;
-    baton.base_stream = svn_stream_disown(base_stream, scratch_pool);
-    baton.local_stream = svn_stream_disown(local_stream, scratch_pool);
-    err = editor->apply_textdelta_stream(editor, file_baton, base_digest_hex,
-                                         open_txdelta_stream, &baton,
-                                         scratch_pool);
-  }
+  *delta = td;
+  return SVN_NO_ERROR;
+}
+
+/* Return the MD5 of the pristine text of DELTA in hex, allocated in
+ * RESULT_POOL, or NULL when sending a fulltext. */
+static const char *
+base_digest(const svn_wc__text_delta_t *delta,
+            apr_pool_t *result_pool)
+{
+  if (delta->expected_md5_checksum)
+    /* ### Why '..._display()'?  expected_md5_checksum should never be all-
+     * zero, but if it is, we would want to pass NULL not an all-zero
+     * digest to apply_textdelta_stream(), wouldn't we? */
+    return svn_checksum_to_cstring_display(delta->expected_md5_checksum,
+                                           result_pool);
+
+  return NULL;
+}
+
+/* Complete sending the text of DELTA with FILE_BATON of EDITOR.  ERR is
+ * the result of sending the delta itself.  Verify the pristine text,
+ * install the new one if requested and close the file.  Return the new
+ * text's checksums in *NEW_TEXT_BASE_MD5_CHECKSUM and
+ * *NEW_TEXT_BASE_SHA1_CHECKSUM, allocated in RESULT_POOL, if they are not
+ * NULL.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+close_text_delta(const svn_checksum_t **new_text_base_md5_checksum,
+                 const svn_checksum_t **new_text_base_sha1_checksum,
+                 svn_error_t *err,
+                 svn_wc__text_delta_t *delta,
+                 const svn_delta_editor_t *editor,
+                 void *file_baton,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  svn_error_t *err2;
+  const char *local_abspath = delta->local_abspath;
 
   /* Close the two streams to force writing the digest */
-  err2 = svn_stream_close(base_stream);
+  err2 = svn_stream_close(delta->base_stream);
   if (err2)
     {
       /* Set verify_checksum to NULL if svn_stream_close() returns error
          because checksum will be uninitialized in this case. */
-      verify_checksum = NULL;
+      delta->verify_checksum = NULL;
       err = svn_error_compose_create(err, err2);
     }
 
-  err = svn_error_compose_create(err, svn_stream_close(local_stream));
+  err = svn_error_compose_create(err, svn_stream_close(delta->local_stream));
 
   /* If we have an error, it may be caused by a corrupt text base,
      so check the checksum. */
-  if (expected_md5_checksum && verify_checksum
-      && !svn_checksum_match(expected_md5_checksum, verify_checksum))
+  if (delta->expected_md5_checksum && delta->verify_checksum
+      && !svn_checksum_match(delta->expected_md5_checksum,
+                             delta->verify_checksum))
     {
       /* The entry checksum does not match the actual text
          base checksum.  Extreme badness. Of course,
@@ -1189,7 +1240,8 @@ svn_wc__internal_transmit_text_deltas(svn_stream_t *tempstream,
          too, such as `svn diff'.  */
 
       err = svn_error_compose_create(
-              svn_checksum_mismatch_err(expected_md5_checksum, verify_checksum,
+              svn_checksum_mismatch_err(delta->expected_md5_checksum,
+                                        delta->verify_checksum,
                             scratch_pool,
                             _("Checksum mismatch for text base of '%s'"),
                             svn_dirent_local_style(local_abspath,
@@ -1207,26 +1259,174 @@ svn_wc__internal_transmit_text_deltas(svn_stream_t *tempstream,
                                                      scratch_pool)));
 
   if (new_text_base_md5_checksum)
-    *new_text_base_md5_checksum = svn_checksum_dup(local_md5_checksum,
+    *new_text_base_md5_checksum = svn_checksum_dup(delta->local_md5_checksum,
                                                    result_pool);
-  if (new_text_base_sha1_checksum)
+  if (delta->install_data)
     {
-      SVN_ERR(svn_wc__db_pristine_install(install_data,
-                                          local_sha1_checksum,
-                                          local_md5_checksum,
+      SVN_ERR(svn_wc__db_pristine_install(delta->install_data,
+                                          delta->local_sha1_checksum,
+                                          delta->local_md5_checksum,
                                           scratch_pool));
-      *new_text_base_sha1_checksum = svn_checksum_dup(local_sha1_checksum,
-                                                      result_pool);
+      if (new_text_base_sha1_checksum)
+        *new_text_base_sha1_checksum
+          = svn_checksum_dup(delta->local_sha1_checksum, result_pool);
     }
 
   /* Close the file baton, and get outta here. */
   return svn_error_trace(
              editor->close_file(file_baton,
-                                svn_checksum_to_cstring(local_md5_checksum,
-                                                        scratch_pool),
+                                svn_checksum_to_cstring(
+                                  delta->local_md5_checksum,
+                                  scratch_pool),
                                 scratch_pool));
 }
 
+svn_error_t *
+svn_wc__internal_transmit_text_deltas(svn_stream_t *tempstream,
+                                      const svn_checksum_t **new_text_base_md5_checksum,
+                                      const svn_checksum_t **new_text_base_sha1_checksum,
+                                      svn_wc__db_t *db,
+                                      const char *local_abspath,
+                                      svn_boolean_t fulltext,
+                                      const svn_delta_editor_t *editor,
+                                      void *file_baton,
+                                      apr_pool_t *result_pool,
+                                      apr_pool_t *scratch_pool)
+{
+  svn_wc__text_delta_t *delta;
+  open_txdelta_stream_baton_t baton = { 0 };
+  svn_error_t *err;
+
+  SVN_ERR(open_text_delta(&delta, tempstream,
+                          new_text_base_sha1_checksum != NULL,
+                          db, local_abspath, fulltext,
+                          scratch_pool, scratch_pool));
+
+  /* Tell the editor to apply a textdelta stream to the file baton. */
+  baton.need_reset = FALSE;
+  baton.base_stream = svn_stream_disown(delta->base_stream, scratch_pool);
+  baton.local_stream = svn_stream_disown(delta->local_stream, scratch_pool);
+  err = editor->apply_textdelta_stream(editor, file_baton,
+                                       base_digest(delta, scratch_pool),
+                                       open_txdelta_stream, &baton,
+                                       scratch_pool);
+
+  return svn_error_trace(close_text_delta(new_text_base_md5_checksum,
+                                          new_text_base_sha1_checksum,
+                                          err, delta, editor, file_baton,
+                                          result_pool, scratch_pool));
+}
+
+svn_error_t *
+svn_wc__text_delta_begin(svn_wc__text_delta_t **delta,
+                         svn_wc_context_t *wc_ctx,
+                         const char *local_abspath,
+                         svn_boolean_t fulltext,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  SVN_ERR(open_text_delta(delta, NULL, TRUE, wc_ctx->db, local_abspath,
+                          fulltext, result_pool, scratch_pool));
+  (*delta)->windows = apr_array_make(result_pool, 4,
+                                     sizeof(svn_txdelta_window_t *));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__text_delta_run(svn_wc__text_delta_t *delta,
+                       apr_size_t max_size,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *scratch_pool)
+{
+  apr_size_t size = 0;
+  svn_txdelta_window_t *window;
+
+  /* The windows go into DELTA->POOL.  This only reads files. */
+  svn_txdelta2(&delta->txdelta_stream, delta->base_stream,
+               delta->local_stream, FALSE, delta->pool);
+
+  do
+    {
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(svn_txdelta_next_window(&window, delta->txdelta_stream,
+                                      delta->pool));
+      APR_ARRAY_PUSH(delta->windows, svn_txdelta_window_t *) = window;
+
+      if (window)
+        size += window->tview_len;
+    }
+  while (window && size < max_size);
+
+  return SVN_NO_ERROR;
+}
+
+/* Send the windows of DELTA that svn_wc__text_delta_run() has produced
+ * to HANDLER with HANDLER_BATON, followed by the rest of the delta. */
+static svn_error_t *
+send_text_delta(svn_wc__text_delta_t *delta,
+                svn_txdelta_window_handler_t handler,
+                void *handler_baton,
+                apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_txdelta_window_t *window = NULL;
+  int i;
+
+  for (i = 0; i < delta->windows->nelts; i++)
+    {
+      window = APR_ARRAY_IDX(delta->windows, i, svn_txdelta_window_t *);
+      SVN_ERR(handler(window, handler_baton));
+    }
+
+  if (!delta->txdelta_stream)
+    svn_txdelta2(&delta->txdelta_stream, delta->base_stream,
+                 delta->local_stream, FALSE, delta->pool);
+
+  /* Continue where the prefetch stopped, if it did. */
+  if (!delta->windows->nelts || window)
+    {
+      do
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(svn_txdelta_next_window(&window, delta->txdelta_stream,
+                                          iterpool));
+          SVN_ERR(handler(window, handler_baton));
+        }
+      while (window);
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__text_delta_finish(const svn_checksum_t **new_text_base_md5_checksum,
+                          const svn_checksum_t **new_text_base_sha1_checksum,
+                          svn_wc__text_delta_t *delta,
+                          const svn_delta_editor_t *editor,
+                          void *file_baton,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  svn_error_t *err;
+
+  err = editor->apply_textdelta(file_baton, base_digest(delta, scratch_pool),
+                                scratch_pool, &handler, &handler_baton);
+  if (!err)
+    err = send_text_delta(delta, handler, handler_baton, scratch_pool);
+
+  return svn_error_trace(close_text_delta(new_text_base_md5_checksum,
+                                          new_text_base_sha1_checksum,
+                                          err, delta, editor, file_baton,
+                                          result_pool, scratch_pool));
+}
+
 svn_error_t *
 svn_wc_transmit_text_deltas3(const svn_checksum_t **new_text_base_md5_checksum,
                              const svn_checksum_t **new_text_base_sha1_checksum,
@@ -0,0 +1,267 @@
+/*
+ * fsmonitor.c:  asking an external file system monitor what changed
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#include <string.h>
+
+#include <apr_pools.h>
+#include <apr_hash.h>
+#include <apr_signal.h>
+#include <apr_strings.h>
+#include <apr_thread_proc.h>
+
+#include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_string.h"
+
+#include "wc.h"
+#include "adm_files.h"
+#include "fsmonitor.h"
+
+#include "svn_private_config.h"
+
+
+/* Name of the file in the administrative area of the working copy root
+   that keeps the state between walks. */
+#define FSMONITOR_STATE "fsmonitor"
+
+struct svn_wc__fsmonitor_t
+{
+  /* The working copy root and its state file. */
+  const char *wcroot_abspath;
+  const char *state_abspath;
+
+  /* The token the monitor returned for this walk. */
+  const char *token;
+
+  /* Whether the monitor couldn't tell what changed. */
+  svn_boolean_t all_dirty;
+
+  /* Paths that may have changed since the last walk, including those
+     that were kept dirty by it.  const char *local_abspath -> "" */
+  apr_hash_t *dirty;
+
+  /* Files to check again in the next walk.  const char *local_relpath
+     -> "" */
+  apr_hash_t *keep_dirty;
+
+  /* Pool for the members of this struct. */
+  apr_pool_t *pool;
+};
+
+/* Add PATH, relative to the working copy root of MONITOR or absolute
+   and in local style, to the dirty paths of MONITOR. */
+static void
+add_dirty(svn_wc__fsmonitor_t *monitor,
+          const char *path)
+{
+  const char *local_abspath;
+
+  local_abspath = svn_dirent_join(monitor->wcroot_abspath,
+                                  svn_dirent_internal_style(path,
+                                                            monitor->pool),
+                                  monitor->pool);
+  svn_hash_sets(monitor->dirty, local_abspath, "");
+}
+
+/* Run CMD with the WCROOT_ABSPATH and TOKEN arguments and set *OUTPUT to
+   what it printed.  Return an error if it couldn't be run or failed.
+   Allocate *OUTPUT in POOL. */
+static svn_error_t *
+run_monitor(svn_stringbuf_t **output,
+            const char *cmd,
+            const char *wcroot_abspath,
+            const char *token,
+            apr_pool_t *pool)
+{
+  const char *args[4];
+  apr_proc_t proc;
+  apr_file_t *null_handle;
+  svn_stream_t *stream;
+  svn_error_t *err;
+
+  args[0] = cmd;
+  args[1] = svn_dirent_local_style(wcroot_abspath, pool);
+  args[2] = token;
+  args[3] = NULL;
+
+  SVN_ERR(svn_io_file_open(&null_handle, SVN_NULL_DEVICE_NAME,
+                           APR_READ, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_start_cmd3(&proc, wcroot_abspath, cmd, args, NULL,
+                            TRUE /* inherit */,
+                            FALSE, null_handle,
+                            TRUE, NULL,
+                            FALSE, NULL,
+                            pool));
+
+  stream = svn_stream_from_aprfile2(proc.out, FALSE, pool);
+  err = svn_stringbuf_from_stream(output, stream, 0, pool);
+  if (err)
+    {
+      apr_proc_kill(&proc, SIGKILL);
+      return svn_error_compose_create(
+                err, svn_io_wait_for_cmd(&proc, cmd, NULL, NULL, pool));
+    }
+
+  return svn_error_trace(svn_io_wait_for_cmd(&proc, cmd, NULL, NULL, pool));
+}
+
+svn_error_t *
+svn_wc__fsmonitor_query(svn_wc__fsmonitor_t **monitor,
+                        svn_wc__db_t *db,
+                        const char *wri_abspath,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  const char *cmd = svn_wc__db_fsmonitor_cmd(db);
+  svn_wc__fsmonitor_t *fsm;
+  svn_stringbuf_t *state;
+  svn_stringbuf_t *output;
+  apr_array_header_t *lines;
+  const char *old_token = "";
+  svn_error_t *err;
+  int i;
+
+  *monitor = NULL;
+  if (!cmd)
+    return SVN_NO_ERROR;
+
+  fsm = apr_pcalloc(result_pool, sizeof(*fsm));
+  fsm->pool = result_pool;
+  fsm->dirty = apr_hash_make(result_pool);
+  fsm->keep_dirty = apr_hash_make(result_pool);
+  SVN_ERR(svn_wc__db_get_wcroot(&fsm->wcroot_abspath, db, wri_abspath,
+                                result_pool, scratch_pool));
+  fsm->state_abspath = svn_wc__adm_child(fsm->wcroot_abspath,
+                                         FSMONITOR_STATE, result_pool);
+
+  /* Without a usable state everything has to be checked once. */
+  err = svn_stringbuf_from_file2(&state, fsm->state_abspath, scratch_pool);
+  if (err)
+    svn_error_clear(err);
+  else
+    {
+      lines = svn_cstring_split(state->data, "\n", FALSE, scratch_pool);
+      if (lines->nelts > 0)
+        old_token = APR_ARRAY_IDX(lines, 0, const char *);
+      for (i = 1; i < lines->nelts; i++)
+        add_dirty(fsm, APR_ARRAY_IDX(lines, i, const char *));
+    }
+
+  /* A monitor that isn't available must not make status unusable. */
+  err = run_monitor(&output, cmd, fsm->wcroot_abspath, old_token,
+                    scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  lines = svn_cstring_split(output->data, "\r\n", FALSE, scratch_pool);
+  if (lines->nelts == 0)
+    return SVN_NO_ERROR;
+
+  fsm->token = apr_pstrdup(result_pool,
+                           APR_ARRAY_IDX(lines, 0, const char *));
+  fsm->all_dirty = (*old_token == '\0');
+  for (i = 1; i < lines->nelts && !fsm->all_dirty; i++)
+    {
+      const char *path = APR_ARRAY_IDX(lines, i, const char *);
+
+      if (strcmp(path, "/") == 0)
+        fsm->all_dirty = TRUE;
+      else
+        add_dirty(fsm, path);
+    }
+
+  *monitor = fsm;
+  return SVN_NO_ERROR;
+}
+
+const char *
+svn_wc__fsmonitor_wcroot(const svn_wc__fsmonitor_t *monitor)
+{
+  return monitor->wcroot_abspath;
+}
+
+svn_boolean_t
+svn_wc__fsmonitor_is_dirty(const svn_wc__fsmonitor_t *monitor,
+                           const char *local_abspath,
+                           apr_pool_t *scratch_pool)
+{
+  if (monitor->all_dirty)
+    return TRUE;
+
+  /* Monitors may report a directory instead of the files in it. */
+  while (TRUE)
+    {
+      if (svn_hash_gets(monitor->dirty, local_abspath))
+        return TRUE;
+
+      if (!svn_dirent_is_child(monitor->wcroot_abspath, local_abspath,
+                               NULL))
+        return FALSE;
+
+      local_abspath = svn_dirent_dirname(local_abspath, scratch_pool);
+    }
+}
+
+void
+svn_wc__fsmonitor_keep_dirty(svn_wc__fsmonitor_t *monitor,
+                             const char *local_abspath)
+{
+  const char *local_relpath;
+
+  local_relpath = svn_dirent_skip_ancestor(monitor->wcroot_abspath,
+                                           local_abspath);
+  if (local_relpath && *local_relpath)
+    svn_hash_sets(monitor->keep_dirty,
+                  apr_pstrdup(monitor->pool, local_relpath), "");
+}
+
+void
+svn_wc__fsmonitor_save(svn_wc__fsmonitor_t *monitor,
+                       apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *state = svn_stringbuf_create(monitor->token,
+                                                scratch_pool);
+  apr_hash_index_t *hi;
+
+  svn_stringbuf_appendbyte(state, '\n');
+  for (hi = apr_hash_first(scratch_pool, monitor->keep_dirty);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      svn_stringbuf_appendcstr(state, apr_hash_this_key(hi));
+      svn_stringbuf_appendbyte(state, '\n');
+    }
+
+  /* The working copy may be read-only; then the next walk just has to
+     check more. */
+  svn_error_clear(svn_io_write_atomic2(monitor->state_abspath,
+                                      state->data, state->len,
+                                      NULL, FALSE /* flush_to_disk */,
+                                      scratch_pool));
+}
@@ -0,0 +1,98 @@
+/*
+ * fsmonitor.h:  asking an external file system monitor what changed
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#ifndef SVN_LIBSVN_WC_FSMONITOR_H
+#define SVN_LIBSVN_WC_FSMONITOR_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+#include "svn_error.h"
+
+#include "wc_db.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+/* The paths of a working copy that may have changed since the last
+   complete status walk, as reported by the command configured in
+   [working-copy] fsmonitor.
+
+   All other files are known to still match the size and timestamp that
+   were found when the last walk started, so status can skip stat()ing
+   them.  The walk marks the files that did not match their recorded
+   values with svn_wc__fsmonitor_keep_dirty(), so that they are checked
+   again next time even if the monitor doesn't report them.
+
+   The state between walks is kept in the administrative area of the
+   working copy root: the last token of the monitor on the first line,
+   followed by the paths that were kept dirty, one per line.  */
+typedef struct svn_wc__fsmonitor_t svn_wc__fsmonitor_t;
+
+/* Set *MONITOR to the changes reported for the working copy containing
+   WRI_ABSPATH.  Set *MONITOR to NULL if no monitor is configured for DB,
+   or if it failed; the caller should then check all files.
+
+   Allocate *MONITOR in RESULT_POOL, which must outlive the walk, and use
+   SCRATCH_POOL for temporary allocations.  */
+svn_error_t *
+svn_wc__fsmonitor_query(svn_wc__fsmonitor_t **monitor,
+                        svn_wc__db_t *db,
+                        const char *wri_abspath,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool);
+
+/* Return the root of the working copy MONITOR reports changes for. */
+const char *
+svn_wc__fsmonitor_wcroot(const svn_wc__fsmonitor_t *monitor);
+
+/* Return TRUE if LOCAL_ABSPATH or one of its parents may have changed
+   according to MONITOR.  Use SCRATCH_POOL for temporary allocations.  */
+svn_boolean_t
+svn_wc__fsmonitor_is_dirty(const svn_wc__fsmonitor_t *monitor,
+                           const char *local_abspath,
+                           apr_pool_t *scratch_pool);
+
+/* Remember that the file LOCAL_ABSPATH doesn't match its recorded size
+   and timestamp, so the next walk using MONITOR's state checks it.  */
+void
+svn_wc__fsmonitor_keep_dirty(svn_wc__fsmonitor_t *monitor,
+                             const char *local_abspath);
+
+/* Store the state of MONITOR after a complete status walk of its
+   working copy.  Failing to store it is not an error; the next walk
+   will just check all files.  Use SCRATCH_POOL for temporary
+   allocations.  */
+void
+svn_wc__fsmonitor_save(svn_wc__fsmonitor_t *monitor,
+                       apr_pool_t *scratch_pool);
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_WC_FSMONITOR_H */
@@ -792,17 +792,101 @@ merge_file_trivial(svn_skel_t **work_items,
 }
 
 
+/* Create an empty temporary file for the result of merging the contents
+ * of the 'text' file MT->LOCAL_ABSPATH and return its path in
+ * *RESULT_TARGET, allocated in RESULT_POOL.  We want to use a tempfile
+ * with a name that reflects the original, in case this ultimately winds
+ * up in a conflict resolution editor.
+ */
+static svn_error_t *
+create_merge_result(const char **result_target,
+                    const merge_target_t *mt,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  const char *base_name;
+  const char *temp_dir;
+
+  base_name = svn_dirent_basename(mt->local_abspath, scratch_pool);
+  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&temp_dir, mt->db, mt->wri_abspath,
+                                         scratch_pool, scratch_pool));
+  SVN_ERR(svn_io_open_uniquely_named(NULL, result_target,
+                                     temp_dir, base_name, ".tmp",
+                                     svn_io_file_del_none,
+                                     result_pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Merge the contents of the 'text' files at LEFT_ABSPATH, RIGHT_ABSPATH
+ * and DETRANSLATED_TARGET_ABSPATH into the file RESULT_TARGET, using the
+ * external or internal merge as given by MT.  Set *CONTAINS_CONFLICTS to
+ * indicate whether the result contains conflict markers.
+ *
+ * This does not access MT->DB, so it may run in any thread as long as
+ * none of the files get modified concurrently.
+ */
+static svn_error_t *
+merge_text_contents(svn_boolean_t *contains_conflicts,
+                    const char *result_target,
+                    const merge_target_t *mt,
+                    const char *left_abspath,
+                    const char *right_abspath,
+                    const char *left_label,
+                    const char *right_label,
+                    const char *target_label,
+                    const char *detranslated_target_abspath,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *scratch_pool)
+{
+  apr_file_t *result_f;
+
+  SVN_ERR(svn_io_file_open(&result_f, result_target,
+                           APR_WRITE | APR_TRUNCATE | APR_BUFFERED,
+                           APR_OS_DEFAULT, scratch_pool));
+
+  /* Run the external or internal merge, as requested. */
+  if (mt->diff3_cmd)
+      SVN_ERR(do_text_merge_external(contains_conflicts,
+                                     result_f,
+                                     mt->diff3_cmd,
+                                     mt->merge_options,
+                                     detranslated_target_abspath,
+                                     left_abspath,
+                                     right_abspath,
+                                     target_label,
+                                     left_label,
+                                     right_label,
+                                     scratch_pool));
+  else /* Use internal merge. */
+    SVN_ERR(do_text_merge(contains_conflicts,
+                          result_f,
+                          mt->merge_options,
+                          detranslated_target_abspath,
+                          left_abspath,
+                          right_abspath,
+                          target_label,
+                          left_label,
+                          right_label,
+                          cancel_func, cancel_baton,
+                          scratch_pool));
+
+  return svn_error_trace(svn_io_file_close(result_f, scratch_pool));
+}
+
 /* Handle a non-trivial merge of 'text' files.  (Assume that a trivial
- * merge was not possible.)
+ * merge was not possible.)  RESULT_TARGET contains the merged contents
+ * as produced by merge_text_contents() and CONTAINS_CONFLICTS is the
+ * conflict status that it returned.
  *
  * Set *WORK_ITEMS, *CONFLICT_SKEL and *MERGE_OUTCOME according to the
  * result -- to install the merged file, or to indicate a conflict.
  *
- * On successful merge, leave the result in a temporary file and set
- * *WORK_ITEMS to hold work items that will translate and install that
- * file into its proper form and place (unless DRY_RUN) and delete the
- * temporary file (in any case).  Set *MERGE_OUTCOME to 'merged' or
- * 'unchanged'.
+ * On successful merge, set *WORK_ITEMS to hold work items that will
+ * translate and install the result file into its proper form and place
+ * (unless DRY_RUN) and delete the temporary file (in any case).  Set
+ * *MERGE_OUTCOME to 'merged' or 'unchanged'.
  *
  * If a conflict occurs, set *MERGE_OUTCOME to 'conflicted', and (unless
  * DRY_RUN) set *WORK_ITEMS and *CONFLICT_SKEL to record the conflict
@@ -824,61 +908,18 @@ merge_text_file(svn_skel_t **work_items,
                 const char *target_label,
                 svn_boolean_t dry_run,
                 const char *detranslated_target_abspath,
+                svn_boolean_t contains_conflicts,
+                const char *result_target,
                 svn_cancel_func_t cancel_func,
                 void *cancel_baton,
                 apr_pool_t *result_pool,
                 apr_pool_t *scratch_pool)
 {
   apr_pool_t *pool = scratch_pool;  /* ### temporary rename  */
-  svn_boolean_t contains_conflicts;
-  apr_file_t *result_f;
-  const char *result_target;
-  const char *base_name;
-  const char *temp_dir;
   svn_skel_t *work_item;
 
   *work_items = NULL;
 
-  base_name = svn_dirent_basename(mt->local_abspath, scratch_pool);
-
-  /* Open a second temporary file for writing; this is where diff3
-     will write the merged results.  We want to use a tempfile
-     with a name that reflects the original, in case this
-     ultimately winds up in a conflict resolution editor.  */
-  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&temp_dir, mt->db, mt->wri_abspath,
-                                         pool, pool));
-  SVN_ERR(svn_io_open_uniquely_named(&result_f, &result_target,
-                                     temp_dir, base_name, ".tmp",
-                                     svn_io_file_del_none, pool, pool));
-
-  /* Run the external or internal merge, as requested. */
-  if (mt->diff3_cmd)
-      SVN_ERR(do_text_merge_external(&contains_conflicts,
-                                     result_f,
-                                     mt->diff3_cmd,
-                                     mt->merge_options,
-                                     detranslated_target_abspath,
-                                     left_abspath,
-                                     right_abspath,
-                                     target_label,
-                                     left_label,
-                                     right_label,
-                                     pool));
-  else /* Use internal merge. */
-    SVN_ERR(do_text_merge(&contains_conflicts,
-                          result_f,
-                          mt->merge_options,
-                          detranslated_target_abspath,
-                          left_abspath,
-                          right_abspath,
-                          target_label,
-                          left_label,
-                          right_label,
-                          cancel_func, cancel_baton,
-                          pool));
-
-  SVN_ERR(svn_io_file_close(result_f, pool));
-
   /* Determine the MERGE_OUTCOME, and record any conflict. */
   if (contains_conflicts)
     {
@@ -1074,48 +1115,86 @@ merge_binary_file(svn_skel_t **work_items,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_wc__internal_merge(svn_skel_t **work_items,
-                       svn_skel_t **conflict_skel,
-                       enum svn_wc_merge_outcome_t *merge_outcome,
-                       svn_wc__db_t *db,
-                       const char *left_abspath,
-                       const char *right_abspath,
-                       const char *target_abspath,
-                       const char *wri_abspath,
-                       const char *left_label,
-                       const char *right_label,
-                       const char *target_label,
-                       apr_hash_t *old_actual_props,
-                       svn_boolean_t dry_run,
-                       const char *diff3_cmd,
-                       const apr_array_header_t *merge_options,
-                       const apr_array_header_t *prop_diff,
-                       svn_cancel_func_t cancel_func,
-                       void *cancel_baton,
-                       apr_pool_t *result_pool,
-                       apr_pool_t *scratch_pool)
+/* The state of a file merge between begin_merge() and finish_merge(). */
+typedef struct merge_state_t
 {
+  merge_target_t mt;
+
+  const char *left_abspath;
+  const char *right_abspath;
+  const char *left_label;
+  const char *right_label;
+  const char *target_label;
+  svn_boolean_t dry_run;
   const char *detranslated_target_abspath;
+
+  /* The merge outcome and work items so far. */
+  enum svn_wc_merge_outcome_t merge_outcome;
+  svn_skel_t *work_items;
+
+  /* If not NULL, the contents of the 'text' files still need to be
+     merged into this file by merge_text_contents(). */
+  const char *result_target;
+  svn_boolean_t contains_conflicts;
+
+} merge_state_t;
+
+/* Start merging the changes between LEFT_ABSPATH and RIGHT_ABSPATH into
+ * TARGET_ABSPATH and initialize MS accordingly.  The other parameters are
+ * the same as for svn_wc__internal_merge().
+ *
+ * Trivial merges and merges of 'binary' files get handled completely.  For
+ * a non-trivial merge of 'text' files, only create the temporary result
+ * file and set MS->RESULT_TARGET.  In that case, the caller must run
+ * merge_text_contents() before calling finish_merge().
+ *
+ * Allocate everything that MS refers to in RESULT_POOL.
+ */
+static svn_error_t *
+begin_merge(merge_state_t *ms,
+            svn_skel_t **conflict_skel,
+            svn_wc__db_t *db,
+            const char *left_abspath,
+            const char *right_abspath,
+            const char *target_abspath,
+            const char *wri_abspath,
+            const char *left_label,
+            const char *right_label,
+            const char *target_label,
+            apr_hash_t *old_actual_props,
+            svn_boolean_t dry_run,
+            const char *diff3_cmd,
+            const apr_array_header_t *merge_options,
+            const apr_array_header_t *prop_diff,
+            svn_cancel_func_t cancel_func,
+            void *cancel_baton,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
   svn_boolean_t is_binary = FALSE;
   const svn_prop_t *mimeprop;
-  svn_skel_t *work_item;
-  merge_target_t mt;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(left_abspath));
   SVN_ERR_ASSERT(svn_dirent_is_absolute(right_abspath));
   SVN_ERR_ASSERT(svn_dirent_is_absolute(target_abspath));
 
-  *work_items = NULL;
-
   /* Fill the merge target baton */
-  mt.db = db;
-  mt.local_abspath = target_abspath;
-  mt.wri_abspath = wri_abspath;
-  mt.old_actual_props = old_actual_props;
-  mt.prop_diff = prop_diff;
-  mt.diff3_cmd = diff3_cmd;
-  mt.merge_options = merge_options;
+  ms->mt.db = db;
+  ms->mt.local_abspath = target_abspath;
+  ms->mt.wri_abspath = wri_abspath;
+  ms->mt.old_actual_props = old_actual_props;
+  ms->mt.prop_diff = prop_diff;
+  ms->mt.diff3_cmd = diff3_cmd;
+  ms->mt.merge_options = merge_options;
+
+  ms->right_abspath = right_abspath;
+  ms->left_label = left_label;
+  ms->right_label = right_label;
+  ms->target_label = target_label;
+  ms->dry_run = dry_run;
+  ms->work_items = NULL;
+  ms->result_target = NULL;
+  ms->contains_conflicts = FALSE;
 
   /* Decide if the merge target is a text or binary file. */
   if ((mimeprop = get_prop(prop_diff, SVN_PROP_MIME_TYPE))
@@ -1123,31 +1202,33 @@ svn_wc__internal_merge(svn_skel_t **work_items,
     is_binary = svn_mime_type_is_binary(mimeprop->value->data);
   else
     {
-      const char *value = svn_prop_get_value(mt.old_actual_props,
+      const char *value = svn_prop_get_value(old_actual_props,
                                              SVN_PROP_MIME_TYPE);
 
       is_binary = value && svn_mime_type_is_binary(value);
     }
 
-  SVN_ERR(detranslate_wc_file(&detranslated_target_abspath, &mt,
+  SVN_ERR(detranslate_wc_file(&ms->detranslated_target_abspath, &ms->mt,
                               (! is_binary) && diff3_cmd != NULL,
                               target_abspath,
                               cancel_func, cancel_baton,
-                              scratch_pool, scratch_pool));
+                              result_pool, scratch_pool));
 
   /* We cannot depend on the left file to contain the same eols as the
      right file. If the merge target has mods, this will mark the entire
      file as conflicted, so we need to compensate. */
-  SVN_ERR(maybe_update_target_eols(&left_abspath, prop_diff, left_abspath,
+  SVN_ERR(maybe_update_target_eols(&ms->left_abspath, prop_diff,
+                                   left_abspath,
                                    cancel_func, cancel_baton,
-                                   scratch_pool, scratch_pool));
+                                   result_pool, scratch_pool));
 
-  SVN_ERR(merge_file_trivial(work_items, merge_outcome,
-                             left_abspath, right_abspath,
-                             target_abspath, detranslated_target_abspath,
+  SVN_ERR(merge_file_trivial(&ms->work_items, &ms->merge_outcome,
+                             ms->left_abspath, right_abspath,
+                             target_abspath,
+                             ms->detranslated_target_abspath,
                              dry_run, db, cancel_func, cancel_baton,
                              result_pool, scratch_pool));
-  if (*merge_outcome == svn_wc_merge_no_merge)
+  if (ms->merge_outcome == svn_wc_merge_no_merge)
     {
       /* We have a non-trivial merge.  If we classify it as a merge of
        * 'binary' files we'll just raise a conflict, otherwise we'll do
@@ -1155,44 +1236,101 @@ svn_wc__internal_merge(svn_skel_t **work_items,
       if (is_binary)
         {
           /* Raise a text conflict */
-          SVN_ERR(merge_binary_file(work_items,
+          SVN_ERR(merge_binary_file(&ms->work_items,
                                     conflict_skel,
-                                    merge_outcome,
-                                    &mt,
-                                    left_abspath,
+                                    &ms->merge_outcome,
+                                    &ms->mt,
+                                    ms->left_abspath,
                                     right_abspath,
                                     left_label,
                                     right_label,
                                     target_label,
                                     dry_run,
-                                    detranslated_target_abspath,
+                                    ms->detranslated_target_abspath,
                                     result_pool, scratch_pool));
         }
       else
         {
-          SVN_ERR(merge_text_file(work_items,
-                                  conflict_skel,
-                                  merge_outcome,
-                                  &mt,
-                                  left_abspath,
-                                  right_abspath,
-                                  left_label,
-                                  right_label,
-                                  target_label,
-                                  dry_run,
-                                  detranslated_target_abspath,
-                                  cancel_func, cancel_baton,
-                                  result_pool, scratch_pool));
+          SVN_ERR(create_merge_result(&ms->result_target, &ms->mt,
+                                      result_pool, scratch_pool));
         }
     }
 
+  return SVN_NO_ERROR;
+}
+
+/* Merge the contents of the 'text' files for MS, if begin_merge() left
+ * that to be done.  Like merge_text_contents(), this may run in any
+ * thread.
+ */
+static svn_error_t *
+run_merge(merge_state_t *ms,
+          svn_cancel_func_t cancel_func,
+          void *cancel_baton,
+          apr_pool_t *scratch_pool)
+{
+  if (ms->result_target)
+    SVN_ERR(merge_text_contents(&ms->contains_conflicts,
+                                ms->result_target,
+                                &ms->mt,
+                                ms->left_abspath,
+                                ms->right_abspath,
+                                ms->left_label,
+                                ms->right_label,
+                                ms->target_label,
+                                ms->detranslated_target_abspath,
+                                cancel_func, cancel_baton,
+                                scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Complete the merge for MS that has been started by begin_merge() and
+ * run by run_merge().  Set *WORK_ITEMS, *CONFLICT_SKEL and *MERGE_OUTCOME
+ * as documented for svn_wc__internal_merge().
+ */
+static svn_error_t *
+finish_merge(svn_skel_t **work_items,
+             svn_skel_t **conflict_skel,
+             enum svn_wc_merge_outcome_t *merge_outcome,
+             const merge_state_t *ms,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  svn_skel_t *work_item;
+
+  *work_items = ms->work_items;
+  *merge_outcome = ms->merge_outcome;
+
+  if (ms->result_target)
+    {
+      SVN_ERR(merge_text_file(&work_item,
+                              conflict_skel,
+                              merge_outcome,
+                              &ms->mt,
+                              ms->left_abspath,
+                              ms->right_abspath,
+                              ms->left_label,
+                              ms->right_label,
+                              ms->target_label,
+                              ms->dry_run,
+                              ms->detranslated_target_abspath,
+                              ms->contains_conflicts,
+                              ms->result_target,
+                              cancel_func, cancel_baton,
+                              result_pool, scratch_pool));
+      *work_items = svn_wc__wq_merge(*work_items, work_item, result_pool);
+    }
+
   /* Merging is complete.  Regardless of text or binariness, we might
      need to tweak the executable bit on the new working file, and
      possibly make it read-only. */
-  if (! dry_run)
+  if (! ms->dry_run)
     {
-      SVN_ERR(svn_wc__wq_build_sync_file_flags(&work_item, db,
-                                               target_abspath,
+      SVN_ERR(svn_wc__wq_build_sync_file_flags(&work_item, ms->mt.db,
+                                               ms->mt.local_abspath,
                                                result_pool, scratch_pool));
       *work_items = svn_wc__wq_merge(*work_items, work_item, result_pool);
     }
@@ -1200,42 +1338,104 @@ svn_wc__internal_merge(svn_skel_t **work_items,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__internal_merge(svn_skel_t **work_items,
+                       svn_skel_t **conflict_skel,
+                       enum svn_wc_merge_outcome_t *merge_outcome,
+                       svn_wc__db_t *db,
+                       const char *left_abspath,
+                       const char *right_abspath,
+                       const char *target_abspath,
+                       const char *wri_abspath,
+                       const char *left_label,
+                       const char *right_label,
+                       const char *target_label,
+                       apr_hash_t *old_actual_props,
+                       svn_boolean_t dry_run,
+                       const char *diff3_cmd,
+                       const apr_array_header_t *merge_options,
+                       const apr_array_header_t *prop_diff,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  merge_state_t ms;
+
+  SVN_ERR(begin_merge(&ms, conflict_skel, db,
+                      left_abspath, right_abspath, target_abspath,
+                      wri_abspath, left_label, right_label, target_label,
+                      old_actual_props, dry_run, diff3_cmd, merge_options,
+                      prop_diff, cancel_func, cancel_baton,
+                      result_pool, scratch_pool));
+  SVN_ERR(run_merge(&ms, cancel_func, cancel_baton, scratch_pool));
+
+  return svn_error_trace(finish_merge(work_items, conflict_skel,
+                                      merge_outcome, &ms,
+                                      cancel_func, cancel_baton,
+                                      result_pool, scratch_pool));
+}
+
+
+/* The state of a merge into a working file between
+   svn_wc__file_merge_begin() and svn_wc__file_merge_finish(). */
+struct svn_wc__file_merge_t
+{
+  /* FALSE, if the target is not a versioned file that we can merge into.
+     All other members are undefined in that case. */
+  svn_boolean_t mergeable;
+
+  merge_state_t ms;
+  svn_node_kind_t kind;
+  const char *left_abspath;
+  const svn_wc_conflict_version_t *left_version;
+  const svn_wc_conflict_version_t *right_version;
+
+  /* Result of the property merge, if any.  NEW_ACTUAL_PROPS is NULL if
+     properties have not been merged. */
+  enum svn_wc_notify_state_t props_outcome;
+  apr_hash_t *new_actual_props;
+
+  svn_skel_t *conflict_skel;
+};
 
 svn_error_t *
-svn_wc_merge5(enum svn_wc_merge_outcome_t *merge_content_outcome,
-              enum svn_wc_notify_state_t *merge_props_outcome,
-              svn_wc_context_t *wc_ctx,
-              const char *left_abspath,
-              const char *right_abspath,
-              const char *target_abspath,
-              const char *left_label,
-              const char *right_label,
-              const char *target_label,
-              const svn_wc_conflict_version_t *left_version,
-              const svn_wc_conflict_version_t *right_version,
-              svn_boolean_t dry_run,
-              const char *diff3_cmd,
-              const apr_array_header_t *merge_options,
-              apr_hash_t *original_props,
-              const apr_array_header_t *prop_diff,
-              svn_wc_conflict_resolver_func2_t conflict_func,
-              void *conflict_baton,
-              svn_cancel_func_t cancel_func,
-              void *cancel_baton,
-              apr_pool_t *scratch_pool)
+svn_wc__file_merge_begin(svn_wc__file_merge_t **merge,
+                         svn_wc_context_t *wc_ctx,
+                         const char *left_abspath,
+                         const char *right_abspath,
+                         const char *target_abspath,
+                         const char *left_label,
+                         const char *right_label,
+                         const char *target_label,
+                         const svn_wc_conflict_version_t *left_version,
+                         const svn_wc_conflict_version_t *right_version,
+                         svn_boolean_t dry_run,
+                         const char *diff3_cmd,
+                         const apr_array_header_t *merge_options,
+                         apr_hash_t *original_props,
+                         const apr_array_header_t *prop_diff,
+                         svn_boolean_t merge_props,
+                         svn_cancel_func_t cancel_func,
+                         void *cancel_baton,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
 {
   const char *dir_abspath = svn_dirent_dirname(target_abspath, scratch_pool);
-  svn_skel_t *work_items;
-  svn_skel_t *conflict_skel = NULL;
+  svn_wc__file_merge_t *fm = apr_pcalloc(result_pool, sizeof(*fm));
   apr_hash_t *pristine_props = NULL;
   apr_hash_t *old_actual_props;
-  apr_hash_t *new_actual_props = NULL;
-  svn_node_kind_t kind;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(left_abspath));
   SVN_ERR_ASSERT(svn_dirent_is_absolute(right_abspath));
   SVN_ERR_ASSERT(svn_dirent_is_absolute(target_abspath));
 
+  *merge = fm;
+  fm->left_abspath = apr_pstrdup(result_pool, left_abspath);
+  fm->left_version = left_version;
+  fm->right_version = right_version;
+  fm->props_outcome = svn_wc_notify_state_unchanged;
+
   /* Before we do any work, make sure we hold a write lock.  */
   if (!dry_run)
     SVN_ERR(svn_wc__write_check(wc_ctx->db, dir_abspath, scratch_pool));
@@ -1247,20 +1447,18 @@ svn_wc_merge5(enum svn_wc_merge_outcome_t *merge_content_outcome,
     svn_boolean_t props_mod;
     svn_boolean_t conflicted;
 
-    SVN_ERR(svn_wc__db_read_info(&status, &kind, NULL, NULL, NULL, NULL, NULL,
+    SVN_ERR(svn_wc__db_read_info(&status, &fm->kind, NULL, NULL, NULL, NULL,
+                                 NULL, NULL, NULL, NULL, NULL, NULL, NULL,
                                  NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-                                 NULL, NULL, NULL, NULL, NULL, NULL,
                                  &conflicted, NULL, &had_props, &props_mod,
                                  NULL, NULL, NULL,
                                  wc_ctx->db, target_abspath,
                                  scratch_pool, scratch_pool));
 
-    if (kind != svn_node_file || (status != svn_wc__db_status_normal
-                                  && status != svn_wc__db_status_added))
+    if (fm->kind != svn_node_file || (status != svn_wc__db_status_normal
+                                      && status != svn_wc__db_status_added))
       {
-        *merge_content_outcome = svn_wc_merge_no_merge;
-        if (merge_props_outcome)
-          *merge_props_outcome = svn_wc_notify_state_unchanged;
+        fm->mergeable = FALSE;
         return SVN_NO_ERROR;
       }
 
@@ -1289,30 +1487,32 @@ svn_wc_merge5(enum svn_wc_merge_outcome_t *merge_content_outcome,
         /* else: Conflict was resolved by removing markers */
       }
 
-    if (merge_props_outcome && had_props)
+    if (merge_props && had_props)
       {
         SVN_ERR(svn_wc__db_read_pristine_props(&pristine_props,
                                                wc_ctx->db, target_abspath,
-                                               scratch_pool, scratch_pool));
+                                               result_pool, scratch_pool));
       }
-    else if (merge_props_outcome)
-      pristine_props = apr_hash_make(scratch_pool);
+    else if (merge_props)
+      pristine_props = apr_hash_make(result_pool);
 
     if (props_mod)
       {
         SVN_ERR(svn_wc__db_read_props(&old_actual_props,
                                       wc_ctx->db, target_abspath,
-                                      scratch_pool, scratch_pool));
+                                      result_pool, scratch_pool));
       }
     else if (pristine_props)
       old_actual_props = pristine_props;
     else
-      old_actual_props = apr_hash_make(scratch_pool);
+      old_actual_props = apr_hash_make(result_pool);
   }
 
+  fm->mergeable = TRUE;
+
   /* Merge the properties, if requested.  We merge the properties first
    * because the properties can affect the text (EOL style, keywords). */
-  if (merge_props_outcome)
+  if (merge_props)
     {
       int i;
 
@@ -1332,71 +1532,161 @@ svn_wc_merge5(enum svn_wc_merge_outcome_t *merge_content_outcome,
                                                             scratch_pool));
         }
 
-      SVN_ERR(svn_wc__merge_props(&conflict_skel,
-                                  merge_props_outcome,
-                                  &new_actual_props,
+      SVN_ERR(svn_wc__merge_props(&fm->conflict_skel,
+                                  &fm->props_outcome,
+                                  &fm->new_actual_props,
                                   wc_ctx->db, target_abspath,
                                   original_props, pristine_props, old_actual_props,
                                   prop_diff,
-                                  scratch_pool, scratch_pool));
+                                  result_pool, scratch_pool));
     }
 
-  /* Merge the text. */
-  SVN_ERR(svn_wc__internal_merge(&work_items,
-                                 &conflict_skel,
-                                 merge_content_outcome,
-                                 wc_ctx->db,
-                                 left_abspath,
-                                 right_abspath,
-                                 target_abspath,
-                                 target_abspath,
-                                 left_label, right_label, target_label,
-                                 old_actual_props,
-                                 dry_run,
-                                 diff3_cmd,
-                                 merge_options,
-                                 prop_diff,
-                                 cancel_func, cancel_baton,
-                                 scratch_pool, scratch_pool));
+  /* Start merging the text. */
+  return svn_error_trace(begin_merge(&fm->ms,
+                                     &fm->conflict_skel,
+                                     wc_ctx->db,
+                                     left_abspath,
+                                     right_abspath,
+                                     target_abspath,
+                                     target_abspath,
+                                     left_label, right_label, target_label,
+                                     old_actual_props,
+                                     dry_run,
+                                     diff3_cmd,
+                                     merge_options,
+                                     prop_diff,
+                                     cancel_func, cancel_baton,
+                                     result_pool, scratch_pool));
+}
+
+svn_boolean_t
+svn_wc__file_merge_pending(const svn_wc__file_merge_t *merge)
+{
+  return merge->mergeable && merge->ms.result_target != NULL;
+}
+
+/* Copy the file at *ABSPATH to a new temporary file that will be removed
+   when RESULT_POOL gets cleaned up and set *ABSPATH to the new path. */
+static svn_error_t *
+copy_to_temp_file(const char **abspath,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  const char *copy_abspath;
+
+  SVN_ERR(svn_io_open_unique_file3(NULL, &copy_abspath, NULL,
+                                   svn_io_file_del_on_pool_cleanup,
+                                   result_pool, scratch_pool));
+  SVN_ERR(svn_io_copy_file(*abspath, copy_abspath, FALSE, scratch_pool));
+  *abspath = copy_abspath;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__file_merge_detach(svn_wc__file_merge_t *merge,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  if (!svn_wc__file_merge_pending(merge))
+    return SVN_NO_ERROR;
+
+  /* The left side may already be a translated copy of our own. */
+  if (strcmp(merge->ms.left_abspath, merge->left_abspath) == 0)
+    SVN_ERR(copy_to_temp_file(&merge->ms.left_abspath,
+                              result_pool, scratch_pool));
+
+  SVN_ERR(copy_to_temp_file(&merge->ms.right_abspath,
+                            result_pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__file_merge_run(svn_wc__file_merge_t *merge,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *scratch_pool)
+{
+  if (!merge->mergeable)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(run_merge(&merge->ms, cancel_func, cancel_baton,
+                                   scratch_pool));
+}
+
+svn_error_t *
+svn_wc__file_merge_finish(enum svn_wc_merge_outcome_t *merge_content_outcome,
+                          enum svn_wc_notify_state_t *merge_props_outcome,
+                          svn_wc__file_merge_t *merge,
+                          svn_wc_conflict_resolver_func2_t conflict_func,
+                          void *conflict_baton,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *scratch_pool)
+{
+  svn_wc__db_t *db = merge->ms.mt.db;
+  const char *target_abspath = merge->ms.mt.local_abspath;
+  svn_skel_t *work_items;
+
+  if (merge_props_outcome)
+    *merge_props_outcome = merge->props_outcome;
+
+  if (!merge->mergeable)
+    {
+      *merge_content_outcome = svn_wc_merge_no_merge;
+      return SVN_NO_ERROR;
+    }
+
+  /* Finish merging the text. */
+  SVN_ERR(finish_merge(&work_items,
+                       &merge->conflict_skel,
+                       merge_content_outcome,
+                       &merge->ms,
+                       cancel_func, cancel_baton,
+                       scratch_pool, scratch_pool));
 
   /* If this isn't a dry run, then update the DB, run the work, and
    * call the conflict resolver callback.  */
-  if (!dry_run)
+  if (!merge->ms.dry_run)
     {
+      svn_skel_t *conflict_skel = merge->conflict_skel;
+
       if (conflict_skel)
         {
           svn_skel_t *work_item;
 
           SVN_ERR(svn_wc__conflict_skel_set_op_merge(conflict_skel,
-                                                     left_version,
-                                                     right_version,
+                                                     merge->left_version,
+                                                     merge->right_version,
                                                      scratch_pool,
                                                      scratch_pool));
 
           SVN_ERR(svn_wc__conflict_create_markers(&work_item,
-                                                  wc_ctx->db, target_abspath,
+                                                  db, target_abspath,
                                                   conflict_skel,
                                                   scratch_pool, scratch_pool));
 
           work_items = svn_wc__wq_merge(work_items, work_item, scratch_pool);
         }
 
-      if (new_actual_props)
-        SVN_ERR(svn_wc__db_op_set_props(wc_ctx->db, target_abspath,
-                                        new_actual_props,
-                                        svn_wc__has_magic_property(prop_diff),
+      if (merge->new_actual_props)
+        SVN_ERR(svn_wc__db_op_set_props(db, target_abspath,
+                                        merge->new_actual_props,
+                                        svn_wc__has_magic_property(
+                                                      merge->ms.mt.prop_diff),
                                         conflict_skel, work_items,
                                         scratch_pool));
       else if (conflict_skel)
-        SVN_ERR(svn_wc__db_op_mark_conflict(wc_ctx->db, target_abspath,
+        SVN_ERR(svn_wc__db_op_mark_conflict(db, target_abspath,
                                             conflict_skel, work_items,
                                             scratch_pool));
       else if (work_items)
-        SVN_ERR(svn_wc__db_wq_add(wc_ctx->db, target_abspath, work_items,
+        SVN_ERR(svn_wc__db_wq_add(db, target_abspath, work_items,
                                   scratch_pool));
 
       if (work_items)
-        SVN_ERR(svn_wc__wq_run(wc_ctx->db, target_abspath,
+        SVN_ERR(svn_wc__wq_run(db, target_abspath,
                                cancel_func, cancel_baton,
                                scratch_pool));
 
@@ -1405,8 +1695,8 @@ svn_wc_merge5(enum svn_wc_merge_outcome_t *merge_content_outcome,
           svn_boolean_t text_conflicted, prop_conflicted;
 
           SVN_ERR(svn_wc__conflict_invoke_resolver(
-                    wc_ctx->db, target_abspath, kind,
-                    conflict_skel, merge_options,
+                    db, target_abspath, merge->kind,
+                    conflict_skel, merge->ms.mt.merge_options,
                     conflict_func, conflict_baton,
                     cancel_func, cancel_baton,
                     scratch_pool));
@@ -1414,8 +1704,9 @@ svn_wc_merge5(enum svn_wc_merge_outcome_t *merge_content_outcome,
           /* Reset *MERGE_CONTENT_OUTCOME etc. if a conflict was resolved. */
           SVN_ERR(svn_wc__internal_conflicted_p(
                     &text_conflicted, &prop_conflicted, NULL,
-                    wc_ctx->db, target_abspath, scratch_pool));
-          if (*merge_props_outcome == svn_wc_notify_state_conflicted
+                    db, target_abspath, scratch_pool));
+          if (merge_props_outcome
+              && *merge_props_outcome == svn_wc_notify_state_conflicted
               && ! prop_conflicted)
             *merge_props_outcome = svn_wc_notify_state_merged;
           if (*merge_content_outcome == svn_wc_merge_conflict
@@ -1426,3 +1717,52 @@ svn_wc_merge5(enum svn_wc_merge_outcome_t *merge_content_outcome,
 
   return SVN_NO_ERROR;
 }
+
+
+svn_error_t *
+svn_wc_merge5(enum svn_wc_merge_outcome_t *merge_content_outcome,
+              enum svn_wc_notify_state_t *merge_props_outcome,
+              svn_wc_context_t *wc_ctx,
+              const char *left_abspath,
+              const char *right_abspath,
+              const char *target_abspath,
+              const char *left_label,
+              const char *right_label,
+              const char *target_label,
+              const svn_wc_conflict_version_t *left_version,
+              const svn_wc_conflict_version_t *right_version,
+              svn_boolean_t dry_run,
+              const char *diff3_cmd,
+              const apr_array_header_t *merge_options,
+              apr_hash_t *original_props,
+              const apr_array_header_t *prop_diff,
+              svn_wc_conflict_resolver_func2_t conflict_func,
+              void *conflict_baton,
+              svn_cancel_func_t cancel_func,
+              void *cancel_baton,
+              apr_pool_t *scratch_pool)
+{
+  svn_wc__file_merge_t *merge;
+
+  SVN_ERR(svn_wc__file_merge_begin(&merge, wc_ctx,
+                                   left_abspath, right_abspath,
+                                   target_abspath,
+                                   left_label, right_label, target_label,
+                                   left_version, right_version,
+                                   dry_run, diff3_cmd, merge_options,
+                                   original_props, prop_diff,
+                                   merge_props_outcome != NULL,
+                                   cancel_func, cancel_baton,
+                                   scratch_pool, scratch_pool));
+  SVN_ERR(svn_wc__file_merge_run(merge, cancel_func, cancel_baton,
+                                 scratch_pool));
+
+  return svn_error_trace(svn_wc__file_merge_finish(merge_content_outcome,
+                                                   merge_props_outcome,
+                                                   merge,
+                                                   conflict_func,
+                                                   conflict_baton,
+                                                   cancel_func,
+                                                   cancel_baton,
+                                                   scratch_pool));
+}
@@ -28,6 +28,7 @@
 #include <apr_pools.h>
 #include <apr_file_io.h>
 #include <apr_file_info.h>
+#include <apr_strings.h>
 #include <apr_time.h>
 
 #include "svn_pools.h"
@@ -78,83 +79,115 @@
 */
 
 
-/* Set *MODIFIED_P to TRUE if (after translation) VERSIONED_FILE_ABSPATH
- * (of VERSIONED_FILE_SIZE bytes) differs from PRISTINE_STREAM (of
- * PRISTINE_SIZE bytes), else to FALSE if not.
- *
- * If EXACT_COMPARISON is FALSE, translate VERSIONED_FILE_ABSPATH's EOL
- * style and keywords to repository-normal form according to its properties,
- * and compare the result with PRISTINE_STREAM.  If EXACT_COMPARISON is
- * TRUE, translate PRISTINE_STREAM's EOL style and keywords to working-copy
- * form according to VERSIONED_FILE_ABSPATH's properties, and compare the
- * result with VERSIONED_FILE_ABSPATH.
- *
- * HAS_PROPS should be TRUE if the file had properties when it was not
- * modified, otherwise FALSE.
- *
- * PROPS_MOD should be TRUE if the file's properties have been changed,
- * otherwise FALSE.
- *
- * PRISTINE_STREAM will be closed before a successful return.
- *
- * DB is a wc_db; use SCRATCH_POOL for temporary allocation.
- */
-static svn_error_t *
-compare_and_verify(svn_boolean_t *modified_p,
-                   svn_wc__db_t *db,
-                   const char *versioned_file_abspath,
-                   svn_filesize_t versioned_file_size,
-                   svn_stream_t *pristine_stream,
-                   svn_filesize_t pristine_size,
-                   svn_boolean_t has_props,
-                   svn_boolean_t props_mod,
-                   svn_boolean_t exact_comparison,
-                   apr_pool_t *scratch_pool)
+struct svn_wc__text_compare_t
 {
-  svn_boolean_t same;
+  const char *local_abspath;
+  svn_boolean_t exact_comparison;
+
+  /* Set if there is no pristine to compare with, so the text has to be
+     considered modified. */
+  svn_boolean_t no_pristine;
+
+  /* The last-known-unmodified size and timestamp of the working file. */
+  svn_filesize_t recorded_size;
+  apr_time_t recorded_mod_time;
+
+  /* The pristine text and its size. */
+  const char *pristine_abspath;
+  svn_filesize_t pristine_size;
+
+  /* How to translate between the working file and the pristine. */
+  svn_boolean_t need_translation;
+  svn_boolean_t special;
   svn_subst_eol_style_t eol_style;
   const char *eol_str;
   apr_hash_t *keywords;
-  svn_boolean_t special = FALSE;
-  svn_boolean_t need_translation;
-  svn_stream_t *v_stream; /* versioned_file */
 
-  SVN_ERR_ASSERT(svn_dirent_is_absolute(versioned_file_abspath));
+  /* The working file as last seen by svn_wc__text_compare_run() and
+     whether that had to compare its contents. */
+  const svn_io_dirent2_t *dirent;
+  svn_boolean_t compared;
+};
+
+/* Read the location and size of the pristine text with CHECKSUM of
+ * COMPARE->LOCAL_ABSPATH, as well as the translation to apply, from DB
+ * into COMPARE.  HAS_PROPS and PROPS_MOD tell whether the node has
+ * pristine properties and local property modifications, respectively.
+ *
+ * Allocate the results in RESULT_POOL and use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+read_compare_info(svn_wc__text_compare_t *compare,
+                  svn_wc__db_t *db,
+                  const svn_checksum_t *checksum,
+                  svn_boolean_t has_props,
+                  svn_boolean_t props_mod,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  SVN_ERR(svn_wc__db_pristine_read(NULL, &compare->pristine_size,
+                                   db, compare->local_abspath, checksum,
+                                   scratch_pool, scratch_pool));
+  SVN_ERR(svn_wc__db_pristine_get_path(&compare->pristine_abspath,
+                                       db, compare->local_abspath, checksum,
+                                       result_pool, scratch_pool));
 
   if (props_mod)
     has_props = TRUE; /* Maybe it didn't have properties; but it has now */
 
   if (has_props)
     {
-      SVN_ERR(svn_wc__get_translate_info(&eol_style, &eol_str,
-                                         &keywords,
-                                         &special,
-                                         db, versioned_file_abspath, NULL,
-                                         !exact_comparison,
-                                         scratch_pool, scratch_pool));
-
-      need_translation = svn_subst_translation_required(eol_style, eol_str,
-                                                        keywords, special,
-                                                        TRUE);
+      SVN_ERR(svn_wc__get_translate_info(&compare->eol_style,
+                                         &compare->eol_str,
+                                         &compare->keywords,
+                                         &compare->special,
+                                         db, compare->local_abspath, NULL,
+                                         !compare->exact_comparison,
+                                         result_pool, scratch_pool));
+
+      compare->need_translation
+        = svn_subst_translation_required(compare->eol_style,
+                                         compare->eol_str,
+                                         compare->keywords,
+                                         compare->special, TRUE);
     }
   else
-    need_translation = FALSE;
+    compare->need_translation = FALSE;
 
-  if (! need_translation
-      && (versioned_file_size != pristine_size))
-    {
-      *modified_p = TRUE;
+  return SVN_NO_ERROR;
+}
 
-      /* ### Why did we open the pristine? */
-      return svn_error_trace(svn_stream_close(pristine_stream));
-    }
+/* Set *MODIFIED_P to TRUE if (after translation) the working file
+ * described by COMPARE (of VERSIONED_FILE_SIZE bytes) differs from
+ * PRISTINE_STREAM, else to FALSE if not.
+ *
+ * If COMPARE->EXACT_COMPARISON is FALSE, translate the working file's EOL
+ * style and keywords to repository-normal form according to its
+ * properties, and compare the result with PRISTINE_STREAM.  If it is
+ * TRUE, translate PRISTINE_STREAM's EOL style and keywords to working-copy
+ * form according to the working file's properties, and compare the result
+ * with the working file.
+ *
+ * Use SCRATCH_POOL for temporary allocation.
+ */
+static svn_error_t *
+compare_and_verify(svn_boolean_t *modified_p,
+                   const svn_wc__text_compare_t *compare,
+                   svn_filesize_t versioned_file_size,
+                   svn_stream_t *pristine_stream,
+                   apr_pool_t *scratch_pool)
+{
+  svn_boolean_t same;
+  const char *eol_str = compare->eol_str;
+  svn_stream_t *v_stream; /* versioned_file */
 
-  /* ### Other checks possible? */
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(compare->local_abspath));
 
   /* Reading files is necessary. */
-  if (special && need_translation)
+  if (compare->special && compare->need_translation)
     {
-      SVN_ERR(svn_subst_read_specialfile(&v_stream, versioned_file_abspath,
+      SVN_ERR(svn_subst_read_specialfile(&v_stream, compare->local_abspath,
                                           scratch_pool, scratch_pool));
     }
   else
@@ -162,18 +195,18 @@ compare_and_verify(svn_boolean_t *modified_p,
       /* We don't use APR-level buffering because the comparison function
        * will do its own buffering. */
       apr_file_t *file;
-      SVN_ERR(svn_io_file_open(&file, versioned_file_abspath, APR_READ,
+      SVN_ERR(svn_io_file_open(&file, compare->local_abspath, APR_READ,
                                APR_OS_DEFAULT, scratch_pool));
       v_stream = svn_stream_from_aprfile2(file, FALSE, scratch_pool);
 
-      if (need_translation)
+      if (compare->need_translation)
         {
-          if (!exact_comparison)
+          if (!compare->exact_comparison)
             {
-              if (eol_style == svn_subst_eol_style_native)
+              if (compare->eol_style == svn_subst_eol_style_native)
                 eol_str = SVN_SUBST_NATIVE_EOL_STR;
-              else if (eol_style != svn_subst_eol_style_fixed
-                       && eol_style != svn_subst_eol_style_none)
+              else if (compare->eol_style != svn_subst_eol_style_fixed
+                       && compare->eol_style != svn_subst_eol_style_none)
                 return svn_error_create(SVN_ERR_IO_UNKNOWN_EOL,
                                         svn_stream_close(v_stream), NULL);
 
@@ -182,7 +215,7 @@ compare_and_verify(svn_boolean_t *modified_p,
               v_stream = svn_subst_stream_translated(v_stream,
                                                      eol_str,
                                                      TRUE /* repair */,
-                                                     keywords,
+                                                     compare->keywords,
                                                      FALSE /* expand */,
                                                      scratch_pool);
             }
@@ -192,7 +225,8 @@ compare_and_verify(svn_boolean_t *modified_p,
                * arrange to throw an error if its EOL style is inconsistent. */
               pristine_stream = svn_subst_stream_translated(pristine_stream,
                                                             eol_str, FALSE,
-                                                            keywords, TRUE,
+                                                            compare->keywords,
+                                                            TRUE,
                                                             scratch_pool);
             }
         }
@@ -206,6 +240,126 @@ compare_and_verify(svn_boolean_t *modified_p,
   return SVN_NO_ERROR;
 }
 
+/* Set *MODIFIED_P to TRUE if the working file described by COMPARE, of
+ * which DIRENT is the current state, differs from its pristine text.
+ * This does not access the working copy database.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+static svn_error_t *
+compare_file(svn_boolean_t *modified_p,
+             const svn_wc__text_compare_t *compare,
+             const svn_io_dirent2_t *dirent,
+             apr_pool_t *scratch_pool)
+{
+  svn_stream_t *pristine_stream;
+  apr_file_t *file;
+  svn_error_t *err;
+
+  if (! compare->need_translation
+      && (dirent->filesize != compare->pristine_size))
+    {
+      *modified_p = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  /* We also don't enable APR_BUFFERED on this file to maximize throughput
+   * of the fulltext comparison. */
+  SVN_ERR(svn_io_file_open(&file, compare->pristine_abspath, APR_READ,
+                           APR_OS_DEFAULT, scratch_pool));
+  pristine_stream = svn_stream_from_aprfile2(file, FALSE, scratch_pool);
+
+  /* Check all bytes, and verify checksum if requested. */
+  err = compare_and_verify(modified_p, compare, dirent->filesize,
+                           pristine_stream, scratch_pool);
+
+  /* At this point we already opened the pristine file, so we know that
+     the access denied applies to the working copy path */
+  if (err && APR_STATUS_IS_EACCES(err->apr_err))
+    return svn_error_create(SVN_ERR_WC_PATH_ACCESS_DENIED, err, NULL);
+  else
+    SVN_ERR(err);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *MODIFIED_P to FALSE if the heuristic of a non-exact comparison
+ * allows to consider the working file of DIRENT unmodified, given its
+ * RECORDED_SIZE and RECORDED_MOD_TIME, else set it to TRUE.
+ */
+static void
+maybe_modified(svn_boolean_t *modified_p,
+               const svn_io_dirent2_t *dirent,
+               svn_filesize_t recorded_size,
+               apr_time_t recorded_mod_time)
+{
+  /* We're allowed to use a heuristic to determine whether files may
+     have changed.  The heuristic has these steps:
+
+     1. Compare the working file's size
+        with the size cached in the entries file
+     2. If they differ, do a full file compare
+     3. Compare the working file's timestamp
+        with the timestamp cached in the entries file
+     4. If they differ, do a full file compare
+     5. Otherwise, return indicating an unchanged file.
+
+     There are 2 problematic situations which may occur:
+
+     1. The cached working size is missing
+     --> In this case, we forget we ever tried to compare
+         and skip to the timestamp comparison.  This is
+         because old working copies do not contain cached sizes
+
+     2. The cached timestamp is missing
+     --> In this case, we forget we ever tried to compare
+         and skip to full file comparison.  This is because
+         the timestamp will be removed when the library
+         updates a locally changed file.  (ie, this only happens
+         when the file was locally modified.)
+
+  */
+
+  /* Compare the sizes, if applicable */
+  if (recorded_size != SVN_INVALID_FILESIZE
+      && dirent->filesize != recorded_size)
+    *modified_p = TRUE;
+
+  /* Compare the timestamps
+
+     Note: recorded_mod_time == 0 means not available,
+           which also means the timestamps won't be equal,
+           so there's no need to explicitly check the 'absent' value. */
+  else if (recorded_mod_time != dirent->mtime)
+    *modified_p = TRUE;
+
+  else
+    *modified_p = FALSE;
+}
+
+/* If a write lock is held on LOCAL_ABSPATH in DB, record DIRENT as the
+ * last-known-unmodified state of the file.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+static svn_error_t *
+repair_timestamp(svn_wc__db_t *db,
+                 const char *local_abspath,
+                 const svn_io_dirent2_t *dirent,
+                 apr_pool_t *scratch_pool)
+{
+  svn_boolean_t own_lock;
+
+  /* The timestamp is missing or "broken" so "repair" it if we can. */
+  SVN_ERR(svn_wc__db_wclock_owns_lock(&own_lock, db, local_abspath, FALSE,
+                                      scratch_pool));
+  if (own_lock)
+    SVN_ERR(svn_wc__db_global_record_fileinfo(db, local_abspath,
+                                              dirent->filesize,
+                                              dirent->mtime,
+                                              scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
                                  svn_wc__db_t *db,
@@ -213,22 +367,23 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
                                  svn_boolean_t exact_comparison,
                                  apr_pool_t *scratch_pool)
 {
-  svn_stream_t *pristine_stream;
-  svn_filesize_t pristine_size;
+  svn_wc__text_compare_t compare = { 0 };
   svn_wc__db_status_t status;
   svn_node_kind_t kind;
   const svn_checksum_t *checksum;
-  svn_filesize_t recorded_size;
-  apr_time_t recorded_mod_time;
   svn_boolean_t has_props;
   svn_boolean_t props_mod;
   const svn_io_dirent2_t *dirent;
 
+  compare.local_abspath = local_abspath;
+  compare.exact_comparison = exact_comparison;
+
   /* Read the relevant info */
   SVN_ERR(svn_wc__db_read_info(&status, &kind, NULL, NULL, NULL, NULL, NULL,
                                NULL, NULL, NULL, &checksum, NULL, NULL, NULL,
                                NULL, NULL, NULL,
-                               &recorded_size, &recorded_mod_time,
+                               &compare.recorded_size,
+                               &compare.recorded_mod_time,
                                NULL, NULL, NULL, &has_props, &props_mod,
                                NULL, NULL, NULL,
                                db, local_abspath,
@@ -257,88 +412,114 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
 
   if (! exact_comparison)
     {
-      /* We're allowed to use a heuristic to determine whether files may
-         have changed.  The heuristic has these steps:
-
-         1. Compare the working file's size
-            with the size cached in the entries file
-         2. If they differ, do a full file compare
-         3. Compare the working file's timestamp
-            with the timestamp cached in the entries file
-         4. If they differ, do a full file compare
-         5. Otherwise, return indicating an unchanged file.
-
-         There are 2 problematic situations which may occur:
-
-         1. The cached working size is missing
-         --> In this case, we forget we ever tried to compare
-             and skip to the timestamp comparison.  This is
-             because old working copies do not contain cached sizes
-
-         2. The cached timestamp is missing
-         --> In this case, we forget we ever tried to compare
-             and skip to full file comparison.  This is because
-             the timestamp will be removed when the library
-             updates a locally changed file.  (ie, this only happens
-             when the file was locally modified.)
-
-      */
-
-      /* Compare the sizes, if applicable */
-      if (recorded_size != SVN_INVALID_FILESIZE
-          && dirent->filesize != recorded_size)
-        goto compare_them;
-
-      /* Compare the timestamps
-
-         Note: recorded_mod_time == 0 means not available,
-               which also means the timestamps won't be equal,
-               so there's no need to explicitly check the 'absent' value. */
-      if (recorded_mod_time != dirent->mtime)
-        goto compare_them;
+      maybe_modified(modified_p, dirent, compare.recorded_size,
+                     compare.recorded_mod_time);
+      if (! *modified_p)
+        return SVN_NO_ERROR;
+    }
 
-      *modified_p = FALSE;
+  SVN_ERR(read_compare_info(&compare, db, checksum, has_props, props_mod,
+                            scratch_pool, scratch_pool));
+  SVN_ERR(compare_file(modified_p, &compare, dirent, scratch_pool));
+
+  if (!*modified_p)
+    SVN_ERR(repair_timestamp(db, local_abspath, dirent, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__text_compare_prepare(svn_wc__text_compare_t **compare,
+                             svn_wc__db_t *db,
+                             const char *local_abspath,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  svn_wc__text_compare_t *tc = apr_pcalloc(result_pool, sizeof(*tc));
+  svn_wc__db_status_t status;
+  svn_node_kind_t kind;
+  const svn_checksum_t *checksum;
+  svn_boolean_t has_props;
+  svn_boolean_t props_mod;
+
+  tc->local_abspath = apr_pstrdup(result_pool, local_abspath);
+  tc->exact_comparison = FALSE;
+  *compare = tc;
+
+  SVN_ERR(svn_wc__db_read_info(&status, &kind, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, &checksum, NULL, NULL, NULL,
+                               NULL, NULL, NULL,
+                               &tc->recorded_size, &tc->recorded_mod_time,
+                               NULL, NULL, NULL, &has_props, &props_mod,
+                               NULL, NULL, NULL,
+                               db, local_abspath,
+                               scratch_pool, scratch_pool));
+
+  /* Same as in svn_wc__internal_file_modified_p() */
+  if (!checksum
+      || (kind != svn_node_file)
+      || ((status != svn_wc__db_status_normal)
+          && (status != svn_wc__db_status_added)))
+    {
+      tc->no_pristine = TRUE;
       return SVN_NO_ERROR;
     }
 
- compare_them:
-  SVN_ERR(svn_wc__db_pristine_read(&pristine_stream, &pristine_size,
-                                   db, local_abspath, checksum,
-                                   scratch_pool, scratch_pool));
+  return svn_error_trace(read_compare_info(tc, db, checksum,
+                                           has_props, props_mod,
+                                           result_pool, scratch_pool));
+}
 
-  /* Check all bytes, and verify checksum if requested. */
-  {
-    svn_error_t *err;
-    err = compare_and_verify(modified_p, db,
-                             local_abspath, dirent->filesize,
-                             pristine_stream, pristine_size,
-                             has_props, props_mod,
-                             exact_comparison,
-                             scratch_pool);
-
-    /* At this point we already opened the pristine file, so we know that
-       the access denied applies to the working copy path */
-    if (err && APR_STATUS_IS_EACCES(err->apr_err))
-      return svn_error_create(SVN_ERR_WC_PATH_ACCESS_DENIED, err, NULL);
-    else
-      SVN_ERR(err);
-  }
+svn_error_t *
+svn_wc__text_compare_run(svn_boolean_t *modified_p,
+                         svn_wc__text_compare_t *compare,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  const svn_io_dirent2_t *dirent;
 
-  if (!*modified_p)
+  compare->dirent = NULL;
+  compare->compared = FALSE;
+  if (compare->no_pristine)
     {
-      svn_boolean_t own_lock;
+      *modified_p = TRUE;
+      return SVN_NO_ERROR;
+    }
 
-      /* The timestamp is missing or "broken" so "repair" it if we can. */
-      SVN_ERR(svn_wc__db_wclock_owns_lock(&own_lock, db, local_abspath, FALSE,
-                                          scratch_pool));
-      if (own_lock)
-        SVN_ERR(svn_wc__db_global_record_fileinfo(db, local_abspath,
-                                                  dirent->filesize,
-                                                  dirent->mtime,
-                                                  scratch_pool));
+  SVN_ERR(svn_io_stat_dirent2(&dirent, compare->local_abspath, FALSE, TRUE,
+                              result_pool, scratch_pool));
+
+  if (dirent->kind != svn_node_file)
+    {
+      /* There is no file on disk, so the text is missing, not modified. */
+      *modified_p = FALSE;
+      return SVN_NO_ERROR;
     }
 
-  return SVN_NO_ERROR;
+  compare->dirent = dirent;
+
+  maybe_modified(modified_p, dirent, compare->recorded_size,
+                 compare->recorded_mod_time);
+  if (! *modified_p)
+    return SVN_NO_ERROR;
+
+  compare->compared = TRUE;
+  return svn_error_trace(compare_file(modified_p, compare, dirent,
+                                      scratch_pool));
+}
+
+svn_error_t *
+svn_wc__text_compare_finish(svn_wc__db_t *db,
+                            const svn_wc__text_compare_t *compare,
+                            svn_boolean_t modified,
+                            apr_pool_t *scratch_pool)
+{
+  /* Only repair what has actually been compared. */
+  if (modified || !compare->compared)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(repair_timestamp(db, compare->local_abspath,
+                                          compare->dirent, scratch_pool));
 }
 
 
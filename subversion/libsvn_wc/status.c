@@ -46,11 +46,13 @@
 
 #include "wc.h"
 #include "props.h"
+#include "fsmonitor.h"
 
 #include "private/svn_sorts_private.h"
 #include "private/svn_wc_private.h"
 #include "private/svn_fspath.h"
 #include "private/svn_editor.h"
+#include "private/svn_task.h"
 
 
 /* The file internal variant of svn_wc_status3_t, with slightly more
@@ -100,6 +102,19 @@ struct walk_status_baton
 
   /* Repository locks, if set. */
   apr_hash_t *repos_locks;
+
+  /*** Concurrent text comparison ***/
+  /* Number of threads to compare file contents with. */
+  int threads;
+
+  /* Results of comparing the files of the current directory ahead of
+     time (const char *local_abspath -> svn_boolean_t *), or NULL. */
+  apr_hash_t *text_mods;
+
+  /*** File system monitor ***/
+  /* The paths that may have changed since the last walk, or NULL to
+     check all files. */
+  svn_wc__fsmonitor_t *monitor;
 };
 
 /*** Editor batons ***/
@@ -333,6 +348,10 @@ internal_status(svn_wc__internal_status_t **status,
    returned to reflect that assumption. If CHECK_WORKING_COPY is FALSE,
    do not adjust the result for missing working copy files.
 
+   If TEXT_MODIFIED is not NULL, it is the result of comparing the text of
+   LOCAL_ABSPATH with its pristine ahead of time; use it instead of doing
+   the comparison again.
+
    The status struct's repos_lock field will be set to REPOS_LOCK.
 */
 static svn_error_t *
@@ -347,6 +366,7 @@ assemble_status(svn_wc__internal_status_t **status,
                 svn_boolean_t get_all,
                 svn_boolean_t ignore_text_mods,
                 svn_boolean_t check_working_copy,
+                const svn_boolean_t *text_modified,
                 const svn_lock_t *repos_lock,
                 apr_pool_t *result_pool,
                 apr_pool_t *scratch_pool)
@@ -468,6 +488,8 @@ assemble_status(svn_wc__internal_status_t **status,
                      && info->recorded_size == dirent->filesize
                      && info->recorded_time == dirent->mtime))
             text_modified_p = FALSE;
+          else if (text_modified)
+            text_modified_p = *text_modified;
           else
             {
               svn_error_t *err;
@@ -831,6 +853,9 @@ send_status_structure(const struct walk_status_baton *wb,
                           parent_repos_uuid,
                           info, dirent, get_all,
                           wb->ignore_text_mods, wb->check_working_copy,
+                          wb->text_mods
+                            ? svn_hash_gets(wb->text_mods, local_abspath)
+                            : NULL,
                           repos_lock, scratch_pool, scratch_pool));
 
   if (statstruct && status_func)
@@ -1188,6 +1213,246 @@ one_child_status(const struct walk_status_baton *wb,
   return SVN_NO_ERROR;
 }
 
+/* Files of a directory whose texts are compared concurrently. */
+typedef struct text_compare_batch_t
+{
+  svn_wc__db_t *db;
+
+  /* The files (const char *) and what has been prepared for comparing
+     them (svn_wc__text_compare_t *). */
+  apr_array_header_t *paths;
+  apr_array_header_t *compares;
+
+  /* Where to put the results (const char * -> svn_boolean_t *). */
+  apr_hash_t *results;
+  apr_pool_t *result_pool;
+} text_compare_batch_t;
+
+/* Compare the file with the given INDEX in the text_compare_batch_t
+ * PROCESS_BATON with its pristine and return a svn_boolean_t * in
+ * *RESULT.  If that fails for any reason but an access denied, set
+ * *RESULT to NULL to make assemble_status() repeat the comparison and
+ * report the error in order.
+ * Implements svn_task__process_func_t. */
+static svn_error_t *
+compare_text(void **result,
+             int index,
+             void *process_baton,
+             void *thread_context,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  text_compare_batch_t *batch = process_baton;
+  svn_wc__text_compare_t *compare
+    = APR_ARRAY_IDX(batch->compares, index, svn_wc__text_compare_t *);
+  svn_boolean_t *modified = apr_palloc(result_pool, sizeof(*modified));
+  svn_error_t *err;
+
+  if (cancel_func)
+    SVN_ERR(cancel_func(cancel_baton));
+
+  err = svn_wc__text_compare_run(modified, compare, result_pool,
+                                 scratch_pool);
+  if (err)
+    {
+      /* Same as in assemble_status() */
+      if (err->apr_err == SVN_ERR_WC_PATH_ACCESS_DENIED)
+        *modified = TRUE;
+      else
+        modified = NULL;
+
+      svn_error_clear(err);
+    }
+
+  *result = modified;
+  return SVN_NO_ERROR;
+}
+
+/* Store the svn_boolean_t * RESULT for the file with the given INDEX in
+ * the text_compare_batch_t OUTPUT_BATON.
+ * Implements svn_task__output_func_t. */
+static svn_error_t *
+store_text_compare(void *result,
+                   int index,
+                   void *output_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *scratch_pool)
+{
+  text_compare_batch_t *batch = output_baton;
+  const svn_boolean_t *modified = result;
+
+  if (modified)
+    {
+      SVN_ERR(svn_wc__text_compare_finish(
+                batch->db,
+                APR_ARRAY_IDX(batch->compares, index,
+                              svn_wc__text_compare_t *),
+                *modified, scratch_pool));
+
+      svn_hash_sets(batch->results,
+                    APR_ARRAY_IDX(batch->paths, index, const char *),
+                    apr_pmemdup(batch->result_pool, modified,
+                                sizeof(*modified)));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Compare the texts of those files of the directory LOCAL_ABSPATH that
+   assemble_status() would have to compare, using WB->THREADS threads.
+   NODES and DIRENTS are the directory's children as read by
+   get_dir_status().  Return the results in *TEXT_MODS (const char *
+   local_abspath -> svn_boolean_t *), allocated in RESULT_POOL, or NULL
+   if it is not worth the effort.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+compare_texts_ahead(apr_hash_t **text_mods,
+                    const struct walk_status_baton *wb,
+                    const char *local_abspath,
+                    apr_hash_t *nodes,
+                    apr_hash_t *dirents,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  text_compare_batch_t batch;
+  apr_hash_index_t *hi;
+  svn_error_t *err;
+
+  batch.db = wb->db;
+  batch.paths = apr_array_make(scratch_pool, 16, sizeof(const char *));
+  batch.compares = apr_array_make(scratch_pool, 16,
+                                  sizeof(svn_wc__text_compare_t *));
+  batch.results = apr_hash_make(result_pool);
+  batch.result_pool = result_pool;
+
+  for (hi = apr_hash_first(scratch_pool, nodes); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const struct svn_wc__db_info_t *info = apr_hash_this_val(hi);
+      const svn_io_dirent2_t *dirent = svn_hash_gets(dirents, name);
+      svn_wc__text_compare_t *compare;
+      const char *child_abspath;
+
+      /* Only plain files that don't match their recorded size and
+         timestamp; see assemble_status(). */
+      if (!dirent
+          || dirent->kind != svn_node_file
+          || dirent->special
+          || info->kind != svn_node_file
+          || info->special
+          || info->incomplete
+          || !info->has_checksum
+          || (info->status != svn_wc__db_status_normal
+              && info->status != svn_wc__db_status_added)
+          || (info->recorded_size != SVN_INVALID_FILESIZE
+              && info->recorded_time != 0
+              && info->recorded_size == dirent->filesize
+              && info->recorded_time == dirent->mtime))
+        continue;
+
+      /* Leave any error to assemble_status(), to report it in order. */
+      child_abspath = svn_dirent_join(local_abspath, name, result_pool);
+      err = svn_wc__text_compare_prepare(&compare, wb->db, child_abspath,
+                                         scratch_pool, scratch_pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          continue;
+        }
+
+      APR_ARRAY_PUSH(batch.paths, const char *) = child_abspath;
+      APR_ARRAY_PUSH(batch.compares, svn_wc__text_compare_t *) = compare;
+    }
+
+  if (batch.compares->nelts < 2)
+    {
+      *text_mods = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_task__run(wb->threads, batch.compares->nelts,
+                        compare_text, &batch,
+                        store_text_compare, &batch,
+                        NULL, NULL,
+                        cancel_func, cancel_baton,
+                        scratch_pool));
+
+  *text_mods = batch.results;
+  return SVN_NO_ERROR;
+}
+
+/* Complete the type-only DIRENTS of the versioned files in NODES, the
+   children of the directory LOCAL_ABSPATH, as far as assemble_status()
+   needs them.  Stat the files that MONITOR reports as possibly changed
+   and assume that all others still match their recorded size and
+   timestamp.  Mark the files that don't match as dirty in MONITOR.
+   Allocate the new dirents in RESULT_POOL and use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+apply_fsmonitor(svn_wc__fsmonitor_t *monitor,
+                const char *local_abspath,
+                apr_hash_t *nodes,
+                apr_hash_t *dirents,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(scratch_pool, nodes); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const struct svn_wc__db_info_t *info = apr_hash_this_val(hi);
+      const svn_io_dirent2_t *dirent = svn_hash_gets(dirents, name);
+      const char *child_abspath;
+      svn_io_dirent2_t *file_dirent;
+
+      if (!dirent
+          || dirent->kind != svn_node_file
+          || info->kind != svn_node_file)
+        continue;
+
+      svn_pool_clear(iterpool);
+      child_abspath = svn_dirent_join(local_abspath, name, iterpool);
+
+      if (!dirent->special
+          && !info->special
+          && info->recorded_size != SVN_INVALID_FILESIZE
+          && info->recorded_time != 0
+          && !svn_wc__fsmonitor_is_dirty(monitor, child_abspath, iterpool))
+        {
+          file_dirent = svn_io_dirent2_dup(dirent, result_pool);
+          file_dirent->filesize = info->recorded_size;
+          file_dirent->mtime = info->recorded_time;
+        }
+      else
+        {
+          const svn_io_dirent2_t *stat_dirent;
+
+          SVN_ERR(svn_io_stat_dirent2(&stat_dirent, child_abspath,
+                                      FALSE /* verify_truename */,
+                                      TRUE /* ignore_enoent */,
+                                      result_pool, iterpool));
+          file_dirent = (svn_io_dirent2_t *)stat_dirent;
+
+          if (file_dirent->kind != svn_node_file
+              || file_dirent->filesize != info->recorded_size
+              || file_dirent->mtime != info->recorded_time)
+            svn_wc__fsmonitor_keep_dirty(monitor, child_abspath);
+        }
+
+      svn_hash_sets(dirents, name, file_dirent);
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 /* Send svn_wc_status3_t * structures for the directory LOCAL_ABSPATH and
    for all its child nodes (according to DEPTH) through STATUS_FUNC /
    STATUS_BATON.
@@ -1233,6 +1498,7 @@ get_dir_status(const struct walk_status_baton *wb,
   apr_hash_t *dirents, *nodes, *conflicts, *all_children;
   apr_array_header_t *sorted_children;
   apr_array_header_t *collected_ignore_patterns = NULL;
+  struct walk_status_baton dir_wb;
   apr_pool_t *iterpool;
   svn_error_t *err;
   int i;
@@ -1248,7 +1514,8 @@ get_dir_status(const struct walk_status_baton *wb,
   if (wb->check_working_copy)
     {
       err = svn_io_get_dirents3(&dirents, local_abspath,
-                                wb->ignore_text_mods /* only_check_type*/,
+                                (wb->ignore_text_mods
+                                 || wb->monitor != NULL) /* only_check_type*/,
                                 scratch_pool, iterpool);
       if (err
           && (APR_STATUS_IS_ENOENT(err->apr_err)
@@ -1283,6 +1550,11 @@ get_dir_status(const struct walk_status_baton *wb,
                                         !wb->check_working_copy,
                                         scratch_pool, iterpool));
 
+  /* Only stat the files that may have changed, if a monitor tells us. */
+  if (wb->monitor)
+    SVN_ERR(apply_fsmonitor(wb->monitor, local_abspath, nodes, dirents,
+                            scratch_pool, iterpool));
+
   all_children = apr_hash_overlay(scratch_pool, nodes, dirents);
   if (apr_hash_count(conflicts) > 0)
     all_children = apr_hash_overlay(scratch_pool, conflicts, all_children);
@@ -1336,6 +1608,18 @@ get_dir_status(const struct walk_status_baton *wb,
   if (depth == svn_depth_empty)
     return SVN_NO_ERROR;
 
+  /* Compare the texts of modified files concurrently, if enabled.  Their
+     status is still reported in order below. */
+  if (wb->threads > 1 && wb->check_working_copy && !wb->ignore_text_mods)
+    {
+      dir_wb = *wb;
+      SVN_ERR(compare_texts_ahead(&dir_wb.text_mods, wb, local_abspath,
+                                  nodes, dirents,
+                                  cancel_func, cancel_baton,
+                                  scratch_pool, iterpool));
+      wb = &dir_wb;
+    }
+
   /* Walk all the children of this directory. */
   sorted_children = svn_sort__hash(all_children,
                                    svn_sort_compare_items_lexically,
@@ -2513,6 +2797,9 @@ svn_wc__get_status_editor(const svn_delta_editor_t **editor,
   eb->wb.check_working_copy = check_working_copy;
   eb->wb.repos_locks      = NULL;
   eb->wb.repos_root       = NULL;
+  eb->wb.threads          = svn_wc__db_status_threads(wc_ctx->db);
+  eb->wb.text_mods        = NULL;
+  eb->wb.monitor          = NULL;
 
   SVN_ERR(svn_wc__db_externals_defined_below(&eb->wb.externals,
                                              wc_ctx->db, eb->target_abspath,
@@ -2619,19 +2906,22 @@ stat_wc_dirent_case_sensitive(const svn_io_dirent2_t **dirent,
                                 result_pool, scratch_pool));
 }
 
-svn_error_t *
-svn_wc__internal_walk_status(svn_wc__db_t *db,
-                             const char *local_abspath,
-                             svn_depth_t depth,
-                             svn_boolean_t get_all,
-                             svn_boolean_t no_ignore,
-                             svn_boolean_t ignore_text_mods,
-                             const apr_array_header_t *ignore_patterns,
-                             svn_wc_status_func4_t status_func,
-                             void *status_baton,
-                             svn_cancel_func_t cancel_func,
-                             void *cancel_baton,
-                             apr_pool_t *scratch_pool)
+/* Implement svn_wc__internal_walk_status(), comparing the texts of
+   modified files with THREADS threads. */
+static svn_error_t *
+walk_status(svn_wc__db_t *db,
+            const char *local_abspath,
+            svn_depth_t depth,
+            svn_boolean_t get_all,
+            svn_boolean_t no_ignore,
+            svn_boolean_t ignore_text_mods,
+            const apr_array_header_t *ignore_patterns,
+            int threads,
+            svn_wc_status_func4_t status_func,
+            void *status_baton,
+            svn_cancel_func_t cancel_func,
+            void *cancel_baton,
+            apr_pool_t *scratch_pool)
 {
   struct walk_status_baton wb;
   const svn_io_dirent2_t *dirent;
@@ -2644,6 +2934,9 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
   wb.check_working_copy = TRUE;
   wb.repos_root = NULL;
   wb.repos_locks = NULL;
+  wb.threads = threads;
+  wb.text_mods = NULL;
+  wb.monitor = NULL;
 
   /* Use the caller-provided ignore patterns if provided; the build-time
      configured defaults otherwise. */
@@ -2690,6 +2983,10 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
       && info->status != svn_wc__db_status_excluded
       && info->status != svn_wc__db_status_server_excluded)
     {
+      if (!ignore_text_mods)
+        SVN_ERR(svn_wc__fsmonitor_query(&wb.monitor, db, local_abspath,
+                                        scratch_pool, scratch_pool));
+
       SVN_ERR(get_dir_status(&wb,
                              local_abspath,
                              FALSE /* skip_root */,
@@ -2703,6 +3000,13 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
                              status_func, status_baton,
                              cancel_func, cancel_baton,
                              scratch_pool));
+
+      /* Only a walk of the whole working copy knows all dirty files. */
+      if (wb.monitor
+          && (depth == svn_depth_infinity || depth == svn_depth_unknown)
+          && strcmp(local_abspath,
+                    svn_wc__fsmonitor_wcroot(wb.monitor)) == 0)
+        svn_wc__fsmonitor_save(wb.monitor, scratch_pool);
     }
   else
     {
@@ -2735,6 +3039,54 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__internal_walk_status(svn_wc__db_t *db,
+                             const char *local_abspath,
+                             svn_depth_t depth,
+                             svn_boolean_t get_all,
+                             svn_boolean_t no_ignore,
+                             svn_boolean_t ignore_text_mods,
+                             const apr_array_header_t *ignore_patterns,
+                             svn_wc_status_func4_t status_func,
+                             void *status_baton,
+                             svn_cancel_func_t cancel_func,
+                             void *cancel_baton,
+                             apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(walk_status(db, local_abspath, depth, get_all,
+                                     no_ignore, ignore_text_mods,
+                                     ignore_patterns,
+                                     svn_wc__db_status_threads(db),
+                                     status_func, status_baton,
+                                     cancel_func, cancel_baton,
+                                     scratch_pool));
+}
+
+svn_error_t *
+svn_wc__walk_status_threaded(svn_wc_context_t *wc_ctx,
+                             const char *local_abspath,
+                             svn_depth_t depth,
+                             svn_boolean_t get_all,
+                             svn_boolean_t no_ignore,
+                             svn_boolean_t ignore_text_mods,
+                             const apr_array_header_t *ignore_patterns,
+                             int thread_count,
+                             svn_wc_status_func4_t status_func,
+                             void *status_baton,
+                             svn_cancel_func_t cancel_func,
+                             void *cancel_baton,
+                             apr_pool_t *scratch_pool)
+{
+  int threads = MAX(thread_count, svn_wc__db_status_threads(wc_ctx->db));
+
+  return svn_error_trace(walk_status(wc_ctx->db, local_abspath, depth,
+                                     get_all, no_ignore, ignore_text_mods,
+                                     ignore_patterns, threads,
+                                     status_func, status_baton,
+                                     cancel_func, cancel_baton,
+                                     scratch_pool));
+}
+
 svn_error_t *
 svn_wc_walk_status(svn_wc_context_t *wc_ctx,
                    const char *local_abspath,
@@ -2900,6 +3252,7 @@ internal_status(svn_wc__internal_status_t **status,
                                          dirent,
                                          TRUE /* get_all */,
                                          FALSE, check_working_copy,
+                                         NULL /* text_modified */,
                                          NULL /* repos_lock */,
                                          result_pool, scratch_pool));
 }
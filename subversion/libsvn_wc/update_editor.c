@@ -2795,7 +2795,9 @@ close_directory(void *dir_baton,
         }
 
       /* Update the BASE data for the directory and mark the directory
-         complete */
+         complete, together with the changes of its files */
+      SVN_ERR(svn_wc__db_batch_begin(eb->db, eb->wcroot_abspath,
+                                     scratch_pool));
       SVN_ERR(svn_wc__db_base_add_directory(
                 eb->db, db->local_abspath,
                 eb->wcroot_abspath,
@@ -4558,6 +4560,10 @@ close_file(void *file_baton,
         svn_hash_sets(eb->wcroot_iprops, fb->local_abspath, NULL);
     }
 
+  /* Group the changes of the files of a directory; close_directory()
+     commits them when it runs the work queue. */
+  SVN_ERR(svn_wc__db_batch_begin(eb->db, eb->wcroot_abspath, scratch_pool));
+
   SVN_ERR(svn_wc__db_base_add_file(eb->db, fb->local_abspath,
                                    eb->wcroot_abspath,
                                    fb->new_repos_relpath,
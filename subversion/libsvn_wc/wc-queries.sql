@@ -883,6 +883,9 @@ SELECT id, work FROM work_queue ORDER BY id LIMIT 1
 -- STMT_DELETE_WORK_ITEM
 DELETE FROM work_queue WHERE id = ?1
 
+-- STMT_SELECT_WORK_ITEMS_AFTER
+SELECT id, work FROM work_queue WHERE id > ?1 ORDER BY id LIMIT ?2
+
 -- STMT_INSERT_OR_IGNORE_PRISTINE
 INSERT OR IGNORE INTO pristine (checksum, md5_checksum, size, refcount)
 VALUES (?1, ?2, ?3, 0)
@@ -1302,6 +1305,12 @@ PRAGMA locking_mode = exclusive;
    exclusive-locking is mostly used on remote file systems. */
 PRAGMA journal_mode = DELETE
 
+-- STMT_PRAGMA_JOURNAL_MODE_WAL
+PRAGMA journal_mode = WAL
+
+-- STMT_PRAGMA_JOURNAL_MODE_TRUNCATE
+PRAGMA journal_mode = TRUNCATE
+
 -- STMT_FIND_REPOS_PATH_IN_WC
 SELECT local_relpath FROM nodes_current
   WHERE wc_id = ?1 AND repos_path = ?2
@@ -1609,6 +1618,70 @@ WHERE wc_id = ?1
   AND repos_path IS NOT RELPATH_SKIP_JOIN(?2, ?3, local_relpath)
 LIMIT 1
 
+/* Remember what svn_wc__db_revision_status() found until the next change
+   to the tables it looks at.  The table and its triggers are created when
+   first needed; older clients that don't know the table still fire the
+   triggers, so they never see a stale row either. */
+-- STMT_CREATE_REVISION_STATUS_CACHE
+CREATE TABLE IF NOT EXISTS revision_status_cache (
+  wc_id  INTEGER NOT NULL,
+  local_relpath  TEXT NOT NULL,
+  trail_url  TEXT NOT NULL,
+  committed  INTEGER NOT NULL,
+  min_revision  INTEGER,
+  max_revision  INTEGER,
+  sparse_checkout  INTEGER NOT NULL,
+  modified  INTEGER NOT NULL,
+  switched  INTEGER NOT NULL,
+  PRIMARY KEY (wc_id, local_relpath, trail_url, committed)
+  );
+CREATE TRIGGER IF NOT EXISTS revision_status_cache_nodes_insert
+AFTER INSERT ON nodes
+BEGIN
+  DELETE FROM revision_status_cache;
+END;
+CREATE TRIGGER IF NOT EXISTS revision_status_cache_nodes_update
+AFTER UPDATE ON nodes
+BEGIN
+  DELETE FROM revision_status_cache;
+END;
+CREATE TRIGGER IF NOT EXISTS revision_status_cache_nodes_delete
+AFTER DELETE ON nodes
+BEGIN
+  DELETE FROM revision_status_cache;
+END;
+CREATE TRIGGER IF NOT EXISTS revision_status_cache_actual_insert
+AFTER INSERT ON actual_node
+BEGIN
+  DELETE FROM revision_status_cache;
+END;
+CREATE TRIGGER IF NOT EXISTS revision_status_cache_actual_update
+AFTER UPDATE ON actual_node
+BEGIN
+  DELETE FROM revision_status_cache;
+END;
+CREATE TRIGGER IF NOT EXISTS revision_status_cache_actual_delete
+AFTER DELETE ON actual_node
+BEGIN
+  DELETE FROM revision_status_cache;
+END;
+CREATE TRIGGER IF NOT EXISTS revision_status_cache_repository_update
+AFTER UPDATE ON repository
+BEGIN
+  DELETE FROM revision_status_cache;
+END
+
+-- STMT_SELECT_REVISION_STATUS_CACHE
+SELECT min_revision, max_revision, sparse_checkout, modified, switched
+FROM revision_status_cache
+WHERE wc_id = ?1 AND local_relpath = ?2 AND trail_url = ?3 AND committed = ?4
+
+-- STMT_INSERT_REVISION_STATUS_CACHE
+INSERT OR REPLACE INTO revision_status_cache (
+  wc_id, local_relpath, trail_url, committed, min_revision, max_revision,
+  sparse_checkout, modified, switched)
+VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9)
+
 -- STMT_SELECT_MOVED_FROM_RELPATH
 SELECT local_relpath, op_depth FROM nodes
 WHERE wc_id = ?1 AND moved_to = ?2 AND op_depth > 0
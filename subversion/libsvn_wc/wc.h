@@ -350,6 +350,43 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
                                  svn_boolean_t exact_comparison,
                                  apr_pool_t *scratch_pool);
 
+/* The non-exact svn_wc__internal_file_modified_p() check, split into
+ * parts so that the file contents can be compared in another thread.
+ */
+typedef struct svn_wc__text_compare_t svn_wc__text_compare_t;
+
+/* Read everything from DB that is needed to check LOCAL_ABSPATH for text
+ * modifications and return it in *COMPARE, allocated in RESULT_POOL.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_wc__text_compare_prepare(svn_wc__text_compare_t **compare,
+                             svn_wc__db_t *db,
+                             const char *local_abspath,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool);
+
+/* Set *MODIFIED_P like svn_wc__internal_file_modified_p() would for the
+ * file of COMPARE.  This does not access the working copy database and
+ * may be called from any thread.  Allocate the state kept in COMPARE in
+ * RESULT_POOL and use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_wc__text_compare_run(svn_boolean_t *modified_p,
+                         svn_wc__text_compare_t *compare,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool);
+
+/* Do the timestamp repair of svn_wc__internal_file_modified_p() in DB
+ * for COMPARE, which has been found to be MODIFIED or not.  Use
+ * SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_wc__text_compare_finish(svn_wc__db_t *db,
+                            const svn_wc__text_compare_t *compare,
+                            svn_boolean_t modified,
+                            apr_pool_t *scratch_pool);
+
 
 /* Prepare to merge a file content change into the working copy.
 
@@ -1432,12 +1432,13 @@ create_db(svn_sqlite__db_t **sdb,
           svn_depth_t root_node_depth,
           svn_boolean_t exclusive,
           apr_int32_t timeout,
+          svn_tristate_t wal,
           apr_pool_t *result_pool,
           apr_pool_t *scratch_pool)
 {
   SVN_ERR(svn_wc__db_util_open_db(sdb, dir_abspath, sdb_fname,
                                   svn_sqlite__mode_rwcreate, exclusive,
-                                  timeout,
+                                  timeout, wal,
                                   NULL /* my_statements */,
                                   result_pool, scratch_pool));
 
@@ -1487,7 +1488,7 @@ svn_wc__db_init(svn_wc__db_t *db,
   SVN_ERR(create_db(&sdb, &repos_id, &wc_id, local_abspath, repos_root_url,
                     repos_uuid, SDB_FILE,
                     repos_relpath, initial_rev, depth, sqlite_exclusive,
-                    sqlite_timeout,
+                    sqlite_timeout, db->wal,
                     db->state_pool, scratch_pool));
 
   /* Create the WCROOT for this directory.  */
@@ -9571,6 +9572,30 @@ read_children_info(svn_wc__db_wcroot_t *wcroot,
   return SVN_NO_ERROR;
 }
 
+/* Set *CACHE to the node cache of WCROOT if DB is configured to use one
+   and it can be used for the next read, and to NULL otherwise. */
+static svn_error_t *
+get_node_cache(svn_wc__db_cache_t **cache,
+               svn_wc__db_t *db,
+               svn_wc__db_wcroot_t *wcroot)
+{
+  svn_boolean_t usable;
+
+  *cache = NULL;
+  if (db->node_cache_size == 0)
+    return SVN_NO_ERROR;
+
+  if (!wcroot->node_cache)
+    wcroot->node_cache = svn_wc__db_cache_create(db->node_cache_size,
+                                                 db->state_pool);
+
+  SVN_ERR(svn_wc__db_cache_check(&usable, wcroot->node_cache, wcroot->sdb));
+  if (usable)
+    *cache = wcroot->node_cache;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_wc__db_read_children_info(apr_hash_t **nodes,
                               apr_hash_t **conflicts,
@@ -9582,9 +9607,8 @@ svn_wc__db_read_children_info(apr_hash_t **nodes,
 {
   svn_wc__db_wcroot_t *wcroot;
   const char *dir_relpath;
+  svn_wc__db_cache_t *cache;
 
-  *conflicts = apr_hash_make(result_pool);
-  *nodes = apr_hash_make(result_pool);
   SVN_ERR_ASSERT(svn_dirent_is_absolute(dir_abspath));
 
   SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &dir_relpath, db,
@@ -9592,11 +9616,24 @@ svn_wc__db_read_children_info(apr_hash_t **nodes,
                                                 scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
+  SVN_ERR(get_node_cache(&cache, db, wcroot));
+  if (cache && svn_wc__db_cache_get_children(nodes, conflicts, cache,
+                                             dir_relpath, base_tree_only,
+                                             result_pool, scratch_pool))
+    return SVN_NO_ERROR;
+
+  *conflicts = apr_hash_make(result_pool);
+  *nodes = apr_hash_make(result_pool);
+
   SVN_WC__DB_WITH_TXN(
     read_children_info(wcroot, dir_relpath, *conflicts, *nodes,
                        base_tree_only, result_pool, scratch_pool),
     wcroot);
 
+  if (cache)
+    svn_wc__db_cache_set_children(cache, dir_relpath, base_tree_only,
+                                  *nodes, *conflicts);
+
   return SVN_NO_ERROR;
 }
 
@@ -9783,6 +9820,7 @@ svn_wc__db_read_single_info(const struct svn_wc__db_info_t **info,
 {
   svn_wc__db_wcroot_t *wcroot;
   const char *local_relpath;
+  svn_wc__db_cache_t *cache;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
 
@@ -9791,11 +9829,20 @@ svn_wc__db_read_single_info(const struct svn_wc__db_info_t **info,
                                                 scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
+  SVN_ERR(get_node_cache(&cache, db, wcroot));
+  if (cache && svn_wc__db_cache_get_info(info, cache, local_relpath,
+                                         base_tree_only,
+                                         result_pool, scratch_pool))
+    return SVN_NO_ERROR;
+
   SVN_WC__DB_WITH_TXN(read_single_info(info, wcroot, local_relpath,
                                        base_tree_only,
                                        result_pool, scratch_pool),
                       wcroot);
 
+  if (cache)
+    svn_wc__db_cache_set_info(cache, local_relpath, base_tree_only, *info);
+
   return SVN_NO_ERROR;
 }
 
@@ -10451,6 +10498,7 @@ svn_wc__db_read_props(apr_hash_t **props,
 {
   svn_wc__db_wcroot_t *wcroot;
   const char *local_relpath;
+  svn_wc__db_cache_t *cache;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
 
@@ -10458,12 +10506,20 @@ svn_wc__db_read_props(apr_hash_t **props,
                               local_abspath, scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
+  SVN_ERR(get_node_cache(&cache, db, wcroot));
+  if (cache && svn_wc__db_cache_get_props(props, cache, local_relpath,
+                                          result_pool))
+    return SVN_NO_ERROR;
+
   SVN_WC__DB_WITH_TXN(svn_wc__db_read_props_internal(props, wcroot,
                                                      local_relpath,
                                                      result_pool,
                                                      scratch_pool),
                       wcroot);
 
+  if (cache)
+    svn_wc__db_cache_set_props(cache, local_relpath, *props);
+
   return SVN_NO_ERROR;
 }
 
@@ -13334,6 +13390,7 @@ svn_wc__db_upgrade_begin(svn_sqlite__db_t **sdb,
                     NULL, SVN_INVALID_REVNUM, svn_depth_unknown,
                     TRUE /* exclusive */,
                     0 /* timeout */,
+                    svn_tristate_unknown /* wal */,
                     wc_db->state_pool, scratch_pool));
 
   SVN_ERR(svn_wc__db_pdh_create_wcroot(&wcroot,
@@ -13596,6 +13653,167 @@ svn_wc__db_wq_record_and_fetch_next(apr_uint64_t *id,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__db_wq_fetch_following(apr_array_header_t **work_items,
+                              svn_wc__db_t *db,
+                              const char *wri_abspath,
+                              apr_uint64_t after_id,
+                              int max_items,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  *work_items = apr_array_make(result_pool, max_items,
+                               sizeof(svn_wc__db_wq_item_t *));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_WORK_ITEMS_AFTER));
+  SVN_ERR(svn_sqlite__bindf(stmt, "id", (apr_int64_t)after_id, max_items));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+
+  while (have_row)
+    {
+      svn_wc__db_wq_item_t *item = apr_palloc(result_pool, sizeof(*item));
+      apr_size_t len;
+      const void *val;
+
+      item->id = svn_sqlite__column_int64(stmt, 0);
+      val = svn_sqlite__column_blob(stmt, 1, &len, result_pool);
+      item->work_item = svn_skel__parse(val, len, result_pool);
+
+      APR_ARRAY_PUSH(*work_items, svn_wc__db_wq_item_t *) = item;
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* The body of svn_wc__db_wq_record_and_complete(). */
+static svn_error_t *
+wq_complete(svn_wc__db_wcroot_t *wcroot,
+            const apr_array_header_t *completed_ids,
+            apr_pool_t *scratch_pool)
+{
+  int i;
+
+  for (i = 0; i < completed_ids->nelts; i++)
+    {
+      svn_sqlite__stmt_t *stmt;
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                        STMT_DELETE_WORK_ITEM));
+      SVN_ERR(svn_sqlite__bind_int64(stmt, 1,
+                                     APR_ARRAY_IDX(completed_ids, i,
+                                                   apr_uint64_t)));
+      SVN_ERR(svn_sqlite__step_done(stmt));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_wq_record_and_complete(svn_wc__db_t *db,
+                                  const char *wri_abspath,
+                                  const apr_array_header_t *completed_ids,
+                                  apr_hash_t *record_map,
+                                  apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  SVN_WC__DB_WITH_TXN(
+    svn_error_compose_create(
+            wq_complete(wcroot, completed_ids, scratch_pool),
+            record_map ? wq_record(wcroot, record_map, scratch_pool)
+                       : SVN_NO_ERROR),
+    wcroot);
+
+  return SVN_NO_ERROR;
+}
+
+int
+svn_wc__db_wq_install_threads(svn_wc__db_t *db)
+{
+  return db->install_threads;
+}
+
+svn_error_t *
+svn_wc__db_batch_begin(svn_wc__db_t *db,
+                       const char *wri_abspath,
+                       apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  if (wcroot->batch_open)
+    return SVN_NO_ERROR;
+
+  /* Take the 'RESERVED' lock right away, so that the pristine store can
+     nest its transactions in this one. */
+  SVN_ERR(svn_sqlite__begin_immediate_transaction(wcroot->sdb));
+  wcroot->batch_open = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_batch_end(svn_wc__db_t *db,
+                     const char *wri_abspath,
+                     apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  return svn_error_trace(svn_wc__db_util_end_batch(wcroot));
+}
+
+int
+svn_wc__db_status_threads(svn_wc__db_t *db)
+{
+  return db->status_threads;
+}
+
+int
+svn_wc__db_cleanup_threads(svn_wc__db_t *db)
+{
+  return db->cleanup_threads;
+}
+
+const char *
+svn_wc__db_fsmonitor_cmd(svn_wc__db_t *db)
+{
+  return db->fsmonitor_cmd;
+}
+
 
 
 /* ### temporary API. remove before release.  */
@@ -15679,7 +15897,9 @@ svn_wc__db_has_db_mods(svn_boolean_t *is_modified,
 }
 
 
-/* The body of svn_wc__db_revision_status().
+/* The body of svn_wc__db_revision_status().  If USE_CACHE is TRUE, look
+ * for the answer in the revision_status_cache table first, and remember
+ * it there otherwise.
  */
 static svn_error_t *
 revision_status_txn(svn_revnum_t *min_revision,
@@ -15692,10 +15912,33 @@ revision_status_txn(svn_revnum_t *min_revision,
                     svn_wc__db_t *db,
                     const char *trail_url,
                     svn_boolean_t committed,
+                    svn_boolean_t use_cache,
                     apr_pool_t *scratch_pool)
 {
   svn_error_t *err;
   svn_boolean_t exists;
+  svn_sqlite__stmt_t *stmt;
+
+  if (use_cache)
+    {
+      svn_boolean_t have_row;
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                        STMT_SELECT_REVISION_STATUS_CACHE));
+      SVN_ERR(svn_sqlite__bindf(stmt, "issd", wcroot->wc_id, local_relpath,
+                                trail_url ? trail_url : "", committed));
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+      if (have_row)
+        {
+          *min_revision = svn_sqlite__column_revnum(stmt, 0);
+          *max_revision = svn_sqlite__column_revnum(stmt, 1);
+          *is_sparse_checkout = svn_sqlite__column_boolean(stmt, 2);
+          *is_modified = svn_sqlite__column_boolean(stmt, 3);
+          *is_switched = svn_sqlite__column_boolean(stmt, 4);
+          return svn_error_trace(svn_sqlite__reset(stmt));
+        }
+      SVN_ERR(svn_sqlite__reset(stmt));
+    }
 
   SVN_ERR(does_node_exist(&exists, wcroot, local_relpath));
 
@@ -15733,6 +15976,21 @@ revision_status_txn(svn_revnum_t *min_revision,
   /* Check for db mods. */
   SVN_ERR(has_db_mods(is_modified, wcroot, local_relpath, scratch_pool));
 
+  if (use_cache)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                        STMT_INSERT_REVISION_STATUS_CACHE));
+      SVN_ERR(svn_sqlite__bindf(stmt, "isdrrddd", wcroot->wc_id,
+                                local_relpath, trail_url ? trail_url : "",
+                                committed, *min_revision, *max_revision,
+                                *is_sparse_checkout, *is_modified,
+                                *is_switched));
+
+      /* Another process may be writing to the database; then this answer
+         is just not remembered. */
+      svn_error_clear(svn_sqlite__insert(NULL, stmt));
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -15751,6 +16009,8 @@ svn_wc__db_revision_status(svn_revnum_t *min_revision,
 {
   svn_wc__db_wcroot_t *wcroot;
   const char *local_relpath;
+  svn_error_t *err;
+  svn_boolean_t use_cache;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
 
@@ -15759,11 +16019,19 @@ svn_wc__db_revision_status(svn_revnum_t *min_revision,
                                                 scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
+  /* Build tools ask this again and again for a working copy that
+     rarely changes in between, so remember the answer in the database
+     itself.  A working copy that can't be written to just doesn't. */
+  err = svn_sqlite__exec_statements(wcroot->sdb,
+                                    STMT_CREATE_REVISION_STATUS_CACHE);
+  use_cache = (err == SVN_NO_ERROR);
+  svn_error_clear(err);
+
   SVN_WC__DB_WITH_TXN(
     revision_status_txn(min_revision, max_revision,
                         is_sparse_checkout, is_modified, is_switched,
                         wcroot, local_relpath, db,
-                        trail_url, committed,
+                        trail_url, committed, use_cache,
                         scratch_pool),
     wcroot);
   return SVN_NO_ERROR;
@@ -16016,6 +16284,7 @@ svn_wc__db_bump_format(int *result_format,
                                 svn_sqlite__mode_readwrite,
                                 TRUE, /* exclusive */
                                 0, /* default timeout */
+                                svn_tristate_unknown, /* wal */
                                 NULL, /* my statements */
                                 scratch_pool, scratch_pool);
   if (err)
@@ -945,6 +945,19 @@ svn_wc__db_pristine_read(svn_stream_t **contents,
                          apr_pool_t *result_pool,
                          apr_pool_t *scratch_pool);
 
+/* Set *CONTENTS to a readable stream of the pristine text identified by
+   SHA1_CHECKSUM in the pristine directory that DB shares with other
+   working copies, or to NULL if there is no such directory or it doesn't
+   contain that text.
+
+   Allocate the stream in RESULT_POOL. */
+svn_error_t *
+svn_wc__db_pristine_read_shared(svn_stream_t **contents,
+                                svn_wc__db_t *db,
+                                const svn_checksum_t *sha1_checksum,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool);
+
 /* Baton for svn_wc__db_pristine_install */
 typedef struct svn_wc__db_install_data_t
                svn_wc__db_install_data_t;
@@ -1040,7 +1053,9 @@ svn_wc__db_pristine_remove(svn_wc__db_t *db,
                            apr_pool_t *scratch_pool);
 
 
-/* Remove all unreferenced pristines in the WC of WRI_ABSPATH in DB. */
+/* Remove all unreferenced pristines in the WC of WRI_ABSPATH in DB, and
+   the texts of the shared pristine directory of DB that no working copy
+   links to anymore. */
 svn_error_t *
 svn_wc__db_pristine_cleanup(svn_wc__db_t *db,
                             const char *wri_abspath,
@@ -3028,6 +3043,77 @@ svn_wc__db_wq_record_and_fetch_next(apr_uint64_t *id,
                                     apr_pool_t *result_pool,
                                     apr_pool_t *scratch_pool);
 
+/* A queued work item, as returned by svn_wc__db_wq_fetch_following(). */
+typedef struct svn_wc__db_wq_item_t
+{
+  apr_uint64_t id;
+  svn_skel_t *work_item;
+} svn_wc__db_wq_item_t;
+
+/* Return in *WORK_ITEMS up to MAX_ITEMS (svn_wc__db_wq_item_t *) items
+   that follow the item AFTER_ID in the work queue for WRI_ABSPATH, in the
+   order they were queued.  None of them is marked as completed.
+
+   RESULT_POOL will be used to allocate *WORK_ITEMS, and SCRATCH_POOL
+   will be used for all temporary allocations.  */
+svn_error_t *
+svn_wc__db_wq_fetch_following(apr_array_header_t **work_items,
+                              svn_wc__db_t *db,
+                              const char *wri_abspath,
+                              apr_uint64_t after_id,
+                              int max_items,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
+/* Mark the wq items COMPLETED_IDS (apr_uint64_t) as completed and, in the
+   same transaction, record the timestamps and sizes in RECORD_MAP, which
+   may be NULL.  */
+svn_error_t *
+svn_wc__db_wq_record_and_complete(svn_wc__db_t *db,
+                                  const char *wri_abspath,
+                                  const apr_array_header_t *completed_ids,
+                                  apr_hash_t *record_map,
+                                  apr_pool_t *scratch_pool);
+
+/* Return the number of threads that the work queue for DB may use to
+   install files concurrently.  */
+int
+svn_wc__db_wq_install_threads(svn_wc__db_t *db);
+
+/* Open a transaction in the working copy of WRI_ABSPATH in DB that the
+   following database changes join, instead of each committing its own,
+   until svn_wc__db_batch_end() is called.  Do nothing if one is already
+   open.
+
+   svn_wc__wq_run() ends the batch before it changes any working file,
+   so a batch that is lost never leaves the working copy inconsistent.  */
+svn_error_t *
+svn_wc__db_batch_begin(svn_wc__db_t *db,
+                       const char *wri_abspath,
+                       apr_pool_t *scratch_pool);
+
+/* Commit the transaction opened by svn_wc__db_batch_begin() in the
+   working copy of WRI_ABSPATH in DB, if any.  */
+svn_error_t *
+svn_wc__db_batch_end(svn_wc__db_t *db,
+                     const char *wri_abspath,
+                     apr_pool_t *scratch_pool);
+
+/* Return the number of threads that status walks using DB may use to
+   compare file contents concurrently.  */
+int
+svn_wc__db_status_threads(svn_wc__db_t *db);
+
+/* Return the number of threads that cleanup and the work queue using DB
+   may use to remove files concurrently.  */
+int
+svn_wc__db_cleanup_threads(svn_wc__db_t *db);
+
+/* Return the command that reports changed paths to status walks using
+   DB, or NULL if none is configured.  */
+const char *
+svn_wc__db_fsmonitor_cmd(svn_wc__db_t *db);
+
 
 /* @} */
 
@@ -3283,6 +3369,9 @@ svn_wc__db_get_not_present_descendants(const apr_array_header_t **descendants,
  * might be changed by a switch.  If it does not match the end of WC_PATH's
  * actual URL, then report a "switched" status.
  *
+ * The answer is remembered in the working copy database until the next
+ * change to it, so asking again is cheap.
+ *
  * See also the functions below which provide a subset of this functionality.
  */
 svn_error_t *
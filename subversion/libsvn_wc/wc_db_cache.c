@@ -0,0 +1,323 @@
+/*
+ * wc_db_cache.c :  remembering recent reads from a working copy database
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#define SVN_WC__I_AM_WC_DB
+
+#include <apr_pools.h>
+#include <apr_hash.h>
+#include <apr_strings.h>
+
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_props.h"
+
+#include "wc.h"
+#include "wc_db.h"
+#include "wc_db_private.h"
+
+#include "private/svn_sqlite.h"
+
+
+/* The cache only hands out copies of what it holds, so it can drop
+   everything at any time without affecting earlier results. */
+struct svn_wc__db_cache_t
+{
+  /* Number of nodes to remember before starting over. */
+  int max_nodes;
+
+  /* Number of nodes in the hashes below. */
+  int nodes;
+
+  /* What svn_sqlite__read_data_version() returned when the hashes below
+     were last known to be up to date. */
+  apr_int64_t data_version;
+  apr_int64_t total_changes;
+
+  /* const char *key -> const struct svn_wc__db_info_t *info, where KEY is
+     the local_relpath, prefixed with "b" for the BASE tree or "w" for the
+     actual node. */
+  apr_hash_t *infos;
+
+  /* const char *key -> children_t *children, with keys as above. */
+  apr_hash_t *children;
+
+  /* const char *local_relpath -> apr_hash_t *props */
+  apr_hash_t *props;
+
+  /* Pool for the hashes and everything in them. */
+  apr_pool_t *pool;
+};
+
+/* The result of svn_wc__db_read_children_info() for one directory. */
+typedef struct children_t
+{
+  apr_hash_t *nodes;
+  apr_hash_t *conflicts;
+} children_t;
+
+
+/* Forget everything in CACHE. */
+static void
+clear_cache(svn_wc__db_cache_t *cache)
+{
+  svn_pool_clear(cache->pool);
+  cache->nodes = 0;
+  cache->infos = apr_hash_make(cache->pool);
+  cache->children = apr_hash_make(cache->pool);
+  cache->props = apr_hash_make(cache->pool);
+}
+
+/* Make room for COUNT more nodes in CACHE. */
+static void
+make_room(svn_wc__db_cache_t *cache,
+          int count)
+{
+  if (cache->nodes + count > cache->max_nodes)
+    clear_cache(cache);
+
+  cache->nodes += count;
+}
+
+/* Return the key for LOCAL_RELPATH and BASE_TREE_ONLY, allocated in
+   RESULT_POOL. */
+static const char *
+make_key(const char *local_relpath,
+         svn_boolean_t base_tree_only,
+         apr_pool_t *result_pool)
+{
+  return apr_pstrcat(result_pool, base_tree_only ? "b" : "w",
+                     local_relpath, SVN_VA_NULL);
+}
+
+/* Return a deep copy of INFO, allocated in RESULT_POOL. */
+static struct svn_wc__db_info_t *
+dup_info(const struct svn_wc__db_info_t *info,
+         apr_pool_t *result_pool)
+{
+  struct svn_wc__db_info_t *new_info;
+  struct svn_wc__db_moved_to_info_t **moved_to;
+  const struct svn_wc__db_moved_to_info_t *mt;
+
+  new_info = apr_pmemdup(result_pool, info, sizeof(*info));
+  new_info->repos_relpath = apr_pstrdup(result_pool, info->repos_relpath);
+  new_info->repos_root_url = apr_pstrdup(result_pool, info->repos_root_url);
+  new_info->repos_uuid = apr_pstrdup(result_pool, info->repos_uuid);
+  new_info->changed_author = apr_pstrdup(result_pool, info->changed_author);
+  new_info->changelist = apr_pstrdup(result_pool, info->changelist);
+
+  if (info->lock)
+    {
+      new_info->lock = apr_pmemdup(result_pool, info->lock,
+                                   sizeof(*info->lock));
+      new_info->lock->token = apr_pstrdup(result_pool, info->lock->token);
+      new_info->lock->owner = apr_pstrdup(result_pool, info->lock->owner);
+      new_info->lock->comment = apr_pstrdup(result_pool,
+                                            info->lock->comment);
+    }
+
+  moved_to = &new_info->moved_to;
+  for (mt = info->moved_to; mt; mt = mt->next)
+    {
+      *moved_to = apr_pcalloc(result_pool, sizeof(**moved_to));
+      (*moved_to)->moved_to_abspath = apr_pstrdup(result_pool,
+                                                  mt->moved_to_abspath);
+      (*moved_to)->shadow_op_root_abspath =
+                  apr_pstrdup(result_pool, mt->shadow_op_root_abspath);
+      moved_to = &(*moved_to)->next;
+    }
+  *moved_to = NULL;
+
+  return new_info;
+}
+
+/* Return a deep copy of CHILDREN, allocated in RESULT_POOL. */
+static children_t *
+dup_children(const children_t *children,
+             apr_pool_t *result_pool)
+{
+  children_t *new_children = apr_palloc(result_pool, sizeof(*new_children));
+  apr_hash_index_t *hi;
+
+  new_children->nodes = apr_hash_make(result_pool);
+  for (hi = apr_hash_first(NULL, children->nodes); hi; hi = apr_hash_next(hi))
+    svn_hash_sets(new_children->nodes,
+                  apr_pstrdup(result_pool, apr_hash_this_key(hi)),
+                  dup_info(apr_hash_this_val(hi), result_pool));
+
+  new_children->conflicts = apr_hash_make(result_pool);
+  for (hi = apr_hash_first(NULL, children->conflicts);
+       hi;
+       hi = apr_hash_next(hi))
+    svn_hash_sets(new_children->conflicts,
+                  apr_pstrdup(result_pool, apr_hash_this_key(hi)), "");
+
+  return new_children;
+}
+
+
+svn_wc__db_cache_t *
+svn_wc__db_cache_create(int max_nodes,
+                        apr_pool_t *result_pool)
+{
+  svn_wc__db_cache_t *cache = apr_pcalloc(result_pool, sizeof(*cache));
+
+  cache->max_nodes = max_nodes;
+  cache->data_version = -1;
+  cache->pool = svn_pool_create(result_pool);
+  clear_cache(cache);
+
+  return cache;
+}
+
+svn_error_t *
+svn_wc__db_cache_check(svn_boolean_t *usable,
+                       svn_wc__db_cache_t *cache,
+                       svn_sqlite__db_t *sdb)
+{
+  apr_int64_t data_version;
+  apr_int64_t total_changes;
+
+  SVN_ERR(svn_sqlite__read_data_version(&data_version, &total_changes,
+                                        sdb));
+
+  /* Nothing is remembered while this can't be checked, so what there is
+     stays valid until it can be checked again. */
+  *usable = (data_version != -1);
+  if (!*usable)
+    return SVN_NO_ERROR;
+
+  if (data_version != cache->data_version
+      || total_changes != cache->total_changes)
+    {
+      if (cache->nodes)
+        clear_cache(cache);
+
+      cache->data_version = data_version;
+      cache->total_changes = total_changes;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_boolean_t
+svn_wc__db_cache_get_info(const struct svn_wc__db_info_t **info,
+                          svn_wc__db_cache_t *cache,
+                          const char *local_relpath,
+                          svn_boolean_t base_tree_only,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  const struct svn_wc__db_info_t *cached;
+
+  cached = svn_hash_gets(cache->infos, make_key(local_relpath,
+                                                base_tree_only,
+                                                scratch_pool));
+  if (!cached)
+    return FALSE;
+
+  *info = dup_info(cached, result_pool);
+  return TRUE;
+}
+
+void
+svn_wc__db_cache_set_info(svn_wc__db_cache_t *cache,
+                          const char *local_relpath,
+                          svn_boolean_t base_tree_only,
+                          const struct svn_wc__db_info_t *info)
+{
+  make_room(cache, 1);
+  svn_hash_sets(cache->infos,
+                make_key(local_relpath, base_tree_only, cache->pool),
+                dup_info(info, cache->pool));
+}
+
+svn_boolean_t
+svn_wc__db_cache_get_children(apr_hash_t **nodes,
+                              apr_hash_t **conflicts,
+                              svn_wc__db_cache_t *cache,
+                              const char *dir_relpath,
+                              svn_boolean_t base_tree_only,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  const children_t *cached;
+  children_t *children;
+
+  cached = svn_hash_gets(cache->children, make_key(dir_relpath,
+                                                   base_tree_only,
+                                                   scratch_pool));
+  if (!cached)
+    return FALSE;
+
+  children = dup_children(cached, result_pool);
+  *nodes = children->nodes;
+  *conflicts = children->conflicts;
+  return TRUE;
+}
+
+void
+svn_wc__db_cache_set_children(svn_wc__db_cache_t *cache,
+                              const char *dir_relpath,
+                              svn_boolean_t base_tree_only,
+                              apr_hash_t *nodes,
+                              apr_hash_t *conflicts)
+{
+  children_t children;
+
+  /* Directories bigger than the cache are not worth remembering. */
+  if (apr_hash_count(nodes) >= (unsigned int)cache->max_nodes)
+    return;
+
+  children.nodes = nodes;
+  children.conflicts = conflicts;
+
+  make_room(cache, (int)apr_hash_count(nodes) + 1);
+  svn_hash_sets(cache->children,
+                make_key(dir_relpath, base_tree_only, cache->pool),
+                dup_children(&children, cache->pool));
+}
+
+svn_boolean_t
+svn_wc__db_cache_get_props(apr_hash_t **props,
+                           svn_wc__db_cache_t *cache,
+                           const char *local_relpath,
+                           apr_pool_t *result_pool)
+{
+  apr_hash_t *cached = svn_hash_gets(cache->props, local_relpath);
+
+  if (!cached)
+    return FALSE;
+
+  *props = svn_prop_hash_dup(cached, result_pool);
+  return TRUE;
+}
+
+void
+svn_wc__db_cache_set_props(svn_wc__db_cache_t *cache,
+                           const char *local_relpath,
+                           apr_hash_t *props)
+{
+  make_room(cache, 1);
+  svn_hash_sets(cache->props, apr_pstrdup(cache->pool, local_relpath),
+                svn_prop_hash_dup(props, cache->pool));
+}
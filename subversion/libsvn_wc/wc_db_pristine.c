@@ -25,11 +25,15 @@
 
 #define SVN_WC__I_AM_WC_DB
 
+#include <string.h>
+
 #include "svn_pools.h"
 #include "svn_io.h"
 #include "svn_dirent_uri.h"
 
 #include "private/svn_io_private.h"
+#include "private/svn_subr_private.h"
+#include "private/svn_task.h"
 
 #include "wc.h"
 #include "wc_db.h"
@@ -42,6 +46,43 @@
 
 
 
+/* Returns in PRISTINE_ABSPATH a new string allocated from RESULT_POOL,
+   holding the local absolute path to the file location that is dedicated
+   to hold CHECKSUM's pristine file within the pristine directory
+   BASE_DIR_ABSPATH.  The returned path does not necessarily currently
+   exist.
+
+   Any other allocations are made in SCRATCH_POOL. */
+static svn_error_t *
+get_pristine_fname_in(const char **pristine_abspath,
+                      const char *base_dir_abspath,
+                      const svn_checksum_t *sha1_checksum,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  const char *hexdigest = svn_checksum_to_cstring(sha1_checksum, scratch_pool);
+  char subdir[3];
+
+  /* We should have a valid checksum and (thus) a valid digest. */
+  SVN_ERR_ASSERT(hexdigest != NULL);
+
+  /* Get the first two characters of the digest, for the subdir. */
+  subdir[0] = hexdigest[0];
+  subdir[1] = hexdigest[1];
+  subdir[2] = '\0';
+
+  hexdigest = apr_pstrcat(scratch_pool, hexdigest, PRISTINE_STORAGE_EXT,
+                          SVN_VA_NULL);
+
+  /* The file is located at BASE_DIR/XX/XXYYZZ...svn-base */
+  *pristine_abspath = svn_dirent_join_many(result_pool,
+                                           base_dir_abspath,
+                                           subdir,
+                                           hexdigest,
+                                           SVN_VA_NULL);
+  return SVN_NO_ERROR;
+}
+
 /* Returns in PRISTINE_ABSPATH a new string allocated from RESULT_POOL,
    holding the local absolute path to the file location that is dedicated
    to hold CHECKSUM's pristine file, relating to the pristine store
@@ -57,8 +98,6 @@ get_pristine_fname(const char **pristine_abspath,
                    apr_pool_t *scratch_pool)
 {
   const char *base_dir_abspath;
-  const char *hexdigest = svn_checksum_to_cstring(sha1_checksum, scratch_pool);
-  char subdir[3];
 
   /* ### code is in transition. make sure we have the proper data.  */
   SVN_ERR_ASSERT(pristine_abspath != NULL);
@@ -72,24 +111,37 @@ get_pristine_fname(const char **pristine_abspath,
                                           PRISTINE_STORAGE_RELPATH,
                                           SVN_VA_NULL);
 
-  /* We should have a valid checksum and (thus) a valid digest. */
-  SVN_ERR_ASSERT(hexdigest != NULL);
+  /* The file is located at DIR/.svn/pristine/XX/XXYYZZ...svn-base */
+  return svn_error_trace(get_pristine_fname_in(pristine_abspath,
+                                               base_dir_abspath,
+                                               sha1_checksum,
+                                               result_pool, scratch_pool));
+}
 
-  /* Get the first two characters of the digest, for the subdir. */
-  subdir[0] = hexdigest[0];
-  subdir[1] = hexdigest[1];
-  subdir[2] = '\0';
+/* Like get_pristine_fname(), but for the pristine directory that DB
+   shares with other working copies.  Set *PRISTINE_ABSPATH to NULL if
+   there is none.
 
-  hexdigest = apr_pstrcat(scratch_pool, hexdigest, PRISTINE_STORAGE_EXT,
-                          SVN_VA_NULL);
+   The working copies share a text by hard linking the same file into
+   their own pristine stores, so the link count of a file in the shared
+   directory tells whether any working copy still uses it. */
+static svn_error_t *
+get_shared_pristine_fname(const char **pristine_abspath,
+                          svn_wc__db_t *db,
+                          const svn_checksum_t *sha1_checksum,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  if (!db->shared_pristine_abspath)
+    {
+      *pristine_abspath = NULL;
+      return SVN_NO_ERROR;
+    }
 
-  /* The file is located at DIR/.svn/pristine/XX/XXYYZZ...svn-base */
-  *pristine_abspath = svn_dirent_join_many(result_pool,
-                                           base_dir_abspath,
-                                           subdir,
-                                           hexdigest,
-                                           SVN_VA_NULL);
-  return SVN_NO_ERROR;
+  return svn_error_trace(get_pristine_fname_in(pristine_abspath,
+                                               db->shared_pristine_abspath,
+                                               sha1_checksum,
+                                               result_pool, scratch_pool));
 }
 
 
@@ -255,6 +307,36 @@ svn_wc__db_pristine_read(svn_stream_t **contents,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__db_pristine_read_shared(svn_stream_t **contents,
+                                svn_wc__db_t *db,
+                                const svn_checksum_t *sha1_checksum,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool)
+{
+  const char *shared_abspath;
+  svn_error_t *err;
+
+  SVN_ERR_ASSERT(sha1_checksum->kind == svn_checksum_sha1);
+
+  *contents = NULL;
+  SVN_ERR(get_shared_pristine_fname(&shared_abspath, db, sha1_checksum,
+                                    scratch_pool, scratch_pool));
+  if (!shared_abspath)
+    return SVN_NO_ERROR;
+
+  err = svn_stream_open_readonly(contents, shared_abspath,
+                                 result_pool, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *contents = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(err);
+}
+
 
 /* Return the absolute path to the temporary directory for pristine text
    files within WCROOT. */
@@ -268,10 +350,88 @@ pristine_get_tempdir(svn_wc__db_wcroot_t *wcroot,
                               PRISTINE_TEMPDIR_RELPATH, SVN_VA_NULL);
 }
 
+/* Insert a row for the pristine text with SHA1_CHECKSUM, MD5_CHECKSUM
+ * and SIZE into the PRISTINE table of SDB. */
+static svn_error_t *
+insert_pristine(svn_sqlite__db_t *sdb,
+                const svn_checksum_t *sha1_checksum,
+                const svn_checksum_t *md5_checksum,
+                apr_off_t size,
+                apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_PRISTINE));
+  SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
+  SVN_ERR(svn_sqlite__bind_checksum(stmt, 2, md5_checksum, scratch_pool));
+  SVN_ERR(svn_sqlite__bind_int64(stmt, 3, size));
+  return svn_error_trace(svn_sqlite__insert(NULL, stmt));
+}
+
+/* Make the pristine text file PRISTINE_ABSPATH of SIZE bytes a hard link
+ * to the same text SHARED_ABSPATH in the shared pristine directory, if
+ * that exists.  Set *LINKED to whether that worked.  Do not report any
+ * errors; sharing texts is just an optimization. */
+static void
+link_from_shared(svn_boolean_t *linked,
+                 const char *shared_abspath,
+                 const char *pristine_abspath,
+                 apr_off_t size,
+                 apr_pool_t *scratch_pool)
+{
+  apr_finfo_t finfo;
+  svn_error_t *err;
+
+  *linked = FALSE;
+
+  /* Don't trust a text of the wrong size. */
+  err = svn_io_stat(&finfo, shared_abspath, APR_FINFO_SIZE, scratch_pool);
+  if (err || finfo.size != size)
+    {
+      svn_error_clear(err);
+      return;
+    }
+
+  /* Any file already at the target location is an orphan. */
+  err = svn_io_remove_file2(pristine_abspath, TRUE, scratch_pool);
+  if (!err)
+    err = svn_io_make_dir_recursively(svn_dirent_dirname(pristine_abspath,
+                                                         scratch_pool),
+                                      scratch_pool);
+  if (!err)
+    err = svn_io__file_link(shared_abspath, pristine_abspath, scratch_pool);
+
+  *linked = (err == SVN_NO_ERROR);
+  svn_error_clear(err);
+}
+
+/* Make the pristine text file PRISTINE_ABSPATH available to other working
+ * copies as SHARED_ABSPATH.  Do not report any errors, e.g. when another
+ * working copy did the same first. */
+static void
+link_to_shared(const char *pristine_abspath,
+               const char *shared_abspath,
+               apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+
+  err = svn_io_make_dir_recursively(svn_dirent_dirname(shared_abspath,
+                                                       scratch_pool),
+                                    scratch_pool);
+  if (!err)
+    err = svn_io__file_link(pristine_abspath, shared_abspath, scratch_pool);
+
+  svn_error_clear(err);
+}
+
 /* Install the pristine text described by BATON into the pristine store of
  * SDB.  If it is already stored then just delete the new file
  * BATON->tempfile_abspath.
  *
+ * If SHARED_ABSPATH is not NULL, link the pristine file to that location
+ * in the shared pristine directory, reusing the file found there if
+ * possible.
+ *
  * This function expects to be executed inside a SQLite txn that has already
  * acquired a 'RESERVED' lock.
  *
@@ -287,6 +447,8 @@ pristine_install_txn(svn_sqlite__db_t *sdb,
                      const svn_checksum_t *sha1_checksum,
                      /* The pristine text's MD-5 checksum. */
                      const svn_checksum_t *md5_checksum,
+                     /* The location in the shared pristine directory. */
+                     const char *shared_abspath,
                      apr_pool_t *scratch_pool)
 {
   svn_sqlite__stmt_t *stmt;
@@ -333,18 +495,32 @@ pristine_install_txn(svn_sqlite__db_t *sdb,
    * an orphan file and it doesn't matter if we overwrite it.) */
   {
     apr_finfo_t finfo;
+    svn_boolean_t linked = FALSE;
+
     SVN_ERR(svn_stream__install_get_info(&finfo, install_stream,
                                          APR_FINFO_SIZE, scratch_pool));
-    SVN_ERR(svn_stream__install_stream(install_stream, pristine_abspath,
-                                       TRUE, scratch_pool));
 
-    SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_PRISTINE));
-    SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
-    SVN_ERR(svn_sqlite__bind_checksum(stmt, 2, md5_checksum, scratch_pool));
-    SVN_ERR(svn_sqlite__bind_int64(stmt, 3, finfo.size));
-    SVN_ERR(svn_sqlite__insert(NULL, stmt));
+    /* Use the copy that another working copy stored, if there is one. */
+    if (shared_abspath)
+      link_from_shared(&linked, shared_abspath, pristine_abspath,
+                       finfo.size, scratch_pool);
+
+    if (linked)
+      SVN_ERR(svn_stream__install_delete(install_stream, scratch_pool));
+    else
+      SVN_ERR(svn_stream__install_stream(install_stream, pristine_abspath,
+                                         TRUE, scratch_pool));
+
+    SVN_ERR(insert_pristine(sdb, sha1_checksum, md5_checksum, finfo.size,
+                            scratch_pool));
 
-    SVN_ERR(svn_io_set_file_read_only(pristine_abspath, FALSE, scratch_pool));
+    if (!linked)
+      {
+        SVN_ERR(svn_io_set_file_read_only(pristine_abspath, FALSE,
+                                          scratch_pool));
+        if (shared_abspath)
+          link_to_shared(pristine_abspath, shared_abspath, scratch_pool);
+      }
   }
 
   return SVN_NO_ERROR;
@@ -352,6 +528,7 @@ pristine_install_txn(svn_sqlite__db_t *sdb,
 
 struct svn_wc__db_install_data_t
 {
+  svn_wc__db_t *db;
   svn_wc__db_wcroot_t *wcroot;
   svn_stream_t *inner_stream;
 };
@@ -379,6 +556,7 @@ svn_wc__db_pristine_prepare_install(svn_stream_t **stream,
   temp_dir_abspath = pristine_get_tempdir(wcroot, scratch_pool, scratch_pool);
 
   *install_data = apr_pcalloc(result_pool, sizeof(**install_data));
+  (*install_data)->db = db;
   (*install_data)->wcroot = wcroot;
 
   SVN_ERR_W(svn_stream__create_for_install(stream,
@@ -388,10 +566,16 @@ svn_wc__db_pristine_prepare_install(svn_stream_t **stream,
 
   (*install_data)->inner_stream = *stream;
 
-  if (md5_checksum)
+  if (md5_checksum && sha1_checksum)
+    *stream = svn_checksum__wrap_write_stream2(md5_checksum,
+                                               svn_checksum_md5,
+                                               sha1_checksum,
+                                               svn_checksum_sha1,
+                                               *stream, result_pool);
+  else if (md5_checksum)
     *stream = svn_stream_checksummed2(*stream, NULL, md5_checksum,
                                       svn_checksum_md5, FALSE, result_pool);
-  if (sha1_checksum)
+  else if (sha1_checksum)
     *stream = svn_stream_checksummed2(*stream, NULL, sha1_checksum,
                                       svn_checksum_sha1, FALSE, result_pool);
 
@@ -406,6 +590,7 @@ svn_wc__db_pristine_install(svn_wc__db_install_data_t *install_data,
 {
   svn_wc__db_wcroot_t *wcroot = install_data->wcroot;
   const char *pristine_abspath;
+  const char *shared_abspath;
 
   SVN_ERR_ASSERT(sha1_checksum != NULL);
   SVN_ERR_ASSERT(sha1_checksum->kind == svn_checksum_sha1);
@@ -415,15 +600,18 @@ svn_wc__db_pristine_install(svn_wc__db_install_data_t *install_data,
   SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
                              sha1_checksum,
                              scratch_pool, scratch_pool));
+  SVN_ERR(get_shared_pristine_fname(&shared_abspath, install_data->db,
+                                    sha1_checksum,
+                                    scratch_pool, scratch_pool));
 
   /* Ensure the SQL txn has at least a 'RESERVED' lock before we start looking
    * at the disk, to ensure no concurrent pristine install/delete txn. */
-  SVN_SQLITE__WITH_IMMEDIATE_TXN(
+  SVN_WC__DB_WITH_IMMEDIATE_TXN(
     pristine_install_txn(wcroot->sdb,
                          install_data->inner_stream, pristine_abspath,
-                         sha1_checksum, md5_checksum,
+                         sha1_checksum, md5_checksum, shared_abspath,
                          scratch_pool),
-    wcroot->sdb);
+    wcroot);
 
   return SVN_NO_ERROR;
 }
@@ -744,6 +932,9 @@ pristine_remove_if_unreferenced(svn_wc__db_wcroot_t *wcroot,
   SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
                              sha1_checksum, scratch_pool, scratch_pool));
 
+  /* The file is gone for good, so the row must be, too. */
+  SVN_ERR(svn_wc__db_util_end_batch(wcroot));
+
   /* Ensure the SQL txn has at least a 'RESERVED' lock before we start looking
    * at the disk, to ensure no concurrent pristine install/delete txn. */
   SVN_SQLITE__WITH_IMMEDIATE_TXN(
@@ -798,7 +989,88 @@ svn_wc__db_pristine_remove(svn_wc__db_t *db,
 }
 
 
-/* Remove all unreferenced pristines in the WC DB in WCROOT.
+/* Remove the file at index INDEX of the array of pristine file paths
+ * PROCESS_BATON.
+ * Implements svn_task__process_func_t. */
+static svn_error_t *
+remove_pristine_file(void **result,
+                     int index,
+                     void *process_baton,
+                     void *thread_context,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  const apr_array_header_t *abspaths = process_baton;
+  /* See pristine_remove_if_unreferenced_txn(). */
+#ifdef SVN_DEBUG
+  svn_boolean_t ignore_enoent = FALSE;
+#else
+  svn_boolean_t ignore_enoent = TRUE;
+#endif
+
+  *result = NULL;
+  return svn_error_trace(
+           svn_io_remove_file2(APR_ARRAY_IDX(abspaths, index, const char *),
+                               ignore_enoent, scratch_pool));
+}
+
+/* Delete the rows of the pristine texts with the SHA1_CHECKSUMS in WCROOT
+ * that are still unreferenced, and then remove their files using up to
+ * THREAD_COUNT threads.  Set *REMOVE_ERR to the error removing the files,
+ * if any, instead of returning it: a row that is gone leaves at most an
+ * unused file behind, but rows that are restored by a rollback would
+ * refer to files that have been removed.
+ *
+ * Like pristine_remove_if_unreferenced_txn(), this function expects to be
+ * executed inside a SQLite txn that has already acquired a 'RESERVED'
+ * lock. */
+static svn_error_t *
+pristine_cleanup_txn(svn_error_t **remove_err,
+                     svn_wc__db_wcroot_t *wcroot,
+                     const apr_array_header_t *sha1_checksums,
+                     int thread_count,
+                     apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *abspaths;
+  int i;
+
+  abspaths = apr_array_make(scratch_pool, sha1_checksums->nelts,
+                            sizeof(const char *));
+  for (i = 0; i < sha1_checksums->nelts; i++)
+    {
+      const svn_checksum_t *sha1_checksum
+        = APR_ARRAY_IDX(sha1_checksums, i, const svn_checksum_t *);
+      svn_sqlite__stmt_t *stmt;
+      int affected_rows;
+      const char *pristine_abspath;
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                        STMT_DELETE_PRISTINE_IF_UNREFERENCED));
+      SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum,
+                                        scratch_pool));
+      SVN_ERR(svn_sqlite__update(&affected_rows, stmt));
+      if (affected_rows == 0)
+        continue;
+
+      SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
+                                 sha1_checksum, scratch_pool, scratch_pool));
+      APR_ARRAY_PUSH(abspaths, const char *) = pristine_abspath;
+    }
+
+  *remove_err = svn_task__run(thread_count, abspaths->nelts,
+                              remove_pristine_file, abspaths,
+                              NULL, NULL,
+                              NULL, NULL,
+                              NULL, NULL,
+                              scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove all unreferenced pristines in the WC DB in WCROOT, using up to
+ * THREAD_COUNT threads to remove their files.
  *
  * Look for pristine texts whose 'refcount' in the DB is zero, and remove
  * them from the 'pristine' table and from disk.
@@ -831,36 +1103,145 @@ svn_wc__db_pristine_remove(svn_wc__db_t *db,
  */
 static svn_error_t *
 pristine_cleanup_wcroot(svn_wc__db_wcroot_t *wcroot,
+                        int thread_count,
                         apr_pool_t *scratch_pool)
 {
   svn_sqlite__stmt_t *stmt;
-  svn_error_t *err = NULL;
-  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_array_header_t *sha1_checksums;
+  svn_error_t *remove_err = SVN_NO_ERROR;
+  svn_boolean_t have_row;
 
-  /* Find each unreferenced pristine in the DB and remove it. */
+  /* Find each unreferenced pristine in the DB. */
+  sha1_checksums = apr_array_make(scratch_pool, 0,
+                                  sizeof(const svn_checksum_t *));
   SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
                                     STMT_SELECT_UNREFERENCED_PRISTINES));
-  while (! err)
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
     {
-      svn_boolean_t have_row;
       const svn_checksum_t *sha1_checksum;
 
-      svn_pool_clear(iterpool);
-
+      SVN_ERR(svn_sqlite__column_checksum(&sha1_checksum, stmt, 0,
+                                          scratch_pool));
+      APR_ARRAY_PUSH(sha1_checksums, const svn_checksum_t *) = sha1_checksum;
       SVN_ERR(svn_sqlite__step(&have_row, stmt));
-      if (! have_row)
-        break;
+    }
+  SVN_ERR(svn_sqlite__reset(stmt));
 
-      SVN_ERR(svn_sqlite__column_checksum(&sha1_checksum, stmt, 0,
-                                          iterpool));
-      err = pristine_remove_if_unreferenced(wcroot, sha1_checksum,
-                                            iterpool);
+  if (sha1_checksums->nelts == 0)
+    return SVN_NO_ERROR;
+
+  /* The files are gone for good, so the rows must be, too. */
+  SVN_ERR(svn_wc__db_util_end_batch(wcroot));
+
+  /* Remove all rows and files in a single txn with a 'RESERVED' lock, so
+   * that no concurrent txn installs one of the texts meanwhile. */
+  SVN_SQLITE__WITH_IMMEDIATE_TXN(
+    pristine_cleanup_txn(&remove_err, wcroot, sha1_checksums, thread_count,
+                         scratch_pool),
+    wcroot->sdb);
+
+  return svn_error_trace(remove_err);
+}
+
+/* Remove the texts of the shared pristine subdirectory at index INDEX of
+ * the array of paths PROCESS_BATON that are no longer hard linked from
+ * any working copy.
+ * Implements svn_task__process_func_t. */
+static svn_error_t *
+cleanup_shared_subdir(void **result,
+                      int index,
+                      void *process_baton,
+                      void *thread_context,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  const apr_array_header_t *subdir_abspaths = process_baton;
+  const char *subdir_abspath
+    = APR_ARRAY_IDX(subdir_abspaths, index, const char *);
+  apr_hash_t *files;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  *result = NULL;
+  SVN_ERR(svn_io_get_dirents3(&files, subdir_abspath,
+                              TRUE /* only_check_type */,
+                              scratch_pool, scratch_pool));
+
+  for (hi = apr_hash_first(scratch_pool, files); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      apr_size_t len = strlen(name);
+      const char *file_abspath;
+      apr_finfo_t finfo;
+      svn_error_t *err;
+
+      if (len < sizeof(PRISTINE_STORAGE_EXT)
+          || strcmp(name + len - (sizeof(PRISTINE_STORAGE_EXT) - 1),
+                    PRISTINE_STORAGE_EXT) != 0)
+        continue;
+
+      svn_pool_clear(iterpool);
+      file_abspath = svn_dirent_join(subdir_abspath, name, iterpool);
+      err = svn_io_stat(&finfo, file_abspath, APR_FINFO_NLINK, iterpool);
+      if (!err && finfo.nlink == 1)
+        err = svn_io_remove_file2(file_abspath, TRUE, iterpool);
+
+      if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+        svn_error_clear(err);
+      else
+        SVN_ERR(err);
     }
 
   svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
 
-  return svn_error_trace(
-      svn_error_compose_create(err, svn_sqlite__reset(stmt)));
+/* Remove the texts of the shared pristine directory SHARED_ABSPATH that
+ * are no longer hard linked from any working copy, checking up to
+ * THREAD_COUNT of its subdirectories concurrently.  A working copy that
+ * links a text concurrently keeps its own link, so the worst outcome of
+ * a race is a text that is no longer shared. */
+static svn_error_t *
+pristine_cleanup_shared(const char *shared_abspath,
+                        int thread_count,
+                        apr_pool_t *scratch_pool)
+{
+  apr_hash_t *subdirs;
+  apr_hash_index_t *hi;
+  apr_array_header_t *subdir_abspaths;
+  svn_error_t *err;
+
+  err = svn_io_get_dirents3(&subdirs, shared_abspath,
+                            TRUE /* only_check_type */,
+                            scratch_pool, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  subdir_abspaths = apr_array_make(scratch_pool, apr_hash_count(subdirs),
+                                   sizeof(const char *));
+  for (hi = apr_hash_first(scratch_pool, subdirs); hi; hi = apr_hash_next(hi))
+    {
+      const svn_io_dirent2_t *dirent = apr_hash_this_val(hi);
+
+      if (dirent->kind == svn_node_dir)
+        APR_ARRAY_PUSH(subdir_abspaths, const char *)
+          = svn_dirent_join(shared_abspath, apr_hash_this_key(hi),
+                            scratch_pool);
+    }
+
+  return svn_error_trace(svn_task__run(thread_count, subdir_abspaths->nelts,
+                                       cleanup_shared_subdir, subdir_abspaths,
+                                       NULL, NULL,
+                                       NULL, NULL,
+                                       NULL, NULL,
+                                       scratch_pool));
 }
 
 svn_error_t *
@@ -877,7 +1258,12 @@ svn_wc__db_pristine_cleanup(svn_wc__db_t *db,
                               wri_abspath, scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
-  SVN_ERR(pristine_cleanup_wcroot(wcroot, scratch_pool));
+  SVN_ERR(pristine_cleanup_wcroot(wcroot, db->cleanup_threads,
+                                  scratch_pool));
+
+  if (db->shared_pristine_abspath)
+    SVN_ERR(pristine_cleanup_shared(db->shared_pristine_abspath,
+                                    db->cleanup_threads, scratch_pool));
 
   return SVN_NO_ERROR;
 }
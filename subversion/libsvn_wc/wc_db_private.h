@@ -52,6 +52,29 @@ struct svn_wc__db_t {
   /* Busy timeout in ms., 0 for the libsvn_subr default. */
   apr_int32_t timeout;
 
+  /* Switch Sqlite databases to (true) or from (false) write-ahead
+     logging, or leave them alone (unknown). */
+  svn_tristate_t wal;
+
+  /* Number of threads the work queue may use to install files. */
+  int install_threads;
+
+  /* Number of threads status walks may use to compare file contents. */
+  int status_threads;
+
+  /* Number of threads cleanup may use to remove files. */
+  int cleanup_threads;
+
+  /* Command reporting changed paths to status walks, or NULL. */
+  const char *fsmonitor_cmd;
+
+  /* Directory shared with other working copies' pristine stores, or
+     NULL. */
+  const char *shared_pristine_abspath;
+
+  /* Number of nodes to cache per wcroot, 0 to not cache any. */
+  int node_cache_size;
+
   /* Map a given working copy directory to its relevant data.
      const char *local_abspath -> svn_wc__db_wcroot_t *wcroot  */
   apr_hash_t *dir_data;
@@ -80,6 +103,9 @@ typedef struct svn_wc__db_wclock_t
 } svn_wc__db_wclock_t;
 
 
+/* Recently read nodes of a WCROOT, see wc_db_cache.c. */
+typedef struct svn_wc__db_cache_t svn_wc__db_cache_t;
+
 /** Hold information about a WCROOT.
  *
  * This structure is referenced by all per-directory handles underneath it.
@@ -107,6 +133,13 @@ typedef struct svn_wc__db_wcroot_t {
      const char *local_abspath -> svn_wc_adm_access_t *adm_access */
   apr_hash_t *access_cache;
 
+  /* Whether a transaction started by svn_wc__db_batch_begin() is open
+     in SDB. */
+  svn_boolean_t batch_open;
+
+  /* Cached results of reading SDB, or NULL if nothing was cached yet.  */
+  svn_wc__db_cache_t *node_cache;
+
 } svn_wc__db_wcroot_t;
 
 
@@ -200,6 +233,10 @@ svn_wc__db_util_fetch_wc_id(apr_int64_t *wc_id,
  *
  * SMODE, EXCLUSIVE and TIMEOUT are passed to svn_sqlite__open().
  *
+ * Unless EXCLUSIVE is set, switch the database to write-ahead logging if
+ * WAL is svn_tristate_true, or back to a rollback journal if WAL is
+ * svn_tristate_false, as far as SQLite can.
+ *
  * Register MY_STATEMENTS, or if that is null, the default set of WC DB
  * statements, as the set of statements to be prepared now and executed
  * later.  MY_STATEMENTS (the strings and the array itself) is not duplicated
@@ -212,10 +249,83 @@ svn_wc__db_util_open_db(svn_sqlite__db_t **sdb,
                         svn_sqlite__mode_t smode,
                         svn_boolean_t exclusive,
                         apr_int32_t timeout,
+                        svn_tristate_t wal,
                         const char *const *my_statements,
                         apr_pool_t *result_pool,
                         apr_pool_t *scratch_pool);
 
+/* Commit the transaction started by svn_wc__db_batch_begin() in WCROOT,
+ * if any. */
+svn_error_t *
+svn_wc__db_util_end_batch(svn_wc__db_wcroot_t *wcroot);
+
+/* Create an empty cache for up to MAX_NODES nodes in RESULT_POOL. */
+svn_wc__db_cache_t *
+svn_wc__db_cache_create(int max_nodes,
+                        apr_pool_t *result_pool);
+
+/* Drop everything from CACHE if SDB changed since it was filled, be it
+ * through SDB or another connection.  Set *USABLE to whether CACHE may be
+ * used for the next read of SDB, which is not the case while SDB is in a
+ * transaction. */
+svn_error_t *
+svn_wc__db_cache_check(svn_boolean_t *usable,
+                       svn_wc__db_cache_t *cache,
+                       svn_sqlite__db_t *sdb);
+
+/* If CACHE has the result of svn_wc__db_read_single_info() for
+ * LOCAL_RELPATH and BASE_TREE_ONLY, set *INFO to a copy of it allocated in
+ * RESULT_POOL and return TRUE.  Otherwise return FALSE. */
+svn_boolean_t
+svn_wc__db_cache_get_info(const struct svn_wc__db_info_t **info,
+                          svn_wc__db_cache_t *cache,
+                          const char *local_relpath,
+                          svn_boolean_t base_tree_only,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
+/* Store a copy of INFO for LOCAL_RELPATH and BASE_TREE_ONLY in CACHE. */
+void
+svn_wc__db_cache_set_info(svn_wc__db_cache_t *cache,
+                          const char *local_relpath,
+                          svn_boolean_t base_tree_only,
+                          const struct svn_wc__db_info_t *info);
+
+/* Like svn_wc__db_cache_get_info(), but for the results of
+ * svn_wc__db_read_children_info() for DIR_RELPATH. */
+svn_boolean_t
+svn_wc__db_cache_get_children(apr_hash_t **nodes,
+                              apr_hash_t **conflicts,
+                              svn_wc__db_cache_t *cache,
+                              const char *dir_relpath,
+                              svn_boolean_t base_tree_only,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
+/* Like svn_wc__db_cache_set_info(), but for the results of
+ * svn_wc__db_read_children_info() for DIR_RELPATH. */
+void
+svn_wc__db_cache_set_children(svn_wc__db_cache_t *cache,
+                              const char *dir_relpath,
+                              svn_boolean_t base_tree_only,
+                              apr_hash_t *nodes,
+                              apr_hash_t *conflicts);
+
+/* Like svn_wc__db_cache_get_info(), but for the results of
+ * svn_wc__db_read_props() for LOCAL_RELPATH. */
+svn_boolean_t
+svn_wc__db_cache_get_props(apr_hash_t **props,
+                           svn_wc__db_cache_t *cache,
+                           const char *local_relpath,
+                           apr_pool_t *result_pool);
+
+/* Like svn_wc__db_cache_set_info(), but for the results of
+ * svn_wc__db_read_props() for LOCAL_RELPATH. */
+void
+svn_wc__db_cache_set_props(svn_wc__db_cache_t *cache,
+                           const char *local_relpath,
+                           apr_hash_t *props);
+
 /* Like svn_wc__db_wq_add() but taking WCROOT */
 svn_error_t *
 svn_wc__db_wq_add_internal(svn_wc__db_wcroot_t *wcroot,
@@ -394,6 +504,18 @@ svn_wc__db_mark_conflict_internal(svn_wc__db_wcroot_t *wcroot,
 #define SVN_WC__DB_WITH_TXN4(expr1, expr2, expr3, expr4, wcroot) \
   SVN_SQLITE__WITH_LOCK4(expr1, expr2, expr3, expr4, (wcroot)->sdb)
 
+/* Like SVN_SQLITE__WITH_IMMEDIATE_TXN() on WCROOT's DB, but within the
+ * batch transaction of WCROOT if one is open.  That transaction already
+ * holds the 'RESERVED' lock.
+ */
+#define SVN_WC__DB_WITH_IMMEDIATE_TXN(expr, wcroot)                          \
+  do {                                                                       \
+    if ((wcroot)->batch_open)                                                \
+      SVN_SQLITE__WITH_LOCK(expr, (wcroot)->sdb);                            \
+    else                                                                     \
+      SVN_SQLITE__WITH_IMMEDIATE_TXN(expr, (wcroot)->sdb);                   \
+  } while (0)
+
 /* Update the single op-depth layer in the move destination subtree
    rooted at DST_RELPATH to make it match the move source subtree
    rooted at SRC_RELPATH. */
@@ -109,6 +109,18 @@ relpath_depth_sqlite(svn_sqlite__context_t *sctx,
 }
 
 
+svn_error_t *
+svn_wc__db_util_end_batch(svn_wc__db_wcroot_t *wcroot)
+{
+  if (!wcroot->batch_open)
+    return SVN_NO_ERROR;
+
+  wcroot->batch_open = FALSE;
+  return svn_error_trace(svn_sqlite__finish_transaction(wcroot->sdb,
+                                                        SVN_NO_ERROR));
+}
+
+
 svn_error_t *
 svn_wc__db_util_open_db(svn_sqlite__db_t **sdb,
                         const char *dir_abspath,
@@ -116,6 +128,7 @@ svn_wc__db_util_open_db(svn_sqlite__db_t **sdb,
                         svn_sqlite__mode_t smode,
                         svn_boolean_t exclusive,
                         apr_int32_t timeout,
+                        svn_tristate_t wal,
                         const char *const *my_statements,
                         apr_pool_t *result_pool,
                         apr_pool_t *scratch_pool)
@@ -144,6 +157,13 @@ svn_wc__db_util_open_db(svn_sqlite__db_t **sdb,
 
   if (exclusive)
     SVN_ERR(svn_sqlite__exec_statements(*sdb, STMT_PRAGMA_LOCKING_MODE));
+  else if (wal != svn_tristate_unknown)
+    /* SQLite keeps the current mode if it can't switch, e.g. when other
+       connections are open or shared memory is not available. */
+    svn_error_clear(svn_sqlite__exec_statements(
+                      *sdb, (wal == svn_tristate_true)
+                              ? STMT_PRAGMA_JOURNAL_MODE_WAL
+                              : STMT_PRAGMA_JOURNAL_MODE_TRUNCATE));
 
   SVN_ERR(svn_sqlite__create_scalar_function(*sdb, "relpath_depth", 1,
                                              TRUE /* deterministic */,
@@ -232,6 +232,10 @@ svn_wc__db_open(svn_wc__db_t **db,
   (*db)->verify_format = !open_without_upgrade;
   (*db)->enforce_empty_wq = enforce_empty_wq;
   (*db)->dir_data = apr_hash_make(result_pool);
+  (*db)->install_threads = 1;
+  (*db)->status_threads = 1;
+  (*db)->cleanup_threads = 1;
+  (*db)->wal = svn_tristate_unknown;
 
   (*db)->state_pool = result_pool;
 
@@ -241,6 +245,11 @@ svn_wc__db_open(svn_wc__db_t **db,
       svn_error_t *err;
       svn_boolean_t sqlite_exclusive = FALSE;
       apr_int64_t timeout;
+      apr_int64_t install_threads;
+      apr_int64_t status_threads;
+      apr_int64_t cleanup_threads;
+      apr_int64_t node_cache_size;
+      const char *shared_pristine_dir;
 
       err = svn_config_get_bool(config, &sqlite_exclusive,
                                 SVN_CONFIG_SECTION_WORKING_COPY,
@@ -261,6 +270,82 @@ svn_wc__db_open(svn_wc__db_t **db,
         svn_error_clear(err);
       else
         (*db)->timeout = (apr_int32_t)timeout;
+
+      err = svn_config_get_tristate(config, &(*db)->wal,
+                                    SVN_CONFIG_SECTION_WORKING_COPY,
+                                    SVN_CONFIG_OPTION_SQLITE_WAL,
+                                    "", svn_tristate_unknown);
+      if (err)
+        {
+          svn_error_clear(err);
+          (*db)->wal = svn_tristate_unknown;
+        }
+
+      err = svn_config_get_int64(config, &install_threads,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_INSTALL_THREADS,
+                                 1);
+      if (err || install_threads < 1)
+        svn_error_clear(err);
+      else
+        (*db)->install_threads = (int)(install_threads > 64
+                                       ? 64 : install_threads);
+
+      err = svn_config_get_int64(config, &status_threads,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_STATUS_THREADS,
+                                 1);
+      if (err || status_threads < 1)
+        svn_error_clear(err);
+      else
+        (*db)->status_threads = (int)(status_threads > 64
+                                      ? 64 : status_threads);
+
+      err = svn_config_get_int64(config, &cleanup_threads,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_CLEANUP_THREADS,
+                                 1);
+      if (err || cleanup_threads < 1)
+        svn_error_clear(err);
+      else
+        (*db)->cleanup_threads = (int)(cleanup_threads > 64
+                                       ? 64 : cleanup_threads);
+
+      err = svn_config_get_int64(config, &node_cache_size,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_NODE_CACHE_SIZE,
+                                 0);
+      if (err || node_cache_size < 0)
+        svn_error_clear(err);
+      else
+        (*db)->node_cache_size = (int)(node_cache_size > APR_INT32_MAX
+                                       ? APR_INT32_MAX : node_cache_size);
+
+      svn_config_get(config, &(*db)->fsmonitor_cmd,
+                     SVN_CONFIG_SECTION_WORKING_COPY,
+                     SVN_CONFIG_OPTION_FSMONITOR, NULL);
+      if ((*db)->fsmonitor_cmd && !*(*db)->fsmonitor_cmd)
+        (*db)->fsmonitor_cmd = NULL;
+      else if ((*db)->fsmonitor_cmd)
+        (*db)->fsmonitor_cmd = apr_pstrdup(result_pool,
+                                           (*db)->fsmonitor_cmd);
+
+      svn_config_get(config, &shared_pristine_dir,
+                     SVN_CONFIG_SECTION_WORKING_COPY,
+                     SVN_CONFIG_OPTION_SHARED_PRISTINE_DIR, NULL);
+      if (shared_pristine_dir && *shared_pristine_dir)
+        {
+          err = svn_dirent_get_absolute(
+                    &(*db)->shared_pristine_abspath,
+                    svn_dirent_internal_style(shared_pristine_dir,
+                                              scratch_pool),
+                    result_pool);
+          if (err)
+            {
+              svn_error_clear(err);
+              (*db)->shared_pristine_abspath = NULL;
+            }
+        }
     }
 
   return SVN_NO_ERROR;
@@ -377,6 +462,8 @@ svn_wc__db_pdh_create_wcroot(svn_wc__db_wcroot_t **wcroot,
   (*wcroot)->owned_locks = apr_array_make(result_pool, 8,
                                           sizeof(svn_wc__db_wclock_t));
   (*wcroot)->access_cache = apr_hash_make(result_pool);
+  (*wcroot)->batch_open = FALSE;
+  (*wcroot)->node_cache = NULL;
 
   /* SDB will be NULL for pre-NG working copies. We only need to run a
      cleanup when the SDB is present.  */
@@ -641,8 +728,8 @@ svn_wc__db_wcroot_parse_local_abspath(svn_wc__db_wcroot_t **wcroot,
              as the filesystem allows. */
           err = svn_wc__db_util_open_db(&sdb, local_abspath, SDB_FILE,
                                         svn_sqlite__mode_readwrite,
-                                        db->exclusive, db->timeout, NULL,
-                                        db->state_pool, scratch_pool);
+                                        db->exclusive, db->timeout, db->wal,
+                                        NULL, db->state_pool, scratch_pool);
           if (err == NULL)
             {
 #ifdef SVN_DEBUG
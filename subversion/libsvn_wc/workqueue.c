@@ -40,6 +40,7 @@
 
 #include "private/svn_io_private.h"
 #include "private/svn_skel.h"
+#include "private/svn_task.h"
 
 
 /* Workqueue operation names.  */
@@ -64,6 +65,11 @@
 /* For work queue debugging. Generates output about its operation.  */
 /* #define SVN_DEBUG_WORK_QUEUE */
 
+/* The most work items svn_wc__wq_run() runs before marking them as
+   completed in one transaction, and the longest it runs them.  */
+#define WQ_BATCH_SIZE 256
+#define WQ_BATCH_TIME apr_time_from_msec(500)
+
 typedef struct work_item_baton_t work_item_baton_t;
 
 struct work_item_dispatch {
@@ -445,60 +451,76 @@ svn_wc__wq_build_postupgrade(svn_skel_t **work_item,
 
 /* OP_FILE_INSTALL */
 
-/* Process the OP_FILE_INSTALL work item WORK_ITEM.
- * See svn_wc__wq_build_file_install() which generates this work item.
- * Implements (struct work_item_dispatch).func. */
-static svn_error_t *
-run_file_install(work_item_baton_t *wqb,
-                 svn_wc__db_t *db,
-                 const svn_skel_t *work_item,
-                 const char *wri_abspath,
-                 svn_cancel_func_t cancel_func,
-                 void *cancel_baton,
-                 apr_pool_t *scratch_pool)
+/* Everything needed to install the working file of an OP_FILE_INSTALL
+   work item without accessing the working copy database. */
+typedef struct file_install_t
 {
-  const svn_skel_t *arg1 = work_item->children->next;
-  const svn_skel_t *arg4 = arg1->next->next->next;
-  const char *local_relpath;
   const char *local_abspath;
-  svn_boolean_t use_commit_times;
-  svn_boolean_t record_fileinfo;
+  const char *source_abspath;
+
+  /* Translation to apply to the source. */
   svn_boolean_t special;
-  svn_stream_t *src_stream;
   svn_subst_eol_style_t style;
   const char *eol;
   apr_hash_t *keywords;
+
+  /* Where to create the temporary file for non-special files. */
   const char *temp_dir_abspath;
-  svn_stream_t *dst_stream;
+
+  /* How to tweak the installed file. */
+  svn_boolean_t set_executable;
+  svn_boolean_t set_read_only;
+  apr_time_t affected_time; /* 0 to leave it alone */
+
+  /* Whether to record the timestamp and size of the installed file. */
+  svn_boolean_t record_fileinfo;
+} file_install_t;
+
+/* Read everything needed to process the OP_FILE_INSTALL work item
+ * WORK_ITEM from DB and return it in *INSTALL, allocated in RESULT_POOL.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+prepare_file_install(file_install_t **install,
+                     svn_wc__db_t *db,
+                     const svn_skel_t *work_item,
+                     const char *wri_abspath,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  const svn_skel_t *arg1 = work_item->children->next;
+  const svn_skel_t *arg4 = arg1->next->next->next;
+  file_install_t *fi = apr_pcalloc(result_pool, sizeof(*fi));
+  const char *local_relpath;
+  svn_boolean_t use_commit_times;
   apr_int64_t val;
   const char *wcroot_abspath;
-  const char *source_abspath;
   const svn_checksum_t *checksum;
   apr_hash_t *props;
   apr_time_t changed_date;
 
   local_relpath = apr_pstrmemdup(scratch_pool, arg1->data, arg1->len);
-  SVN_ERR(svn_wc__db_from_relpath(&local_abspath, db, wri_abspath,
-                                  local_relpath, scratch_pool, scratch_pool));
+  SVN_ERR(svn_wc__db_from_relpath(&fi->local_abspath, db, wri_abspath,
+                                  local_relpath, result_pool, scratch_pool));
 
   SVN_ERR(svn_skel__parse_int(&val, arg1->next, scratch_pool));
   use_commit_times = (val != 0);
   SVN_ERR(svn_skel__parse_int(&val, arg1->next->next, scratch_pool));
-  record_fileinfo = (val != 0);
+  fi->record_fileinfo = (val != 0);
 
   SVN_ERR(svn_wc__db_read_node_install_info(&wcroot_abspath,
                                             &checksum, &props,
                                             &changed_date,
-                                            db, local_abspath, wri_abspath,
+                                            db, fi->local_abspath,
+                                            wri_abspath,
                                             scratch_pool, scratch_pool));
 
   if (arg4 != NULL)
     {
       /* Use the provided path for the source.  */
       local_relpath = apr_pstrmemdup(scratch_pool, arg4->data, arg4->len);
-      SVN_ERR(svn_wc__db_from_relpath(&source_abspath, db, wri_abspath,
+      SVN_ERR(svn_wc__db_from_relpath(&fi->source_abspath, db, wri_abspath,
                                       local_relpath,
-                                      scratch_pool, scratch_pool));
+                                      result_pool, scratch_pool));
     }
   else if (! checksum)
     {
@@ -513,86 +535,40 @@ run_file_install(work_item_baton_t *wqb,
                                _("Can't install '%s' from pristine store, "
                                  "because no checksum is recorded for this "
                                  "file"),
-                               svn_dirent_local_style(local_abspath,
+                               svn_dirent_local_style(fi->local_abspath,
                                                       scratch_pool));
     }
   else
     {
-      SVN_ERR(svn_wc__db_pristine_get_future_path(&source_abspath,
+      SVN_ERR(svn_wc__db_pristine_get_future_path(&fi->source_abspath,
                                                   wcroot_abspath,
                                                   checksum,
-                                                  scratch_pool, scratch_pool));
+                                                  result_pool, scratch_pool));
     }
 
-  SVN_ERR(svn_stream_open_readonly(&src_stream, source_abspath,
-                                   scratch_pool, scratch_pool));
-
   /* Fetch all the translation bits.  */
-  SVN_ERR(svn_wc__get_translate_info(&style, &eol,
-                                     &keywords,
-                                     &special, db, local_abspath,
+  SVN_ERR(svn_wc__get_translate_info(&fi->style, &fi->eol,
+                                     &fi->keywords,
+                                     &fi->special, db, fi->local_abspath,
                                      props, FALSE,
-                                     scratch_pool, scratch_pool));
-  if (special)
+                                     result_pool, scratch_pool));
+  if (fi->special)
     {
-      /* When this stream is closed, the resulting special file will
-         atomically be created/moved into place at LOCAL_ABSPATH.  */
-      SVN_ERR(svn_subst_create_specialfile(&dst_stream, local_abspath,
-                                           scratch_pool, scratch_pool));
-
-      /* Copy the "repository normal" form of the special file into the
-         special stream.  */
-      SVN_ERR(svn_stream_copy3(src_stream, dst_stream,
-                               cancel_func, cancel_baton,
-                               scratch_pool));
-
       /* No need to set exec or read-only flags on special files.  */
 
       /* ### Shouldn't this record a timestamp and size, etc.? */
+      fi->record_fileinfo = FALSE;
+      *install = fi;
       return SVN_NO_ERROR;
     }
 
-  if (svn_subst_translation_required(style, eol, keywords,
-                                     FALSE /* special */,
-                                     TRUE /* force_eol_check */))
-    {
-      /* Wrap it in a translating (expanding) stream.  */
-      src_stream = svn_subst_stream_translated(src_stream, eol,
-                                               TRUE /* repair */,
-                                               keywords,
-                                               TRUE /* expand */,
-                                               scratch_pool);
-    }
-
   /* Where is the Right Place to put a temp file in this working copy?  */
-  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&temp_dir_abspath,
+  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&fi->temp_dir_abspath,
                                          db, wcroot_abspath,
-                                         scratch_pool, scratch_pool));
+                                         result_pool, scratch_pool));
 
-  /* Translate to a temporary file. We don't want the user seeing a partial
-     file, nor let them muck with it while we translate. We may also need to
-     get its TRANSLATED_SIZE before the user can monkey it.  */
-  SVN_ERR(svn_stream__create_for_install(&dst_stream, temp_dir_abspath,
-                                         scratch_pool, scratch_pool));
-
-  /* Copy from the source to the dest, translating as we go. This will also
-     close both streams.  */
-  SVN_ERR(svn_stream_copy3(src_stream, dst_stream,
-                           cancel_func, cancel_baton,
-                           scratch_pool));
-
-  /* All done. Move the file into place.  */
-  /* With a single db we might want to install files in a missing directory.
-     Simply trying this scenario on error won't do any harm and at least
-     one user reported this problem on IRC. */
-  SVN_ERR(svn_stream__install_stream(dst_stream, local_abspath,
-                                     TRUE /* make_parents*/, scratch_pool));
-
-  /* Tweak the on-disk file according to its properties.  */
 #ifndef WIN32
-  if (props && svn_hash_gets(props, SVN_PROP_EXECUTABLE))
-    SVN_ERR(svn_io_set_file_executable(local_abspath, TRUE, FALSE,
-                                       scratch_pool));
+  fi->set_executable = (props && svn_hash_gets(props, SVN_PROP_EXECUTABLE));
 #endif
 
   /* Note that this explicitly checks the pristine properties, to make sure
@@ -605,25 +581,137 @@ run_file_install(work_item_baton_t *wqb,
                                    NULL, NULL, NULL, NULL, NULL, NULL, NULL,
                                    NULL, NULL, &lock, NULL, NULL, NULL, NULL,
                                    NULL, NULL, NULL, NULL, NULL, NULL,
-                                   db, local_abspath,
+                                   db, fi->local_abspath,
                                    scratch_pool, scratch_pool));
 
-      if (!lock && status != svn_wc__db_status_added)
-        SVN_ERR(svn_io_set_file_read_only(local_abspath, FALSE, scratch_pool));
+      fi->set_read_only = (!lock && status != svn_wc__db_status_added);
     }
 
   if (use_commit_times)
+    fi->affected_time = changed_date;
+
+  *install = fi;
+  return SVN_NO_ERROR;
+}
+
+/* Install the working file described by INSTALL.  This does not access
+ * the working copy database and may therefore run in any thread.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+install_file(const file_install_t *install,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *scratch_pool)
+{
+  svn_stream_t *src_stream;
+  svn_stream_t *dst_stream;
+
+  if (install->special)
     {
-      if (changed_date)
-        SVN_ERR(svn_io_set_file_affected_time(changed_date,
-                                              local_abspath,
+      SVN_ERR(svn_stream_open_readonly(&src_stream, install->source_abspath,
+                                       scratch_pool, scratch_pool));
+
+      /* When this stream is closed, the resulting special file will
+         atomically be created/moved into place at LOCAL_ABSPATH.  */
+      SVN_ERR(svn_subst_create_specialfile(&dst_stream,
+                                           install->local_abspath,
+                                           scratch_pool, scratch_pool));
+
+      /* Copy the "repository normal" form of the special file into the
+         special stream.  */
+      return svn_error_trace(svn_stream_copy3(src_stream, dst_stream,
+                                              cancel_func, cancel_baton,
                                               scratch_pool));
     }
 
+  /* Translate to a temporary file. We don't want the user seeing a partial
+     file, nor let them muck with it while we translate. We may also need to
+     get its TRANSLATED_SIZE before the user can monkey it.  */
+  SVN_ERR(svn_stream__create_for_install(&dst_stream,
+                                         install->temp_dir_abspath,
+                                         scratch_pool, scratch_pool));
+
+  if (svn_subst_translation_required(install->style, install->eol,
+                                     install->keywords,
+                                     FALSE /* special */,
+                                     TRUE /* force_eol_check */))
+    {
+      SVN_ERR(svn_stream_open_readonly(&src_stream, install->source_abspath,
+                                       scratch_pool, scratch_pool));
+
+      /* Wrap it in a translating (expanding) stream.  */
+      src_stream = svn_subst_stream_translated(src_stream, install->eol,
+                                               TRUE /* repair */,
+                                               install->keywords,
+                                               TRUE /* expand */,
+                                               scratch_pool);
+
+      /* Copy from the source to the dest, translating as we go. This will
+         also close both streams.  */
+      SVN_ERR(svn_stream_copy3(src_stream, dst_stream,
+                               cancel_func, cancel_baton,
+                               scratch_pool));
+    }
+  else
+    {
+      apr_file_t *src_file;
+
+      /* The working file is an exact copy of the source, which copy-on-write
+         file systems can create without writing the data again. */
+      SVN_ERR(svn_io_file_open(&src_file, install->source_abspath,
+                               APR_READ, APR_OS_DEFAULT, scratch_pool));
+      SVN_ERR(svn_io__file_clone(src_file, svn_stream__aprfile(dst_stream),
+                                 scratch_pool));
+      SVN_ERR(svn_io_file_close(src_file, scratch_pool));
+      SVN_ERR(svn_stream_close(dst_stream));
+    }
+
+  /* All done. Move the file into place.  */
+  /* With a single db we might want to install files in a missing directory.
+     Simply trying this scenario on error won't do any harm and at least
+     one user reported this problem on IRC. */
+  SVN_ERR(svn_stream__install_stream(dst_stream, install->local_abspath,
+                                     TRUE /* make_parents*/, scratch_pool));
+
+  /* Tweak the on-disk file according to its properties.  */
+  if (install->set_executable)
+    SVN_ERR(svn_io_set_file_executable(install->local_abspath, TRUE, FALSE,
+                                       scratch_pool));
+
+  if (install->set_read_only)
+    SVN_ERR(svn_io_set_file_read_only(install->local_abspath, FALSE,
+                                      scratch_pool));
+
+  if (install->affected_time)
+    SVN_ERR(svn_io_set_file_affected_time(install->affected_time,
+                                          install->local_abspath,
+                                          scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Process the OP_FILE_INSTALL work item WORK_ITEM.
+ * See svn_wc__wq_build_file_install() which generates this work item.
+ * Implements (struct work_item_dispatch).func. */
+static svn_error_t *
+run_file_install(work_item_baton_t *wqb,
+                 svn_wc__db_t *db,
+                 const svn_skel_t *work_item,
+                 const char *wri_abspath,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *scratch_pool)
+{
+  file_install_t *install;
+
+  SVN_ERR(prepare_file_install(&install, db, work_item, wri_abspath,
+                               scratch_pool, scratch_pool));
+  SVN_ERR(install_file(install, cancel_func, cancel_baton, scratch_pool));
+
   /* ### this should happen before we rename the file into place.  */
-  if (record_fileinfo)
+  if (install->record_fileinfo)
     {
-      SVN_ERR(get_and_record_fileinfo(wqb, local_abspath,
+      SVN_ERR(get_and_record_fileinfo(wqb, install->local_abspath,
                                       FALSE /* ignore_enoent */,
                                       scratch_pool));
     }
@@ -760,7 +848,9 @@ run_dir_remove(work_item_baton_t *wqb,
   /* Remove the path, no worrying if it isn't there.  */
   if (recursive)
     return svn_error_trace(
-                svn_io_remove_dir2(local_abspath, TRUE,
+                svn_io__remove_dir_concurrently(
+                                   local_abspath, TRUE,
+                                   svn_wc__db_cleanup_threads(db),
                                    cancel_func, cancel_baton,
                                    scratch_pool));
   else
@@ -1412,8 +1502,6 @@ struct work_item_baton_t
 {
   apr_pool_t *result_pool; /* Pool to allocate result in */
 
-  svn_boolean_t used; /* needs reset */
-
   apr_hash_t *record_map; /* const char * -> svn_io_dirent2_t map */
 };
 
@@ -1473,6 +1561,299 @@ dispatch_work_item(work_item_baton_t *wqb,
   return SVN_NO_ERROR;
 }
 
+/* Return ERR, the failure of WORK_ITEM with id ID in the work queue for
+   WRI_ABSPATH, wrapped in an SVN_ERR_WC_BAD_ADM_LOG error. */
+static svn_error_t *
+wrap_work_item_error(svn_error_t *err,
+                     const char *wri_abspath,
+                     apr_uint64_t id,
+                     const svn_skel_t *work_item,
+                     apr_pool_t *scratch_pool)
+{
+  const char *skel = svn_skel__unparse(work_item, scratch_pool)->data;
+
+  return svn_error_createf(SVN_ERR_WC_BAD_ADM_LOG, err,
+                           _("Failed to run the WC DB work queue "
+                             "associated with '%s', work item %d %s"),
+                           svn_dirent_local_style(wri_abspath,
+                                                  scratch_pool),
+                           (int)id, skel);
+}
+
+/* A run of OP_FILE_INSTALL work items being installed concurrently. */
+typedef struct install_batch_t
+{
+  /* The work items (svn_wc__db_wq_item_t *) and what has been prepared
+     for them (file_install_t *), in queue order. */
+  apr_array_header_t *items;
+  apr_array_header_t *installs;
+
+  /* The ids (apr_uint64_t) of the items installed so far and the
+     fileinfo to record for them. */
+  apr_array_header_t *completed_ids;
+  apr_hash_t *record_map;
+
+  /* Pool to allocate the above in. */
+  apr_pool_t *pool;
+} install_batch_t;
+
+/* Install the file of the batch item with the given INDEX and return its
+ * svn_io_dirent2_t in *RESULT if its fileinfo shall be recorded.
+ * Implements svn_task__process_func_t. */
+static svn_error_t *
+install_batch_item(void **result,
+                   int index,
+                   void *process_baton,
+                   void *thread_context,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  install_batch_t *batch = process_baton;
+  const file_install_t *install
+    = APR_ARRAY_IDX(batch->installs, index, const file_install_t *);
+  const svn_io_dirent2_t *dirent = NULL;
+
+  SVN_ERR(install_file(install, cancel_func, cancel_baton, scratch_pool));
+
+  if (install->record_fileinfo)
+    SVN_ERR(svn_io_stat_dirent2(&dirent, install->local_abspath, FALSE,
+                                FALSE /* ignore_enoent */,
+                                result_pool, scratch_pool));
+
+  *result = (void *)dirent;
+  return SVN_NO_ERROR;
+}
+
+/* Remember the batch item with the given INDEX as completed, together
+ * with the fileinfo in RESULT.
+ * Implements svn_task__output_func_t. */
+static svn_error_t *
+complete_batch_item(void *result,
+                    int index,
+                    void *output_baton,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *scratch_pool)
+{
+  install_batch_t *batch = output_baton;
+  const svn_io_dirent2_t *dirent = result;
+  const file_install_t *install
+    = APR_ARRAY_IDX(batch->installs, index, const file_install_t *);
+  const svn_wc__db_wq_item_t *item
+    = APR_ARRAY_IDX(batch->items, index, const svn_wc__db_wq_item_t *);
+
+  if (dirent && dirent->kind == svn_node_file)
+    svn_hash_sets(batch->record_map, install->local_abspath,
+                  svn_io_dirent2_dup(dirent, batch->pool));
+
+  APR_ARRAY_PUSH(batch->completed_ids, apr_uint64_t) = item->id;
+
+  return SVN_NO_ERROR;
+}
+
+/* Process the OP_FILE_INSTALL work item WORK_ITEM with id ID in the work
+   queue for WRI_ABSPATH together with the file installs that directly
+   follow it, using up to THREAD_COUNT threads to install the files.
+   Mark all items processed successfully as completed, even on error.
+
+   Only the file installs themselves run concurrently.  Reading their
+   information from DB and updating the queue happens in this thread. */
+static svn_error_t *
+run_file_install_batch(svn_wc__db_t *db,
+                       const char *wri_abspath,
+                       apr_uint64_t id,
+                       svn_skel_t *work_item,
+                       int thread_count,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *scratch_pool)
+{
+  install_batch_t batch;
+  svn_wc__db_wq_item_t *first;
+  apr_array_header_t *candidates;
+  apr_array_header_t *following;
+  apr_hash_t *seen = apr_hash_make(scratch_pool);
+  svn_error_t *err;
+  int i;
+
+  first = apr_palloc(scratch_pool, sizeof(*first));
+  first->id = id;
+  first->work_item = work_item;
+
+  SVN_ERR(svn_wc__db_wq_fetch_following(&following, db, wri_abspath, id,
+                                        8 * thread_count - 1,
+                                        scratch_pool, scratch_pool));
+  candidates = apr_array_make(scratch_pool, following->nelts + 1,
+                              sizeof(svn_wc__db_wq_item_t *));
+  APR_ARRAY_PUSH(candidates, svn_wc__db_wq_item_t *) = first;
+  apr_array_cat(candidates, following);
+
+  batch.items = apr_array_make(scratch_pool, candidates->nelts,
+                               sizeof(svn_wc__db_wq_item_t *));
+  batch.installs = apr_array_make(scratch_pool, candidates->nelts,
+                                  sizeof(file_install_t *));
+  batch.completed_ids = apr_array_make(scratch_pool, candidates->nelts,
+                                       sizeof(apr_uint64_t));
+  batch.record_map = apr_hash_make(scratch_pool);
+  batch.pool = scratch_pool;
+
+  /* Take the leading run of file installs, stopping at any other kind of
+     item and before installing the same file twice.  If preparing a
+     later item fails, stop there as well: that item will report the
+     error when it is run on its own. */
+  for (i = 0; i < candidates->nelts; i++)
+    {
+      svn_wc__db_wq_item_t *item
+        = APR_ARRAY_IDX(candidates, i, svn_wc__db_wq_item_t *);
+      file_install_t *install;
+
+      if (! svn_skel__matches_atom(item->work_item->children,
+                                   OP_FILE_INSTALL))
+        break;
+
+      err = prepare_file_install(&install, db, item->work_item, wri_abspath,
+                                 scratch_pool, scratch_pool);
+      if (err && i == 0)
+        return wrap_work_item_error(err, wri_abspath, item->id,
+                                    item->work_item, scratch_pool);
+      else if (err)
+        {
+          svn_error_clear(err);
+          break;
+        }
+
+      if (svn_hash_gets(seen, install->local_abspath))
+        break;
+      svn_hash_sets(seen, install->local_abspath, install);
+
+      APR_ARRAY_PUSH(batch.items, svn_wc__db_wq_item_t *) = item;
+      APR_ARRAY_PUSH(batch.installs, file_install_t *) = install;
+    }
+
+  err = svn_task__run(thread_count, batch.items->nelts,
+                      install_batch_item, &batch,
+                      complete_batch_item, &batch,
+                      NULL, NULL,
+                      cancel_func, cancel_baton,
+                      scratch_pool);
+
+  /* All items before the failed one have been completed. */
+  if (err)
+    {
+      const svn_wc__db_wq_item_t *failed
+        = APR_ARRAY_IDX(batch.items, batch.completed_ids->nelts,
+                        const svn_wc__db_wq_item_t *);
+
+      err = wrap_work_item_error(err, wri_abspath, failed->id,
+                                 failed->work_item, scratch_pool);
+    }
+
+  if (batch.completed_ids->nelts > 0)
+    err = svn_error_compose_create(
+            err,
+            svn_wc__db_wq_record_and_complete(db, wri_abspath,
+                                              batch.completed_ids,
+                                              batch.record_map,
+                                              scratch_pool));
+
+  return svn_error_trace(err);
+}
+
+
+/* Run the work item WORK_ITEM with id ID in the work queue for
+   WRI_ABSPATH and the items that follow it one by one, until
+   WQ_BATCH_SIZE items ran or WQ_BATCH_TIME passed.  Then mark the items
+   that ran as completed in a single transaction, even on error.
+
+   If INSTALL_THREADS is greater than 1, stop before the next
+   OP_FILE_INSTALL item, so that it can be run by
+   run_file_install_batch(). */
+static svn_error_t *
+run_work_item_batch(svn_wc__db_t *db,
+                    const char *wri_abspath,
+                    apr_uint64_t id,
+                    svn_skel_t *work_item,
+                    int install_threads,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *scratch_pool)
+{
+  apr_time_t deadline = apr_time_now() + WQ_BATCH_TIME;
+  work_item_baton_t wib = { 0 };
+  svn_wc__db_wq_item_t *first;
+  apr_array_header_t *items;
+  apr_array_header_t *following;
+  apr_array_header_t *completed_ids;
+  apr_pool_t *iterpool;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  first = apr_palloc(scratch_pool, sizeof(*first));
+  first->id = id;
+  first->work_item = work_item;
+
+  SVN_ERR(svn_wc__db_wq_fetch_following(&following, db, wri_abspath, id,
+                                        WQ_BATCH_SIZE - 1,
+                                        scratch_pool, scratch_pool));
+  items = apr_array_make(scratch_pool, following->nelts + 1,
+                         sizeof(svn_wc__db_wq_item_t *));
+  APR_ARRAY_PUSH(items, svn_wc__db_wq_item_t *) = first;
+  apr_array_cat(items, following);
+
+  completed_ids = apr_array_make(scratch_pool, items->nelts,
+                                 sizeof(apr_uint64_t));
+  wib.result_pool = scratch_pool;
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < items->nelts; i++)
+    {
+      const svn_wc__db_wq_item_t *item
+        = APR_ARRAY_IDX(items, i, const svn_wc__db_wq_item_t *);
+
+      svn_pool_clear(iterpool);
+
+      if (i > 0
+          && ((install_threads > 1
+               && svn_skel__matches_atom(item->work_item->children,
+                                         OP_FILE_INSTALL))
+              || apr_time_now() > deadline))
+        break;
+
+      /* Stop work queue processing, if requested. A future 'svn cleanup'
+         should be able to continue the processing.  */
+      if (cancel_func)
+        {
+          err = cancel_func(cancel_baton);
+          if (err)
+            break;
+        }
+
+      err = dispatch_work_item(&wib, db, wri_abspath, item->work_item,
+                               cancel_func, cancel_baton, iterpool);
+      if (err)
+        {
+          err = wrap_work_item_error(err, wri_abspath, item->id,
+                                     item->work_item, scratch_pool);
+          break;
+        }
+
+      APR_ARRAY_PUSH(completed_ids, apr_uint64_t) = item->id;
+    }
+  svn_pool_destroy(iterpool);
+
+  if (completed_ids->nelts > 0)
+    err = svn_error_compose_create(
+            err,
+            svn_wc__db_wq_record_and_complete(db, wri_abspath,
+                                              completed_ids,
+                                              wib.record_map,
+                                              scratch_pool));
+
+  return svn_error_trace(err);
+}
+
 
 svn_error_t *
 svn_wc__wq_run(svn_wc__db_t *db,
@@ -1482,9 +1863,7 @@ svn_wc__wq_run(svn_wc__db_t *db,
                apr_pool_t *scratch_pool)
 {
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
-  apr_uint64_t last_id = 0;
-  work_item_baton_t wib = { 0 };
-  wib.result_pool = svn_pool_create(scratch_pool);
+  int install_threads = svn_wc__db_wq_install_threads(db);
 
 #ifdef SVN_DEBUG_WORK_QUEUE
   SVN_DBG(("wq_run: wri='%s'\n", wri_abspath));
@@ -1500,37 +1879,20 @@ svn_wc__wq_run(svn_wc__db_t *db,
   }
 #endif
 
+  /* Commit the database changes the queued items depend on before
+     changing the working files. */
+  SVN_ERR(svn_wc__db_batch_end(db, wri_abspath, iterpool));
+
   while (TRUE)
     {
       apr_uint64_t id;
       svn_skel_t *work_item;
-      svn_error_t *err;
 
       svn_pool_clear(iterpool);
 
-      if (! wib.used)
-        {
-          /* Make sure to do this *early* in the loop iteration. There may
-             be a LAST_ID that needs to be marked as completed, *before* we
-             start worrying about anything else.  */
-          SVN_ERR(svn_wc__db_wq_fetch_next(&id, &work_item, db, wri_abspath,
-                                           last_id, iterpool, iterpool));
-        }
-      else
-        {
-          /* Make sure to do this *early* in the loop iteration. There may
-             be a LAST_ID that needs to be marked as completed, *before* we
-             start worrying about anything else.  */
-          SVN_ERR(svn_wc__db_wq_record_and_fetch_next(&id, &work_item,
-                                                      db, wri_abspath,
-                                                      last_id, wib.record_map,
-                                                      iterpool,
-                                                      wib.result_pool));
-
-          svn_pool_clear(wib.result_pool);
-          wib.record_map = NULL;
-          wib.used = FALSE;
-        }
+      /* The batches below mark their items as completed themselves. */
+      SVN_ERR(svn_wc__db_wq_fetch_next(&id, &work_item, db, wri_abspath,
+                                       0, iterpool, iterpool));
 
       /* Stop work queue processing, if requested. A future 'svn cleanup'
          should be able to continue the processing. Note that we may
@@ -1543,23 +1905,19 @@ svn_wc__wq_run(svn_wc__db_t *db,
       if (work_item == NULL)
         break;
 
-      err = dispatch_work_item(&wib, db, wri_abspath, work_item,
-                               cancel_func, cancel_baton, iterpool);
-      if (err)
-        {
-          const char *skel = svn_skel__unparse(work_item, scratch_pool)->data;
-
-          return svn_error_createf(SVN_ERR_WC_BAD_ADM_LOG, err,
-                                   _("Failed to run the WC DB work queue "
-                                     "associated with '%s', work item %d %s"),
-                                   svn_dirent_local_style(wri_abspath,
-                                                          scratch_pool),
-                                   (int)id, skel);
-        }
-
-      /* The work item finished without error. Mark it completed
-         in the next loop.  */
-      last_id = id;
+      /* Install runs of files concurrently, if configured.  Run other
+         items one by one, but don't commit a transaction for each.  */
+      if (install_threads > 1
+          && svn_skel__matches_atom(work_item->children, OP_FILE_INSTALL))
+        SVN_ERR(run_file_install_batch(db, wri_abspath, id, work_item,
+                                       install_threads,
+                                       cancel_func, cancel_baton,
+                                       iterpool));
+      else
+        SVN_ERR(run_work_item_batch(db, wri_abspath, id, work_item,
+                                    install_threads,
+                                    cancel_func, cancel_baton,
+                                    iterpool));
     }
 
   svn_pool_destroy(iterpool);
@@ -1629,8 +1987,6 @@ get_and_record_fileinfo(work_item_baton_t *wqb,
   if (dirent->kind != svn_node_file)
     return SVN_NO_ERROR;
 
-  wqb->used = TRUE;
-
   if (! wqb->record_map)
     wqb->record_map = apr_hash_make(wqb->result_pool);
 
@@ -36,6 +36,7 @@
 #include <ap_mmn.h>
 #include <apr_uri.h>
 #include <apr_lib.h>
+#include <apr_time.h>
 #include <mod_dav.h>
 
 #include "mod_dav_svn.h"
@@ -445,6 +446,14 @@ get_access_conf(request_rec *r, authz_svn_config_rec *conf,
   svn_authz_t *access_conf = NULL;
   svn_error_t *svn_err = SVN_NO_ERROR;
   dav_error *dav_err;
+  const char *request_key = apr_psprintf(scratch_pool,
+                                         "mod_authz_svn:access_conf:%pp",
+                                         (void *)conf);
+
+  /* Subrequest bypasses call us many times for the same request. */
+  apr_pool_userdata_get(&user_data, request_key, r->pool);
+  if (user_data)
+    return user_data;
 
   dav_err = dav_svn_get_repos_path2(r, conf->base_path, &repos_path, scratch_pool);
   if (dav_err)
@@ -531,9 +540,181 @@ get_access_conf(request_rec *r, authz_svn_config_rec *conf,
                                 NULL, r->connection->pool);
         }
     }
+
+  if (access_conf)
+    apr_pool_userdata_set(access_conf, request_key, NULL, r->pool);
+
   return access_conf;
 }
 
+/* Number of access verdicts remembered per connection. */
+#define VERDICT_CACHE_SIZE 64
+
+/* Key of the per-connection verdict_cache_t in the connection pool. */
+#define VERDICT_CACHE_KEY "mod_authz_svn:verdicts"
+
+/* Key of the authz_stats_t in the pool of the main request. */
+#define AUTHZ_STATS_KEY "mod_authz_svn:stats"
+
+/* A remembered result of svn_repos_authz_check_access(). */
+typedef struct verdict_t
+{
+  /* Identifies the authz rules, user, requested access and path that
+     the verdict applies to.  NULL if this entry has never been used. */
+  svn_stringbuf_t *key;
+
+  /* Whether access was granted. */
+  svn_boolean_t granted;
+
+  /* Value of the cache's clock when this entry was last used. */
+  apr_uint64_t last_used;
+} verdict_t;
+
+/* A small LRU cache of access verdicts, shared by all requests on one
+ * connection.  PROPFIND and log requests check access to many paths,
+ * often the same ones again, through subrequests and subreq_bypass(). */
+typedef struct verdict_cache_t
+{
+  verdict_t entries[VERDICT_CACHE_SIZE];
+
+  /* Maps the keys of the used ENTRIES to the entries. */
+  apr_hash_t *index;
+
+  /* Incremented with every lookup, used to find the LRU entry. */
+  apr_uint64_t clock;
+
+  /* The connection pool. */
+  apr_pool_t *pool;
+} verdict_cache_t;
+
+/* Authz statistics of one request and its subrequests. */
+typedef struct authz_stats_t
+{
+  /* Number of access checks. */
+  int checks;
+
+  /* Number of those answered from the verdict cache. */
+  int cache_hits;
+
+  /* Total time spent in access control. */
+  apr_interval_time_t time;
+} authz_stats_t;
+
+/* Return the verdict cache of the connection of R, creating it if
+   necessary. */
+static verdict_cache_t *
+get_verdict_cache(request_rec *r)
+{
+  void *user_data = NULL;
+  verdict_cache_t *cache;
+
+  apr_pool_userdata_get(&user_data, VERDICT_CACHE_KEY, r->connection->pool);
+  if (user_data)
+    return user_data;
+
+  cache = apr_pcalloc(r->connection->pool, sizeof(*cache));
+  cache->index = apr_hash_make(r->connection->pool);
+  cache->pool = r->connection->pool;
+  apr_pool_userdata_setn(cache, VERDICT_CACHE_KEY, NULL, r->connection->pool);
+
+  return cache;
+}
+
+/* Return the authz statistics of the main request of R, creating them
+   if necessary. */
+static authz_stats_t *
+get_authz_stats(request_rec *r)
+{
+  void *user_data = NULL;
+  authz_stats_t *stats;
+
+  while (r->main)
+    r = r->main;
+
+  apr_pool_userdata_get(&user_data, AUTHZ_STATS_KEY, r->pool);
+  if (user_data)
+    return user_data;
+
+  stats = apr_pcalloc(r->pool, sizeof(*stats));
+  apr_pool_userdata_setn(stats, AUTHZ_STATS_KEY, NULL, r->pool);
+
+  return stats;
+}
+
+/* Like svn_repos_authz_check_access() but remember the verdict in the
+ * verdict cache of the connection of R and reuse earlier verdicts.
+ *
+ * ACCESS_CONF lives as long as the connection and is never modified,
+ * so its address identifies the rules (and, for in-repository authz
+ * files, the revision they were read from) a verdict was made with.
+ */
+static svn_error_t *
+check_access(svn_boolean_t *access_granted,
+             request_rec *r,
+             svn_authz_t *access_conf,
+             const char *repos_name,
+             const char *repos_path,
+             const char *user,
+             svn_repos_authz_access_t required_access,
+             apr_pool_t *scratch_pool)
+{
+  verdict_cache_t *cache = get_verdict_cache(r);
+  authz_stats_t *stats = get_authz_stats(r);
+  verdict_t *verdict;
+  const char *key;
+  int i;
+
+  /* Prefix the user name with its length, so that names containing
+   * spaces can't be confused with other fields.  Repository names can't
+   * contain '/' and REPOS_PATH, if given, starts with one. */
+  key = apr_psprintf(scratch_pool, "%pp %d %s %s:%s",
+                     (void *)access_conf, (int)required_access,
+                     user ? apr_psprintf(scratch_pool,
+                                         "%" APR_SIZE_T_FMT ":%s",
+                                         strlen(user), user)
+                          : "-",
+                     repos_name ? repos_name : "",
+                     repos_path ? repos_path : "");
+
+  stats->checks++;
+  verdict = apr_hash_get(cache->index, key, APR_HASH_KEY_STRING);
+  if (verdict)
+    {
+      stats->cache_hits++;
+      verdict->last_used = ++cache->clock;
+      *access_granted = verdict->granted;
+
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_repos_authz_check_access(access_conf, repos_name, repos_path,
+                                       user, required_access,
+                                       access_granted, scratch_pool));
+
+  /* Replace the least recently used entry.  Unused ones come first. */
+  verdict = &cache->entries[0];
+  for (i = 1; i < VERDICT_CACHE_SIZE; i++)
+    if (cache->entries[i].last_used < verdict->last_used)
+      verdict = &cache->entries[i];
+
+  if (verdict->key)
+    {
+      apr_hash_set(cache->index, verdict->key->data, verdict->key->len,
+                   NULL);
+      svn_stringbuf_set(verdict->key, key);
+    }
+  else
+    {
+      verdict->key = svn_stringbuf_create(key, cache->pool);
+    }
+
+  verdict->granted = *access_granted;
+  verdict->last_used = ++cache->clock;
+  apr_hash_set(cache->index, verdict->key->data, verdict->key->len, verdict);
+
+  return SVN_NO_ERROR;
+}
+
 /* Convert TEXT to upper case if TO_UPPERCASE is TRUE, else
    converts it to lower case. */
 static void
@@ -563,15 +744,11 @@ get_username_to_authorize(request_rec *r, authz_svn_config_rec *conf,
   return username_to_authorize;
 }
 
-/* Check if the current request R is allowed.  Upon exit *REPOS_PATH_REF
- * will contain the path and repository name that an operation was requested
- * on in the form 'name:path'.  *DEST_REPOS_PATH_REF will contain the
- * destination path if the requested operation was a MOVE or a COPY.
- * Returns OK when access is allowed, DECLINED when it isn't, or an HTTP_
- * error code when an error occurred.
+/*
+ * Implementation of req_check_access.
  */
 static int
-req_check_access(request_rec *r,
+req_check_access2(request_rec *r,
                  authz_svn_config_rec *conf,
                  const char **repos_path_ref,
                  const char **dest_repos_path_ref)
@@ -768,12 +945,10 @@ req_check_access(request_rec *r,
   if (repos_path
       || (!repos_path && (authz_svn_type & svn_authz_write)))
     {
-      svn_err = svn_repos_authz_check_access(access_conf, repos_name,
-                                             repos_path,
-                                             username_to_authorize,
-                                             authz_svn_type,
-                                             &authz_access_granted,
-                                             r->pool);
+      svn_err = check_access(&authz_access_granted, r, access_conf,
+                             repos_name, repos_path,
+                             username_to_authorize, authz_svn_type,
+                             r->pool);
       if (svn_err)
         {
           log_svn_error(APLOG_MARK, r,
@@ -803,14 +978,11 @@ req_check_access(request_rec *r,
      repos_path == NULL (see above for explanations) */
   if (repos_path)
     {
-      svn_err = svn_repos_authz_check_access(access_conf,
-                                             dest_repos_name,
-                                             dest_repos_path,
-                                             username_to_authorize,
-                                             svn_authz_write
-                                             |svn_authz_recursive,
-                                             &authz_access_granted,
-                                             r->pool);
+      svn_err = check_access(&authz_access_granted, r, access_conf,
+                             dest_repos_name, dest_repos_path,
+                             username_to_authorize,
+                             svn_authz_write|svn_authz_recursive,
+                             r->pool);
       if (svn_err)
         {
           log_svn_error(APLOG_MARK, r,
@@ -830,6 +1002,28 @@ req_check_access(request_rec *r,
   return OK;
 }
 
+/* Check if the current request R is allowed.  Upon exit *REPOS_PATH_REF
+ * will contain the path and repository name that an operation was requested
+ * on in the form 'name:path'.  *DEST_REPOS_PATH_REF will contain the
+ * destination path if the requested operation was a MOVE or a COPY.
+ * Returns OK when access is allowed, DECLINED when it isn't, or an HTTP_
+ * error code when an error occurred.
+ */
+static int
+req_check_access(request_rec *r,
+                 authz_svn_config_rec *conf,
+                 const char **repos_path_ref,
+                 const char **dest_repos_path_ref)
+{
+  apr_time_t start = apr_time_now();
+  int status;
+
+  status = req_check_access2(r, conf, repos_path_ref, dest_repos_path_ref);
+  get_authz_stats(r)->time += apr_time_now() - start;
+
+  return status;
+}
+
 /*
  * Implementation of subreq_bypass with scratch_pool parameter.
  */
@@ -867,12 +1061,11 @@ subreq_bypass2(request_rec *r,
    */
   if (repos_path)
     {
-      svn_err = svn_repos_authz_check_access(access_conf, repos_name,
-                                             repos_path,
-                                             username_to_authorize,
-                                             svn_authz_none|svn_authz_read,
-                                             &authz_access_granted,
-                                             scratch_pool);
+      svn_err = check_access(&authz_access_granted, r, access_conf,
+                             repos_name, repos_path,
+                             username_to_authorize,
+                             svn_authz_none|svn_authz_read,
+                             scratch_pool);
       if (svn_err)
         {
           log_svn_error(APLOG_MARK, r,
@@ -904,10 +1097,12 @@ subreq_bypass(request_rec *r,
 {
   int status;
   apr_pool_t *scratch_pool;
+  apr_time_t start = apr_time_now();
 
   scratch_pool = svn_pool_create(r->pool);
   status = subreq_bypass2(r, repos_path, repos_name, scratch_pool);
   svn_pool_destroy(scratch_pool);
+  get_authz_stats(r)->time += apr_time_now() - start;
 
   return status;
 }
@@ -1107,6 +1302,35 @@ auth_checker(request_rec *r)
   return OK;
 }
 
+/* Publish the authz statistics of the main request R as the request
+ * notes "authz_svn-checks", "authz_svn-cache-hits" and "authz_svn-usec",
+ * so that they can be logged with e.g. "%{authz_svn-usec}n" in a
+ * LogFormat. */
+static int
+log_authz_stats(request_rec *r)
+{
+  void *user_data = NULL;
+  const authz_stats_t *stats;
+
+  apr_pool_userdata_get(&user_data, AUTHZ_STATS_KEY, r->pool);
+  if (!user_data)
+    return DECLINED;
+
+  stats = user_data;
+  apr_table_setn(r->notes, "authz_svn-checks",
+                 apr_itoa(r->pool, stats->checks));
+  apr_table_setn(r->notes, "authz_svn-cache-hits",
+                 apr_itoa(r->pool, stats->cache_hits));
+  apr_table_setn(r->notes, "authz_svn-usec",
+                 apr_psprintf(r->pool, "%" APR_TIME_T_FMT, stats->time));
+
+  ap_log_rerror(APLOG_MARK, APLOG_DEBUG, 0, r,
+                "authz: %d checks, %d cached, %" APR_TIME_T_FMT " usec",
+                stats->checks, stats->cache_hits, stats->time);
+
+  return DECLINED;
+}
+
 #if USE_FORCE_AUTHN
 static int
 force_authn(request_rec *r)
@@ -1134,6 +1358,8 @@ register_hooks(apr_pool_t *p)
    * give SSLOptions +FakeBasicAuth a chance to work. */
   ap_hook_check_user_id(check_user_id, mod_ssl, NULL, APR_HOOK_FIRST);
   ap_hook_auth_checker(auth_checker, NULL, NULL, APR_HOOK_FIRST);
+  /* Before mod_log_config writes the notes to the log. */
+  ap_hook_log_transaction(log_authz_stats, NULL, NULL, APR_HOOK_FIRST);
 #if USE_FORCE_AUTHN
   ap_hook_force_authn(force_authn, NULL, NULL, APR_HOOK_FIRST);
 #endif
@@ -34,12 +34,13 @@
 #include "dav_svn.h"
 
 
-svn_boolean_t
-dav_svn__allow_read(request_rec *r,
-                    const dav_svn_repos *repos,
-                    const char *path,
-                    svn_revnum_t rev,
-                    apr_pool_t *pool)
+/* The implementation of dav_svn__allow_read() for enabled path authz. */
+static svn_boolean_t
+allow_read(request_rec *r,
+           const dav_svn_repos *repos,
+           const char *path,
+           svn_revnum_t rev,
+           apr_pool_t *pool)
 {
   const char *uri;
   request_rec *subreq;
@@ -47,13 +48,6 @@ dav_svn__allow_read(request_rec *r,
   svn_boolean_t allowed = FALSE;
   authz_svn__subreq_bypass_func_t allow_read_bypass = NULL;
 
-  /* Easy out:  if the admin has explicitly set 'SVNPathAuthz Off',
-     then this whole callback does nothing. */
-  if (! dav_svn__get_pathauthz_flag(r))
-    {
-      return TRUE;
-    }
-
   /* Sometimes we get paths that do not start with '/' and
      hence below uri concatenation would lead to wrong uris .*/
   if (path && path[0] != '/')
@@ -98,6 +92,31 @@ dav_svn__allow_read(request_rec *r,
 }
 
 
+svn_boolean_t
+dav_svn__allow_read(request_rec *r,
+                    const dav_svn_repos *repos,
+                    const char *path,
+                    svn_revnum_t rev,
+                    apr_pool_t *pool)
+{
+  apr_time_t start;
+  svn_boolean_t allowed;
+
+  /* Easy out:  if the admin has explicitly set 'SVNPathAuthz Off',
+     then this whole callback does nothing. */
+  if (! dav_svn__get_pathauthz_flag(r))
+    {
+      return TRUE;
+    }
+
+  start = apr_time_now();
+  allowed = allow_read(r, repos, path, rev, pool);
+  dav_svn__add_phase_time(r, DAV_SVN__PHASE_AUTHZ, start);
+
+  return allowed;
+}
+
+
 svn_boolean_t
 dav_svn__allow_list_repos(request_rec *r,
                           const char *repos_name,
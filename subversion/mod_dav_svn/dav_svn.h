@@ -306,6 +306,11 @@ struct dav_resource_private {
 
   /* resource is accessed by 'public' uri (not under "!svn") */
   svn_boolean_t is_public_uri;
+
+  /* If RANGE_LENGTH is not 0, a GET of this file delivers only the
+     RANGE_LENGTH bytes starting at RANGE_OFFSET (HTTP Range request). */
+  svn_filesize_t range_offset;
+  svn_filesize_t range_length;
 };
 
 
@@ -347,6 +352,10 @@ dav_svn__get_nodeprop_cache_flag(request_rec *r);
  * request? */
 svn_boolean_t dav_svn__get_block_read_flag(request_rec *r);
 
+/* for the repository referred to by this request, shall svndiff responses
+ * for immutable resources be cached? */
+svn_boolean_t dav_svn__get_response_cache_flag(request_rec *r);
+
 /* for the repository referred to by this request, are subrequests bypassed?
  * A function pointer if yes, NULL if not.
  */
@@ -416,6 +425,12 @@ const char *dav_svn__get_master_uri(request_rec *r);
    Comes from the <SVNMasterVersion> directive. */
 svn_version_t *dav_svn__get_master_version(request_rec *r);
 
+/* Return whether read requests for revisions that the master server has
+   but this slave has not synced yet shall be proxied to the master.
+   Always FALSE if no master URI is in place for this location.
+   Comes from the <SVNMasterReadThrough> directive. */
+svn_boolean_t dav_svn__get_master_read_through_flag(request_rec *r);
+
 /* Return the disk path to the activities db.
    Comes from the <SVNActivitiesDB> directive. */
 const char *dav_svn__get_activities_db(request_rec *r);
@@ -431,6 +446,11 @@ int dav_svn__get_compression_level(request_rec *r);
 /* Return the hook script environment parsed from the configuration. */
 const char *dav_svn__get_hooks_env(request_rec *r);
 
+/* Return the number of bytes of each changed file that an update report
+   in skelta mode shall read ahead before telling the client to fetch it.
+   0 disables the read-ahead. */
+apr_size_t dav_svn__get_update_read_ahead(request_rec *r);
+
 /** For HTTP protocol v2, these are the new URIs and URI stubs
     returned to the client in our OPTIONS response.  They all depend
     on the 'special uri', which is configurable in httpd.conf.  **/
@@ -533,6 +553,37 @@ int dav_svn__method_post(request_rec *r);
 /* Request handler to GET Subversion internal status (FSFS cache). */
 int dav_svn__status(request_rec *r);
 
+
+/*** Request phase timers ***/
+
+/* The phases of a request whose durations are being recorded.  They
+   may overlap, e.g. an update report also sends data while it is being
+   driven. */
+typedef enum dav_svn__phase_t
+{
+  DAV_SVN__PHASE_AUTHZ,     /* path-based authorization checks */
+  DAV_SVN__PHASE_FS_OPEN,   /* opening the repository */
+  DAV_SVN__PHASE_REPORT,    /* driving the update reporter */
+  DAV_SVN__PHASE_SEND,      /* passing response data to the network */
+  DAV_SVN__PHASE_COUNT
+} dav_svn__phase_t;
+
+/* Add the time elapsed since START to the total of PHASE for the main
+   request of R.  The totals are exported as the request notes and
+   environment variables SVN-TIME-AUTHZ, SVN-TIME-FS-OPEN, SVN-TIME-REPORT
+   and SVN-TIME-SEND, in microseconds, before the request gets logged. */
+void
+dav_svn__add_phase_time(request_rec *r,
+                        dav_svn__phase_t phase,
+                        apr_time_t start);
+
+/* Set *REQUESTS to the number of requests that this process has logged
+   with phase timers and TOTALS[i] to the sum of their times for phase i,
+   in microseconds. */
+void
+dav_svn__get_phase_totals(apr_uint64_t *requests,
+                          apr_interval_time_t totals[DAV_SVN__PHASE_COUNT]);
+
 /*** repos.c ***/
 
 /* generate an ETag for RESOURCE and return it, allocated in POOL. */
@@ -1134,6 +1185,11 @@ dav_svn__fuzzy_escape_author(const char *author,
 
 /*** mirror.c ***/
 
+/* Initialize the process-wide state of mirror.c in POOL, which must
+   live as long as the child process. */
+svn_error_t *
+dav_svn__mirror_child_init(apr_pool_t *pool);
+
 /* Perform the fixup hook for the R request.  */
 int dav_svn__proxy_request_fixup(request_rec *r);
 
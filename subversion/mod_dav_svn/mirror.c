@@ -28,9 +28,223 @@
 #include <httpd.h>
 #include <http_core.h>
 
+#include "svn_hash.h"
+#include "svn_dav.h"
 #include "private/svn_fspath.h"
+#include "private/svn_mutex.h"
 
 #include "dav_svn.h"
+#include "mod_dav_svn.h"
+
+
+/* How often a slave that is behind its master re-reads the youngest
+   revision of its own repository, i.e. how soon it notices that svnsync
+   has caught up. */
+#define LOCAL_YOUNGEST_RECHECK_INTERVAL apr_time_from_sec(1)
+
+/* Key of the repository path stashed in the request pool by the fixup
+   hook for dav_svn__location_header_filter. */
+#define REPOS_PATH_KEY "mod_dav_svn:mirror-repos-path"
+
+/* What a slave knows about the youngest revisions of one repository. */
+typedef struct youngest_revs_t
+{
+    /* Youngest revision seen in responses of the master server, or
+       SVN_INVALID_REVNUM if we have not seen any. */
+    svn_revnum_t master;
+
+    /* Youngest revision of the local repository when last checked, or
+       SVN_INVALID_REVNUM. */
+    svn_revnum_t local;
+
+    /* When LOCAL was last checked. */
+    apr_time_t checked;
+} youngest_revs_t;
+
+/* Maps repository paths to youngest_revs_t for SVNMasterReadThrough.
+   NULL if initialization failed.  Access to it and its pool is
+   serialized by YOUNGEST_REVS_MUTEX. */
+static apr_hash_t *youngest_revs = NULL;
+static svn_mutex__t *youngest_revs_mutex = NULL;
+
+svn_error_t *dav_svn__mirror_child_init(apr_pool_t *pool)
+{
+    SVN_ERR(svn_mutex__init(&youngest_revs_mutex, TRUE, pool));
+    youngest_revs = apr_hash_make(pool);
+
+    return SVN_NO_ERROR;
+}
+
+/* Return the entry for REPOS_PATH in YOUNGEST_REVS, creating it if
+   necessary.  The caller must hold YOUNGEST_REVS_MUTEX. */
+static youngest_revs_t *lookup_youngest_revs(const char *repos_path)
+{
+    youngest_revs_t *revs = svn_hash_gets(youngest_revs, repos_path);
+    if (!revs) {
+        apr_pool_t *pool = apr_hash_pool_get(youngest_revs);
+
+        revs = apr_palloc(pool, sizeof(*revs));
+        revs->master = SVN_INVALID_REVNUM;
+        revs->local = SVN_INVALID_REVNUM;
+        revs->checked = 0;
+        svn_hash_sets(youngest_revs, apr_pstrdup(pool, repos_path), revs);
+    }
+
+    return revs;
+}
+
+/* Set *REVS to a copy of what we know about REPOS_PATH. */
+static svn_error_t *get_youngest_revs(youngest_revs_t *revs,
+                                      const char *repos_path)
+{
+    SVN_ERR(svn_mutex__lock(youngest_revs_mutex));
+    *revs = *lookup_youngest_revs(repos_path);
+
+    return svn_error_trace(svn_mutex__unlock(youngest_revs_mutex,
+                                             SVN_NO_ERROR));
+}
+
+/* Record that the master's repository for REPOS_PATH has at least
+   revision YOUNGEST. */
+static svn_error_t *set_master_youngest(const char *repos_path,
+                                        svn_revnum_t youngest)
+{
+    youngest_revs_t *revs;
+
+    SVN_ERR(svn_mutex__lock(youngest_revs_mutex));
+    revs = lookup_youngest_revs(repos_path);
+    if (!SVN_IS_VALID_REVNUM(revs->master) || revs->master < youngest)
+        revs->master = youngest;
+
+    return svn_error_trace(svn_mutex__unlock(youngest_revs_mutex,
+                                             SVN_NO_ERROR));
+}
+
+/* Record that the local repository at REPOS_PATH had YOUNGEST as its
+   youngest revision at time NOW. */
+static svn_error_t *set_local_youngest(const char *repos_path,
+                                       svn_revnum_t youngest,
+                                       apr_time_t now)
+{
+    youngest_revs_t *revs;
+
+    SVN_ERR(svn_mutex__lock(youngest_revs_mutex));
+    revs = lookup_youngest_revs(repos_path);
+    revs->local = youngest;
+    revs->checked = now;
+
+    return svn_error_trace(svn_mutex__unlock(youngest_revs_mutex,
+                                             SVN_NO_ERROR));
+}
+
+/* If URI_SEGMENT (relative to the repository root) addresses a
+   revision-pinned special resource, i.e. a revision resource, a
+   revision root or a baseline collection, set *REV to its revision and
+   return TRUE.  Otherwise, return FALSE.  SPECIAL_URI is as configured
+   by SVNSpecialURI. */
+static svn_boolean_t get_pinned_revision(svn_revnum_t *rev,
+                                         const char *uri_segment,
+                                         const char *special_uri)
+{
+    static const char * const prefixes[] = { "/rvr/", "/rev/", "/bc/",
+                                             "/ver/", NULL };
+    apr_size_t special_len = strlen(special_uri);
+    int i;
+
+    if (uri_segment[0] != '/'
+        || strncmp(uri_segment + 1, special_uri, special_len) != 0)
+        return FALSE;
+
+    uri_segment += 1 + special_len;
+    for (i = 0; prefixes[i]; ++i) {
+        apr_size_t prefix_len = strlen(prefixes[i]);
+        const char *end;
+        svn_error_t *err;
+
+        if (strncmp(uri_segment, prefixes[i], prefix_len) != 0)
+            continue;
+
+        err = svn_revnum_parse(rev, uri_segment + prefix_len, &end);
+        if (err) {
+            svn_error_clear(err);
+            return FALSE;
+        }
+
+        return *end == '\0' || *end == '/';
+    }
+
+    return FALSE;
+}
+
+/* Set *LOCAL to TRUE if the read request R for URI_SEGMENT (relative to
+   the root of the repository at REPOS_PATH) can be answered from the
+   local repository.  That is the case unless the master is known to have
+   revisions that we don't have yet and the request does not explicitly
+   address a revision that we have.  SPECIAL_URI is as configured by
+   SVNSpecialURI.
+
+   While we are behind, the youngest local revision is re-read at most
+   every LOCAL_YOUNGEST_RECHECK_INTERVAL.  Once we have caught up, we
+   don't look at the local repository again until the master reports a
+   newer revision. */
+static svn_error_t *can_serve_locally(svn_boolean_t *local,
+                                      request_rec *r,
+                                      const char *repos_path,
+                                      const char *uri_segment,
+                                      const char *special_uri)
+{
+    youngest_revs_t revs;
+    svn_revnum_t rev;
+    apr_time_t now;
+
+    SVN_ERR(get_youngest_revs(&revs, repos_path));
+    if (!SVN_IS_VALID_REVNUM(revs.master)
+        || (SVN_IS_VALID_REVNUM(revs.local) && revs.local >= revs.master)) {
+        *local = TRUE;
+        return SVN_NO_ERROR;
+    }
+
+    now = apr_time_now();
+    if (now - revs.checked >= LOCAL_YOUNGEST_RECHECK_INTERVAL) {
+        svn_repos_t *repos;
+
+        SVN_ERR(svn_repos_open3(&repos, repos_path, NULL, r->pool, r->pool));
+        SVN_ERR(svn_fs_youngest_rev(&revs.local, svn_repos_fs(repos),
+                                    r->pool));
+        SVN_ERR(set_local_youngest(repos_path, revs.local, now));
+
+        if (revs.local >= revs.master) {
+            *local = TRUE;
+            return SVN_NO_ERROR;
+        }
+    }
+
+    *local = (SVN_IS_VALID_REVNUM(revs.local)
+              && get_pinned_revision(&rev, uri_segment, special_uri)
+              && rev <= revs.local);
+
+    return SVN_NO_ERROR;
+}
+
+
+/* Return TRUE if the master at MASTER_URI serves its repository at the
+   same path as we serve ours at ROOT_DIR.  Only then can the master's
+   OPTIONS response, which reports the HTTPv2 resource stubs and the
+   youngest revision in headers that we don't rewrite, be passed on to
+   the client of request R. */
+static svn_boolean_t same_root_dir(request_rec *r,
+                                   const char *master_uri,
+                                   const char *root_dir)
+{
+    apr_uri_t uri;
+
+    if (apr_uri_parse(r->pool, master_uri, &uri) != APR_SUCCESS
+        || !uri.path)
+        return FALSE;
+
+    return strcmp(svn_urlpath__canonicalize(uri.path, r->pool),
+                  root_dir) == 0;
+}
 
 
 /* Tweak the request record R, and add the necessary filters, so that
@@ -86,6 +300,48 @@ int dav_svn__proxy_request_fixup(request_rec *r)
 
     if (root_dir && master_uri) {
         const char *seg;
+        const char *repos_path = NULL;
+
+        /* Remember which repository this is about, so we can attribute
+           the youngest revision reported by the master to it, even
+           after R->URI has been rewritten for proxying. */
+        if (youngest_revs && dav_svn__get_master_read_through_flag(r)
+            && ! dav_svn_get_repos_path2(r, root_dir, &repos_path, r->pool))
+            apr_pool_userdata_setn(repos_path, REPOS_PATH_KEY, NULL,
+                                   r->pool);
+
+        /* While the master has revisions that we don't, forward reads
+           that we can't answer with up-to-date data.  The master's
+           responses are subject to the same URI rewriting (and issue
+           #3445) as any other proxied request. */
+        if (repos_path
+            && (r->method_number == M_REPORT ||
+                r->method_number == M_PROPFIND ||
+                r->method_number == M_GET ||
+                (r->method_number == M_OPTIONS
+                 && same_root_dir(r, master_uri, root_dir)))
+            && (seg = ap_strstr(r->uri, root_dir))) {
+            svn_boolean_t local;
+            svn_error_t *serr;
+
+            seg += strlen(root_dir);
+            serr = can_serve_locally(&local, r, repos_path, seg,
+                                     special_uri);
+            if (serr) {
+                ap_log_rerror(APLOG_MARK, APLOG_WARNING, serr->apr_err, r,
+                              "Can't determine whether to proxy '%s' to "
+                              "the master: %s", r->uri,
+                              serr->message ? serr->message : "");
+                svn_error_clear(serr);
+                local = TRUE;
+            }
+
+            if (! local) {
+                int rv = proxy_request_fixup(r, master_uri, seg);
+                if (rv) return rv;
+                return OK;
+            }
+        }
 
         /* We know we can always safely handle these. */
         if (r->method_number == M_REPORT ||
@@ -249,6 +505,23 @@ apr_status_t dav_svn__location_header_filter(ap_filter_t *f,
         return ap_pass_brigade(f->next, bb);
     }
 
+    /* Note the master's youngest revision, so that we can forward reads
+       that we can't serve until svnsync catches up. */
+    if (dav_svn__get_master_read_through_flag(r)) {
+        const char *youngest = apr_table_get(r->headers_out,
+                                             SVN_DAV_YOUNGEST_REV_HEADER);
+        void *repos_path = NULL;
+        svn_revnum_t rev;
+
+        apr_pool_userdata_get(&repos_path, REPOS_PATH_KEY, r->pool);
+        if (youngest && repos_path) {
+            svn_error_t *serr = svn_revnum_parse(&rev, youngest, NULL);
+            if (!serr)
+                serr = set_master_youngest(repos_path, rev);
+            svn_error_clear(serr);
+        }
+    }
+
     location = apr_table_get(r->headers_out, "Location");
     if (location) {
         start_foo = ap_strstr_c(location, master_uri);
@@ -35,6 +35,8 @@
 #include <mod_dav.h>
 
 #include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_dirent_uri.h"
 #include "svn_version.h"
 #include "svn_cache_config.h"
 #include "svn_utf.h"
@@ -42,7 +44,10 @@
 #include "svn_dso.h"
 #include "mod_dav_svn.h"
 
+#include "private/svn_cache.h"
 #include "private/svn_fspath.h"
+#include "private/svn_fs_fs_private.h"
+#include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
 
 #include "dav_svn.h"
@@ -67,6 +72,9 @@ typedef struct server_conf_t {
      compression level. */
   int compression_level;
 
+  /* Capacity of the process-wide FSFS access trace.  0 disables it. */
+  int fsfs_access_trace;
+
 } server_conf_t;
 
 
@@ -101,13 +109,16 @@ typedef struct dir_conf_t {
   const char *root_dir;              /* our top-level directory */
   const char *master_uri;            /* URI to the master SVN repos */
   svn_version_t *master_version;     /* version of master server */
+  enum conf_flag master_read_through; /* whether to proxy reads of newer revs */
   const char *activities_db;         /* path to activities database(s) */
   enum conf_flag txdelta_cache;      /* whether to enable txdelta caching */
   enum conf_flag fulltext_cache;     /* whether to enable fulltext caching */
   enum conf_flag revprop_cache;      /* whether to enable revprop caching */
   enum conf_flag nodeprop_cache;     /* whether to enable nodeprop caching */
   enum conf_flag block_read;         /* whether to enable block read mode */
+  enum conf_flag response_cache;     /* whether to cache svndiff responses */
   const char *hooks_env;             /* path to hook script env config file */
+  apr_size_t update_read_ahead;      /* bytes to read ahead per fetched file */
 } dir_conf_t;
 
 
@@ -120,6 +131,12 @@ extern module AP_MODULE_DECLARE_DATA dav_svn_module;
 /* The authz_svn provider for bypassing path authz. */
 static authz_svn__subreq_bypass_func_t pathauthz_bypass_func = NULL;
 
+/* Whether the in-memory cache shall be shared between all processes. */
+static svn_boolean_t shared_memory_cache = FALSE;
+
+/* Whether the in-memory cache contents shall be persisted. */
+static svn_boolean_t cache_snapshot = FALSE;
+
 static int
 init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
 {
@@ -150,9 +167,79 @@ init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
   conf = ap_get_module_config(s->module_config, &dav_svn_module);
   svn_utf_initialize2(conf->use_utf8, p);
 
+  /* A shared cache must be created in the parent process, i.e. before
+   * the workers get forked. */
+  if (shared_memory_cache)
+    svn_cache__get_global_membuffer_cache();
+
+  if (conf->fsfs_access_trace)
+    {
+      svn_fs_fs__ioctl_set_access_trace_input_t input;
+      input.capacity = conf->fsfs_access_trace;
+
+      serr = svn_fs_ioctl(NULL, SVN_FS_FS__IOCTL_SET_ACCESS_TRACE, &input,
+                          NULL, NULL, NULL, p, ptemp);
+      if (serr)
+        {
+          ap_log_perror(APLOG_MARK, APLOG_ERR, serr->apr_err, p,
+                        "mod_dav_svn: error enabling the FSFS access "
+                        "trace: '%s'",
+                        serr->message ? serr->message : "(no more info)");
+          svn_error_clear(serr);
+          return HTTP_INTERNAL_SERVER_ERROR;
+        }
+    }
+
   return OK;
 }
 
+/* Implements apr_pool_cleanup_t, writing the cache snapshot configured by
+ * SVNInMemoryCacheSnapshot when a worker process terminates. */
+static apr_status_t
+save_cache_snapshot(void *data)
+{
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  /* Caching is optional, so is the snapshot. */
+  svn_error_clear(svn_cache__save_global_membuffer(pool));
+  svn_pool_destroy(pool);
+
+  return APR_SUCCESS;
+}
+
+/* The phase timer totals of all requests logged by this process, for
+   the svn-status page.  Access is serialized by PHASE_TOTALS_MUTEX. */
+static svn_mutex__t *phase_totals_mutex = NULL;
+static apr_uint64_t phase_requests = 0;
+static apr_interval_time_t phase_totals[DAV_SVN__PHASE_COUNT] = { 0 };
+
+/* Implements the #child_init hook. */
+static void
+child_init(apr_pool_t *p, server_rec *s)
+{
+  svn_error_t *serr;
+
+  if (cache_snapshot)
+    apr_pool_cleanup_register(p, NULL, save_cache_snapshot,
+                              apr_pool_cleanup_null);
+
+  serr = svn_mutex__init(&phase_totals_mutex, TRUE, p);
+  if (serr)
+    {
+      ap_log_error(APLOG_MARK, APLOG_WARNING, serr->apr_err, s,
+                   "mod_dav_svn: could not create the phase timer mutex");
+      svn_error_clear(serr);
+    }
+
+  serr = dav_svn__mirror_child_init(p);
+  if (serr)
+    {
+      ap_log_error(APLOG_MARK, APLOG_WARNING, serr->apr_err, s,
+                   "mod_dav_svn: could not initialize SVNMasterReadThrough");
+      svn_error_clear(serr);
+    }
+}
+
 static svn_error_t *
 malfunction_handler(svn_boolean_t can_return,
                     const char *file, int line,
@@ -234,6 +321,9 @@ merge_server_config(apr_pool_t *p, void *base, void *overrides)
   newconf->use_utf8 = INHERIT_VALUE(parent, child, use_utf8);
   svn_utf_initialize2(newconf->use_utf8, p);
 
+  newconf->fsfs_access_trace = INHERIT_VALUE(parent, child,
+                                             fsfs_access_trace);
+
   return newconf;
 }
 
@@ -272,6 +362,8 @@ merge_dir_config(apr_pool_t *p, void *base, void *overrides)
   newconf->fs_path = INHERIT_VALUE(parent, child, fs_path);
   newconf->master_uri = INHERIT_VALUE(parent, child, master_uri);
   newconf->master_version = INHERIT_VALUE(parent, child, master_version);
+  newconf->master_read_through = INHERIT_VALUE(parent, child,
+                                               master_read_through);
   newconf->activities_db = INHERIT_VALUE(parent, child, activities_db);
   newconf->repo_name = INHERIT_VALUE(parent, child, repo_name);
   newconf->xslt_uri = INHERIT_VALUE(parent, child, xslt_uri);
@@ -286,8 +378,11 @@ merge_dir_config(apr_pool_t *p, void *base, void *overrides)
   newconf->revprop_cache = INHERIT_VALUE(parent, child, revprop_cache);
   newconf->nodeprop_cache = INHERIT_VALUE(parent, child, nodeprop_cache);
   newconf->block_read = INHERIT_VALUE(parent, child, block_read);
+  newconf->response_cache = INHERIT_VALUE(parent, child, response_cache);
   newconf->root_dir = INHERIT_VALUE(parent, child, root_dir);
   newconf->hooks_env = INHERIT_VALUE(parent, child, hooks_env);
+  newconf->update_read_ahead = INHERIT_VALUE(parent, child,
+                                             update_read_ahead);
 
   if (parent->fs_path)
     ap_log_error(APLOG_MARK, APLOG_WARNING, 0, NULL,
@@ -611,6 +706,32 @@ SVNBlockRead_cmd(cmd_parms *cmd, void *config, int arg)
   return NULL;
 }
 
+static const char *
+SVNMasterReadThrough_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  dir_conf_t *conf = config;
+
+  if (arg)
+    conf->master_read_through = CONF_FLAG_ON;
+  else
+    conf->master_read_through = CONF_FLAG_OFF;
+
+  return NULL;
+}
+
+static const char *
+SVNCacheResponses_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  dir_conf_t *conf = config;
+
+  if (arg)
+    conf->response_cache = CONF_FLAG_ON;
+  else
+    conf->response_cache = CONF_FLAG_OFF;
+
+  return NULL;
+}
+
 static const char *
 SVNInMemoryCacheSize_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -631,6 +752,40 @@ SVNInMemoryCacheSize_cmd(cmd_parms *cmd, void *config, const char *arg1)
   return NULL;
 }
 
+static const char *
+SVNInMemoryCacheSharedMemory_cmd(cmd_parms *cmd, void *config,
+                                 const char *arg1)
+{
+  /* The name must survive until the cache gets created in init(). */
+  shared_memory_cache = TRUE;
+  svn_cache__set_global_membuffer_shared(
+      TRUE, apr_pstrdup(cmd->server->process->pool,
+                        ap_server_root_relative(cmd->temp_pool, arg1)));
+
+  return NULL;
+}
+
+static const char *
+SVNInMemoryCacheAdmissionFilter_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  svn_cache__set_global_membuffer_admission_filter(arg);
+
+  return NULL;
+}
+
+static const char *
+SVNInMemoryCacheSnapshot_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  /* The path must survive until the worker processes terminate. */
+  cache_snapshot = TRUE;
+  svn_cache__set_global_membuffer_snapshot(
+      svn_dirent_internal_style(ap_server_root_relative(cmd->temp_pool,
+                                                        arg1),
+                                cmd->server->process->pool));
+
+  return NULL;
+}
+
 static const char *
 SVNCompressionLevel_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -659,6 +814,28 @@ SVNCompressionLevel_cmd(cmd_parms *cmd, void *config, const char *arg1)
   return NULL;
 }
 
+static const char *
+SVNFSFSAccessTrace_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  server_conf_t *conf;
+  int value = 0;
+  svn_error_t *err = svn_cstring_atoi(&value, arg1);
+  if (err)
+    {
+      svn_error_clear(err);
+      return "Invalid decimal number for the FSFS access trace size.";
+    }
+
+  if (value < 0)
+    return "The FSFS access trace size must not be negative.";
+
+  conf = ap_get_module_config(cmd->server->module_config,
+                              &dav_svn_module);
+  conf->fsfs_access_trace = value;
+
+  return NULL;
+}
+
 static const char *
 SVNUseUTF8_cmd(cmd_parms *cmd, void *config, int arg)
 {
@@ -681,6 +858,27 @@ SVNHooksEnv_cmd(cmd_parms *cmd, void *config, const char *arg1)
   return NULL;
 }
 
+static const char *
+SVNUpdateReadAhead_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  dir_conf_t *conf = config;
+  apr_uint64_t value = 0;
+  svn_error_t *err = svn_cstring_atoui64(&value, arg1);
+
+  if (err)
+    {
+      svn_error_clear(err);
+      return "Invalid decimal number for the update read-ahead size.";
+    }
+
+  if (value > APR_SIZE_MAX / 0x400)
+    return "Update read-ahead size too large.";
+
+  conf->update_read_ahead = (apr_size_t)value * 0x400;
+
+  return NULL;
+}
+
 static svn_boolean_t
 get_conf_flag(enum conf_flag flag, svn_boolean_t default_value)
 {
@@ -807,6 +1005,18 @@ dav_svn__get_master_version(request_rec *r)
 }
 
 
+svn_boolean_t
+dav_svn__get_master_read_through_flag(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  /* read-through is disabled by default. */
+  return conf->master_uri && get_conf_flag(conf->master_read_through, FALSE);
+}
+
+
 const char *
 dav_svn__get_xslt_uri(request_rec *r)
 {
@@ -1034,6 +1244,17 @@ dav_svn__get_block_read_flag(request_rec *r)
   return get_conf_flag(conf->block_read, FALSE);
 }
 
+svn_boolean_t
+dav_svn__get_response_cache_flag(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  /* response caching is disabled by default. */
+  return get_conf_flag(conf->response_cache, FALSE);
+}
+
 int
 dav_svn__get_compression_level(request_rec *r)
 {
@@ -1061,6 +1282,113 @@ dav_svn__get_hooks_env(request_rec *r)
   return conf->hooks_env;
 }
 
+apr_size_t
+dav_svn__get_update_read_ahead(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+  return conf->update_read_ahead;
+}
+
+/* The per-request phase timers, kept in the request_config of the main
+   request. */
+typedef struct phase_times_t
+{
+  apr_interval_time_t elapsed[DAV_SVN__PHASE_COUNT];
+} phase_times_t;
+
+/* The names of the notes and environment variables for each phase. */
+static const char * const phase_names[DAV_SVN__PHASE_COUNT] =
+{
+  "SVN-TIME-AUTHZ",
+  "SVN-TIME-FS-OPEN",
+  "SVN-TIME-REPORT",
+  "SVN-TIME-SEND"
+};
+
+void
+dav_svn__add_phase_time(request_rec *r,
+                        dav_svn__phase_t phase,
+                        apr_time_t start)
+{
+  phase_times_t *times;
+
+  /* Connection-level filters have no request. */
+  if (r == NULL)
+    return;
+
+  while (r->main)
+    r = r->main;
+
+  times = ap_get_module_config(r->request_config, &dav_svn_module);
+  if (times == NULL)
+    {
+      times = apr_pcalloc(r->pool, sizeof(*times));
+      ap_set_module_config(r->request_config, &dav_svn_module, times);
+    }
+
+  times->elapsed[phase] += apr_time_now() - start;
+}
+
+/* Add TIMES to the process-wide phase totals. */
+static svn_error_t *
+add_phase_totals(const phase_times_t *times)
+{
+  int i;
+
+  SVN_ERR(svn_mutex__lock(phase_totals_mutex));
+
+  ++phase_requests;
+  for (i = 0; i < DAV_SVN__PHASE_COUNT; ++i)
+    phase_totals[i] += times->elapsed[i];
+
+  return svn_error_trace(svn_mutex__unlock(phase_totals_mutex,
+                                           SVN_NO_ERROR));
+}
+
+/* Implements the #log_transaction hook, exporting the phase timers of R
+   before mod_log_config writes the log entry. */
+static int
+log_phase_times(request_rec *r)
+{
+  phase_times_t *times = ap_get_module_config(r->request_config,
+                                              &dav_svn_module);
+  int i;
+
+  if (times == NULL)
+    return DECLINED;
+
+  for (i = 0; i < DAV_SVN__PHASE_COUNT; ++i)
+    {
+      const char *value = apr_psprintf(r->pool, "%" APR_TIME_T_FMT,
+                                       times->elapsed[i]);
+
+      apr_table_setn(r->notes, phase_names[i], value);
+      apr_table_setn(r->subprocess_env, phase_names[i], value);
+    }
+
+  svn_error_clear(add_phase_totals(times));
+
+  return DECLINED;
+}
+
+void
+dav_svn__get_phase_totals(apr_uint64_t *requests,
+                          apr_interval_time_t totals[DAV_SVN__PHASE_COUNT])
+{
+  svn_error_t *serr = svn_mutex__lock(phase_totals_mutex);
+  int i;
+
+  *requests = phase_requests;
+  for (i = 0; i < DAV_SVN__PHASE_COUNT; ++i)
+    totals[i] = phase_totals[i];
+
+  if (!serr)
+    serr = svn_mutex__unlock(phase_totals_mutex, SVN_NO_ERROR);
+  svn_error_clear(serr);
+}
+
 static void
 merge_xml_filter_insert(request_rec *r)
 {
@@ -1334,6 +1662,14 @@ static const command_rec cmds[] =
                 "specifies the Subversion release version of a master "
                 "Subversion server "),
 
+  /* per directory/location */
+  AP_INIT_FLAG("SVNMasterReadThrough", SVNMasterReadThrough_cmd, NULL,
+               ACCESS_CONF,
+               "proxies read requests to the master server while it has "
+               "revisions this slave has not synced yet, except for "
+               "requests for revisions the slave already has "
+               "(default is Off)."),
+
   /* per directory/location */
   AP_INIT_TAKE1("SVNActivitiesDB", SVNActivitiesDB_cmd, NULL, ACCESS_CONF,
                 "specifies the location in the filesystem in which the "
@@ -1389,6 +1725,14 @@ static const command_rec cmds[] =
                "caches (see SVNInMemoryCacheSize) have been configured."
                "(default is Off)."),
 
+  /* per directory/location */
+  AP_INIT_FLAG("SVNCacheResponses", SVNCacheResponses_cmd, NULL,
+               ACCESS_CONF|RSRC_CONF,
+               "speeds up repeated fetches of the same file deltas, e.g. "
+               "by build farms, by caching the svndiff responses for "
+               "revision-pinned URLs in the in-memory cache (see "
+               "SVNInMemoryCacheSize) (default is Off)."),
+
   /* per server */
   AP_INIT_TAKE1("SVNInMemoryCacheSize", SVNInMemoryCacheSize_cmd, NULL,
                 RSRC_CONF,
@@ -1396,12 +1740,39 @@ static const command_rec cmds[] =
                 "in-memory object cache (default value is 16384; 0 switches "
                 "to dynamically sized caches)."),
   /* per server */
+  AP_INIT_TAKE1("SVNInMemoryCacheSharedMemory",
+                SVNInMemoryCacheSharedMemory_cmd, NULL, RSRC_CONF,
+                "places the in-memory object cache into the shared memory "
+                "segment named by the argument such that all worker "
+                "processes share a single cache (see SVNInMemoryCacheSize "
+                "for its total size)."),
+  /* per server */
+  AP_INIT_TAKE1("SVNInMemoryCacheSnapshot",
+                SVNInMemoryCacheSnapshot_cmd, NULL, RSRC_CONF,
+                "loads the in-memory object cache from the file named by "
+                "the argument when the cache gets created and writes the "
+                "cache contents back to it when a worker process "
+                "terminates."),
+  /* per server */
+  AP_INIT_FLAG("SVNInMemoryCacheAdmissionFilter",
+               SVNInMemoryCacheAdmissionFilter_cmd, NULL, RSRC_CONF,
+               "enables or disables caching large items only if they are "
+               "requested more often than the data they would replace "
+               "(default is Off)."),
+  /* per server */
   AP_INIT_TAKE1("SVNCompressionLevel", SVNCompressionLevel_cmd, NULL,
                 RSRC_CONF,
                 "specifies the compression level used before sending file "
                 "content over the network (0 for no compression, 9 for "
                 "maximum, 5 is default)."),
 
+  /* per server */
+  AP_INIT_TAKE1("SVNFSFSAccessTrace", SVNFSFSAccessTrace_cmd, NULL,
+                RSRC_CONF,
+                "specifies the number of recent FSFS item reads to record "
+                "per process for display by the svn-status handler "
+                "(default is 0, i.e. disabled)."),
+
   /* per server */
   AP_INIT_FLAG("SVNUseUTF8",
                SVNUseUTF8_cmd, NULL,
@@ -1415,6 +1786,15 @@ static const command_rec cmds[] =
                 "of hook scripts. If not absolute, the path is relative to "
                 "the repository's conf directory (by default the hooks-env "
                 "file in the repository is used)."),
+
+  /* per directory/location */
+  AP_INIT_TAKE1("SVNUpdateReadAhead", SVNUpdateReadAhead_cmd, NULL,
+                ACCESS_CONF|RSRC_CONF,
+                "specifies how many kB of each changed file an update "
+                "report that leaves the file contents to separate GET "
+                "requests reads into the in-memory cache before it tells "
+                "the client to fetch the file (default is 0, i.e. "
+                "disabled)."),
   { NULL }
 };
 
@@ -1436,6 +1816,7 @@ register_hooks(apr_pool_t *pconf)
 {
   ap_hook_pre_config(init_dso, NULL, NULL, APR_HOOK_REALLY_FIRST);
   ap_hook_post_config(init, NULL, NULL, APR_HOOK_MIDDLE);
+  ap_hook_child_init(child_init, NULL, NULL, APR_HOOK_MIDDLE);
 
   /* our provider */
   dav_register_provider(pconf, "svn", &provider);
@@ -1452,6 +1833,9 @@ register_hooks(apr_pool_t *pconf)
   /* Handler to GET Subversion's FSFS cache stats, a bit like mod_status. */
   ap_hook_handler(dav_svn__status, NULL, NULL, APR_HOOK_MIDDLE);
 
+  /* Export the phase timers ahead of mod_log_config. */
+  ap_hook_log_transaction(log_phase_times, NULL, NULL, APR_HOOK_FIRST);
+
   /* live property handling */
   dav_hook_gather_propsets(dav_svn__gather_propsets, NULL, NULL,
                            APR_HOOK_MIDDLE);
@@ -36,6 +36,7 @@
 #include "svn_dav.h"
 #include "svn_pools.h"
 #include "svn_props.h"
+#include "svn_time.h"
 
 #include "private/svn_log.h"
 #include "private/svn_fspath.h"
@@ -71,6 +72,12 @@ struct log_receiver_baton
   /* whether the client can handle encoded binary property values */
   svn_boolean_t encode_binary_props;
 
+  /* whether the client can handle compact <S:entry> elements, and the
+     revision and date the next one's deltas are relative to */
+  svn_boolean_t compact_entries;
+  svn_revnum_t compact_rev;
+  apr_time_t compact_date;
+
   /* Helper variables to force early bucket brigade flushes */
   int result_count;
   int next_forced_flush;
@@ -217,6 +224,146 @@ log_change_receiver(void *baton,
   return SVN_NO_ERROR;
 }
 
+/* Return TRUE if LOG_ENTRY may be sent to LRB's client as a compact
+   <S:entry> element, i.e. if it has neither changed paths nor merge
+   information and its only revprops are an XML-safe svn:author and
+   svn:date.  Use SCRATCH_POOL for temporary allocations. */
+static svn_boolean_t
+can_send_compact_entry(struct log_receiver_baton *lrb,
+                       svn_repos_log_entry_t *log_entry,
+                       apr_pool_t *scratch_pool)
+{
+  apr_hash_index_t *hi;
+
+  if (! lrb->compact_entries
+      || ! lrb->needs_log_item
+      || ! SVN_IS_VALID_REVNUM(log_entry->revision)
+      || log_entry->has_children
+      || log_entry->subtractive_merge)
+    return FALSE;
+
+  if (! log_entry->revprops)
+    return TRUE;
+
+  for (hi = apr_hash_first(scratch_pool, log_entry->revprops);
+       hi != NULL;
+       hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const svn_string_t *value = apr_hash_this_val(hi);
+
+      if (strcmp(name, SVN_PROP_REVISION_AUTHOR) != 0
+          && strcmp(name, SVN_PROP_REVISION_DATE) != 0)
+        return FALSE;
+
+      if (! svn_xml_is_xml_safe(value->data, value->len))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Send LOG_ENTRY to LRB's client as a compact <S:entry> element.  The
+   revision is sent as the difference to the previous compact entry's,
+   and so is the date in microseconds, unless the client could not
+   reproduce the svn:date string from that.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+send_compact_entry(struct log_receiver_baton *lrb,
+                   svn_repos_log_entry_t *log_entry,
+                   apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *entry;
+  const svn_string_t *author = NULL;
+  const svn_string_t *date = NULL;
+
+  if (log_entry->revprops)
+    {
+      author = svn_hash_gets(log_entry->revprops, SVN_PROP_REVISION_AUTHOR);
+      date = svn_hash_gets(log_entry->revprops, SVN_PROP_REVISION_DATE);
+    }
+
+  entry = svn_stringbuf_createf(scratch_pool, "<S:entry r=\"%ld\"",
+                                log_entry->revision - lrb->compact_rev);
+  lrb->compact_rev = log_entry->revision;
+
+  if (author)
+    {
+      svn_stringbuf_appendcstr(entry, " a=\"");
+      svn_stringbuf_appendcstr(entry,
+                               apr_xml_quote_string(scratch_pool,
+                                                    author->data, 1));
+      svn_stringbuf_appendbyte(entry, '"');
+    }
+
+  if (date)
+    {
+      apr_time_t when;
+      svn_error_t *err = svn_time_from_cstring(&when, date->data,
+                                               scratch_pool);
+
+      if (!err && strcmp(svn_time_to_cstring(when, scratch_pool),
+                         date->data) == 0)
+        {
+          svn_stringbuf_appendcstr(entry,
+                                   apr_psprintf(scratch_pool,
+                                                " t=\"%" APR_TIME_T_FMT "\"",
+                                                when - lrb->compact_date));
+          lrb->compact_date = when;
+        }
+      else
+        {
+          svn_error_clear(err);
+          svn_stringbuf_appendcstr(entry, " d=\"");
+          svn_stringbuf_appendcstr(entry,
+                                   apr_xml_quote_string(scratch_pool,
+                                                        date->data, 1));
+          svn_stringbuf_appendbyte(entry, '"');
+        }
+    }
+
+  svn_stringbuf_appendcstr(entry, "/>" DEBUG_CR);
+
+  return svn_error_trace(dav_svn__brigade_write(lrb->bb, lrb->output,
+                                                entry->data, entry->len));
+}
+
+/* Count another result sent by LRB and flush the output if this is
+   one of the first few results.
+
+   In general APR will flush the brigade every 8000 bytes through the filter
+   stack, but log items may not be generated that fast, especially in
+   combination with authz and busy servers. We now explicitly flush after
+   log-item 4, 16, 64 and 256 to produce a few results fast.
+
+   This introduces 4 full flushes of our brigade and the installed output
+   filters at growing intervals and then falls back to the standard
+   buffering of 8000 bytes + whatever buffers are added in output filters. */
+static svn_error_t *
+maybe_force_flush(struct log_receiver_baton *lrb)
+{
+  lrb->result_count++;
+  if (lrb->result_count == lrb->next_forced_flush)
+    {
+      apr_bucket *bkt;
+
+      /* Compared to using ap_filter_flush(), which we use in other place
+         this adds a flush frame before flushing the brigade, to make output
+         filters perform a flush as well */
+
+      /* No brigade empty check. We want output filters to flush anyway */
+      bkt = apr_bucket_flush_create(
+                dav_svn__output_get_bucket_alloc(lrb->output));
+      APR_BRIGADE_INSERT_TAIL(lrb->bb, bkt);
+      SVN_ERR(dav_svn__output_pass_brigade(lrb->output, lrb->bb));
+
+      if (lrb->result_count < 256)
+        lrb->next_forced_flush = lrb->next_forced_flush * 4;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* This implements `svn_repos_log_entry_receiver_t'.
    BATON is a `struct log_receiver_baton *'.  */
 static svn_error_t *
@@ -238,6 +385,13 @@ log_revision_receiver(void *baton,
         lrb->stack_depth--;
     }
 
+  /* Entries with nothing but author and date may be sent compactly. */
+  if (can_send_compact_entry(lrb, log_entry, scratch_pool))
+    {
+      SVN_ERR(send_compact_entry(lrb, log_entry, scratch_pool));
+      return svn_error_trace(maybe_force_flush(lrb));
+    }
+
   /* If we have not received any path changes, the log-item XML node
      still needs to be opened.  Also, reset the controlling flag to
      prepare it for the next revision - if there should be one. */
@@ -323,34 +477,7 @@ log_revision_receiver(void *baton,
   SVN_ERR(dav_svn__brigade_puts(lrb->bb, lrb->output,
                                 "</S:log-item>" DEBUG_CR));
 
-  /* In general APR will flush the brigade every 8000 bytes through the filter
-     stack, but log items may not be generated that fast, especially in
-     combination with authz and busy servers. We now explicitly flush after
-     log-item 4, 16, 64 and 256 to produce a few results fast.
-
-     This introduces 4 full flushes of our brigade and the installed output
-     filters at growing intervals and then falls back to the standard
-     buffering of 8000 bytes + whatever buffers are added in output filters. */
-  lrb->result_count++;
-  if (lrb->result_count == lrb->next_forced_flush)
-    {
-      apr_bucket *bkt;
-
-      /* Compared to using ap_filter_flush(), which we use in other place
-         this adds a flush frame before flushing the brigade, to make output
-         filters perform a flush as well */
-
-      /* No brigade empty check. We want output filters to flush anyway */
-      bkt = apr_bucket_flush_create(
-                dav_svn__output_get_bucket_alloc(lrb->output));
-      APR_BRIGADE_INSERT_TAIL(lrb->bb, bkt);
-      SVN_ERR(dav_svn__output_pass_brigade(lrb->output, lrb->bb));
-
-      if (lrb->result_count < 256)
-        lrb->next_forced_flush = lrb->next_forced_flush * 4;
-    }
-
-  return SVN_NO_ERROR;
+  return svn_error_trace(maybe_force_flush(lrb));
 }
 
 
@@ -402,6 +529,7 @@ dav_svn__log_report(const dav_resource *resource,
 
   lrb.requested_custom_revprops = FALSE;
   lrb.encode_binary_props = FALSE;
+  lrb.compact_entries = FALSE;
   for (child = doc->root->first_child; child != NULL; child = child->next)
     {
       /* if this element isn't one of ours, then skip it */
@@ -431,6 +559,8 @@ dav_svn__log_report(const dav_resource *resource,
         include_merged_revisions = TRUE; /* presence indicates positivity */
       else if (strcmp(child->name, "encode-binary-props") == 0)
         lrb.encode_binary_props = TRUE; /* presence indicates positivity */
+      else if (strcmp(child->name, "compact-entries") == 0)
+        lrb.compact_entries = TRUE; /* presence indicates positivity */
       else if (strcmp(child->name, "all-revprops") == 0)
         {
           revprops = NULL; /* presence indicates fetch all revprops */
@@ -494,6 +624,8 @@ dav_svn__log_report(const dav_resource *resource,
   lrb.needs_header = TRUE;
   lrb.needs_log_item = TRUE;
   lrb.stack_depth = 0;
+  lrb.compact_rev = 0;
+  lrb.compact_date = 0;
   /* lrb.requested_custom_revprops set above */
 
   lrb.result_count = 0;
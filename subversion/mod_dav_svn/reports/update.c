@@ -39,6 +39,7 @@
 #include "svn_path.h"
 #include "svn_dav.h"
 #include "svn_props.h"
+#include "svn_sorts.h"
 
 #include "private/svn_log.h"
 #include "private/svn_fspath.h"
@@ -96,6 +97,14 @@ typedef struct update_ctx_t {
      resource" and are we advertising support for as much? */
   svn_boolean_t enable_v2_response;
 
+  /* In skelta mode, the number of bytes of each changed file to read
+     before telling the client to fetch it, so that its GET finds the
+     data in the caches.  0 disables the read-ahead. */
+  apr_size_t read_ahead;
+
+  /* When we last pushed the buffered report to the client. */
+  apr_time_t last_flush;
+
 } update_ctx_t;
 
 
@@ -839,11 +848,71 @@ upd_apply_textdelta(void *file_baton,
 }
 
 
+/* In skelta mode, the client fetches the files named in the report while
+   we are still generating it.  Push the buffered report to the client if
+   it has not been pushed for this long, so the fetches don't wait for
+   the filters to fill their buffers. */
+#define SKELTA_FLUSH_INTERVAL apr_time_from_msec(100)
+
+/* In skelta mode, pass the buffered output of UC down to the client if
+   that has not happened for SKELTA_FLUSH_INTERVAL. */
+static svn_error_t *
+maybe_flush_skelta(update_ctx_t *uc)
+{
+  apr_time_t now;
+
+  if (uc->send_all || uc->resource_walk)
+    return SVN_NO_ERROR;
+
+  now = apr_time_now();
+  if (now - uc->last_flush < SKELTA_FLUSH_INTERVAL)
+    return SVN_NO_ERROR;
+
+  uc->last_flush = now;
+  APR_BRIGADE_INSERT_TAIL(uc->bb,
+                          apr_bucket_flush_create(
+                            dav_svn__output_get_bucket_alloc(uc->output)));
+
+  return svn_error_trace(dav_svn__output_pass_brigade(uc->output, uc->bb));
+}
+
+/* Read the first UC->READ_AHEAD bytes of the contents of FILE, such that
+   the repository caches hold them by the time the client fetches FILE.
+   Use POOL for temporary allocations. */
+static svn_error_t *
+read_ahead(item_baton_t *file, apr_pool_t *pool)
+{
+  update_ctx_t *uc = file->uc;
+  svn_stream_t *contents;
+  apr_size_t remaining = uc->read_ahead;
+  char *buffer = apr_palloc(pool, SVN__STREAM_CHUNK_SIZE);
+
+  SVN_ERR(svn_fs_file_contents(&contents, uc->rev_root,
+                               get_real_fs_path(file, pool), pool));
+
+  while (remaining > 0)
+    {
+      apr_size_t len = MIN(remaining, SVN__STREAM_CHUNK_SIZE);
+
+      SVN_ERR(svn_stream_read_full(contents, buffer, &len));
+      if (len == 0)
+        break;
+
+      remaining -= len;
+    }
+
+  return svn_error_trace(svn_stream_close(contents));
+}
+
 static svn_error_t *
 upd_close_file(void *file_baton, const char *text_checksum, apr_pool_t *pool)
 {
   item_baton_t *file = file_baton;
 
+  /* The read-ahead is a mere optimization. */
+  if ((! file->uc->send_all) && file->text_changed && file->uc->read_ahead)
+    svn_error_clear(read_ahead(file, pool));
+
   /* If we are not in "send all" mode, and this file is not a new
      addition or didn't otherwise have changed text, tell the client
      to fetch it. */
@@ -880,7 +949,9 @@ upd_close_file(void *file_baton, const char *text_checksum, apr_pool_t *pool)
                                       text_checksum));
     }
 
-  return close_helper(FALSE /* is_dir */, file, pool);
+  SVN_ERR(close_helper(FALSE /* is_dir */, file, pool));
+
+  return svn_error_trace(maybe_flush_skelta(file->uc));
 }
 
 
@@ -979,6 +1050,7 @@ dav_svn__update_report(const dav_resource *resource,
   svn_boolean_t resource_walk = FALSE;
   svn_boolean_t ignore_ancestry = FALSE;
   svn_boolean_t send_copyfrom_args = FALSE;
+  apr_time_t report_start;
   dav_svn__authz_read_baton arb;
   apr_pool_t *subpool = svn_pool_create(resource->pool);
 
@@ -1198,6 +1270,8 @@ dav_svn__update_report(const dav_resource *resource,
 
   uc.svndiff_version = resource->info->svndiff_version;
   uc.compression_level = dav_svn__get_compression_level(resource->info->r);
+  uc.read_ahead = dav_svn__get_update_read_ahead(resource->info->r);
+  uc.last_flush = apr_time_now();
   uc.resource = resource;
   uc.output = output;
   uc.anchor = src_path;
@@ -1446,7 +1520,10 @@ dav_svn__update_report(const dav_resource *resource,
 
   /* this will complete the report, and then drive our editor to generate
      the response to the client. */
+  report_start = apr_time_now();
   serr = svn_repos_finish_report(rbaton, resource->pool);
+  dav_svn__add_phase_time(resource->info->r, DAV_SVN__PHASE_REPORT,
+                          report_start);
 
   /* Whether svn_repos_finish_report returns an error or not we can no
      longer abort this report as the file has been closed. */
@@ -53,10 +53,13 @@
 #include "mod_dav_svn.h"
 #include "svn_ra.h"  /* for SVN_RA_CAPABILITY_* */
 #include "svn_dirent_uri.h"
+#include "private/svn_atomic.h"
+#include "private/svn_cache.h"
 #include "private/svn_log.h"
 #include "private/svn_fspath.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_subr_private.h"
 
 #include "dav_svn.h"
 
@@ -1760,18 +1763,11 @@ static apr_array_header_t *do_header_line(apr_pool_t *p,
 /* ---------------------------------------------------------------------- */
 
 
-/* qsort comparison function for the quality field of the accept_rec
-   structure */
-static int sort_encoding_pref(const void *accept_rec1, const void *accept_rec2)
-{
-  float diff = ((const accept_rec *) accept_rec1)->quality -
-      ((const accept_rec *) accept_rec2)->quality;
-  return (diff == 0 ? 0 : (diff > 0 ? -1 : 1));
-}
-
 static int get_svndiff_version(const struct accept_rec *rec)
 {
-  if (strcmp(rec->name, "svndiff2") == 0)
+  if (strcmp(rec->name, "svndiff3") == 0)
+    return svn__zstd_available() ? 3 : -1;
+  else if (strcmp(rec->name, "svndiff2") == 0)
     return 2;
   else if (strcmp(rec->name, "svndiff1") == 0)
     return 1;
@@ -1782,7 +1778,12 @@ static int get_svndiff_version(const struct accept_rec *rec)
 }
 
 /* Parse and handle any possible Accept-Encoding header that has been
-   sent as part of the request.  */
+   sent as part of the request.
+
+   The svndiff version with the highest quality value wins, with ties
+   going to the one listed first.  Versions with a quality of 0 are not
+   acceptable.  This lets clients on fast networks ask for uncompressed
+   svndiff0 and those on slow ones for the best compression ratio.  */
 static void
 negotiate_encoding_prefs(request_rec *r, int *svndiff_version)
 {
@@ -1794,61 +1795,48 @@ negotiate_encoding_prefs(request_rec *r, int *svndiff_version)
      necessary ones in this file. */
   int i;
   apr_array_header_t *encoding_prefs;
-  apr_array_header_t *svndiff_encodings;
+  float best_quality = 0;
   svn_boolean_t accepts_svndiff2 = FALSE;
 
+  *svndiff_version = 0;
+
+  /* If the compression is disabled on the server, use the uncompressed
+     svndiff0 format, which we assume is always supported. */
+  if (dav_svn__get_compression_level(r) == 0)
+    return;
+
   encoding_prefs = do_header_line(r->pool,
                                   apr_table_get(r->headers_in,
                                                 "Accept-Encoding"));
+  if (!encoding_prefs)
+    return;
 
-  if (!encoding_prefs || apr_is_empty_array(encoding_prefs))
-    {
-      *svndiff_version = 0;
-      return;
-    }
-
-  svndiff_encodings = apr_array_make(r->pool, 3, sizeof(struct accept_rec));
   for (i = 0; i < encoding_prefs->nelts; i++)
     {
       const struct accept_rec *rec = &APR_ARRAY_IDX(encoding_prefs, i,
                                                     struct accept_rec);
       int version = get_svndiff_version(rec);
 
-      if (version > 0)
-        APR_ARRAY_PUSH(svndiff_encodings, struct accept_rec) = *rec;
+      if (version < 0 || rec->quality <= 0)
+        continue;
+
+      if (rec->quality > best_quality)
+        {
+          best_quality = rec->quality;
+          *svndiff_version = version;
+        }
 
       if (version == 2)
         accepts_svndiff2 = TRUE;
     }
 
-  if (dav_svn__get_compression_level(r) == 0)
-    {
-      /* If the compression is disabled on the server, use the uncompressed
-       * svndiff0 format, which we assume is always supported. */
-      *svndiff_version = 0;
-    }
-  else if (accepts_svndiff2 && dav_svn__get_compression_level(r) == 1)
-    {
-      /* Enable svndiff2 if the client can read it, and if the server-side
-       * compression level is set to 1.  Svndiff2 offers better speed and
-       * compression ratio comparable to svndiff1 with compression level 1,
-       * but not with other compression levels.
-       */
-      *svndiff_version = 2;
-    }
-  else if (svndiff_encodings->nelts > 0)
-    {
-      const struct accept_rec *rec;
-
-      /* Otherwise, use what the client prefers to see. */
-      svn_sort__array(svndiff_encodings, sort_encoding_pref);
-      rec = &APR_ARRAY_IDX(svndiff_encodings, 0, struct accept_rec);
-      *svndiff_version = get_svndiff_version(rec);
-    }
-  else
-    {
-      *svndiff_version = 0;
-    }
+  /* Svndiff2 offers better speed and compression ratio comparable to
+     svndiff1 with compression level 1, but not with other compression
+     levels.  So use it instead of svndiff1 if the client can read it and
+     the server-side compression level is set to 1. */
+  if (*svndiff_version == 1 && accepts_svndiff2
+      && dav_svn__get_compression_level(r) == 1)
+    *svndiff_version = 2;
 }
 
 
@@ -2466,8 +2454,13 @@ get_resource(request_rec *r,
 
       /* open the FS */
       if (!serr)
-        serr = svn_repos_open3(&(repos->repos), fs_path, fs_config,
-                               r->connection->pool, r->pool);
+        {
+          apr_time_t open_start = apr_time_now();
+
+          serr = svn_repos_open3(&(repos->repos), fs_path, fs_config,
+                                 r->connection->pool, r->pool);
+          dav_svn__add_phase_time(r, DAV_SVN__PHASE_FS_OPEN, open_start);
+        }
       if (serr != NULL)
         {
           /* The error returned by svn_repos_open2 might contain the
@@ -3207,6 +3200,79 @@ is_cacheable(request_rec *r, const dav_resource *resource)
       return FALSE;
 }
 
+/* If the GET request R asks for a single, satisfiable byte range of a
+   file of LENGTH bytes, set *OFFSET and *RANGE_LENGTH to it and return
+   TRUE.  Anything else, e.g. multiple ranges, is left to httpd's byterange
+   filter, which cuts the ranges out of the complete response. */
+static svn_boolean_t
+get_single_range(svn_filesize_t *offset,
+                 svn_filesize_t *range_length,
+                 request_rec *r,
+                 svn_filesize_t length)
+{
+  const char *range = apr_table_get(r->headers_in, "Range");
+  const char *if_range = apr_table_get(r->headers_in, "If-Range");
+  const char *etag = apr_table_get(r->headers_out, "ETag");
+  const char *dash;
+  apr_int64_t first, last;
+  svn_error_t *serr;
+
+  if (r->method_number != M_GET || length == 0 || range == NULL
+      || strncmp(range, "bytes=", 6) != 0)
+    return FALSE;
+
+  /* If the file changed, the client wants all of it. */
+  if (if_range && (etag == NULL || strcmp(if_range, etag) != 0))
+    return FALSE;
+
+  range += 6;
+  dash = strchr(range, '-');
+  if (dash == NULL || strchr(range, ',') != NULL)
+    return FALSE;
+
+  if (dash == range)
+    {
+      /* "bytes=-N" asks for the last N bytes. */
+      serr = svn_cstring_atoi64(&first, dash + 1);
+      if (serr)
+        {
+          svn_error_clear(serr);
+          return FALSE;
+        }
+      first = first > length ? 0 : length - first;
+      last = length - 1;
+    }
+  else
+    {
+      serr = svn_cstring_atoi64(&first, apr_pstrmemdup(r->pool, range,
+                                                       dash - range));
+      if (!serr)
+        {
+          if (dash[1])
+            serr = svn_cstring_atoi64(&last, dash + 1);
+          else
+            last = length - 1;
+        }
+      if (serr)
+        {
+          svn_error_clear(serr);
+          return FALSE;
+        }
+    }
+
+  /* Let httpd deal with unsatisfiable ranges. */
+  if (first < 0 || first > last || first >= length)
+    return FALSE;
+
+  if (last >= length)
+    last = length - 1;
+
+  *offset = first;
+  *range_length = last - first + 1;
+
+  return TRUE;
+}
+
 static dav_error *
 set_headers(request_rec *r, const dav_resource *resource)
 {
@@ -3214,10 +3280,12 @@ set_headers(request_rec *r, const dav_resource *resource)
   svn_filesize_t length;
   const char *mimetype = NULL;
 
-  /* As version resources don't change, encourage caching. */
+  /* As version resources don't change, encourage caching.  They are
+     immutable, so caches need not revalidate them before they expire. */
   if (is_cacheable(r, resource))
     /* Cache resource for one week (specified in seconds). */
-    apr_table_setn(r->headers_out, "Cache-Control", "max-age=604800");
+    apr_table_setn(r->headers_out, "Cache-Control",
+                   "max-age=604800, immutable");
   else
     apr_table_setn(r->headers_out, "Cache-Control", "max-age=0");
 
@@ -3301,6 +3369,22 @@ set_headers(request_rec *r, const dav_resource *resource)
           apr_table_setn(r->headers_out, "Vary", SVN_DAV_DELTA_BASE_HEADER);
           apr_table_setn(r->headers_out, SVN_DAV_DELTA_BASE_HEADER,
                          resource->info->delta_base);
+
+          /* A strong ETag must differ between the representations of a
+             resource, so tell the svndiffs apart from the fulltext. */
+          if (!resource->collection)
+            apr_table_setn(r->headers_out, "ETag",
+                           apr_psprintf(resource->pool,
+                                        "\"%ld/%s;%ld/%s;svndiff%d\"",
+                                        resource->info->root.rev,
+                                        apr_xml_quote_string(
+                                          resource->pool,
+                                          resource->info->repos_path, 1),
+                                        info.rev,
+                                        apr_xml_quote_string(
+                                          resource->pool,
+                                          info.repos_path, 1),
+                                        resource->info->svndiff_version));
         }
       svn_error_clear(serr);
     }
@@ -3368,6 +3452,27 @@ set_headers(request_rec *r, const dav_resource *resource)
                                           "could not fetch the resource length",
                                           resource->pool);
             }
+
+          /* Serve a single byte range ourselves, so that the fs only
+             needs to reconstruct that part of the file.  The
+             Content-Range header tells httpd's byterange filter to keep
+             its hands off the response. */
+          if (get_single_range(&resource->info->range_offset,
+                               &resource->info->range_length, r, length))
+            {
+              r->status = HTTP_PARTIAL_CONTENT;
+              apr_table_setn(r->headers_out, "Content-Range",
+                             apr_psprintf(r->pool,
+                                          "bytes %" SVN_FILESIZE_T_FMT
+                                          "-%" SVN_FILESIZE_T_FMT
+                                          "/%" SVN_FILESIZE_T_FMT,
+                                          resource->info->range_offset,
+                                          resource->info->range_offset
+                                          + resource->info->range_length - 1,
+                                          length));
+              length = resource->info->range_length;
+            }
+
           ap_set_content_length(r, (apr_off_t) length);
         }
     }
@@ -3383,6 +3488,11 @@ set_headers(request_rec *r, const dav_resource *resource)
 typedef struct diff_ctx_t {
   dav_svn__output *output;
   apr_bucket_brigade *bb;
+
+  /* If not NULL, also collect the data in CAPTURE for CACHE, as long as
+     CACHE can hold it. */
+  svn_stringbuf_t *capture;
+  svn_cache__t *cache;
 } diff_ctx_t;
 
 
@@ -3391,6 +3501,14 @@ write_to_filter(void *baton, const char *buffer, apr_size_t *len)
 {
   diff_ctx_t *dc = baton;
 
+  if (dc->capture)
+    {
+      if (svn_cache__is_cachable(dc->cache, dc->capture->len + *len))
+        svn_stringbuf_appendbytes(dc->capture, buffer, *len);
+      else
+        dc->capture = NULL;
+    }
+
   /* take the current data and shove it into the filter */
   SVN_ERR(dav_svn__brigade_write(dc->bb, dc->output, buffer, *len));
 
@@ -3659,6 +3777,71 @@ emit_collection_tail(const dav_resource *resource,
 }
 
 
+/* Process-wide cache of svndiff responses for immutable resources, see
+   SVNCacheResponses.  NULL if no in-memory cache has been configured.
+   Since it lives in the global membuffer cache, it is shared between
+   processes and persisted along with that cache, if so configured. */
+static svn_cache__t *response_cache = NULL;
+static volatile svn_atomic_t response_cache_init_state = 0;
+
+/* Implements svn_atomic__err_init_func_t, creating RESPONSE_CACHE. */
+static svn_error_t *
+init_response_cache(void *baton, apr_pool_t *scratch_pool)
+{
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+
+  if (membuffer)
+    SVN_ERR(svn_cache__create_membuffer_cache(
+                &response_cache, membuffer,
+                NULL /* stringbuf */, NULL /* stringbuf */,
+                APR_HASH_KEY_STRING, "dav_svn:response",
+                SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                TRUE /* thread_safe */, FALSE /* short_lived */,
+                svn_pool_create(NULL), scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the cache for the svndiff of RESOURCE against the base file
+   BASE_INFO in *CACHE and its key in *KEY, allocated in RESOURCE's pool.
+   Set *CACHE to NULL if the response must not or can't be cached. */
+static void
+get_response_cache(svn_cache__t **cache,
+                   const char **key,
+                   const dav_resource *resource,
+                   const dav_svn__uri_info *base_info)
+{
+  request_rec *r = resource->info->r;
+  const char *uuid;
+  svn_error_t *serr;
+
+  *cache = NULL;
+  if (!dav_svn__get_response_cache_flag(r)
+      || !is_cacheable(r, resource)
+      || resource->info->keyword_subst)
+    return;
+
+  serr = svn_atomic__init_once(&response_cache_init_state,
+                               init_response_cache, NULL, resource->pool);
+  if (!serr)
+    serr = svn_fs_get_uuid(resource->info->repos->fs, &uuid,
+                           resource->pool);
+
+  /* Caching is optional. */
+  if (serr)
+    {
+      svn_error_clear(serr);
+      return;
+    }
+
+  *cache = response_cache;
+  *key = apr_psprintf(resource->pool, "%s:%ld:%s:%ld:%s:%d:%d", uuid,
+                      resource->info->root.rev, resource->info->repos_path,
+                      base_info->rev, base_info->repos_path,
+                      resource->info->svndiff_version,
+                      dav_svn__get_compression_level(r));
+}
+
 static dav_error *
 deliver(const dav_resource *resource, ap_filter_t *unused)
 {
@@ -3867,6 +4050,46 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
       /* If we successfully parse the base URL, then send an svndiff. */
       if ((serr == NULL) && (info.rev != SVN_INVALID_REVNUM))
         {
+          svn_cache__t *cache;
+          const char *cache_key;
+
+          /* Immutable responses may have been generated before. */
+          get_response_cache(&cache, &cache_key, resource, &info);
+          if (cache)
+            {
+              svn_stringbuf_t *cached;
+              svn_boolean_t found;
+              apr_size_t len;
+
+              serr = svn_cache__get((void **)&cached, &found, cache,
+                                    cache_key, resource->pool);
+              if (serr || !found)
+                {
+                  svn_error_clear(serr);
+                }
+              else
+                {
+                  dc.output = output;
+                  dc.bb = apr_brigade_create(resource->pool,
+                                    dav_svn__output_get_bucket_alloc(output));
+
+                  len = cached->len;
+                  serr = write_to_filter(&dc, cached->data, &len);
+                  if (serr == NULL)
+                    serr = close_filter(&dc);
+                  apr_brigade_destroy(dc.bb);
+
+                  if (serr != NULL)
+                    return dav_svn__convert_err(serr,
+                                                HTTP_INTERNAL_SERVER_ERROR,
+                                                "could not deliver the "
+                                                "cached txdelta stream",
+                                                resource->pool);
+
+                  return NULL;
+                }
+            }
+
           /* We are always accessing the base resource by ID, so open
              an ID root. */
           serr = svn_fs_revision_root(&root, resource->info->repos->fs,
@@ -3909,6 +4132,11 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
              which will copy it to the network */
           dc.output = output;
           dc.bb = bb;
+          if (cache)
+            {
+              dc.cache = cache;
+              dc.capture = svn_stringbuf_create_empty(resource->pool);
+            }
           o_stream = svn_stream_create(&dc, resource->pool);
           svn_stream_set_write(o_stream, write_to_filter);
           svn_stream_set_close(o_stream, close_filter);
@@ -3931,6 +4159,10 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
                                         "could not deliver the txdelta stream",
                                         resource->pool);
 
+          /* Caching is optional. */
+          if (dc.capture)
+            svn_error_clear(svn_cache__set(cache, cache_key, dc.capture,
+                                           resource->pool));
 
           return NULL;
         }
@@ -3944,6 +4176,7 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
     {
       svn_stream_t *stream;
       char *block;
+      svn_filesize_t offset, remaining;
 
       serr = svn_fs_file_contents(&stream,
                                   resource->info->root.root,
@@ -4027,6 +4260,23 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
             }
         }
 
+      /* For a byte range, skip to its start without reconstructing
+         the data before it, as far as the fs allows. */
+      remaining = resource->info->range_length;
+      for (offset = resource->info->range_offset; offset > 0; )
+        {
+          apr_size_t to_skip = offset > APR_SIZE_MAX
+                             ? APR_SIZE_MAX
+                             : (apr_size_t)offset;
+
+          serr = svn_stream_skip(stream, to_skip);
+          if (serr != NULL)
+            return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                        "could not skip to the range",
+                                        resource->pool);
+          offset -= to_skip;
+        }
+
       /* ### one day in the future, we can create a custom bucket type
          ### which will read from the FS stream on demand */
 
@@ -4037,6 +4287,14 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
       while (1) {
         apr_size_t bufsize = SVN__STREAM_CHUNK_SIZE;
 
+        if (resource->info->range_length)
+          {
+            if (remaining == 0)
+              break;
+            if (remaining < (svn_filesize_t)bufsize)
+              bufsize = (apr_size_t)remaining;
+          }
+
         /* read from the FS ... */
         serr = svn_stream_read_full(stream, block, &bufsize);
         if (serr != NULL)
@@ -4048,6 +4306,7 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
           }
         if (bufsize == 0)
           break;
+        remaining -= bufsize;
 
         /* write to the filter ... */
         bkt = apr_bucket_transient_create(
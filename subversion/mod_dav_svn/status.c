@@ -28,6 +28,7 @@
 #include "dav_svn.h"
 #include "private/svn_cache.h"
 #include "private/svn_fs_private.h"
+#include "private/svn_fs_fs_private.h"
 
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>   /* For getpid() */
@@ -66,7 +67,150 @@
      </Location>
 
   and then point a browser at http://server/svn-status.
+
+  The membuffer cache statistics are followed by a break-down by cache
+  prefix class, i.e. by type of cached data.
+
+  If SVNFSFSAccessTrace has been set, the recent FSFS item reads will be
+  listed as well.  Adding "?clear" to the URL empties the trace after
+  showing it.
+
+  Finally, the time that this process spent in each request phase is
+  summed up over all requests it has logged.
 */
+
+/* Write the process-wide totals of the request phase timers to R.
+   Do nothing if no request has been timed. */
+static void
+write_phase_totals(request_rec *r)
+{
+  static const char * const labels[DAV_SVN__PHASE_COUNT] =
+    { "Authz", "FS open", "Report", "Send" };
+  apr_interval_time_t totals[DAV_SVN__PHASE_COUNT];
+  apr_uint64_t requests;
+  int i;
+
+  dav_svn__get_phase_totals(&requests, totals);
+  if (requests == 0)
+    return;
+
+  ap_rprintf(r, "</dl>\n<h2>Request Phase Times</h2>\n"
+                "<p>%" APR_UINT64_T_FMT " requests timed.</p>\n"
+                "<table border=\"1\">\n"
+                "<tr><th>Phase</th><th>Total [usec]</th>"
+                "<th>Average [usec]</th></tr>\n",
+             requests);
+
+  for (i = 0; i < DAV_SVN__PHASE_COUNT; ++i)
+    ap_rprintf(r, "<tr><td>%s</td><td>%" APR_TIME_T_FMT "</td>"
+                  "<td>%" APR_TIME_T_FMT "</td></tr>\n",
+               labels[i], totals[i],
+               (apr_interval_time_t)(totals[i] / requests));
+
+  ap_rvputs(r, "</table>\n<dl>\n", SVN_VA_NULL);
+}
+
+/* Write the contents of the process-wide FSFS access trace to R.
+   Do nothing if the trace is not available. */
+static void
+write_access_trace(request_rec *r)
+{
+  svn_fs_fs__ioctl_get_access_trace_input_t input = { FALSE };
+  svn_fs_fs__ioctl_get_access_trace_output_t *output;
+  svn_error_t *serr;
+  int i;
+
+  input.clear = r->args && strcmp(r->args, "clear") == 0;
+  serr = svn_fs_ioctl(NULL, SVN_FS_FS__IOCTL_GET_ACCESS_TRACE, &input,
+                      (void **)&output, NULL, NULL, r->pool, r->pool);
+  if (serr)
+    {
+      svn_error_clear(serr);
+      return;
+    }
+
+  if (output->entries->nelts == 0 && output->dropped == 0)
+    return;
+
+  ap_rprintf(r, "</dl>\n<h2>FSFS Access Trace</h2>\n"
+                "<p>%" APR_UINT64_T_FMT " older entries dropped.</p>\n"
+                "<table border=\"1\">\n"
+                "<tr><th>Time</th><th>Repository</th><th>Revision</th>"
+                "<th>Item</th><th>Type</th><th>Cache</th><th>Offset</th>"
+                "<th>Size</th><th>Latency [usec]</th></tr>\n",
+             output->dropped);
+
+  for (i = 0; i < output->entries->nelts; ++i)
+    {
+      const svn_fs_fs__access_trace_entry_t *entry
+        = APR_ARRAY_IDX(output->entries, i,
+                        const svn_fs_fs__access_trace_entry_t *);
+
+      ap_rprintf(r, "<tr><td>%s</td><td>%s</td><td>%ld</td>"
+                    "<td>%" APR_UINT64_T_FMT "</td><td>%u</td><td>%s</td>"
+                    "<td>%" APR_OFF_T_FMT "</td><td>%" APR_OFF_T_FMT "</td>"
+                    "<td>%" APR_TIME_T_FMT "</td></tr>\n",
+                 ap_ht_time(r->pool, entry->timestamp,
+                            DEFAULT_TIME_FORMAT, 0),
+                 ap_escape_html(r->pool, entry->fs_path),
+                 entry->revision, entry->item_index,
+                 (unsigned)entry->item_type,
+                 entry->cache_hit ? "hit" : "miss",
+                 entry->offset, entry->size,
+                 (apr_time_t)entry->latency);
+    }
+
+  ap_rvputs(r, "</table>\n<dl>\n", SVN_VA_NULL);
+}
+
+/* Write the per-prefix-class statistics of the global membuffer cache
+   to R.  Do nothing if there is no such cache or no activity. */
+static void
+write_prefix_stats(request_rec *r)
+{
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  apr_array_header_t *stats;
+  svn_error_t *serr;
+  int i;
+
+  if (!membuffer)
+    return;
+
+  serr = svn_cache__membuffer_get_prefix_stats(&stats, membuffer, r->pool);
+  if (serr)
+    {
+      svn_error_clear(serr);
+      return;
+    }
+
+  if (stats->nelts == 0)
+    return;
+
+  ap_rvputs(r, "</dl>\n<h2>Cache Statistics by Prefix</h2>\n"
+               "<table border=\"1\">\n"
+               "<tr><th>Prefix</th><th>Gets</th><th>Hits</th>"
+               "<th>Sets</th><th>Bytes inserted</th><th>Evictions</th>"
+               "<th>Too large</th></tr>\n", SVN_VA_NULL);
+
+  for (i = 0; i < stats->nelts; ++i)
+    {
+      const svn_cache__prefix_stats_t *entry
+        = APR_ARRAY_IDX(stats, i, const svn_cache__prefix_stats_t *);
+
+      ap_rprintf(r, "<tr><td>%s</td><td>%" APR_UINT64_T_FMT "</td>"
+                    "<td>%" APR_UINT64_T_FMT "</td>"
+                    "<td>%" APR_UINT64_T_FMT "</td>"
+                    "<td>%" APR_UINT64_T_FMT "</td>"
+                    "<td>%" APR_UINT64_T_FMT "</td>"
+                    "<td>%" APR_UINT64_T_FMT "</td></tr>\n",
+                 ap_escape_html(r->pool, entry->name),
+                 entry->gets, entry->hits, entry->sets,
+                 entry->bytes_inserted, entry->evictions, entry->rejected);
+    }
+
+  ap_rvputs(r, "</table>\n<dl>\n", SVN_VA_NULL);
+}
+
 int dav_svn__status(request_rec *r)
 {
   svn_cache__info_t *info;
@@ -113,6 +257,10 @@ int dav_svn__status(request_rec *r)
       ap_rvputs(r, "<dt>", line, "</dt>\n", SVN_VA_NULL);
     }
 
+  write_prefix_stats(r);
+  write_access_trace(r);
+  write_phase_totals(r);
+
   ap_rvputs(r, "</dl></body></html>\n", SVN_VA_NULL);
 
   return 0;
@@ -494,9 +494,11 @@ svn_error_t *
 dav_svn__output_pass_brigade(dav_svn__output *output,
                              apr_bucket_brigade *bb)
 {
+  apr_time_t start = apr_time_now();
   apr_status_t status;
 
   status = ap_pass_brigade(output->r->output_filters, bb);
+  dav_svn__add_phase_time(output->r, DAV_SVN__PHASE_SEND, start);
   /* Empty the brigade here, as required by ap_pass_brigade(). */
   apr_brigade_cleanup(bb);
   if (status)
@@ -513,6 +515,20 @@ dav_svn__output_pass_brigade(dav_svn__output *output,
 /*** Brigade I/O wrappers ***/
 
 
+/* Like ap_filter_flush(), but add the time spent to the send phase of the
+   request of the filter CTX.  Implements apr_brigade_flush. */
+static apr_status_t
+timed_filter_flush(apr_bucket_brigade *bb, void *ctx)
+{
+  ap_filter_t *f = ctx;
+  apr_time_t start = apr_time_now();
+  apr_status_t status = ap_filter_flush(bb, ctx);
+
+  dav_svn__add_phase_time(f->r, DAV_SVN__PHASE_SEND, start);
+  return status;
+}
+
+
 svn_error_t *
 dav_svn__brigade_write(apr_bucket_brigade *bb,
                        dav_svn__output *output,
@@ -520,7 +536,7 @@ dav_svn__brigade_write(apr_bucket_brigade *bb,
                        apr_size_t len)
 {
   apr_status_t apr_err;
-  apr_err = apr_brigade_write(bb, ap_filter_flush,
+  apr_err = apr_brigade_write(bb, timed_filter_flush,
                               output->r->output_filters, data, len);
   if (apr_err)
     return svn_error_create(apr_err, 0, NULL);
@@ -538,7 +554,7 @@ dav_svn__brigade_puts(apr_bucket_brigade *bb,
                       const char *str)
 {
   apr_status_t apr_err;
-  apr_err = apr_brigade_puts(bb, ap_filter_flush,
+  apr_err = apr_brigade_puts(bb, timed_filter_flush,
                              output->r->output_filters, str);
   if (apr_err)
     return svn_error_create(apr_err, 0, NULL);
@@ -560,7 +576,7 @@ dav_svn__brigade_printf(apr_bucket_brigade *bb,
   va_list ap;
 
   va_start(ap, fmt);
-  apr_err = apr_brigade_vprintf(bb, ap_filter_flush,
+  apr_err = apr_brigade_vprintf(bb, timed_filter_flush,
                                 output->r->output_filters, fmt, ap);
   va_end(ap);
   if (apr_err)
@@ -582,7 +598,7 @@ dav_svn__brigade_putstrs(apr_bucket_brigade *bb,
   va_list ap;
 
   va_start(ap, output);
-  apr_err = apr_brigade_vputstrs(bb, ap_filter_flush,
+  apr_err = apr_brigade_vputstrs(bb, timed_filter_flush,
                                  output->r->output_filters, ap);
   va_end(ap);
   if (apr_err)
@@ -667,7 +683,7 @@ brigade_write_fn(void *baton, const char *data, apr_size_t *len)
   struct brigade_write_baton *wb = baton;
   apr_status_t apr_err;
 
-  apr_err = apr_brigade_write(wb->bb, ap_filter_flush,
+  apr_err = apr_brigade_write(wb->bb, timed_filter_flush,
                               wb->output->r->output_filters, data, *len);
 
   if (apr_err != APR_SUCCESS)
@@ -728,7 +744,10 @@ dav_svn__final_flush_or_error(request_rec *r,
      provided a more-important DERR, though. */
   if (do_flush)
     {
+      apr_time_t start = apr_time_now();
       apr_status_t apr_err = ap_fflush(output->r->output_filters, bb);
+
+      dav_svn__add_phase_time(output->r, DAV_SVN__PHASE_SEND, start);
       if (apr_err && (! derr))
         derr = dav_svn__new_error(pool, HTTP_INTERNAL_SERVER_ERROR, 0, apr_err,
                                   "Error flushing brigade.");
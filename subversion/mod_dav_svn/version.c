@@ -153,6 +153,7 @@ get_vsn_options(apr_pool_t *p, apr_text_header *phdr)
   apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_INLINE_PROPS);
   apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_REVERSE_FILE_REVS);
   apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_LIST);
+  apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_LOG_COMPACT);
   /* Mergeinfo is a special case: here we merely say that the server
    * knows how to handle mergeinfo -- whether the repository does too
    * is a separate matter.
@@ -370,6 +371,12 @@ get_option(const dav_resource *resource,
                      apr_pstrdup(r->pool, capabilities[i].capability_name));
     }
 
+  /* Whether we can handle svndiff3 depends on the build, so it can't
+     be part of the static list above. */
+  if (svn__zstd_available()
+      && (!master_version || svn_version__at_least(master_version, 1, 15, 0)))
+    apr_table_addn(r->headers_out, "DAV", SVN_DAV_NS_DAV_SVN_SVNDIFF3);
+
   return NULL;
 }
 
@@ -1533,6 +1540,12 @@ merge(dav_resource *target,
           serr = SVN_NO_ERROR;
         }
 
+      /* Slave servers that proxied this commit to us learn from this
+         that they are out of date (see SVNMasterReadThrough). */
+      apr_table_set(target->info->r->headers_out,
+                    SVN_DAV_YOUNGEST_REV_HEADER,
+                    apr_psprintf(pool, "%ld", new_rev));
+
       /* HTTPv2 doesn't send DELETE after a successful MERGE so if
          using the optional vtxn name mapping then delete it here. */
       if (source->info->root.vtxn_name)
@@ -97,6 +97,8 @@ check_lib_versions(void)
 /** Subcommands. **/
 
 static svn_opt_subcommand_t
+  subcommand_build_date_index,
+  subcommand_build_path_index,
   subcommand_build_repcache,
   subcommand_crashtest,
   subcommand_create,
@@ -156,10 +158,12 @@ enum svnadmin__cmdline_options_t
     svnadmin__check_normalization,
     svnadmin__metadata_only,
     svnadmin__no_flush_to_disk,
+    svnadmin__bulk_load,
     svnadmin__normalize_props,
     svnadmin__exclude,
     svnadmin__include,
-    svnadmin__glob
+    svnadmin__glob,
+    svnadmin__jobs
   };
 
 /* Option codes and descriptions.
@@ -256,6 +260,15 @@ static const apr_getopt_option_t options_table[] =
     {"keep-going",    svnadmin__keep_going, 0,
      N_("continue verification after detecting a corruption")},
 
+    {"jobs",          svnadmin__jobs, 1,
+     N_("use up to ARG worker threads where supported\n"
+        "                             (currently only for packing, hotcopying\n"
+        "                             and building the rep-cache of FSFS\n"
+        "                             repositories, for verifying the\n"
+        "                             metadata of FSFS format 7 repositories\n"
+        "                             and for dumping FSFS and FSX repositories).\n"
+        "                             Default: 1.")},
+
     {"memory-cache-size",     'M', 1,
      N_("size of the extra in-memory cache in MB used to\n"
         "                             minimize redundant operations. Default: 16.\n"
@@ -282,6 +295,11 @@ static const apr_getopt_option_t options_table[] =
      N_("disable flushing to disk during the operation\n"
         "                             (faster, but unsafe on power off)")},
 
+    {"bulk-load", svnadmin__bulk_load, 0,
+     N_("assume exclusive access to the repository and\n"
+        "                             flush the loaded revisions to disk only at\n"
+        "                             the end of the load (FSFS only)")},
+
     {"normalize-props", svnadmin__normalize_props, 0,
      N_("normalize property values found in the dumpstream\n"
         "                             (currently, only translates non-LF line endings)")},
@@ -307,6 +325,36 @@ static const apr_getopt_option_t options_table[] =
  */
 static const svn_opt_subcommand_desc3_t cmd_table[] =
 {
+  {"build-date-index", subcommand_build_date_index, {0}, {N_(
+    "usage: svnadmin build-date-index REPOS_PATH\n"
+    "\n"), N_(
+    "Create the revision date index for the repository at REPOS_PATH from\n"
+    "the svn:date properties of all revisions, replacing any existing one.\n"
+    "The index speeds up the lookup of revisions by date, e.g. for\n"
+    "'-r {DATE}'.  New repositories have it from the start; commits and\n"
+    "revision property changes keep it up to date.  Run this to add the\n"
+    "index to an older repository or after changing revision properties\n"
+    "with an older Subversion version.\n"
+    "To remove the index, delete the 'rev-dates' file from the\n"
+    "repository's 'db' directory.\n"
+   )},
+   {'q', 'M'} },
+
+  {"build-path-index", subcommand_build_path_index, {0}, {N_(
+    "usage: svnadmin build-path-index REPOS_PATH\n"
+    "\n"), N_(
+    "Create the per-path revision index for the repository at REPOS_PATH,\n"
+    "if it does not exist yet, and add all revisions missing from it.\n"
+    "Once created, the index is updated with every commit and speeds up\n"
+    "'svn log' for paths deep down the repository tree as well as the\n"
+    "tracing of copies, e.g. for location segments used by merges, and\n"
+    "the mergeinfo lookups of merges.  Run this again to index copies\n"
+    "and mergeinfo in older revisions after an upgrade.\n"
+    "To remove the index, delete the 'path-index.db' file from the\n"
+    "repository's 'db' directory.\n"
+   )},
+   {'q', 'M'} },
+
   {"build-repcache", subcommand_build_repcache, {0}, {N_(
     "usage: svnadmin build-repcache REPOS_PATH [-r LOWER[:UPPER]]\n"
     "\n"), N_(
@@ -315,7 +363,7 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "If no revision arguments are given, process all revisions. If only\n"
     "LOWER revision argument is given, process only that single revision.\n"
    )},
-   {'r', 'q', 'M'} },
+   {'r', 'q', 'M', svnadmin__jobs} },
 
   {"crashtest", subcommand_crashtest, {0}, {N_(
     "usage: svnadmin crashtest REPOS_PATH\n"
@@ -383,7 +431,7 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "excluded, the copy is transformed into an add (unlike in 'svndumpfilter').\n"
    )},
   {'r', svnadmin__incremental, svnadmin__deltas, 'q', 'M', 'F',
-   svnadmin__exclude, svnadmin__include, svnadmin__glob },
+   svnadmin__exclude, svnadmin__include, svnadmin__glob, svnadmin__jobs },
   {{'F', N_("write to file ARG instead of stdout")}} },
 
   {"dump-revprops", subcommand_dump_revprops, {0}, {N_(
@@ -429,7 +477,7 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "If --incremental is passed, data which already exists at the destination\n"
     "is not copied again.  Incremental mode is implemented for FSFS repositories.\n"
    )},
-   {svnadmin__clean_logs, svnadmin__incremental, 'q'} },
+   {svnadmin__clean_logs, svnadmin__incremental, 'q', svnadmin__jobs} },
 
   {"info", subcommand_info, {0}, {N_(
     "usage: svnadmin info REPOS_PATH\n"
@@ -470,7 +518,7 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     svnadmin__use_pre_commit_hook, svnadmin__use_post_commit_hook,
     svnadmin__parent_dir, svnadmin__normalize_props,
     svnadmin__bypass_prop_validation, 'M',
-    svnadmin__no_flush_to_disk, 'F'},
+    svnadmin__no_flush_to_disk, svnadmin__bulk_load, 'F'},
    {{'F', N_("read from file ARG instead of stdin")}} },
 
   {"load-revprops", subcommand_load_revprops, {0}, {N_(
@@ -520,7 +568,7 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "Possibly compact the repository into a more efficient storage model.\n"
     "This may not apply to all repositories, in which case, exit.\n"
    )},
-   {'q', 'M'} },
+   {'q', 'M', svnadmin__jobs} },
 
   {"recover", subcommand_recover, {0}, {N_(
     "usage: svnadmin recover REPOS_PATH\n"
@@ -629,7 +677,7 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "\n"), N_(
     "Verify the data stored in the repository.\n"
    )},
-   {'t', 'r', 'q', svnadmin__keep_going, 'M',
+   {'t', 'r', 'q', svnadmin__keep_going, 'M', svnadmin__jobs,
     svnadmin__check_normalization, svnadmin__metadata_only} },
 
   { NULL, NULL, {0}, {NULL}, {0} }
@@ -664,10 +712,12 @@ struct svnadmin_opt_state
   svn_boolean_t bypass_prop_validation;             /* --bypass-prop-validation */
   svn_boolean_t ignore_dates;                       /* --ignore-dates */
   svn_boolean_t no_flush_to_disk;                   /* --no-flush-to-disk */
+  svn_boolean_t bulk_load;                          /* --bulk-load */
   svn_boolean_t normalize_props;                    /* --normalize_props */
   enum svn_repos_load_uuid uuid_action;             /* --ignore-uuid,
                                                        --force-uuid */
   apr_uint64_t memory_cache_size;                   /* --memory-cache-size M */
+  int jobs;                                         /* --jobs */
   const char *parent_dir;                           /* --parent-dir */
   const char *file;                                 /* --file */
   apr_array_header_t *exclude;                      /* --exclude */
@@ -702,6 +752,18 @@ open_repos(svn_repos_t **repos,
                            use_block_read ? "1" : "0");
   svn_hash_sets(fs_config, SVN_FS_CONFIG_NO_FLUSH_TO_DISK,
                            opt_state->no_flush_to_disk ? "1" : "0");
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_VERIFY_JOBS,
+                           apr_itoa(pool, opt_state->jobs));
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_PACK_JOBS,
+                           apr_itoa(pool, opt_state->jobs));
+  svn_hash_sets(fs_config, SVN_REPOS_CONFIG_DUMP_JOBS,
+                           apr_itoa(pool, opt_state->jobs));
+  svn_hash_sets(fs_config, SVN_REPOS_CONFIG_BULK_LOAD,
+                           opt_state->bulk_load ? "1" : "0");
+
+  /* We may commit many revisions (e.g. during 'load') using the same FS
+     object, so we get the most out of the rep-cache filter. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_REP_CACHE_FILTER, "1");
 
   /* now, open the requested repository */
   SVN_ERR(svn_repos_open3(repos, path, fs_config, pool, pool));
@@ -1058,7 +1120,7 @@ repos_verify_callback(void *baton,
 
 /* Implementation of svn_repos_notify_func_t to wrap the output to a
    response stream for svn_repos_dump_fs2(), svn_repos_verify_fs(),
-   svn_repos_hotcopy3() and others. */
+   svn_repos_hotcopy4() and others. */
 static void
 repos_notify_handler(void *baton,
                      const svn_repos_notify_t *notify,
@@ -2362,6 +2424,7 @@ subcommand_hotcopy(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   svn_stream_t *feedback_stream = NULL;
   apr_array_header_t *targets;
   const char *new_repos_path;
+  apr_hash_t *fs_config = apr_hash_make(pool);
 
   /* Expect one more argument: NEW_REPOS_PATH */
   SVN_ERR(parse_args(&targets, os, 1, 1, pool));
@@ -2372,8 +2435,13 @@ subcommand_hotcopy(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   if (! opt_state->quiet)
     feedback_stream = recode_stream_create(stdout, pool);
 
-  return svn_repos_hotcopy3(opt_state->repository_path, new_repos_path,
+  /* Packed shards may be copied concurrently. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_HOTCOPY_JOBS,
+                apr_itoa(pool, opt_state->jobs));
+
+  return svn_repos_hotcopy4(opt_state->repository_path, new_repos_path,
                             opt_state->clean_logs, opt_state->incremental,
+                            fs_config,
                             !opt_state->quiet ? repos_notify_handler : NULL,
                             feedback_stream, check_cancel, NULL, pool);
 }
@@ -2956,6 +3024,7 @@ build_rep_cache(svn_fs_t *fs,
 
   input.start_rev = start_rev;
   input.end_rev = end_rev;
+  input.jobs = opt_state->jobs;
 
   if (opt_state->quiet)
     {
@@ -2992,6 +3061,70 @@ build_rep_cache(svn_fs_t *fs,
     }
 }
 
+/* This implements `svn_opt_subcommand_t'. */
+static svn_error_t *
+subcommand_build_date_index(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  struct svnadmin_opt_state *opt_state = baton;
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_fs__ioctl_build_date_index_input_t input = {0};
+  svn_error_t *err;
+
+  /* Expect no more arguments. */
+  SVN_ERR(parse_args(NULL, os, 0, 0, pool));
+
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, opt_state, pool));
+  fs = svn_repos_fs(repos);
+
+  if (!opt_state->quiet)
+    input.progress_func = build_rep_cache_progress_func;
+
+  err = svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_BUILD_DATE_INDEX,
+                     &input, NULL,
+                     check_cancel, NULL, pool, pool);
+  if (err && err->apr_err == SVN_ERR_FS_UNRECOGNIZED_IOCTL_CODE)
+    return svn_error_quick_wrapf(err,
+                                 _("Building the date index is not "
+                                   "implemented for the filesystem type "
+                                   "found in '%s'"),
+                                 svn_fs_path(fs, pool));
+
+  return svn_error_trace(err);
+}
+
+/* This implements `svn_opt_subcommand_t'. */
+static svn_error_t *
+subcommand_build_path_index(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  struct svnadmin_opt_state *opt_state = baton;
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_fs__ioctl_build_path_index_input_t input = {0};
+  svn_error_t *err;
+
+  /* Expect no more arguments. */
+  SVN_ERR(parse_args(NULL, os, 0, 0, pool));
+
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, opt_state, pool));
+  fs = svn_repos_fs(repos);
+
+  if (!opt_state->quiet)
+    input.progress_func = build_rep_cache_progress_func;
+
+  err = svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_BUILD_PATH_INDEX,
+                     &input, NULL,
+                     check_cancel, NULL, pool, pool);
+  if (err && err->apr_err == SVN_ERR_FS_UNRECOGNIZED_IOCTL_CODE)
+    return svn_error_quick_wrapf(err,
+                                 _("Building the path index is not "
+                                   "implemented for the filesystem type "
+                                   "found in '%s'"),
+                                 svn_fs_path(fs, pool));
+
+  return svn_error_trace(err);
+}
+
 /* This implements `svn_opt_subcommand_t'. */
 static svn_error_t *
 subcommand_build_repcache(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -3076,6 +3209,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   opt_state.start_revision.kind = svn_opt_revision_unspecified;
   opt_state.end_revision.kind = svn_opt_revision_unspecified;
   opt_state.memory_cache_size = svn_cache_config_get()->cache_size;
+  opt_state.jobs = 1;
 
   /* Parse options. */
   SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
@@ -3141,6 +3275,13 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           opt_state.memory_cache_size = 0x100000 * sz_val;
         }
         break;
+      case svnadmin__jobs:
+        SVN_ERR(svn_cstring_atoi(&opt_state.jobs, opt_arg));
+        if (opt_state.jobs < 1)
+          return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                   _("Invalid number of jobs '%s'"),
+                                   opt_arg);
+        break;
       case 'F':
         SVN_ERR(svn_utf_cstring_to_utf8(&(opt_state.file), opt_arg, pool));
         dash_F_arg = TRUE;
@@ -3270,6 +3411,9 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case svnadmin__no_flush_to_disk:
         opt_state.no_flush_to_disk = TRUE;
         break;
+      case svnadmin__bulk_load:
+        opt_state.bulk_load = TRUE;
+        break;
       case svnadmin__normalize_props:
         opt_state.normalize_props = TRUE;
         break;
@@ -3418,6 +3562,11 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
 
     settings.cache_size = opt_state.memory_cache_size;
     settings.single_threaded = TRUE;
+#if APR_HAS_THREADS
+    /* Worker threads will access the caches concurrently. */
+    if (opt_state.jobs > 1)
+      settings.single_threaded = FALSE;
+#endif
 
     svn_cache_config_set(&settings);
   }
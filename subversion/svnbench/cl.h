@@ -33,6 +33,7 @@
 #include <apr_tables.h>
 
 #include "svn_client.h"
+#include "svn_delta.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -96,6 +97,10 @@ typedef struct svn_cl__opt_state_t
   svn_boolean_t trust_server_cert_not_yet_valid;
   svn_boolean_t trust_server_cert_other_failure;
   apr_array_header_t* search_patterns; /* pattern arguments for --search */
+  apr_int64_t file_size;         /* file size for null-commit, or -1 */
+  int concurrency;               /* number of load test workers */
+  int duration;                  /* load test duration in seconds */
+  const char *mix_file;          /* load test operation mix */ /* UTF-8! */
 } svn_cl__opt_state_t;
 
 
@@ -113,7 +118,13 @@ svn_opt_subcommand_t
   svn_cl__null_export,
   svn_cl__null_list,
   svn_cl__null_log,
-  svn_cl__null_info;
+  svn_cl__null_info,
+  svn_cl__null_update,
+  svn_cl__null_checkout,
+  svn_cl__null_diff,
+  svn_cl__null_merge,
+  svn_cl__null_commit,
+  svn_cl__load;
 
 
 /* See definition in main.c for documentation. */
@@ -155,6 +166,37 @@ extern svn_cancel_func_t svn_cl__check_cancel;
 
 
 
+/*** An editor that only counts what it receives. */
+
+/* What a null editor received. */
+typedef struct svn_cl__editor_stats_t
+{
+  apr_int64_t file_count;
+  apr_int64_t dir_count;
+  apr_int64_t delete_count;
+  apr_int64_t byte_count;
+  apr_int64_t prop_count;
+  apr_int64_t prop_byte_count;
+} svn_cl__editor_stats_t;
+
+/* Set *EDITOR and *EDIT_BATON to an editor that adds what it receives
+ * to STATS and discards it, checking for cancellation with the
+ * callbacks of CTX.  Allocate them in POOL.
+ */
+svn_error_t *
+svn_cl__get_null_editor(const svn_delta_editor_t **editor,
+                        void **edit_baton,
+                        svn_cl__editor_stats_t *stats,
+                        svn_client_ctx_t *ctx,
+                        apr_pool_t *pool);
+
+/* Print the counters in STATS, lined up with the timing summary. */
+svn_error_t *
+svn_cl__print_editor_stats(const svn_cl__editor_stats_t *stats,
+                           apr_pool_t *pool);
+
+
+
 /*** Notification functions to display results on the terminal. */
 
 /* Set *NOTIFY_FUNC_P and *NOTIFY_BATON_P to a notifier/baton for all
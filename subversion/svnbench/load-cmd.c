@@ -0,0 +1,559 @@
+/*
+ * load-cmd.c -- Run a mix of benchmarks concurrently
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* ==================================================================== */
+
+
+
+/*** Includes. ***/
+
+#include <string.h>
+
+#include <apr_thread_proc.h>
+#include <apr_time.h>
+
+#include "svn_client.h"
+#include "svn_cmdline.h"
+#include "svn_config.h"
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_string.h"
+#include "cl.h"
+
+#include "svn_private_config.h"
+#include "private/svn_sorts_private.h"
+
+
+/*** Code. ***/
+
+/* One line of the mix file. */
+typedef struct mix_entry_t
+{
+  /* Line number in the mix file, to identify the entry in the report. */
+  int line;
+
+  /* How often to run this entry relative to the others. */
+  int weight;
+
+  /* The subcommand to run. */
+  const svn_opt_subcommand_desc3_t *cmd;
+
+  /* Its options and targets, as const char *. */
+  apr_array_header_t *args;
+} mix_entry_t;
+
+/* What one worker measured for one mix entry. */
+typedef struct entry_stats_t
+{
+  /* Durations of the successful runs, as apr_interval_time_t. */
+  apr_array_header_t *latencies;
+
+  /* Number of failed runs, and the error of the first one. */
+  int errors;
+  svn_error_t *first_error;
+} entry_stats_t;
+
+/* State of one worker thread. */
+typedef struct worker_t
+{
+  /* The mix, shared read-only by all workers. */
+  const apr_array_header_t *entries;
+  int total_weight;
+
+  /* The options of the load command, the base of every run. */
+  const svn_cl__opt_state_t *opt_state;
+
+  /* When to stop starting new runs. */
+  apr_time_t deadline;
+
+  /* Client context with its own sessions and credentials. */
+  svn_client_ctx_t *ctx;
+
+  /* Per-entry results, one for each element of ENTRIES. */
+  entry_stats_t *stats;
+
+  /* State of the random number generator picking the entries. */
+  apr_uint32_t seed;
+
+  /* Root pool used only by this worker. */
+  apr_pool_t *pool;
+} worker_t;
+
+/* Set *OPT_STATE to the options for one run of an entry with ARGS, based
+   on BASE, and *ARGC and *ARGV to the command line that the subcommand
+   will get its targets from.  Only the options that make sense in a mix
+   are supported.  Allocate the results in POOL. */
+static svn_error_t *
+parse_entry_args(svn_cl__opt_state_t *opt_state,
+                 int *argc,
+                 const char ***argv,
+                 const svn_cl__opt_state_t *base,
+                 const apr_array_header_t *args,
+                 apr_pool_t *pool)
+{
+  apr_array_header_t *cmdline = apr_array_make(pool, args->nelts + 2,
+                                               sizeof(const char *));
+  int i;
+
+  *opt_state = *base;
+  opt_state->revision_ranges
+    = apr_array_make(pool, 1, sizeof(svn_opt_revision_range_t *));
+
+  APR_ARRAY_PUSH(cmdline, const char *) = "svnbench";
+  for (i = 0; i < args->nelts; i++)
+    {
+      const char *arg = APR_ARRAY_IDX(args, i, const char *);
+      const char *value = (i + 1 < args->nelts)
+                        ? APR_ARRAY_IDX(args, i + 1, const char *)
+                        : NULL;
+
+      if (arg[0] != '-')
+        {
+          APR_ARRAY_PUSH(cmdline, const char *) = arg;
+          continue;
+        }
+
+      if (strcmp(arg, "-v") == 0)
+        {
+          opt_state->verbose = TRUE;
+          continue;
+        }
+
+      if (!value)
+        return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                 _("Option '%s' needs an argument"), arg);
+      i++;
+
+      if (strcmp(arg, "-r") == 0)
+        {
+          if (svn_opt_parse_revision_to_range(opt_state->revision_ranges,
+                                              value, pool) != 0)
+            return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                     _("Syntax error in revision argument "
+                                       "'%s'"), value);
+          opt_state->used_revision_arg = TRUE;
+        }
+      else if (strcmp(arg, "-l") == 0)
+        {
+          SVN_ERR(svn_cstring_atoi(&opt_state->limit, value));
+        }
+      else if (strcmp(arg, "--depth") == 0)
+        {
+          opt_state->depth = svn_depth_from_word(value);
+          if (opt_state->depth == svn_depth_unknown
+              || opt_state->depth == svn_depth_exclude)
+            return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                     _("'%s' is not a valid depth"), value);
+        }
+      else
+        return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                 _("Option '%s' is not supported in a mix "
+                                   "file"), arg);
+    }
+
+  if (opt_state->revision_ranges->nelts == 0)
+    {
+      svn_opt_revision_range_t *range = apr_pcalloc(pool, sizeof(*range));
+
+      range->start.kind = svn_opt_revision_unspecified;
+      range->end.kind = svn_opt_revision_unspecified;
+      APR_ARRAY_PUSH(opt_state->revision_ranges,
+                     svn_opt_revision_range_t *) = range;
+    }
+  opt_state->start_revision = APR_ARRAY_IDX(opt_state->revision_ranges, 0,
+                                            svn_opt_revision_range_t *)->start;
+  opt_state->end_revision = APR_ARRAY_IDX(opt_state->revision_ranges, 0,
+                                          svn_opt_revision_range_t *)->end;
+
+  APR_ARRAY_PUSH(cmdline, const char *) = NULL;
+  *argc = cmdline->nelts - 1;
+  *argv = (const char **)cmdline->elts;
+
+  return SVN_NO_ERROR;
+}
+
+/* Run ENTRY once with the base options OPT_STATE and CTX. */
+static svn_error_t *
+run_entry(const mix_entry_t *entry,
+          const svn_cl__opt_state_t *opt_state,
+          svn_client_ctx_t *ctx,
+          apr_pool_t *pool)
+{
+  svn_cl__opt_state_t run_opt_state;
+  svn_cl__cmd_baton_t command_baton;
+  apr_getopt_t *os;
+  const char **argv;
+  int argc;
+  svn_error_t *err;
+
+  SVN_ERR(parse_entry_args(&run_opt_state, &argc, &argv, opt_state,
+                           entry->args, pool));
+
+  /* The subcommands only take their targets from OS. */
+  if (apr_getopt_init(&os, pool, argc, argv) != APR_SUCCESS)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL, NULL);
+
+  command_baton.opt_state = &run_opt_state;
+  command_baton.ctx = ctx;
+
+  err = entry->cmd->cmd_func(os, &command_baton, pool);
+
+  /* Some subcommands install a notifier with a baton of their own. */
+  ctx->notify_func2 = NULL;
+  ctx->notify_baton2 = NULL;
+
+  return svn_error_trace(err);
+}
+
+/* Return the index of a random element of ENTRIES, picked according to
+   the weights that add up to TOTAL_WEIGHT, advancing *SEED. */
+static int
+pick_entry(const apr_array_header_t *entries,
+           int total_weight,
+           apr_uint32_t *seed)
+{
+  int pick;
+  int i;
+
+  *seed = *seed * 1103515245 + 12345;
+  pick = (int)((*seed >> 8) % (apr_uint32_t)total_weight);
+
+  for (i = 0; i < entries->nelts - 1; i++)
+    {
+      pick -= APR_ARRAY_IDX(entries, i, mix_entry_t *)->weight;
+      if (pick < 0)
+        break;
+    }
+
+  return i;
+}
+
+/* Run randomly picked entries until the deadline of the worker_t DATA,
+   recording how long each of them took. */
+static void * APR_THREAD_FUNC
+worker_thread(apr_thread_t *thread, void *data)
+{
+  worker_t *worker = data;
+  apr_pool_t *iterpool = svn_pool_create(worker->pool);
+
+  while (apr_time_now() < worker->deadline)
+    {
+      int index = pick_entry(worker->entries, worker->total_weight,
+                             &worker->seed);
+      const mix_entry_t *entry = APR_ARRAY_IDX(worker->entries, index,
+                                               mix_entry_t *);
+      entry_stats_t *stats = &worker->stats[index];
+      apr_time_t start;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      err = svn_cl__check_cancel(NULL);
+      if (err)
+        {
+          svn_error_clear(err);
+          break;
+        }
+
+      start = apr_time_now();
+      err = run_entry(entry, worker->opt_state, worker->ctx, iterpool);
+      if (err)
+        {
+          if (stats->first_error)
+            svn_error_clear(err);
+          else
+            stats->first_error = err;
+          stats->errors++;
+        }
+      else
+        {
+          APR_ARRAY_PUSH(stats->latencies, apr_interval_time_t)
+            = apr_time_now() - start;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  apr_thread_exit(thread, APR_SUCCESS);
+  return NULL;
+}
+
+/* Read the mix file PATH into *ENTRIES and set *TOTAL_WEIGHT to the sum
+   of their weights.  Each non-empty line that doesn't start with '#'
+   holds a weight, a subcommand and its options and targets.  */
+static svn_error_t *
+read_mix(apr_array_header_t **entries,
+         int *total_weight,
+         const char *path,
+         apr_pool_t *pool)
+{
+  svn_stringbuf_t *contents;
+  apr_array_header_t *lines;
+  int i, k;
+
+  SVN_ERR(svn_stringbuf_from_file2(&contents, path, pool));
+  lines = svn_cstring_split(contents->data, "\n", FALSE, pool);
+
+  *entries = apr_array_make(pool, lines->nelts, sizeof(mix_entry_t *));
+  *total_weight = 0;
+  for (i = 0; i < lines->nelts; i++)
+    {
+      const char *line = APR_ARRAY_IDX(lines, i, const char *);
+      apr_array_header_t *words = svn_cstring_split(line, " \t\r", TRUE,
+                                                    pool);
+      mix_entry_t *entry;
+      const char *name;
+
+      if (words->nelts == 0
+          || APR_ARRAY_IDX(words, 0, const char *)[0] == '#')
+        continue;
+
+      entry = apr_pcalloc(pool, sizeof(*entry));
+      entry->line = i + 1;
+
+      if (words->nelts < 2
+          || svn_cstring_atoi(&entry->weight,
+                              APR_ARRAY_IDX(words, 0, const char *))
+          || entry->weight <= 0)
+        return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                 _("%s:%d: Expected a positive weight "
+                                   "and a subcommand"),
+                                 path, entry->line);
+
+      name = APR_ARRAY_IDX(words, 1, const char *);
+      entry->cmd = svn_opt_get_canonical_subcommand3(svn_cl__cmd_table, name);
+      if (!entry->cmd
+          || entry->cmd->cmd_func == svn_cl__help
+          || entry->cmd->cmd_func == svn_cl__load)
+        return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                 _("%s:%d: '%s' can't be run in a load "
+                                   "test"),
+                                 path, entry->line, name);
+
+      entry->args = apr_array_make(pool, words->nelts - 2,
+                                   sizeof(const char *));
+      for (k = 2; k < words->nelts; k++)
+        APR_ARRAY_PUSH(entry->args, const char *)
+          = APR_ARRAY_IDX(words, k, const char *);
+
+      APR_ARRAY_PUSH(*entries, mix_entry_t *) = entry;
+      *total_weight += entry->weight;
+    }
+
+  if ((*entries)->nelts == 0)
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             _("'%s' contains no operations"), path);
+
+  return SVN_NO_ERROR;
+}
+
+/* Compare two apr_interval_time_t for svn_sort__array(). */
+static int
+compare_latencies(const void *a,
+                  const void *b)
+{
+  apr_interval_time_t l1 = *(const apr_interval_time_t *)a;
+  apr_interval_time_t l2 = *(const apr_interval_time_t *)b;
+
+  return l1 < l2 ? -1 : (l1 > l2 ? 1 : 0);
+}
+
+/* Return the PERCENTILE of the sorted, non-empty LATENCIES in ms. */
+static double
+percentile(const apr_array_header_t *latencies,
+           int percentile)
+{
+  int index = (int)((apr_int64_t)(latencies->nelts - 1) * percentile / 100);
+
+  return APR_ARRAY_IDX(latencies, index, apr_interval_time_t) / 1.0e3;
+}
+
+/* Print the throughput and latency percentiles of each of ENTRIES, with
+   the results in STATS of WORKER_COUNT workers that ran for ELAPSED. */
+static svn_error_t *
+print_report(const apr_array_header_t *entries,
+             const worker_t *workers,
+             int worker_count,
+             apr_interval_time_t elapsed,
+             apr_pool_t *pool)
+{
+  double seconds = elapsed / 1.0e6;
+  apr_int64_t total = 0;
+  int i, k;
+
+  SVN_ERR(svn_cmdline_printf(pool,
+                             _("%-20s %9s %7s %9s %9s %9s %9s %9s\n"),
+                             _("operation"), _("runs"), _("errors"),
+                             _("runs/s"), _("p50 ms"), _("p90 ms"),
+                             _("p99 ms"), _("max ms")));
+
+  for (i = 0; i < entries->nelts; i++)
+    {
+      const mix_entry_t *entry = APR_ARRAY_IDX(entries, i, mix_entry_t *);
+      apr_array_header_t *latencies;
+      svn_error_t *first_error = NULL;
+      int errors = 0;
+
+      latencies = apr_array_make(pool, 0, sizeof(apr_interval_time_t));
+      for (k = 0; k < worker_count; k++)
+        {
+          apr_array_cat(latencies, workers[k].stats[i].latencies);
+          errors += workers[k].stats[i].errors;
+          if (!first_error)
+            first_error = workers[k].stats[i].first_error;
+        }
+      svn_sort__array(latencies, compare_latencies);
+      total += latencies->nelts;
+
+      if (latencies->nelts)
+        SVN_ERR(svn_cmdline_printf(
+                  pool, "%-20s %9d %7d %9.2f %9.3f %9.3f %9.3f %9.3f\n",
+                  apr_psprintf(pool, "%d:%s", entry->line, entry->cmd->name),
+                  latencies->nelts, errors, latencies->nelts / seconds,
+                  percentile(latencies, 50), percentile(latencies, 90),
+                  percentile(latencies, 99), percentile(latencies, 100)));
+      else
+        SVN_ERR(svn_cmdline_printf(
+                  pool, "%-20s %9d %7d\n",
+                  apr_psprintf(pool, "%d:%s", entry->line, entry->cmd->name),
+                  0, errors));
+
+      if (first_error)
+        svn_handle_warning2(stderr, first_error, "svnbench: ");
+    }
+
+  return svn_error_trace(svn_cmdline_printf(pool,
+                                            _("%15.2f runs per second\n"),
+                                            total / seconds));
+}
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__load(apr_getopt_t *os,
+             void *baton,
+             apr_pool_t *pool)
+{
+  svn_cl__opt_state_t *opt_state = ((svn_cl__cmd_baton_t *) baton)->opt_state;
+  svn_client_ctx_t *ctx = ((svn_cl__cmd_baton_t *) baton)->ctx;
+#if APR_HAS_THREADS
+  apr_array_header_t *entries;
+  int total_weight;
+  int concurrency = opt_state->concurrency ? opt_state->concurrency : 1;
+  int duration = opt_state->duration ? opt_state->duration : 60;
+  svn_cl__opt_state_t run_opt_state = { 0 };
+  apr_thread_t **threads;
+  worker_t *workers;
+  apr_time_t start;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i, k;
+
+  if (!opt_state->mix_file)
+    return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, NULL,
+                            _("The load test needs a --mix file"));
+  SVN_ERR(read_mix(&entries, &total_weight, opt_state->mix_file, pool));
+
+  /* Every run starts from the global options only, and runs quietly. */
+  run_opt_state.auth_username = opt_state->auth_username;
+  run_opt_state.auth_password = opt_state->auth_password;
+  run_opt_state.config_dir = opt_state->config_dir;
+  run_opt_state.no_auth_cache = opt_state->no_auth_cache;
+  run_opt_state.non_interactive = TRUE;
+  run_opt_state.depth = svn_depth_unknown;
+  run_opt_state.file_size = -1;
+  run_opt_state.quiet = TRUE;
+
+  /* Nothing the workers use may be shared, not even the allocator. */
+  threads = apr_pcalloc(pool, concurrency * sizeof(*threads));
+  workers = apr_pcalloc(pool, concurrency * sizeof(*workers));
+  start = apr_time_now();
+  for (i = 0; i < concurrency; i++)
+    {
+      worker_t *worker = &workers[i];
+      apr_hash_t *cfg_hash;
+      svn_config_t *cfg_config;
+
+      worker->entries = entries;
+      worker->total_weight = total_weight;
+      worker->opt_state = &run_opt_state;
+      worker->deadline = start + apr_time_from_sec(duration);
+      worker->seed = (apr_uint32_t)(start + i * 7919);
+      worker->pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+      worker->stats = apr_pcalloc(worker->pool,
+                                  entries->nelts * sizeof(*worker->stats));
+      for (k = 0; k < entries->nelts; k++)
+        worker->stats[k].latencies
+          = apr_array_make(worker->pool, 64, sizeof(apr_interval_time_t));
+
+      SVN_ERR(svn_config_copy_config(&cfg_hash, ctx->config, worker->pool));
+      SVN_ERR(svn_client_create_context2(&worker->ctx, cfg_hash,
+                                         worker->pool));
+      cfg_config = svn_hash_gets(cfg_hash, SVN_CONFIG_CATEGORY_CONFIG);
+      SVN_ERR(svn_cmdline_create_auth_baton2(
+                &worker->ctx->auth_baton,
+                TRUE /* non_interactive */,
+                opt_state->auth_username,
+                opt_state->auth_password,
+                opt_state->config_dir,
+                opt_state->no_auth_cache,
+                opt_state->trust_server_cert_unknown_ca,
+                opt_state->trust_server_cert_cn_mismatch,
+                opt_state->trust_server_cert_expired,
+                opt_state->trust_server_cert_not_yet_valid,
+                opt_state->trust_server_cert_other_failure,
+                cfg_config,
+                ctx->cancel_func,
+                ctx->cancel_baton,
+                worker->pool));
+      worker->ctx->cancel_func = ctx->cancel_func;
+      worker->ctx->cancel_baton = ctx->cancel_baton;
+    }
+
+  for (i = 0; i < concurrency && !err; i++)
+    {
+      apr_status_t status = apr_thread_create(&threads[i], NULL,
+                                              worker_thread, &workers[i],
+                                              workers[i].pool);
+      if (status)
+        err = svn_error_wrap_apr(status, _("Can't create thread"));
+    }
+
+  for (k = 0; k < i; k++)
+    {
+      apr_status_t retval;
+      if (threads[k])
+        apr_thread_join(&retval, threads[k]);
+    }
+
+  if (!err)
+    err = print_report(entries, workers, concurrency,
+                       apr_time_now() - start, pool);
+
+  for (i = 0; i < concurrency; i++)
+    svn_pool_destroy(workers[i].pool);
+
+  return svn_error_trace(err);
+#else
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Load tests need thread support"));
+#endif
+}
@@ -0,0 +1,276 @@
+/*
+ * null-commit-cmd.c -- Subversion synthetic commit benchmark
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* ==================================================================== */
+
+
+
+/*** Includes. ***/
+
+#include <apr_time.h>
+
+#include "svn_client.h"
+#include "svn_ra.h"
+#include "svn_delta.h"
+#include "svn_pools.h"
+#include "svn_props.h"
+#include "svn_hash.h"
+#include "svn_error.h"
+#include "svn_cmdline.h"
+#include "svn_dirent_uri.h"
+#include "svn_path.h"
+#include "cl.h"
+
+#include "svn_private_config.h"
+#include "private/svn_string_private.h"
+
+
+/*** Code. ***/
+
+/* Number of files added if no limit is given. */
+#define DEFAULT_FILE_COUNT 100
+
+/* Size of each file added if no size is given. */
+#define DEFAULT_FILE_SIZE 1024
+
+/* Number of files per directory of the synthetic tree. */
+#define FILES_PER_DIR 100
+
+/* Implements svn_commit_callback2_t, setting BATON, an svn_revnum_t *,
+   to the new revision. */
+static svn_error_t *
+commit_callback(const svn_commit_info_t *commit_info,
+                void *baton,
+                apr_pool_t *pool)
+{
+  svn_revnum_t *new_revision = baton;
+  *new_revision = commit_info->revision;
+
+  return SVN_NO_ERROR;
+}
+
+/* Fill CONTENTS with the text of file number INDEX.  The text is not
+   trivially compressible, so that the server stores and transfers
+   about as much as for real files. */
+static void
+make_contents(svn_stringbuf_t *contents,
+              int index)
+{
+  apr_uint32_t seed = (apr_uint32_t)index * 2654435761u + 1;
+  apr_size_t i;
+
+  for (i = 0; i < contents->len; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      contents->data[i] = (i % 64 == 63) ? '\n'
+                                         : (char)(' ' + (seed >> 16) % 95);
+    }
+}
+
+/* Add FILE_COUNT files of FILE_SIZE bytes each in a new directory below
+   the repository directory URL in a single commit, without a working
+   copy.  Set *NEW_REVISION to the new revision and *BYTE_COUNT to the
+   number of bytes in the files. */
+static svn_error_t *
+bench_null_commit(svn_revnum_t *new_revision,
+                  apr_int64_t *byte_count,
+                  const char *url,
+                  int file_count,
+                  apr_size_t file_size,
+                  svn_client_ctx_t *ctx,
+                  apr_pool_t *pool)
+{
+  svn_ra_session_t *ra_session;
+  svn_node_kind_t kind;
+  svn_revnum_t head;
+  apr_hash_t *revprops = apr_hash_make(pool);
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+  void *root_baton;
+  void *top_baton;
+  void *dir_baton = NULL;
+  const char *top_relpath;
+  const char *dir_relpath = NULL;
+  svn_stringbuf_t *contents;
+  apr_pool_t *dirpool = svn_pool_create(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  SVN_ERR(svn_client_open_ra_session2(&ra_session, url, NULL, ctx,
+                                      pool, pool));
+  SVN_ERR(svn_ra_get_latest_revnum(ra_session, &head, pool));
+  SVN_ERR(svn_ra_check_path(ra_session, "", head, &kind, pool));
+  if (kind != svn_node_dir)
+    return svn_error_createf(SVN_ERR_FS_NOT_DIRECTORY, NULL,
+                             _("'%s' is not a directory in the repository"),
+                             url);
+
+  /* Each run gets its own directory, so it can be repeated at will. */
+  top_relpath = apr_psprintf(pool, "svnbench-%" APR_TIME_T_FMT,
+                             apr_time_now());
+
+  svn_hash_sets(revprops, SVN_PROP_REVISION_LOG,
+                svn_string_create(_("Synthetic commit by svnbench"), pool));
+  SVN_ERR(svn_ra_get_commit_editor3(ra_session, &editor, &edit_baton,
+                                    revprops, commit_callback, new_revision,
+                                    NULL, FALSE, pool));
+
+  contents = svn_stringbuf_create_ensure(file_size, pool);
+  contents->len = file_size;
+  contents->data[file_size] = '\0';
+  *byte_count = 0;
+
+  err = editor->open_root(edit_baton, head, pool, &root_baton);
+  if (!err)
+    err = editor->add_directory(top_relpath, root_baton, NULL,
+                                SVN_INVALID_REVNUM, pool, &top_baton);
+
+  for (i = 0; !err && i < file_count; i++)
+    {
+      const char *file_relpath;
+      void *file_baton;
+      svn_txdelta_window_handler_t handler;
+      void *handler_baton;
+      svn_string_t file_contents;
+
+      svn_pool_clear(iterpool);
+
+      if (ctx->cancel_func)
+        {
+          err = ctx->cancel_func(ctx->cancel_baton);
+          if (err)
+            break;
+        }
+
+      /* Start a new directory every FILES_PER_DIR files. */
+      if (i % FILES_PER_DIR == 0)
+        {
+          if (dir_baton)
+            {
+              err = editor->close_directory(dir_baton, iterpool);
+              if (err)
+                break;
+            }
+
+          svn_pool_clear(dirpool);
+          dir_relpath = svn_relpath_join(top_relpath,
+                                         apr_psprintf(dirpool, "d%05d",
+                                                      i / FILES_PER_DIR),
+                                         dirpool);
+          err = editor->add_directory(dir_relpath, top_baton, NULL,
+                                      SVN_INVALID_REVNUM, dirpool,
+                                      &dir_baton);
+          if (err)
+            break;
+        }
+
+      file_relpath = svn_relpath_join(dir_relpath,
+                                      apr_psprintf(iterpool, "f%07d", i),
+                                      iterpool);
+      err = editor->add_file(file_relpath, dir_baton, NULL,
+                             SVN_INVALID_REVNUM, iterpool, &file_baton);
+      if (!err)
+        err = editor->apply_textdelta(file_baton, NULL, iterpool,
+                                      &handler, &handler_baton);
+      if (!err)
+        {
+          make_contents(contents, i);
+          file_contents.data = contents->data;
+          file_contents.len = contents->len;
+          err = svn_txdelta_send_string(&file_contents, handler,
+                                        handler_baton, iterpool);
+        }
+      if (!err)
+        err = editor->close_file(file_baton, NULL, iterpool);
+
+      if (!err)
+        *byte_count += file_size;
+    }
+
+  if (!err && dir_baton)
+    err = editor->close_directory(dir_baton, iterpool);
+  if (!err)
+    err = editor->close_directory(top_baton, pool);
+  if (!err)
+    err = editor->close_directory(root_baton, pool);
+  if (!err)
+    err = editor->close_edit(edit_baton, pool);
+
+  if (err)
+    return svn_error_compose_create(err,
+                                    editor->abort_edit(edit_baton, pool));
+
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(dirpool);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__null_commit(apr_getopt_t *os,
+                    void *baton,
+                    apr_pool_t *pool)
+{
+  svn_cl__opt_state_t *opt_state = ((svn_cl__cmd_baton_t *) baton)->opt_state;
+  svn_client_ctx_t *ctx = ((svn_cl__cmd_baton_t *) baton)->ctx;
+  apr_array_header_t *targets;
+  const char *url;
+  int file_count = opt_state->limit ? opt_state->limit : DEFAULT_FILE_COUNT;
+  apr_size_t file_size = opt_state->file_size >= 0
+                       ? (apr_size_t)opt_state->file_size
+                       : DEFAULT_FILE_SIZE;
+  svn_revnum_t new_revision = SVN_INVALID_REVNUM;
+  apr_int64_t byte_count = 0;
+
+  SVN_ERR(svn_cl__args_to_target_array_print_reserved(&targets, os,
+                                                      opt_state->targets,
+                                                      ctx, FALSE, pool));
+
+  /* We want exactly 1 target for this subcommand. */
+  if (targets->nelts < 1)
+    return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, 0, NULL);
+  if (targets->nelts > 1)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, 0, NULL);
+
+  url = APR_ARRAY_IDX(targets, 0, const char *);
+  if (! svn_path_is_url(url))
+    return svn_error_createf(SVN_ERR_BAD_URL, NULL,
+                             _("'%s' does not appear to be a URL"), url);
+
+  SVN_ERR(bench_null_commit(&new_revision, &byte_count, url,
+                            file_count, file_size, ctx, pool));
+
+  if (!opt_state->quiet)
+    SVN_ERR(svn_cmdline_printf(pool,
+                               _("%15s files added\n"
+                                 "%15s bytes in files\n"
+                                 "%15ld committed revision\n"),
+                               svn__i64toa_sep(file_count, ',', pool),
+                               svn__i64toa_sep(byte_count, ',', pool),
+                               new_revision));
+
+  return SVN_NO_ERROR;
+}
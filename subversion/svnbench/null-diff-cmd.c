@@ -0,0 +1,143 @@
+/*
+ * null-diff-cmd.c -- Subversion repository diff benchmark
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* ==================================================================== */
+
+
+
+/*** Includes. ***/
+
+#include "svn_client.h"
+#include "svn_ra.h"
+#include "svn_error.h"
+#include "svn_path.h"
+#include "cl.h"
+
+#include "svn_private_config.h"
+#include "private/svn_client_private.h"
+
+
+/*** Code. ***/
+
+/* Let the server send the differences between URL@PEG_REVISION in
+   START_REVISION and in END_REVISION, as it would for a repository to
+   repository 'svn diff', feeding them into a null editor that updates
+   STATS. */
+static svn_error_t *
+bench_null_diff(const char *url,
+                const svn_opt_revision_t *peg_revision,
+                const svn_opt_revision_t *start_revision,
+                const svn_opt_revision_t *end_revision,
+                svn_depth_t depth,
+                svn_cl__editor_stats_t *stats,
+                svn_client_ctx_t *ctx,
+                apr_pool_t *pool)
+{
+  svn_client__pathrev_t *loc;
+  svn_ra_session_t *ra_session;
+  svn_revnum_t end_rev;
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+  const svn_ra_reporter3_t *reporter;
+  void *report_baton;
+
+  SVN_ERR(svn_client__ra_session_from_path2(&ra_session, &loc, url, NULL,
+                                            peg_revision, start_revision,
+                                            ctx, pool));
+  SVN_ERR(svn_client__get_revision_number(&end_rev, NULL, ctx->wc_ctx,
+                                          NULL, ra_session, end_revision,
+                                          pool));
+
+  SVN_ERR(svn_cl__get_null_editor(&editor, &edit_baton, stats, ctx, pool));
+  SVN_ERR(svn_ra_do_diff3(ra_session, &reporter, &report_baton,
+                          end_rev,
+                          "", /* no sub-target */
+                          depth,
+                          TRUE /* ignore_ancestry */,
+                          TRUE /* text_deltas */,
+                          loc->url,
+                          editor, edit_baton,
+                          pool));
+
+  SVN_ERR(reporter->set_path(report_baton, "", loc->rev, depth,
+                             FALSE, NULL, pool));
+
+  return svn_error_trace(reporter->finish_report(report_baton, pool));
+}
+
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__null_diff(apr_getopt_t *os,
+                  void *baton,
+                  apr_pool_t *pool)
+{
+  svn_cl__opt_state_t *opt_state = ((svn_cl__cmd_baton_t *) baton)->opt_state;
+  svn_client_ctx_t *ctx = ((svn_cl__cmd_baton_t *) baton)->ctx;
+  apr_array_header_t *targets;
+  const char *truefrom;
+  svn_opt_revision_t peg_revision;
+  svn_opt_revision_t end_revision = opt_state->end_revision;
+  svn_cl__editor_stats_t stats = { 0 };
+  svn_error_t *err;
+
+  SVN_ERR(svn_cl__args_to_target_array_print_reserved(&targets, os,
+                                                      opt_state->targets,
+                                                      ctx, FALSE, pool));
+
+  /* We want exactly 1 target for this subcommand. */
+  if (targets->nelts < 1)
+    return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, 0, NULL);
+  if (targets->nelts > 1)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, 0, NULL);
+
+  SVN_ERR(svn_opt_parse_path(&peg_revision, &truefrom,
+                             APR_ARRAY_IDX(targets, 0, const char *), pool));
+  if (! svn_path_is_url(truefrom))
+    return svn_error_createf(SVN_ERR_BAD_URL, NULL,
+                             _("'%s' does not appear to be a URL"),
+                             truefrom);
+
+  /* There is nothing to compare without at least one revision. */
+  if (opt_state->start_revision.kind == svn_opt_revision_unspecified)
+    return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, NULL,
+                            _("A revision range must be given with "
+                              "'-r' or '-c'"));
+
+  if (peg_revision.kind == svn_opt_revision_unspecified)
+    peg_revision.kind = svn_opt_revision_head;
+  if (end_revision.kind == svn_opt_revision_unspecified)
+    end_revision.kind = svn_opt_revision_head;
+
+  if (opt_state->depth == svn_depth_unknown)
+    opt_state->depth = svn_depth_infinity;
+
+  err = bench_null_diff(truefrom, &peg_revision,
+                        &(opt_state->start_revision), &end_revision,
+                        opt_state->depth, &stats, ctx, pool);
+
+  if (!opt_state->quiet)
+    SVN_ERR(svn_cl__print_editor_stats(&stats, pool));
+
+  return svn_error_trace(err);
+}
@@ -0,0 +1,204 @@
+/*
+ * null-editor.c -- an editor that only counts what it receives
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* ==================================================================== */
+
+
+
+/*** Includes. ***/
+
+#include "svn_delta.h"
+#include "svn_error.h"
+#include "svn_cmdline.h"
+#include "cl.h"
+
+#include "svn_private_config.h"
+#include "private/svn_string_private.h"
+
+
+/*** Code. ***/
+
+/* All batons of the editor are the svn_cl__editor_stats_t to update. */
+
+static svn_error_t *
+open_root(void *edit_baton,
+          svn_revnum_t base_revision,
+          apr_pool_t *pool,
+          void **root_baton)
+{
+  *root_baton = edit_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+delete_entry(const char *path,
+             svn_revnum_t revision,
+             void *parent_baton,
+             apr_pool_t *pool)
+{
+  svn_cl__editor_stats_t *stats = parent_baton;
+  stats->delete_count++;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+add_directory(const char *path,
+              void *parent_baton,
+              const char *copyfrom_path,
+              svn_revnum_t copyfrom_revision,
+              apr_pool_t *pool,
+              void **baton)
+{
+  svn_cl__editor_stats_t *stats = parent_baton;
+  stats->dir_count++;
+
+  *baton = parent_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+open_directory(const char *path,
+               void *parent_baton,
+               svn_revnum_t base_revision,
+               apr_pool_t *pool,
+               void **baton)
+{
+  *baton = parent_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+add_file(const char *path,
+         void *parent_baton,
+         const char *copyfrom_path,
+         svn_revnum_t copyfrom_revision,
+         apr_pool_t *pool,
+         void **baton)
+{
+  svn_cl__editor_stats_t *stats = parent_baton;
+  stats->file_count++;
+
+  *baton = parent_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+open_file(const char *path,
+          void *parent_baton,
+          svn_revnum_t base_revision,
+          apr_pool_t *pool,
+          void **baton)
+{
+  svn_cl__editor_stats_t *stats = parent_baton;
+  stats->file_count++;
+
+  *baton = parent_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+window_handler(svn_txdelta_window_t *window, void *baton)
+{
+  svn_cl__editor_stats_t *stats = baton;
+  if (window != NULL)
+    stats->byte_count += window->tview_len;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+apply_textdelta(void *file_baton,
+                const char *base_checksum,
+                apr_pool_t *pool,
+                svn_txdelta_window_handler_t *handler,
+                void **handler_baton)
+{
+  *handler_baton = file_baton;
+  *handler = window_handler;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+change_prop(void *baton,
+            const char *name,
+            const svn_string_t *value,
+            apr_pool_t *pool)
+{
+  svn_cl__editor_stats_t *stats = baton;
+  stats->prop_count++;
+  if (value)
+    stats->prop_byte_count += value->len;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cl__get_null_editor(const svn_delta_editor_t **editor,
+                        void **edit_baton,
+                        svn_cl__editor_stats_t *stats,
+                        svn_client_ctx_t *ctx,
+                        apr_pool_t *pool)
+{
+  svn_delta_editor_t *null_editor = svn_delta_default_editor(pool);
+
+  null_editor->open_root = open_root;
+  null_editor->delete_entry = delete_entry;
+  null_editor->add_directory = add_directory;
+  null_editor->open_directory = open_directory;
+  null_editor->change_dir_prop = change_prop;
+  null_editor->add_file = add_file;
+  null_editor->open_file = open_file;
+  null_editor->apply_textdelta = apply_textdelta;
+  null_editor->change_file_prop = change_prop;
+
+  return svn_error_trace(svn_delta_get_cancellation_editor(ctx->cancel_func,
+                                                           ctx->cancel_baton,
+                                                           null_editor,
+                                                           stats,
+                                                           editor,
+                                                           edit_baton,
+                                                           pool));
+}
+
+svn_error_t *
+svn_cl__print_editor_stats(const svn_cl__editor_stats_t *stats,
+                           apr_pool_t *pool)
+{
+  return svn_error_trace(svn_cmdline_printf(
+                           pool,
+                           _("%15s directories\n"
+                             "%15s files\n"
+                             "%15s deletions\n"
+                             "%15s bytes in files\n"
+                             "%15s properties\n"
+                             "%15s bytes in properties\n"),
+                           svn__ui64toa_sep(stats->dir_count, ',', pool),
+                           svn__ui64toa_sep(stats->file_count, ',', pool),
+                           svn__ui64toa_sep(stats->delete_count, ',', pool),
+                           svn__ui64toa_sep(stats->byte_count, ',', pool),
+                           svn__ui64toa_sep(stats->prop_count, ',', pool),
+                           svn__ui64toa_sep(stats->prop_byte_count, ',',
+                                            pool)));
+}
@@ -268,7 +268,7 @@ svn_cl__null_info(apr_getopt_t *os,
           err = NULL;
           seen_nonexistent_target = TRUE;
         }
-      else
+      else if (!opt_state->quiet)
         {
           SVN_ERR(svn_cmdline_printf(pool, _("Number of status notifications "
                                              "received: %d\n"),
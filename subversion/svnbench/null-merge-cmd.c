@@ -0,0 +1,174 @@
+/*
+ * null-merge-cmd.c -- Subversion merge calculation benchmark
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* ==================================================================== */
+
+
+
+/*** Includes. ***/
+
+#include "svn_client.h"
+#include "svn_wc.h"
+#include "svn_error.h"
+#include "svn_cmdline.h"
+#include "svn_path.h"
+#include "cl.h"
+
+#include "svn_private_config.h"
+#include "private/svn_string_private.h"
+
+
+/*** Code. ***/
+
+/* What the merge would have done to the working copy. */
+typedef struct merge_stats_t
+{
+  apr_int64_t added;
+  apr_int64_t updated;
+  apr_int64_t deleted;
+  apr_int64_t conflicted;
+  apr_int64_t skipped;
+} merge_stats_t;
+
+/* Implements svn_wc_notify_func2_t, counting the changes in BATON,
+   a merge_stats_t. */
+static void
+count_notification(void *baton,
+                   const svn_wc_notify_t *notify,
+                   apr_pool_t *pool)
+{
+  merge_stats_t *stats = baton;
+
+  switch (notify->action)
+    {
+      case svn_wc_notify_update_add:
+        stats->added++;
+        break;
+
+      case svn_wc_notify_update_update:
+        if (notify->content_state == svn_wc_notify_state_conflicted
+            || notify->prop_state == svn_wc_notify_state_conflicted)
+          stats->conflicted++;
+        else
+          stats->updated++;
+        break;
+
+      case svn_wc_notify_update_delete:
+        stats->deleted++;
+        break;
+
+      case svn_wc_notify_tree_conflict:
+        stats->conflicted++;
+        break;
+
+      case svn_wc_notify_skip:
+      case svn_wc_notify_update_skip_obstruction:
+      case svn_wc_notify_update_skip_working_only:
+      case svn_wc_notify_update_skip_access_denied:
+        stats->skipped++;
+        break;
+
+      default:
+        break;
+    }
+}
+
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__null_merge(apr_getopt_t *os,
+                   void *baton,
+                   apr_pool_t *pool)
+{
+  svn_cl__opt_state_t *opt_state = ((svn_cl__cmd_baton_t *) baton)->opt_state;
+  svn_client_ctx_t *ctx = ((svn_cl__cmd_baton_t *) baton)->ctx;
+  apr_array_header_t *targets;
+  apr_array_header_t *ranges_to_merge = NULL;
+  const char *source;
+  const char *target_wcpath = "";
+  svn_opt_revision_t peg_revision;
+  merge_stats_t stats = { 0 };
+  svn_error_t *err;
+
+  SVN_ERR(svn_cl__args_to_target_array_print_reserved(&targets, os,
+                                                      opt_state->targets,
+                                                      ctx, FALSE, pool));
+
+  /* We want a source and optionally a target working copy path. */
+  if (targets->nelts < 1)
+    return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, 0, NULL);
+  if (targets->nelts > 2)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, 0, NULL);
+
+  SVN_ERR(svn_opt_parse_path(&peg_revision, &source,
+                             APR_ARRAY_IDX(targets, 0, const char *), pool));
+  if (targets->nelts == 2)
+    {
+      target_wcpath = APR_ARRAY_IDX(targets, 1, const char *);
+      SVN_ERR(svn_cl__check_target_is_local_path(target_wcpath));
+    }
+
+  if (peg_revision.kind == svn_opt_revision_unspecified)
+    peg_revision.kind = svn_path_is_url(source)
+                      ? svn_opt_revision_head
+                      : svn_opt_revision_working;
+
+  /* Without a revision range, calculate an automatic merge. */
+  if (APR_ARRAY_IDX(opt_state->revision_ranges, 0,
+                    svn_opt_revision_range_t *)->start.kind
+        != svn_opt_revision_unspecified)
+    ranges_to_merge = opt_state->revision_ranges;
+
+  if (opt_state->depth == svn_depth_unknown)
+    opt_state->depth = svn_depth_infinity;
+
+  /* Count what the merge would do instead of printing it.  A dry run
+     does all the calculation but doesn't touch the working copy. */
+  ctx->notify_func2 = count_notification;
+  ctx->notify_baton2 = &stats;
+
+  err = svn_client_merge_peg5(source, ranges_to_merge, &peg_revision,
+                              target_wcpath, opt_state->depth,
+                              FALSE /* ignore_mergeinfo */,
+                              FALSE /* diff_ignore_ancestry */,
+                              FALSE /* force_delete */,
+                              FALSE /* record_only */,
+                              TRUE /* dry_run */,
+                              TRUE /* allow_mixed_rev */,
+                              NULL, ctx, pool);
+
+  if (!opt_state->quiet)
+    SVN_ERR(svn_cmdline_printf(pool,
+                               _("%15s added\n"
+                                 "%15s updated\n"
+                                 "%15s deleted\n"
+                                 "%15s conflicted\n"
+                                 "%15s skipped\n"),
+                               svn__ui64toa_sep(stats.added, ',', pool),
+                               svn__ui64toa_sep(stats.updated, ',', pool),
+                               svn__ui64toa_sep(stats.deleted, ',', pool),
+                               svn__ui64toa_sep(stats.conflicted, ',', pool),
+                               svn__ui64toa_sep(stats.skipped, ',', pool)));
+
+  return svn_error_trace(err);
+}
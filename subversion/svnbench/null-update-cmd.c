@@ -0,0 +1,260 @@
+/*
+ * null-update-cmd.c -- Subversion update and checkout benchmarks
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* ==================================================================== */
+
+
+
+/*** Includes. ***/
+
+#include "svn_client.h"
+#include "svn_wc.h"
+#include "svn_ra.h"
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_dirent_uri.h"
+#include "svn_path.h"
+#include "cl.h"
+
+#include "svn_private_config.h"
+#include "private/svn_client_private.h"
+
+
+/*** Code. ***/
+
+/* Let the server send the changes that would update the working copy
+   at LOCAL_ABSPATH to REVISION, reporting the state of the working copy
+   just like 'svn update' does, but feed them into a null editor that
+   updates STATS.  Nothing in the working copy is changed. */
+static svn_error_t *
+bench_null_update(const char *local_abspath,
+                  const svn_opt_revision_t *revision,
+                  svn_depth_t depth,
+                  svn_cl__editor_stats_t *stats,
+                  svn_client_ctx_t *ctx,
+                  apr_pool_t *pool)
+{
+  const char *anchor_abspath;
+  const char *target;
+  const char *anchor_url;
+  svn_ra_session_t *ra_session;
+  svn_revnum_t revnum;
+  svn_opt_revision_t opt_rev = *revision;
+  svn_boolean_t server_supports_depth;
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+  const svn_ra_reporter3_t *reporter;
+  void *report_baton;
+
+  SVN_ERR(svn_wc_get_actual_target2(&anchor_abspath, &target, ctx->wc_ctx,
+                                    local_abspath, pool, pool));
+  SVN_ERR(svn_client_url_from_path2(&anchor_url, anchor_abspath, ctx,
+                                    pool, pool));
+  if (!anchor_url)
+    return svn_error_createf(SVN_ERR_ENTRY_MISSING_URL, NULL,
+                             _("'%s' has no URL"),
+                             svn_dirent_local_style(anchor_abspath, pool));
+
+  SVN_ERR(svn_client_open_ra_session2(&ra_session, anchor_url,
+                                      anchor_abspath, ctx, pool, pool));
+
+  if (opt_rev.kind == svn_opt_revision_unspecified)
+    opt_rev.kind = svn_opt_revision_head;
+  SVN_ERR(svn_client__get_revision_number(&revnum, NULL, ctx->wc_ctx,
+                                          local_abspath, ra_session, &opt_rev,
+                                          pool));
+
+  SVN_ERR(svn_ra_has_capability(ra_session, &server_supports_depth,
+                                SVN_RA_CAPABILITY_DEPTH, pool));
+
+  SVN_ERR(svn_cl__get_null_editor(&editor, &edit_baton, stats, ctx, pool));
+  SVN_ERR(svn_ra_do_update3(ra_session, &reporter, &report_baton,
+                            revnum, target,
+                            server_supports_depth ? depth
+                                                  : svn_depth_unknown,
+                            FALSE /* send_copyfrom_args */,
+                            FALSE /* ignore_ancestry */,
+                            editor, edit_baton,
+                            pool, pool));
+
+  /* Describe the working copy without restoring missing files. */
+  SVN_ERR(svn_wc_crawl_revisions5(ctx->wc_ctx, local_abspath, reporter,
+                                  report_baton, FALSE /* restore_files */,
+                                  depth, TRUE /* honor_depth_exclude */,
+                                  ! server_supports_depth,
+                                  FALSE /* use_commit_times */,
+                                  ctx->cancel_func, ctx->cancel_baton,
+                                  NULL, NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Let the server send the tree at URL@PEG_REVISION in REVISION as it
+   would for 'svn checkout', feeding it into a null editor that updates
+   STATS. */
+static svn_error_t *
+bench_null_checkout(const char *url,
+                    const svn_opt_revision_t *peg_revision,
+                    const svn_opt_revision_t *revision,
+                    svn_depth_t depth,
+                    svn_cl__editor_stats_t *stats,
+                    svn_client_ctx_t *ctx,
+                    apr_pool_t *pool)
+{
+  svn_client__pathrev_t *loc;
+  svn_ra_session_t *ra_session;
+  svn_node_kind_t kind;
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+  const svn_ra_reporter3_t *reporter;
+  void *report_baton;
+
+  SVN_ERR(svn_client__ra_session_from_path2(&ra_session, &loc, url, NULL,
+                                            peg_revision, revision,
+                                            ctx, pool));
+
+  SVN_ERR(svn_ra_check_path(ra_session, "", loc->rev, &kind, pool));
+  if (kind == svn_node_none)
+    return svn_error_createf(SVN_ERR_RA_ILLEGAL_URL, NULL,
+                             _("URL '%s' doesn't exist"), loc->url);
+  if (kind == svn_node_file)
+    return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                             _("URL '%s' refers to a file, not a directory"),
+                             loc->url);
+
+  SVN_ERR(svn_cl__get_null_editor(&editor, &edit_baton, stats, ctx, pool));
+  SVN_ERR(svn_ra_do_update3(ra_session, &reporter, &report_baton,
+                            loc->rev,
+                            "", /* no sub-target */
+                            depth,
+                            FALSE /* send_copyfrom_args */,
+                            FALSE /* ignore_ancestry */,
+                            editor, edit_baton,
+                            pool, pool));
+
+  SVN_ERR(reporter->set_path(report_baton, "", loc->rev, depth,
+                             TRUE, /* "help, my dir is empty!" */
+                             NULL, pool));
+
+  SVN_ERR(reporter->finish_report(report_baton, pool));
+
+  /* We don't receive the "add directory" callback for the root. */
+  stats->dir_count++;
+
+  return SVN_NO_ERROR;
+}
+
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__null_update(apr_getopt_t *os,
+                    void *baton,
+                    apr_pool_t *pool)
+{
+  svn_cl__opt_state_t *opt_state = ((svn_cl__cmd_baton_t *) baton)->opt_state;
+  svn_client_ctx_t *ctx = ((svn_cl__cmd_baton_t *) baton)->ctx;
+  apr_array_header_t *targets;
+  apr_pool_t *iterpool;
+  svn_cl__editor_stats_t stats = { 0 };
+  int i;
+
+  SVN_ERR(svn_cl__args_to_target_array_print_reserved(&targets, os,
+                                                      opt_state->targets,
+                                                      ctx, FALSE, pool));
+
+  /* Add "." if user passed 0 arguments. */
+  svn_opt_push_implicit_dot_target(targets, pool);
+
+  if (opt_state->depth == svn_depth_unknown)
+    opt_state->depth = svn_depth_infinity;
+
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < targets->nelts; i++)
+    {
+      const char *target = APR_ARRAY_IDX(targets, i, const char *);
+      const char *local_abspath;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_cl__check_target_is_local_path(target));
+      SVN_ERR(svn_dirent_get_absolute(&local_abspath, target, iterpool));
+
+      SVN_ERR(bench_null_update(local_abspath,
+                                &(opt_state->start_revision),
+                                opt_state->depth, &stats, ctx, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  if (!opt_state->quiet)
+    SVN_ERR(svn_cl__print_editor_stats(&stats, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__null_checkout(apr_getopt_t *os,
+                      void *baton,
+                      apr_pool_t *pool)
+{
+  svn_cl__opt_state_t *opt_state = ((svn_cl__cmd_baton_t *) baton)->opt_state;
+  svn_client_ctx_t *ctx = ((svn_cl__cmd_baton_t *) baton)->ctx;
+  apr_array_header_t *targets;
+  const char *truefrom;
+  svn_opt_revision_t peg_revision;
+  svn_opt_revision_t *revision = &(opt_state->start_revision);
+  svn_cl__editor_stats_t stats = { 0 };
+  svn_error_t *err;
+
+  SVN_ERR(svn_cl__args_to_target_array_print_reserved(&targets, os,
+                                                      opt_state->targets,
+                                                      ctx, FALSE, pool));
+
+  /* We want exactly 1 target for this subcommand. */
+  if (targets->nelts < 1)
+    return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, 0, NULL);
+  if (targets->nelts > 1)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, 0, NULL);
+
+  SVN_ERR(svn_opt_parse_path(&peg_revision, &truefrom,
+                             APR_ARRAY_IDX(targets, 0, const char *), pool));
+  if (! svn_path_is_url(truefrom))
+    return svn_error_createf(SVN_ERR_BAD_URL, NULL,
+                             _("'%s' does not appear to be a URL"),
+                             truefrom);
+
+  if (peg_revision.kind == svn_opt_revision_unspecified)
+    peg_revision.kind = svn_opt_revision_head;
+  if (revision->kind == svn_opt_revision_unspecified)
+    revision = &peg_revision;
+
+  if (opt_state->depth == svn_depth_unknown)
+    opt_state->depth = svn_depth_infinity;
+
+  err = bench_null_checkout(truefrom, &peg_revision, revision,
+                            opt_state->depth, &stats, ctx, pool);
+
+  if (!opt_state->quiet)
+    SVN_ERR(svn_cl__print_editor_stats(&stats, pool));
+
+  return svn_error_trace(err);
+}
@@ -70,7 +70,11 @@ typedef enum svn_cl__longopt_t {
   opt_trust_server_cert,
   opt_trust_server_cert_failures,
   opt_changelist,
-  opt_search
+  opt_search,
+  opt_file_size,
+  opt_concurrency,
+  opt_duration,
+  opt_mix
 } svn_cl__longopt_t;
 
 
@@ -171,6 +175,14 @@ const apr_getopt_option_t svn_cl__options[] =
                        "history")},
   {"search", opt_search, 1,
                        N_("use ARG as search pattern (glob syntax)")},
+  {"file-size",     opt_file_size, 1,
+                    N_("size of each file in bytes")},
+  {"concurrency",   opt_concurrency, 1,
+                    N_("number of operations to run at the same time")},
+  {"duration",      opt_duration, 1,
+                    N_("number of seconds to run for")},
+  {"mix",           opt_mix, 1,
+                    N_("read the operations to run from file ARG")},
 
   /* Long-opt Aliases
    *
@@ -316,6 +328,86 @@ const svn_opt_subcommand_desc3_t svn_cl__cmd_table[] =
     {'r', 'R', opt_depth, opt_targets, opt_changelist}
   },
 
+  { "null-update", svn_cl__null_update, {0}, {N_(
+     "Fetch the changes that would update a working copy.\n"
+     "usage: null-update [PATH...]\n"
+     "\n"), N_(
+     "  Describes each PATH (default: '.') to the server like 'svn update'\n"
+     "  does and receives the changes to revision REV, or HEAD if no\n"
+     "  revision is given, without applying them.  The working copy is not\n"
+     "  modified.\n"
+    )},
+    {'r', 'q', opt_depth, opt_targets} },
+
+  { "null-checkout", svn_cl__null_checkout, {"null-co"}, {N_(
+     "Fetch a tree as for a checkout.\n"
+     "usage: null-checkout [-r REV] URL[@PEGREV]\n"
+     "\n"), N_(
+     "  Receives the directory tree at URL like 'svn checkout' does, at\n"
+     "  revision REV if it is given, otherwise at HEAD, without storing it.\n"
+     "\n"), N_(
+     "  If specified, PEGREV determines in which revision the target is first\n"
+     "  looked up.\n"
+    )},
+    {'r', 'q', opt_depth} },
+
+  { "null-diff", svn_cl__null_diff, {0}, {N_(
+     "Fetch the differences between two revisions of a tree.\n"
+     "usage: null-diff -r N[:M] URL[@PEGREV]\n"
+     "       null-diff -c M URL[@PEGREV]\n"
+     "\n"), N_(
+     "  Receives the changes between URL in revision N and in revision M\n"
+     "  (default: HEAD) like a repository to repository 'svn diff' does,\n"
+     "  without producing the diff.\n"
+     "\n"), N_(
+     "  If specified, PEGREV determines in which revision the target is first\n"
+     "  looked up.\n"
+    )},
+    {'r', 'c', 'q', opt_depth} },
+
+  { "null-merge", svn_cl__null_merge, {0}, {N_(
+     "Calculate a merge without changing the working copy.\n"
+     "usage: null-merge [-c M[,N...] | -r N:M ...] SOURCE[@REV] [PATH]\n"
+     "\n"), N_(
+     "  Runs the merge of SOURCE into the working copy PATH (default: '.')\n"
+     "  as a dry run and counts the changes it would make.  Without a\n"
+     "  revision range, all eligible revisions are merged, as for an\n"
+     "  automatic merge.\n"
+    )},
+    {'r', 'c', 'q', opt_depth} },
+
+  { "null-commit", svn_cl__null_commit, {0}, {N_(
+     "Commit a synthetic tree of files.\n"
+     "usage: null-commit [-l COUNT] [--file-size SIZE] URL\n"
+     "\n"), N_(
+     "  Adds COUNT (default: 100) files of SIZE (default: 1024) bytes in\n"
+     "  a new directory below the repository directory URL, in a single\n"
+     "  commit and without a working copy.\n"
+    )},
+    {'l', 'q', opt_file_size},
+    {{'l', N_("number of files to add")}} },
+
+  { "load", svn_cl__load, {0}, {N_(
+     "Run a weighted mix of benchmarks concurrently.\n"
+     "usage: load --mix FILE [--concurrency N] [--duration SECONDS]\n"
+     "\n"), N_(
+     "  Runs N (default: 1) workers for SECONDS (default: 60), each with\n"
+     "  its own sessions, that repeatedly pick an operation from FILE and\n"
+     "  run it.  Reports the throughput and the latency percentiles of\n"
+     "  each operation.\n"
+     "\n"), N_(
+     "  Each line of FILE holds a relative weight, a subcommand and its\n"
+     "  arguments, for instance:\n"
+     "\n"
+     "    # weight  subcommand  arguments\n"
+     "    10        null-list   -v http://svn.example.com/repos/trunk\n"
+     "    1         null-log    -l 100 http://svn.example.com/repos/trunk\n"
+     "\n"), N_(
+     "  Only the options -r, -l, -v and --depth can be given per line.\n"
+     "  Empty lines and lines starting with '#' are ignored.\n"
+    )},
+    {opt_mix, opt_concurrency, opt_duration} },
+
   { NULL, NULL, {0}, {NULL}, {0} }
 };
 
@@ -431,6 +523,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   opt_state.revision_ranges =
     apr_array_make(pool, 0, sizeof(svn_opt_revision_range_t *));
   opt_state.depth = svn_depth_unknown;
+  opt_state.file_size = -1;
 
   /* No args?  Show usage. */
   if (argc <= 1)
@@ -696,6 +789,41 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case 'g':
         opt_state.use_merge_history = TRUE;
         break;
+      case opt_file_size:
+        err = svn_cstring_atoi64(&opt_state.file_size, opt_arg);
+        if (err)
+          return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, err,
+                                  _("Non-numeric file size argument given"));
+        if (opt_state.file_size < 0)
+          return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
+                                  _("Argument to --file-size must not be "
+                                    "negative"));
+        break;
+      case opt_concurrency:
+        err = svn_cstring_atoi(&opt_state.concurrency, opt_arg);
+        if (err)
+          return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, err,
+                                  _("Non-numeric concurrency argument "
+                                    "given"));
+        if (opt_state.concurrency <= 0)
+          return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
+                                  _("Argument to --concurrency must be "
+                                    "positive"));
+        break;
+      case opt_duration:
+        err = svn_cstring_atoi(&opt_state.duration, opt_arg);
+        if (err)
+          return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, err,
+                                  _("Non-numeric duration argument given"));
+        if (opt_state.duration <= 0)
+          return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
+                                  _("Argument to --duration must be "
+                                    "positive"));
+        break;
+      case opt_mix:
+        SVN_ERR(svn_utf_cstring_to_utf8(&utf8_opt_arg, opt_arg, pool));
+        opt_state.mix_file = svn_dirent_internal_style(utf8_opt_arg, pool);
+        break;
       case opt_search:
         SVN_ERR(svn_utf_cstring_to_utf8(&utf8_opt_arg, opt_arg, pool));
         SVN_ERR(svn_utf__xfrm(&utf8_opt_arg, utf8_opt_arg,
@@ -814,7 +942,8 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     }
 
   /* Only merge and log support multiple revisions/revision ranges. */
-  if (subcommand->cmd_func != svn_cl__null_log)
+  if (subcommand->cmd_func != svn_cl__null_log
+      && subcommand->cmd_func != svn_cl__null_merge)
     {
       if (opt_state.revision_ranges->nelts > 1)
         {
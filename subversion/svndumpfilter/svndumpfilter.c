@@ -192,6 +192,9 @@ struct parse_baton_t
   svn_stream_t *in_stream;
   svn_stream_t *out_stream;
 
+  /* The buffered file behind OUT_STREAM. */
+  apr_file_t *out_file;
+
   /* State for the filtering process. */
   apr_int32_t rev_drop_count;
   apr_hash_t *dropped_nodes;
@@ -1030,6 +1033,65 @@ struct svndumpfilter_opt_state
 };
 
 
+/* Size of the I/O buffers for STDIN and STDOUT.  The parser reads and
+   writes in small chunks and dumps tend to be large. */
+#define STDIO_BUFFER_SIZE (1024 * 1024)
+
+/* Open one of the standard streams as a buffered APR file using the APR
+   function OPEN_FUNC with FLAGS and return it in *FILE, allocated in POOL.
+   NAME is the name of the stream used in error messages. */
+static svn_error_t *
+open_stdio_file(apr_file_t **file,
+                apr_status_t (*open_func)(apr_file_t **, apr_int32_t,
+                                          apr_pool_t *),
+                apr_int32_t flags,
+                const char *name,
+                apr_pool_t *pool)
+{
+  apr_status_t apr_err;
+
+  apr_err = open_func(file, flags | APR_BUFFERED, pool);
+  if (apr_err)
+    return svn_error_wrap_apr(apr_err, _("Can't open %s"), name);
+
+  apr_err = apr_file_buffer_set(*file, apr_palloc(pool, STDIO_BUFFER_SIZE),
+                                STDIO_BUFFER_SIZE);
+  if (apr_err)
+    return svn_error_wrap_apr(apr_err, _("Can't set buffer of %s"), name);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set up the input and output streams of BATON, using large buffers.
+   If the input is a regular file, the parser will seek over the contents
+   of nodes we drop instead of reading them. */
+static svn_error_t *
+open_stdio_streams(struct parse_baton_t *baton,
+                   apr_pool_t *pool)
+{
+  apr_file_t *in_file;
+  apr_finfo_t finfo;
+
+  SVN_ERR(open_stdio_file(&in_file, apr_file_open_flags_stdin, APR_READ,
+                          "stdin", pool));
+  SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_TYPE, in_file, pool));
+
+  /* Pipes and the like don't support positioning requests, so use the
+     standard stream for them. */
+  if (finfo.filetype == APR_REG)
+    baton->in_stream = svn_stream_from_aprfile2(in_file, TRUE, pool);
+  else
+    SVN_ERR(svn_stream_for_stdin2(&baton->in_stream, TRUE, pool));
+
+  /* The parser closes the output stream after each text, so disown the
+     file and flush it explicitly when done. */
+  SVN_ERR(open_stdio_file(&baton->out_file, apr_file_open_flags_stdout,
+                          APR_WRITE, "stdout", pool));
+  baton->out_stream = svn_stream_from_aprfile2(baton->out_file, TRUE, pool);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 parse_baton_initialize(struct parse_baton_t **pb,
                        struct svndumpfilter_opt_state *opt_state,
@@ -1038,11 +1100,9 @@ parse_baton_initialize(struct parse_baton_t **pb,
 {
   struct parse_baton_t *baton = apr_palloc(pool, sizeof(*baton));
 
-  /* Read the stream from STDIN.  Users can redirect a file. */
-  SVN_ERR(svn_stream_for_stdin2(&baton->in_stream, TRUE, pool));
-
-  /* Have the parser dump results to STDOUT. Users can redirect a file. */
-  SVN_ERR(svn_stream_for_stdout(&baton->out_stream, pool));
+  /* Read the stream from STDIN and have the parser dump results to STDOUT.
+     Users can redirect files. */
+  SVN_ERR(open_stdio_streams(baton, pool));
 
   baton->do_exclude = do_exclude;
 
@@ -1124,6 +1184,7 @@ do_filter(apr_getopt_t *os,
   apr_hash_index_t *hi;
   apr_array_header_t *keys;
   int i, num_keys;
+  svn_error_t *err;
 
   if (! opt_state->quiet)
     {
@@ -1173,8 +1234,10 @@ do_filter(apr_getopt_t *os,
     }
 
   SVN_ERR(parse_baton_initialize(&pb, opt_state, do_exclude, pool));
-  SVN_ERR(svn_repos_parse_dumpstream3(pb->in_stream, &filtering_vtable, pb,
-                                      TRUE, NULL, NULL, pool));
+  err = svn_repos_parse_dumpstream3(pb->in_stream, &filtering_vtable, pb,
+                                    TRUE, NULL, NULL, pool);
+  SVN_ERR(svn_error_compose_create(err, svn_io_file_flush(pb->out_file,
+                                                          pool)));
 
   /* The rest of this is just reporting.  If we aren't reporting, get
      outta here. */
@@ -25,6 +25,7 @@
 #include "svn_dirent_uri.h"
 #include "svn_pools.h"
 #include "private/svn_fs_fs_private.h"
+#include "private/svn_fs_x_private.h"
 
 #include "svnfsfs.h"
 
@@ -69,6 +70,42 @@ dump_index_entry(const svn_fs_fs__p2l_entry_t *entry,
   return SVN_NO_ERROR;
 }
 
+/* Map svn_fs_x__index_entry_t.type to C string. */
+static const char *fsx_item_type_str[]
+  = {"none ", "frep ", "drep ", "fprop", "dprop", "node ", "chgs ", "rep  ",
+     "chgc ", "nodc ", "repc "};
+
+/* Implements svn_fs_x__dump_index_func_t as printing one table row
+ * containing the fields of ENTRY to the console.
+ */
+static svn_error_t *
+dump_fsx_index_entry(const svn_fs_x__index_entry_t *entry,
+                     void *baton,
+                     apr_pool_t *scratch_pool)
+{
+  const char *type_str
+    = entry->type < (sizeof(fsx_item_type_str) / sizeof(fsx_item_type_str[0]))
+    ? fsx_item_type_str[entry->type]
+    : "???";
+  svn_revnum_t revision = entry->item_count
+                        ? entry->items[0].revision
+                        : SVN_INVALID_REVNUM;
+  apr_uint64_t number = entry->item_count ? entry->items[0].number : 0;
+
+  printf("%12" APR_UINT64_T_HEX_FMT " %12" APR_UINT64_T_HEX_FMT
+         " %s %9ld %8" APR_UINT64_T_FMT " %s",
+         (apr_uint64_t)entry->offset, (apr_uint64_t)entry->size,
+         type_str, revision, number,
+         fnv1_to_string(entry->fnv1_checksum, scratch_pool));
+
+  if (entry->item_count > 1)
+    printf(" (%u)", (unsigned)entry->item_count);
+
+  printf("\n");
+
+  return SVN_NO_ERROR;
+}
+
 /* Read the repository at PATH beginning with revision START_REVISION and
  * return the result in *FS.  Allocate caches with MEMSIZE bytes total
  * capacity.  Use POOL for non-cache allocations.
@@ -79,15 +116,27 @@ dump_index(const char *path,
            apr_pool_t *pool)
 {
   svn_fs_t *fs;
+  svn_boolean_t is_fsx;
   svn_fs_fs__ioctl_dump_index_input_t input = {0};
 
   /* Check repository type and open it. */
-  SVN_ERR(open_fs(&fs, path, pool));
+  SVN_ERR(open_fs(&fs, &is_fsx, path, pool));
 
   /* Write header line. */
   printf("       Start       Length Type   Revision     Item Checksum\n");
 
   /* Dump the whole index contents */
+  if (is_fsx)
+    {
+      svn_fs_x__ioctl_dump_index_input_t fsx_input = {0};
+
+      fsx_input.revision = revision;
+      fsx_input.callback_func = dump_fsx_index_entry;
+      return svn_error_trace(svn_fs_ioctl(fs, SVN_FS_X__IOCTL_DUMP_INDEX,
+                                          &fsx_input, NULL, check_cancel,
+                                          NULL, pool, pool));
+    }
+
   input.revision = revision;
   input.callback_func = dump_index_entry;
   SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_DUMP_INDEX, &input, NULL,
@@ -138,7 +138,7 @@ load_index(const char *path,
   svn_fs_fs__ioctl_load_index_input_t ioctl_input = {0};
 
   /* Check repository type and open it. */
-  SVN_ERR(open_fs(&fs, path, pool));
+  SVN_ERR(open_fs(&fs, NULL, path, pool));
 
   while (TRUE)
     {
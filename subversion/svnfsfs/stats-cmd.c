@@ -29,6 +29,7 @@
 #include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_fs_fs_private.h"
+#include "private/svn_fs_x_private.h"
 
 #include "svn_private_config.h"
 #include "svnfsfs.h"
@@ -129,6 +130,32 @@ print_histogram(svn_fs_fs__histogram_t *histogram,
            (int)(histogram->lines[i].count * 100 / histogram->total.count));
 }
 
+/* Print the non-zero section of the delta chain length HISTOGRAM to
+ * console.  Use POOL for allocations.
+ */
+static void
+print_chain_length_histogram(svn_fs_fs__histogram_t *histogram,
+                             apr_pool_t *pool)
+{
+  int first = 0;
+  int last = 63;
+  int i;
+
+  /* identify non-zero range */
+  while (last > 0 && histogram->lines[last].count == 0)
+    --last;
+
+  while (first <= last && histogram->lines[first].count == 0)
+    ++first;
+
+  /* display histogram lines */
+  for (i = last; i >= first; --i)
+    printf(_("  %4s .. < %-4s %12s (%2d%%) representations\n"),
+           print_two_power(i-1, pool), print_two_power(i, pool),
+           svn__ui64toa_sep(histogram->lines[i].count, ',', pool),
+           (int)(histogram->lines[i].count * 100 / histogram->total.count));
+}
+
 /* COMPARISON_FUNC for svn_sort__hash.
  * Sort extension_info_t values by total count in descending order.
  */
@@ -479,10 +506,340 @@ print_stats(svn_fs_fs__stats_t *stats,
   print_histogram(&stats->dir_prop_histogram, pool);
   printf("\nHistogram of directory property representation sizes:\n");
   print_histogram(&stats->dir_prop_rep_histogram, pool);
+  printf("\nHistogram of delta chain lengths:\n");
+  print_chain_length_histogram(&stats->chain_length_histogram, pool);
 
   print_histograms_by_extension(stats, pool);
 }
 
+/* Print STR as a JSON string literal to the console.
+ */
+static void
+print_json_string(const char *str)
+{
+  putchar('"');
+  for (; *str; ++str)
+    {
+      unsigned char c = (unsigned char)*str;
+      if (c == '"' || c == '\\')
+        printf("\\%c", c);
+      else if (c < 0x20)
+        printf("\\u%04x", c);
+      else
+        putchar(c);
+    }
+  putchar('"');
+}
+
+/* Print the non-zero lines of HISTOGRAM to the console as a JSON array.
+ * Each line covers the values from "min" up to but not including "max".
+ */
+static void
+print_json_histogram(const svn_fs_fs__histogram_t *histogram)
+{
+  const char *separator = "";
+  int i;
+
+  printf("[");
+  for (i = 0; i < 64; ++i)
+    if (histogram->lines[i].count)
+      {
+        printf("%s{\"min\": %" APR_UINT64_T_FMT
+               ", \"max\": %" APR_UINT64_T_FMT
+               ", \"count\": %" APR_UINT64_T_FMT
+               ", \"sum\": %" APR_UINT64_T_FMT "}",
+               separator,
+               i ? (apr_uint64_t)1 << (i - 1) : 0,
+               (apr_uint64_t)1 << i,
+               histogram->lines[i].count,
+               histogram->lines[i].sum);
+        separator = ", ";
+      }
+  printf("]");
+}
+
+/* Print the compression statistics STATS to the console as a JSON object.
+ */
+static void
+print_json_rep_pack_stats(const svn_fs_fs__rep_pack_stats_t *stats)
+{
+  printf("{\"count\": %" APR_UINT64_T_FMT
+         ", \"packed_size\": %" APR_UINT64_T_FMT
+         ", \"expanded_size\": %" APR_UINT64_T_FMT
+         ", \"overhead_size\": %" APR_UINT64_T_FMT "}",
+         stats->count, stats->packed_size, stats->expanded_size,
+         stats->overhead_size);
+}
+
+/* Print the representation statistics STATS as member NAME of a JSON
+ * object to the console.  Terminate it with SEPARATOR.
+ */
+static void
+print_json_rep_stats(const char *name,
+                     const svn_fs_fs__representation_stats_t *stats,
+                     const char *separator)
+{
+  printf("    \"%s\": {\n      \"total\": ", name);
+  print_json_rep_pack_stats(&stats->total);
+  printf(",\n      \"uniques\": ");
+  print_json_rep_pack_stats(&stats->uniques);
+  printf(",\n      \"shared\": ");
+  print_json_rep_pack_stats(&stats->shared);
+  printf(",\n      \"references\": %" APR_UINT64_T_FMT
+         ",\n      \"expanded_size\": %" APR_UINT64_T_FMT
+         ",\n      \"chain_len\": %" APR_UINT64_T_FMT "\n    }%s\n",
+         stats->references, stats->expanded_size, stats->chain_len,
+         separator);
+}
+
+/* Print the noderev statistics STATS as member NAME of a JSON object to
+ * the console.  Terminate it with SEPARATOR.
+ */
+static void
+print_json_node_stats(const char *name,
+                      const svn_fs_fs__node_stats_t *stats,
+                      const char *separator)
+{
+  printf("    \"%s\": {\"count\": %" APR_UINT64_T_FMT
+         ", \"size\": %" APR_UINT64_T_FMT "}%s\n",
+         name, stats->count, stats->size, separator);
+}
+
+/* Print HISTOGRAM as member NAME of a JSON object to the console.
+ * Terminate it with SEPARATOR.
+ */
+static void
+print_json_named_histogram(const char *name,
+                           const svn_fs_fs__histogram_t *histogram,
+                           const char *separator)
+{
+  printf("    \"%s\": ", name);
+  print_json_histogram(histogram);
+  printf("%s\n", separator);
+}
+
+/* Print the contents of STATS to the console as a single JSON object.
+ * Use POOL for allocations.
+ */
+static void
+print_stats_json(svn_fs_fs__stats_t *stats,
+                 apr_pool_t *pool)
+{
+  apr_array_header_t *extensions;
+  const char *separator;
+  apr_size_t k;
+  int i;
+
+  printf("{\n"
+         "  \"revision_count\": %" APR_UINT64_T_FMT ",\n"
+         "  \"total_size\": %" APR_UINT64_T_FMT ",\n"
+         "  \"change_count\": %" APR_UINT64_T_FMT ",\n"
+         "  \"change_len\": %" APR_UINT64_T_FMT ",\n",
+         stats->revision_count, stats->total_size,
+         stats->change_count, stats->change_len);
+
+  printf("  \"nodes\": {\n");
+  print_json_node_stats("total", &stats->total_node_stats, ",");
+  print_json_node_stats("dir", &stats->dir_node_stats, ",");
+  print_json_node_stats("file", &stats->file_node_stats, "");
+  printf("  },\n");
+
+  printf("  \"representations\": {\n");
+  print_json_rep_stats("total", &stats->total_rep_stats, ",");
+  print_json_rep_stats("dir", &stats->dir_rep_stats, ",");
+  print_json_rep_stats("file", &stats->file_rep_stats, ",");
+  print_json_rep_stats("dir_prop", &stats->dir_prop_rep_stats, ",");
+  print_json_rep_stats("file_prop", &stats->file_prop_rep_stats, "");
+  printf("  },\n");
+
+  printf("  \"histograms\": {\n");
+  print_json_named_histogram("node_size", &stats->node_size_histogram, ",");
+  print_json_named_histogram("rep_size", &stats->rep_size_histogram, ",");
+  print_json_named_histogram("added_node_size",
+                             &stats->added_node_size_histogram, ",");
+  print_json_named_histogram("added_rep_size",
+                             &stats->added_rep_size_histogram, ",");
+  print_json_named_histogram("unused_rep", &stats->unused_rep_histogram, ",");
+  print_json_named_histogram("file", &stats->file_histogram, ",");
+  print_json_named_histogram("file_rep", &stats->file_rep_histogram, ",");
+  print_json_named_histogram("file_prop", &stats->file_prop_histogram, ",");
+  print_json_named_histogram("file_prop_rep",
+                             &stats->file_prop_rep_histogram, ",");
+  print_json_named_histogram("dir", &stats->dir_histogram, ",");
+  print_json_named_histogram("dir_rep", &stats->dir_rep_histogram, ",");
+  print_json_named_histogram("dir_prop", &stats->dir_prop_histogram, ",");
+  print_json_named_histogram("dir_prop_rep",
+                             &stats->dir_prop_rep_histogram, ",");
+  print_json_named_histogram("chain_length",
+                             &stats->chain_length_histogram, "");
+  printf("  },\n");
+
+  printf("  \"shards\": [");
+  separator = "\n";
+  for (i = 0; i < stats->shards->nelts; ++i)
+    {
+      const svn_fs_fs__shard_stats_t *shard
+        = APR_ARRAY_IDX(stats->shards, i, const svn_fs_fs__shard_stats_t *);
+
+      printf("%s    {\"first_revision\": %ld"
+             ", \"revision_count\": %" APR_UINT64_T_FMT
+             ", \"total_size\": %" APR_UINT64_T_FMT
+             ", \"change_count\": %" APR_UINT64_T_FMT
+             ", \"noderev_count\": %" APR_UINT64_T_FMT
+             ", \"rep_count\": %" APR_UINT64_T_FMT
+             ", \"rep_size\": %" APR_UINT64_T_FMT "}",
+             separator, shard->first_revision, shard->revision_count,
+             shard->total_size, shard->change_count, shard->noderev_count,
+             shard->rep_count, shard->rep_size);
+      separator = ",\n";
+    }
+  printf("\n  ],\n");
+
+  printf("  \"largest_changes\": [");
+  separator = "\n";
+  for (k = 0; k < stats->largest_changes->count; ++k)
+    {
+      const svn_fs_fs__large_change_info_t *change
+        = stats->largest_changes->changes[k];
+      if (!change->size)
+        break;
+
+      printf("%s    {\"size\": %" APR_UINT64_T_FMT ", \"revision\": %ld"
+             ", \"path\": ",
+             separator, change->size, change->revision);
+      print_json_string(change->path->data);
+      printf("}");
+      separator = ",\n";
+    }
+  printf("\n  ],\n");
+
+  printf("  \"extensions\": [");
+  separator = "\n";
+  extensions = svn_sort__hash(stats->by_extension, compare_count, pool);
+  for (i = 0; i < extensions->nelts; ++i)
+    {
+      const svn_fs_fs__extension_info_t *info
+        = APR_ARRAY_IDX(extensions, i, svn_sort__item_t).value;
+
+      printf("%s    {\"extension\": ", separator);
+      print_json_string(info->extension);
+      printf(",\n     \"node_histogram\": ");
+      print_json_histogram(&info->node_histogram);
+      printf(",\n     \"rep_histogram\": ");
+      print_json_histogram(&info->rep_histogram);
+      printf("}");
+      separator = ",\n";
+    }
+  printf("\n  ]\n}\n");
+}
+
+/* Print the per item type summaries of the FSX statistics STATS to the
+ * console.  Use POOL for allocations.
+ */
+static void
+print_fsx_item_types(const svn_fs_x__stats_t *stats,
+                     apr_pool_t *pool)
+{
+  static const char *item_type_names[SVN_FS_X__STATS_ITEM_TYPE_COUNT]
+    = { "unused", "file reps", "dir reps", "file props", "dir props",
+        "noderevs", "changes", "other reps", "changes containers",
+        "noderevs containers", "reps containers" };
+  int i;
+
+  for (i = 0; i < SVN_FS_X__STATS_ITEM_TYPE_COUNT; ++i)
+    {
+      const svn_fs_x__item_type_stats_t *type_stats = &stats->item_types[i];
+      if (type_stats->count == 0)
+        continue;
+
+      printf(_("%20s bytes in %12s %s\n"),
+             svn__ui64toa_sep(type_stats->size, ',', pool),
+             svn__ui64toa_sep(type_stats->count, ',', pool),
+             item_type_names[i]);
+
+      /* Types 8 and above are containers holding multiple items. */
+      if (i >= 8)
+        printf(_("%20.3f items per container on average, %s max\n"
+                 "%20s containers too large for the cache\n"),
+               type_stats->sub_items / MAX(1.0, (double)type_stats->count),
+               svn__ui64toa_sep(type_stats->max_sub_items, ',', pool),
+               svn__ui64toa_sep(type_stats->uncachable, ',', pool));
+    }
+}
+
+/* Print the string table statistics STATS, labeled with NAME, to the
+ * console.  Use POOL for allocations.
+ */
+static void
+print_fsx_string_tables(const char *name,
+                        const svn_fs_x__string_table_stats_t *stats,
+                        apr_pool_t *pool)
+{
+  printf(_("\n%s:\n"), name);
+  printf(_("%20s strings in %12s tables\n"
+           "%20s bytes expanded size\n"
+           "%20s bytes stored size\n"
+           "%20.3f compression ratio\n"),
+         svn__ui64toa_sep(stats->strings, ',', pool),
+         svn__ui64toa_sep(stats->tables, ',', pool),
+         svn__ui64toa_sep(stats->expanded_size, ',', pool),
+         svn__ui64toa_sep(stats->stored_size, ',', pool),
+         stats->expanded_size / MAX(1.0, (double)stats->stored_size));
+}
+
+/* Print the FSX statistics STATS to the console.  Use POOL for allocations.
+ */
+static void
+print_fsx_stats(const svn_fs_x__stats_t *stats,
+                apr_pool_t *pool)
+{
+  int i;
+
+  printf(_("\nGlobal statistics:\n"));
+  printf(_("%20s revisions, %s per shard, %s packed\n"
+           "%20s bytes in rev and pack files\n"),
+         svn__ui64toa_sep(stats->revision_count, ',', pool),
+         svn__i64toa_sep(stats->shard_size, ',', pool),
+         svn__ui64toa_sep(stats->min_unpacked_rev, ',', pool),
+         svn__ui64toa_sep(stats->total_size, ',', pool));
+
+  printf(_("\nItems and containers:\n"));
+  print_fsx_item_types(stats, pool);
+
+  print_fsx_string_tables(_("Changed paths string tables"),
+                          &stats->changes_paths, pool);
+  print_fsx_string_tables(_("Node revision string tables"),
+                          &stats->noderevs_paths, pool);
+
+  printf(_("\nDelta chains:\n"));
+  printf(_("%20s representations\n"
+           "%20.3f average delta chain length, %s max\n"
+           "%20.3f average shards per chain\n"),
+         svn__ui64toa_sep(stats->chain_count, ',', pool),
+         stats->chain_length_sum / MAX(1.0, (double)stats->chain_count),
+         svn__ui64toa_sep(stats->chain_length_max, ',', pool),
+         stats->chain_shard_sum / MAX(1.0, (double)stats->chain_count));
+
+  printf(_("\nDelta chain length histogram:\n"));
+  for (i = 0; i < SVN_FS_X__STATS_CHAIN_BUCKETS; ++i)
+    if (stats->chain_histogram[i])
+      printf(_("  [%s, %s)\t%12s chains (%5.1f%%)\n"),
+             print_two_power(i, pool),
+             i + 1 < SVN_FS_X__STATS_CHAIN_BUCKETS
+               ? print_two_power(i + 1, pool)
+               : "...",
+             svn__ui64toa_sep(stats->chain_histogram[i], ',', pool),
+             stats->chain_histogram[i] * 100.0
+               / MAX(1.0, (double)stats->chain_count));
+
+  printf(_("\nCache footprint after full scan:\n"));
+  printf(_("%20s bytes cache capacity\n"
+           "%20s bytes used by %s entries\n"),
+         svn__ui64toa_sep(stats->cache_total_size, ',', pool),
+         svn__ui64toa_sep(stats->cache_used_size, ',', pool),
+         svn__ui64toa_sep(stats->cache_used_entries, ',', pool));
+}
+
 /* Our progress function simply prints the REVISION number and makes it
  * appear immediately.
  */
@@ -501,16 +858,44 @@ subcommand__stats(apr_getopt_t *os, void *baton, apr_pool_t *pool)
 {
   svnfsfs__opt_state *opt_state = baton;
   svn_fs_t *fs;
+  svn_boolean_t is_fsx;
   svn_fs_fs__ioctl_get_stats_input_t input = {0};
   svn_fs_fs__ioctl_get_stats_output_t *output;
 
-  printf("Reading revisions\n");
-  SVN_ERR(open_fs(&fs, opt_state->repository_path, pool));
+  /* Progress output would render the JSON output unparsable. */
+  if (!opt_state->json)
+    printf("Reading revisions\n");
+  SVN_ERR(open_fs(&fs, &is_fsx, opt_state->repository_path, pool));
+
+  if (is_fsx)
+    {
+      svn_fs_x__ioctl_get_stats_input_t fsx_input = {0};
+      svn_fs_x__ioctl_get_stats_output_t *fsx_output;
+
+      if (opt_state->json)
+        return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                                _("JSON output is not supported for FSX "
+                                  "repositories"));
+
+      fsx_input.progress_func = print_progress;
+      SVN_ERR(svn_fs_ioctl(fs, SVN_FS_X__IOCTL_GET_STATS, &fsx_input,
+                           (void **)&fsx_output, check_cancel, NULL,
+                           pool, pool));
+      print_fsx_stats(fsx_output->stats, pool);
 
-  input.progress_func = print_progress;
+      return SVN_NO_ERROR;
+    }
+
+  if (!opt_state->json)
+    input.progress_func = print_progress;
+  input.jobs = opt_state->jobs;
   SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_GET_STATS, &input, (void **)&output,
                        check_cancel, NULL, pool, pool));
-  print_stats(output->stats, pool);
+
+  if (opt_state->json)
+    print_stats_json(output->stats, pool);
+  else
+    print_stats(output->stats, pool);
 
   return SVN_NO_ERROR;
 }
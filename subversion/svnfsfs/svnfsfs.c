@@ -76,7 +76,9 @@ check_lib_versions(void)
 
 enum svnfsfs__cmdline_options_t
   {
-    svnfsfs__version = SVN_OPT_FIRST_LONGOPT_ID
+    svnfsfs__version = SVN_OPT_FIRST_LONGOPT_ID,
+    svnfsfs__jobs,
+    svnfsfs__json
   };
 
 /* Option codes and descriptions.
@@ -104,6 +106,13 @@ static const apr_getopt_option_t options_table[] =
      N_("size of the extra in-memory cache in MB used to\n"
         "                             minimize redundant operations. Default: 16.")},
 
+    {"jobs",          svnfsfs__jobs, 1,
+     N_("scan the repository using up to ARG concurrent\n"
+        "                             threads.  Default: 1.")},
+
+    {"json",          svnfsfs__json, 0,
+     N_("write machine-readable output in JSON format")},
+
     {NULL}
   };
 
@@ -124,7 +133,8 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "usage: svnfsfs dump-index REPOS_PATH -r REV\n"
     "\n"), N_(
     "Dump the index contents for the revision / pack file containing revision REV\n"
-    "to console.  This is only available for FSFS format 7 (SVN 1.9+) repositories.\n"
+    "to console.  This is only available for FSFS format 7 (SVN 1.9+) and FSX\n"
+    "repositories.\n"
     "The table produced contains a header in the first line followed by one line\n"
     "per index entry, ordered by location in the revision / pack file.  Columns:\n"
     "\n"), N_(
@@ -140,6 +150,9 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "        node ... Node revision.\n"
     "        chgs ... Changed paths list.\n"
     "        rep .... Representation of unknown type.  Should not be used.\n"
+    "        chgc ... Changed paths lists container (FSX only).\n"
+    "        nodc ... Node revisions container (FSX only).\n"
+    "        repc ... Representations container (FSX only).\n"
     "        ??? .... Invalid.  Index data is corrupt.\n"
     "\n"), N_(
     "        The distinction between frep, drep, fprop and dprop is a mere internal\n"
@@ -149,6 +162,9 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "   * Revision that the item belongs to (decimal)\n"
     "   * Item number (decimal) within that revision\n"
     "   * Modified FNV1a checksum (8 hex digits)\n"
+    "\n"), N_(
+    "For FSX containers, revision and item number refer to the first item in\n"
+    "the container and the number of items follows in parentheses.\n"
    )},
    {'r', 'M'} },
 
@@ -159,6 +175,7 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "dump-index command, except that checksum as well as header are optional and will\n"
     "be ignored.  The data must cover the full revision / pack file;  the revision\n"
     "number is automatically extracted from input stream.  No ordering is required.\n"
+    "This is only available for FSFS repositories.\n"
    )},
    {'M'} },
 
@@ -166,8 +183,17 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "usage: svnfsfs stats REPOS_PATH\n"
     "\n"), N_(
     "Write object size statistics to console.\n"
+    "\n"
+    "If --jobs is given, revision and pack files of format 7+ repositories\n"
+    "will be scanned concurrently.  With --json, the statistics including\n"
+    "per-shard summaries and all histograms are written as a JSON object\n"
+    "and no progress information is shown.\n"
+    "\n"
+    "For FSX repositories, the report lists container fill ratios, string\n"
+    "table compression, delta chain lengths and the cache footprint.  --json\n"
+    "is not supported for those and --jobs is ignored.\n"
    )},
-   {'M'} },
+   {'M', svnfsfs__jobs, svnfsfs__json} },
 
   { NULL, NULL, {0}, {NULL}, {0} }
 };
@@ -175,6 +201,7 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
 
 svn_error_t *
 open_fs(svn_fs_t **fs,
+        svn_boolean_t *is_fsx,
         const char *path,
         apr_pool_t *pool)
 {
@@ -183,7 +210,10 @@ open_fs(svn_fs_t **fs,
   /* Verify that we can handle the repository type. */
   path = svn_dirent_join(path, "db", pool);
   SVN_ERR(svn_fs_type(&fs_type, path, pool));
-  if (strcmp(fs_type, SVN_FS_TYPE_FSFS))
+  if (is_fsx)
+    *is_fsx = strcmp(fs_type, SVN_FS_TYPE_FSX) == 0;
+
+  if (strcmp(fs_type, SVN_FS_TYPE_FSFS) && !(is_fsx && *is_fsx))
     return svn_error_createf(SVN_ERR_FS_UNSUPPORTED_TYPE, NULL,
                              _("%s repositories are not supported"),
                              fs_type);
@@ -259,6 +289,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   opt_state.start_revision.kind = svn_opt_revision_unspecified;
   opt_state.end_revision.kind = svn_opt_revision_unspecified;
   opt_state.memory_cache_size = svn_cache_config_get()->cache_size;
+  opt_state.jobs = 1;
 
   /* Parse options. */
   SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
@@ -320,6 +351,16 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           opt_state.memory_cache_size = 0x100000 * sz_val;
         }
         break;
+      case svnfsfs__jobs:
+        SVN_ERR(svn_cstring_atoi(&opt_state.jobs, opt_arg));
+        if (opt_state.jobs < 1)
+          return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                   _("Invalid number of jobs '%s'"),
+                                   opt_arg);
+        break;
+      case svnfsfs__json:
+        opt_state.json = TRUE;
+        break;
       case svnfsfs__version:
         opt_state.version = TRUE;
         break;
@@ -450,6 +491,11 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
 
     settings.cache_size = opt_state.memory_cache_size;
     settings.single_threaded = TRUE;
+#if APR_HAS_THREADS
+    /* Worker threads will access the caches concurrently. */
+    if (opt_state.jobs > 1)
+      settings.single_threaded = FALSE;
+#endif
 
     svn_cache_config_set(&settings);
   }
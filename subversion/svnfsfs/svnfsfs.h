@@ -45,6 +45,8 @@ typedef struct svnfsfs__opt_state
   svn_boolean_t version;                            /* --version */
   svn_boolean_t quiet;                              /* --quiet */
   apr_uint64_t memory_cache_size;                   /* --memory-cache-size M */
+  int jobs;                                         /* --jobs */
+  svn_boolean_t json;                               /* --json */
 } svnfsfs__opt_state;
 
 /* Declare all the command procedures */
@@ -56,9 +58,12 @@ svn_opt_subcommand_t
 
 
 /* Check that the filesystem at PATH is an FSFS repository and then open it.
- * Return the filesystem in *FS, allocated in POOL. */
+ * Return the filesystem in *FS, allocated in POOL.  If IS_FSX is not NULL,
+ * FSX repositories will be accepted as well and *IS_FSX will be set to
+ * TRUE for those and to FALSE for FSFS repositories. */
 svn_error_t *
 open_fs(svn_fs_t **fs,
+        svn_boolean_t *is_fsx,
         const char *path,
         apr_pool_t *pool);
 
@@ -103,7 +103,8 @@ enum
     svnlook__properties_only,
     svnlook__diff_cmd,
     svnlook__show_inherited_props,
-    svnlook__no_newline
+    svnlook__no_newline,
+    svnlook__max_size
   };
 
 /*
@@ -144,6 +145,9 @@ static const apr_getopt_option_t options_table[] =
   {"properties-only",   svnlook__properties_only, 0,
    N_("show only properties during the operation")},
 
+  {"max-size",          svnlook__max_size, 1,
+   N_("compare at most the first ARG bytes of each file")},
+
   {"memory-cache-size", 'M', 1,
    N_("size of the extra in-memory cache in MB used to\n"
       "                             "
@@ -249,7 +253,8 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
    )},
    {'r', 't', svnlook__no_diff_deleted, svnlook__no_diff_added,
     svnlook__diff_copy_from, svnlook__diff_cmd, 'x',
-    svnlook__ignore_properties, svnlook__properties_only} },
+    svnlook__ignore_properties, svnlook__properties_only,
+    svnlook__max_size} },
 
   {"dirs-changed", subcommand_dirschanged, {0}, {N_(
       "usage: svnlook dirs-changed REPOS_PATH\n"
@@ -382,6 +387,7 @@ struct svnlook_opt_state
   svn_boolean_t show_inherited_props; /*  --show-inherited-props */
   svn_boolean_t no_newline;       /* --no-newline */
   apr_uint64_t memory_cache_size; /* --memory-cache-size */
+  svn_filesize_t max_size;        /* --max-size */
 };
 
 
@@ -404,6 +410,7 @@ typedef struct svnlook_ctxt_t
   svn_boolean_t ignore_properties;
   svn_boolean_t properties_only;
   const char *diff_cmd;
+  svn_filesize_t max_size;
 
 } svnlook_ctxt_t;
 
@@ -505,8 +512,9 @@ generate_delta_tree(svn_repos_node_t **tree,
   SVN_ERR(svn_repos_node_editor(&editor, &edit_baton, repos,
                                 base_root, root, pool, edit_pool));
 
-  /* Drive our editor. */
-  SVN_ERR(svn_repos_replay2(root, "", SVN_INVALID_REVNUM, TRUE,
+  /* Drive our editor.  The node editor only notes that file contents
+     changed, so don't make the replay compute any deltas. */
+  SVN_ERR(svn_repos_replay2(root, "", SVN_INVALID_REVNUM, FALSE,
                             editor, edit_baton, NULL, NULL, edit_pool));
 
   /* Return the tree we just built. */
@@ -587,92 +595,132 @@ print_dirs_changed_tree(svn_repos_node_t *node,
 }
 
 
-/* Recursively print all nodes in the tree that have been modified
-   (do not include directories affected only by "bubble-up"). */
+/* Sort svn_fs_path_change3_t * by path such that every directory is
+   directly followed by the paths below it, just like in a delta tree. */
+static int
+compare_changes(const void *a,
+                const void *b)
+{
+  const svn_fs_path_change3_t *lhs = *(const svn_fs_path_change3_t *const *)a;
+  const svn_fs_path_change3_t *rhs = *(const svn_fs_path_change3_t *const *)b;
+
+  return svn_path_compare_paths(lhs->path.data, rhs->path.data);
+}
+
+/* Print STATUS, PATH (UTF-8!) and -- if COPY_INFO is set -- the copy
+   source COPYFROM_PATH@COPYFROM_REV of a changed node of KIND. */
 static svn_error_t *
-print_changed_tree(svn_repos_node_t *node,
-                   const char *path /* UTF-8! */,
+print_changed_path(const char *status,
+                   const char *path,
+                   svn_node_kind_t kind,
                    svn_boolean_t copy_info,
+                   const char *copyfrom_path,
+                   svn_revnum_t copyfrom_rev,
                    apr_pool_t *pool)
 {
-  const char *full_path;
-  char status[4] = "_  ";
-  svn_boolean_t print_me = TRUE;
-  apr_pool_t *iterpool;
+  SVN_ERR(svn_cmdline_printf(pool, "%s %s%s\n",
+                             status,
+                             path,
+                             kind == svn_node_dir ? "/" : ""));
+  if (copy_info && copyfrom_path)
+    /* Remove the leading slash from the copyfrom path for consistency
+       with the rest of the output. */
+    SVN_ERR(svn_cmdline_printf(pool, "    (from %s%s:r%ld)\n",
+                               (copyfrom_path[0] == '/'
+                                ? copyfrom_path + 1
+                                : copyfrom_path),
+                               (kind == svn_node_dir ? "/" : ""),
+                               copyfrom_rev));
 
-  SVN_ERR(check_cancel(NULL));
-
-  if (! node)
-    return SVN_NO_ERROR;
+  return SVN_NO_ERROR;
+}
 
-  /* Print the node. */
-  if (node->action == 'A')
+/* Print CHANGE between BASE_ROOT and ROOT in a format compatible with
+   `svn update'.  A replacement gets printed as a deletion followed by
+   an addition.  Modifications that neither touched the contents nor
+   the properties are skipped. */
+static svn_error_t *
+print_change(const svn_fs_path_change3_t *change,
+             svn_fs_root_t *root,
+             svn_fs_root_t *base_root,
+             svn_boolean_t copy_info,
+             apr_pool_t *pool)
+{
+  const char *fspath = change->path.data;
+  const char *path = fspath[0] == '/' ? fspath + 1 : fspath;
+  svn_node_kind_t kind = change->node_kind;
+  const char *copyfrom_path = change->copyfrom_path;
+  svn_revnum_t copyfrom_rev = change->copyfrom_rev;
+
+  if (kind == svn_node_unknown)
+    SVN_ERR(svn_fs_check_path(&kind,
+                              change->change_kind == svn_fs_path_change_delete
+                                ? base_root : root,
+                              fspath, pool));
+
+  if (! change->copyfrom_known
+      && change->change_kind != svn_fs_path_change_delete)
+    SVN_ERR(svn_fs_copied_from(&copyfrom_rev, &copyfrom_path, root, fspath,
+                               pool));
+
+  if (change->change_kind == svn_fs_path_change_delete)
     {
-      status[0] = 'A';
-      if (copy_info && node->copyfrom_path)
-        status[2] = '+';
+      SVN_ERR(print_changed_path("D  ", path, kind, FALSE, NULL,
+                                 SVN_INVALID_REVNUM, pool));
     }
-  else if (node->action == 'D')
-    status[0] = 'D';
-  else if (node->action == 'R')
+  else if (change->change_kind == svn_fs_path_change_add
+           || change->change_kind == svn_fs_path_change_replace)
     {
-      if ((! node->text_mod) && (! node->prop_mod))
-        print_me = FALSE;
-      if (node->text_mod)
-        status[0] = 'U';
-      if (node->prop_mod)
-        status[1] = 'U';
-    }
-  else
-    print_me = FALSE;
+      if (change->change_kind == svn_fs_path_change_replace)
+        {
+          svn_node_kind_t base_kind;
+
+          /* The replaced node may have been of a different kind.  If it
+             does not exist in BASE_ROOT, it came with a copied parent. */
+          SVN_ERR(svn_fs_check_path(&base_kind, base_root, fspath, pool));
+          SVN_ERR(print_changed_path("D  ", path,
+                                     base_kind == svn_node_none
+                                       ? kind : base_kind,
+                                     FALSE, NULL, SVN_INVALID_REVNUM, pool));
+        }
 
-  /* Print this node unless told to skip it. */
-  if (print_me)
-    {
-      SVN_ERR(svn_cmdline_printf(pool, "%s %s%s\n",
-                                 status,
-                                 path,
-                                 node->kind == svn_node_dir ? "/" : ""));
-      if (copy_info && node->copyfrom_path)
-        /* Remove the leading slash from the copyfrom path for consistency
-           with the rest of the output. */
-        SVN_ERR(svn_cmdline_printf(pool, "    (from %s%s:r%ld)\n",
-                                   (node->copyfrom_path[0] == '/'
-                                    ? node->copyfrom_path + 1
-                                    : node->copyfrom_path),
-                                   (node->kind == svn_node_dir ? "/" : ""),
-                                   node->copyfrom_rev));
+      SVN_ERR(print_changed_path((copy_info && copyfrom_path) ? "A +" : "A  ",
+                                 path, kind, copy_info, copyfrom_path,
+                                 copyfrom_rev, pool));
     }
+  else if (change->change_kind == svn_fs_path_change_modify)
+    {
+      char status[4] = "_  ";
+      svn_boolean_t text_mod = change->text_mod && kind == svn_node_file;
 
-  /* Return here if the node has no children. */
-  node = node->child;
-  if (! node)
-    return SVN_NO_ERROR;
+      if (! text_mod && ! change->prop_mod)
+        return SVN_NO_ERROR;
 
-  /* Recursively handle the node's children. */
-  iterpool = svn_pool_create(pool);
-  while (node)
-    {
-      svn_pool_clear(iterpool);
-      full_path = svn_dirent_join(path, node->name, iterpool);
-      SVN_ERR(print_changed_tree(node, full_path, copy_info, iterpool));
-      node = node->sibling;
+      if (text_mod)
+        status[0] = 'U';
+      if (change->prop_mod)
+        status[1] = 'U';
+
+      SVN_ERR(print_changed_path(status, path, kind, FALSE, NULL,
+                                 SVN_INVALID_REVNUM, pool));
     }
-  svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
 
 
+/* Copy the contents of PATH in ROOT to STREAM and close it.  If MAX_SIZE
+   is not 0, copy no more than the first MAX_SIZE bytes. */
 static svn_error_t *
 dump_contents(svn_stream_t *stream,
               svn_fs_root_t *root,
               const char *path /* UTF-8! */,
+              svn_filesize_t max_size,
               apr_pool_t *pool)
 {
   if (root == NULL)
     SVN_ERR(svn_stream_close(stream));  /* leave an empty file */
-  else
+  else if (max_size == 0)
     {
       svn_stream_t *contents;
 
@@ -680,6 +728,28 @@ dump_contents(svn_stream_t *stream,
       SVN_ERR(svn_fs_file_contents(&contents, root, path, pool));
       SVN_ERR(svn_stream_copy3(contents, stream, NULL, NULL, pool));
     }
+  else
+    {
+      svn_stream_t *contents;
+      char *buffer = apr_palloc(pool, SVN__STREAM_CHUNK_SIZE);
+
+      /* Only copy the leading part of the contents. */
+      SVN_ERR(svn_fs_file_contents(&contents, root, path, pool));
+      while (max_size > 0)
+        {
+          apr_size_t len = (apr_size_t)MIN(max_size, SVN__STREAM_CHUNK_SIZE);
+
+          SVN_ERR(svn_stream_read_full(contents, buffer, &len));
+          if (len == 0)
+            break;
+
+          SVN_ERR(svn_stream_write(stream, buffer, &len));
+          max_size -= len;
+        }
+
+      SVN_ERR(svn_stream_close(contents));
+      SVN_ERR(svn_stream_close(stream));
+    }
 
   return SVN_NO_ERROR;
 }
@@ -696,26 +766,34 @@ dump_contents(svn_stream_t *stream,
    non-textual data -- in this case, the *IS_BINARY flag is set and no
    temporary files are created.
 
+   If MAX_SIZE is not 0, the temporary files will only contain the first
+   MAX_SIZE bytes of each file.  *TRUNCATED will be set if that cut off
+   either of them.
+
    TMPFILE1 and TMPFILE2 will be removed when RESULT_POOL is destroyed.
  */
 static svn_error_t *
 prepare_tmpfiles(const char **tmpfile1,
                  const char **tmpfile2,
                  svn_boolean_t *is_binary,
+                 svn_boolean_t *truncated,
                  svn_fs_root_t *root1,
                  const char *path1,
                  svn_fs_root_t *root2,
                  const char *path2,
+                 svn_filesize_t max_size,
                  apr_pool_t *result_pool,
                  apr_pool_t *scratch_pool)
 {
   svn_string_t *mimetype;
   svn_stream_t *stream;
+  svn_filesize_t length;
 
   /* Init the return values. */
   *tmpfile1 = NULL;
   *tmpfile2 = NULL;
   *is_binary = FALSE;
+  *truncated = FALSE;
 
   assert(path1 && path2);
 
@@ -742,17 +820,28 @@ prepare_tmpfiles(const char **tmpfile1,
         }
     }
 
+  if (max_size && root1)
+    {
+      SVN_ERR(svn_fs_file_length(&length, root1, path1, scratch_pool));
+      *truncated |= length > max_size;
+    }
+  if (max_size && root2)
+    {
+      SVN_ERR(svn_fs_file_length(&length, root2, path2, scratch_pool));
+      *truncated |= length > max_size;
+    }
+
   /* Now, prepare the two temporary files, each of which will either
      be empty, or will have real contents.  */
   SVN_ERR(svn_stream_open_unique(&stream, tmpfile1, NULL,
                                  svn_io_file_del_on_pool_cleanup,
                                  result_pool, scratch_pool));
-  SVN_ERR(dump_contents(stream, root1, path1, scratch_pool));
+  SVN_ERR(dump_contents(stream, root1, path1, max_size, scratch_pool));
 
   SVN_ERR(svn_stream_open_unique(&stream, tmpfile2, NULL,
                                  svn_io_file_del_on_pool_cleanup,
                                  result_pool, scratch_pool));
-  SVN_ERR(dump_contents(stream, root2, path2, scratch_pool));
+  SVN_ERR(dump_contents(stream, root2, path2, max_size, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -859,6 +948,7 @@ print_diff_tree(svn_stream_t *out_stream,
   svn_boolean_t orig_empty = FALSE;
   svn_boolean_t is_copy = FALSE;
   svn_boolean_t binary = FALSE;
+  svn_boolean_t truncated = FALSE;
   svn_boolean_t diff_header_printed = FALSE;
   apr_pool_t *iterpool;
   svn_stringbuf_t *header;
@@ -920,8 +1010,8 @@ print_diff_tree(svn_stream_t *out_stream,
         {
           do_diff = TRUE;
           SVN_ERR(prepare_tmpfiles(&orig_path, &new_path, &binary,
-                                   base_root, base_path, root, path,
-                                   pool, pool));
+                                   &truncated, base_root, base_path,
+                                   root, path, c->max_size, pool, pool));
         }
       else if (c->diff_copy_from && node->action == 'A' && is_copy)
         {
@@ -929,8 +1019,8 @@ print_diff_tree(svn_stream_t *out_stream,
             {
               do_diff = TRUE;
               SVN_ERR(prepare_tmpfiles(&orig_path, &new_path, &binary,
-                                       base_root, base_path, root, path,
-                                       pool, pool));
+                                       &truncated, base_root, base_path,
+                                       root, path, c->max_size, pool, pool));
             }
         }
       else if (! c->no_diff_added && node->action == 'A')
@@ -938,15 +1028,15 @@ print_diff_tree(svn_stream_t *out_stream,
           do_diff = TRUE;
           orig_empty = TRUE;
           SVN_ERR(prepare_tmpfiles(&orig_path, &new_path, &binary,
-                                   NULL, base_path, root, path,
-                                   pool, pool));
+                                   &truncated, NULL, base_path,
+                                   root, path, c->max_size, pool, pool));
         }
       else if (! c->no_diff_deleted && node->action == 'D')
         {
           do_diff = TRUE;
           SVN_ERR(prepare_tmpfiles(&orig_path, &new_path, &binary,
-                                   base_root, base_path, NULL, path,
-                                   pool, pool));
+                                   &truncated, base_root, base_path,
+                                   NULL, path, c->max_size, pool, pool));
         }
 
       /* The header for the copy case has already been created, and we don't
@@ -976,6 +1066,14 @@ print_diff_tree(svn_stream_t *out_stream,
         }
       else
         {
+          if (truncated)
+            svn_stringbuf_appendcstr
+              (header,
+               apr_psprintf(pool,
+                            _("(Only the first %" SVN_FILESIZE_T_FMT
+                              " bytes of each file are compared)\n"),
+                            c->max_size));
+
           if (c->diff_cmd)
             {
               apr_file_t *outfile;
@@ -1502,18 +1600,44 @@ do_cat(svnlook_ctxt_t *c, const char *path, apr_pool_t *pool)
 static svn_error_t *
 do_changed(svnlook_ctxt_t *c, apr_pool_t *pool)
 {
-  svn_fs_root_t *root;
+  svn_fs_root_t *root, *base_root;
   svn_revnum_t base_rev_id;
-  svn_repos_node_t *tree;
+  svn_fs_path_change_iterator_t *iterator;
+  svn_fs_path_change3_t *change;
+  apr_array_header_t *changes;
+  apr_pool_t *iterpool;
+  int i;
 
   SVN_ERR(get_root(&root, c, pool));
   SVN_ERR(get_base_rev(&base_rev_id, c, pool));
   if (base_rev_id == SVN_INVALID_REVNUM)
     return SVN_NO_ERROR;
 
-  SVN_ERR(generate_delta_tree(&tree, c->repos, root, base_rev_id, pool));
-  if (tree)
-    SVN_ERR(print_changed_tree(tree, "", c->copy_info, pool));
+  SVN_ERR(svn_fs_revision_root(&base_root, c->fs, base_rev_id, pool));
+
+  /* The list of changes has all we need.  There is no point in replaying
+     it into a delta tree; we only have to sort it. */
+  changes = apr_array_make(pool, 16, sizeof(svn_fs_path_change3_t *));
+  SVN_ERR(svn_fs_paths_changed3(&iterator, root, pool, pool));
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  while (change)
+    {
+      APR_ARRAY_PUSH(changes, svn_fs_path_change3_t *)
+        = svn_fs_path_change3_dup(change, pool);
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+    }
+
+  svn_sort__array(changes, compare_changes);
+
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < changes->nelts; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(check_cancel(NULL));
+      SVN_ERR(print_change(APR_ARRAY_IDX(changes, i, svn_fs_path_change3_t *),
+                           root, base_root, c->copy_info, iterpool));
+    }
+  svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
@@ -2119,6 +2243,7 @@ get_ctxt_baton(svnlook_ctxt_t **baton_p,
   baton->ignore_properties = opt_state->ignore_properties;
   baton->properties_only = opt_state->properties_only;
   baton->diff_cmd = opt_state->diff_cmd;
+  baton->max_size = opt_state->max_size;
 
   if (baton->txn_name)
     SVN_ERR(svn_fs_open_txn(&(baton->txn), baton->fs,
@@ -2641,6 +2766,16 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           opt_state.no_newline = TRUE;
           break;
 
+        case svnlook__max_size:
+          {
+            apr_int64_t max_size;
+
+            SVN_ERR(svn_cstring_strtoi64(&max_size, opt_arg, 1,
+                                         APR_INT64_MAX, 10));
+            opt_state.max_size = (svn_filesize_t)max_size;
+          }
+          break;
+
         default:
           SVN_ERR(subcommand_help(NULL, NULL, pool));
           *exit_code = EXIT_FAILURE;
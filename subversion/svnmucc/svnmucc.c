@@ -138,6 +138,20 @@ struct action {
   const svn_string_t *prop_value;
 };
 
+/* Implements svn_stream_lazyopen_func_t, opening the local file BATON,
+   a const char *, for reading. */
+static svn_error_t *
+open_put_source(svn_stream_t **stream,
+                void *baton,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  const char *path = baton;
+
+  return svn_error_trace(svn_stream_open_readonly(stream, path, result_pool,
+                                                  scratch_pool));
+}
+
 static svn_error_t *
 execute(const apr_array_header_t *actions,
         const char *anchor,
@@ -199,9 +213,12 @@ execute(const apr_array_header_t *actions,
           {
             svn_stream_t *src;
 
+            /* Scripts may put many thousands of files, so don't open
+               them before the commit actually sends their contents. */
             if (strcmp(action->path[1], "-") != 0)
-              SVN_ERR(svn_stream_open_readonly(&src, action->path[1],
-                                               pool, iterpool));
+              src = svn_stream_lazyopen_create(open_put_source,
+                                               (void *)action->path[1],
+                                               FALSE, pool);
             else
               SVN_ERR(svn_stream_for_stdin2(&src, TRUE, pool));
 
@@ -23,6 +23,8 @@
  */
 
 #include <apr_uri.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
 
 #include "svn_pools.h"
 #include "svn_cmdline.h"
@@ -35,12 +37,16 @@
 #include "svn_private_config.h"
 #include "svn_string.h"
 #include "svn_props.h"
+#include "svn_sorts.h"
 
 #include "svnrdump.h"
 
 #include "private/svn_repos_private.h"
 #include "private/svn_cmdline_private.h"
 #include "private/svn_ra_private.h"
+#include "private/svn_subr_private.h"
+#include "private/svn_mutex.h"
+#include "private/svn_atomic.h"
 
 
 
@@ -65,6 +71,7 @@ enum svn_svnrdump__longopt_t
     opt_skip_revprop,
     opt_force_interactive,
     opt_incremental,
+    opt_jobs,
     opt_trust_server_cert,
     opt_trust_server_cert_failures,
     opt_version
@@ -90,7 +97,7 @@ static const svn_opt_subcommand_desc3_t svnrdump__cmd_table[] =
        "in a 'dumpfile' portable format.  If only LOWER is given, dump that\n"
        "one revision.\n"
     )},
-    { 'r', 'q', opt_incremental, 'F', SVN_SVNRDUMP__BASE_OPTIONS },
+    { 'r', 'q', opt_incremental, opt_jobs, 'F', SVN_SVNRDUMP__BASE_OPTIONS },
     {{'F', N_("write to file ARG instead of stdout")}} },
   { "load", load_cmd, { 0 }, {N_(
        "usage: svnrdump load URL\n"
@@ -116,6 +123,10 @@ static const apr_getopt_option_t svnrdump__options[] =
                       N_("no progress (only errors) to stderr")},
     {"incremental",   opt_incremental, 0,
                       N_("dump incrementally")},
+    {"jobs",          opt_jobs, 1,
+                      N_("replay up to ARG ranges of revisions in parallel,\n"
+                         "                             "
+                         "each over separate connections.  Default: 1.")},
     {"skip-revprop",  opt_skip_revprop, 1,
                       N_("skip revision property ARG (e.g., \"svn:author\")")},
     {"config-dir",    opt_config_dir, 1,
@@ -196,6 +207,7 @@ typedef struct opt_baton_t {
   svn_boolean_t quiet;
   svn_boolean_t incremental;
   apr_hash_t *skip_revprops;
+  int jobs;
 } opt_baton_t;
 
 /* Print dumpstream-formatted information about REVISION.
@@ -465,11 +477,391 @@ dump_initial_full_revision(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+#if APR_HAS_THREADS && !defined(USE_EV2_IMPL)
+
+/* Number of revisions that a worker dumps in one go. */
+#define DUMP_CHUNK_SIZE 16
+
+/* Memory that the dump of a chunk may use before being spilled to a
+   temporary file. */
+#define DUMP_SPILL_SIZE (16 * 1024 * 1024)
+
+/* A range of revisions dumped by one of the workers. */
+typedef struct dump_chunk_t
+{
+  svn_revnum_t start_revision;
+  svn_revnum_t end_revision;
+
+  /* The dump data and, if not NULL, the error that prevented it from
+     being completed. */
+  svn_spillbuf_t *buffer;
+  svn_error_t *err;
+
+  /* Set once the worker has finished with this chunk. */
+  svn_boolean_t done;
+
+  /* Root pool containing BUFFER.  Only one thread uses it at a time. */
+  apr_pool_t *pool;
+} dump_chunk_t;
+
+/* State shared between the workers dumping chunks and the main thread
+   writing them to the output stream in order. */
+typedef struct parallel_dump_t
+{
+  dump_chunk_t *chunks;
+  int chunk_count;
+
+  /* Index of the next chunk to be picked by a worker. */
+  int next_chunk;
+
+  /* Index of the next chunk to be written to the output. */
+  int next_output;
+
+  /* Maximum number of chunks to be dumped ahead of the output, limiting
+     the amount of buffered data. */
+  int max_ahead;
+
+  /* Set when the workers shall stop. */
+  volatile svn_atomic_t stopped;
+
+  /* Synchronization objects. */
+  svn_mutex__t *mutex;
+  apr_thread_cond_t *cond;
+} parallel_dump_t;
+
+/* A worker thread with its own RA sessions. */
+typedef struct dump_worker_t
+{
+  parallel_dump_t *dump;
+  svn_ra_session_t *session;
+  svn_ra_session_t *extra_ra_session;
+  apr_thread_t *thread;
+} dump_worker_t;
+
+/* Wake up all threads waiting for state changes in DUMP.
+ * The caller must hold DUMP->MUTEX. */
+static svn_error_t *
+dump_broadcast(parallel_dump_t *dump)
+{
+  apr_status_t status = apr_thread_cond_broadcast(dump->cond);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't broadcast condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait for the next state change in DUMP.
+ * The caller must hold DUMP->MUTEX. */
+static svn_error_t *
+dump_wait(parallel_dump_t *dump)
+{
+  apr_status_t status = apr_thread_cond_wait(dump->cond,
+                                             svn_mutex__get(dump->mutex));
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't wait on condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *CHUNK to the next chunk of DUMP to work on, waiting while the
+ * workers are too far ahead of the output.  Set it to NULL if there is
+ * nothing left to do.  The caller must hold DUMP->MUTEX. */
+static svn_error_t *
+claim_chunk(dump_chunk_t **chunk,
+            parallel_dump_t *dump)
+{
+  while (dump->next_chunk < dump->chunk_count
+         && dump->next_chunk >= dump->next_output + dump->max_ahead
+         && !svn_atomic_read(&dump->stopped))
+    SVN_ERR(dump_wait(dump));
+
+  if (dump->next_chunk == dump->chunk_count
+      || svn_atomic_read(&dump->stopped))
+    *chunk = NULL;
+  else
+    *chunk = &dump->chunks[dump->next_chunk++];
+
+  return SVN_NO_ERROR;
+}
+
+/* Mark CHUNK of DUMP as done with ERR as its result.
+ * The caller must hold DUMP->MUTEX. */
+static svn_error_t *
+finish_chunk(parallel_dump_t *dump,
+             dump_chunk_t *chunk,
+             svn_error_t *err)
+{
+  chunk->err = err;
+  chunk->done = TRUE;
+
+  return svn_error_trace(dump_broadcast(dump));
+}
+
+/* Replay the revisions of CHUNK using the RA sessions of WORKER into
+ * the spill buffer of CHUNK. */
+static svn_error_t *
+dump_chunk(dump_worker_t *worker,
+           dump_chunk_t *chunk)
+{
+  struct replay_baton *replay_baton;
+
+  chunk->pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  chunk->buffer = svn_spillbuf__create(SVN__STREAM_CHUNK_SIZE,
+                                       DUMP_SPILL_SIZE, chunk->pool);
+
+  /* The main thread reports the progress once the chunk is written. */
+  replay_baton = apr_pcalloc(chunk->pool, sizeof(*replay_baton));
+  replay_baton->stdout_stream = svn_stream__from_spillbuf(chunk->buffer,
+                                                          chunk->pool);
+  replay_baton->extra_ra_session = worker->extra_ra_session;
+  replay_baton->quiet = TRUE;
+
+  return svn_error_trace(svn_ra_replay_range(worker->session,
+                                             chunk->start_revision,
+                                             chunk->end_revision,
+                                             0, TRUE, replay_revstart,
+                                             replay_revend, replay_baton,
+                                             chunk->pool));
+}
+
+/* Thread dumping chunks using the dump_worker_t DATA until there are
+ * none left. */
+static void * APR_THREAD_FUNC
+dump_worker_thread(apr_thread_t *thread, void *data)
+{
+  dump_worker_t *worker = data;
+  parallel_dump_t *dump = worker->dump;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  while (!err)
+    {
+      dump_chunk_t *chunk;
+      svn_error_t *chunk_err;
+
+      err = svn_mutex__lock(dump->mutex);
+      if (!err)
+        err = svn_mutex__unlock(dump->mutex, claim_chunk(&chunk, dump));
+      if (err || !chunk)
+        break;
+
+      chunk_err = dump_chunk(worker, chunk);
+
+      err = svn_mutex__lock(dump->mutex);
+      if (!err)
+        err = svn_mutex__unlock(dump->mutex,
+                                finish_chunk(dump, chunk, chunk_err));
+    }
+
+  /* Without the synchronization working, the main thread might wait
+     forever, so there is no way to recover. */
+  if (err)
+    svn_handle_error2(err, stderr, TRUE, "svnrdump: ");
+
+  apr_thread_exit(thread, APR_SUCCESS);
+  return NULL;
+}
+
+/* Wait for CHUNK of DUMP to be finished.
+ * The caller must hold DUMP->MUTEX. */
+static svn_error_t *
+wait_for_chunk(parallel_dump_t *dump,
+               dump_chunk_t *chunk)
+{
+  while (!chunk->done)
+    SVN_ERR(dump_wait(dump));
+
+  return SVN_NO_ERROR;
+}
+
+/* Release CHUNK and let the workers of DUMP continue.
+ * The caller must hold DUMP->MUTEX. */
+static svn_error_t *
+release_chunk(parallel_dump_t *dump,
+              dump_chunk_t *chunk)
+{
+  svn_pool_destroy(chunk->pool);
+  chunk->pool = NULL;
+  dump->next_output++;
+
+  return svn_error_trace(dump_broadcast(dump));
+}
+
+/* Tell the workers of DUMP to stop.
+ * The caller must hold DUMP->MUTEX. */
+static svn_error_t *
+stop_dump(parallel_dump_t *dump)
+{
+  svn_atomic_set(&dump->stopped, TRUE);
+
+  return svn_error_trace(dump_broadcast(dump));
+}
+
+/* Write the contents of CHUNK to OUTPUT_STREAM and report its revisions
+ * as dumped unless QUIET is set. */
+static svn_error_t *
+write_chunk(svn_stream_t *output_stream,
+            dump_chunk_t *chunk,
+            svn_boolean_t quiet,
+            apr_pool_t *scratch_pool)
+{
+  svn_revnum_t revision;
+  svn_error_t *err = chunk->err;
+
+  chunk->err = SVN_NO_ERROR;
+  SVN_ERR(err);
+
+  while (TRUE)
+    {
+      const char *data;
+      apr_size_t len;
+
+      SVN_ERR(svn_spillbuf__read(&data, &len, chunk->buffer, scratch_pool));
+      if (data == NULL)
+        break;
+
+      SVN_ERR(svn_stream_write(output_stream, data, &len));
+    }
+
+  if (! quiet)
+    for (revision = chunk->start_revision;
+         revision <= chunk->end_revision;
+         revision++)
+      SVN_ERR(svn_cmdline_fprintf(stderr, scratch_pool,
+                                  "* Dumped revision %lu.\n", revision));
+
+  return SVN_NO_ERROR;
+}
+
+/* Like svn_ra_replay_range() with replay_revstart() and replay_revend(),
+ * dump the revisions START_REVISION thru END_REVISION of the repository
+ * at the session URL of SESSION to OUTPUT_STREAM, but let JOBS worker
+ * threads replay chunks of revisions in parallel, each over RA sessions
+ * of its own opened using CTX.  The chunks get written in order. */
+static svn_error_t *
+replay_revisions_parallel(svn_ra_session_t *session,
+                          svn_stream_t *output_stream,
+                          svn_revnum_t start_revision,
+                          svn_revnum_t end_revision,
+                          svn_boolean_t quiet,
+                          int jobs,
+                          svn_client_ctx_t *ctx,
+                          apr_pool_t *pool)
+{
+  parallel_dump_t *dump = apr_pcalloc(pool, sizeof(*dump));
+  dump_worker_t *workers = apr_pcalloc(pool, jobs * sizeof(*workers));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  const char *session_url;
+  const char *repos_root;
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_error_t *stop_err;
+  int started = 0;
+  int i;
+
+  dump->chunk_count = (int)((end_revision - start_revision)
+                            / DUMP_CHUNK_SIZE + 1);
+  dump->chunks = apr_pcalloc(pool, dump->chunk_count * sizeof(*dump->chunks));
+  dump->max_ahead = 2 * jobs;
+  for (i = 0; i < dump->chunk_count; i++)
+    {
+      dump_chunk_t *chunk = &dump->chunks[i];
+
+      chunk->start_revision = start_revision + i * DUMP_CHUNK_SIZE;
+      chunk->end_revision = MIN(chunk->start_revision + DUMP_CHUNK_SIZE - 1,
+                                end_revision);
+    }
+
+  SVN_ERR(svn_mutex__init(&dump->mutex, TRUE, pool));
+  {
+    apr_status_t status = apr_thread_cond_create(&dump->cond, pool);
+    if (status)
+      return svn_error_wrap_apr(status, _("Can't create condition variable"));
+  }
+
+  /* Open all sessions up-front, so the workers won't need CTX. */
+  SVN_ERR(svn_ra_get_session_url(session, &session_url, pool));
+  SVN_ERR(svn_ra_get_repos_root2(session, &repos_root, pool));
+  for (i = 0; i < jobs; i++)
+    {
+      dump_worker_t *worker = &workers[i];
+
+      worker->dump = dump;
+      SVN_ERR(svn_client_open_ra_session2(&worker->session, session_url,
+                                          NULL, ctx, pool, pool));
+      SVN_ERR(svn_client_open_ra_session2(&worker->extra_ra_session,
+                                          repos_root, NULL, ctx, pool, pool));
+    }
+
+  for (started = 0; started < jobs; started++)
+    {
+      apr_status_t status = apr_thread_create(&workers[started].thread, NULL,
+                                              dump_worker_thread,
+                                              &workers[started], pool);
+      if (status)
+        {
+          err = svn_error_wrap_apr(status, _("Can't create dump thread"));
+          break;
+        }
+    }
+
+  /* Write the chunks in revision order. */
+  for (i = 0; !err && i < dump->chunk_count; i++)
+    {
+      dump_chunk_t *chunk = &dump->chunks[i];
+
+      svn_pool_clear(iterpool);
+
+      err = svn_mutex__lock(dump->mutex);
+      if (!err)
+        err = svn_mutex__unlock(dump->mutex, wait_for_chunk(dump, chunk));
+      if (!err)
+        err = write_chunk(output_stream, chunk, quiet, iterpool);
+      if (!err)
+        err = check_cancel(NULL);
+      if (!err)
+        err = svn_mutex__lock(dump->mutex);
+      if (!err)
+        err = svn_mutex__unlock(dump->mutex, release_chunk(dump, chunk));
+    }
+
+  /* The workers may still be busy, e.g. after a failed write. */
+
+  stop_err = svn_mutex__lock(dump->mutex);
+  if (!stop_err)
+    stop_err = svn_mutex__unlock(dump->mutex, stop_dump(dump));
+  err = svn_error_compose_create(err, stop_err);
+
+  for (i = 0; i < started; i++)
+    {
+      apr_status_t thread_status;
+      apr_status_t status = apr_thread_join(&thread_status,
+                                            workers[i].thread);
+      if (status)
+        err = svn_error_compose_create(
+                err, svn_error_wrap_apr(status, _("Can't join dump thread")));
+    }
+
+  /* Drop whatever has been dumped but not written. */
+  for (i = dump->next_output; i < dump->chunk_count; i++)
+    {
+      dump_chunk_t *chunk = &dump->chunks[i];
+
+      svn_error_clear(chunk->err);
+      if (chunk->pool)
+        svn_pool_destroy(chunk->pool);
+    }
+
+  svn_pool_destroy(iterpool);
+  return svn_error_trace(err);
+}
+
+#endif
+
 /* Replay revisions START_REVISION thru END_REVISION (inclusive) of
  * the repository URL at which SESSION is rooted, using callbacks
  * which generate Subversion repository dumpstreams describing the
  * changes made in those revisions.  If QUIET is set, don't generate
- * progress messages.
+ * progress messages.  If JOBS is larger than 1, replay that many
+ * ranges of revisions in parallel, using RA sessions opened with CTX.
  */
 static svn_error_t *
 replay_revisions(svn_ra_session_t *session,
@@ -479,6 +871,8 @@ replay_revisions(svn_ra_session_t *session,
                  svn_boolean_t quiet,
                  svn_boolean_t incremental,
                  const char *dumpfile,
+                 int jobs,
+                 svn_client_ctx_t *ctx,
                  apr_pool_t *pool)
 {
   struct replay_baton *replay_baton;
@@ -537,6 +931,13 @@ replay_revisions(svn_ra_session_t *session,
   if (start_revision <= end_revision)
     {
 #ifndef USE_EV2_IMPL
+#if APR_HAS_THREADS
+      if (jobs > 1 && end_revision - start_revision >= DUMP_CHUNK_SIZE)
+        SVN_ERR(replay_revisions_parallel(session, output_stream,
+                                          start_revision, end_revision,
+                                          quiet, jobs, ctx, pool));
+      else
+#endif
       SVN_ERR(svn_ra_replay_range(session, start_revision, end_revision,
                                   0, TRUE, replay_revstart, replay_revend,
                                   replay_baton, pool));
@@ -577,6 +978,9 @@ load_revisions(svn_ra_session_t *session,
       SVN_ERR(svn_stream_for_stdin2(&output_stream, TRUE, pool));
     }
 
+  /* Read the next revisions while the current one gets committed. */
+  SVN_ERR(svn_rdump__read_ahead_stream(&output_stream, output_stream, pool));
+
   SVN_ERR(svn_rdump__load_dumpstream(output_stream, session, aux_session,
                                      quiet, skip_revprops,
                                      check_cancel, NULL, pool));
@@ -648,7 +1052,8 @@ dump_cmd(apr_getopt_t *os,
                           opt_baton->start_revision.value.number,
                           opt_baton->end_revision.value.number,
                           opt_baton->quiet, opt_baton->incremental,
-                          opt_baton->dumpfile, pool);
+                          opt_baton->dumpfile, opt_baton->jobs,
+                          opt_baton->ctx, pool);
 }
 
 /* Handle the "load" subcommand.  Implements `svn_opt_subcommand_t'.  */
@@ -813,6 +1218,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   opt_baton->url = NULL;
   opt_baton->skip_revprops = apr_hash_make(pool);
   opt_baton->dumpfile = NULL;
+  opt_baton->jobs = 1;
 
   SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
 
@@ -900,6 +1306,13 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
         case opt_incremental:
           opt_baton->incremental = TRUE;
           break;
+        case opt_jobs:
+          SVN_ERR(svn_cstring_atoi(&opt_baton->jobs, opt_arg));
+          if (opt_baton->jobs < 1)
+            return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                     _("Invalid number of jobs '%s'"),
+                                     opt_arg);
+          break;
         case opt_skip_revprop:
           SVN_ERR(svn_utf_cstring_to_utf8(&opt_arg, opt_arg, pool));
           svn_hash_sets(opt_baton->skip_revprops, opt_arg, opt_arg);
@@ -1165,10 +1578,10 @@ main(int argc, const char *argv[])
   if (svn_cmdline_init("svnrdump", stderr) != EXIT_SUCCESS)
     return EXIT_FAILURE;
 
-  /* Create our top-level pool.  Use a separate mutexless allocator,
-   * given this application is single threaded.
+  /* Create our top-level pool.  Dumping with --jobs and loading use
+   * separate threads, so the allocator must be thread-safe.
    */
-  pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  pool = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
 
   err = sub_main(&exit_code, argc, argv, pool);
 
@@ -115,6 +115,20 @@ svn_rdump__normalize_props(apr_hash_t **normal_props,
                            apr_hash_t *props,
                            apr_pool_t *result_pool);
 
+/* Set *STREAM to a stream returning the contents of SOURCE, which get
+ * read ahead in a separate thread, so that e.g. reading the dumpstream
+ * overlaps with the commits of the revisions read before.  Closing
+ * *STREAM closes SOURCE.  SOURCE must not be used otherwise until then.
+ *
+ * Without thread support, simply set *STREAM to SOURCE.
+ *
+ * Allocate *STREAM in RESULT_POOL.
+ */
+svn_error_t *
+svn_rdump__read_ahead_stream(svn_stream_t **stream,
+                             svn_stream_t *source,
+                             apr_pool_t *result_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -21,10 +21,20 @@
  * ====================================================================
  */
 
+#include <string.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
+
+#include "svn_pools.h"
+#include "svn_sorts.h"
 #include "private/svn_repos_private.h"
+#include "private/svn_mutex.h"
+#include "private/svn_atomic.h"
 
 #include "svnrdump.h"
 
+#include "svn_private_config.h"
+
 
 svn_error_t *
 svn_rdump__normalize_props(apr_hash_t **normal_props,
@@ -53,3 +63,331 @@ svn_rdump__normalize_props(apr_hash_t **normal_props,
 
   return SVN_NO_ERROR;
 }
+
+
+#if APR_HAS_THREADS
+
+/* Number and size of the buffers that the read-ahead thread may fill
+   before the consumer gets to them, i.e. 4 MiB in total. */
+#define READ_AHEAD_BUFFERS 256
+#define READ_AHEAD_BUFFER_SIZE SVN__STREAM_CHUNK_SIZE
+
+/* Baton for a read-ahead stream. */
+typedef struct read_ahead_baton_t
+{
+  /* The stream we read from.  Only used by the read-ahead thread. */
+  svn_stream_t *source;
+
+  /* Ring buffer of filled buffers and their lengths. */
+  char *buffers[READ_AHEAD_BUFFERS];
+  apr_size_t lengths[READ_AHEAD_BUFFERS];
+  int first;
+  int count;
+
+  /* Bytes of the first buffer that have already been consumed.  Only
+     used by the consumer. */
+  apr_size_t offset;
+
+  /* Set when the read-ahead thread has finished, with ERR being the
+     error that made it stop, if any. */
+  svn_boolean_t eof;
+  svn_error_t *err;
+
+  /* Set when the read-ahead thread shall stop. */
+  volatile svn_atomic_t stopped;
+
+  /* The read-ahead thread.  NULL after it has been joined. */
+  apr_thread_t *thread;
+
+  /* Synchronization objects. */
+  svn_mutex__t *mutex;
+  apr_thread_cond_t *cond;
+} read_ahead_baton_t;
+
+/* Wake up the other thread waiting for state changes in BATON.
+ * The caller must hold BATON->MUTEX. */
+static svn_error_t *
+read_ahead_broadcast(read_ahead_baton_t *baton)
+{
+  apr_status_t status = apr_thread_cond_broadcast(baton->cond);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't broadcast condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait for the next state change in BATON.
+ * The caller must hold BATON->MUTEX. */
+static svn_error_t *
+read_ahead_wait(read_ahead_baton_t *baton)
+{
+  apr_status_t status = apr_thread_cond_wait(baton->cond,
+                                             svn_mutex__get(baton->mutex));
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't wait on condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *SLOT to the index of the next empty buffer in BATON, waiting for
+ * one to become available.  Set it to -1 if the thread shall stop.
+ * The caller must hold BATON->MUTEX. */
+static svn_error_t *
+get_empty_buffer(int *slot,
+                 read_ahead_baton_t *baton)
+{
+  while (baton->count == READ_AHEAD_BUFFERS
+         && !svn_atomic_read(&baton->stopped))
+    SVN_ERR(read_ahead_wait(baton));
+
+  *slot = svn_atomic_read(&baton->stopped)
+        ? -1
+        : (baton->first + baton->count) % READ_AHEAD_BUFFERS;
+
+  return SVN_NO_ERROR;
+}
+
+/* Pass the buffer SLOT in BATON with LEN bytes of data on to the consumer.
+ * Data shorter than a full buffer marks the end of the source stream.
+ * The caller must hold BATON->MUTEX. */
+static svn_error_t *
+put_full_buffer(read_ahead_baton_t *baton,
+                int slot,
+                apr_size_t len)
+{
+  baton->lengths[slot] = len;
+  if (len)
+    baton->count++;
+  if (len < READ_AHEAD_BUFFER_SIZE)
+    baton->eof = TRUE;
+
+  return svn_error_trace(read_ahead_broadcast(baton));
+}
+
+/* Pass ERR on to the consumer of BATON.
+ * The caller must hold BATON->MUTEX. */
+static svn_error_t *
+put_error(read_ahead_baton_t *baton,
+          svn_error_t *err)
+{
+  baton->eof = TRUE;
+  baton->err = err;
+
+  return svn_error_trace(read_ahead_broadcast(baton));
+}
+
+/* Thread reading from the source stream of the read_ahead_baton_t DATA
+ * until it hits EOF, an error or gets stopped. */
+static void * APR_THREAD_FUNC
+read_ahead_thread(apr_thread_t *thread, void *data)
+{
+  read_ahead_baton_t *baton = data;
+  svn_error_t *err = SVN_NO_ERROR;
+  int slot = 0;
+
+  while (!err)
+    {
+      apr_size_t len = READ_AHEAD_BUFFER_SIZE;
+
+      err = svn_mutex__lock(baton->mutex);
+      if (!err)
+        err = svn_mutex__unlock(baton->mutex,
+                                get_empty_buffer(&slot, baton));
+      if (err || slot < 0)
+        break;
+
+      /* The consumer does not touch empty buffers. */
+      err = svn_stream_read_full(baton->source, baton->buffers[slot], &len);
+      if (err)
+        break;
+
+      err = svn_mutex__lock(baton->mutex);
+      if (!err)
+        err = svn_mutex__unlock(baton->mutex,
+                                put_full_buffer(baton, slot, len));
+
+      if (len < READ_AHEAD_BUFFER_SIZE)
+        break;
+    }
+
+  /* Should we fail to pass on the error, the consumer would wait
+     forever, so there is no way to recover. */
+  if (err)
+    {
+      svn_error_t *err2 = svn_mutex__lock(baton->mutex);
+      if (!err2)
+        err2 = svn_mutex__unlock(baton->mutex, put_error(baton, err));
+      if (err2)
+        svn_handle_error2(err2, stderr, TRUE, "svnrdump: ");
+    }
+
+  apr_thread_exit(thread, APR_SUCCESS);
+  return NULL;
+}
+
+/* Copy up to *LEN bytes from the buffers in BATON to BUFFER, waiting for
+ * the read-ahead thread if necessary.  Set *LEN to the number of bytes
+ * actually copied, which is only less than requested at EOF.
+ * The caller must hold BATON->MUTEX. */
+static svn_error_t *
+copy_from_buffers(read_ahead_baton_t *baton,
+                  char *buffer,
+                  apr_size_t *len)
+{
+  apr_size_t copied = 0;
+
+  while (copied < *len)
+    {
+      apr_size_t available;
+      apr_size_t to_copy;
+
+      while (baton->count == 0 && !baton->eof)
+        SVN_ERR(read_ahead_wait(baton));
+
+      if (baton->count == 0)
+        {
+          svn_error_t *err = baton->err;
+          baton->err = SVN_NO_ERROR;
+          SVN_ERR(err);
+
+          break;
+        }
+
+      available = baton->lengths[baton->first] - baton->offset;
+      to_copy = MIN(available, *len - copied);
+      memcpy(buffer + copied, baton->buffers[baton->first] + baton->offset,
+             to_copy);
+      copied += to_copy;
+      baton->offset += to_copy;
+
+      /* Hand the buffer back to the read-ahead thread once it is used up. */
+      if (to_copy == available)
+        {
+          baton->first = (baton->first + 1) % READ_AHEAD_BUFFERS;
+          baton->count--;
+          baton->offset = 0;
+          SVN_ERR(read_ahead_broadcast(baton));
+        }
+    }
+
+  *len = copied;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_read_fn_t for read-ahead streams. */
+static svn_error_t *
+read_handler_read_ahead(void *baton,
+                        char *buffer,
+                        apr_size_t *len)
+{
+  read_ahead_baton_t *rab = baton;
+
+  SVN_MUTEX__WITH_LOCK(rab->mutex, copy_from_buffers(rab, buffer, len));
+
+  return SVN_NO_ERROR;
+}
+
+/* Tell the read-ahead thread of BATON to stop. */
+static svn_error_t *
+stop_read_ahead(read_ahead_baton_t *baton)
+{
+  svn_atomic_set(&baton->stopped, TRUE);
+
+  return svn_error_trace(read_ahead_broadcast(baton));
+}
+
+/* Stop and join the read-ahead thread of BATON, if it is still around. */
+static svn_error_t *
+join_read_ahead_thread(read_ahead_baton_t *baton)
+{
+  apr_status_t status;
+  apr_status_t thread_status;
+  svn_error_t *err;
+
+  if (!baton->thread)
+    return SVN_NO_ERROR;
+
+  SVN_MUTEX__WITH_LOCK(baton->mutex, stop_read_ahead(baton));
+
+  status = apr_thread_join(&thread_status, baton->thread);
+  baton->thread = NULL;
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't join read-ahead thread"));
+
+  /* Errors that the consumer did not get to see don't matter anymore. */
+  err = baton->err;
+  baton->err = SVN_NO_ERROR;
+  svn_error_clear(err);
+
+  return SVN_NO_ERROR;
+}
+
+/* Pool cleanup function making sure that the read-ahead thread of the
+ * read_ahead_baton_t DATA has terminated before its buffers go away. */
+static apr_status_t
+cleanup_read_ahead(void *data)
+{
+  read_ahead_baton_t *baton = data;
+  svn_error_t *err = join_read_ahead_thread(baton);
+
+  if (err)
+    {
+      apr_status_t status = err->apr_err;
+      svn_error_clear(err);
+      return status;
+    }
+
+  return APR_SUCCESS;
+}
+
+/* Implements svn_close_fn_t for read-ahead streams. */
+static svn_error_t *
+close_handler_read_ahead(void *baton)
+{
+  read_ahead_baton_t *rab = baton;
+
+  SVN_ERR(join_read_ahead_thread(rab));
+
+  return svn_error_trace(svn_stream_close(rab->source));
+}
+
+#endif
+
+svn_error_t *
+svn_rdump__read_ahead_stream(svn_stream_t **stream,
+                             svn_stream_t *source,
+                             apr_pool_t *result_pool)
+{
+#if APR_HAS_THREADS
+  read_ahead_baton_t *baton = apr_pcalloc(result_pool, sizeof(*baton));
+  apr_status_t status;
+  int i;
+
+  baton->source = source;
+  for (i = 0; i < READ_AHEAD_BUFFERS; i++)
+    baton->buffers[i] = apr_palloc(result_pool, READ_AHEAD_BUFFER_SIZE);
+
+  SVN_ERR(svn_mutex__init(&baton->mutex, TRUE, result_pool));
+  status = apr_thread_cond_create(&baton->cond, result_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  status = apr_thread_create(&baton->thread, NULL, read_ahead_thread,
+                             baton, result_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create read-ahead thread"));
+
+  /* Make sure the thread has terminated before its pool, the buffers and
+     the synchronization objects get destroyed. */
+  apr_pool_pre_cleanup_register(result_pool, baton, cleanup_read_ahead);
+
+  *stream = svn_stream_create(baton, result_pool);
+  svn_stream_set_read2(*stream, NULL /* only full read support */,
+                       read_handler_read_ahead);
+  svn_stream_set_close(*stream, close_handler_read_ahead);
+#else
+  *stream = source;
+#endif
+
+  return SVN_NO_ERROR;
+}
@@ -166,6 +166,7 @@ static svn_error_t *try_auth(svn_ra_svn_conn_t *conn,
                              sasl_conn_t *sasl_ctx,
                              apr_pool_t *pool,
                              server_baton_t *b,
+                             enum access_type required,
                              svn_boolean_t *success)
 {
   const char *out, *mech;
@@ -179,6 +180,11 @@ static svn_error_t *try_auth(svn_ra_svn_conn_t *conn,
   /* Read the client's chosen mech and the initial token. */
   SVN_ERR(svn_ra_svn__read_tuple(conn, pool, "w(?s)", &mech, &in));
 
+  /* Auth tickets are ours, not SASL's. */
+  if (strcmp(mech, "SVN-TICKET") == 0 && auth_ticket_usable(conn, b, required))
+    return svn_error_trace(auth_with_ticket(success, conn,
+                                            in ? in->data : NULL, b, pool));
+
   if (strcmp(mech, "EXTERNAL") == 0 && !in)
     in = svn_string_create(b->client_info->tunnel_user, pool);
   else if (in)
@@ -338,6 +344,9 @@ svn_error_t *cyrus_auth_request(svn_ra_svn_conn_t *conn,
       return svn_ra_svn__flush(conn, pool);
     }
 
+  if (auth_ticket_usable(conn, b, required))
+    mechlist = apr_pstrcat(pool, mechlist, " SVN-TICKET", SVN_VA_NULL);
+
   /* Send the list of mechanisms and the realm to the client. */
   SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, "(w)c",
                                          mechlist, b->repository->realm));
@@ -347,11 +356,15 @@ svn_error_t *cyrus_auth_request(svn_ra_svn_conn_t *conn,
   do
     {
       svn_pool_clear(subpool);
-      SVN_ERR(try_auth(conn, sasl_ctx, subpool, b, &success));
+      SVN_ERR(try_auth(conn, sasl_ctx, subpool, b, required, &success));
     }
   while (!success);
   svn_pool_destroy(subpool);
 
+  /* An auth ticket has set the username, without a security layer. */
+  if (b->client_info->ticket_auth)
+    return SVN_NO_ERROR;
+
   SVN_ERR(svn_ra_svn__enable_sasl_encryption(conn, sasl_ctx, pool));
 
   if (no_anonymous)
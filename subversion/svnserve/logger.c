@@ -171,6 +171,30 @@ logger__log_warning(logger_t *logger,
   log_message(logger, err, "WARN", repository, client_info);
 }
 
+void
+logger__log_stats(logger_t *logger,
+                  const char *message)
+{
+  if (logger)
+    {
+      const char *timestr, *line;
+      apr_size_t len;
+
+      svn_error_clear(svn_mutex__lock(logger->mutex));
+
+      timestr = svn_time_to_cstring(apr_time_now(), logger->pool);
+      line = apr_psprintf(logger->pool,
+                          "%" APR_PID_T_FMT " %s - - - STATS %s" APR_EOL_STR,
+                          getpid(), timestr, message);
+      len = strlen(line);
+
+      svn_error_clear(svn_stream_write(logger->stream, line, &len));
+      svn_pool_clear(logger->pool);
+
+      svn_error_clear(svn_mutex__unlock(logger->mutex, SVN_NO_ERROR));
+    }
+}
+
 svn_error_t *
 logger__write(logger_t *logger,
               const char *errstr,
@@ -79,6 +79,13 @@ logger__log_warning(logger_t *logger,
                     repository_t *repository,
                     client_info_t *client_info);
 
+/* Write MESSAGE as a line of server statistics to the log file managed
+ * by LOGGER.  If LOGGER is NULL, this becomes a no-op.
+ */
+void
+logger__log_stats(logger_t *logger,
+                  const char *message);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
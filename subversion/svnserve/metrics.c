@@ -0,0 +1,436 @@
+/*
+ * metrics.c : Per-command statistics for svnserve
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#define APR_WANT_STRFUNC
+#include <apr_want.h>
+#include <apr_general.h>
+
+#include "svn_error.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_sorts.h"
+#include "svn_string.h"
+
+#include "private/svn_mutex.h"
+#include "private/svn_sorts_private.h"
+
+#include "svn_private_config.h"
+#include "metrics.h"
+
+/* Upper bounds of the latency histogram buckets in microseconds and as
+ * Prometheus "le" labels.  The last bucket catches everything slower. */
+static const apr_interval_time_t bucket_limits[] =
+  {
+        1000,     2500,     5000,    10000,    25000,
+       50000,   100000,   250000,   500000,  1000000,
+     2500000,  5000000, 10000000, 30000000, 60000000
+  };
+
+static const char * const bucket_labels[] =
+  {
+    "0.001", "0.0025", "0.005", "0.01", "0.025",
+    "0.05", "0.1", "0.25", "0.5", "1",
+    "2.5", "5", "10", "30", "60", "+Inf"
+  };
+
+#define BUCKET_COUNT (sizeof(bucket_labels) / sizeof(bucket_labels[0]))
+
+/* Name under which we account commands not in the command table. */
+#define UNKNOWN_COMMAND "unknown"
+
+/* Counters for one command. */
+typedef struct counters_t
+{
+  apr_uint64_t count;
+  apr_uint64_t failed;
+  apr_uint64_t bytes_in;
+  apr_uint64_t bytes_out;
+  apr_uint64_t total_usec;
+
+  /* Memory allocated from the pools of the commands, if known. */
+  apr_uint64_t pool_bytes;
+
+  /* Number of commands per latency bucket, not cumulative. */
+  apr_uint64_t buckets[BUCKET_COUNT];
+} counters_t;
+
+/* Statistics for one command. */
+typedef struct command_metrics_t
+{
+  const char *cmdname;
+
+  /* Since the start of the server. */
+  counters_t total;
+
+  /* TOTAL as of the last report. */
+  counters_t reported;
+
+  /* Longest time taken since the last report. */
+  apr_interval_time_t max_duration;
+
+  /* Most memory allocated from the pool of one command since the last
+     report. */
+  apr_uint64_t max_pool_bytes;
+} command_metrics_t;
+
+struct metrics_t
+{
+  /* command_metrics_t * per command name, allocated in POOL. */
+  apr_hash_t *commands;
+
+  /* Report settings, see metrics__create(). */
+  apr_interval_time_t interval;
+  logger_t *logger;
+  const char *filename;
+
+  /* When the next report is due. */
+  apr_time_t next_report;
+
+  /* mutex used to serialize access to this structure */
+  svn_mutex__t *mutex;
+
+  apr_pool_t *pool;
+};
+
+svn_error_t *
+metrics__create(metrics_t **metrics,
+                apr_interval_time_t interval,
+                logger_t *logger,
+                const char *filename,
+                apr_pool_t *pool)
+{
+  metrics_t *result = apr_pcalloc(pool, sizeof(*result));
+
+  result->pool = svn_pool_create(pool);
+  result->commands = apr_hash_make(result->pool);
+  result->interval = interval;
+  result->logger = logger;
+  result->filename = filename ? apr_pstrdup(pool, filename) : NULL;
+  result->next_report = apr_time_now() + interval;
+  SVN_ERR(svn_mutex__init(&result->mutex, TRUE, pool));
+
+  *metrics = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the smallest bucket limit in ms that at least FRACTION of the
+ * commands counted in BUCKETS, which add up to COUNT, stay within.  If
+ * that is the last bucket, return MAX_DURATION in ms instead. */
+static apr_int64_t
+percentile_ms(const apr_uint64_t *buckets,
+              apr_uint64_t count,
+              double fraction,
+              apr_interval_time_t max_duration)
+{
+  apr_uint64_t needed = (apr_uint64_t)(count * fraction + 0.999999);
+  apr_uint64_t sum = 0;
+  apr_size_t i;
+
+  for (i = 0; i < BUCKET_COUNT - 1; i++)
+    {
+      sum += buckets[i];
+      if (sum >= needed)
+        return (bucket_limits[i] < max_duration ? bucket_limits[i]
+                                                : max_duration) / 1000;
+    }
+
+  return max_duration / 1000;
+}
+
+/* Append the log record lines for the commands in SORTED that were
+ * handled since the last report to LINES and reset the per-report
+ * values.  Allocate the lines in RESULT_POOL. */
+static void
+format_log_records(apr_array_header_t *lines,
+                   apr_array_header_t *sorted,
+                   apr_pool_t *result_pool)
+{
+  int i;
+  apr_size_t k;
+
+  for (i = 0; i < sorted->nelts; i++)
+    {
+      command_metrics_t *command
+        = APR_ARRAY_IDX(sorted, i, svn_sort__item_t).value;
+      counters_t delta;
+
+      delta.count = command->total.count - command->reported.count;
+      if (delta.count == 0)
+        continue;
+
+      delta.failed = command->total.failed - command->reported.failed;
+      delta.bytes_in = command->total.bytes_in - command->reported.bytes_in;
+      delta.bytes_out = command->total.bytes_out
+                      - command->reported.bytes_out;
+      delta.total_usec = command->total.total_usec
+                       - command->reported.total_usec;
+      delta.pool_bytes = command->total.pool_bytes
+                       - command->reported.pool_bytes;
+      for (k = 0; k < BUCKET_COUNT; k++)
+        delta.buckets[k] = command->total.buckets[k]
+                         - command->reported.buckets[k];
+
+      APR_ARRAY_PUSH(lines, const char *)
+        = apr_psprintf(result_pool,
+                       "command %s: %" APR_UINT64_T_FMT " ops, "
+                       "%" APR_UINT64_T_FMT " failed, "
+                       "avg %" APR_UINT64_T_FMT " ms, "
+                       "p50 %" APR_INT64_T_FMT " ms, "
+                       "p90 %" APR_INT64_T_FMT " ms, "
+                       "p99 %" APR_INT64_T_FMT " ms, "
+                       "max %" APR_INT64_T_FMT " ms, "
+                       "%" APR_UINT64_T_FMT " bytes in, "
+                       "%" APR_UINT64_T_FMT " bytes out",
+                       command->cmdname, delta.count, delta.failed,
+                       delta.total_usec / delta.count / 1000,
+                       percentile_ms(delta.buckets, delta.count, 0.5,
+                                     command->max_duration),
+                       percentile_ms(delta.buckets, delta.count, 0.9,
+                                     command->max_duration),
+                       percentile_ms(delta.buckets, delta.count, 0.99,
+                                     command->max_duration),
+                       (apr_int64_t)command->max_duration / 1000,
+                       delta.bytes_in, delta.bytes_out);
+
+      /* Pool sizes are only known in pool debugging builds. */
+      if (delta.pool_bytes)
+        APR_ARRAY_IDX(lines, lines->nelts - 1, const char *)
+          = apr_psprintf(result_pool,
+                         "%s, avg %" APR_UINT64_T_FMT " KB pool, "
+                         "max %" APR_UINT64_T_FMT " KB pool",
+                         APR_ARRAY_IDX(lines, lines->nelts - 1,
+                                       const char *),
+                         delta.pool_bytes / delta.count / 1024,
+                         command->max_pool_bytes / 1024);
+
+      command->reported = command->total;
+      command->max_duration = 0;
+      command->max_pool_bytes = 0;
+    }
+}
+
+/* Append the per-command counter NAME of type TYPE with help text HELP
+ * for all commands in SORTED to TEXT.  OFFSET is the position of the
+ * counter within counters_t. */
+static void
+format_counter(svn_stringbuf_t *text,
+               const char *name,
+               const char *type,
+               const char *help,
+               apr_size_t offset,
+               apr_array_header_t *sorted)
+{
+  int i;
+
+  svn_stringbuf_appendcstr(text,
+                           apr_psprintf(text->pool,
+                                        "# HELP %s %s\n# TYPE %s %s\n",
+                                        name, help, name, type));
+
+  for (i = 0; i < sorted->nelts; i++)
+    {
+      command_metrics_t *command
+        = APR_ARRAY_IDX(sorted, i, svn_sort__item_t).value;
+      const apr_uint64_t *value
+        = (const apr_uint64_t *)((const char *)&command->total + offset);
+
+      svn_stringbuf_appendcstr(text,
+                               apr_psprintf(text->pool,
+                                            "%s{command=\"%s\"} %"
+                                            APR_UINT64_T_FMT "\n",
+                                            name, command->cmdname,
+                                            *value));
+    }
+}
+
+/* Return all statistics in SORTED in the Prometheus text exposition
+ * format, allocated in RESULT_POOL. */
+static svn_stringbuf_t *
+format_exposition(apr_array_header_t *sorted,
+                  apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *text = svn_stringbuf_create_empty(result_pool);
+  const char *name = "svnserve_command_duration_seconds";
+  int i;
+  apr_size_t k;
+
+  svn_stringbuf_appendcstr(text,
+                           apr_psprintf(result_pool,
+                                        "# HELP %s Time taken to handle "
+                                        "client commands.\n"
+                                        "# TYPE %s histogram\n",
+                                        name, name));
+  for (i = 0; i < sorted->nelts; i++)
+    {
+      command_metrics_t *command
+        = APR_ARRAY_IDX(sorted, i, svn_sort__item_t).value;
+      apr_uint64_t cumulative = 0;
+
+      for (k = 0; k < BUCKET_COUNT; k++)
+        {
+          cumulative += command->total.buckets[k];
+          svn_stringbuf_appendcstr(text,
+                                   apr_psprintf(result_pool,
+                                                "%s_bucket{command=\"%s\","
+                                                "le=\"%s\"} %"
+                                                APR_UINT64_T_FMT "\n",
+                                                name, command->cmdname,
+                                                bucket_labels[k],
+                                                cumulative));
+        }
+
+      svn_stringbuf_appendcstr(text,
+                               apr_psprintf(result_pool,
+                                            "%s_sum{command=\"%s\"} %.6f\n"
+                                            "%s_count{command=\"%s\"} %"
+                                            APR_UINT64_T_FMT "\n",
+                                            name, command->cmdname,
+                                            command->total.total_usec / 1e6,
+                                            name, command->cmdname,
+                                            command->total.count));
+    }
+
+  format_counter(text, "svnserve_command_failures_total", "counter",
+                 "Number of client commands that failed.",
+                 APR_OFFSETOF(counters_t, failed), sorted);
+  format_counter(text, "svnserve_command_received_bytes_total", "counter",
+                 "Bytes received while handling client commands.",
+                 APR_OFFSETOF(counters_t, bytes_in), sorted);
+  format_counter(text, "svnserve_command_sent_bytes_total", "counter",
+                 "Bytes sent while handling client commands.",
+                 APR_OFFSETOF(counters_t, bytes_out), sorted);
+#if APR_POOL_DEBUG
+  format_counter(text, "svnserve_command_pool_bytes_total", "counter",
+                 "Memory allocated from pools while handling client "
+                 "commands.",
+                 APR_OFFSETOF(counters_t, pool_bytes), sorted);
+#endif
+
+  return text;
+}
+
+/* Add STATS, accounted to CMDNAME, to METRICS.  If a report is due,
+ * return the log record lines in *LINES and the exposition text in
+ * *TEXT, allocated in RESULT_POOL.  Otherwise, set them to NULL.  Call
+ * with METRICS->MUTEX locked. */
+static svn_error_t *
+record(apr_array_header_t **lines,
+       svn_stringbuf_t **text,
+       metrics_t *metrics,
+       const char *cmdname,
+       const svn_ra_svn__command_stats_t *stats,
+       apr_uint64_t pool_bytes,
+       apr_pool_t *result_pool)
+{
+  command_metrics_t *command = svn_hash_gets(metrics->commands, cmdname);
+  apr_time_t now = apr_time_now();
+  apr_size_t k;
+
+  if (!command)
+    {
+      command = apr_pcalloc(metrics->pool, sizeof(*command));
+      command->cmdname = apr_pstrdup(metrics->pool, cmdname);
+      svn_hash_sets(metrics->commands, command->cmdname, command);
+    }
+
+  for (k = 0; k < BUCKET_COUNT - 1; k++)
+    if (stats->duration <= bucket_limits[k])
+      break;
+
+  command->total.count++;
+  command->total.buckets[k]++;
+  command->total.total_usec += stats->duration;
+  command->total.bytes_in += stats->bytes_in;
+  command->total.bytes_out += stats->bytes_out;
+  if (stats->failed)
+    command->total.failed++;
+  if (stats->duration > command->max_duration)
+    command->max_duration = stats->duration;
+  command->total.pool_bytes += pool_bytes;
+  if (pool_bytes > command->max_pool_bytes)
+    command->max_pool_bytes = pool_bytes;
+
+  *lines = NULL;
+  *text = NULL;
+  if (now >= metrics->next_report)
+    {
+      apr_array_header_t *sorted
+        = svn_sort__hash(metrics->commands,
+                         svn_sort_compare_items_lexically, result_pool);
+
+      *lines = apr_array_make(result_pool, sorted->nelts,
+                              sizeof(const char *));
+      format_log_records(*lines, sorted, result_pool);
+      if (metrics->filename)
+        *text = format_exposition(sorted, result_pool);
+
+      metrics->next_report = now + metrics->interval;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+void
+metrics__record(metrics_t *metrics,
+                const svn_ra_svn__command_stats_t *stats,
+                svn_boolean_t known,
+                apr_uint64_t pool_bytes,
+                apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *lines;
+  svn_stringbuf_t *text;
+  svn_error_t *err;
+  int i;
+
+  err = svn_mutex__lock(metrics->mutex);
+  if (!err)
+    err = svn_mutex__unlock(metrics->mutex,
+                            record(&lines, &text, metrics,
+                                   known ? stats->cmdname : UNKNOWN_COMMAND,
+                                   stats, pool_bytes, scratch_pool));
+  if (err)
+    {
+      logger__log_error(metrics->logger, err, NULL, NULL);
+      svn_error_clear(err);
+      return;
+    }
+
+  /* Write the report without blocking other threads. */
+  for (i = 0; lines && i < lines->nelts; i++)
+    logger__log_stats(metrics->logger, APR_ARRAY_IDX(lines, i, const char *));
+
+  if (text)
+    {
+      err = svn_io_write_atomic2(metrics->filename, text->data, text->len,
+                                 NULL, FALSE, scratch_pool);
+      if (err)
+        {
+          logger__log_error(metrics->logger, err, NULL, NULL);
+          svn_error_clear(err);
+        }
+    }
+}
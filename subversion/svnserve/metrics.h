@@ -0,0 +1,72 @@
+/*
+ * metrics.h : Public definitions for the per-command statistics
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "private/svn_ra_svn_private.h"
+
+#include "logger.h"
+
+
+
+/* Opaque collection of per-command counters and latency histograms.
+ * Access will be serialized among threads within the same process.
+ */
+typedef struct metrics_t metrics_t;
+
+/* In POOL, create an empty statistics collection and return it in
+ * *METRICS.  Every INTERVAL, write the statistics for the commands
+ * handled since the last report to LOGGER.  If FILENAME is not NULL,
+ * also replace that file with all statistics collected so far, in the
+ * Prometheus text exposition format.
+ */
+svn_error_t *
+metrics__create(metrics_t **metrics,
+                apr_interval_time_t interval,
+                logger_t *logger,
+                const char *filename,
+                apr_pool_t *pool);
+
+/* Add STATS for a command to METRICS.  If KNOWN is FALSE, account it
+ * to unknown commands instead of STATS->CMDNAME.  POOL_BYTES is the
+ * memory allocated from the command's pool, or 0 if that is unknown.
+ * Write any report that is due.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+void
+metrics__record(metrics_t *metrics,
+                const svn_ra_svn__command_stats_t *stats,
+                svn_boolean_t known,
+                apr_uint64_t pool_bytes,
+                apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* METRICS_H */
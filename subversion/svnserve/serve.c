@@ -52,9 +52,11 @@
 #include "svn_user.h"
 
 #include "private/svn_log.h"
+#include "private/svn_fs_fs_private.h"
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_ra_svn_private.h"
 #include "private/svn_fspath.h"
+#include "private/svn_subr_private.h"
 
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>   /* For getpid() */
@@ -62,6 +64,7 @@
 
 #include "server.h"
 #include "logger.h"
+#include "metrics.h"
 
 typedef struct commit_callback_baton_t {
   apr_pool_t *pool;
@@ -180,6 +183,73 @@ static svn_error_t *log_command(server_baton_t *b,
   return logger__write(b->logger, line, nbytes);
 }
 
+/* Log how well the stream compression on CONN did, if enabled. */
+static svn_error_t *
+log_compression_stats(server_baton_t *b,
+                      svn_ra_svn_conn_t *conn,
+                      apr_pool_t *pool)
+{
+  const svn_ra_svn__compression_stats_t *stats
+    = svn_ra_svn__get_compression_stats(conn);
+
+  if (stats == NULL)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(log_command(b, conn, pool,
+                                     "compression in=%" APR_UINT64_T_FMT
+                                     "/%" APR_UINT64_T_FMT
+                                     " out=%" APR_UINT64_T_FMT
+                                     "/%" APR_UINT64_T_FMT,
+                                     stats->raw_in, stats->wire_in,
+                                     stats->raw_out, stats->wire_out));
+}
+
+/* Write all FSFS access trace entries accumulated since the last call
+   to the log and clear the trace.  As the trace is
+   process-wide, this includes accesses on behalf of other connections. */
+static svn_error_t *
+log_access_trace(server_baton_t *b,
+                 svn_ra_svn_conn_t *conn,
+                 apr_pool_t *pool)
+{
+  svn_fs_fs__ioctl_get_access_trace_input_t input = { TRUE };
+  svn_fs_fs__ioctl_get_access_trace_output_t *output;
+  int i;
+
+  if (b->logger == NULL)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_ioctl(NULL, SVN_FS_FS__IOCTL_GET_ACCESS_TRACE,
+                       &input, (void **)&output,
+                       NULL, NULL, pool, pool));
+
+  if (output->dropped)
+    SVN_ERR(log_command(b, conn, pool,
+                        "fsfs-access-dropped %" APR_UINT64_T_FMT,
+                        output->dropped));
+
+  for (i = 0; i < output->entries->nelts; ++i)
+    {
+      const svn_fs_fs__access_trace_entry_t *entry
+        = APR_ARRAY_IDX(output->entries, i,
+                        const svn_fs_fs__access_trace_entry_t *);
+
+      SVN_ERR(log_command(b, conn, pool,
+                          "fsfs-access %s r%ld/%" APR_UINT64_T_FMT
+                          " type=%u %s offset=%" APR_OFF_T_FMT
+                          " size=%" APR_OFF_T_FMT
+                          " usec=%" APR_TIME_T_FMT,
+                          svn_path_uri_encode(entry->fs_path, pool),
+                          entry->revision, entry->item_index,
+                          (unsigned)entry->item_type,
+                          entry->cache_hit ? "hit" : "miss",
+                          entry->offset, entry->size,
+                          (apr_time_t)entry->latency));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Log an authz failure */
 static svn_error_t *
 log_authz_denied(const char *path,
@@ -574,6 +644,107 @@ current_access(server_baton_t *b)
                               : b->repository->anon_access;
 }
 
+/* Return the signature of an auth ticket for USER in the realm of B that
+ * expires at EXPIRES, allocated in POOL.
+ */
+static const char *
+auth_ticket_digest(server_baton_t *b,
+                   const char *user,
+                   apr_time_t expires,
+                   apr_pool_t *pool)
+{
+  const char *data = apr_psprintf(pool, "%" APR_TIME_T_FMT "\n%s\n%s",
+                                  expires, b->repository->realm, user);
+
+  return svn_ra_svn__hmac_md5_hex(b->repository->ticket_key, data, pool);
+}
+
+/* Return a new auth ticket for the user authenticated in B, allocated in
+ * POOL.  The ticket reads "EXPIRES:SIGNATURE:USER".  There is no state
+ * kept on the server side, so any connection that knows the key can
+ * verify it.
+ */
+static const char *
+make_auth_ticket(server_baton_t *b, apr_pool_t *pool)
+{
+  apr_time_t expires = apr_time_now() + b->repository->ticket_lifetime;
+
+  return apr_psprintf(pool, "%" APR_TIME_T_FMT ":%s:%s", expires,
+                      auth_ticket_digest(b, b->client_info->user, expires,
+                                         pool),
+                      b->client_info->user);
+}
+
+svn_boolean_t
+auth_ticket_usable(svn_ra_svn_conn_t *conn,
+                   server_baton_t *b,
+                   enum access_type required)
+{
+  if (!b->repository->ticket_key || b->repository->auth_access < required)
+    return FALSE;
+
+#ifdef SVN_HAVE_SASL
+  /* Tickets bypass the SASL security layer. */
+  if (b->repository->use_sasl && b->repository->min_ssf > 0)
+    return FALSE;
+#endif
+
+  return svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_AUTH_TICKET);
+}
+
+svn_error_t *
+auth_with_ticket(svn_boolean_t *success,
+                 svn_ra_svn_conn_t *conn,
+                 const char *ticket,
+                 server_baton_t *b,
+                 apr_pool_t *pool)
+{
+  char *expires_str = apr_pstrdup(pool, ticket ? ticket : "");
+  char *digest, *user;
+  const char *password;
+  apr_int64_t expires;
+  svn_error_t *err;
+
+  *success = FALSE;
+
+  digest = strchr(expires_str, ':');
+  user = digest ? strchr(digest + 1, ':') : NULL;
+  if (!user)
+    return svn_ra_svn__write_tuple(conn, pool, "w(c)", "failure",
+                                   "Malformed auth ticket");
+  *digest++ = '\0';
+  *user++ = '\0';
+
+  err = svn_cstring_atoi64(&expires, expires_str);
+  if (err || !*user
+      || strcmp(digest, auth_ticket_digest(b, user, expires, pool)) != 0)
+    {
+      svn_error_clear(err);
+      return svn_ra_svn__write_tuple(conn, pool, "w(c)", "failure",
+                                     "Invalid auth ticket");
+    }
+
+  if (expires <= apr_time_now())
+    return svn_ra_svn__write_tuple(conn, pool, "w(c)", "failure",
+                                   "Auth ticket expired");
+
+  /* Users removed from the password database lose access right away. */
+  if (b->repository->pwdb && !b->repository->use_sasl)
+    {
+      svn_config_get(b->repository->pwdb, &password,
+                     SVN_CONFIG_SECTION_USERS, user, NULL);
+      if (!password)
+        return svn_ra_svn__write_tuple(conn, pool, "w(c)", "failure",
+                                       "Username not found");
+    }
+
+  b->client_info->user = apr_pstrdup(b->pool, user);
+  b->client_info->ticket_auth = TRUE;
+  *success = TRUE;
+
+  return svn_ra_svn__write_tuple(conn, pool, "w()", "success");
+}
+
 /* Send authentication mechs for ACCESS_TYPE to the client.  If NEEDS_USERNAME
    is true, don't send anonymous mech even if that would give the desired
    access. */
@@ -587,6 +758,8 @@ static svn_error_t *send_mechs(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
     SVN_ERR(svn_ra_svn__write_word(conn, pool, "EXTERNAL"));
   if (b->repository->pwdb && b->repository->auth_access >= required)
     SVN_ERR(svn_ra_svn__write_word(conn, pool, "CRAM-MD5"));
+  if (auth_ticket_usable(conn, b, required))
+    SVN_ERR(svn_ra_svn__write_word(conn, pool, "SVN-TICKET"));
   return SVN_NO_ERROR;
 }
 
@@ -685,6 +858,11 @@ static svn_error_t *auth(svn_boolean_t *success,
       return SVN_NO_ERROR;
     }
 
+  if (auth_ticket_usable(conn, b, required)
+      && strcmp(mech, "SVN-TICKET") == 0)
+    return svn_error_trace(auth_with_ticket(success, conn, mecharg, b,
+                                            scratch_pool));
+
   return svn_ra_svn__write_tuple(conn, scratch_pool, "w(c)", "failure",
                                 "Must authenticate with listed mechanism");
 }
@@ -856,8 +1034,11 @@ static svn_error_t *must_have_access(svn_ra_svn_conn_t *conn,
  * the error finish_report, to be handled by the calling command.
  */
 
+/* Report command handlers.  Clients may send millions of set-path
+   commands, so these read their parameters directly from CONN. */
+
 static svn_error_t *set_path(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
-                             svn_ra_svn__list_t *params, void *baton)
+                             void *baton)
 {
   report_driver_baton_t *b = baton;
   const char *path, *lock_token, *depth_word, *canonical_relpath;
@@ -866,9 +1047,9 @@ static svn_error_t *set_path(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   svn_depth_t depth = svn_depth_infinity;
   svn_boolean_t start_empty;
 
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "crb?(?c)?w",
-                                  &path, &rev, &start_empty, &lock_token,
-                                  &depth_word));
+  SVN_ERR(svn_ra_svn__read_tuple(conn, pool, "crb?(?c)?w",
+                                 &path, &rev, &start_empty, &lock_token,
+                                 &depth_word));
   if (depth_word)
     depth = svn_depth_from_word(depth_word);
   SVN_ERR(svn_relpath_canonicalize_safe(&canonical_relpath, NULL, path,
@@ -886,12 +1067,12 @@ static svn_error_t *set_path(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
 }
 
 static svn_error_t *delete_path(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
-                                svn_ra_svn__list_t *params, void *baton)
+                                void *baton)
 {
   report_driver_baton_t *b = baton;
   const char *path, *canonical_relpath;
 
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "c", &path));
+  SVN_ERR(svn_ra_svn__read_tuple(conn, pool, "c", &path));
   SVN_ERR(svn_relpath_canonicalize_safe(&canonical_relpath, NULL, path,
                                         pool, pool));
   path = canonical_relpath;
@@ -901,7 +1082,7 @@ static svn_error_t *delete_path(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
 }
 
 static svn_error_t *link_path(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
-                              svn_ra_svn__list_t *params, void *baton)
+                              void *baton)
 {
   report_driver_baton_t *b = baton;
   const char *path, *url, *lock_token, *fs_path, *depth_word, *canonical_url;
@@ -911,7 +1092,7 @@ static svn_error_t *link_path(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   /* Default to infinity, for old clients that don't send depth. */
   svn_depth_t depth = svn_depth_infinity;
 
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "ccrb?(?c)?w",
+  SVN_ERR(svn_ra_svn__read_tuple(conn, pool, "ccrb?(?c)?w",
                                  &path, &url, &rev, &start_empty,
                                  &lock_token, &depth_word));
 
@@ -962,9 +1143,9 @@ abort_report(svn_ra_svn_conn_t *conn,
 }
 
 static const svn_ra_svn__cmd_entry_t report_commands[] = {
-  { "set-path",      set_path },
-  { "delete-path",   delete_path },
-  { "link-path",     link_path },
+  { "set-path",      NULL, NULL, FALSE, set_path },
+  { "delete-path",   NULL, NULL, FALSE, delete_path },
+  { "link-path",     NULL, NULL, FALSE, link_path },
   { "finish-report", finish_report, NULL, TRUE },
   { "abort-report",  abort_report,  NULL, TRUE },
   { NULL }
@@ -1582,15 +1763,26 @@ commit(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+/* Send the get-file response for FULL_PATH in revision REV over CONN,
+ * including the contents if WANT_CONTENTS is set.  Include the explicit
+ * properties if WANT_PROPS is set and the inherited ones if
+ * WANTS_INHERITED_PROPS is set.  If LENGTH is not negative, send only
+ * the LENGTH bytes of the contents that start at OFFSET and no checksum.
+ * The caller must have checked read access to FULL_PATH.  Use POOL for
+ * allocations. */
 static svn_error_t *
-get_file(svn_ra_svn_conn_t *conn,
-         apr_pool_t *pool,
-         svn_ra_svn__list_t *params,
-         void *baton)
+send_file(svn_ra_svn_conn_t *conn,
+          apr_pool_t *pool,
+          server_baton_t *b,
+          const char *full_path,
+          svn_revnum_t rev,
+          svn_boolean_t want_props,
+          svn_boolean_t want_contents,
+          svn_boolean_t wants_inherited_props,
+          svn_filesize_t offset,
+          svn_filesize_t length)
 {
-  server_baton_t *b = baton;
-  const char *path, *full_path, *hex_digest, *canonical_path;
-  svn_revnum_t rev;
+  const char *hex_digest = NULL;
   svn_fs_root_t *root;
   svn_stream_t *contents;
   apr_hash_t *props = NULL;
@@ -1598,8 +1790,6 @@ get_file(svn_ra_svn_conn_t *conn,
   svn_string_t write_str;
   char buf[4096];
   apr_size_t len;
-  svn_boolean_t want_props, want_contents;
-  apr_uint64_t wants_inherited_props;
   svn_checksum_t *checksum;
   svn_error_t *err, *write_err;
   int i;
@@ -1608,35 +1798,14 @@ get_file(svn_ra_svn_conn_t *conn,
   ab.server = b;
   ab.conn = conn;
 
-  /* Parse arguments. */
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "c(?r)bb?B", &path, &rev,
-                                  &want_props, &want_contents,
-                                  &wants_inherited_props));
-
-  if (wants_inherited_props == SVN_RA_SVN_UNSPECIFIED_NUMBER)
-    wants_inherited_props = FALSE;
-
-  SVN_ERR(svn_relpath_canonicalize_safe(&canonical_path, NULL, path, pool,
-                                        pool));
-  full_path = svn_fspath__join(b->repository->fs_path->data, canonical_path,
-                               pool);
-
-  /* Check authorizations */
-  SVN_ERR(must_have_access(conn, pool, b, svn_authz_read,
-                           full_path, FALSE));
-
-  if (!SVN_IS_VALID_REVNUM(rev))
-    SVN_CMD_ERR(svn_fs_youngest_rev(&rev, b->repository->fs, pool));
-
-  SVN_ERR(log_command(b, conn, pool, "%s",
-                      svn_log__get_file(full_path, rev,
-                                        want_contents, want_props, pool)));
-
   /* Fetch the properties and a stream for the contents. */
   SVN_CMD_ERR(svn_fs_revision_root(&root, b->repository->fs, rev, pool));
-  SVN_CMD_ERR(svn_fs_file_checksum(&checksum, svn_checksum_md5, root,
-                                   full_path, TRUE, pool));
-  hex_digest = svn_checksum_to_cstring_display(checksum, pool);
+  if (length < 0)
+    {
+      SVN_CMD_ERR(svn_fs_file_checksum(&checksum, svn_checksum_md5, root,
+                                       full_path, TRUE, pool));
+      hex_digest = svn_checksum_to_cstring_display(checksum, pool);
+    }
 
   /* Fetch the file's explicit and/or inherited properties if
      requested.  Although the wants-iprops boolean was added to the
@@ -1647,7 +1816,17 @@ get_file(svn_ra_svn_conn_t *conn,
                           &ab, root, full_path,
                           pool));
   if (want_contents)
-    SVN_CMD_ERR(svn_fs_file_contents(&contents, root, full_path, pool));
+    {
+      SVN_CMD_ERR(svn_fs_file_contents(&contents, root, full_path, pool));
+
+      /* Get to the start of the range without reconstructing the data
+         before it, as far as the FS allows. */
+      for (; length >= 0 && offset > 0; offset -= len)
+        {
+          len = offset > APR_SIZE_MAX ? APR_SIZE_MAX : (apr_size_t)offset;
+          SVN_CMD_ERR(svn_stream_skip(contents, len));
+        }
+    }
 
   /* Send successful command response with revision and props. */
   SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w((?c)r(!", "success",
@@ -1682,7 +1861,12 @@ get_file(svn_ra_svn_conn_t *conn,
       err = SVN_NO_ERROR;
       while (1)
         {
-          len = sizeof(buf);
+          apr_size_t requested = sizeof(buf);
+
+          if (length >= 0 && length < (svn_filesize_t)requested)
+            requested = (apr_size_t)length;
+
+          len = requested;
           err = svn_stream_read_full(contents, buf, &len);
           if (err)
             break;
@@ -1691,8 +1875,10 @@ get_file(svn_ra_svn_conn_t *conn,
               write_str.data = buf;
               write_str.len = len;
               SVN_ERR(svn_ra_svn__write_string(conn, pool, &write_str));
+              if (length >= 0)
+                length -= len;
             }
-          if (len < sizeof(buf))
+          if (len < requested || length == 0)
             {
               err = svn_stream_close(contents);
               break;
@@ -1711,6 +1897,179 @@ get_file(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+get_file(svn_ra_svn_conn_t *conn,
+         apr_pool_t *pool,
+         svn_ra_svn__list_t *params,
+         void *baton)
+{
+  server_baton_t *b = baton;
+  const char *path, *full_path, *canonical_path;
+  svn_revnum_t rev;
+  svn_boolean_t want_props, want_contents;
+  apr_uint64_t wants_inherited_props;
+
+  /* Parse arguments. */
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "c(?r)bb?B", &path, &rev,
+                                  &want_props, &want_contents,
+                                  &wants_inherited_props));
+
+  if (wants_inherited_props == SVN_RA_SVN_UNSPECIFIED_NUMBER)
+    wants_inherited_props = FALSE;
+
+  SVN_ERR(svn_relpath_canonicalize_safe(&canonical_path, NULL, path, pool,
+                                        pool));
+  full_path = svn_fspath__join(b->repository->fs_path->data, canonical_path,
+                               pool);
+
+  /* Check authorizations */
+  SVN_ERR(must_have_access(conn, pool, b, svn_authz_read,
+                           full_path, FALSE));
+
+  if (!SVN_IS_VALID_REVNUM(rev))
+    SVN_CMD_ERR(svn_fs_youngest_rev(&rev, b->repository->fs, pool));
+
+  SVN_ERR(log_command(b, conn, pool, "%s",
+                      svn_log__get_file(full_path, rev,
+                                        want_contents, want_props, pool)));
+
+  return svn_error_trace(send_file(conn, pool, b, full_path, rev,
+                                   want_props, want_contents,
+                                   (svn_boolean_t)wants_inherited_props,
+                                   0, -1));
+}
+
+static svn_error_t *
+get_file_range(svn_ra_svn_conn_t *conn,
+               apr_pool_t *pool,
+               svn_ra_svn__list_t *params,
+               void *baton)
+{
+  server_baton_t *b = baton;
+  const char *path, *full_path, *canonical_path;
+  svn_revnum_t rev;
+  svn_boolean_t want_props;
+  apr_uint64_t offset, length;
+
+  /* Parse arguments. */
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "c(?r)bnn", &path, &rev,
+                                  &want_props, &offset, &length));
+
+  if (offset > (apr_uint64_t)APR_INT64_MAX
+      || length > (apr_uint64_t)APR_INT64_MAX)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("File range out of bounds"));
+
+  SVN_ERR(svn_relpath_canonicalize_safe(&canonical_path, NULL, path, pool,
+                                        pool));
+  full_path = svn_fspath__join(b->repository->fs_path->data, canonical_path,
+                               pool);
+
+  /* Check authorizations */
+  SVN_ERR(must_have_access(conn, pool, b, svn_authz_read,
+                           full_path, FALSE));
+
+  if (!SVN_IS_VALID_REVNUM(rev))
+    SVN_CMD_ERR(svn_fs_youngest_rev(&rev, b->repository->fs, pool));
+
+  SVN_ERR(log_command(b, conn, pool, "%s",
+                      svn_log__get_file(full_path, rev,
+                                        TRUE, want_props, pool)));
+
+  return svn_error_trace(send_file(conn, pool, b, full_path, rev,
+                                   want_props, TRUE, FALSE,
+                                   (svn_filesize_t)offset,
+                                   (svn_filesize_t)length));
+}
+
+static svn_error_t *
+get_files(svn_ra_svn_conn_t *conn,
+          apr_pool_t *pool,
+          svn_ra_svn__list_t *params,
+          void *baton)
+{
+  server_baton_t *b = baton;
+  svn_ra_svn__list_t *files;
+  svn_boolean_t want_props, want_contents;
+  svn_revnum_t youngest = SVN_INVALID_REVNUM;
+  const char **full_paths;
+  svn_revnum_t *revs;
+  apr_pool_t *iterpool;
+  int i;
+
+  /* Parse arguments. */
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "lbb", &files,
+                                  &want_props, &want_contents));
+
+  full_paths = apr_palloc(pool, files->nelts * sizeof(*full_paths));
+  revs = apr_palloc(pool, files->nelts * sizeof(*revs));
+  for (i = 0; i < files->nelts; i++)
+    {
+      svn_ra_svn__item_t *elt = &SVN_RA_SVN__LIST_ITEM(files, i);
+      const char *path, *canonical_path;
+
+      if (elt->kind != SVN_RA_SVN_LIST)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("File entry not a list"));
+
+      SVN_ERR(svn_ra_svn__parse_tuple(&elt->u.list, "c(?r)",
+                                      &path, &revs[i]));
+      SVN_ERR(svn_relpath_canonicalize_safe(&canonical_path, NULL, path,
+                                            pool, pool));
+      full_paths[i] = svn_fspath__join(b->repository->fs_path->data,
+                                       canonical_path, pool);
+    }
+
+  /* Only blanket access gets checked here, because the client may already
+     have sent its next request and cannot answer an auth request for the
+     individual paths.  Those get checked as we go. */
+  SVN_ERR(must_have_access(conn, pool, b, svn_authz_read, NULL, FALSE));
+
+  SVN_ERR(log_command(b, conn, pool, "get-files %d", files->nelts));
+
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < files->nelts; i++)
+    {
+      svn_revnum_t rev = revs[i];
+      svn_boolean_t allowed;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      /* A failure to send one file gets reported in its place, then we
+         continue with the next one. */
+      err = authz_check_access(&allowed, full_paths[i], svn_authz_read, b,
+                               iterpool);
+      if (!err && !allowed)
+        err = error_create_and_log(SVN_ERR_RA_NOT_AUTHORIZED, NULL, NULL, b);
+      if (!err && !SVN_IS_VALID_REVNUM(rev))
+        {
+          if (!SVN_IS_VALID_REVNUM(youngest))
+            err = svn_fs_youngest_rev(&youngest, b->repository->fs, pool);
+          rev = youngest;
+        }
+      if (err)
+        err = svn_error_create(SVN_ERR_RA_SVN_CMD_ERR, err, NULL);
+      else
+        err = send_file(conn, iterpool, b, full_paths[i], rev,
+                        want_props, want_contents, FALSE, 0, -1);
+
+      if (err && err->apr_err == SVN_ERR_RA_SVN_CMD_ERR)
+        {
+          svn_error_t *write_err
+            = svn_ra_svn__write_cmd_failure(conn, iterpool, err->child);
+
+          svn_error_clear(err);
+          SVN_ERR(write_err);
+        }
+      else
+        SVN_ERR(err);
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Translate all the words in DIRENT_FIELDS_LIST into the flags in
  * DIRENT_FIELDS_P.  If DIRENT_FIELDS_LIST is NULL, set all flags. */
 static svn_error_t *
@@ -3515,16 +3874,65 @@ replay(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+/* Baton for replay_range_revstart() and replay_range_revfinish(). */
+typedef struct replay_range_baton_t
+{
+  svn_ra_svn_conn_t *conn;
+  server_baton_t *server;
+} replay_range_baton_t;
+
+/* Implements svn_repos_replay_revstart_func_t.
+   Send the REV_PROPS of REVISION and return an editor that sends the
+   changes over the connection in the replay_range_baton_t REPLAY_BATON. */
+static svn_error_t *
+replay_range_revstart(svn_revnum_t revision,
+                      void *replay_baton,
+                      const svn_delta_editor_t **editor,
+                      void **edit_baton,
+                      apr_hash_t *rev_props,
+                      apr_pool_t *pool)
+{
+  replay_range_baton_t *rb = replay_baton;
+  svn_ra_svn_conn_t *conn = rb->conn;
+  server_baton_t *b = rb->server;
+
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w(!", "revprops"));
+  SVN_ERR(svn_ra_svn__write_proplist(conn, pool, rev_props));
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!)"));
+
+  SVN_ERR(log_command(b, conn, pool,
+                      svn_log__replay(b->repository->fs_path->data, revision,
+                                      pool)));
+
+  svn_ra_svn_get_editor(editor, edit_baton, conn, pool, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_replay_revfinish_func_t. */
+static svn_error_t *
+replay_range_revfinish(svn_revnum_t revision,
+                       void *replay_baton,
+                       const svn_delta_editor_t *editor,
+                       void *edit_baton,
+                       apr_hash_t *rev_props,
+                       apr_pool_t *pool)
+{
+  replay_range_baton_t *rb = replay_baton;
+
+  return svn_ra_svn__write_cmd_finish_replay(rb->conn, pool);
+}
+
 static svn_error_t *
 replay_range(svn_ra_svn_conn_t *conn,
              apr_pool_t *pool,
              svn_ra_svn__list_t *params,
              void *baton)
 {
-  svn_revnum_t start_rev, end_rev, rev, low_water_mark;
+  svn_revnum_t start_rev, end_rev, low_water_mark;
   svn_boolean_t send_deltas;
   server_baton_t *b = baton;
-  apr_pool_t *iterpool;
+  replay_range_baton_t rb;
   authz_baton_t ab;
 
   ab.server = b;
@@ -3536,27 +3944,17 @@ replay_range(svn_ra_svn_conn_t *conn,
 
   SVN_ERR(trivial_auth_request(conn, pool, b));
 
-  iterpool = svn_pool_create(pool);
-  for (rev = start_rev; rev <= end_rev; rev++)
-    {
-      apr_hash_t *props;
-
-      svn_pool_clear(iterpool);
-
-      SVN_CMD_ERR(svn_repos_fs_revision_proplist(&props,
-                                                 b->repository->repos, rev,
-                                                 authz_check_access_cb_func(b),
-                                                 &ab,
-                                                 iterpool));
-      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "w(!", "revprops"));
-      SVN_ERR(svn_ra_svn__write_proplist(conn, iterpool, props));
-      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "!)"));
-
-      SVN_ERR(replay_one_revision(conn, b, rev, low_water_mark,
-                                  send_deltas, iterpool));
-
-    }
-  svn_pool_destroy(iterpool);
+  /* Let the repository read ahead while we stream the revisions. */
+  rb.conn = conn;
+  rb.server = b;
+  SVN_CMD_ERR(svn_repos_replay_range(b->repository->repos,
+                                     start_rev, end_rev,
+                                     b->repository->fs_path->data,
+                                     low_water_mark, send_deltas,
+                                     replay_range_revstart,
+                                     replay_range_revfinish, &rb,
+                                     authz_check_access_cb_func(b), &ab,
+                                     NULL, NULL, pool));
 
   SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
 
@@ -3706,7 +4104,6 @@ list(svn_ra_svn_conn_t *conn,
   apr_array_header_t *patterns = NULL;
   svn_fs_root_t *root;
   const char *depth_word;
-  svn_boolean_t path_info_only;
   svn_ra_svn__list_t *dirent_fields_list = NULL;
   svn_ra_svn__list_t *patterns_list = NULL;
   int i;
@@ -3762,10 +4159,9 @@ list(svn_ra_svn_conn_t *conn,
   SVN_CMD_ERR(svn_fs_revision_root(&root, b->repository->fs, rev, pool));
 
   /* Fetch the directory entries if requested and send them immediately. */
-  path_info_only = (rb.dirent_fields & ~SVN_DIRENT_KIND) == 0;
-  err = svn_repos_list(root, full_path, patterns, depth, path_info_only,
-                       authz_check_access_cb_func(b), &ab, list_receiver,
-                       &rb, NULL, NULL, pool);
+  err = svn_repos_list2(root, full_path, patterns, depth, rb.dirent_fields,
+                        authz_check_access_cb_func(b), &ab, list_receiver,
+                        &rb, NULL, NULL, pool);
 
 
   /* Finish response. */
@@ -3790,6 +4186,8 @@ static const svn_ra_svn__cmd_entry_t main_commands[] = {
   { "rev-prop",        rev_prop },
   { "commit",          commit },
   { "get-file",        get_file },
+  { "get-files",       get_files },
+  { "get-file-range",  get_file_range },
   { "get-dir",         get_dir },
   { "update",          update },
   { "switch",          switch_cmd },
@@ -3868,12 +4266,266 @@ repos_path_valid(const char *path)
   return TRUE;
 }
 
+/* Keep at most this many idle handles per repository in a repos_cache_t.
+ * That is enough to serve bursts of short connections from build farms
+ * without keeping the memory of past bursts around forever. */
+#define REPOS_CACHE_MAX_IDLE 16
+
+/* An idle repository handle in a repos_cache_t. */
+typedef struct cached_repos_t
+{
+  /* The open repository, allocated in POOL. */
+  svn_repos_t *repos;
+
+  /* Identity of the repository's db/format file when REPOS got opened.
+     A different one means that the repository got replaced or upgraded. */
+  apr_finfo_t format_info;
+
+  /* Root pool owning this structure. */
+  apr_pool_t *pool;
+
+  /* Next idle handle for the same repository. */
+  struct cached_repos_t *next;
+} cached_repos_t;
+
+/* The idle handles for one repository in a repos_cache_t. */
+typedef struct idle_repos_t
+{
+  /* Chain of idle handles, may be NULL. */
+  cached_repos_t *first;
+
+  /* Number of handles in FIRST. */
+  int count;
+} idle_repos_t;
+
+struct repos_cache_t
+{
+  /* Serializes all access to IDLE. */
+  svn_mutex__t *mutex;
+
+  /* Repository root path -> idle_repos_t *.  Entries never get removed.
+     Both keys and values are allocated in POOL. */
+  apr_hash_t *idle;
+
+  /* Pool owning this structure. */
+  apr_pool_t *pool;
+};
+
+/* Baton for release_repos. */
+typedef struct release_repos_baton_t
+{
+  repos_cache_t *cache;
+  cached_repos_t *handle;
+  const char *repos_root;
+} release_repos_baton_t;
+
+svn_error_t *
+repos_cache_create(repos_cache_t **cache,
+                   svn_boolean_t thread_safe,
+                   apr_pool_t *pool)
+{
+  repos_cache_t *result = apr_pcalloc(pool, sizeof(*result));
+
+  SVN_ERR(svn_mutex__init(&result->mutex, thread_safe, pool));
+  result->idle = svn_hash__make(pool);
+  result->pool = pool;
+
+  *cache = result;
+  return SVN_NO_ERROR;
+}
+
+/* Set *FORMAT_INFO to the identity of the db/format file of the
+ * repository at REPOS_ROOT.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+stat_repos_format(apr_finfo_t *format_info,
+                  const char *repos_root,
+                  apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_io_stat(format_info,
+                                     svn_dirent_join_many(scratch_pool,
+                                                          repos_root,
+                                                          "db", "format",
+                                                          SVN_VA_NULL),
+                                     APR_FINFO_IDENT | APR_FINFO_MTIME,
+                                     scratch_pool));
+}
+
+/* Take the first idle handle for REPOS_ROOT that matches FORMAT_INFO out
+ * of CACHE and return it in *HANDLE.  Set *HANDLE to NULL if there is
+ * none.  Move all outdated handles to *STALE.
+ *
+ * Requires external serialization on CACHE.
+ */
+static svn_error_t *
+take_idle_repos(cached_repos_t **handle,
+                cached_repos_t **stale,
+                repos_cache_t *cache,
+                const char *repos_root,
+                const apr_finfo_t *format_info)
+{
+  idle_repos_t *idle = svn_hash_gets(cache->idle, repos_root);
+
+  *handle = NULL;
+  while (idle && idle->first && !*handle)
+    {
+      cached_repos_t *first = idle->first;
+
+      idle->first = first->next;
+      idle->count--;
+
+      if (   first->format_info.inode == format_info->inode
+          && first->format_info.device == format_info->device
+          && first->format_info.mtime == format_info->mtime)
+        {
+          first->next = NULL;
+          *handle = first;
+        }
+      else
+        {
+          first->next = *stale;
+          *stale = first;
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return HANDLE for REPOS_ROOT to CACHE unless there are enough idle
+ * handles already.  In that case, set *STALE to HANDLE.
+ *
+ * Requires external serialization on CACHE.
+ */
+static svn_error_t *
+put_idle_repos(cached_repos_t **stale,
+               repos_cache_t *cache,
+               const char *repos_root,
+               cached_repos_t *handle)
+{
+  idle_repos_t *idle = svn_hash_gets(cache->idle, repos_root);
+
+  if (!idle)
+    {
+      idle = apr_pcalloc(cache->pool, sizeof(*idle));
+      svn_hash_sets(cache->idle, apr_pstrdup(cache->pool, repos_root),
+                    idle);
+    }
+
+  if (idle->count < REPOS_CACHE_MAX_IDLE)
+    {
+      handle->next = idle->first;
+      idle->first = handle;
+      idle->count++;
+    }
+  else
+    {
+      *stale = handle;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Destroy all handles in the chain STALE. */
+static void
+destroy_repos_handles(cached_repos_t *stale)
+{
+  while (stale)
+    {
+      cached_repos_t *next = stale->next;
+      svn_pool_destroy(stale->pool);
+      stale = next;
+    }
+}
+
+/* Pool cleanup handler returning the repository handle in the
+ * release_repos_baton_t DATA to its cache. */
+static apr_status_t
+release_repos(void *data)
+{
+  release_repos_baton_t *baton = data;
+  cached_repos_t *stale = NULL;
+  svn_error_t *err;
+
+  /* Don't keep pointers into the connection's pools around. */
+  err = svn_repos_remember_client_capabilities(baton->handle->repos, NULL);
+  if (!err)
+    SVN_MUTEX__WITH_LOCK(baton->cache->mutex,
+                         put_idle_repos(&stale, baton->cache,
+                                        baton->repos_root, baton->handle));
+  else
+    stale = baton->handle;
+
+  svn_error_clear(err);
+  destroy_repos_handles(stale);
+
+  return APR_SUCCESS;
+}
+
+/* Open the repository at REPOS_ROOT with FS_CONFIG and return it in
+ * *REPOS.  If CACHE is not NULL, reuse an idle handle from it if there
+ * is one and hand the repository back to CACHE once RESULT_POOL gets
+ * cleaned up.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+open_repos(svn_repos_t **repos,
+           repos_cache_t *cache,
+           const char *repos_root,
+           apr_hash_t *fs_config,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  cached_repos_t *handle = NULL;
+  cached_repos_t *stale = NULL;
+  apr_finfo_t format_info;
+  release_repos_baton_t *baton;
+  svn_error_t *err;
+
+  if (!cache)
+    return svn_error_trace(svn_repos_open3(repos, repos_root, fs_config,
+                                           result_pool, scratch_pool));
+
+  SVN_ERR(stat_repos_format(&format_info, repos_root, scratch_pool));
+  SVN_MUTEX__WITH_LOCK(cache->mutex,
+                       take_idle_repos(&handle, &stale, cache, repos_root,
+                                       &format_info));
+  destroy_repos_handles(stale);
+
+  if (!handle)
+    {
+      apr_pool_t *pool
+        = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+      handle = apr_pcalloc(pool, sizeof(*handle));
+      handle->pool = pool;
+      handle->format_info = format_info;
+
+      err = svn_repos_open3(&handle->repos, repos_root, fs_config, pool,
+                            scratch_pool);
+      if (err)
+        {
+          svn_pool_destroy(pool);
+          return svn_error_trace(err);
+        }
+    }
+
+  baton = apr_palloc(result_pool, sizeof(*baton));
+  baton->cache = cache;
+  baton->handle = handle;
+  baton->repos_root = apr_pstrdup(result_pool, repos_root);
+  apr_pool_cleanup_register(result_pool, baton, release_repos,
+                            apr_pool_cleanup_null);
+
+  *repos = handle->repos;
+  return SVN_NO_ERROR;
+}
+
 /* Look for the repository given by URL, using ROOT as the virtual
  * repository root.  If we find one, fill in the repos, fs, repos_url,
  * and fs_path fields of REPOSITORY.  VHOST and READ_ONLY flags are the
  * same as in the server baton.
  *
- * CONFIG_POOL shall be used to load config objects.
+ * CONFIG_POOL shall be used to load config objects.  Reuse idle repository
+ * handles from REPOS_CACHE, if not NULL.
  *
  * Use SCRATCH_POOL for temporary allocations.
  *
@@ -3886,6 +4538,7 @@ find_repos(const char *url,
            svn_config_t *cfg,
            repository_t *repository,
            svn_repos__config_pool_t *config_pool,
+           repos_cache_t *repos_cache,
            apr_hash_t *fs_config,
            svn_repos_authz_warning_func_t authz_warning_func,
            void *authz_warning_baton,
@@ -3896,6 +4549,7 @@ find_repos(const char *url,
   const char *canonical_root;
   svn_stringbuf_t *url_buf;
   svn_boolean_t sasl_requested;
+  apr_int64_t ticket_lifetime;
 
   /* Skip past the scheme and authority part. */
   path = skip_scheme_part(url);
@@ -3931,8 +4585,9 @@ find_repos(const char *url,
                              "No repository found in '%s'", url);
 
   /* Open the repository and fill in b with the resulting information. */
-  SVN_ERR(svn_repos_open3(&repository->repos, repository->repos_root,
-                          fs_config, result_pool, scratch_pool));
+  SVN_ERR(open_repos(&repository->repos, repos_cache,
+                     repository->repos_root, fs_config, result_pool,
+                     scratch_pool));
   SVN_ERR(svn_repos_remember_client_capabilities(repository->repos,
                                                  repository->capabilities));
   repository->fs = svn_repos_fs(repository->repos);
@@ -4003,6 +4658,12 @@ find_repos(const char *url,
       repository->use_sasl = FALSE;
     }
 
+  /* Auth tickets are off unless they get a lifetime. */
+  SVN_ERR(svn_config_get_int64(cfg, &ticket_lifetime,
+                               SVN_CONFIG_SECTION_GENERAL,
+                               SVN_CONFIG_OPTION_AUTH_TICKET_LIFETIME, 0));
+  repository->ticket_lifetime = apr_time_from_sec(ticket_lifetime);
+
   /* Use the repository UUID as the default realm. */
   SVN_ERR(svn_fs_get_uuid(repository->fs, &repository->realm, scratch_pool));
   svn_config_get(cfg, &repository->realm, SVN_CONFIG_SECTION_GENERAL,
@@ -4239,7 +4900,7 @@ construct_server_baton(server_baton_t **baton,
    * send an empty mechlist. */
   if (params->compression_level > 0)
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwwwwwww?w)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_SVNDIFF1,
@@ -4253,11 +4914,17 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_GET_FILES,
+                                           SVN_RA_SVN_CAP_GET_FILE_RANGE,
+                                           SVN_RA_SVN_CAP_COMPRESS_STREAM,
+                                           svn__zstd_available()
+                                             ? SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED
+                                             : NULL
                                            ));
   else
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwwww)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_ABSENT_ENTRIES,
@@ -4269,7 +4936,9 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_GET_FILES,
+                                           SVN_RA_SVN_CAP_GET_FILE_RANGE
                                            ));
 
   /* Read client response, which we assume to be in version 2 format:
@@ -4336,6 +5005,7 @@ construct_server_baton(server_baton_t **baton,
   err = handle_config_error(find_repos(client_url, params->root, b->vhost,
                                        b->read_only, params->cfg,
                                        b->repository, params->config_pool,
+                                       params->repos_cache,
                                        params->fs_config,
                                        handle_authz_warning, b,
                                        conn_pool, scratch_pool),
@@ -4352,6 +5022,9 @@ construct_server_baton(server_baton_t **baton,
     }
   if (!err)
     {
+      if (b->repository->ticket_lifetime > 0)
+        b->repository->ticket_key = params->auth_ticket_key;
+
       SVN_ERR(auth_request(conn, scratch_pool, b, READ_ACCESS, FALSE));
       if (current_access(b) == NO_ACCESS)
         err = error_create_and_log(SVN_ERR_RA_NOT_AUTHORIZED, NULL,
@@ -4378,21 +5051,34 @@ construct_server_baton(server_baton_t **baton,
      the client has sent the url. */
   {
     svn_boolean_t supports_mergeinfo;
+    const char *ticket = NULL;
     SVN_ERR(svn_repos_has_capability(b->repository->repos,
                                      &supports_mergeinfo,
                                      SVN_REPOS_CAPABILITY_MERGEINFO,
                                      scratch_pool));
 
+    /* Let a client that had to authenticate in full skip that on its
+       next connections.  Tickets are not renewed when used, so every
+       client will authenticate in full once per ticket lifetime. */
+    if (b->client_info->user && !b->client_info->ticket_auth
+        && auth_ticket_usable(conn, b, READ_ACCESS))
+      ticket = make_auth_ticket(b, scratch_pool);
+
     SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "w(cc(!",
                                     "success", b->repository->uuid,
                                     b->repository->repos_url));
     if (supports_mergeinfo)
       SVN_ERR(svn_ra_svn__write_word(conn, scratch_pool,
                                      SVN_RA_SVN_CAP_MERGEINFO));
-    SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "!))"));
+    SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "!)?c)", ticket));
     SVN_ERR(svn_ra_svn__flush(conn, scratch_pool));
   }
 
+  /* The client switches to compression after reading repos-info. */
+  if (params->compression_level > 0
+      && svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_COMPRESS_STREAM))
+    SVN_ERR(svn_ra_svn__enable_stream_compression(conn, scratch_pool));
+
   /* Log the open. */
   if (ra_client_string == NULL || ra_client_string[0] == '\0')
     ra_client_string = "-";
@@ -4432,6 +5118,38 @@ construct_server_baton(server_baton_t **baton,
   return SVN_NO_ERROR;
 }
 
+/* Handle the next command on CONNECTION according to CMD_HASH, see
+ * svn_ra_svn__handle_command(), and add it to the per-command statistics.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+handle_command(svn_boolean_t *terminate,
+               connection_t *connection,
+               apr_hash_t *cmd_hash,
+               apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__command_stats_t stats;
+  metrics_t *metrics = connection->params->metrics;
+  apr_uint64_t pool_bytes = 0;
+  svn_error_t *err;
+
+  err = svn_ra_svn__handle_command(terminate, metrics ? &stats : NULL,
+                                   cmd_hash, connection->baton,
+                                   connection->conn, FALSE, scratch_pool);
+
+#if APR_POOL_DEBUG
+  /* Only pool debugging builds can tell how much memory a pool holds. */
+  if (metrics)
+    pool_bytes = apr_pool_num_bytes(scratch_pool, TRUE);
+#endif
+
+  if (metrics && stats.cmdname)
+    metrics__record(metrics, &stats,
+                    svn_hash_gets(cmd_hash, stats.cmdname) != NULL,
+                    pool_bytes, scratch_pool);
+
+  return svn_error_trace(err);
+}
+
 svn_error_t *
 serve_interruptable(svn_boolean_t *terminate_p,
                     connection_t *connection,
@@ -4500,10 +5218,11 @@ serve_interruptable(svn_boolean_t *terminate_p,
           err = svn_ra_svn__has_command(&has_command, &terminate,
                                         connection->conn, iterpool);
           if (!err && has_command)
-            err = svn_ra_svn__handle_command(&terminate, cmd_hash,
-                                             connection->baton,
-                                             connection->conn,
-                                             FALSE, iterpool);
+            err = handle_command(&terminate, connection, cmd_hash,
+                                 iterpool);
+          if (!err && connection->params->fsfs_access_trace > 0)
+            err = log_access_trace(connection->baton, connection->conn,
+                                   iterpool);
 
           break;
         }
@@ -4514,14 +5233,19 @@ serve_interruptable(svn_boolean_t *terminate_p,
            * busy() callback test to return TRUE while there are still some
            * resources left.
            */
-          err = svn_ra_svn__handle_command(&terminate, cmd_hash,
-                                           connection->baton,
-                                           connection->conn,
-                                           FALSE, iterpool);
+          err = handle_command(&terminate, connection, cmd_hash, iterpool);
+          if (!err && connection->params->fsfs_access_trace > 0)
+            err = log_access_trace(connection->baton, connection->conn,
+                                   iterpool);
         }
     }
 
   /* error or normal end of session. Close the connection */
+  if (terminate && connection->baton)
+    err = svn_error_compose_create(err,
+                                   log_compression_stats(connection->baton,
+                                                         connection->conn,
+                                                         iterpool));
   svn_pool_destroy(iterpool);
   if (terminate_p)
     *terminate_p = terminate;
@@ -4536,5 +5260,8 @@ svn_error_t *serve(svn_ra_svn_conn_t *conn,
   server_baton_t *baton = NULL;
 
   SVN_ERR(construct_server_baton(&baton, conn, params, pool));
-  return svn_ra_svn__handle_commands2(conn, pool, main_commands, baton, FALSE);
+  SVN_ERR(svn_ra_svn__handle_commands2(conn, pool, main_commands, baton,
+                                       FALSE));
+
+  return svn_error_trace(log_compression_stats(baton, conn, pool));
 }
@@ -27,6 +27,7 @@
 #define SERVER_H
 
 #include <apr_network_io.h>
+#include <apr_poll.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -73,6 +74,10 @@ typedef struct repository_t {
   enum access_type auth_access; /* access granted to authenticated users */
   enum access_type anon_access; /* access granted to anonymous users */
 
+  const char *ticket_key;  /* Key to sign auth tickets with or NULL if
+                              auth tickets are disabled */
+  apr_interval_time_t ticket_lifetime; /* Validity of new auth tickets */
+
 } repository_t;
 
 typedef struct client_info_t {
@@ -81,6 +86,7 @@ typedef struct client_info_t {
   const char *authz_user;  /* Username for authz ('user' + 'username_case') */
   svn_boolean_t tunnel;    /* Tunneled through login agent */
   const char *tunnel_user; /* Allow EXTERNAL to authenticate as this */
+  svn_boolean_t ticket_auth; /* 'user' was authenticated by an auth ticket */
 } client_info_t;
 
 typedef struct server_baton_t {
@@ -127,6 +133,12 @@ typedef struct serve_params_t {
   /* all configurations should be opened through this factory */
   svn_repos__config_pool_t *config_pool;
 
+  /* Idle repository handles to reuse for new connections; may be NULL. */
+  struct repos_cache_t *repos_cache;
+
+  /* Per-command statistics to record; may be NULL. */
+  struct metrics_t *metrics;
+
   /* The FS configuration to be applied to all repositories.
      It mainly contains things like cache settings. */
   apr_hash_t *fs_config;
@@ -159,6 +171,15 @@ typedef struct serve_params_t {
 
   /* Use virtual-host-based path to repo. */
   svn_boolean_t vhost;
+
+  /* Key to sign auth tickets with.  It is shared by all connections of
+     the listening process, so that a ticket issued on one connection
+     is accepted by any other.  NULL if no tickets shall be issued. */
+  const char *auth_ticket_key;
+
+  /* Capacity of the FSFS access trace.  If not 0, all item accesses
+     will be recorded and written to the log after each command. */
+  int fsfs_access_trace;
 } serve_params_t;
 
 /* This structure contains all data that describes a client / server
@@ -181,6 +202,18 @@ typedef struct connection_t
   /* memory pool for objects with connection lifetime */
   apr_pool_t *pool;
 
+  /* poll set entry while the connection waits for its next command
+     (svnserve --park-idle) */
+  apr_pollfd_t pollfd;
+
+  /* With svnserve --max-client-threads, the client that the connection's
+     current turn in the thread pool is accounted to, see set_client_key(),
+     when it started to wait for a free slot of that client, and the next
+     connection of that client waiting for one. */
+  svn_stringbuf_t *client_key;
+  apr_time_t queued_since;
+  struct connection_t *next_waiting;
+
   /* Number of threads using the pool.
      The pool passed to apr_thread_create can only be released when both
 
@@ -194,6 +227,16 @@ typedef struct connection_t
 
 } connection_t;
 
+/* Process-wide cache of idle repository handles. */
+typedef struct repos_cache_t repos_cache_t;
+
+/* Create an empty repository handle cache in POOL and return it in
+ * *CACHE.  If THREAD_SAFE is set, the cache may be used by multiple
+ * connection threads concurrently. */
+svn_error_t *repos_cache_create(repos_cache_t **cache,
+                                svn_boolean_t thread_safe,
+                                apr_pool_t *pool);
+
 /* Return a client_info_t structure allocated in POOL and initialize it
  * with data from CONN. */
 client_info_t * get_client_info(svn_ra_svn_conn_t *conn,
@@ -231,6 +274,22 @@ svn_error_t *cyrus_auth_request(svn_ra_svn_conn_t *conn,
                                 enum access_type required,
                                 svn_boolean_t needs_username);
 
+/* Return TRUE if the client on CONN may authenticate with an auth ticket
+   to get the REQUIRED access to the repository in B. */
+svn_boolean_t auth_ticket_usable(svn_ra_svn_conn_t *conn,
+                                 server_baton_t *b,
+                                 enum access_type required);
+
+/* Authenticate the client on CONN with the auth ticket TICKET, which may
+   be NULL, and report the outcome to the client.  On success, set
+   *SUCCESS to TRUE and the user in B to the one the ticket was issued to.
+   Otherwise, set *SUCCESS to FALSE.  Use POOL for temporary allocations. */
+svn_error_t *auth_with_ticket(svn_boolean_t *success,
+                              svn_ra_svn_conn_t *conn,
+                              const char *ticket,
+                              server_baton_t *b,
+                              apr_pool_t *pool);
+
 /* Escape SOURCE into DEST where SOURCE is null-terminated and DEST is
    size BUFLEN DEST will be null-terminated.  Returns number of bytes
    written, including terminating null byte. */
@@ -49,18 +49,22 @@
 #include "svn_version.h"
 #include "svn_io.h"
 #include "svn_hash.h"
+#include "svn_checksum.h"
 
 #include "svn_private_config.h"
 
 #include "private/svn_dep_compat.h"
 #include "private/svn_cmdline_private.h"
 #include "private/svn_atomic.h"
+#include "private/svn_cache.h"
 #include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_fs_fs_private.h"
 
 #if APR_HAS_THREADS
 #    include <apr_thread_pool.h>
 #endif
+#include <apr_poll.h>
 
 #include "winservice.h"
 
@@ -70,6 +74,7 @@
 
 #include "server.h"
 #include "logger.h"
+#include "metrics.h"
 
 /* The strategy for handling incoming connections.  Some of these may be
    unavailable due to platform limitations. */
@@ -145,6 +150,18 @@ enum run_mode {
  */
 #define THREADPOOL_THREAD_IDLE_LIMIT 1000000
 
+/* Maximum number of idle connections that a single poll for incoming
+ * commands may report when running with --park-idle.  This does not limit
+ * the number of parked connections, only how many we dispatch at once.
+ */
+#define PARKED_POLL_BATCH 1024
+
+/* Minimum number of microseconds between two reports on connections that
+ * had to wait for a thread because their client reached the limit set with
+ * --max-client-threads.  Nothing gets reported while no one is waiting.
+ */
+#define ADMISSION_REPORT_INTERVAL (60 * APR_USEC_PER_SEC)
+
 /* Number of client to server connections that may concurrently in the
  * TCP 3-way handshake state, i.e. are in the process of being created.
  *
@@ -222,6 +239,16 @@ void winservice_notify_stop(void)
 #define SVNSERVE_OPT_MAX_REQUEST     274
 #define SVNSERVE_OPT_MAX_RESPONSE    275
 #define SVNSERVE_OPT_CACHE_NODEPROPS 276
+#define SVNSERVE_OPT_FSFS_ACCESS_TRACE 277
+#define SVNSERVE_OPT_CACHE_PARTITIONS 278
+#define SVNSERVE_OPT_CACHE_SHM       279
+#define SVNSERVE_OPT_CACHE_SNAPSHOT  280
+#define SVNSERVE_OPT_CACHE_STATS     281
+#define SVNSERVE_OPT_CACHE_ADMISSION 282
+#define SVNSERVE_OPT_PARK_IDLE       283
+#define SVNSERVE_OPT_MAX_CLIENT_THREADS 284
+#define SVNSERVE_OPT_COMMAND_STATS   285
+#define SVNSERVE_OPT_COMMAND_STATS_FILE 286
 
 /* Text macro because we can't use #ifdef sections inside a N_("...")
    macro expansion. */
@@ -325,6 +352,56 @@ static const apr_getopt_option_t svnserve__options[] =
         "Default is yes.\n"
         "                             "
         "[used for FSFS repositories only]")},
+    {"cache-partitions", SVNSERVE_OPT_CACHE_PARTITIONS, 1,
+     N_("split the in-memory cache into ARG partitions,\n"
+        "                             "
+        "one per NUMA node, and serve lookups from the\n"
+        "                             "
+        "partition local to the requesting thread first.\n"
+        "                             "
+        "Default is 1 (no partitioning).\n"
+        "                             "
+        "[used for FSFS and FSX repositories only]")},
+    {"cache-shm", SVNSERVE_OPT_CACHE_SHM, 1,
+     N_("place the in-memory cache into the shared memory\n"
+        "                             "
+        "segment named ARG such that all processes forked\n"
+        "                             "
+        "for client connections share the same cache.\n"
+        "                             "
+        "Any existing segment of that name gets replaced.\n"
+        "                             "
+        "[used for FSFS and FSX repositories only]")},
+    {"cache-snapshot", SVNSERVE_OPT_CACHE_SNAPSHOT, 1,
+     N_("load the in-memory cache contents from file ARG\n"
+        "                             "
+        "at startup and write them back to it when\n"
+        "                             "
+        "terminated by SIGTERM or SIGINT.  Entries written\n"
+        "                             "
+        "by a different Subversion version are ignored.\n"
+        "                             "
+        "[used for FSFS and FSX repositories only]")},
+    {"cache-stats", SVNSERVE_OPT_CACHE_STATS, 0,
+     N_("write the in-memory cache statistics per type of\n"
+        "                             "
+        "cached data and per quota group to the log file\n"
+        "                             "
+        "upon SIGUSR1.  In fork mode, only the accesses\n"
+        "                             "
+        "made by the listener process itself are shown.\n"
+        "                             "
+        "[used for FSFS and FSX repositories only]")},
+    {"cache-admission-filter", SVNSERVE_OPT_CACHE_ADMISSION, 0,
+     N_("cache large items only if they are being requested\n"
+        "                             "
+        "more often than the data they would replace.\n"
+        "                             "
+        "Protects the cache against one-off requests like\n"
+        "                             "
+        "exports of large trees.\n"
+        "                             "
+        "[used for FSFS and FSX repositories only]")},
     {"client-speed", SVNSERVE_OPT_CLIENT_SPEED, 1,
      N_("Optimize network handling based on the assumption\n"
         "                             "
@@ -341,6 +418,18 @@ static const apr_getopt_option_t svnserve__options[] =
         "Default is no.\n"
         "                             "
         "[used for FSFS repositories in 1.9 format only]")},
+    {"fsfs-access-trace", SVNSERVE_OPT_FSFS_ACCESS_TRACE, 1,
+     N_("Record up to ARG recent FSFS item reads, their\n"
+        "                             "
+        "offsets, sizes and latencies and whether they were\n"
+        "                             "
+        "served from cache.  The records are written to the\n"
+        "                             "
+        "log after each command.\n"
+        "                             "
+        "Default is 0 (disabled).\n"
+        "                             "
+        "[used for FSFS repositories only]")},
 #ifdef CONNECTION_HAVE_THREAD_OPTION
     /* ### Making the assumption here that WIN32 never has fork and so
      * ### this option never exists when --service exists. */
@@ -362,6 +451,37 @@ static const apr_getopt_option_t svnserve__options[] =
         "                             "
         "Default is " APR_STRINGIFY(THREADPOOL_MAX_SIZE) "."
         ONLY_AVAILABLE_WITH_THEADS)},
+    {"park-idle",        SVNSERVE_OPT_PARK_IDLE, 0,
+     N_("Don't block a server thread on connections that\n"
+        "                             "
+        "wait for the client's next command.  Wait for\n"
+        "                             "
+        "them in the system's event poll set (e.g. epoll\n"
+        "                             "
+        "or kqueue) instead and serve their commands in\n"
+        "                             "
+        "the thread pool.  Allows for many more concurrent\n"
+        "                             "
+        "connections than there are server threads."
+        ONLY_AVAILABLE_WITH_THEADS)},
+    {"max-client-threads", SVNSERVE_OPT_MAX_CLIENT_THREADS, 1,
+     N_("Maximum number of server threads that the
+"
+        "                             "
+        "connections of a single user (or client host,
+"
+        "                             "
+        "before authentication) may occupy at once.
+"
+        "                             "
+        "Further connections of that client wait for one
+"
+        "                             "
+        "of them while other clients get served.  Works
+"
+        "                             "
+        "best with --park-idle.  Default is 0 (no limit)."
+        ONLY_AVAILABLE_WITH_THEADS)},
 #endif
     {"max-request-size", SVNSERVE_OPT_MAX_REQUEST, 1,
      N_("Maximum acceptable size of a client request in MB.\n"
@@ -396,6 +516,24 @@ static const apr_getopt_option_t svnserve__options[] =
         "process (useful for debugging)")},
     {"log-file",         SVNSERVE_OPT_LOG_FILE, 1,
      N_("svnserve log file")},
+    {"command-stats",    SVNSERVE_OPT_COMMAND_STATS, 1,
+     N_("write the number, latency histogram and traffic\n"
+        "                             "
+        "of the commands handled per command type to the\n"
+        "                             "
+        "log file every ARG seconds.\n"
+        "                             "
+        "[mode: daemon with --threads or --single-thread,\n"
+        "                             "
+        "listen-once]")},
+    {"command-stats-file", SVNSERVE_OPT_COMMAND_STATS_FILE, 1,
+     N_("with --command-stats, also replace file ARG with\n"
+        "                             "
+        "all command statistics collected so far, in the\n"
+        "                             "
+        "Prometheus text format (e.g. for the textfile\n"
+        "                             "
+        "collector of the Prometheus node exporter)")},
     {"pid-file",         SVNSERVE_OPT_PID_FILE, 1,
 #ifdef WIN32
      N_("write server process ID to file ARG\n"
@@ -492,6 +630,52 @@ static void sigchld_handler(int signo)
 }
 #endif
 
+/* Set by shutdown_handler() to make the main loop write the cache
+ * snapshot and exit. */
+static volatile sig_atomic_t shutdown_requested = FALSE;
+
+static void shutdown_handler(int signo)
+{
+  /* Let the accept() loop do the actual work. */
+  shutdown_requested = TRUE;
+}
+
+/* Set by stats_handler() to make the main loop log the cache statistics.
+ */
+static volatile sig_atomic_t stats_requested = FALSE;
+
+static void stats_handler(int signo)
+{
+  /* Let the accept() loop do the actual work. */
+  stats_requested = TRUE;
+}
+
+/* Write the per-prefix statistics and the quota group usage of the global
+ * membuffer cache to LOGGER.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+log_cache_stats(logger_t *logger,
+                apr_pool_t *scratch_pool)
+{
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  apr_array_header_t *stats;
+  svn_string_t *text;
+
+  if (!logger || !membuffer)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_cache__membuffer_get_prefix_stats(&stats, membuffer,
+                                                scratch_pool));
+  text = svn_cache__format_prefix_stats(stats, scratch_pool);
+  SVN_ERR(logger__write(logger, text->data, text->len));
+
+  SVN_ERR(svn_cache__membuffer_get_quota_stats(&stats, membuffer,
+                                               scratch_pool));
+  text = svn_cache__format_quota_stats(stats, scratch_pool);
+
+  return svn_error_trace(logger__write(logger, text->data, text->len));
+}
+
 /* Redirect stdout to stderr.  ARG is the pool.
  *
  * In tunnel or inetd mode, we don't want hook scripts corrupting the
@@ -530,9 +714,17 @@ accept_connection(connection_t **connection,
 
   /* Non-standard pool handling.  The main thread never blocks to join
    *         the connection threads so it cannot clean up after each one.  So
-   *         separate pools that can be cleared at thread exit are used. */
-
-  apr_pool_t *connection_pool = svn_pool_create(pool);
+   *         separate pools that can be cleared at thread exit are used.
+   *
+   * In threaded mode, every connection also gets an allocator of its own.
+   * Subpools of POOL would share its allocator, and all threads would
+   * contend for that allocator's mutex.  Only one thread at a time works
+   * on a connection, so its allocator needs no mutex. */
+
+  apr_pool_t *connection_pool
+    = handling_mode == connection_mode_thread
+    ? apr_allocator_owner_get(svn_pool_create_allocator(FALSE))
+    : svn_pool_create(pool);
   *connection = apr_pcalloc(connection_pool, sizeof(**connection));
   (*connection)->pool = connection_pool;
   (*connection)->params = params;
@@ -545,6 +737,19 @@ accept_connection(connection_t **connection,
         exit(0);
       #endif
 
+      if (shutdown_requested)
+        {
+          /* Caching is optional, so is the snapshot. */
+          svn_error_clear(svn_cache__save_global_membuffer(connection_pool));
+          exit(0);
+        }
+
+      if (stats_requested)
+        {
+          stats_requested = FALSE;
+          svn_error_clear(log_cache_stats(params->logger, connection_pool));
+        }
+
       status = apr_socket_accept(&(*connection)->usock, sock,
                                  connection_pool);
       if (handling_mode == connection_mode_fork)
@@ -614,6 +819,10 @@ static svn_root_pools__t *connection_pools;
 /* The global thread pool serving all connections. */
 static apr_thread_pool_t *threads;
 
+/* With --park-idle, the connections waiting for their next command.
+   NULL otherwise. */
+static apr_pollset_t *parked_connections;
+
 /* Very simple load determination callback for serve_interruptable:
    With less than half the threads in THREADS in use, we can afford to
    wait in the socket read() function.  Otherwise, poll them round-robin. */
@@ -624,9 +833,338 @@ is_busy(connection_t *connection)
        > apr_thread_pool_thread_max_get(threads);
 }
 
+/* Load determination callback for serve_interruptable when parking idle
+   connections:  Always serve just one command so that no thread ever
+   blocks waiting for a client to send its next one. */
+static svn_boolean_t
+serve_one_command(connection_t *connection)
+{
+  return TRUE;
+}
+
+static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data);
+
+/* With --max-client-threads, the number of connections per client that
+   may be in THREADS at the same time.  0 if there is no limit. */
+static int max_client_threads = 0;
+
+/* Admission state of a client with connections in THREADS. */
+typedef struct client_slots_t
+{
+  /* See set_client_key(). */
+  svn_stringbuf_t *key;
+
+  /* Number of this client's connections in THREADS. */
+  int active;
+
+  /* This client's connections waiting to be pushed to THREADS,
+     oldest first. */
+  connection_t *first_waiting;
+  connection_t *last_waiting;
+
+  /* Next unused entry, see FREE_CLIENTS. */
+  struct client_slots_t *next_free;
+} client_slots_t;
+
+/* The admission state of all clients with connections in THREADS,
+   indexed by client key, and unused entries for later reuse.  Both get
+   allocated in ADMISSION_POOL.  Access is serialized by ADMISSION_MUTEX,
+   as is access to ADMISSION_STATS. */
+static apr_hash_t *clients;
+static client_slots_t *free_clients;
+static apr_pool_t *admission_pool;
+static svn_mutex__t *admission_mutex;
+
+/* Statistics on connections that had to wait for a slot of their client
+   since the last report. */
+static struct admission_stats_t
+{
+  /* Currently waiting connections and their maximum number. */
+  apr_size_t waiting;
+  apr_size_t peak_waiting;
+
+  /* Number of connections that finished waiting and how long they
+     waited. */
+  apr_uint64_t delayed;
+  apr_time_t total_wait;
+  apr_time_t max_wait;
+
+  /* When we last wrote these statistics to the log. */
+  apr_time_t last_report;
+} admission_stats;
+
+/* Set CONNECTION's client key to the authenticated user name or, before
+   authentication, to the client's IP address. */
+static void
+set_client_key(connection_t *connection)
+{
+  if (!connection->client_key)
+    connection->client_key = svn_stringbuf_create_empty(connection->pool);
+
+  if (connection->baton && connection->baton->client_info->user)
+    {
+      svn_stringbuf_set(connection->client_key, "user ");
+      svn_stringbuf_appendcstr(connection->client_key,
+                               connection->baton->client_info->user);
+    }
+  else
+    {
+      char host[64] = "-";
+      apr_sockaddr_t *sa;
+
+      if (apr_socket_addr_get(&sa, APR_REMOTE, connection->usock) == 0)
+        apr_sockaddr_ip_getbuf(host, sizeof(host), sa);
+
+      svn_stringbuf_set(connection->client_key, "host ");
+      svn_stringbuf_appendcstr(connection->client_key, host);
+    }
+}
+
+/* Take a slot of CONNECTION's client and set *ADMITTED to TRUE.  If the
+   client has no free slot, queue CONNECTION and set *ADMITTED to FALSE.
+   Call with ADMISSION_MUTEX locked. */
+static svn_error_t *
+admit_connection(svn_boolean_t *admitted,
+                 connection_t *connection)
+{
+  client_slots_t *slots = svn_hash_gets(clients,
+                                        connection->client_key->data);
+  if (!slots)
+    {
+      if (free_clients)
+        {
+          slots = free_clients;
+          free_clients = slots->next_free;
+        }
+      else
+        {
+          slots = apr_pcalloc(admission_pool, sizeof(*slots));
+          slots->key = svn_stringbuf_create_empty(admission_pool);
+        }
+
+      svn_stringbuf_set(slots->key, connection->client_key->data);
+      svn_hash_sets(clients, slots->key->data, slots);
+    }
+
+  if (slots->active < max_client_threads)
+    {
+      slots->active++;
+      *admitted = TRUE;
+
+      return SVN_NO_ERROR;
+    }
+
+  connection->queued_since = apr_time_now();
+  connection->next_waiting = NULL;
+  if (slots->last_waiting)
+    slots->last_waiting->next_waiting = connection;
+  else
+    slots->first_waiting = connection;
+  slots->last_waiting = connection;
+
+  admission_stats.waiting++;
+  if (admission_stats.waiting > admission_stats.peak_waiting)
+    admission_stats.peak_waiting = admission_stats.waiting;
+
+  *admitted = FALSE;
+  return SVN_NO_ERROR;
+}
+
+/* Give CONNECTION's slot to the next waiting connection of the same
+   client and return that in *NEXT.  If there is none, release the slot
+   and set *NEXT to NULL.  If it is time for a report on the admission
+   statistics, return it in *REPORT, allocated in RESULT_POOL, and reset
+   them.  Otherwise, set *REPORT to NULL.  Call with ADMISSION_MUTEX
+   locked. */
+static svn_error_t *
+release_slot(connection_t **next,
+             const char **report,
+             connection_t *connection,
+             apr_pool_t *result_pool)
+{
+  client_slots_t *slots = svn_hash_gets(clients,
+                                        connection->client_key->data);
+  apr_time_t now = apr_time_now();
+
+  *next = slots->first_waiting;
+  if (*next)
+    {
+      apr_time_t wait = now - (*next)->queued_since;
+
+      slots->first_waiting = (*next)->next_waiting;
+      if (!slots->first_waiting)
+        slots->last_waiting = NULL;
+
+      admission_stats.waiting--;
+      admission_stats.delayed++;
+      admission_stats.total_wait += wait;
+      if (wait > admission_stats.max_wait)
+        admission_stats.max_wait = wait;
+    }
+  else if (--slots->active == 0)
+    {
+      svn_hash_sets(clients, slots->key->data, NULL);
+      slots->next_free = free_clients;
+      free_clients = slots;
+    }
+
+  *report = NULL;
+  if (admission_stats.delayed
+      && now - admission_stats.last_report >= ADMISSION_REPORT_INTERVAL)
+    {
+      *report = apr_psprintf(result_pool,
+                             "admission: %" APR_SIZE_T_FMT " waiting, "
+                             "peak %" APR_SIZE_T_FMT ", "
+                             "%" APR_UINT64_T_FMT " delayed, "
+                             "wait avg %" APR_TIME_T_FMT " ms, "
+                             "max %" APR_TIME_T_FMT " ms",
+                             admission_stats.waiting,
+                             admission_stats.peak_waiting,
+                             admission_stats.delayed,
+                             admission_stats.total_wait
+                               / (apr_time_t)admission_stats.delayed
+                               / 1000,
+                             admission_stats.max_wait / 1000);
+
+      admission_stats.peak_waiting = admission_stats.waiting;
+      admission_stats.delayed = 0;
+      admission_stats.total_wait = 0;
+      admission_stats.max_wait = 0;
+      admission_stats.last_report = now;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Push CONNECTION to THREADS, unless its client already occupies
+   MAX_CLIENT_THREADS slots.  In that case, CONNECTION gets pushed once
+   the client's previously waiting connections got their turn and one
+   of its slots becomes available. */
+static svn_error_t *
+dispatch_connection(connection_t *connection)
+{
+  svn_boolean_t admitted = TRUE;
+  apr_status_t status;
+
+  if (max_client_threads)
+    {
+      set_client_key(connection);
+      SVN_MUTEX__WITH_LOCK(admission_mutex,
+                           admit_connection(&admitted, connection));
+    }
+
+  if (admitted)
+    {
+      status = apr_thread_pool_push(threads, serve_thread, connection, 0,
+                                    NULL);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't push task"));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Like dispatch_connection() but log errors instead of returning them.
+   Use SCRATCH_POOL for temporary allocations. */
+static void
+requeue_connection(connection_t *connection,
+                   apr_pool_t *scratch_pool)
+{
+  svn_error_t *err = dispatch_connection(connection);
+  if (err)
+    {
+      logger__log_error(connection->params->logger, err, NULL,
+                        get_client_info(connection->conn, connection->params,
+                                        scratch_pool));
+      svn_error_clear(err);
+    }
+}
+
+/* CONNECTION has finished its turn in THREADS.  With --max-client-threads,
+   hand its slot to the next waiting connection of the same client.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+leave_thread_pool(connection_t *connection,
+                  apr_pool_t *scratch_pool)
+{
+  connection_t *next;
+  const char *report;
+  apr_status_t status;
+
+  if (!max_client_threads)
+    return SVN_NO_ERROR;
+
+  SVN_MUTEX__WITH_LOCK(admission_mutex,
+                       release_slot(&next, &report, connection,
+                                    scratch_pool));
+  if (report)
+    logger__log_stats(connection->params->logger, report);
+
+  if (next)
+    {
+      status = apr_thread_pool_push(threads, serve_thread, next, 0, NULL);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't push task"));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Hand CONNECTION, which has just been served and is still open, either
+   back to the thread pool if its next command is already waiting, or
+   to PARKED_CONNECTIONS.  Return TRUE if CONNECTION got terminated and
+   should be closed.  Use SCRATCH_POOL for temporary allocations. */
+static svn_boolean_t
+park_connection(connection_t *connection,
+                apr_pool_t *scratch_pool)
+{
+  svn_boolean_t has_command, terminated;
+  apr_status_t status;
+  svn_error_t *err;
+
+  /* This also flushes our response to the previous command.  Only then,
+     the client will send the next one. */
+  err = svn_ra_svn__has_command(&has_command, &terminated, connection->conn,
+                                scratch_pool);
+  if (err)
+    {
+      logger__log_error(connection->params->logger, err, NULL,
+                        get_client_info(connection->conn, connection->params,
+                                        scratch_pool));
+      svn_error_clear(err);
+      return TRUE;
+    }
+
+  if (terminated)
+    return TRUE;
+
+  /* The poll set would not report data that we already buffered. */
+  if (has_command)
+    {
+      requeue_connection(connection, scratch_pool);
+      return FALSE;
+    }
+
+  connection->pollfd.p = connection->pool;
+  connection->pollfd.desc_type = APR_POLL_SOCKET;
+  connection->pollfd.desc.s = connection->usock;
+  connection->pollfd.reqevents = APR_POLLIN;
+  connection->pollfd.client_data = connection;
+
+  status = apr_pollset_add(parked_connections, &connection->pollfd);
+  if (status)
+    {
+      /* Fall back to polling the connection round-robin. */
+      requeue_connection(connection, scratch_pool);
+    }
+
+  return FALSE;
+}
+
 /* Serve the connection given by DATA.  Under high load, serve only
    the current command (if any) and then put the connection back into
-   THREAD's task pool. */
+   THREAD's task pool.  With --park-idle, always serve just one command
+   and park the connection afterwards. */
 static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
 {
   svn_boolean_t done;
@@ -636,7 +1174,9 @@ static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
   apr_pool_t *pool = svn_root_pools__acquire_pool(connection_pools);
 
   /* process the actual request and log errors */
-  err = serve_interruptable(&done, connection, is_busy, pool);
+  err = serve_interruptable(&done, connection,
+                            parked_connections ? serve_one_command : is_busy,
+                            pool);
   if (err)
     {
       logger__log_error(connection->params->logger, err, NULL,
@@ -645,17 +1185,74 @@ static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
       svn_error_clear(err);
       done = TRUE;
     }
+
+  /* Let the next connection of the same client have its turn. */
+  err = leave_thread_pool(connection, pool);
+  if (err)
+    {
+      logger__log_error(connection->params->logger, err, NULL, NULL);
+      svn_error_clear(err);
+    }
+
+  /* Park or re-schedule the connection. */
+  if (!done)
+    {
+      if (parked_connections)
+        done = park_connection(connection, pool);
+      else
+        requeue_connection(connection, pool);
+    }
+
   svn_root_pools__release_pool(pool, connection_pools);
 
-  /* Close or re-schedule connection. */
   if (done)
     close_connection(connection);
-  else
-    apr_thread_pool_push(threads, serve_thread, connection, 0, NULL);
 
   return NULL;
 }
 
+/* Wait for parked connections to receive their next command and hand
+   them back to the thread pool.  DATA is the serve_params_t. */
+static void * APR_THREAD_FUNC poll_parked_thread(apr_thread_t *tid,
+                                                 void *data)
+{
+  serve_params_t *params = data;
+
+  while (1)
+    {
+      const apr_pollfd_t *descriptors;
+      apr_int32_t count, i;
+      apr_status_t status;
+
+      status = apr_pollset_poll(parked_connections, -1, &count,
+                                &descriptors);
+      if (APR_STATUS_IS_EINTR(status) || APR_STATUS_IS_TIMEUP(status))
+        continue;
+
+      if (status)
+        {
+          svn_error_t *err
+            = svn_error_wrap_apr(status,
+                                 _("Can't poll idle client connections"));
+          logger__log_error(params->logger, err, NULL, NULL);
+          svn_error_clear(err);
+          continue;
+        }
+
+      /* A connection must not be reported again while being served. */
+      for (i = 0; i < count; i++)
+        {
+          connection_t *connection = descriptors[i].client_data;
+
+          apr_pollset_remove(parked_connections, &connection->pollfd);
+          requeue_connection(connection, connection->pool);
+        }
+    }
+
+  /* NOTREACHED */
+  return NULL;
+}
+
 #endif
 
 /* Write the PID of the current process as a decimal number, followed by a
@@ -725,6 +1322,11 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   svn_boolean_t cache_txdeltas = TRUE;
   svn_boolean_t cache_revprops = FALSE;
   svn_boolean_t use_block_read = FALSE;
+  apr_int64_t cache_partitions = 1;
+  const char *cache_shm_file = NULL;
+  const char *cache_snapshot_file = NULL;
+  svn_boolean_t cache_stats = FALSE;
+  svn_boolean_t cache_admission_filter = FALSE;
   apr_uint16_t port = SVN_RA_SVN_PORT;
   const char *host = NULL;
   int family = APR_INET;
@@ -739,9 +1341,12 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   const char *config_filename = NULL;
   const char *pid_filename = NULL;
   const char *log_filename = NULL;
+  const char *command_stats_filename = NULL;
+  int command_stats_interval = 0;
   svn_node_kind_t kind;
   apr_size_t min_thread_count = THREADPOOL_MIN_SIZE;
   apr_size_t max_thread_count = THREADPOOL_MAX_SIZE;
+  svn_boolean_t park_idle = FALSE;
 #ifdef SVN_HAVE_SASL
   SVN_ERR(cyrus_init(pool));
 #endif
@@ -766,14 +1371,18 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   params.compression_level = SVN_DELTA_COMPRESSION_LEVEL_DEFAULT;
   params.logger = NULL;
   params.config_pool = NULL;
+  params.repos_cache = NULL;
+  params.metrics = NULL;
   params.fs_config = NULL;
   params.vhost = FALSE;
+  params.auth_ticket_key = NULL;
   params.username_case = CASE_ASIS;
   params.memory_cache_size = (apr_uint64_t)-1;
   params.zero_copy_limit = 0;
   params.error_check_interval = 4096;
   params.max_request_size = MAX_REQUEST_SIZE * 0x100000;
   params.max_response_size = 0;
+  params.fsfs_access_trace = 0;
 
   while (1)
     {
@@ -954,6 +1563,45 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           params.max_response_size = 0x100000 * apr_strtoi64(arg, NULL, 0);
           break;
 
+        case SVNSERVE_OPT_CACHE_PARTITIONS:
+          cache_partitions = apr_strtoi64(arg, NULL, 0);
+          if (cache_partitions < 1)
+            cache_partitions = 1;
+          break;
+
+        case SVNSERVE_OPT_CACHE_SHM:
+          SVN_ERR(svn_utf_cstring_to_utf8(&cache_shm_file, arg, pool));
+          cache_shm_file = svn_dirent_internal_style(cache_shm_file, pool);
+          SVN_ERR(svn_dirent_get_absolute(&cache_shm_file, cache_shm_file,
+                                          pool));
+          SVN_ERR(svn_path_cstring_from_utf8(&cache_shm_file,
+                                   svn_dirent_local_style(cache_shm_file,
+                                                          pool),
+                                             pool));
+          break;
+
+        case SVNSERVE_OPT_CACHE_SNAPSHOT:
+          SVN_ERR(svn_utf_cstring_to_utf8(&cache_snapshot_file, arg, pool));
+          cache_snapshot_file = svn_dirent_internal_style(cache_snapshot_file,
+                                                          pool);
+          SVN_ERR(svn_dirent_get_absolute(&cache_snapshot_file,
+                                          cache_snapshot_file, pool));
+          break;
+
+        case SVNSERVE_OPT_CACHE_STATS:
+          cache_stats = TRUE;
+          break;
+
+        case SVNSERVE_OPT_CACHE_ADMISSION:
+          cache_admission_filter = TRUE;
+          break;
+
+        case SVNSERVE_OPT_FSFS_ACCESS_TRACE:
+          params.fsfs_access_trace = (int)apr_strtoi64(arg, NULL, 0);
+          if (params.fsfs_access_trace < 0)
+            params.fsfs_access_trace = 0;
+          break;
+
         case SVNSERVE_OPT_MIN_THREADS:
           min_thread_count = (apr_size_t)apr_strtoi64(arg, NULL, 0);
           break;
@@ -962,6 +1610,18 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           max_thread_count = (apr_size_t)apr_strtoi64(arg, NULL, 0);
           break;
 
+        case SVNSERVE_OPT_PARK_IDLE:
+          park_idle = TRUE;
+          break;
+
+#if APR_HAS_THREADS
+        case SVNSERVE_OPT_MAX_CLIENT_THREADS:
+          max_client_threads = (int)apr_strtoi64(arg, NULL, 0);
+          if (max_client_threads < 0)
+            max_client_threads = 0;
+          break;
+#endif
+
 #ifdef WIN32
         case SVNSERVE_OPT_SERVICE:
           if (run_mode != run_mode_service)
@@ -995,6 +1655,21 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           SVN_ERR(svn_dirent_get_absolute(&log_filename, log_filename, pool));
           break;
 
+        case SVNSERVE_OPT_COMMAND_STATS:
+          command_stats_interval = (int)apr_strtoi64(arg, NULL, 0);
+          if (command_stats_interval < 1)
+            command_stats_interval = 0;
+          break;
+
+        case SVNSERVE_OPT_COMMAND_STATS_FILE:
+          SVN_ERR(svn_utf_cstring_to_utf8(&command_stats_filename, arg,
+                                          pool));
+          command_stats_filename
+            = svn_dirent_internal_style(command_stats_filename, pool);
+          SVN_ERR(svn_dirent_get_absolute(&command_stats_filename,
+                                          command_stats_filename, pool));
+          break;
+
         }
     }
 
@@ -1036,6 +1711,55 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       return SVN_NO_ERROR;
     }
 
+  if (park_idle && handling_mode != connection_mode_thread)
+    {
+      svn_error_clear(svn_cmdline_fputs(
+                      _("--park-idle requires the threaded server\n"),
+                      stderr, pool));
+      usage(argv[0], pool);
+      *exit_code = EXIT_FAILURE;
+      return SVN_NO_ERROR;
+    }
+
+  /* Only serve_interruptable() collects command statistics and in fork
+     mode, they would be scattered over the child processes. */
+  if (command_stats_interval
+      && (   run_mode == run_mode_inetd || run_mode == run_mode_tunnel
+          || (   run_mode != run_mode_listen_once
+              && handling_mode == connection_mode_fork)))
+    {
+      svn_error_clear(svn_cmdline_fputs(
+                      _("--command-stats requires the threaded or "
+                        "single-threaded server\n"),
+                      stderr, pool));
+      usage(argv[0], pool);
+      *exit_code = EXIT_FAILURE;
+      return SVN_NO_ERROR;
+    }
+
+  if (command_stats_filename && !command_stats_interval)
+    {
+      svn_error_clear(svn_cmdline_fputs(
+                      _("--command-stats-file requires --command-stats\n"),
+                      stderr, pool));
+      usage(argv[0], pool);
+      *exit_code = EXIT_FAILURE;
+      return SVN_NO_ERROR;
+    }
+
+#if APR_HAS_THREADS
+  if (max_client_threads && handling_mode != connection_mode_thread)
+    {
+      svn_error_clear(svn_cmdline_fputs(
+                      _("--max-client-threads requires the threaded "
+                        "server\n"),
+                      stderr, pool));
+      usage(argv[0], pool);
+      *exit_code = EXIT_FAILURE;
+      return SVN_NO_ERROR;
+    }
+#endif
+
   /* construct object pools */
   is_multi_threaded = handling_mode == connection_mode_thread;
   params.fs_config = apr_hash_make(pool);
@@ -1054,6 +1778,13 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
                                         is_multi_threaded,
                                         pool));
 
+  /* Forked connection processes and inetd or tunnel mode serve only one
+     connection per process.  Reusing repository handles won't pay off. */
+  if ((run_mode == run_mode_daemon || run_mode == run_mode_service)
+      && handling_mode != connection_mode_fork)
+    SVN_ERR(repos_cache_create(&params.repos_cache, is_multi_threaded,
+                               pool));
+
   /* If a configuration file is specified, load it and any referenced
    * password and authorization files. */
   if (config_filename)
@@ -1073,6 +1804,11 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   else if (run_mode == run_mode_listen_once)
     SVN_ERR(logger__create_for_stderr(&params.logger, pool));
 
+  if (command_stats_interval)
+    SVN_ERR(metrics__create(&params.metrics,
+                            apr_time_from_sec(command_stats_interval),
+                            params.logger, command_stats_filename, pool));
+
   if (params.tunnel_user && run_mode != run_mode_tunnel)
     {
       return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
@@ -1112,6 +1848,23 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       return err;
     }
 
+  /* Every connection of this listener, forked or threaded, inherits the
+     same auth ticket key.  In inetd and tunnel mode, the key would die
+     with the connection, so no tickets are issued there. */
+  {
+    unsigned char random_bytes[16];
+    svn_checksum_t *key;
+
+    status = apr_generate_random_bytes(random_bytes, sizeof(random_bytes));
+    if (status)
+      return svn_error_wrap_apr(status,
+                                _("Can't generate the auth ticket key"));
+
+    SVN_ERR(svn_checksum(&key, svn_checksum_md5, random_bytes,
+                         sizeof(random_bytes), pool));
+    params.auth_ticket_key = svn_checksum_to_cstring_display(key, pool);
+  }
+
 #ifdef WIN32
   /* If svnserve needs to run as a Win32 service, then we need to
      coordinate with the Service Control Manager (SCM) before
@@ -1244,6 +1997,19 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   apr_signal(SIGCHLD, sigchld_handler);
 #endif
 
+  /* Write the cache snapshot upon termination of the listener. */
+  if (cache_snapshot_file && run_mode != run_mode_listen_once)
+    {
+      apr_signal(SIGTERM, shutdown_handler);
+      apr_signal(SIGINT, shutdown_handler);
+    }
+
+#ifdef SIGUSR1
+  /* Log the cache statistics on demand. */
+  if (cache_stats && run_mode != run_mode_listen_once)
+    apr_signal(SIGUSR1, stats_handler);
+#endif
+
 #ifdef SIGPIPE
   /* Disable SIGPIPE generation for the platforms that have it. */
   apr_signal(SIGPIPE, SIG_IGN);
@@ -1295,8 +2061,28 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       }
 
     svn_cache_config_set(&settings);
+    svn_cache__set_global_membuffer_partitions((apr_size_t)cache_partitions);
+    svn_cache__set_global_membuffer_snapshot(cache_snapshot_file);
+    svn_cache__set_global_membuffer_admission_filter(cache_admission_filter);
+
+    /* The shared cache must exist before we fork the first worker.
+     * The same goes for a warm cache that the workers shall inherit. */
+    if (cache_shm_file)
+      svn_cache__set_global_membuffer_shared(TRUE, cache_shm_file);
+    if (cache_shm_file || cache_snapshot_file)
+      svn_cache__get_global_membuffer_cache();
   }
 
+  /* Enable FSFS access tracing before serving the first request. */
+  if (params.fsfs_access_trace)
+    {
+      svn_fs_fs__ioctl_set_access_trace_input_t trace_input;
+      trace_input.capacity = params.fsfs_access_trace;
+
+      SVN_ERR(svn_fs_ioctl(NULL, SVN_FS_FS__IOCTL_SET_ACCESS_TRACE,
+                           &trace_input, NULL, NULL, NULL, pool, pool));
+    }
+
 #if APR_HAS_THREADS
   SVN_ERR(svn_root_pools__create(&connection_pools));
 
@@ -1323,6 +2109,35 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
 
       /* don't queue requests unless we reached the worker thread limit */
       apr_thread_pool_threshold_set(threads, 0);
+
+      if (max_client_threads)
+        {
+          SVN_ERR(svn_mutex__init(&admission_mutex, TRUE, pool));
+          admission_pool = svn_pool_create(pool);
+          clients = apr_hash_make(admission_pool);
+          admission_stats.last_report = apr_time_now();
+        }
+
+      /* Only the event-based poll set implementations (epoll, kqueue,
+         event ports) support adding sockets while another thread polls
+         them. */
+      if (park_idle)
+        {
+          apr_thread_t *poll_thread;
+
+          status = apr_pollset_create(&parked_connections,
+                                      PARKED_POLL_BATCH, pool,
+                                      APR_POLLSET_THREADSAFE);
+          if (status)
+            return svn_error_wrap_apr(status,
+                                      _("Can't create poll set for idle "
+                                        "connections"));
+
+          status = apr_thread_create(&poll_thread, NULL, poll_parked_thread,
+                                     &params, pool);
+          if (status)
+            return svn_error_wrap_apr(status, _("Can't create thread"));
+        }
     }
   else
     {
@@ -1352,6 +2167,19 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
               /* the child wouldn't listen to the main server's socket */
               apr_socket_close(sock);
 
+              /* nor write the cache snapshot */
+              if (cache_snapshot_file)
+                {
+                  apr_signal(SIGTERM, SIG_DFL);
+                  apr_signal(SIGINT, SIG_DFL);
+                }
+
+#ifdef SIGUSR1
+              /* and the listener's statistics are of no interest */
+              if (cache_stats)
+                apr_signal(SIGUSR1, SIG_IGN);
+#endif
+
               /* serve_socket() logs any error it returns, so ignore it. */
               svn_error_clear(serve_socket(connection, connection->pool));
               close_connection(connection);
@@ -1372,13 +2200,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
              little different from forking one process per connection. */
 #if APR_HAS_THREADS
           attach_connection(connection);
-
-          status = apr_thread_pool_push(threads, serve_thread, connection,
-                                        0, NULL);
-          if (status)
-            {
-              return svn_error_wrap_apr(status, _("Can't push task"));
-            }
+          SVN_ERR(dispatch_connection(connection));
 #endif
           break;
 
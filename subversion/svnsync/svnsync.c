@@ -38,12 +38,16 @@
 #include "private/svn_opt_private.h"
 #include "private/svn_ra_private.h"
 #include "private/svn_cmdline_private.h"
+#include "private/svn_mutex.h"
+#include "private/svn_atomic.h"
 
 #include "sync.h"
 
 #include "svn_private_config.h"
 
 #include <apr_uuid.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
 
 static svn_opt_subcommand_t initialize_cmd,
                             synchronize_cmd,
@@ -1424,6 +1428,356 @@ replay_rev_finished(svn_revnum_t revision,
   return SVN_NO_ERROR;
 }
 
+#if APR_HAS_THREADS
+
+/* Number of replayed revisions that may wait for their commit. */
+#define PIPELINE_DEPTH 8
+
+/* Memory used for the text deltas of a single revision before they get
+   spilled to a temporary file. */
+#define PIPELINE_SPILL_SIZE (1024 * 1024)
+
+/* A revision replayed from the source, waiting to be committed. */
+typedef struct recorded_rev_t
+{
+  svn_revnum_t revision;
+  apr_hash_t *rev_props;
+  svnsync_recording_t *recording;
+
+  /* Root pool containing everything above. */
+  apr_pool_t *pool;
+} recorded_rev_t;
+
+/* State shared between the thread replaying revisions from the source
+   and the main thread committing them to the target. */
+typedef struct pipeline_t
+{
+  svn_ra_session_t *from_session;
+  svn_revnum_t start_revision;
+  svn_revnum_t end_revision;
+
+  /* Ring buffer of revisions replayed but not yet committed. */
+  recorded_rev_t *queue[PIPELINE_DEPTH];
+  int first;
+  int count;
+
+  /* The revision currently being replayed.  Only used by the replay
+     thread. */
+  recorded_rev_t *current;
+
+  /* Set when the replay thread has finished, with ERR being its result. */
+  svn_boolean_t done;
+  svn_error_t *err;
+
+  /* Set when the replay thread shall stop, e.g. after a failed commit.
+     Read by the cancellation callback, so access it atomically. */
+  volatile svn_atomic_t stopped;
+
+  /* Synchronization objects. */
+  svn_mutex__t *mutex;
+  apr_thread_cond_t *cond;
+} pipeline_t;
+
+/* Wake up the other thread waiting for state changes in PIPELINE.
+ * The caller must hold PIPELINE->MUTEX. */
+static svn_error_t *
+pipeline_broadcast(pipeline_t *pipeline)
+{
+  apr_status_t status = apr_thread_cond_broadcast(pipeline->cond);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't broadcast condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait for the next state change in PIPELINE.
+ * The caller must hold PIPELINE->MUTEX. */
+static svn_error_t *
+pipeline_wait(pipeline_t *pipeline)
+{
+  apr_status_t status = apr_thread_cond_wait(pipeline->cond,
+                                             svn_mutex__get(pipeline->mutex));
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't wait on condition variable"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cancel_func_t for the replay thread.  BATON is the
+ * pipeline_t. */
+static svn_error_t *
+pipeline_check_cancel(void *baton)
+{
+  pipeline_t *pipeline = baton;
+
+  if (svn_atomic_read(&pipeline->stopped))
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  return svn_error_trace(check_cancel(NULL));
+}
+
+/* Append PIPELINE->CURRENT to the queue of PIPELINE, waiting for a free
+ * slot.  The caller must hold PIPELINE->MUTEX. */
+static svn_error_t *
+enqueue_rev(pipeline_t *pipeline)
+{
+  while (pipeline->count == PIPELINE_DEPTH
+         && !svn_atomic_read(&pipeline->stopped))
+    SVN_ERR(pipeline_wait(pipeline));
+
+  if (svn_atomic_read(&pipeline->stopped))
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  pipeline->queue[(pipeline->first + pipeline->count) % PIPELINE_DEPTH]
+    = pipeline->current;
+  pipeline->count++;
+  pipeline->current = NULL;
+
+  return svn_error_trace(pipeline_broadcast(pipeline));
+}
+
+/* Set *REV to the next revision in the queue of PIPELINE, waiting for one
+ * to become available.  Set it to NULL if the replay thread finished and
+ * return its error, if any.  The caller must hold PIPELINE->MUTEX. */
+static svn_error_t *
+dequeue_rev(recorded_rev_t **rev,
+            pipeline_t *pipeline)
+{
+  svn_error_t *err;
+
+  while (pipeline->count == 0 && !pipeline->done)
+    SVN_ERR(pipeline_wait(pipeline));
+
+  if (pipeline->count == 0)
+    {
+      *rev = NULL;
+      err = pipeline->err;
+      pipeline->err = SVN_NO_ERROR;
+
+      return svn_error_trace(err);
+    }
+
+  *rev = pipeline->queue[pipeline->first];
+  pipeline->first = (pipeline->first + 1) % PIPELINE_DEPTH;
+  pipeline->count--;
+
+  return svn_error_trace(pipeline_broadcast(pipeline));
+}
+
+/* Callback function for svn_ra_replay_range in the replay thread, invoked
+ * when starting to parse a replay report.  Record the revision instead of
+ * committing it.
+ */
+static svn_error_t *
+record_rev_started(svn_revnum_t revision,
+                   void *replay_baton,
+                   const svn_delta_editor_t **editor,
+                   void **edit_baton,
+                   apr_hash_t *rev_props,
+                   apr_pool_t *pool)
+{
+  pipeline_t *pipeline = replay_baton;
+  const svn_delta_editor_t *record_editor;
+  void *record_baton;
+
+  /* The main thread releases the revision, so it gets a pool of its own.
+     Only one thread at a time uses it, hence no mutex. */
+  apr_pool_t *rev_pool
+    = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  recorded_rev_t *rev = apr_pcalloc(rev_pool, sizeof(*rev));
+
+  rev->revision = revision;
+  rev->rev_props = svn_prop_hash_dup(rev_props, rev_pool);
+  rev->pool = rev_pool;
+  pipeline->current = rev;
+
+  SVN_ERR(svnsync_get_recording_editor(&record_editor, &record_baton,
+                                       &rev->recording, PIPELINE_SPILL_SIZE,
+                                       rev_pool));
+  SVN_ERR(svn_delta_get_cancellation_editor(pipeline_check_cancel, pipeline,
+                                            record_editor, record_baton,
+                                            editor, edit_baton,
+                                            rev_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Callback function for svn_ra_replay_range in the replay thread, invoked
+ * when finishing parsing a replay report.  Hand the recorded revision over
+ * to the main thread.
+ */
+static svn_error_t *
+record_rev_finished(svn_revnum_t revision,
+                    void *replay_baton,
+                    const svn_delta_editor_t *editor,
+                    void *edit_baton,
+                    apr_hash_t *rev_props,
+                    apr_pool_t *pool)
+{
+  pipeline_t *pipeline = replay_baton;
+
+  SVN_MUTEX__WITH_LOCK(pipeline->mutex, enqueue_rev(pipeline));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set PIPELINE->DONE and PIPELINE->ERR to ERR and notify the main thread.
+ * The caller must hold PIPELINE->MUTEX. */
+static svn_error_t *
+finish_replay(pipeline_t *pipeline,
+              svn_error_t *err)
+{
+  pipeline->done = TRUE;
+  pipeline->err = err;
+
+  return svn_error_trace(pipeline_broadcast(pipeline));
+}
+
+/* Thread replaying all revisions of the pipeline_t DATA. */
+static void * APR_THREAD_FUNC
+replay_thread(apr_thread_t *thread, void *data)
+{
+  pipeline_t *pipeline = data;
+  apr_pool_t *pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  svn_error_t *replay_err;
+  svn_error_t *err;
+
+  replay_err = svn_ra_replay_range(pipeline->from_session,
+                                   pipeline->start_revision,
+                                   pipeline->end_revision,
+                                   0, TRUE, record_rev_started,
+                                   record_rev_finished, pipeline, pool);
+
+  /* Drop an incomplete revision. */
+  if (pipeline->current)
+    {
+      svn_pool_destroy(pipeline->current->pool);
+      pipeline->current = NULL;
+    }
+
+  /* Should we fail to pass on the result, the main thread would wait
+     forever, so there is no way to recover. */
+  err = svn_mutex__lock(pipeline->mutex);
+  if (!err)
+    err = svn_mutex__unlock(pipeline->mutex,
+                            finish_replay(pipeline, replay_err));
+  if (err)
+    svn_handle_error2(err, stderr, TRUE, "svnsync: ");
+
+  svn_pool_destroy(pool);
+  apr_thread_exit(thread, APR_SUCCESS);
+  return NULL;
+}
+
+/* Commit the recorded revision REV with the replay baton RB, just like
+ * replay_rev_started() and replay_rev_finished() do for revisions replayed
+ * directly into the commit. */
+static svn_error_t *
+commit_recorded_rev(replay_baton_t *rb,
+                    recorded_rev_t *rev,
+                    apr_pool_t *pool)
+{
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+
+  SVN_ERR(replay_rev_started(rev->revision, rb, &editor, &edit_baton,
+                             rev->rev_props, pool));
+  SVN_ERR(svnsync_play_recording(rev->recording, editor, edit_baton, pool));
+  SVN_ERR(replay_rev_finished(rev->revision, rb, editor, edit_baton,
+                              rev->rev_props, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Stop the replay thread of PIPELINE and release all revisions that have
+ * not been committed.  The caller must hold PIPELINE->MUTEX. */
+static svn_error_t *
+stop_pipeline(pipeline_t *pipeline)
+{
+  svn_atomic_set(&pipeline->stopped, TRUE);
+
+  for (; pipeline->count > 0; pipeline->count--)
+    {
+      svn_pool_destroy(pipeline->queue[pipeline->first]->pool);
+      pipeline->first = (pipeline->first + 1) % PIPELINE_DEPTH;
+    }
+
+  return svn_error_trace(pipeline_broadcast(pipeline));
+}
+
+/* Copy START_REVISION through END_REVISION from RB->FROM_SESSION to
+ * RB->TO_SESSION like svn_ra_replay_range() with replay_rev_started() and
+ * replay_rev_finished() would, but replay the revisions from the source
+ * in a separate thread while earlier ones are still being committed.
+ * This way, synchronizing takes about as long as the slower of the two
+ * repositories needs instead of the sum of both.
+ */
+static svn_error_t *
+replay_pipelined(replay_baton_t *rb,
+                 svn_revnum_t start_revision,
+                 svn_revnum_t end_revision,
+                 apr_pool_t *pool)
+{
+  pipeline_t *pipeline = apr_pcalloc(pool, sizeof(*pipeline));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_thread_t *thread;
+  apr_status_t status;
+  apr_status_t thread_status;
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_error_t *stop_err;
+
+  pipeline->from_session = rb->from_session;
+  pipeline->start_revision = start_revision;
+  pipeline->end_revision = end_revision;
+
+  SVN_ERR(svn_mutex__init(&pipeline->mutex, TRUE, pool));
+  status = apr_thread_cond_create(&pipeline->cond, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create condition variable"));
+
+  status = apr_thread_create(&thread, NULL, replay_thread, pipeline, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create replay thread"));
+
+  while (TRUE)
+    {
+      recorded_rev_t *rev;
+
+      svn_pool_clear(iterpool);
+
+      err = svn_mutex__lock(pipeline->mutex);
+      if (!err)
+        err = svn_mutex__unlock(pipeline->mutex,
+                                dequeue_rev(&rev, pipeline));
+      if (err || !rev)
+        break;
+
+      err = commit_recorded_rev(rb, rev, iterpool);
+      svn_pool_destroy(rev->pool);
+      if (err)
+        break;
+    }
+
+  /* After a failed commit, the replay thread may still be running. */
+  stop_err = svn_mutex__lock(pipeline->mutex);
+  if (!stop_err)
+    stop_err = svn_mutex__unlock(pipeline->mutex, stop_pipeline(pipeline));
+  err = svn_error_compose_create(err, stop_err);
+
+  status = apr_thread_join(&thread_status, thread);
+  if (status)
+    err = svn_error_compose_create(
+            err, svn_error_wrap_apr(status, _("Can't join replay thread")));
+
+  /* Anything left from the replay thread is a consequence of ERR. */
+  svn_error_clear(pipeline->err);
+
+  svn_pool_destroy(iterpool);
+  return svn_error_trace(err);
+}
+
+#endif
+
 /* Synchronize the repository associated with RA session TO_SESSION,
  * using information found in BATON.
  *
@@ -1556,9 +1910,13 @@ do_synchronize(svn_ra_session_t *to_session,
 
   SVN_ERR(check_cancel(NULL));
 
+#if APR_HAS_THREADS
+  SVN_ERR(replay_pipelined(rb, start_revision, end_revision, pool));
+#else
   SVN_ERR(svn_ra_replay_range(from_session, start_revision, end_revision,
                               0, TRUE, replay_rev_started,
                               replay_rev_finished, rb, pool));
+#endif
 
   SVN_ERR(log_properties_normalized(rb->normalized_rev_props_count
                                       + normalized_rev_props_count,
@@ -2412,10 +2770,10 @@ main(int argc, const char *argv[])
   if (svn_cmdline_init("svnsync", stderr) != EXIT_SUCCESS)
     return EXIT_FAILURE;
 
-  /* Create our top-level pool.  Use a separate mutexless allocator,
-   * given this application is single threaded.
+  /* Create our top-level pool.  'svnsync sync' replays the source
+   * repository in a separate thread, so the allocator must be thread-safe.
    */
-  pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  pool = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
 
   err = sub_main(&exit_code, argc, argv, pool);
 
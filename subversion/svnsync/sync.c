@@ -19,6 +19,8 @@
  * ====================================================================
  */
 
+#include <string.h>
+
 #include "svn_hash.h"
 #include "svn_cmdline.h"
 #include "svn_config.h"
@@ -32,9 +34,11 @@
 #include "svn_ra.h"
 #include "svn_utf.h"
 #include "svn_subst.h"
+#include "svn_sorts.h"
 #include "svn_string.h"
 
 #include "private/svn_string_private.h"
+#include "private/svn_subr_private.h"
 
 #include "sync.h"
 
@@ -756,3 +760,533 @@ svnsync_get_sync_editor(const svn_delta_editor_t *wrapped_editor,
   return SVN_NO_ERROR;
 }
 
+
+
+/*** Recording editor ***/
+
+/* The editor functions that a recording can contain. */
+typedef enum recorded_op_kind_t
+{
+  op_set_target_revision,
+  op_open_root,
+  op_delete_entry,
+  op_add_directory,
+  op_open_directory,
+  op_change_dir_prop,
+  op_close_directory,
+  op_absent_directory,
+  op_add_file,
+  op_open_file,
+  op_apply_textdelta,
+  op_change_file_prop,
+  op_close_file,
+  op_absent_file
+} recorded_op_kind_t;
+
+/* One recorded editor call.  Directory and file batons are represented
+ * by the index of the call that created them. */
+typedef struct recorded_op_t
+{
+  recorded_op_kind_t kind;
+
+  /* The baton the call was made on: the parent directory for calls that
+   * take a path, the node itself for all others.  -1 for calls on the
+   * edit baton. */
+  int node;
+
+  /* Path of the node, or name of the property. */
+  const char *path;
+
+  /* Copy source of added nodes. */
+  const char *copyfrom_path;
+
+  /* Target, base or copyfrom revision. */
+  svn_revnum_t revision;
+
+  /* New property value. */
+  const svn_string_t *value;
+
+  /* Base checksum for apply_textdelta(), text checksum for close_file(). */
+  const char *checksum;
+
+  /* Number of svndiff bytes that apply_textdelta() received. */
+  svn_filesize_t delta_len;
+} recorded_op_t;
+
+struct svnsync_recording_t
+{
+  /* The recorded calls, as recorded_op_t, in order. */
+  apr_array_header_t *ops;
+
+  /* The svndiff data of all text deltas, one after the other. */
+  svn_spillbuf_reader_t *deltas;
+
+  apr_pool_t *pool;
+};
+
+/* Baton for recorded directories and files. */
+typedef struct record_baton_t
+{
+  svnsync_recording_t *recording;
+
+  /* Index of the operation that created this baton. */
+  int node;
+} record_baton_t;
+
+/* Append an operation of KIND on NODE to RECORDING and return it. */
+static recorded_op_t *
+record_op(svnsync_recording_t *recording,
+          recorded_op_kind_t kind,
+          int node)
+{
+  recorded_op_t *op = apr_array_push(recording->ops);
+
+  memset(op, 0, sizeof(*op));
+  op->kind = kind;
+  op->node = node;
+  op->revision = SVN_INVALID_REVNUM;
+
+  return op;
+}
+
+/* Return a baton for the node created by the operation just recorded in
+ * RECORDING, allocated in POOL. */
+static record_baton_t *
+make_record_baton(svnsync_recording_t *recording,
+                  apr_pool_t *pool)
+{
+  record_baton_t *baton = apr_palloc(pool, sizeof(*baton));
+
+  baton->recording = recording;
+  baton->node = recording->ops->nelts - 1;
+
+  return baton;
+}
+
+static svn_error_t *
+record_set_target_revision(void *edit_baton,
+                           svn_revnum_t target_revision,
+                           apr_pool_t *pool)
+{
+  svnsync_recording_t *recording = edit_baton;
+  recorded_op_t *op = record_op(recording, op_set_target_revision, -1);
+
+  op->revision = target_revision;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_open_root(void *edit_baton,
+                 svn_revnum_t base_revision,
+                 apr_pool_t *pool,
+                 void **root_baton)
+{
+  svnsync_recording_t *recording = edit_baton;
+  recorded_op_t *op = record_op(recording, op_open_root, -1);
+
+  op->revision = base_revision;
+  *root_baton = make_record_baton(recording, pool);
+  return SVN_NO_ERROR;
+}
+
+/* Record an operation of KIND with PATH, COPYFROM_PATH and REVISION on
+ * the directory PARENT_BATON.  If CHILD_BATON is not NULL, set it to the
+ * baton of the new node, allocated in POOL. */
+static svn_error_t *
+record_path_op(recorded_op_kind_t kind,
+               const char *path,
+               const char *copyfrom_path,
+               svn_revnum_t revision,
+               void *parent_baton,
+               apr_pool_t *pool,
+               void **child_baton)
+{
+  record_baton_t *pb = parent_baton;
+  svnsync_recording_t *recording = pb->recording;
+  recorded_op_t *op = record_op(recording, kind, pb->node);
+
+  op->path = apr_pstrdup(recording->pool, path);
+  if (copyfrom_path)
+    op->copyfrom_path = apr_pstrdup(recording->pool, copyfrom_path);
+  op->revision = revision;
+
+  if (child_baton)
+    *child_baton = make_record_baton(recording, pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_delete_entry(const char *path,
+                    svn_revnum_t base_revision,
+                    void *parent_baton,
+                    apr_pool_t *pool)
+{
+  return record_path_op(op_delete_entry, path, NULL, base_revision,
+                        parent_baton, pool, NULL);
+}
+
+static svn_error_t *
+record_add_directory(const char *path,
+                     void *parent_baton,
+                     const char *copyfrom_path,
+                     svn_revnum_t copyfrom_rev,
+                     apr_pool_t *pool,
+                     void **child_baton)
+{
+  return record_path_op(op_add_directory, path, copyfrom_path, copyfrom_rev,
+                        parent_baton, pool, child_baton);
+}
+
+static svn_error_t *
+record_open_directory(const char *path,
+                      void *parent_baton,
+                      svn_revnum_t base_revision,
+                      apr_pool_t *pool,
+                      void **child_baton)
+{
+  return record_path_op(op_open_directory, path, NULL, base_revision,
+                        parent_baton, pool, child_baton);
+}
+
+static svn_error_t *
+record_absent_directory(const char *path,
+                        void *parent_baton,
+                        apr_pool_t *pool)
+{
+  return record_path_op(op_absent_directory, path, NULL,
+                        SVN_INVALID_REVNUM, parent_baton, pool, NULL);
+}
+
+static svn_error_t *
+record_add_file(const char *path,
+                void *parent_baton,
+                const char *copyfrom_path,
+                svn_revnum_t copyfrom_rev,
+                apr_pool_t *pool,
+                void **file_baton)
+{
+  return record_path_op(op_add_file, path, copyfrom_path, copyfrom_rev,
+                        parent_baton, pool, file_baton);
+}
+
+static svn_error_t *
+record_open_file(const char *path,
+                 void *parent_baton,
+                 svn_revnum_t base_revision,
+                 apr_pool_t *pool,
+                 void **file_baton)
+{
+  return record_path_op(op_open_file, path, NULL, base_revision,
+                        parent_baton, pool, file_baton);
+}
+
+static svn_error_t *
+record_absent_file(const char *path,
+                   void *parent_baton,
+                   apr_pool_t *pool)
+{
+  return record_path_op(op_absent_file, path, NULL, SVN_INVALID_REVNUM,
+                        parent_baton, pool, NULL);
+}
+
+/* Record a property change of KIND on the node NODE_BATON. */
+static svn_error_t *
+record_prop_op(recorded_op_kind_t kind,
+               void *node_baton,
+               const char *name,
+               const svn_string_t *value)
+{
+  record_baton_t *nb = node_baton;
+  svnsync_recording_t *recording = nb->recording;
+  recorded_op_t *op = record_op(recording, kind, nb->node);
+
+  op->path = apr_pstrdup(recording->pool, name);
+  if (value)
+    op->value = svn_string_dup(value, recording->pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_change_dir_prop(void *dir_baton,
+                       const char *name,
+                       const svn_string_t *value,
+                       apr_pool_t *pool)
+{
+  return record_prop_op(op_change_dir_prop, dir_baton, name, value);
+}
+
+static svn_error_t *
+record_change_file_prop(void *file_baton,
+                        const char *name,
+                        const svn_string_t *value,
+                        apr_pool_t *pool)
+{
+  return record_prop_op(op_change_file_prop, file_baton, name, value);
+}
+
+static svn_error_t *
+record_close_directory(void *dir_baton,
+                       apr_pool_t *pool)
+{
+  record_baton_t *db = dir_baton;
+
+  record_op(db->recording, op_close_directory, db->node);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_close_file(void *file_baton,
+                  const char *text_checksum,
+                  apr_pool_t *pool)
+{
+  record_baton_t *fb = file_baton;
+  svnsync_recording_t *recording = fb->recording;
+  recorded_op_t *op = record_op(recording, op_close_file, fb->node);
+
+  if (text_checksum)
+    op->checksum = apr_pstrdup(recording->pool, text_checksum);
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for the stream that receives the svndiff data of a text delta. */
+typedef struct delta_stream_baton_t
+{
+  svnsync_recording_t *recording;
+
+  /* Index of the apply_textdelta() operation. */
+  int op;
+
+  apr_pool_t *pool;
+} delta_stream_baton_t;
+
+/* Implements svn_write_fn_t, appending to the recording's deltas. */
+static svn_error_t *
+write_delta(void *baton,
+            const char *data,
+            apr_size_t *len)
+{
+  delta_stream_baton_t *sb = baton;
+  recorded_op_t *op = &APR_ARRAY_IDX(sb->recording->ops, sb->op,
+                                     recorded_op_t);
+
+  SVN_ERR(svn_spillbuf__reader_write(sb->recording->deltas, data, *len,
+                                     sb->pool));
+  op->delta_len += *len;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_apply_textdelta(void *file_baton,
+                       const char *base_checksum,
+                       apr_pool_t *pool,
+                       svn_txdelta_window_handler_t *handler,
+                       void **handler_baton)
+{
+  record_baton_t *fb = file_baton;
+  svnsync_recording_t *recording = fb->recording;
+  recorded_op_t *op = record_op(recording, op_apply_textdelta, fb->node);
+  delta_stream_baton_t *sb = apr_palloc(pool, sizeof(*sb));
+  svn_stream_t *stream;
+
+  if (base_checksum)
+    op->checksum = apr_pstrdup(recording->pool, base_checksum);
+
+  sb->recording = recording;
+  sb->op = recording->ops->nelts - 1;
+  sb->pool = pool;
+
+  stream = svn_stream_create(sb, pool);
+  svn_stream_set_write(stream, write_delta);
+
+  /* The data is only kept until it gets played back, so don't spend
+     any time on compressing it. */
+  svn_txdelta_to_svndiff3(handler, handler_baton, stream, 0,
+                          SVN_DELTA_COMPRESSION_LEVEL_NONE, pool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svnsync_get_recording_editor(const svn_delta_editor_t **editor,
+                             void **edit_baton,
+                             svnsync_recording_t **recording_p,
+                             apr_size_t memory_limit,
+                             apr_pool_t *pool)
+{
+  svn_delta_editor_t *tree_editor = svn_delta_default_editor(pool);
+  svnsync_recording_t *recording = apr_palloc(pool, sizeof(*recording));
+
+  tree_editor->set_target_revision = record_set_target_revision;
+  tree_editor->open_root = record_open_root;
+  tree_editor->delete_entry = record_delete_entry;
+  tree_editor->add_directory = record_add_directory;
+  tree_editor->open_directory = record_open_directory;
+  tree_editor->change_dir_prop = record_change_dir_prop;
+  tree_editor->close_directory = record_close_directory;
+  tree_editor->absent_directory = record_absent_directory;
+  tree_editor->add_file = record_add_file;
+  tree_editor->open_file = record_open_file;
+  tree_editor->apply_textdelta = record_apply_textdelta;
+  tree_editor->change_file_prop = record_change_file_prop;
+  tree_editor->close_file = record_close_file;
+  tree_editor->absent_file = record_absent_file;
+
+  recording->ops = apr_array_make(pool, 16, sizeof(recorded_op_t));
+  recording->deltas = svn_spillbuf__reader_create(SVN__STREAM_CHUNK_SIZE,
+                                                  memory_limit, pool);
+  recording->pool = pool;
+
+  *editor = tree_editor;
+  *edit_baton = recording;
+  *recording_p = recording;
+
+  return SVN_NO_ERROR;
+}
+
+/* Send the next LEN bytes of svndiff data in RECORDING to the window
+ * HANDLER and HANDLER_BATON. */
+static svn_error_t *
+play_delta(svnsync_recording_t *recording,
+           svn_filesize_t len,
+           svn_txdelta_window_handler_t handler,
+           void *handler_baton,
+           apr_pool_t *scratch_pool)
+{
+  svn_stream_t *stream;
+  char *buffer;
+
+  /* An empty delta didn't even get a header. */
+  if (len == 0)
+    return svn_error_trace(handler(NULL, handler_baton));
+
+  stream = svn_txdelta_parse_svndiff(handler, handler_baton, TRUE,
+                                     scratch_pool);
+  buffer = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
+  while (len > 0)
+    {
+      apr_size_t amt;
+      apr_size_t to_read = (apr_size_t)MIN(len, SVN__STREAM_CHUNK_SIZE);
+
+      SVN_ERR(svn_spillbuf__reader_read(&amt, recording->deltas, buffer,
+                                        to_read, scratch_pool));
+      if (amt == 0)
+        return svn_error_create(SVN_ERR_STREAM_UNEXPECTED_EOF, NULL,
+                                _("Recorded text delta is incomplete"));
+
+      SVN_ERR(svn_stream_write(stream, buffer, &amt));
+      len -= amt;
+    }
+
+  return svn_error_trace(svn_stream_close(stream));
+}
+
+svn_error_t *
+svnsync_play_recording(svnsync_recording_t *recording,
+                       const svn_delta_editor_t *editor,
+                       void *edit_baton,
+                       apr_pool_t *scratch_pool)
+{
+  int count = recording->ops->nelts;
+  void **batons = apr_pcalloc(scratch_pool, count * sizeof(*batons));
+  apr_pool_t **pools = apr_pcalloc(scratch_pool, count * sizeof(*pools));
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < count; i++)
+    {
+      const recorded_op_t *op = &APR_ARRAY_IDX(recording->ops, i,
+                                               recorded_op_t);
+      void *baton = op->node >= 0 ? batons[op->node] : NULL;
+      apr_pool_t *node_pool = op->node >= 0 ? pools[op->node] : NULL;
+      svn_txdelta_window_handler_t handler;
+      void *handler_baton;
+
+      svn_pool_clear(iterpool);
+
+      switch (op->kind)
+        {
+          case op_set_target_revision:
+            SVN_ERR(editor->set_target_revision(edit_baton, op->revision,
+                                                iterpool));
+            break;
+
+          case op_open_root:
+            pools[i] = svn_pool_create(scratch_pool);
+            SVN_ERR(editor->open_root(edit_baton, op->revision, pools[i],
+                                      &batons[i]));
+            break;
+
+          case op_delete_entry:
+            SVN_ERR(editor->delete_entry(op->path, op->revision, baton,
+                                         iterpool));
+            break;
+
+          case op_add_directory:
+            pools[i] = svn_pool_create(node_pool);
+            SVN_ERR(editor->add_directory(op->path, baton, op->copyfrom_path,
+                                          op->revision, pools[i],
+                                          &batons[i]));
+            break;
+
+          case op_open_directory:
+            pools[i] = svn_pool_create(node_pool);
+            SVN_ERR(editor->open_directory(op->path, baton, op->revision,
+                                           pools[i], &batons[i]));
+            break;
+
+          case op_change_dir_prop:
+            SVN_ERR(editor->change_dir_prop(baton, op->path, op->value,
+                                            iterpool));
+            break;
+
+          case op_close_directory:
+            SVN_ERR(editor->close_directory(baton, node_pool));
+            svn_pool_destroy(node_pool);
+            break;
+
+          case op_absent_directory:
+            SVN_ERR(editor->absent_directory(op->path, baton, iterpool));
+            break;
+
+          case op_add_file:
+            pools[i] = svn_pool_create(node_pool);
+            SVN_ERR(editor->add_file(op->path, baton, op->copyfrom_path,
+                                     op->revision, pools[i], &batons[i]));
+            break;
+
+          case op_open_file:
+            pools[i] = svn_pool_create(node_pool);
+            SVN_ERR(editor->open_file(op->path, baton, op->revision,
+                                      pools[i], &batons[i]));
+            break;
+
+          case op_apply_textdelta:
+            SVN_ERR(editor->apply_textdelta(baton, op->checksum, node_pool,
+                                            &handler, &handler_baton));
+            SVN_ERR(play_delta(recording, op->delta_len, handler,
+                               handler_baton, iterpool));
+            break;
+
+          case op_change_file_prop:
+            SVN_ERR(editor->change_file_prop(baton, op->path, op->value,
+                                             iterpool));
+            break;
+
+          case op_close_file:
+            SVN_ERR(editor->close_file(baton, op->checksum, node_pool));
+            svn_pool_destroy(node_pool);
+            break;
+
+          case op_absent_file:
+            SVN_ERR(editor->absent_file(op->path, baton, iterpool));
+            break;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
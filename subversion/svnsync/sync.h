@@ -78,6 +78,37 @@ svnsync_get_sync_editor(const svn_delta_editor_t *wrapped_editor,
                         apr_pool_t *pool);
 
 
+/* An editor drive recorded for later playback. */
+typedef struct svnsync_recording_t svnsync_recording_t;
+
+/* Set *EDITOR and *EDIT_BATON to an editor that records how it gets
+ * driven in *RECORDING, so that the same drive can be played back into
+ * another editor later, e.g. from another thread.  Text deltas are kept
+ * in memory up to MEMORY_LIMIT bytes and spilled to a temporary file
+ * beyond that.  The driver must send all windows of a text delta before
+ * calling any other editor function, and close_edit() and abort_edit()
+ * are not recorded.
+ *
+ * Allocate the editor and everything it records in POOL.
+ */
+svn_error_t *
+svnsync_get_recording_editor(const svn_delta_editor_t **editor,
+                             void **edit_baton,
+                             svnsync_recording_t **recording,
+                             apr_size_t memory_limit,
+                             apr_pool_t *pool);
+
+/* Drive EDITOR and EDIT_BATON exactly like the editor that filled
+ * RECORDING was driven, except for close_edit().  RECORDING can only be
+ * played back once.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svnsync_play_recording(svnsync_recording_t *recording,
+                       const svn_delta_editor_t *editor,
+                       void *edit_baton,
+                       apr_pool_t *scratch_pool);
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -3181,6 +3181,48 @@ def commit_sees_tree_conflict_on_unversioned_path(sbox):
   os.chdir(was_cwd)
 
 
+def commit_with_commit_threads(sbox):
+  "commit file contents with commit-threads"
+
+  sbox.build()
+  wc_dir = sbox.wc_dir
+
+  changed = ['iota', 'A/mu', 'A/B/lambda', 'A/B/E/alpha', 'A/B/E/beta',
+             'A/D/gamma', 'A/D/G/pi', 'A/D/G/rho', 'A/D/G/tau',
+             'A/D/H/chi', 'A/D/H/omega', 'A/D/H/psi']
+  for path in changed:
+    sbox.simple_append(path, 'r2 change\n')
+
+  # Large enough to be sent only partly from the precomputed windows.
+  big_contents = 'abcdefghijklmnopqrstuvwxyz\n' * 100000
+  sbox.simple_add_text(big_contents, 'A/big')
+
+  expected_output = svntest.wc.State(wc_dir, {
+    'A/big' : Item(verb='Adding'),
+  })
+  for path in changed:
+    expected_output.add({path : Item(verb='Sending')})
+
+  expected_status = svntest.actions.get_virginal_state(wc_dir, 1)
+  expected_status.tweak(*changed, wc_rev=2)
+  expected_status.add({
+    'A/big' : Item(status='  ', wc_rev=2),
+  })
+
+  svntest.actions.run_and_verify_commit(wc_dir, expected_output,
+                                        expected_status, [],
+                                        wc_dir, '--config-option',
+                                        'config:miscellany:commit-threads=4')
+
+  # The repository must have received the same contents.
+  svntest.actions.run_and_verify_svn(big_contents.splitlines(True), [],
+                                     'cat', sbox.repo_url + '/A/big')
+  for path in changed:
+    expected = svntest.main.greek_state.desc[path].contents + 'r2 change\n'
+    svntest.actions.run_and_verify_svn(expected.splitlines(True), [],
+                                       'cat', sbox.repo_url + '/' + path)
+
+
 ########################################################################
 # Run the tests
 
@@ -3260,6 +3302,7 @@ test_list = [ None,
               commit_xml,
               commit_issue4722_checksum,
               commit_sees_tree_conflict_on_unversioned_path,
+              commit_with_commit_threads,
              ]
 
 if __name__ == '__main__':
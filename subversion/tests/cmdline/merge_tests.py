@@ -18511,6 +18511,62 @@ def merge_dir_delete_force(sbox):
                                      'merge', '-c2', '^/', sbox.wc_dir,
                                      '--ignore-ancestry', '--force')
 
+def merge_text_changes_concurrently(sbox):
+  "merge file contents on multiple threads"
+
+  sbox.build()
+  wc_dir = sbox.wc_dir
+
+  changed = ['iota', 'A/mu', 'A/B/lambda', 'A/D/gamma', 'A/D/G/pi',
+             'A/D/H/omega']
+  for path in changed:
+    sbox.simple_append(path, 'r2 change\n')
+  sbox.simple_commit() # r2
+
+  sbox.simple_update(revision=1)
+
+  # A local change that merges cleanly and one that conflicts.
+  mu_path = sbox.ospath('A/mu')
+  svntest.main.file_write(mu_path, "local change\n" + open(mu_path).read())
+  sbox.simple_append('A/D/gamma', 'local change\n')
+
+  svntest.actions.run_and_verify_svn(None, [],
+                                     'merge', '-c2', '^/', wc_dir,
+                                     '--config-option',
+                                     'config:miscellany:merge-threads=4')
+
+  expected_status = svntest.actions.get_virginal_state(wc_dir, 1)
+  expected_status.tweak('', status=' M')
+  expected_status.tweak(*changed, status='M ')
+  expected_status.tweak('A/D/gamma', status='C ')
+  svntest.actions.run_and_verify_status(wc_dir, expected_status)
+
+  expected_disk = svntest.main.greek_state.copy()
+  for path in changed:
+    expected_disk.tweak(path,
+                        contents=expected_disk.desc[path].contents
+                                 + "r2 change\n")
+  expected_disk.tweak('A/mu',
+                      contents="local change\n"
+                               + expected_disk.desc['A/mu'].contents)
+  expected_disk.tweak('A/D/gamma',
+                      contents="This is the file 'gamma'.\n"
+                               "<<<<<<< .working\n"
+                               "local change\n"
+                               "||||||| .merge-left.r1\n"
+                               "=======\n"
+                               "r2 change\n"
+                               ">>>>>>> .merge-right.r2\n")
+  expected_disk.add({
+    ''                           : Item(props={SVN_PROP_MERGEINFO : '/:2'}),
+    'A/D/gamma.working'          : Item(contents="This is the file 'gamma'.\n"
+                                                 "local change\n"),
+    'A/D/gamma.merge-left.r1'    : Item(contents="This is the file 'gamma'.\n"),
+    'A/D/gamma.merge-right.r2'   : Item(contents="This is the file 'gamma'.\n"
+                                                 "r2 change\n"),
+  })
+  svntest.actions.verify_disk(wc_dir, expected_disk, True)
+
 ########################################################################
 # Run the tests
 
@@ -18658,6 +18714,7 @@ test_list = [ None,
               merge_to_empty_target_merge_to_infinite_target,
               conflict_naming,
               merge_dir_delete_force,
+              merge_text_changes_concurrently,
              ]
 
 if __name__ == '__main__':
@@ -1264,6 +1264,48 @@ def fsfs_recover_handle_missing_revs_or_revprops_file(sbox):
   os.rename(revprop_was_3, revprop_3)
 
 
+@SkipUnless(svntest.main.is_fs_type_fsfs)
+def fsfs_recover_validates_unpublished_revs(sbox):
+  "fsfs recovery checks revs younger than current"
+  sbox.build(create_wc=False)
+  current_path = os.path.join(sbox.repo_dir, 'db', 'current')
+
+  svntest.actions.run_and_verify_svnmucc(None, [],
+                                         '-U', sbox.repo_url,
+                                         '-m', 'r2',
+                                         'mkdir', 'X')
+
+  rev_2 = fsfs_file(sbox.repo_dir, 'revs', '2')
+  if rev_2.endswith('pack'):
+    raise svntest.Skip('Test doesn\'t handle packed revisions')
+
+  # Simulate a commit that got interrupted after the revs file had been
+  # moved into place but before db/current got bumped and make the revs
+  # file incomplete.
+  expected_current_contents = open(current_path).read()
+  svntest.main.file_write(current_path, '1\n')
+  rev_2_contents = open(rev_2, 'rb').read()
+  os.chmod(rev_2, svntest.main.S_ALL_RW)
+  svntest.main.file_write(rev_2, rev_2_contents[:len(rev_2_contents) // 2],
+                          'wb')
+
+  exit_code, output, errput = svntest.main.run_svnadmin("recover",
+                                                        sbox.repo_dir)
+  if svntest.verify.verify_outputs(
+    "Output of 'svnadmin recover' is unexpected.", None, errput, None,
+    ".*Revision 2 has an incomplete or corrupt revs file"):
+    raise svntest.Failure
+
+  # Once the revs file is complete, recovery publishes the revision.
+  svntest.main.file_write(rev_2, rev_2_contents, 'wb')
+  svntest.actions.run_and_verify_svnadmin(None, [],
+                                          "recover", sbox.repo_dir)
+  actual_current_contents = open(current_path).read()
+  svntest.verify.compare_and_display_lines(
+    "Contents of db/current is unexpected.",
+    'db/current', expected_current_contents, actual_current_contents)
+
+
 #----------------------------------------------------------------------
 
 @Skip(svntest.main.tests_use_prepackaged_repository)
@@ -4058,6 +4100,198 @@ def build_repcache(sbox):
   if new_rep_cache != rep_cache:
     raise svntest.Failure
 
+@SkipUnless(svntest.main.is_fs_type_fsfs)
+@SkipUnless(svntest.main.fs_has_pack)
+def hotcopy_packed_concurrently(sbox):
+  "'svnadmin hotcopy --jobs' with packed shards"
+
+  # Configure two files per shard and create a few packed shards.
+  sbox.build(create_wc=False)
+  patch_format(sbox.repo_dir, shard_size=2)
+  for i in range(4):
+    svntest.actions.run_and_verify_svnmucc(None, [],
+                                           '-U', sbox.repo_url,
+                                           '-m', svntest.main.make_log_msg(),
+                                           'mkdir', 'newdir-%i' % i)
+  svntest.actions.run_and_verify_svnadmin(None, [], "pack", sbox.repo_dir)
+
+  backup_dir, backup_url = sbox.add_repo_path('backup')
+  svntest.actions.run_and_verify_svnadmin(None, [], "hotcopy",
+                                          "--jobs", "4",
+                                          sbox.repo_dir, backup_dir)
+  check_hotcopy_fsfs(sbox.repo_dir, backup_dir)
+
+  # Add and pack more shards, then update the copy incrementally.
+  for i in range(4, 8):
+    svntest.actions.run_and_verify_svnmucc(None, [],
+                                           '-U', sbox.repo_url,
+                                           '-m', svntest.main.make_log_msg(),
+                                           'mkdir', 'newdir-%i' % i)
+  svntest.actions.run_and_verify_svnadmin(None, [], "pack", sbox.repo_dir)
+
+  svntest.actions.run_and_verify_svnadmin(None, [], "hotcopy",
+                                          "--incremental", "--jobs", "4",
+                                          sbox.repo_dir, backup_dir)
+  check_hotcopy_fsfs(sbox.repo_dir, backup_dir)
+
+@SkipUnless(svntest.main.is_fs_type_fsfs)
+def build_path_index(sbox):
+  "svnadmin build-path-index"
+
+  sbox.build(create_wc=False)
+  new_file = sbox.get_tempname()
+  svntest.main.file_write(new_file, "new content\n")
+  svntest.actions.run_and_verify_svnmucc(None, [],
+                                         '-U', sbox.repo_url,
+                                         '-m', 'r2',
+                                         'put', new_file,
+                                         'A/D/G/pi')
+  svntest.actions.run_and_verify_svnmucc(None, [],
+                                         '-U', sbox.repo_url,
+                                         '-m', 'r3',
+                                         'cp', '2', 'A/D', 'A/D2')
+  svntest.actions.run_and_verify_svnmucc(None, [],
+                                         '-U', sbox.repo_url,
+                                         '-m', 'r4',
+                                         'rm', 'A/D/G/pi')
+
+  def get_logs():
+    logs = []
+    for path in ['', 'A', 'A/D2/G/pi', 'A/D/G', 'iota']:
+      for args in [[], ['--stop-on-copy'], ['-r', '1:HEAD']]:
+        exit_code, output, errput = svntest.main.run_svn(
+                                      None, 'log', '-q',
+                                      sbox.repo_url + '/' + path, *args)
+        logs.append(output)
+    return logs
+
+  expected_logs = get_logs()
+
+  # Index all existing revisions.
+  expected_output = ["* Processed revision %d.\n" % i for i in range(5)]
+  svntest.actions.run_and_verify_svnadmin(expected_output, [],
+                                          "build-path-index", sbox.repo_dir)
+  if not os.path.exists(os.path.join(sbox.repo_dir, 'db', 'path-index.db')):
+    raise svntest.Failure("path-index.db has not been created")
+
+  # Nothing left to do.
+  svntest.actions.run_and_verify_svnadmin([], [],
+                                          "build-path-index", sbox.repo_dir)
+
+  # The index must not change the results.
+  if get_logs() != expected_logs:
+    raise svntest.Failure("log output differs with path index")
+
+  # Commits keep updating the index.
+  svntest.main.file_write(new_file, "changed content\n")
+  svntest.actions.run_and_verify_svnmucc(None, [],
+                                         '-U', sbox.repo_url,
+                                         '-m', 'r5',
+                                         'put', new_file,
+                                         'A/D2/G/pi')
+  svntest.actions.run_and_verify_svnadmin([], [],
+                                          "build-path-index", sbox.repo_dir)
+  exit_code, output, errput = svntest.main.run_svn(None, 'log', '-q',
+                                                   sbox.repo_url + '/A/D2')
+  if len([line for line in output if line.startswith('r')]) != 4:
+    raise svntest.Failure("unexpected log for A/D2")
+
+@SkipUnless(svntest.main.is_fs_type_fsfs)
+def build_date_index(sbox):
+  "svnadmin build-date-index"
+
+  sbox.build(create_wc=False)
+  svntest.actions.run_and_verify_svnmucc(None, [],
+                                         '-U', sbox.repo_url,
+                                         '-m', 'r2',
+                                         'mkdir', 'X')
+  svntest.actions.run_and_verify_svnmucc(None, [],
+                                         '-U', sbox.repo_url,
+                                         '-m', 'r3',
+                                         'mkdir', 'Y')
+
+  # Give the revisions well-known dates.  This updates the index that
+  # got created together with the repository.
+  date_file = sbox.get_tempname()
+  for rev in range(4):
+    svntest.main.file_write(date_file,
+                            "200%d-01-01T00:00:00.000000Z" % rev)
+    svntest.actions.run_and_verify_svnadmin(None, [],
+                                            "setrevprop", sbox.repo_dir,
+                                            "-r", str(rev), "svn:date",
+                                            date_file)
+
+  index_path = os.path.join(sbox.repo_dir, 'db', 'rev-dates')
+  expected = { '1999-06-01' : 0,
+               '2000-01-01' : 0,
+               '2001-06-01' : 1,
+               '2002-01-01T00:00:00Z' : 2,
+               '2002-06-01' : 2,
+               '2010-01-01' : 3 }
+
+  def check_dated_revisions():
+    for date, rev in expected.items():
+      svntest.actions.run_and_verify_svn(['%d\n' % rev], [],
+                                         'info', '--show-item', 'revision',
+                                         '-r', '{%s}' % date,
+                                         sbox.repo_url)
+
+  if not os.path.exists(index_path):
+    raise svntest.Failure("rev-dates has not been created")
+  check_dated_revisions()
+
+  # Without the index, the results must be the same.
+  os.remove(index_path)
+  check_dated_revisions()
+
+  # Re-create it.
+  expected_output = ["* Processed revision %d.\n" % i for i in range(4)]
+  svntest.actions.run_and_verify_svnadmin(expected_output, [],
+                                          "build-date-index", sbox.repo_dir)
+  if not os.path.exists(index_path):
+    raise svntest.Failure("rev-dates has not been created")
+  check_dated_revisions()
+
+  # Commits keep updating the index.
+  svntest.actions.run_and_verify_svnmucc(None, [],
+                                         '-U', sbox.repo_url,
+                                         '-m', 'r4',
+                                         'mkdir', 'Z')
+  if os.path.getsize(index_path) != 8 + 5 * 8:
+    raise svntest.Failure("rev-dates has not been updated")
+  expected['2010-01-01'] = 3
+  expected['9999-01-01'] = 4
+  check_dated_revisions()
+
+
+def load_bulk(sbox):
+  "svnadmin load --bulk-load"
+
+  # Create some revisions with shared content and mergeinfo.
+  sbox.build(create_wc=False)
+  new_file = sbox.get_tempname()
+  svntest.main.file_write(new_file, "This is the file 'mu'.\n")
+  svntest.actions.run_and_verify_svnmucc(None, [],
+                                         '-U', sbox.repo_url,
+                                         '-m', 'r2',
+                                         'put', new_file, 'A/mu2',
+                                         'cp', '1', 'A/B', 'A/B2')
+  svntest.actions.run_and_verify_svnmucc(None, [],
+                                         '-U', sbox.repo_url,
+                                         '-m', 'r3',
+                                         'propset', 'svn:mergeinfo',
+                                         '/A/B:2', 'A/B2')
+  expected_dump = svntest.actions.run_and_verify_dump(sbox.repo_dir)
+
+  sbox2 = sbox.clone_dependent()
+  sbox2.build(create_wc=False, empty=True)
+  load_dumpstream(sbox2, expected_dump, '--bulk-load')
+
+  actual_dump = svntest.actions.run_and_verify_dump(sbox2.repo_dir)
+  svntest.verify.compare_dump_files(None, None, expected_dump, actual_dump)
+  svntest.actions.run_and_verify_svnadmin(None, [], "verify",
+                                          sbox2.repo_dir)
+
 
 ########################################################################
 # Run the tests
@@ -4083,6 +4317,7 @@ test_list = [ None,
               set_uuid,
               reflect_dropped_renumbered_revs,
               fsfs_recover_handle_missing_revs_or_revprops_file,
+              fsfs_recover_validates_unpublished_revs,
               create_in_repo_subdir,
               verify_with_invalid_revprops,
               dont_drop_valid_mergeinfo_during_incremental_loads,
@@ -4139,6 +4374,10 @@ test_list = [ None,
               dump_include_copied_directory,
               load_normalize_node_props,
               build_repcache,
+              hotcopy_packed_concurrently,
+              build_path_index,
+              build_date_index,
+              load_bulk,
              ]
 
 if __name__ == '__main__':
@@ -165,7 +165,8 @@ def test_stats(sbox):
                       'Histogram of directory sizes:',
                       'Histogram of directory representation sizes:',
                       'Histogram of directory property sizes:',
-                      'Histogram of directory property representation sizes:']
+                      'Histogram of directory property representation sizes:',
+                      'Histogram of delta chain lengths:']
   patterns_to_find = {
     'Reading revisions' : ['\s+ 0[ 0-9]*'],
     'Global .*'         : ['.*\d+ bytes in .*\d+ revisions',
@@ -718,6 +718,28 @@ def property_delete(sbox):
   svntest.actions.run_and_verify_svnlook(["_U  A/mu\n"], [],
                                          'changed', repo_dir)
 
+#----------------------------------------------------------------------
+def diff_max_size(sbox):
+  "test 'svnlook diff --max-size'"
+
+  sbox.build()
+  repo_dir = sbox.repo_dir
+
+  # Change A/mu beyond its first 23 bytes and iota within them.
+  sbox.simple_append('A/mu', "appended text for mu\n")
+  sbox.simple_append('iota', "That is the file 'iota'.\n", truncate=True)
+  sbox.simple_commit()
+
+  output = run_svnlook('diff', '--max-size', '23', repo_dir)
+  if "Modified: A/mu\n" in output:
+    raise svntest.Failure("Change beyond --max-size shown in "
+                          "'svnlook diff' output.")
+  if not "Modified: iota\n" in output:
+    raise svntest.Failure("Change within --max-size not shown in "
+                          "'svnlook diff' output.")
+  if not "(Only the first 23 bytes of each file are compared)\n" in output:
+    raise svntest.Failure("No truncation note in 'svnlook diff' output.")
+
 
 ########################################################################
 # Run the tests
@@ -738,6 +760,7 @@ test_list = [ None,
               test_filesize,
               test_txn_flag,
               property_delete,
+              diff_max_size,
              ]
 
 if __name__ == '__main__':
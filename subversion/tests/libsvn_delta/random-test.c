@@ -30,12 +30,16 @@
 #include <apr_general.h>
 #include <apr_getopt.h>
 #include <apr_file_io.h>
+#include <apr_md5.h>
 
 #include "../svn_test.h"
 
 #include "svn_delta.h"
 #include "svn_pools.h"
 #include "svn_error.h"
+#include "svn_sorts.h"
+
+#include "private/svn_delta_private.h"
 
 #include "../../libsvn_delta/delta.h"
 #include "delta-window-test.h"
@@ -605,6 +609,190 @@ random_txdelta_to_svndiff_stream_test(apr_pool_t *pool)
   return err;
 }
 
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+parallel_txdelta_test(apr_pool_t *pool)
+{
+  apr_uint32_t seed = 0x4d3e2f1a;
+  svn_stringbuf_t *source = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *target;
+  svn_txdelta_stream_t *expected_stream, *actual_stream;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_size_t i;
+
+  /* Data for about 10 windows.  Let the target differ from the source in
+     several places, so some windows contain copies and some don't. */
+  for (i = 0; i < 10 * SVN_DELTA_WINDOW_SIZE + 1234; ++i)
+    svn_stringbuf_appendbyte(source, (char)(svn_test_rand(&seed) % 64));
+
+  target = svn_stringbuf_dup(source, pool);
+  for (i = 0; i < target->len; i += SVN_DELTA_WINDOW_SIZE / 3)
+    target->data[i] = (char)(svn_test_rand(&seed) & 0xff);
+  svn_stringbuf_appendcstr(target, "some more data at the end");
+
+  svn_txdelta2(&expected_stream,
+               svn_stream_from_stringbuf(source, pool),
+               svn_stream_from_stringbuf(target, pool),
+               TRUE, pool);
+  svn_txdelta__parallel(&actual_stream,
+                        svn_stream_from_stringbuf(source, pool),
+                        svn_stream_from_stringbuf(target, pool),
+                        TRUE, 4, pool);
+
+  /* Both streams must produce exactly the same windows. */
+  while (TRUE)
+    {
+      svn_txdelta_window_t *expected, *actual;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_txdelta_next_window(&expected, expected_stream, iterpool));
+      SVN_ERR(svn_txdelta_next_window(&actual, actual_stream, iterpool));
+
+      if (expected == NULL)
+        {
+          SVN_TEST_ASSERT(actual == NULL);
+          break;
+        }
+
+      SVN_TEST_ASSERT(actual != NULL);
+      SVN_TEST_ASSERT(actual->sview_offset == expected->sview_offset);
+      SVN_TEST_ASSERT(actual->sview_len == expected->sview_len);
+      SVN_TEST_ASSERT(actual->tview_len == expected->tview_len);
+      SVN_TEST_ASSERT(actual->num_ops == expected->num_ops);
+      SVN_TEST_ASSERT(actual->src_ops == expected->src_ops);
+      SVN_TEST_ASSERT(memcmp(actual->ops, expected->ops,
+                             expected->num_ops * sizeof(*expected->ops))
+                      == 0);
+      SVN_TEST_ASSERT(svn_string_compare(actual->new_data,
+                                         expected->new_data));
+    }
+
+  SVN_TEST_ASSERT(svn_txdelta_md5_digest(actual_stream) != NULL);
+  SVN_TEST_ASSERT(memcmp(svn_txdelta_md5_digest(actual_stream),
+                         svn_txdelta_md5_digest(expected_stream),
+                         APR_MD5_DIGESTSIZE) == 0);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Length of the texts in compose_chain_test. */
+#define CHAIN_TEXT_LEN (16 * 1024)
+
+/* Number of windows to compose in compose_chain_test. */
+#define CHAIN_LENGTH 60
+
+/* Return a random window that transforms a text of CHAIN_TEXT_LEN bytes
+   into another one of the same length, using ops of at most MAX_OP_LEN
+   bytes.  Use and update *SEED.  Allocate the result in POOL. */
+static svn_txdelta_window_t *
+make_random_chain_window(apr_uint32_t *seed,
+                         apr_size_t max_op_len,
+                         apr_pool_t *pool)
+{
+  svn_txdelta__ops_baton_t build_baton = { 0 };
+  svn_txdelta_window_t *window;
+  char new_data[256];
+  apr_size_t tpos = 0;
+
+  build_baton.new_data = svn_stringbuf_create_empty(pool);
+  while (tpos < CHAIN_TEXT_LEN)
+    {
+      apr_size_t len = 1 + svn_test_rand(seed) % max_op_len;
+      apr_size_t offset;
+      apr_size_t i;
+
+      len = MIN(len, CHAIN_TEXT_LEN - tpos);
+      switch (svn_test_rand(seed) % 4)
+        {
+          case 0:
+          case 1:
+            offset = svn_test_rand(seed) % CHAIN_TEXT_LEN;
+            len = MIN(len, CHAIN_TEXT_LEN - offset);
+            svn_txdelta__insert_op(&build_baton, svn_txdelta_source,
+                                   offset, len, NULL, pool);
+            break;
+
+          case 2:
+            if (tpos > 0)
+              {
+                /* Target copies may overlap their own output. */
+                offset = svn_test_rand(seed) % tpos;
+                svn_txdelta__insert_op(&build_baton, svn_txdelta_target,
+                                       offset, len, NULL, pool);
+                break;
+              }
+            /* fall through */
+
+          default:
+            len = MIN(len, sizeof(new_data));
+            for (i = 0; i < len; ++i)
+              new_data[i] = (char)svn_test_rand(seed);
+            svn_txdelta__insert_op(&build_baton, svn_txdelta_new,
+                                   0, len, new_data, pool);
+            break;
+        }
+
+      tpos += len;
+    }
+
+  window = svn_txdelta__make_window(&build_baton, pool);
+  window->sview_offset = 0;
+  window->sview_len = CHAIN_TEXT_LEN;
+  window->tview_len = CHAIN_TEXT_LEN;
+
+  return window;
+}
+
+/* Implements svn_test_driver2_t. */
+static svn_error_t *
+compose_chain_test(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  apr_uint32_t seed = 0x1b2c3d4e;
+  char *text = apr_palloc(pool, CHAIN_TEXT_LEN);
+  char *base = apr_palloc(pool, CHAIN_TEXT_LEN);
+  char *result = apr_palloc(pool, CHAIN_TEXT_LEN);
+  svn_txdelta_window_t *windows[CHAIN_LENGTH];
+  svn_txdelta_window_t *composite;
+  apr_time_t start;
+  apr_size_t len;
+  int i;
+
+  for (i = 0; i < CHAIN_TEXT_LEN; ++i)
+    base[i] = (char)svn_test_rand(&seed);
+
+  /* Alternate between windows with a few long and many short ops, so
+     the composition uses both types of range index. */
+  memcpy(text, base, CHAIN_TEXT_LEN);
+  for (i = 0; i < CHAIN_LENGTH; ++i)
+    {
+      windows[i] = make_random_chain_window(&seed, i % 2 ? 200 : 10, pool);
+
+      len = CHAIN_TEXT_LEN;
+      svn_txdelta_apply_instructions(windows[i], text, result, &len);
+      SVN_TEST_ASSERT(len == CHAIN_TEXT_LEN);
+      memcpy(text, result, CHAIN_TEXT_LEN);
+    }
+
+  start = apr_time_now();
+  composite = windows[0];
+  for (i = 1; i < CHAIN_LENGTH; ++i)
+    composite = svn_txdelta_compose_windows(composite, windows[i], pool);
+
+  if (opts->verbose)
+    printf("composed %d windows in %" APR_TIME_T_FMT " usec\n",
+           CHAIN_LENGTH, apr_time_now() - start);
+
+  /* Applying the composite to the base must give the final text. */
+  len = CHAIN_TEXT_LEN;
+  svn_txdelta_apply_instructions(composite, base, result, &len);
+  SVN_TEST_ASSERT(len == CHAIN_TEXT_LEN);
+  SVN_TEST_ASSERT(memcmp(text, result, CHAIN_TEXT_LEN) == 0);
+
+  return SVN_NO_ERROR;
+}
+
 /* Change to 1 to enable the unit test for the delta combiner's range index: */
 #if 0
 #include "range-index-test.h"
@@ -625,6 +813,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "random combine delta test"),
     SVN_TEST_PASS2(random_txdelta_to_svndiff_stream_test,
                    "random txdelta to svndiff stream test"),
+    SVN_TEST_PASS2(parallel_txdelta_test,
+                   "parallel txdelta stream"),
+    SVN_TEST_OPTS_PASS(compose_chain_test,
+                       "compose a long chain of windows"),
 #ifdef SVN_RANGE_INDEX_TEST_H
     SVN_TEST_PASS2(random_range_index_test,
                    "random range index test"),
@@ -22,6 +22,8 @@
  */
 
 #include "svn_delta.h"
+#include "svn_pools.h"
+#include "private/svn_delta_private.h"
 #include "../svn_test.h"
 
 static svn_error_t *
@@ -66,6 +68,183 @@ test_txdelta_to_svndiff_stream_small_reads(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_decode_svndiff_window_in_place(apr_pool_t *pool)
+{
+  int version;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  for (version = 0; version <= 3; version++)
+    {
+      svn_stringbuf_t *source, *target, *svndiff;
+      svn_txdelta_stream_t *txstream;
+      svn_txdelta_window_handler_t handler;
+      void *handler_baton;
+      svn_stream_t *stream;
+      svn_txdelta__window_decoder_t *decoder;
+      apr_size_t pos;
+      int i;
+
+      svn_pool_clear(iterpool);
+      source = svn_stringbuf_create_empty(iterpool);
+      target = svn_stringbuf_create_empty(iterpool);
+      svndiff = svn_stringbuf_create_empty(iterpool);
+
+      /* Make sure we get several windows with all kinds of instructions. */
+      for (i = 0; i < 20000; i++)
+        {
+          svn_stringbuf_appendcstr(source,
+                                   apr_psprintf(iterpool, "line %d\n", i));
+          svn_stringbuf_appendcstr(target,
+                                   apr_psprintf(iterpool, "line %d%s\n", i,
+                                                i % 7 ? "" : " changed"));
+        }
+
+      svn_txdelta2(&txstream,
+                   svn_stream_from_stringbuf(source, iterpool),
+                   svn_stream_from_stringbuf(target, iterpool),
+                   FALSE, iterpool);
+      svn_txdelta_to_svndiff3(&handler, &handler_baton,
+                              svn_stream_from_stringbuf(svndiff, iterpool),
+                              version, SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                              iterpool);
+      SVN_ERR(svn_txdelta_send_txstream(txstream, handler, handler_baton,
+                                        iterpool));
+
+      /* Decode the windows from memory and compare them with what the
+         stream-based parser produces. */
+      stream = svn_stream_from_stringbuf(svndiff, iterpool);
+      SVN_ERR(svn_stream_skip(stream, 4));
+      decoder = svn_txdelta__window_decoder_create(FALSE, iterpool);
+
+      for (pos = 4; pos < svndiff->len; )
+        {
+          svn_txdelta_window_t *window;
+          svn_txdelta_window_t *expected;
+          apr_size_t window_len;
+
+          SVN_ERR(svn_txdelta__decode_svndiff_window(&window, &window_len,
+                                                     decoder,
+                                                     svndiff->data + pos,
+                                                     svndiff->len - pos,
+                                                     version));
+          SVN_ERR(svn_txdelta_read_svndiff_window(&expected, stream,
+                                                  version, iterpool));
+
+          SVN_TEST_ASSERT(window->sview_offset == expected->sview_offset);
+          SVN_TEST_ASSERT(window->sview_len == expected->sview_len);
+          SVN_TEST_ASSERT(window->tview_len == expected->tview_len);
+          SVN_TEST_INT_ASSERT(window->num_ops, expected->num_ops);
+          SVN_TEST_INT_ASSERT(window->src_ops, expected->src_ops);
+          SVN_TEST_ASSERT(memcmp(window->ops, expected->ops,
+                                 window->num_ops * sizeof(*window->ops))
+                          == 0);
+          SVN_TEST_ASSERT(window->new_data->len == expected->new_data->len);
+          SVN_TEST_ASSERT(memcmp(window->new_data->data,
+                                 expected->new_data->data,
+                                 window->new_data->len) == 0);
+
+          pos += window_len;
+        }
+
+      SVN_TEST_ASSERT(pos == svndiff->len);
+
+      /* Truncated input must be detected. */
+      if (svndiff->len > 5)
+        {
+          svn_txdelta_window_t *window;
+          apr_size_t window_len;
+
+          SVN_TEST_ASSERT_ERROR(
+            svn_txdelta__decode_svndiff_window(&window, &window_len,
+                                               decoder, svndiff->data + 4,
+                                               1, version),
+            SVN_ERR_SVNDIFF_UNEXPECTED_END);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_svndiff_reader_peek_release(apr_pool_t *pool)
+{
+  int version;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  for (version = 0; version <= 3; version++)
+    {
+      svn_stringbuf_t *source, *target, *expected, *actual;
+      svn_txdelta_stream_t *txstream;
+      svn_txdelta_window_handler_t handler;
+      void *handler_baton;
+      svn_txdelta__svndiff_reader_t *reader;
+      int i;
+
+      svn_pool_clear(iterpool);
+      source = svn_stringbuf_create_empty(iterpool);
+      target = svn_stringbuf_create_empty(iterpool);
+      expected = svn_stringbuf_create_empty(iterpool);
+      actual = svn_stringbuf_create_empty(iterpool);
+
+      for (i = 0; i < 20000; i++)
+        {
+          svn_stringbuf_appendcstr(source,
+                                   apr_psprintf(iterpool, "line %d\n", i));
+          svn_stringbuf_appendcstr(target,
+                                   apr_psprintf(iterpool, "line %d%s\n", i,
+                                                i % 7 ? "" : " changed"));
+        }
+
+      svn_txdelta2(&txstream,
+                   svn_stream_from_stringbuf(source, iterpool),
+                   svn_stream_from_stringbuf(target, iterpool),
+                   FALSE, iterpool);
+      svn_txdelta_to_svndiff3(&handler, &handler_baton,
+                              svn_stream_from_stringbuf(expected, iterpool),
+                              version, SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                              iterpool);
+      SVN_ERR(svn_txdelta_send_txstream(txstream, handler, handler_baton,
+                                        iterpool));
+
+      /* Consume the lent buffers in odd-sized pieces. */
+      svn_txdelta2(&txstream,
+                   svn_stream_from_stringbuf(source, iterpool),
+                   svn_stream_from_stringbuf(target, iterpool),
+                   FALSE, iterpool);
+      reader = svn_txdelta__svndiff_reader_create(
+                 txstream, version, SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                 iterpool);
+
+      while (TRUE)
+        {
+          const char *data, *again;
+          apr_size_t len, again_len;
+
+          SVN_ERR(svn_txdelta__svndiff_reader_peek(&data, &len, reader));
+          if (len == 0)
+            break;
+
+          /* Peeking without releasing returns the same buffer. */
+          SVN_ERR(svn_txdelta__svndiff_reader_peek(&again, &again_len,
+                                                   reader));
+          SVN_TEST_ASSERT(again == data && again_len == len);
+
+          if (len > 777)
+            len = 777;
+
+          svn_stringbuf_appendbytes(actual, data, len);
+          svn_txdelta__svndiff_reader_release(reader, len);
+        }
+
+      SVN_TEST_ASSERT(svn_stringbuf_compare(actual, expected));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = -1;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -73,6 +252,10 @@ static struct svn_test_descriptor_t test_funcs[] =
   SVN_TEST_NULL,
   SVN_TEST_PASS2(test_txdelta_to_svndiff_stream_small_reads,
                  "test svn_txdelta_to_svndiff_stream() small reads"),
+  SVN_TEST_PASS2(test_decode_svndiff_window_in_place,
+                 "test decoding svndiff windows from memory"),
+  SVN_TEST_PASS2(test_svndiff_reader_peek_release,
+                 "test lending encoded svndiff windows"),
   SVN_TEST_NULL
 };
 
@@ -29,6 +29,7 @@
 #include "svn_error.h"
 #include "svn_delta.h"
 
+#include "private/svn_delta_private.h"
 #include "private/svn_subr_private.h"
 
 static svn_error_t *
@@ -97,6 +98,222 @@ stream_window_test(apr_pool_t *pool)
 }
 
 
+/* Baton for large_window_test's window handler. */
+typedef struct window_stats_t
+{
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  apr_size_t max_tview_len;
+} window_stats_t;
+
+/* Implements svn_txdelta_window_handler_t.  Record the window size and
+   forward WINDOW to the handler in BATON. */
+static svn_error_t *
+record_window(svn_txdelta_window_t *window,
+              void *baton)
+{
+  window_stats_t *stats = baton;
+
+  if (window && window->tview_len > stats->max_tview_len)
+    stats->max_tview_len = window->tview_len;
+
+  return stats->handler(window, stats->handler_baton);
+}
+
+/* Set *DELTA_SIZE to the size of the svndiff data for the txdelta FORMAT
+   delta between SOURCE and TARGET, using the requested WINDOW_SIZE.
+   Verify that the delta reproduces TARGET and return the size of the
+   largest target view in *MAX_TVIEW_LEN. */
+static svn_error_t *
+check_delta(apr_size_t *delta_size,
+            apr_size_t *max_tview_len,
+            const svn_string_t *source,
+            const svn_string_t *target,
+            int format,
+            apr_size_t window_size,
+            apr_pool_t *pool)
+{
+  svn_stringbuf_t *svndiff = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(pool);
+  window_stats_t stats = { 0 };
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  svn_stream_t *stream;
+  apr_size_t len;
+
+  /* Create the delta. */
+  svn_txdelta_to_svndiff3(&stats.handler, &stats.handler_baton,
+                          svn_stream_from_stringbuf(svndiff, pool),
+                          0, 0, pool);
+  stream = svn_txdelta__target_push(record_window, &stats,
+                                    svn_stream_from_string(source, pool),
+                                    format, window_size, pool);
+  len = target->len;
+  SVN_ERR(svn_stream_write(stream, target->data, &len));
+  SVN_ERR(svn_stream_close(stream));
+
+  /* Apply it again. */
+  svn_txdelta_apply(svn_stream_from_string(source, pool),
+                    svn_stream_from_stringbuf(result, pool),
+                    NULL, NULL, pool, &handler, &handler_baton);
+  stream = svn_txdelta_parse_svndiff(handler, handler_baton, TRUE, pool);
+  len = svndiff->len;
+  SVN_ERR(svn_stream_write(stream, svndiff->data, &len));
+  SVN_ERR(svn_stream_close(stream));
+
+  SVN_TEST_ASSERT(result->len == target->len);
+  SVN_TEST_ASSERT(memcmp(result->data, target->data, target->len) == 0);
+
+  *delta_size = svndiff->len;
+  *max_tview_len = stats.max_tview_len;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+large_window_test(apr_pool_t *pool)
+{
+  enum { SOURCE_SIZE = 3 * 1024 * 1024, INSERT_SIZE = 300 * 1024 };
+  svn_stringbuf_t *source = svn_stringbuf_create_ensure(SOURCE_SIZE, pool);
+  svn_stringbuf_t *target;
+  svn_string_t source_str, target_str;
+  apr_size_t v1_size, v2_size, v1_tview, v2_tview;
+  apr_uint32_t seed = 0x12345678;
+  apr_size_t i;
+
+  /* Incompressible pseudo-random content. */
+  for (i = 0; i < SOURCE_SIZE; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      svn_stringbuf_appendbyte(source, (char)(seed >> 16));
+    }
+
+  /* Insert data near the start such that the rest of the content moves
+     by more than a classic window but less than a large one. */
+  target = svn_stringbuf_create_ensure(SOURCE_SIZE + INSERT_SIZE, pool);
+  svn_stringbuf_appendbytes(target, source->data, 1000);
+  svn_stringbuf_appendbytes(target, source->data + SOURCE_SIZE - INSERT_SIZE,
+                            INSERT_SIZE);
+  svn_stringbuf_appendbytes(target, source->data + 1000,
+                            SOURCE_SIZE - 1000);
+
+  source_str.data = source->data;
+  source_str.len = source->len;
+  target_str.data = target->data;
+  target_str.len = target->len;
+
+  SVN_ERR(check_delta(&v1_size, &v1_tview, &source_str, &target_str, 1, 0,
+                      pool));
+  SVN_ERR(check_delta(&v2_size, &v2_tview, &source_str, &target_str, 2, 0,
+                      pool));
+
+  SVN_TEST_ASSERT(v1_tview == 102400);
+  SVN_TEST_ASSERT(v2_tview == 1024 * 1024);
+
+  /* The classic windows can't find the moved data at all.  The large
+     windows need to store little more than the inserted data. */
+  SVN_TEST_ASSERT(v1_size > SOURCE_SIZE / 2);
+  SVN_TEST_ASSERT(v2_size < 2 * INSERT_SIZE);
+
+  /* Explicit window sizes get clipped to the supported range. */
+  SVN_ERR(check_delta(&v1_size, &v1_tview, &source_str, &target_str, 1,
+                      SOURCE_SIZE, pool));
+  SVN_TEST_ASSERT(v1_tview == 1024 * 1024);
+  SVN_ERR(check_delta(&v1_size, &v1_tview, &source_str, &target_str, 1,
+                      1000, pool));
+  SVN_TEST_ASSERT(v1_tview == 4096);
+  SVN_ERR(check_delta(&v2_size, &v2_tview, &source_str, &target_str, 2,
+                      65536, pool));
+  SVN_TEST_ASSERT(v2_tview == 65536);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Size of the target views in apply_instructions_test. */
+#define APPLY_TVIEW_LEN (100 * 1024)
+
+/* Number of times apply_instructions_test applies each window when
+   measuring throughput. */
+#define APPLY_ITERATIONS 200
+
+static svn_error_t *
+apply_instructions_test(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  static const apr_size_t periods[] = { 1, 2, 3, 4, 7, 8, 16, 31, 100, 4097 };
+  char *expected = apr_palloc(pool, APPLY_TVIEW_LEN);
+  char *actual = apr_palloc(pool, APPLY_TVIEW_LEN);
+  svn_string_t new_data;
+  svn_txdelta_op_t ops[2];
+  svn_txdelta_window_t window = { 0 };
+  char pattern[5000];
+  int i, k;
+
+  for (i = 0; i < (int)sizeof(pattern); ++i)
+    pattern[i] = (char)('a' + i % 26 + i / 26 % 3);
+
+  new_data.data = pattern;
+  window.ops = ops;
+  window.num_ops = 2;
+  window.new_data = &new_data;
+  window.tview_len = APPLY_TVIEW_LEN;
+
+  /* Target copies that overlap their own output and repeat the
+     pattern given by the initial new data. */
+  for (k = 0; k < (int)(sizeof(periods) / sizeof(periods[0])); ++k)
+    {
+      apr_size_t period = periods[k];
+      apr_size_t len = APPLY_TVIEW_LEN;
+      apr_size_t j;
+
+      new_data.len = period;
+      ops[0].action_code = svn_txdelta_new;
+      ops[0].offset = 0;
+      ops[0].length = period;
+      ops[1].action_code = svn_txdelta_target;
+      ops[1].offset = 0;
+      ops[1].length = APPLY_TVIEW_LEN - period;
+
+      for (j = 0; j < APPLY_TVIEW_LEN; ++j)
+        expected[j] = pattern[j % period];
+
+      memset(actual, 0, APPLY_TVIEW_LEN);
+      svn_txdelta_apply_instructions(&window, NULL, actual, &len);
+      SVN_TEST_ASSERT(len == APPLY_TVIEW_LEN);
+      SVN_TEST_ASSERT(memcmp(expected, actual, APPLY_TVIEW_LEN) == 0);
+
+      /* A target copy that does not start at the beginning of the
+         pattern and gets truncated by the output buffer size. */
+      len = APPLY_TVIEW_LEN / 2 + 1;
+      ops[1].offset = period / 2;
+      memset(actual, 0, APPLY_TVIEW_LEN);
+      svn_txdelta_apply_instructions(&window, NULL, actual, &len);
+      SVN_TEST_ASSERT(len == APPLY_TVIEW_LEN / 2 + 1);
+      for (j = period; j < len; ++j)
+        SVN_TEST_ASSERT(actual[j] == actual[j - period + period / 2]);
+
+      /* Report the throughput for full-size windows. */
+      if (opts->verbose)
+        {
+          apr_time_t start = apr_time_now();
+
+          ops[1].offset = 0;
+          for (i = 0; i < APPLY_ITERATIONS; ++i)
+            {
+              len = APPLY_TVIEW_LEN;
+              svn_txdelta_apply_instructions(&window, NULL, actual, &len);
+            }
+
+          printf("period %5" APR_SIZE_T_FMT ": %8.1f MB/s\n", period,
+                 (double)APPLY_TVIEW_LEN * APPLY_ITERATIONS
+                 / (apr_time_now() - start + 1));
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
 
 /* The test table.  */
 
@@ -107,6 +324,10 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_NULL,
     SVN_TEST_PASS2(stream_window_test,
                    "txdelta stream and windows test"),
+    SVN_TEST_PASS2(large_window_test,
+                   "txdelta format 2 windows"),
+    SVN_TEST_OPTS_PASS(apply_instructions_test,
+                       "apply overlapping target copies"),
     SVN_TEST_NULL
   };
 
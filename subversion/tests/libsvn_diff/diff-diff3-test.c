@@ -2693,6 +2693,56 @@ test_token_compare(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Identical prefix and suffix spanning several chunks, with mixed eol
+   styles that end up at varying offsets within machine words.
+   The magic number 1<<17 is CHUNK_SIZE from ../../libsvn_diff/diff_file.c.
+ */
+#define MIXED_EOL_LINES "abcdefghijklmnop\r\n" "abc\r" "abcdefg\n"
+static svn_error_t *
+test_identical_prefix_mixed_eols(apr_pool_t *pool)
+{
+  /* Each pattern is 3 lines and 30 bytes. */
+  apr_size_t patterns = (1 << 17) / (sizeof(MIXED_EOL_LINES) - 1) + 100;
+  svn_stringbuf_t *common, *original, *modified;
+  apr_size_t i;
+
+  common = svn_stringbuf_create_ensure(patterns
+                                       * (sizeof(MIXED_EOL_LINES) - 1),
+                                       pool);
+  for (i = 0; i < patterns; i++)
+    svn_stringbuf_appendbytes(common, MIXED_EOL_LINES,
+                              sizeof(MIXED_EOL_LINES) - 1);
+
+  original = svn_stringbuf_dup(common, pool);
+  svn_stringbuf_appendcstr(original, "original\n");
+  svn_stringbuf_appendstr(original, common);
+
+  modified = svn_stringbuf_dup(common, pool);
+  svn_stringbuf_appendcstr(modified, "modified\r\n");
+  svn_stringbuf_appendstr(modified, common);
+
+  SVN_ERR(two_way_diff("mixed-eols-original", "mixed-eols-modified",
+                       original->data, modified->data,
+                       apr_psprintf(pool,
+                                    "--- mixed-eols-original" NL
+                                    "+++ mixed-eols-modified" NL
+                                    "@@ -%u,7 +%u,7 @@" NL
+                                    " abcdefghijklmnop\r\n"
+                                    " abc\r"
+                                    " abcdefg\n"
+                                    "-original\n"
+                                    "+modified\r\n"
+                                    " abcdefghijklmnop\r\n"
+                                    " abc\r"
+                                    " abcdefg\n",
+                                    3 * (unsigned int)patterns - 2,
+                                    3 * (unsigned int)patterns - 2),
+                       NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+#undef MIXED_EOL_LINES
+
 static svn_error_t *
 two_way_issue_3362_v1(apr_pool_t *pool)
 {
@@ -2952,6 +3002,63 @@ two_way_issue_3362_v2(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* The minimal diff matches the repeated lines, while the patience
+   algorithm anchors the diff at the lines that occur once in each file. */
+static svn_error_t *
+test_diff_algorithms(apr_pool_t *pool)
+{
+  svn_diff_file_options_t *diff_opts = svn_diff_file_options_create(pool);
+  apr_array_header_t *args = apr_array_make(pool, 1, sizeof(const char *));
+
+  SVN_ERR(two_way_diff("algorithm-original", "algorithm-minimal",
+                       "u\np\np\np\nv\n",
+                       "v\np\np\np\nu\n",
+                       "--- algorithm-original" NL
+                       "+++ algorithm-minimal" NL
+                       "@@ -1,5 +1,5 @@" NL
+                       "-u\n"
+                       "+v\n"
+                       " p\n"
+                       " p\n"
+                       " p\n"
+                       "-v\n"
+                       "+u\n",
+                       diff_opts, pool));
+
+  APR_ARRAY_PUSH(args, const char *) = "--patience";
+  SVN_ERR(svn_diff_file_options_parse(diff_opts, args, pool));
+  SVN_TEST_ASSERT(diff_opts->algorithm == svn_diff_file_algorithm_patience);
+
+  SVN_ERR(two_way_diff("algorithm-original", "algorithm-patience",
+                       "u\np\np\np\nv\n",
+                       "v\np\np\np\nu\n",
+                       "--- algorithm-original" NL
+                       "+++ algorithm-patience" NL
+                       "@@ -1,5 +1,5 @@" NL
+                       "-u\n"
+                       "-p\n"
+                       "-p\n"
+                       "-p\n"
+                       " v\n"
+                       "+p\n"
+                       "+p\n"
+                       "+p\n"
+                       "+u\n",
+                       diff_opts, pool));
+
+  SVN_ERR(three_way_merge("algorithm-merge1", "algorithm-merge2",
+                          "algorithm-merge3",
+                          "a\nb\nc\nd\ne\n",
+                          "a\nB\nc\nd\ne\n",
+                          "a\nb\nc\nd\nE\n",
+                          "a\nB\nc\nd\nE\n",
+                          diff_opts,
+                          svn_diff_conflict_display_modified_latest,
+                          pool));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 three_way_double_add(apr_pool_t *pool)
 {
@@ -3103,10 +3210,14 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "identical suffix starts at the boundary of a chunk"),
     SVN_TEST_PASS2(test_token_compare,
                    "compare tokens at the chunk boundary"),
+    SVN_TEST_PASS2(test_identical_prefix_mixed_eols,
+                   "identical prefix and suffix with mixed eols"),
     SVN_TEST_PASS2(two_way_issue_3362_v1,
                    "2-way issue #3362 test v1"),
     SVN_TEST_PASS2(two_way_issue_3362_v2,
                    "2-way issue #3362 test v2"),
+    SVN_TEST_PASS2(test_diff_algorithms,
+                   "minimal and patience diff algorithms"),
     SVN_TEST_XFAIL2(three_way_double_add,
                    "3-way merge, double add"),
     SVN_TEST_NULL
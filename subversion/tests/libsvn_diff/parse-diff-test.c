@@ -1104,6 +1104,139 @@ test_parse_unidiff_with_mergeinfo(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Check the hunks of a patch that is larger than the parser's buffer,
+ * reading them back to front so that the buffer has to move backwards. */
+static svn_error_t *
+test_parse_large_unidiff(apr_pool_t *pool)
+{
+  const int hunk_count = 5000;
+  svn_stringbuf_t *diff;
+  svn_patch_file_t *patch_file;
+  svn_patch_t *patch;
+  apr_pool_t *iterpool;
+  int i;
+
+  diff = svn_stringbuf_create("--- A/mu\r\n+++ A/mu\r\n", pool);
+  for (i = 0; i < hunk_count; i++)
+    svn_stringbuf_appendcstr(diff,
+                             apr_psprintf(pool,
+                                          "@@ -%d,2 +%d,2 @@\r\n"
+                                          " context line %d\r\n"
+                                          "-original line %d\r\n"
+                                          "+modified line %d\r\n",
+                                          i * 10 + 1, i * 10 + 1, i, i, i));
+
+  SVN_ERR(create_patch_file(&patch_file, diff->data, pool));
+  SVN_ERR(svn_diff_parse_next_patch(&patch, patch_file, FALSE, FALSE,
+                                    pool, pool));
+  SVN_TEST_ASSERT(patch);
+  SVN_TEST_STRING_ASSERT(patch->old_filename, "A/mu");
+  SVN_TEST_ASSERT(patch->hunks->nelts == hunk_count);
+
+  iterpool = svn_pool_create(pool);
+  for (i = hunk_count - 1; i >= 0; i--)
+    {
+      svn_diff_hunk_t *hunk = APR_ARRAY_IDX(patch->hunks, i,
+                                            svn_diff_hunk_t *);
+      svn_stringbuf_t *line;
+      const char *eol;
+      svn_boolean_t eof;
+
+      svn_pool_clear(iterpool);
+
+      SVN_TEST_ASSERT(svn_diff_hunk_get_original_start(hunk) == i * 10 + 1);
+
+      SVN_ERR(svn_diff_hunk_readline_original_text(hunk, &line, &eol, &eof,
+                                                   iterpool, iterpool));
+      SVN_TEST_STRING_ASSERT(line->data,
+                             apr_psprintf(iterpool, "context line %d", i));
+      SVN_TEST_STRING_ASSERT(eol, "\r\n");
+      SVN_ERR(svn_diff_hunk_readline_original_text(hunk, &line, &eol, &eof,
+                                                   iterpool, iterpool));
+      SVN_TEST_STRING_ASSERT(line->data,
+                             apr_psprintf(iterpool, "original line %d", i));
+      SVN_TEST_STRING_ASSERT(eol, "\r\n");
+      SVN_ERR(svn_diff_hunk_readline_original_text(hunk, &line, &eol, &eof,
+                                                   iterpool, iterpool));
+      SVN_TEST_ASSERT(eof);
+
+      SVN_ERR(svn_diff_hunk_readline_modified_text(hunk, &line, &eol, &eof,
+                                                   iterpool, iterpool));
+      SVN_TEST_STRING_ASSERT(line->data,
+                             apr_psprintf(iterpool, "context line %d", i));
+      SVN_ERR(svn_diff_hunk_readline_modified_text(hunk, &line, &eol, &eof,
+                                                   iterpool, iterpool));
+      SVN_TEST_STRING_ASSERT(line->data,
+                             apr_psprintf(iterpool, "modified line %d", i));
+      SVN_TEST_STRING_ASSERT(eol, "\r\n");
+    }
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_diff_parse_next_patch(&patch, patch_file, FALSE, FALSE,
+                                    pool, pool));
+  SVN_TEST_ASSERT(patch == NULL);
+
+  SVN_ERR(svn_diff_close_patch_file(patch_file, pool));
+  return SVN_NO_ERROR;
+}
+
+/* Check that a binary diff written by svn_diff_output_binary() reads back
+ * correctly.  The content doesn't compress, so it is large enough for the
+ * writer to spill to disk. */
+static svn_error_t *
+test_binary_diff_roundtrip(apr_pool_t *pool)
+{
+  const apr_size_t size = 1536 * 1024;
+  svn_stringbuf_t *original = svn_stringbuf_create_ensure(size, pool);
+  svn_stringbuf_t *latest;
+  svn_stringbuf_t *diff;
+  svn_stringbuf_t *result;
+  svn_patch_file_t *patch_file;
+  svn_patch_t *patch;
+  apr_uint32_t seed = 0;
+  apr_size_t i;
+
+  for (i = 0; i < size; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      svn_stringbuf_appendbyte(original, (char)(seed >> 16));
+    }
+
+  latest = svn_stringbuf_dup(original, pool);
+  for (i = 0; i < size; i += 4096)
+    latest->data[i] ^= 0x55;
+  svn_stringbuf_appendcstr(latest, "trailing data");
+
+  diff = svn_stringbuf_create("diff --git a/foo.bin b/foo.bin" NL, pool);
+  SVN_ERR(svn_diff_output_binary(svn_stream_from_stringbuf(diff, pool),
+                                 svn_stream_from_stringbuf(original, pool),
+                                 svn_stream_from_stringbuf(latest, pool),
+                                 NULL, NULL, pool));
+
+  SVN_ERR(create_patch_file(&patch_file, diff->data, pool));
+  SVN_ERR(svn_diff_parse_next_patch(&patch, patch_file, FALSE, FALSE,
+                                    pool, pool));
+  SVN_TEST_ASSERT(patch);
+  SVN_TEST_ASSERT(patch->binary_patch);
+
+  SVN_ERR(svn_stringbuf_from_stream(
+            &result,
+            svn_diff_get_binary_diff_original_stream(patch->binary_patch,
+                                                     pool),
+            size, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(result, original));
+
+  SVN_ERR(svn_stringbuf_from_stream(
+            &result,
+            svn_diff_get_binary_diff_result_stream(patch->binary_patch,
+                                                   pool),
+            size, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(result, latest));
+
+  SVN_ERR(svn_diff_close_patch_file(patch_file, pool));
+  return SVN_NO_ERROR;
+}
+
 /* ========================================================================== */
 
 
@@ -1132,6 +1265,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test parsing unidiffs lacking trailing eol"),
     SVN_TEST_PASS2(test_parse_unidiff_with_mergeinfo,
                    "test parsing unidiffs with mergeinfo"),
+    SVN_TEST_PASS2(test_parse_large_unidiff,
+                   "test parsing unidiffs larger than the buffer"),
+    SVN_TEST_PASS2(test_binary_diff_roundtrip,
+                   "test writing and parsing large binary diffs"),
     SVN_TEST_NULL
   };
 
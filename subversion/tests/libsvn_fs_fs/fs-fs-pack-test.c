@@ -27,16 +27,22 @@
 #include "../svn_test.h"
 #include "../../libsvn_fs/fs-loader.h"
 #include "../../libsvn_fs_fs/fs.h"
+#include "../../libsvn_fs_fs/cached_data.h"
 #include "../../libsvn_fs_fs/fs_fs.h"
 #include "../../libsvn_fs_fs/low_level.h"
 #include "../../libsvn_fs_fs/pack.h"
+#include "../../libsvn_fs_fs/path-index.h"
 #include "../../libsvn_fs_fs/util.h"
 
 #include "svn_hash.h"
+#include "svn_mergeinfo.h"
 #include "svn_pools.h"
 #include "svn_props.h"
+#include "svn_sorts.h"
 #include "svn_fs.h"
+#include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
+#include "private/svn_fs_fs_private.h"
 
 #include "../svn_test_fs.h"
 
@@ -290,7 +296,7 @@ pack_filesystem(const svn_test_opts_t *opts,
      don't. */
   for (i = 0; i < (MAX_REV + 1) / SHARD_SIZE; i++)
     {
-      path = svn_dirent_join_many(pool, REPO_NAME, "revs",
+      path = svn_dirent_join_many(pool, REPO_NAME, PATH_REVS_DIR,
                                   apr_psprintf(pool, "%d.pack", i / SHARD_SIZE),
                                   "pack", SVN_VA_NULL);
 
@@ -302,7 +308,7 @@ pack_filesystem(const svn_test_opts_t *opts,
 
       if (opts->server_minor_version && (opts->server_minor_version < 9))
         {
-          path = svn_dirent_join_many(pool, REPO_NAME, "revs",
+          path = svn_dirent_join_many(pool, REPO_NAME, PATH_REVS_DIR,
                                       apr_psprintf(pool, "%d.pack", i / SHARD_SIZE),
                                       "manifest", SVN_VA_NULL);
           SVN_ERR(svn_io_check_path(path, &kind, pool));
@@ -313,7 +319,7 @@ pack_filesystem(const svn_test_opts_t *opts,
         }
 
       /* This directory should not exist. */
-      path = svn_dirent_join_many(pool, REPO_NAME, "revs",
+      path = svn_dirent_join_many(pool, REPO_NAME, PATH_REVS_DIR,
                                   apr_psprintf(pool, "%d", i / SHARD_SIZE),
                                   SVN_VA_NULL);
       SVN_ERR(svn_io_check_path(path, &kind, pool));
@@ -335,7 +341,7 @@ pack_filesystem(const svn_test_opts_t *opts,
                              "Bad '%s' contents", PATH_MIN_UNPACKED_REV);
 
   /* Finally, make sure the final revision directory does exist. */
-  path = svn_dirent_join_many(pool, REPO_NAME, "revs",
+  path = svn_dirent_join_many(pool, REPO_NAME, PATH_REVS_DIR,
                               apr_psprintf(pool, "%d", (i / SHARD_SIZE) + 1),
                               SVN_VA_NULL);
   SVN_ERR(svn_io_check_path(path, &kind, pool));
@@ -364,7 +370,7 @@ pack_even_filesystem(const svn_test_opts_t *opts,
   SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
                                    pool));
 
-  path = svn_dirent_join_many(pool, REPO_NAME, "revs", "2.pack", SVN_VA_NULL);
+  path = svn_dirent_join_many(pool, REPO_NAME, PATH_REVS_DIR, "2.pack", SVN_VA_NULL);
   SVN_ERR(svn_io_check_path(path, &kind, pool));
   if (kind != svn_node_dir)
     return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
@@ -1445,9 +1451,13 @@ multiply_string(const char *s,
   return temp->data;
 }
 
+/* Create a repository at REPO_NAME and verify that identical contents
+   get shared.  Enable the rep-cache filter if USE_FILTER is set. */
 static svn_error_t *
-rep_sharing_effectiveness(const svn_test_opts_t *opts,
-                          apr_pool_t *pool)
+check_rep_sharing(const svn_test_opts_t *opts,
+                  const char *repo_name,
+                  svn_boolean_t use_filter,
+                  apr_pool_t *pool)
 {
   svn_fs_t *fs;
   fs_fs_data_t *ffd;
@@ -1462,13 +1472,14 @@ rep_sharing_effectiveness(const svn_test_opts_t *opts,
     return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
 
   /* Create a repo that and explicitly enable rep sharing. */
-  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_test__create_fs(&fs, repo_name, opts, pool));
 
   ffd = fs->fsap_data;
   if (ffd->format < SVN_FS_FS__MIN_REP_SHARING_FORMAT)
     return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
 
   ffd->rep_sharing_allowed = TRUE;
+  ffd->use_rep_cache_filter = use_filter;
 
   /* Revision 1: create 2 files with different content. */
   SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
@@ -1559,6 +1570,26 @@ rep_sharing_effectiveness(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+rep_sharing_effectiveness(const svn_test_opts_t *opts,
+                          apr_pool_t *pool)
+{
+  return svn_error_trace(check_rep_sharing(opts, REPO_NAME, FALSE, pool));
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-rep_sharing_with_filter"
+
+static svn_error_t *
+rep_sharing_with_filter(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  return svn_error_trace(check_rep_sharing(opts, REPO_NAME, TRUE, pool));
+}
+
 #undef REPO_NAME
 
 /* ------------------------------------------------------------------------ */
@@ -1812,6 +1843,252 @@ pack_with_limited_memory(const svn_test_opts_t *opts,
 #undef MAX_REV
 #undef SHARD_SIZE
 
+/* ------------------------------------------------------------------------ */
+/* Verify a repository with packed and non-packed shards concurrently. */
+#define REPO_NAME "test-repo-verify_concurrently"
+#define SHARD_SIZE 4
+#define MAX_REV (5 * SHARD_SIZE + 2)
+static svn_error_t *
+verify_concurrently(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  apr_hash_t *fs_config;
+  int jobs;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (opts->server_minor_version && (opts->server_minor_version < 15))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.15 SVN doesn't support concurrent verify");
+
+  /* All but the last shard will be packed. */
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+
+  for (jobs = 1; jobs <= 8; jobs *= 2)
+    {
+      fs_config = apr_hash_make(pool);
+      svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_VERIFY_JOBS,
+                    apr_itoa(pool, jobs));
+
+      /* Full range as well as ranges that don't align with shards. */
+      SVN_ERR(svn_fs_verify(REPO_NAME, fs_config,
+                            SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                            NULL, NULL, NULL, NULL, pool));
+      SVN_ERR(svn_fs_verify(REPO_NAME, fs_config, 1, MAX_REV - 1,
+                            NULL, NULL, NULL, NULL, pool));
+      SVN_ERR(svn_fs_verify(REPO_NAME, fs_config, 2, 3,
+                            NULL, NULL, NULL, NULL, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+
+/* ------------------------------------------------------------------------ */
+/* Pack a repository concurrently and with throttled I/O. */
+#define REPO_NAME "test-repo-pack_concurrently"
+#define SHARD_SIZE 4
+#define MAX_REV (5 * SHARD_SIZE + 2)
+static svn_error_t *
+pack_concurrently(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  const char *config = "\n[" CONFIG_SECTION_PACK "]\n"
+                       CONFIG_OPTION_MAX_IO_RATE " = 102400\n";
+  struct pack_notify_baton pnb;
+  apr_hash_t *fs_config;
+  apr_file_t *file;
+  svn_fs_t *fs;
+  svn_revnum_t i;
+  apr_pool_t *iterpool;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (opts->server_minor_version && (opts->server_minor_version < 15))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.15 SVN doesn't support concurrent pack");
+
+  SVN_ERR(create_non_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                       pool));
+
+  /* Set a generous I/O limit, just to exercise the throttling code. */
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, config, strlen(config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  /* Notifications must still arrive in shard order. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_PACK_JOBS, "4");
+
+  pnb.expected_shard = 0;
+  pnb.expected_action = svn_fs_pack_notify_start;
+  SVN_ERR(svn_fs_pack2(REPO_NAME, fs_config, pack_notify, &pnb, NULL, NULL,
+                       pool));
+  SVN_TEST_ASSERT(pnb.expected_shard == MAX_REV / SHARD_SIZE);
+
+  /* All contents must have survived. */
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, SVN_INVALID_REVNUM,
+                        SVN_INVALID_REVNUM, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  iterpool = svn_pool_create(pool);
+  for (i = 2; i <= MAX_REV; i++)
+    {
+      svn_fs_root_t *rev_root;
+      svn_stream_t *rstream;
+      svn_stringbuf_t *rstring;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, iterpool));
+      SVN_ERR(svn_fs_file_contents(&rstream, rev_root, "iota", iterpool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, iterpool));
+      SVN_TEST_STRING_ASSERT(rstring->data, get_rev_contents(i, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-read_mapped_pack_files"
+#define SHARD_SIZE 4
+#define MAX_REV (3 * SHARD_SIZE + 1)
+static svn_error_t *
+read_mapped_pack_files(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  const char *config = "\n[" CONFIG_SECTION_IO "]\n"
+                       CONFIG_OPTION_MMAP_PACKED_FILES " = true\n";
+  apr_file_t *file;
+  svn_fs_t *fs;
+  svn_revnum_t i;
+  apr_pool_t *iterpool;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (opts->server_minor_version && (opts->server_minor_version < 15))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.15 SVN doesn't support mapped pack files");
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, config, strlen(config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  /* Everything must still be readable, whether the platform actually
+   * supports memory mapping the pack files or not. */
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, SVN_INVALID_REVNUM,
+                        SVN_INVALID_REVNUM, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  iterpool = svn_pool_create(pool);
+  for (i = 2; i <= MAX_REV; i++)
+    {
+      svn_fs_root_t *rev_root;
+      svn_stream_t *rstream;
+      svn_stringbuf_t *rstring;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, iterpool));
+      SVN_ERR(svn_fs_file_contents(&rstream, rev_root, "iota", iterpool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, iterpool));
+      SVN_TEST_STRING_ASSERT(rstring->data, get_rev_contents(i, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-shared_l2p_tables"
+#define SHARD_SIZE 4
+#define MAX_REV (3 * SHARD_SIZE + 1)
+static svn_error_t *
+shared_l2p_tables(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  const char *config = "\n[" CONFIG_SECTION_IO "]\n"
+                       CONFIG_OPTION_SHARED_L2P_TABLES " = true\n";
+  apr_file_t *file;
+  svn_fs_t *fs;
+  svn_node_kind_t kind;
+  svn_revnum_t i;
+  apr_pool_t *iterpool;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 15)))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.15 SVN doesn't support shared L2P tables");
+
+  SVN_ERR(create_non_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                       pool));
+
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, config, strlen(config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  SVN_ERR(svn_fs_pack2(REPO_NAME, NULL, NULL, NULL, NULL, NULL, pool));
+
+  /* Only format 7 repositories have L2P indexes. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_io_check_path(svn_dirent_join_many(pool, REPO_NAME,
+                                                 PATH_REVS_DIR, "0.pack",
+                                                 PATH_L2P_TABLE,
+                                                 SVN_VA_NULL),
+                            &kind, pool));
+  if (svn_fs_fs__use_log_addressing(fs))
+    SVN_TEST_ASSERT(kind == svn_node_file);
+  else
+    SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* All contents must be accessible through the tables. */
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, SVN_INVALID_REVNUM,
+                        SVN_INVALID_REVNUM, NULL, NULL, NULL, NULL, pool));
+
+  iterpool = svn_pool_create(pool);
+  for (i = 2; i <= MAX_REV; i++)
+    {
+      svn_fs_root_t *rev_root;
+      svn_stream_t *rstream;
+      svn_stringbuf_t *rstring;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, iterpool));
+      SVN_ERR(svn_fs_file_contents(&rstream, rev_root, "iota", iterpool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, iterpool));
+      SVN_TEST_STRING_ASSERT(rstring->data, get_rev_contents(i, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+
 /* ------------------------------------------------------------------------ */
 
 #define REPO_NAME "test-repo-large_delta_against_plain"
@@ -1888,6 +2165,1541 @@ large_delta_against_plain(const svn_test_opts_t *opts,
 
 #undef REPO_NAME
 
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-indexed_directories"
+#define ENTRY_COUNT 1000
+
+static svn_error_t *
+indexed_directories(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  apr_hash_t *fs_config;
+  apr_hash_t *entries;
+  svn_node_kind_t kind;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* Revision 1: a directory with many files and sub-directories. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(root, "/dir", pool));
+  for (i = 0; i < ENTRY_COUNT; ++i)
+    {
+      const char *path;
+
+      svn_pool_clear(iterpool);
+      path = apr_psprintf(iterpool, "/dir/e%04d", i);
+      if (i % 10)
+        SVN_ERR(svn_fs_make_file(root, path, iterpool));
+      else
+        SVN_ERR(svn_fs_make_dir(root, path, iterpool));
+    }
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Single entry lookups must work without reading the whole directory
+   * first.  To make sure we actually read from disk, use a new FS instance
+   * with disjoint caches. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                           svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+
+  for (i = 0; i < ENTRY_COUNT; i += 7)
+    {
+      const char *path;
+
+      svn_pool_clear(iterpool);
+      path = apr_psprintf(iterpool, "/dir/e%04d", i);
+      SVN_ERR(svn_fs_check_path(&kind, root, path, iterpool));
+      SVN_TEST_ASSERT(kind == (i % 10 ? svn_node_file : svn_node_dir));
+    }
+
+  /* Names before, between and after the existing entries. */
+  SVN_ERR(svn_fs_check_path(&kind, root, "/dir/a", pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  SVN_ERR(svn_fs_check_path(&kind, root, "/dir/e0001a", pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  SVN_ERR(svn_fs_check_path(&kind, root, "/dir/z", pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* The full listing must still be complete. */
+  SVN_ERR(svn_fs_dir_entries(&entries, root, "/dir", pool));
+  SVN_TEST_ASSERT(apr_hash_count(entries) == ENTRY_COUNT);
+  SVN_ERR(svn_fs_check_path(&kind, root, "/dir/e0999", pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  /* Modifying a directory stored in the new format must work as well. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_delete(root, "/dir/e0500", pool));
+  SVN_ERR(svn_fs_make_file(root, "/dir/e0500a", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_fs_check_path(&kind, root, "/dir/e0500", pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  SVN_ERR(svn_fs_check_path(&kind, root, "/dir/e0500a", pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+  SVN_ERR(svn_fs_dir_entries(&entries, root, "/dir", pool));
+  SVN_TEST_ASSERT(apr_hash_count(entries) == ENTRY_COUNT);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef ENTRY_COUNT
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-delta_chain_size_limit"
+#define MAX_REV 10
+
+static svn_error_t *
+delta_chain_size_limit(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  const char *config = "\n[" CONFIG_SECTION_DELTIFICATION "]\n"
+                       CONFIG_OPTION_MAX_DELTA_CHAIN_SIZE " = 1\n";
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  apr_file_t *file;
+  svn_fs_fs__stats_t *stats;
+  svn_stringbuf_t *contents = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *read_back;
+  apr_uint32_t seed = 0;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i, k;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* Limit the delta chains to 1 kB of data to read. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, config, strlen(config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  /* Grow a file by some poorly compressible data in each revision.
+   * Without the limit, each version would be a delta against the
+   * previous one. */
+  for (rev = 0; rev < MAX_REV; )
+    {
+      svn_pool_clear(iterpool);
+
+      for (k = 0; k < 4096; ++k)
+        {
+          seed = seed * 1103515245 + 12345;
+          svn_stringbuf_appendbyte(contents,
+                                   "0123456789abcdef"[(seed >> 16) & 0xf]);
+        }
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      if (rev == 0)
+        SVN_ERR(svn_fs_make_file(root, "/file", iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, "/file", contents->data,
+                                          iterpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, iterpool));
+    }
+
+  /* No long delta chains must have been created. */
+  SVN_ERR(svn_fs_fs__get_stats(&stats, fs, 1, NULL, NULL, NULL, NULL,
+                               pool, pool));
+  for (i = 3; i < 64; ++i)
+    SVN_TEST_ASSERT(stats->chain_length_histogram.lines[i].count == 0);
+
+  /* All contents must still be intact. */
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "/file", &read_back, pool));
+  SVN_TEST_STRING_ASSERT(read_back->data, contents->data);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-packed_revprops_across_refresh"
+#define SHARD_SIZE 4
+#define MAX_REV 10
+
+static svn_error_t *
+packed_revprops_across_refresh(const svn_test_opts_t *opts,
+                               apr_pool_t *pool)
+{
+  const char *config = "\n[" CONFIG_SECTION_IO "]\n"
+                       CONFIG_OPTION_MMAP_PACKED_FILES " = true\n";
+  apr_file_t *file;
+  svn_fs_t *fs, *fs2;
+  svn_string_t *prop_value;
+  svn_revnum_t rev;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (opts->server_minor_version && (opts->server_minor_version < 15))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.15 SVN doesn't map packed revprops");
+
+  /* Create the packed FS and access it through two separate handles. */
+  SVN_ERR(prepare_revprop_repo(&fs, REPO_NAME, MAX_REV, SHARD_SIZE, opts,
+                               pool));
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, config, strlen(config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_open2(&fs2, REPO_NAME, NULL, pool, pool));
+
+  for (rev = 1; rev <= MAX_REV; ++rev)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_change_rev_prop2(fs2, rev, SVN_PROP_REVISION_LOG, NULL,
+                                      default_log(rev, iterpool),
+                                      iterpool));
+    }
+
+  /* Read all revprops once to populate the caches. */
+  for (rev = 1; rev <= MAX_REV; ++rev)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_prop2(&prop_value, fs, rev,
+                                    SVN_PROP_REVISION_LOG, FALSE,
+                                    iterpool, iterpool));
+      SVN_TEST_STRING_ASSERT(prop_value->data,
+                             default_log(rev, iterpool)->data);
+    }
+
+  /* Rewrite the pack file of the second shard behind FS's back. */
+  SVN_ERR(svn_fs_change_rev_prop2(fs2, 6, SVN_PROP_REVISION_LOG, NULL,
+                                  svn_string_create("tweaked-log", pool),
+                                  pool));
+
+  /* After a refresh, all packs must be read consistently - whether they
+   * changed or not. */
+  SVN_ERR(svn_fs_refresh_revision_props(fs, pool));
+  for (rev = 1; rev <= MAX_REV; ++rev)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_prop2(&prop_value, fs, rev,
+                                    SVN_PROP_REVISION_LOG, FALSE,
+                                    iterpool, iterpool));
+      SVN_TEST_STRING_ASSERT(prop_value->data,
+                             rev == 6 ? "tweaked-log"
+                                      : default_log(rev, iterpool)->data);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+
+/* ------------------------------------------------------------------------ */
+/* Gather repository statistics with concurrent scans. */
+#define REPO_NAME "test-repo-stats_concurrently"
+#define SHARD_SIZE 4
+#define MAX_REV (5 * SHARD_SIZE + 2)
+
+/* Assert that the histograms LHS and RHS are identical. */
+static svn_error_t *
+compare_histograms(const svn_fs_fs__histogram_t *lhs,
+                   const svn_fs_fs__histogram_t *rhs)
+{
+  int i;
+
+  SVN_TEST_ASSERT(lhs->total.count == rhs->total.count);
+  SVN_TEST_ASSERT(lhs->total.sum == rhs->total.sum);
+  for (i = 0; i < 64; ++i)
+    {
+      SVN_TEST_ASSERT(lhs->lines[i].count == rhs->lines[i].count);
+      SVN_TEST_ASSERT(lhs->lines[i].sum == rhs->lines[i].sum);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+stats_concurrently(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_fs__stats_t *expected;
+  int jobs, i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 15)))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.15 SVN doesn't support concurrent stats");
+
+  /* All but the last shard will be packed. */
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  /* Sequential scan as the reference. */
+  SVN_ERR(svn_fs_fs__get_stats(&expected, fs, 1, NULL, NULL, NULL, NULL,
+                               pool, pool));
+  SVN_TEST_ASSERT(expected->revision_count == MAX_REV + 1);
+  SVN_TEST_ASSERT(expected->shards->nelts == MAX_REV / SHARD_SIZE + 1);
+
+  for (jobs = 2; jobs <= 8; jobs *= 2)
+    {
+      svn_fs_fs__stats_t *stats;
+
+      SVN_ERR(svn_fs_fs__get_stats(&stats, fs, jobs, NULL, NULL, NULL, NULL,
+                                   pool, pool));
+
+      SVN_TEST_ASSERT(stats->total_size == expected->total_size);
+      SVN_TEST_ASSERT(stats->revision_count == expected->revision_count);
+      SVN_TEST_ASSERT(stats->change_count == expected->change_count);
+      SVN_TEST_ASSERT(stats->change_len == expected->change_len);
+      SVN_TEST_ASSERT(stats->total_rep_stats.chain_len
+                      == expected->total_rep_stats.chain_len);
+      SVN_TEST_ASSERT(stats->total_rep_stats.references
+                      == expected->total_rep_stats.references);
+      SVN_TEST_ASSERT(stats->total_node_stats.count
+                      == expected->total_node_stats.count);
+      SVN_ERR(compare_histograms(&stats->rep_size_histogram,
+                                 &expected->rep_size_histogram));
+      SVN_ERR(compare_histograms(&stats->chain_length_histogram,
+                                 &expected->chain_length_histogram));
+
+      SVN_TEST_ASSERT(stats->shards->nelts == expected->shards->nelts);
+      for (i = 0; i < stats->shards->nelts; ++i)
+        {
+          const svn_fs_fs__shard_stats_t *shard
+            = APR_ARRAY_IDX(stats->shards, i, svn_fs_fs__shard_stats_t *);
+          const svn_fs_fs__shard_stats_t *expected_shard
+            = APR_ARRAY_IDX(expected->shards, i, svn_fs_fs__shard_stats_t *);
+
+          SVN_TEST_ASSERT(shard->first_revision == i * SHARD_SIZE);
+          SVN_TEST_ASSERT(shard->total_size == expected_shard->total_size);
+          SVN_TEST_ASSERT(shard->noderev_count
+                          == expected_shard->noderev_count);
+          SVN_TEST_ASSERT(shard->rep_count == expected_shard->rep_count);
+          SVN_TEST_ASSERT(shard->rep_size == expected_shard->rep_size);
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+
+/* ------------------------------------------------------------------------ */
+/* Record FSFS item accesses in the runtime access trace. */
+#define REPO_NAME "test-repo-access_trace"
+#define SHARD_SIZE 4
+#define MAX_REV 5
+
+/* Set the capacity of the FSFS access trace to CAPACITY. */
+static svn_error_t *
+set_access_trace(int capacity,
+                 apr_pool_t *pool)
+{
+  svn_fs_fs__ioctl_set_access_trace_input_t input;
+  input.capacity = capacity;
+
+  return svn_error_trace(svn_fs_ioctl(NULL, SVN_FS_FS__IOCTL_SET_ACCESS_TRACE,
+                                      &input, NULL, NULL, NULL, pool, pool));
+}
+
+/* Fetch and clear the FSFS access trace and return the number of entries
+ * for the filesystem at FS_PATH in *COUNT.  Other tests may run
+ * concurrently, so ignore all other entries. */
+static svn_error_t *
+count_access_trace(int *count,
+                   const char *fs_path,
+                   apr_pool_t *pool)
+{
+  svn_fs_fs__ioctl_get_access_trace_input_t input = { TRUE };
+  svn_fs_fs__ioctl_get_access_trace_output_t *output;
+  int i;
+
+  SVN_ERR(svn_fs_ioctl(NULL, SVN_FS_FS__IOCTL_GET_ACCESS_TRACE,
+                       &input, (void **)&output, NULL, NULL, pool, pool));
+
+  *count = 0;
+  for (i = 0; i < output->entries->nelts; ++i)
+    {
+      const svn_fs_fs__access_trace_entry_t *entry
+        = APR_ARRAY_IDX(output->entries, i,
+                        const svn_fs_fs__access_trace_entry_t *);
+
+      if (strcmp(entry->fs_path, fs_path))
+        continue;
+
+      SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(entry->revision));
+      SVN_TEST_ASSERT(entry->revision <= MAX_REV);
+      SVN_TEST_ASSERT(entry->latency >= 0);
+      ++*count;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the contents of "iota" in all revisions of FS. */
+static svn_error_t *
+read_all_iota(svn_fs_t *fs,
+              apr_pool_t *pool)
+{
+  svn_revnum_t rev;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  for (rev = 1; rev <= MAX_REV; ++rev)
+    {
+      svn_fs_root_t *root;
+      svn_stream_t *stream;
+      svn_stringbuf_t *contents;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, iterpool));
+      SVN_ERR(svn_fs_file_contents(&stream, root, "iota", iterpool));
+      SVN_ERR(svn_stringbuf_from_stream(&contents, stream, 0, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+access_trace(const svn_test_opts_t *opts,
+             apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  const char *fs_path;
+  int count;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 15)))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.15 SVN doesn't support access tracing");
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  fs_path = svn_fs_path(fs, pool);
+
+  /* Nothing gets recorded by default. */
+  SVN_ERR(read_all_iota(fs, pool));
+  SVN_ERR(count_access_trace(&count, fs_path, pool));
+  SVN_TEST_ASSERT(count == 0);
+
+  /* Once enabled, reading will leave a trace - no matter whether the data
+   * came from disk or from cache. */
+  SVN_ERR(set_access_trace(1000, pool));
+  SVN_ERR(read_all_iota(fs, pool));
+  SVN_ERR(count_access_trace(&count, fs_path, pool));
+  SVN_TEST_ASSERT(count > 0);
+
+  /* The previous call cleared the trace. */
+  SVN_ERR(count_access_trace(&count, fs_path, pool));
+  SVN_TEST_ASSERT(count == 0);
+
+  /* The capacity is a hard limit. */
+  SVN_ERR(set_access_trace(2, pool));
+  SVN_ERR(read_all_iota(fs, pool));
+  SVN_ERR(count_access_trace(&count, fs_path, pool));
+  SVN_TEST_ASSERT(count <= 2);
+
+  /* Disable it again. */
+  SVN_ERR(set_access_trace(0, pool));
+  SVN_ERR(read_all_iota(fs, pool));
+  SVN_ERR(count_access_trace(&count, fs_path, pool));
+  SVN_TEST_ASSERT(count == 0);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+
+/* ------------------------------------------------------------------------ */
+/* Maintain and query the per-path revision index. */
+#define REPO_NAME "test-repo-path_index"
+
+/* Query FS's path index for PATH in the revision range START to END and
+ * verify that it returns the EXPECTED_CHANGE and EXPECTED_CREATION
+ * revisions. */
+static svn_error_t *
+check_path_index(svn_fs_t *fs,
+                 const char *path,
+                 svn_revnum_t start,
+                 svn_revnum_t end,
+                 svn_revnum_t expected_change,
+                 svn_revnum_t expected_creation,
+                 apr_pool_t *pool)
+{
+  svn_fs_fs__ioctl_path_index_prev_input_t input;
+  svn_fs_fs__ioctl_path_index_prev_output_t *output;
+
+  input.path = path;
+  input.start = start;
+  input.end = end;
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_PATH_INDEX_PREV, &input,
+                       (void **)&output, NULL, NULL, pool, pool));
+
+  SVN_TEST_ASSERT(output->available);
+  SVN_TEST_INT_ASSERT(output->change_rev, expected_change);
+  SVN_TEST_INT_ASSERT(output->creation_rev, expected_creation);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+path_index(const svn_test_opts_t *opts,
+           apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t rev;
+  svn_fs_fs__ioctl_build_path_index_input_t build_input = { 0 };
+  svn_fs_fs__ioctl_path_index_prev_input_t input;
+  svn_fs_fs__ioctl_path_index_prev_output_t *output;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 15)))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.15 SVN doesn't support path indexes");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* r1: greek tree */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r2: modify A/D/G/pi */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/D/G/pi", "new pi\n",
+                                      pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Without an index, there is nothing to query. */
+  input.path = "/A";
+  input.start = 0;
+  input.end = rev;
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_PATH_INDEX_PREV, &input,
+                       (void **)&output, NULL, NULL, pool, pool));
+  SVN_TEST_ASSERT(!output->available);
+
+  /* Index the existing revisions. */
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_BUILD_PATH_INDEX, &build_input,
+                       NULL, NULL, NULL, pool, pool));
+
+  /* r3: modify iota */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", "new iota\n",
+                                      pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r4: copy A/D to A/D2 */
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, rev, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "A/D", txn_root, "A/D2", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r5: modify A/D2/G/rho */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/D2/G/rho", "new rho\n",
+                                      pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Commits keep the index up to date. */
+  SVN_ERR(check_path_index(fs, "/", 0, 5, 5, SVN_INVALID_REVNUM, pool));
+  SVN_ERR(check_path_index(fs, "/A/D/G/pi", 0, 5, 2, 1, pool));
+  SVN_ERR(check_path_index(fs, "/A/D/G", 0, 5, 2, 1, pool));
+  SVN_ERR(check_path_index(fs, "/A/D/G", 3, 5, SVN_INVALID_REVNUM,
+                           SVN_INVALID_REVNUM, pool));
+  SVN_ERR(check_path_index(fs, "/iota", 0, 5, 3, 1, pool));
+  SVN_ERR(check_path_index(fs, "/iota", 0, 2, 1, 1, pool));
+  SVN_ERR(check_path_index(fs, "/A", 0, 5, 5, 1, pool));
+  SVN_ERR(check_path_index(fs, "/A/D2/G/rho", 0, 5, 5, 4, pool));
+
+  /* Copies only list the copy target. */
+  SVN_ERR(check_path_index(fs, "A/D2/G", 0, 4, SVN_INVALID_REVNUM, 4, pool));
+
+  /* The index does not cover future revisions. */
+  input.path = "/A";
+  input.start = 0;
+  input.end = rev + 1;
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_PATH_INDEX_PREV, &input,
+                       (void **)&output, NULL, NULL, pool, pool));
+  SVN_TEST_ASSERT(!output->available);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+/* Look up copy sources in the per-path revision index. */
+#define REPO_NAME "test-repo-path_index_copies"
+
+/* Query FS's path index for the origin of the node at PATH in REVISION
+ * and verify that it returns EXPECTED_APPEARED as well as the
+ * EXPECTED_COPYFROM_PATH and EXPECTED_COPYFROM_REV. */
+static svn_error_t *
+check_path_index_copy(svn_fs_t *fs,
+                      const char *path,
+                      svn_revnum_t revision,
+                      svn_revnum_t expected_appeared,
+                      const char *expected_copyfrom_path,
+                      svn_revnum_t expected_copyfrom_rev,
+                      apr_pool_t *pool)
+{
+  svn_fs_fs__ioctl_path_index_prev_copy_input_t input;
+  svn_fs_fs__ioctl_path_index_prev_copy_output_t *output;
+
+  input.path = path;
+  input.revision = revision;
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_PATH_INDEX_PREV_COPY, &input,
+                       (void **)&output, NULL, NULL, pool, pool));
+
+  SVN_TEST_ASSERT(output->available);
+  SVN_TEST_INT_ASSERT(output->appeared_rev, expected_appeared);
+  SVN_TEST_STRING_ASSERT(output->copyfrom_path, expected_copyfrom_path);
+  SVN_TEST_INT_ASSERT(output->copyfrom_rev, expected_copyfrom_rev);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+path_index_copies(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t rev;
+  svn_fs_fs__ioctl_build_path_index_input_t build_input = { 0 };
+  svn_fs_fs__ioctl_path_index_prev_copy_input_t input;
+  svn_fs_fs__ioctl_path_index_prev_copy_output_t *output;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 15)))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.15 SVN doesn't support path indexes");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* r1: greek tree */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Index the existing revisions. */
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_BUILD_PATH_INDEX, &build_input,
+                       NULL, NULL, NULL, pool, pool));
+
+  /* r2: copy A/D to A/D2 */
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, rev, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "A/D", txn_root, "A/D2", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r3: modify A/D2/G/rho and add A/D2/new */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/D2/G/rho", "new rho\n",
+                                      pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "A/D2/new", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r4: copy A/D2/G/rho to rho2 */
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, rev, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "A/D2/G/rho", txn_root, "rho2", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r5: replace A/D2/H without history and add a file to it */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/D2/H", pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "A/D2/H", pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "A/D2/H/x", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Nodes that have never been copied. */
+  SVN_ERR(check_path_index_copy(fs, "/", 5, 0, NULL, SVN_INVALID_REVNUM,
+                                pool));
+  SVN_ERR(check_path_index_copy(fs, "/A/mu", 5, 1, NULL, SVN_INVALID_REVNUM,
+                                pool));
+  SVN_ERR(check_path_index_copy(fs, "/A/D2/new", 5, 3, NULL,
+                                SVN_INVALID_REVNUM, pool));
+  SVN_ERR(check_path_index_copy(fs, "/A/D2/H", 5, 5, NULL,
+                                SVN_INVALID_REVNUM, pool));
+  SVN_ERR(check_path_index_copy(fs, "/A/D2/H/x", 5, 5, NULL,
+                                SVN_INVALID_REVNUM, pool));
+
+  /* Copies of the node itself or of one of its parents. */
+  SVN_ERR(check_path_index_copy(fs, "/A/D2", 2, 2, "/A/D", 1, pool));
+  SVN_ERR(check_path_index_copy(fs, "/A/D2/G/rho", 5, 2, "/A/D/G/rho", 1,
+                                pool));
+  SVN_ERR(check_path_index_copy(fs, "/rho2", 4, 4, "/A/D2/G/rho", 3,
+                                pool));
+
+  /* Before the replacement, A/D2/H came from the copy. */
+  SVN_ERR(check_path_index_copy(fs, "/A/D2/H", 4, 2, "/A/D/H", 1, pool));
+
+  /* The index does not cover future revisions. */
+  input.path = "/A";
+  input.revision = rev + 1;
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_PATH_INDEX_PREV_COPY, &input,
+                       (void **)&output, NULL, NULL, pool, pool));
+  SVN_TEST_ASSERT(!output->available);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+
+
+/* ------------------------------------------------------------------------ */
+/* Look up node deletions in the per-path revision index. */
+#define REPO_NAME "test-repo-path_index_deleted_rev"
+
+/* Query FS's path index for the deletion of PATH@START up to END and
+ * verify that it returns EXPECTED_DELETED. */
+static svn_error_t *
+check_path_index_deleted_rev(svn_fs_t *fs,
+                             const char *path,
+                             svn_revnum_t start,
+                             svn_revnum_t end,
+                             svn_revnum_t expected_deleted,
+                             apr_pool_t *pool)
+{
+  svn_fs_fs__ioctl_path_index_deleted_rev_input_t input;
+  svn_fs_fs__ioctl_path_index_deleted_rev_output_t *output;
+
+  input.path = path;
+  input.start = start;
+  input.end = end;
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_PATH_INDEX_DELETED_REV, &input,
+                       (void **)&output, NULL, NULL, pool, pool));
+
+  SVN_TEST_ASSERT(output->available);
+  SVN_TEST_INT_ASSERT(output->deleted, expected_deleted);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+path_index_deleted_rev(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t rev;
+  svn_fs_fs__ioctl_build_path_index_input_t build_input = { 0 };
+  svn_fs_fs__ioctl_path_index_deleted_rev_input_t input;
+  svn_fs_fs__ioctl_path_index_deleted_rev_output_t *output;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 15)))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.15 SVN doesn't support path indexes");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* r1: greek tree */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Index the existing revisions. */
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_BUILD_PATH_INDEX, &build_input,
+                       NULL, NULL, NULL, pool, pool));
+
+  /* r2: delete A/D/G/pi */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/D/G/pi", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r3: replace A/B with a copy of itself */
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, rev, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/B", pool));
+  SVN_ERR(svn_fs_copy(rev_root, "A/B", txn_root, "A/B", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r4: modify iota */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", "new iota\n",
+                                      pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r5: delete A/D */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/D", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Deletions of the node itself or of one of its parents. */
+  SVN_ERR(check_path_index_deleted_rev(fs, "/A/D/G/pi", 1, 5, 2, pool));
+  SVN_ERR(check_path_index_deleted_rev(fs, "/A/D/G/rho", 1, 5, 5, pool));
+  SVN_ERR(check_path_index_deleted_rev(fs, "A/D", 2, 5, 5, pool));
+
+  /* Replacements count as deletions, even by a copy of the same node. */
+  SVN_ERR(check_path_index_deleted_rev(fs, "/A/B", 1, 5, 3, pool));
+  SVN_ERR(check_path_index_deleted_rev(fs, "/A/B/E/alpha", 1, 5, 3, pool));
+
+  /* Nodes that survive the range. */
+  SVN_ERR(check_path_index_deleted_rev(fs, "/A/B/E/alpha", 3, 5,
+                                       SVN_INVALID_REVNUM, pool));
+  SVN_ERR(check_path_index_deleted_rev(fs, "/iota", 1, 5,
+                                       SVN_INVALID_REVNUM, pool));
+  SVN_ERR(check_path_index_deleted_rev(fs, "/A/D/H", 1, 4,
+                                       SVN_INVALID_REVNUM, pool));
+
+  /* The index does not cover future revisions. */
+  input.path = "/A";
+  input.start = 1;
+  input.end = rev + 1;
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_PATH_INDEX_DELETED_REV, &input,
+                       (void **)&output, NULL, NULL, pool, pool));
+  SVN_TEST_ASSERT(!output->available);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+
+
+/* ------------------------------------------------------------------------ */
+/* Read mergeinfo catalogs from the per-path revision index. */
+#define REPO_NAME "test-repo-path_index_mergeinfo"
+
+/* Implements svn_fs_mergeinfo_receiver_t, adding the unparsed MERGEINFO
+ * for PATH to the apr_hash_t in BATON. */
+static svn_error_t *
+collect_mergeinfo_receiver(const char *path,
+                           svn_mergeinfo_t mergeinfo,
+                           void *baton,
+                           apr_pool_t *scratch_pool)
+{
+  apr_hash_t *catalog = baton;
+  apr_pool_t *result_pool = apr_hash_pool_get(catalog);
+  svn_string_t *mergeinfo_string;
+
+  SVN_ERR(svn_mergeinfo_to_string(&mergeinfo_string, mergeinfo,
+                                  result_pool));
+  svn_hash_sets(catalog, apr_pstrdup(result_pool, path),
+                mergeinfo_string->data);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the explicit mergeinfo of PATH and all its descendants in
+ * REVISION of FS as "PATH=MERGEINFO\n" lines, sorted by path, in *RESULT.
+ * Allocate it in POOL. */
+static svn_error_t *
+get_mergeinfo_lines(const char **result,
+                    svn_fs_t *fs,
+                    svn_revnum_t revision,
+                    const char *path,
+                    apr_pool_t *pool)
+{
+  svn_fs_root_t *root;
+  apr_array_header_t *paths = apr_array_make(pool, 1, sizeof(const char *));
+  apr_hash_t *catalog = apr_hash_make(pool);
+  apr_array_header_t *sorted;
+  svn_stringbuf_t *lines = svn_stringbuf_create_empty(pool);
+  int i;
+
+  APR_ARRAY_PUSH(paths, const char *) = path;
+  SVN_ERR(svn_fs_revision_root(&root, fs, revision, pool));
+  SVN_ERR(svn_fs_get_mergeinfo3(root, paths, svn_mergeinfo_explicit, TRUE,
+                                FALSE, collect_mergeinfo_receiver, catalog,
+                                pool));
+
+  sorted = svn_sort__hash(catalog, svn_sort_compare_items_as_paths, pool);
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+      svn_stringbuf_appendcstr(lines, item->key);
+      svn_stringbuf_appendbyte(lines, '=');
+      svn_stringbuf_appendcstr(lines, item->value);
+      svn_stringbuf_appendbyte(lines, '\n');
+    }
+
+  *result = lines->data;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_fs_mergeinfo_receiver_t, doing nothing. */
+static svn_error_t *
+ignore_mergeinfo_receiver(const char *path,
+                          svn_mergeinfo_t mergeinfo,
+                          void *baton,
+                          apr_pool_t *scratch_pool)
+{
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+path_index_mergeinfo(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t rev;
+  svn_fs_fs__ioctl_build_path_index_input_t build_input = { 0 };
+  svn_boolean_t available;
+  const char *indexed[6][2];
+  const char *lines;
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 15)))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.15 SVN doesn't support path indexes");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* r1: greek tree */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r2: add mergeinfo to A/B, A/D/G and A/D/H/psi */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/B", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/trunk/B:1", pool),
+                                  pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/D/G", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/x:1", pool), pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/D/H/psi", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/y:1", pool), pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Index the existing revisions. */
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_BUILD_PATH_INDEX, &build_input,
+                       NULL, NULL, NULL, pool, pool));
+
+  /* r3: copy A/D to A/D2 and modify the mergeinfo of A/B */
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, rev, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "A/D", txn_root, "A/D2", pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/B", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/trunk/B:1-2", pool),
+                                  pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r4: delete A/D/G, drop the mergeinfo of A/D/H/psi and add some to
+         A/D2 */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/D/G", pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/D/H/psi", SVN_PROP_MERGEINFO,
+                                  NULL, pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/D2", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/z:3", pool), pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r5: copy A/D2 to A/D3 and replace A/D2 with a copy of A/D */
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, rev, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "A/D2", txn_root, "A/D3", pool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/D2", pool));
+  SVN_ERR(svn_fs_copy(rev_root, "A/D", txn_root, "A/D2", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* The index covers all revisions. */
+  SVN_ERR(svn_fs_fs__path_index_mergeinfo(&available, fs, "/", rev,
+                                          ignore_mergeinfo_receiver, NULL,
+                                          pool));
+  SVN_TEST_ASSERT(available);
+
+  for (i = 1; i <= rev; ++i)
+    {
+      SVN_ERR(get_mergeinfo_lines(&indexed[i][0], fs, i, "/", pool));
+      SVN_ERR(get_mergeinfo_lines(&indexed[i][1], fs, i, "/A/D", pool));
+    }
+
+  SVN_TEST_STRING_ASSERT(indexed[1][0], "");
+  SVN_TEST_STRING_ASSERT(indexed[3][0],
+                         "/A/B=/trunk/B:1-2\n"
+                         "/A/D/G=/x:1\n"
+                         "/A/D/H/psi=/y:1\n"
+                         "/A/D2/G=/x:1\n"
+                         "/A/D2/H/psi=/y:1\n");
+  SVN_TEST_STRING_ASSERT(indexed[5][0],
+                         "/A/B=/trunk/B:1-2\n"
+                         "/A/D3=/z:3\n"
+                         "/A/D3/G=/x:1\n"
+                         "/A/D3/H/psi=/y:1\n");
+
+  /* Without the index, crawling the tree must yield the same results. */
+  SVN_ERR(svn_fs_fs__close_path_index(fs));
+  SVN_ERR(svn_io_remove_file2(svn_dirent_join(fs->path, PATH_INDEX_DB_NAME,
+                                              pool),
+                              FALSE, pool));
+
+  SVN_ERR(svn_fs_fs__path_index_mergeinfo(&available, fs, "/", rev,
+                                          ignore_mergeinfo_receiver, NULL,
+                                          pool));
+  SVN_TEST_ASSERT(!available);
+
+  for (i = 1; i <= rev; ++i)
+    {
+      SVN_ERR(get_mergeinfo_lines(&lines, fs, i, "/", pool));
+      SVN_TEST_STRING_ASSERT(indexed[i][0], lines);
+      SVN_ERR(get_mergeinfo_lines(&lines, fs, i, "/A/D", pool));
+      SVN_TEST_STRING_ASSERT(indexed[i][1], lines);
+    }
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+/* Read node revision headers from cache and from disk. */
+#define REPO_NAME "test-repo-noderev_header"
+
+/* Verify that the noderev header for PATH in ROOT matches the full node
+ * revision.  Use POOL for allocations. */
+static svn_error_t *
+check_noderev_header(svn_fs_root_t *root,
+                     const char *path,
+                     apr_pool_t *pool)
+{
+  svn_fs_t *fs = svn_fs_root_fs(root);
+  const svn_fs_id_t *id;
+  node_revision_t *noderev;
+  svn_fs_fs__noderev_header_t header;
+  int i;
+
+  SVN_ERR(svn_fs_node_id(&id, root, path, pool));
+
+  /* Repeated lookups must be consistent, whether cached or not. */
+  for (i = 0; i < 2; ++i)
+    {
+      SVN_ERR(svn_fs_fs__get_noderev_header(&header, fs, id, pool));
+      SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, pool, pool));
+
+      SVN_TEST_ASSERT(header.kind == noderev->kind);
+      SVN_TEST_ASSERT(header.predecessor_rev
+                      == (noderev->predecessor_id
+                            ? svn_fs_fs__id_rev(noderev->predecessor_id)
+                            : SVN_INVALID_REVNUM));
+      SVN_TEST_ASSERT(header.predecessor_count == noderev->predecessor_count);
+      SVN_TEST_ASSERT(header.copyfrom_rev == noderev->copyfrom_rev);
+      SVN_TEST_ASSERT(header.copyroot_rev == noderev->copyroot_rev);
+      SVN_TEST_ASSERT(header.mergeinfo_count == noderev->mergeinfo_count);
+      SVN_TEST_ASSERT(header.has_mergeinfo == noderev->has_mergeinfo);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+noderev_header(const svn_test_opts_t *opts,
+               apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t rev;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* r1: greek tree */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r2: copy A/D with some mergeinfo */
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, rev, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "A/D", txn_root, "A/D2", pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "A/D2", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/A/D:1", pool), pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, rev, pool));
+
+  SVN_ERR(check_noderev_header(rev_root, "/", pool));
+  SVN_ERR(check_noderev_header(rev_root, "A", pool));
+  SVN_ERR(check_noderev_header(rev_root, "A/D2", pool));
+  SVN_ERR(check_noderev_header(rev_root, "A/D2/G/rho", pool));
+  SVN_ERR(check_noderev_header(rev_root, "iota", pool));
+
+  /* Txn nodes are never cached. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", "new iota\n",
+                                      pool));
+  SVN_ERR(check_noderev_header(txn_root, "iota", pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+/* Move locks into the lock database and query them there. */
+#define REPO_NAME "test-repo-lock_database"
+
+/* Implements svn_fs_get_locks_callback_t, counting the locks in
+ * *(int *)BATON. */
+static svn_error_t *
+count_locks(void *baton,
+            svn_lock_t *lock,
+            apr_pool_t *pool)
+{
+  int *count = baton;
+  ++*count;
+
+  return SVN_NO_ERROR;
+}
+
+/* Verify that FS reports EXPECTED locks at or below PATH.
+ * Use POOL for allocations. */
+static svn_error_t *
+check_lock_count(svn_fs_t *fs,
+                 const char *path,
+                 int expected,
+                 apr_pool_t *pool)
+{
+  int count = 0;
+
+  SVN_ERR(svn_fs_get_locks2(fs, path, svn_depth_infinity, count_locks,
+                            &count, pool));
+  SVN_TEST_INT_ASSERT(count, expected);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+lock_database(const svn_test_opts_t *opts,
+              apr_pool_t *pool)
+{
+  const char *config = "\n[" CONFIG_SECTION_LOCKS "]\n"
+                       CONFIG_OPTION_USE_LOCK_DATABASE " = true\n";
+  apr_file_t *file;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_fs_access_t *access;
+  svn_lock_t *lock;
+  svn_revnum_t rev;
+  svn_node_kind_t kind;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 15))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.15 SVN doesn't support lock databases");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Create a few locks in the digest file tree. */
+  SVN_ERR(svn_fs_create_access(&access, "bubba", pool));
+  SVN_ERR(svn_fs_set_access(fs, access));
+  SVN_ERR(svn_fs_lock(&lock, fs, "/A/D/G/pi", NULL, "", 0, 0,
+                      SVN_INVALID_REVNUM, FALSE, pool));
+  SVN_ERR(svn_fs_lock(&lock, fs, "/A/D/H/psi", NULL, "", 0, 0,
+                      SVN_INVALID_REVNUM, FALSE, pool));
+  SVN_ERR(svn_fs_lock(&lock, fs, "/iota", NULL, "", 0, 0,
+                      SVN_INVALID_REVNUM, FALSE, pool));
+
+  /* Enable the lock database.  Reading does not migrate the locks. */
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, config, strlen(config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_set_access(fs, access));
+
+  SVN_ERR(check_lock_count(fs, "/", 3, pool));
+  SVN_ERR(svn_io_check_path(svn_dirent_join(REPO_NAME, PATH_LOCK_DB, pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* The first write moves all locks into the database. */
+  SVN_ERR(svn_fs_lock(&lock, fs, "/A/D/G/rho", NULL, "", 0, 0,
+                      SVN_INVALID_REVNUM, FALSE, pool));
+  SVN_ERR(svn_io_check_path(svn_dirent_join(REPO_NAME, PATH_LOCK_DB, pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+  SVN_ERR(svn_io_check_path(svn_dirent_join(REPO_NAME, PATH_LOCKS_DIR, pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  SVN_ERR(check_lock_count(fs, "/", 4, pool));
+  SVN_ERR(check_lock_count(fs, "/A/D", 3, pool));
+  SVN_ERR(check_lock_count(fs, "/A/D/G", 2, pool));
+  SVN_ERR(check_lock_count(fs, "/A/D/G/pi", 1, pool));
+  SVN_ERR(check_lock_count(fs, "/A/B", 0, pool));
+
+  SVN_ERR(svn_fs_get_lock(&lock, fs, "/A/D/G/pi", pool));
+  SVN_TEST_ASSERT(lock && !strcmp(lock->owner, "bubba"));
+
+  /* A separate FS instance sees the same locks. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_set_access(fs, access));
+  SVN_ERR(check_lock_count(fs, "/A", 3, pool));
+
+  /* Lock tokens are required for regular unlocks. */
+  SVN_ERR(svn_fs_unlock(fs, "/A/D/G/pi", lock->token, FALSE, pool));
+  SVN_ERR(svn_fs_unlock(fs, "/iota", NULL, TRUE, pool));
+  SVN_ERR(check_lock_count(fs, "/", 2, pool));
+  SVN_ERR(svn_fs_get_lock(&lock, fs, "/A/D/G/pi", pool));
+  SVN_TEST_ASSERT(lock == NULL);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+
+/* ------------------------------------------------------------------------ */
+/* Count acquisitions of the txn list lock. */
+#define REPO_NAME "test-repo-txn_list_lock_stats"
+
+static svn_error_t *
+txn_list_lock_stats(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t rev;
+  void *output_void;
+  svn_fs_fs__ioctl_get_txn_list_lock_stats_output_t *before, *after;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_GET_TXN_LIST_LOCK_STATS,
+                       NULL, &output_void, NULL, NULL, pool, pool));
+  before = output_void;
+
+  /* Writing reps to the proto-rev file claims and releases it. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_GET_TXN_LIST_LOCK_STATS,
+                       NULL, &output_void, NULL, NULL, pool, pool));
+  after = output_void;
+
+  SVN_TEST_ASSERT(after->count > before->count);
+  SVN_TEST_ASSERT(after->wait_time >= before->wait_time);
+  SVN_TEST_ASSERT(after->max_wait_time <= after->wait_time);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+/* Repeated lookups of non-existent paths. */
+#define REPO_NAME "test-repo-absent_path_lookups"
+
+static svn_error_t *
+absent_path_lookups(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root, *rev1_root;
+  svn_revnum_t rev;
+  svn_node_kind_t kind;
+  const svn_fs_id_t *id;
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(root, "/dir", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev1_root, fs, rev, pool));
+
+  /* Misses must be reported consistently, whether cached or not. */
+  for (i = 0; i < 3; ++i)
+    {
+      SVN_ERR(svn_fs_check_path(&kind, rev1_root, "/dir/new", pool));
+      SVN_TEST_ASSERT(kind == svn_node_none);
+      SVN_ERR(svn_fs_check_path(&kind, rev1_root, "/dir/new/sub", pool));
+      SVN_TEST_ASSERT(kind == svn_node_none);
+      SVN_TEST_ASSERT_ERROR(svn_fs_node_id(&id, rev1_root, "/dir/new",
+                                           pool),
+                            SVN_ERR_FS_NOT_FOUND);
+    }
+
+  /* Adding the path in a txn based on that revision must work. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_check_path(&kind, root, "/dir/new", pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  SVN_ERR(svn_fs_make_file(root, "/dir/new", pool));
+  SVN_ERR(svn_fs_check_path(&kind, root, "/dir/new", pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* The new revision sees it while the old one still doesn't. */
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_fs_check_path(&kind, root, "/dir/new", pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+  SVN_ERR(svn_fs_check_path(&kind, rev1_root, "/dir/new", pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-content_chunking"
+
+static svn_error_t *
+content_chunking(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  const char *config = "\n[" CONFIG_SECTION_DELTIFICATION "]\n"
+                       CONFIG_OPTION_ENABLE_CONTENT_CHUNKING " = true\n";
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  apr_file_t *file;
+  apr_finfo_t finfo;
+  svn_stringbuf_t *contents = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *modified;
+  svn_stringbuf_t *read_back;
+  apr_uint32_t seed = 0;
+  apr_size_t i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+  if (opts->server_minor_version && (opts->server_minor_version < 9))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.9 SVN doesn't support this feature");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_io_file_open(&file,
+                           svn_dirent_join(REPO_NAME, PATH_CONFIG, pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, config, strlen(config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  /* r1: Add a file with 2 MB of poorly compressible data. */
+  for (i = 0; i < 0x200000; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      svn_stringbuf_appendbyte(contents,
+                               "0123456789abcdef"[(seed >> 16) & 0xf]);
+    }
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "/a", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "/a", contents->data, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r2: Add an unrelated file with mostly the same contents but shifted
+   * by a new header and with a few local modifications. */
+  modified = svn_stringbuf_create("new header\n", pool);
+  svn_stringbuf_appendstr(modified, contents);
+  for (i = 1; i < 8; ++i)
+    modified->data[i * 0x40000] = 'x';
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "/b", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "/b", modified->data, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Without a delta against /a, r2 would be at least half as large as
+   * the new contents. */
+  SVN_ERR(svn_io_stat(&finfo, svn_fs_fs__path_rev_absolute(fs, rev, pool),
+                      APR_FINFO_SIZE, pool));
+  SVN_TEST_ASSERT(finfo.size < (apr_off_t)(modified->len / 16));
+
+  /* All contents must still be intact. */
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "/a", &read_back, pool));
+  SVN_TEST_STRING_ASSERT(read_back->data, contents->data);
+  SVN_ERR(svn_test__get_file_contents(root, "/b", &read_back, pool));
+  SVN_TEST_STRING_ASSERT(read_back->data, modified->data);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-delta_window_sizes"
+
+static svn_error_t *
+delta_window_sizes(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  static const char *window_sizes[] = { "0", "4", "1024" };
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  apr_file_t *file;
+  svn_stringbuf_t *contents = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *read_back;
+  apr_uint32_t seed = 0;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_size_t i, k;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* 5 MB of poorly compressible data, i.e. enough for large windows. */
+  for (i = 0; i < 0x500000; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      svn_stringbuf_appendbyte(contents,
+                               "0123456789abcdef"[(seed >> 16) & 0xf]);
+    }
+
+  for (k = 0; k < sizeof(window_sizes) / sizeof(window_sizes[0]); ++k)
+    {
+      const char *repo_name = apr_psprintf(pool, "%s-%s", REPO_NAME,
+                                           window_sizes[k]);
+      const char *config = apr_psprintf(pool, "\n[%s]\n%s = %s\n",
+                                        CONFIG_SECTION_DELTIFICATION,
+                                        CONFIG_OPTION_DELTA_WINDOW_SIZE,
+                                        window_sizes[k]);
+      char original = contents->data[0x280000];
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_test__create_fs(&fs, repo_name, opts, iterpool));
+      SVN_ERR(svn_io_file_open(&file,
+                               svn_dirent_join(repo_name, PATH_CONFIG,
+                                               iterpool),
+                               APR_WRITE | APR_APPEND, APR_OS_DEFAULT,
+                               iterpool));
+      SVN_ERR(svn_io_file_write_full(file, config, strlen(config), NULL,
+                                     iterpool));
+      SVN_ERR(svn_io_file_close(file, iterpool));
+      SVN_ERR(svn_fs_open2(&fs, repo_name, NULL, iterpool, iterpool));
+
+      /* r1: a small and a large file. */
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      SVN_ERR(svn_fs_make_file(root, "/small", iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, "/small", "small\n",
+                                          iterpool));
+      SVN_ERR(svn_fs_make_file(root, "/large", iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, "/large", contents->data,
+                                          iterpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, iterpool));
+
+      /* r2: grow the small file and modify the large one, so both get
+       * stored as deltas. */
+      contents->data[0x280000] = 'x';
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, "/small",
+                                          contents->data + 0x400000,
+                                          iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, "/large", contents->data,
+                                          iterpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, iterpool));
+
+      /* All contents must be intact. */
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, iterpool));
+      SVN_ERR(svn_test__get_file_contents(root, "/small", &read_back,
+                                          iterpool));
+      SVN_TEST_STRING_ASSERT(read_back->data, contents->data + 0x400000);
+      SVN_ERR(svn_test__get_file_contents(root, "/large", &read_back,
+                                          iterpool));
+      SVN_TEST_STRING_ASSERT(read_back->data, contents->data);
+
+      contents->data[0x280000] = original;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
 
 
 /* The test table.  */
@@ -1943,6 +3755,46 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "pack with limited memory for metadata"),
     SVN_TEST_OPTS_PASS(large_delta_against_plain,
                        "large deltas against PLAIN, issue #4658"),
+    SVN_TEST_OPTS_PASS(verify_concurrently,
+                       "verify FSFS shards concurrently"),
+    SVN_TEST_OPTS_PASS(pack_concurrently,
+                       "pack FSFS shards concurrently"),
+    SVN_TEST_OPTS_PASS(read_mapped_pack_files,
+                       "read FSFS pack files through memory mappings"),
+    SVN_TEST_OPTS_PASS(shared_l2p_tables,
+                       "write and use decoded L2P index tables"),
+    SVN_TEST_OPTS_PASS(rep_sharing_with_filter,
+                       "rep-sharing with a rep-cache filter"),
+    SVN_TEST_OPTS_PASS(indexed_directories,
+                       "lookups in indexed directories"),
+    SVN_TEST_OPTS_PASS(delta_chain_size_limit,
+                       "limit the size of delta chains"),
+    SVN_TEST_OPTS_PASS(packed_revprops_across_refresh,
+                       "read packed revprops across cache refreshes"),
+    SVN_TEST_OPTS_PASS(stats_concurrently,
+                       "gather FSFS statistics concurrently"),
+    SVN_TEST_OPTS_PASS(access_trace,
+                       "record FSFS item accesses at runtime"),
+    SVN_TEST_OPTS_PASS(path_index,
+                       "maintain and query the per-path revision index"),
+    SVN_TEST_OPTS_PASS(path_index_copies,
+                       "look up copies in the per-path revision index"),
+    SVN_TEST_OPTS_PASS(path_index_deleted_rev,
+                       "look up deletions in the per-path revision index"),
+    SVN_TEST_OPTS_PASS(path_index_mergeinfo,
+                       "read mergeinfo from the per-path revision index"),
+    SVN_TEST_OPTS_PASS(noderev_header,
+                       "read node revision headers in place"),
+    SVN_TEST_OPTS_PASS(lock_database,
+                       "store and query locks in a database"),
+    SVN_TEST_OPTS_PASS(txn_list_lock_stats,
+                       "count txn list lock acquisitions"),
+    SVN_TEST_OPTS_PASS(absent_path_lookups,
+                       "cache lookups of non-existent paths"),
+    SVN_TEST_OPTS_PASS(content_chunking,
+                       "deltify against similar content of other nodes"),
+    SVN_TEST_OPTS_PASS(delta_window_sizes,
+                       "delta windows of different sizes"),
     SVN_TEST_NULL
   };
 
@@ -25,14 +25,18 @@
 #include <apr_pools.h>
 
 #include "../svn_test.h"
-#include "../../libsvn_fs_x/batch_fsync.h"
 #include "../../libsvn_fs_x/fs.h"
+#include "../../libsvn_fs_x/index.h"
+#include "../../libsvn_fs_x/noderevs.h"
 #include "../../libsvn_fs_x/reps.h"
+#include "../../libsvn_fs_x/rev_file.h"
+#include "../../libsvn_fs_x/util.h"
 
 #include "svn_pools.h"
 #include "svn_props.h"
 #include "svn_fs.h"
 #include "private/svn_string_private.h"
+#include "private/svn_batch_fsync.h"
 
 #include "../svn_test_fs.h"
 
@@ -820,6 +824,86 @@ test_reps(const svn_test_opts_t *opts,
 #undef SHARD_SIZE
 #undef MAX_REV
 
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-fsx-reps-bounded-hash"
+static svn_error_t *
+test_reps_bounded_hash(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_x__data_t *ffd;
+  svn_fs_x__reps_builder_t *builder;
+  svn_fs_x__reps_t *container;
+  svn_stringbuf_t *serialized;
+  svn_stream_t *stream;
+  svn_stringbuf_t *base = svn_stringbuf_create_ensure(100000, pool);
+  apr_array_header_t *texts = apr_array_make(pool, 20, sizeof(svn_string_t *));
+  apr_uint32_t seed = 4711;
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsx") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSX repositories only");
+
+  /* Pseudo-random text that will make the hash overflow quickly. */
+  for (i = 0; i < 100000; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      svn_stringbuf_appendbyte(base, (char)('a' + (seed >> 16) % 26));
+    }
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* Limit the hash to its minimal size of 16 buckets. */
+  ffd = fs->fsap_data;
+  ffd->reps_container_hash_size = 1;
+  builder = svn_fs_x__reps_builder_create(fs, pool);
+
+  /* Add variations of BASE with a few bytes changed. */
+  for (i = 0; i < 20; ++i)
+    {
+      apr_size_t idx;
+      svn_stringbuf_t *text = svn_stringbuf_dup(base, pool);
+      svn_string_t *string = apr_pcalloc(pool, sizeof(*string));
+
+      text->data[(i * 4999) % text->len] = 'X';
+      string->data = text->data;
+      string->len = text->len;
+
+      SVN_ERR(svn_fs_x__reps_add(&idx, builder, string));
+      SVN_TEST_ASSERT(idx == (apr_size_t)i);
+      APR_ARRAY_PUSH(texts, svn_string_t *) = string;
+    }
+
+  serialized = svn_stringbuf_create_empty(pool);
+  stream = svn_stream_from_stringbuf(serialized, pool);
+  SVN_ERR(svn_fs_x__write_reps_container(stream, builder, pool));
+
+  SVN_ERR(svn_stream_reset(stream));
+  SVN_ERR(svn_fs_x__read_reps_container(&container, stream, pool, pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  /* All texts must be reconstructed faithfully. */
+  for (i = 0; i < texts->nelts; ++i)
+    {
+      svn_fs_x__rep_extractor_t *extractor;
+      svn_stringbuf_t *contents;
+      const svn_string_t *expected = APR_ARRAY_IDX(texts, i, svn_string_t *);
+
+      SVN_ERR(svn_fs_x__reps_get(&extractor, fs, container, i, pool));
+      SVN_ERR(svn_fs_x__extractor_drive(&contents, extractor, 0, 0, pool,
+                                        pool));
+      SVN_TEST_ASSERT(contents->len == expected->len);
+      SVN_TEST_ASSERT(memcmp(contents->data, expected->data,
+                             expected->len) == 0);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
 /* ------------------------------------------------------------------------ */
 #define REPO_NAME "test-repo-fsx-pack-shard-size-one"
 #define SHARD_SIZE 1
@@ -851,7 +935,7 @@ test_batch_fsync(const svn_test_opts_t *opts,
                  apr_pool_t *pool)
 {
   const char *abspath;
-  svn_fs_x__batch_fsync_t *batch;
+  svn_batch_fsync__t *batch;
   int i;
 
   /* Disable this test for non FSX backends because it has no relevance to
@@ -870,13 +954,13 @@ test_batch_fsync(const svn_test_opts_t *opts,
 
   /* Initialize infrastructure with a pool that lives as long as this
    * application. */
-  SVN_ERR(svn_fs_x__batch_fsync_init(pool));
+  SVN_ERR(svn_batch_fsync__init(pool));
 
   /* We use and re-use the same batch object throughout this test. */
-  SVN_ERR(svn_fs_x__batch_fsync_create(&batch, TRUE, pool));
+  SVN_ERR(svn_batch_fsync__create(&batch, TRUE, pool));
 
   /* The working directory is new. */
-  SVN_ERR(svn_fs_x__batch_fsync_new_path(batch, abspath, pool));
+  SVN_ERR(svn_batch_fsync__new_path(batch, abspath, pool));
 
   /* 1st run: Has to fire up worker threads etc. */
   for (i = 0; i < 10; ++i)
@@ -887,12 +971,12 @@ test_batch_fsync(const svn_test_opts_t *opts,
                                          pool);
       apr_size_t len = strlen(path);
 
-      SVN_ERR(svn_fs_x__batch_fsync_open_file(&file, batch, path, pool));
+      SVN_ERR(svn_batch_fsync__open_file(&file, batch, path, pool));
 
       SVN_ERR(svn_io_file_write(file, path, &len, pool));
     }
 
-  SVN_ERR(svn_fs_x__batch_fsync_run(batch, pool));
+  SVN_ERR(svn_batch_fsync__run(batch, pool));
 
   /* 2nd run: Running a batch must leave the container in an empty,
    * re-usable state. Hence, try to re-use it. */
@@ -904,12 +988,12 @@ test_batch_fsync(const svn_test_opts_t *opts,
                                          pool);
       apr_size_t len = strlen(path);
 
-      SVN_ERR(svn_fs_x__batch_fsync_open_file(&file, batch, path, pool));
+      SVN_ERR(svn_batch_fsync__open_file(&file, batch, path, pool));
 
       SVN_ERR(svn_io_file_write(file, path, &len, pool));
     }
 
-  SVN_ERR(svn_fs_x__batch_fsync_run(batch, pool));
+  SVN_ERR(svn_batch_fsync__run(batch, pool));
 
   /* 3rd run: Schedule but don't execute. POOL cleanup shall not fail. */
   for (i = 0; i < 10; ++i)
@@ -920,7 +1004,7 @@ test_batch_fsync(const svn_test_opts_t *opts,
                                          pool);
       apr_size_t len = strlen(path);
 
-      SVN_ERR(svn_fs_x__batch_fsync_open_file(&file, batch, path, pool));
+      SVN_ERR(svn_batch_fsync__open_file(&file, batch, path, pool));
 
       SVN_ERR(svn_io_file_write(file, path, &len, pool));
     }
@@ -928,6 +1012,209 @@ test_batch_fsync(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 #undef REPO_NAME
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-fsx-index-page-checksums"
+/* Invert the lowest bit of the byte at OFFSET in file PATH.
+ * Use POOL for temporary allocations. */
+static svn_error_t *
+flip_byte(const char *path,
+          apr_off_t offset,
+          apr_pool_t *pool)
+{
+  apr_file_t *file;
+  apr_off_t pos = offset;
+  char c;
+
+  SVN_ERR(svn_io_set_file_read_write(path, FALSE, pool));
+  SVN_ERR(svn_io_file_open(&file, path, APR_READ | APR_WRITE,
+                           APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &pos, pool));
+  SVN_ERR(svn_io_file_getc(&c, file, pool));
+
+  pos = offset;
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &pos, pool));
+  SVN_ERR(svn_io_file_putc((char)(c ^ 1), file, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+index_page_checksums(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_fs_x__revision_file_t *rev_file;
+  svn_fs_x__index_info_t l2p_info;
+  svn_fs_x__index_info_t p2l_info;
+  const char *rev_path;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsx") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSX repositories only");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+
+  /* Intact index pages pass verification. */
+  SVN_ERR(svn_fs_x__rev_file_init(&rev_file, fs, rev, pool));
+  SVN_ERR(svn_fs_x__l2p_index_verify_pages(fs, rev_file, NULL, NULL, pool));
+  SVN_ERR(svn_fs_x__p2l_index_verify_pages(fs, rev_file, NULL, NULL, pool));
+  SVN_ERR(svn_fs_x__rev_file_l2p_info(&l2p_info, rev_file));
+  SVN_ERR(svn_fs_x__rev_file_p2l_info(&p2l_info, rev_file));
+  SVN_ERR(svn_fs_x__close_revision_file(rev_file));
+
+  /* Both indexes end with the data of their last page.  Corrupt it. */
+  rev_path = svn_fs_x__path_rev_absolute(fs, rev, pool);
+  SVN_ERR(flip_byte(rev_path, l2p_info.end - 1, pool));
+  SVN_ERR(flip_byte(rev_path, p2l_info.end - 1, pool));
+
+  SVN_ERR(svn_fs_x__rev_file_init(&rev_file, fs, rev, pool));
+  SVN_TEST_ASSERT_ERROR(svn_fs_x__l2p_index_verify_pages(fs, rev_file,
+                                                          NULL, NULL, pool),
+                        SVN_ERR_FS_INDEX_CORRUPTION);
+  SVN_TEST_ASSERT_ERROR(svn_fs_x__p2l_index_verify_pages(fs, rev_file,
+                                                          NULL, NULL, pool),
+                        SVN_ERR_FS_INDEX_CORRUPTION);
+  SVN_ERR(svn_fs_x__close_revision_file(rev_file));
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+/* ------------------------------------------------------------------------ */
+/* Compare the noderevs LHS and RHS and fail the test if they differ in any
+ * way that a noderevs container round trip would preserve. */
+static svn_error_t *
+compare_noderevs(const svn_fs_x__noderev_t *lhs,
+                 const svn_fs_x__noderev_t *rhs)
+{
+  SVN_TEST_ASSERT(svn_fs_x__id_eq(&lhs->noderev_id, &rhs->noderev_id));
+  SVN_TEST_ASSERT(svn_fs_x__id_eq(&lhs->node_id, &rhs->node_id));
+  SVN_TEST_ASSERT(svn_fs_x__id_eq(&lhs->copy_id, &rhs->copy_id));
+  SVN_TEST_ASSERT(svn_fs_x__id_eq(&lhs->predecessor_id,
+                                  &rhs->predecessor_id));
+  SVN_TEST_ASSERT(lhs->kind == rhs->kind);
+  SVN_TEST_ASSERT(lhs->predecessor_count == rhs->predecessor_count);
+  SVN_TEST_ASSERT(lhs->mergeinfo_count == rhs->mergeinfo_count);
+  SVN_TEST_STRING_ASSERT(lhs->created_path, rhs->created_path);
+  SVN_TEST_STRING_ASSERT(lhs->copyroot_path, rhs->copyroot_path);
+  SVN_TEST_ASSERT(lhs->copyroot_rev == rhs->copyroot_rev);
+
+  SVN_TEST_ASSERT(!lhs->data_rep == !rhs->data_rep);
+  if (lhs->data_rep)
+    {
+      SVN_TEST_ASSERT(svn_fs_x__id_eq(&lhs->data_rep->id,
+                                      &rhs->data_rep->id));
+      SVN_TEST_ASSERT(lhs->data_rep->size == rhs->data_rep->size);
+      SVN_TEST_ASSERT(lhs->data_rep->has_sha1 == rhs->data_rep->has_sha1);
+    }
+
+  SVN_TEST_ASSERT(!lhs->prop_rep == !rhs->prop_rep);
+  if (lhs->prop_rep)
+    SVN_TEST_ASSERT(svn_fs_x__id_eq(&lhs->prop_rep->id,
+                                    &rhs->prop_rep->id));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_noderevs_item_read(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  enum { COUNT = 100 };
+
+  svn_fs_x__noderevs_t *container = svn_fs_x__noderevs_create(COUNT, pool);
+  svn_fs_x__noderevs_t *read_back;
+  svn_stringbuf_t *serialized = svn_stringbuf_create_empty(pool);
+  svn_stream_t *stream;
+  svn_fs_x__noderev_t *item;
+  svn_fs_x__noderev_t *expected;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_size_t i;
+
+  /* This is about FSX's internal data structures only. */
+  if (strcmp(opts->fs_type, "fsx") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSX repositories only");
+
+  /* Fill the container with noderevs that reference shared and unique
+   * IDs and representations, with and without SHA1 digests. */
+  for (i = 0; i < COUNT; ++i)
+    {
+      svn_fs_x__noderev_t *noderev = apr_pcalloc(pool, sizeof(*noderev));
+
+      noderev->noderev_id.change_set = 1;
+      noderev->noderev_id.number = i + 1;
+      noderev->node_id.change_set = 1;
+      noderev->node_id.number = i / 3;
+      noderev->copy_id.change_set = 0;
+      noderev->copy_id.number = i % 2;
+      svn_fs_x__id_reset(&noderev->predecessor_id);
+
+      noderev->kind = (i % 4) ? svn_node_file : svn_node_dir;
+      noderev->predecessor_count = (int)i;
+      noderev->mergeinfo_count = i % 5;
+      noderev->created_path = apr_psprintf(pool, "/trunk/file%d", (int)i);
+      noderev->copyroot_path = "/trunk";
+      noderev->copyroot_rev = 1;
+
+      noderev->data_rep = apr_pcalloc(pool, sizeof(*noderev->data_rep));
+      noderev->data_rep->id.change_set = 1;
+      noderev->data_rep->id.number = i + 1000;
+      noderev->data_rep->size = i * 10;
+      noderev->data_rep->expanded_size = i * 20;
+      noderev->data_rep->has_sha1 = (i % 3) == 0;
+      noderev->data_rep->md5_digest[0] = (unsigned char)i;
+
+      if (i % 7 == 0)
+        {
+          noderev->prop_rep = apr_pcalloc(pool, sizeof(*noderev->prop_rep));
+          noderev->prop_rep->id.change_set = 1;
+          noderev->prop_rep->id.number = i + 2000;
+        }
+
+      SVN_TEST_ASSERT(svn_fs_x__noderevs_add(container, noderev) == i);
+    }
+
+  stream = svn_stream_from_stringbuf(serialized, pool);
+  SVN_ERR(svn_fs_x__write_noderevs_container(stream, container, pool));
+
+  stream = svn_stream_from_stringbuf(serialized, pool);
+  SVN_ERR(svn_fs_x__read_noderevs_container(&read_back, stream, pool, pool));
+
+  /* Single-item reads must return the same data as full container reads. */
+  for (i = 0; i < COUNT; ++i)
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_x__noderevs_get(&expected, read_back, i, iterpool));
+
+      stream = svn_stream_from_stringbuf(serialized, iterpool);
+      SVN_ERR(svn_fs_x__read_noderevs_container_item(&item, stream, i,
+                                                     iterpool, iterpool));
+      SVN_ERR(compare_noderevs(expected, item));
+    }
+
+  /* Out-of-range items. */
+  stream = svn_stream_from_stringbuf(serialized, pool);
+  SVN_TEST_ASSERT_ERROR(svn_fs_x__read_noderevs_container_item(&item, stream,
+                                                                COUNT, pool,
+                                                                pool),
+                        SVN_ERR_FS_CONTAINER_INDEX);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* ------------------------------------------------------------------------ */
 
 /* The test table.  */
@@ -959,10 +1246,16 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test svn_fs_info"),
     SVN_TEST_OPTS_PASS(test_reps,
                        "test representations container"),
+    SVN_TEST_OPTS_PASS(test_reps_bounded_hash,
+                       "test representations container with bounded hash"),
     SVN_TEST_OPTS_PASS(pack_shard_size_one,
                        "test packing with shard size = 1"),
     SVN_TEST_OPTS_PASS(test_batch_fsync,
                        "test batch fsync"),
+    SVN_TEST_OPTS_PASS(index_page_checksums,
+                       "verify index page checksums"),
+    SVN_TEST_OPTS_PASS(test_noderevs_item_read,
+                       "read single items from a noderevs container"),
     SVN_TEST_NULL
   };
 
@@ -1877,6 +1877,137 @@ test_get_deleted_rev_errors(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Baton for get_files_receiver. */
+typedef struct get_files_baton_t
+{
+  apr_array_header_t *files;
+  int count;
+} get_files_baton_t;
+
+/* Implements svn_ra_file_receiver_t, checking that the files arrive in
+   the order they were requested. */
+static svn_error_t *
+get_files_receiver(void *baton,
+                   const svn_ra_file_request_t *file,
+                   svn_revnum_t fetched_rev,
+                   apr_hash_t *props,
+                   apr_pool_t *scratch_pool)
+{
+  get_files_baton_t *b = baton;
+
+  SVN_TEST_ASSERT(b->count < b->files->nelts);
+  SVN_TEST_ASSERT(file == APR_ARRAY_IDX(b->files, b->count,
+                                        svn_ra_file_request_t *));
+  SVN_TEST_INT_ASSERT(fetched_rev, 1);
+  SVN_TEST_ASSERT(props != NULL);
+  b->count++;
+
+  return SVN_NO_ERROR;
+}
+
+/* Fetch enough files over a tunnel to need several get-files requests. */
+static svn_error_t *
+tunnel_get_files(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  tunnel_baton_t *b = apr_pcalloc(pool, sizeof(*b));
+  apr_pool_t *scratch_pool = svn_pool_create(pool);
+  const char *url;
+  svn_ra_callbacks2_t *cbtable;
+  svn_ra_session_t *session;
+  const char tunnel_repos_name[] = "test-repo-get-files";
+  svn_repos_t *repos;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev;
+  apr_array_header_t *files;
+  get_files_baton_t gfb;
+  svn_error_t *err;
+  int i;
+
+  b->magic = TUNNEL_MAGIC;
+
+  SVN_ERR(svn_test__create_repos(&repos, tunnel_repos_name, opts,
+                                 scratch_pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, svn_repos_fs(repos), 0, scratch_pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, scratch_pool));
+  for (i = 0; i < 600; i++)
+    {
+      const char *path = apr_psprintf(scratch_pool, "f%d", i);
+
+      SVN_ERR(svn_fs_make_file(txn_root, path, scratch_pool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, path,
+                                          apr_psprintf(scratch_pool,
+                                                       "This is %s.\n",
+                                                       path),
+                                          scratch_pool));
+    }
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                  scratch_pool));
+
+  /* Immediately close the repository to avoid race condition with svnserve
+     (and then the cleanup code) with BDB when our pool is cleared. */
+  svn_pool_clear(scratch_pool);
+
+  url = apr_pstrcat(pool, "svn+test://localhost/", tunnel_repos_name,
+                    SVN_VA_NULL);
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+  cbtable->check_tunnel_func = check_tunnel;
+  cbtable->open_tunnel_func = open_tunnel;
+  cbtable->tunnel_baton = b;
+  SVN_ERR(svn_cmdline_create_auth_baton2(&cbtable->auth_baton,
+                                         TRUE  /* non_interactive */,
+                                         "jrandom", "rayjandom",
+                                         NULL,
+                                         TRUE  /* no_auth_cache */,
+                                         FALSE /* trust_server_cert */,
+                                         FALSE, FALSE, FALSE, FALSE,
+                                         NULL, NULL, NULL, pool));
+
+  SVN_ERR(svn_ra_open5(&session, NULL, NULL, url, NULL, cbtable, NULL, NULL,
+                       pool));
+
+  files = apr_array_make(pool, 600, sizeof(svn_ra_file_request_t *));
+  for (i = 0; i < 600; i++)
+    {
+      svn_ra_file_request_t *file = apr_pcalloc(pool, sizeof(*file));
+
+      file->path = apr_psprintf(pool, "f%d", i);
+      file->revision = (i % 2) ? 1 : SVN_INVALID_REVNUM;
+      file->stream
+        = svn_stream_from_stringbuf(svn_stringbuf_create_empty(pool), pool);
+      APR_ARRAY_PUSH(files, svn_ra_file_request_t *) = file;
+    }
+
+  gfb.files = files;
+  gfb.count = 0;
+  SVN_ERR(svn_ra_get_files(session, files, TRUE, get_files_receiver, &gfb,
+                           pool));
+  SVN_TEST_INT_ASSERT(gfb.count, 600);
+
+  for (i = 0; i < 600; i++)
+    {
+      svn_ra_file_request_t *file
+        = APR_ARRAY_IDX(files, i, svn_ra_file_request_t *);
+      svn_stringbuf_t *contents;
+
+      SVN_ERR(svn_stringbuf_from_stream(&contents, file->stream, 0, pool));
+      SVN_TEST_STRING_ASSERT(contents->data,
+                             apr_psprintf(pool, "This is %s.\n",
+                                          file->path));
+    }
+
+  /* A missing file ends the call but leaves the session usable. */
+  APR_ARRAY_IDX(files, 10, svn_ra_file_request_t *)->path = "missing";
+  err = svn_ra_get_files(session, files, FALSE, NULL, NULL, pool);
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_FS_NOT_FOUND);
+
+  SVN_ERR(svn_ra_get_latest_revnum(session, &youngest_rev, pool));
+  SVN_TEST_INT_ASSERT(youngest_rev, 1);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* The test table.  */
 
@@ -1917,6 +2048,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test get-deleted-rev no delete"),
     SVN_TEST_OPTS_PASS(test_get_deleted_rev_errors,
                        "test get-deleted-rev errors"),
+    SVN_TEST_OPTS_PASS(tunnel_get_files,
+                       "fetch many files over a tunnel"),
     SVN_TEST_NULL
   };
 
@@ -23,6 +23,7 @@
 #include <apr_fnmatch.h>
 
 #include "svn_pools.h"
+#include "svn_dirent_uri.h"
 #include "svn_iter.h"
 #include "svn_hash.h"
 #include "private/svn_subr_private.h"
@@ -511,6 +512,113 @@ reposful_reposless_stanzas_inherit(apr_pool_t *pool)
    return SVN_NO_ERROR;
 }
 
+/* Check that ACCESS to PATH in REPOS is GRANTED for USER in AUTHZ. */
+static svn_error_t *
+check_shared_access(svn_authz_t *authz,
+                    const char *repos,
+                    const char *path,
+                    const char *user,
+                    svn_repos_authz_access_t access,
+                    svn_boolean_t granted,
+                    apr_pool_t *pool)
+{
+  svn_boolean_t access_granted;
+
+  SVN_ERR(svn_repos_authz_check_access(authz, repos, path, user, access,
+                                       &access_granted, pool));
+  if (access_granted != granted)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "Access %d to %s:%s for %s should%s be granted",
+                             access, repos, path, user,
+                             granted ? "" : " not");
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_shared_filtered_trees(apr_pool_t *pool)
+{
+  const char rules1[] =
+    "[groups]"                  NL
+    "g1 = userA, userB"         NL
+    "g2 = userC"                NL
+    ""                          NL
+    "[/]"                       NL
+    "@g1 = rw"                  NL
+    "@g2 = r"                   NL
+    ""                          NL
+    "[/secret]"                 NL
+    "@g2 ="                     NL
+    ""                          NL
+    "[r2:/secret]"              NL
+    "@g1 ="                     NL
+    ;
+  const char rules2[] =
+    "[groups]"                  NL
+    "g1 = userA, userB"         NL
+    "g2 = userC"                NL
+    ""                          NL
+    "[/]"                       NL
+    "@g1 = rw"                  NL
+    "@g2 = r"                   NL
+    ""                          NL
+    "[/secret]"                 NL
+    "@g2 = rw"                  NL
+    ""                          NL
+    "[r2:/secret]"              NL
+    "@g1 ="                     NL
+    ;
+
+  const char *wrk_dir = svn_test_data_path("authz-shared-trees", pool);
+  const char *path = svn_dirent_join(wrk_dir, "authz", pool);
+  svn_authz_t *authz;
+
+  SVN_ERR(svn_repos_authz_initialize(pool));
+  SVN_ERR(svn_io_make_dir_recursively(wrk_dir, pool));
+  SVN_ERR(svn_io_write_atomic2(path, rules1, sizeof(rules1) - 1, NULL,
+                               FALSE, pool));
+  SVN_ERR(svn_repos_authz_read4(&authz, path, NULL, TRUE, NULL, NULL, NULL,
+                                pool, pool));
+
+  /* Users in the same groups and repositories without specific rules
+   * may share filtered trees.  Make sure none of them leaks into the
+   * access checks of a different user or repository. */
+  SVN_ERR(check_shared_access(authz, "r1", "/secret", "userA",
+                              svn_authz_write, TRUE, pool));
+  SVN_ERR(check_shared_access(authz, "r1", "/secret", "userB",
+                              svn_authz_write, TRUE, pool));
+  SVN_ERR(check_shared_access(authz, "r3", "/secret", "userB",
+                              svn_authz_write, TRUE, pool));
+  SVN_ERR(check_shared_access(authz, "r2", "/secret", "userA",
+                              svn_authz_read, FALSE, pool));
+  SVN_ERR(check_shared_access(authz, "r2", "/secret", "userB",
+                              svn_authz_read, FALSE, pool));
+  SVN_ERR(check_shared_access(authz, "r1", "/secret", "userC",
+                              svn_authz_read, FALSE, pool));
+  SVN_ERR(check_shared_access(authz, "r2", "/secret", "userC",
+                              svn_authz_read, TRUE, pool));
+  SVN_ERR(check_shared_access(authz, "r3", "/", "userC",
+                              svn_authz_write, FALSE, pool));
+
+  /* Reload a modified configuration.  Only trees whose rules changed
+   * may differ. */
+  SVN_ERR(svn_io_write_atomic2(path, rules2, sizeof(rules2) - 1, NULL,
+                               FALSE, pool));
+  SVN_ERR(svn_repos_authz_read4(&authz, path, NULL, TRUE, NULL, NULL, NULL,
+                                pool, pool));
+
+  SVN_ERR(check_shared_access(authz, "r1", "/secret", "userA",
+                              svn_authz_write, TRUE, pool));
+  SVN_ERR(check_shared_access(authz, "r2", "/secret", "userB",
+                              svn_authz_read, FALSE, pool));
+  SVN_ERR(check_shared_access(authz, "r1", "/secret", "userC",
+                              svn_authz_write, TRUE, pool));
+  SVN_ERR(check_shared_access(authz, "r2", "/secret", "userC",
+                              svn_authz_write, FALSE, pool));
+
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = 4;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -524,6 +632,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "issue 4741 groups"),
     SVN_TEST_XFAIL2(reposful_reposless_stanzas_inherit,
                     "[foo:/] inherits [/]"),
+    SVN_TEST_PASS2(test_shared_filtered_trees,
+                   "test sharing of filtered authz trees"),
     SVN_TEST_NULL
   };
 
@@ -27,6 +27,7 @@
 #include "svn_pools.h"
 #include "svn_error.h"
 #include "svn_fs.h"
+#include "svn_hash.h"
 #include "svn_repos.h"
 #include "private/svn_repos_private.h"
 
@@ -273,6 +274,129 @@ test_load_r0_mergeinfo(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_repos_notify_func_t.  Count the notifications in the
+ * int in BATON. */
+static void
+count_notifications(void *baton,
+                    const svn_repos_notify_t *notify,
+                    apr_pool_t *scratch_pool)
+{
+  int *count = baton;
+
+  ++*count;
+}
+
+/* Dump the repository at REPOS_PATH, opened with FS_CONFIG, from
+ * START_REV to END_REV and return the dump data in *DUMP_DATA_P.
+ * Count the notifications received in *NOTIFICATION_COUNT.
+ */
+static svn_error_t *
+dump_with_config(svn_stringbuf_t **dump_data_p,
+                 int *notification_count,
+                 const char *repos_path,
+                 apr_hash_t *fs_config,
+                 svn_revnum_t start_rev,
+                 svn_revnum_t end_rev,
+                 svn_boolean_t incremental,
+                 apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_stringbuf_t *dump_data = svn_stringbuf_create_empty(pool);
+  svn_stream_t *stream = svn_stream_from_stringbuf(dump_data, pool);
+
+  *notification_count = 0;
+  SVN_ERR(svn_repos_open3(&repos, repos_path, fs_config, pool, pool));
+  SVN_ERR(svn_repos_dump_fs4(repos, stream, start_rev, end_rev,
+                             incremental, TRUE /*use_deltas*/,
+                             TRUE /*include_revprops*/,
+                             TRUE /*include_changes*/,
+                             count_notifications, notification_count,
+                             NULL, NULL, NULL, NULL,
+                             pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  *dump_data_p = dump_data;
+  return SVN_NO_ERROR;
+}
+
+/* Dumping with several worker threads must produce the same output
+ * and notifications as the sequential dump. */
+static svn_error_t *
+test_dump_concurrently(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev = 0;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  apr_pool_t *subpool = svn_pool_create(pool);
+  const char *repos_path;
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-dump-concurrently",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+  repos_path = svn_repos_path(repos, pool);
+
+  /* Revision 1:  Add the Greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Enough changes and copies for several chunks of revisions. */
+  for (i = 0; i < 40; i++)
+    {
+      svn_pool_clear(subpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+
+      SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu",
+                                          apr_psprintf(subpool,
+                                                       "Revision %d\n", i),
+                                          subpool));
+      if (i % 5 == 0)
+        {
+          SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev,
+                                       subpool));
+          SVN_ERR(svn_fs_copy(rev_root, "A/B",
+                              txn_root, apr_psprintf(subpool, "B%d", i),
+                              subpool));
+        }
+
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      subpool));
+    }
+  svn_pool_clear(subpool);
+
+  /* BDB does not support concurrent dumps and simply ignores the option. */
+  svn_hash_sets(fs_config, SVN_REPOS_CONFIG_DUMP_JOBS, "4");
+
+  for (i = 0; i < 2; i++)
+    {
+      svn_boolean_t incremental = (i == 1);
+      svn_revnum_t start_rev = incremental ? 7 : 0;
+      svn_stringbuf_t *expected, *actual;
+      int expected_count, actual_count;
+
+      SVN_ERR(dump_with_config(&expected, &expected_count, repos_path, NULL,
+                               start_rev, youngest_rev, incremental,
+                               subpool));
+      SVN_ERR(dump_with_config(&actual, &actual_count, repos_path, fs_config,
+                               start_rev, youngest_rev, incremental,
+                               subpool));
+
+      SVN_TEST_ASSERT(svn_stringbuf_compare(actual, expected));
+      SVN_TEST_INT_ASSERT(actual_count, expected_count);
+      svn_pool_clear(subpool);
+    }
+
+  svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -284,6 +408,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test dumping with r0 mergeinfo"),
     SVN_TEST_OPTS_PASS(test_load_r0_mergeinfo,
                        "test loading with r0 mergeinfo"),
+    SVN_TEST_OPTS_PASS(test_dump_concurrently,
+                       "test dumping with several worker threads"),
     SVN_TEST_NULL
   };
 
@@ -1501,6 +1501,59 @@ test_authz_wildcards(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Test that wildcard lookups give consistent results when the same paths
+ * get looked up repeatedly, i.e. when the lookup follows transitions it
+ * has taken before. */
+static svn_error_t *
+test_authz_wildcard_repeated(apr_pool_t *pool)
+{
+  svn_authz_t *authz_cfg;
+  int i;
+
+  /* Suffix and prefix patterns that both match the same segment. */
+  const char *contents =
+    "[:glob:/**/*.c]"                                                        NL
+    "* = r"                                                                  NL
+    ""                                                                       NL
+    "[:glob:/A/main*]"                                                       NL
+    "* = rw"                                                                 NL
+    ""                                                                       NL
+    "[:glob:/*/*/*in*]"                                                      NL
+    "* ="                                                                    NL;
+
+  /* Definition of the paths to test and expected replies for each. */
+  struct check_access_tests test_set[] = {
+    { "/", NULL, NULL, svn_authz_read, FALSE },              /* default */
+    { "/A", NULL, NULL, svn_authz_read, FALSE },             /* inherited */
+    { "/A/main.c", NULL, NULL, svn_authz_write, TRUE },      /* rule 2 */
+    { "/A/main.h", NULL, NULL, svn_authz_write, TRUE },      /* rule 2 */
+    { "/A/util.c", NULL, NULL, svn_authz_read, TRUE },       /* rule 1 */
+    { "/A/util.c", NULL, NULL, svn_authz_write, FALSE },     /* rule 1 */
+    { "/A/util.h", NULL, NULL, svn_authz_read, FALSE },      /* inherited */
+    { "/B/main.c", NULL, NULL, svn_authz_read, TRUE },       /* rule 1 */
+    { "/B/main.c", NULL, NULL, svn_authz_write, FALSE },     /* rule 1 */
+    { "/A/main.c/x.c", NULL, NULL, svn_authz_read, TRUE },   /* rule 1 */
+    { "/A/main.c/x.h", NULL, NULL, svn_authz_write, TRUE },  /* inherited */
+    { "/A/B/main.c", NULL, NULL, svn_authz_read, FALSE },    /* rule 3 */
+    { "/A/B/util.c", NULL, NULL, svn_authz_read, TRUE },     /* rule 1 */
+    { "/C/D/E/main.c", NULL, NULL, svn_authz_read, TRUE },   /* rule 1 */
+    { "/A", NULL, NULL, svn_authz_read | svn_authz_recursive, FALSE },
+    { "/A/main.h", NULL, NULL, svn_authz_write | svn_authz_recursive, FALSE },
+    /* Sentinel */
+    { NULL, NULL, NULL, svn_authz_none, FALSE }
+  };
+
+  /* Load the test authz rules. */
+  SVN_ERR(authz_get_handle(&authz_cfg, contents, FALSE, pool));
+
+  /* The first iteration builds the lookup structures, the later ones
+   * reuse them. */
+  for (i = 0; i < 3; ++i)
+    SVN_ERR(authz_check_access(authz_cfg, test_set, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Test the authz performance with wildcard rules. */
 static svn_error_t *
 test_authz_wildcard_performance(apr_pool_t *pool)
@@ -3274,6 +3327,137 @@ reporter_depth_exclude(const svn_test_opts_t *opts,
 }
 
 
+/* Drive an update of REPOS from revision FROM_REV to revision 2 into a
+   transaction based on FROM_REV and verify that the result matches the
+   tree ENTRIES.  If START_EMPTY is set, report the working copy as empty,
+   i.e. do a checkout.  ZERO_COPY_LIMIT is passed to the reporter. */
+static svn_error_t *
+verify_report_drive(svn_repos_t *repos,
+                    svn_revnum_t from_rev,
+                    svn_boolean_t start_empty,
+                    apr_size_t zero_copy_limit,
+                    svn_test__tree_entry_t *entries,
+                    int num_entries,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  const svn_delta_editor_t *editor;
+  void *edit_baton, *report_baton;
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, from_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(dir_delta_get_editor(&editor, &edit_baton, fs,
+                               txn_root, "", pool));
+
+  SVN_ERR(svn_repos_begin_report3(&report_baton, 2, repos, "/", "", NULL,
+                                  TRUE, svn_depth_infinity, FALSE, FALSE,
+                                  editor, edit_baton, NULL, NULL,
+                                  zero_copy_limit, pool));
+  SVN_ERR(svn_repos_set_path3(report_baton, "", from_rev,
+                              svn_depth_infinity,
+                              start_empty, NULL, pool));
+  SVN_ERR(svn_repos_finish_report(report_baton, pool));
+
+  SVN_ERR(svn_test__validate_tree(txn_root, entries, num_entries, pool));
+  SVN_ERR(svn_fs_abort_txn(txn, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+reporter_concurrent_deltas(const svn_test_opts_t *opts,
+                           apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_revnum_t youngest_rev;
+  static svn_test__tree_entry_t entries[] = {
+    { "iota",        "Changed file 'iota'.\n" },
+    { "A",           0 },
+    { "A/mu",        "Changed file 'mu'.\n" },
+    { "A/B",         0 },
+    { "A/B/bar",     "New file 'bar'.\n" },
+    { "A/B/lambda",  "This is the file 'lambda'.\n" },
+    { "A/B/E",       0 },
+    { "A/B/E/alpha", "Changed file 'alpha'.\n" },
+    { "A/B/E/beta",  "This is the file 'beta'.\n" },
+    { "A/B/F",       0 },
+    { "A/C",         0 },
+    { "A/D",         0 },
+    { "A/D/foo",     "New file 'foo'.\n" },
+    { "A/D/gamma",   "This is the file 'gamma'.\n" },
+    { "A/D/G",       0 },
+    { "A/D/G/pi",    "Changed file 'pi'.\n" },
+    { "A/D/G/rho",   "Changed file 'rho'.\n" },
+    { "A/D/G/tau",   "This is the file 'tau'.\n" },
+  };
+
+  SVN_ERR(svn_test__create_repos(&repos,
+                                 "test-repo-reporter-concurrent-deltas",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* Revision 1: the greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* Revision 2: modify and add several files per directory. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  {
+    static svn_test__txn_script_command_t script_entries[] = {
+      { 'e', "iota",        "Changed file 'iota'.\n" },
+      { 'e', "A/mu",        "Changed file 'mu'.\n" },
+      { 'e', "A/B/E/alpha", "Changed file 'alpha'.\n" },
+      { 'e', "A/D/G/pi",    "Changed file 'pi'.\n" },
+      { 'e', "A/D/G/rho",   "Changed file 'rho'.\n" },
+      { 'a', "A/D/foo",     "New file 'foo'.\n" },
+      { 'a', "A/B/bar",     "New file 'bar'.\n" },
+      { 'd', "A/D/H",       NULL }
+    };
+    SVN_ERR(svn_test__txn_script_exec(txn_root,
+                                      script_entries,
+                                      sizeof(script_entries)/
+                                       sizeof(script_entries[0]),
+                                      subpool));
+  }
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* Compute the deltas on worker threads.  BDB ignores the option. */
+  svn_hash_sets(fs_config, SVN_REPOS_CONFIG_REPORT_JOBS, "4");
+  SVN_ERR(svn_repos_open3(&repos, svn_repos_path(repos, pool), fs_config,
+                          pool, pool));
+
+  /* Checkout and update must produce the r2 tree. */
+  SVN_ERR(verify_report_drive(repos, 0, TRUE, 0, entries,
+                              sizeof(entries) / sizeof(entries[0]),
+                              subpool));
+  svn_pool_clear(subpool);
+  SVN_ERR(verify_report_drive(repos, 1, FALSE, 0, entries,
+                              sizeof(entries) / sizeof(entries[0]),
+                              subpool));
+  svn_pool_clear(subpool);
+
+  /* The same with changed files being sent as cached fulltexts. */
+  SVN_ERR(verify_report_drive(repos, 1, FALSE, 0x10000, entries,
+                              sizeof(entries) / sizeof(entries[0]),
+                              subpool));
+
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Test if prop values received by the server are validated.
  * These tests "send" property values to the server and diagnose the
@@ -3512,6 +3696,118 @@ get_logs(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Revision receiver that appends the revision numbers to the
+   apr_array_header_t in BATON. */
+static svn_error_t *
+log_entry_rev_receiver(void *baton,
+                       svn_repos_log_entry_t *log_entry,
+                       apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *revs = baton;
+
+  APR_ARRAY_PUSH(revs, svn_revnum_t) = log_entry->revision;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+get_logs_concurrently(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  svn_repos_t *repos, *concurrent_repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev = 0;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  apr_array_header_t *paths = apr_array_make(pool, 4, sizeof(const char *));
+  apr_pool_t *subpool = svn_pool_create(pool);
+  int i, limit;
+
+  /* Create a filesystem and repository. */
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-get-logs-concurrently",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* Revision 1:  Add the Greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Change the log targets in different patterns, often enough for the
+     histories to be walked in several batches.  Copy one of them half-way
+     through so the walk has to follow that copy. */
+  for (i = 0; i < 150; i++)
+    {
+      svn_pool_clear(subpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+
+      if (i == 75)
+        {
+          SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev,
+                                       subpool));
+          SVN_ERR(svn_fs_copy(rev_root, "A/mu", txn_root, "A/mu2", subpool));
+        }
+      else
+        {
+          const char *contents = apr_psprintf(subpool, "Revision %d", i);
+
+          SVN_ERR(svn_test__set_file_contents(txn_root,
+                                              i < 75 ? "A/mu" : "A/mu2",
+                                              contents, subpool));
+          if (i % 3 == 0)
+            SVN_ERR(svn_test__set_file_contents(txn_root, "A/B/E/alpha",
+                                                contents, subpool));
+          if (i % 7 == 0)
+            SVN_ERR(svn_test__set_file_contents(txn_root, "A/D/G/pi",
+                                                contents, subpool));
+        }
+
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      subpool));
+    }
+
+  /* BDB does not support concurrent walks and simply ignores the option. */
+  svn_hash_sets(fs_config, SVN_REPOS_CONFIG_LOG_JOBS, "4");
+  SVN_ERR(svn_repos_open3(&concurrent_repos, svn_repos_path(repos, pool),
+                          fs_config, pool, pool));
+
+  APR_ARRAY_PUSH(paths, const char *) = "/A/mu2";
+  APR_ARRAY_PUSH(paths, const char *) = "/A/B/E/alpha";
+  APR_ARRAY_PUSH(paths, const char *) = "/A/D/G/pi";
+  APR_ARRAY_PUSH(paths, const char *) = "/iota";
+
+  /* Both repository instances must report the same revisions. */
+  for (limit = 0; limit <= 100; limit += 25)
+    {
+      apr_array_header_t *expected, *actual;
+
+      svn_pool_clear(subpool);
+      expected = apr_array_make(subpool, 0, sizeof(svn_revnum_t));
+      actual = apr_array_make(subpool, 0, sizeof(svn_revnum_t));
+
+      SVN_ERR(svn_repos_get_logs5(repos, paths, youngest_rev, 0, limit,
+                                  FALSE, FALSE, NULL, NULL, NULL,
+                                  NULL, NULL,
+                                  log_entry_rev_receiver, expected,
+                                  subpool));
+      SVN_ERR(svn_repos_get_logs5(concurrent_repos, paths, youngest_rev, 0,
+                                  limit, FALSE, FALSE, NULL, NULL, NULL,
+                                  NULL, NULL,
+                                  log_entry_rev_receiver, actual,
+                                  subpool));
+
+      SVN_TEST_INT_ASSERT(actual->nelts, expected->nelts);
+      for (i = 0; i < expected->nelts; i++)
+        SVN_TEST_INT_ASSERT(APR_ARRAY_IDX(actual, i, svn_revnum_t),
+                            APR_ARRAY_IDX(expected, i, svn_revnum_t));
+    }
+
+  svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
+}
+
 
 /* Tests for svn_repos_get_file_revsN() */
 
@@ -4458,14 +4754,529 @@ test_list(const svn_test_opts_t *opts,
   patterns = apr_array_make(pool, 1, sizeof(const char *));
   APR_ARRAY_PUSH(patterns, const char *) = "*a*";
   SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
-  SVN_ERR(svn_repos_list(rev_root, "/A", patterns, svn_depth_infinity, FALSE,
-                         NULL, NULL, list_callback, &counter, NULL, NULL,
-                         pool));
+  SVN_ERR(svn_repos_list2(rev_root, "/A", patterns, svn_depth_infinity,
+                          SVN_DIRENT_ALL, NULL, NULL, list_callback, &counter,
+                          NULL, NULL, pool));
   SVN_TEST_ASSERT(counter == 7);
 
   return SVN_NO_ERROR;
 }
 
+/* Test listing directories with authz read restrictions, checking the
+ * entries of each directory all at once. */
+static svn_error_t *
+test_list_authz(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev;
+  svn_authz_t *authz_cfg;
+  svn_repos_authz_func_t authz_read_func;
+  void *authz_read_baton;
+  apr_array_header_t *names;
+  svn_boolean_t granted[4];
+  int counter = 0;
+
+  const char *contents =
+    "[/]"                                                                    NL
+    "* = r"                                                                  NL
+    ""                                                                       NL
+    "[/A/B]"                                                                 NL
+    "* ="                                                                    NL
+    ""                                                                       NL
+    "[/A/D/G]"                                                               NL
+    "* ="                                                                    NL;
+
+  /* Create yet another greek tree repository. */
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-list-authz", opts, pool));
+  fs = svn_repos_fs(repos);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+
+  SVN_ERR(authz_get_handle(&authz_cfg, contents, FALSE, pool));
+
+  /* Check the children of /A directly. */
+  names = apr_array_make(pool, 4, sizeof(const char *));
+  APR_ARRAY_PUSH(names, const char *) = "mu";
+  APR_ARRAY_PUSH(names, const char *) = "B";
+  APR_ARRAY_PUSH(names, const char *) = "C";
+  APR_ARRAY_PUSH(names, const char *) = "D";
+  SVN_ERR(svn_repos_authz_check_children(authz_cfg, NULL, "/A/", names,
+                                         "plato", svn_authz_read, granted,
+                                         pool));
+  SVN_TEST_ASSERT(granted[0] && !granted[1] && granted[2] && granted[3]);
+
+  /* List everything under /A except for the B and G sub-trees. */
+  svn_repos__authz_read_func_create(&authz_read_func, &authz_read_baton,
+                                    authz_cfg, NULL, "plato", pool);
+  SVN_ERR(svn_repos_list2(rev_root, "/A", NULL, svn_depth_infinity,
+                          SVN_DIRENT_ALL, authz_read_func, authz_read_baton,
+                          list_callback, &counter, NULL, NULL, pool));
+  SVN_TEST_INT_ASSERT(counter, 9);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_dirent_receiver_t, appending a description of
+ * each entry to the apr_array_header_t in BATON. */
+static svn_error_t *
+list_describe_callback(const char *path,
+                       svn_dirent_t *dirent,
+                       void *baton,
+                       apr_pool_t *pool)
+{
+  apr_array_header_t *entries = baton;
+
+  APR_ARRAY_PUSH(entries, const char *)
+    = apr_psprintf(entries->pool, "%s %s %" SVN_FILESIZE_T_FMT " %ld",
+                   path, svn_node_kind_to_word(dirent->kind), dirent->size,
+                   dirent->created_rev);
+
+  return SVN_NO_ERROR;
+}
+
+/* List PATH in ROOT with the given PATTERNS, DIRENT_FIELDS and authz
+ * settings and return the descriptions of all entries in *ENTRIES. */
+static svn_error_t *
+list_describe(apr_array_header_t **entries,
+              svn_fs_root_t *root,
+              const char *path,
+              const apr_array_header_t *patterns,
+              apr_uint32_t dirent_fields,
+              svn_repos_authz_func_t authz_read_func,
+              void *authz_read_baton,
+              apr_pool_t *pool)
+{
+  *entries = apr_array_make(pool, 16, sizeof(const char *));
+  SVN_ERR(svn_repos_list2(root, path, patterns, svn_depth_infinity,
+                          dirent_fields, authz_read_func, authz_read_baton,
+                          list_describe_callback, *entries, NULL, NULL,
+                          pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Test that listing on multiple threads and with only some dirent fields
+ * reports the same entries in the same order. */
+static svn_error_t *
+test_list_concurrently(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_repos_t *repos, *concurrent_repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root, *concurrent_root;
+  svn_revnum_t youngest_rev;
+  svn_authz_t *authz_cfg;
+  svn_repos_authz_func_t authz_read_func;
+  void *authz_read_baton;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  apr_array_header_t *patterns, *expected, *actual;
+  int i, k;
+
+  const char *contents =
+    "[/]"                                                                    NL
+    "* = r"                                                                  NL
+    ""                                                                       NL
+    "[/A/B/E]"                                                               NL
+    "* ="                                                                    NL
+    ""                                                                       NL
+    "[/A/D/G]"                                                               NL
+    "* ="                                                                    NL;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-list-concurrently",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+
+  /* Fields that have not been requested will not be filled in. */
+  SVN_ERR(list_describe(&actual, rev_root, "/A/B", NULL, SVN_DIRENT_SIZE,
+                        NULL, NULL, pool));
+  SVN_TEST_INT_ASSERT(actual->nelts, 6);
+  SVN_TEST_STRING_ASSERT(APR_ARRAY_IDX(actual, 1, const char *),
+                         "/A/B/E dir -1 0");
+  SVN_TEST_STRING_ASSERT(APR_ARRAY_IDX(actual, 2, const char *),
+                         "/A/B/E/alpha file 26 0");
+
+  SVN_ERR(list_describe(&actual, rev_root, "/A/B", NULL,
+                        SVN_DIRENT_CREATED_REV, NULL, NULL, pool));
+  SVN_TEST_STRING_ASSERT(APR_ARRAY_IDX(actual, 2, const char *),
+                         "/A/B/E/alpha file 0 1");
+
+  /* BDB does not support concurrent listings and simply ignores the
+     option. */
+  svn_hash_sets(fs_config, SVN_REPOS_CONFIG_LIST_JOBS, "4");
+  SVN_ERR(svn_repos_open3(&concurrent_repos, svn_repos_path(repos, pool),
+                          fs_config, pool, pool));
+  SVN_ERR(svn_fs_revision_root(&concurrent_root,
+                               svn_repos_fs(concurrent_repos),
+                               youngest_rev, pool));
+
+  SVN_ERR(authz_get_handle(&authz_cfg, contents, FALSE, pool));
+  svn_repos__authz_read_func_create(&authz_read_func, &authz_read_baton,
+                                    authz_cfg, NULL, "plato", pool);
+  patterns = apr_array_make(pool, 1, sizeof(const char *));
+  APR_ARRAY_PUSH(patterns, const char *) = "*a*";
+
+  /* Compare with and without patterns and authz. */
+  for (i = 0; i < 4; i++)
+    {
+      const apr_array_header_t *list_patterns = (i & 1) ? patterns : NULL;
+      svn_repos_authz_func_t list_authz_func
+        = (i & 2) ? authz_read_func : NULL;
+
+      SVN_ERR(list_describe(&expected, rev_root, "/", list_patterns,
+                            SVN_DIRENT_ALL, list_authz_func,
+                            authz_read_baton, pool));
+      SVN_ERR(list_describe(&actual, concurrent_root, "/", list_patterns,
+                            SVN_DIRENT_ALL, list_authz_func,
+                            authz_read_baton, pool));
+
+      SVN_TEST_INT_ASSERT(actual->nelts, expected->nelts);
+      for (k = 0; k < expected->nelts; k++)
+        SVN_TEST_STRING_ASSERT(APR_ARRAY_IDX(actual, k, const char *),
+                               APR_ARRAY_IDX(expected, k, const char *));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_blame_receiver_t, appending the revisions to the
+ * apr_array_header_t in BATON. */
+static svn_error_t *
+blame_rev_receiver(void *baton,
+                   apr_int64_t line_no,
+                   svn_revnum_t revision,
+                   apr_pool_t *pool)
+{
+  apr_array_header_t *revs = baton;
+
+  SVN_TEST_ASSERT(line_no == revs->nelts);
+  APR_ARRAY_PUSH(revs, svn_revnum_t) = revision;
+  return SVN_NO_ERROR;
+}
+
+/* Blame PATH in REPOS between START and END and compare the result with
+ * the EXPECTED_COUNT revisions in EXPECTED. */
+static svn_error_t *
+check_blame(svn_repos_t *repos,
+            const char *path,
+            svn_revnum_t start,
+            svn_revnum_t end,
+            const svn_revnum_t *expected,
+            int expected_count,
+            apr_pool_t *pool)
+{
+  apr_array_header_t *revs = apr_array_make(pool, 0, sizeof(svn_revnum_t));
+  int i;
+
+  SVN_ERR(svn_repos_blame(repos, path, start, end, NULL, NULL,
+                          blame_rev_receiver, revs, NULL, NULL, pool));
+
+  SVN_TEST_INT_ASSERT(revs->nelts, expected_count);
+  for (i = 0; i < expected_count; i++)
+    SVN_TEST_INT_ASSERT(APR_ARRAY_IDX(revs, i, svn_revnum_t), expected[i]);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_blame(const svn_test_opts_t *opts,
+           apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  int i;
+
+  const char *contents[] =
+    {
+      "line1\nline2\nline3\n",
+      "line1\nchanged\nline3\n",
+      NULL,
+      "line0\nline1\nchanged\nline3\n"
+    };
+  const svn_revnum_t full[] = { 5, 2, 3, 2 };
+  const svn_revnum_t partial[] = { 5, SVN_INVALID_REVNUM, 3,
+                                   SVN_INVALID_REVNUM };
+  const svn_revnum_t older[] = { 2, 3, 2 };
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-blame", opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* Revision 1:  Add the Greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Revisions 2 to 5:  Change iota, except in r4 which changes mu. */
+  for (i = 0; i < sizeof(contents) / sizeof(contents[0]); i++)
+    {
+      svn_pool_clear(subpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root,
+                                          contents[i] ? "iota" : "A/mu",
+                                          contents[i] ? contents[i] : "mu\n",
+                                          subpool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      subpool));
+    }
+
+  /* The second run gets its line maps from the cache. */
+  SVN_ERR(check_blame(repos, "/iota", 0, 5, full, 4, subpool));
+  SVN_ERR(check_blame(repos, "/iota", 0, 5, full, 4, subpool));
+  SVN_ERR(check_blame(repos, "/iota", 3, 5, partial, 4, subpool));
+  SVN_ERR(check_blame(repos, "/iota", 0, 3, older, 3, subpool));
+
+  /* Directories cannot be blamed. */
+  SVN_TEST_ASSERT_ERROR(check_blame(repos, "/A", 0, 5, NULL, 0, subpool),
+                        SVN_ERR_FS_NOT_FILE);
+
+  svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
+}
+
+/* Baton for replay_range_revstart() and replay_range_revfinish(). */
+typedef struct replay_range_baton_t
+{
+  /* The repository to replay the revisions into. */
+  svn_fs_t *mirror_fs;
+  svn_fs_txn_t *txn;
+} replay_range_baton_t;
+
+/* Implements svn_repos_replay_revstart_func_t.
+   Start a new transaction in the mirror of the replay_range_baton_t
+   REPLAY_BATON and return an editor that edits it. */
+static svn_error_t *
+replay_range_revstart(svn_revnum_t revision,
+                      void *replay_baton,
+                      const svn_delta_editor_t **editor,
+                      void **edit_baton,
+                      apr_hash_t *rev_props,
+                      apr_pool_t *pool)
+{
+  replay_range_baton_t *rb = replay_baton;
+  svn_fs_root_t *txn_root;
+
+  SVN_TEST_ASSERT(svn_hash_gets(rev_props, SVN_PROP_REVISION_DATE));
+
+  SVN_ERR(svn_fs_begin_txn(&rb->txn, rb->mirror_fs, revision - 1, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, rb->txn, pool));
+  SVN_ERR(dir_delta_get_editor(editor, edit_baton, rb->mirror_fs, txn_root,
+                               "", pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_replay_revfinish_func_t.
+   Commit the transaction in the mirror of the replay_range_baton_t
+   REPLAY_BATON as REVISION. */
+static svn_error_t *
+replay_range_revfinish(svn_revnum_t revision,
+                       void *replay_baton,
+                       const svn_delta_editor_t *editor,
+                       void *edit_baton,
+                       apr_hash_t *rev_props,
+                       apr_pool_t *pool)
+{
+  replay_range_baton_t *rb = replay_baton;
+  svn_revnum_t new_rev;
+
+  SVN_ERR(editor->close_edit(edit_baton, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &new_rev, rb->txn, pool));
+  SVN_TEST_INT_ASSERT(new_rev, revision);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_replay_range(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev = 0;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  const char *jobs[] = { "1", "4" };
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-replay-range", opts,
+                                 pool));
+  fs = svn_repos_fs(repos);
+
+  /* Revision 1:  Add the Greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* Modify and add files in enough revisions for the read-ahead to
+     have some work to do. */
+  for (i = 0; i < 20; i++)
+    {
+      const char *contents;
+
+      svn_pool_clear(subpool);
+      contents = apr_psprintf(subpool, "Revision %d\n", i);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu", contents,
+                                          subpool));
+      if (i % 2)
+        SVN_ERR(svn_test__set_file_contents(txn_root, "iota", contents,
+                                            subpool));
+      if (i % 5 == 0)
+        {
+          const char *path = apr_psprintf(subpool, "A/C/file%d", i);
+
+          SVN_ERR(svn_fs_make_file(txn_root, path, subpool));
+          SVN_ERR(svn_test__set_file_contents(txn_root, path, contents,
+                                              subpool));
+        }
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      subpool));
+    }
+
+  /* Replay everything into a fresh mirror, with and without read-ahead.
+     BDB does not support read-ahead and simply ignores the option. */
+  for (i = 0; i < sizeof(jobs) / sizeof(jobs[0]); i++)
+    {
+      svn_repos_t *source, *mirror;
+      replay_range_baton_t rb;
+      apr_hash_t *fs_config;
+      svn_fs_root_t *mirror_root;
+      const char *paths[] = { "A/mu", "iota", "A/C/file15" };
+      int k;
+
+      svn_pool_clear(subpool);
+      fs_config = apr_hash_make(subpool);
+      svn_hash_sets(fs_config, SVN_REPOS_CONFIG_REPLAY_JOBS, jobs[i]);
+      SVN_ERR(svn_repos_open3(&source, svn_repos_path(repos, subpool),
+                              fs_config, subpool, subpool));
+      SVN_ERR(svn_test__create_repos(&mirror,
+                                     apr_psprintf(subpool,
+                                                  "test-repo-replay-range-%s",
+                                                  jobs[i]),
+                                     opts, subpool));
+
+      rb.mirror_fs = svn_repos_fs(mirror);
+      SVN_ERR(svn_repos_replay_range(source, 1, youngest_rev, "", 0, TRUE,
+                                     replay_range_revstart,
+                                     replay_range_revfinish, &rb,
+                                     NULL, NULL, NULL, NULL, subpool));
+
+      /* The mirror must have the same contents as the source. */
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, subpool));
+      SVN_ERR(svn_fs_revision_root(&mirror_root, rb.mirror_fs, youngest_rev,
+                                   subpool));
+      for (k = 0; k < sizeof(paths) / sizeof(paths[0]); k++)
+        {
+          svn_stringbuf_t *expected, *actual;
+
+          SVN_ERR(svn_test__get_file_contents(rev_root, paths[k], &expected,
+                                              subpool));
+          SVN_ERR(svn_test__get_file_contents(mirror_root, paths[k],
+                                              &actual, subpool));
+          SVN_TEST_STRING_ASSERT(actual->data, expected->data);
+        }
+    }
+
+  svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_hook_server(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+#ifdef WIN32
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                          "hook server script requires a Unix shell");
+#else
+  svn_repos_t *repos;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t new_rev;
+  svn_stringbuf_t *pids;
+  const char *hook, *pid_file;
+  svn_error_t *err, *cause;
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-hook-server", opts,
+                                 pool));
+
+  /* The pre-commit hook itself would accept everything. */
+  hook = svn_repos_pre_commit_hook(repos, pool);
+  SVN_ERR(svn_io_file_create(hook, "#!/bin/sh" NL "exit 0" NL, pool));
+  SVN_ERR(svn_io_set_file_executable(hook, TRUE, FALSE, pool));
+
+  /* The hook server rejects all pre-commit requests and records the
+     PID of each server process that has been started. */
+  pid_file = svn_dirent_join(svn_repos_path(repos, pool), "pids", pool);
+  hook = svn_dirent_join(svn_dirent_dirname(hook, pool), "hook-server",
+                         pool);
+  SVN_ERR(svn_io_file_create(hook, apr_pstrcat(pool,
+    "#!/bin/sh"                                                         NL
+    "echo $$ >> '", pid_file, "'"                                       NL
+    "while read name nargs nenv len; do"                                NL
+    "  i=0"                                                             NL
+    "  while [ $i -lt $((nargs + nenv)) ]; do"                          NL
+    "    read flen"                                                     NL
+    "    dd bs=1 count=$((flen + 1)) > /dev/null 2>&1"                  NL
+    "    i=$((i + 1))"                                                  NL
+    "  done"                                                            NL
+    "  dd bs=1 count=$len > /dev/null 2>&1"                             NL
+    "  if [ \"$name\" = pre-commit ]; then"                             NL
+    "    printf '1 0 18\\nrejected by server'"                          NL
+    "  else"                                                            NL
+    "    printf '0 0 0\\n'"                                             NL
+    "  fi"                                                              NL
+    "done"                                                              NL,
+    SVN_VA_NULL), pool));
+  SVN_ERR(svn_io_set_file_executable(hook, TRUE, FALSE, pool));
+
+  /* Both commits must get rejected by the same server process. */
+  for (i = 0; i < 2; i++)
+    {
+      SVN_ERR(svn_repos_fs_begin_txn_for_commit2(&txn, repos, 0,
+                                                 apr_hash_make(pool), pool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+      SVN_ERR(svn_fs_make_dir(root, "/whatever", pool));
+
+      err = svn_repos_fs_commit_txn(NULL, repos, &new_rev, txn, pool);
+      cause = svn_error_find_cause(err, SVN_ERR_REPOS_HOOK_FAILURE);
+      SVN_TEST_ASSERT(cause && strstr(cause->message, "rejected by server"));
+      svn_error_clear(err);
+
+      SVN_ERR(svn_fs_abort_txn(txn, pool));
+    }
+
+  SVN_ERR(svn_stringbuf_from_file2(&pids, pid_file, pool));
+  SVN_TEST_ASSERT(strchr(pids->data, '\n') == pids->data + pids->len - 1);
+
+  return SVN_NO_ERROR;
+#endif
+}
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -4501,10 +5312,14 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test svn_repos_node_location_segments"),
     SVN_TEST_OPTS_PASS(reporter_depth_exclude,
                        "test reporter and svn_depth_exclude"),
+    SVN_TEST_OPTS_PASS(reporter_concurrent_deltas,
+                       "test reporter with concurrent text deltas"),
     SVN_TEST_OPTS_PASS(prop_validation,
                        "test if revprops are validated by repos"),
     SVN_TEST_OPTS_PASS(get_logs,
                        "test svn_repos_get_logs ranges and limits"),
+    SVN_TEST_OPTS_PASS(get_logs_concurrently,
+                       "test svn_repos_get_logs5 with concurrent walks"),
     SVN_TEST_OPTS_PASS(test_get_file_revs,
                        "test svn_repos_get_file_revsN"),
     SVN_TEST_OPTS_PASS(issue_4060,
@@ -4533,10 +5348,22 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test various basic authz pattern combinations"),
     SVN_TEST_PASS2(test_authz_wildcards,
                    "test the different types of authz wildcards"),
+    SVN_TEST_PASS2(test_authz_wildcard_repeated,
+                   "test repeated authz wildcard lookups"),
     SVN_TEST_SKIP2(test_authz_wildcard_performance, TRUE,
                    "optional authz wildcard performance test"),
     SVN_TEST_OPTS_PASS(test_list,
                        "test svn_repos_list"),
+    SVN_TEST_OPTS_PASS(test_list_authz,
+                       "test svn_repos_list with authz restrictions"),
+    SVN_TEST_OPTS_PASS(test_list_concurrently,
+                       "test svn_repos_list2 on multiple threads"),
+    SVN_TEST_OPTS_PASS(test_blame,
+                       "test svn_repos_blame"),
+    SVN_TEST_OPTS_PASS(test_replay_range,
+                       "test svn_repos_replay_range"),
+    SVN_TEST_OPTS_PASS(test_hook_server,
+                       "test running hooks on a hook server"),
     SVN_TEST_NULL
   };
 
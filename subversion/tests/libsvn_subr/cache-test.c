@@ -26,9 +26,17 @@
 #include <apr_general.h>
 #include <apr_lib.h>
 #include <apr_time.h>
+#include <apr_thread_proc.h>
+
+#if APR_HAS_FORK
+#include <unistd.h>   /* for _exit() */
+#endif
 
 #include "svn_pools.h"
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
 
+#include "private/svn_atomic.h"
 #include "private/svn_cache.h"
 #include "svn_private_config.h"
 
@@ -67,6 +75,27 @@ create_memcache(svn_memcache_t **memcache,
   return SVN_NO_ERROR;
 }
 
+/* Create a Redis server set if configured */
+static svn_error_t *
+create_redis(svn_redis_t **redis,
+             const svn_test_opts_t *opts,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  svn_config_t *config;
+
+  *redis = NULL;
+  if (!opts->config_file)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_config_read3(&config, opts->config_file,
+                           TRUE, FALSE, FALSE, scratch_pool));
+  SVN_ERR(svn_cache__make_redis_from_config(redis, config,
+                                            result_pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Implements svn_cache__serialize_func_t */
 static svn_error_t *
 serialize_revnum(void **data,
@@ -156,6 +185,51 @@ basic_cache_test(svn_cache__t *cache,
   return SVN_NO_ERROR;
 }
 
+/* Store revnums for the keys "0" to "9" with even values in CACHE.
+ * Use POOL for temporary allocations.
+ */
+static svn_error_t *
+fill_even_keys(svn_cache__t *cache,
+               apr_pool_t *pool)
+{
+  svn_revnum_t i;
+  for (i = 0; i < 10; i += 2)
+    SVN_ERR(svn_cache__set(cache, apr_psprintf(pool, "%ld", i), &i, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Look up the keys "0" to "9" plus a NULL key in CACHE with a single
+ * svn_cache__get_many call and verify that exactly the entries stored by
+ * fill_even_keys() are being found.  Use POOL for allocations.
+ */
+static svn_error_t *
+verify_even_keys(svn_cache__t *cache,
+                 apr_pool_t *pool)
+{
+  const char *keys[11];
+  void *values[11];
+  svn_boolean_t found[11];
+  int i;
+
+  for (i = 0; i < 10; ++i)
+    keys[i] = apr_psprintf(pool, "%d", i);
+  keys[10] = NULL;
+
+  SVN_ERR(svn_cache__get_many(values, found, cache,
+                              (const void * const *)keys, 11, pool));
+
+  for (i = 0; i < 10; ++i)
+    {
+      SVN_TEST_ASSERT(found[i] == (i % 2 == 0));
+      if (found[i])
+        SVN_TEST_ASSERT(*(svn_revnum_t *)values[i] == i);
+    }
+  SVN_TEST_ASSERT(!found[10]);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_inprocess_cache_basic(apr_pool_t *pool)
 {
@@ -203,13 +277,78 @@ test_memcache_basic(const svn_test_opts_t *opts,
   return basic_cache_test(cache, FALSE, pool);
 }
 
+static svn_error_t *
+test_memcache_get_many(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_memcache_t *memcache = NULL;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  const char *prefix = apr_psprintf(pool,
+                                    "test_memcache_get_many-%" APR_TIME_T_FMT,
+                                    apr_time_now());
+
+  SVN_ERR(create_memcache(&memcache, opts, subpool, pool));
+  if (! memcache)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "not configured to use memcached");
+
+  /* Write asynchronously.  Destroying SUBPOOL waits for all writes to
+   * complete. */
+  SVN_ERR(svn_cache__memcache_enable_async_sets(memcache));
+  SVN_ERR(svn_cache__create_memcache(&cache, memcache,
+                                     serialize_revnum, deserialize_revnum,
+                                     APR_HASH_KEY_STRING, prefix, subpool));
+  SVN_ERR(fill_even_keys(cache, subpool));
+  svn_pool_destroy(subpool);
+
+  /* Read everything back in a single multi-get. */
+  SVN_ERR(create_memcache(&memcache, opts, pool, pool));
+  SVN_ERR(svn_cache__create_memcache(&cache, memcache,
+                                     serialize_revnum, deserialize_revnum,
+                                     APR_HASH_KEY_STRING, prefix, pool));
+
+  return verify_even_keys(cache, pool);
+}
+
+static svn_error_t *
+test_redis_basic(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_redis_t *redis;
+  const char *prefix = apr_psprintf(pool,
+                                    "test_redis_basic-%" APR_TIME_T_FMT,
+                                    apr_time_now());
+
+  SVN_ERR(create_redis(&redis, opts, pool, pool));
+  if (! redis)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "not configured to use Redis");
+
+  SVN_ERR(svn_cache__create_redis(&cache, redis,
+                                  serialize_revnum, deserialize_revnum,
+                                  APR_HASH_KEY_STRING, prefix, pool));
+  SVN_ERR(basic_cache_test(cache, FALSE, pool));
+
+  /* Read back values that may live on different servers in a single
+   * pipelined multi-get. */
+  prefix = apr_pstrcat(pool, prefix, "-many", SVN_VA_NULL);
+  SVN_ERR(svn_cache__create_redis(&cache, redis,
+                                  serialize_revnum, deserialize_revnum,
+                                  APR_HASH_KEY_STRING, prefix, pool));
+  SVN_ERR(fill_even_keys(cache, pool));
+
+  return verify_even_keys(cache, pool);
+}
+
 static svn_error_t *
 test_membuffer_cache_basic(apr_pool_t *pool)
 {
   svn_cache__t *cache;
   svn_membuffer_t *membuffer;
 
-  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0, 1,
                                             TRUE, TRUE, pool));
 
   /* Create a cache with just one entry. */
@@ -227,6 +366,237 @@ test_membuffer_cache_basic(apr_pool_t *pool)
   return basic_cache_test(cache, FALSE, pool);
 }
 
+static svn_error_t *
+test_cache_get_many(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+
+  /* Without native support in the backend. */
+  SVN_ERR(svn_cache__create_inprocess(&cache,
+                                      serialize_revnum,
+                                      deserialize_revnum,
+                                      APR_HASH_KEY_STRING,
+                                      16, 1, TRUE, "", pool));
+  SVN_ERR(fill_even_keys(cache, pool));
+  SVN_ERR(verify_even_keys(cache, pool));
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0, 1,
+                                            TRUE, TRUE, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE,
+                                            FALSE,
+                                            pool, pool));
+  SVN_ERR(fill_even_keys(cache, pool));
+  SVN_ERR(verify_even_keys(cache, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Create a membuffer cache front-end in *CACHE_P for MEMBUFFER that maps
+ * svn_revnum_t keys to svn_revnum_t values.  Use POOL for allocations.
+ */
+static svn_error_t *
+create_revnum_cache(svn_cache__t **cache_p,
+                    svn_membuffer_t *membuffer,
+                    apr_pool_t *pool)
+{
+  return svn_error_trace(svn_cache__create_membuffer_cache(
+                            cache_p,
+                            membuffer,
+                            serialize_revnum,
+                            deserialize_revnum,
+                            sizeof(svn_revnum_t),
+                            "revnums:",
+                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                            FALSE,
+                            FALSE,
+                            pool, pool));
+}
+
+static svn_error_t *
+test_membuffer_cache_snapshot(apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer;
+  svn_cache__t *cache;
+  svn_cache__t *string_cache;
+  const char *sb_dir;
+  const char *path;
+  svn_revnum_t rev, *result;
+  svn_boolean_t found;
+  svn_error_t *err;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&sb_dir, "cache-snapshot", pool));
+  path = svn_dirent_join(sb_dir, "snapshot", pool);
+
+  /* Fill a cache with items that can and can't be persisted. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024*1024, 64*1024,
+                                            0, 1, TRUE, TRUE, pool));
+  SVN_ERR(create_revnum_cache(&cache, membuffer, pool));
+  for (rev = 0; rev < 100; ++rev)
+    SVN_ERR(svn_cache__set(cache, &rev, &rev, pool));
+
+  SVN_ERR(svn_cache__create_membuffer_cache(&string_cache, membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "strings:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, TRUE, pool, pool));
+  rev = 42;
+  SVN_ERR(svn_cache__set(string_cache, "answer", &rev, pool));
+
+  err = svn_cache__membuffer_save(membuffer, path, pool);
+  if (err && err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, err,
+                            "snapshots are not supported by this build");
+  SVN_ERR(err);
+
+  /* Warm start of a new cache instance. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024*1024, 64*1024,
+                                            0, 1, TRUE, TRUE, pool));
+  SVN_ERR(svn_cache__membuffer_load(membuffer, path, pool));
+  SVN_ERR(create_revnum_cache(&cache, membuffer, pool));
+  for (rev = 0; rev < 100; ++rev)
+    {
+      SVN_ERR(svn_cache__get((void **)&result, &found, cache, &rev, pool));
+      SVN_TEST_ASSERT(found);
+      SVN_TEST_ASSERT(*result == rev);
+    }
+
+  /* Short-lived caches are not part of the snapshot. */
+  SVN_ERR(svn_cache__create_membuffer_cache(&string_cache, membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "strings:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, TRUE, pool, pool));
+  SVN_ERR(svn_cache__get((void **)&result, &found, string_cache, "answer",
+                         pool));
+  SVN_TEST_ASSERT(!found);
+
+  /* Missing and foreign snapshot files are silently ignored. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024*1024, 64*1024,
+                                            0, 1, TRUE, TRUE, pool));
+  SVN_ERR(svn_cache__membuffer_load(membuffer,
+                                    svn_dirent_join(sb_dir, "missing", pool),
+                                    pool));
+  SVN_ERR(svn_io_file_create(path, "not a cache snapshot", pool));
+  SVN_ERR(svn_cache__membuffer_load(membuffer, path, pool));
+
+  SVN_ERR(create_revnum_cache(&cache, membuffer, pool));
+  rev = 0;
+  SVN_ERR(svn_cache__get((void **)&result, &found, cache, &rev, pool));
+  SVN_TEST_ASSERT(!found);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_cache_partitioned(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+  svn_revnum_t value = 1;
+  svn_revnum_t *result;
+  svn_boolean_t found;
+
+  /* Use two partitions of two segments each. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024*1024, 4096, 4,
+                                            2, TRUE, TRUE, pool));
+
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE,
+                                            FALSE,
+                                            pool, pool));
+
+  SVN_ERR(basic_cache_test(cache, FALSE, pool));
+
+  /* Overwriting an entry must never leave the old value visible. */
+  SVN_ERR(svn_cache__set(cache, "key", &value, pool));
+  value = 2;
+  SVN_ERR(svn_cache__set(cache, "key", &value, pool));
+  SVN_ERR(svn_cache__get((void **)&result, &found, cache, "key", pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_ASSERT(*result == 2);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_cache_shared(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+  svn_revnum_t value = 42;
+  svn_revnum_t *result;
+  svn_boolean_t found;
+  svn_error_t *err;
+
+  err = svn_cache__membuffer_cache_create_shared(&membuffer, 1024*1024,
+                                                 4096, 2, TRUE, NULL, pool);
+  if (err && err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, err,
+                            "shared memory not supported");
+  SVN_ERR(err);
+
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE,
+                                            FALSE,
+                                            pool, pool));
+
+  SVN_ERR(basic_cache_test(cache, FALSE, pool));
+
+#if APR_HAS_FORK
+  {
+    /* Data written by a child process must be visible to the parent. */
+    apr_proc_t proc;
+    int exitcode;
+    apr_exit_why_e exitwhy;
+    apr_status_t status = apr_proc_fork(&proc, pool);
+
+    if (status == APR_INCHILD)
+      {
+        err = svn_cache__set(cache, "from-child", &value, pool);
+        _exit(err ? 1 : 0);
+      }
+    else if (status != APR_INPARENT)
+      return svn_error_wrap_apr(status, "Can't fork");
+
+    status = apr_proc_wait(&proc, &exitcode, &exitwhy, APR_WAIT);
+    if (status != APR_CHILD_DONE)
+      return svn_error_wrap_apr(status, "Can't wait for child");
+    SVN_TEST_ASSERT(APR_PROC_CHECK_EXIT(exitwhy) && exitcode == 0);
+
+    SVN_ERR(svn_cache__get((void **)&result, &found, cache, "from-child",
+                           pool));
+    SVN_TEST_ASSERT(found);
+    SVN_TEST_ASSERT(*result == 42);
+  }
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 /* Implements svn_cache__deserialize_func_t */
 static svn_error_t *
 raise_error_deserialize_func(void **out,
@@ -258,6 +628,312 @@ raise_error_partial_setter_func(void **data,
   return svn_error_create(APR_EGENERAL, NULL, NULL);
 }
 
+/* Return the entry for prefix class NAME in STATS or NULL. */
+static const svn_cache__prefix_stats_t *
+find_prefix_stats(const apr_array_header_t *stats,
+                  const char *name)
+{
+  int i;
+  for (i = 0; i < stats->nelts; ++i)
+    {
+      const svn_cache__prefix_stats_t *entry
+        = APR_ARRAY_IDX(stats, i, const svn_cache__prefix_stats_t *);
+      if (strcmp(entry->name, name) == 0)
+        return entry;
+    }
+
+  return NULL;
+}
+
+static svn_error_t *
+test_membuffer_cache_prefix_stats(apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer;
+  svn_cache__t *cache;
+  svn_cache__t *blob_cache;
+  apr_array_header_t *stats;
+  const svn_cache__prefix_stats_t *revnums, *blobs;
+  svn_stringbuf_t *blob;
+  svn_revnum_t rev, *result;
+  svn_boolean_t found;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024*1024, 64*1024,
+                                            0, 1, TRUE, TRUE, pool));
+
+  /* Fixed-size keys with a pooled prefix. */
+  SVN_ERR(create_revnum_cache(&cache, membuffer, pool));
+  for (rev = 0; rev < 100; ++rev)
+    SVN_ERR(svn_cache__set(cache, &rev, &rev, pool));
+  for (rev = 0; rev <= 100; ++rev)
+    SVN_ERR(svn_cache__get((void **)&result, &found, cache, &rev, pool));
+
+  /* Full keys.  Flood the cache and add one item that is too large. */
+  SVN_ERR(svn_cache__create_membuffer_cache(&blob_cache, membuffer,
+                                            NULL, NULL,
+                                            APR_HASH_KEY_STRING,
+                                            "repo:/path:BLOB",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+  blob = svn_stringbuf_create_ensure(1024, pool);
+  memset(blob->data, 'x', 1024);
+  blob->len = 1024;
+  blob->data[blob->len] = '\0';
+  for (i = 0; i < 10000; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_cache__set(blob_cache, apr_psprintf(iterpool, "%d", i),
+                             blob, iterpool));
+    }
+
+  svn_stringbuf_ensure(blob, 2*1024*1024);
+  memset(blob->data, 'x', 2*1024*1024);
+  blob->len = 2*1024*1024;
+  blob->data[blob->len] = '\0';
+  SVN_ERR(svn_cache__set(blob_cache, "large", blob, pool));
+
+  SVN_ERR(svn_cache__membuffer_get_prefix_stats(&stats, membuffer, pool));
+  revnums = find_prefix_stats(stats, "revnums");
+  blobs = find_prefix_stats(stats, "BLOB");
+  SVN_TEST_ASSERT(revnums && blobs);
+
+  SVN_TEST_ASSERT(revnums->sets == 100);
+  SVN_TEST_ASSERT(revnums->gets == 101);
+  SVN_TEST_ASSERT(revnums->hits == 100);
+  SVN_TEST_ASSERT(revnums->rejected == 0);
+
+  SVN_TEST_ASSERT(blobs->sets == 10001);
+  SVN_TEST_ASSERT(blobs->bytes_inserted > 10000 * 1024);
+  SVN_TEST_ASSERT(blobs->evictions > 0);
+  SVN_TEST_ASSERT(blobs->rejected == 1);
+
+  SVN_TEST_ASSERT(svn_cache__format_prefix_stats(stats, pool)->len > 0);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_cache_admission_filter(apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer;
+  svn_cache__t *cache;
+  svn_stringbuf_t *blob, *result;
+  svn_boolean_t found;
+  const apr_size_t blob_size = 400 * 1024;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i, k;
+
+  /* One segment with 4MB of L1. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 16*1024*1024,
+                                            1024*1024, 1, 1, FALSE, FALSE,
+                                            pool));
+  SVN_ERR(svn_cache__membuffer_enable_admission_filter(membuffer, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache, membuffer, NULL, NULL,
+                                            APR_HASH_KEY_STRING, "blobs:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+
+  blob = svn_stringbuf_create_ensure(blob_size, pool);
+  memset(blob->data, 'x', blob_size);
+  blob->len = blob_size;
+  blob->data[blob->len] = '\0';
+
+  /* A working set of popular large items. */
+  for (i = 0; i < 8; ++i)
+    {
+      const char *key = apr_psprintf(pool, "hot%d", i);
+      SVN_ERR(svn_cache__set(cache, key, blob, pool));
+      for (k = 0; k < 5; ++k)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(svn_cache__get((void **)&result, &found, cache, key,
+                                 iterpool));
+          SVN_TEST_ASSERT(found);
+        }
+    }
+
+  /* A scan over many items that are requested only once. */
+  for (i = 0; i < 20; ++i)
+    {
+      const char *key = apr_psprintf(pool, "scan%d", i);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_cache__get((void **)&result, &found, cache, key,
+                             iterpool));
+      SVN_TEST_ASSERT(!found);
+      SVN_ERR(svn_cache__set(cache, key, blob, iterpool));
+    }
+
+  /* The scan must not have replaced the working set. */
+  for (i = 0; i < 8; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_cache__has_key(&found, cache,
+                                 apr_psprintf(iterpool, "hot%d", i),
+                                 iterpool));
+      SVN_TEST_ASSERT(found);
+    }
+
+  SVN_ERR(svn_cache__has_key(&found, cache, "scan19", pool));
+  SVN_TEST_ASSERT(!found);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__partial_getter_func_t.  Return the first
+ * character of the serialized svn_stringbuf_t in *OUT. */
+static svn_error_t *
+get_first_char(void **out,
+               const void *data,
+               apr_size_t data_len,
+               void *baton,
+               apr_pool_t *result_pool)
+{
+  *out = apr_pstrndup(result_pool, data, 1);
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__partial_setter_func_t.  Does nothing. */
+static svn_error_t *
+keep_data(void **data,
+          apr_size_t *data_len,
+          void *baton,
+          apr_pool_t *result_pool)
+{
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_cache_compression(apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer;
+  svn_cache__t *cache;
+  svn_stringbuf_t *text, *result;
+  apr_array_header_t *stats;
+  const svn_cache__prefix_stats_t *texts;
+  const char *first;
+  svn_boolean_t found;
+  int i;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 4*1024*1024,
+                                            64*1024, 1, 1, FALSE, FALSE,
+                                            pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache, membuffer, NULL, NULL,
+                                            APR_HASH_KEY_STRING, "texts:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+  SVN_ERR(svn_cache__membuffer_enable_compression(cache, 1024));
+
+  /* A compressible large text and a small one. */
+  text = svn_stringbuf_create_empty(pool);
+  for (i = 0; i < 10000; ++i)
+    svn_stringbuf_appendcstr(text, "int main(void);\n");
+
+  SVN_ERR(svn_cache__set(cache, "large", text, pool));
+  SVN_ERR(svn_cache__set(cache, "small", svn_stringbuf_create("x", pool),
+                         pool));
+
+  SVN_ERR(svn_cache__get((void **)&result, &found, cache, "large", pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_ASSERT(svn_stringbuf_compare(result, text));
+
+  SVN_ERR(svn_cache__get((void **)&result, &found, cache, "small", pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_STRING_ASSERT(result->data, "x");
+
+  SVN_ERR(svn_cache__get_partial((void **)&first, &found, cache, "large",
+                                 get_first_char, NULL, pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_STRING_ASSERT(first, "i");
+
+  /* The large text must have been stored compressed. */
+  SVN_ERR(svn_cache__membuffer_get_prefix_stats(&stats, membuffer, pool));
+  texts = find_prefix_stats(stats, "texts");
+  SVN_TEST_ASSERT(texts && texts->bytes_inserted < text->len / 2);
+
+  /* Partial modifications simply remove compressed items. */
+  SVN_ERR(svn_cache__set_partial(cache, "large", keep_data, NULL, pool));
+  SVN_ERR(svn_cache__has_key(&found, cache, "large", pool));
+  SVN_TEST_ASSERT(!found);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_cache_quota(apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer;
+  svn_cache__t *quiet_cache, *noisy_cache;
+  svn_stringbuf_t *blob;
+  apr_array_header_t *stats;
+  const svn_cache__quota_stats_t *noisy = NULL;
+  svn_boolean_t found;
+  const apr_size_t blob_size = 4 * 1024;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 4*1024*1024,
+                                            256*1024, 1, 1, FALSE, FALSE,
+                                            pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&quiet_cache, membuffer,
+                                            NULL, NULL, sizeof(i),
+                                            "repo:/quiet:BLOB",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&noisy_cache, membuffer,
+                                            NULL, NULL, sizeof(i),
+                                            "repo:/noisy:BLOB",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+  SVN_ERR(svn_cache__membuffer_set_quota(noisy_cache, "noisy", 10));
+
+  blob = svn_stringbuf_create_ensure(blob_size, pool);
+  memset(blob->data, 'x', blob_size);
+  blob->len = blob_size;
+  blob->data[blob->len] = '\0';
+
+  /* Some data that the quiet repository keeps using. */
+  for (i = 0; i < 200; ++i)
+    SVN_ERR(svn_cache__set(quiet_cache, &i, blob, pool));
+
+  /* A bulk export from the noisy one. */
+  for (i = 0; i < 2000; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_cache__set(noisy_cache, &i, blob, iterpool));
+    }
+
+  /* The noisy repository must not have replaced the quiet one's data. */
+  for (i = 0; i < 200; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_cache__has_key(&found, quiet_cache, &i, iterpool));
+      SVN_TEST_ASSERT(found);
+    }
+
+  SVN_ERR(svn_cache__membuffer_get_quota_stats(&stats, membuffer, pool));
+  for (i = 0; i < stats->nelts; ++i)
+    {
+      const svn_cache__quota_stats_t *entry
+        = APR_ARRAY_IDX(stats, i, const svn_cache__quota_stats_t *);
+      if (strcmp(entry->name, "noisy") == 0)
+        noisy = entry;
+    }
+
+  SVN_TEST_ASSERT(noisy);
+  SVN_TEST_ASSERT(noisy->quota > 0);
+  SVN_TEST_ASSERT(noisy->used > 0);
+  SVN_TEST_ASSERT(noisy->used <= noisy->quota + 2 * blob_size);
+  SVN_TEST_ASSERT(noisy->throttled > 0);
+  SVN_TEST_ASSERT(svn_cache__format_quota_stats(stats, pool)->len > 0);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_membuffer_serializer_error_handling(apr_pool_t *pool)
 {
@@ -267,7 +943,7 @@ test_membuffer_serializer_error_handling(apr_pool_t *pool)
   svn_boolean_t found;
   void *val;
 
-  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0, 1,
                                             TRUE, TRUE, pool));
 
   /* Create a cache with just one entry. */
@@ -299,7 +975,7 @@ test_membuffer_serializer_error_handling(apr_pool_t *pool)
     APR_EGENERAL);
 
   /* Create a new cache. */
-  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0, 1,
                                             TRUE, TRUE, pool));
   SVN_ERR(svn_cache__create_membuffer_cache(&cache,
                                             membuffer,
@@ -386,7 +1062,7 @@ test_membuffer_cache_clearing(apr_pool_t *pool)
   svn_revnum_t valueB = 67890;
 
   /* Create a simple cache for strings, keyed by strings. */
-  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0, 1,
                                             TRUE, TRUE, pool));
   SVN_ERR(svn_cache__create_membuffer_cache(&cache,
                                             membuffer,
@@ -504,7 +1180,7 @@ test_membuffer_unaligned_string_keys(apr_pool_t *pool)
   const char *unaligned_key = apr_pstrdup(pool, "_fifty") + 1;
   const char *unaligned_prefix = apr_pstrdup(pool, "_cache:") + 1;
 
-  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0, 1,
                                             TRUE, TRUE, pool));
 
   /* Create a cache with just one entry. */
@@ -554,7 +1230,7 @@ test_membuffer_unaligned_fixed_keys(apr_pool_t *pool)
   const char *unaligned_key = apr_pstrdup(pool, "_12345678") + 1;
   const char *unaligned_prefix = apr_pstrdup(pool, "_cache:") + 1;
 
-  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0, 1,
                                             TRUE, TRUE, pool));
 
   /* Create a cache with just one entry. */
@@ -591,6 +1267,288 @@ test_membuffer_unaligned_fixed_keys(apr_pool_t *pool)
 }
 
 
+static svn_error_t *
+test_membuffer_cache_adaptive_levels(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+  svn_cache__info_t info = { 0 };
+  svn_stringbuf_t *value = svn_stringbuf_create_ensure(1000, pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i, k;
+
+  /* Single segment, so L1 will initially be 1/4 of the data buffer. */
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024*1024, 4096, 1,
+                                            1, FALSE, FALSE, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            NULL,
+                                            NULL,
+                                            APR_HASH_KEY_STRING,
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE,
+                                            FALSE,
+                                            pool, pool));
+
+  memset(value->data, 'x', 999);
+  value->data[999] = 0;
+  value->len = 999;
+
+  /* Streaming: every item gets read right after being written, i.e. all
+   * hits will be in L1.  Write about 4x the cache size. */
+  for (i = 0; i < 4000; ++i)
+    {
+      const char *key;
+      svn_stringbuf_t *result;
+      svn_boolean_t found;
+
+      svn_pool_clear(iterpool);
+      key = apr_psprintf(iterpool, "item-%d", i);
+      SVN_ERR(svn_cache__set(cache, key, value, iterpool));
+
+      for (k = 0; k < 3; ++k)
+        {
+          SVN_ERR(svn_cache__get((void **)&result, &found, cache, key,
+                                 iterpool));
+          SVN_TEST_ASSERT(found);
+          SVN_TEST_STRING_ASSERT(result->data, value->data);
+        }
+    }
+
+  /* L1 must have grown. */
+  SVN_ERR(svn_cache__get_info(cache, &info, FALSE, pool));
+  SVN_TEST_ASSERT(info.l1_resizes > 0);
+  SVN_TEST_ASSERT(info.l1_size > info.data_size / 4);
+  SVN_TEST_ASSERT(info.l1_size < info.data_size);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+#define APR_ERR(expr)                           \
+  do {                                          \
+    apr_status_t status = (expr);               \
+    if (status)                                 \
+      return svn_error_wrap_apr(status, NULL);  \
+  } while (0)
+
+/* Number of revnum items in the cache used by the concurrency test. */
+#define CONCURRENT_ITEM_COUNT 1000
+
+/* Number of lookups per reader thread in the concurrency test. */
+#define CONCURRENT_LOOKUP_COUNT 200000
+
+/* Parameters and result of a single concurrency test thread. */
+typedef struct concurrent_baton_t
+{
+  /* The cache shared between all threads. */
+  svn_membuffer_t *membuffer;
+
+  /* Seed for the key sequence of this thread. */
+  int seed;
+
+  /* If set, rewrite the cache items instead of reading them. */
+  svn_boolean_t writer;
+
+  /* Number of completed reader threads.  Writers stop when all readers
+   * are done. */
+  volatile svn_atomic_t *readers_done;
+
+  /* Number of readers. */
+  int reader_count;
+
+  /* Error returned from the thread.  */
+  svn_error_t *err;
+} concurrent_baton_t;
+
+/* Each thread uses its own front-end cache just like e.g. each svn_fs_t
+ * does.  Only the shared BATON->MEMBUFFER serializes the accesses.  Every
+ * item's value is its key, so torn reads will be detected.
+ */
+static svn_error_t *
+concurrent_access(concurrent_baton_t *baton,
+                  apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_revnum_t key;
+  int i;
+
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            baton->membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(key),
+                                            "concurrent:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE,
+                                            FALSE,
+                                            pool, pool));
+
+  for (i = 0; baton->writer
+              ? svn_atomic_read(baton->readers_done) < baton->reader_count
+              : i < CONCURRENT_LOOKUP_COUNT;
+       ++i)
+    {
+      if ((i & 0xff) == 0)
+        svn_pool_clear(iterpool);
+
+      key = (svn_revnum_t)(((apr_uint64_t)i * 7919 + baton->seed)
+                           % CONCURRENT_ITEM_COUNT);
+      if (baton->writer)
+        {
+          SVN_ERR(svn_cache__set(cache, &key, &key, iterpool));
+        }
+      else
+        {
+          svn_revnum_t *value;
+          svn_boolean_t found;
+
+          /* Items may get evicted while being rewritten.  But if we find
+           * one, it must be correct. */
+          SVN_ERR(svn_cache__get((void **)&value, &found, cache, &key,
+                                 iterpool));
+          if (found && *value != key)
+            return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                     "expected %ld but found %ld",
+                                     key, *value);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+static void *
+APR_THREAD_FUNC concurrent_thread_func(apr_thread_t *tid, void *data)
+{
+  concurrent_baton_t *baton = data;
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  baton->err = concurrent_access(baton, pool);
+  if (!baton->writer)
+    svn_atomic_inc(baton->readers_done);
+
+  svn_pool_destroy(pool);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* Run READER_COUNT readers and, if WITH_WRITER is set, one writer thread
+ * against MEMBUFFER.  Return the time it took in *DURATION.
+ */
+static svn_error_t *
+run_concurrent_threads(apr_interval_time_t *duration,
+                       svn_membuffer_t *membuffer,
+                       int reader_count,
+                       svn_boolean_t with_writer,
+                       apr_pool_t *pool)
+{
+  int thread_count = reader_count + (with_writer ? 1 : 0);
+  apr_thread_t **threads = apr_pcalloc(pool, thread_count * sizeof(*threads));
+  concurrent_baton_t *batons = apr_pcalloc(pool,
+                                           thread_count * sizeof(*batons));
+  volatile svn_atomic_t readers_done = 0;
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_time_t start = apr_time_now();
+  int i;
+
+  for (i = 0; i < thread_count; ++i)
+    {
+      batons[i].membuffer = membuffer;
+      batons[i].seed = i * 131;
+      batons[i].writer = i >= reader_count;
+      batons[i].readers_done = &readers_done;
+      batons[i].reader_count = reader_count;
+
+      APR_ERR(apr_thread_create(&threads[i], NULL, concurrent_thread_func,
+                                &batons[i], pool));
+    }
+
+  /* wait for the threads to finish */
+  for (i = 0; i < thread_count; ++i)
+    {
+      apr_status_t retval;
+      APR_ERR(apr_thread_join(&retval, threads[i]));
+      APR_ERR(retval);
+
+      err = svn_error_compose_create(err, batons[i].err);
+    }
+
+  *duration = apr_time_now() - start;
+
+  return err;
+}
+#endif
+
+static svn_error_t *
+test_membuffer_cache_concurrency(const svn_test_opts_t *opts,
+                                 apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  /* Reader scalability is limited by the per-segment locks.  Use a single
+   * segment to maximize contention.  To compare with the purely lock-based
+   * reader code, build with SVN_MEMBUFFER_DISABLE_LOCK_FREE_READS.
+   */
+  svn_membuffer_t *membuffer;
+  svn_cache__t *cache;
+  svn_revnum_t key;
+  int reader_count;
+  apr_interval_time_t duration;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 4 * 1024 * 1024,
+                                            4096, 1, 1, TRUE, TRUE, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(key),
+                                            "concurrent:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE,
+                                            FALSE,
+                                            pool, pool));
+
+  /* Fill the cache. */
+  for (key = 0; key < CONCURRENT_ITEM_COUNT; ++key)
+    SVN_ERR(svn_cache__set(cache, &key, &key, pool));
+
+  for (reader_count = 1; reader_count <= 8; reader_count *= 2)
+    {
+      apr_int64_t lookups = (apr_int64_t)reader_count
+                          * CONCURRENT_LOOKUP_COUNT;
+
+      SVN_ERR(run_concurrent_threads(&duration, membuffer, reader_count,
+                                     FALSE, pool));
+      if (opts->verbose)
+        printf("%d reader(s):            %.0f lookups/s\n",
+               reader_count,
+               (double)lookups * APR_USEC_PER_SEC / (duration ? duration : 1));
+      svn_test_bench_report(opts,
+                            apr_psprintf(pool, "membuffer-get-%dr",
+                                         reader_count),
+                            lookups, 0, duration);
+
+      SVN_ERR(run_concurrent_threads(&duration, membuffer, reader_count,
+                                     TRUE, pool));
+      if (opts->verbose)
+        printf("%d reader(s), 1 writer:  %.0f lookups/s\n",
+               reader_count,
+               (double)lookups * APR_USEC_PER_SEC / (duration ? duration : 1));
+      svn_test_bench_report(opts,
+                            apr_psprintf(pool, "membuffer-get-%dr-1w",
+                                         reader_count),
+                            lookups, 0, duration);
+    }
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+
 /* The test table.  */
 
 static int max_threads = 1;
@@ -616,6 +1574,31 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test membuffer cache with unaligned string keys"),
     SVN_TEST_PASS2(test_membuffer_unaligned_fixed_keys,
                    "test membuffer cache with unaligned fixed keys"),
+    SVN_TEST_PASS2(test_membuffer_cache_partitioned,
+                   "test NUMA partitioned membuffer svn_cache"),
+    SVN_TEST_PASS2(test_membuffer_cache_shared,
+                   "test membuffer svn_cache in shared memory"),
+    SVN_TEST_PASS2(test_membuffer_cache_adaptive_levels,
+                   "test adaptive L1 / L2 split in membuffer svn_cache"),
+    SVN_TEST_OPTS_SKIP(test_membuffer_cache_concurrency,
+                       ! APR_HAS_THREADS,
+                       "test concurrent membuffer svn_cache access"),
+    SVN_TEST_PASS2(test_cache_get_many,
+                   "test svn_cache__get_many fallback"),
+    SVN_TEST_OPTS_PASS(test_memcache_get_many,
+                       "memcache svn_cache multi-get and async writes"),
+    SVN_TEST_PASS2(test_membuffer_cache_snapshot,
+                   "test membuffer svn_cache snapshots"),
+    SVN_TEST_PASS2(test_membuffer_cache_prefix_stats,
+                   "test membuffer svn_cache per-prefix statistics"),
+    SVN_TEST_PASS2(test_membuffer_cache_admission_filter,
+                   "test membuffer svn_cache admission filter"),
+    SVN_TEST_PASS2(test_membuffer_cache_compression,
+                   "test compressing membuffer svn_cache"),
+    SVN_TEST_PASS2(test_membuffer_cache_quota,
+                   "test membuffer svn_cache quota groups"),
+    SVN_TEST_OPTS_PASS(test_redis_basic,
+                       "basic Redis svn_cache test"),
     SVN_TEST_NULL
   };
 
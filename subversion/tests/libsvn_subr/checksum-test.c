@@ -27,6 +27,7 @@
 
 #include "svn_error.h"
 #include "svn_io.h"
+#include "svn_pools.h"
 
 #include "../svn_test.h"
 
@@ -364,6 +365,54 @@ test_checksummed_stream_reset(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Size of the buffer that the checksum benchmark digests. */
+#define BENCH_DATA_SIZE (1024 * 1024)
+
+static svn_error_t *
+bench_checksums(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  static const char * const names[] =
+    { "md5", "sha1", "fnv1a-32", "fnv1a-32x4" };
+  apr_int64_t iterations = svn_test_bench_iterations(opts, 500);
+  char *data = apr_palloc(pool, BENCH_DATA_SIZE);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_uint32_t seed = 0;
+  svn_checksum_kind_t kind;
+  apr_size_t i;
+
+  for (i = 0; i < BENCH_DATA_SIZE; ++i)
+    data[i] = (char)svn_test_rand(&seed);
+
+  for (kind = svn_checksum_md5; kind <= svn_checksum_fnv1a_32x4; ++kind)
+    {
+      svn_checksum_t *expected;
+      svn_checksum_t *checksum;
+      apr_time_t start;
+      apr_int64_t k;
+
+      SVN_ERR(svn_checksum(&expected, kind, data, BENCH_DATA_SIZE, pool));
+
+      start = apr_time_now();
+      for (k = 0; k < iterations; ++k)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(svn_checksum(&checksum, kind, data, BENCH_DATA_SIZE,
+                               iterpool));
+        }
+      svn_test_bench_report(opts,
+                            apr_pstrcat(pool, "checksum-", names[kind],
+                                        SVN_VA_NULL),
+                            iterations, iterations * BENCH_DATA_SIZE,
+                            apr_time_now() - start);
+
+      SVN_TEST_ASSERT(svn_checksum_match(expected, checksum));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 /* An array of all test functions */
 
 static int max_threads = 1;
@@ -389,6 +438,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "read from checksummed stream"),
     SVN_TEST_PASS2(test_checksummed_stream_reset,
                    "reset checksummed stream"),
+    SVN_TEST_OPTS_PASS(bench_checksums,
+                       "checksum throughput benchmark"),
     SVN_TEST_NULL
   };
 
@@ -35,6 +35,10 @@
 #include "svn_string.h"
 #include "svn_error.h"
 #include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+
+#include "private/svn_subr_private.h"
 
 
 /* Our own global variables */
@@ -230,6 +234,69 @@ read_hash_buffered_test(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Number of entries in the hash that the benchmark writes and parses,
+   about as many as in a large directory. */
+#define BENCH_ENTRY_COUNT 10000
+
+static svn_error_t *
+bench_hash_dump(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  apr_int64_t iterations = svn_test_bench_iterations(opts, 100);
+  apr_hash_t *ht = apr_hash_make(pool);
+  svn_stringbuf_t *dump = svn_stringbuf_create_empty(pool);
+  apr_hash_t *parsed = NULL;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_time_t start;
+  apr_int64_t i;
+
+  for (i = 0; i < BENCH_ENTRY_COUNT; ++i)
+    svn_hash_sets(ht, apr_psprintf(pool, "file-%" APR_INT64_T_FMT, i),
+                  svn_string_createf(pool, "file 3-%" APR_INT64_T_FMT
+                                     ".0.r%" APR_INT64_T_FMT "/%"
+                                     APR_INT64_T_FMT, i, i % 977, i * 31));
+
+  start = apr_time_now();
+  for (i = 0; i < iterations; ++i)
+    {
+      svn_pool_clear(iterpool);
+      svn_stringbuf_setempty(dump);
+      SVN_ERR(svn_hash_write2(ht, svn_stream_from_stringbuf(dump, iterpool),
+                              SVN_HASH_TERMINATOR, iterpool));
+    }
+  svn_test_bench_report(opts, "hash-write", iterations,
+                        iterations * dump->len, apr_time_now() - start);
+
+  start = apr_time_now();
+  for (i = 0; i < iterations; ++i)
+    {
+      svn_pool_clear(iterpool);
+      parsed = apr_hash_make(iterpool);
+      SVN_ERR(svn_hash_read2(parsed,
+                             svn_stream_from_stringbuf(dump, iterpool),
+                             SVN_HASH_TERMINATOR, iterpool));
+    }
+  svn_test_bench_report(opts, "hash-read-stream", iterations,
+                        iterations * dump->len, apr_time_now() - start);
+  SVN_TEST_ASSERT(apr_hash_count(parsed) == BENCH_ENTRY_COUNT);
+
+  /* The in-place parser modifies its input, so it works on a copy. */
+  start = apr_time_now();
+  for (i = 0; i < iterations; ++i)
+    {
+      svn_pool_clear(iterpool);
+      parsed = apr_hash_make(iterpool);
+      SVN_ERR(svn_hash__read_buffer(parsed, svn_stringbuf_dup(dump, iterpool),
+                                    SVN_HASH_TERMINATOR, iterpool));
+    }
+  svn_test_bench_report(opts, "hash-read-buffer", iterations,
+                        iterations * dump->len, apr_time_now() - start);
+  SVN_TEST_ASSERT(apr_hash_count(parsed) == BENCH_ENTRY_COUNT);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 
 /*
    ====================================================================
@@ -252,6 +319,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "write hash out, read back in, compare"),
     SVN_TEST_PASS2(read_hash_buffered_test,
                    "read hash from buffered file"),
+    SVN_TEST_OPTS_PASS(bench_hash_dump,
+                       "hash dump benchmark"),
     SVN_TEST_NULL
   };
 
@@ -1228,6 +1228,37 @@ test_rmtree_all_readonly(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_file_prefetch(apr_pool_t *pool)
+{
+  const char *tmp_dir, *path;
+  apr_file_t *file;
+  char buffer[4];
+  apr_off_t offset = 2;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&tmp_dir, "test_file_prefetch", pool));
+  path = svn_dirent_join(tmp_dir, "file", pool);
+  SVN_ERR(svn_io_file_create(path, "12345678", pool));
+
+  SVN_ERR(svn_io_file_open(&file, path, APR_READ | APR_BUFFERED,
+                           APR_OS_DEFAULT, pool));
+
+  /* Read-ahead hints must neither fail nor affect the file contents,
+   * even when they are out of range. */
+  SVN_ERR(svn_io__file_prefetch(file, 0, 8, pool));
+  SVN_ERR(svn_io__file_prefetch(file, 4, 1000, pool));
+  SVN_ERR(svn_io__file_prefetch(file, 100, 8, pool));
+  SVN_ERR(svn_io__file_prefetch(file, 0, 0, pool));
+
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, pool));
+  SVN_ERR(svn_io_file_read_full2(file, buffer, sizeof(buffer), NULL, NULL,
+                                 pool));
+  SVN_TEST_ASSERT(memcmp(buffer, "3456", sizeof(buffer)) == 0);
+
+  SVN_ERR(svn_io_file_close(file, pool));
+  return SVN_NO_ERROR;
+}
+
 
 /* The test table.  */
 
@@ -1274,6 +1305,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test svn_io_remove_dir2() with read-only directory"),
     SVN_TEST_PASS2(test_rmtree_all_readonly,
                    "test svn_io_remove_dir2() with read-only tree"),
+    SVN_TEST_PASS2(test_file_prefetch,
+                   "test svn_io__file_prefetch()"),
     SVN_TEST_NULL
   };
 
@@ -35,6 +35,7 @@
 #include "../svn_test.h"
 
 #include "svn_error.h"
+#include "svn_pools.h"
 #include "svn_string.h"   /* This includes <apr_*.h> */
 #include "private/svn_packed_data.h"
 
@@ -553,6 +554,80 @@ test_full_structure(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Number of values per stream in the packed data benchmark. */
+#define BENCH_VALUE_COUNT 100000
+
+static svn_error_t *
+bench_packed_data(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  apr_int64_t iterations = svn_test_bench_iterations(opts, 100);
+  svn_stringbuf_t *buffer = svn_stringbuf_create_empty(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_uint64_t sum = 0;
+  apr_time_t start;
+  apr_int64_t i;
+  int k;
+
+  /* Ascending offsets and small signed deltas, as in FSFS indexes. */
+  start = apr_time_now();
+  for (i = 0; i < iterations; ++i)
+    {
+      svn_packed__data_root_t *root;
+      svn_packed__int_stream_t *offsets;
+      svn_packed__int_stream_t *deltas;
+
+      svn_pool_clear(iterpool);
+      root = svn_packed__data_create_root(iterpool);
+      offsets = svn_packed__create_int_stream(root, TRUE, FALSE);
+      deltas = svn_packed__create_int_stream(root, FALSE, TRUE);
+      for (k = 0; k < BENCH_VALUE_COUNT; ++k)
+        {
+          svn_packed__add_uint(offsets, (apr_uint64_t)k * 117 + k % 13);
+          svn_packed__add_int(deltas, (k % 201) - 100);
+        }
+
+      svn_stringbuf_setempty(buffer);
+      SVN_ERR(svn_packed__data_write(svn_stream_from_stringbuf(buffer,
+                                                               iterpool),
+                                     root, iterpool));
+    }
+  svn_test_bench_report(opts, "packed-data-write", iterations,
+                        iterations * buffer->len, apr_time_now() - start);
+
+  start = apr_time_now();
+  for (i = 0; i < iterations; ++i)
+    {
+      svn_packed__data_root_t *root;
+      svn_packed__int_stream_t *offsets;
+      svn_packed__int_stream_t *deltas;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_packed__data_read(&root,
+                                    svn_stream_from_stringbuf(buffer,
+                                                              iterpool),
+                                    iterpool, iterpool));
+      offsets = svn_packed__first_int_stream(root);
+      deltas = svn_packed__next_int_stream(offsets);
+
+      sum = 0;
+      for (k = 0; k < BENCH_VALUE_COUNT; ++k)
+        {
+          sum += svn_packed__get_uint(offsets);
+          sum += svn_packed__get_int(deltas);
+        }
+    }
+  svn_test_bench_report(opts, "packed-data-read", iterations,
+                        iterations * buffer->len, apr_time_now() - start);
+
+  for (k = 0; k < BENCH_VALUE_COUNT; ++k)
+    sum -= (apr_uint64_t)k * 117 + k % 13 + (k % 201) - 100;
+  SVN_TEST_ASSERT(sum == 0);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 /* An array of all test functions */
 
 static int max_threads = 1;
@@ -572,6 +647,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test empty, nested structure"),
     SVN_TEST_PASS2(test_full_structure,
                    "test nested structure"),
+    SVN_TEST_OPTS_PASS(bench_packed_data,
+                       "packed data benchmark"),
     SVN_TEST_NULL
   };
 
@@ -1065,6 +1065,49 @@ test_stream_readline_file_nul(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+bench_base64(const svn_test_opts_t *opts,
+             apr_pool_t *pool)
+{
+  apr_int64_t iterations = svn_test_bench_iterations(opts, 200);
+  svn_stringbuf_t *data = svn_stringbuf_create_ensure(1024 * 1024, pool);
+  const svn_string_t *original;
+  const svn_string_t *encoded;
+  const svn_string_t *decoded = NULL;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_uint32_t seed = 0;
+  apr_time_t start;
+  apr_int64_t i;
+
+  while (data->len < data->blocksize - 1)
+    svn_stringbuf_appendbyte(data, (char)svn_test_rand(&seed));
+  original = svn_string_ncreate(data->data, data->len, pool);
+  encoded = svn_base64_encode_string2(original, TRUE, pool);
+
+  start = apr_time_now();
+  for (i = 0; i < iterations; ++i)
+    {
+      svn_pool_clear(iterpool);
+      svn_base64_encode_string2(original, TRUE, iterpool);
+    }
+  svn_test_bench_report(opts, "base64-encode", iterations,
+                        iterations * original->len, apr_time_now() - start);
+
+  start = apr_time_now();
+  for (i = 0; i < iterations; ++i)
+    {
+      svn_pool_clear(iterpool);
+      decoded = svn_base64_decode_string(encoded, iterpool);
+    }
+  svn_test_bench_report(opts, "base64-decode", iterations,
+                        iterations * encoded->len, apr_time_now() - start);
+
+  SVN_TEST_ASSERT(decoded && svn_string_compare(decoded, original));
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 1;
@@ -1104,6 +1147,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test reading CRLF-terminated lines from file"),
     SVN_TEST_PASS2(test_stream_readline_file_nul,
                    "test reading line from file with nul bytes"),
+    SVN_TEST_OPTS_PASS(bench_base64,
+                       "base64 throughput benchmark"),
     SVN_TEST_NULL
   };
 
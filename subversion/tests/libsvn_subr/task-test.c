@@ -0,0 +1,209 @@
+/*
+ * task-test.c:  a collection of svn_task__* tests
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* ====================================================================
+   To add tests, look toward the bottom of this file.
+
+*/
+
+
+
+#include <apr_pools.h>
+
+#include "../svn_test.h"
+
+#include "svn_error.h"
+#include "private/svn_task.h"
+
+/* Number of work items used by the tests. */
+enum {ITEM_COUNT = 100};
+
+/* Baton type used with all test callbacks. */
+typedef struct test_baton_t
+{
+  /* Index of the item that shall fail to process.  -1 for "none". */
+  int failing_item;
+
+  /* Index of the next item that we expect to be reported. */
+  int next_output;
+} test_baton_t;
+
+/* Implements svn_task__thread_context_constructor_t.
+ * Returns the test_baton_t in BATON as context. */
+static svn_error_t *
+construct_context(void **thread_context,
+                  void *context_baton,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  *thread_context = context_baton;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.
+ * Returns the square of INDEX as an int. */
+static svn_error_t *
+process_square(void **result,
+               int index,
+               void *process_baton,
+               void *thread_context,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  const test_baton_t *baton = process_baton;
+  int *value;
+
+  SVN_TEST_ASSERT(thread_context == process_baton);
+  if (cancel_func)
+    SVN_ERR(cancel_func(cancel_baton));
+
+  if (index == baton->failing_item)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "Item %d failed", index);
+
+  value = apr_palloc(result_pool, sizeof(*value));
+  *value = index * index;
+  *result = value;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.
+ * Verifies that RESULT is the one expected for INDEX. */
+static svn_error_t *
+output_square(void *result,
+              int index,
+              void *output_baton,
+              svn_cancel_func_t cancel_func,
+              void *cancel_baton,
+              apr_pool_t *scratch_pool)
+{
+  test_baton_t *baton = output_baton;
+
+  SVN_TEST_ASSERT(index == baton->next_output);
+  SVN_TEST_ASSERT(*(int *)result == index * index);
+  SVN_TEST_ASSERT(index != baton->failing_item);
+
+  baton->next_output++;
+
+  return SVN_NO_ERROR;
+}
+
+/* Run ITEM_COUNT square calculations with THREAD_COUNT threads and let
+ * FAILING_ITEM fail.  Verify the results and the expected error.
+ * Use POOL for allocations. */
+static svn_error_t *
+run_squares(int thread_count,
+            int failing_item,
+            apr_pool_t *pool)
+{
+  svn_error_t *err;
+  test_baton_t baton = { 0 };
+  baton.failing_item = failing_item;
+
+  err = svn_task__run(thread_count, ITEM_COUNT,
+                      process_square, &baton,
+                      output_square, &baton,
+                      construct_context, &baton,
+                      NULL, NULL, pool);
+
+  if (failing_item < 0)
+    {
+      SVN_ERR(err);
+      SVN_TEST_ASSERT(baton.next_output == ITEM_COUNT);
+    }
+  else
+    {
+      /* We must get the original error and all previous items must have
+       * been reported. */
+      SVN_TEST_ASSERT_ERROR(err, SVN_ERR_TEST_FAILED);
+      SVN_TEST_ASSERT(baton.next_output == failing_item);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_sequential(apr_pool_t *pool)
+{
+  SVN_ERR(run_squares(1, -1, pool));
+  SVN_ERR(run_squares(1, 0, pool));
+  SVN_ERR(run_squares(1, ITEM_COUNT / 2, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_concurrent(apr_pool_t *pool)
+{
+  SVN_ERR(run_squares(4, -1, pool));
+  SVN_ERR(run_squares(ITEM_COUNT * 2, -1, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_concurrent_error(apr_pool_t *pool)
+{
+  SVN_ERR(run_squares(4, 0, pool));
+  SVN_ERR(run_squares(4, ITEM_COUNT / 2, pool));
+  SVN_ERR(run_squares(4, ITEM_COUNT - 1, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_empty(apr_pool_t *pool)
+{
+  test_baton_t baton = { 0 };
+  baton.failing_item = -1;
+
+  SVN_ERR(svn_task__run(4, 0, process_square, &baton,
+                        output_square, &baton,
+                        NULL, NULL, NULL, NULL, pool));
+  SVN_TEST_ASSERT(baton.next_output == 0);
+
+  return SVN_NO_ERROR;
+}
+
+/* An array of all test functions */
+
+static int max_threads = 1;
+
+static struct svn_test_descriptor_t test_funcs[] =
+  {
+    SVN_TEST_NULL,
+    SVN_TEST_PASS2(test_sequential,
+                   "process work items sequentially"),
+    SVN_TEST_PASS2(test_concurrent,
+                   "process work items concurrently"),
+    SVN_TEST_PASS2(test_concurrent_error,
+                   "errors are reported in item order"),
+    SVN_TEST_PASS2(test_empty,
+                   "processing an empty item list"),
+    SVN_TEST_NULL
+  };
+
+SVN_TEST_MAIN
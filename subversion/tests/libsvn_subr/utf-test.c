@@ -998,6 +998,51 @@ test_utf_xfrm(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Run the UTF-8 validation benchmark NAME over DATA. */
+static svn_error_t *
+bench_utf_validation(const svn_test_opts_t *opts,
+                     const char *name,
+                     const svn_stringbuf_t *data)
+{
+  apr_int64_t iterations = svn_test_bench_iterations(opts, 1000);
+  svn_boolean_t valid = TRUE;
+  apr_time_t start = apr_time_now();
+  apr_int64_t i;
+
+  for (i = 0; i < iterations; ++i)
+    valid &= svn_utf__is_valid(data->data, data->len);
+
+  svn_test_bench_report(opts, name, iterations, iterations * data->len,
+                        apr_time_now() - start);
+  SVN_TEST_ASSERT(valid);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+bench_utf_is_valid(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  /* Latin, Greek, CJK and 4-byte sequences in one line of text. */
+  static const char mixed[]
+    = "Gr\xc3\xb6\xc3\x9f" "e \xce\xb1\xce\xb2\xce\xb3 "
+      "\xe4\xb8\xad\xe6\x96\x87 \xf0\x9f\x98\x80 plain text\n";
+  static const char ascii[]
+    = "The quick brown fox jumps over the lazy dog.\n";
+  svn_stringbuf_t *data = svn_stringbuf_create_ensure(1024 * 1024, pool);
+
+  while (data->len + sizeof(ascii) < data->blocksize)
+    svn_stringbuf_appendbytes(data, ascii, sizeof(ascii) - 1);
+  SVN_ERR(bench_utf_validation(opts, "utf8-valid-ascii", data));
+
+  svn_stringbuf_setempty(data);
+  while (data->len + sizeof(mixed) < data->blocksize)
+    svn_stringbuf_appendbytes(data, mixed, sizeof(mixed) - 1);
+  SVN_ERR(bench_utf_validation(opts, "utf8-valid-mixed", data));
+
+  return SVN_NO_ERROR;
+}
+
 
 /* The test table.  */
 
@@ -1028,6 +1073,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test svn_utf__normalize"),
     SVN_TEST_PASS2(test_utf_xfrm,
                    "test svn_utf__xfrm"),
+    SVN_TEST_OPTS_PASS(bench_utf_is_valid,
+                       "UTF-8 validation benchmark"),
     SVN_TEST_NULL
   };
 
@@ -148,6 +148,7 @@ svn_test__create_fake_wc(const char *wc_abspath,
   SVN_ERR(svn_wc__db_util_open_db(&sdb, wc_abspath, "wc.db",
                                   svn_sqlite__mode_rwcreate,
                                   FALSE /* exclusive */, 0 /* timeout */,
+                                  svn_tristate_unknown /* wal */,
                                   my_statements,
                                   scratch_pool, scratch_pool));
   for (i = 0; my_statements[i] != NULL; i++)
@@ -162,6 +163,7 @@ svn_test__create_fake_wc(const char *wc_abspath,
   SVN_ERR(svn_wc__db_util_open_db(&sdb, wc_abspath, "wc.db",
                                   svn_sqlite__mode_readwrite,
                                   FALSE /* exclusive */, 0 /* timeout */,
+                                  svn_tristate_unknown /* wal */,
                                   statements,
                                   scratch_pool, scratch_pool));
 
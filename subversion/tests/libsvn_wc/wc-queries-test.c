@@ -71,6 +71,7 @@ static const int schema_statements[] =
   /* Usual tables */
   STMT_CREATE_SCHEMA,
   STMT_INSTALL_SCHEMA_STATISTICS,
+  STMT_CREATE_REVISION_STATUS_CACHE,
   /* Memory tables */
   STMT_CREATE_TARGETS_LIST,
   STMT_CREATE_CHANGELIST_LIST,
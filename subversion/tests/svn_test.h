@@ -173,6 +173,8 @@ typedef struct svn_test_opts_t
      the current latest version. */
   int server_minor_version;
   svn_boolean_t verbose;
+  /* Run benchmarks at full size and report their results. */
+  svn_boolean_t bench;
   /* Add future "arguments" here. */
 } svn_test_opts_t;
 
@@ -307,6 +309,24 @@ apr_uint32_t svn_test_rand(apr_uint32_t *seed);
 void svn_test_add_dir_cleanup(const char *path);
 
 
+/* Return the number of iterations a benchmark should run: BENCH_COUNT
+ * with --bench, and just enough to check that it works otherwise.
+ */
+apr_int64_t svn_test_bench_iterations(const svn_test_opts_t *opts,
+                                      apr_int64_t bench_count);
+
+/* With --bench, print the result of the benchmark NAME, which ran
+ * ITERATIONS times over a total of BYTES bytes in ELAPSED microseconds,
+ * as a single line that scripts can parse.  BYTES may be 0 for
+ * benchmarks that don't process data.  Otherwise, do nothing.
+ */
+void svn_test_bench_report(const svn_test_opts_t *opts,
+                           const char *name,
+                           apr_int64_t iterations,
+                           apr_int64_t bytes,
+                           apr_interval_time_t elapsed);
+
+
 /* A simple representation for a tree node. */
 typedef struct svn_test__tree_entry_t
 {
@@ -108,7 +108,8 @@ enum test_options_e {
   mode_filter_opt,
   sqlite_log_opt,
   parallel_opt,
-  fsfs_version_opt
+  fsfs_version_opt,
+  bench_opt
 };
 
 static const apr_getopt_option_t cl_options[] =
@@ -151,6 +152,9 @@ static const apr_getopt_option_t cl_options[] =
                     N_("enable SQLite logging")},
   {"parallel",      parallel_opt, 0,
                     N_("allow concurrent execution of tests")},
+  {"bench",         bench_opt, 0,
+                    N_("run benchmarks at full size and print their "
+                       "results")},
   {0,               0, 0, 0}
 };
 
@@ -280,6 +284,34 @@ svn_test_rand(apr_uint32_t *seed)
 }
 
 
+/* ================================================================= */
+/* Benchmark support. */
+
+apr_int64_t
+svn_test_bench_iterations(const svn_test_opts_t *opts,
+                          apr_int64_t bench_count)
+{
+  return opts->bench ? bench_count : 1;
+}
+
+void
+svn_test_bench_report(const svn_test_opts_t *opts,
+                      const char *name,
+                      apr_int64_t iterations,
+                      apr_int64_t bytes,
+                      apr_interval_time_t elapsed)
+{
+  if (!opts->bench)
+    return;
+
+  /* Benchmarks run one at a time, so this can't interleave. */
+  printf("BENCH: %s %s iterations=%" APR_INT64_T_FMT
+         " usec=%" APR_INT64_T_FMT " bytes=%" APR_INT64_T_FMT "\n",
+         opts->prog_name, name, iterations, (apr_int64_t)elapsed, bytes);
+  fflush(stdout);
+}
+
+
 /* ================================================================= */
 
 
@@ -1002,10 +1034,17 @@ svn_test_main(int argc, const char *argv[], int max_threads,
           parallel = TRUE;
           break;
 #endif
+        case bench_opt:
+          opts.bench = TRUE;
+          break;
       }
     }
   opts.verbose = verbose_mode;
 
+  /* Concurrent tests would distort the timings. */
+  if (opts.bench)
+    parallel = FALSE;
+
   /* Disable sleeping for timestamps, to speed up the tests. */
   apr_env_set(
          "SVN_I_LOVE_CORRUPTED_WORKING_COPIES_SO_DISABLE_SLEEP_FOR_TIMESTAMPS",
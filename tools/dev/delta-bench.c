@@ -0,0 +1,635 @@
+/* delta-bench.c -- measure the delta engine on a corpus of file pairs
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <apr_time.h>
+
+#include "svn_cmdline.h"
+#include "svn_dirent_uri.h"
+#include "svn_delta.h"
+#include "svn_io.h"
+#include "svn_opt.h"
+#include "svn_pools.h"
+#include "svn_string.h"
+#include "svn_utf.h"
+
+#include "private/svn_cmdline_private.h"
+#include "private/svn_subr_private.h"
+
+#include "svn_private_config.h"
+
+/* One svndiff encoding to measure. */
+typedef struct format_t
+{
+  /* svndiff version and compression level to pass to
+   * svn_txdelta_to_svndiff3(). */
+  int version;
+  int level;
+
+  /* Whether this format is available in the current build. */
+  svn_boolean_t available;
+
+  /* Accumulated over all pairs of the corpus: encoded size as well as
+   * the fastest encoding and decoding times. */
+  apr_uint64_t encoded_size;
+  apr_interval_time_t encode_time;
+  apr_interval_time_t decode_time;
+} format_t;
+
+/* All svndiff encodings that we measure. */
+static format_t formats[] =
+  {
+    { 0, SVN_DELTA_COMPRESSION_LEVEL_NONE, TRUE },
+    { 1, SVN__COMPRESSION_ZLIB_MIN, TRUE },
+    { 1, SVN__COMPRESSION_ZLIB_DEFAULT, TRUE },
+    { 1, SVN__COMPRESSION_ZLIB_MAX, TRUE },
+    { 2, SVN_DELTA_COMPRESSION_LEVEL_DEFAULT, TRUE },
+    { 3, SVN__COMPRESSION_ZSTD_MIN, TRUE },
+    { 3, SVN__COMPRESSION_ZSTD_DEFAULT, TRUE },
+    { 3, SVN__COMPRESSION_ZSTD_MAX, TRUE }
+  };
+
+#define FORMAT_COUNT ((int)(sizeof(formats) / sizeof(formats[0])))
+
+/* Totals of the format-independent phases over all pairs. */
+typedef struct totals_t
+{
+  int pairs;
+  apr_uint64_t source_size;
+  apr_uint64_t target_size;
+  apr_uint64_t windows;
+  apr_interval_time_t delta_time;
+  apr_interval_time_t apply_time;
+} totals_t;
+
+/* Program options. */
+typedef struct options_t
+{
+  /* Number of times each phase gets run.  We report the fastest one. */
+  int iterations;
+
+  /* Show results for each pair as well. */
+  svn_boolean_t verbose;
+} options_t;
+
+static void
+usage(apr_pool_t *pool)
+{
+  svn_error_clear(svn_cmdline_fprintf(stderr, pool,
+    _("Usage: delta-bench [OPTIONS] [SOURCE TARGET]...\n"
+      "\n"
+      "Replay pairs of files through the delta engine and report its\n"
+      "throughput and the output size for each svndiff format.  Each pair\n"
+      "is given either as two arguments or as one line in a corpus file.\n"
+      "\n"
+      "Options:\n"
+      "  -F FILE   read pairs from FILE.  Each line contains a source and\n"
+      "            a target path separated by a TAB.  Relative paths are\n"
+      "            relative to FILE.  Empty lines and lines starting with\n"
+      "            '#' are ignored.  Can be given multiple times.\n"
+      "  -n COUNT  run each phase COUNT times and report the fastest\n"
+      "            (default: 3)\n"
+      "  -v        also show the results for each pair\n")));
+}
+
+/* Return the throughput for SIZE bytes processed in DURATION as a
+ * number in MB/s. */
+static double
+mb_per_sec(apr_uint64_t size, apr_interval_time_t duration)
+{
+  if (duration <= 0)
+    duration = 1;
+
+  return (double)size / (double)duration;
+}
+
+/* Return the ratio of PART to WHOLE in percent. */
+static double
+percent(apr_uint64_t part, apr_uint64_t whole)
+{
+  return whole ? 100.0 * (double)part / (double)whole : 0.0;
+}
+
+/* Return a short description of FORMAT allocated in POOL. */
+static const char *
+format_name(const format_t *format,
+            apr_pool_t *pool)
+{
+  if (format->version == 0 || format->version == 2)
+    return apr_psprintf(pool, "svndiff%d", format->version);
+
+  return apr_psprintf(pool, "svndiff%d/%d", format->version, format->level);
+}
+
+/* Remember the shortest of DURATION and *BEST in *BEST.  A value of 0
+ * in *BEST means "not set, yet". */
+static void
+keep_fastest(apr_interval_time_t *best,
+             apr_interval_time_t duration)
+{
+  if (*best == 0 || duration < *best)
+    *best = duration;
+}
+
+/* Deltify TARGET against SOURCE and return copies of all windows in
+ * *WINDOWS, allocated in RESULT_POOL.  Return the time it took in
+ * *DURATION. */
+static svn_error_t *
+run_delta(apr_array_header_t **windows,
+          apr_interval_time_t *duration,
+          svn_stringbuf_t *source,
+          svn_stringbuf_t *target,
+          apr_pool_t *result_pool,
+          apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_txdelta_stream_t *delta_stream;
+  svn_txdelta_window_t *window;
+  apr_time_t start;
+
+  *windows = apr_array_make(result_pool, 16, sizeof(window));
+  *duration = 0;
+
+  svn_txdelta2(&delta_stream,
+               svn_stream_from_stringbuf(source, scratch_pool),
+               svn_stream_from_stringbuf(target, scratch_pool),
+               FALSE, scratch_pool);
+
+  do
+    {
+      svn_pool_clear(iterpool);
+
+      /* Only time the delta calculation, not the copying. */
+      start = apr_time_now();
+      SVN_ERR(svn_txdelta_next_window(&window, delta_stream, iterpool));
+      *duration += apr_time_now() - start;
+
+      if (window)
+        APR_ARRAY_PUSH(*windows, svn_txdelta_window_t *)
+          = svn_txdelta_window_dup(window, result_pool);
+    }
+  while (window);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Send WINDOWS followed by the final NULL window to HANDLER with
+ * HANDLER_BATON. */
+static svn_error_t *
+send_windows(const apr_array_header_t *windows,
+             svn_txdelta_window_handler_t handler,
+             void *handler_baton)
+{
+  int i;
+
+  for (i = 0; i < windows->nelts; ++i)
+    SVN_ERR(handler(APR_ARRAY_IDX(windows, i, svn_txdelta_window_t *),
+                    handler_baton));
+
+  return svn_error_trace(handler(NULL, handler_baton));
+}
+
+/* Apply WINDOWS to SOURCE and verify that the result matches TARGET.
+ * Return the time it took in *DURATION. */
+static svn_error_t *
+run_apply(apr_interval_time_t *duration,
+          const apr_array_header_t *windows,
+          svn_stringbuf_t *source,
+          svn_stringbuf_t *target,
+          apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create_ensure(target->len,
+                                                        scratch_pool);
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  apr_time_t start;
+
+  svn_txdelta_apply(svn_stream_from_stringbuf(source, scratch_pool),
+                    svn_stream_from_stringbuf(result, scratch_pool),
+                    NULL, NULL, scratch_pool, &handler, &handler_baton);
+
+  start = apr_time_now();
+  SVN_ERR(send_windows(windows, handler, handler_baton));
+  *duration = apr_time_now() - start;
+
+  if (!svn_stringbuf_compare(result, target))
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            _("Applying the delta did not reproduce "
+                              "the target"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Encode WINDOWS in FORMAT and return the svndiff data in *ENCODED,
+ * allocated in RESULT_POOL.  Return the time it took in *DURATION. */
+static svn_error_t *
+run_encode(svn_stringbuf_t **encoded,
+           apr_interval_time_t *duration,
+           const apr_array_header_t *windows,
+           const format_t *format,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  apr_time_t start;
+
+  *encoded = svn_stringbuf_create_empty(result_pool);
+  svn_txdelta_to_svndiff3(&handler, &handler_baton,
+                          svn_stream_from_stringbuf(*encoded, scratch_pool),
+                          format->version, format->level, scratch_pool);
+
+  start = apr_time_now();
+  SVN_ERR(send_windows(windows, handler, handler_baton));
+  *duration = apr_time_now() - start;
+
+  return SVN_NO_ERROR;
+}
+
+/* Parse the svndiff data in ENCODED, apply it to SOURCE and verify
+ * that the result matches TARGET.  Return the time it took in
+ * *DURATION. */
+static svn_error_t *
+run_decode(apr_interval_time_t *duration,
+           svn_stringbuf_t *encoded,
+           svn_stringbuf_t *source,
+           svn_stringbuf_t *target,
+           apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create_ensure(target->len,
+                                                        scratch_pool);
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  svn_stream_t *parser;
+  apr_size_t len = encoded->len;
+  apr_time_t start;
+
+  svn_txdelta_apply(svn_stream_from_stringbuf(source, scratch_pool),
+                    svn_stream_from_stringbuf(result, scratch_pool),
+                    NULL, NULL, scratch_pool, &handler, &handler_baton);
+  parser = svn_txdelta_parse_svndiff(handler, handler_baton, TRUE,
+                                     scratch_pool);
+
+  start = apr_time_now();
+  SVN_ERR(svn_stream_write(parser, encoded->data, &len));
+  SVN_ERR(svn_stream_close(parser));
+  *duration = apr_time_now() - start;
+
+  if (!svn_stringbuf_compare(result, target))
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            _("Decoding the svndiff data did not reproduce "
+                              "the target"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Run all phases for the pair SOURCE_PATH, TARGET_PATH as specified by
+ * OPTIONS and add the results to TOTALS and FORMATS. */
+static svn_error_t *
+bench_pair(totals_t *totals,
+           const char *source_path,
+           const char *target_path,
+           const options_t *options,
+           apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_stringbuf_t *source, *target;
+  apr_array_header_t *windows = NULL;
+  apr_interval_time_t delta_time = 0, apply_time = 0;
+  apr_interval_time_t duration;
+  int i, k;
+
+  SVN_ERR(svn_stringbuf_from_file2(&source, source_path, scratch_pool));
+  SVN_ERR(svn_stringbuf_from_file2(&target, target_path, scratch_pool));
+
+  /* Keep the windows of the first run for the later phases. */
+  for (i = 0; i < options->iterations; ++i)
+    {
+      apr_array_header_t *run_windows;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(run_delta(&run_windows, &duration, source, target,
+                        windows ? iterpool : scratch_pool, iterpool));
+      keep_fastest(&delta_time, duration);
+      if (!windows)
+        windows = run_windows;
+    }
+
+  for (i = 0; i < options->iterations; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(run_apply(&duration, windows, source, target, iterpool));
+      keep_fastest(&apply_time, duration);
+    }
+
+  if (options->verbose)
+    SVN_ERR(svn_cmdline_printf(scratch_pool,
+                               "%s -> %s: %" APR_SIZE_T_FMT " -> %"
+                               APR_SIZE_T_FMT " bytes, %d windows\n"
+                               "  delta   %8.1f MB/s\n"
+                               "  apply   %8.1f MB/s\n",
+                               source_path, target_path,
+                               source->len, target->len, windows->nelts,
+                               mb_per_sec(target->len, delta_time),
+                               mb_per_sec(target->len, apply_time)));
+
+  totals->pairs++;
+  totals->source_size += source->len;
+  totals->target_size += target->len;
+  totals->windows += windows->nelts;
+  totals->delta_time += delta_time;
+  totals->apply_time += apply_time;
+
+  for (k = 0; k < FORMAT_COUNT; ++k)
+    {
+      format_t *format = &formats[k];
+      apr_interval_time_t encode_time = 0, decode_time = 0;
+      svn_stringbuf_t *encoded = NULL;
+
+      if (!format->available)
+        continue;
+
+      for (i = 0; i < options->iterations; ++i)
+        {
+          svn_stringbuf_t *run_encoded;
+
+          svn_pool_clear(iterpool);
+          SVN_ERR(run_encode(&run_encoded, &duration, windows, format,
+                             encoded ? iterpool : scratch_pool, iterpool));
+          keep_fastest(&encode_time, duration);
+          if (!encoded)
+            encoded = run_encoded;
+        }
+
+      for (i = 0; i < options->iterations; ++i)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(run_decode(&duration, encoded, source, target, iterpool));
+          keep_fastest(&decode_time, duration);
+        }
+
+      if (options->verbose)
+        SVN_ERR(svn_cmdline_printf(scratch_pool,
+                                   "  %-12s %6.2f%%  encode %8.1f MB/s"
+                                   "  decode %8.1f MB/s\n",
+                                   format_name(format, iterpool),
+                                   percent(encoded->len, target->len),
+                                   mb_per_sec(target->len, encode_time),
+                                   mb_per_sec(target->len, decode_time)));
+
+      format->encoded_size += encoded->len;
+      format->encode_time += encode_time;
+      format->decode_time += decode_time;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the corpus file at PATH and append the paths of all pairs listed
+ * in it to PAIRS.  Allocate them in RESULT_POOL. */
+static svn_error_t *
+read_corpus(apr_array_header_t *pairs,
+            const char *path,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  const char *dir = svn_dirent_dirname(path, scratch_pool);
+  svn_stringbuf_t *contents;
+  apr_array_header_t *lines;
+  int i;
+
+  SVN_ERR(svn_stringbuf_from_file2(&contents, path, scratch_pool));
+  lines = svn_cstring_split(contents->data, "\r\n", TRUE, scratch_pool);
+
+  for (i = 0; i < lines->nelts; ++i)
+    {
+      const char *line = APR_ARRAY_IDX(lines, i, const char *);
+      const char *tab = strchr(line, '\t');
+
+      if (*line == '\0' || *line == '#')
+        continue;
+
+      if (!tab)
+        return svn_error_createf(SVN_ERR_MALFORMED_FILE, NULL,
+                                 _("Missing TAB in line '%s' of corpus "
+                                   "file '%s'"),
+                                 line, svn_dirent_local_style(path,
+                                                              scratch_pool));
+
+      APR_ARRAY_PUSH(pairs, const char *)
+        = svn_dirent_join(dir, apr_pstrmemdup(scratch_pool, line,
+                                              tab - line),
+                          result_pool);
+      APR_ARRAY_PUSH(pairs, const char *)
+        = svn_dirent_join(dir, tab + 1, result_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Print the totals over the whole corpus. */
+static svn_error_t *
+print_totals(const totals_t *totals,
+             apr_pool_t *scratch_pool)
+{
+  int k;
+
+  SVN_ERR(svn_cmdline_printf(scratch_pool,
+                             "%d pairs: %" APR_UINT64_T_FMT " -> %"
+                             APR_UINT64_T_FMT " bytes, %" APR_UINT64_T_FMT
+                             " windows\n"
+                             "delta   %8.1f MB/s\n"
+                             "apply   %8.1f MB/s\n"
+                             "\n"
+                             "format         size    encode MB/s"
+                             "  decode MB/s\n",
+                             totals->pairs, totals->source_size,
+                             totals->target_size, totals->windows,
+                             mb_per_sec(totals->target_size,
+                                        totals->delta_time),
+                             mb_per_sec(totals->target_size,
+                                        totals->apply_time)));
+
+  for (k = 0; k < FORMAT_COUNT; ++k)
+    {
+      const format_t *format = &formats[k];
+
+      if (!format->available)
+        continue;
+
+      SVN_ERR(svn_cmdline_printf(scratch_pool,
+                                 "%-12s %6.2f%%  %11.1f  %11.1f\n",
+                                 format_name(format, scratch_pool),
+                                 percent(format->encoded_size,
+                                         totals->target_size),
+                                 mb_per_sec(totals->target_size,
+                                            format->encode_time),
+                                 mb_per_sec(totals->target_size,
+                                            format->decode_time)));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/*
+ * On success, leave *EXIT_CODE untouched and return SVN_NO_ERROR. On error,
+ * either return an error to be displayed, or set *EXIT_CODE to non-zero and
+ * return SVN_NO_ERROR.
+ */
+static svn_error_t *
+sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_getopt_t *os;
+  apr_array_header_t *pairs = apr_array_make(pool, 16, sizeof(const char *));
+  options_t options = { 3, FALSE };
+  totals_t totals = { 0 };
+  int i, k;
+
+  SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
+
+  while (1)
+    {
+      char opt;
+      const char *arg;
+      const char *utf8_arg;
+      apr_status_t status = apr_getopt(os, "F:n:v", &opt, &arg);
+      if (APR_STATUS_IS_EOF(status))
+        break;
+      if (status != APR_SUCCESS)
+        {
+          usage(pool);
+          *exit_code = EXIT_FAILURE;
+          return SVN_NO_ERROR;
+        }
+
+      switch (opt)
+        {
+        case 'F':
+          SVN_ERR(svn_utf_cstring_to_utf8(&utf8_arg, arg, pool));
+          SVN_ERR(read_corpus(pairs,
+                              svn_dirent_internal_style(utf8_arg, pool),
+                              pool, iterpool));
+          break;
+        case 'n':
+          options.iterations = atoi(arg);
+          if (options.iterations < 1)
+            {
+              usage(pool);
+              *exit_code = EXIT_FAILURE;
+              return SVN_NO_ERROR;
+            }
+          break;
+        case 'v':
+          options.verbose = TRUE;
+          break;
+        default:
+          usage(pool);
+          *exit_code = EXIT_FAILURE;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  /* The remaining arguments are pairs of paths. */
+  if ((argc - os->ind) % 2)
+    {
+      usage(pool);
+      *exit_code = EXIT_FAILURE;
+      return SVN_NO_ERROR;
+    }
+
+  while (os->ind < argc)
+    {
+      const char *path;
+
+      SVN_ERR(svn_utf_cstring_to_utf8(&path, os->argv[os->ind++], pool));
+      APR_ARRAY_PUSH(pairs, const char *)
+        = svn_dirent_internal_style(path, pool);
+    }
+
+  if (pairs->nelts == 0)
+    {
+      usage(pool);
+      *exit_code = EXIT_FAILURE;
+      return SVN_NO_ERROR;
+    }
+
+  /* svndiff3 is only available with zstd support. */
+  for (k = 0; k < FORMAT_COUNT; ++k)
+    if (formats[k].version == 3)
+      formats[k].available = svn__zstd_available();
+
+  for (i = 0; i < pairs->nelts; i += 2)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(bench_pair(&totals,
+                         APR_ARRAY_IDX(pairs, i, const char *),
+                         APR_ARRAY_IDX(pairs, i + 1, const char *),
+                         &options, iterpool));
+    }
+
+  if (options.verbose)
+    SVN_ERR(svn_cmdline_printf(pool, "\n"));
+
+  SVN_ERR(print_totals(&totals, pool));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  apr_pool_t *pool;
+  int exit_code = EXIT_SUCCESS;
+  svn_error_t *err;
+
+  /* Initialize the app. */
+  if (svn_cmdline_init("delta-bench", stderr) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  /* Create our top-level pool.  Use a separate mutexless allocator,
+   * given this application is single threaded.
+   */
+  pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+  err = sub_main(&exit_code, argc, argv, pool);
+
+  /* Flush stdout and report if it fails. It would be flushed on exit anyway
+     but this makes sure that output is not silently lost if it fails. */
+  err = svn_error_compose_create(err, svn_cmdline_fflush(stdout));
+
+  if (err)
+    {
+      exit_code = EXIT_FAILURE;
+      svn_cmdline_handle_exit_error(err, NULL, "delta-bench: ");
+    }
+
+  svn_pool_destroy(pool);
+  return exit_code;
+}
@@ -0,0 +1,203 @@
+/* diff-bench.c -- measure file diffs and merges of libsvn_diff
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <stdlib.h>
+
+#include <apr_time.h>
+
+#include "svn_cmdline.h"
+#include "svn_diff.h"
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_utf.h"
+
+#include "private/svn_cmdline_private.h"
+
+#include "svn_private_config.h"
+
+static void
+usage(apr_pool_t *pool)
+{
+  svn_error_clear(svn_cmdline_fprintf(stderr, pool,
+    _("Usage: diff-bench [OPTIONS] ORIGINAL MODIFIED [LATEST]\n"
+      "\n"
+      "Diff two files or merge three files with libsvn_diff and report\n"
+      "the throughput.  Large, mostly identical files measure the scan\n"
+      "for the identical prefix and suffix.\n"
+      "\n"
+      "Options:\n"
+      "  -n COUNT  run the diff COUNT times and report the fastest\n"
+      "            (default: 10)\n")));
+}
+
+/* Return the throughput for SIZE bytes processed in DURATION as a
+ * number in MB/s. */
+static double
+mb_per_sec(apr_uint64_t size, apr_interval_time_t duration)
+{
+  if (duration <= 0)
+    duration = 1;
+
+  return (double)size / (double)duration;
+}
+
+/* Diff the PATHS_COUNT files in PATHS once and return the time it took
+ * in *DURATION.  Set *DIFFERENT if the files differ. */
+static svn_error_t *
+run_diff(apr_interval_time_t *duration,
+         svn_boolean_t *different,
+         const char **paths,
+         int paths_count,
+         apr_pool_t *scratch_pool)
+{
+  svn_diff_file_options_t *options
+    = svn_diff_file_options_create(scratch_pool);
+  svn_diff_t *diff;
+  apr_time_t start = apr_time_now();
+
+  if (paths_count == 2)
+    SVN_ERR(svn_diff_file_diff_2(&diff, paths[0], paths[1], options,
+                                 scratch_pool));
+  else
+    SVN_ERR(svn_diff_file_diff3_2(&diff, paths[0], paths[1], paths[2],
+                                  options, scratch_pool));
+
+  *duration = apr_time_now() - start;
+  *different = svn_diff_contains_diffs(diff);
+
+  return SVN_NO_ERROR;
+}
+
+/*
+ * On success, leave *EXIT_CODE untouched and return SVN_NO_ERROR. On error,
+ * either return an error to be displayed, or set *EXIT_CODE to non-zero and
+ * return SVN_NO_ERROR.
+ */
+static svn_error_t *
+sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_getopt_t *os;
+  const char *paths[3];
+  int paths_count = 0;
+  int iterations = 10;
+  apr_uint64_t total_size = 0;
+  apr_interval_time_t fastest = 0;
+  svn_boolean_t different = FALSE;
+  int i;
+
+  SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
+
+  while (1)
+    {
+      char opt;
+      const char *arg;
+      apr_status_t status = apr_getopt(os, "n:", &opt, &arg);
+      if (APR_STATUS_IS_EOF(status))
+        break;
+      if (status == APR_SUCCESS && opt == 'n')
+        iterations = atoi(arg);
+
+      if (status != APR_SUCCESS || opt != 'n' || iterations < 1)
+        {
+          usage(pool);
+          *exit_code = EXIT_FAILURE;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  if (argc - os->ind < 2 || argc - os->ind > 3)
+    {
+      usage(pool);
+      *exit_code = EXIT_FAILURE;
+      return SVN_NO_ERROR;
+    }
+
+  while (os->ind < argc)
+    {
+      const char *path;
+      apr_finfo_t finfo;
+
+      SVN_ERR(svn_utf_cstring_to_utf8(&path, os->argv[os->ind++], pool));
+      path = svn_dirent_internal_style(path, pool);
+      SVN_ERR(svn_io_stat(&finfo, path, APR_FINFO_SIZE, pool));
+
+      paths[paths_count++] = path;
+      total_size += finfo.size;
+    }
+
+  for (i = 0; i < iterations; i++)
+    {
+      apr_interval_time_t duration;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(run_diff(&duration, &different, paths, paths_count,
+                       iterpool));
+      if (fastest == 0 || duration < fastest)
+        fastest = duration;
+    }
+
+  SVN_ERR(svn_cmdline_printf(pool,
+                             _("%d-way diff of %" APR_UINT64_T_FMT " bytes"
+                               " (%s): %.3f ms, %.1f MB/s\n"),
+                             paths_count, total_size,
+                             different ? _("different") : _("identical"),
+                             (double)fastest / 1000.0,
+                             mb_per_sec(total_size, fastest)));
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  apr_pool_t *pool;
+  int exit_code = EXIT_SUCCESS;
+  svn_error_t *err;
+
+  /* Initialize the app. */
+  if (svn_cmdline_init("diff-bench", stderr) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  /* Create our top-level pool.  Use a separate mutexless allocator,
+   * given this application is single threaded.
+   */
+  pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+  err = sub_main(&exit_code, argc, argv, pool);
+
+  /* Flush stdout and report if it fails. It would be flushed on exit anyway
+     but this makes sure that output is not silently lost if it fails. */
+  err = svn_error_compose_create(err, svn_cmdline_fflush(stdout));
+
+  if (err)
+    {
+      exit_code = EXIT_FAILURE;
+      svn_cmdline_handle_exit_error(err, NULL, "diff-bench: ");
+    }
+
+  svn_pool_destroy(pool);
+  return exit_code;
+}